@@ -5,6 +5,7 @@ package org.qtproject.qt.android.bluetooth;
 
 import java.io.InputStream;
 import java.io.IOException;
+import java.nio.ByteBuffer;
 import android.util.Log;
 
 @SuppressWarnings("WeakerAccess")
@@ -18,6 +19,11 @@ public class QtBluetoothInputStreamThread extends Thread
     private static final String TAG = "QtBluetooth";
     private InputStream m_inputStream = null;
 
+    // Received data is handed to Qt through this ring, Qt reads it in place.
+    // Qt tracks both ends of the ring, readyData() publishes written bytes.
+    private static final int RING_CAPACITY = 64 * 1024; // must be a power of two
+    private final ByteBuffer m_ring = ByteBuffer.allocateDirect(RING_CAPACITY);
+
     //error codes
     public static final int QT_MISSING_INPUT_STREAM = 0;
     public static final int QT_READ_FAILED = 1;
@@ -33,6 +39,25 @@ public class QtBluetoothInputStreamThread extends Thread
         m_inputStream = stream;
     }
 
+    public ByteBuffer ringBuffer()
+    {
+        return m_ring;
+    }
+
+    // called by Qt once it read from a full ring
+    public synchronized void wakeUp()
+    {
+        notifyAll();
+    }
+
+    private synchronized int waitForSpace() throws InterruptedException
+    {
+        int freeSpace;
+        while ((freeSpace = freeSpace(qtObject)) == 0)
+            wait();
+        return freeSpace;
+    }
+
     public void run()
     {
         if (m_inputStream == null) {
@@ -42,15 +67,38 @@ public class QtBluetoothInputStreamThread extends Thread
 
         byte[] buffer = new byte[1000];
         int bytesRead;
+        int writeIndex = 0;
+        int freeSpace = RING_CAPACITY;
 
         try {
             while (!isInterrupted()) {
+                if (freeSpace == 0)
+                    freeSpace = waitForSpace();
+
                 //this blocks until we see incoming data
                 //or close() on related BluetoothSocket is called
-                bytesRead = m_inputStream.read(buffer);
-                readyData(qtObject, buffer, bytesRead);
+                bytesRead = m_inputStream.read(buffer, 0, Math.min(buffer.length, freeSpace));
+                if (bytesRead < 0) {
+                    if (logEnabled)
+                        Log.d(TAG, "InputStream reached end of stream");
+                    errorOccurred(qtObject, QT_READ_FAILED);
+                    return;
+                }
+
+                final int firstPart = Math.min(bytesRead, RING_CAPACITY - writeIndex);
+                m_ring.position(writeIndex);
+                m_ring.put(buffer, 0, firstPart);
+                if (firstPart < bytesRead) {
+                    m_ring.position(0);
+                    m_ring.put(buffer, firstPart, bytesRead - firstPart);
+                }
+                writeIndex = (writeIndex + bytesRead) & (RING_CAPACITY - 1);
+
+                freeSpace = readyData(qtObject, bytesRead);
             }
 
+            errorOccurred(qtObject, QT_THREAD_INTERRUPTED);
+        } catch (InterruptedException ex) {
             errorOccurred(qtObject, QT_THREAD_INTERRUPTED);
         } catch (IOException ex) {
             if (logEnabled)
@@ -64,5 +112,6 @@ public class QtBluetoothInputStreamThread extends Thread
     }
 
     public static native void errorOccurred(long qtObject, int errorCode);
-    public static native void readyData(long qtObject, byte[] buffer, int bufferLength);
+    public static native int readyData(long qtObject, int bytesWritten);
+    public static native int freeSpace(long qtObject);
 }
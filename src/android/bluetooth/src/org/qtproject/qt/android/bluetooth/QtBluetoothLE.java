@@ -24,13 +24,18 @@ import android.os.Build;
 import android.os.Handler;
 import android.os.HandlerThread;
 import android.os.Looper;
+import android.os.ParcelUuid;
 import android.util.Log;
 import java.lang.reflect.Constructor;
 import java.lang.reflect.Method;
+import java.io.ByteArrayOutputStream;
 import java.util.concurrent.atomic.AtomicInteger;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 
 import java.util.ArrayList;
 import java.util.Hashtable;
+import java.util.Iterator;
 import java.util.LinkedList;
 import java.util.List;
 import java.util.NoSuchElementException;
@@ -46,11 +51,35 @@ public class QtBluetoothLE {
     private HandlerThread mHandlerThread = null;
     private Handler mHandler = null;
     private Constructor mCharacteristicConstructor = null;
+    // BluetoothGatt.writeCharacteristic(BluetoothGattCharacteristic, byte[], int), API 33
+    private Method mWriteCharacteristicMethod = null;
+    // must be in sync with android.bluetooth.BluetoothStatusCodes
+    private final int STATUS_SUCCESS = 0;
+    private final int STATUS_GATT_WRITE_REQUEST_BUSY = 201;
+    private final int BUSY_RETRY_DELAY = 5; // milliseconds
+    // set by executeWriteJob() if the request was refused because the previous one is not done
+    private boolean mGattBusy = false;
     private String mRemoteGattAddress;
     private final UUID clientCharacteristicUuid = UUID.fromString("00002902-0000-1000-8000-00805f9b34fb");
     private final int MAX_MTU = 512;
     private final int DEFAULT_MTU = 23;
     private int mSupportedMtu = -1;
+    private int mPreferredMtu = MAX_MTU;
+    // connect on the next advertisement of the device rather than with a timeout
+    private boolean mAutoConnect = false;
+
+    /*
+     *  Characteristic changes are queued until Qt takes them all at once. Each entry is the
+     *  handle and the value length as ints in native byte order, followed by the value.
+     *  Qt is only called when the queue stops being empty. It reads the batch it took in place,
+     *  the batch is reused once Qt takes the next one.
+     */
+    private final int NOTIFICATION_BATCH_CAPACITY = 4096;
+    private final Object mNotificationBatchLock = new Object();
+    private ByteBuffer mNotificationBatch = ByteBuffer.allocateDirect(NOTIFICATION_BATCH_CAPACITY)
+                                                        .order(ByteOrder.nativeOrder());
+    private ByteBuffer mTakenNotificationBatch = ByteBuffer.allocateDirect(NOTIFICATION_BATCH_CAPACITY)
+                                                        .order(ByteOrder.nativeOrder());
 
     /*
      *  The atomic synchronizes the timeoutRunnable thread and the response thread for the pending
@@ -67,6 +96,11 @@ public class QtBluetoothLE {
     private final Handler timeoutHandler = new Handler(Looper.getMainLooper());
 
     private BluetoothLeScanner mBluetoothLeScanner = null;
+    private int mScanMode = ScanSettings.SCAN_MODE_BALANCED;
+    private long mScanReportDelay = 0;
+    private final List<String> mScanNameFilters = new ArrayList<String>();
+    private final List<String> mScanServiceUuidFilters = new ArrayList<String>();
+    private final List<Integer> mScanManufacturerIdFilters = new ArrayList<Integer>();
 
     private class TimeoutRunnable implements Runnable {
         public TimeoutRunnable(int handle) { pendingJobHandle = handle; }
@@ -166,6 +200,15 @@ public class QtBluetoothLE {
     public QtBluetoothLE() {
         mBluetoothAdapter = BluetoothAdapter.getDefaultAdapter();
         mBluetoothLeScanner = mBluetoothAdapter.getBluetoothLeScanner();
+
+        if (Build.VERSION.SDK_INT >= 33) {
+            try {
+                mWriteCharacteristicMethod = BluetoothGatt.class.getMethod("writeCharacteristic",
+                        BluetoothGattCharacteristic.class, byte[].class, int.class);
+            } catch (NoSuchMethodException ex) {
+                Log.w(TAG, "writeCharacteristic() v33 not available");
+            }
+        }
     }
 
     public QtBluetoothLE(final String remoteAddress, Context context) {
@@ -181,6 +224,88 @@ public class QtBluetoothLE {
     /* variables that are not accessed from Java threads         */
     /*************************************************************/
 
+    public void setScanSettings(int scanMode, long reportDelayMillis) {
+        mScanMode = scanMode;
+        mScanReportDelay = reportDelayMillis;
+    }
+
+    public void clearScanFilters() {
+        mScanNameFilters.clear();
+        mScanServiceUuidFilters.clear();
+        mScanManufacturerIdFilters.clear();
+    }
+
+    public void addScanNameFilter(String name) {
+        mScanNameFilters.add(name);
+    }
+
+    public void addScanServiceUuidFilter(String uuid) {
+        mScanServiceUuidFilters.add(uuid);
+    }
+
+    public void addScanManufacturerIdFilter(int id) {
+        mScanManufacturerIdFilters.add(id);
+    }
+
+    /*
+        A device must match one of the ScanFilters, all criteria of a ScanFilter must match.
+        Every combination of the requested names, services and manufacturers therefore
+        gets its own ScanFilter. No filter at all reports every device.
+     */
+    private List<ScanFilter> buildScanFilters() {
+        List<ScanFilter> filterList = new ArrayList<ScanFilter>();
+        filterList.add(null);
+
+        if (!mScanNameFilters.isEmpty()) {
+            List<ScanFilter> combined = new ArrayList<ScanFilter>();
+            for (ScanFilter filter : filterList) {
+                for (String name : mScanNameFilters) {
+                    ScanFilter.Builder builder = builderFor(filter);
+                    combined.add(builder.setDeviceName(name).build());
+                }
+            }
+            filterList = combined;
+        }
+
+        if (!mScanServiceUuidFilters.isEmpty()) {
+            List<ScanFilter> combined = new ArrayList<ScanFilter>();
+            for (ScanFilter filter : filterList) {
+                for (String uuid : mScanServiceUuidFilters) {
+                    ScanFilter.Builder builder = builderFor(filter);
+                    combined.add(builder.setServiceUuid(ParcelUuid.fromString(uuid)).build());
+                }
+            }
+            filterList = combined;
+        }
+
+        if (!mScanManufacturerIdFilters.isEmpty()) {
+            List<ScanFilter> combined = new ArrayList<ScanFilter>();
+            for (ScanFilter filter : filterList) {
+                for (int id : mScanManufacturerIdFilters) {
+                    ScanFilter.Builder builder = builderFor(filter);
+                    // an empty data array matches any data of that manufacturer
+                    combined.add(builder.setManufacturerData(id, new byte[0]).build());
+                }
+            }
+            filterList = combined;
+        }
+
+        if (filterList.get(0) == null)
+            filterList.clear();
+        return filterList;
+    }
+
+    private static ScanFilter.Builder builderFor(ScanFilter filter) {
+        ScanFilter.Builder builder = new ScanFilter.Builder();
+        if (filter == null)
+            return builder;
+        if (filter.getDeviceName() != null)
+            builder.setDeviceName(filter.getDeviceName());
+        if (filter.getServiceUuid() != null)
+            builder.setServiceUuid(filter.getServiceUuid());
+        return builder;
+    }
+
     public boolean scanForLeDevice(final boolean isEnabled) {
         if (isEnabled == mLeScanRunning)
             return true;
@@ -188,10 +313,16 @@ public class QtBluetoothLE {
         if (isEnabled) {
             Log.d(TAG, "Attempting to start BTLE scan");
             ScanSettings.Builder settingsBuilder = new ScanSettings.Builder();
-            settingsBuilder = settingsBuilder.setScanMode(ScanSettings.SCAN_MODE_BALANCED);
+            settingsBuilder = settingsBuilder.setScanMode(mScanMode);
+            if (mScanReportDelay > 0) {
+                if (mBluetoothAdapter.isOffloadedScanBatchingSupported())
+                    settingsBuilder = settingsBuilder.setReportDelay(mScanReportDelay);
+                else
+                    Log.d(TAG, "Batched scan results are not supported, ignoring report delay");
+            }
             ScanSettings settings = settingsBuilder.build();
 
-            List<ScanFilter> filterList = new ArrayList<ScanFilter>();
+            List<ScanFilter> filterList = buildScanFilters();
 
             mBluetoothLeScanner.startScan(filterList, settings, leScanCallback);
             mLeScanRunning = true;
@@ -220,9 +351,17 @@ public class QtBluetoothLE {
         @Override
         public void onBatchScanResults(List<ScanResult> results) {
             super.onBatchScanResults(results);
-            for (ScanResult result : results)
-                leScanResult(qtObject, result.getDevice(), result.getRssi(), result.getScanRecord().getBytes());
-
+            final int count = results.size();
+            BluetoothDevice[] devices = new BluetoothDevice[count];
+            int[] rssis = new int[count];
+            byte[][] scanRecords = new byte[count][];
+            for (int i = 0; i < count; ++i) {
+                final ScanResult result = results.get(i);
+                devices[i] = result.getDevice();
+                rssis[i] = result.getRssi();
+                scanRecords[i] = result.getScanRecord().getBytes();
+            }
+            leScanResults(qtObject, devices, rssis, scanRecords);
         }
 
         @Override
@@ -233,6 +372,8 @@ public class QtBluetoothLE {
     };
 
     public native void leScanResult(long qtObject, BluetoothDevice device, int rssi, byte[] scanRecord);
+    public native void leScanResults(long qtObject, BluetoothDevice[] devices, int[] rssis,
+                                     byte[][] scanRecords);
 
     private synchronized void handleOnConnectionStateChange(BluetoothGatt gatt,
                                                            int status, int newState) {
@@ -350,11 +491,27 @@ public class QtBluetoothLE {
             return;
         }
 
+        if (pendingJob != null && pendingJob.cancelled) {
+            // nobody is interested in the value anymore
+            pendingJob = null;
+            performNextIO();
+            return;
+        }
+
         GattEntry entry = entries.get(foundHandle);
         final boolean isServiceDiscoveryRun = !entry.valueKnown;
         entry.valueKnown = true;
 
-        if (status == BluetoothGatt.GATT_SUCCESS) {
+        if (isServiceDiscoveryRun) {
+            if (status != BluetoothGatt.GATT_SUCCESS) {
+                Log.w(TAG, "onCharacteristicRead during discovery error: " + status);
+
+                Log.d(TAG, "Non-readable characteristic " + characteristic.getUuid() +
+                                " for service " + characteristic.getService().getUuid());
+            }
+            addDiscoveredCharacteristic(entry.associatedServiceHandle, foundHandle,
+                                        characteristic);
+        } else if (status == BluetoothGatt.GATT_SUCCESS) {
             // Qt manages handles starting at 1, in Java we use a system starting with 0
             //TODO avoid sending service uuid -> service handle should be sufficient
             leCharacteristicRead(qtObject,
@@ -362,19 +519,9 @@ public class QtBluetoothLE {
                     foundHandle + 1, characteristic.getUuid().toString(),
                     characteristic.getProperties(), characteristic.getValue());
         } else {
-            if (isServiceDiscoveryRun) {
-                Log.w(TAG, "onCharacteristicRead during discovery error: " + status);
-
-                Log.d(TAG, "Non-readable characteristic " + characteristic.getUuid() +
-                                " for service " + characteristic.getService().getUuid());
-                leCharacteristicRead(qtObject, characteristic.getService().getUuid().toString(),
-                    foundHandle + 1, characteristic.getUuid().toString(),
-                    characteristic.getProperties(), characteristic.getValue());
-            } else {
-                // This must be in sync with QLowEnergyService::CharacteristicReadError
-                final int characteristicReadError = 5;
-                leServiceError(qtObject, foundHandle + 1, characteristicReadError);
-            }
+            // This must be in sync with QLowEnergyService::CharacteristicReadError
+            final int characteristicReadError = 5;
+            leServiceError(qtObject, foundHandle + 1, characteristicReadError);
         }
 
         if (isServiceDiscoveryRun) {
@@ -400,7 +547,44 @@ public class QtBluetoothLE {
             return;
         }
 
-        leCharacteristicChanged(qtObject, handle+1, characteristic.getValue());
+        final byte[] value = characteristic.getValue();
+        final int length = value == null ? 0 : value.length;
+        boolean wasEmpty;
+        synchronized (mNotificationBatchLock) {
+            wasEmpty = mNotificationBatch.position() == 0;
+            if (mNotificationBatch.remaining() < 8 + length) {
+                final int capacity = Math.max(2 * mNotificationBatch.capacity(),
+                                              mNotificationBatch.position() + 8 + length);
+                final ByteBuffer batch = ByteBuffer.allocateDirect(capacity)
+                                                   .order(ByteOrder.nativeOrder());
+                mNotificationBatch.flip();
+                batch.put(mNotificationBatch);
+                mNotificationBatch = batch;
+            }
+            mNotificationBatch.putInt(handle+1);
+            mNotificationBatch.putInt(length);
+            if (length > 0)
+                mNotificationBatch.put(value);
+        }
+
+        if (wasEmpty)
+            leCharacteristicsChanged(qtObject);
+    }
+
+    /*
+     *  Called by Qt after leCharacteristicsChanged(). Returns the queued characteristic
+     *  changes, the returned buffer must not be accessed anymore once this is called again.
+     */
+    public ByteBuffer takeNotificationBatch()
+    {
+        synchronized (mNotificationBatchLock) {
+            final ByteBuffer batch = mNotificationBatch;
+            mNotificationBatch = mTakenNotificationBatch;
+            mNotificationBatch.clear();
+            mTakenNotificationBatch = batch;
+            batch.flip();
+            return batch;
+        }
     }
 
     private synchronized void handleOnCharacteristicWrite(android.bluetooth.BluetoothGatt gatt,
@@ -472,34 +656,37 @@ public class QtBluetoothLE {
             return;
         }
 
+        if (pendingJob != null && pendingJob.cancelled) {
+            // nobody is interested in the value anymore
+            pendingJob = null;
+            performNextIO();
+            return;
+        }
+
         GattEntry entry = entries.get(foundHandle);
         final boolean isServiceDiscoveryRun = !entry.valueKnown;
         entry.valueKnown = true;
 
-        if (status == BluetoothGatt.GATT_SUCCESS) {
-            //TODO avoid sending service and characteristic uuid -> handles should be sufficient
-            leDescriptorRead(qtObject,
-                    descriptor.getCharacteristic().getService().getUuid().toString(),
-                    descriptor.getCharacteristic().getUuid().toString(), foundHandle + 1,
-                    descriptor.getUuid().toString(), descriptor.getValue());
-        } else {
-            if (isServiceDiscoveryRun) {
+        if (isServiceDiscoveryRun) {
+            if (status != BluetoothGatt.GATT_SUCCESS) {
                 // Cannot read but still advertise the fact that we found a descriptor
                 // The value will be empty.
                 Log.w(TAG, "onDescriptorRead during discovery error: " + status);
                 Log.d(TAG, "Non-readable descriptor " + descriptor.getUuid() +
                       " for characteristic "  + descriptor.getCharacteristic().getUuid() +
                       " for service " + descriptor.getCharacteristic().getService().getUuid());
-                leDescriptorRead(qtObject,
+            }
+            addDiscoveredDescriptor(entry.associatedServiceHandle, foundHandle, descriptor);
+        } else if (status == BluetoothGatt.GATT_SUCCESS) {
+            //TODO avoid sending service and characteristic uuid -> handles should be sufficient
+            leDescriptorRead(qtObject,
                     descriptor.getCharacteristic().getService().getUuid().toString(),
                     descriptor.getCharacteristic().getUuid().toString(), foundHandle + 1,
                     descriptor.getUuid().toString(), descriptor.getValue());
-            } else {
-                // This must be in sync with QLowEnergyService::DescriptorReadError
-                final int descriptorReadError = 6;
-                leServiceError(qtObject, foundHandle + 1, descriptorReadError);
-            }
-
+        } else {
+            // This must be in sync with QLowEnergyService::DescriptorReadError
+            final int descriptorReadError = 6;
+            leServiceError(qtObject, foundHandle + 1, descriptorReadError);
         }
 
         if (isServiceDiscoveryRun) {
@@ -667,6 +854,17 @@ public class QtBluetoothLE {
             super.onMtuChanged(gatt, mtu, status);
             handleOnMtuChanged(gatt, mtu, status);
         }
+
+        public void onPhyUpdate(android.bluetooth.BluetoothGatt gatt, int txPhy, int rxPhy,
+                                int status)
+        {
+            super.onPhyUpdate(gatt, txPhy, rxPhy, status);
+            if (status != BluetoothGatt.GATT_SUCCESS) {
+                Log.w(TAG, "PHY update error " + status);
+                return;
+            }
+            lePhyUpdated(qtObject, txPhy, rxPhy);
+        }
     };
 
     // This function is called from Qt thread
@@ -678,6 +876,16 @@ public class QtBluetoothLE {
         }
     }
 
+    // This function is called from Qt thread
+    public synchronized void setPreferredMtu(int mtu) {
+        mPreferredMtu = (mtu > 0) ? mtu : MAX_MTU;
+    }
+
+    // This function is called from Qt thread
+    public synchronized void setAutoConnect(boolean autoConnect) {
+        mAutoConnect = autoConnect;
+    }
+
     // This function is called from Qt thread
     public synchronized boolean connect() {
         BluetoothDevice mRemoteGattDevice;
@@ -708,7 +916,7 @@ public class QtBluetoothLE {
             try {
                 Method connectMethod = mRemoteGattDevice.getClass().getDeclaredMethod("connectGatt", args);
                 if (connectMethod != null) {
-                    mBluetoothGatt = (BluetoothGatt) connectMethod.invoke(mRemoteGattDevice, qtContext, false,
+                    mBluetoothGatt = (BluetoothGatt) connectMethod.invoke(mRemoteGattDevice, qtContext, mAutoConnect,
                             gattCallback, 2 /* TRANSPORT_LE */, 1 /*BluetoothDevice.PHY_LE_1M*/, mHandler);
                     Log.w(TAG, "Using Android v26 BluetoothDevice.connectGatt()");
                 }
@@ -745,7 +953,7 @@ public class QtBluetoothLE {
             }
             try {
                 mBluetoothGatt =
-                    mRemoteGattDevice.connectGatt(qtContext, false,
+                    mRemoteGattDevice.connectGatt(qtContext, mAutoConnect,
                                                   gattCallback, 2 /* TRANSPORT_LE */);
             } catch (IllegalArgumentException ex) {
                 Log.w(TAG, "Gatt connection failed");
@@ -805,6 +1013,8 @@ public class QtBluetoothLE {
         public byte[] newValue;
         public int requestedWriteType;
         public IoJobType jobType;
+        // set by cancelServiceJobs() while the job is in flight, its result is dropped
+        public boolean cancelled = false;
     }
 
     // service uuid -> service handle mapping (there can be more than one service with same uuid)
@@ -814,10 +1024,44 @@ public class QtBluetoothLE {
     //backlog of to be discovered services
     private final LinkedList<Integer> servicesToBeDiscovered = new LinkedList<Integer>();
 
+    /*
+     *  The characteristics and descriptors found while discovering a service are handed to Qt
+     *  together with the end of the discovery, keyed by service handle. Each entry holds its
+     *  type, handle, properties, UUID and value length in big endian order, followed by the
+     *  value. Descriptors follow the characteristic they belong to.
+     */
+    private final int DISCOVERED_CHARACTERISTIC = 0;
+    private final int DISCOVERED_DESCRIPTOR = 1;
+    private final int DISCOVERED_ENTRY_HEADER_SIZE = 1 + 4 + 4 + 16 + 4;
+    private final Hashtable<Integer, ByteArrayOutputStream> serviceDetails =
+            new Hashtable<Integer, ByteArrayOutputStream>();
+
 
     private final LinkedList<ReadWriteJob> readWriteQueue = new LinkedList<ReadWriteJob>();
+    // Write Without Response jobs, any job in readWriteQueue is executed before them
+    private final LinkedList<ReadWriteJob> bulkWriteQueue = new LinkedList<ReadWriteJob>();
     private ReadWriteJob pendingJob;
 
+    /*
+        Queues a job requested by Qt. Reads and writes with response may overtake
+        queued Write Without Response jobs, except for those to the same entry.
+     */
+    private boolean enqueueJob(ReadWriteJob job)
+    {
+        boolean bulk = job.jobType == IoJobType.Write
+                && job.requestedWriteType == BluetoothGattCharacteristic.WRITE_TYPE_NO_RESPONSE;
+        if (!bulk) {
+            for (ReadWriteJob queued : bulkWriteQueue) {
+                if (queued.entry == job.entry) {
+                    bulk = true;
+                    break;
+                }
+            }
+        }
+
+        return bulk ? bulkWriteQueue.add(job) : readWriteQueue.add(job);
+    }
+
     /*
         Internal helper function
         Returns the handle id for the given characteristic; otherwise returns -1.
@@ -967,16 +1211,21 @@ public class QtBluetoothLE {
         uuidToEntry.clear();
         entries.clear();
         servicesToBeDiscovered.clear();
+        serviceDetails.clear();
 
         // kill all timeout handlers
         timeoutHandler.removeCallbacksAndMessages(null);
         handleForTimeout.set(HANDLE_FOR_RESET);
 
         readWriteQueue.clear();
+        bulkWriteQueue.clear();
     }
 
     // This function is called from Qt thread
-    public synchronized boolean discoverServiceDetails(String serviceUuid, boolean fullDiscovery)
+    public synchronized boolean discoverServiceDetails(String serviceUuid,
+                                                       boolean readCharacteristics,
+                                                       boolean readDescriptors,
+                                                       String[] characteristicUuids)
     {
         try {
             if (mBluetoothGatt == null)
@@ -1020,7 +1269,8 @@ public class QtBluetoothLE {
             }
 
             servicesToBeDiscovered.add(serviceHandle);
-            scheduleServiceDetailDiscovery(serviceHandle, fullDiscovery);
+            scheduleServiceDetailDiscovery(serviceHandle, readCharacteristics, readDescriptors,
+                                           characteristicUuids);
             performNextIOThreaded();
         } catch (Exception ex) {
             ex.printStackTrace();
@@ -1030,6 +1280,55 @@ public class QtBluetoothLE {
         return true;
     }
 
+    /*
+        Drops the queued reads of the given service, including those of a pending
+        detail discovery. The discovery of the service is abandoned and may be
+        started again. Writes are still executed.
+        This function is called from Qt thread
+     */
+    public synchronized boolean cancelServiceJobs(String serviceUuid)
+    {
+        if (mBluetoothGatt == null || entries.isEmpty())
+            return false;
+
+        int serviceHandle;
+        try {
+            List<Integer> handles = uuidToEntry.get(UUID.fromString(serviceUuid));
+            if (handles == null || handles.isEmpty())
+                return false;
+
+            //TODO for now we assume we always want the first service in case of uuid collision
+            serviceHandle = handles.get(0);
+        } catch (IllegalArgumentException ex) {
+            Log.w(TAG, "Cannot parse given UUID");
+            return false;
+        }
+
+        Iterator<ReadWriteJob> it = readWriteQueue.iterator();
+        while (it.hasNext()) {
+            if (isReadOfService(it.next(), serviceHandle))
+                it.remove();
+        }
+        if (pendingJob != null && isReadOfService(pendingJob, serviceHandle))
+            pendingJob.cancelled = true;
+
+        if (servicesToBeDiscovered.remove(Integer.valueOf(serviceHandle))) {
+            // the entries read so far are discovered again by the next attempt
+            serviceDetails.remove(serviceHandle);
+            final int endHandle = entries.get(serviceHandle).endHandle;
+            for (int i = serviceHandle + 1; i <= endHandle; i++)
+                entries.get(i).valueKnown = false;
+        }
+
+        return true;
+    }
+
+    private static boolean isReadOfService(ReadWriteJob job, int serviceHandle)
+    {
+        return (job.jobType == IoJobType.Read || job.jobType == IoJobType.SkippedRead)
+                && job.entry != null && job.entry.associatedServiceHandle == serviceHandle;
+    }
+
     /*
         Returns the uuids of the services included by the given service. Otherwise returns null.
         This function is called from Qt thread
@@ -1075,15 +1374,53 @@ public class QtBluetoothLE {
             Log.w(TAG, "Expected queued service but didn't find any");
         }
 
+        ByteArrayOutputStream details = serviceDetails.remove(handleDiscoveredService);
         leServiceDetailDiscoveryFinished(qtObject, discoveredService.service.getUuid().toString(),
-                handleDiscoveredService + 1, discoveredService.endHandle + 1);
+                handleDiscoveredService + 1, discoveredService.endHandle + 1,
+                details != null ? details.toByteArray() : new byte[0]);
+    }
+
+    private void addDiscoveredEntry(int serviceHandle, int type, int handle, int properties,
+                                    UUID uuid, byte[] value)
+    {
+        ByteArrayOutputStream details = serviceDetails.get(serviceHandle);
+        if (details == null) {
+            details = new ByteArrayOutputStream();
+            serviceDetails.put(serviceHandle, details);
+        }
+
+        final int valueLength = (value != null) ? value.length : 0;
+        ByteBuffer header = ByteBuffer.allocate(DISCOVERED_ENTRY_HEADER_SIZE)
+                                      .order(ByteOrder.BIG_ENDIAN);
+        // Qt manages handles starting at 1, in Java we use a system starting with 0
+        header.put((byte) type).putInt(handle + 1).putInt(properties)
+              .putLong(uuid.getMostSignificantBits()).putLong(uuid.getLeastSignificantBits())
+              .putInt(valueLength);
+        details.write(header.array(), 0, DISCOVERED_ENTRY_HEADER_SIZE);
+        if (valueLength > 0)
+            details.write(value, 0, valueLength);
+    }
+
+    private void addDiscoveredCharacteristic(int serviceHandle, int handle,
+                                             BluetoothGattCharacteristic characteristic)
+    {
+        addDiscoveredEntry(serviceHandle, DISCOVERED_CHARACTERISTIC, handle,
+                           characteristic.getProperties(), characteristic.getUuid(),
+                           characteristic.getValue());
+    }
+
+    private void addDiscoveredDescriptor(int serviceHandle, int handle,
+                                         BluetoothGattDescriptor descriptor)
+    {
+        addDiscoveredEntry(serviceHandle, DISCOVERED_DESCRIPTOR, handle, 0,
+                           descriptor.getUuid(), descriptor.getValue());
     }
 
     // Executes under "this" client mutex. Returns true
     // if no actual MTU exchange is initiated
     private boolean executeMtuExchange()
     {
-        if (mBluetoothGatt.requestMtu(MAX_MTU)) {
+        if (mBluetoothGatt.requestMtu(mPreferredMtu)) {
             Log.w(TAG, "MTU change initiated");
             return false;
         } else {
@@ -1113,10 +1450,14 @@ public class QtBluetoothLE {
         Internal Helper function for discoverServiceDetails()
 
         Adds all Gatt entries for the given service to the readWriteQueue to be discovered.
-        This function only ever adds read requests to the queue.
+        This function only ever adds read requests to the queue. The values of
+        characteristics and descriptors are only read if requested and, if
+        characteristicUuids is not empty, their characteristic is one of the listed ones.
 
      */
-    private void scheduleServiceDetailDiscovery(int serviceHandle, boolean fullDiscovery)
+    private void scheduleServiceDetailDiscovery(int serviceHandle, boolean readCharacteristics,
+                                                boolean readDescriptors,
+                                                String[] characteristicUuids)
     {
         GattEntry serviceEntry = entries.get(serviceHandle);
         final int endHandle = serviceEntry.endHandle;
@@ -1127,6 +1468,11 @@ public class QtBluetoothLE {
             return;
         }
 
+        List<UUID> filter = new ArrayList<UUID>();
+        for (String uuid: characteristicUuids)
+            filter.add(UUID.fromString(uuid));
+
+        boolean filtered = false;
         // serviceHandle + 1 -> ignore service handle itself
         for (int i = serviceHandle + 1; i <= endHandle; i++) {
             GattEntry entry = entries.get(i);
@@ -1137,9 +1483,21 @@ public class QtBluetoothLE {
                 return;
             }
 
+            // the value and descriptor entries follow their characteristic entry
+            if (entry.type == GattEntryType.Characteristic) {
+                filtered = !filter.isEmpty()
+                        && !filter.contains(entry.characteristic.getUuid());
+            }
+
+            boolean read;
+            if (entry.type == GattEntryType.Descriptor)
+                read = readDescriptors && !filtered;
+            else
+                read = readCharacteristics && !filtered;
+
             ReadWriteJob newJob = new ReadWriteJob();
             newJob.entry = entry;
-            if (fullDiscovery) {
+            if (read) {
                 newJob.jobType = IoJobType.Read;
             } else {
                 newJob.jobType = IoJobType.SkippedRead;
@@ -1190,7 +1548,7 @@ public class QtBluetoothLE {
         }
 
         boolean result;
-        result = readWriteQueue.add(newJob);
+        result = enqueueJob(newJob);
 
         if (!result) {
             Log.w(TAG, "Cannot add characteristic write request for " + charHandle + " to queue" );
@@ -1226,7 +1584,7 @@ public class QtBluetoothLE {
         newJob.jobType = IoJobType.Write;
 
         boolean result;
-        result = readWriteQueue.add(newJob);
+        result = enqueueJob(newJob);
 
         if (!result) {
             Log.w(TAG, "Cannot add descriptor write request for " + descHandle + " to queue" );
@@ -1260,7 +1618,7 @@ public class QtBluetoothLE {
         newJob.jobType = IoJobType.Read;
 
         boolean result;
-        result = readWriteQueue.add(newJob);
+        result = enqueueJob(newJob);
 
         if (!result) {
             Log.w(TAG, "Cannot add characteristic read request for " + charHandle + " to queue" );
@@ -1290,7 +1648,7 @@ public class QtBluetoothLE {
         newJob.jobType = IoJobType.Read;
 
         boolean result;
-        result = readWriteQueue.add(newJob);
+        result = enqueueJob(newJob);
 
         if (!result) {
             Log.w(TAG, "Cannot add descriptor read request for " + descHandle + " to queue" );
@@ -1306,12 +1664,14 @@ public class QtBluetoothLE {
     // and the regular responses will be blocked off.
     private synchronized void interruptCurrentIO(int handle)
     {
+        final boolean cancelled = pendingJob != null && pendingJob.cancelled;
+
         //unlock the queue for next item
         pendingJob = null;
 
         performNextIOThreaded();
 
-        if (handle == HANDLE_FOR_MTU_EXCHANGE)
+        if (cancelled || handle == HANDLE_FOR_MTU_EXCHANGE)
             return;
 
         try {
@@ -1363,10 +1723,10 @@ public class QtBluetoothLE {
         final ReadWriteJob nextJob;
         int handle = HANDLE_FOR_RESET;
 
-        if (readWriteQueue.isEmpty() || pendingJob != null)
+        if ((readWriteQueue.isEmpty() && bulkWriteQueue.isEmpty()) || pendingJob != null)
             return;
 
-        nextJob = readWriteQueue.remove();
+        nextJob = readWriteQueue.isEmpty() ? bulkWriteQueue.remove() : readWriteQueue.remove();
         if (nextJob.jobType == IoJobType.Mtu) {
             handle = HANDLE_FOR_MTU_EXCHANGE; //mtu request is special case
         } else {
@@ -1405,6 +1765,21 @@ public class QtBluetoothLE {
                 break;
         }
 
+        if (mGattBusy) {
+            // the stack still handles a request whose reply we gave up on, try again shortly
+            mGattBusy = false;
+            handleForTimeout.set(HANDLE_FOR_RESET);
+            readWriteQueue.addFirst(nextJob);
+            final Handler handler = mHandler != null ? mHandler : timeoutHandler;
+            handler.postDelayed(new Runnable() {
+                @Override
+                public void run() {
+                    performNextIO();
+                }
+            }, BUSY_RETRY_DELAY);
+            return;
+        }
+
         if (skip) {
             handleForTimeout.set(HANDLE_FOR_RESET); // not a pending call -> release atomic
         } else {
@@ -1444,9 +1819,8 @@ public class QtBluetoothLE {
                                 nextJob.jobType == IoJobType.Read ? "Non-readable" : "Skipped reading of"
                                 + " characteristic " + entry.characteristic.getUuid()
                                 + " for service " + entry.characteristic.getService().getUuid());
-                            leCharacteristicRead(qtObject, entry.characteristic.getService().getUuid().toString(),
-                                    handle + 1, entry.characteristic.getUuid().toString(),
-                                    entry.characteristic.getProperties(), entry.characteristic.getValue());
+                            addDiscoveredCharacteristic(entry.associatedServiceHandle, handle,
+                                                        entry.characteristic);
                             break;
                         case Descriptor:
                             Log.d(TAG,
@@ -1454,14 +1828,11 @@ public class QtBluetoothLE {
                                 + " descriptor " + entry.descriptor.getUuid()
                                 + " for service/char " + entry.descriptor.getCharacteristic().getService().getUuid()
                                 + "/" + entry.descriptor.getCharacteristic().getUuid());
-                            leDescriptorRead(qtObject,
-                                    entry.descriptor.getCharacteristic().getService().getUuid().toString(),
-                                    entry.descriptor.getCharacteristic().getUuid().toString(),
-                                    handle + 1, entry.descriptor.getUuid().toString(),
-                                    entry.descriptor.getValue());
+                            addDiscoveredDescriptor(entry.associatedServiceHandle, handle,
+                                                    entry.descriptor);
                             break;
                         case CharacteristicValue:
-                            // for more details see scheduleServiceDetailDiscovery(int, boolean)
+                            // for more details see scheduleServiceDetailDiscovery()
                             break;
                         case Service:
                             Log.w(TAG, "Scheduling of Service Gatt entry for service discovery should never happen.");
@@ -1513,7 +1884,21 @@ public class QtBluetoothLE {
         boolean result;
         switch (nextJob.entry.type) {
             case Characteristic:
-                if (mHandler != null || mCharacteristicConstructor == null) {
+                if (mWriteCharacteristicMethod != null) {
+                    // takes the value as argument, the shared characteristic is not modified
+                    int status;
+                    try {
+                        status = (Integer) mWriteCharacteristicMethod.invoke(mBluetoothGatt,
+                                nextJob.entry.characteristic, nextJob.newValue,
+                                nextJob.requestedWriteType);
+                    } catch (Exception ex) {
+                        ex.printStackTrace();
+                        return true;
+                    }
+                    if (status == STATUS_GATT_WRITE_REQUEST_BUSY)
+                        mGattBusy = true;
+                    return status != STATUS_SUCCESS;
+                } else if (mHandler != null || mCharacteristicConstructor == null) {
                     if (nextJob.entry.characteristic.getWriteType() != nextJob.requestedWriteType) {
                         nextJob.entry.characteristic.setWriteType(nextJob.requestedWriteType);
                     }
@@ -1672,11 +2057,24 @@ public class QtBluetoothLE {
         }
     }
 
+    // This function is called from Qt thread
+    public synchronized boolean requestPhy(int txPhyMask, int rxPhyMask)
+    {
+        if (mBluetoothGatt == null || Build.VERSION.SDK_INT < 26)
+            return false;
+
+        // BluetoothDevice.PHY_OPTION_NO_PREFERRED
+        mBluetoothGatt.setPreferredPhy(txPhyMask, rxPhyMask, 0);
+        return true;
+    }
+
     public native void leConnectionStateChange(long qtObject, int wasErrorTransition, int newState);
     public native void leMtuChanged(long qtObject, int mtu);
+    public native void lePhyUpdated(long qtObject, int txPhy, int rxPhy);
     public native void leServicesDiscovered(long qtObject, int errorCode, String uuidList);
     public native void leServiceDetailDiscoveryFinished(long qtObject, final String serviceUuid,
-                                                        int startHandle, int endHandle);
+                                                        int startHandle, int endHandle,
+                                                        byte[] details);
     public native void leCharacteristicRead(long qtObject, String serviceUuid,
                                             int charHandle, String charUuid,
                                             int properties, byte[] data);
@@ -1686,7 +2084,7 @@ public class QtBluetoothLE {
                                                int errorCode);
     public native void leDescriptorWritten(long qtObject, int charHandle, byte[] newData,
                                            int errorCode);
-    public native void leCharacteristicChanged(long qtObject, int charHandle, byte[] newData);
+    public native void leCharacteristicsChanged(long qtObject);
     public native void leServiceError(long qtObject, int attributeHandle, int errorCode);
 }
 
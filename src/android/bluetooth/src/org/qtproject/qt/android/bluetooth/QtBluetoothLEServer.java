@@ -23,9 +23,12 @@ import android.os.ParcelUuid;
 import android.util.Log;
 import android.util.Pair;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.Iterator;
+import java.util.LinkedHashSet;
 import java.util.LinkedList;
 import java.util.List;
 import java.util.ListIterator;
@@ -84,7 +87,7 @@ public class QtBluetoothLEServer {
         }
         // Returns true if this is a proper entry for given device + target
         public boolean match(BluetoothDevice device, Object target) {
-            return remoteDevice.equals(device) && target.equals(target);
+            return remoteDevice.equals(device) && this.target.equals(target);
         }
         public final BluetoothDevice remoteDevice; // Device that issued the writes
         public final Object target; // Characteristic or Descriptor
@@ -92,6 +95,80 @@ public class QtBluetoothLEServer {
     }
     private final List<WriteEntry> mPendingPreparedWrites = new ArrayList<>();
 
+    /*
+     *  Written values are queued until Qt takes them all at once. Each entry is the kind of
+     *  the target (WRITE_TARGET_*) and the value length as ints in native byte order, followed
+     *  by the value. The targets are kept in a list of the same order. Qt is only called when
+     *  the queue stops being empty. It reads the batch it took in place, the batch is reused
+     *  once Qt takes the next one.
+     */
+    private static final int WRITE_BATCH_CAPACITY = 4096;
+    private static final int WRITE_TARGET_CHARACTERISTIC = 0;
+    private static final int WRITE_TARGET_DESCRIPTOR = 1;
+    private final Object mWriteBatchLock = new Object();
+    private ByteBuffer mWriteBatch = ByteBuffer.allocateDirect(WRITE_BATCH_CAPACITY)
+                                               .order(ByteOrder.nativeOrder());
+    private ByteBuffer mTakenWriteBatch = ByteBuffer.allocateDirect(WRITE_BATCH_CAPACITY)
+                                                    .order(ByteOrder.nativeOrder());
+    private ArrayList<Object> mWriteBatchTargets = new ArrayList<>();
+    private ArrayList<Object> mTakenWriteBatchTargets = new ArrayList<>();
+
+    private void queueWrite(Object target, byte[] value)
+    {
+        final int length = value == null ? 0 : value.length;
+        boolean wasEmpty;
+        synchronized (mWriteBatchLock) {
+            wasEmpty = mWriteBatchTargets.isEmpty();
+            if (mWriteBatch.remaining() < 8 + length) {
+                final int capacity = Math.max(2 * mWriteBatch.capacity(),
+                                              mWriteBatch.position() + 8 + length);
+                final ByteBuffer batch = ByteBuffer.allocateDirect(capacity)
+                                                   .order(ByteOrder.nativeOrder());
+                mWriteBatch.flip();
+                batch.put(mWriteBatch);
+                mWriteBatch = batch;
+            }
+            mWriteBatch.putInt(target instanceof BluetoothGattCharacteristic
+                               ? WRITE_TARGET_CHARACTERISTIC : WRITE_TARGET_DESCRIPTOR);
+            mWriteBatch.putInt(length);
+            if (length > 0)
+                mWriteBatch.put(value);
+            mWriteBatchTargets.add(target);
+        }
+
+        if (wasEmpty)
+            leServerWritesReceived(qtObject);
+    }
+
+    /*
+     *  Called by Qt after leServerWritesReceived(). Returns the queued writes, the returned
+     *  buffer must not be accessed anymore once this is called again. The targets of the
+     *  writes are returned by takenWriteTargets().
+     */
+    public ByteBuffer takeWriteBatch()
+    {
+        synchronized (mWriteBatchLock) {
+            final ByteBuffer batch = mWriteBatch;
+            mWriteBatch = mTakenWriteBatch;
+            mWriteBatch.clear();
+            mTakenWriteBatch = batch;
+
+            final ArrayList<Object> targets = mWriteBatchTargets;
+            mWriteBatchTargets = mTakenWriteBatchTargets;
+            mWriteBatchTargets.clear();
+            mTakenWriteBatchTargets = targets;
+
+            batch.flip();
+            return batch;
+        }
+    }
+
+    // Called by Qt after takeWriteBatch(), only the Qt thread touches the taken targets
+    public Object[] takenWriteTargets()
+    {
+        return mTakenWriteBatchTargets.toArray();
+    }
+
     // Helper function to clear the pending writes of a remote device. If the provided device
     // is null, all writes are cleared
     private void clearPendingPreparedWrites(Object device) {
@@ -246,6 +323,20 @@ public class QtBluetoothLEServer {
             .fromString("00002902-0000-1000-8000-00805f9b34fb");
     ClientCharacteristicManager clientCharacteristicManager = new ClientCharacteristicManager();
 
+    /*
+        Notifications and indications are sent to each device independently. Android accepts
+        the next one for a device only once onNotificationSent() reported the previous one,
+        a device waiting for that does not hold up the others. Updates arriving meanwhile
+        only mark the characteristic as pending, the device then receives its latest value.
+     */
+    private class NotificationPipeline {
+        boolean inFlight = false;
+        final LinkedHashSet<BluetoothGattCharacteristic> pending =
+                new LinkedHashSet<BluetoothGattCharacteristic>();
+    }
+    private final HashMap<BluetoothDevice, NotificationPipeline> mNotificationPipelines =
+                  new HashMap<BluetoothDevice, NotificationPipeline>();
+
     public QtBluetoothLEServer(Context context)
     {
         qtContext = context;
@@ -312,6 +403,7 @@ public class QtBluetoothLEServer {
             case BluetoothProfile.STATE_DISCONNECTED:
                 clientCharacteristicManager.markDeviceConnectivity(device, false);
                 clearPendingPreparedWrites(device);
+                mNotificationPipelines.remove(device);
                 // Update the remoteAddress and remoteName if needed
                 if (device.getAddress().equals(mRemoteAddress)
                         && !connectedDevices.isEmpty()) {
@@ -328,6 +420,7 @@ public class QtBluetoothLEServer {
         // If last client disconnected, close down the server
         if (qtControllerState == 0) { // QLowEnergyController::UnconnectedState
             mPendingServiceAdditions.clear();
+            mNotificationPipelines.clear();
             mGattServer.close();
             mGattServer = null;
             mRemoteName = "";
@@ -414,7 +507,7 @@ public class QtBluetoothLEServer {
             Log.w(TAG, "Ignoring characteristic write, server is disconnected");
             return;
         }
-        Log.w(TAG, "onCharacteristicWriteRequest " + preparedWrite + " " + offset + " "
+        Log.d(TAG, "onCharacteristicWriteRequest " + preparedWrite + " " + offset + " "
                     + value.length);
         final int minValueLen = ((QtBluetoothGattCharacteristic)characteristic).minValueLength;
         final int maxValueLen = ((QtBluetoothGattCharacteristic)characteristic).maxValueLength;
@@ -433,7 +526,7 @@ public class QtBluetoothLEServer {
                 resultStatus = BluetoothGatt.GATT_INVALID_ATTRIBUTE_LENGTH;
             } else if (offset == 0) {
                 characteristic.setValue(value);
-                leServerCharacteristicChanged(qtObject, characteristic, value);
+                queueWrite(characteristic, value);
                 sendNotificationOrIndication = true;
             } else {
                 // This should not really happen as per Bluetooth spec
@@ -494,7 +587,7 @@ public class QtBluetoothLEServer {
             return;
         }
 
-        Log.w(TAG, "onDescriptorWriteRequest " + preparedWrite + " " + offset + " " + value.length);
+        Log.d(TAG, "onDescriptorWriteRequest " + preparedWrite + " " + offset + " " + value.length);
         int resultStatus = BluetoothGatt.GATT_SUCCESS;
 
         if (!preparedWrite) { // regular write
@@ -519,7 +612,7 @@ public class QtBluetoothLEServer {
                 }
 
                 descriptor.setValue(value);
-                leServerDescriptorWritten(qtObject, descriptor, value);
+                queueWrite(descriptor, value);
             } else {
                 // This should not really happen as per Bluetooth spec
                 Log.w(TAG, "onDescriptorWriteRequest: !preparedWrite, offset "
@@ -556,17 +649,18 @@ public class QtBluetoothLEServer {
                 if (!entry.remoteDevice.equals(device))
                     continue;
 
-                byte[] newValue = null;
                 // The target can be a descriptor or a characteristic
-                byte[] currentValue = (entry.target instanceof BluetoothGattCharacteristic)
+                final byte[] currentValue = (entry.target instanceof BluetoothGattCharacteristic)
                                 ? ((BluetoothGattCharacteristic)entry.target).getValue()
                                 : ((BluetoothGattDescriptor)entry.target).getValue();
 
-                // Iterate writes and apply them to the currentValue in received order
+                // Validate the writes in received order and determine the size of the new
+                // value, as the writes may extend the current value
+                int newLength = currentValue.length;
                 for (Pair<byte[], Integer> write : entry.writes) {
                     // write.first is data, write.second.intValue() is offset. Check
-                    // that the offset is not beyond the length of the current value
-                    if (write.second.intValue() > currentValue.length) {
+                    // that the offset is not beyond the length of the value so far
+                    if (write.second.intValue() > newLength) {
                         clearPendingPreparedWrites(device);
                         // BT Core v5.3, 3.4.6.3, Vol 3, Part F
                         mGattServer.sendResponse(device, requestId,
@@ -590,31 +684,24 @@ public class QtBluetoothLEServer {
                                     0, null);
                         return;
                     }
+                    newLength = Math.max(newLength,
+                                         write.second.intValue() + write.first.length);
+                }
 
-                    // Determine the size of the new value as we may be extending the
-                    // current value size
-                    newValue = new byte[Math.max(write.second.intValue() +
-                                                 write.first.length, currentValue.length)];
-                    // Copy the current value to the newValue. We can't use the currentValue
-                    // directly because the length of value might increase by this write
-                    System.arraycopy(currentValue, 0, newValue, 0, currentValue.length);
-                    // Apply this iteration's write to the newValue
+                // Allocate the new value once and apply the writes to it in received order
+                final byte[] newValue = new byte[newLength];
+                System.arraycopy(currentValue, 0, newValue, 0, currentValue.length);
+                for (Pair<byte[], Integer> write : entry.writes) {
                     System.arraycopy(write.first, 0, newValue, write.second.intValue(),
                                      write.first.length);
-                    // Update the currentValue as there may be more writes to apply
-                    currentValue = newValue;
                 }
 
                 // Update value and inform the Qt/C++ side on the update
-                if (entry.target instanceof BluetoothGattCharacteristic) {
+                if (entry.target instanceof BluetoothGattCharacteristic)
                     ((BluetoothGattCharacteristic)entry.target).setValue(newValue);
-                    leServerCharacteristicChanged(
-                        qtObject, (BluetoothGattCharacteristic)entry.target, newValue);
-                } else {
+                else
                     ((BluetoothGattDescriptor)entry.target).setValue(newValue);
-                    leServerDescriptorWritten(
-                        qtObject, (BluetoothGattDescriptor)entry.target, newValue);
-                }
+                queueWrite(entry.target, newValue);
             }
         }
         // Either we executed all writes or were asked to cancel.
@@ -623,6 +710,24 @@ public class QtBluetoothLEServer {
         mGattServer.sendResponse(device, requestId, BluetoothGatt.GATT_SUCCESS, 0, null);
     }
 
+    public synchronized void handleOnNotificationSent(BluetoothDevice device, int status)
+    {
+        if (status != BluetoothGatt.GATT_SUCCESS)
+            Log.w(TAG, "onNotificationSent " + device + " failed: " + status);
+
+        final NotificationPipeline pipeline = mNotificationPipelines.get(device);
+        if (pipeline == null)
+            return;
+
+        pipeline.inFlight = false;
+        final Iterator<BluetoothGattCharacteristic> iter = pipeline.pending.iterator();
+        while (!pipeline.inFlight && iter.hasNext()) {
+            final BluetoothGattCharacteristic characteristic = iter.next();
+            iter.remove();
+            pipeline.inFlight = sendNotificationOrIndication(device, characteristic);
+        }
+    }
+
     public synchronized void handleOnMtuChanged(BluetoothDevice device, int mtu)
     {
         if (mSupportedMtu == mtu)
@@ -692,7 +797,7 @@ public class QtBluetoothLEServer {
         @Override
         public void onNotificationSent(BluetoothDevice device, int status) {
             super.onNotificationSent(device, status);
-            Log.w(TAG, "onNotificationSent" + device + " " + status);
+            handleOnNotificationSent(device, status);
         }
 
         @Override
@@ -731,6 +836,7 @@ public class QtBluetoothLEServer {
 
         clearPendingPreparedWrites(null);
         mPendingServiceAdditions.clear();
+        mNotificationPipelines.clear();
         mGattServer.close();
         mGattServer = null;
 
@@ -791,30 +897,52 @@ public class QtBluetoothLEServer {
 
     /*
         Check the client characteristics configuration for the given characteristic
-        and sends notifications or indications as per required.
+        and sends notifications or indications as per required. All devices share
+        the characteristic's current value.
 
         This function is called from Qt and Java threads and calls must be protected
      */
     private void sendNotificationsOrIndications(BluetoothGattCharacteristic characteristic)
     {
-        final ListIterator<BluetoothDevice> iter =
-                clientCharacteristicManager.getToBeUpdatedDevices(characteristic).listIterator();
-
-        // TODO This quick loop over multiple devices should be synced with onNotificationSent().
-        //      The next notifyCharacteristicChanged() call must wait until onNotificationSent()
-        //      was received. At this becomes an issue when the server accepts multiple remote
-        //      devices at the same time.
-        while (iter.hasNext()) {
-            final BluetoothDevice device = iter.next();
-            final byte[] clientCharacteristicConfig = clientCharacteristicManager.valueFor(characteristic, device);
-            if (clientCharacteristicConfig != null) {
-                if (Arrays.equals(clientCharacteristicConfig, BluetoothGattDescriptor.ENABLE_NOTIFICATION_VALUE)) {
-                    mGattServer.notifyCharacteristicChanged(device, characteristic, false);
-                } else if (Arrays.equals(clientCharacteristicConfig, BluetoothGattDescriptor.ENABLE_INDICATION_VALUE)) {
-                    mGattServer.notifyCharacteristicChanged(device, characteristic, true);
-                }
+        if (mGattServer == null)
+            return;
+
+        for (BluetoothDevice device : clientCharacteristicManager.getToBeUpdatedDevices(characteristic)) {
+            NotificationPipeline pipeline = mNotificationPipelines.get(device);
+            if (pipeline == null) {
+                pipeline = new NotificationPipeline();
+                mNotificationPipelines.put(device, pipeline);
             }
+
+            if (pipeline.inFlight)
+                pipeline.pending.add(characteristic);
+            else
+                pipeline.inFlight = sendNotificationOrIndication(device, characteristic);
+        }
+    }
+
+    // Returns true if onNotificationSent() is to be expected for the device.
+    private boolean sendNotificationOrIndication(BluetoothDevice device,
+                                                 BluetoothGattCharacteristic characteristic)
+    {
+        final byte[] clientCharacteristicConfig = clientCharacteristicManager.valueFor(characteristic, device);
+        if (clientCharacteristicConfig == null)
+            return false;
+
+        boolean confirm;
+        if (Arrays.equals(clientCharacteristicConfig, BluetoothGattDescriptor.ENABLE_NOTIFICATION_VALUE))
+            confirm = false;
+        else if (Arrays.equals(clientCharacteristicConfig, BluetoothGattDescriptor.ENABLE_INDICATION_VALUE))
+            confirm = true;
+        else
+            return false;
+
+        if (!mGattServer.notifyCharacteristicChanged(device, characteristic, confirm)) {
+            Log.w(TAG, "Sending " + (confirm ? "indication" : "notification") + " to "
+                  + device + " failed");
+            return false;
         }
+        return true;
     }
 
     /*
@@ -950,10 +1078,5 @@ public class QtBluetoothLEServer {
     public native void leServerConnectionStateChange(long qtObject, int errorCode, int newState);
     public native void leMtuChanged(long qtObject, int mtu);
     public native void leServerAdvertisementError(long qtObject, int status);
-    public native void leServerCharacteristicChanged(long qtObject,
-                                                     BluetoothGattCharacteristic characteristic,
-                                                     byte[] newValue);
-    public native void leServerDescriptorWritten(long qtObject,
-                                                 BluetoothGattDescriptor descriptor,
-                                                 byte[] newValue);
+    public native void leServerWritesReceived(long qtObject);
 }
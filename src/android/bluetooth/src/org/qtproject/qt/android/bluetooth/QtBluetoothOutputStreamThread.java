@@ -0,0 +1,112 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+package org.qtproject.qt.android.bluetooth;
+
+import java.io.OutputStream;
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import android.util.Log;
+
+@SuppressWarnings("WeakerAccess")
+public class QtBluetoothOutputStreamThread extends Thread
+{
+    /* Pointer to the Qt object that "owns" the Java object */
+    @SuppressWarnings("CanBeFinal")
+    long qtObject = 0;
+    @SuppressWarnings("CanBeFinal")
+    public boolean logEnabled = false;
+    private static final String TAG = "QtBluetooth";
+    private OutputStream m_outputStream = null;
+
+    // Qt writes the outgoing data into this ring, we pass it on to the stream.
+    // Qt tracks both ends of the ring, bytesWritten() releases sent bytes.
+    private static final int RING_CAPACITY = 64 * 1024; // must be a power of two
+    private final ByteBuffer m_ring = ByteBuffer.allocateDirect(RING_CAPACITY);
+    // the small writes queued meanwhile are sent with a single OutputStream.write()
+    private static final int MAX_WRITE_SIZE = 8 * 1024;
+
+    //error codes
+    public static final int QT_MISSING_OUTPUT_STREAM = 0;
+    public static final int QT_WRITE_FAILED = 1;
+    public static final int QT_THREAD_INTERRUPTED = 2;
+
+    public QtBluetoothOutputStreamThread()
+    {
+        setName("QtBtOutputStreamThread");
+    }
+
+    public void setOutputStream(OutputStream stream)
+    {
+        m_outputStream = stream;
+    }
+
+    public ByteBuffer ringBuffer()
+    {
+        return m_ring;
+    }
+
+    // called by Qt once it wrote to an empty ring
+    public synchronized void wakeUp()
+    {
+        notifyAll();
+    }
+
+    private synchronized int waitForData() throws InterruptedException
+    {
+        int pending;
+        while ((pending = pendingData(qtObject)) == 0)
+            wait();
+        return pending;
+    }
+
+    public void run()
+    {
+        if (m_outputStream == null) {
+            errorOccurred(qtObject, QT_MISSING_OUTPUT_STREAM);
+            return;
+        }
+
+        byte[] buffer = new byte[MAX_WRITE_SIZE];
+        int readIndex = 0;
+        int pending = 0;
+
+        try {
+            while (!isInterrupted()) {
+                if (pending == 0)
+                    pending = waitForData();
+
+                final int size = Math.min(pending, buffer.length);
+                final int firstPart = Math.min(size, RING_CAPACITY - readIndex);
+                m_ring.position(readIndex);
+                m_ring.get(buffer, 0, firstPart);
+                if (firstPart < size) {
+                    m_ring.position(0);
+                    m_ring.get(buffer, firstPart, size - firstPart);
+                }
+                readIndex = (readIndex + size) & (RING_CAPACITY - 1);
+
+                //this blocks until the stack took the data
+                //or close() on related BluetoothSocket is called
+                m_outputStream.write(buffer, 0, size);
+
+                pending = bytesWritten(qtObject, size);
+            }
+
+            errorOccurred(qtObject, QT_THREAD_INTERRUPTED);
+        } catch (InterruptedException ex) {
+            errorOccurred(qtObject, QT_THREAD_INTERRUPTED);
+        } catch (IOException ex) {
+            if (logEnabled)
+                Log.d(TAG, "OutputStream.write() failed:" + ex.toString());
+            errorOccurred(qtObject, QT_WRITE_FAILED);
+        }
+
+        if (logEnabled)
+            Log.d(TAG, "Leaving output stream thread");
+    }
+
+    public static native void errorOccurred(long qtObject, int errorCode);
+    public static native int bytesWritten(long qtObject, int bytesWritten);
+    public static native int pendingData(long qtObject);
+}
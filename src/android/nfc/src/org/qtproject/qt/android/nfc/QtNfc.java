@@ -14,6 +14,7 @@ import android.app.PendingIntent;
 import android.content.Intent;
 import android.content.IntentFilter;
 import android.nfc.NfcAdapter;
+import android.nfc.Tag;
 import android.content.IntentFilter.MalformedMimeTypeException;
 import android.os.Bundle;
 import android.os.Build;
@@ -30,6 +31,7 @@ public class QtNfc
     static public IntentFilter[] m_filters;
     static public Context m_context = null;
     static public Activity m_activity = null;
+    static private boolean m_readerMode = false;
 
     static public void setContext(Context context)
     {
@@ -114,6 +116,39 @@ public class QtNfc
         return true;
     }
 
+    static public boolean startReaderMode(final boolean skipNdefCheck)
+    {
+        if (m_adapter == null || m_activity == null
+               || !m_activity.getPackageManager().hasSystemFeature(PackageManager.FEATURE_NFC))
+            return false;
+
+        m_activity.runOnUiThread(new Runnable() {
+            public void run() {
+                //Log.d(TAG, "Enabling NFC reader mode");
+                int flags = NfcAdapter.FLAG_READER_NFC_A | NfcAdapter.FLAG_READER_NFC_B
+                          | NfcAdapter.FLAG_READER_NFC_F | NfcAdapter.FLAG_READER_NFC_V;
+                // Without the NDEF check, the tag does not offer the Ndef technology.
+                if (skipNdefCheck)
+                    flags |= NfcAdapter.FLAG_READER_SKIP_NDEF_CHECK;
+                try {
+                    m_adapter.enableReaderMode(m_activity, new NfcAdapter.ReaderCallback() {
+                        public void onTagDiscovered(Tag tag) {
+                            // Wrapped like a dispatched tag, without going through the intent system
+                            Intent intent = new Intent(NfcAdapter.ACTION_TAG_DISCOVERED);
+                            intent.putExtra(NfcAdapter.EXTRA_TAG, tag);
+                            jniOnTagDiscovered(intent);
+                        }
+                    }, flags, null);
+                    m_readerMode = true;
+                } catch(IllegalStateException e) {
+                    // On Android we must call enableReaderMode when the activity is in foreground, only.
+                    Log.d(TAG, "enableReaderMode failed: " + e.toString());
+                }
+            }
+        });
+        return true;
+    }
+
     static public boolean stop()
     {
         if (m_adapter == null || m_activity == null
@@ -124,7 +159,12 @@ public class QtNfc
             public void run() {
                 //Log.d(TAG, "Disabling NFC");
                 try {
-                    m_adapter.disableForegroundDispatch(m_activity);
+                    if (m_readerMode) {
+                        m_adapter.disableReaderMode(m_activity);
+                        m_readerMode = false;
+                    } else {
+                        m_adapter.disableForegroundDispatch(m_activity);
+                    }
                 } catch(IllegalStateException e) {
                     // On Android we must call disableForegroundDispatch when the activity is in foreground, only.
                     Log.d(TAG, "disableForegroundDispatch failed: " + e.toString());
@@ -163,4 +203,6 @@ public class QtNfc
             return null;
         }
     }
+
+    static private native void jniOnTagDiscovered(Intent intent);
 }
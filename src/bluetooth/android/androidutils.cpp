@@ -43,4 +43,25 @@ bool ensureAndroidPermission(BluetoothPermission permission)
      return false;
 }
 
+jbyteArray toJavaByteArray(JNIEnv *env, QByteArrayView data)
+{
+    jbyteArray array = env->NewByteArray(jsize(data.size()));
+    if (array && !data.isEmpty()) {
+        env->SetByteArrayRegion(array, 0, jsize(data.size()),
+                                reinterpret_cast<const jbyte *>(data.data()));
+    }
+    return array;
+}
+
+QByteArray fromJavaByteArray(JNIEnv *env, jbyteArray array)
+{
+    if (!array) // empty Java byte array is 0x0
+        return QByteArray();
+
+    const jsize length = env->GetArrayLength(array);
+    QByteArray result(length, Qt::Uninitialized);
+    env->GetByteArrayRegion(array, 0, length, reinterpret_cast<jbyte *>(result.data()));
+    return result;
+}
+
 QT_END_NAMESPACE
@@ -16,7 +16,10 @@
 //
 
 #include <qglobal.h>
+#include <QtCore/QByteArray>
+#include <QtCore/QJniObject>
 #include <QtCore/QString>
+#include <jni.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -30,6 +33,11 @@ enum class BluetoothPermission {
 // Returns true if permission is successfully authorized
 bool ensureAndroidPermission(BluetoothPermission permission);
 
+// Returns a new local reference to a Java array holding a copy of data.
+jbyteArray toJavaByteArray(JNIEnv *env, QByteArrayView data);
+// Copies the content of a Java array, a null array yields an empty QByteArray.
+QByteArray fromJavaByteArray(JNIEnv *env, jbyteArray array);
+
 QT_END_NAMESPACE
 
 #endif // QANDROIDBLUETOOTHUTILS_H
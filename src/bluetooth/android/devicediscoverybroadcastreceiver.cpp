@@ -4,14 +4,15 @@
 
 #include "android/devicediscoverybroadcastreceiver_p.h"
 #include <QCoreApplication>
-#include <QtCore/QtEndian>
 #include <QtCore/QLoggingCategory>
 #include <QtBluetooth/QBluetoothAddress>
 #include <QtBluetooth/QBluetoothDeviceInfo>
 #include <QtBluetooth/QBluetoothUuid>
 #include "android/jni_android_p.h"
+#include "qbluetoothdeviceinfo_p.h"
 #include <QtCore/QHash>
 #include <QtCore/qbitarray.h>
+#include <QtCore/qvarlengtharray.h>
 #include <algorithm>
 
 QT_BEGIN_NAMESPACE
@@ -201,35 +202,6 @@ static const MinorClassJavaToQtMapping minorMappings[] = {
     { nullptr, 0 }, // index 64 & separator
 };
 
-/*
-    Advertising Data Type (AD type) for LE scan records, as defined in
-    https://www.bluetooth.com/specifications/assigned-numbers/generic-access-profile
-*/
-enum ADType {
-    ADType16BitUuidIncomplete = 0x02,
-    ADType16BitUuidComplete = 0x03,
-    ADType32BitUuidIncomplete = 0x04,
-    ADType32BitUuidComplete = 0x05,
-    ADType128BitUuidIncomplete = 0x06,
-    ADType128BitUuidComplete = 0x07,
-    ADTypeShortenedLocalName = 0x08,
-    ADTypeCompleteLocalName = 0x09,
-    ADTypeServiceData16Bit = 0x16,
-    ADTypeServiceData32Bit = 0x20,
-    ADTypeServiceData128Bit = 0x21,
-    ADTypeManufacturerSpecificData = 0xff,
-    // .. more will be added when required
-};
-
-// Endianness conversion for quint128 doesn't exist in qtendian.h
-inline quint128 qbswap(const quint128 src)
-{
-    quint128 dst;
-    for (int i = 0; i < 16; i++)
-        dst.data[i] = src.data[15 - i];
-    return dst;
-}
-
 QBluetoothDeviceInfo::CoreConfigurations qtBtTypeForJavaBtType(jint javaType)
 {
     const JCachedBtTypes::iterator it = cachedBtTypes()->find(javaType);
@@ -406,18 +378,43 @@ void DeviceDiscoveryBroadcastReceiver::onReceive(JNIEnv *env, jobject context, j
 
 // Runs in Java thread
 void DeviceDiscoveryBroadcastReceiver::onReceiveLeScan(
-        JNIEnv */*env*/, jobject jBluetoothDevice, jint rssi, jbyteArray scanRecord)
+        JNIEnv *env, jobject jBluetoothDevice, jint rssi, jbyteArray scanRecord)
 {
     const QJniObject bluetoothDevice(jBluetoothDevice);
     if (!bluetoothDevice.isValid())
         return;
 
-    const QBluetoothDeviceInfo info = retrieveDeviceInfo(bluetoothDevice, rssi, scanRecord);
-    if (info.isValid())
-        emit deviceDiscovered(info, true);
+    // A device advertises many times per second. Its name, class and type are
+    // only queried from Java the first time, afterwards each advertisement
+    // costs a single call and a copy of the scan record.
+    const QBluetoothAddress deviceAddress(
+            bluetoothDevice.callObjectMethod<jstring>("getAddress").toString());
+    auto cached = leDeviceCache.constFind(deviceAddress);
+    if (cached == leDeviceCache.cend()) {
+        const QBluetoothDeviceInfo deviceInfo = retrieveDeviceInfo(bluetoothDevice, rssi);
+        if (!deviceInfo.isValid())
+            return;
+        if (leDeviceCache.size() >= maxCachedLeDevices)
+            leDeviceCache.clear();
+        cached = leDeviceCache.insert(deviceAddress, deviceInfo);
+    }
+
+    QBluetoothDeviceInfo info = cached.value();
+    info.setRssi(rssi);
+    if (scanRecord != nullptr) {
+        const jsize length = env->GetArrayLength(scanRecord);
+        QVarLengthArray<char, 62> record(length);
+        env->GetByteArrayRegion(scanRecord, 0, length, reinterpret_cast<jbyte *>(record.data()));
+
+        const QBluetoothEirData eir = QBluetoothEirData::parse(record);
+        if (info.name().isEmpty())
+            info.setName(eir.name);
+        eir.applyTo(&info);
+    }
+    emit deviceDiscovered(info, true);
 }
 
-QBluetoothDeviceInfo DeviceDiscoveryBroadcastReceiver::retrieveDeviceInfo(const QJniObject &bluetoothDevice, int rssi, jbyteArray scanRecord)
+QBluetoothDeviceInfo DeviceDiscoveryBroadcastReceiver::retrieveDeviceInfo(const QJniObject &bluetoothDevice, int rssi)
 {
     const QString deviceName = bluetoothDevice.callObjectMethod<jstring>("getName").toString();
     const QBluetoothAddress deviceAddress(bluetoothDevice.callObjectMethod<jstring>("getAddress").toString());
@@ -463,102 +460,6 @@ QBluetoothDeviceInfo DeviceDiscoveryBroadcastReceiver::retrieveDeviceInfo(const
     QBluetoothDeviceInfo info(deviceAddress, deviceName, classType);
     info.setRssi(rssi);
     QJniEnvironment env;
-    if (scanRecord != nullptr) {
-        // Parse scan record
-        jboolean isCopy;
-        jbyte *elems = env->GetByteArrayElements(scanRecord, &isCopy);
-        const char *scanRecordBuffer = reinterpret_cast<const char *>(elems);
-        const jsize scanRecordLength = env->GetArrayLength(scanRecord);
-
-        QList<QBluetoothUuid> serviceUuids;
-        jsize i = 0;
-
-        // Spec 4.2, Vol 3, Part C, Chapter 11
-        QString localName;
-        while (i < scanRecordLength) {
-            // sizeof(EIR Data) = sizeof(Length) + sizeof(EIR data Type) + sizeof(EIR Data)
-            // Length = sizeof(EIR data Type) + sizeof(EIR Data)
-
-            const int nBytes = scanRecordBuffer[i];
-            if (nBytes == 0)
-                break;
-
-            if (i >= scanRecordLength - nBytes)
-                break;
-
-            const int adType = scanRecordBuffer[i+1];
-            const char *dataPtr = &scanRecordBuffer[i+2];
-            QBluetoothUuid foundService;
-
-            switch (adType) {
-            case ADType16BitUuidIncomplete:
-            case ADType16BitUuidComplete:
-                foundService = QBluetoothUuid(qFromLittleEndian<quint16>(dataPtr));
-                break;
-            case ADType32BitUuidIncomplete:
-            case ADType32BitUuidComplete:
-                foundService = QBluetoothUuid(qFromLittleEndian<quint32>(dataPtr));
-                break;
-            case ADType128BitUuidIncomplete:
-            case ADType128BitUuidComplete:
-                foundService =
-                    QBluetoothUuid(qToBigEndian<quint128>(qFromLittleEndian<quint128>(dataPtr)));
-                break;
-            case ADTypeServiceData16Bit:
-                if (nBytes >= 3) {
-                    info.setServiceData(QBluetoothUuid(qFromLittleEndian<quint16>(dataPtr)),
-                                        QByteArray(dataPtr + 2, nBytes - 3));
-                }
-                break;
-            case ADTypeServiceData32Bit:
-                if (nBytes >= 5) {
-                    info.setServiceData(QBluetoothUuid(qFromLittleEndian<quint32>(dataPtr)),
-                                        QByteArray(dataPtr + 4, nBytes - 5));
-                }
-                break;
-            case ADTypeServiceData128Bit:
-                if (nBytes >= 17) {
-                    info.setServiceData(QBluetoothUuid(qToBigEndian<quint128>(
-                                                qFromLittleEndian<quint128>(dataPtr))),
-                                        QByteArray(dataPtr + 16, nBytes - 17));
-                }
-                break;
-            case ADTypeManufacturerSpecificData:
-                if (nBytes >= 3) {
-                    info.setManufacturerData(qFromLittleEndian<quint16>(dataPtr),
-                                              QByteArray(dataPtr + 2, nBytes - 3));
-                }
-                break;
-            // According to Spec 5.0, Vol 3, Part C, Chapter 12.1
-            // the device's local  name is utf8 encoded
-            case ADTypeShortenedLocalName:
-                if (localName.isEmpty())
-                    localName = QString::fromUtf8(dataPtr, nBytes - 1);
-                break;
-            case ADTypeCompleteLocalName:
-                localName = QString::fromUtf8(dataPtr, nBytes - 1);
-                break;
-            default:
-                // qWarning() << "Unhandled AD Type" << Qt::hex << adType;
-                // no other types supported yet and therefore skipped
-                // https://www.bluetooth.com/specifications/assigned-numbers/generic-access-profile
-                break;
-            }
-
-            i += nBytes + 1;
-
-            if (!foundService.isNull() && !serviceUuids.contains(foundService))
-                serviceUuids.append(foundService);
-        }
-
-        if (info.name().isEmpty())
-            info.setName(localName);
-
-        info.setServiceUuids(serviceUuids);
-
-        env->ReleaseByteArrayElements(scanRecord, elems, JNI_ABORT);
-    }
-
     auto methodId = env.findMethod(bluetoothDevice.objectClass(), "getType", "()I");
     jint javaBtType = env->CallIntMethod(bluetoothDevice.object(), methodId);
     if (!env.checkAndClearExceptions()) {
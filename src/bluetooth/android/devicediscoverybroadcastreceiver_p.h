@@ -18,11 +18,11 @@
 
 #include "android/androidbroadcastreceiver_p.h"
 #include <QtBluetooth/QBluetoothDeviceDiscoveryAgent>
+#include <QtBluetooth/QBluetoothDeviceInfo>
+#include <QtCore/QHash>
 
 QT_BEGIN_NAMESPACE
 
-class QBluetoothDeviceInfo;
-
 class DeviceDiscoveryBroadcastReceiver : public AndroidBroadcastReceiver
 {
     Q_OBJECT
@@ -37,8 +37,12 @@ signals:
     void finished();
 
 private:
-    QBluetoothDeviceInfo retrieveDeviceInfo(const QJniObject& bluetoothDevice,
-                                            int rssi, jbyteArray scanRecord = nullptr);
+    QBluetoothDeviceInfo retrieveDeviceInfo(const QJniObject& bluetoothDevice, int rssi);
+
+    // bounds the memory a long scan among changing random addresses can take
+    static constexpr qsizetype maxCachedLeDevices = 256;
+    // what the Java device objects report about LE devices, only used on the scan thread
+    QHash<QBluetoothAddress, QBluetoothDeviceInfo> leDeviceCache;
 };
 
 QT_END_NAMESPACE
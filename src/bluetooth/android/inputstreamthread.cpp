@@ -8,6 +8,8 @@
 #include "android/inputstreamthread_p.h"
 #include "qbluetoothsocket_android_p.h"
 
+#include <cstring>
+
 QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT_ANDROID)
@@ -27,6 +29,20 @@ bool InputStreamThread::run()
 
     javaInputStreamThread.callMethod<void>("setInputStream", "(Ljava/io/InputStream;)V",
                                            m_socket_p->inputStream.object<jobject>());
+
+    ringBuffer = javaInputStreamThread.callObjectMethod("ringBuffer", "()Ljava/nio/ByteBuffer;");
+    if (!ringBuffer.isValid())
+        return false;
+
+    QJniEnvironment env;
+    ringData = static_cast<char *>(env->GetDirectBufferAddress(ringBuffer.object()));
+    ringCapacity = env->GetDirectBufferCapacity(ringBuffer.object());
+    // the indices wrap at 2^32, which only lines up with a power of two capacity
+    if (!ringData || ringCapacity <= 0 || (ringCapacity & (ringCapacity - 1))) {
+        qCWarning(QT_BT_ANDROID) << "Invalid input stream ring buffer" << ringCapacity;
+        return false;
+    }
+
     javaInputStreamThread.setField<jlong>("qtObject", reinterpret_cast<long>(this));
     javaInputStreamThread.setField<jboolean>("logEnabled", QT_BT_ANDROID().isDebugEnabled());
 
@@ -37,24 +53,49 @@ bool InputStreamThread::run()
 
 qint64 InputStreamThread::bytesAvailable() const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_socket_p->rxBuffer.size();
+    return quint32(tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed));
 }
 
 bool InputStreamThread::canReadLine() const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_socket_p->rxBuffer.canReadLine();
+    const quint32 current = head.load(std::memory_order_relaxed);
+    const qint64 available = quint32(tail.load(std::memory_order_acquire) - current);
+    if (available == 0)
+        return false;
+
+    const qint64 offset = current & (ringCapacity - 1);
+    const qint64 first = qMin(available, ringCapacity - offset);
+
+    return memchr(ringData + offset, '\n', first)
+            || memchr(ringData, '\n', available - first);
 }
 
 qint64 InputStreamThread::readData(char *data, qint64 maxSize)
 {
-    QMutexLocker locker(&m_mutex);
-
-    if (!m_socket_p->rxBuffer.isEmpty())
-        return m_socket_p->rxBuffer.read(data, maxSize);
+    const quint32 current = head.load(std::memory_order_relaxed);
+    const qint64 available = quint32(tail.load(std::memory_order_acquire) - current);
+    const qint64 size = qMin(maxSize, available);
+    if (size <= 0)
+        return 0;
+
+    const qint64 offset = current & (ringCapacity - 1);
+    const qint64 first = qMin(size, ringCapacity - offset);
+    memcpy(data, ringData + offset, first);
+    memcpy(data + first, ringData, size - first);
+
+    // pairs with javaFreeSpace(), either the Java thread sees the new head
+    // or this sees that it is about to wait
+    head.store(current + quint32(size), std::memory_order_seq_cst);
+    if (stalled.exchange(false, std::memory_order_seq_cst))
+        javaInputStreamThread.callMethod<void>("wakeUp");
+
+    return size;
+}
 
-    return 0;
+qint64 InputStreamThread::freeSpace() const
+{
+    return ringCapacity
+            - quint32(tail.load(std::memory_order_relaxed) - head.load(std::memory_order_seq_cst));
 }
 
 //inside the java thread
@@ -69,20 +110,28 @@ void InputStreamThread::javaThreadErrorOccurred(int errorCode)
 }
 
 //inside the java thread
-void InputStreamThread::javaReadyRead(jbyteArray buffer, int bufferLength)
+int InputStreamThread::javaReadyRead(int bytesWritten)
 {
-    QJniEnvironment env;
-
-    QMutexLocker lock(&m_mutex);
-    char *writePtr = m_socket_p->rxBuffer.reserve(bufferLength);
-    env->GetByteArrayRegion(buffer, 0, bufferLength, reinterpret_cast<jbyte*>(writePtr));
+    // the Java thread wrote the bytes before it called in here
+    tail.fetch_add(quint32(bytesWritten), std::memory_order_release);
     emit dataAvailable();
+    return int(freeSpace());
+}
+
+//inside the java thread
+int InputStreamThread::javaFreeSpace()
+{
+    stalled.store(true, std::memory_order_seq_cst);
+    return int(freeSpace());
 }
 
 void InputStreamThread::prepareForClosure()
 {
     QMutexLocker lock(&m_mutex);
     expectClosure = true;
+    // BluetoothSocket.close() does not end a wait for space in the ring
+    if (javaInputStreamThread.isValid())
+        javaInputStreamThread.callMethod<void>("interrupt");
 }
 
 QT_END_NAMESPACE
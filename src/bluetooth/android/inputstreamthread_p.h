@@ -22,10 +22,18 @@
 #include <QtCore/private/qglobal_p.h>
 #include <jni.h>
 
+#include <atomic>
+
 QT_BEGIN_NAMESPACE
 
 class QBluetoothSocketPrivateAndroid;
 
+/*
+ * Receives the data of an RFCOMM socket from QtBluetoothInputStreamThread.java.
+ * The Java thread writes into a direct ByteBuffer ring it allocated and the
+ * socket reads the ring's memory in place. The Java thread only writes while
+ * the ring has space and otherwise waits until readData() made room.
+ */
 class InputStreamThread : public QObject
 {
     Q_OBJECT
@@ -38,7 +46,10 @@ public:
 
     qint64 readData(char *data, qint64 maxSize);
     void javaThreadErrorOccurred(int errorCode);
-    void javaReadyRead(jbyteArray buffer, int bufferLength);
+    // Publishes bytes written to the ring, returns the remaining space.
+    int javaReadyRead(int bytesWritten);
+    // Returns the space in the ring, readData() wakes the Java thread when it was 0.
+    int javaFreeSpace();
 
     void prepareForClosure();
 
@@ -47,8 +58,18 @@ signals:
     void errorOccurred(int errorCode);
 
 private:
+    qint64 freeSpace() const;
+
     QBluetoothSocketPrivateAndroid *m_socket_p;
     QJniObject javaInputStreamThread;
+    // keeps the ring alive while the Java thread might still write to it
+    QJniObject ringBuffer;
+    char *ringData = nullptr;
+    qint64 ringCapacity = 0;
+    // head is written by readData() only, tail by the Java thread only
+    std::atomic<quint32> head = 0;
+    std::atomic<quint32> tail = 0;
+    std::atomic<bool> stalled = false;
     mutable QMutex m_mutex;
     bool expectClosure;
 };
@@ -5,11 +5,13 @@
 #include <jni.h>
 #include <android/log.h>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QVarLengthArray>
 #include <QtBluetooth/qtbluetoothglobal.h>
 #include "android/jni_android_p.h"
 #include "android/androidbroadcastreceiver_p.h"
 #include "android/serveracceptancethread_p.h"
 #include "android/inputstreamthread_p.h"
+#include "android/outputstreamthread_p.h"
 #include "android/lowenergynotificationhub_p.h"
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT_ANDROID)
@@ -143,10 +145,34 @@ static void QtBluetoothInputStreamThread_errorOccurred(JNIEnv */*env*/, jobject
     reinterpret_cast<InputStreamThread*>(qtObject)->javaThreadErrorOccurred(errorCode);
 }
 
-static void QtBluetoothInputStreamThread_readyData(JNIEnv */*env*/, jobject /*javaObject*/,
-                                       jlong qtObject, jbyteArray buffer, jint bufferLength)
+static jint QtBluetoothInputStreamThread_readyData(JNIEnv */*env*/, jobject /*javaObject*/,
+                                       jlong qtObject, jint bytesWritten)
 {
-    reinterpret_cast<InputStreamThread*>(qtObject)->javaReadyRead(buffer, bufferLength);
+    return reinterpret_cast<InputStreamThread*>(qtObject)->javaReadyRead(bytesWritten);
+}
+
+static jint QtBluetoothInputStreamThread_freeSpace(JNIEnv */*env*/, jobject /*javaObject*/,
+                                       jlong qtObject)
+{
+    return reinterpret_cast<InputStreamThread*>(qtObject)->javaFreeSpace();
+}
+
+static void QtBluetoothOutputStreamThread_errorOccurred(JNIEnv */*env*/, jobject /*javaObject*/,
+                                           jlong qtObject, jint errorCode)
+{
+    reinterpret_cast<OutputStreamThread*>(qtObject)->javaThreadErrorOccurred(errorCode);
+}
+
+static jint QtBluetoothOutputStreamThread_bytesWritten(JNIEnv */*env*/, jobject /*javaObject*/,
+                                       jlong qtObject, jint bytesWritten)
+{
+    return reinterpret_cast<OutputStreamThread*>(qtObject)->javaBytesWritten(bytesWritten);
+}
+
+static jint QtBluetoothOutputStreamThread_pendingData(JNIEnv */*env*/, jobject /*javaObject*/,
+                                       jlong qtObject)
+{
+    return reinterpret_cast<OutputStreamThread*>(qtObject)->javaPendingData();
 }
 
 void QtBluetoothLE_leScanResult(JNIEnv *env, jobject, jlong qtObject, jobject bluetoothDevice,
@@ -160,6 +186,28 @@ void QtBluetoothLE_leScanResult(JNIEnv *env, jobject, jlong qtObject, jobject bl
                                                                 scanRecord);
 }
 
+void QtBluetoothLE_leScanResults(JNIEnv *env, jobject, jlong qtObject, jobjectArray bluetoothDevices,
+                                 jintArray rssis, jobjectArray scanRecords)
+{
+    if (Q_UNLIKELY(qtObject == 0))
+        return;
+
+    const jsize count = env->GetArrayLength(bluetoothDevices);
+    QVarLengthArray<jint, 64> rssiValues(count);
+    env->GetIntArrayRegion(rssis, 0, count, rssiValues.data());
+
+    AndroidBroadcastReceiver *receiver = reinterpret_cast<AndroidBroadcastReceiver*>(qtObject);
+    for (jsize i = 0; i < count; ++i) {
+        jobject bluetoothDevice = env->GetObjectArrayElement(bluetoothDevices, i);
+        jobject scanRecord = env->GetObjectArrayElement(scanRecords, i);
+        receiver->onReceiveLeScan(env, bluetoothDevice, rssiValues[i],
+                                  static_cast<jbyteArray>(scanRecord));
+        // a batch may hold more results than the local reference table
+        env->DeleteLocalRef(scanRecord);
+        env->DeleteLocalRef(bluetoothDevice);
+    }
+}
+
 
 static JNINativeMethod methods[] = {
     {"jniOnReceive", "(JLandroid/content/Context;Landroid/content/Intent;)V",
@@ -169,13 +217,17 @@ static JNINativeMethod methods[] = {
 static JNINativeMethod methods_le[] = {
     {"leScanResult", "(JLandroid/bluetooth/BluetoothDevice;I[B)V",
                 (void *) QtBluetoothLE_leScanResult},
+    {"leScanResults", "(J[Landroid/bluetooth/BluetoothDevice;[I[[B)V",
+                (void *) QtBluetoothLE_leScanResults},
     {"leConnectionStateChange", "(JII)V",
                 (void *) LowEnergyNotificationHub::lowEnergy_connectionChange},
     {"leMtuChanged", "(JI)V",
                 (void *) LowEnergyNotificationHub::lowEnergy_mtuChanged},
+    {"lePhyUpdated", "(JII)V",
+                (void *) LowEnergyNotificationHub::lowEnergy_phyUpdated},
     {"leServicesDiscovered", "(JILjava/lang/String;)V",
                 (void *) LowEnergyNotificationHub::lowEnergy_servicesDiscovered},
-    {"leServiceDetailDiscoveryFinished", "(JLjava/lang/String;II)V",
+    {"leServiceDetailDiscoveryFinished", "(JLjava/lang/String;II[B)V",
                 (void *) LowEnergyNotificationHub::lowEnergy_serviceDetailsDiscovered},
     {"leCharacteristicRead", "(JLjava/lang/String;ILjava/lang/String;I[B)V",
                 (void *) LowEnergyNotificationHub::lowEnergy_characteristicRead},
@@ -185,8 +237,8 @@ static JNINativeMethod methods_le[] = {
                 (void *) LowEnergyNotificationHub::lowEnergy_characteristicWritten},
     {"leDescriptorWritten", "(JI[BI)V",
                 (void *) LowEnergyNotificationHub::lowEnergy_descriptorWritten},
-    {"leCharacteristicChanged", "(JI[B)V",
-                (void *) LowEnergyNotificationHub::lowEnergy_characteristicChanged},
+    {"leCharacteristicsChanged", "(J)V",
+                (void *) LowEnergyNotificationHub::lowEnergy_characteristicsChanged},
     {"leServiceError", "(JII)V",
                 (void *) LowEnergyNotificationHub::lowEnergy_serviceError},
 };
@@ -198,10 +250,8 @@ static JNINativeMethod methods_leServer[] = {
                 (void *) LowEnergyNotificationHub::lowEnergy_mtuChanged},
     {"leServerAdvertisementError", "(JI)V",
                 (void *) LowEnergyNotificationHub::lowEnergy_advertisementError},
-    {"leServerCharacteristicChanged", "(JLandroid/bluetooth/BluetoothGattCharacteristic;[B)V",
-                (void *) LowEnergyNotificationHub::lowEnergy_serverCharacteristicChanged},
-    {"leServerDescriptorWritten", "(JLandroid/bluetooth/BluetoothGattDescriptor;[B)V",
-                (void *) LowEnergyNotificationHub::lowEnergy_serverDescriptorWritten},
+    {"leServerWritesReceived", "(J)V",
+                (void *) LowEnergyNotificationHub::lowEnergy_serverWritesReceived},
 };
 
 static JNINativeMethod methods_server[] = {
@@ -214,8 +264,19 @@ static JNINativeMethod methods_server[] = {
 static JNINativeMethod methods_inputStream[] = {
         {"errorOccurred", "(JI)V",
                     (void *) QtBluetoothInputStreamThread_errorOccurred},
-        {"readyData", "(J[BI)V",
+        {"readyData", "(JI)I",
                     (void *) QtBluetoothInputStreamThread_readyData},
+        {"freeSpace", "(J)I",
+                    (void *) QtBluetoothInputStreamThread_freeSpace},
+};
+
+static JNINativeMethod methods_outputStream[] = {
+        {"errorOccurred", "(JI)V",
+                    (void *) QtBluetoothOutputStreamThread_errorOccurred},
+        {"bytesWritten", "(JI)I",
+                    (void *) QtBluetoothOutputStreamThread_bytesWritten},
+        {"pendingData", "(J)I",
+                    (void *) QtBluetoothOutputStreamThread_pendingData},
 };
 
 static const char logTag[] = "QtBluetooth";
@@ -263,6 +324,13 @@ static bool registerNatives(JNIEnv *env)
         return false;
     }
 
+    FIND_AND_CHECK_CLASS("org/qtproject/qt/android/bluetooth/QtBluetoothOutputStreamThread");
+    if (env->RegisterNatives(clazz, methods_outputStream,
+                             sizeof(methods_outputStream) / sizeof(methods_outputStream[0])) < 0) {
+        __android_log_print(ANDROID_LOG_FATAL, logTag, "RegisterNatives for OutputStreamThread failed");
+        return false;
+    }
+
     return true;
 }
 
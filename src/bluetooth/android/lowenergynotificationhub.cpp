@@ -2,9 +2,11 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include "lowenergynotificationhub_p.h"
+#include "android/androidutils_p.h"
 
 #include <QCoreApplication>
 #include <QtCore/QHash>
+#include <QtCore/QtEndian>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QRandomGenerator>
 #include <QtCore/QJniEnvironment>
@@ -90,6 +92,19 @@ void LowEnergyNotificationHub::lowEnergy_mtuChanged(
     QMetaObject::invokeMethod(hub, "mtuChanged", Qt::QueuedConnection, Q_ARG(int, mtu));
 }
 
+void LowEnergyNotificationHub::lowEnergy_phyUpdated(
+        JNIEnv *, jobject, jlong qtObject, jint txPhy, jint rxPhy)
+{
+    lock.lockForRead();
+    LowEnergyNotificationHub *hub = hubMap()->value(qtObject);
+    lock.unlock();
+    if (!hub)
+        return;
+
+    QMetaObject::invokeMethod(hub, "phyUpdated", Qt::QueuedConnection,
+                              Q_ARG(int, txPhy), Q_ARG(int, rxPhy));
+}
+
 void LowEnergyNotificationHub::lowEnergy_servicesDiscovered(
         JNIEnv *, jobject, jlong qtObject, jint errorCode, jobject uuidList)
 {
@@ -107,8 +122,8 @@ void LowEnergyNotificationHub::lowEnergy_servicesDiscovered(
 }
 
 void LowEnergyNotificationHub::lowEnergy_serviceDetailsDiscovered(
-        JNIEnv *, jobject, jlong qtObject, jobject uuid, jint startHandle,
-        jint endHandle)
+        JNIEnv *env, jobject, jlong qtObject, jobject uuid, jint startHandle,
+        jint endHandle, jbyteArray details)
 {
     lock.lockForRead();
     LowEnergyNotificationHub *hub = hubMap()->value(qtObject);
@@ -117,11 +132,14 @@ void LowEnergyNotificationHub::lowEnergy_serviceDetailsDiscovered(
         return;
 
     const QString serviceUuid = QJniObject(uuid).toString();
+    // all characteristics and descriptors of the service in one go
+    const QByteArray serviceDetails = fromJavaByteArray(env, details);
     QMetaObject::invokeMethod(hub, "serviceDetailsDiscoveryFinished",
                               Qt::QueuedConnection,
                               Q_ARG(QString, serviceUuid),
                               Q_ARG(int, startHandle),
-                              Q_ARG(int, endHandle));
+                              Q_ARG(int, endHandle),
+                              Q_ARG(QByteArray, serviceDetails));
 }
 
 void LowEnergyNotificationHub::lowEnergy_characteristicRead(
@@ -142,13 +160,7 @@ void LowEnergyNotificationHub::lowEnergy_characteristicRead(
     if (charUuid.isNull())
         return;
 
-    QByteArray payload;
-    if (data) { //empty Java byte array is 0x0
-        jsize length = env->GetArrayLength(data);
-        payload.resize(length);
-        env->GetByteArrayRegion(data, 0, length,
-                                reinterpret_cast<signed char*>(payload.data()));
-    }
+    const QByteArray payload = fromJavaByteArray(env, data);
 
     QMetaObject::invokeMethod(hub, "characteristicRead", Qt::QueuedConnection,
                               Q_ARG(QBluetoothUuid, serviceUuid),
@@ -178,13 +190,7 @@ void LowEnergyNotificationHub::lowEnergy_descriptorRead(
     if (charUuid.isNull() || descUuid.isNull())
         return;
 
-    QByteArray payload;
-    if (data) { //empty Java byte array is 0x0
-        jsize length = env->GetArrayLength(data);
-        payload.resize(length);
-        env->GetByteArrayRegion(data, 0, length,
-                                reinterpret_cast<signed char*>(payload.data()));
-    }
+    const QByteArray payload = fromJavaByteArray(env, data);
 
     QMetaObject::invokeMethod(hub, "descriptorRead", Qt::QueuedConnection,
                               Q_ARG(QBluetoothUuid, serviceUuid),
@@ -204,13 +210,7 @@ void LowEnergyNotificationHub::lowEnergy_characteristicWritten(
     if (!hub)
         return;
 
-    QByteArray payload;
-    if (data) { //empty Java byte array is 0x0
-        jsize length = env->GetArrayLength(data);
-        payload.resize(length);
-        env->GetByteArrayRegion(data, 0, length,
-                                reinterpret_cast<signed char*>(payload.data()));
-    }
+    const QByteArray payload = fromJavaByteArray(env, data);
 
     QMetaObject::invokeMethod(hub, "characteristicWritten", Qt::QueuedConnection,
                               Q_ARG(int, charHandle),
@@ -229,13 +229,7 @@ void LowEnergyNotificationHub::lowEnergy_descriptorWritten(
     if (!hub)
         return;
 
-    QByteArray payload;
-    if (data) { //empty Java byte array is 0x0
-        jsize length = env->GetArrayLength(data);
-        payload.resize(length);
-        env->GetByteArrayRegion(data, 0, length,
-                                reinterpret_cast<signed char*>(payload.data()));
-    }
+    const QByteArray payload = fromJavaByteArray(env, data);
 
     QMetaObject::invokeMethod(hub, "descriptorWritten", Qt::QueuedConnection,
                               Q_ARG(int, descHandle),
@@ -244,8 +238,8 @@ void LowEnergyNotificationHub::lowEnergy_descriptorWritten(
                                     (QLowEnergyService::ServiceError)errorCode));
 }
 
-void LowEnergyNotificationHub::lowEnergy_serverDescriptorWritten(
-        JNIEnv *env, jobject, jlong qtObject, jobject descriptor, jbyteArray newValue)
+void LowEnergyNotificationHub::lowEnergy_characteristicsChanged(
+        JNIEnv *, jobject, jlong qtObject)
 {
     lock.lockForRead();
     LowEnergyNotificationHub *hub = hubMap()->value(qtObject);
@@ -253,42 +247,40 @@ void LowEnergyNotificationHub::lowEnergy_serverDescriptorWritten(
     if (!hub)
         return;
 
-    QByteArray payload;
-    if (newValue) { //empty Java byte array is 0x0
-        jsize length = env->GetArrayLength(newValue);
-        payload.resize(length);
-        env->GetByteArrayRegion(newValue, 0, length,
-                                reinterpret_cast<signed char*>(payload.data()));
-    }
-
-    QMetaObject::invokeMethod(hub, "serverDescriptorWritten", Qt::QueuedConnection,
-                              Q_ARG(QJniObject, descriptor),
-                              Q_ARG(QByteArray, payload));
+    // the changes are taken once this is processed, including any that arrive meanwhile
+    QMetaObject::invokeMethod(hub, &LowEnergyNotificationHub::takeCharacteristicChanges,
+                              Qt::QueuedConnection);
 }
 
-void LowEnergyNotificationHub::lowEnergy_characteristicChanged(
-        JNIEnv *env, jobject, jlong qtObject, jint charHandle, jbyteArray data)
+void LowEnergyNotificationHub::takeCharacteristicChanges()
 {
-    lock.lockForRead();
-    LowEnergyNotificationHub *hub = hubMap()->value(qtObject);
-    lock.unlock();
-    if (!hub)
+    const QJniObject batch = jBluetoothLe.callObjectMethod("takeNotificationBatch",
+                                                           "()Ljava/nio/ByteBuffer;");
+    if (!batch.isValid())
         return;
 
-    QByteArray payload;
-    if (data) { //empty Java byte array is 0x0
-        jsize length = env->GetArrayLength(data);
-        payload.resize(length);
-        env->GetByteArrayRegion(data, 0, length,
-                                reinterpret_cast<signed char*>(payload.data()));
-    }
+    QJniEnvironment env;
+    const char *data = static_cast<const char *>(env->GetDirectBufferAddress(batch.object()));
+    const jint size = batch.callMethod<jint>("limit");
+    if (!data || size <= 0)
+        return;
+
+    // each entry is the handle and value length in native byte order, followed by the value
+    constexpr qsizetype headerSize = 2 * sizeof(qint32);
+    QByteArrayView remaining(data, size);
+    while (remaining.size() >= headerSize) {
+        const int charHandle = qFromUnaligned<qint32>(remaining.data());
+        const qsizetype length = qFromUnaligned<qint32>(remaining.data() + sizeof(qint32));
+        if (length < 0 || remaining.size() - headerSize < length)
+            break;
 
-    QMetaObject::invokeMethod(hub, "characteristicChanged", Qt::QueuedConnection,
-                              Q_ARG(int, charHandle), Q_ARG(QByteArray, payload));
+        emit characteristicChanged(charHandle, remaining.sliced(headerSize, length).toByteArray());
+        remaining = remaining.sliced(headerSize + length);
+    }
 }
 
-void LowEnergyNotificationHub::lowEnergy_serverCharacteristicChanged(
-        JNIEnv *env, jobject, jlong qtObject, jobject characteristic, jbyteArray newValue)
+void LowEnergyNotificationHub::lowEnergy_serverWritesReceived(
+        JNIEnv *, jobject, jlong qtObject)
 {
     lock.lockForRead();
     LowEnergyNotificationHub *hub = hubMap()->value(qtObject);
@@ -296,17 +288,49 @@ void LowEnergyNotificationHub::lowEnergy_serverCharacteristicChanged(
     if (!hub)
         return;
 
-    QByteArray payload;
-    if (newValue) { //empty Java byte array is 0x0
-        jsize length = env->GetArrayLength(newValue);
-        payload.resize(length);
-        env->GetByteArrayRegion(newValue, 0, length,
-                                reinterpret_cast<signed char*>(payload.data()));
-    }
+    // the writes are taken once this is processed, including any that arrive meanwhile
+    QMetaObject::invokeMethod(hub, &LowEnergyNotificationHub::takeServerWrites,
+                              Qt::QueuedConnection);
+}
 
-    QMetaObject::invokeMethod(hub, "serverCharacteristicChanged", Qt::QueuedConnection,
-                              Q_ARG(QJniObject, characteristic),
-                              Q_ARG(QByteArray, payload));
+void LowEnergyNotificationHub::takeServerWrites()
+{
+    const QJniObject batch = jBluetoothLe.callObjectMethod("takeWriteBatch",
+                                                           "()Ljava/nio/ByteBuffer;");
+    if (!batch.isValid())
+        return;
+    const QJniObject targets = jBluetoothLe.callObjectMethod("takenWriteTargets",
+                                                             "()[Ljava/lang/Object;");
+    if (!targets.isValid())
+        return;
+
+    QJniEnvironment env;
+    const char *data = static_cast<const char *>(env->GetDirectBufferAddress(batch.object()));
+    const jint size = batch.callMethod<jint>("limit");
+    const jobjectArray targetArray = targets.object<jobjectArray>();
+    const jsize targetCount = env->GetArrayLength(targetArray);
+    if (!data || size <= 0)
+        return;
+
+    // each entry is the kind of target and value length in native byte order, followed
+    // by the value, see QtBluetoothLEServer.queueWrite()
+    constexpr qsizetype headerSize = 2 * sizeof(qint32);
+    QByteArrayView remaining(data, size);
+    for (jsize i = 0; i < targetCount && remaining.size() >= headerSize; ++i) {
+        const qint32 kind = qFromUnaligned<qint32>(remaining.data());
+        const qsizetype length = qFromUnaligned<qint32>(remaining.data() + sizeof(qint32));
+        if (length < 0 || remaining.size() - headerSize < length)
+            break;
+
+        const QJniObject target = QJniObject::fromLocalRef(
+                env->GetObjectArrayElement(targetArray, i));
+        const QByteArray value = remaining.sliced(headerSize, length).toByteArray();
+        if (kind == 0)
+            emit serverCharacteristicChanged(target, value);
+        else
+            emit serverDescriptorWritten(target, value);
+        remaining = remaining.sliced(headerSize + length);
+    }
 }
 
 void LowEnergyNotificationHub::lowEnergy_serviceError(
@@ -40,11 +40,14 @@ public:
                                            jint errorCode, jint newState);
     static void lowEnergy_mtuChanged(JNIEnv*, jobject, jlong qtObject,
                                            jint mtu);
+    static void lowEnergy_phyUpdated(JNIEnv*, jobject, jlong qtObject,
+                                     jint txPhy, jint rxPhy);
     static void lowEnergy_servicesDiscovered(JNIEnv*, jobject, jlong qtObject,
                                              jint errorCode, jobject uuidList);
     static void lowEnergy_serviceDetailsDiscovered(JNIEnv *, jobject,
                                                    jlong qtObject, jobject uuid,
-                                                   jint startHandle, jint endHandle);
+                                                   jint startHandle, jint endHandle,
+                                                   jbyteArray details);
     static void lowEnergy_characteristicRead(JNIEnv*env, jobject, jlong qtObject,
                                              jobject serviceUuid,
                                              jint handle, jobject charUuid,
@@ -58,12 +61,8 @@ public:
     static void lowEnergy_descriptorWritten(JNIEnv *, jobject, jlong qtObject,
                                             jint descHandle, jbyteArray data,
                                             jint errorCode);
-    static void lowEnergy_serverDescriptorWritten(JNIEnv *, jobject, jlong qtObject,
-                                                  jobject descriptor, jbyteArray newValue);
-    static void lowEnergy_characteristicChanged(JNIEnv *, jobject, jlong qtObject,
-                                                jint charHandle, jbyteArray data);
-    static void lowEnergy_serverCharacteristicChanged(JNIEnv *, jobject, jlong qtObject,
-                                                jobject characteristic, jbyteArray newValue);
+    static void lowEnergy_characteristicsChanged(JNIEnv *, jobject, jlong qtObject);
+    static void lowEnergy_serverWritesReceived(JNIEnv *, jobject, jlong qtObject);
     static void lowEnergy_serviceError(JNIEnv *, jobject, jlong qtObject,
                                        jint attributeHandle, int errorCode);
     static void lowEnergy_advertisementError(JNIEnv *, jobject, jlong qtObject,
@@ -78,9 +77,10 @@ signals:
     void connectionUpdated(QLowEnergyController::ControllerState newState,
             QLowEnergyController::Error errorCode);
     void mtuChanged(int mtu);
+    void phyUpdated(int txPhy, int rxPhy);
     void servicesDiscovered(QLowEnergyController::Error errorCode, const QString &uuids);
     void serviceDetailsDiscoveryFinished(const QString& serviceUuid,
-            int startHandle, int endHandle);
+            int startHandle, int endHandle, const QByteArray &details);
     void characteristicRead(const QBluetoothUuid &serviceUuid,
             int handle, const QBluetoothUuid &charUuid,
             int properties, const QByteArray &data);
@@ -98,6 +98,9 @@ signals:
 
 public slots:
 private:
+    void takeCharacteristicChanges();
+    void takeServerWrites();
+
     static QReadWriteLock lock;
 
     QJniObject jBluetoothLe;
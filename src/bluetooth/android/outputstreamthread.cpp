@@ -0,0 +1,141 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QJniEnvironment>
+
+#include "android/outputstreamthread_p.h"
+#include "qbluetoothsocket_android_p.h"
+
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_ANDROID)
+
+OutputStreamThread::OutputStreamThread(QBluetoothSocketPrivateAndroid *socket)
+    : QObject(), m_socket_p(socket)
+{
+}
+
+bool OutputStreamThread::run()
+{
+    QMutexLocker lock(&m_mutex);
+
+    javaOutputStreamThread = QJniObject("org/qtproject/qt/android/bluetooth/QtBluetoothOutputStreamThread");
+    if (!javaOutputStreamThread.isValid() || !m_socket_p->outputStream.isValid())
+        return false;
+
+    javaOutputStreamThread.callMethod<void>("setOutputStream", "(Ljava/io/OutputStream;)V",
+                                            m_socket_p->outputStream.object<jobject>());
+
+    ringBuffer = javaOutputStreamThread.callObjectMethod("ringBuffer", "()Ljava/nio/ByteBuffer;");
+    if (!ringBuffer.isValid())
+        return false;
+
+    QJniEnvironment env;
+    ringData = static_cast<char *>(env->GetDirectBufferAddress(ringBuffer.object()));
+    ringCapacity = env->GetDirectBufferCapacity(ringBuffer.object());
+    // the indices wrap at 2^32, which only lines up with a power of two capacity
+    if (!ringData || ringCapacity <= 0 || (ringCapacity & (ringCapacity - 1))) {
+        qCWarning(QT_BT_ANDROID) << "Invalid output stream ring buffer" << ringCapacity;
+        return false;
+    }
+
+    javaOutputStreamThread.setField<jlong>("qtObject", reinterpret_cast<long>(this));
+    javaOutputStreamThread.setField<jboolean>("logEnabled", QT_BT_ANDROID().isDebugEnabled());
+
+    javaOutputStreamThread.callMethod<void>("start");
+
+    return true;
+}
+
+qint64 OutputStreamThread::bytesToWrite() const
+{
+    return quint32(tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire));
+}
+
+/*
+ * Queues all of \a data, waits only while the ring is full. Returns -1
+ * if the Java thread ended before the data could be queued.
+ */
+qint64 OutputStreamThread::writeData(const char *data, qint64 maxSize)
+{
+    for (qint64 written = 0; written < maxSize;) {
+        const quint32 current = tail.load(std::memory_order_relaxed);
+        qint64 space = ringCapacity - quint32(current - head.load(std::memory_order_acquire));
+        if (space == 0) {
+            QMutexLocker lock(&m_mutex);
+            while (!finished
+                   && (space = ringCapacity
+                               - quint32(current - head.load(std::memory_order_acquire))) == 0) {
+                spaceAvailable.wait(&m_mutex);
+            }
+            if (finished)
+                return -1;
+        }
+
+        const qint64 size = qMin(maxSize - written, space);
+        const qint64 offset = current & (ringCapacity - 1);
+        const qint64 first = qMin(size, ringCapacity - offset);
+        memcpy(ringData + offset, data + written, first);
+        memcpy(ringData, data + written + first, size - first);
+        written += size;
+
+        // pairs with javaPendingData(), either the Java thread sees the new tail
+        // or this sees that it is about to wait
+        tail.store(current + quint32(size), std::memory_order_seq_cst);
+        if (stalled.exchange(false, std::memory_order_seq_cst))
+            javaOutputStreamThread.callMethod<void>("wakeUp");
+    }
+
+    return maxSize;
+}
+
+//inside the java thread
+void OutputStreamThread::javaThreadErrorOccurred(int errorCode)
+{
+    QMutexLocker lock(&m_mutex);
+
+    // a writeData() waiting for space gives up
+    finished = true;
+    spaceAvailable.wakeAll();
+
+    if (!expectClosure)
+        emit errorOccurred(errorCode);
+    else
+        emit errorOccurred(-1); // magic error, -1 means error was expected due to expected close()
+}
+
+//inside the java thread
+int OutputStreamThread::javaBytesWritten(int bytesWritten)
+{
+    const quint32 current = head.fetch_add(quint32(bytesWritten), std::memory_order_release)
+            + quint32(bytesWritten);
+    {
+        // the lock orders the new head before the wait of writeData()
+        QMutexLocker lock(&m_mutex);
+        spaceAvailable.wakeAll();
+    }
+    emit bytesWritten(bytesWritten);
+    return int(quint32(tail.load(std::memory_order_acquire) - current));
+}
+
+//inside the java thread
+int OutputStreamThread::javaPendingData()
+{
+    stalled.store(true, std::memory_order_seq_cst);
+    return int(quint32(tail.load(std::memory_order_seq_cst)
+                       - head.load(std::memory_order_relaxed)));
+}
+
+void OutputStreamThread::prepareForClosure()
+{
+    QMutexLocker lock(&m_mutex);
+    expectClosure = true;
+    // BluetoothSocket.close() does not end a wait for queued data
+    if (javaOutputStreamThread.isValid())
+        javaOutputStreamThread.callMethod<void>("interrupt");
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,79 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef OUTPUTSTREAMTHREAD_H
+#define OUTPUTSTREAMTHREAD_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/QObject>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QJniObject>
+#include <QtCore/private/qglobal_p.h>
+#include <jni.h>
+
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+
+class QBluetoothSocketPrivateAndroid;
+
+/*
+ * Sends the data of an RFCOMM socket through QtBluetoothOutputStreamThread.java.
+ * writeData() copies into a direct ByteBuffer ring the Java thread allocated,
+ * the Java thread drains the ring with one OutputStream.write() for all queued
+ * bytes. A slow peer only blocks writeData() once the ring is full.
+ */
+class OutputStreamThread : public QObject
+{
+    Q_OBJECT
+public:
+    explicit OutputStreamThread(QBluetoothSocketPrivateAndroid *socket_p);
+
+    qint64 bytesToWrite() const;
+    bool run();
+
+    qint64 writeData(const char *data, qint64 maxSize);
+    void javaThreadErrorOccurred(int errorCode);
+    // Releases bytes sent from the ring, returns the bytes still queued.
+    int javaBytesWritten(int bytesWritten);
+    // Returns the bytes in the ring, writeData() wakes the Java thread when it was 0.
+    int javaPendingData();
+
+    void prepareForClosure();
+
+signals:
+    void bytesWritten(qint64 bytes);
+    void errorOccurred(int errorCode);
+
+private:
+    QBluetoothSocketPrivateAndroid *m_socket_p;
+    QJniObject javaOutputStreamThread;
+    // keeps the ring alive while the Java thread might still read from it
+    QJniObject ringBuffer;
+    char *ringData = nullptr;
+    qint64 ringCapacity = 0;
+    // tail is written by writeData() only, head by the Java thread only
+    std::atomic<quint32> head = 0;
+    std::atomic<quint32> tail = 0;
+    std::atomic<bool> stalled = false;
+    // writeData() waits here for space in a full ring
+    QMutex m_mutex;
+    QWaitCondition spaceAvailable;
+    bool expectClosure = false;
+    bool finished = false;
+};
+
+QT_END_NAMESPACE
+
+#endif // OUTPUTSTREAMTHREAD_H
@@ -8,10 +8,21 @@
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT_ANDROID)
 
+// The Java thread accepts this many connections beyond the pending connection limit
+// while the application is still busy with earlier ones.
+static constexpr int defaultBacklogSize = 4;
+
 ServerAcceptanceThread::ServerAcceptanceThread(QObject *parent) :
-    QObject(parent), maxPendingConnections(1)
+    QObject(parent), backlogSize(defaultBacklogSize), maxPendingConnections(1)
 {
     qRegisterMetaType<QBluetoothServer::Error>();
+
+    if (Q_UNLIKELY(!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_SERVER_BACKLOG"))) {
+        bool ok = false;
+        const int value = qEnvironmentVariableIntValue("QT_BLUETOOTH_SERVER_BACKLOG", &ok);
+        if (ok && value >= 0)
+            backlogSize = value;
+    }
 }
 
 ServerAcceptanceThread::~ServerAcceptanceThread()
@@ -48,14 +59,28 @@ QJniObject ServerAcceptanceThread::nextPendingConnection()
     QMutexLocker lock(&m_mutex);
     if (pendingSockets.isEmpty())
         return QJniObject();
-    else
-        return pendingSockets.takeFirst();
+
+    const QJniObject socket = pendingSockets.takeFirst();
+    promoteBacklog();
+    return socket;
 }
 
 void ServerAcceptanceThread::setMaxPendingConnections(int maximumCount)
 {
     QMutexLocker lock(&m_mutex);
     maxPendingConnections = maximumCount;
+    promoteBacklog();
+}
+
+// Moves backlog sockets into the freed pending slots. The caller holds the mutex, and
+// the signals are queued as the caller may be the slot connected to newConnection().
+void ServerAcceptanceThread::promoteBacklog()
+{
+    while (!backlogSockets.isEmpty() && pendingSockets.size() < maxPendingConnections) {
+        pendingSockets.append(backlogSockets.takeFirst());
+        QMetaObject::invokeMethod(this, &ServerAcceptanceThread::newConnection,
+                                  Qt::QueuedConnection);
+    }
 }
 
 void ServerAcceptanceThread::run()
@@ -123,10 +148,15 @@ void ServerAcceptanceThread::javaNewSocket(jobject s)
     if (!socket.isValid())
        return;
 
+    // the Java thread returns to accept() right away, whether the socket is pending or
+    // waits in the backlog
     if (pendingSockets.size() < maxPendingConnections) {
         qCDebug(QT_BT_ANDROID) << "New incoming java socket detected";
         pendingSockets.append(socket);
         emit newConnection();
+    } else if (backlogSockets.size() < backlogSize) {
+        qCDebug(QT_BT_ANDROID) << "Pending socket queue is full, keeping socket in backlog";
+        backlogSockets.append(socket);
     } else {
         qCWarning(QT_BT_ANDROID) << "Refusing connection due to limited pending socket queue";
         socket.callMethod<void>("close");
@@ -144,4 +174,8 @@ void ServerAcceptanceThread::shutdownPendingConnections()
         QJniObject socket = pendingSockets.takeFirst();
         socket.callMethod<void>("close");
     }
+    while (!backlogSockets.isEmpty()) {
+        QJniObject socket = backlogSockets.takeFirst();
+        socket.callMethod<void>("close");
+    }
 }
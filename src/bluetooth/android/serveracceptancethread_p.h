@@ -51,8 +51,12 @@ signals:
 private:
     bool validSetup() const;
     void shutdownPendingConnections();
+    void promoteBacklog();
 
     QList<QJniObject> pendingSockets;
+    // accepted sockets beyond maxPendingConnections, announced once they become pending
+    QList<QJniObject> backlogSockets;
+    int backlogSize;
     mutable QMutex m_mutex;
     QString m_serviceName;
     QBluetoothUuid m_uuid;
@@ -0,0 +1,464 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "attpdu_p.h"
+
+#include <algorithm>
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+namespace QBluezAtt {
+
+using AttCommand = QBluezConst::AttCommand;
+
+static constexpr qsizetype Uuid16Size = 2;
+static constexpr qsizetype Uuid128Size = 16;
+
+// Resizes the PDU without giving up its capacity, so that a buffer reused for
+// every outgoing PDU stops allocating once it reached the MTU.
+static char *preparePdu(QByteArray &pdu, AttCommand opcode, qsizetype size)
+{
+    pdu.resize(size);
+    char *data = pdu.data();
+    data[0] = static_cast<char>(opcode);
+    return data;
+}
+
+static qsizetype boundedSize(qsizetype valueSize, qsizetype headerSize, qsizetype maxSize)
+{
+    if (maxSize < 0)
+        return valueSize;
+    return std::clamp(maxSize - headerSize, qsizetype(0), valueSize);
+}
+
+QBluetoothUuid uuidFromData(QByteArrayView data)
+{
+    if (data.size() == Uuid16Size)
+        return QBluetoothUuid(bt_get_le16(data.data()));
+    if (data.size() != Uuid128Size)
+        return QBluetoothUuid();
+
+    // ATT transmits the UUID as little endian, QUuid is constructed from big endian
+    quint128 qtUuidOrder;
+    const uchar *src = reinterpret_cast<const uchar *>(data.data());
+    for (qsizetype i = 0; i < Uuid128Size; ++i)
+        qtUuidOrder.data[i] = src[Uuid128Size - 1 - i];
+    return QBluetoothUuid(qtUuidOrder);
+}
+
+qsizetype putUuid(const QBluetoothUuid &uuid, char *dst)
+{
+    if (uuid.minimumSize() == Uuid16Size) {
+        putBtData(uuid.toUInt16(), dst);
+        return Uuid16Size;
+    }
+
+    const quint128 qtUuidOrder = uuid.toUInt128();
+    uchar *out = reinterpret_cast<uchar *>(dst);
+    for (qsizetype i = 0; i < Uuid128Size; ++i)
+        out[i] = qtUuidOrder.data[Uuid128Size - 1 - i];
+    return Uuid128Size;
+}
+
+bool parseErrorResponse(QByteArrayView pdu, ErrorResponse *result)
+{
+    Q_ASSERT(result);
+    if (pdu.size() != 5 || opcode(pdu) != AttCommand::ATT_OP_ERROR_RESPONSE)
+        return false;
+
+    const char *data = pdu.data();
+    result->request = static_cast<AttCommand>(data[1]);
+    result->handle = bt_get_le16(data + 2);
+    result->code = static_cast<QBluezConst::AttError>(data[4]);
+    return true;
+}
+
+bool parseMtu(QByteArrayView pdu, quint16 *mtu)
+{
+    Q_ASSERT(mtu);
+    if (pdu.size() != OpcodeSize + 2)
+        return false;
+    *mtu = bt_get_le16(pdu.data() + OpcodeSize);
+    return true;
+}
+
+bool parseHandleRangeRequest(QByteArrayView pdu, HandleRangeRequest *result)
+{
+    Q_ASSERT(result);
+    constexpr qsizetype headerSize = OpcodeSize + 2 * HandleSize;
+    if (pdu.size() < headerSize)
+        return false;
+
+    const QByteArrayView tail = pdu.sliced(headerSize);
+    switch (opcode(pdu)) {
+    case AttCommand::ATT_OP_FIND_INFORMATION_REQUEST:
+        if (!tail.isEmpty())
+            return false;
+        break;
+    case AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_REQUEST:
+        if (tail.size() < Uuid16Size)
+            return false;
+        break;
+    case AttCommand::ATT_OP_READ_BY_TYPE_REQUEST:
+    case AttCommand::ATT_OP_READ_BY_GROUP_REQUEST:
+        if (tail.size() != Uuid16Size && tail.size() != Uuid128Size)
+            return false;
+        break;
+    default:
+        return false;
+    }
+
+    result->startingHandle = bt_get_le16(pdu.data() + OpcodeSize);
+    result->endingHandle = bt_get_le16(pdu.data() + OpcodeSize + HandleSize);
+    result->tail = tail;
+    return true;
+}
+
+bool parseHandleValue(QByteArrayView pdu, HandleValue *result)
+{
+    Q_ASSERT(result);
+    qsizetype headerSize = OpcodeSize + HandleSize;
+    bool hasOffset = false;
+    bool hasValue = true;
+    switch (opcode(pdu)) {
+    case AttCommand::ATT_OP_READ_REQUEST:
+        hasValue = false;
+        break;
+    case AttCommand::ATT_OP_READ_BLOB_REQUEST:
+        hasOffset = true;
+        hasValue = false;
+        break;
+    case AttCommand::ATT_OP_PREPARE_WRITE_REQUEST:
+    case AttCommand::ATT_OP_PREPARE_WRITE_RESPONSE:
+        hasOffset = true;
+        break;
+    case AttCommand::ATT_OP_WRITE_REQUEST:
+    case AttCommand::ATT_OP_WRITE_COMMAND:
+    case AttCommand::ATT_OP_SIGNED_WRITE_COMMAND:
+    case AttCommand::ATT_OP_HANDLE_VAL_NOTIFICATION:
+    case AttCommand::ATT_OP_HANDLE_VAL_INDICATION:
+        break;
+    default:
+        return false;
+    }
+    if (hasOffset)
+        headerSize += 2;
+    if (pdu.size() < headerSize || (!hasValue && pdu.size() != headerSize))
+        return false;
+
+    result->handle = bt_get_le16(pdu.data() + OpcodeSize);
+    result->offset = hasOffset ? bt_get_le16(pdu.data() + OpcodeSize + HandleSize) : 0;
+    result->value = pdu.sliced(headerSize);
+    return true;
+}
+
+bool parseSignedWrite(QByteArrayView pdu, SignedWrite *result)
+{
+    Q_ASSERT(result);
+    constexpr qsizetype headerSize = OpcodeSize + HandleSize;
+    if (pdu.size() < headerSize + SignatureSize
+        || opcode(pdu) != AttCommand::ATT_OP_SIGNED_WRITE_COMMAND) {
+        return false;
+    }
+
+    const char *signature = pdu.data() + pdu.size() - SignatureSize;
+    result->handle = bt_get_le16(pdu.data() + OpcodeSize);
+    result->signedData = pdu.chopped(SignatureSize);
+    result->value = result->signedData.sliced(headerSize);
+    result->signCounter = getBtData<quint32>(signature);
+    result->mac = getBtData<quint64>(signature + sizeof(quint32));
+    return true;
+}
+
+bool parseExecuteWriteRequest(QByteArrayView pdu, bool *execute)
+{
+    Q_ASSERT(execute);
+    if (pdu.size() != OpcodeSize + 1 || opcode(pdu) != AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST)
+        return false;
+    *execute = pdu[1] != 0;
+    return true;
+}
+
+qsizetype handleCount(QByteArrayView pdu)
+{
+    return (std::max)(pdu.size() - OpcodeSize, qsizetype(0)) / HandleSize;
+}
+
+quint16 handleAt(QByteArrayView pdu, qsizetype index)
+{
+    Q_ASSERT(index >= 0 && index < handleCount(pdu));
+    return bt_get_le16(pdu.data() + OpcodeSize + index * HandleSize);
+}
+
+bool takeValue(QByteArrayView *data, qsizetype length, QByteArrayView *value)
+{
+    Q_ASSERT(data && value && length >= 0);
+    if (data->size() < length) {
+        *data = QByteArrayView();
+        return false;
+    }
+
+    *value = data->first(length);
+    *data = data->sliced(length);
+    return true;
+}
+
+bool takeLengthValue(QByteArrayView *data, QByteArrayView *value, quint16 *length)
+{
+    Q_ASSERT(data && value && length);
+    if (data->size() < 2)
+        return false;
+
+    *length = bt_get_le16(data->data());
+    const qsizetype available = (std::min)(data->size() - 2, qsizetype(*length));
+    *value = data->sliced(2, available);
+    *data = data->sliced(2 + available);
+    return true;
+}
+
+AttributeDataList::AttributeDataList(QByteArrayView pdu)
+{
+    if (pdu.size() < OpcodeSize)
+        return;
+
+    switch (opcode(pdu)) {
+    case AttCommand::ATT_OP_FIND_INFORMATION_RESPONSE:
+        // the format byte selects 16 or 128 bit UUIDs
+        if (pdu.size() < 2)
+            return;
+        if (pdu[1] == 0x1)
+            elementLength = HandleSize + Uuid16Size;
+        else if (pdu[1] == 0x2)
+            elementLength = HandleSize + Uuid128Size;
+        else
+            return;
+        elements = pdu.sliced(2);
+        break;
+    case AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_RESPONSE:
+        elementLength = 2 * HandleSize;
+        elements = pdu.sliced(OpcodeSize);
+        break;
+    case AttCommand::ATT_OP_READ_BY_TYPE_RESPONSE:
+    case AttCommand::ATT_OP_READ_BY_GROUP_RESPONSE:
+        if (pdu.size() < 2)
+            return;
+        elementLength = quint8(pdu[1]);
+        elements = pdu.sliced(2);
+        break;
+    default:
+        break;
+    }
+}
+
+bool parseCharacteristicDeclaration(QByteArrayView element, CharacteristicDeclaration *result)
+{
+    Q_ASSERT(result);
+    // <handle><properties><value handle><uuid>
+    constexpr qsizetype headerSize = 2 * HandleSize + 1;
+    if (element.size() != headerSize + Uuid16Size && element.size() != headerSize + Uuid128Size)
+        return false;
+
+    const char *data = element.data();
+    result->declarationHandle = bt_get_le16(data);
+    result->properties = quint8(data[2]);
+    result->valueHandle = bt_get_le16(data + 3);
+    result->uuid = uuidFromData(element.sliced(headerSize));
+    return true;
+}
+
+bool parseIncludeDeclaration(QByteArrayView element, IncludeDeclaration *result)
+{
+    Q_ASSERT(result);
+    // <handle><included service start handle><included service end handle>[<uuid>]
+    // Servers omit 128 bit UUIDs of included services, which leaves a null UUID,
+    // see Spec v5.3, Vol 3, Part G, 4.5.1.
+    constexpr qsizetype headerSize = 3 * HandleSize;
+    if (element.size() != headerSize && element.size() != headerSize + Uuid16Size
+        && element.size() != headerSize + Uuid128Size)
+        return false;
+
+    const char *data = element.data();
+    result->declarationHandle = bt_get_le16(data);
+    result->startingHandle = bt_get_le16(data + 2);
+    result->endingHandle = bt_get_le16(data + 4);
+    result->uuid = uuidFromData(element.sliced(headerSize));
+    return true;
+}
+
+bool parseGroupData(QByteArrayView element, GroupData *result)
+{
+    Q_ASSERT(result);
+    // <handle><end group handle><value>
+    if (element.size() < 2 * HandleSize)
+        return false;
+
+    result->startingHandle = bt_get_le16(element.data());
+    result->endingHandle = bt_get_le16(element.data() + HandleSize);
+    result->value = element.sliced(2 * HandleSize);
+    return true;
+}
+
+void buildErrorResponse(QByteArray &pdu, AttCommand request, quint16 handle,
+                        QBluezConst::AttError code)
+{
+    char *data = preparePdu(pdu, AttCommand::ATT_OP_ERROR_RESPONSE, 5);
+    data[1] = static_cast<char>(request);
+    putBtData(handle, data + 2);
+    data[4] = static_cast<char>(code);
+}
+
+void buildOpcode(QByteArray &pdu, AttCommand opcode)
+{
+    preparePdu(pdu, opcode, OpcodeSize);
+}
+
+void buildMtu(QByteArray &pdu, AttCommand opcode, quint16 mtu)
+{
+    char *data = preparePdu(pdu, opcode, OpcodeSize + 2);
+    putBtData(mtu, data + OpcodeSize);
+}
+
+void buildHandleRangeRequest(QByteArray &pdu, AttCommand opcode, quint16 startingHandle,
+                             quint16 endingHandle, QByteArrayView tail)
+{
+    constexpr qsizetype headerSize = OpcodeSize + 2 * HandleSize;
+    char *data = preparePdu(pdu, opcode, headerSize + tail.size());
+    putBtData(startingHandle, data + OpcodeSize);
+    putBtData(endingHandle, data + OpcodeSize + HandleSize);
+    if (!tail.isEmpty())
+        memcpy(data + headerSize, tail.data(), tail.size());
+}
+
+void buildHandleRangeRequest(QByteArray &pdu, AttCommand opcode, quint16 startingHandle,
+                             quint16 endingHandle, const QBluetoothUuid &type)
+{
+    constexpr qsizetype headerSize = OpcodeSize + 2 * HandleSize;
+    char *data = preparePdu(pdu, opcode, headerSize + Uuid128Size);
+    putBtData(startingHandle, data + OpcodeSize);
+    putBtData(endingHandle, data + OpcodeSize + HandleSize);
+    pdu.resize(headerSize + putUuid(type, data + headerSize));
+}
+
+void buildFindByTypeValueRequest(QByteArray &pdu, quint16 startingHandle, quint16 endingHandle,
+                                 quint16 type, QByteArrayView value)
+{
+    constexpr qsizetype headerSize = OpcodeSize + 2 * HandleSize + Uuid16Size;
+    char *data = preparePdu(pdu, AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_REQUEST,
+                            headerSize + value.size());
+    putBtData(startingHandle, data + OpcodeSize);
+    putBtData(endingHandle, data + OpcodeSize + HandleSize);
+    putBtData(type, data + OpcodeSize + 2 * HandleSize);
+    if (!value.isEmpty())
+        memcpy(data + headerSize, value.data(), value.size());
+}
+
+void buildHandleValue(QByteArray &pdu, AttCommand opcode, quint16 handle, QByteArrayView value,
+                      qsizetype maxSize)
+{
+    constexpr qsizetype headerSize = OpcodeSize + HandleSize;
+    const qsizetype valueSize = boundedSize(value.size(), headerSize, maxSize);
+    char *data = preparePdu(pdu, opcode, headerSize + valueSize);
+    putBtData(handle, data + OpcodeSize);
+    if (valueSize > 0)
+        memcpy(data + headerSize, value.data(), valueSize);
+}
+
+void buildHandleOffsetValue(QByteArray &pdu, AttCommand opcode, quint16 handle, quint16 offset,
+                            QByteArrayView value, qsizetype maxSize)
+{
+    constexpr qsizetype headerSize = OpcodeSize + 2 * HandleSize;
+    const qsizetype valueSize = boundedSize(value.size(), headerSize, maxSize);
+    char *data = preparePdu(pdu, opcode, headerSize + valueSize);
+    putBtData(handle, data + OpcodeSize);
+    putBtData(offset, data + OpcodeSize + HandleSize);
+    if (valueSize > 0)
+        memcpy(data + headerSize, value.data(), valueSize);
+}
+
+void buildValue(QByteArray &pdu, AttCommand opcode, QByteArrayView value, qsizetype maxSize)
+{
+    const qsizetype valueSize = boundedSize(value.size(), OpcodeSize, maxSize);
+    char *data = preparePdu(pdu, opcode, OpcodeSize + valueSize);
+    if (valueSize > 0)
+        memcpy(data + OpcodeSize, value.data(), valueSize);
+}
+
+void buildExecuteWriteRequest(QByteArray &pdu, bool execute)
+{
+    char *data = preparePdu(pdu, AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST, OpcodeSize + 1);
+    data[1] = execute ? 0x01 : 0x00;
+}
+
+void buildHandleList(QByteArray &pdu, AttCommand opcode, const quint16 *handles, qsizetype count)
+{
+    char *data = preparePdu(pdu, opcode, OpcodeSize + count * HandleSize) + OpcodeSize;
+    for (qsizetype i = 0; i < count; ++i, data += HandleSize)
+        putBtData(handles[i], data);
+}
+
+void appendSignature(QByteArray &pdu, quint32 signCounter, quint64 mac)
+{
+    const qsizetype offset = pdu.size();
+    pdu.resize(offset + SignatureSize);
+    char *data = pdu.data() + offset;
+    putBtData(signCounter, data);
+    putBtData(mac, data + sizeof(quint32));
+}
+
+void appendValue(QByteArray &pdu, QByteArrayView value, qsizetype maxSize)
+{
+    const qsizetype offset = pdu.size();
+    const qsizetype valueSize = boundedSize(value.size(), offset, maxSize);
+    if (valueSize > 0)
+        pdu.append(value.data(), valueSize);
+}
+
+bool appendLengthValue(QByteArray &pdu, QByteArrayView value, qsizetype maxSize)
+{
+    const qsizetype offset = pdu.size();
+    if (offset + 2 > maxSize)
+        return false;
+
+    const qsizetype valueSize = boundedSize(value.size(), offset + 2, maxSize);
+    pdu.resize(offset + 2 + valueSize);
+    char *data = pdu.data() + offset;
+    putBtData(quint16(value.size()), data);
+    if (valueSize > 0)
+        memcpy(data + 2, value.data(), valueSize);
+    return true;
+}
+
+AttributeDataListBuilder::AttributeDataListBuilder(QByteArray &pdu, AttCommand opcode,
+                                                   qsizetype elementLength, qsizetype maxSize)
+    : pdu(pdu), elementLength(elementLength), maxSize(maxSize)
+{
+    Q_ASSERT(elementLength > 0);
+    switch (opcode) {
+    case AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_RESPONSE:
+        preparePdu(pdu, opcode, OpcodeSize);
+        break;
+    case AttCommand::ATT_OP_FIND_INFORMATION_RESPONSE:
+        Q_ASSERT(elementLength == HandleSize + Uuid16Size
+                 || elementLength == HandleSize + Uuid128Size);
+        preparePdu(pdu, opcode, 2)[1] = elementLength == HandleSize + Uuid16Size ? 0x1 : 0x2;
+        break;
+    default:
+        preparePdu(pdu, opcode, 2)[1] = static_cast<char>(elementLength);
+        break;
+    }
+}
+
+char *AttributeDataListBuilder::appendElement()
+{
+    const qsizetype offset = pdu.size();
+    if (offset + elementLength > maxSize)
+        return nullptr;
+    pdu.resize(offset + elementLength);
+    ++count;
+    return pdu.data() + offset;
+}
+
+} // namespace QBluezAtt
+
+QT_END_NAMESPACE
@@ -0,0 +1,268 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef ATTPDU_P_H
+#define ATTPDU_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtBluetooth/QBluetoothUuid>
+#include <QtBluetooth/private/qtbluetoothglobal_p.h>
+#include <QtCore/QByteArray>
+#include <QtCore/QByteArrayView>
+
+#include "bluez_data_p.h"
+
+QT_BEGIN_NAMESPACE
+
+/*
+ * Encoding and decoding of ATT PDUs, see Spec v5.3, Vol 3, Part F, 3.4.
+ *
+ * The parsers take the complete PDU including the opcode and return views into
+ * it, so the PDU must outlive the result. The builders overwrite the caller's
+ * buffer, which keeps its capacity across calls. None of the functions needs a
+ * bearer, they are shared by the client and the server role of the controller.
+ */
+namespace QBluezAtt {
+
+constexpr qsizetype OpcodeSize = 1;
+constexpr qsizetype HandleSize = 2;
+// <sign counter><mac> at the end of a signed write command
+constexpr qsizetype SignatureSize = 12;
+
+inline QBluezConst::AttCommand opcode(QByteArrayView pdu)
+{
+    return static_cast<QBluezConst::AttCommand>(pdu.isEmpty() ? 0 : quint8(pdu.front()));
+}
+
+// decodes a 16 or 128 bit UUID in ATT byte order, any other size yields a null UUID
+Q_BLUETOOTH_PRIVATE_EXPORT QBluetoothUuid uuidFromData(QByteArrayView data);
+// returns the number of bytes written, 2 or 16
+Q_BLUETOOTH_PRIVATE_EXPORT qsizetype putUuid(const QBluetoothUuid &uuid, char *dst);
+
+// <0x01><request opcode><handle><error code>
+struct ErrorResponse
+{
+    QBluezConst::AttCommand request = QBluezConst::AttCommand::ATT_OP_ERROR_RESPONSE;
+    quint16 handle = 0;
+    QBluezConst::AttError code = QBluezConst::AttError::ATT_ERROR_NO_ERROR;
+};
+Q_BLUETOOTH_PRIVATE_EXPORT bool parseErrorResponse(QByteArrayView pdu, ErrorResponse *result);
+
+// <opcode><mtu>, exchange MTU request and response
+Q_BLUETOOTH_PRIVATE_EXPORT bool parseMtu(QByteArrayView pdu, quint16 *mtu);
+
+// <opcode><start handle><end handle><tail>
+// The tail is empty for find information requests, the 16 or 128 bit attribute
+// type for read by (group) type requests and the 16 bit type followed by the
+// value for find by type value requests.
+struct HandleRangeRequest
+{
+    quint16 startingHandle = 0;
+    quint16 endingHandle = 0;
+    QByteArrayView tail;
+};
+Q_BLUETOOTH_PRIVATE_EXPORT bool parseHandleRangeRequest(QByteArrayView pdu,
+                                                        HandleRangeRequest *result);
+
+// <opcode><handle>[<offset>]<value>
+// Read, read blob, write and prepare write requests, write commands as well as
+// notifications and indications. The offset is only present for read blob and
+// prepare write PDUs. The value of a signed write command includes the
+// signature, see parseSignedWrite().
+struct HandleValue
+{
+    quint16 handle = 0;
+    quint16 offset = 0;
+    QByteArrayView value;
+};
+Q_BLUETOOTH_PRIVATE_EXPORT bool parseHandleValue(QByteArrayView pdu, HandleValue *result);
+
+// <0xd2><handle><value><sign counter><mac>
+struct SignedWrite
+{
+    quint16 handle = 0;
+    QByteArrayView value;
+    // the part of the PDU which the MAC covers
+    QByteArrayView signedData;
+    quint32 signCounter = 0;
+    quint64 mac = 0;
+};
+Q_BLUETOOTH_PRIVATE_EXPORT bool parseSignedWrite(QByteArrayView pdu, SignedWrite *result);
+
+// <0x18><flags>, execute is false if the prepared writes are cancelled
+Q_BLUETOOTH_PRIVATE_EXPORT bool parseExecuteWriteRequest(QByteArrayView pdu, bool *execute);
+
+// <opcode><handle>+, read multiple (variable) requests
+Q_BLUETOOTH_PRIVATE_EXPORT qsizetype handleCount(QByteArrayView pdu);
+Q_BLUETOOTH_PRIVATE_EXPORT quint16 handleAt(QByteArrayView pdu, qsizetype index);
+
+// Takes the next value of a read multiple response, whose length the client knows,
+// from the front of data. Returns false if the MTU cut off the value, data is
+// empty then.
+Q_BLUETOOTH_PRIVATE_EXPORT bool takeValue(QByteArrayView *data, qsizetype length,
+                                          QByteArrayView *value);
+
+// Takes the next <length><value> tuple of a read multiple variable response from the
+// front of data. A value cut off by the MTU is returned as far as it is present, the
+// length is the complete one.
+Q_BLUETOOTH_PRIVATE_EXPORT bool takeLengthValue(QByteArrayView *data, QByteArrayView *value,
+                                                quint16 *length);
+
+/*
+ * View on the element list of find information, find by type value, read by type
+ * and read by group type responses. The element length is taken from the PDU,
+ * a trailing partial element is ignored.
+ */
+class Q_BLUETOOTH_PRIVATE_EXPORT AttributeDataList
+{
+public:
+    AttributeDataList() = default;
+    explicit AttributeDataList(QByteArrayView pdu);
+
+    bool isValid() const { return elementLength > 0; }
+    qsizetype elementSize() const { return elementLength; }
+    qsizetype size() const { return isValid() ? elements.size() / elementLength : 0; }
+    QByteArrayView at(qsizetype index) const
+    {
+        return elements.sliced(index * elementLength, elementLength);
+    }
+
+    class const_iterator
+    {
+    public:
+        QByteArrayView operator*() const { return QByteArrayView(data, length); }
+        const_iterator &operator++() { data += length; return *this; }
+        bool operator!=(const const_iterator &other) const { return data != other.data; }
+        bool operator==(const const_iterator &other) const { return data == other.data; }
+
+    private:
+        friend class AttributeDataList;
+        const_iterator(const char *d, qsizetype l) : data(d), length(l) {}
+        const char *data;
+        qsizetype length;
+    };
+    const_iterator begin() const { return const_iterator(elements.data(), elementLength); }
+    const_iterator end() const
+    {
+        return const_iterator(elements.data() + size() * elementLength, elementLength);
+    }
+
+private:
+    QByteArrayView elements;
+    qsizetype elementLength = 0;
+};
+
+// read by type response elements of characteristic and include declarations
+struct CharacteristicDeclaration
+{
+    quint16 declarationHandle = 0;
+    quint8 properties = 0;
+    quint16 valueHandle = 0;
+    QBluetoothUuid uuid;
+};
+Q_BLUETOOTH_PRIVATE_EXPORT bool parseCharacteristicDeclaration(QByteArrayView element,
+                                                               CharacteristicDeclaration *result);
+
+struct IncludeDeclaration
+{
+    quint16 declarationHandle = 0;
+    quint16 startingHandle = 0;
+    quint16 endingHandle = 0;
+    QBluetoothUuid uuid;
+};
+Q_BLUETOOTH_PRIVATE_EXPORT bool parseIncludeDeclaration(QByteArrayView element,
+                                                        IncludeDeclaration *result);
+
+// read by group type response elements
+struct GroupData
+{
+    quint16 startingHandle = 0;
+    quint16 endingHandle = 0;
+    QByteArrayView value;
+};
+Q_BLUETOOTH_PRIVATE_EXPORT bool parseGroupData(QByteArrayView element, GroupData *result);
+
+Q_BLUETOOTH_PRIVATE_EXPORT void buildErrorResponse(QByteArray &pdu,
+                                                   QBluezConst::AttCommand request,
+                                                   quint16 handle, QBluezConst::AttError code);
+Q_BLUETOOTH_PRIVATE_EXPORT void buildOpcode(QByteArray &pdu, QBluezConst::AttCommand opcode);
+Q_BLUETOOTH_PRIVATE_EXPORT void buildMtu(QByteArray &pdu, QBluezConst::AttCommand opcode,
+                                         quint16 mtu);
+Q_BLUETOOTH_PRIVATE_EXPORT void buildHandleRangeRequest(QByteArray &pdu,
+                                                        QBluezConst::AttCommand opcode,
+                                                        quint16 startingHandle,
+                                                        quint16 endingHandle,
+                                                        QByteArrayView tail = {});
+Q_BLUETOOTH_PRIVATE_EXPORT void buildHandleRangeRequest(QByteArray &pdu,
+                                                        QBluezConst::AttCommand opcode,
+                                                        quint16 startingHandle,
+                                                        quint16 endingHandle,
+                                                        const QBluetoothUuid &type);
+Q_BLUETOOTH_PRIVATE_EXPORT void buildFindByTypeValueRequest(QByteArray &pdu,
+                                                            quint16 startingHandle,
+                                                            quint16 endingHandle,
+                                                            quint16 type, QByteArrayView value);
+// the value is truncated to fit into maxSize, which is usually the ATT MTU
+Q_BLUETOOTH_PRIVATE_EXPORT void buildHandleValue(QByteArray &pdu, QBluezConst::AttCommand opcode,
+                                                 quint16 handle, QByteArrayView value = {},
+                                                 qsizetype maxSize = -1);
+Q_BLUETOOTH_PRIVATE_EXPORT void buildHandleOffsetValue(QByteArray &pdu,
+                                                       QBluezConst::AttCommand opcode,
+                                                       quint16 handle, quint16 offset,
+                                                       QByteArrayView value = {},
+                                                       qsizetype maxSize = -1);
+Q_BLUETOOTH_PRIVATE_EXPORT void buildValue(QByteArray &pdu, QBluezConst::AttCommand opcode,
+                                           QByteArrayView value, qsizetype maxSize = -1);
+// flushes the prepare queue if execute is true, otherwise cancels it
+Q_BLUETOOTH_PRIVATE_EXPORT void buildExecuteWriteRequest(QByteArray &pdu, bool execute);
+Q_BLUETOOTH_PRIVATE_EXPORT void buildHandleList(QByteArray &pdu, QBluezConst::AttCommand opcode,
+                                                const quint16 *handles, qsizetype count);
+
+// appends the signature of a signed write command
+Q_BLUETOOTH_PRIVATE_EXPORT void appendSignature(QByteArray &pdu, quint32 signCounter,
+                                                quint64 mac);
+// appends the value of a read multiple response as far as it fits into maxSize
+Q_BLUETOOTH_PRIVATE_EXPORT void appendValue(QByteArray &pdu, QByteArrayView value,
+                                            qsizetype maxSize);
+// appends a <length><value> tuple, returns false if not even the length fits into maxSize
+Q_BLUETOOTH_PRIVATE_EXPORT bool appendLengthValue(QByteArray &pdu, QByteArrayView value,
+                                                  qsizetype maxSize);
+
+/*
+ * Builds the element list of a find information, find by type value, read by type
+ * or read by group type response in place. The format byte is written for all
+ * responses except find by type value, and elements are only accepted as long as
+ * they fit into maxSize.
+ */
+class Q_BLUETOOTH_PRIVATE_EXPORT AttributeDataListBuilder
+{
+public:
+    AttributeDataListBuilder(QByteArray &pdu, QBluezConst::AttCommand opcode,
+                             qsizetype elementLength, qsizetype maxSize);
+
+    // returns nullptr once the PDU is full
+    char *appendElement();
+    qsizetype size() const { return count; }
+
+private:
+    QByteArray &pdu;
+    qsizetype elementLength;
+    qsizetype maxSize;
+    qsizetype count = 0;
+};
+
+} // namespace QBluezAtt
+
+QT_END_NAMESPACE
+
+#endif // ATTPDU_P_H
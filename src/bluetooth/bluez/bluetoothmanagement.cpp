@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include <QtCore/qloggingcategory.h>
+#include <QtCore/qmetaobject.h>
 #include <QtCore/qsocketnotifier.h>
 #include <QtCore/qtimer.h>
 
@@ -27,6 +28,23 @@ struct MgmtHdr {
     quint16 length;
 } __attribute__((packed));
 
+struct MgmtEventCommandComplete {
+    quint16 commandCode;
+    quint8 status;
+    quint8 data[0];
+} __attribute__((packed));
+
+enum MgmtCommandCode : quint16 {
+    ReadDefaultSystemConfigurationCommand = 0x004B,
+    SetDefaultSystemConfigurationCommand = 0x004C
+};
+
+// the types of the system configuration parameters
+enum : quint16 {
+    LeDiscoveryScanIntervalType = 0x0011,
+    LeDiscoveryScanWindowType = 0x0012
+};
+
 struct MgmtEventDeviceFound {
     bdaddr_t bdaddr;
     quint8 type;
@@ -86,11 +104,6 @@ struct capData {
 
 const int msecInADay = 1000*60*60*24;
 
-inline uint qHash(const QBluetoothAddress& address)
-{
-    return qHash(address.toUInt64());
-}
-
 static int sysCallCapGet(capHdr *header, capData *data)
 {
     return syscall(__NR_capget, header, data);
@@ -197,22 +210,43 @@ void BluetoothManagement::_q_readNotifier()
         switch (static_cast<EventCode>(qFromLittleEndian(hdr->cmdCode))) {
         case EventCode::DeviceFoundEvent:
         {
+            if (nextPackageSize < qsizetype(sizeof(MgmtHdr) + sizeof(MgmtEventDeviceFound))) {
+                qCWarning(QT_BT_BLUEZ) << "BluetoothManagement: truncated Device Found event";
+                break;
+            }
+
             const MgmtEventDeviceFound *event = reinterpret_cast<const MgmtEventDeviceFound*>
                                                    (data.constData() + sizeof(MgmtHdr));
+            const bdaddr_t address = event->bdaddr;
+            quint64 bdaddr;
+            convertAddress(address.b, &bdaddr);
+            const QBluetoothAddress qtAddress(bdaddr);
 
             if (event->type == BDADDR_LE_RANDOM) {
-                const bdaddr_t address = event->bdaddr;
-                quint64 bdaddr;
-
-                convertAddress(address.b, &bdaddr);
-                const QBluetoothAddress qtAddress(bdaddr);
                 qCDebug(QT_BT_BLUEZ) << "BluetoothManagement: found random device"
                                      << qtAddress;
                 processRandomAddressFlagInformation(qtAddress);
             }
 
+            // copying the EIR data costs, skip it unless somebody wants it
+            static const QMetaMethod deviceFoundSignal =
+                    QMetaMethod::fromSignal(&BluetoothManagement::deviceFound);
+            if (isSignalConnected(deviceFoundSignal)) {
+                const qsizetype eirLength = qMin<qsizetype>(
+                            qFromLittleEndian(event->eirLength),
+                            nextPackageSize - sizeof(MgmtHdr) - sizeof(MgmtEventDeviceFound));
+                emit deviceFound(qFromLittleEndian(hdr->controllerIndex), qtAddress, event->type,
+                                 qint8(event->rssi),
+                                 QByteArray(reinterpret_cast<const char *>(event->eirData),
+                                            eirLength));
+            }
+
             break;
         }
+        case EventCode::CommandCompleteEvent:
+            processCommandComplete(qFromLittleEndian(hdr->controllerIndex),
+                                   data.mid(sizeof(MgmtHdr), nextPackageSize - sizeof(MgmtHdr)));
+            break;
         default:
             qCDebug(QT_BT_BLUEZ) << "BluetoothManagement: Ignored event:"
                                  << Qt::hex << (EventCode)qFromLittleEndian(hdr->cmdCode);
@@ -271,6 +305,108 @@ bool BluetoothManagement::isMonitoringEnabled() const
     return (fd == -1) ? false : true;
 }
 
+bool BluetoothManagement::sendCommand(quint16 commandCode, quint16 controllerIndex,
+                                      const QByteArray &parameters)
+{
+    if (fd == -1)
+        return false;
+
+    MgmtHdr header;
+    header.cmdCode = qToLittleEndian(commandCode);
+    header.controllerIndex = qToLittleEndian(controllerIndex);
+    header.length = qToLittleEndian(quint16(parameters.size()));
+    QByteArray packet(reinterpret_cast<const char *>(&header), sizeof header);
+    packet += parameters;
+    while (::write(fd, packet.constData(), packet.size()) < 0) {
+        if (errno == EINTR)
+            continue;
+        qCWarning(QT_BT_BLUEZ) << "BluetoothManagement: cannot send command" << Qt::hex
+                               << commandCode << qt_error_string(errno);
+        return false;
+    }
+    return true;
+}
+
+static void appendSystemParameter(QByteArray *parameters, quint16 type, quint16 value)
+{
+    // type, length and value of mgmt-api.txt, Set Default System Configuration
+    const quint16 leType = qToLittleEndian(type);
+    const quint16 leValue = qToLittleEndian(value);
+    parameters->append(reinterpret_cast<const char *>(&leType), sizeof leType);
+    parameters->append(char(sizeof leValue));
+    parameters->append(reinterpret_cast<const char *>(&leValue), sizeof leValue);
+}
+
+/*
+ * Changes the scan parameters bluetoothd configured for all discoveries of
+ * the controller. Requires a kernel with support of the default system
+ * configuration (5.8+). The original values are read once first, the kernel
+ * executes the commands in order.
+ */
+bool BluetoothManagement::setDiscoveryScanParameters(quint16 controllerIndex, quint16 interval,
+                                                     quint16 window)
+{
+    QMutexLocker locker(&accessLock);
+    if (!originalScanParameters.contains(controllerIndex)
+            && !pendingScanParameterReads.contains(controllerIndex)) {
+        if (!sendCommand(ReadDefaultSystemConfigurationCommand, controllerIndex, QByteArray()))
+            return false;
+        pendingScanParameterReads.insert(controllerIndex);
+    }
+
+    QByteArray parameters;
+    appendSystemParameter(&parameters, LeDiscoveryScanIntervalType, interval);
+    appendSystemParameter(&parameters, LeDiscoveryScanWindowType, window);
+    return sendCommand(SetDefaultSystemConfigurationCommand, controllerIndex, parameters);
+}
+
+void BluetoothManagement::restoreDiscoveryScanParameters(quint16 controllerIndex)
+{
+    QMutexLocker locker(&accessLock);
+    pendingScanParameterReads.remove(controllerIndex);
+    const auto it = originalScanParameters.constFind(controllerIndex);
+    if (it == originalScanParameters.cend())
+        return;
+
+    QByteArray parameters;
+    appendSystemParameter(&parameters, LeDiscoveryScanIntervalType, it->interval);
+    appendSystemParameter(&parameters, LeDiscoveryScanWindowType, it->window);
+    originalScanParameters.erase(it);
+    sendCommand(SetDefaultSystemConfigurationCommand, controllerIndex, parameters);
+}
+
+void BluetoothManagement::processCommandComplete(quint16 controllerIndex, const QByteArray &data)
+{
+    if (size_t(data.size()) < sizeof(MgmtEventCommandComplete))
+        return;
+    const auto *event = reinterpret_cast<const MgmtEventCommandComplete *>(data.constData());
+    const quint16 commandCode = qFromLittleEndian(event->commandCode);
+    if (event->status != 0) {
+        qCDebug(QT_BT_BLUEZ) << "BluetoothManagement: command" << Qt::hex << commandCode
+                             << "failed with status" << event->status;
+    }
+    if (commandCode != ReadDefaultSystemConfigurationCommand)
+        return;
+
+    QMutexLocker locker(&accessLock);
+    if (!pendingScanParameterReads.remove(controllerIndex) || event->status != 0)
+        return;
+
+    ScanParameters original;
+    const quint8 *tlv = event->data;
+    const quint8 *end = reinterpret_cast<const quint8 *>(data.constData()) + data.size();
+    while (end - tlv >= 3 && end - tlv >= 3 + tlv[2]) {
+        const quint16 type = bt_get_le16(tlv);
+        if (tlv[2] == 2 && type == LeDiscoveryScanIntervalType)
+            original.interval = bt_get_le16(tlv + 3);
+        else if (tlv[2] == 2 && type == LeDiscoveryScanWindowType)
+            original.window = bt_get_le16(tlv + 3);
+        tlv += 3 + tlv[2];
+    }
+    if (original.interval && original.window)
+        originalScanParameters.insert(controllerIndex, original);
+}
+
 
 QT_END_NAMESPACE
 
@@ -18,6 +18,7 @@
 #include <QtCore/qdatetime.h>
 #include <QtCore/qmutex.h>
 #include <QtCore/qobject.h>
+#include <QtCore/qset.h>
 
 #include <QtBluetooth/qbluetoothaddress.h>
 
@@ -92,18 +93,39 @@ public:
     bool isAddressRandom(const QBluetoothAddress &address) const;
     bool isMonitoringEnabled() const;
 
+    // LE scan interval and window of the kernel's device discovery, in units
+    // of 0.625 ms. The values found before the first change are restored by
+    // restoreDiscoveryScanParameters().
+    bool setDiscoveryScanParameters(quint16 controllerIndex, quint16 interval, quint16 window);
+    void restoreDiscoveryScanParameters(quint16 controllerIndex);
+
+signals:
+    // Emitted for every Device Found event of the kernel, the address type is
+    // one of BDADDR_BREDR, BDADDR_LE_PUBLIC or BDADDR_LE_RANDOM.
+    void deviceFound(quint16 controllerIndex, const QBluetoothAddress &address,
+                     quint8 addressType, qint8 rssi, const QByteArray &eirData);
+
 private slots:
     void _q_readNotifier();
     void processRandomAddressFlagInformation(const QBluetoothAddress &address);
     void cleanupOldAddressFlags();
 
 private:
+    struct ScanParameters {
+        quint16 interval = 0;
+        quint16 window = 0;
+    };
+
     void readyRead();
+    bool sendCommand(quint16 commandCode, quint16 controllerIndex, const QByteArray &parameters);
+    void processCommandComplete(quint16 controllerIndex, const QByteArray &data);
 
     int fd = -1;
     QSocketNotifier* notifier;
     QPrivateLinearBuffer buffer;
     QHash<QBluetoothAddress, QDateTime> privateFlagAddresses;
+    QHash<quint16, ScanParameters> originalScanParameters;
+    QSet<quint16> pendingScanParameterReads;
     mutable QMutex accessLock;
 };
 
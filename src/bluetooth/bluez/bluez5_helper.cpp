@@ -1,16 +1,19 @@
 // Copyright (C) 2016 The Qt Company Ltd.
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
+#include <QtCore/QCoreApplication>
 #include <QtCore/QGlobalStatic>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QMap>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
 #include <QtCore/QVersionNumber>
 #include <QtNetwork/private/qnet_unix_p.h>
 #include "bluez5_helper_p.h"
 #include "bluez_data_p.h"
 #include "objectmanager_p.h"
-#include "properties_p.h"
 #include "adapter1_bluez5_p.h"
+#include "../qbluetoothaddress_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -39,17 +42,15 @@ Q_GLOBAL_STATIC_WITH_ARGS(QVersionNumber, bluezDaemonVersion, (QVersionNumber())
 void initializeBluez5()
 {
     if (*bluezVersion() == BluezVersionUnknown) {
-        OrgFreedesktopDBusObjectManagerInterface manager(QStringLiteral("org.bluez"),
-                                                         QStringLiteral("/"),
-                                                         QDBusConnection::systemBus());
         qDBusRegisterMetaType<InterfaceList>();
         qDBusRegisterMetaType<ManagedObjectList>();
         qDBusRegisterMetaType<ManufacturerDataList>();
         qDBusRegisterMetaType<ServiceDataList>();
 
-        QDBusPendingReply<ManagedObjectList> reply = manager.GetManagedObjects();
-        reply.waitForFinished();
-        if (reply.isError()) {
+        // also fetches the object tree all later lookups are served from
+        QDBusError error;
+        QtBluezObjectCache::instance()->managedObjects(&error);
+        if (error.isValid()) {
             *bluezVersion() = BluezNotAvailable;
             qWarning() << "Cannot find a compatible running Bluez. "
                           "Please check the Bluez installation. "
@@ -137,6 +138,105 @@ bool mandatoryHciIoctlsAvailable()
     return true;
 }
 
+/*
+    Interfaces of the adapter objects and the first bluetoothd release which
+    exports them. Interfaces which older releases exported in experimental
+    mode do not tell the version apart and are not listed.
+ */
+static const struct {
+    const char *interface;
+    int majorVersion;
+    int minorVersion;
+} bluetoothdInterfaceVersions[] = {
+    { "org.bluez.AdvertisementMonitorManager1", 5, 56 },
+};
+
+// the newest release any backend selection depends on
+static const QVersionNumber bluetoothdVersionOfInterest(5, 56);
+
+/*
+    Returns the lowest version of bluetoothd which exports the interfaces
+    found on the adapters. The object tree is shared with the object cache,
+    usually it was fetched by initializeBluez5() already.
+ */
+static QVersionNumber bluetoothdVersionFromInterfaces()
+{
+    QDBusError error;
+    const ManagedObjectList objects = QtBluezObjectCache::instance()->managedObjects(&error);
+    if (error.isValid())
+        return QVersionNumber();
+
+    QVersionNumber version;
+    for (const InterfaceList &interfaces : objects) {
+        if (!interfaces.contains(QStringLiteral("org.bluez.Adapter1")))
+            continue;
+        for (const auto &entry : bluetoothdInterfaceVersions) {
+            const QVersionNumber vn(entry.majorVersion, entry.minorVersion);
+            if (vn > version && interfaces.contains(QLatin1String(entry.interface)))
+                version = vn;
+        }
+    }
+    return version;
+}
+
+/*
+    The detected version is kept for the rest of the boot in the runtime
+    directory. The file records the boot and the pid of bluetoothd, a
+    restarted (and possibly upgraded) daemon is detected again.
+ */
+static QString bluetoothdVersionCachePath()
+{
+    const QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtimeDir.isEmpty())
+        return QString();
+    return runtimeDir + QLatin1String("/qtbluetooth-bluetoothd-version");
+}
+
+static QByteArray currentBootId()
+{
+    QFile file(QStringLiteral("/proc/sys/kernel/random/boot_id"));
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll().trimmed();
+}
+
+static QVersionNumber cachedBluetoothdVersion(qint64 daemonPid)
+{
+    const QString path = bluetoothdVersionCachePath();
+    const QByteArray bootId = currentBootId();
+    if (path.isEmpty() || bootId.isEmpty())
+        return QVersionNumber();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QVersionNumber();
+
+    // <boot id> <pid of bluetoothd> <version>
+    const QList<QByteArray> fields = file.readAll().simplified().split(' ');
+    if (fields.size() != 3 || fields.at(0) != bootId
+            || fields.at(1).toLongLong() != daemonPid) {
+        return QVersionNumber();
+    }
+    return QVersionNumber::fromString(QString::fromLatin1(fields.at(2)));
+}
+
+static void storeBluetoothdVersion(qint64 daemonPid, const QVersionNumber &version)
+{
+    const QString path = bluetoothdVersionCachePath();
+    const QByteArray bootId = currentBootId();
+    if (path.isEmpty() || bootId.isEmpty())
+        return;
+
+    // replaced atomically, other processes may read it concurrently
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    file.write(bootId + ' ' + QByteArray::number(daemonPid) + ' '
+               + version.toString().toLatin1() + '\n');
+    if (!file.commit())
+        qCDebug(QT_BT_BLUEZ) << "Cannot store bluetoothd version in" << path;
+}
+
 /*
  * This function returns the version of bluetoothd in use on the system.
  * This is required to determine which QLEControllerPrivate implementation
@@ -148,7 +248,12 @@ bool mandatoryHciIoctlsAvailable()
  *
  * This function utilizes a singleton pattern. It always returns a cached
  * version tag which is determined on first call. This is necessary to
- * avoid continuesly running the somewhat expensive tests.
+ * avoid continuesly running the somewhat expensive tests. The result of the
+ * detection is shared with later processes of the same boot.
+ *
+ * The interfaces bluetoothd exports determine the version if they imply
+ * bluetoothdVersionOfInterest or newer. Only older daemons are asked for
+ * their version by running the binary.
  *
  * The function must never return a null QVersionNumber.
  */
@@ -177,10 +282,32 @@ QVersionNumber bluetoothdVersion()
             }
         }
 
-        // 2. Find bluetoothd binary and check "bluetoothd --version"
+        // 2. Reuse the version an earlier process of this boot detected for the daemon
+        qint64 pid = 0;
         if (bluezDaemonVersion()->isNull() && qt_haveLinuxProcfs()) {
             QDBusConnection session = QDBusConnection::systemBus();
-            qint64 pid = session.interface()->servicePid(QStringLiteral("org.bluez")).value();
+            pid = session.interface()->servicePid(QStringLiteral("org.bluez")).value();
+            if (pid > 0) {
+                const QVersionNumber vn = cachedBluetoothdVersion(pid);
+                if (!vn.isNull()) {
+                    *bluezDaemonVersion() = vn;
+                    qCDebug(QT_BT_BLUEZ) << "Using bluetoothd version detected earlier:" << vn;
+                }
+            }
+        }
+
+        // 3. Derive the version from the D-Bus interfaces of the adapters
+        if (bluezDaemonVersion()->isNull() && pid > 0) {
+            const QVersionNumber vn = bluetoothdVersionFromInterfaces();
+            if (vn >= bluetoothdVersionOfInterest) {
+                qCDebug(QT_BT_BLUEZ) << "Interfaces imply bluetoothd version" << vn;
+                *bluezDaemonVersion() = vn;
+                storeBluetoothdVersion(pid, vn);
+            }
+        }
+
+        // 4. Find bluetoothd binary and check "bluetoothd --version"
+        if (bluezDaemonVersion()->isNull() && pid > 0) {
             QByteArray buffer;
 
             auto determineBinaryVersion = [](const QString &binary) -> QVersionNumber {
@@ -220,9 +347,12 @@ QVersionNumber bluetoothdVersion()
                                              << binary;
                 }
             }
+
+            if (!bluezDaemonVersion()->isNull())
+                storeBluetoothdVersion(pid, *bluezDaemonVersion());
         }
 
-        // 3. Fall back to custom ATT backend, if possible?
+        // 5. Fall back to custom ATT backend, if possible?
         if (bluezDaemonVersion()->isNull()) {
             // Check mandatory HCI ioctls are available
             if (mandatoryHciIoctlsAvailable()) {
@@ -231,7 +361,7 @@ QVersionNumber bluetoothdVersion()
             }
         }
 
-        // 4. Ultimate fallback -> enable dummy backend
+        // 6. Ultimate fallback -> enable dummy backend
         if (bluezDaemonVersion()->isNull()) {
             // version 3 represents disabled BTLE
             // bluezDaemonVersion should not be null to avoid repeated version tests
@@ -254,7 +384,7 @@ public:
 
     int reference;
     bool wasListeningAlready;
-    OrgFreedesktopDBusPropertiesInterface *propteryListener = nullptr;
+    QtBluezPropertiesMonitor *propteryListener = nullptr;
 };
 
 class QtBluezDiscoveryManagerPrivate
@@ -335,9 +465,9 @@ bool QtBluezDiscoveryManager::registerDiscoveryInterest(const QString &adapterPa
 
     AdapterData *data = new AdapterData();
 
-    OrgFreedesktopDBusPropertiesInterface *propIface = new OrgFreedesktopDBusPropertiesInterface(
-                QStringLiteral("org.bluez"), adapterPath, QDBusConnection::systemBus());
-    connect(propIface, &OrgFreedesktopDBusPropertiesInterface::PropertiesChanged,
+    QtBluezPropertiesMonitor *propIface = new QtBluezPropertiesMonitor(
+                adapterPath, QStringLiteral("org.bluez.Adapter1"));
+    connect(propIface, &QtBluezPropertiesMonitor::PropertiesChanged,
             this, &QtBluezDiscoveryManager::PropertiesChanged);
     data->propteryListener = propIface;
 
@@ -406,8 +536,7 @@ void QtBluezDiscoveryManager::PropertiesChanged(const QString &interface,
 {
     Q_UNUSED(invalidated_properties);
 
-    OrgFreedesktopDBusPropertiesInterface *propIface =
-            qobject_cast<OrgFreedesktopDBusPropertiesInterface *>(sender());
+    QtBluezPropertiesMonitor *propIface = qobject_cast<QtBluezPropertiesMonitor *>(sender());
 
     if (!propIface)
         return;
@@ -447,52 +576,617 @@ void QtBluezDiscoveryManager::removeAdapterFromMonitoring(const QString &dbusPat
     emit discoveryInterrupted(dbusPath);
 }
 
-/*
-    Finds the path for the local adapter with \a wantedAddress or an empty string
-    if no local adapter with the given address can be found.
-    If \a wantedAddress is \c null it returns the first/default adapter or an empty
-    string if none is available.
+Q_GLOBAL_STATIC(QtBluezObjectCache, objectCache)
 
-    If \a ok is false the lookup was aborted due to a dbus error and this function
-    returns an empty string.
- */
-QString findAdapterForAddress(const QBluetoothAddress &wantedAddress, bool *ok = nullptr)
+/*!
+    \internal
+    \class QtBluezObjectCache
+
+    This class keeps a process-wide copy of the object tree of org.bluez.
+
+    The tree is fetched with "org.freedesktop.DBus.ObjectManager::GetManagedObjects"
+    once and kept up to date via the InterfacesAdded, InterfacesRemoved and
+    PropertiesChanged signals. On hosts with many known devices the reply to
+    GetManagedObjects is large, all BlueZ D-Bus classes should therefore query
+    \l managedObjects() instead of calling it themselves. The adapters and
+    devices are additionally indexed by address for \l adapters() and
+    \l deviceProperties(), which findAdapterForAddress() and the local device
+    use without scanning the tree.
+
+    Only the PropertiesChanged signals of org.bluez.Adapter1, org.bluez.Device1
+    and org.bluez.Battery1 are subscribed to. The properties of the GATT objects
+    change with every notification and their users read them through their own
+    proxies, in the cache they keep the values of the time the object was added.
+
+    The signals are processed by the thread of the QCoreApplication, while the
+    accessors may be called from any thread. Every member is guarded by the
+    mutex, which is never held while a signal is emitted. Without application
+    object every call of \l managedObjects() fetches the tree again.
+    If bluetoothd goes away, the tree is dropped and fetched again once it is
+    back.
+
+    The connected devices of each adapter are tracked as well and changes of
+    that set are announced by deviceConnectionChanged(), which spares every
+    QBluetoothLocalDevice its own property monitors.
+*/
+
+QtBluezObjectCache::QtBluezObjectCache(QObject *parent) :
+    QObject(parent)
+{
+    qCDebug(QT_BT_BLUEZ) << "Creating QtBluezObjectCache";
+
+    QCoreApplication *app = QCoreApplication::instance();
+    if (!app)
+        return;
+    enabled = true;
+    moveToThread(app->thread());
+
+    QDBusConnection bus = QDBusConnection::systemBus();
+    auto manager = new OrgFreedesktopDBusObjectManagerInterface(
+                QStringLiteral("org.bluez"), QStringLiteral("/"), bus, this);
+    connect(manager, SIGNAL(InterfacesAdded(QDBusObjectPath,InterfaceList)),
+            SLOT(InterfacesAdded(QDBusObjectPath,InterfaceList)));
+    connect(manager, SIGNAL(InterfacesRemoved(QDBusObjectPath,QStringList)),
+            SLOT(InterfacesRemoved(QDBusObjectPath,QStringList)));
+    // an empty path matches all objects, arg0 limits the match to the interfaces
+    // whose properties are read from the cache
+    static const QString monitoredInterfaces[] = {
+        QStringLiteral("org.bluez.Adapter1"),
+        QStringLiteral("org.bluez.Battery1"),
+        QStringLiteral("org.bluez.Device1"),
+    };
+    for (const QString &interface : monitoredInterfaces) {
+        bus.connect(QStringLiteral("org.bluez"), QString(),
+                    QStringLiteral("org.freedesktop.DBus.Properties"),
+                    QStringLiteral("PropertiesChanged"), QStringList{ interface }, QString(),
+                    this, SLOT(PropertiesChanged(QString,QVariantMap,QStringList,QDBusMessage)));
+    }
+
+    auto watcher = new QDBusServiceWatcher(QStringLiteral("org.bluez"), bus,
+                                           QDBusServiceWatcher::WatchForOwnerChange, this);
+    connect(watcher, &QDBusServiceWatcher::serviceRegistered,
+            this, &QtBluezObjectCache::bluezRegistered);
+    connect(watcher, &QDBusServiceWatcher::serviceUnregistered,
+            this, &QtBluezObjectCache::bluezUnregistered);
+}
+
+QtBluezObjectCache::~QtBluezObjectCache()
 {
+    qCDebug(QT_BT_BLUEZ) << "Destroying QtBluezObjectCache";
+}
+
+QtBluezObjectCache *QtBluezObjectCache::instance()
+{
+    return objectCache();
+}
+
+/*!
+    Returns the managed objects of org.bluez. Only the first call, or the first
+    call after bluetoothd restarted, asks bluetoothd for them. If that fails,
+    \a error is set and an empty list is returned.
+
+    The returned list shares its data with the cache, copying it is cheap.
+*/
+ManagedObjectList QtBluezObjectCache::managedObjects(QDBusError *error)
+{
+    QMutexLocker locker(&mutex);
+    if (valid)
+        return objects;
+
     OrgFreedesktopDBusObjectManagerInterface manager(QStringLiteral("org.bluez"),
                                                      QStringLiteral("/"),
                                                      QDBusConnection::systemBus());
-
     QDBusPendingReply<ManagedObjectList> reply = manager.GetManagedObjects();
     reply.waitForFinished();
     if (reply.isError()) {
-        if (ok)
-            *ok = false;
+        if (error)
+            *error = reply.error();
+        return ManagedObjectList();
+    }
 
-        return QString();
+    if (!enabled)
+        return reply.value();
+
+    QList<ConnectionChange> changes;
+    setObjects(reply.value(), &changes);
+    const ManagedObjectList result = objects;
+    locker.unlock();
+    emitConnectionChanges(changes);
+    return result;
+}
+
+static QMap<QString, QBluetoothAddress> adapterAddressesOf(const ManagedObjectList &objects)
+{
+    static const QString adapterInterface = QStringLiteral("org.bluez.Adapter1");
+
+    QMap<QString, QBluetoothAddress> result;
+    for (auto it = objects.cbegin(); it != objects.cend(); ++it) {
+        const auto interface = it->constFind(adapterInterface);
+        if (interface == it->cend())
+            continue;
+        const QBluetoothAddress address(interface->value(QStringLiteral("Address")).toString());
+        if (!address.isNull())
+            result.insert(it.key().path(), address);
     }
+    return result;
+}
+
+/*!
+    Returns the addresses of the local adapters by object path. Other than
+    managedObjects() the caller does not need to scan the whole tree, the
+    list is kept up to date via the InterfacesAdded and InterfacesRemoved
+    signals for org.bluez.Adapter1.
+*/
+QMap<QString, QBluetoothAddress> QtBluezObjectCache::adapters(QDBusError *error)
+{
+    const ManagedObjectList managedObjectList = managedObjects(error);
 
-    typedef QPair<QString, QBluetoothAddress> AddressForPathType;
-    QList<AddressForPathType> localAdapters;
+    QMutexLocker locker(&mutex);
+    if (valid)
+        return adapterAddresses;
+    // without application object nothing is cached
+    return adapterAddressesOf(managedObjectList);
+}
 
-    ManagedObjectList managedObjectList = reply.value();
-    for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-        const QDBusObjectPath &path = it.key();
-        const InterfaceList &ifaceList = it.value();
+static ManagedObjectList::const_iterator findDevice(const ManagedObjectList &managedObjectList,
+                                                    const QString &adapterPath,
+                                                    const QBluetoothAddress &address)
+{
+    static const QString deviceInterface = QStringLiteral("org.bluez.Device1");
+
+    for (auto it = managedObjectList.cbegin(); it != managedObjectList.cend(); ++it) {
+        const auto interface = it->constFind(deviceInterface);
+        if (interface == it->cend() || !it.key().path().startsWith(adapterPath + u'/'))
+            continue;
+        QBluetoothAddress deviceAddress = deviceAddressFromPath(it.key().path());
+        if (deviceAddress.isNull())
+            deviceAddress = QBluetoothAddress(
+                        interface->value(QStringLiteral("Address")).toString());
+        if (deviceAddress == address)
+            return it;
+    }
+    return managedObjectList.cend();
+}
 
-        for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-            const QString &iface = jt.key();
+static QVariantMap findDeviceProperties(const ManagedObjectList &managedObjectList,
+                                        const QString &adapterPath,
+                                        const QBluetoothAddress &address)
+{
+    const auto it = findDevice(managedObjectList, adapterPath, address);
+    if (it == managedObjectList.cend())
+        return QVariantMap();
+    return it->value(QStringLiteral("org.bluez.Device1"));
+}
 
-            if (iface == QStringLiteral("org.bluez.Adapter1")) {
-                AddressForPathType pair;
-                pair.first = path.path();
-                pair.second = QBluetoothAddress(ifaceList.value(iface).value(
-                                          QStringLiteral("Address")).toString());
-                if (!pair.second.isNull())
-                    localAdapters.append(pair);
-                break;
-            }
+/*!
+    Returns the object path of the org.bluez.Device1 object for \a address on
+    the adapter at \a adapterPath, or an empty string if bluetoothd does not
+    know the device.
+*/
+QString QtBluezObjectCache::devicePath(const QString &adapterPath,
+                                       const QBluetoothAddress &address, QDBusError *error)
+{
+    const ManagedObjectList managedObjectList = managedObjects(error);
+
+    QMutexLocker locker(&mutex);
+    if (valid)
+        return devices.value(adapterPath).value(address.toUInt64()).path();
+    const auto it = findDevice(managedObjectList, adapterPath, address);
+    return it == managedObjectList.cend() ? QString() : it.key().path();
+}
+
+/*!
+    Returns the properties of the org.bluez.Device1 object for \a address on
+    the adapter at \a adapterPath, or an empty map if bluetoothd does not know
+    the device. Fills the cache like managedObjects() if necessary, afterwards
+    the lookup does not iterate over all objects anymore.
+*/
+QVariantMap QtBluezObjectCache::deviceProperties(const QString &adapterPath,
+                                                 const QBluetoothAddress &address,
+                                                 QDBusError *error)
+{
+    const ManagedObjectList managedObjectList = managedObjects(error);
+
+    QMutexLocker locker(&mutex);
+    if (valid)
+        return cachedDeviceProperties(adapterPath, address);
+    // without application object nothing is cached
+    return findDeviceProperties(managedObjectList, adapterPath, address);
+}
+
+/*!
+    Like deviceProperties() but does not block if the cache is not filled yet.
+    \a handler is called in the thread of \a context with the properties, or
+    with the error of GetManagedObjects.
+*/
+void QtBluezObjectCache::fetchDeviceProperties(const QString &adapterPath,
+                                               const QBluetoothAddress &address,
+                                               QObject *context,
+                                               DevicePropertiesHandler handler)
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (valid) {
+            const QVariantMap properties = cachedDeviceProperties(adapterPath, address);
+            QMetaObject::invokeMethod(context, [handler, properties]() {
+                handler(properties, QDBusError());
+            }, Qt::QueuedConnection);
+            return;
+        }
+    }
+
+    fetchObjects(context, [adapterPath, address, handler](const ManagedObjectList &objects,
+                                                          const QDBusError &error) {
+        handler(findDeviceProperties(objects, adapterPath, address), error);
+    });
+}
+
+/*!
+    Like fetchDeviceProperties() but for the device of the adapter with the
+    address \a adapterAddress, which saves the caller the lookup of the
+    adapter path.
+*/
+void QtBluezObjectCache::fetchDeviceProperties(const QBluetoothAddress &adapterAddress,
+                                               const QBluetoothAddress &address,
+                                               QObject *context,
+                                               DevicePropertiesHandler handler)
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (valid) {
+            const QVariantMap properties =
+                    cachedDeviceProperties(adapterAddresses.key(adapterAddress), address);
+            QMetaObject::invokeMethod(context, [handler, properties]() {
+                handler(properties, QDBusError());
+            }, Qt::QueuedConnection);
+            return;
+        }
+    }
+
+    fetchObjects(context, [adapterAddress, address, handler](const ManagedObjectList &objects,
+                                                             const QDBusError &error) {
+        const QString adapterPath = adapterAddressesOf(objects).key(adapterAddress);
+        handler(findDeviceProperties(objects, adapterPath, address), error);
+    });
+}
+
+/*!
+    Returns the devices connected to the adapter at \a adapterPath. The set is
+    maintained from the Connected property of org.bluez.Device1, changes are
+    reported by deviceConnectionChanged().
+*/
+QList<QBluetoothAddress> QtBluezObjectCache::connectedDevices(const QString &adapterPath,
+                                                              QDBusError *error)
+{
+    static const QString deviceInterface = QStringLiteral("org.bluez.Device1");
+
+    const ManagedObjectList managedObjectList = managedObjects(error);
+    {
+        QMutexLocker locker(&mutex);
+        if (valid)
+            return connected.value(adapterPath).values();
+    }
+
+    // without application object nothing is cached
+    QList<QBluetoothAddress> result;
+    for (auto it = managedObjectList.cbegin(); it != managedObjectList.cend(); ++it) {
+        const auto interface = it->constFind(deviceInterface);
+        if (interface == it->cend() || !it.key().path().startsWith(adapterPath + u'/')
+                || !interface->value(QStringLiteral("Connected")).toBool()) {
+            continue;
+        }
+        result.append(QBluetoothAddress(interface->value(QStringLiteral("Address")).toString()));
+    }
+    return result;
+}
+
+/*
+    Fetches the tree without blocking, fills the cache with it and calls
+    \a handler in the thread of \a context.
+*/
+void QtBluezObjectCache::fetchObjects(QObject *context, ObjectsHandler handler)
+{
+    OrgFreedesktopDBusObjectManagerInterface manager(QStringLiteral("org.bluez"),
+                                                     QStringLiteral("/"),
+                                                     QDBusConnection::systemBus());
+    auto watcher = new QDBusPendingCallWatcher(manager.GetManagedObjects(), context);
+    connect(watcher, &QDBusPendingCallWatcher::finished, context,
+            [this, handler](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        const QDBusPendingReply<ManagedObjectList> reply = *watcher;
+        if (reply.isError()) {
+            handler(ManagedObjectList(), reply.error());
+            return;
+        }
+
+        QList<ConnectionChange> changes;
+        {
+            QMutexLocker locker(&mutex);
+            // the signals since the call was sent are lost, a concurrent
+            // managedObjects() may have filled the cache with a newer tree
+            if (enabled && !valid)
+                setObjects(reply.value(), &changes);
+        }
+        emitConnectionChanges(changes);
+        handler(reply.value(), QDBusError());
+    });
+}
+
+// Called with the mutex locked.
+QVariantMap QtBluezObjectCache::cachedDeviceProperties(const QString &adapterPath,
+                                                       const QBluetoothAddress &address) const
+{
+    const QDBusObjectPath path = devices.value(adapterPath).value(address.toUInt64());
+    if (path.path().isEmpty())
+        return QVariantMap();
+    return objects.value(path).value(QStringLiteral("org.bluez.Device1"));
+}
+
+// Called with the mutex locked.
+void QtBluezObjectCache::setObjects(const ManagedObjectList &managedObjects,
+                                    QList<ConnectionChange> *changes)
+{
+    static const QString deviceInterface = QStringLiteral("org.bluez.Device1");
+
+    objects = managedObjects;
+    adapterAddresses = adapterAddressesOf(objects);
+    devices.clear();
+    connected.clear();
+    // the devices connected at the first fetch are the initial state
+    QList<ConnectionChange> *reportedChanges = fetchedBefore ? changes : nullptr;
+    for (auto it = objects.cbegin(); it != objects.cend(); ++it) {
+        const auto interface = it->constFind(deviceInterface);
+        if (interface != it->cend())
+            addDevice(it.key(), *interface, reportedChanges);
+    }
+    valid = true;
+    fetchedBefore = true;
+}
+
+// Called with the mutex locked.
+void QtBluezObjectCache::addDevice(const QDBusObjectPath &path, const QVariantMap &properties,
+                                   QList<ConnectionChange> *changes)
+{
+    QBluetoothAddress address = deviceAddressFromPath(path.path());
+    if (address.isNull())
+        address = QBluetoothAddress(properties.value(QStringLiteral("Address")).toString());
+    if (address.isNull())
+        return;
+    const QString adapterPath = path.path().left(path.path().lastIndexOf(u'/'));
+    devices[adapterPath].insert(address.toUInt64(), path);
+    if (properties.value(QStringLiteral("Connected")).toBool())
+        setConnected(adapterPath, address, true, changes);
+}
+
+// Called with the mutex locked.
+void QtBluezObjectCache::removeDevice(const QDBusObjectPath &path,
+                                      QList<ConnectionChange> *changes)
+{
+    const QString adapterPath = path.path().left(path.path().lastIndexOf(u'/'));
+    const auto adapter = devices.find(adapterPath);
+    if (adapter == devices.end())
+        return;
+    for (auto it = adapter->begin(); it != adapter->end(); ) {
+        if (it.value() == path) {
+            setConnected(adapterPath, QBluetoothAddress(it.key()), false, changes);
+            it = adapter->erase(it);
+        } else {
+            ++it;
         }
     }
+}
+
+// Called with the mutex locked.
+void QtBluezObjectCache::setConnected(const QString &adapterPath,
+                                      const QBluetoothAddress &address, bool isConnected,
+                                      QList<ConnectionChange> *changes)
+{
+    QSet<QBluetoothAddress> &adapterConnections = connected[adapterPath];
+    const bool changed = isConnected ? !adapterConnections.contains(address)
+                                     : adapterConnections.contains(address);
+    if (!changed)
+        return;
+
+    if (isConnected)
+        adapterConnections.insert(address);
+    else
+        adapterConnections.remove(address);
+    if (changes)
+        changes->append({ adapterPath, address, isConnected });
+}
+
+// Called with the mutex unlocked, the receivers may call into the cache.
+void QtBluezObjectCache::emitConnectionChanges(const QList<ConnectionChange> &changes)
+{
+    for (const ConnectionChange &change : changes)
+        emit deviceConnectionChanged(change.adapterPath, change.address, change.connected);
+}
+
+void QtBluezObjectCache::InterfacesAdded(const QDBusObjectPath &object_path,
+                                         InterfaceList interfaces_and_properties)
+{
+    QMutexLocker locker(&mutex);
+    if (!valid)
+        return;
+
+    QList<ConnectionChange> changes;
+    InterfaceList &interfaces = objects[object_path];
+    for (auto it = interfaces_and_properties.cbegin(); it != interfaces_and_properties.cend(); ++it)
+        interfaces.insert(it.key(), it.value());
+
+    const auto device = interfaces_and_properties.constFind(QStringLiteral("org.bluez.Device1"));
+    if (device != interfaces_and_properties.cend())
+        addDevice(object_path, *device, &changes);
+
+    const auto adapter = interfaces_and_properties.constFind(QStringLiteral("org.bluez.Adapter1"));
+    if (adapter != interfaces_and_properties.cend()) {
+        const QBluetoothAddress address(adapter->value(QStringLiteral("Address")).toString());
+        if (!address.isNull())
+            adapterAddresses.insert(object_path.path(), address);
+    }
+
+    locker.unlock();
+    emitConnectionChanges(changes);
+}
+
+void QtBluezObjectCache::InterfacesRemoved(const QDBusObjectPath &object_path,
+                                           const QStringList &interfaces)
+{
+    QMutexLocker locker(&mutex);
+    if (!valid)
+        return;
+
+    auto it = objects.find(object_path);
+    if (it == objects.end())
+        return;
+
+    for (const QString &interface : interfaces)
+        it->remove(interface);
+    if (it->isEmpty())
+        objects.erase(it);
+
+    QList<ConnectionChange> changes;
+    if (interfaces.contains(QStringLiteral("org.bluez.Device1")))
+        removeDevice(object_path, &changes);
+    if (interfaces.contains(QStringLiteral("org.bluez.Adapter1"))) {
+        adapterAddresses.remove(object_path.path());
+        devices.remove(object_path.path());
+        for (const QBluetoothAddress &address : connected.take(object_path.path()))
+            changes.append({ object_path.path(), address, false });
+    }
+
+    locker.unlock();
+    emitConnectionChanges(changes);
+}
+
+void QtBluezObjectCache::PropertiesChanged(const QString &interface,
+                                           const QVariantMap &changed_properties,
+                                           const QStringList &invalidated_properties,
+                                           const QDBusMessage &msg)
+{
+    QMutexLocker locker(&mutex);
+    if (!valid)
+        return;
+
+    // objects which are not exported via the object manager are of no interest
+    auto objectIt = objects.find(QDBusObjectPath(msg.path()));
+    if (objectIt == objects.end())
+        return;
+    auto interfaceIt = objectIt->find(interface);
+    if (interfaceIt == objectIt->end())
+        return;
+
+    for (auto it = changed_properties.cbegin(); it != changed_properties.cend(); ++it)
+        interfaceIt->insert(it.key(), it.value());
+    for (const QString &property : invalidated_properties)
+        interfaceIt->remove(property);
+
+    const auto connectedIt = changed_properties.constFind(QStringLiteral("Connected"));
+    if (connectedIt == changed_properties.cend()
+            || interface != QStringLiteral("org.bluez.Device1")) {
+        return;
+    }
+
+    QBluetoothAddress address = deviceAddressFromPath(msg.path());
+    if (address.isNull())
+        address = QBluetoothAddress(interfaceIt->value(QStringLiteral("Address")).toString());
+    if (address.isNull())
+        return;
+
+    QList<ConnectionChange> changes;
+    setConnected(msg.path().left(msg.path().lastIndexOf(u'/')), address,
+                 connectedIt->toBool(), &changes);
+    locker.unlock();
+    emitConnectionChanges(changes);
+}
+
+void QtBluezObjectCache::bluezUnregistered()
+{
+    qCDebug(QT_BT_BLUEZ) << "bluetoothd went away, dropping cached objects";
+
+    QMutexLocker locker(&mutex);
+    QList<ConnectionChange> changes;
+    for (auto it = connected.cbegin(); it != connected.cend(); ++it) {
+        for (const QBluetoothAddress &address : it.value())
+            changes.append({ it.key(), address, false });
+    }
+    objects.clear();
+    adapterAddresses.clear();
+    devices.clear();
+    connected.clear();
+    valid = false;
+
+    locker.unlock();
+    emitConnectionChanges(changes);
+}
+
+void QtBluezObjectCache::bluezRegistered()
+{
+    qCDebug(QT_BT_BLUEZ) << "bluetoothd is back, fetching objects";
+
+    // reports the devices connected in the meantime
+    fetchObjects(this, [](const ManagedObjectList &, const QDBusError &error) {
+        if (error.isValid())
+            qCWarning(QT_BT_BLUEZ) << "Cannot fetch the BlueZ objects:" << error.message();
+    });
+}
+
+/*!
+    \internal
+    \class QtBluezPropertiesMonitor
+
+    This class reports the property changes of \a interface on the object at
+    \a path of org.bluez. An empty \a path monitors all objects.
+
+    Unlike OrgFreedesktopDBusPropertiesInterface, the match rule registered
+    with the bus contains the interface name as arg0. The bus daemon therefore
+    only wakes us up for the changes we are interested in, instead of for
+    every property change on the object(s), most of which would be discarded.
+*/
+
+QtBluezPropertiesMonitor::QtBluezPropertiesMonitor(const QString &path, const QString &interface,
+                                                   QObject *parent) :
+    QObject(parent), objectPath(path), interfaceName(interface)
+{
+    const bool success = QDBusConnection::systemBus().connect(
+                QStringLiteral("org.bluez"), path,
+                QStringLiteral("org.freedesktop.DBus.Properties"),
+                QStringLiteral("PropertiesChanged"), QStringList{ interface }, QString(), this,
+                SLOT(propertiesChangedReceived(QString,QVariantMap,QStringList,QDBusMessage)));
+    if (!success)
+        qCWarning(QT_BT_BLUEZ) << "Cannot monitor properties of" << interface << "on" << path;
+}
+
+void QtBluezPropertiesMonitor::propertiesChangedReceived(const QString &interface,
+                                                         const QVariantMap &changed_properties,
+                                                         const QStringList &invalidated_properties,
+                                                         const QDBusMessage &msg)
+{
+    // the match rule already filtered by interface, the receiver is
+    // disconnected from the bus automatically when it is destroyed
+    emit PropertiesChanged(interface, changed_properties, invalidated_properties, msg);
+}
+
+/*
+    Finds the path for the local adapter with \a wantedAddress or an empty string
+    if no local adapter with the given address can be found.
+    If \a wantedAddress is \c null it returns the first/default adapter or an empty
+    string if none is available.
+
+    If \a ok is false the lookup was aborted due to a dbus error and this function
+    returns an empty string.
+ */
+QString findAdapterForAddress(const QBluetoothAddress &wantedAddress, bool *ok = nullptr)
+{
+    QDBusError error;
+    const QMap<QString, QBluetoothAddress> localAdapters =
+            QtBluezObjectCache::instance()->adapters(&error);
+    if (error.isValid()) {
+        if (ok)
+            *ok = false;
+
+        return QString();
+    }
 
     if (ok)
         *ok = true;
@@ -501,16 +1195,75 @@ QString findAdapterForAddress(const QBluetoothAddress &wantedAddress, bool *ok =
         return QString(); // -> no local adapter found
 
     if (wantedAddress.isNull())
-        return localAdapters.front().first; // -> return first found adapter
+        return localAdapters.firstKey(); // -> return first found adapter
 
-    for (const AddressForPathType &pair : qAsConst(localAdapters)) {
-        if (pair.second == wantedAddress)
-            return pair.first; // -> found local adapter with wanted address
+    for (auto it = localAdapters.cbegin(); it != localAdapters.cend(); ++it) {
+        if (it.value() == wantedAddress)
+            return it.key(); // -> found local adapter with wanted address
     }
 
     return QString(); // nothing matching found
 }
 
+/*
+    Returns the address of the remote device whose object path is \a path, or a
+    null address if \a path is not the path of a device. bluetoothd names device
+    objects after their address, e.g. /org/bluez/hci0/dev_00_11_22_33_44_55.
+ */
+QBluetoothAddress deviceAddressFromPath(QStringView path)
+{
+    const QStringView name = path.sliced(path.lastIndexOf(u'/') + 1);
+    if (!name.startsWith(u"dev_"))
+        return QBluetoothAddress();
+    return QBluetoothAddress(qt_parseBluetoothAddress(name.sliced(4), u'_'));
+}
+
+/*
+    The dictionaries of variants a{qv} and a{sv} reach us as QDBusArgument.
+    Reading the entries straight from it saves building the QMap of
+    QDBusVariant qdbus_cast() would return, which matters as bluetoothd sends
+    these properties with every advertisement. Maps which were demarshalled
+    already are converted instead.
+ */
+template <typename Key, typename Map, typename KeyConverter>
+static QList<std::pair<Key, QByteArray>> bluezDataList(const QVariant &value,
+                                                       KeyConverter toKey)
+{
+    QList<std::pair<Key, QByteArray>> result;
+    if (value.metaType() == QMetaType::fromType<QDBusArgument>()) {
+        // reading a copy detaches it, the variant can be read again
+        const QDBusArgument argument = value.value<QDBusArgument>();
+        argument.beginMap();
+        while (!argument.atEnd()) {
+            typename Map::key_type key;
+            QDBusVariant data;
+            argument.beginMapEntry();
+            argument >> key >> data;
+            argument.endMapEntry();
+            result.append(std::make_pair(toKey(key), data.variant().toByteArray()));
+        }
+        argument.endMap();
+    } else if (value.isValid()) {
+        const Map map = qdbus_cast<Map>(value);
+        result.reserve(map.size());
+        for (auto it = map.cbegin(); it != map.cend(); ++it)
+            result.append(std::make_pair(toKey(it.key()), it.value().variant().toByteArray()));
+    }
+    return result;
+}
+
+QList<std::pair<quint16, QByteArray>> bluezManufacturerData(const QVariant &value)
+{
+    return bluezDataList<quint16, ManufacturerDataList>(value, [](quint16 id) { return id; });
+}
+
+QList<std::pair<QBluetoothUuid, QByteArray>> bluezServiceData(const QVariant &value)
+{
+    return bluezDataList<QBluetoothUuid, ServiceDataList>(value, [](const QString &uuid) {
+        return QBluetoothUuid(uuid);
+    });
+}
+
 /*
     Removes every character that cannot be used in QDbusObjectPath
 
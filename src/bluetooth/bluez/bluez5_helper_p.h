@@ -15,12 +15,16 @@
 // We mean it.
 //
 
+#include <QtCore/QMutex>
 #include <QtCore/QObject>
+#include <QtCore/QSet>
 #include <QtDBus/QtDBus>
 #include <QtBluetooth/QBluetoothUuid>
 #include <QtBluetooth/QBluetoothAddress>
 #include <QtBluetooth/private/qtbluetoothglobal_p.h>
 
+#include <functional>
+
 typedef QMap<QString, QVariantMap> InterfaceList;
 typedef QMap<QDBusObjectPath, InterfaceList> ManagedObjectList;
 typedef QMap<quint16, QDBusVariant> ManufacturerDataList;
@@ -42,6 +46,11 @@ Q_BLUETOOTH_PRIVATE_EXPORT QVersionNumber bluetoothdVersion();
 QString sanitizeNameForDBus(const QString& text);
 
 QString findAdapterForAddress(const QBluetoothAddress &wantedAddress, bool *ok);
+QBluetoothAddress deviceAddressFromPath(QStringView path);
+
+// decode the ManufacturerData and ServiceData properties of org.bluez.Device1
+QList<std::pair<quint16, QByteArray>> bluezManufacturerData(const QVariant &value);
+QList<std::pair<QBluetoothUuid, QByteArray>> bluezServiceData(const QVariant &value);
 
 class QtBluezDiscoveryManagerPrivate;
 class QtBluezDiscoveryManager : public QObject
@@ -74,6 +83,108 @@ private:
     QtBluezDiscoveryManagerPrivate *d;
 };
 
+class QtBluezObjectCache : public QObject
+{
+    Q_OBJECT
+public:
+    QtBluezObjectCache(QObject *parent = nullptr);
+    ~QtBluezObjectCache();
+    static QtBluezObjectCache *instance();
+
+    ManagedObjectList managedObjects(QDBusError *error = nullptr);
+    QMap<QString, QBluetoothAddress> adapters(QDBusError *error = nullptr);
+    QString devicePath(const QString &adapterPath, const QBluetoothAddress &address,
+                       QDBusError *error = nullptr);
+    QVariantMap deviceProperties(const QString &adapterPath, const QBluetoothAddress &address,
+                                 QDBusError *error = nullptr);
+    using DevicePropertiesHandler = std::function<void(const QVariantMap &, const QDBusError &)>;
+    void fetchDeviceProperties(const QString &adapterPath, const QBluetoothAddress &address,
+                               QObject *context, DevicePropertiesHandler handler);
+    void fetchDeviceProperties(const QBluetoothAddress &adapterAddress,
+                               const QBluetoothAddress &address, QObject *context,
+                               DevicePropertiesHandler handler);
+    QList<QBluetoothAddress> connectedDevices(const QString &adapterPath,
+                                              QDBusError *error = nullptr);
+
+signals:
+    void deviceConnectionChanged(const QString &adapterPath, const QBluetoothAddress &address,
+                                 bool connected);
+
+private slots:
+    void InterfacesAdded(const QDBusObjectPath &object_path,
+                         InterfaceList interfaces_and_properties);
+    void InterfacesRemoved(const QDBusObjectPath &object_path,
+                           const QStringList &interfaces);
+    void PropertiesChanged(const QString &interface,
+                           const QVariantMap &changed_properties,
+                           const QStringList &invalidated_properties,
+                           const QDBusMessage &msg);
+    void bluezRegistered();
+    void bluezUnregistered();
+
+private:
+    struct ConnectionChange
+    {
+        QString adapterPath;
+        QBluetoothAddress address;
+        bool connected;
+    };
+    using ObjectsHandler = std::function<void(const ManagedObjectList &, const QDBusError &)>;
+
+    void fetchObjects(QObject *context, ObjectsHandler handler);
+    void setObjects(const ManagedObjectList &managedObjects, QList<ConnectionChange> *changes);
+    void addDevice(const QDBusObjectPath &path, const QVariantMap &properties,
+                   QList<ConnectionChange> *changes);
+    void removeDevice(const QDBusObjectPath &path, QList<ConnectionChange> *changes);
+    void setConnected(const QString &adapterPath, const QBluetoothAddress &address,
+                      bool connected, QList<ConnectionChange> *changes);
+    void emitConnectionChanges(const QList<ConnectionChange> &changes);
+    QVariantMap cachedDeviceProperties(const QString &adapterPath,
+                                       const QBluetoothAddress &address) const;
+
+    // guards the members below, they are written by the application thread and
+    // read by the thread of any caller
+    QMutex mutex;
+    ManagedObjectList objects;
+    // addresses of the org.bluez.Adapter1 objects by path
+    QMap<QString, QBluetoothAddress> adapterAddresses;
+    // org.bluez.Device1 objects by adapter path and device address
+    QHash<QString, QHash<quint64, QDBusObjectPath>> devices;
+    // connected org.bluez.Device1 objects by adapter path
+    QHash<QString, QSet<QBluetoothAddress>> connected;
+    bool valid = false;
+    bool enabled = false;
+    // whether the tree was fetched before, only a refetch reports connection changes
+    bool fetchedBefore = false;
+};
+
+class QtBluezPropertiesMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    QtBluezPropertiesMonitor(const QString &path, const QString &interface,
+                             QObject *parent = nullptr);
+
+    QString path() const { return objectPath; }
+    QString interface() const { return interfaceName; }
+
+signals:
+    void PropertiesChanged(const QString &interface,
+                           const QVariantMap &changed_properties,
+                           const QStringList &invalidated_properties,
+                           const QDBusMessage &msg);
+
+private slots:
+    void propertiesChangedReceived(const QString &interface,
+                                   const QVariantMap &changed_properties,
+                                   const QStringList &invalidated_properties,
+                                   const QDBusMessage &msg);
+
+private:
+    const QString objectPath;
+    const QString interfaceName;
+};
+
 QT_END_NAMESPACE
 
 #endif
@@ -24,12 +24,14 @@
 QT_BEGIN_NAMESPACE
 
 #define ATTRIBUTE_CHANNEL_ID 4
+#define EATT_PSM 0x27
 #define SIGNALING_CHANNEL_ID 5
 #define SECURITY_CHANNEL_ID 6
 
 #define BTPROTO_L2CAP   0
 #define BTPROTO_HCI     1
 #define BTPROTO_RFCOMM  3
+#define BTPROTO_ISO     8
 
 #define SOL_HCI     0
 #define SOL_L2CAP   6
@@ -61,6 +63,63 @@ struct bt_security {
 #define BT_SECURITY_MEDIUM  2
 #define BT_SECURITY_HIGH    3
 
+#define BT_SNDMTU   12
+#define BT_RCVMTU   13
+#define BT_MODE     15
+#define BT_MODE_EXT_FLOWCTL 0x04
+
+// LE isochronous channels, see linux/include/net/bluetooth/bluetooth.h
+#define BT_ISO_QOS  17
+#define BT_ISO_QOS_CIG_UNSET    0xff
+#define BT_ISO_QOS_CIS_UNSET    0xff
+#define BT_ISO_QOS_BIG_UNSET    0xff
+#define BT_ISO_QOS_BIS_UNSET    0xff
+#define BT_ISO_SYNC_TIMEOUT     0x07d0 // 20 s
+
+struct bt_iso_io_qos {
+    quint32 interval;
+    quint16 latency;
+    quint16 sdu;
+    quint8 phy;
+    quint8 rtn;
+};
+
+struct bt_iso_ucast_qos {
+    quint8 cig;
+    quint8 cis;
+    quint8 sca;
+    quint8 packing;
+    quint8 framing;
+    bt_iso_io_qos in;
+    bt_iso_io_qos out;
+};
+
+struct bt_iso_bcast_qos {
+    quint8 big;
+    quint8 bis;
+    quint8 sync_factor;
+    quint8 packing;
+    quint8 framing;
+    bt_iso_io_qos in;
+    bt_iso_io_qos out;
+    quint8 encryption;
+    quint8 bcode[16];
+    quint8 options;
+    quint16 skip;
+    quint16 sync_timeout;
+    quint8 sync_cte_type;
+    quint8 mse;
+    quint16 timeout;
+};
+
+struct bt_iso_qos {
+    union {
+        bt_iso_ucast_qos ucast;
+        bt_iso_bcast_qos bcast;
+    };
+};
+
+#define BDADDR_BREDR        0x00
 #define BDADDR_LE_PUBLIC    0x01
 #define BDADDR_LE_RANDOM    0x02
 
@@ -115,6 +174,25 @@ struct sockaddr_rc {
     quint8      rc_channel;
 };
 
+// ISO socket
+#define ISO_MAX_NUM_BIS 0x1f
+
+struct sockaddr_iso_bc {
+    bdaddr_t    bc_bdaddr;
+    quint8      bc_bdaddr_type;
+    quint8      bc_sid;
+    quint8      bc_num_bis;
+    quint8      bc_bis[ISO_MAX_NUM_BIS];
+};
+
+struct sockaddr_iso {
+    sa_family_t     iso_family;
+    bdaddr_t        iso_bdaddr;
+    quint8          iso_bdaddr_type;
+    // a flexible array in the kernel, only passed for broadcast streams
+    sockaddr_iso_bc iso_bc;
+};
+
 // Bt Low Energy related
 
 #if __BYTE_ORDER == __LITTLE_ENDIAN
@@ -181,8 +259,12 @@ template<> inline void putBtData(quint128 src, void *dst)
 #define HCI_MAX_EVENT_SIZE 260
 
 // HCI sockopts
+#define HCI_DATA_DIR 1
 #define HCI_FILTER 2
 
+// HCI control messages
+#define HCI_CMSG_DIR 0x0001
+
 // HCI packet types
 #define HCI_COMMAND_PKT 0x01
 #define HCI_ACL_PKT     0x02
@@ -321,6 +403,12 @@ struct evt_cmd_complete {
     quint16 opcode;
 } __attribute__ ((packed));
 
+struct evt_cmd_status {
+    quint8 status;
+    quint8 ncmd;
+    quint16 opcode;
+} __attribute__ ((packed));
+
 struct AclData {
     quint16 handle: 12;
     quint16 pbFlag: 2;
@@ -351,9 +439,24 @@ namespace QBluezConst {
         OcfLeSetAdvData = 0x8,
         OcfLeSetScanResponseData = 0x9,
         OcfLeSetAdvEnable = 0xa,
+        OcfLeCreateConnection = 0xd,
+        OcfLeCreateConnectionCancel = 0xe,
         OcfLeClearWhiteList = 0x10,
         OcfLeAddToWhiteList = 0x11,
         OcfLeConnectionUpdate = 0x13,
+        OcfLeSetDataLength = 0x22,
+        OcfLeSetPhy = 0x32,
+        OcfLeSetExtAdvParams = 0x36,
+        OcfLeSetExtAdvData = 0x37,
+        OcfLeSetExtScanResponseData = 0x38,
+        OcfLeSetExtAdvEnable = 0x39,
+        OcfLeRemoveAdvSet = 0x3c,
+        OcfLeSetPeriodicAdvParams = 0x3e,
+        OcfLeSetPeriodicAdvData = 0x3f,
+        OcfLeSetPeriodicAdvEnable = 0x40,
+        OcfLePeriodicAdvCreateSync = 0x44,
+        OcfLePeriodicAdvCreateSyncCancel = 0x45,
+        OcfLePeriodicAdvTerminateSync = 0x46,
     };
     Q_ENUM_NS(OpCodeCommandField)
 
@@ -384,6 +487,8 @@ namespace QBluezConst {
         ATT_OP_HANDLE_VAL_NOTIFICATION     = 0x1b, //informs about value change
         ATT_OP_HANDLE_VAL_INDICATION       = 0x1d, //informs about value change -> requires reply
         ATT_OP_HANDLE_VAL_CONFIRMATION     = 0x1e, //answer for ATT_OP_HANDLE_VAL_INDICATION
+        ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST  = 0x20, //read several values of variable length
+        ATT_OP_READ_MULTIPLE_VARIABLE_RESPONSE = 0x21,
         ATT_OP_WRITE_COMMAND               = 0x52, //write characteristic without response
         ATT_OP_SIGNED_WRITE_COMMAND        = 0xD2
     };
@@ -0,0 +1,188 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "btsnoop_p.h"
+
+#include <QtCore/qendian.h>
+#include <QtCore/qloggingcategory.h>
+
+#include <chrono>
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+static constexpr char btSnoopMagic[8] = { 'b', 't', 's', 'n', 'o', 'o', 'p', '\0' };
+static constexpr quint32 btSnoopVersion = 1;
+static constexpr int btSnoopHeaderSize = 16;
+static constexpr int btSnoopRecordHeaderSize = 24;
+
+// datalink types
+static constexpr quint32 btSnoopHci = 1001;
+static constexpr quint32 btSnoopHciUart = 1002;
+static constexpr quint32 btSnoopMonitor = 2001;
+
+// btsnoop timestamps count microseconds since midnight, January 1st of year 0
+static constexpr qint64 btSnoopUnixEpoch = Q_INT64_C(0x00E03AB44A676000);
+
+static constexpr quint32 btSnoopFlagReceived = 0x01;
+static constexpr quint32 btSnoopFlagCommandOrEvent = 0x02;
+static constexpr quint16 monitorAclTxPacket = 5;
+static constexpr quint16 monitorAclRxPacket = 6;
+
+static constexpr quint8 h4AclPacket = 0x02;
+static constexpr quint16 aclStartOfPacket = 0x2;
+static constexpr quint16 aclContinuationFragment = 0x1;
+static constexpr int aclHeaderSize = 4;
+static constexpr int l2capHeaderSize = 4;
+static constexpr quint16 attributeChannelId = 0x0004;
+
+bool BtSnoopWriter::open(const QString &fileName)
+{
+    file.setFileName(fileName);
+    // every record is a single write so that a capture survives a crash
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot open ATT capture" << fileName << file.errorString();
+        return false;
+    }
+
+    char header[btSnoopHeaderSize];
+    memcpy(header, btSnoopMagic, sizeof btSnoopMagic);
+    qToBigEndian<quint32>(btSnoopVersion, header + 8);
+    qToBigEndian<quint32>(btSnoopHciUart, header + 12);
+    if (file.write(header, sizeof header) != qint64(sizeof header)) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot write ATT capture" << fileName << file.errorString();
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+void BtSnoopWriter::writeAttPdu(quint16 connectionHandle, bool received, const QByteArray &pdu)
+{
+    if (!file.isOpen())
+        return;
+
+    const auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::system_clock::now().time_since_epoch());
+    const quint32 packetSize = 1 + aclHeaderSize + l2capHeaderSize + pdu.size();
+
+    QByteArray record(btSnoopRecordHeaderSize + packetSize, Qt::Uninitialized);
+    char *data = record.data();
+    qToBigEndian<quint32>(packetSize, data);
+    qToBigEndian<quint32>(packetSize, data + 4);
+    qToBigEndian<quint32>(received ? btSnoopFlagReceived : 0, data + 8);
+    qToBigEndian<quint32>(0, data + 12); // dropped packets
+    qToBigEndian<qint64>(now.count() + btSnoopUnixEpoch, data + 16);
+
+    data += btSnoopRecordHeaderSize;
+    *data++ = char(h4AclPacket);
+    qToLittleEndian<quint16>((connectionHandle & 0x0fff) | (aclStartOfPacket << 12), data);
+    qToLittleEndian<quint16>(l2capHeaderSize + pdu.size(), data + 2);
+    qToLittleEndian<quint16>(pdu.size(), data + 4);
+    qToLittleEndian<quint16>(attributeChannelId, data + 6);
+    memcpy(data + aclHeaderSize + l2capHeaderSize, pdu.constData(), pdu.size());
+
+    if (file.write(record) != record.size()) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot write ATT capture, stopping it:" << file.errorString();
+        file.close();
+    }
+}
+
+bool BtSnoopReader::readAttRecords(const QString &fileName, QList<BtSnoopAttRecord> *records)
+{
+    Q_ASSERT(records);
+    records->clear();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot open ATT capture" << fileName << file.errorString();
+        return false;
+    }
+
+    const QByteArray header = file.read(btSnoopHeaderSize);
+    if (header.size() != btSnoopHeaderSize
+            || memcmp(header.constData(), btSnoopMagic, sizeof btSnoopMagic) != 0
+            || qFromBigEndian<quint32>(header.constData() + 8) != btSnoopVersion) {
+        qCWarning(QT_BT_BLUEZ) << fileName << "is not a btsnoop capture";
+        return false;
+    }
+    const quint32 datalink = qFromBigEndian<quint32>(header.constData() + 12);
+    if (datalink != btSnoopHci && datalink != btSnoopHciUart && datalink != btSnoopMonitor) {
+        qCWarning(QT_BT_BLUEZ) << "Unsupported btsnoop datalink type" << datalink;
+        return false;
+    }
+
+    // L2CAP frames under reassembly, by direction
+    QByteArray frames[2];
+    int connectionHandle = -1;
+
+    while (!file.atEnd()) {
+        const QByteArray recordHeader = file.read(btSnoopRecordHeaderSize);
+        if (recordHeader.size() != btSnoopRecordHeaderSize)
+            break; // truncated by a crash, keep what we have
+        const quint32 includedLength = qFromBigEndian<quint32>(recordHeader.constData() + 4);
+        const quint32 flags = qFromBigEndian<quint32>(recordHeader.constData() + 8);
+        const qint64 timestamp = qFromBigEndian<qint64>(recordHeader.constData() + 16)
+                                    - btSnoopUnixEpoch;
+        QByteArray packet = file.read(includedLength);
+        if (packet.size() != qsizetype(includedLength))
+            break;
+
+        bool received = flags & btSnoopFlagReceived;
+        switch (datalink) {
+        case btSnoopHciUart:
+            if (packet.isEmpty() || quint8(packet.at(0)) != h4AclPacket)
+                continue;
+            packet.remove(0, 1);
+            break;
+        case btSnoopHci:
+            if (flags & btSnoopFlagCommandOrEvent)
+                continue;
+            break;
+        case btSnoopMonitor: {
+            const quint16 opcode = flags & 0xffff;
+            if (opcode != monitorAclTxPacket && opcode != monitorAclRxPacket)
+                continue;
+            received = opcode == monitorAclRxPacket;
+            break;
+        }
+        }
+
+        if (packet.size() < aclHeaderSize)
+            continue;
+        const quint16 handleAndFlags = qFromLittleEndian<quint16>(packet.constData());
+        const quint16 handle = handleAndFlags & 0x0fff;
+        if (connectionHandle >= 0 && handle != connectionHandle)
+            continue;
+
+        QByteArray &frame = frames[received];
+        const QByteArray payload = packet.mid(aclHeaderSize,
+                                              qFromLittleEndian<quint16>(packet.constData() + 2));
+        if (((handleAndFlags >> 12) & 0x3) == aclContinuationFragment) {
+            if (frame.isEmpty())
+                continue; // start of the frame is not part of the capture
+            frame.append(payload);
+        } else {
+            frame = payload;
+        }
+
+        if (frame.size() < l2capHeaderSize)
+            continue;
+        const quint16 l2capLength = qFromLittleEndian<quint16>(frame.constData());
+        if (frame.size() < l2capHeaderSize + l2capLength)
+            continue;
+
+        if (qFromLittleEndian<quint16>(frame.constData() + 2) == attributeChannelId
+                && l2capLength > 0) {
+            connectionHandle = handle;
+            records->append({ timestamp, received, frame.mid(l2capHeaderSize, l2capLength) });
+        }
+        frame.clear();
+    }
+
+    return true;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,65 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef BTSNOOP_P_H
+#define BTSNOOP_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qstring.h>
+
+QT_BEGIN_NAMESPACE
+
+// One ATT PDU of a capture, the timestamp is in microseconds since the Unix epoch.
+struct BtSnoopAttRecord
+{
+    qint64 timestamp = 0;
+    bool received = false;
+    QByteArray pdu;
+};
+
+/*
+ * Writes the ATT PDUs of a connection in the btsnoop format as used by
+ * btmon and Wireshark. Each PDU is wrapped into an L2CAP frame on the
+ * attribute channel and an HCI ACL packet with UART (H4) framing.
+ */
+class BtSnoopWriter
+{
+public:
+    bool open(const QString &fileName);
+    bool isOpen() const { return file.isOpen(); }
+    void close() { file.close(); }
+
+    void writeAttPdu(quint16 connectionHandle, bool received, const QByteArray &pdu);
+
+private:
+    QFile file;
+};
+
+/*
+ * Reads the ATT PDUs of the first LE connection in a btsnoop capture. Besides
+ * the H4 captures written by BtSnoopWriter this accepts unencapsulated HCI
+ * captures and the captures of btmon. Fragmented ACL packets are reassembled,
+ * L2CAP frames on other channels are skipped.
+ */
+class BtSnoopReader
+{
+public:
+    static bool readAttRecords(const QString &fileName, QList<BtSnoopAttRecord> *records);
+};
+
+QT_END_NAMESPACE
+
+#endif // BTSNOOP_P_H
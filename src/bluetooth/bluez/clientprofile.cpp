@@ -0,0 +1,232 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "clientprofile_p.h"
+#include "bluez5_helper_p.h"
+#include "profile1context_p.h"
+#include "profilemanager1_p.h"
+
+#include <QtBluetooth/qbluetoothsocket.h>
+
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qrandom.h>
+#include <QtCore/qthread.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+using namespace std::chrono_literals;
+
+static const QLatin1String profilePathTemplate("/qt/btsocket/%1%2/%3");
+
+// how long an unused profile stays registered with bluetoothd
+static constexpr auto profileIdleTimeout = 30s;
+
+namespace {
+struct ProfileRegistry
+{
+    QMutex mutex;
+    QHash<QPair<QThread *, QString>, QtBluezClientProfile *> profiles;
+};
+}
+
+Q_GLOBAL_STATIC(ProfileRegistry, profileRegistry)
+
+QtBluezClientProfile::QtBluezClientProfile(const QString &uuid)
+    : serviceUuid(uuid)
+{
+    profileManager = new OrgBluezProfileManager1Interface(QStringLiteral("org.bluez"),
+                                                          QStringLiteral("/org/bluez"),
+                                                          QDBusConnection::systemBus(), this);
+
+    idleTimer.setSingleShot(true);
+    idleTimer.setInterval(profileIdleTimeout);
+    connect(&idleTimer, &QTimer::timeout, this, [this]() {
+        qCDebug(QT_BT_BLUEZ) << "Client profile for" << serviceUuid << "unused, unregistering";
+        dropFromRegistry();
+        deleteLater();
+    });
+}
+
+QtBluezClientProfile::~QtBluezClientProfile()
+{
+    unregisterProfile();
+}
+
+/*!
+    Returns the profile for \a uuid of the current thread and adds \a client
+    to it. The first client registers the profile with bluetoothd. Returns
+    \c nullptr and sets \a errorString if that fails.
+*/
+QtBluezClientProfile *QtBluezClientProfile::acquire(const QString &uuid, const void *client,
+                                                    QString *errorString)
+{
+    ProfileRegistry *registry = profileRegistry();
+    QMutexLocker locker(&registry->mutex);
+
+    const auto key = qMakePair(QThread::currentThread(), uuid);
+    QtBluezClientProfile *profile = registry->profiles.value(key);
+    if (!profile) {
+        profile = new QtBluezClientProfile(uuid);
+        if (!profile->registerProfile(errorString)) {
+            delete profile;
+            return nullptr;
+        }
+        registry->profiles.insert(key, profile);
+    }
+
+    profile->idleTimer.stop();
+    if (!profile->clients.contains(client))
+        profile->clients.append(client);
+    return profile;
+}
+
+/*!
+    Removes \a client and its pending connection from the profile. The
+    profile is unregistered once it was not used for a while.
+*/
+void QtBluezClientProfile::release(const void *client)
+{
+    cancelConnection(client);
+    if (!clients.removeOne(client) || !clients.isEmpty())
+        return;
+
+    if (registered)
+        idleTimer.start();
+    else
+        deleteLater(); // bluetoothd released us already
+}
+
+void QtBluezClientProfile::expectConnection(const void *client, const QString &devicePath,
+                                            ConnectionHandler handler)
+{
+    pendingConnections[devicePath].append({ client, std::move(handler) });
+}
+
+void QtBluezClientProfile::cancelConnection(const void *client)
+{
+    for (auto it = pendingConnections.begin(); it != pendingConnections.end(); ) {
+        it->removeIf([client](const PendingConnection &pending) {
+            return pending.client == client;
+        });
+        if (it->isEmpty())
+            it = pendingConnections.erase(it);
+        else
+            ++it;
+    }
+}
+
+void QtBluezClientProfile::newConnection(const QDBusObjectPath &device,
+                                         const QDBusUnixFileDescriptor &fd)
+{
+    const auto it = pendingConnections.find(device.path());
+    if (it == pendingConnections.end()) {
+        // the connection was cancelled, bluetoothd closes its copy of the fd
+        qCDebug(QT_BT_BLUEZ) << "Unexpected profile connection from" << device.path();
+        return;
+    }
+
+    const PendingConnection pending = it->takeFirst();
+    if (it->isEmpty())
+        pendingConnections.erase(it);
+    pending.handler(fd);
+}
+
+void QtBluezClientProfile::released()
+{
+    qCDebug(QT_BT_BLUEZ) << "Client profile for" << serviceUuid << "released by bluetoothd";
+
+    // the registration is gone, new sockets need a new profile
+    registered = false;
+    dropFromRegistry();
+    if (clients.isEmpty())
+        deleteLater();
+}
+
+bool QtBluezClientProfile::registerProfile(QString *errorString)
+{
+    context = new OrgBluezProfile1ContextInterface(this);
+    connect(context, &OrgBluezProfile1ContextInterface::newConnection,
+            this, &QtBluezClientProfile::newConnection);
+    connect(context, &OrgBluezProfile1ContextInterface::released,
+            this, &QtBluezClientProfile::released);
+
+    bool exported = false;
+    for (int i = 0; i < 10 && !exported; i++) {
+        // profile registration might fail in case other service uses same path
+        // try 10 times and otherwise abort
+        path = QString(profilePathTemplate).
+                        arg(sanitizeNameForDBus(QCoreApplication::applicationName())).
+                        arg(QCoreApplication::applicationPid()).
+                        arg(QRandomGenerator::global()->generate());
+
+        exported = QDBusConnection::systemBus().registerObject(
+                        path, context, QDBusConnection::ExportAllSlots);
+    }
+
+    if (!exported) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot export serial client profile on DBus";
+        path.clear();
+        *errorString = QBluetoothSocket::tr("Cannot export profile on DBus");
+        return false;
+    }
+
+    QVariantMap profileOptions;
+    profileOptions.insert(QStringLiteral("Role"), QStringLiteral("client"));
+    profileOptions.insert(QStringLiteral("Service"), serviceUuid);
+    profileOptions.insert(QStringLiteral("Name"),
+                          QStringLiteral("QBluetoothSocket-%1").arg(QCoreApplication::applicationPid()));
+
+    // TODO support more profile parameter
+    // profileOptions.insert(QStringLiteral("Channel"), 0);
+
+    qCDebug(QT_BT_BLUEZ) << "Registering client profile on" << path << "with options:";
+    qCDebug(QT_BT_BLUEZ) << profileOptions;
+    QDBusPendingReply<> reply = profileManager->RegisterProfile(QDBusObjectPath(path),
+                                                                serviceUuid, profileOptions);
+    reply.waitForFinished();
+    if (reply.isError()) {
+        qCWarning(QT_BT_BLUEZ) << "Client profile registration failed:"
+                               << reply.error().message();
+        QDBusConnection::systemBus().unregisterObject(path);
+        path.clear();
+        *errorString = QBluetoothSocket::tr("Cannot register profile on DBus");
+        return false;
+    }
+
+    registered = true;
+    return true;
+}
+
+void QtBluezClientProfile::unregisterProfile()
+{
+    if (path.isEmpty())
+        return;
+
+    if (registered) {
+        QDBusPendingReply<> reply = profileManager->UnregisterProfile(QDBusObjectPath(path));
+        reply.waitForFinished();
+        if (reply.isError())
+            qCWarning(QT_BT_BLUEZ) << "Unregister profile:" << reply.error().message();
+        registered = false;
+    }
+
+    QDBusConnection::systemBus().unregisterObject(path);
+    path.clear();
+}
+
+void QtBluezClientProfile::dropFromRegistry()
+{
+    ProfileRegistry *registry = profileRegistry();
+    QMutexLocker locker(&registry->mutex);
+    const auto key = qMakePair(thread(), serviceUuid);
+    if (registry->profiles.value(key) == this)
+        registry->profiles.remove(key);
+}
+
+QT_END_NAMESPACE
+
+#include "moc_clientprofile_p.cpp"
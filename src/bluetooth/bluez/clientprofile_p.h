@@ -0,0 +1,88 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef CLIENTPROFILE_P_H
+#define CLIENTPROFILE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qtimer.h>
+#include <QtDBus/qdbusextratypes.h>
+#include <QtDBus/qdbusunixfiledescriptor.h>
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+
+class OrgBluezProfile1ContextInterface;
+class OrgBluezProfileManager1Interface;
+
+/*
+ * A client role org.bluez.Profile1 object for one service UUID, shared by all
+ * sockets of a thread which connect to that service. The profile stays
+ * registered with bluetoothd for a while after its last client is gone, so
+ * that sockets opened in quick succession only pay for ConnectProfile.
+ * bluetoothd hands every connection over by NewConnection, which is passed to
+ * the oldest client waiting for the device.
+ */
+class QtBluezClientProfile : public QObject
+{
+    Q_OBJECT
+public:
+    using ConnectionHandler = std::function<void(const QDBusUnixFileDescriptor &)>;
+
+    static QtBluezClientProfile *acquire(const QString &uuid, const void *client,
+                                         QString *errorString);
+    void release(const void *client);
+
+    QString uuid() const { return serviceUuid; }
+
+    void expectConnection(const void *client, const QString &devicePath,
+                          ConnectionHandler handler);
+    void cancelConnection(const void *client);
+
+private slots:
+    void newConnection(const QDBusObjectPath &device, const QDBusUnixFileDescriptor &fd);
+    void released();
+
+private:
+    struct PendingConnection
+    {
+        const void *client;
+        ConnectionHandler handler;
+    };
+
+    explicit QtBluezClientProfile(const QString &uuid);
+    ~QtBluezClientProfile();
+
+    bool registerProfile(QString *errorString);
+    void unregisterProfile();
+    void dropFromRegistry();
+
+    const QString serviceUuid;
+    QString path;
+    bool registered = false;
+    QList<const void *> clients;
+    // clients waiting for NewConnection, by device object path
+    QHash<QString, QList<PendingConnection>> pendingConnections;
+    OrgBluezProfile1ContextInterface *context = nullptr;
+    OrgBluezProfileManager1Interface *profileManager = nullptr;
+    QTimer idleTimer;
+};
+
+QT_END_NAMESPACE
+
+#endif // CLIENTPROFILE_P_H
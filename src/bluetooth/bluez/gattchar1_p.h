@@ -40,6 +40,10 @@ public:
     inline QStringList flags() const
     { return qvariant_cast< QStringList >(property("Flags")); }
 
+    Q_PROPERTY(bool NotifyAcquired READ notifyAcquired)
+    inline bool notifyAcquired() const
+    { return qvariant_cast< bool >(property("NotifyAcquired")); }
+
     Q_PROPERTY(bool Notifying READ notifying)
     inline bool notifying() const
     { return qvariant_cast< bool >(property("Notifying")); }
@@ -56,7 +60,45 @@ public:
     inline QByteArray value() const
     { return qvariant_cast< QByteArray >(property("Value")); }
 
+    Q_PROPERTY(bool WriteAcquired READ writeAcquired)
+    inline bool writeAcquired() const
+    { return qvariant_cast< bool >(property("WriteAcquired")); }
+
 public Q_SLOTS: // METHODS
+    inline QDBusPendingReply<QDBusUnixFileDescriptor, ushort> AcquireNotify(const QVariantMap &options)
+    {
+        QList<QVariant> argumentList;
+        argumentList << QVariant::fromValue(options);
+        return asyncCallWithArgumentList(QStringLiteral("AcquireNotify"), argumentList);
+    }
+    inline QDBusReply<QDBusUnixFileDescriptor> AcquireNotify(const QVariantMap &options, ushort &mtu)
+    {
+        QList<QVariant> argumentList;
+        argumentList << QVariant::fromValue(options);
+        QDBusMessage reply = callWithArgumentList(QDBus::Block, QStringLiteral("AcquireNotify"), argumentList);
+        if (reply.type() == QDBusMessage::ReplyMessage && reply.arguments().count() == 2) {
+            mtu = qdbus_cast<ushort>(reply.arguments().at(1));
+        }
+        return reply;
+    }
+
+    inline QDBusPendingReply<QDBusUnixFileDescriptor, ushort> AcquireWrite(const QVariantMap &options)
+    {
+        QList<QVariant> argumentList;
+        argumentList << QVariant::fromValue(options);
+        return asyncCallWithArgumentList(QStringLiteral("AcquireWrite"), argumentList);
+    }
+    inline QDBusReply<QDBusUnixFileDescriptor> AcquireWrite(const QVariantMap &options, ushort &mtu)
+    {
+        QList<QVariant> argumentList;
+        argumentList << QVariant::fromValue(options);
+        QDBusMessage reply = callWithArgumentList(QDBus::Block, QStringLiteral("AcquireWrite"), argumentList);
+        if (reply.type() == QDBusMessage::ReplyMessage && reply.arguments().count() == 2) {
+            mtu = qdbus_cast<ushort>(reply.arguments().at(1));
+        }
+        return reply;
+    }
+
     inline QDBusPendingReply<QByteArray> ReadValue(const QVariantMap &options)
     {
         QList<QVariant> argumentList;
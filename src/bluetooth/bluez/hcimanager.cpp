@@ -8,6 +8,8 @@
 #include "qlowenergyconnectionparameters.h"
 
 #include <QtCore/qloggingcategory.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qtimer.h>
 
 #include <cstring>
 #include <errno.h>
@@ -21,6 +23,29 @@ QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
 
+// the kernel's HCI_CMD_TIMEOUT, controllers answer well within it
+static constexpr int commandTimeout = 2000;
+
+void HciConnectionSubscriber::hciConnectionUpdated(quint16, const QLowEnergyConnectionParameters &)
+{
+}
+
+void HciConnectionSubscriber::hciDataLengthChanged(quint16, quint16, quint16)
+{
+}
+
+void HciConnectionSubscriber::hciPhyUpdated(quint16, quint8, quint8)
+{
+}
+
+void HciConnectionSubscriber::hciEncryptionChanged(quint16, bool)
+{
+}
+
+void HciConnectionSubscriber::hciSignatureResolvingKeyReceived(quint16, bool, const quint128 &)
+{
+}
+
 HciManager::HciManager(const QBluetoothAddress& deviceAdapter, QObject *parent) :
     QObject(parent), hciSocket(-1), hciDev(-1)
 {
@@ -54,15 +79,75 @@ HciManager::HciManager(const QBluetoothAddress& deviceAdapter, QObject *parent)
     notifier = new QSocketNotifier(hciSocket, QSocketNotifier::Read, this);
     connect(notifier, SIGNAL(activated(QSocketDescriptor)), this, SLOT(_q_readNotify()));
 
+    commandTimer = new QTimer(this);
+    commandTimer->setSingleShot(true);
+    commandTimer->setInterval(commandTimeout);
+    connect(commandTimer, &QTimer::timeout, this, &HciManager::handleCommandTimeout);
 }
 
 HciManager::~HciManager()
 {
+    // nobody waits for the queue anymore, the kernel queues the command itself
+    if (autoConnectInitiating) {
+        writeCommand(opCodePack(QBluezConst::OgfLinkControl,
+                                QBluezConst::OcfLeCreateConnectionCancel), {});
+    }
     if (hciSocket >= 0)
         ::close(hciSocket);
 
 }
 
+QSharedPointer<HciManager> HciManager::forAdapter(const QBluetoothAddress &deviceAdapter)
+{
+    // the socket notifier is bound to the thread which created the manager
+    static thread_local QHash<QBluetoothAddress, QWeakPointer<HciManager>> managers;
+
+    QSharedPointer<HciManager> manager = managers.value(deviceAdapter).toStrongRef();
+    if (manager)
+        return manager;
+
+    // the last user may release the manager while one of its signals is being emitted
+    manager = QSharedPointer<HciManager>(new HciManager(deviceAdapter), &QObject::deleteLater);
+    if (manager->isValid())
+        managers.insert(deviceAdapter, manager);
+    else
+        managers.remove(deviceAdapter);
+    return manager;
+}
+
+void HciManager::subscribe(quint16 handle, HciConnectionSubscriber *subscriber)
+{
+    QList<HciConnectionSubscriber *> &subscribers = connectionSubscribers[handle];
+    if (!subscribers.contains(subscriber))
+        subscribers.append(subscriber);
+}
+
+void HciManager::unsubscribe(HciConnectionSubscriber *subscriber)
+{
+    for (auto it = connectionSubscribers.begin(); it != connectionSubscribers.end();) {
+        it->removeAll(subscriber);
+        if (it->isEmpty())
+            it = connectionSubscribers.erase(it);
+        else
+            ++it;
+    }
+}
+
+template <typename Function>
+void HciManager::dispatchToConnection(quint16 handle, Function function)
+{
+    const auto it = connectionSubscribers.constFind(handle);
+    if (it == connectionSubscribers.cend())
+        return;
+
+    // a subscriber may end its own or other subscriptions while being called
+    const QList<HciConnectionSubscriber *> subscribers = *it;
+    for (HciConnectionSubscriber *subscriber : subscribers) {
+        if (connectionSubscribers.value(handle).contains(subscriber))
+            function(subscriber);
+    }
+}
+
 bool HciManager::isValid() const
 {
     if (hciSocket && hciDev >= 0)
@@ -120,7 +205,6 @@ bool HciManager::monitorEvent(HciManager::HciEvent event)
         return false;
 
     // this event is already enabled
-    // TODO runningEvents does not seem to be used
     if (runningEvents.contains(event))
         return true;
 
@@ -139,6 +223,19 @@ bool HciManager::monitorEvent(HciManager::HciEvent event)
         qCWarning(QT_BT_BLUEZ) << "Could not set HCI socket options:" << strerror(errno);
         return false;
     }
+    runningEvents.insert(event);
+
+    // from now on no connection escapes the events, pick up the existing ones once
+    if (!connectionsTracked && runningEvents.contains(HciEvent::EVT_LE_META_EVENT)
+            && runningEvents.contains(HciEvent::EVT_DISCONN_COMPLETE)) {
+        const QList<hci_conn_info> connections = kernelConnections(&connectionsTracked);
+        for (const hci_conn_info &info : connections) {
+            if (info.type == LE_LINK) {
+                lowEnergyConnections.insert(info.handle,
+                                            QBluetoothAddress(convertAddress(info.bdaddr.b)));
+            }
+        }
+    }
 
     return true;
 }
@@ -163,15 +260,140 @@ bool HciManager::monitorAclPackets()
         return false;
     }
 
+    // The socket also sees the ACL packets sent by the host; let the kernel tell us
+    // the direction of each packet so that the link statistics can be kept apart.
+    const int enable = 1;
+    if (setsockopt(hciSocket, SOL_HCI, HCI_DATA_DIR, &enable, sizeof(enable)) < 0)
+        qCWarning(QT_BT_BLUEZ) << "Could not enable HCI data direction info:" << strerror(errno);
+
     return true;
 }
 
+/*
+ * Queues the command without waiting for its result, see queueCommand().
+ */
 bool HciManager::sendCommand(QBluezConst::OpCodeGroupField ogf, QBluezConst::OpCodeCommandField ocf, const QByteArray &parameters)
 {
-    qCDebug(QT_BT_BLUEZ) << "sending command; ogf:" << ogf << "ocf:" << ocf;
+    return queueCommand(ogf, ocf, parameters);
+}
+
+/*
+ * Queues the command for the controller. At most as many commands are sent
+ * ahead of their Command Complete or Command Status events as the controller
+ * announced in the Num_HCI_Command_Packets of its last such event, so that a
+ * sequence of commands is pipelined instead of being sent one by one.
+ *
+ * The result of the command is passed to \a callback. The command fails with
+ * HCI_UNSPECIFIED_ERROR if it cannot be written and with HCI_HOST_TIMEOUT if
+ * the controller does not answer. Results are matched to the oldest command
+ * in flight with the same opcode. If \a context is given, the callback is not
+ * called once the context is destroyed.
+ *
+ * Returns false if the command was not queued, or if it was written right
+ * away and the write failed.
+ */
+bool HciManager::queueCommand(QBluezConst::OpCodeGroupField ogf,
+                              QBluezConst::OpCodeCommandField ocf, const QByteArray &parameters,
+                              QObject *context, CommandCallback callback)
+{
+    // the credits come with these events, the queue would stall without them
+    if (!monitorEvent(HciEvent::EVT_CMD_COMPLETE) || !monitorEvent(HciEvent::EVT_CMD_STATUS))
+        return false;
+
+    QueuedCommand command{ opCodePack(ogf, ocf), parameters, std::move(callback), context,
+                           context != nullptr };
+    if (!queuedCommands.isEmpty() || commandCredits <= 0) {
+        queuedCommands.append(std::move(command));
+        return true;
+    }
+
+    if (!writeCommand(command.opCode, command.parameters))
+        return false;
+    --commandCredits;
+    commandsInFlight.append(std::move(command));
+    commandTimer->start();
+    return true;
+}
+
+void HciManager::sendQueuedCommands()
+{
+    while (commandCredits > 0 && !queuedCommands.isEmpty()) {
+        QueuedCommand command = queuedCommands.takeFirst();
+        if (!writeCommand(command.opCode, command.parameters)) {
+            CommandResult result;
+            result.opCode = command.opCode;
+            finishCommand(command, result);
+            continue;
+        }
+        --commandCredits;
+        commandsInFlight.append(std::move(command));
+        commandTimer->start();
+    }
+}
+
+/*
+ * Takes the credits of a Command Complete or Command Status event and passes
+ * the result to the command it belongs to, if it is one of the queued ones.
+ */
+void HciManager::handleCommandResult(CommandResult &&result, quint8 credits)
+{
+    // the count includes the commands of other hosts of the adapter
+    commandCredits = credits;
+
+    qsizetype index = -1;
+    for (qsizetype i = 0; i < commandsInFlight.size(); ++i) {
+        if (commandsInFlight.at(i).opCode == result.opCode) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        sendQueuedCommands();
+        return;
+    }
+
+    QueuedCommand command = commandsInFlight.takeAt(index);
+    if (commandsInFlight.isEmpty())
+        commandTimer->stop();
+    else
+        commandTimer->start();
+
+    // the queued commands go before those the callback may queue
+    sendQueuedCommands();
+    finishCommand(command, result);
+}
+
+void HciManager::handleCommandTimeout()
+{
+    qCWarning(QT_BT_BLUEZ) << "No result for" << commandsInFlight.size()
+                           << "HCI commands, assuming they were lost";
+
+    QList<QueuedCommand> lostCommands;
+    lostCommands.swap(commandsInFlight);
+    commandCredits = 1;
+    sendQueuedCommands();
+
+    for (QueuedCommand &command : lostCommands) {
+        CommandResult result;
+        result.opCode = command.opCode;
+        result.status = quint8(HciError::HCI_HOST_TIMEOUT);
+        finishCommand(command, result);
+    }
+}
+
+void HciManager::finishCommand(QueuedCommand &command, const CommandResult &result)
+{
+    if (command.callback && (!command.hasContext || command.context))
+        command.callback(result);
+}
+
+bool HciManager::writeCommand(quint16 opCode, const QByteArray &parameters)
+{
+    qCDebug(QT_BT_BLUEZ) << "sending command; ogf:" << ogfFromOpCode(opCode)
+                         << "ocf:" << ocfFromOpCode(opCode);
     quint8 packetType = HCI_COMMAND_PKT;
     hci_command_hdr command = {
-        opCodePack(ogf, ocf),
+        opCode,
         static_cast<uint8_t>(parameters.size())
     };
     static_assert(sizeof command == 3, "unexpected struct size");
@@ -213,78 +435,93 @@ void HciManager::stopEvents()
     }
 
     runningEvents.clear();
+    lowEnergyConnections.clear();
+    connectionsTracked = false;
 }
 
-QBluetoothAddress HciManager::addressForConnectionHandle(quint16 handle) const
+/*
+ * Returns the connections of the adapter as known to the kernel, \a ok is set
+ * to false if they cannot be retrieved.
+ */
+QList<hci_conn_info> HciManager::kernelConnections(bool *ok) const
 {
+    if (ok)
+        *ok = false;
     if (!isValid())
-        return QBluetoothAddress();
-
-    hci_conn_info *info;
-    hci_conn_list_req *infoList;
+        return QList<hci_conn_info>();
 
     const int maxNoOfConnections = 20;
-    infoList = (hci_conn_list_req *)
+    hci_conn_list_req *infoList = (hci_conn_list_req *)
             malloc(sizeof(hci_conn_list_req) + maxNoOfConnections * sizeof(hci_conn_info));
 
     if (!infoList)
-        return QBluetoothAddress();
+        return QList<hci_conn_info>();
 
     QScopedPointer<hci_conn_list_req, QScopedPointerPodDeleter> p(infoList);
     p->conn_num = maxNoOfConnections;
     p->dev_id = hciDev;
-    info = p->conn_info;
 
     if (ioctl(hciSocket, HCIGETCONNLIST, (void *) infoList) < 0) {
         qCWarning(QT_BT_BLUEZ) << "Cannot retrieve connection list";
-        return QBluetoothAddress();
+        return QList<hci_conn_info>();
     }
 
-    for (int i = 0; i < infoList->conn_num; i++) {
-        if (info[i].handle == handle)
-            return QBluetoothAddress(convertAddress(info[i].bdaddr.b));
+    if (ok)
+        *ok = true;
+    return QList<hci_conn_info>(p->conn_info, p->conn_info + p->conn_num);
+}
+
+/*
+ * LE connections are tracked from the connection and disconnection events
+ * once both are monitored, other links are looked up in the kernel.
+ */
+QBluetoothAddress HciManager::addressForConnectionHandle(quint16 handle) const
+{
+    const auto it = lowEnergyConnections.constFind(handle);
+    if (it != lowEnergyConnections.cend())
+        return *it;
+
+    const QList<hci_conn_info> connections = kernelConnections();
+    for (const hci_conn_info &info : connections) {
+        if (info.handle == handle)
+            return QBluetoothAddress(convertAddress(info.bdaddr.b));
     }
 
     return QBluetoothAddress();
 }
 
-QList<quint16> HciManager::activeLowEnergyConnections() const
+/*
+ * Fills \a counters with the traffic seen on the connection with \a handle
+ * since it was established. Returns false if nothing is known about the connection.
+ * Traffic is only counted while ACL packets are monitored.
+ */
+bool HciManager::linkCounters(quint16 handle, LinkCounters *counters) const
 {
-    if (!isValid())
-        return QList<quint16>();
-
-    hci_conn_info *info;
-    hci_conn_list_req *infoList;
-
-    const int maxNoOfConnections = 20;
-    infoList = (hci_conn_list_req *)
-            malloc(sizeof(hci_conn_list_req) + maxNoOfConnections * sizeof(hci_conn_info));
-
-    if (!infoList)
-        return QList<quint16>();
-
-    QScopedPointer<hci_conn_list_req, QScopedPointerPodDeleter> p(infoList);
-    p->conn_num = maxNoOfConnections;
-    p->dev_id = hciDev;
-    info = p->conn_info;
+    const auto it = linkStatistics.constFind(handle);
+    if (it == linkStatistics.cend())
+        return false;
+    *counters = *it;
+    return true;
+}
 
-    if (ioctl(hciSocket, HCIGETCONNLIST, (void *) infoList) < 0) {
-        qCWarning(QT_BT_BLUEZ) << "Cannot retrieve connection list";
-        return QList<quint16>();
-    }
+QList<quint16> HciManager::activeLowEnergyConnections() const
+{
+    if (connectionsTracked)
+        return lowEnergyConnections.keys();
 
     QList<quint16> activeLowEnergyHandles;
-    for (int i = 0; i < infoList->conn_num; i++) {
-        switch (info[i].type) {
+    const QList<hci_conn_info> connections = kernelConnections();
+    for (const hci_conn_info &info : connections) {
+        switch (info.type) {
         case SCO_LINK:
         case ACL_LINK:
         case ESCO_LINK:
             continue;
         case LE_LINK:
-            activeLowEnergyHandles.append(info[i].handle);
+            activeLowEnergyHandles.append(info.handle);
             break;
         default:
-            qCWarning(QT_BT_BLUEZ) << "Unknown active connection type:" << Qt::hex << info[i].type;
+            qCWarning(QT_BT_BLUEZ) << "Unknown active connection type:" << Qt::hex << info.type;
             break;
         }
     }
@@ -336,6 +573,169 @@ bool HciManager::sendConnectionUpdateCommand(quint16 handle,
     return sendCommand(QBluezConst::OgfLinkControl, QBluezConst::OcfLeConnectionUpdate, data);
 }
 
+bool HciManager::sendSetDataLengthCommand(quint16 handle, quint16 txOctets)
+{
+    // Spec v5.3, Vol 4, part E, 7.8.33
+    struct CommandParams {
+        quint16 handle;
+        quint16 txOctets;
+        quint16 txTime;
+    } __attribute((packed)) commandParams;
+    txOctets = qBound<quint16>(0x1b, txOctets, 0xfb);
+    commandParams.handle = qToLittleEndian(handle);
+    commandParams.txOctets = qToLittleEndian(txOctets);
+    // Let the octet count be the only limit, regardless of the PHY in use
+    commandParams.txTime = qToLittleEndian(quint16(0x4290));
+    const QByteArray data = QByteArray::fromRawData(reinterpret_cast<char *>(&commandParams),
+                                                    sizeof commandParams);
+    return sendCommand(QBluezConst::OgfLinkControl, QBluezConst::OcfLeSetDataLength, data);
+}
+
+/*
+ * \a txPhys and \a rxPhys are bit masks of preferred PHYs as defined
+ * in Spec v5.3, Vol 4, part E, 7.8.49 (bit 0: LE 1M, bit 1: LE 2M, bit 2: LE Coded).
+ */
+bool HciManager::sendSetPhyCommand(quint16 handle, quint8 txPhys, quint8 rxPhys)
+{
+    struct CommandParams {
+        quint16 handle;
+        quint8 allPhys;
+        quint8 txPhys;
+        quint8 rxPhys;
+        quint16 phyOptions;
+    } __attribute((packed)) commandParams;
+    commandParams.handle = qToLittleEndian(handle);
+    commandParams.allPhys = 0;
+    commandParams.txPhys = txPhys;
+    commandParams.rxPhys = rxPhys;
+    commandParams.phyOptions = 0;
+    const QByteArray data = QByteArray::fromRawData(reinterpret_cast<char *>(&commandParams),
+                                                    sizeof commandParams);
+    return sendCommand(QBluezConst::OgfLinkControl, QBluezConst::OcfLeSetPhy, data);
+}
+
+/*
+ * Adds \a address to the devices the adapter connects to in the background.
+ * The accept list of the adapter is reprogrammed with all of them and the
+ * initiator waits for the first advertisement of any of them, without a
+ * timeout. A device leaves the set once its connection completed. Returns
+ * false if the adapter cannot be programmed.
+ */
+bool HciManager::addAutoConnectDevice(const QBluetoothAddress &address, bool randomAddress)
+{
+    if (!monitorEvent(HciEvent::EVT_CMD_COMPLETE) || !monitorEvent(HciEvent::EVT_CMD_STATUS)
+            || !monitorEvent(HciEvent::EVT_LE_META_EVENT)) {
+        return false;
+    }
+
+    const quint8 addressType = randomAddress ? 1 : 0;
+    const auto it = autoConnectDevices.constFind(address);
+    if (it != autoConnectDevices.cend() && *it == addressType)
+        return true;
+
+    autoConnectDevices.insert(address, addressType);
+    if (!updateAutoConnect()) {
+        autoConnectDevices.remove(address);
+        return false;
+    }
+    return true;
+}
+
+void HciManager::removeAutoConnectDevice(const QBluetoothAddress &address)
+{
+    if (autoConnectDevices.remove(address))
+        updateAutoConnect();
+}
+
+bool HciManager::updateAutoConnect()
+{
+    // Spec v5.3, Vol 4, Part E, 7.8.16, the accept list is locked while the initiator uses it
+    if (autoConnectInitiating) {
+        if (!queueCommand(QBluezConst::OgfLinkControl, QBluezConst::OcfLeCreateConnectionCancel,
+                          QByteArray())) {
+            return false;
+        }
+        autoConnectInitiating = false;
+        autoConnectCancelling = true;
+    }
+    if (autoConnectDevices.isEmpty())
+        return true;
+
+    // the commands are executed one after the other, the cancellation is done before
+    const auto handleResult = [this](const CommandResult &result) {
+        handleAutoConnectCommandResult(result);
+    };
+    if (!queueCommand(QBluezConst::OgfLinkControl, QBluezConst::OcfLeClearWhiteList, QByteArray(),
+                      this, handleResult)) {
+        return false;
+    }
+    for (auto it = autoConnectDevices.cbegin(); it != autoConnectDevices.cend(); ++it) {
+        struct {
+            quint8 addrType;
+            bdaddr_t addr;
+        } __attribute((packed)) whiteListParams;
+        static_assert(sizeof whiteListParams == 7, "unexpected struct size");
+        whiteListParams.addrType = it.value();
+        convertAddress(it.key().toUInt64(), whiteListParams.addr.b);
+        const QByteArray data = QByteArray::fromRawData(
+                reinterpret_cast<char *>(&whiteListParams), sizeof whiteListParams);
+        if (!queueCommand(QBluezConst::OgfLinkControl, QBluezConst::OcfLeAddToWhiteList, data,
+                          this, handleResult)) {
+            return false;
+        }
+    }
+
+    // Spec v5.3, Vol 4, Part E, 7.8.12, the peer address is taken from the accept list
+    struct {
+        quint16 scanInterval;
+        quint16 scanWindow;
+        quint8 initiatorFilterPolicy;
+        quint8 peerAddrType;
+        bdaddr_t peerAddr;
+        quint8 ownAddrType;
+        quint16 minInterval;
+        quint16 maxInterval;
+        quint16 latency;
+        quint16 supervisionTimeout;
+        quint16 minCeLength;
+        quint16 maxCeLength;
+    } __attribute((packed)) commandParams;
+    static_assert(sizeof commandParams == 25, "unexpected struct size");
+    memset(&commandParams, 0, sizeof commandParams);
+    // the defaults of the kernel for background connections
+    commandParams.scanInterval = qToLittleEndian(quint16(0x0060)); // 60 ms
+    commandParams.scanWindow = qToLittleEndian(quint16(0x0030)); // 30 ms
+    commandParams.initiatorFilterPolicy = 1;
+    commandParams.minInterval = qToLittleEndian(quint16(0x0018)); // 30 ms
+    commandParams.maxInterval = qToLittleEndian(quint16(0x0028)); // 50 ms
+    commandParams.supervisionTimeout = qToLittleEndian(quint16(0x002a)); // 420 ms
+    const QByteArray data = QByteArray::fromRawData(reinterpret_cast<char *>(&commandParams),
+                                                    sizeof commandParams);
+    if (!queueCommand(QBluezConst::OgfLinkControl, QBluezConst::OcfLeCreateConnection, data, this,
+                      handleResult)) {
+        return false;
+    }
+    autoConnectInitiating = true;
+    return true;
+}
+
+void HciManager::handleAutoConnectCommandResult(const CommandResult &result)
+{
+    if (result.isSuccess() || autoConnectDevices.isEmpty())
+        return;
+
+    const quint16 ocf = ocfFromOpCode(result.opCode);
+
+    // a full accept list or an adapter which is busy initiating a connection itself
+    qCWarning(QT_BT_BLUEZ) << "Background connection attempt rejected by the adapter, status:"
+                           << result.error();
+    autoConnectDevices.clear();
+    if (autoConnectInitiating && ocf != QBluezConst::OcfLeCreateConnection)
+        sendCommand(QBluezConst::OgfLinkControl, QBluezConst::OcfLeCreateConnectionCancel, {});
+    autoConnectInitiating = false;
+    emit autoConnectFailed();
+}
+
 bool HciManager::sendConnectionParameterUpdateRequest(quint16 handle,
                                                       const QLowEnergyConnectionParameters &params)
 {
@@ -391,25 +791,76 @@ bool HciManager::sendConnectionParameterUpdateRequest(quint16 handle,
  */
 void HciManager::_q_readNotify()
 {
-    unsigned char buffer[qMax<int>(HCI_MAX_EVENT_SIZE, sizeof(AclData))];
+    // Drain all packets queued on the socket, several of them per system call,
+    // so that a busy adapter does not cost one event loop iteration per packet.
+    // The number of batches is bounded so that a flood of ACL packets cannot
+    // starve the rest of the event loop; the notifier fires again for the remainder.
+    constexpr int batchSize = 16;
+    constexpr int maxBatches = 8;
+    unsigned char buffers[batchSize][qMax<int>(HCI_MAX_EVENT_SIZE, sizeof(AclData))];
+    alignas(cmsghdr) char controlBuffers[batchSize][CMSG_SPACE(sizeof(int))];
+    iovec iv[batchSize];
+    mmsghdr messages[batchSize];
+    memset(messages, 0, sizeof(messages));
+    for (int i = 0; i < batchSize; ++i) {
+        iv[i].iov_base = buffers[i];
+        iv[i].iov_len = sizeof(buffers[i]);
+        messages[i].msg_hdr.msg_iov = &iv[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_control = controlBuffers[i];
+    }
 
-    const auto size = ::read(hciSocket, buffer, sizeof(buffer));
-    if (size < 0) {
-        if (errno != EAGAIN && errno != EINTR)
-            qCWarning(QT_BT_BLUEZ) << "Failed reading HCI events:" << qt_error_string(errno);
+    // a handler may delete us while we are still dispatching the batch
+    const QPointer<HciManager> guard(this);
+    for (int batch = 0; batch < maxBatches; ++batch) {
+        // the kernel shrinks msg_controllen to what it actually wrote
+        for (int i = 0; i < batchSize; ++i)
+            messages[i].msg_hdr.msg_controllen = sizeof(controlBuffers[i]);
+
+        const int count = ::recvmmsg(hciSocket, messages, batchSize, MSG_DONTWAIT, nullptr);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                qCWarning(QT_BT_BLUEZ) << "Failed reading HCI events:" << qt_error_string(errno);
+
+            return;
+        }
 
-        return;
+        for (int i = 0; i < count; ++i) {
+            bool incoming = true;
+            msghdr &header = messages[i].msg_hdr;
+            for (cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+                if (cmsg->cmsg_level == SOL_HCI && cmsg->cmsg_type == HCI_CMSG_DIR) {
+                    int direction;
+                    memcpy(&direction, CMSG_DATA(cmsg), sizeof(direction));
+                    incoming = direction != 0;
+                }
+            }
+            handleHciPacket(buffers[i], int(messages[i].msg_len), incoming);
+            if (!guard)
+                return;
+        }
+
+        if (count < batchSize)
+            return;
     }
+}
 
-    switch (buffer[0]) {
+void HciManager::handleHciPacket(const quint8 *data, int size, bool incoming)
+{
+    if (size < 1)
+        return;
+
+    switch (data[0]) {
     case HCI_EVENT_PKT:
-        handleHciEventPacket(buffer + 1, size - 1);
+        handleHciEventPacket(data + 1, size - 1);
         break;
     case HCI_ACL_PKT:
-        handleHciAclPacket(buffer + 1, size - 1);
+        handleHciAclPacket(data + 1, size - 1, incoming);
         break;
     default:
-        qCWarning(QT_BT_BLUEZ) << "Ignoring unexpected HCI packet type" << buffer[0];
+        qCWarning(QT_BT_BLUEZ) << "Ignoring unexpected HCI packet type" << data[0];
     }
 }
 
@@ -441,23 +892,57 @@ void HciManager::handleHciEventPacket(const quint8 *data, int size)
                              << "handle:" << Qt::hex << event->handle
                              << "encrypt:" << event->encrypt;
 
-        QBluetoothAddress remoteDevice = addressForConnectionHandle(event->handle);
-        if (!remoteDevice.isNull())
-            emit encryptionChangedEvent(remoteDevice, event->status == 0);
+        const quint16 handle = qFromLittleEndian(event->handle);
+        const bool wasSuccess = event->status == 0;
+        dispatchToConnection(handle, [handle, wasSuccess](HciConnectionSubscriber *subscriber) {
+            subscriber->hciEncryptionChanged(handle, wasSuccess);
+        });
     } break;
     case HciEvent::EVT_CMD_COMPLETE: {
         auto * const event = reinterpret_cast<const evt_cmd_complete *>(data);
         static_assert(sizeof *event == 3, "unexpected struct size");
+        if (size < static_cast<int>(sizeof *event))
+            break;
 
-        // There is always a status byte right after the generic structure.
-        Q_ASSERT(size > static_cast<int>(sizeof *event));
-        const quint8 status = data[sizeof *event];
-        const auto additionalData = QByteArray(reinterpret_cast<const char *>(data)
-                                               + sizeof *event + 1, size - sizeof *event - 1);
-        emit commandCompleted(event->opcode, status, additionalData);
+        CommandResult result;
+        result.opCode = qFromLittleEndian(event->opcode);
+        // Only the NOP opcode, which just hands out credits, has no status byte
+        if (size == static_cast<int>(sizeof *event)) {
+            handleCommandResult(std::move(result), event->ncmd);
+            break;
+        }
+        result.status = data[sizeof *event];
+        result.returnParameters = QByteArray(reinterpret_cast<const char *>(data)
+                                             + sizeof *event + 1, size - sizeof *event - 1);
+        emit commandCompleted(result.opCode, result.status, result.returnParameters);
+        handleCommandResult(std::move(result), event->ncmd);
+    } break;
+    case HciEvent::EVT_CMD_STATUS: {
+        if (size < static_cast<int>(sizeof(evt_cmd_status)))
+            break;
+        auto * const event = reinterpret_cast<const evt_cmd_status *>(data);
+        CommandResult result;
+        result.opCode = qFromLittleEndian(event->opcode);
+        result.status = event->status;
+        result.isCommandStatus = true;
+        emit commandStatusReceived(result.opCode, result.status);
+        handleCommandResult(std::move(result), event->ncmd);
     } break;
     case HciEvent::EVT_LE_META_EVENT:
-        handleLeMetaEvent(data);
+        handleLeMetaEvent(data, size);
+        break;
+    case HciEvent::EVT_NUM_COMP_PKTS:
+        handleNumberOfCompletedPackets(data, size);
+        break;
+    case HciEvent::EVT_DISCONN_COMPLETE:
+        if (size >= 3) {
+            linkStatistics.remove(bt_get_le16(data + 1));
+            if (data[0] == 0) {
+                lowEnergyConnections.remove(bt_get_le16(data + 1));
+                // the handle may be assigned to the next connection
+                connectionSubscribers.remove(bt_get_le16(data + 1));
+            }
+        }
         break;
     default:
         break;
@@ -465,7 +950,21 @@ void HciManager::handleHciEventPacket(const quint8 *data, int size)
 
 }
 
-void HciManager::handleHciAclPacket(const quint8 *data, int size)
+void HciManager::handleNumberOfCompletedPackets(const quint8 *data, int size)
+{
+    // Spec v5.3, Vol 4, part E, 7.7.19
+    if (size < 1)
+        return;
+    const int handleCount = qMin<int>(data[0], (size - 1) / 4);
+    for (int i = 0; i < handleCount; ++i) {
+        const quint16 handle = bt_get_le16(data + 1 + i * 4) & 0x0fff;
+        const auto it = linkStatistics.find(handle);
+        if (it != linkStatistics.end())
+            it->completedPackets += bt_get_le16(data + 3 + i * 4);
+    }
+}
+
+void HciManager::handleHciAclPacket(const quint8 *data, int size, bool incoming)
 {
     if (size < int(sizeof(AclData))) {
         qCWarning(QT_BT_BLUEZ) << "Unexpected HCI ACL packet size";
@@ -479,6 +978,17 @@ void HciManager::handleHciAclPacket(const quint8 *data, int size)
     data += sizeof *aclData;
     size -= sizeof *aclData;
 
+    const auto it = linkStatistics.find(aclData->handle);
+    if (it != linkStatistics.end()) {
+        if (incoming) {
+            it->bytesReceived += aclData->dataLen;
+            ++it->packetsReceived;
+        } else {
+            it->bytesSent += aclData->dataLen;
+            ++it->packetsSent;
+        }
+    }
+
     // Consider only directed, complete messages.
     if ((aclData->pbFlag != 0 && aclData->pbFlag != 2) || aclData->bcFlag != 0)
         return;
@@ -519,10 +1029,20 @@ void HciManager::handleHciAclPacket(const quint8 *data, int size)
     quint128 csrk;
     memcpy(&csrk, data + 1, sizeof csrk);
     const bool isRemoteKey = aclData->pbFlag == 2;
-    emit signatureResolvingKeyReceived(aclData->handle, isRemoteKey, csrk);
+    const quint16 handle = aclData->handle;
+    dispatchToConnection(handle, [handle, isRemoteKey, &csrk](HciConnectionSubscriber *subscriber) {
+        subscriber->hciSignatureResolvingKeyReceived(handle, isRemoteKey, csrk);
+    });
 }
 
-void HciManager::handleLeMetaEvent(const quint8 *data)
+static QBluetoothAddress addressFromHci(const quint8 *data)
+{
+    bdaddr_t address;
+    memcpy(address.b, data, sizeof address.b);
+    return QBluetoothAddress(convertAddress(address.b));
+}
+
+void HciManager::handleLeMetaEvent(const quint8 *data, int size)
 {
     // Spec v5.3, Vol 4, part E, 7.7.65.*
     switch (*data) {
@@ -530,7 +1050,29 @@ void HciManager::handleLeMetaEvent(const quint8 *data)
     case 0xA: // HCI_LE_Enhanced_Connection_Complete
     {
         const quint16 handle = bt_get_le16(data + 2);
-        emit connectionComplete(handle);
+        QBluetoothAddress address;
+        if (data[1] == 0) {
+            // the enhanced event carries two additional resolvable private addresses
+            const int intervalOffset = *data == 0x1 ? 12 : 24;
+            LinkCounters counters;
+            counters.connectionInterval = bt_get_le16(data + intervalOffset);
+            counters.peripheralLatency = bt_get_le16(data + intervalOffset + 2);
+            counters.supervisionTimeout = bt_get_le16(data + intervalOffset + 4);
+            linkStatistics.insert(handle, counters);
+            address = addressFromHci(data + 6);
+            if (connectionsTracked)
+                lowEnergyConnections.insert(handle, address);
+        } else if (data[1] == quint8(HciError::HCI_NO_CONNECTION) && autoConnectCancelling) {
+            // the end of the background initiator which updateAutoConnect() cancelled
+            autoConnectCancelling = false;
+            break;
+        }
+        if (autoConnectInitiating && (data[1] != 0 || autoConnectDevices.remove(address))) {
+            // the initiator stopped, the other devices are still awaited
+            autoConnectInitiating = false;
+            updateAutoConnect();
+        }
+        emit connectionComplete(handle, address);
         break;
     }
     case 0x3: {
@@ -545,20 +1087,100 @@ void HciManager::handleLeMetaEvent(const quint8 *data)
         const auto * const updateData
                 = reinterpret_cast<const ConnectionUpdateData *>(data + 1);
         if (updateData->status == 0) {
+            const auto it = linkStatistics.find(qFromLittleEndian(updateData->handle));
+            if (it != linkStatistics.end()) {
+                it->connectionInterval = qFromLittleEndian(updateData->interval);
+                it->peripheralLatency = qFromLittleEndian(updateData->latency);
+                it->supervisionTimeout = qFromLittleEndian(updateData->timeout);
+            }
             QLowEnergyConnectionParameters params;
             const double interval = qFromLittleEndian(updateData->interval) * 1.25;
             params.setIntervalRange(interval, interval);
             params.setLatency(qFromLittleEndian(updateData->latency));
             params.setSupervisionTimeout(qFromLittleEndian(updateData->timeout) * 10);
-            emit connectionUpdate(qFromLittleEndian(updateData->handle), params);
+            const quint16 handle = qFromLittleEndian(updateData->handle);
+            dispatchToConnection(handle, [handle, &params](HciConnectionSubscriber *subscriber) {
+                subscriber->hciConnectionUpdated(handle, params);
+            });
+        }
+        break;
+    }
+    case 0x7: { // HCI_LE_Data_Length_Change
+        const quint16 handle = bt_get_le16(data + 1);
+        const quint16 maxTxOctets = bt_get_le16(data + 3);
+        const quint16 maxRxOctets = bt_get_le16(data + 7);
+        dispatchToConnection(handle, [=](HciConnectionSubscriber *subscriber) {
+            subscriber->hciDataLengthChanged(handle, maxTxOctets, maxRxOctets);
+        });
+        break;
+    }
+    case 0xC: { // HCI_LE_PHY_Update_Complete
+        const quint8 status = data[1];
+        if (status == 0) {
+            const quint16 handle = bt_get_le16(data + 2);
+            dispatchToConnection(handle, [handle, data](HciConnectionSubscriber *subscriber) {
+                subscriber->hciPhyUpdated(handle, data[4], data[5]);
+            });
         }
         break;
     }
+    case 0xD: // HCI_LE_Extended_Advertising_Report
+        handleExtendedAdvertisingReports(data + 1, size - 1);
+        break;
+    case 0xE: { // HCI_LE_Periodic_Advertising_Sync_Established
+        if (size < 16)
+            break;
+        const quint16 syncHandle = bt_get_le16(data + 2);
+        const QBluetoothAddress address = addressFromHci(data + 6);
+        emit periodicAdvertisingSyncEstablished(data[1], syncHandle, address, data[4]);
+        break;
+    }
+    case 0xF: { // HCI_LE_Periodic_Advertising_Report
+        if (size < 8 || size < 8 + data[7])
+            break;
+        const quint16 syncHandle = bt_get_le16(data + 1);
+        const QByteArray reportData(reinterpret_cast<const char *>(data) + 8, data[7]);
+        emit periodicAdvertisingReport(syncHandle, data[6], reportData);
+        break;
+    }
+    case 0x10: // HCI_LE_Periodic_Advertising_Sync_Lost
+        if (size >= 3)
+            emit periodicAdvertisingSyncLost(bt_get_le16(data + 1));
+        break;
     default:
         break;
     }
 }
 
+/*!
+    \internal
+
+    Picks the advertisers which also advertise periodically out of the
+    extended advertising reports in \a data, the Advertising Set ID they
+    report is needed to synchronize to them.
+ */
+void HciManager::handleExtendedAdvertisingReports(const quint8 *data, int size)
+{
+    // Spec v5.3, Vol 4, part E, 7.7.65.13
+    if (size < 1)
+        return;
+    const int reportCount = data[0];
+    int offset = 1;
+    for (int i = 0; i < reportCount; ++i) {
+        constexpr int headerSize = 24;
+        if (size - offset < headerSize || size - offset < headerSize + data[offset + 23])
+            return;
+        const quint8 *report = data + offset;
+        offset += headerSize + report[23];
+
+        const quint16 periodicInterval = bt_get_le16(report + 14);
+        if (periodicInterval == 0)
+            continue;
+        const QBluetoothAddress address = addressFromHci(report + 3);
+        emit periodicAdvertiserFound(address, report[2], report[11], periodicInterval);
+    }
+}
+
 QT_END_NAMESPACE
 
 #include "moc_hcimanager_p.cpp"
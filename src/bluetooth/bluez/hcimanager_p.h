@@ -15,16 +15,38 @@
 // We mean it.
 //
 
+#include <QtCore/QHash>
 #include <QtCore/QObject>
 #include <QtCore/QList>
+#include <QtCore/QPointer>
 #include <QtCore/QSet>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QSocketNotifier>
 #include <QtBluetooth/QBluetoothAddress>
 #include "bluez/bluez_data_p.h"
 
+#include <functional>
+
 QT_BEGIN_NAMESPACE
 
 class QLowEnergyConnectionParameters;
+class QTimer;
+
+// Receives the events of the connections it subscribed to, see HciManager::subscribe()
+class HciConnectionSubscriber
+{
+public:
+    virtual void hciConnectionUpdated(quint16 handle,
+                                      const QLowEnergyConnectionParameters &parameters);
+    virtual void hciDataLengthChanged(quint16 handle, quint16 maxTxOctets, quint16 maxRxOctets);
+    virtual void hciPhyUpdated(quint16 handle, quint8 txPhy, quint8 rxPhy);
+    virtual void hciEncryptionChanged(quint16 handle, bool wasSuccess);
+    virtual void hciSignatureResolvingKeyReceived(quint16 handle, bool remoteKey,
+                                                  const quint128 &csrk);
+
+protected:
+    ~HciConnectionSubscriber() = default;
+};
 
 class HciManager : public QObject
 {
@@ -98,6 +120,17 @@ public:
     };
     Q_ENUM(HciEvent);
 
+    struct LinkCounters {
+        quint64 bytesSent = 0;
+        quint64 bytesReceived = 0;
+        quint64 packetsSent = 0;
+        quint64 packetsReceived = 0;
+        quint64 completedPackets = 0;
+        quint16 connectionInterval = 0; // in units of 1.25 ms
+        quint16 peripheralLatency = 0; // in connection events
+        quint16 supervisionTimeout = 0; // in units of 10 ms
+    };
+
     enum class HciError {
         HCI_SUCCESS                         = 0x00, // added for convenience, not in bluez code
         HCI_UNKNOWN_COMMAND                 = 0x01,
@@ -156,45 +189,128 @@ public:
     };
     Q_ENUM(HciError);
 
+    // The outcome of a queued command, from its Command Complete or Command Status event
+    struct CommandResult {
+        quint16 opCode = 0;
+        quint8 status = quint8(HciError::HCI_UNSPECIFIED_ERROR);
+        // the return parameters after the status, empty for Command Status
+        QByteArray returnParameters;
+        bool isCommandStatus = false;
+
+        bool isSuccess() const { return status == 0; }
+        HciError error() const { return static_cast<HciError>(status); }
+    };
+    using CommandCallback = std::function<void(const CommandResult &)>;
+
     explicit HciManager(const QBluetoothAddress &deviceAdapter, QObject *parent = nullptr);
     ~HciManager();
 
+    // One manager per adapter and thread, shared by all its users. Every raw
+    // HCI socket receives all events of the adapter, a socket per user only
+    // multiplies the work.
+    static QSharedPointer<HciManager> forAdapter(const QBluetoothAddress &deviceAdapter);
+
     bool isValid() const;
     bool monitorEvent(HciManager::HciEvent event);
     bool monitorAclPackets();
     bool sendCommand(QBluezConst::OpCodeGroupField ogf, QBluezConst::OpCodeCommandField ocf, const QByteArray &parameters);
+    // Sends the commands in order, without exceeding the Num_HCI_Command_Packets
+    // the controller allows. The callback, if any, receives the result unless
+    // context was destroyed in the meantime.
+    bool queueCommand(QBluezConst::OpCodeGroupField ogf, QBluezConst::OpCodeCommandField ocf,
+                      const QByteArray &parameters, QObject *context = nullptr,
+                      CommandCallback callback = CommandCallback());
 
     void stopEvents();
     QBluetoothAddress addressForConnectionHandle(quint16 handle) const;
 
     // active connections
     QList<quint16> activeLowEnergyConnections() const;
+    bool linkCounters(quint16 handle, LinkCounters *counters) const;
 
     bool sendConnectionUpdateCommand(quint16 handle, const QLowEnergyConnectionParameters &params);
     bool sendConnectionParameterUpdateRequest(quint16 handle,
                                               const QLowEnergyConnectionParameters &params);
+    bool sendSetDataLengthCommand(quint16 handle, quint16 txOctets);
+    bool sendSetPhyCommand(quint16 handle, quint8 txPhys, quint8 rxPhys);
+
+    // Background connections, the adapter connects to the first of the devices
+    // in its accept list which advertises. The device is removed once connected.
+    bool addAutoConnectDevice(const QBluetoothAddress &address, bool randomAddress);
+    void removeAutoConnectDevice(const QBluetoothAddress &address);
+
+    // Connection specific events go to the subscribers of the connection handle
+    // only, rather than to every user of the adapter. Subscriptions end with the
+    // disconnection of the handle.
+    void subscribe(quint16 handle, HciConnectionSubscriber *subscriber);
+    void unsubscribe(HciConnectionSubscriber *subscriber);
 
 signals:
-    void encryptionChangedEvent(const QBluetoothAddress &address, bool wasSuccess);
     void commandCompleted(quint16 opCode, quint8 status, const QByteArray &data);
-    void connectionComplete(quint16 handle);
-    void connectionUpdate(quint16 handle, const QLowEnergyConnectionParameters &parameters);
-    void signatureResolvingKeyReceived(quint16 connHandle, bool remoteKey, const quint128 &csrk);
+    void commandStatusReceived(quint16 opCode, quint8 status);
+    // the peer address is null if the connection failed
+    void connectionComplete(quint16 handle, const QBluetoothAddress &address);
+    // only for extended advertising reports of advertisers which also advertise periodically
+    void periodicAdvertiserFound(const QBluetoothAddress &address, quint8 addressType, quint8 sid,
+                                 quint16 interval);
+    void periodicAdvertisingSyncEstablished(quint8 status, quint16 syncHandle,
+                                            const QBluetoothAddress &address, quint8 sid);
+    void periodicAdvertisingReport(quint16 syncHandle, quint8 dataStatus, const QByteArray &data);
+    void periodicAdvertisingSyncLost(quint16 syncHandle);
+    // the adapter rejected the background connections, all devices were removed
+    void autoConnectFailed();
 
 private slots:
     void _q_readNotify();
 
 private:
+    struct QueuedCommand {
+        quint16 opCode;
+        QByteArray parameters;
+        CommandCallback callback;
+        QPointer<QObject> context;
+        bool hasContext;
+    };
+
     int hciForAddress(const QBluetoothAddress &deviceAdapter);
+    bool writeCommand(quint16 opCode, const QByteArray &parameters);
+    void sendQueuedCommands();
+    void handleCommandResult(CommandResult &&result, quint8 credits);
+    void handleCommandTimeout();
+    static void finishCommand(QueuedCommand &command, const CommandResult &result);
+    QList<hci_conn_info> kernelConnections(bool *ok = nullptr) const;
+    void handleHciPacket(const quint8 *data, int size, bool incoming);
     void handleHciEventPacket(const quint8 *data, int size);
-    void handleHciAclPacket(const quint8 *data, int size);
-    void handleLeMetaEvent(const quint8 *data);
+    void handleHciAclPacket(const quint8 *data, int size, bool incoming);
+    void handleNumberOfCompletedPackets(const quint8 *data, int size);
+    void handleLeMetaEvent(const quint8 *data, int size);
+    void handleExtendedAdvertisingReports(const quint8 *data, int size);
+    bool updateAutoConnect();
+    void handleAutoConnectCommandResult(const CommandResult &result);
+    template <typename Function>
+    void dispatchToConnection(quint16 handle, Function function);
 
     int hciSocket;
     int hciDev;
     quint8 sigPacketIdentifier = 0;
     QSocketNotifier *notifier = nullptr;
+    // Spec v5.3, Vol 4, Part E, 4.4, the host may send one command before the first event
+    int commandCredits = 1;
+    QList<QueuedCommand> queuedCommands;
+    // sent and waiting for their Command Complete or Command Status event, oldest first
+    QList<QueuedCommand> commandsInFlight;
+    QTimer *commandTimer = nullptr;
     QSet<HciManager::HciEvent> runningEvents;
+    QHash<quint16, LinkCounters> linkStatistics;
+    // peer addresses of the LE connections, complete once connectionsTracked is set
+    QHash<quint16, QBluetoothAddress> lowEnergyConnections;
+    bool connectionsTracked = false;
+    QHash<quint16, QList<HciConnectionSubscriber *>> connectionSubscribers;
+    // address types (0 public, 1 random) of the devices in the accept list
+    QHash<QBluetoothAddress, quint8> autoConnectDevices;
+    bool autoConnectInitiating = false;
+    // the cancelled initiator reports a failed connection that nobody waits for
+    bool autoConnectCancelling = false;
 };
 
 QT_END_NAMESPACE
@@ -0,0 +1,259 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "periodicadvertisingsync_p.h"
+#include "bluez_data_p.h"
+#include "hcimanager_p.h"
+#include "../qbluetoothsocketbase_p.h"
+
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qtimer.h>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+// the controller keeps looking for the periodic advertising until it is canceled
+static constexpr int syncEstablishmentTimeout = 10000;
+
+QtBluezPeriodicAdvertisingSync::QtBluezPeriodicAdvertisingSync(
+        const QBluetoothAddress &localAdapter, QObject *parent)
+    : QObject(parent), hciManager(HciManager::forAdapter(localAdapter))
+{
+    if (!hciManager->isValid()
+            || !hciManager->monitorEvent(HciManager::HciEvent::EVT_LE_META_EVENT)
+            || !hciManager->monitorEvent(HciManager::HciEvent::EVT_CMD_STATUS)) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot monitor HCI events, periodic advertising "
+                                  "is not available";
+        hciManager.reset();
+        return;
+    }
+
+    connect(hciManager.data(), &HciManager::periodicAdvertiserFound,
+            this, &QtBluezPeriodicAdvertisingSync::advertiserFound);
+    connect(hciManager.data(), &HciManager::commandStatusReceived,
+            this, &QtBluezPeriodicAdvertisingSync::handleCommandStatus);
+    connect(hciManager.data(), &HciManager::periodicAdvertisingSyncEstablished,
+            this, &QtBluezPeriodicAdvertisingSync::handleSyncEstablished);
+    connect(hciManager.data(), &HciManager::periodicAdvertisingReport,
+            this, &QtBluezPeriodicAdvertisingSync::handleReport);
+    connect(hciManager.data(), &HciManager::periodicAdvertisingSyncLost,
+            this, &QtBluezPeriodicAdvertisingSync::handleSyncLost);
+
+    pendingTimer = new QTimer(this);
+    pendingTimer->setSingleShot(true);
+    pendingTimer->setInterval(syncEstablishmentTimeout);
+    connect(pendingTimer, &QTimer::timeout, this, [this]() {
+        qCDebug(QT_BT_BLUEZ) << "Periodic advertising of" << pendingAddress << "not found";
+        cancelPendingSync();
+    });
+}
+
+QtBluezPeriodicAdvertisingSync::~QtBluezPeriodicAdvertisingSync()
+{
+    if (!hciManager)
+        return;
+
+    // the controller would stay synchronized otherwise
+    requested.clear();
+    cancelPendingSync();
+    for (auto it = syncs.cbegin(); it != syncs.cend(); ++it) {
+        QByteArray data(2, Qt::Uninitialized);
+        putBtData(it.key(), data.data());
+        hciManager->sendCommand(QBluezConst::OgfLinkControl,
+                                QBluezConst::OcfLePeriodicAdvTerminateSync, data);
+    }
+}
+
+bool QtBluezPeriodicAdvertisingSync::isValid() const
+{
+    return !hciManager.isNull();
+}
+
+void QtBluezPeriodicAdvertisingSync::start(const QBluetoothAddress &address)
+{
+    const bool isSynced = std::any_of(syncs.cbegin(), syncs.cend(), [&address](const Sync &sync) {
+        return sync.address == address;
+    });
+    if (isSynced || requested.contains(address))
+        return;
+
+    requested.append(address);
+    createNextSync();
+}
+
+void QtBluezPeriodicAdvertisingSync::stop(const QBluetoothAddress &address)
+{
+    requested.removeOne(address);
+    if (pendingAddress == address) {
+        cancelPendingSync();
+        return;
+    }
+
+    for (auto it = syncs.begin(); it != syncs.end(); ++it) {
+        if (it->address != address)
+            continue;
+
+        // Spec v5.3, Vol 4, Part E, 7.8.69
+        QByteArray data(2, Qt::Uninitialized);
+        putBtData(it.key(), data.data());
+        hciManager->sendCommand(QBluezConst::OgfLinkControl,
+                                QBluezConst::OcfLePeriodicAdvTerminateSync, data);
+        syncs.erase(it);
+        return;
+    }
+}
+
+void QtBluezPeriodicAdvertisingSync::advertiserFound(const QBluetoothAddress &address,
+                                                     quint8 addressType, quint8 sid,
+                                                     quint16 interval)
+{
+    advertisers.insert(address, { addressType, sid, interval });
+    if (pendingAddress.isNull() && requested.contains(address))
+        createNextSync();
+}
+
+void QtBluezPeriodicAdvertisingSync::createNextSync()
+{
+    if (!hciManager || !pendingAddress.isNull())
+        return;
+
+    for (const QBluetoothAddress &address : std::as_const(requested)) {
+        const auto advertiser = advertisers.constFind(address);
+        if (advertiser == advertisers.cend())
+            continue;
+
+        // Spec v5.3, Vol 4, Part E, 7.8.67
+        struct CreateSyncParams {
+            quint8 options;
+            quint8 sid;
+            quint8 addressType;
+            bdaddr_t address;
+            quint16 skip;
+            quint16 syncTimeout;
+            quint8 cteType;
+        } __attribute__ ((packed)) params;
+        static_assert(sizeof params == 14, "unexpected struct size");
+        params.options = 0; // No advertiser list, reports enabled.
+        params.sid = advertiser->sid;
+        params.addressType = advertiser->addressType;
+        convertAddress(address.toUInt64(), params.address.b);
+        params.skip = 0;
+        // in units of 10 ms, allow for six missed events
+        const int timeout = (std::max)(advertiser->interval * 125 * 6 / 1000, 100);
+        params.syncTimeout = qToLittleEndian(quint16((std::min)(timeout, 0x4000)));
+        params.cteType = 0;
+
+        const QByteArray data(reinterpret_cast<const char *>(&params), sizeof params);
+        if (!hciManager->sendCommand(QBluezConst::OgfLinkControl,
+                                     QBluezConst::OcfLePeriodicAdvCreateSync, data)) {
+            break;
+        }
+        qCDebug(QT_BT_BLUEZ) << "Synchronizing to periodic advertising of" << address;
+        pendingAddress = address;
+        pendingTimer->start();
+        return;
+    }
+}
+
+void QtBluezPeriodicAdvertisingSync::cancelPendingSync()
+{
+    if (pendingAddress.isNull())
+        return;
+
+    // Spec v5.3, Vol 4, Part E, 7.8.68, the sync established event reports the cancellation
+    pendingTimer->stop();
+    hciManager->sendCommand(QBluezConst::OgfLinkControl,
+                            QBluezConst::OcfLePeriodicAdvCreateSyncCancel, QByteArray());
+}
+
+void QtBluezPeriodicAdvertisingSync::handleCommandStatus(quint16 opCode, quint8 status)
+{
+    if (ocfFromOpCode(opCode) != QBluezConst::OcfLePeriodicAdvCreateSync
+            || pendingAddress.isNull() || status == 0) {
+        return;
+    }
+
+    qCWarning(QT_BT_BLUEZ) << "Cannot synchronize to periodic advertising of" << pendingAddress
+                           << "status" << static_cast<HciManager::HciError>(status);
+    const QBluetoothAddress address = pendingAddress;
+    pendingAddress.clear();
+    pendingTimer->stop();
+    if (requested.removeOne(address))
+        emit syncFailed(address);
+    createNextSync();
+}
+
+void QtBluezPeriodicAdvertisingSync::handleSyncEstablished(quint8 status, quint16 syncHandle,
+                                                           const QBluetoothAddress &address,
+                                                           quint8 sid)
+{
+    Q_UNUSED(sid);
+    // other users of the adapter may synchronize too
+    if (address != pendingAddress)
+        return;
+
+    pendingAddress.clear();
+    pendingTimer->stop();
+    const bool isRequested = requested.removeOne(address);
+    if (status == 0 && isRequested) {
+        qCDebug(QT_BT_BLUEZ) << "Synchronized to periodic advertising of" << address;
+        syncs.insert(syncHandle, { address });
+    } else if (status == 0) {
+        // stopped while being established
+        QByteArray data(2, Qt::Uninitialized);
+        putBtData(syncHandle, data.data());
+        hciManager->sendCommand(QBluezConst::OgfLinkControl,
+                                QBluezConst::OcfLePeriodicAdvTerminateSync, data);
+    } else if (isRequested) {
+        qCDebug(QT_BT_BLUEZ) << "Synchronizing to periodic advertising of" << address
+                             << "failed with status" << static_cast<HciManager::HciError>(status);
+        emit syncFailed(address);
+    }
+    createNextSync();
+}
+
+void QtBluezPeriodicAdvertisingSync::handleReport(quint16 syncHandle, quint8 dataStatus,
+                                                  const QByteArray &data)
+{
+    const auto it = syncs.find(syncHandle);
+    if (it == syncs.end())
+        return;
+
+    // Spec v5.3, Vol 4, Part E, 7.7.65.15, the data may come in several reports
+    enum DataStatus : quint8 { Complete = 0x0, Incomplete = 0x1, Truncated = 0x2 };
+    switch (dataStatus) {
+    case Complete: {
+        const QByteArray report = it->data.isEmpty() ? data : it->data + data;
+        it->data.clear();
+        emit dataReceived(it->address, report);
+        break;
+    }
+    case Incomplete:
+        it->data += data;
+        break;
+    case Truncated:
+    default:
+        qCDebug(QT_BT_BLUEZ) << "Dropping truncated periodic advertising data of" << it->address;
+        it->data.clear();
+        break;
+    }
+}
+
+void QtBluezPeriodicAdvertisingSync::handleSyncLost(quint16 syncHandle)
+{
+    const auto it = syncs.constFind(syncHandle);
+    if (it == syncs.cend())
+        return;
+
+    const QBluetoothAddress address = it->address;
+    syncs.erase(it);
+    qCDebug(QT_BT_BLUEZ) << "Lost periodic advertising of" << address;
+    emit syncLost(address);
+}
+
+QT_END_NAMESPACE
+
+#include "moc_periodicadvertisingsync_p.cpp"
@@ -0,0 +1,92 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef PERIODICADVERTISINGSYNC_P_H
+#define PERIODICADVERTISINGSYNC_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qsharedpointer.h>
+
+#include <QtBluetooth/qbluetoothaddress.h>
+
+QT_BEGIN_NAMESPACE
+
+class HciManager;
+class QTimer;
+
+/*
+ * Synchronizes to the periodic advertising of remote devices using HCI
+ * commands. bluetoothd does not offer this, but the extended advertising
+ * reports of its device search carry the Advertising Set ID which the
+ * controller needs to find the periodic advertising of a device. A device
+ * is therefore only synchronized to once it has been seen by a device search.
+ *
+ * The controller establishes one synchronization at a time, further requests
+ * wait until the pending one is established, failed or timed out.
+ */
+class QtBluezPeriodicAdvertisingSync : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QtBluezPeriodicAdvertisingSync(const QBluetoothAddress &localAdapter,
+                                            QObject *parent = nullptr);
+    ~QtBluezPeriodicAdvertisingSync();
+
+    bool isValid() const;
+
+    void start(const QBluetoothAddress &address);
+    void stop(const QBluetoothAddress &address);
+
+signals:
+    void dataReceived(const QBluetoothAddress &address, const QByteArray &data);
+    void syncFailed(const QBluetoothAddress &address);
+    void syncLost(const QBluetoothAddress &address);
+
+private:
+    void advertiserFound(const QBluetoothAddress &address, quint8 addressType, quint8 sid,
+                         quint16 interval);
+    void createNextSync();
+    void cancelPendingSync();
+    void handleCommandStatus(quint16 opCode, quint8 status);
+    void handleSyncEstablished(quint8 status, quint16 syncHandle, const QBluetoothAddress &address,
+                               quint8 sid);
+    void handleReport(quint16 syncHandle, quint8 dataStatus, const QByteArray &data);
+    void handleSyncLost(quint16 syncHandle);
+
+    struct Advertiser {
+        quint8 addressType;
+        quint8 sid;
+        quint16 interval; // in units of 1.25 ms
+    };
+    struct Sync {
+        QBluetoothAddress address;
+        // the fragments of the current report
+        QByteArray data;
+    };
+
+    QSharedPointer<HciManager> hciManager;
+    QHash<QBluetoothAddress, Advertiser> advertisers;
+    // requested, but not synchronized yet, in the order of the requests
+    QList<QBluetoothAddress> requested;
+    QBluetoothAddress pendingAddress;
+    QTimer *pendingTimer = nullptr;
+    QHash<quint16, Sync> syncs;
+};
+
+QT_END_NAMESPACE
+
+#endif // PERIODICADVERTISINGSYNC_P_H
@@ -0,0 +1,585 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "peripheralapplication_p.h"
+
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qrandom.h>
+#include <QtCore/qsocketnotifier.h>
+#include <QtDBus/qdbusconnection.h>
+#include <QtDBus/qdbusmessage.h>
+#include <QtDBus/qdbuspendingcall.h>
+#include <QtDBus/qdbuspendingreply.h>
+#include <QtDBus/qdbusunixfiledescriptor.h>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+static const QLatin1String applicationPathTemplate("/qt/btle/%1%2/%3");
+
+static const QLatin1String objectManagerInterface("org.freedesktop.DBus.ObjectManager");
+static const QLatin1String propertiesInterface("org.freedesktop.DBus.Properties");
+static const QLatin1String serviceInterface("org.bluez.GattService1");
+static const QLatin1String characteristicInterface("org.bluez.GattCharacteristic1");
+static const QLatin1String descriptorInterface("org.bluez.GattDescriptor1");
+static const QLatin1String advertisementInterface("org.bluez.LEAdvertisement1");
+
+static const QLatin1String errorFailed("org.bluez.Error.Failed");
+static const QLatin1String errorNotSupported("org.bluez.Error.NotSupported");
+
+// ATT header of a Handle Value Notification
+static constexpr int notificationHeaderSize = 3;
+
+static QString advertisementPathOf(const QString &rootPath)
+{
+    return rootPath + QLatin1String("/advertisement0");
+}
+
+static QtBluezPeripheralRequest requestFromOptions(const QVariantMap &options)
+{
+    QtBluezPeripheralRequest request;
+    const QString device =
+            qvariant_cast<QDBusObjectPath>(options.value(QStringLiteral("device"))).path();
+    request.central = deviceAddressFromPath(device);
+    request.mtu = options.value(QStringLiteral("mtu")).toUInt();
+    request.offset = options.value(QStringLiteral("offset")).toUInt();
+    request.withResponse = options.value(QStringLiteral("type")).toString()
+                            != QLatin1String("command");
+    return request;
+}
+
+QtBluezPeripheralApplication::QtBluezPeripheralApplication(const QString &adapterPath,
+                                                           QtBluezPeripheralDelegate *delegate,
+                                                           QObject *parent)
+    : QDBusVirtualObject(parent), adapterPath(adapterPath), delegate(delegate)
+{
+    Q_ASSERT(delegate);
+    initializeBluez5();
+}
+
+QtBluezPeripheralApplication::~QtBluezPeripheralApplication()
+{
+    unregisterAdvertisement();
+    unregisterApplication();
+    if (objectRegistered)
+        QDBusConnection::systemBus().unregisterObject(rootPath, QDBusConnection::UnregisterTree);
+}
+
+/*!
+    Exports \a services below a new object path and registers them with the
+    GattManager1 of the adapter. A previously registered database is replaced.
+    bluetoothd answers asynchronously, its errors are reported by errorOccurred().
+*/
+bool QtBluezPeripheralApplication::registerApplication(
+        const QList<QtBluezPeripheralService> &services)
+{
+    unregisterApplication();
+    if (!exportObjects())
+        return false;
+
+    objects.clear();
+    characteristicPaths.clear();
+
+    QHash<QBluetoothUuid, QString> servicePaths;
+    for (qsizetype i = 0; i < services.size(); ++i)
+        servicePaths.insert(services.at(i).uuid, rootPath + QLatin1String("/service%1").arg(i));
+
+    int charIndex = 0;
+    int descIndex = 0;
+    for (const QtBluezPeripheralService &service : services) {
+        const QString servicePath = servicePaths.value(service.uuid);
+
+        QList<QDBusObjectPath> includes;
+        for (const QBluetoothUuid &included : service.includedServices) {
+            const QString includedPath = servicePaths.value(included);
+            if (!includedPath.isEmpty())
+                includes.append(QDBusObjectPath(includedPath));
+        }
+
+        Object serviceObject;
+        serviceObject.interface = serviceInterface;
+        serviceObject.properties.insert(QStringLiteral("UUID"),
+                                        service.uuid.toString(QUuid::WithoutBraces));
+        serviceObject.properties.insert(QStringLiteral("Primary"), service.primary);
+        serviceObject.properties.insert(QStringLiteral("Includes"), QVariant::fromValue(includes));
+        objects.insert(servicePath, serviceObject);
+
+        for (const QtBluezPeripheralCharacteristic &characteristic : service.characteristics) {
+            const QString charPath = servicePath + QLatin1String("/char%1").arg(charIndex++);
+
+            Object charObject;
+            charObject.interface = characteristicInterface;
+            charObject.charHandle = characteristic.handle;
+            charObject.properties.insert(QStringLiteral("UUID"),
+                                         characteristic.uuid.toString(QUuid::WithoutBraces));
+            charObject.properties.insert(QStringLiteral("Service"),
+                                         QVariant::fromValue(QDBusObjectPath(servicePath)));
+            charObject.properties.insert(QStringLiteral("Flags"), characteristic.flags);
+            // indications need the confirmation of the central, bluetoothd
+            // sends those by itself only when the value arrives by D-Bus
+            if ((characteristic.properties & QLowEnergyCharacteristic::Notify)
+                    && !(characteristic.properties & QLowEnergyCharacteristic::Indicate)) {
+                charObject.properties.insert(QStringLiteral("NotifyAcquired"), false);
+            }
+            objects.insert(charPath, charObject);
+            characteristicPaths.insert(characteristic.handle, charPath);
+
+            for (const QtBluezPeripheralDescriptor &descriptor : characteristic.descriptors) {
+                Object descObject;
+                descObject.interface = descriptorInterface;
+                descObject.charHandle = characteristic.handle;
+                descObject.descHandle = descriptor.handle;
+                descObject.properties.insert(QStringLiteral("UUID"),
+                                             descriptor.uuid.toString(QUuid::WithoutBraces));
+                descObject.properties.insert(QStringLiteral("Characteristic"),
+                                             QVariant::fromValue(QDBusObjectPath(charPath)));
+                descObject.properties.insert(QStringLiteral("Flags"), descriptor.flags);
+                objects.insert(charPath + QLatin1String("/desc%1").arg(descIndex++), descObject);
+            }
+        }
+    }
+
+    qCDebug(QT_BT_BLUEZ) << "Registering GATT application" << rootPath << "with"
+                         << objects.size() << "objects on" << adapterPath;
+    applicationRegistered = true;
+    callManager(QStringLiteral("org.bluez.GattManager1"), QStringLiteral("RegisterApplication"),
+                { QVariant::fromValue(QDBusObjectPath(rootPath)), QVariantMap() },
+                &applicationRegistered);
+    return true;
+}
+
+void QtBluezPeripheralApplication::unregisterApplication()
+{
+    for (auto it = notifySockets.cbegin(); it != notifySockets.cend(); ++it) {
+        delete it->notifier;
+        ::close(it->fd);
+    }
+    notifySockets.clear();
+    notifyingCharacteristics.clear();
+
+    if (!applicationRegistered)
+        return;
+
+    applicationRegistered = false;
+    QDBusMessage call = QDBusMessage::createMethodCall(
+                QStringLiteral("org.bluez"), adapterPath,
+                QStringLiteral("org.bluez.GattManager1"), QStringLiteral("UnregisterApplication"));
+    call << QVariant::fromValue(QDBusObjectPath(rootPath));
+    QDBusConnection::systemBus().send(call);
+}
+
+/*!
+    Registers an advertisement with the LEAdvertisingManager1 of the adapter.
+    bluetoothd picks the advertising interval and the advertising set, the
+    filter policy and the whitelist of \a params are not supported.
+*/
+bool QtBluezPeripheralApplication::registerAdvertisement(
+        const QLowEnergyAdvertisingParameters &params,
+        const QLowEnergyAdvertisingData &advertisingData,
+        const QLowEnergyAdvertisingData &scanResponseData)
+{
+    unregisterAdvertisement();
+    if (!exportObjects())
+        return false;
+
+    // LEAdvertisement1 has no stable properties for these
+    const QLowEnergyAdvertisingParameters defaultParams;
+    if (params.minimumInterval() != defaultParams.minimumInterval()
+            || params.maximumInterval() != defaultParams.maximumInterval()) {
+        qCWarning(QT_BT_BLUEZ) << "bluetoothd picks the advertising interval, ignoring"
+                               << params.minimumInterval() << params.maximumInterval();
+    }
+    if (params.filterPolicy() != defaultParams.filterPolicy() || !params.whiteList().isEmpty())
+        qCWarning(QT_BT_BLUEZ) << "bluetoothd does not support advertising white lists, ignoring";
+
+    advertisingParams = params;
+    this->advertisingData = advertisingData;
+    this->scanResponseData = scanResponseData;
+
+    advertisementRegistered = true;
+    callManager(QStringLiteral("org.bluez.LEAdvertisingManager1"),
+                QStringLiteral("RegisterAdvertisement"),
+                { QVariant::fromValue(QDBusObjectPath(advertisementPathOf(rootPath))),
+                  QVariantMap() },
+                &advertisementRegistered);
+    return true;
+}
+
+void QtBluezPeripheralApplication::unregisterAdvertisement()
+{
+    if (!advertisementRegistered)
+        return;
+
+    advertisementRegistered = false;
+    QDBusMessage call = QDBusMessage::createMethodCall(
+                QStringLiteral("org.bluez"), adapterPath,
+                QStringLiteral("org.bluez.LEAdvertisingManager1"),
+                QStringLiteral("UnregisterAdvertisement"));
+    call << QVariant::fromValue(QDBusObjectPath(advertisementPathOf(rootPath)));
+    QDBusConnection::systemBus().send(call);
+}
+
+bool QtBluezPeripheralApplication::isNotifying(QLowEnergyHandle charHandle) const
+{
+    return notifySockets.contains(charHandle) || notifyingCharacteristics.contains(charHandle);
+}
+
+/*!
+    Sends \a value of the characteristic \a charHandle to the subscribed centrals.
+    With an acquired socket this is a single write(), the value is cut to what
+    fits into a notification. Otherwise bluetoothd picks it up from a
+    PropertiesChanged signal.
+*/
+void QtBluezPeripheralApplication::notify(QLowEnergyHandle charHandle, QByteArrayView value)
+{
+    const auto it = notifySockets.constFind(charHandle);
+    if (it != notifySockets.cend()) {
+        const qsizetype size = (std::min)(value.size(),
+                                          qsizetype(it->mtu) - notificationHeaderSize);
+        if (::send(it->fd, value.data(), size, MSG_NOSIGNAL | MSG_DONTWAIT) >= 0)
+            return;
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            qCWarning(QT_BT_BLUEZ) << "Notification socket full, dropping value of" << charHandle;
+        } else {
+            qCDebug(QT_BT_BLUEZ) << "Notification socket of" << charHandle << "closed:"
+                                 << qt_error_string(errno);
+            releaseNotifySocket(charHandle);
+        }
+        return;
+    }
+
+    if (!notifyingCharacteristics.contains(charHandle))
+        return;
+
+    QDBusMessage signal = QDBusMessage::createSignal(characteristicPaths.value(charHandle),
+                                                     propertiesInterface,
+                                                     QStringLiteral("PropertiesChanged"));
+    QVariantMap changed;
+    changed.insert(QStringLiteral("Value"), value.toByteArray());
+    signal << QString(characteristicInterface) << changed << QStringList();
+    QDBusConnection::systemBus().send(signal);
+}
+
+QString QtBluezPeripheralApplication::introspect(const QString &path) const
+{
+    QString interface;
+    if (path == rootPath)
+        interface = objectManagerInterface;
+    else if (path == advertisementPathOf(rootPath))
+        interface = advertisementInterface;
+    else
+        interface = objects.value(path).interface;
+
+    if (interface.isEmpty())
+        return QString();
+    return QLatin1String("  <interface name=\"%1\"/>\n").arg(interface);
+}
+
+// QtDBus delivers the calls in the thread of the application object.
+bool QtBluezPeripheralApplication::handleMessage(const QDBusMessage &message,
+                                                 const QDBusConnection &connection)
+{
+    if (message.type() != QDBusMessage::MethodCallMessage)
+        return false;
+
+    const QString path = message.path();
+    QDBusMessage reply;
+    if (path == rootPath) {
+        if (message.interface() != objectManagerInterface)
+            return false;
+        reply = handleObjectManagerCall(message);
+    } else if (path == advertisementPathOf(rootPath)) {
+        if (message.interface() == propertiesInterface) {
+            reply = handlePropertiesCall(advertisementProperties(), advertisementInterface,
+                                         message);
+        } else if (message.interface() == advertisementInterface
+                   && message.member() == QLatin1String("Release")) {
+            qCDebug(QT_BT_BLUEZ) << "Advertisement released by bluetoothd";
+            advertisementRegistered = false;
+            reply = message.createReply();
+            emit advertisementReleased();
+        } else {
+            return false;
+        }
+    } else {
+        const auto it = objects.constFind(path);
+        if (it == objects.cend())
+            return false;
+        if (message.interface() == propertiesInterface)
+            reply = handlePropertiesCall(it->properties, it->interface, message);
+        else if (message.interface() == it->interface && it->charHandle)
+            reply = handleAttributeCall(*it, message);
+        else
+            return false;
+    }
+
+    if (reply.type() == QDBusMessage::InvalidMessage)
+        return false;
+    connection.send(reply);
+    return true;
+}
+
+bool QtBluezPeripheralApplication::exportObjects()
+{
+    if (objectRegistered)
+        return true;
+
+    for (int i = 0; i < 10 && !objectRegistered; i++) {
+        // another application might use the same path, try 10 times
+        rootPath = QString(applicationPathTemplate).
+                        arg(sanitizeNameForDBus(QCoreApplication::applicationName())).
+                        arg(QCoreApplication::applicationPid()).
+                        arg(QRandomGenerator::global()->generate());
+
+        objectRegistered = QDBusConnection::systemBus().registerVirtualObject(
+                        rootPath, this, QDBusConnection::SubPath);
+    }
+
+    if (!objectRegistered) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot export GATT application on DBus";
+        rootPath.clear();
+    }
+    return objectRegistered;
+}
+
+QDBusMessage QtBluezPeripheralApplication::handleObjectManagerCall(
+        const QDBusMessage &message) const
+{
+    if (message.member() != QLatin1String("GetManagedObjects"))
+        return message.createErrorReply(QDBusError::UnknownMethod, message.member());
+
+    ManagedObjectList managedObjects;
+    for (auto it = objects.cbegin(); it != objects.cend(); ++it) {
+        InterfaceList interfaces;
+        interfaces.insert(it->interface, it->properties);
+        managedObjects.insert(QDBusObjectPath(it.key()), interfaces);
+    }
+    return message.createReply(QVariant::fromValue(managedObjects));
+}
+
+QDBusMessage QtBluezPeripheralApplication::handlePropertiesCall(
+        const QVariantMap &properties, const QString &interface,
+        const QDBusMessage &message) const
+{
+    const QVariantList arguments = message.arguments();
+    if (arguments.isEmpty() || arguments.constFirst().toString() != interface) {
+        return message.createErrorReply(QDBusError::UnknownInterface,
+                                        arguments.value(0).toString());
+    }
+
+    if (message.member() == QLatin1String("GetAll"))
+        return message.createReply(properties);
+
+    if (message.member() == QLatin1String("Get") && arguments.size() == 2) {
+        const QString name = arguments.at(1).toString();
+        const auto it = properties.constFind(name);
+        if (it == properties.cend())
+            return message.createErrorReply(QDBusError::UnknownProperty, name);
+        return message.createReply(QVariant::fromValue(QDBusVariant(it.value())));
+    }
+
+    return message.createErrorReply(QDBusError::PropertyReadOnly, message.member());
+}
+
+QDBusMessage QtBluezPeripheralApplication::handleAttributeCall(const Object &object,
+                                                               const QDBusMessage &message)
+{
+    const QString member = message.member();
+    const QVariantList arguments = message.arguments();
+
+    if (member == QLatin1String("ReadValue") && arguments.size() == 1) {
+        const QtBluezPeripheralRequest request =
+                requestFromOptions(qdbus_cast<QVariantMap>(arguments.at(0)));
+        QByteArray value;
+        const QString error = delegate->peripheralRead(object.charHandle, object.descHandle,
+                                                       request, &value);
+        if (!error.isEmpty())
+            return message.createErrorReply(error, QString());
+        if (request.offset > value.size())
+            return message.createErrorReply(QStringLiteral("org.bluez.Error.InvalidOffset"),
+                                            QString());
+        return message.createReply(value.mid(request.offset));
+    }
+
+    if (member == QLatin1String("WriteValue") && arguments.size() == 2) {
+        const QtBluezPeripheralRequest request =
+                requestFromOptions(qdbus_cast<QVariantMap>(arguments.at(1)));
+        const QString error = delegate->peripheralWrite(object.charHandle, object.descHandle,
+                                                        request, arguments.at(0).toByteArray());
+        if (!error.isEmpty())
+            return message.createErrorReply(error, QString());
+        return message.createReply();
+    }
+
+    if (object.descHandle)
+        return message.createErrorReply(QDBusError::UnknownMethod, member);
+
+    if (member == QLatin1String("AcquireNotify") && arguments.size() == 1)
+        return acquireNotify(object, message);
+
+    if (member == QLatin1String("StartNotify") || member == QLatin1String("StopNotify")) {
+        const bool enabled = member == QLatin1String("StartNotify");
+        if (enabled) {
+            if (!notifyingCharacteristics.contains(object.charHandle))
+                notifyingCharacteristics.append(object.charHandle);
+        } else {
+            notifyingCharacteristics.removeOne(object.charHandle);
+        }
+        setNotifying(object.charHandle, enabled);
+        return message.createReply();
+    }
+
+    return message.createErrorReply(QDBusError::UnknownMethod, member);
+}
+
+QDBusMessage QtBluezPeripheralApplication::acquireNotify(const Object &object,
+                                                         const QDBusMessage &message)
+{
+    if (!object.properties.contains(QStringLiteral("NotifyAcquired")))
+        return message.createErrorReply(errorNotSupported, QString());
+    if (notifySockets.contains(object.charHandle))
+        return message.createErrorReply(QStringLiteral("org.bluez.Error.NotPermitted"),
+                                        QStringLiteral("Notify already acquired"));
+
+    const QtBluezPeripheralRequest request =
+            requestFromOptions(qdbus_cast<QVariantMap>(message.arguments().at(0)));
+
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) < 0) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot create notification socket:"
+                               << qt_error_string(errno);
+        return message.createErrorReply(errorFailed, qt_error_string(errno));
+    }
+
+    // QDBusUnixFileDescriptor keeps a duplicate for the reply
+    const QDBusUnixFileDescriptor remoteFd(fds[1]);
+    ::close(fds[1]);
+
+    NotifySocket socket;
+    socket.fd = fds[0];
+    socket.mtu = request.mtu;
+    // bluetoothd closes its end once no central is subscribed anymore
+    socket.notifier = new QSocketNotifier(fds[0], QSocketNotifier::Read, this);
+    const QLowEnergyHandle charHandle = object.charHandle;
+    connect(socket.notifier, &QSocketNotifier::activated, this, [this, charHandle]() {
+        const auto it = notifySockets.constFind(charHandle);
+        if (it == notifySockets.cend())
+            return;
+        char buffer;
+        const ssize_t result = ::recv(it->fd, &buffer, sizeof buffer, MSG_DONTWAIT);
+        if (result == 0 || (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+            releaseNotifySocket(charHandle);
+    });
+    notifySockets.insert(charHandle, socket);
+    objects[characteristicPaths.value(charHandle)].properties.insert(
+                QStringLiteral("NotifyAcquired"), true);
+
+    qCDebug(QT_BT_BLUEZ) << "Notifications of" << charHandle << "acquired with mtu"
+                         << request.mtu;
+    setNotifying(charHandle, true);
+    return message.createReply({ QVariant::fromValue(remoteFd), QVariant::fromValue(request.mtu) });
+}
+
+void QtBluezPeripheralApplication::releaseNotifySocket(QLowEnergyHandle charHandle)
+{
+    const NotifySocket socket = notifySockets.take(charHandle);
+    if (socket.fd < 0)
+        return;
+
+    // we might be called by the notifier
+    socket.notifier->setEnabled(false);
+    socket.notifier->deleteLater();
+    ::close(socket.fd);
+
+    const auto it = objects.find(characteristicPaths.value(charHandle));
+    if (it != objects.end())
+        it->properties.insert(QStringLiteral("NotifyAcquired"), false);
+
+    qCDebug(QT_BT_BLUEZ) << "Notifications of" << charHandle << "released";
+    if (!notifyingCharacteristics.contains(charHandle))
+        setNotifying(charHandle, false);
+}
+
+void QtBluezPeripheralApplication::setNotifying(QLowEnergyHandle charHandle, bool enabled)
+{
+    delegate->peripheralNotificationsChanged(charHandle, enabled);
+}
+
+QVariantMap QtBluezPeripheralApplication::advertisementProperties() const
+{
+    QVariantMap properties;
+
+    const bool connectable = advertisingParams.mode() == QLowEnergyAdvertisingParameters::AdvInd;
+    properties.insert(QStringLiteral("Type"), connectable ? QStringLiteral("peripheral")
+                                                          : QStringLiteral("broadcast"));
+
+    QStringList serviceUuids;
+    bool includeTxPower = false;
+    QString localName;
+    ManufacturerDataList manufacturerData;
+    bool discoverable = false;
+    for (const QLowEnergyAdvertisingData *data : { &advertisingData, &scanResponseData }) {
+        const QList<QBluetoothUuid> services = data->services();
+        for (const QBluetoothUuid &uuid : services) {
+            const QString uuidString = uuid.toString(QUuid::WithoutBraces);
+            if (!serviceUuids.contains(uuidString))
+                serviceUuids.append(uuidString);
+        }
+        includeTxPower |= data->includePowerLevel();
+        if (localName.isEmpty())
+            localName = data->localName();
+        if (data->manufacturerId() != QLowEnergyAdvertisingData::invalidManufacturerId()) {
+            manufacturerData.insert(data->manufacturerId(),
+                                    QDBusVariant(data->manufacturerData()));
+        }
+        discoverable |= data->discoverability() == QLowEnergyAdvertisingData::DiscoverabilityGeneral;
+    }
+
+    if (!serviceUuids.isEmpty())
+        properties.insert(QStringLiteral("ServiceUUIDs"), serviceUuids);
+    if (!manufacturerData.isEmpty())
+        properties.insert(QStringLiteral("ManufacturerData"),
+                          QVariant::fromValue(manufacturerData));
+    if (!localName.isEmpty())
+        properties.insert(QStringLiteral("LocalName"), localName);
+    if (includeTxPower)
+        properties.insert(QStringLiteral("Includes"), QStringList(QStringLiteral("tx-power")));
+    if (discoverable)
+        properties.insert(QStringLiteral("Discoverable"), true);
+    return properties;
+}
+
+void QtBluezPeripheralApplication::callManager(const QString &interface, const QString &method,
+                                               const QVariantList &arguments, bool *registered)
+{
+    QDBusMessage call = QDBusMessage::createMethodCall(QStringLiteral("org.bluez"), adapterPath,
+                                                       interface, method);
+    call.setArguments(arguments);
+    auto watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(call),
+                                               this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this,
+            [this, method, registered](QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+        const QDBusPendingReply<> reply = *call;
+        if (!reply.isError())
+            return;
+
+        qCWarning(QT_BT_BLUEZ) << method << "failed:" << reply.error().name()
+                               << reply.error().message();
+        *registered = false;
+        emit errorOccurred(reply.error().name(), reply.error().message());
+    });
+}
+
+QT_END_NAMESPACE
+
+#include "moc_peripheralapplication_p.cpp"
@@ -0,0 +1,172 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef PERIPHERALAPPLICATION_P_H
+#define PERIPHERALAPPLICATION_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "bluez5_helper_p.h"
+
+#include <QtBluetooth/qbluetoothaddress.h>
+#include <QtBluetooth/qbluetoothuuid.h>
+#include <QtBluetooth/qlowenergyadvertisingdata.h>
+#include <QtBluetooth/qlowenergyadvertisingparameters.h>
+#include <QtBluetooth/qlowenergycharacteristic.h>
+#include <QtCore/qbytearrayview.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qstringlist.h>
+#include <QtDBus/qdbusvirtualobject.h>
+
+QT_BEGIN_NAMESPACE
+
+class QSocketNotifier;
+
+// The local GATT database as exported to bluetoothd, handles are the ones of QLowEnergyService.
+struct QtBluezPeripheralDescriptor
+{
+    QLowEnergyHandle handle = 0;
+    QBluetoothUuid uuid;
+    QStringList flags;
+};
+
+struct QtBluezPeripheralCharacteristic
+{
+    QLowEnergyHandle handle = 0;
+    QBluetoothUuid uuid;
+    QLowEnergyCharacteristic::PropertyTypes properties;
+    QStringList flags;
+    QList<QtBluezPeripheralDescriptor> descriptors;
+};
+
+struct QtBluezPeripheralService
+{
+    QBluetoothUuid uuid;
+    bool primary = true;
+    QList<QBluetoothUuid> includedServices;
+    QList<QtBluezPeripheralCharacteristic> characteristics;
+};
+
+// The options bluetoothd passes along with ReadValue and WriteValue.
+struct QtBluezPeripheralRequest
+{
+    QBluetoothAddress central;
+    quint16 mtu = 0;
+    quint16 offset = 0;
+    bool withResponse = true;
+};
+
+// Answers the requests of the centrals from the database of the controller.
+class QtBluezPeripheralDelegate
+{
+public:
+    // the D-Bus error name is returned, an empty string means success
+    virtual QString peripheralRead(QLowEnergyHandle charHandle, QLowEnergyHandle descHandle,
+                                   const QtBluezPeripheralRequest &request,
+                                   QByteArray *value) = 0;
+    virtual QString peripheralWrite(QLowEnergyHandle charHandle, QLowEnergyHandle descHandle,
+                                    const QtBluezPeripheralRequest &request,
+                                    const QByteArray &value) = 0;
+    virtual void peripheralNotificationsChanged(QLowEnergyHandle charHandle, bool enabled) = 0;
+
+protected:
+    ~QtBluezPeripheralDelegate() = default;
+};
+
+/*
+ * Exports a local GATT database to bluetoothd by GattManager1 and, optionally,
+ * an advertisement by LEAdvertisingManager1. bluetoothd runs the ATT server,
+ * accepts any number of centrals and negotiates the MTU with each of them, we
+ * only see the reads and writes which reach the application.
+ *
+ * Notifications of characteristics without the indicate property are pushed
+ * through the socket handed over by AcquireNotify, so that a value costs one
+ * write() rather than a D-Bus signal. Characteristics which bluetoothd does not
+ * acquire fall back to PropertiesChanged signals after StartNotify.
+ */
+class QtBluezPeripheralApplication : public QDBusVirtualObject
+{
+    Q_OBJECT
+public:
+    QtBluezPeripheralApplication(const QString &adapterPath, QtBluezPeripheralDelegate *delegate,
+                                 QObject *parent = nullptr);
+    ~QtBluezPeripheralApplication() override;
+
+    bool registerApplication(const QList<QtBluezPeripheralService> &services);
+    void unregisterApplication();
+
+    bool registerAdvertisement(const QLowEnergyAdvertisingParameters &params,
+                               const QLowEnergyAdvertisingData &advertisingData,
+                               const QLowEnergyAdvertisingData &scanResponseData);
+    void unregisterAdvertisement();
+    bool isAdvertising() const { return advertisementRegistered; }
+
+    bool isNotifying(QLowEnergyHandle charHandle) const;
+    void notify(QLowEnergyHandle charHandle, QByteArrayView value);
+
+    QString introspect(const QString &path) const override;
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override;
+
+signals:
+    void errorOccurred(const QString &errorName, const QString &errorMessage);
+    void advertisementReleased();
+
+private:
+    struct Object
+    {
+        QString interface;
+        QVariantMap properties;
+        QLowEnergyHandle charHandle = 0;
+        QLowEnergyHandle descHandle = 0;
+    };
+
+    struct NotifySocket
+    {
+        int fd = -1;
+        quint16 mtu = 0;
+        QSocketNotifier *notifier = nullptr;
+    };
+
+    bool exportObjects();
+    QDBusMessage handleObjectManagerCall(const QDBusMessage &message) const;
+    QDBusMessage handlePropertiesCall(const QVariantMap &properties, const QString &interface,
+                                      const QDBusMessage &message) const;
+    QDBusMessage handleAttributeCall(const Object &object, const QDBusMessage &message);
+    QDBusMessage acquireNotify(const Object &object, const QDBusMessage &message);
+    void releaseNotifySocket(QLowEnergyHandle charHandle);
+    void setNotifying(QLowEnergyHandle charHandle, bool enabled);
+    QVariantMap advertisementProperties() const;
+    void callManager(const QString &interface, const QString &method,
+                     const QVariantList &arguments, bool *registered);
+
+    const QString adapterPath;
+    QString rootPath;
+    QtBluezPeripheralDelegate *delegate;
+    bool objectRegistered = false;
+    bool applicationRegistered = false;
+    bool advertisementRegistered = false;
+
+    QHash<QString, Object> objects; // by object path
+    QHash<QLowEnergyHandle, QString> characteristicPaths;
+    QHash<QLowEnergyHandle, NotifySocket> notifySockets;
+    QList<QLowEnergyHandle> notifyingCharacteristics; // StartNotify without a socket
+
+    QLowEnergyAdvertisingParameters advertisingParams;
+    QLowEnergyAdvertisingData advertisingData;
+    QLowEnergyAdvertisingData scanResponseData;
+};
+
+QT_END_NAMESPACE
+
+#endif // PERIPHERALAPPLICATION_P_H
@@ -13,12 +13,12 @@ OrgBluezProfile1ContextInterface::OrgBluezProfile1ContextInterface(QObject *pare
 {
 }
 
-void OrgBluezProfile1ContextInterface::NewConnection(const QDBusObjectPath &/*remotePath*/,
+void OrgBluezProfile1ContextInterface::NewConnection(const QDBusObjectPath &remotePath,
                                    const QDBusUnixFileDescriptor &descriptor,
                                    const QVariantMap &/*properties*/)
 {
     qCDebug(QT_BT_BLUEZ) << "Profile Context: New Connection";
-    emit newConnection(descriptor);
+    emit newConnection(remotePath, descriptor);
     setDelayedReply(false);
 }
 
@@ -31,6 +31,7 @@ void OrgBluezProfile1ContextInterface::RequestDisconnection(const QDBusObjectPat
 void OrgBluezProfile1ContextInterface::Release()
 {
     qCDebug(QT_BT_BLUEZ) << "Profile Context: Release";
+    emit released();
 }
 
 QT_END_NAMESPACE
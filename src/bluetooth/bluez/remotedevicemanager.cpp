@@ -12,18 +12,33 @@ QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
 
+// D-Bus calls run concurrently by default, bluetoothd serializes what it has to
+static constexpr int defaultMaxConcurrentJobs = 8;
+
 /*!
  * Convenience wrapper around org.bluez.Device1 management
  *
- * Very simple and not thread safe.
+ * Very simple and not thread safe. The jobs are started in the order they were
+ * scheduled, at most maxConcurrentJobs() at a time. The limit can be changed
+ * with the QT_BLUETOOTH_MAX_DEVICE_JOBS environment variable. jobFinished() is
+ * emitted for every device, finished() once all scheduled jobs are done.
  */
 
 RemoteDeviceManager::RemoteDeviceManager(
         const QBluetoothAddress &address, QObject *parent)
-    : QObject(parent), localAddress(address)
+    : QObject(parent), jobLimit(defaultMaxConcurrentJobs), localAddress(address)
 {
     initializeBluez5();
 
+    if (!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_MAX_DEVICE_JOBS")) {
+        bool ok = false;
+        const int limit = qEnvironmentVariableIntValue("QT_BLUETOOTH_MAX_DEVICE_JOBS", &ok);
+        if (ok && limit > 0)
+            jobLimit = limit;
+        else
+            qCWarning(QT_BT_BLUEZ) << "Ignoring invalid QT_BLUETOOTH_MAX_DEVICE_JOBS";
+    }
+
     bool ok = false;
     adapterPath = findAdapterForAddress(address, &ok);
     if (!ok || adapterPath.isEmpty()) {
@@ -31,6 +46,12 @@ RemoteDeviceManager::RemoteDeviceManager(
     }
 }
 
+void RemoteDeviceManager::setMaxConcurrentJobs(int limit)
+{
+    jobLimit = qMax(1, limit);
+    QTimer::singleShot(0, this, [this](){ runQueue(); });
+}
+
 bool RemoteDeviceManager::scheduleJob(JobType job, const QList<QBluetoothAddress> &remoteDevices)
 {
     if (adapterPath.isEmpty())
@@ -45,91 +66,78 @@ bool RemoteDeviceManager::scheduleJob(JobType job, const QList<QBluetoothAddress
 
 void RemoteDeviceManager::runQueue()
 {
-    if (jobInProgress || adapterPath.isEmpty())
+    if (adapterPath.isEmpty() || jobQueue.empty())
         return;
 
-    if (jobQueue.empty())
-        return;
+    while (runningJobs < jobLimit && !jobQueue.empty()) {
+        const auto [job, remote] = jobQueue.front();
+        jobQueue.pop_front();
 
-    jobInProgress = true;
-    switch (jobQueue.front().first) {
-    case JobType::JobDisconnectDevice:
-        disconnectDevice(jobQueue.front().second);
-        break;
-    default:
-        break;
+        if (startJob(job, remote)) {
+            ++runningJobs;
+        } else {
+            qCDebug(QT_BT_BLUEZ) << "RemoteDeviceManager job" << int(job) << "failed for" << remote;
+            emit jobFinished(job, remote, false);
+        }
     }
+
+    qCDebug(QT_BT_BLUEZ) << "RemoteDeviceManager jobs running:" << runningJobs
+                         << "queued:" << jobQueue.size();
+    // every remaining job failed to start
+    if (!isJobInProgress())
+        emit finished();
 }
 
-void RemoteDeviceManager::prepareNextJob()
+void RemoteDeviceManager::jobDone(JobType job, const QBluetoothAddress &remote, bool success)
 {
-    Q_ASSERT(!jobQueue.empty());
+    Q_ASSERT(runningJobs > 0);
+    --runningJobs;
 
-    jobQueue.pop_front();
-    jobInProgress = false;
-
-    qCDebug(QT_BT_BLUEZ) << "RemoteDeviceManager job queue status:" << jobQueue.empty();
-    if (jobQueue.empty())
-        emit finished();
-    else
+    emit jobFinished(job, remote, success);
+    if (isJobInProgress())
         runQueue();
+    else
+        emit finished();
 }
 
-void RemoteDeviceManager::disconnectDevice(const QBluetoothAddress &remote)
+bool RemoteDeviceManager::startJob(JobType job, const QBluetoothAddress &remote)
 {
-    // collect initial set of information
-    OrgFreedesktopDBusObjectManagerInterface managerBluez5(
-                                               QStringLiteral("org.bluez"),
-                                               QStringLiteral("/"),
-                                               QDBusConnection::systemBus(), this);
-    QDBusPendingReply<ManagedObjectList> reply = managerBluez5.GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError()) {
-        QTimer::singleShot(0, this, [this](){ prepareNextJob(); });
-        return;
-    }
+    QDBusError error;
+    const QString path = QtBluezObjectCache::instance()->devicePath(adapterPath, remote, &error);
+    if (error.isValid() || path.isEmpty())
+        return false;
 
-    bool jobStarted = false;
-    ManagedObjectList managedObjectList = reply.value();
-    for (auto it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-        const QDBusObjectPath &path = it.key();
-        const InterfaceList &ifaceList = it.value();
-
-        for (auto jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-            const QString &iface = jt.key();
-
-            if (path.path().indexOf(adapterPath) != 0)
-                continue; //devices whose path doesn't start with same path we skip
-
-            if (iface != QStringLiteral("org.bluez.Device1"))
-                continue;
-
-            const QBluetoothAddress foundAddress(ifaceList.value(iface).value(QStringLiteral("Address")).toString());
-            if (foundAddress != remote)
-                continue;
-
-            // found the correct Device1 path
-            OrgBluezDevice1Interface* device1 = new OrgBluezDevice1Interface(QStringLiteral("org.bluez"),
-                                                                             path.path(),
-                                                                             QDBusConnection::systemBus(),
-                                                                             this);
-            QDBusPendingReply<> asyncReply = device1->Disconnect();
-            QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(asyncReply, this);
-            const auto watcherFinished = [this, device1](QDBusPendingCallWatcher* call) {
-                call->deleteLater();
-                device1->deleteLater();
-                prepareNextJob();
-            };
-            connect(watcher, &QDBusPendingCallWatcher::finished, this, watcherFinished);
-            jobStarted = true;
-            break;
-        }
+    OrgBluezDevice1Interface *device1 = new OrgBluezDevice1Interface(QStringLiteral("org.bluez"),
+                                                                     path,
+                                                                     QDBusConnection::systemBus(),
+                                                                     this);
+    QDBusPendingReply<> asyncReply;
+    switch (job) {
+    case JobType::JobDisconnectDevice:
+        asyncReply = device1->Disconnect();
+        break;
+    case JobType::JobConnectDevice:
+        asyncReply = device1->Connect();
+        break;
+    case JobType::JobCancelPairing:
+        asyncReply = device1->CancelPairing();
+        break;
     }
 
-    if (!jobStarted) {
-        qCDebug(QT_BT_BLUEZ) << "RemoteDeviceManager JobDisconnectDevice failed";
-        QTimer::singleShot(0, this, [this](){ prepareNextJob(); });
-    }
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(asyncReply, this);
+    const auto watcherFinished = [this, device1, job, remote](QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+        device1->deleteLater();
+
+        const QDBusPendingReply<> reply = *call;
+        if (reply.isError()) {
+            qCDebug(QT_BT_BLUEZ) << "RemoteDeviceManager job" << int(job) << "for" << remote
+                                 << "failed:" << reply.error().message();
+        }
+        jobDone(job, remote, !reply.isError());
+    };
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, watcherFinished);
+    return true;
 }
 
 QT_END_NAMESPACE
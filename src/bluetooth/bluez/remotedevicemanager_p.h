@@ -18,7 +18,6 @@
 #include <deque>
 
 #include <QList>
-#include <QMutex>
 #include <QObject>
 
 #include <QtBluetooth/qbluetoothaddress.h>
@@ -27,7 +26,8 @@
 
 QT_BEGIN_NAMESPACE
 
-// This API is kept a bit more generic in anticipation of further changes in the future.
+// Runs org.bluez.Device1 calls for a set of remote devices. Up to
+// maxConcurrentJobs() calls are pending at the same time.
 
 class RemoteDeviceManager : public QObject
 {
@@ -36,24 +36,32 @@ public:
     enum class JobType
     {
         JobDisconnectDevice,
+        JobConnectDevice,
+        JobCancelPairing,
     };
 
     explicit RemoteDeviceManager(const QBluetoothAddress& localAddress, QObject *parent = nullptr);
 
-    bool isJobInProgress() const { return jobInProgress; }
+    bool isJobInProgress() const { return runningJobs > 0 || !jobQueue.empty(); }
     bool scheduleJob(JobType job, const QList<QBluetoothAddress> &remoteDevices);
 
+    int maxConcurrentJobs() const { return jobLimit; }
+    void setMaxConcurrentJobs(int limit);
+
 signals:
+    void jobFinished(RemoteDeviceManager::JobType job, const QBluetoothAddress &remote,
+                     bool success);
     void finished();
 
 private slots:
     void runQueue();
-    void prepareNextJob();
 
 private:
-    void disconnectDevice(const QBluetoothAddress& remote);
+    bool startJob(JobType job, const QBluetoothAddress &remote);
+    void jobDone(JobType job, const QBluetoothAddress &remote, bool success);
 
-    bool jobInProgress = false;
+    int runningJobs = 0;
+    int jobLimit;
     QBluetoothAddress localAddress;
     std::deque<std::pair<JobType, QBluetoothAddress>> jobQueue;
     QString adapterPath;
@@ -0,0 +1,478 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "scansession_p.h"
+#include "adapter1_bluez5_p.h"
+#include "bluetoothmanagement_p.h"
+#include "bluez_data_p.h"
+#include "objectmanager_p.h"
+#include "../qbluetoothdeviceinfo_p.h"
+#include "../qbluetoothuuid_p.h"
+
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qthread.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+namespace {
+struct SessionRegistry
+{
+    QMutex mutex;
+    QHash<QPair<QThread *, QString>, QtBluezScanSession *> sessions;
+};
+}
+
+Q_GLOBAL_STATIC(SessionRegistry, sessionRegistry)
+
+// Returns invalid QBluetoothDeviceInfo in case of error
+static QBluetoothDeviceInfo createDeviceInfoFromBluez5Device(const QVariantMap& properties)
+{
+    const QBluetoothAddress btAddress(properties[QStringLiteral("Address")].toString());
+    if (btAddress.isNull())
+        return QBluetoothDeviceInfo();
+
+    const QString btName = properties[QStringLiteral("Alias")].toString();
+    quint32 btClass = properties[QStringLiteral("Class")].toUInt();
+
+    QBluetoothDeviceInfo deviceInfo(btAddress, btName, btClass);
+    deviceInfo.setRssi(qvariant_cast<short>(properties[QStringLiteral("RSSI")]));
+
+    QList<QBluetoothUuid> uuids;
+    bool foundLikelyLowEnergyUuid = false;
+    const QStringList foundUuids = qvariant_cast<QStringList>(properties[QStringLiteral("UUIDs")]);
+    uuids.reserve(foundUuids.size());
+    for (const auto &u: foundUuids) {
+        int size = 0;
+        const QBluetoothUuid id = qt_bluetoothUuidFromString(u, &size);
+        if (size == 0)
+            continue;
+
+        if (!foundLikelyLowEnergyUuid && size == 2) {
+            //once we found one BTLE service we are done
+            const quint16 shortId = quint16(id.data1);
+            quint16 genericAccessInt = static_cast<quint16>(QBluetoothUuid::ServiceClassUuid::GenericAccess);
+            if ((shortId & genericAccessInt) == genericAccessInt)
+                foundLikelyLowEnergyUuid = true;
+        }
+        uuids.append(id);
+    }
+    deviceInfo.setServiceUuids(uuids);
+
+    if (!btClass) {
+        deviceInfo.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+    } else {
+        deviceInfo.setCoreConfigurations(QBluetoothDeviceInfo::BaseRateCoreConfiguration);
+        if (foundLikelyLowEnergyUuid)
+            deviceInfo.setCoreConfigurations(QBluetoothDeviceInfo::BaseRateAndLowEnergyCoreConfiguration);
+    }
+
+    const auto deviceManufacturerData =
+            bluezManufacturerData(properties[QStringLiteral("ManufacturerData")]);
+    for (const auto &entry : deviceManufacturerData)
+        deviceInfo.setManufacturerData(entry.first, entry.second);
+
+    const auto deviceServiceData = bluezServiceData(properties[QStringLiteral("ServiceData")]);
+    for (const auto &entry : deviceServiceData)
+        deviceInfo.setServiceData(entry.first, entry.second);
+
+    return deviceInfo;
+}
+
+/*
+ * Builds the device information from a single advertising report or inquiry
+ * result. Unlike createDeviceInfoFromBluez5Device(), the result only contains
+ * what this one report carried.
+ */
+static QBluetoothDeviceInfo createDeviceInfoFromEir(const QBluetoothAddress &address,
+                                                    quint8 addressType, qint8 rssi,
+                                                    const QByteArray &eirData)
+{
+    const QBluetoothEirData eir = QBluetoothEirData::parse(eirData);
+
+    QBluetoothDeviceInfo deviceInfo(address, eir.name, eir.classOfDevice);
+    deviceInfo.setRssi(rssi);
+    deviceInfo.setCoreConfigurations(addressType == BDADDR_BREDR
+                                     ? QBluetoothDeviceInfo::BaseRateCoreConfiguration
+                                     : QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+    eir.applyTo(&deviceInfo);
+    return deviceInfo;
+}
+
+/*!
+    \internal
+    \class QtBluezScanSession
+
+    A scan session runs the device discovery on one adapter on behalf of all
+    QBluetoothDeviceDiscoveryAgent instances of a thread that search on it.
+
+    The session owns the only D-Bus subscriptions needed for the discovery and
+    a cache of the properties of all devices of the adapter. Every report is
+    decoded into a QBluetoothDeviceInfo once and then handed to all clients,
+    which only apply their own filter and bookkeeping. bluetoothd accepts one
+    discovery filter per D-Bus connection, the session therefore sets the
+    union of the filters of its clients.
+
+    Sessions are not shared across threads. The signals are delivered directly
+    and are not meant to cross thread boundaries.
+*/
+
+static int controllerIndexForPath(const QString &adapterPath)
+{
+    const qsizetype hciPos = adapterPath.lastIndexOf(QLatin1String("/hci"));
+    bool ok = false;
+    const int index = hciPos < 0 ? -1 : QStringView(adapterPath).mid(hciPos + 4).toInt(&ok);
+    return ok ? index : -1;
+}
+
+QtBluezScanSession::QtBluezScanSession(const QString &adapterPath)
+    : adapter(adapterPath)
+{
+    qCDebug(QT_BT_BLUEZ) << "Creating scan session for" << adapterPath;
+
+    // Optionally take the advertising reports straight from the kernel. This spares
+    // us decoding a PropertiesChanged message per advertisement, but requires
+    // CAP_NET_ADMIN. bluetoothd still drives the discovery.
+    if (Q_UNLIKELY(qEnvironmentVariableIntValue("QT_BLUETOOTH_MGMT_DEVICE_FOUND") > 0)) {
+        const int index = controllerIndexForPath(adapterPath);
+        if (index < 0 || !BluetoothManagement::instance()->isMonitoringEnabled()) {
+            qCDebug(QT_BT_BLUEZ) << "Cannot use Bluetooth Management socket for device "
+                                    "discovery, falling back to D-Bus";
+        } else {
+            mgmtControllerIndex = index;
+            connect(BluetoothManagement::instance(), &BluetoothManagement::deviceFound,
+                    this, &QtBluezScanSession::mgmtDeviceFound);
+        }
+    }
+
+    auto manager = new OrgFreedesktopDBusObjectManagerInterface(
+                QStringLiteral("org.bluez"), QStringLiteral("/"),
+                QDBusConnection::systemBus(), this);
+    connect(manager, &OrgFreedesktopDBusObjectManagerInterface::InterfacesAdded,
+            this, &QtBluezScanSession::interfacesAdded);
+    connect(manager, &OrgFreedesktopDBusObjectManagerInterface::InterfacesRemoved,
+            this, &QtBluezScanSession::interfacesRemoved);
+
+    if (mgmtControllerIndex < 0) {
+        // device paths are not known up front, but only Device1 changes are of interest
+        propertiesMonitor = new QtBluezPropertiesMonitor(
+                    QString(), QStringLiteral("org.bluez.Device1"), this);
+        connect(propertiesMonitor, &QtBluezPropertiesMonitor::PropertiesChanged,
+                this, &QtBluezScanSession::propertiesChanged);
+    }
+
+    connect(QtBluezDiscoveryManager::instance(), &QtBluezDiscoveryManager::discoveryInterrupted,
+            this, &QtBluezScanSession::discoveryInterrupted);
+
+    // collect initial set of information
+    const ManagedObjectList managedObjectList = QtBluezObjectCache::instance()->managedObjects();
+    for (auto it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
+        const QString path = it.key().path();
+        if (!path.startsWith(adapter))
+            continue; //devices whose path doesn't start with same path we skip
+
+        const auto jt = it.value().constFind(QStringLiteral("org.bluez.Device1"));
+        if (jt != it.value().constEnd())
+            addDevice(path, jt.value());
+    }
+}
+
+QtBluezScanSession::~QtBluezScanSession()
+{
+    qCDebug(QT_BT_BLUEZ) << "Destroying scan session for" << adapter;
+}
+
+/*!
+    Returns the scan session for \a adapterPath in the current thread and adds
+    \a client with its \a filter to it. The discovery is started by the first client.
+
+    Returns \c nullptr if bluetoothd rejects the resulting discovery filter.
+*/
+QtBluezScanSession *QtBluezScanSession::acquire(const QString &adapterPath, const void *client,
+                                                const QtBluezDiscoveryFilter &filter)
+{
+    SessionRegistry *registry = sessionRegistry();
+    QMutexLocker locker(&registry->mutex);
+
+    const auto key = qMakePair(QThread::currentThread(), adapterPath);
+    QtBluezScanSession *session = registry->sessions.value(key);
+    const bool created = !session;
+    if (created)
+        session = new QtBluezScanSession(adapterPath);
+
+    session->clients.insert(client, filter);
+    const QDBusError error = session->applyDiscoveryFilter();
+    if (error.type() == QDBusError::Other
+            && error.name() == QStringLiteral("org.bluez.Error.Failed")) {
+        session->clients.remove(client);
+        if (created)
+            delete session;
+        else
+            session->applyDiscoveryFilter();
+        return nullptr;
+    }
+
+    if (created)
+        registry->sessions.insert(key, session);
+    if (!session->discoveryRegistered) {
+        QtBluezDiscoveryManager::instance()->registerDiscoveryInterest(adapterPath);
+        session->discoveryRegistered = true;
+    }
+    return session;
+}
+
+/*!
+    Removes \a client from the session. The last client stops the discovery
+    and destroys the session.
+*/
+void QtBluezScanSession::release(const void *client)
+{
+    SessionRegistry *registry = sessionRegistry();
+    QMutexLocker locker(&registry->mutex);
+
+    if (!clients.remove(client))
+        return;
+
+    if (!clients.isEmpty()) {
+        applyDiscoveryFilter();
+        return;
+    }
+
+    if (scanParametersChanged) {
+        BluetoothManagement::instance()->restoreDiscoveryScanParameters(
+                    controllerIndexForPath(adapter));
+        scanParametersChanged = false;
+    }
+
+    const auto key = qMakePair(thread(), adapter);
+    if (registry->sessions.value(key) == this)
+        registry->sessions.remove(key);
+    if (discoveryRegistered)
+        QtBluezDiscoveryManager::instance()->unregisterDiscoveryInterest(adapter);
+    discoveryRegistered = false;
+
+    // the client may be called from one of our signals
+    deleteLater();
+}
+
+QDBusError QtBluezScanSession::applyDiscoveryFilter()
+{
+    QBluetoothDeviceDiscoveryAgent::DiscoveryMethods methods;
+    QList<QBluetoothUuid> uuids;
+    bool allUuids = false;
+    bool allRssi = true;
+    bool allPathloss = true;
+    qint16 rssi = 0;
+    quint16 pathloss = 0;
+    bool duplicateData = false;
+    for (const QtBluezDiscoveryFilter &filter : qAsConst(clients)) {
+        methods |= filter.methods;
+        if (filter.serviceUuids.isEmpty())
+            allUuids = true;
+        for (const QBluetoothUuid &uuid : filter.serviceUuids) {
+            if (!uuids.contains(uuid))
+                uuids.append(uuid);
+        }
+        allRssi = allRssi && filter.rssiThreshold != 0;
+        rssi = rssi == 0 ? filter.rssiThreshold : qMin(rssi, filter.rssiThreshold);
+        allPathloss = allPathloss && filter.rssiThreshold == 0 && filter.pathlossThreshold != 0;
+        pathloss = qMax(pathloss, filter.pathlossThreshold);
+        duplicateData = duplicateData || filter.duplicateData;
+    }
+
+    QVariantMap map;
+    if (methods == (QBluetoothDeviceDiscoveryAgent::LowEnergyMethod|QBluetoothDeviceDiscoveryAgent::ClassicMethod))
+        map.insert(QStringLiteral("Transport"), QStringLiteral("auto"));
+    else if (methods & QBluetoothDeviceDiscoveryAgent::LowEnergyMethod)
+        map.insert(QStringLiteral("Transport"), QStringLiteral("le"));
+    else
+        map.insert(QStringLiteral("Transport"), QStringLiteral("bredr"));
+
+    if (!allUuids) {
+        QStringList uuidStrings;
+        uuidStrings.reserve(uuids.size());
+        for (const QBluetoothUuid &uuid : qAsConst(uuids))
+            uuidStrings.append(uuid.toString(QUuid::WithoutBraces));
+        map.insert(QStringLiteral("UUIDs"), uuidStrings);
+    }
+    // bluetoothd rejects filters containing both
+    if (allRssi)
+        map.insert(QStringLiteral("RSSI"), QVariant::fromValue(rssi));
+    else if (allPathloss)
+        map.insert(QStringLiteral("Pathloss"), QVariant::fromValue(pathloss));
+    if (!duplicateData)
+        map.insert(QStringLiteral("DuplicateData"), false);
+
+    applyScanParameters();
+
+    // older BlueZ 5.x versions don't have this function
+    // filterReply returns UnknownMethod which we ignore
+    OrgBluezAdapter1Interface iface(QStringLiteral("org.bluez"), adapter,
+                                    QDBusConnection::systemBus());
+    QDBusPendingReply<> filterReply = iface.SetDiscoveryFilter(map);
+    filterReply.waitForFinished();
+    if (filterReply.isError()) {
+        if (filterReply.error().type() == QDBusError::Other
+                    && filterReply.error().name() == QStringLiteral("org.bluez.Error.Failed")) {
+            qCDebug(QT_BT_BLUEZ) << "Discovery method" << methods << "not supported";
+        } else if (filterReply.error().type() != QDBusError::UnknownMethod) {
+            qCDebug(QT_BT_BLUEZ) << "SetDiscoveryFilter failed:" << filterReply.error();
+        }
+    }
+    return filterReply.error();
+}
+
+/*
+ * bluetoothd has no discovery filter for the scan parameters, they are set
+ * for the kernel's discoveries of the adapter instead, which requires
+ * CAP_NET_ADMIN. The session scans with the highest duty cycle any of its
+ * clients asked for. A client without scan parameters keeps the default of
+ * the kernel, which scans continuously.
+ */
+void QtBluezScanSession::applyScanParameters()
+{
+    quint16 interval = 0;
+    quint16 window = 0;
+    for (const QtBluezDiscoveryFilter &filter : qAsConst(clients)) {
+        if (!filter.scanInterval) {
+            interval = window = 0;
+            break;
+        }
+        // window / interval > current window / current interval
+        if (!interval || quint32(filter.scanWindow) * interval > quint32(window) * filter.scanInterval
+                || (quint32(filter.scanWindow) * interval == quint32(window) * filter.scanInterval
+                    && filter.scanInterval < interval)) {
+            interval = filter.scanInterval;
+            window = filter.scanWindow;
+        }
+    }
+
+    const int index = controllerIndexForPath(adapter);
+    if (index < 0 || !BluetoothManagement::instance()->isMonitoringEnabled()) {
+        if (interval)
+            qCDebug(QT_BT_BLUEZ) << "Cannot set the scan parameters without CAP_NET_ADMIN";
+        return;
+    }
+
+    if (interval) {
+        scanParametersChanged = BluetoothManagement::instance()->setDiscoveryScanParameters(
+                    quint16(index), interval, window) || scanParametersChanged;
+    } else if (scanParametersChanged) {
+        BluetoothManagement::instance()->restoreDiscoveryScanParameters(quint16(index));
+        scanParametersChanged = false;
+    }
+}
+
+/*
+ * Caches the properties of the device at \a path if it belongs to our adapter.
+ * Returns false if it does not or if the properties are invalid.
+ */
+bool QtBluezScanSession::addDevice(const QString &path, const QVariantMap &properties)
+{
+    const auto deviceAdapter = qvariant_cast<QDBusObjectPath>(
+                properties.value(QStringLiteral("Adapter")));
+    if (deviceAdapter.path() != adapter)
+        return false;
+
+    const QBluetoothDeviceInfo info = createDeviceInfoFromBluez5Device(properties);
+    if (!info.isValid()) // no point reporting an empty address
+        return false;
+
+    devices.insert(path, Device{ properties, info });
+    return true;
+}
+
+void QtBluezScanSession::interfacesAdded(const QDBusObjectPath &objectPath,
+                                         InterfaceList interfaces)
+{
+    const auto it = interfaces.constFind(QStringLiteral("org.bluez.Device1"));
+    if (it == interfaces.constEnd())
+        return;
+
+    const QString path = objectPath.path();
+    if (!addDevice(path, it.value()))
+        return;
+
+    // in this mode all devices are taken from the kernel's reports
+    if (mgmtControllerIndex >= 0)
+        return;
+
+    const Device device = devices.value(path);
+    emit deviceFound(path, device.properties, device.info);
+}
+
+void QtBluezScanSession::interfacesRemoved(const QDBusObjectPath &objectPath,
+                                           const QStringList &interfaces)
+{
+    if (interfaces.contains(QStringLiteral("org.bluez.Device1")))
+        devices.remove(objectPath.path());
+}
+
+void QtBluezScanSession::propertiesChanged(const QString &interface,
+                                           const QVariantMap &changedProperties,
+                                           const QStringList &invalidatedProperties,
+                                           const QDBusMessage &msg)
+{
+    if (interface != QStringLiteral("org.bluez.Device1"))
+        return;
+
+    const QString path = msg.path();
+    auto it = devices.find(path);
+    if (it == devices.end()) {
+        // not a device of our adapter or it appeared without InterfacesAdded
+        if (!path.startsWith(adapter))
+            return;
+
+        const ManagedObjectList objects = QtBluezObjectCache::instance()->managedObjects();
+        const InterfaceList interfaces = objects.value(QDBusObjectPath(path));
+        const auto jt = interfaces.constFind(QStringLiteral("org.bluez.Device1"));
+        if (jt == interfaces.constEnd() || !addDevice(path, jt.value()))
+            return;
+        it = devices.find(path);
+    }
+
+    QVariantMap &properties = it->properties;
+    for (auto jt = changedProperties.constBegin(); jt != changedProperties.constEnd(); ++jt)
+        properties[jt.key()] = jt.value();
+    for (const QString &property : invalidatedProperties)
+        properties.remove(property);
+
+    const QBluetoothDeviceInfo info = createDeviceInfoFromBluez5Device(properties);
+    if (!info.isValid())
+        return;
+    it->info = info;
+
+    // copy, clients may spin the event loop and thereby change the cache
+    const QVariantMap currentProperties = properties;
+    emit devicePropertiesChanged(path, currentProperties, changedProperties, info);
+}
+
+void QtBluezScanSession::mgmtDeviceFound(quint16 controllerIndex, const QBluetoothAddress &address,
+                                         quint8 addressType, qint8 rssi,
+                                         const QByteArray &eirData)
+{
+    if (controllerIndex != mgmtControllerIndex)
+        return;
+
+    emit advertisementReceived(createDeviceInfoFromEir(address, addressType, rssi, eirData),
+                               eirData);
+}
+
+void QtBluezScanSession::discoveryInterrupted(const QString &path)
+{
+    if (path != adapter)
+        return;
+
+    // QtBluezDiscoveryManager has dropped our interest already, new clients get a new session
+    discoveryRegistered = false;
+    SessionRegistry *registry = sessionRegistry();
+    QMutexLocker locker(&registry->mutex);
+    const auto key = qMakePair(thread(), adapter);
+    if (registry->sessions.value(key) == this)
+        registry->sessions.remove(key);
+}
+
+QT_END_NAMESPACE
+
+#include "moc_scansession_p.cpp"
@@ -0,0 +1,106 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef SCANSESSION_P_H
+#define SCANSESSION_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qvariant.h>
+
+#include <QtBluetooth/qbluetoothdevicediscoveryagent.h>
+#include <QtBluetooth/qbluetoothdeviceinfo.h>
+
+#include "bluez5_helper_p.h"
+
+QT_BEGIN_NAMESPACE
+
+class QtBluezPropertiesMonitor;
+
+/*
+ * The discovery filter of one client of a scan session. The session passes
+ * the union of the filters of all its clients to bluetoothd, every client has
+ * to apply its own filter to what the session reports.
+ */
+struct QtBluezDiscoveryFilter
+{
+    QBluetoothDeviceDiscoveryAgent::DiscoveryMethods methods;
+    QList<QBluetoothUuid> serviceUuids;
+    qint16 rssiThreshold = 0;
+    quint16 pathlossThreshold = 0;
+    bool duplicateData = true;
+    // in units of 0.625 ms, 0 leaves the scan parameters to the kernel
+    quint16 scanInterval = 0;
+    quint16 scanWindow = 0;
+};
+
+class QtBluezScanSession : public QObject
+{
+    Q_OBJECT
+public:
+    struct Device
+    {
+        QVariantMap properties;
+        QBluetoothDeviceInfo info;
+    };
+
+    static QtBluezScanSession *acquire(const QString &adapterPath, const void *client,
+                                       const QtBluezDiscoveryFilter &filter);
+    void release(const void *client);
+
+    QString adapterPath() const { return adapter; }
+    bool isUsingManagementSocket() const { return mgmtControllerIndex >= 0; }
+    QList<QString> devicePaths() const { return devices.keys(); }
+    Device device(const QString &path) const { return devices.value(path); }
+
+signals:
+    void deviceFound(const QString &path, const QVariantMap &properties,
+                     const QBluetoothDeviceInfo &info);
+    void devicePropertiesChanged(const QString &path, const QVariantMap &properties,
+                                 const QVariantMap &changedProperties,
+                                 const QBluetoothDeviceInfo &info);
+    void advertisementReceived(const QBluetoothDeviceInfo &info, const QByteArray &eirData);
+
+private slots:
+    void interfacesAdded(const QDBusObjectPath &objectPath, InterfaceList interfaces);
+    void interfacesRemoved(const QDBusObjectPath &objectPath, const QStringList &interfaces);
+    void propertiesChanged(const QString &interface, const QVariantMap &changedProperties,
+                           const QStringList &invalidatedProperties, const QDBusMessage &msg);
+    void mgmtDeviceFound(quint16 controllerIndex, const QBluetoothAddress &address,
+                         quint8 addressType, qint8 rssi, const QByteArray &eirData);
+    void discoveryInterrupted(const QString &path);
+
+private:
+    explicit QtBluezScanSession(const QString &adapterPath);
+    ~QtBluezScanSession();
+
+    QDBusError applyDiscoveryFilter();
+    void applyScanParameters();
+    bool addDevice(const QString &path, const QVariantMap &properties);
+
+    const QString adapter;
+    int mgmtControllerIndex = -1;
+    // the scan parameters were changed for the clients, see applyScanParameters()
+    bool scanParametersChanged = false;
+    bool discoveryRegistered = false;
+    QHash<const void *, QtBluezDiscoveryFilter> clients;
+    QHash<QString, Device> devices;
+    QtBluezPropertiesMonitor *propertiesMonitor = nullptr;
+};
+
+QT_END_NAMESPACE
+
+#endif // SCANSESSION_P_H
@@ -0,0 +1,338 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "sdpclient_p.h"
+#include "bluez_data_p.h"
+
+#include "qbluetoothserviceinfo_p.h"
+#include "qbluetoothsocketbase_p.h"
+
+#include <QtCore/qendian.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qsocketnotifier.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/private/qcore_unix_p.h>
+
+#include <cstring>
+#include <utility>
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+namespace {
+
+// PDU ids, see Bluetooth Core Specification Vol 3, Part B, 4.2
+enum : quint8 {
+    ErrorResponse = 0x01,
+    ServiceSearchAttributeRequest = 0x06,
+    ServiceSearchAttributeResponse = 0x07
+};
+
+}
+
+static constexpr quint16 sdpPsm = 0x0001;
+static constexpr qsizetype pduHeaderSize = 5;
+static constexpr qsizetype maxContinuationStateSize = 16;
+// comfortably above the default incoming L2CAP MTU of 672 bytes
+static constexpr qsizetype maxResponseSize = 1024;
+static constexpr int responseTimeout = 20000; // ms
+
+static void appendUInt16(QByteArray *out, quint16 value)
+{
+    char buffer[2];
+    qToBigEndian<quint16>(value, buffer);
+    out->append(buffer, sizeof(buffer));
+}
+
+bool QtBluezSdpClient::isEnabled()
+{
+    static const bool enabled = qEnvironmentVariableIntValue("QT_BLUETOOTH_USE_SDPSCANNER") <= 0;
+    return enabled;
+}
+
+QtBluezSdpClient::QtBluezSdpClient(QObject *parent)
+    : QObject(parent)
+{
+    connectTimer = new QTimer(this);
+    connectTimer->setSingleShot(true);
+    connectTimer->setInterval(0);
+    connect(connectTimer, &QTimer::timeout, this, &QtBluezSdpClient::connectSocket);
+
+    responseTimer = new QTimer(this);
+    responseTimer->setSingleShot(true);
+    responseTimer->setInterval(responseTimeout);
+    connect(responseTimer, &QTimer::timeout, this, &QtBluezSdpClient::responseTimedOut);
+}
+
+QtBluezSdpClient::~QtBluezSdpClient()
+{
+    closeSocket();
+}
+
+void QtBluezSdpClient::start(const QBluetoothAddress &remoteAddress,
+                             const QBluetoothAddress &localAddress,
+                             const QList<QBluetoothUuid> &uuids)
+{
+    stop();
+
+    remote = remoteAddress;
+    local = localAddress;
+    pendingUuids = uuids;
+    if (pendingUuids.isEmpty())
+        pendingUuids.append(QBluetoothUuid(QBluetoothUuid::ServiceClassUuid::PublicBrowseGroup));
+    connectRetried = false;
+
+    qCDebug(QT_BT_BLUEZ) << "SDP query on" << remote << "for" << pendingUuids;
+    connectTimer->start();
+}
+
+void QtBluezSdpClient::stop()
+{
+    connectTimer->stop();
+    closeSocket();
+    pendingUuids.clear();
+    services.clear();
+    attributeLists.clear();
+    continuationState.clear();
+}
+
+bool QtBluezSdpClient::isActive() const
+{
+    return connectTimer->isActive() || socket != -1;
+}
+
+void QtBluezSdpClient::connectSocket()
+{
+    socket = qt_safe_socket(AF_BLUETOOTH, SOCK_SEQPACKET, BTPROTO_L2CAP, O_NONBLOCK);
+    if (socket < 0) {
+        socket = -1;
+        fail(qt_error_string(errno));
+        return;
+    }
+
+    sockaddr_l2 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.l2_family = AF_BLUETOOTH;
+    convertAddress(local.toUInt64(), addr.l2_bdaddr.b);
+    if (::bind(socket, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        fail(qt_error_string(errno));
+        return;
+    }
+
+    addr.l2_psm = htobs(sdpPsm);
+    convertAddress(remote.toUInt64(), addr.l2_bdaddr.b);
+    if (::connect(socket, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0
+            && errno != EINPROGRESS) {
+        fail(qt_error_string(errno));
+        return;
+    }
+
+    connectNotifier = new QSocketNotifier(socket, QSocketNotifier::Write, this);
+    connect(connectNotifier, &QSocketNotifier::activated, this, &QtBluezSdpClient::connected);
+}
+
+void QtBluezSdpClient::connected()
+{
+    int error = 0;
+    socklen_t length = sizeof(error);
+    ::getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &length);
+
+    connectNotifier->setEnabled(false);
+    connectNotifier->deleteLater();
+    connectNotifier = nullptr;
+
+    if (error != 0) {
+        // like SDP_RETRY_IF_BUSY of libbluetooth, give a busy SDP server one
+        // more chance; any other error, e.g. a page timeout, is final
+        if (!connectRetried && error == ECONNREFUSED) {
+            qCDebug(QT_BT_BLUEZ) << "Retrying SDP connection to" << remote
+                                 << qt_error_string(error);
+            connectRetried = true;
+            closeSocket();
+            connectSocket();
+        } else {
+            fail(qt_error_string(error));
+        }
+        return;
+    }
+
+    readNotifier = new QSocketNotifier(socket, QSocketNotifier::Read, this);
+    connect(readNotifier, &QSocketNotifier::activated, this, &QtBluezSdpClient::readResponse);
+    sendRequest();
+}
+
+void QtBluezSdpClient::sendRequest()
+{
+    // ServiceSearchPattern, a sequence holding the current uuid
+    QBluetoothServiceInfo::Sequence pattern;
+    pattern.append(QVariant::fromValue(pendingUuids.constFirst()));
+
+    QByteArray pdu;
+    pdu.reserve(pduHeaderSize + 2 + 18 + 9 + 1 + continuationState.size());
+    pdu.append(char(ServiceSearchAttributeRequest));
+    appendUInt16(&pdu, ++transactionId);
+    appendUInt16(&pdu, 0); // parameter length, set below
+    QBluetoothServiceInfoPrivate::appendDataElement(&pdu, QVariant::fromValue(pattern));
+    // MaximumAttributeByteCount, the server limits the response to its MTU anyway
+    appendUInt16(&pdu, 0xffff);
+    // AttributeIDList, a sequence holding the range 0x0000-0xffff
+    static constexpr char allAttributes[] = { 0x35, 0x05, 0x0a, 0x00, 0x00, char(0xff), char(0xff) };
+    pdu.append(allAttributes, sizeof(allAttributes));
+    pdu.append(char(continuationState.size()));
+    pdu.append(continuationState);
+    qToBigEndian<quint16>(quint16(pdu.size() - pduHeaderSize), pdu.data() + 3);
+
+    if (qt_safe_write(socket, pdu.constData(), pdu.size()) != pdu.size()) {
+        fail(qt_error_string(errno));
+        return;
+    }
+
+    responseTimer->start();
+}
+
+void QtBluezSdpClient::readResponse()
+{
+    char buffer[maxResponseSize];
+    const qint64 size = qt_safe_read(socket, buffer, sizeof(buffer));
+    if (size < 0 && errno == EAGAIN)
+        return;
+    if (size <= 0) {
+        fail(size < 0 ? qt_error_string(errno) : QStringLiteral("Connection closed by remote device"));
+        return;
+    }
+
+    const QByteArrayView pdu(buffer, size);
+    if (size < pduHeaderSize || qFromBigEndian<quint16>(buffer + 3) != size - pduHeaderSize) {
+        fail(QStringLiteral("Malformed SDP response"));
+        return;
+    }
+    if (qFromBigEndian<quint16>(buffer + 1) != transactionId) {
+        qCDebug(QT_BT_BLUEZ) << "Ignoring SDP response with unexpected transaction id";
+        return;
+    }
+
+    responseTimer->stop();
+
+    const QByteArrayView parameters = pdu.sliced(pduHeaderSize);
+    if (quint8(buffer[0]) == ErrorResponse) {
+        const quint16 errorCode = parameters.size() >= 2
+                ? qFromBigEndian<quint16>(parameters.data()) : 0;
+        fail(QStringLiteral("SDP server reported error 0x%1")
+                     .arg(errorCode, 4, 16, QLatin1Char('0')));
+        return;
+    }
+
+    // AttributeListsByteCount (2) | AttributeLists | ContinuationState (1 + n)
+    qsizetype byteCount = 0;
+    qsizetype continuationSize = 0;
+    if (quint8(buffer[0]) == ServiceSearchAttributeResponse && parameters.size() >= 3) {
+        byteCount = qFromBigEndian<quint16>(parameters.data());
+        if (parameters.size() >= 2 + byteCount + 1)
+            continuationSize = quint8(parameters.data()[2 + byteCount]);
+    }
+    if (parameters.size() < 3 || parameters.size() != 2 + byteCount + 1 + continuationSize
+            || continuationSize > maxContinuationStateSize) {
+        fail(QStringLiteral("Malformed SDP response"));
+        return;
+    }
+
+    attributeLists.append(parameters.sliced(2, byteCount));
+    continuationState = parameters.sliced(3 + byteCount, continuationSize).toByteArray();
+    if (!continuationState.isEmpty()) {
+        sendRequest();
+        return;
+    }
+
+    if (!parseAttributeLists(attributeLists, &services))
+        qCWarning(QT_BT_BLUEZ) << "Ignoring malformed SDP records of" << remote;
+    attributeLists.clear();
+
+    pendingUuids.removeFirst();
+    if (!pendingUuids.isEmpty()) {
+        sendRequest();
+        return;
+    }
+
+    closeSocket();
+    const QList<QBluetoothServiceInfo> result = std::exchange(services, {});
+    emit finished(result);
+}
+
+void QtBluezSdpClient::responseTimedOut()
+{
+    fail(QStringLiteral("SDP server did not respond"));
+}
+
+void QtBluezSdpClient::fail(const QString &errorString)
+{
+    qCDebug(QT_BT_BLUEZ) << "SDP query on" << remote << "failed:" << errorString;
+    stop();
+    emit errorOccurred(errorString);
+}
+
+void QtBluezSdpClient::closeSocket()
+{
+    responseTimer->stop();
+
+    // the notifiers may be emitting right now
+    if (connectNotifier) {
+        connectNotifier->setEnabled(false);
+        connectNotifier->deleteLater();
+        connectNotifier = nullptr;
+    }
+    if (readNotifier) {
+        readNotifier->setEnabled(false);
+        readNotifier->deleteLater();
+        readNotifier = nullptr;
+    }
+
+    if (socket != -1) {
+        qt_safe_close(socket);
+        socket = -1;
+    }
+}
+
+bool QtBluezSdpClient::parseAttributeLists(QByteArrayView data,
+                                           QList<QBluetoothServiceInfo> *services)
+{
+    using Private = QBluetoothServiceInfoPrivate;
+
+    if (data.isEmpty())
+        return true;
+
+    // a sequence of records, each a sequence of attribute id and value pairs
+    Private::DataElement lists;
+    if (!Private::takeDataElement(&data, &lists) || lists.type != Private::SequenceType
+            || !data.isEmpty()) {
+        return false;
+    }
+
+    return parseRecords(lists.content, services);
+}
+
+bool QtBluezSdpClient::parseRecords(QByteArrayView data, QList<QBluetoothServiceInfo> *services)
+{
+    using Private = QBluetoothServiceInfoPrivate;
+
+    while (!data.isEmpty()) {
+        Private::DataElement record;
+        if (!Private::takeDataElement(&data, &record) || record.type != Private::SequenceType)
+            return false;
+
+        // the values are only decoded when the application asks for them
+        QBluetoothServiceInfo serviceInfo;
+        if (!Private::setEncodedAttributes(&serviceInfo, record.content))
+            return false;
+        services->append(serviceInfo);
+    }
+
+    return true;
+}
+
+QT_END_NAMESPACE
+
+#include "moc_sdpclient_p.cpp"
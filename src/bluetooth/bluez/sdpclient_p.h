@@ -0,0 +1,99 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef SDPCLIENT_P_H
+#define SDPCLIENT_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qobject.h>
+
+#include <QtBluetooth/qbluetoothaddress.h>
+#include <QtBluetooth/qbluetoothserviceinfo.h>
+#include <QtBluetooth/qbluetoothuuid.h>
+
+QT_BEGIN_NAMESPACE
+
+class QSocketNotifier;
+class QTimer;
+
+/*
+ * Queries the SDP server of a remote device over an L2CAP connection to PSM 1,
+ * without involving libbluetooth. Every search pattern is sent as a separate
+ * ServiceSearchAttributeRequest asking for all attributes, the results of all
+ * searches are reported together once the last one is answered.
+ *
+ * One client can be reused for any number of devices, one after the other.
+ * Several clients may query different devices at the same time.
+ */
+class QtBluezSdpClient : public QObject
+{
+    Q_OBJECT
+public:
+    // Whether the in-process client is used, see QT_BLUETOOTH_USE_SDPSCANNER.
+    static bool isEnabled();
+
+    explicit QtBluezSdpClient(QObject *parent = nullptr);
+    ~QtBluezSdpClient();
+
+    // An empty uuid list searches the public browse group. Errors are reported
+    // from the event loop, never from within start().
+    void start(const QBluetoothAddress &remoteAddress, const QBluetoothAddress &localAddress,
+               const QList<QBluetoothUuid> &uuids);
+    // Aborts the current query without emitting any signal.
+    void stop();
+    bool isActive() const;
+    QBluetoothAddress remoteAddress() const { return remote; }
+
+    // Parses the AttributeLists of a ServiceSearchAttributeResponse.
+    static bool parseAttributeLists(QByteArrayView data, QList<QBluetoothServiceInfo> *services);
+    // Parses consecutive records, each a sequence of attribute id and value pairs.
+    static bool parseRecords(QByteArrayView data, QList<QBluetoothServiceInfo> *services);
+
+signals:
+    void finished(const QList<QBluetoothServiceInfo> &services);
+    void errorOccurred(const QString &errorString);
+
+private slots:
+    void connected();
+    void readResponse();
+    void responseTimedOut();
+
+private:
+    void connectSocket();
+    void sendRequest();
+    void fail(const QString &errorString);
+    void closeSocket();
+
+    QBluetoothAddress remote;
+    QBluetoothAddress local;
+    // search patterns that still have to be sent, the current one comes first
+    QList<QBluetoothUuid> pendingUuids;
+    QList<QBluetoothServiceInfo> services;
+    // the attribute lists of the current search are collected across continuations
+    QByteArray attributeLists;
+    QByteArray continuationState;
+
+    int socket = -1;
+    bool connectRetried = false;
+    quint16 transactionId = 0;
+    QSocketNotifier *readNotifier = nullptr;
+    QSocketNotifier *connectNotifier = nullptr;
+    QTimer *connectTimer = nullptr;
+    QTimer *responseTimer = nullptr;
+};
+
+QT_END_NAMESPACE
+
+#endif // SDPCLIENT_P_H
@@ -0,0 +1,257 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "socketreader_p.h"
+
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qsocketnotifier.h>
+#include <QtCore/qthread.h>
+#include <QtCore/private/qcore_unix_p.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+// bytes taken from the socket per read notification before yielding to the event loop
+static constexpr qint64 maxReadPerNotification = 256 * 1024;
+static constexpr qint64 defaultChunkSize = 16 * 1024;
+
+namespace {
+struct ReadThread
+{
+    ReadThread()
+    {
+        thread.setObjectName(QStringLiteral("QtBluetoothSocketRead"));
+        thread.start(QThread::HighPriority);
+    }
+    ~ReadThread()
+    {
+        thread.quit();
+        thread.wait();
+    }
+
+    QThread thread;
+};
+}
+
+Q_GLOBAL_STATIC(ReadThread, readThread)
+
+qint64 qt_bluezReadWithTimestamp(int fd, char *data, qint64 maxSize, qint64 *timestamp)
+{
+    if (!timestamp)
+        return qt_safe_read(fd, data, maxSize);
+
+    iovec vector;
+    vector.iov_base = data;
+    vector.iov_len = size_t(maxSize);
+    union {
+        cmsghdr header;
+        char buffer[CMSG_SPACE(sizeof(timeval))];
+    } control;
+
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    qint64 result;
+    EINTR_LOOP(result, ::recvmsg(fd, &message, 0));
+
+    *timestamp = 0;
+    if (result > 0) {
+        for (cmsghdr *header = CMSG_FIRSTHDR(&message); header;
+             header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_TIMESTAMP) {
+                timeval time;
+                memcpy(&time, CMSG_DATA(header), sizeof(time));
+                *timestamp = qint64(time.tv_sec) * 1000000 + time.tv_usec;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+bool QtBluezSocketReader::isEnabled()
+{
+    static const bool enabled = qEnvironmentVariableIntValue("QT_BLUETOOTH_SOCKET_READ_THREAD") > 0;
+    return enabled;
+}
+
+QtBluezSocketReader::QtBluezSocketReader(int socketDescriptor, const Options &options)
+    : socketDescriptor(socketDescriptor), options(options), ownerThread(QThread::currentThread())
+{
+    if (!options.dedicatedThread) {
+        moveToThread(&readThread()->thread);
+        return;
+    }
+
+    dedicatedThread = std::make_unique<QThread>();
+    dedicatedThread->setObjectName(QStringLiteral("QtBluetoothSocketRead %1").arg(socketDescriptor));
+    // real-time priorities need privileges, QThread falls back to the default then
+    dedicatedThread->start(options.priority);
+    moveToThread(dedicatedThread.get());
+}
+
+QtBluezSocketReader::~QtBluezSocketReader()
+{
+    delete notifier;
+    if (dedicatedThread) {
+        dedicatedThread->quit();
+        dedicatedThread->wait();
+    }
+}
+
+void QtBluezSocketReader::start()
+{
+    QMetaObject::invokeMethod(this, [this]() {
+        notifier = new QSocketNotifier(socketDescriptor, QSocketNotifier::Read, this);
+        connect(notifier, &QSocketNotifier::activated, this, &QtBluezSocketReader::readSocket);
+    }, Qt::QueuedConnection);
+}
+
+void QtBluezSocketReader::stop()
+{
+    const auto removeNotifier = [this]() {
+        delete notifier;
+        notifier = nullptr;
+    };
+
+    if (dedicatedThread) {
+        // hand the reader back, so that the owner can delete it once the thread is gone
+        QMetaObject::invokeMethod(this, [this, removeNotifier]() {
+            removeNotifier();
+            moveToThread(ownerThread);
+        }, Qt::BlockingQueuedConnection);
+        dedicatedThread->quit();
+        dedicatedThread->wait();
+        return;
+    }
+
+    // the thread is gone during application shutdown, nothing reads anymore then
+    if (readThread.isDestroyed() || !readThread()->thread.isRunning())
+        removeNotifier();
+    else
+        QMetaObject::invokeMethod(this, removeNotifier, Qt::BlockingQueuedConnection);
+}
+
+bool QtBluezSocketReader::isFull() const
+{
+    return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) == capacity;
+}
+
+bool QtBluezSocketReader::takeChunk(QByteArray *chunk, qint64 *timestamp)
+{
+    const quint32 current = head.load(std::memory_order_relaxed);
+    if (current == tail.load(std::memory_order_acquire))
+        return false;
+
+    *chunk = std::move(chunks[current % capacity]);
+    if (timestamp)
+        *timestamp = timestamps[current % capacity];
+    head.store(current + 1, std::memory_order_release);
+    return true;
+}
+
+void QtBluezSocketReader::resumeIfStalled()
+{
+    if (stalled.exchange(false, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, [this]() {
+            if (notifier)
+                notifier->setEnabled(true);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void QtBluezSocketReader::notifyOwner()
+{
+    if (!notificationPending.exchange(true, std::memory_order_acq_rel))
+        emit dataAvailable();
+}
+
+// The next packet of a busy link usually follows within microseconds, spinning
+// saves the wakeup through the event loop of the reading thread.
+bool QtBluezSocketReader::busyPoll() const
+{
+    const QDeadlineTimer deadline(std::chrono::microseconds(options.busyPollMicroseconds),
+                                  Qt::PreciseTimer);
+    pollfd descriptor = { socketDescriptor, POLLIN, 0 };
+    do {
+        if (::poll(&descriptor, 1, 0) > 0)
+            return true;
+    } while (!deadline.hasExpired());
+    return false;
+}
+
+void QtBluezSocketReader::readSocket()
+{
+    qint64 readTotal = 0;
+    while (readTotal < maxReadPerNotification) {
+        if (isFull()) {
+            notifier->setEnabled(false);
+            stalled.store(true, std::memory_order_release);
+            // the owner might have drained the queue before it could see the stall
+            if (isFull() || !stalled.exchange(false, std::memory_order_acq_rel))
+                break;
+            notifier->setEnabled(true);
+        }
+
+        // FIONREAD reports the size of the next L2CAP packet, or all queued
+        // RFCOMM data, which lets each chunk be allocated at its final size
+        int available = 0;
+        if (::ioctl(socketDescriptor, FIONREAD, &available) < 0 || available <= 0)
+            available = defaultChunkSize;
+
+        QByteArray chunk(available, Qt::Uninitialized);
+        qint64 timestamp = 0;
+        const qint64 readFromDevice = qt_bluezReadWithTimestamp(
+                    socketDescriptor, chunk.data(), chunk.size(),
+                    timestampsEnabled.load(std::memory_order_relaxed) ? &timestamp : nullptr);
+        if (readFromDevice < 0 && errno == EAGAIN) {
+            if (options.busyPollMicroseconds <= 0)
+                break;
+            // the owner must not wait for the end of the polling
+            if (readTotal > 0)
+                notifyOwner();
+            if (!busyPoll())
+                break;
+            continue;
+        }
+
+        if (readFromDevice <= 0) {
+            // a read of 0 bytes means the remote device closed the connection
+            readError = readFromDevice < 0 ? errno : ECONNRESET;
+            finished.store(true, std::memory_order_release);
+            notifier->setEnabled(false);
+            qCDebug(QT_BT_BLUEZ) << "Socket read thread stops reading" << socketDescriptor
+                                 << qt_error_string(readError);
+            break;
+        }
+
+        chunk.truncate(readFromDevice);
+        if (options.packetHandler)
+            options.packetHandler(chunk, timestamp);
+        const quint32 current = tail.load(std::memory_order_relaxed);
+        chunks[current % capacity] = std::move(chunk);
+        timestamps[current % capacity] = timestamp;
+        tail.store(current + 1, std::memory_order_release);
+        readTotal += readFromDevice;
+    }
+
+    if (readTotal > 0 || hasFinished())
+        notifyOwner();
+}
+
+QT_END_NAMESPACE
+
+#include "moc_socketreader_p.cpp"
@@ -0,0 +1,124 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef SOCKETREADER_P_H
+#define SOCKETREADER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qthread.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+class QSocketNotifier;
+
+// Reads from \a fd like read(). If \a timestamp is set, the kernel receive time of
+// the data in microseconds since the Unix epoch is stored in it, see SO_TIMESTAMP.
+// It is 0 if the kernel does not report one.
+qint64 qt_bluezReadWithTimestamp(int fd, char *data, qint64 maxSize, qint64 *timestamp);
+
+/*
+ * Reads a Bluetooth socket on a thread shared by all readers and hands the
+ * data to the thread owning the socket through a single-producer,
+ * single-consumer queue of chunks. The owner never blocks on the reading
+ * thread, except in stop().
+ *
+ * Once the queue is full the reader stops taking data from the socket until
+ * the owner drained it, so that the kernel's flow control remains in effect.
+ *
+ * A reader with a dedicated thread serves only its own socket, optionally
+ * polls it for a while after it ran dry and can hand every chunk to a
+ * handler right on the reading thread, ahead of the queue.
+ */
+class QtBluezSocketReader : public QObject
+{
+    Q_OBJECT
+public:
+    // Whether sockets are read on the shared thread, see QT_BLUETOOTH_SOCKET_READ_THREAD.
+    static bool isEnabled();
+
+    // Called on the reading thread with every chunk before it is queued.
+    using PacketHandler = std::function<void(const QByteArray &chunk, qint64 timestamp)>;
+
+    struct Options
+    {
+        // read on a thread of its own rather than on the shared one
+        bool dedicatedThread = false;
+        QThread::Priority priority = QThread::TimeCriticalPriority;
+        // how long a dedicated thread keeps reading a socket that ran dry
+        int busyPollMicroseconds = 0;
+        PacketHandler packetHandler;
+    };
+
+    explicit QtBluezSocketReader(int socketDescriptor, const Options &options = {});
+    ~QtBluezSocketReader();
+
+    // Called by the owning thread.
+    void start();
+    // Returns once the socket descriptor is no longer used by the reading thread.
+    void stop();
+
+    // Consumer side, called by the owning thread after dataAvailable().
+    void acknowledge() { notificationPending.store(false, std::memory_order_release); }
+    bool takeChunk(QByteArray *chunk, qint64 *timestamp = nullptr);
+    void resumeIfStalled();
+    bool hasFinished() const { return finished.load(std::memory_order_acquire); }
+    int error() const { return readError; }
+    // Whether the receive time of every chunk is taken, see qt_bluezReadWithTimestamp().
+    void setTimestampsEnabled(bool enabled)
+    {
+        timestampsEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+signals:
+    // Emitted on the reading thread, once until acknowledge() is called.
+    void dataAvailable();
+
+private slots:
+    void readSocket();
+
+private:
+    bool isFull() const;
+    bool busyPoll() const;
+    void notifyOwner();
+
+    static constexpr quint32 capacity = 64;
+
+    const int socketDescriptor;
+    const Options options;
+    QSocketNotifier *notifier = nullptr;
+    QThread *ownerThread = nullptr;
+    std::unique_ptr<QThread> dedicatedThread;
+
+    QByteArray chunks[capacity];
+    qint64 timestamps[capacity] = {};
+    // head is written by the consumer only, tail by the producer only
+    std::atomic<quint32> head = 0;
+    std::atomic<quint32> tail = 0;
+
+    std::atomic<bool> stalled = false;
+    std::atomic<bool> notificationPending = false;
+    std::atomic<bool> finished = false;
+    std::atomic<bool> timestampsEnabled = false;
+    // published by finished
+    int readError = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // SOCKETREADER_P_H
@@ -10,6 +10,7 @@
 #include <QtCore/qloggingcategory.h>
 #include <QtCore/qdebug.h>
 #include <QtCore/qmap.h>
+#include <QtCore/qset.h>
 
 #include <algorithm>
 #include <vector>
@@ -109,6 +110,7 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
 {
 @private
     CBCentralManager *manager;
+    dispatch_queue_t queue;
     DarwinBluetooth::CentralManagerState managerState;
     bool disconnectPending;
 
@@ -128,6 +130,19 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
 
     QMap<QBluetoothUuid, DiscoveryMode> servicesToDiscoverDetails;
 
+    // CoreBluetooth keeps the attribute tree of 'peripheral' over reconnects,
+    // until didModifyServices reports a change. Unless the cache policy is
+    // 'Uncached', we reuse what we discovered instead of discovering again.
+    QLowEnergyController::GattCachePolicy cachePolicy;
+    bool servicesDiscovered;
+    bool servicesDiscoveryFailed;
+    QList<QBluetoothUuid> discoveredServiceFilter;
+    QMap<QBluetoothUuid, DiscoveryMode> discoveredDetails;
+    // Services being discovered with their characteristics and descriptors
+    // reused, only their values are read:
+    QSet<QBluetoothUuid> reusedDetails;
+    QSet<QBluetoothUuid> failedDetails;
+
     DarwinBluetooth::ServiceHash serviceMap;
     DarwinBluetooth::CharHash charMap;
     DarwinBluetooth::DescHash descMap;
@@ -135,6 +150,9 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
     QLowEnergyHandle lastValidHandle;
 
     bool requestPending;
+    // A Write Without Response waits at the head of 'requests'
+    // for peripheralIsReadyToSendWriteWithoutResponse.
+    bool writeWithoutResponseBlocked;
     DarwinBluetooth::RequestQueue requests;
     QLowEnergyHandle currentReadHandle;
 
@@ -148,11 +166,16 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
 }
 
 - (id)initWith:(DarwinBluetooth::LECBManagerNotifier *)aNotifier
+         queue:(dispatch_queue_t)aQueue
 {
     using namespace DarwinBluetooth;
 
+    Q_ASSERT(aQueue);
+
     if (self = [super init]) {
         manager = nil;
+        queue = aQueue;
+        dispatch_retain(queue);
         managerState = CentralManagerIdle;
         disconnectPending = false;
         peripheral = nil;
@@ -160,7 +183,11 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
         currentService = 0;
         lastValidHandle = 0;
         requestPending = false;
+        writeWithoutResponseBlocked = false;
         currentReadHandle = 0;
+        cachePolicy = QLowEnergyController::GattCachePolicy::PlatformDefault;
+        servicesDiscovered = false;
+        servicesDiscoveryFailed = false;
 
         if (Q_UNLIKELY(!qEnvironmentVariableIsEmpty("BLUETOOTH_GATT_TIMEOUT"))) {
             bool ok = false;
@@ -199,6 +226,7 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
         notifier->deleteLater();
 
     [self stopWatchers];
+    dispatch_release(queue);
     [super dealloc];
 }
 
@@ -211,7 +239,8 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
 {
     using namespace DarwinBluetooth;
 
-    GCDTimer newWatcher([[GCDTimerObjC alloc] initWithDelegate:self], RetainPolicy::noInitialRetain);
+    GCDTimer newWatcher([[GCDTimerObjC alloc] initWithDelegate:self queue:queue],
+                        RetainPolicy::noInitialRetain);
     [newWatcher watchAfter:object withTimeoutType:type];
     timeoutWatchdogs.push_back(newWatcher);
     [newWatcher startWithTimeout:timeoutMS step:200];
@@ -295,10 +324,8 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
     if (!manager) {
         // The first time we try to connect, no manager created yet,
         // no status update received.
-        if (const dispatch_queue_t leQueue = DarwinBluetooth::qt_LE_queue()) {
-            managerState = DarwinBluetooth::CentralManagerUpdating;
-            manager = [[CBCentralManager alloc] initWithDelegate:self queue:leQueue];
-        }
+        managerState = DarwinBluetooth::CentralManagerUpdating;
+        manager = [[CBCentralManager alloc] initWithDelegate:self queue:queue];
 
         if (!manager) {
             managerState = DarwinBluetooth::CentralManagerIdle;
@@ -426,24 +453,54 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
     }
 }
 
-- (void)discoverServices
+- (void)setGattCachePolicy:(QLowEnergyController::GattCachePolicy)policy
+{
+    cachePolicy = policy;
+}
+
+- (void)discoverServices:(const QT_PREPEND_NAMESPACE(QList)<QT_PREPEND_NAMESPACE(QBluetoothUuid)> &)serviceUuids
 {
     using namespace DarwinBluetooth;
 
     Q_ASSERT_X(peripheral, Q_FUNC_INFO, "invalid peripheral (nil)");
     Q_ASSERT_X(managerState == CentralManagerIdle, Q_FUNC_INFO, "invalid state");
 
+    QT_BT_MAC_AUTORELEASEPOOL;
+
+    if (servicesDiscovered && cachePolicy != QLowEnergyController::GattCachePolicy::Uncached
+        && discoveredServiceFilter == serviceUuids && peripheral.services) {
+        // The same peripheral object after a reconnect, its services
+        // (and the included services) are still valid.
+        qCDebug(QT_BT_DARWIN) << "reusing the services discovered previously";
+        [peripheral setDelegate:self];
+        if (notifier)
+            emit notifier->serviceDiscoveryFinished();
+        return;
+    }
+
+    servicesDiscovered = false;
+    servicesDiscoveryFailed = false;
+    discoveredServiceFilter = serviceUuids;
+    discoveredDetails.clear();
+
     // From Apple's docs:
     //
     //"If the servicesUUIDs parameter is nil, all the available
     //services of the peripheral are returned; setting the
     //parameter to nil is considerably slower and is not recommended."
     //
-    // ... but we'd like to have them all:
+    // ... so we only pass nil if the user did not ask for specific services:
+    NSMutableArray<CBUUID *> *cbUuids = nil;
+    if (!serviceUuids.isEmpty()) {
+        cbUuids = [NSMutableArray arrayWithCapacity:NSUInteger(serviceUuids.size())];
+        for (const auto &uuid : serviceUuids)
+            [cbUuids addObject:cb_uuid(uuid).data()];
+    }
+
     [peripheral setDelegate:self];
     managerState = CentralManagerDiscovering;
     [self watchAfter:peripheral timeout:OperationTimeout::serviceDiscovery];
-    [peripheral discoverServices:nil];
+    [peripheral discoverServices:cbUuids];
 }
 
 - (void)discoverIncludedServices
@@ -459,6 +516,7 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
     NSArray *const services = peripheral.services;
     if (!services || !services.count) {
         // A peripheral without any services at all.
+        servicesDiscovered = !servicesDiscoveryFailed;
         if (notifier)
             emit notifier->serviceDiscoveryFinished();
     } else {
@@ -500,6 +558,24 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
     if (CBService *const service = [self serviceForUUID:serviceUuid]) {
         const auto mode = read ? DiscoveryMode::FullDiscovery : DiscoveryMode::SkipValueDiscovery;
         servicesToDiscoverDetails[serviceUuid] = mode;
+
+        const auto previous = discoveredDetails.constFind(serviceUuid);
+        if (servicesDiscovered && cachePolicy != QLowEnergyController::GattCachePolicy::Uncached
+            && previous != discoveredDetails.cend()
+            && (mode == DiscoveryMode::SkipValueDiscovery || *previous == DiscoveryMode::FullDiscovery)) {
+            // Characteristics (and descriptors, if we need them) are known already.
+            // CoreBluetooth also keeps the values read or notified last, these are
+            // only reused if the cached attribute data were explicitly requested.
+            if (mode == DiscoveryMode::SkipValueDiscovery
+                || cachePolicy == QLowEnergyController::GattCachePolicy::Cached) {
+                [self serviceDetailsDiscoveryFinished:service];
+            } else {
+                reusedDetails.insert(serviceUuid);
+                [self readCharacteristics:service];
+            }
+            return;
+        }
+
         [self watchAfter:service timeout:OperationTimeout::characteristicsDiscovery];
         [peripheral discoverCharacteristics:nil forService:service];
         return;
@@ -558,6 +634,9 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
 
     if (!service.characteristics || !service.characteristics.count) {
         [self serviceDetailsDiscoveryFinished:service];
+    } else if (reusedDetails.contains(qt_uuid(service.UUID))) {
+        // The descriptors were discovered before, only read them.
+        [self readDescriptors:service];
     } else {
         // Start from 0 and continue in the callback.
         CBCharacteristic *ch = [service.characteristics objectAtIndex:0];
@@ -600,8 +679,14 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
     QT_BT_MAC_AUTORELEASEPOOL;
 
     const QBluetoothUuid serviceUuid(qt_uuid(service.UUID));
-    const bool skipValues = servicesToDiscoverDetails[serviceUuid] == DiscoveryMode::SkipValueDiscovery;
+    const auto mode = servicesToDiscoverDetails.value(serviceUuid, DiscoveryMode::FullDiscovery);
+    const bool skipValues = mode == DiscoveryMode::SkipValueDiscovery;
     servicesToDiscoverDetails.remove(serviceUuid);
+    reusedDetails.remove(serviceUuid);
+    if (failedDetails.remove(serviceUuid))
+        discoveredDetails.remove(serviceUuid);
+    else if (!discoveredDetails.contains(serviceUuid) || !skipValues)
+        discoveredDetails[serviceUuid] = mode;
 
     const NSUInteger nHandles = qt_countGATTEntries(service);
     Q_ASSERT_X(nHandles, Q_FUNC_INFO, "unexpected number of GATT entires");
@@ -683,7 +768,7 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
 {
     using namespace DarwinBluetooth;
 
-    if (requestPending || !requests.size())
+    if (requestPending || writeWithoutResponseBlocked || !requests.size())
         return;
 
     switch (requests.head().type) {
@@ -797,6 +882,14 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
             requestPending = true;
             [peripheral setNotifyValue:enable forCharacteristic:characteristic];
         } else {
+            if (!request.withResponse && !peripheral.canSendWriteWithoutResponse) {
+                // Core Bluetooth silently drops commands while its transmit
+                // queue is full, the request is retried once there is room.
+                requests.prepend(request);
+                writeWithoutResponseBlocked = true;
+                return;
+            }
+
             ObjCStrongReference<NSData> data(data_from_bytearray(request.value));
             if (!data) {
                 // Even if qtData.size() == 0, we still need NSData object.
@@ -1196,9 +1289,12 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
 - (void)reset
 {
     requestPending = false;
+    writeWithoutResponseBlocked = false;
     valuesToWrite.clear();
     requests.clear();
     servicesToDiscoverDetails.clear();
+    reusedDetails.clear();
+    failedDetails.clear();
     lastValidHandle = 0;
     serviceMap.clear();
     charMap.clear();
@@ -1366,6 +1462,7 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
 
     if (error) {
         NSLog(@"%s failed with error %@", Q_FUNC_INFO, error);
+        servicesDiscoveryFailed = true;
         // TODO: better error mapping required.
         if (notifier)
             emit notifier->CBManagerError(QLowEnergyController::UnknownError);
@@ -1394,6 +1491,8 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
     // we stop all current operations here, report to QLowEnergyController
     // so that it can trigger re-discovery.
     [self reset];
+    servicesDiscovered = false;
+    discoveredDetails.clear();
     managerState = DarwinBluetooth::CentralManagerIdle;
     if (notifier)
         emit notifier->servicesWereModified();
@@ -1471,6 +1570,7 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
     servicesToVisit.reset();
     servicesToVisitNext.reset();
 
+    servicesDiscovered = !servicesDiscoveryFailed;
     if (notifier)
         emit notifier->serviceDiscoveryFinished();
 }
@@ -1503,6 +1603,7 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
 
     if (error) {
         NSLog(@"%s failed with error: %@", Q_FUNC_INFO, error);
+        failedDetails.insert(qtUuid);
         // We did not discover any characteristics and can not discover descriptors,
         // inform our delegate (it will set a service state also).
         emit notifier->CBManagerError(qtUuid, QLowEnergyController::UnknownError);
@@ -1590,7 +1691,7 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
             emit notifier->characteristicRead(chHandle, qt_bytearray(characteristic.value));
             [self performNextRequest];
         } else {
-            emit notifier->characteristicUpdated(chHandle, qt_bytearray(characteristic.value));
+            notifier->queueCharacteristicUpdate(chHandle, qt_bytearray(characteristic.value));
         }
     }
 }
@@ -1619,7 +1720,8 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
 
     if (error) {
         NSLog(@"%s failed with error %@", Q_FUNC_INFO, error);
-        // We can continue though ...
+        // We can continue though, but not reuse these descriptors later.
+        failedDetails.insert(qt_uuid(characteristic.service.UUID));
     }
 
     // Do we have more characteristics on this service to discover descriptors?
@@ -1836,6 +1938,17 @@ using DiscoveryMode = QLowEnergyService::DiscoveryMode;
     [self performNextRequest];
 }
 
+- (void)peripheralIsReadyToSendWriteWithoutResponse:(CBPeripheral *)aPeripheral
+{
+    Q_UNUSED(aPeripheral);
+
+    if (!writeWithoutResponseBlocked)
+        return;
+
+    writeWithoutResponseBlocked = false;
+    [self performNextRequest];
+}
+
 - (void)detach
 {
     if (notifier) {
@@ -25,6 +25,7 @@
 #include <QtCore/qglobal.h>
 #include <QtCore/qqueue.h>
 #include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
 
 #include <Foundation/Foundation.h>
 
@@ -99,18 +100,21 @@ QT_END_NAMESPACE
 @interface QT_MANGLE_NAMESPACE(DarwinBTCentralManager) : NSObject<CBCentralManagerDelegate,
                                                                   CBPeripheralDelegate,
                                                                   QT_MANGLE_NAMESPACE(GCDTimerDelegate)>
-- (id)initWith:(QT_PREPEND_NAMESPACE(DarwinBluetooth)::LECBManagerNotifier *)notifier;
+- (id)initWith:(QT_PREPEND_NAMESPACE(DarwinBluetooth)::LECBManagerNotifier *)notifier
+         queue:(dispatch_queue_t)queue;
 - (void)dealloc;
 
 - (CBPeripheral *)peripheral;
 
-// IMPORTANT: _all_ these methods are to be executed on qt_LE_queue,
+// IMPORTANT: _all_ these methods are to be executed on the queue passed to init,
 // when passing parameters - C++ objects _must_ be copied (see the controller's code).
 - (void)connectToDevice:(const QT_PREPEND_NAMESPACE(QBluetoothUuid) &)aDeviceUuid;
 
 - (void)disconnectFromDevice;
 
-- (void)discoverServices;
+// Must be set before discoverServices/discoverServiceDetails.
+- (void)setGattCachePolicy:(QT_PREPEND_NAMESPACE(QLowEnergyController)::GattCachePolicy)policy;
+- (void)discoverServices:(const QT_PREPEND_NAMESPACE(QList)<QT_PREPEND_NAMESPACE(QBluetoothUuid)> &)serviceUuids;
 - (void)discoverServiceDetails:(const QT_PREPEND_NAMESPACE(QBluetoothUuid) &)serviceUuid
         readValues:(bool)read;
 
@@ -22,14 +22,20 @@ using namespace DarwinBluetooth;
 
     QElapsedTimer timer;
     id<QT_MANGLE_NAMESPACE(GCDTimerDelegate)> timeoutHandler;
+    dispatch_queue_t queue;
 
     bool cancelled;
 }
 
 - (instancetype)initWithDelegate:(id<QT_MANGLE_NAMESPACE(GCDTimerDelegate)>)delegate
+                           queue:(dispatch_queue_t)aQueue
 {
+    Q_ASSERT(aQueue);
+
     if (self = [super init]) {
         timeoutHandler = delegate;
+        queue = aQueue;
+        dispatch_retain(queue);
         timeoutMS = 0;
         timeoutStepMS = 0;
         objectUnderWatch = nil;
@@ -39,6 +45,12 @@ using namespace DarwinBluetooth;
     return self;
 }
 
+- (void)dealloc
+{
+    dispatch_release(queue);
+    [super dealloc];
+}
+
 - (void)watchAfter:(id)object withTimeoutType:(OperationTimeout)type
 {
     objectUnderWatch = object;
@@ -77,12 +89,10 @@ using namespace DarwinBluetooth;
         [timeoutHandler timeout:self];
     } else {
         // Re-schedule:
-        dispatch_queue_t leQueue(qt_LE_queue());
-        Q_ASSERT(leQueue);
         const qint64 timeChunkMS = std::min(timeoutMS - elapsed, timeoutStepMS);
         dispatch_after(dispatch_time(DISPATCH_TIME_NOW,
                                      int64_t(timeChunkMS / 1000. * NSEC_PER_SEC)),
-                                     leQueue,
+                                     queue,
                                      ^{
                                            [self handleTimeout];
                                       });
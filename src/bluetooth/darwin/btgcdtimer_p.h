@@ -48,7 +48,10 @@ QT_END_NAMESPACE
 @end
 
 @interface QT_MANGLE_NAMESPACE(DarwinBTGCDTimer) : NSObject
-- (instancetype)initWithDelegate:(id<QT_MANGLE_NAMESPACE(GCDTimerDelegate)>)delegate;
+// The timeout is reported on queue, the queue the delegate runs on.
+- (instancetype)initWithDelegate:(id<QT_MANGLE_NAMESPACE(GCDTimerDelegate)>)delegate
+                           queue:(dispatch_queue_t)queue;
+- (void)dealloc;
 - (void)watchAfter:(id)object withTimeoutType:(QT_PREPEND_NAMESPACE(DarwinBluetooth)::OperationTimeout)type;
 - (void)startWithTimeout:(qint64)ms step:(qint64)stepMS;
 - (void)handleTimeout;
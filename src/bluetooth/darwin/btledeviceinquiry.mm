@@ -8,8 +8,10 @@
 #include "btutility_p.h"
 
 #include <QtCore/qloggingcategory.h>
+#include <QtCore/qelapsedtimer.h>
 #include <QtCore/qdebug.h>
 #include <QtCore/qendian.h>
+#include <QtCore/qhash.h>
 
 #include <algorithm>
 
@@ -31,6 +33,24 @@ QBluetoothUuid qt_uuid(NSUUID *nsUuid)
 
 const int timeStepMS = 100;
 const int powerOffTimeoutMS = 30000;
+// With duplicates enabled, a peripheral whose advertisement did not change
+// but its RSSI did is reported at most this often.
+const int defaultRssiUpdateIntervalMS = 1000;
+
+// What we reported last for a peripheral, to recognize repeated
+// advertisements before parsing them.
+struct ReportedAdvertisement
+{
+    ObjCStrongReference<NSDictionary> data;
+    ObjCStrongReference<NSString> name;
+    short rssi = 0;
+    qint64 reportedMS = 0;
+};
+
+bool equal_strings(NSString *a, NSString *b)
+{
+    return a == b || (a && b && [a isEqualToString:b]);
+}
 
 struct AdvertisementData {
     // That's what CoreBluetooth has:
@@ -102,21 +122,38 @@ QT_USE_NAMESPACE
 {
     LECBManagerNotifier *notifier;
     ObjCScopedPointer<CBCentralManager> manager;
+    dispatch_queue_t queue;
 
     QList<QBluetoothDeviceInfo> devices;
     LEInquiryState internalState;
     int inquiryTimeoutMS;
+    ObjCStrongReference<NSArray> serviceFilter;
+
+    QHash<QBluetoothUuid, QT_PREPEND_NAMESPACE(DarwinBluetooth)::ReportedAdvertisement> reported;
+    QElapsedTimer scanTimer;
+    int rssiUpdateIntervalMS;
 
     QT_PREPEND_NAMESPACE(DarwinBluetooth)::GCDTimer elapsedTimer;
 }
 
--(id)initWithNotifier:(LECBManagerNotifier *)aNotifier
+-(id)initWithNotifier:(LECBManagerNotifier *)aNotifier queue:(dispatch_queue_t)aQueue
 {
     if (self = [super init]) {
         Q_ASSERT(aNotifier);
+        Q_ASSERT(aQueue);
         notifier = aNotifier;
+        queue = aQueue;
+        dispatch_retain(queue);
         internalState = InquiryStarting;
         inquiryTimeoutMS = DarwinBluetooth::defaultLEScanTimeoutMS;
+
+        rssiUpdateIntervalMS = DarwinBluetooth::defaultRssiUpdateIntervalMS;
+        if (Q_UNLIKELY(!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_SCAN_RSSI_INTERVAL"))) {
+            bool ok = false;
+            const int value = qEnvironmentVariableIntValue("QT_BLUETOOTH_SCAN_RSSI_INTERVAL", &ok);
+            if (ok && value >= 0)
+                rssiUpdateIntervalMS = value;
+        }
     }
 
     return self;
@@ -128,6 +165,7 @@ QT_USE_NAMESPACE
     [manager setDelegate:nil];
     [elapsedTimer cancelTimer];
     [self stopNotifier];
+    dispatch_release(queue);
     [super dealloc];
 }
 
@@ -152,12 +190,26 @@ QT_USE_NAMESPACE
     }
 }
 
-- (void)startWithTimeout:(int)timeout
+- (void)startWithTimeout:(int)timeout serviceUuids:(const QList<QBluetoothUuid> &)serviceUuids
 {
-    dispatch_queue_t leQueue(DarwinBluetooth::qt_LE_queue());
-    Q_ASSERT(leQueue);
+    using namespace DarwinBluetooth;
+
     inquiryTimeoutMS = timeout;
-    manager.reset([[CBCentralManager alloc] initWithDelegate:self queue:leQueue],
+
+    serviceFilter.reset();
+    if (serviceUuids.size()) {
+        NSMutableArray *uuids = [NSMutableArray arrayWithCapacity:serviceUuids.size()];
+        for (const QBluetoothUuid &uuid : serviceUuids) {
+            if (const auto cbUuid = cb_uuid(uuid))
+                [uuids addObject:cbUuid.data()];
+        }
+        serviceFilter.reset(uuids, RetainPolicy::doInitialRetain);
+    }
+
+    reported.clear();
+    scanTimer.start();
+
+    manager.reset([[CBCentralManager alloc] initWithDelegate:self queue:queue],
                   DarwinBluetooth::RetainPolicy::noInitialRetain);
 }
 
@@ -183,18 +235,21 @@ QT_USE_NAMESPACE
 
             if (inquiryTimeoutMS > 0) {
                 [elapsedTimer cancelTimer];
-                elapsedTimer.reset([[GCDTimerObjC alloc] initWithDelegate:self], RetainPolicy::noInitialRetain);
+                elapsedTimer.reset([[GCDTimerObjC alloc] initWithDelegate:self queue:queue],
+                                   RetainPolicy::noInitialRetain);
                 [elapsedTimer startWithTimeout:inquiryTimeoutMS step:timeStepMS];
             }
 
             // ### Qt 6.x: remove the use of env. variable, as soon as a proper public API is in place.
             bool envOk = false;
             const int env = qEnvironmentVariableIntValue("QT_BLUETOOTH_SCAN_ENABLE_DUPLICATES", &envOk);
+            // CoreBluetooth matches the service UUIDs of the advertisements,
+            // with the same semantics as the filter of the other platforms.
             if (envOk && env) {
-                [manager scanForPeripheralsWithServices:nil
+                [manager scanForPeripheralsWithServices:serviceFilter.data()
                  options:@{CBCentralManagerScanOptionAllowDuplicatesKey : @YES}];
             } else {
-                [manager scanForPeripheralsWithServices:nil options:nil];
+                [manager scanForPeripheralsWithServices:serviceFilter.data() options:nil];
             }
         } // Else we ignore.
     } else if (state == CBManagerStateUnsupported) {
@@ -224,7 +279,8 @@ QT_USE_NAMESPACE
             // we'll receive 'PoweredOn' state update later.
             // No change in internalState. Wait for 30 seconds.
             [elapsedTimer cancelTimer];
-            elapsedTimer.reset([[GCDTimerObjC alloc] initWithDelegate:self], RetainPolicy::noInitialRetain);
+            elapsedTimer.reset([[GCDTimerObjC alloc] initWithDelegate:self queue:queue],
+                               RetainPolicy::noInitialRetain);
             [elapsedTimer startWithTimeout:powerOffTimeoutMS step:300];
             return;
         }
@@ -323,6 +379,23 @@ QT_USE_NAMESPACE
         return;
     }
 
+    // With duplicates enabled CoreBluetooth calls us for every advertisement
+    // received. Drop exact repeats and rate-limit those differing in RSSI only
+    // before any parsing, instead of posting them all to the Qt side.
+    const short rssi = RSSI ? [RSSI shortValue] : 0;
+    const qint64 nowMS = scanTimer.elapsed();
+    ReportedAdvertisement &last = reported[deviceUuid];
+    if (last.data && [last.data.data() isEqualToDictionary:advertisementData]
+        && equal_strings(last.name, peripheral.name)) {
+        if (last.rssi == rssi || nowMS - last.reportedMS < rssiUpdateIntervalMS)
+            return;
+    } else {
+        last.data.reset(advertisementData, RetainPolicy::doInitialRetain);
+        last.name.reset(peripheral.name, RetainPolicy::doInitialRetain);
+    }
+    last.rssi = rssi;
+    last.reportedMS = nowMS;
+
     const AdvertisementData qtAdvData(advertisementData);
     QString name(qtAdvData.localName);
     if (!name.size() && peripheral.name)
@@ -331,7 +404,7 @@ QT_USE_NAMESPACE
     // TODO: fix 'classOfDevice' (0 for now).
     QBluetoothDeviceInfo newDeviceInfo(deviceUuid, name, 0);
     if (RSSI)
-        newDeviceInfo.setRssi([RSSI shortValue]);
+        newDeviceInfo.setRssi(rssi);
 
     if (qtAdvData.serviceUuids.size())
         newDeviceInfo.setServiceUuids(qtAdvData.serviceUuids);
@@ -55,12 +55,12 @@ enum LEInquiryState
 };
 
 @interface QT_MANGLE_NAMESPACE(DarwinBTLEDeviceInquiry) : NSObject<CBCentralManagerDelegate, QT_MANGLE_NAMESPACE(GCDTimerDelegate)>
-- (id)initWithNotifier:(LECBManagerNotifier *)aNotifier;
+- (id)initWithNotifier:(LECBManagerNotifier *)aNotifier queue:(dispatch_queue_t)aQueue;
 - (void)dealloc;
 
-// IMPORTANT: both 'startWithTimeout' and 'stop' MUST be executed on the "Qt's
-// LE queue".
-- (void)startWithTimeout:(int)timeout;
+// IMPORTANT: both 'startWithTimeout' and 'stop' MUST be executed on the queue
+// passed to init. An empty 'serviceUuids' scans for all peripherals.
+- (void)startWithTimeout:(int)timeout serviceUuids:(const QList<QBluetoothUuid> &)serviceUuids;
 - (void)stop;
 
 @end
@@ -1 +1,69 @@
 #include "btnotifier_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace DarwinBluetooth {
+
+LECBManagerNotifier::LECBManagerNotifier()
+{
+    // These are emitted on the manager's queue, same as the updates.
+    const auto close = [this] { closeUpdateBatch(); };
+    connect(this, &LECBManagerNotifier::connected, this, close, Qt::DirectConnection);
+    connect(this, &LECBManagerNotifier::disconnected, this, close, Qt::DirectConnection);
+    connect(this, &LECBManagerNotifier::mtuChanged, this, close, Qt::DirectConnection);
+    connect(this, &LECBManagerNotifier::congestionChanged, this, close, Qt::DirectConnection);
+    connect(this, &LECBManagerNotifier::serviceDiscoveryFinished, this, close,
+            Qt::DirectConnection);
+    connect(this, &LECBManagerNotifier::serviceDetailsDiscoveryFinished, this, close,
+            Qt::DirectConnection);
+    connect(this, &LECBManagerNotifier::characteristicRead, this, close, Qt::DirectConnection);
+    connect(this, &LECBManagerNotifier::characteristicWritten, this, close,
+            Qt::DirectConnection);
+    connect(this, &LECBManagerNotifier::descriptorRead, this, close, Qt::DirectConnection);
+    connect(this, &LECBManagerNotifier::descriptorWritten, this, close, Qt::DirectConnection);
+    connect(this, &LECBManagerNotifier::notificationEnabled, this, close,
+            Qt::DirectConnection);
+    connect(this, &LECBManagerNotifier::servicesWereModified, this, close,
+            Qt::DirectConnection);
+
+    using ControllerError = void (LECBManagerNotifier::*)(QLowEnergyController::Error);
+    using ServiceControllerError = void (LECBManagerNotifier::*)(const QBluetoothUuid &,
+                                                                 QLowEnergyController::Error);
+    using ServiceError = void (LECBManagerNotifier::*)(const QBluetoothUuid &,
+                                                       QLowEnergyService::ServiceError);
+    connect(this, ControllerError(&LECBManagerNotifier::CBManagerError), this, close,
+            Qt::DirectConnection);
+    connect(this, ServiceControllerError(&LECBManagerNotifier::CBManagerError), this, close,
+            Qt::DirectConnection);
+    connect(this, ServiceError(&LECBManagerNotifier::CBManagerError), this, close,
+            Qt::DirectConnection);
+}
+
+void LECBManagerNotifier::queueCharacteristicUpdate(QLowEnergyHandle charHandle,
+                                                    const QByteArray &value)
+{
+    if (openBatch) {
+        QMutexLocker locker(&openBatch->mutex);
+        if (!openBatch->delivered) {
+            openBatch->updates.append({charHandle, value});
+            return;
+        }
+    }
+
+    openBatch = std::make_shared<UpdateBatch>();
+    openBatch->updates.append({charHandle, value});
+    QMetaObject::invokeMethod(this, [this, batch = openBatch]() {
+        QList<std::pair<QLowEnergyHandle, QByteArray>> updates;
+        {
+            QMutexLocker locker(&batch->mutex);
+            batch->delivered = true;
+            updates.swap(batch->updates);
+        }
+        for (const auto &update : std::as_const(updates))
+            emit characteristicUpdated(update.first, update.second);
+    }, Qt::QueuedConnection);
+}
+
+} // namespace DarwinBluetooth
+
+QT_END_NAMESPACE
@@ -26,6 +26,11 @@
 #include <QtCore/qbytearray.h>
 #include <QtCore/private/qglobal_p.h>
 #include <QtCore/qobject.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qlist.h>
+
+#include <memory>
+#include <utility>
 
 QT_BEGIN_NAMESPACE
 
@@ -38,6 +43,15 @@ class LECBManagerNotifier : public QObject
 {
     Q_OBJECT
 
+public:
+    LECBManagerNotifier();
+
+    // To be called on the manager's queue instead of emitting characteristicUpdated.
+    // Updates arriving before the notifier's thread gets to them are emitted from
+    // one queued invocation. Any other signal starts a new batch, so the order
+    // of all signals is preserved.
+    void queueCharacteristicUpdate(QLowEnergyHandle charHandle, const QByteArray &value);
+
 Q_SIGNALS:
     void deviceDiscovered(QBluetoothDeviceInfo deviceInfo);
     void discoveryFinished();
@@ -46,6 +60,7 @@ Q_SIGNALS:
     void disconnected();
 
     void mtuChanged(int newValue);
+    void congestionChanged(bool congested);
 
     void serviceDiscoveryFinished();
     void serviceDetailsDiscoveryFinished(QSharedPointer<QLowEnergyServicePrivate> service);
@@ -62,6 +77,19 @@ Q_SIGNALS:
     void CBManagerError(QLowEnergyController::Error error);
     void CBManagerError(const QBluetoothUuid &serviceUuid, QLowEnergyController::Error error);
     void CBManagerError(const QBluetoothUuid &serviceUuid, QLowEnergyService::ServiceError error);
+
+private:
+    struct UpdateBatch
+    {
+        QMutex mutex;
+        QList<std::pair<QLowEnergyHandle, QByteArray>> updates;
+        bool delivered = false;
+    };
+
+    void closeUpdateBatch() { openBatch.reset(); }
+
+    // Only accessed on the manager's queue.
+    std::shared_ptr<UpdateBatch> openBatch;
 };
 
 } // namespace DarwinBluetooth
@@ -143,6 +143,7 @@ bool qt_validate_value_range(const QLowEnergyCharacteristicData &data)
 @implementation QT_MANGLE_NAMESPACE(DarwinBTPeripheralManager)
 {
     ObjCScopedPointer<CBPeripheralManager> manager;
+    dispatch_queue_t queue;
     LECBManagerNotifier *notifier;
 
     QLowEnergyHandle lastHandle;
@@ -161,21 +162,31 @@ bool qt_validate_value_range(const QLowEnergyCharacteristicData &data)
 
     QMap<QLowEnergyHandle, ValueRange> valueRanges;
 
-    std::deque<UpdateRequest> updateQueue;
+    // The latest value not sent yet of each characteristic, in the order the
+    // characteristics were first updated. A newer value replaces a pending one,
+    // while CoreBluetooth's transmit queue is full there's no point in sending
+    // values the central would only see after a newer one was set.
+    std::deque<QLowEnergyHandle> updateOrder;
+    GenericLEMap<ObjCStrongReference<NSData>> pendingUpdates;
+    bool congested;
 
     PeripheralState state;
     NSUInteger maxNotificationValueLength;
     decltype(services.size()) nOfFailedAds;
 }
 
-- (id)initWith:(LECBManagerNotifier *)aNotifier
+- (id)initWith:(LECBManagerNotifier *)aNotifier queue:(dispatch_queue_t)aQueue
 {
     if (self = [super init]) {
         Q_ASSERT(aNotifier);
+        Q_ASSERT(aQueue);
         notifier = aNotifier;
+        queue = aQueue;
+        dispatch_retain(queue);
         state = PeripheralState::idle;
         nextServiceToAdd = {};
         maxNotificationValueLength = std::numeric_limits<NSUInteger>::max();
+        congested = false;
     }
 
     return self;
@@ -184,6 +195,7 @@ bool qt_validate_value_range(const QLowEnergyCharacteristicData &data)
 - (void)dealloc
 {
     [self detach];
+    dispatch_release(queue);
     [super dealloc];
 }
 
@@ -307,7 +319,7 @@ bool qt_validate_value_range(const QLowEnergyCharacteristicData &data)
     if (manager)
         [manager setDelegate:nil];
     manager.reset([[CBPeripheralManager alloc] initWithDelegate:self
-                   queue:DarwinBluetooth::qt_LE_queue()],
+                   queue:queue],
                    DarwinBluetooth::RetainPolicy::noInitialRetain);
 }
 
@@ -366,7 +378,7 @@ bool qt_validate_value_range(const QLowEnergyCharacteristicData &data)
     // by the time we're allowed to actually send them, the data can change again
     // and we'll send an 'out of order' value.
     const ObjCStrongReference<NSData> copy([NSData dataWithData:nsData], RetainPolicy::doInitialRetain);
-    updateQueue.push_back(UpdateRequest{charHandle, copy});
+    [self queueUpdate:copy forCharacteristic:charHandle];
     [self sendUpdateRequests];
 }
 
@@ -594,10 +606,10 @@ bool qt_validate_value_range(const QLowEnergyCharacteristicData &data)
         const auto handle = pair.first;
         NSMutableData *value = charValues[handle];
         value.length = pair.second;
-        emit notifier->characteristicUpdated(handle, qt_bytearray(value));
+        notifier->queueCharacteristicUpdate(handle, qt_bytearray(value));
         const ObjCStrongReference<NSData> copy([NSData dataWithData:value],
                                                RetainPolicy::doInitialRetain);
-        updateQueue.push_back(UpdateRequest{handle, copy});
+        [self queueUpdate:copy forCharacteristic:handle];
     }
 
     if (requests.count) {
@@ -618,28 +630,48 @@ bool qt_validate_value_range(const QLowEnergyCharacteristicData &data)
     [self sendUpdateRequests];
 }
 
+- (void)queueUpdate:(const ObjCStrongReference<NSData> &)value
+        forCharacteristic:(QLowEnergyHandle)charHandle
+{
+    if (!pendingUpdates.contains(charHandle))
+        updateOrder.push_back(charHandle);
+    pendingUpdates[charHandle] = value;
+}
+
 - (void)sendUpdateRequests
 {
     QT_BT_MAC_AUTORELEASEPOOL
 
-    while (updateQueue.size()) {
-        const auto &request = updateQueue.front();
-        if (charMap.contains(request.charHandle)) {
-            if (maxNotificationValueLength < [request.value length]) {
-                qCWarning(QT_BT_DARWIN) << "value of length" << [request.value length]
+    while (updateOrder.size()) {
+        const QLowEnergyHandle charHandle = updateOrder.front();
+        if (charMap.contains(charHandle)) {
+            NSData *value = pendingUpdates[charHandle];
+            if (maxNotificationValueLength < [value length]) {
+                qCWarning(QT_BT_DARWIN) << "value of length" << [value length]
                                         << "will possibly be truncated to"
                                         << maxNotificationValueLength;
             }
-            const BOOL res = [manager updateValue:request.value
-                              forCharacteristic:static_cast<CBMutableCharacteristic *>(charMap[request.charHandle])
+            const BOOL res = [manager updateValue:value
+                              forCharacteristic:static_cast<CBMutableCharacteristic *>(charMap[charHandle])
                               onSubscribedCentrals:nil];
             if (!res) {
-                // Have to wait for the 'ManagerIsReadyToUpdate'.
-                break;
+                // Have to wait for the 'ManagerIsReadyToUpdate', newer values
+                // replace the pending ones meanwhile.
+                if (!congested && notifier) {
+                    congested = true;
+                    emit notifier->congestionChanged(true);
+                }
+                return;
             }
         }
 
-        updateQueue.pop_front();
+        pendingUpdates.remove(charHandle);
+        updateOrder.pop_front();
+    }
+
+    if (congested && notifier) {
+        congested = false;
+        emit notifier->congestionChanged(false);
     }
 }
 
@@ -70,24 +70,11 @@ enum class PeripheralState
     connected
 };
 
-struct UpdateRequest
-{
-    UpdateRequest() = default;
-    UpdateRequest(QLowEnergyHandle handle, const ObjCStrongReference<NSData> &val)
-        : charHandle(handle),
-          value(val)
-    {
-    }
-
-    QLowEnergyHandle charHandle = {};
-    ObjCStrongReference<NSData> value;
-};
-
 using ValueRange = QPair<NSUInteger, NSUInteger>;
 
 @interface QT_MANGLE_NAMESPACE(DarwinBTPeripheralManager) : NSObject<CBPeripheralManagerDelegate>
 
-- (id)initWith:(LECBManagerNotifier *)notifier;
+- (id)initWith:(LECBManagerNotifier *)notifier queue:(dispatch_queue_t)queue;
 - (void)dealloc;
 
 - (QSharedPointer<QLowEnergyServicePrivate>)addService:(const QLowEnergyServiceData &)data;
@@ -76,6 +76,18 @@ void StrongReference::reset(void *obj, RetainPolicy policy)
         objCInstance = [getAs<NSObject>() retain];
 }
 
+DispatchQueue::~DispatchQueue()
+{
+    reset(nullptr);
+}
+
+void DispatchQueue::reset(void *newQueue)
+{
+    if (queue)
+        dispatch_release(getAs<dispatch_queue_t>());
+    queue = newQueue;
+}
+
 } // namespace DarwinBluetooth
 
 QT_END_NAMESPACE
@@ -95,6 +95,34 @@ private:
     Q_DISABLE_COPY_MOVE(ScopedPointer)
 };
 
+// DispatchQueue owns a (type-erased) dispatch queue, the
+// one returned by qt_create_LE_queue() for example.
+class DispatchQueue final
+{
+public:
+    DispatchQueue() = default;
+    ~DispatchQueue();
+
+    // Takes ownership of an already retained queue.
+    void reset(void *newQueue);
+
+    template<class QueueType>
+    QueueType getAs() const
+    {
+        return static_cast<QueueType>(queue);
+    }
+
+    operator bool() const
+    {
+        return !!queue;
+    }
+
+private:
+    void *queue = nullptr;
+
+    Q_DISABLE_COPY_MOVE(DispatchQueue)
+};
+
 } // namespace DarwinBluetooth
 
 QT_END_NAMESPACE
@@ -346,6 +346,26 @@ dispatch_queue_t qt_LE_queue()
     return leQueue.data();
 }
 
+dispatch_queue_t qt_create_LE_queue(const char *label)
+{
+    Q_ASSERT(label);
+
+    // Core Bluetooth delivers the callbacks of every manager on its queue, with
+    // one shared queue unrelated peripherals wait for each other's callbacks.
+    static const bool dedicatedQueues = qEnvironmentVariableIntValue("QT_BLUETOOTH_DEDICATED_LE_QUEUES") > 0;
+    if (dedicatedQueues) {
+        if (dispatch_queue_t queue = dispatch_queue_create(label, DISPATCH_QUEUE_SERIAL))
+            return queue;
+        qCWarning(QT_BT_DARWIN) << "failed to create dispatch queue with label" << label
+                                << "falling back to the shared LE queue";
+    }
+
+    dispatch_queue_t queue = qt_LE_queue();
+    if (queue)
+        dispatch_retain(queue);
+    return queue;
+}
+
 } // namespace DarwinBluetooth
 
 QT_END_NAMESPACE
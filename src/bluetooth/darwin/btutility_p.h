@@ -117,6 +117,9 @@ ObjCStrongReference<NSData> data_from_bytearray(const QByteArray &qtData);
 ObjCStrongReference<NSMutableData> mutable_data_from_bytearray(const QByteArray &qtData);
 
 dispatch_queue_t qt_LE_queue();
+// Returns a retained serial queue for one LE controller or device discovery agent:
+// a queue of its own if QT_BLUETOOTH_DEDICATED_LE_QUEUES is set, qt_LE_queue() otherwise.
+dispatch_queue_t qt_create_LE_queue(const char *label);
 
 extern const int defaultLEScanTimeoutMS;
 extern const int maxValueLength;
@@ -0,0 +1,106 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+#include "leaddressresolver_p.h"
+#include "qbluetoothmemoryusage_p.h"
+
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+// prand, the most significant 24 bits of the address, and hash, the rest
+static constexpr int prandShift = 24;
+static constexpr quint64 hashMask = 0xffffff;
+
+/*!
+    \internal
+
+    Adds or replaces the \a irk of the device with \a identityAddress.
+    Returns \c false if \a irk does not have KeySize bytes.
+ */
+bool LeAddressResolver::addKey(const QBluetoothAddress &identityAddress, QByteArrayView irk)
+{
+    if (identityAddress.isNull() || irk.size() != KeySize)
+        return false;
+
+    removeKey(identityAddress);
+    Key &key = keys.emplace_back();
+    key.identityAddress = identityAddress;
+    LeAes::expandKey(reinterpret_cast<const quint8 *>(irk.data()), key.roundKeys);
+    cache.clear();
+    return true;
+}
+
+bool LeAddressResolver::removeKey(const QBluetoothAddress &identityAddress)
+{
+    const bool removed = keys.removeIf([&identityAddress](const Key &key) {
+        return key.identityAddress == identityAddress;
+    }) > 0;
+    if (removed)
+        cache.clear();
+    return removed;
+}
+
+// The two most significant bits of a resolvable private address are 0b01.
+bool LeAddressResolver::isResolvablePrivateAddress(const QBluetoothAddress &address)
+{
+    return (address.toUInt64() >> 46) == 0x1;
+}
+
+/*!
+    \internal
+
+    Returns the identity address of \a address. That is \a address itself if
+    it is the identity address of a known key. A null address is returned if
+    \a address is no resolvable private address or none of the keys resolves it.
+ */
+QBluetoothAddress LeAddressResolver::resolve(const QBluetoothAddress &address) const
+{
+    if (keys.isEmpty())
+        return QBluetoothAddress();
+
+    const quint64 value = address.toUInt64();
+    auto it = cache.constFind(value);
+    if (it == cache.cend()) {
+        qsizetype found = -1;
+        for (qsizetype i = 0; i < keys.size() && found < 0; ++i) {
+            if (keys.at(i).identityAddress == address)
+                found = i;
+        }
+        if (found < 0 && isResolvablePrivateAddress(address)) {
+            for (qsizetype i = 0; i < keys.size() && found < 0; ++i) {
+                if (matches(keys.at(i), value))
+                    found = i;
+            }
+        }
+
+        // addresses rotate, a full cache mostly holds outdated ones
+        if (cache.size() >= MaximumCacheSize)
+            cache.clear();
+        it = cache.insert(value, found);
+    }
+
+    return it.value() < 0 ? QBluetoothAddress() : keys.at(it.value()).identityAddress;
+}
+
+qsizetype LeAddressResolver::memoryUsage() const
+{
+    return QBluetoothMemory::bytes(keys) + QBluetoothMemory::bytes(cache);
+}
+
+// hash == ah(irk, prand) (Spec v4.2, Vol 3, Part H, 2.2.2)
+bool LeAddressResolver::matches(const Key &key, quint64 address) const
+{
+    const quint32 prand = quint32(address >> prandShift);
+    quint8 block[LeAes::BlockSize] = {};
+    block[LeAes::BlockSize - 3] = quint8(prand >> 16);
+    block[LeAes::BlockSize - 2] = quint8(prand >> 8);
+    block[LeAes::BlockSize - 1] = quint8(prand);
+    LeAes::encryptBlock(key.roundKeys, block);
+
+    const quint64 hash = (quint64(block[LeAes::BlockSize - 3]) << 16)
+                         | (quint64(block[LeAes::BlockSize - 2]) << 8)
+                         | block[LeAes::BlockSize - 1];
+    return hash == (address & hashMask);
+}
+
+QT_END_NAMESPACE
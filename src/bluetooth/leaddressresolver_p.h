@@ -0,0 +1,68 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+#ifndef LEADDRESSRESOLVER_P_H
+#define LEADDRESSRESOLVER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "leaes_p.h"
+
+#include <QtBluetooth/qbluetoothaddress.h>
+#include <QtCore/private/qglobal_p.h>
+#include <QtCore/qbytearrayview.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+ * Resolves resolvable private addresses to the identity addresses of the
+ * devices whose identity resolving key (IRK) is known (Spec v4.2, Vol 3,
+ * Part C, 10.8.2.3). Every resolution attempt costs one AES operation per
+ * key, hence the results, including the failed ones, are cached per address.
+ */
+class Q_AUTOTEST_EXPORT LeAddressResolver
+{
+public:
+    static constexpr qsizetype KeySize = 16;
+
+    // irk is MSB first, as printed by btmon and shown by most tools
+    bool addKey(const QBluetoothAddress &identityAddress, QByteArrayView irk);
+    bool removeKey(const QBluetoothAddress &identityAddress);
+    bool isEmpty() const { return keys.isEmpty(); }
+
+    static bool isResolvablePrivateAddress(const QBluetoothAddress &address);
+
+    // returns the identity address of address, a null address if it is unknown
+    QBluetoothAddress resolve(const QBluetoothAddress &address) const;
+
+    // approximate heap size of the keys and the resolution cache
+    qsizetype memoryUsage() const;
+
+private:
+    struct Key
+    {
+        QBluetoothAddress identityAddress;
+        quint8 roundKeys[LeAes::RoundKeysSize];
+    };
+
+    bool matches(const Key &key, quint64 address) const;
+
+    QList<Key> keys;
+    // index into keys by address, -1 if none of the keys resolves it
+    mutable QHash<quint64, qsizetype> cache;
+    static constexpr qsizetype MaximumCacheSize = 4096;
+};
+
+QT_END_NAMESPACE
+
+#endif // LEADDRESSRESOLVER_P_H
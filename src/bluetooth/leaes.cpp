@@ -0,0 +1,147 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+#include "leaes_p.h"
+
+#include <QtCore/private/qsimd_p.h>
+
+#include <cstring>
+
+#if defined(Q_PROCESSOR_X86)
+#  if QT_COMPILER_SUPPORTS_HERE(AES)
+#    define LEAES_USE_AESNI
+#    include <wmmintrin.h>
+#  endif
+#elif defined(Q_PROCESSOR_ARM_64) && defined(__ARM_FEATURE_CRYPTO)
+#  define LEAES_USE_ARMV8_CRYPTO
+#  include <arm_neon.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+// AES-128 (FIPS-197) encryption, the security function e of the LE security
+// manager (Spec v4.2, Vol 3, Part H, 2.2.1). Only the encryption direction is
+// needed. All byte arrays are MSB first.
+namespace {
+
+using LeAes::BlockSize;
+constexpr int AesRounds = LeAes::Rounds;
+
+constexpr quint8 sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+inline quint8 xtime(quint8 value)
+{
+    return quint8((value << 1) ^ ((value & 0x80) ? 0x1b : 0x00));
+}
+
+void encryptBlockGeneric(const quint8 *roundKeys, quint8 *block)
+{
+    quint8 state[BlockSize];
+    for (int i = 0; i < BlockSize; ++i)
+        state[i] = block[i] ^ roundKeys[i];
+
+    for (int round = 1; round <= AesRounds; ++round) {
+        // SubBytes and ShiftRows; the state is stored column by column
+        quint8 shifted[BlockSize];
+        for (int column = 0; column < 4; ++column) {
+            for (int row = 0; row < 4; ++row)
+                shifted[4 * column + row] = sbox[state[4 * ((column + row) % 4) + row]];
+        }
+
+        if (round == AesRounds) {
+            std::memcpy(state, shifted, BlockSize);
+        } else {
+            for (int column = 0; column < 4; ++column) {
+                const quint8 *a = shifted + 4 * column;
+                const quint8 all = a[0] ^ a[1] ^ a[2] ^ a[3];
+                quint8 *b = state + 4 * column;
+                b[0] = a[0] ^ all ^ xtime(a[0] ^ a[1]);
+                b[1] = a[1] ^ all ^ xtime(a[1] ^ a[2]);
+                b[2] = a[2] ^ all ^ xtime(a[2] ^ a[3]);
+                b[3] = a[3] ^ all ^ xtime(a[3] ^ a[0]);
+            }
+        }
+
+        const quint8 *roundKey = roundKeys + BlockSize * round;
+        for (int i = 0; i < BlockSize; ++i)
+            state[i] ^= roundKey[i];
+    }
+    std::memcpy(block, state, BlockSize);
+}
+
+#if defined(LEAES_USE_AESNI)
+QT_FUNCTION_TARGET(AES)
+void encryptBlockAesNi(const quint8 *roundKeys, quint8 *block)
+{
+    const __m128i *keys = reinterpret_cast<const __m128i *>(roundKeys);
+    __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+    state = _mm_xor_si128(state, _mm_loadu_si128(keys));
+    for (int round = 1; round < AesRounds; ++round)
+        state = _mm_aesenc_si128(state, _mm_loadu_si128(keys + round));
+    state = _mm_aesenclast_si128(state, _mm_loadu_si128(keys + AesRounds));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(block), state);
+}
+#elif defined(LEAES_USE_ARMV8_CRYPTO)
+void encryptBlockArmV8(const quint8 *roundKeys, quint8 *block)
+{
+    uint8x16_t state = vld1q_u8(block);
+    for (int round = 0; round < AesRounds - 1; ++round)
+        state = vaesmcq_u8(vaeseq_u8(state, vld1q_u8(roundKeys + BlockSize * round)));
+    state = vaeseq_u8(state, vld1q_u8(roundKeys + BlockSize * (AesRounds - 1)));
+    state = veorq_u8(state, vld1q_u8(roundKeys + BlockSize * AesRounds));
+    vst1q_u8(block, state);
+}
+#endif
+
+} // unnamed namespace
+
+void LeAes::expandKey(const quint8 *key, quint8 *roundKeys)
+{
+    static constexpr quint8 rcon[AesRounds] = {
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
+    };
+
+    std::memcpy(roundKeys, key, BlockSize);
+    for (int i = 4; i < 4 * (AesRounds + 1); ++i) {
+        const quint8 *previous = roundKeys + 4 * (i - 1);
+        quint8 temp[4] = { previous[0], previous[1], previous[2], previous[3] };
+        if (i % 4 == 0) {
+            const quint8 first = temp[0];
+            temp[0] = sbox[temp[1]] ^ rcon[i / 4 - 1];
+            temp[1] = sbox[temp[2]];
+            temp[2] = sbox[temp[3]];
+            temp[3] = sbox[first];
+        }
+        for (int j = 0; j < 4; ++j)
+            roundKeys[4 * i + j] = roundKeys[4 * (i - 4) + j] ^ temp[j];
+    }
+}
+
+void LeAes::encryptBlock(const quint8 *roundKeys, quint8 *block)
+{
+#if defined(LEAES_USE_AESNI)
+    if (qCpuHasFeature(AES))
+        return encryptBlockAesNi(roundKeys, block);
+#elif defined(LEAES_USE_ARMV8_CRYPTO)
+    return encryptBlockArmV8(roundKeys, block);
+#endif
+    encryptBlockGeneric(roundKeys, block);
+}
+
+QT_END_NAMESPACE
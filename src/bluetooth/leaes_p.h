@@ -0,0 +1,37 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+#ifndef LEAES_P_H
+#define LEAES_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qglobal.h>
+
+QT_BEGIN_NAMESPACE
+
+// AES-128 encryption as needed by LE signing and address resolution,
+// accelerated by AES-NI or the ARMv8 crypto extension where available.
+namespace LeAes {
+
+constexpr int BlockSize = 16;
+constexpr int Rounds = 10;
+constexpr int RoundKeysSize = (Rounds + 1) * BlockSize;
+
+// key and block are MSB first, roundKeys holds RoundKeysSize bytes
+void expandKey(const quint8 *key, quint8 *roundKeys);
+void encryptBlock(const quint8 *roundKeys, quint8 *block);
+
+} // namespace LeAes
+
+QT_END_NAMESPACE
+
+#endif // LEAES_P_H
@@ -0,0 +1,275 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "lebondstore_p.h"
+
+#include <QtCore/qdir.h>
+#include <QtCore/qendian.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qlockfile.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qstandardpaths.h>
+
+#include <cstring>
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+/*
+ * File layout: the magic below, followed by records of the form
+ *   type (1) | adapter (8) | device (8) | value length (2) | value | checksum (2)
+ * with all integers in little endian. The checksum covers the preceding bytes of
+ * the record and lets us detect a record that was cut short by a crash or power
+ * loss, in which case everything from that record on is discarded.
+ * A later record for the same key supersedes earlier ones; an empty value removes it.
+ */
+static constexpr char fileMagic[] = "QtBtBnd1";
+static constexpr qsizetype magicSize = sizeof(fileMagic) - 1;
+static constexpr qsizetype recordHeaderSize = 1 + 8 + 8 + 2;
+static constexpr qsizetype checksumSize = 2;
+// Compact once the journal holds that many more records than there are live values.
+static constexpr qsizetype compactionSlack = 64;
+
+static void appendRecord(QByteArray *out, const LeBondStore::Key &key, const QByteArray &value)
+{
+    const qsizetype start = out->size();
+    out->resize(start + recordHeaderSize + value.size() + checksumSize);
+    char *data = out->data() + start;
+    data[0] = char(key.type);
+    qToLittleEndian<quint64>(key.adapter, data + 1);
+    qToLittleEndian<quint64>(key.device, data + 9);
+    qToLittleEndian<quint16>(quint16(value.size()), data + 17);
+    memcpy(data + recordHeaderSize, value.constData(), value.size());
+    const quint16 checksum = qChecksum(QByteArrayView(data, recordHeaderSize + value.size()));
+    qToLittleEndian<quint16>(checksum, data + recordHeaderSize + value.size());
+}
+
+/*
+ * Applies the records of content, which starts with the magic, to values and
+ * returns the offset behind the last complete record.
+ */
+static qsizetype readRecords(const QByteArray &content,
+                             QHash<LeBondStore::Key, QByteArray> *values, qsizetype *records)
+{
+    qsizetype offset = magicSize;
+    while (content.size() - offset >= recordHeaderSize + checksumSize) {
+        const char *data = content.constData() + offset;
+        const qsizetype valueSize = qFromLittleEndian<quint16>(data + 17);
+        const qsizetype recordSize = recordHeaderSize + valueSize + checksumSize;
+        if (content.size() - offset < recordSize)
+            break;
+        const quint16 checksum = qFromLittleEndian<quint16>(data + recordHeaderSize + valueSize);
+        if (checksum != qChecksum(QByteArrayView(data, recordHeaderSize + valueSize)))
+            break;
+
+        const LeBondStore::Key key{ LeBondStore::RecordType(data[0]),
+                                    qFromLittleEndian<quint64>(data + 1),
+                                    qFromLittleEndian<quint64>(data + 9) };
+        if (valueSize == 0)
+            values->remove(key);
+        else
+            values->insert(key, QByteArray(data + recordHeaderSize, valueSize));
+        ++*records;
+        offset += recordSize;
+    }
+    return offset;
+}
+
+LeBondStore::LeBondStore(const QString &filePath)
+    : filePath(filePath)
+{
+    writer.setMaxThreadCount(1);
+}
+
+LeBondStore::~LeBondStore()
+{
+    waitForWritten();
+}
+
+LeBondStore *LeBondStore::instance()
+{
+    static LeBondStore store([] {
+        const QString dataLocation
+                = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation);
+        if (dataLocation.isEmpty())
+            return QString();
+        return dataLocation + QLatin1String("/qtbluetooth/bonds");
+    }());
+    return &store;
+}
+
+QByteArray LeBondStore::value(const Key &key)
+{
+    QMutexLocker locker(&mutex);
+    loadIfNecessary();
+    return values.value(key);
+}
+
+void LeBondStore::setValue(const Key &key, const QByteArray &value)
+{
+    Q_ASSERT(value.size() <= 0xffff);
+
+    QMutexLocker locker(&mutex);
+    loadIfNecessary();
+    if (value.isEmpty()) {
+        if (values.remove(key) == 0)
+            return;
+    } else {
+        auto it = values.find(key);
+        if (it != values.end() && *it == value)
+            return;
+        values.insert(key, value);
+    }
+
+    if (filePath.isEmpty())
+        return;
+
+    pending.append(qMakePair(key, value));
+    if (!writeScheduled) {
+        writeScheduled = true;
+        writer.start([this] { writePending(); });
+    }
+}
+
+void LeBondStore::waitForWritten()
+{
+    writer.waitForDone();
+}
+
+/*
+ * Reads the journal the first time the store is accessed. This is the only
+ * file access done by the calling thread. Must be called with the mutex locked.
+ */
+void LeBondStore::loadIfNecessary()
+{
+    if (loaded)
+        return;
+    loaded = true;
+
+    if (filePath.isEmpty())
+        return;
+
+    QFile file(filePath);
+    if (!file.exists()) {
+        // the first write creates the file
+        needsCompaction = true;
+        return;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot open bond store" << filePath << file.errorString();
+        return;
+    }
+
+    const QByteArray content = file.readAll();
+    if (!content.startsWith(QByteArrayView(fileMagic, magicSize))) {
+        qCWarning(QT_BT_BLUEZ) << "Ignoring bond store with unknown format" << filePath;
+        needsCompaction = true;
+        return;
+    }
+
+    const qsizetype offset = readRecords(content, &values, &recordsInFile);
+    if (offset != content.size()) {
+        qCWarning(QT_BT_BLUEZ) << "Discarding truncated tail of bond store" << filePath;
+        needsCompaction = true;
+    }
+}
+
+/*
+ * Runs on the writer thread. Takes all changes that have accumulated so far and
+ * appends them in one go, or rewrites the whole file if it has grown too large.
+ */
+void LeBondStore::writePending()
+{
+    QMutexLocker locker(&mutex);
+    while (!pending.isEmpty()) {
+        const QList<QPair<Key, QByteArray>> batch = std::exchange(pending, {});
+        const bool compactNow = needsCompaction
+                || recordsInFile + batch.size() > 2 * values.size() + compactionSlack;
+        locker.unlock();
+
+        QDir().mkpath(QFileInfo(filePath).path());
+        QLockFile lock(filePath + QLatin1String(".lock"));
+        qsizetype records = 0;
+        bool success = false;
+        if (!lock.lock()) {
+            qCWarning(QT_BT_BLUEZ) << "Cannot lock bond store" << filePath << lock.error();
+        } else if (compactNow || !QFileInfo::exists(filePath)) {
+            success = compact(batch, &records);
+        } else {
+            success = append(batch);
+            records = recordsInFile + batch.size();
+        }
+        lock.unlock();
+
+        locker.relock();
+        if (!success) {
+            // the file may now end in a partial record, replace it with the next change
+            pending = batch + pending;
+            needsCompaction = true;
+            break;
+        }
+        recordsInFile = records;
+        if (compactNow)
+            needsCompaction = false;
+    }
+    writeScheduled = false;
+}
+
+// Must be called with the lock file held.
+bool LeBondStore::append(const QList<QPair<Key, QByteArray>> &batch)
+{
+    QByteArray buffer;
+    for (const auto &change : batch)
+        appendRecord(&buffer, change.first, change.second);
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append) || file.write(buffer) != buffer.size()
+            || !file.flush()) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot write bond store" << filePath << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Rewrites the journal with one record per live value. The values are taken from
+ * the journal as it is now, including the records other processes appended, with
+ * batch applied on top. Must be called with the lock file held.
+ */
+bool LeBondStore::compact(const QList<QPair<Key, QByteArray>> &batch, qsizetype *records)
+{
+    QHash<Key, QByteArray> current;
+    QFile existing(filePath);
+    if (existing.open(QIODevice::ReadOnly)) {
+        const QByteArray content = existing.readAll();
+        qsizetype existingRecords = 0;
+        if (content.startsWith(QByteArrayView(fileMagic, magicSize)))
+            readRecords(content, &current, &existingRecords);
+        existing.close();
+    }
+    for (const auto &change : batch) {
+        if (change.second.isEmpty())
+            current.remove(change.first);
+        else
+            current.insert(change.first, change.second);
+    }
+
+    QByteArray buffer(fileMagic, magicSize);
+    for (auto it = current.cbegin(); it != current.cend(); ++it)
+        appendRecord(&buffer, it.key(), it.value());
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(buffer) != buffer.size()
+            || !file.commit()) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot write bond store" << filePath << file.errorString();
+        return false;
+    }
+    *records = current.size();
+    return true;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,98 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef LEBONDSTORE_P_H
+#define LEBONDSTORE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/private/qglobal_p.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qthreadpool.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+ * Process-wide store for per-bond state of the ATT-socket-based BlueZ backend,
+ * such as signing counters and client characteristic configurations.
+ *
+ * Values are kept in memory and every change is appended to a binary journal
+ * by a worker thread, so that callers never block on disk I/O. Changes made
+ * while a write is in progress are batched into the next one. Once the journal
+ * holds considerably more records than live values, it is compacted.
+ *
+ * Bonds are shared by all applications on the system, and so is the journal.
+ * Writes hold a lock file, and compaction rebuilds the journal from its current
+ * content rather than from the values of this process, so that records appended
+ * by other processes survive. Values are read from the file only once, changes
+ * of other processes become visible on the next start.
+ */
+class Q_AUTOTEST_EXPORT LeBondStore
+{
+public:
+    enum class RecordType : quint8 {
+        LocalSignCounter = 1,
+        RemoteSignCounter = 2,
+        ClientConfigurations = 3,
+    };
+
+    struct Key {
+        RecordType type;
+        quint64 adapter;
+        quint64 device;
+
+        friend bool operator==(const Key &a, const Key &b) noexcept
+        {
+            return a.type == b.type && a.adapter == b.adapter && a.device == b.device;
+        }
+        friend size_t qHash(const Key &key, size_t seed = 0) noexcept
+        {
+            return qHashMulti(seed, quint8(key.type), key.adapter, key.device);
+        }
+    };
+
+    explicit LeBondStore(const QString &filePath);
+    ~LeBondStore();
+
+    static LeBondStore *instance();
+
+    QByteArray value(const Key &key);
+    // An empty value removes the key.
+    void setValue(const Key &key, const QByteArray &value);
+
+    // Blocks until all pending changes have been written.
+    void waitForWritten();
+
+private:
+    void loadIfNecessary();
+    void writePending();
+    bool append(const QList<QPair<Key, QByteArray>> &batch);
+    bool compact(const QList<QPair<Key, QByteArray>> &batch, qsizetype *records);
+
+    const QString filePath;
+    QMutex mutex;
+    QHash<Key, QByteArray> values;
+    QList<QPair<Key, QByteArray>> pending;
+    qsizetype recordsInFile = 0;
+    bool loaded = false;
+    bool needsCompaction = false;
+    bool writeScheduled = false;
+    QThreadPool writer;
+};
+
+QT_END_NAMESPACE
+
+#endif // LEBONDSTORE_P_H
@@ -5,52 +5,39 @@
 #include "bluez/bluez_data_p.h"
 
 #include <QtCore/qbytearray.h>
+#include <QtCore/qendian.h>
 #include <QtCore/qloggingcategory.h>
-#include <QtCore/private/qcore_unix_p.h>
+#include <QtCore/qvarlengtharray.h>
 
+#include <algorithm>
 #include <cstring>
-#include <sys/socket.h>
-#include <sys/types.h>
-#include <unistd.h>
-
-#ifdef CONFIG_LINUX_CRYPTO_API
-#include <linux/if_alg.h>
-#endif
 
 QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
 
-LeCmacCalculator::LeCmacCalculator()
-{
-#ifdef CONFIG_LINUX_CRYPTO_API
-    m_baseSocket = socket(AF_ALG, SOCK_SEQPACKET, 0);
-    if (m_baseSocket == -1) {
-        qCWarning(QT_BT_BLUEZ) << "failed to create first level crypto socket:"
-                               << strerror(errno);
-        return;
-    }
-    sockaddr_alg sa;
-    using namespace std;
-    memset(&sa, 0, sizeof sa);
-    sa.salg_family = AF_ALG;
-    strcpy(reinterpret_cast<char *>(sa.salg_type), "hash");
-    strcpy(reinterpret_cast<char *>(sa.salg_name), "cmac(aes)");
-    if (::bind(m_baseSocket, reinterpret_cast<sockaddr *>(&sa), sizeof sa) == -1) {
-        qCWarning(QT_BT_BLUEZ) << "bind() failed for crypto socket:" << strerror(errno);
-        return;
-    }
-#else // CONFIG_LINUX_CRYPTO_API
-    qCWarning(QT_BT_BLUEZ) << "Linux crypto API not present, CMAC verification will fail.";
-#endif
-}
+// AES-CMAC (RFC 4493), as used by the LE signing algorithm
+// (Spec v4.2, Vol 3, Part H, 2.4.5). All byte arrays are MSB first.
+namespace {
 
-LeCmacCalculator::~LeCmacCalculator()
+constexpr int AesBlockSize = LeAes::BlockSize;
+
+// RFC 4493, 2.3
+void generateSubkey(const quint8 *input, quint8 *subkey)
 {
-    if (m_baseSocket != -1)
-        close(m_baseSocket);
+    for (int i = 0; i < AesBlockSize - 1; ++i)
+        subkey[i] = quint8((input[i] << 1) | (input[i + 1] >> 7));
+    subkey[AesBlockSize - 1] = quint8(input[AesBlockSize - 1] << 1);
+    if (input[0] & 0x80)
+        subkey[AesBlockSize - 1] ^= 0x87;
 }
 
+} // unnamed namespace
+
+LeCmacCalculator::LeCmacCalculator() = default;
+
+LeCmacCalculator::~LeCmacCalculator() = default;
+
 QByteArray LeCmacCalculator::createFullMessage(const QByteArray &message, quint32 signCounter)
 {
     // Spec v4.2, Vol 3, Part H, 2.4.5
@@ -60,77 +47,87 @@ QByteArray LeCmacCalculator::createFullMessage(const QByteArray &message, quint3
     return fullMessage;
 }
 
-quint64 LeCmacCalculator::calculateMac(const QByteArray &message, const quint128 &csrk) const
+/*!
+    \internal
+
+    Returns the expanded AES key and the CMAC subkeys for \a csrk. They are
+    computed once per key and kept for the most recently used keys, as all
+    signed writes of a connection use the same CSRK.
+ */
+const LeCmacCalculator::ExpandedKey &LeCmacCalculator::expandedKey(const quint128 &csrk) const
 {
-#ifdef CONFIG_LINUX_CRYPTO_API
-    if (m_baseSocket == -1)
-        return false;
-    quint128 csrkMsb;
-    std::reverse_copy(std::begin(csrk.data), std::end(csrk.data), std::begin(csrkMsb.data));
-    qCDebug(QT_BT_BLUEZ) << "CSRK (MSB):" << QByteArray(reinterpret_cast<char *>(csrkMsb.data),
-                                                        sizeof csrkMsb).toHex();
-    if (setsockopt(m_baseSocket, 279 /* SOL_ALG */, ALG_SET_KEY, csrkMsb.data, sizeof csrkMsb) == -1) {
-        qCWarning(QT_BT_BLUEZ) << "setsockopt() failed for crypto socket:" << strerror(errno);
-        return 0;
+    for (int i = 0; i < m_cachedKeyCount; ++i) {
+        if (std::memcmp(m_keyCache[i].csrk, csrk.data, sizeof csrk.data) == 0)
+            return m_keyCache[i];
+    }
+
+    ExpandedKey &key = m_keyCache[m_nextCacheSlot];
+    m_nextCacheSlot = (m_nextCacheSlot + 1) % KeyCacheSize;
+    m_cachedKeyCount = (std::min)(m_cachedKeyCount + 1, KeyCacheSize);
+
+    std::memcpy(key.csrk, csrk.data, sizeof csrk.data);
+    quint8 csrkMsb[AesBlockSize];
+    std::reverse_copy(std::begin(csrk.data), std::end(csrk.data), csrkMsb);
+    LeAes::expandKey(csrkMsb, key.roundKeys);
+
+    quint8 l[AesBlockSize] = {};
+    LeAes::encryptBlock(key.roundKeys, l);
+    generateSubkey(l, key.k1);
+    generateSubkey(key.k1, key.k2);
+    return key;
+}
+
+// RFC 4493, 2.4; returns the 64 most significant bits of the CMAC
+quint64 LeCmacCalculator::calculateMac(const quint8 *messageMsb, qsizetype size,
+                                       const ExpandedKey &key)
+{
+    const qsizetype blockCount = size == 0 ? 1 : (size + AesBlockSize - 1) / AesBlockSize;
+    const bool lastBlockComplete = size != 0 && size % AesBlockSize == 0;
+
+    quint8 x[AesBlockSize] = {};
+    for (qsizetype block = 0; block < blockCount - 1; ++block) {
+        const quint8 *m = messageMsb + block * AesBlockSize;
+        for (int i = 0; i < AesBlockSize; ++i)
+            x[i] ^= m[i];
+        LeAes::encryptBlock(key.roundKeys, x);
     }
 
-    class SocketWrapper
-    {
-    public:
-        SocketWrapper(int socket) : m_socket(socket) {}
-        ~SocketWrapper() {
-            if (m_socket != -1)
-                close(m_socket);
-        }
-
-        int value() const { return m_socket; }
-    private:
-        int m_socket;
-    };
-    SocketWrapper cryptoSocket(accept(m_baseSocket, nullptr, nullptr));
-    if (cryptoSocket.value() == -1) {
-        qCWarning(QT_BT_BLUEZ) << "accept() failed for crypto socket:" << strerror(errno);
-        return 0;
+    const qsizetype lastOffset = (blockCount - 1) * AesBlockSize;
+    const qsizetype lastSize = size - lastOffset;
+    quint8 last[AesBlockSize] = {};
+    std::memcpy(last, messageMsb + lastOffset, lastSize);
+    const quint8 *subkey = key.k1;
+    if (!lastBlockComplete) {
+        last[lastSize] = 0x80;
+        subkey = key.k2;
     }
+    for (int i = 0; i < AesBlockSize; ++i)
+        x[i] ^= last[i] ^ subkey[i];
+    LeAes::encryptBlock(key.roundKeys, x);
 
-    QByteArray messageSwapped(message.size(), Qt::Uninitialized);
-    std::reverse_copy(message.begin(), message.end(), messageSwapped.begin());
-    qint64 totalBytesWritten = 0;
-    do {
-        const qint64 bytesWritten = qt_safe_write(cryptoSocket.value(),
-                                                  messageSwapped.constData() + totalBytesWritten,
-                                                  messageSwapped.size() - totalBytesWritten);
-        if (bytesWritten == -1) {
-            qCWarning(QT_BT_BLUEZ) << "writing to crypto socket failed:" << strerror(errno);
-            return 0;
-        }
-        totalBytesWritten += bytesWritten;
-    } while (totalBytesWritten < messageSwapped.size());
-    quint64 mac;
-    quint8 * const macPtr = reinterpret_cast<quint8 *>(&mac);
-    qint64 totalBytesRead = 0;
-    do {
-        const qint64 bytesRead = qt_safe_read(cryptoSocket.value(), macPtr + totalBytesRead,
-                                              sizeof mac - totalBytesRead);
-        if (bytesRead == -1) {
-            qCWarning(QT_BT_BLUEZ) << "reading from crypto socket failed:" << strerror(errno);
-            return 0;
-        }
-        totalBytesRead += bytesRead;
-    } while (totalBytesRead < qint64(sizeof mac));
-    return qFromBigEndian(mac);
-#else // CONFIG_LINUX_CRYPTO_API
-    Q_UNUSED(message);
-    Q_UNUSED(csrk);
-    qCWarning(QT_BT_BLUEZ) << "CMAC calculation failed due to missing Linux crypto API.";
-    return 0;
-#endif
+    return qFromBigEndian<quint64>(x);
+}
+
+quint64 LeCmacCalculator::calculateMac(QByteArrayView message, const quint128 &csrk) const
+{
+    QVarLengthArray<quint8, 64> messageMsb(message.size());
+    std::reverse_copy(message.begin(), message.end(), messageMsb.begin());
+    return calculateMac(messageMsb.constData(), messageMsb.size(), expandedKey(csrk));
 }
 
-bool LeCmacCalculator::verify(const QByteArray &message, const quint128 &csrk,
-                           quint64 expectedMac) const
+quint64 LeCmacCalculator::calculateMac(QByteArrayView message, quint32 signCounter,
+                                       const quint128 &csrk) const
+{
+    // The counter is appended LSB first and ends up in front after the byte swap.
+    QVarLengthArray<quint8, 64> messageMsb(message.size() + qsizetype(sizeof signCounter));
+    qToBigEndian(signCounter, messageMsb.data());
+    std::reverse_copy(message.begin(), message.end(), messageMsb.begin() + sizeof signCounter);
+    return calculateMac(messageMsb.constData(), messageMsb.size(), expandedKey(csrk));
+}
+
+bool LeCmacCalculator::verify(QByteArrayView message, const quint128 &csrk,
+                              quint64 expectedMac) const
 {
-#ifdef CONFIG_LINUX_CRYPTO_API
     const quint64 actualMac = calculateMac(message, csrk);
     if (actualMac != expectedMac) {
         qCWarning(QT_BT_BLUEZ) << Qt::hex << "signature verification failed: calculated mac:"
@@ -138,13 +135,18 @@ bool LeCmacCalculator::verify(const QByteArray &message, const quint128 &csrk,
         return false;
     }
     return true;
-#else // CONFIG_LINUX_CRYPTO_API
-    Q_UNUSED(message);
-    Q_UNUSED(csrk);
-    Q_UNUSED(expectedMac);
-    qCWarning(QT_BT_BLUEZ) << "CMAC verification failed due to missing Linux crypto API.";
-    return false;
-#endif
+}
+
+bool LeCmacCalculator::verify(QByteArrayView message, quint32 signCounter, const quint128 &csrk,
+                              quint64 expectedMac) const
+{
+    const quint64 actualMac = calculateMac(message, signCounter, csrk);
+    if (actualMac != expectedMac) {
+        qCWarning(QT_BT_BLUEZ) << Qt::hex << "signature verification failed: calculated mac:"
+                               << actualMac << "expected mac:" << expectedMac;
+        return false;
+    }
+    return true;
 }
 
 QT_END_NAMESPACE
@@ -15,6 +15,9 @@
 //
 
 #include <QtCore/private/qglobal_p.h>
+#include <QtCore/qbytearrayview.h>
+
+#include "leaes_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -28,13 +31,33 @@ public:
 
     static QByteArray createFullMessage(const QByteArray &message, quint32 signCounter);
 
-    quint64 calculateMac(const QByteArray &message, const quint128 &csrk) const;
+    quint64 calculateMac(QByteArrayView message, const quint128 &csrk) const;
+    // Same as calculateMac(createFullMessage(message, signCounter), csrk), without the copy.
+    quint64 calculateMac(QByteArrayView message, quint32 signCounter,
+                         const quint128 &csrk) const;
 
-    // Convenience function.
-    bool verify(const QByteArray &message, const quint128 &csrk, quint64 expectedMac) const;
+    // Convenience functions.
+    bool verify(QByteArrayView message, const quint128 &csrk, quint64 expectedMac) const;
+    bool verify(QByteArrayView message, quint32 signCounter, const quint128 &csrk,
+                quint64 expectedMac) const;
 
 private:
-    int m_baseSocket = -1;
+    struct ExpandedKey {
+        quint8 csrk[16]; // as passed in, i.e. LSB first
+        quint8 roundKeys[LeAes::RoundKeysSize];
+        quint8 k1[16];
+        quint8 k2[16];
+    };
+
+    const ExpandedKey &expandedKey(const quint128 &csrk) const;
+    static quint64 calculateMac(const quint8 *messageMsb, qsizetype size,
+                                const ExpandedKey &key);
+
+    // Expanded keys and CMAC subkeys of the most recently used CSRKs
+    static constexpr int KeyCacheSize = 4;
+    mutable ExpandedKey m_keyCache[KeyCacheSize];
+    mutable int m_cachedKeyCount = 0;
+    mutable int m_nextCacheSlot = 0;
 };
 
 
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include "qbluetoothaddress.h"
+#include "qbluetoothaddress_p.h"
 
 #ifndef QT_NO_DEBUG_STREAM
 #include <QDebug>
@@ -11,6 +12,38 @@ QT_BEGIN_NAMESPACE
 
 QT_IMPL_METATYPE_EXTERN(QBluetoothAddress)
 
+// Returns the value of the hexadecimal digit c, or -1 if c is none.
+static inline int hexDigitValue(char16_t c) noexcept
+{
+    if (c >= u'0' && c <= u'9')
+        return c - u'0';
+    c |= 0x20; // ASCII letters to lower case
+    if (c >= u'a' && c <= u'f')
+        return c - u'a' + 10;
+    return -1;
+}
+
+quint64 qt_parseBluetoothAddress(QStringView text, char16_t separator)
+{
+    const qsizetype step = separator ? 3 : 2;
+    if (text.size() != (separator ? 17 : 12))
+        return 0;
+
+    // errors are collected in the sign bit instead of branching on each digit
+    quint64 address = 0;
+    int invalid = 0;
+    for (qsizetype i = 0; i < text.size(); i += step) {
+        const int high = hexDigitValue(text[i]);
+        const int low = hexDigitValue(text[i + 1]);
+        invalid |= high | low;
+        if (separator && i + 2 < text.size())
+            invalid |= text[i + 2] == separator ? 0 : -1;
+        address = address << 8 | quint64(high & 0x0f) << 4 | quint64(low & 0x0f);
+    }
+
+    return invalid < 0 ? 0 : address;
+}
+
 /*!
     \class QBluetoothAddress
     \inmodule QtBluetooth
@@ -46,20 +79,8 @@ Q_CONSTRUCTOR_FUNCTION(registerQBluetoothAddress)
     where X is a hexadecimal digit.  Case is not important.
 */
 QBluetoothAddress::QBluetoothAddress(const QString &address)
+    : m_address(qt_parseBluetoothAddress(address, address.size() == 17 ? u':' : u'\0'))
 {
-    QString a = address;
-
-    if (a.size() == 17)
-        a.remove(QLatin1Char(':'));
-
-    if (a.size() == 12) {
-        bool ok;
-        m_address = a.toULongLong(&ok, 16);
-        if (!ok)
-            clear();
-    } else {
-        m_address = 0;
-    }
 }
 
 /*!
@@ -116,14 +137,31 @@ quint64 QBluetoothAddress::toUInt64() const
 */
 QString QBluetoothAddress::toString() const
 {
-    QString s(QStringLiteral("%1:%2:%3:%4:%5:%6"));
+    static constexpr char16_t digits[] = u"0123456789ABCDEF";
 
+    QString s(17, Qt::Uninitialized);
+    char16_t *out = reinterpret_cast<char16_t *>(s.data());
     for (int i = 5; i >= 0; --i) {
         const quint8 a = (m_address >> (i*8)) & 0xff;
-        s = s.arg(a, 2, 16, QLatin1Char('0'));
+        *out++ = digits[a >> 4];
+        *out++ = digits[a & 0x0f];
+        if (i > 0)
+            *out++ = u':';
     }
 
-    return s.toUpper();
+    return s;
+}
+
+/*!
+    \fn size_t qHash(const QBluetoothAddress &address, size_t seed = 0)
+    \relates QBluetoothAddress
+    \since 6.5
+
+    Returns the hash value for \a address, using \a seed to seed the calculation.
+*/
+size_t qHash(const QBluetoothAddress &address, size_t seed) noexcept
+{
+    return qHash(address.toUInt64(), seed);
 }
 
 /*!
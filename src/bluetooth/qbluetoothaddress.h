@@ -55,6 +55,8 @@ private:
 #endif
 };
 
+Q_BLUETOOTH_EXPORT size_t qHash(const QBluetoothAddress &address, size_t seed = 0) noexcept;
+
 QT_END_NAMESPACE
 
 QT_DECL_METATYPE_EXTERN(QBluetoothAddress, Q_BLUETOOTH_EXPORT)
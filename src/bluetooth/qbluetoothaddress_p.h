@@ -0,0 +1,28 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QBLUETOOTHADDRESS_P_H
+#define QBLUETOOTHADDRESS_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qstringview.h>
+
+QT_BEGIN_NAMESPACE
+
+// Parses twelve hexadecimal digits, or six pairs of them separated by
+// separator if it is not null. Returns 0 if text has any other form.
+quint64 qt_parseBluetoothAddress(QStringView text, char16_t separator);
+
+QT_END_NAMESPACE
+
+#endif // QBLUETOOTHADDRESS_P_H
@@ -4,11 +4,20 @@
 
 #include "qbluetoothdevicediscoveryagent.h"
 #include "qbluetoothdevicediscoveryagent_p.h"
+#include "qbluetoothmemoryusage_p.h"
+#include <QtCore/qdatastream.h>
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qendian.h>
 #include <QtCore/qloggingcategory.h>
+#include <QtCore/qtimer.h>
+
+#include <algorithm>
+#include <utility>
 
 QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT)
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_MEMORY)
 
 /*!
     \class QBluetoothDeviceDiscoveryAgent
@@ -87,6 +96,22 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT)
     \since 5.8
 */
 
+/*!
+    \enum QBluetoothDeviceDiscoveryAgent::LowEnergyScanMode
+
+    This enum describes how the Bluetooth controller trades the latency of
+    the Bluetooth Low Energy device search against its power consumption.
+
+    \value Balanced     The controller scans at a moderate duty cycle. This is the default.
+    \value LowLatency   The controller scans continuously. Devices are found fastest,
+                        at the highest power consumption.
+    \value LowPower     The controller scans at a low duty cycle, devices which
+                        advertise rarely may be found late.
+
+    \sa setLowEnergyScanMode()
+    \since 6.5
+*/
+
 /*!
     \fn void QBluetoothDeviceDiscoveryAgent::deviceDiscovered(const QBluetoothDeviceInfo &info)
 
@@ -128,6 +153,52 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT)
     \sa QBluetoothDeviceInfo::rssi(), lowEnergyDiscoveryTimeout()
 */
 
+/*!
+    \fn void QBluetoothDeviceDiscoveryAgent::deviceLost(const QBluetoothDeviceInfo &info)
+
+    This signal is emitted when the device described by \a info was removed from
+    \l discoveredDevices(), either because it has not been seen for
+    \l deviceLostTimeout() milliseconds or to make room for a newly discovered
+    device once \l maximumDiscoveredDevices() is reached. If the device shows up
+    again, \l deviceDiscovered() is emitted for it again.
+
+    \sa setDeviceLostTimeout(), setMaximumDiscoveredDevices()
+    \since 6.5
+*/
+
+/*!
+    \fn void QBluetoothDeviceDiscoveryAgent::advertisementReportsAvailable()
+
+    This signal is emitted once the first advertisement report was stored in
+    a previously empty buffer. Further reports received before the buffer was
+    drained via \l takeAdvertisementReports() do not cause further emissions.
+
+    \sa setAdvertisementReportBufferSize()
+    \since 6.5
+*/
+
+/*!
+    \fn void QBluetoothDeviceDiscoveryAgent::periodicAdvertisingReceived(const QBluetoothDeviceInfo &info, const QByteArray &data)
+
+    This signal is emitted for each periodic advertising \a data received
+    from the device described by \a info. The data contains AD structures
+    like regular advertising data.
+
+    \sa startPeriodicAdvertisingSync()
+    \since 6.5
+*/
+
+/*!
+    \fn void QBluetoothDeviceDiscoveryAgent::periodicAdvertisingSyncLost(const QBluetoothDeviceInfo &info)
+
+    This signal is emitted when the synchronization to the periodic advertising
+    of the device described by \a info was lost, for example because the
+    device went out of range or stopped advertising.
+
+    \sa startPeriodicAdvertisingSync()
+    \since 6.5
+*/
+
 /*!
     \fn void QBluetoothDeviceDiscoveryAgent::finished()
 
@@ -158,6 +229,17 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT)
     Returns true if the agent is currently discovering Bluetooth devices, otherwise returns false.
 */
 
+// the category is checked once, the connection is only made for memory diagnostics
+static void logMemoryUsageWhenFinished(QBluetoothDeviceDiscoveryAgent *agent)
+{
+    if (!QT_BT_MEMORY().isDebugEnabled())
+        return;
+
+    QObject::connect(agent, &QBluetoothDeviceDiscoveryAgent::finished, agent, [agent]() {
+        qCDebug(QT_BT_MEMORY) << agent << agent->memoryUsage();
+    });
+}
+
 /*!
     Constructs a new Bluetooth device discovery agent with parent \a parent.
 */
@@ -165,6 +247,7 @@ QBluetoothDeviceDiscoveryAgent::QBluetoothDeviceDiscoveryAgent(QObject *parent)
     QObject(parent),
     d_ptr(new QBluetoothDeviceDiscoveryAgentPrivate(QBluetoothAddress(), this))
 {
+    logMemoryUsageWhenFinished(this);
 }
 
 /*!
@@ -184,6 +267,8 @@ QBluetoothDeviceDiscoveryAgent::QBluetoothDeviceDiscoveryAgent(
     QObject(parent),
     d_ptr(new QBluetoothDeviceDiscoveryAgentPrivate(deviceAdapter, this))
 {
+    logMemoryUsageWhenFinished(this);
+
     if (!deviceAdapter.isNull()) {
         const QList<QBluetoothHostInfo> localDevices = QBluetoothLocalDevice::allDevices();
         for (const QBluetoothHostInfo &hostInfo : localDevices) {
@@ -209,7 +294,128 @@ QBluetoothDeviceDiscoveryAgent::~QBluetoothDeviceDiscoveryAgent()
 QList<QBluetoothDeviceInfo> QBluetoothDeviceDiscoveryAgent::discoveredDevices() const
 {
     Q_D(const QBluetoothDeviceDiscoveryAgent);
-    return d->discoveredDevices;
+    return d->discoveredDevices.list();
+}
+
+// 'QBtD', followed by the version of the format
+static constexpr quint32 snapshotMagic = 0x51427444;
+static constexpr quint8 snapshotVersion = 1;
+
+/*!
+    Returns a snapshot of \l discoveredDevices(), which
+    \l restoreDiscoveredDevices() loads again, for example after the
+    application restarted. The snapshot is a compact binary representation of
+    the devices, including their advertisement data and how long ago they were
+    last seen.
+
+    \sa restoreDiscoveredDevices()
+    \since 6.5
+ */
+QByteArray QBluetoothDeviceDiscoveryAgent::saveDiscoveredDevices() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+
+    QByteArray snapshot;
+    QDataStream out(&snapshot, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << snapshotMagic << snapshotVersion << quint32(d->discoveredDevices.size());
+    for (qsizetype i = 0; i < d->discoveredDevices.size(); ++i) {
+        const QBluetoothDeviceInfo &info = d->discoveredDevices.at(i);
+        const quint32 classOfDevice = quint32(info.minorDeviceClass()) << 2
+                | quint32(info.majorDeviceClass()) << 8 | quint32(info.serviceClasses()) << 13;
+        out << info.address().toUInt64() << info.deviceUuid() << info.name() << classOfDevice
+            << quint8(info.coreConfigurations()) << info.rssi() << info.serviceUuids()
+            << info.manufacturerData() << info.serviceData()
+            << d->discoveredDevices.msecsSinceSeen(i);
+    }
+    return snapshot;
+}
+
+/*!
+    Replaces \l discoveredDevices() with the devices of \a snapshot, which
+    was returned by \l saveDiscoveredDevices(). The table is warm right away,
+    instead of being filled by a full search.
+
+    The devices are marked as \l {QBluetoothDeviceInfo::isCached()}{cached}
+    until they are seen again, they are kept by the next \l start(). A search
+    which finds them again updates their entries rather than adding new ones,
+    the same way as for devices it found itself. Devices
+    which are not found again age out according to
+    \l setDeviceLostTimeout(), counting from the time they were last seen
+    before the snapshot was taken. \l setMaximumDiscoveredDevices() applies
+    as well.
+
+    Returns \c false and leaves the devices unchanged if the search is active
+    or \a snapshot is invalid.
+
+    \sa saveDiscoveredDevices()
+    \since 6.5
+ */
+bool QBluetoothDeviceDiscoveryAgent::restoreDiscoveredDevices(const QByteArray &snapshot)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    if (isActive()) {
+        qCWarning(QT_BT) << "Cannot restore the discovered devices during a device search";
+        return false;
+    }
+
+    QDataStream in(snapshot);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint8 version = 0;
+    quint32 count = 0;
+    in >> magic >> version >> count;
+    if (in.status() != QDataStream::Ok || magic != snapshotMagic || version != snapshotVersion) {
+        qCWarning(QT_BT) << "Invalid snapshot of discovered devices";
+        return false;
+    }
+
+    QList<QBluetoothDeviceInfo> devices;
+    QList<qint64> ages;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        quint64 address = 0;
+        QBluetoothUuid deviceUuid;
+        QString name;
+        quint32 classOfDevice = 0;
+        quint8 coreConfigurations = 0;
+        qint16 rssi = 0;
+        QList<QBluetoothUuid> serviceUuids;
+        QMultiHash<quint16, QByteArray> manufacturerData;
+        QMultiHash<QBluetoothUuid, QByteArray> serviceData;
+        qint64 age = 0;
+        in >> address >> deviceUuid >> name >> classOfDevice >> coreConfigurations >> rssi
+           >> serviceUuids >> manufacturerData >> serviceData >> age;
+
+        QBluetoothDeviceInfo info = address
+                ? QBluetoothDeviceInfo(QBluetoothAddress(address), name, classOfDevice)
+                : QBluetoothDeviceInfo(deviceUuid, name, classOfDevice);
+        if (address)
+            info.setDeviceUuid(deviceUuid);
+        info.setCoreConfigurations(
+                QBluetoothDeviceInfo::CoreConfigurations::fromInt(coreConfigurations));
+        info.setRssi(rssi);
+        info.setServiceUuids(serviceUuids);
+        for (auto it = manufacturerData.cbegin(); it != manufacturerData.cend(); ++it)
+            info.setManufacturerData(it.key(), it.value());
+        for (auto it = serviceData.cbegin(); it != serviceData.cend(); ++it)
+            info.setServiceData(it.key(), it.value());
+        info.setCached(true);
+        devices.append(info);
+        ages.append(qMax<qint64>(age, 0));
+    }
+    if (in.status() != QDataStream::Ok) {
+        qCWarning(QT_BT) << "Truncated snapshot of discovered devices";
+        return false;
+    }
+
+    d->discoveredDevices.clear();
+    for (qsizetype i = 0; i < devices.size(); ++i) {
+        if (d->maximumDevices > 0 && d->discoveredDevices.size() >= d->maximumDevices)
+            break;
+        d->discoveredDevices.appendRestored(devices.at(i), ages.at(i));
+    }
+    d->keepRestoredDevices = true;
+    return true;
 }
 
 /*!
@@ -266,6 +472,651 @@ int QBluetoothDeviceDiscoveryAgent::lowEnergyDiscoveryTimeout() const
     return d->lowEnergySearchTimeout;
 }
 
+/*!
+    Limits the number of devices kept in \l discoveredDevices() to \a count.
+    Once the limit is reached, the device which has not been seen for the
+    longest time is removed for every newly discovered device and
+    \l deviceLost() is emitted for it. A value of \c 0, the default, means
+    that there is no limit.
+
+    This is mostly useful for never-ending searches, see
+    \l setLowEnergyDiscoveryTimeout(), in environments with many passing
+    devices or devices using random addresses.
+
+    \sa maximumDiscoveredDevices(), setDeviceLostTimeout()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setMaximumDiscoveredDevices(int count)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    if (count < 0) {
+        qCDebug(QT_BT) << "The maximum number of discovered devices cannot be negative.";
+        return;
+    }
+    d->maximumDevices = count;
+}
+
+/*!
+    Returns the maximum number of devices kept in \l discoveredDevices().
+
+    \sa setMaximumDiscoveredDevices()
+    \since 6.5
+ */
+int QBluetoothDeviceDiscoveryAgent::maximumDiscoveredDevices() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->maximumDevices;
+}
+
+/*!
+    Removes devices which have not been seen for \a msTimeout milliseconds
+    from \l discoveredDevices() while the search is active and emits
+    \l deviceLost() for them. A value of \c 0, the default, keeps the
+    devices until the next search is started.
+
+    A device counts as seen whenever the platform reports it or an update of
+    its data. The timeout should therefore be considerably larger than the
+    advertising interval of the devices of interest.
+
+    \sa deviceLostTimeout(), setMaximumDiscoveredDevices()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setDeviceLostTimeout(int msTimeout)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    if (msTimeout < 0) {
+        qCDebug(QT_BT) << "The device lost timeout cannot be negative.";
+        return;
+    }
+    d->deviceLostTimeout = msTimeout;
+    if (d->deviceLostTimer && msTimeout == 0)
+        d->deviceLostTimer->stop();
+}
+
+/*!
+    Returns the time in milliseconds after which a device that has not been
+    seen is removed from \l discoveredDevices().
+
+    \sa setDeviceLostTimeout()
+    \since 6.5
+ */
+int QBluetoothDeviceDiscoveryAgent::deviceLostTimeout() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->deviceLostTimeout;
+}
+
+/*!
+    \class QBluetoothAdvertisementReport
+    \inmodule QtBluetooth
+    \brief The QBluetoothAdvertisementReport struct holds a single received
+    advertisement.
+
+    \since 6.5
+
+    The struct is a plain data type of fixed size, see
+    \l QBluetoothDeviceDiscoveryAgent::setAdvertisementReportBufferSize().
+
+    \list
+    \li \c address is the Bluetooth address of the sender as returned by
+        QBluetoothAddress::toUInt64(). It is \c 0 on macOS and iOS.
+    \li \c deviceUuid identifies the sender on macOS and iOS, see
+        QBluetoothDeviceInfo::deviceUuid(). It is null on all other platforms.
+    \li \c timestamp is the time of reception in milliseconds of the monotonic
+        clock used by QDeadlineTimer.
+    \li \c rssi is the received signal strength in dBm.
+    \li \c data holds \c dataSize bytes of advertising data structures
+        (length, type, value). Longer advertising data is truncated.
+    \endlist
+
+    \note Only BlueZ with the Bluetooth Management socket enabled reports
+    the advertising data exactly as it was received. All other backends
+    re-encode the manufacturer specific data and service data the platform
+    provides, other advertising data types are missing.
+*/
+
+/*!
+    Enables a lightweight stream of advertisement reports by preallocating a
+    ring buffer for \a reports entries. A value of \c 0, the default,
+    disables it.
+
+    While enabled, every advertisement the platform reports during the
+    search is stored as a QBluetoothAdvertisementReport, in addition to the
+    usual deviceDiscovered() and deviceUpdated() signals. Storing a report
+    does not allocate memory. If the buffer is full, the oldest report is
+    overwritten. Applications tracking many beacons should drain the buffer
+    in batches in response to advertisementReportsAvailable().
+
+    Changing the size discards all pending reports.
+
+    \sa takeAdvertisementReports(), advertisementReportBufferSize()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setAdvertisementReportBufferSize(int reports)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    if (reports < 0) {
+        qCDebug(QT_BT) << "The advertisement report buffer size cannot be negative.";
+        return;
+    }
+    d->reportBuffer.resize(reports);
+    d->reportBuffer.squeeze();
+    d->reportHead = 0;
+    d->reportCount = 0;
+}
+
+/*!
+    Returns the number of advertisement reports which can be buffered.
+
+    \sa setAdvertisementReportBufferSize()
+    \since 6.5
+ */
+int QBluetoothDeviceDiscoveryAgent::advertisementReportBufferSize() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return int(d->reportBuffer.size());
+}
+
+/*!
+    Moves up to \a maxCount of the oldest buffered advertisement reports
+    into the array \a reports and returns how many were moved.
+
+    \sa advertisementReportsAvailable(), setAdvertisementReportBufferSize()
+    \since 6.5
+ */
+qsizetype QBluetoothDeviceDiscoveryAgent::takeAdvertisementReports(
+        QBluetoothAdvertisementReport *reports, qsizetype maxCount)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    const qsizetype count = qMin(maxCount, d->reportCount);
+    const qsizetype capacity = d->reportBuffer.size();
+    qsizetype taken = 0;
+    while (taken < count) {
+        // at most two contiguous blocks
+        const qsizetype chunk = qMin(count - taken, capacity - d->reportHead);
+        memcpy(reports + taken, d->reportBuffer.constData() + d->reportHead,
+               chunk * sizeof(QBluetoothAdvertisementReport));
+        taken += chunk;
+        d->reportHead = (d->reportHead + chunk) % capacity;
+    }
+    d->reportCount -= taken;
+    return taken;
+}
+
+/*!
+    Limits the device search to devices which advertise at least one of the
+    services in \a uuids. An empty list, the default, disables the filter.
+
+    Like the other discovery filters, the new value does not take effect
+    until the device search is restarted. The filters are applied by the
+    Bluetooth stack, devices not matching them are not reported to the
+    application at all.
+
+    \note Currently the discovery filters are only supported by BlueZ.
+    Android supports the service UUID, name and manufacturer filters of the
+    Bluetooth Low Energy device search, which it offloads to the Bluetooth
+    controller when possible. macOS and iOS support the service UUID filter
+    of the Bluetooth Low Energy device search. Other platforms ignore them.
+
+    \sa serviceUuidFilter(), setRssiThreshold(), setPathlossThreshold()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setServiceUuidFilter(const QList<QBluetoothUuid> &uuids)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    d->serviceUuidFilter = uuids;
+}
+
+/*!
+    Returns the service UUIDs the device search is limited to.
+
+    \sa setServiceUuidFilter()
+    \since 6.5
+ */
+QList<QBluetoothUuid> QBluetoothDeviceDiscoveryAgent::serviceUuidFilter() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->serviceUuidFilter;
+}
+
+/*!
+    Limits the device search to devices whose received signal strength is at
+    least \a rssi dBm. A value of \c 0, the default, disables the filter.
+
+    If both an RSSI and a pathloss threshold are set, only the RSSI threshold
+    is applied.
+
+    \sa rssiThreshold(), setPathlossThreshold(), setServiceUuidFilter()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setRssiThreshold(qint16 rssi)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    d->rssiThreshold = rssi;
+}
+
+/*!
+    Returns the RSSI threshold of the device search.
+
+    \sa setRssiThreshold()
+    \since 6.5
+ */
+qint16 QBluetoothDeviceDiscoveryAgent::rssiThreshold() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->rssiThreshold;
+}
+
+/*!
+    Limits the device search to devices whose pathloss, the difference
+    between the advertised transmit power and the received signal strength,
+    is at most \a pathloss dB. Devices which do not advertise their transmit
+    power are not reported. A value of \c 0, the default, disables the filter.
+
+    \sa pathlossThreshold(), setRssiThreshold(), setServiceUuidFilter()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setPathlossThreshold(quint16 pathloss)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    d->pathlossThreshold = pathloss;
+}
+
+/*!
+    Returns the pathloss threshold of the device search.
+
+    \sa setPathlossThreshold()
+    \since 6.5
+ */
+quint16 QBluetoothDeviceDiscoveryAgent::pathlossThreshold() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->pathlossThreshold;
+}
+
+/*!
+    Sets whether every received advertisement of a device is reported, even
+    if its data did not change, to \a report. This is the default. Disabling
+    it lets the Bluetooth controller drop repeated advertisements, which
+    reduces the load in crowded environments, but also the frequency of RSSI
+    updates via \l deviceUpdated().
+
+    \sa reportsDuplicateData()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setReportDuplicateData(bool report)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    d->reportDuplicateData = report;
+}
+
+/*!
+    Returns whether repeated advertisements with unchanged data are reported.
+
+    \sa setReportDuplicateData()
+    \since 6.5
+ */
+bool QBluetoothDeviceDiscoveryAgent::reportsDuplicateData() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->reportDuplicateData;
+}
+
+/*!
+    Limits the device search to devices which advertise one of the
+    \a names as their complete local name. An empty list, the default,
+    disables the filter.
+
+    Different kinds of filters must all be matched by a device, within one
+    filter any of the listed values is sufficient.
+
+    \sa nameFilter(), setServiceUuidFilter(), setManufacturerIdFilter()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setNameFilter(const QStringList &names)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    d->nameFilter = names;
+}
+
+/*!
+    Returns the device names the device search is limited to.
+
+    \sa setNameFilter()
+    \since 6.5
+ */
+QStringList QBluetoothDeviceDiscoveryAgent::nameFilter() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->nameFilter;
+}
+
+/*!
+    Limits the device search to devices which advertise manufacturer specific
+    data for one of the company identifiers in \a ids. An empty list, the
+    default, disables the filter.
+
+    \sa manufacturerIdFilter(), setNameFilter(), setServiceUuidFilter()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setManufacturerIdFilter(const QList<quint16> &ids)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    d->manufacturerIdFilter = ids;
+}
+
+/*!
+    Returns the manufacturer identifiers the device search is limited to.
+
+    \sa setManufacturerIdFilter()
+    \since 6.5
+ */
+QList<quint16> QBluetoothDeviceDiscoveryAgent::manufacturerIdFilter() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->manufacturerIdFilter;
+}
+
+/*!
+    Registers the identity resolving  key (IRK) of the Bluetooth Low Energy
+    device with  identityAddress. The key has 16 bytes, the most significant
+    byte first.
+
+    Devices with privacy enabled advertise with a resolvable private address,
+    which changes every few minutes. The addresses which the key resolves are
+    treated as the same device, the device keeps its entry in
+    discoveredDevices() and is reported by deviceDiscovered() or
+    deviceUpdated() under its current address. Use identityAddress() to map
+    the address to the identity of the device.
+
+    Returns \c false if  key does not have 16 bytes or  identityAddress is
+    null.
+
+    \sa removeIdentityResolvingKey(), identityAddress()
+    \since 6.5
+ */
+bool QBluetoothDeviceDiscoveryAgent::addIdentityResolvingKey(
+        const QBluetoothAddress &identityAddress, const QByteArray &key)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    if (!d->addressResolver.addKey(identityAddress, key)) {
+        qCWarning(QT_BT) << "Ignoring invalid identity resolving key for" << identityAddress;
+        return false;
+    }
+    d->discoveredDevices.setAddressResolver(&d->addressResolver);
+    return true;
+}
+
+/*!
+    Removes the identity resolving key of the device with  identityAddress.
+
+    \sa addIdentityResolvingKey()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::removeIdentityResolvingKey(
+        const QBluetoothAddress &identityAddress)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    if (d->addressResolver.removeKey(identityAddress))
+        d->discoveredDevices.setAddressResolver(&d->addressResolver);
+}
+
+/*!
+    Returns the identity address of the device which used  address, or a
+    null address if none of the keys registered via addIdentityResolvingKey()
+    resolves  address. An identity address is returned as it is.
+
+    \sa addIdentityResolvingKey()
+    \since 6.5
+ */
+QBluetoothAddress QBluetoothDeviceDiscoveryAgent::identityAddress(
+        const QBluetoothAddress &address) const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->addressResolver.resolve(address);
+}
+
+/*!
+    Sets the scan mode of the Bluetooth Low Energy device search to \a mode.
+    The new value does not take effect until the device search is restarted.
+
+    \note Currently the scan mode is only supported on Android.
+
+    \sa lowEnergyScanMode()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setLowEnergyScanMode(LowEnergyScanMode mode)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    d->lowEnergyScanMode = mode;
+}
+
+/*!
+    Returns the scan mode of the Bluetooth Low Energy device search.
+
+    \sa setLowEnergyScanMode()
+    \since 6.5
+ */
+QBluetoothDeviceDiscoveryAgent::LowEnergyScanMode QBluetoothDeviceDiscoveryAgent::lowEnergyScanMode() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->lowEnergyScanMode;
+}
+
+/*!
+    Lets the Bluetooth controller collect the advertisements of the Bluetooth
+    Low Energy device search for up to \a msecs milliseconds before they are
+    reported together. This lets the application processor sleep during a
+    continuous search, at the expense of a later \l deviceDiscovered(). A
+    value of \c 0, the default, reports every advertisement immediately.
+
+    The delay is ignored if the controller does not support batched scan
+    results. The new value does not take effect until the device search is
+    restarted.
+
+    \note Currently the report delay is only supported on Android.
+
+    \sa lowEnergyReportDelay()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setLowEnergyReportDelay(int msecs)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    if (msecs < 0) {
+        qCDebug(QT_BT) << "The Bluetooth Low Energy report delay cannot be negative.";
+        return;
+    }
+    d->lowEnergyReportDelay = msecs;
+}
+
+/*!
+    Returns the report delay of the Bluetooth Low Energy device search in
+    milliseconds.
+
+    \sa setLowEnergyReportDelay()
+    \since 6.5
+ */
+int QBluetoothDeviceDiscoveryAgent::lowEnergyReportDelay() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->lowEnergyReportDelay;
+}
+
+/*!
+    Asks the Bluetooth controller to scan for \a windowMsecs milliseconds
+    every \a intervalMsecs milliseconds during the Bluetooth Low Energy device
+    search. A lower duty cycle saves power, but devices which advertise
+    rarely are found later. Passing \c 0 for both, the default, leaves the
+    timing to the platform.
+
+    The interval must be between 3 and 10240 milliseconds and the window must
+    not exceed it. Other values are ignored. The parameters are a hint, the
+    platform may scan more often, for example on behalf of other applications.
+    They take precedence over \l lowEnergyScanMode(). The new values do not
+    take effect until the device search is restarted.
+
+    \note Currently the scan parameters are supported on Linux with BlueZ,
+    which requires the \c CAP_NET_ADMIN capability and changes the parameters
+    of all device searches on the adapter while the search runs, and on
+    Android, which uses the scan mode with the nearest duty cycle.
+
+    \sa lowEnergyScanInterval(), lowEnergyScanWindow(), setLowEnergyScanMode()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setLowEnergyScanParameters(int intervalMsecs,
+                                                                 int windowMsecs)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    if (intervalMsecs == 0 && windowMsecs == 0) {
+        d->lowEnergyScanInterval = d->lowEnergyScanWindow = 0;
+        return;
+    }
+    // Bluetooth Core Specification v5.3, Vol 4, Part E, 7.8.10
+    if (intervalMsecs < 3 || intervalMsecs > 10240 || windowMsecs < 3
+            || windowMsecs > intervalMsecs) {
+        qCDebug(QT_BT) << "Invalid Bluetooth Low Energy scan parameters" << intervalMsecs
+                       << windowMsecs;
+        return;
+    }
+    d->lowEnergyScanInterval = intervalMsecs;
+    d->lowEnergyScanWindow = windowMsecs;
+}
+
+/*!
+    Returns the scan interval of the Bluetooth Low Energy device search in
+    milliseconds, or \c 0 if the platform chooses it.
+
+    \sa setLowEnergyScanParameters()
+    \since 6.5
+ */
+int QBluetoothDeviceDiscoveryAgent::lowEnergyScanInterval() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->lowEnergyScanInterval;
+}
+
+/*!
+    Returns the scan window of the Bluetooth Low Energy device search in
+    milliseconds, or \c 0 if the platform chooses it.
+
+    \sa setLowEnergyScanParameters()
+    \since 6.5
+ */
+int QBluetoothDeviceDiscoveryAgent::lowEnergyScanWindow() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->lowEnergyScanWindow;
+}
+
+/*!
+    Sets whether the Bluetooth Low Energy device search scans passively to
+    \a enabled. The default is \c false.
+
+    An active scan sends a scan request to every advertising device, which
+    answers with its scan response. A passive scan only listens, which halves
+    the radio traffic and the wakeups of the host. Data which devices only
+    put in their scan response, often their name, is not found then. The new
+    value does not take effect until the device search is restarted.
+
+    \note Currently passive scanning is only supported on Windows. BlueZ,
+    Android and Core Bluetooth always scan actively for a device search.
+
+    \sa isLowEnergyPassiveScanEnabled()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::setLowEnergyPassiveScanEnabled(bool enabled)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    d->lowEnergyPassiveScan = enabled;
+}
+
+/*!
+    Returns \c true if the Bluetooth Low Energy device search scans
+    passively; otherwise returns \c false.
+
+    \sa setLowEnergyPassiveScanEnabled()
+    \since 6.5
+ */
+bool QBluetoothDeviceDiscoveryAgent::isLowEnergyPassiveScanEnabled() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->lowEnergyPassiveScan;
+}
+
+/*!
+    Synchronizes to the periodic advertising of the Bluetooth Low Energy
+    \a device. Periodic advertising carries connectionless data, such as
+    sensor readings, at fixed intervals. Every update is reported via
+    periodicAdvertisingReceived() until stopPeriodicAdvertisingSync() is
+    called or periodicAdvertisingSyncLost() is emitted.
+
+    The device must have been found by a running Bluetooth Low Energy device
+    search, which provides the information needed to find its periodic
+    advertising. The synchronization is established as soon as the device is
+    seen, it may therefore be requested before the device is discovered. If the
+    synchronization cannot be established, errorOccurred() is emitted with
+    \l InputOutputError.
+
+    \note Currently periodic advertising is only supported with BlueZ and
+    requires the \c CAP_NET_ADMIN capability as well as a controller which
+    supports Bluetooth 5 extended scanning. On other platforms
+    \l UnsupportedPlatformError is emitted.
+
+    \sa stopPeriodicAdvertisingSync(), QLowEnergyController::setPeriodicAdvertisingData()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::startPeriodicAdvertisingSync(const QBluetoothDeviceInfo &device)
+{
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+#if QT_CONFIG(bluez)
+    d->startPeriodicAdvertisingSync(device);
+#else
+    Q_UNUSED(device);
+    d->lastError = UnsupportedPlatformError;
+    d->errorString = QBluetoothDeviceDiscoveryAgent::tr("Periodic advertising is not supported "
+                                                        "on this platform");
+    emit errorOccurred(d->lastError);
+#endif
+}
+
+/*!
+    Stops the synchronization to the periodic advertising of \a device.
+
+    \sa startPeriodicAdvertisingSync()
+    \since 6.5
+ */
+void QBluetoothDeviceDiscoveryAgent::stopPeriodicAdvertisingSync(const QBluetoothDeviceInfo &device)
+{
+#if QT_CONFIG(bluez)
+    Q_D(QBluetoothDeviceDiscoveryAgent);
+    d->stopPeriodicAdvertisingSync(device);
+#else
+    Q_UNUSED(device);
+#endif
+}
+
+/*!
+    Returns the approximate memory held by the internal structures of this agent.
+
+    The reported structures are the discovered devices including their indexes
+    (\c discoveredDevices), the advertisement report buffer
+    (\c advertisementReports), the keys and the cache of the address resolver
+    (\c addressResolver) and the discovery filters (\c filters). On BlueZ the
+    devices with periodic advertising synchronization are reported as
+    \c periodicDevices.
+
+    With the \c qt.bluetooth.memory logging category enabled, the memory usage
+    is logged whenever \l finished() is emitted.
+
+    \sa QBluetoothMemoryUsage
+    \since 6.5
+ */
+QBluetoothMemoryUsage QBluetoothDeviceDiscoveryAgent::memoryUsage() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryAgent);
+    return d->memoryUsage();
+}
+
 /*!
     \fn QBluetoothDeviceDiscoveryAgent::DiscoveryMethods QBluetoothDeviceDiscoveryAgent::supportedDiscoveryMethods()
 
@@ -366,6 +1217,407 @@ QString QBluetoothDeviceDiscoveryAgent::errorString() const
     return d->errorString;
 }
 
+/*
+ * Adds a device which was not part of discoveredDevices so far, applying the
+ * limits set via setMaximumDiscoveredDevices() and setDeviceLostTimeout().
+ * The backends emit deviceDiscovered() afterwards.
+ */
+void QBluetoothDeviceDiscoveryAgentPrivate::addDiscoveredDevice(const QBluetoothDeviceInfo &info)
+{
+    if (maximumDevices > 0) {
+        while (discoveredDevices.size() >= maximumDevices)
+            deviceLost(discoveredDevices.takeLeastRecentlySeen());
+    }
+    discoveredDevices.append(info);
+    startDeviceLostTimer();
+}
+
+/*
+ * Called by the backends when a search starts. The devices of a restored
+ * snapshot are kept once, they age out with the search.
+ */
+void QBluetoothDeviceDiscoveryAgentPrivate::clearDiscoveredDevices()
+{
+    if (!std::exchange(keepRestoredDevices, false)) {
+        discoveredDevices.clear();
+        return;
+    }
+    if (!discoveredDevices.isEmpty())
+        startDeviceLostTimer();
+}
+
+void QBluetoothDeviceDiscoveryAgentPrivate::startDeviceLostTimer()
+{
+    if (deviceLostTimeout > 0) {
+        Q_Q(QBluetoothDeviceDiscoveryAgent);
+        if (!deviceLostTimer) {
+            deviceLostTimer = new QTimer(q);
+            QObject::connect(deviceLostTimer, &QTimer::timeout, q, [this]() {
+                removeLostDevices();
+            });
+        }
+        // the check is cheap, a coarse resolution is good enough
+        deviceLostTimer->setInterval(qMax(deviceLostTimeout / 4, 250));
+        if (!deviceLostTimer->isActive())
+            deviceLostTimer->start();
+    }
+}
+
+void QBluetoothDeviceDiscoveryAgentPrivate::removeLostDevices()
+{
+    // nothing refreshes the devices once the search is over
+    if (!isActive() || deviceLostTimeout == 0 || discoveredDevices.isEmpty()) {
+        deviceLostTimer->stop();
+        return;
+    }
+
+    const QList<QBluetoothDeviceInfo> lost = discoveredDevices.takeNotSeenFor(deviceLostTimeout);
+    for (const QBluetoothDeviceInfo &info : lost)
+        deviceLost(info);
+}
+
+void QBluetoothDeviceDiscoveryAgentPrivate::deviceLost(const QBluetoothDeviceInfo &info)
+{
+    Q_Q(QBluetoothDeviceDiscoveryAgent);
+    emit q->deviceLost(info);
+}
+
+QBluetoothMemoryUsage QBluetoothDeviceDiscoveryAgentPrivate::memoryUsage() const
+{
+    using namespace QBluetoothMemory;
+
+    QBluetoothMemoryUsage usage;
+    QBluetoothMemoryUsagePrivate::add(&usage, QStringLiteral("discoveredDevices"),
+                                      discoveredDevices.memoryUsage());
+    QBluetoothMemoryUsagePrivate::add(&usage, QStringLiteral("advertisementReports"),
+                                      bytes(reportBuffer));
+    QBluetoothMemoryUsagePrivate::add(&usage, QStringLiteral("addressResolver"),
+                                      addressResolver.memoryUsage());
+    QBluetoothMemoryUsagePrivate::add(&usage, QStringLiteral("filters"),
+                                      bytes(serviceUuidFilter)
+                                      + bytes(nameFilter, [](const QString &name) {
+                                            return bytes(name);
+                                        })
+                                      + bytes(manufacturerIdFilter));
+#if QT_CONFIG(bluez)
+    QBluetoothMemoryUsagePrivate::add(&usage, QStringLiteral("periodicDevices"),
+                                      bytes(periodicDevices, [](const QBluetoothDeviceInfo &info) {
+                                          return bytes(info);
+                                      }));
+#endif
+    return usage;
+}
+
+/*
+ * Returns the ring buffer slot for the next advertisement report with the
+ * timestamp set, or nullptr if reporting is disabled. The caller fills in the rest.
+ */
+QBluetoothAdvertisementReport *QBluetoothDeviceDiscoveryAgentPrivate::nextAdvertisementReport()
+{
+    const qsizetype capacity = reportBuffer.size();
+    if (capacity == 0)
+        return nullptr;
+
+    qsizetype slot;
+    if (reportCount == capacity) {
+        // overwrite the oldest report
+        slot = reportHead;
+        reportHead = (reportHead + 1) % capacity;
+    } else {
+        slot = (reportHead + reportCount) % capacity;
+        ++reportCount;
+    }
+
+    if (!reportsNotificationPending) {
+        // deferred, so that reports arriving in one go are drained together
+        reportsNotificationPending = true;
+        Q_Q(QBluetoothDeviceDiscoveryAgent);
+        QMetaObject::invokeMethod(q, [this]() {
+            reportsNotificationPending = false;
+            if (reportCount > 0)
+                emit q_ptr->advertisementReportsAvailable();
+        }, Qt::QueuedConnection);
+    }
+
+    QBluetoothAdvertisementReport *report = reportBuffer.data() + slot;
+    report->timestamp = QDeadlineTimer::current().deadline();
+    return report;
+}
+
+/*
+ * Stores a report for a platform which does not expose the raw advertising data,
+ * manufacturer and service data are encoded as AD structures.
+ */
+void QBluetoothDeviceDiscoveryAgentPrivate::reportAdvertisement(const QBluetoothDeviceInfo &info)
+{
+    QBluetoothAdvertisementReport *report = nextAdvertisementReport();
+    if (!report)
+        return;
+
+    report->address = info.address().toUInt64();
+    report->deviceUuid = info.deviceUuid().toUInt128();
+    report->rssi = info.rssi();
+
+    quint8 *out = report->data;
+    quint8 *const end = report->data + QBluetoothAdvertisementReport::MaximumDataSize;
+    const auto appendStructure = [&out, end](quint8 type, const uchar *prefix,
+                                             qsizetype prefixSize, const QByteArray &value) {
+        const qsizetype length = 1 + prefixSize + value.size();
+        if (length > 0xff || end - out < 1 + length)
+            return;
+        *out++ = quint8(length);
+        *out++ = type;
+        memcpy(out, prefix, prefixSize);
+        out += prefixSize;
+        memcpy(out, value.constData(), value.size());
+        out += value.size();
+    };
+
+    const QMultiHash<quint16, QByteArray> manufacturerData = info.manufacturerData();
+    for (auto it = manufacturerData.cbegin(); it != manufacturerData.cend(); ++it) {
+        uchar id[2];
+        qToLittleEndian(it.key(), id);
+        appendStructure(0xff, id, sizeof(id), it.value());
+    }
+
+    const QMultiHash<QBluetoothUuid, QByteArray> serviceData = info.serviceData();
+    for (auto it = serviceData.cbegin(); it != serviceData.cend(); ++it) {
+        uchar uuid[16];
+        bool ok = false;
+        if (const quint16 uuid16 = it.key().toUInt16(&ok); ok) {
+            qToLittleEndian(uuid16, uuid);
+            appendStructure(0x16, uuid, 2, it.value());
+        } else if (const quint32 uuid32 = it.key().toUInt32(&ok); ok) {
+            qToLittleEndian(uuid32, uuid);
+            appendStructure(0x20, uuid, 4, it.value());
+        } else {
+            const quint128 uuid128 = it.key().toUInt128();
+            for (int i = 0; i < 16; ++i)
+                uuid[i] = uuid128.data[15 - i];
+            appendStructure(0x21, uuid, 16, it.value());
+        }
+    }
+
+    report->dataSize = quint16(out - report->data);
+}
+
+void QBluetoothDiscoveredDevices::append(const QBluetoothDeviceInfo &info)
+{
+    insert(info, clock.elapsed(), false);
+}
+
+void QBluetoothDiscoveredDevices::appendRestored(const QBluetoothDeviceInfo &info, qint64 msecs)
+{
+    insert(info, clock.elapsed() - msecs, true);
+}
+
+void QBluetoothDiscoveredDevices::insert(const QBluetoothDeviceInfo &info, qint64 seen,
+                                         bool isRestored)
+{
+    const quint64 serial = nextSerial++;
+    devices.append(info);
+    serials.append(serial);
+    lastSeen.append(seen);
+    restored.append(isRestored);
+    seenOrder.insert(seen, serial);
+    index(devices.size() - 1);
+}
+
+qsizetype QBluetoothDiscoveredDevices::indexOfSerial(quint64 serial) const
+{
+    if (serial == 0)
+        return -1;
+    const auto it = std::lower_bound(serials.cbegin(), serials.cend(), serial);
+    Q_ASSERT(it != serials.cend() && *it == serial);
+    return it - serials.cbegin();
+}
+
+void QBluetoothDiscoveredDevices::markSeen(qsizetype i)
+{
+    const qint64 now = clock.elapsed();
+    if (lastSeen.at(i) != now) {
+        seenOrder.erase(seenOrder.find(lastSeen.at(i), serials.at(i)));
+        seenOrder.insert(now, serials.at(i));
+        lastSeen[i] = now;
+    }
+    if (restored.at(i)) {
+        restored[i] = false;
+        devices[i].setCached(false);
+    }
+}
+
+qsizetype QBluetoothDiscoveredDevices::indexOf(const QBluetoothAddress &address) const
+{
+    const qsizetype i = indexOfSerial(addressIndex.value(address.toUInt64()));
+    if (i >= 0 || !addressResolver || addressResolver->isEmpty())
+        return i;
+
+    const QBluetoothAddress identityAddress = addressResolver->resolve(address);
+    if (identityAddress.isNull())
+        return -1;
+    return indexOfSerial(identityIndex.value(identityAddress.toUInt64()));
+}
+
+void QBluetoothDiscoveredDevices::replace(qsizetype i, const QBluetoothDeviceInfo &info)
+{
+    unindex(i);
+    devices.replace(i, info);
+    restored[i] = false;
+    markSeen(i);
+    index(i);
+}
+
+void QBluetoothDiscoveredDevices::clear()
+{
+    devices.clear();
+    serials.clear();
+    lastSeen.clear();
+    restored.clear();
+    seenOrder.clear();
+    addressIndex.clear();
+    uuidIndex.clear();
+    identityIndex.clear();
+}
+
+void QBluetoothDiscoveredDevices::setAddressResolver(const LeAddressResolver *resolver)
+{
+    addressResolver = resolver;
+    rebuildIdentityIndex();
+}
+
+void QBluetoothDiscoveredDevices::index(qsizetype i)
+{
+    const QBluetoothDeviceInfo &info = devices.at(i);
+    const quint64 serial = serials.at(i);
+    if (!info.address().isNull())
+        addressIndex.insert(info.address().toUInt64(), serial);
+    if (!info.deviceUuid().isNull())
+        uuidIndex.insert(info.deviceUuid(), serial);
+    if (addressResolver) {
+        const QBluetoothAddress identityAddress = addressResolver->resolve(info.address());
+        if (!identityAddress.isNull())
+            identityIndex.insert(identityAddress.toUInt64(), serial);
+    }
+}
+
+// removes the index entries of i unless another entry took them over
+void QBluetoothDiscoveredDevices::unindex(qsizetype i)
+{
+    const auto removeOwned = [serial = serials.at(i)](auto &hash, const auto &key) {
+        const auto it = hash.find(key);
+        if (it != hash.end() && *it == serial)
+            hash.erase(it);
+    };
+
+    const QBluetoothDeviceInfo &info = devices.at(i);
+    removeOwned(addressIndex, info.address().toUInt64());
+    removeOwned(uuidIndex, info.deviceUuid());
+    if (addressResolver) {
+        const QBluetoothAddress identityAddress = addressResolver->resolve(info.address());
+        if (!identityAddress.isNull())
+            removeOwned(identityIndex, identityAddress.toUInt64());
+    }
+}
+
+void QBluetoothDiscoveredDevices::rebuildIdentityIndex()
+{
+    identityIndex.clear();
+    if (!addressResolver)
+        return;
+    for (qsizetype i = 0; i < devices.size(); ++i) {
+        const QBluetoothAddress identityAddress = addressResolver->resolve(devices.at(i).address());
+        if (!identityAddress.isNull())
+            identityIndex.insert(identityAddress.toUInt64(), serials.at(i));
+    }
+}
+
+QBluetoothDeviceInfo QBluetoothDiscoveredDevices::takeLeastRecentlySeen()
+{
+    Q_ASSERT(!devices.isEmpty());
+    const qsizetype i = indexOfSerial(seenOrder.first());
+    seenOrder.erase(seenOrder.begin());
+    unindex(i);
+    const QBluetoothDeviceInfo info = devices.takeAt(i);
+    serials.removeAt(i);
+    lastSeen.removeAt(i);
+    restored.removeAt(i);
+    return info;
+}
+
+QList<QBluetoothDeviceInfo> QBluetoothDiscoveredDevices::takeNotSeenFor(qint64 msecs)
+{
+    const qint64 threshold = clock.elapsed() - msecs;
+    QList<QBluetoothDeviceInfo> lost;
+    if (seenOrder.isEmpty() || seenOrder.firstKey() >= threshold)
+        return lost;
+
+    for (auto it = seenOrder.begin(); it != seenOrder.end() && it.key() < threshold;) {
+        unindex(indexOfSerial(*it));
+        it = seenOrder.erase(it);
+    }
+
+    // a single pass keeps the order of the remaining entries
+    qsizetype kept = 0;
+    for (qsizetype i = 0; i < devices.size(); ++i) {
+        if (lastSeen.at(i) < threshold) {
+            lost.append(devices.at(i));
+            continue;
+        }
+        if (kept != i) {
+            devices[kept] = devices.at(i);
+            serials[kept] = serials.at(i);
+            lastSeen[kept] = lastSeen.at(i);
+            restored[kept] = restored.at(i);
+        }
+        ++kept;
+    }
+    devices.resize(kept);
+    serials.resize(kept);
+    lastSeen.resize(kept);
+    restored.resize(kept);
+    return lost;
+}
+
+qsizetype QBluetoothDiscoveredDevices::memoryUsage() const
+{
+    using namespace QBluetoothMemory;
+
+    return bytes(devices, [](const QBluetoothDeviceInfo &info) { return bytes(info); })
+            + bytes(serials) + bytes(lastSeen) + bytes(restored) + bytes(seenOrder)
+            + bytes(addressIndex) + bytes(uuidIndex) + bytes(identityIndex);
+}
+
+/*
+ * Takes over the RSSI, manufacturer data and service data of the newly
+ * received \a info into the device at \a i and returns what was changed.
+ * Only these fields are compared, which is much cheaper than comparing
+ * the whole QBluetoothDeviceInfo for every received advertisement.
+ */
+QBluetoothDeviceInfo::Fields QBluetoothDiscoveredDevices::mergeAdvertisementData(
+        qsizetype i, const QBluetoothDeviceInfo &info)
+{
+    markSeen(i);
+    QBluetoothDeviceInfo &device = devices[i];
+    QBluetoothDeviceInfo::Fields updatedFields = QBluetoothDeviceInfo::Field::None;
+    if (device.rssi() != info.rssi()) {
+        device.setRssi(info.rssi());
+        updatedFields.setFlag(QBluetoothDeviceInfo::Field::RSSI);
+    }
+    if (device.manufacturerData() != info.manufacturerData()) {
+        const QList<quint16> keys = info.manufacturerIds();
+        for (auto key : keys)
+            device.setManufacturerData(key, info.manufacturerData(key));
+        updatedFields.setFlag(QBluetoothDeviceInfo::Field::ManufacturerData);
+    }
+    if (device.serviceData() != info.serviceData()) {
+        const QList<QBluetoothUuid> keys = info.serviceIds();
+        for (auto key : keys)
+            device.setServiceData(key, info.serviceData(key));
+        updatedFields.setFlag(QBluetoothDeviceInfo::Field::ServiceData);
+    }
+    return updatedFields;
+}
+
 QT_END_NAMESPACE
 
 #include "moc_qbluetoothdevicediscoveryagent.cpp"
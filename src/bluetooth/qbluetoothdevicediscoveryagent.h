@@ -8,13 +8,28 @@
 #include <QtBluetooth/qtbluetoothglobal.h>
 
 #include <QtCore/QObject>
+#include <QtCore/QStringList>
 #include <QtBluetooth/QBluetoothDeviceInfo>
 #include <QtBluetooth/QBluetoothAddress>
+#include <QtBluetooth/QBluetoothMemoryUsage>
 
 QT_BEGIN_NAMESPACE
 
 class QBluetoothDeviceDiscoveryAgentPrivate;
 
+struct QBluetoothAdvertisementReport
+{
+    enum { MaximumDataSize = 251 };
+
+    quint64 address;
+    quint128 deviceUuid;
+    qint64 timestamp;
+    qint16 rssi;
+    quint16 dataSize;
+    quint8 data[MaximumDataSize];
+};
+Q_DECLARE_TYPEINFO(QBluetoothAdvertisementReport, Q_PRIMITIVE_TYPE);
+
 class Q_BLUETOOTH_EXPORT QBluetoothDeviceDiscoveryAgent : public QObject
 {
     Q_OBJECT
@@ -44,6 +59,13 @@ public:
     Q_DECLARE_FLAGS(DiscoveryMethods, DiscoveryMethod)
     Q_FLAG(DiscoveryMethods)
 
+    enum class LowEnergyScanMode {
+        Balanced,
+        LowLatency,
+        LowPower
+    };
+    Q_ENUM(LowEnergyScanMode)
+
     explicit QBluetoothDeviceDiscoveryAgent(QObject *parent = nullptr);
     explicit QBluetoothDeviceDiscoveryAgent(const QBluetoothAddress &deviceAdapter,
                                             QObject *parent = nullptr);
@@ -55,10 +77,54 @@ public:
     QString errorString() const;
 
     QList<QBluetoothDeviceInfo> discoveredDevices() const;
+    QByteArray saveDiscoveredDevices() const;
+    bool restoreDiscoveredDevices(const QByteArray &snapshot);
 
     void setLowEnergyDiscoveryTimeout(int msTimeout);
     int lowEnergyDiscoveryTimeout() const;
 
+    void setMaximumDiscoveredDevices(int count);
+    int maximumDiscoveredDevices() const;
+    void setDeviceLostTimeout(int msTimeout);
+    int deviceLostTimeout() const;
+
+    void setAdvertisementReportBufferSize(int reports);
+    int advertisementReportBufferSize() const;
+    qsizetype takeAdvertisementReports(QBluetoothAdvertisementReport *reports,
+                                       qsizetype maxCount);
+
+    void setServiceUuidFilter(const QList<QBluetoothUuid> &uuids);
+    QList<QBluetoothUuid> serviceUuidFilter() const;
+    void setRssiThreshold(qint16 rssi);
+    qint16 rssiThreshold() const;
+    void setPathlossThreshold(quint16 pathloss);
+    quint16 pathlossThreshold() const;
+    void setReportDuplicateData(bool report);
+    bool reportsDuplicateData() const;
+    void setNameFilter(const QStringList &names);
+    QStringList nameFilter() const;
+    void setManufacturerIdFilter(const QList<quint16> &ids);
+    QList<quint16> manufacturerIdFilter() const;
+
+    bool addIdentityResolvingKey(const QBluetoothAddress &identityAddress, const QByteArray &key);
+    void removeIdentityResolvingKey(const QBluetoothAddress &identityAddress);
+    QBluetoothAddress identityAddress(const QBluetoothAddress &address) const;
+
+    void setLowEnergyScanMode(LowEnergyScanMode mode);
+    LowEnergyScanMode lowEnergyScanMode() const;
+    void setLowEnergyReportDelay(int msecs);
+    int lowEnergyReportDelay() const;
+    void setLowEnergyScanParameters(int intervalMsecs, int windowMsecs);
+    int lowEnergyScanInterval() const;
+    int lowEnergyScanWindow() const;
+    void setLowEnergyPassiveScanEnabled(bool enabled);
+    bool isLowEnergyPassiveScanEnabled() const;
+
+    void startPeriodicAdvertisingSync(const QBluetoothDeviceInfo &device);
+    void stopPeriodicAdvertisingSync(const QBluetoothDeviceInfo &device);
+
+    QBluetoothMemoryUsage memoryUsage() const;
+
     static DiscoveryMethods supportedDiscoveryMethods();
 public Q_SLOTS:
     void start();
@@ -68,6 +134,10 @@ public Q_SLOTS:
 Q_SIGNALS:
     void deviceDiscovered(const QBluetoothDeviceInfo &info);
     void deviceUpdated(const QBluetoothDeviceInfo &info, QBluetoothDeviceInfo::Fields updatedFields);
+    void deviceLost(const QBluetoothDeviceInfo &info);
+    void advertisementReportsAvailable();
+    void periodicAdvertisingReceived(const QBluetoothDeviceInfo &info, const QByteArray &data);
+    void periodicAdvertisingSyncLost(const QBluetoothDeviceInfo &info);
     void finished();
     void errorOccurred(QBluetoothDeviceDiscoveryAgent::Error error);
     void canceled();
@@ -174,7 +174,7 @@ void QBluetoothDeviceDiscoveryAgentPrivate::start(QBluetoothDeviceDiscoveryAgent
         QObject::connect(receiver, SIGNAL(finished()), this, SLOT(processSdpDiscoveryFinished()));
     }
 
-    discoveredDevices.clear();
+    clearDiscoveredDevices();
 
     // by arbitrary definition we run classic search first
     if (requestedMethods & QBluetoothDeviceDiscoveryAgent::ClassicMethod) {
@@ -280,62 +280,48 @@ void QBluetoothDeviceDiscoveryAgentPrivate::processDiscoveredDevices(
 
     Q_Q(QBluetoothDeviceDiscoveryAgent);
 
+    reportAdvertisement(info);
+
     // Android Classic scan and LE scan can find the same device under different names
     // The classic name finds the SDP based device name, the LE scan finds the name in
     // the advertisement package.
     // If address is same but name different then we keep both entries.
 
-    for (qsizetype i = 0; i < discoveredDevices.size(); ++i) {
-        if (discoveredDevices[i].address() == info.address()) {
-            QBluetoothDeviceInfo::Fields updatedFields = QBluetoothDeviceInfo::Field::None;
-            if (discoveredDevices[i].rssi() != info.rssi()) {
-                qCDebug(QT_BT_ANDROID) << "Updating RSSI for" << info.address()
-                                       << info.rssi();
-                discoveredDevices[i].setRssi(info.rssi());
-                updatedFields.setFlag(QBluetoothDeviceInfo::Field::RSSI);
-            }
-            if (discoveredDevices[i].manufacturerData() != info.manufacturerData()) {
-                qCDebug(QT_BT_ANDROID) << "Updating manufacturer data for" << info.address();
-                const QList<quint16> keys = info.manufacturerIds();
-                for (auto key: keys)
-                    discoveredDevices[i].setManufacturerData(key, info.manufacturerData(key));
-                updatedFields.setFlag(QBluetoothDeviceInfo::Field::ManufacturerData);
-            }
-            if (discoveredDevices[i].serviceData() != info.serviceData()) {
-                qCDebug(QT_BT_ANDROID) << "Updating service data for" << info.address();
-                const QList<QBluetoothUuid> keys = info.serviceIds();
-                for (auto key : keys)
-                    discoveredDevices[i].setServiceData(key, info.serviceData(key));
-                updatedFields.setFlag(QBluetoothDeviceInfo::Field::ServiceData);
-            }
+    const qsizetype i = discoveredDevices.indexOf(info.address());
+    if (i >= 0) {
+        const QBluetoothDeviceInfo::Fields updatedFields =
+                discoveredDevices.mergeAdvertisementData(i, info);
+        if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None)) {
+            qCDebug(QT_BT_ANDROID) << "Updating" << updatedFields << "for" << info.address()
+                                   << info.rssi();
+        }
 
-            if (lowEnergySearchTimeout > 0) {
-                if (discoveredDevices[i] != info) {
-                    if (discoveredDevices.at(i).name() == info.name()) {
-                        qCDebug(QT_BT_ANDROID) << "Almost Duplicate " << info.address()
-                                               << info.name() << "- replacing in place";
-                        discoveredDevices.replace(i, info);
-                        emit q->deviceDiscovered(info);
-                    }
-                } else {
-                    if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
-                        emit q->deviceUpdated(discoveredDevices[i], updatedFields);
+        if (lowEnergySearchTimeout > 0) {
+            if (discoveredDevices.at(i) != info) {
+                if (discoveredDevices.at(i).name() == info.name()) {
+                    qCDebug(QT_BT_ANDROID) << "Almost Duplicate " << info.address()
+                                           << info.name() << "- replacing in place";
+                    discoveredDevices.replace(i, info);
+                    emit q->deviceDiscovered(info);
                 }
-
-                return;
+            } else {
+                if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
+                    emit q->deviceUpdated(discoveredDevices.at(i), updatedFields);
             }
 
-            discoveredDevices.replace(i, info);
-            emit q->deviceDiscovered(info);
-
-            if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
-                emit q->deviceUpdated(discoveredDevices[i], updatedFields);
-
             return;
         }
+
+        discoveredDevices.replace(i, info);
+        emit q->deviceDiscovered(info);
+
+        if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
+            emit q->deviceUpdated(discoveredDevices.at(i), updatedFields);
+
+        return;
     }
 
-    discoveredDevices.append(info);
+    addDiscoveredDevice(info);
     qCDebug(QT_BT_ANDROID) << "Device found: " << info.name() << info.address().toString()
                            << "isLeScanResult:" << isLeResult
                            << "Manufacturer data size:" << info.manufacturerData().size();
@@ -360,6 +346,33 @@ void QBluetoothDeviceDiscoveryAgentPrivate::startLowEnergyScan()
         leScanner.setField<jlong>("qtObject", reinterpret_cast<long>(receiver));
     }
 
+    // must be in sync with android.bluetooth.le.ScanSettings
+    jint scanMode = 1; // SCAN_MODE_BALANCED
+    if (lowEnergyScanMode == QBluetoothDeviceDiscoveryAgent::LowEnergyScanMode::LowPower)
+        scanMode = 0; // SCAN_MODE_LOW_POWER
+    else if (lowEnergyScanMode == QBluetoothDeviceDiscoveryAgent::LowEnergyScanMode::LowLatency)
+        scanMode = 2; // SCAN_MODE_LOW_LATENCY
+    // ScanSettings has no interval and window, pick the mode with the nearest duty cycle
+    // of 10, 25 and 100 percent
+    if (lowEnergyScanInterval > 0) {
+        const double dutyCycle = double(lowEnergyScanWindow) / lowEnergyScanInterval;
+        scanMode = dutyCycle > 0.5 ? 2 : (dutyCycle > 0.15 ? 1 : 0);
+    }
+    leScanner.callMethod<void>("setScanSettings", "(IJ)V", scanMode, jlong(lowEnergyReportDelay));
+
+    leScanner.callMethod<void>("clearScanFilters");
+    for (const QString &name : std::as_const(nameFilter)) {
+        leScanner.callMethod<void>("addScanNameFilter", "(Ljava/lang/String;)V",
+                                   QJniObject::fromString(name).object<jstring>());
+    }
+    for (const QBluetoothUuid &uuid : std::as_const(serviceUuidFilter)) {
+        const QString uuidString = uuid.toString(QUuid::WithoutBraces);
+        leScanner.callMethod<void>("addScanServiceUuidFilter", "(Ljava/lang/String;)V",
+                                   QJniObject::fromString(uuidString).object<jstring>());
+    }
+    for (quint16 id : std::as_const(manufacturerIdFilter))
+        leScanner.callMethod<void>("addScanManufacturerIdFilter", "(I)V", jint(id));
+
     jboolean result = leScanner.callMethod<jboolean>("scanForLeDevice", "(Z)Z", true);
     if (!result) {
         qCWarning(QT_BT_ANDROID) << "Cannot start BTLE device scanner";
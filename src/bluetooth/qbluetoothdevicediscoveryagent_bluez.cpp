@@ -8,11 +8,13 @@
 #include "qbluetoothuuid.h"
 
 #include "bluez/bluez5_helper_p.h"
-#include "bluez/objectmanager_p.h"
 #include "bluez/adapter1_bluez5_p.h"
 #include "bluez/device1_bluez5_p.h"
-#include "bluez/properties_p.h"
 #include "bluez/bluetoothmanagement_p.h"
+#include "bluez/periodicadvertisingsync_p.h"
+#include "bluez/scansession_p.h"
+
+#include <algorithm>
 
 QT_BEGIN_NAMESPACE
 
@@ -24,16 +26,6 @@ QBluetoothDeviceDiscoveryAgentPrivate::QBluetoothDeviceDiscoveryAgentPrivate(
     q_ptr(parent)
 {
     initializeBluez5();
-    manager = new OrgFreedesktopDBusObjectManagerInterface(
-                                       QStringLiteral("org.bluez"),
-                                       QStringLiteral("/"),
-                                       QDBusConnection::systemBus(), parent);
-    QObject::connect(manager,
-                     &OrgFreedesktopDBusObjectManagerInterface::InterfacesAdded,
-                     q_ptr,
-                     [this](const QDBusObjectPath &objectPath, InterfaceList interfacesAndProperties) {
-        this->_q_InterfacesAdded(objectPath, interfacesAndProperties);
-    });
 
     // start private address monitoring
     BluetoothManagement::instance();
@@ -41,6 +33,9 @@ QBluetoothDeviceDiscoveryAgentPrivate::QBluetoothDeviceDiscoveryAgentPrivate(
 
 QBluetoothDeviceDiscoveryAgentPrivate::~QBluetoothDeviceDiscoveryAgentPrivate()
 {
+    if (scanSession)
+        scanSession->release(this);
+    delete periodicSync;
     delete adapter;
 }
 
@@ -73,8 +68,7 @@ void QBluetoothDeviceDiscoveryAgentPrivate::start(QBluetoothDeviceDiscoveryAgent
         return;
     }
 
-    discoveredDevices.clear();
-    devicesProperties.clear();
+    clearDiscoveredDevices();
 
     Q_Q(QBluetoothDeviceDiscoveryAgent);
 
@@ -101,74 +95,55 @@ void QBluetoothDeviceDiscoveryAgentPrivate::start(QBluetoothDeviceDiscoveryAgent
         return;
     }
 
-    QVariantMap map;
-    if (methods == (QBluetoothDeviceDiscoveryAgent::LowEnergyMethod|QBluetoothDeviceDiscoveryAgent::ClassicMethod))
-        map.insert(QStringLiteral("Transport"), QStringLiteral("auto"));
-    else if (methods & QBluetoothDeviceDiscoveryAgent::LowEnergyMethod)
-        map.insert(QStringLiteral("Transport"), QStringLiteral("le"));
-    else
-        map.insert(QStringLiteral("Transport"), QStringLiteral("bredr"));
-
-    // older BlueZ 5.x versions don't have this function
-    // filterReply returns UnknownMethod which we ignore
-    QDBusPendingReply<> filterReply = adapter->SetDiscoveryFilter(map);
-    filterReply.waitForFinished();
-    if (filterReply.isError()) {
-        if (filterReply.error().type() == QDBusError::Other
-                    && filterReply.error().name() == QStringLiteral("org.bluez.Error.Failed")) {
-            qCDebug(QT_BT_BLUEZ) << "Discovery method" << methods << "not supported";
-            lastError = QBluetoothDeviceDiscoveryAgent::UnsupportedDiscoveryMethod;
-            errorString = QBluetoothDeviceDiscoveryAgent::tr("One or more device discovery methods "
-                                                             "are not supported on this platform");
-            delete adapter;
-            adapter = nullptr;
-            emit q->errorOccurred(lastError);
-            return;
-        } else if (filterReply.error().type() != QDBusError::UnknownMethod) {
-            qCDebug(QT_BT_BLUEZ) << "SetDiscoveryFilter failed:" << filterReply.error();
-        }
+    QtBluezDiscoveryFilter filter;
+    filter.methods = methods;
+    filter.serviceUuids = serviceUuidFilter;
+    filter.rssiThreshold = rssiThreshold;
+    filter.pathlossThreshold = pathlossThreshold;
+    filter.duplicateData = reportDuplicateData;
+    // in units of 0.625 ms
+    filter.scanInterval = quint16(lowEnergyScanInterval * 8 / 5);
+    filter.scanWindow = quint16(lowEnergyScanWindow * 8 / 5);
+
+    // all agents searching on the adapter share one session, which decodes every report once
+    scanSession = QtBluezScanSession::acquire(adapterPath, this, filter);
+    if (!scanSession) {
+        lastError = QBluetoothDeviceDiscoveryAgent::UnsupportedDiscoveryMethod;
+        errorString = QBluetoothDeviceDiscoveryAgent::tr("One or more device discovery methods "
+                                                         "are not supported on this platform");
+        delete adapter;
+        adapter = nullptr;
+        emit q->errorOccurred(lastError);
+        return;
     }
 
-    QtBluezDiscoveryManager::instance()->registerDiscoveryInterest(adapter->path());
     QObject::connect(QtBluezDiscoveryManager::instance(), &QtBluezDiscoveryManager::discoveryInterrupted,
                      q, [this](const QString &path){
         this->_q_discoveryInterrupted(path);
     });
-    OrgFreedesktopDBusPropertiesInterface *prop = new OrgFreedesktopDBusPropertiesInterface(
-                QStringLiteral("org.bluez"), QStringLiteral(""), QDBusConnection::systemBus());
-    QObject::connect(prop, &OrgFreedesktopDBusPropertiesInterface::PropertiesChanged,
-                     q, [this](const QString &interface, const QVariantMap &changedProperties,
-                     const QStringList &invalidatedProperties,
-                     const QDBusMessage &signal) {
-        this->_q_PropertiesChanged(interface, signal.path(), changedProperties, invalidatedProperties);
+    QObject::connect(scanSession, &QtBluezScanSession::deviceFound,
+                     q, [this](const QString &, const QVariantMap &properties,
+                               const QBluetoothDeviceInfo &info) {
+        this->deviceFound(properties, info);
+    });
+    QObject::connect(scanSession, &QtBluezScanSession::devicePropertiesChanged,
+                     q, [this](const QString &, const QVariantMap &properties,
+                               const QVariantMap &changedProperties,
+                               const QBluetoothDeviceInfo &info) {
+        this->_q_PropertiesChanged(properties, changedProperties, info);
+    });
+    QObject::connect(scanSession, &QtBluezScanSession::advertisementReceived,
+                     q, [this](const QBluetoothDeviceInfo &info, const QByteArray &eirData) {
+        this->_q_mgmtDeviceFound(info, eirData);
     });
 
-    // remember what we have to cleanup
-    propertyMonitors.append(prop);
-
-    // collect initial set of information
-    QDBusPendingReply<ManagedObjectList> reply = manager->GetManagedObjects();
-    reply.waitForFinished();
-    if (!reply.isError()) {
-        ManagedObjectList managedObjectList = reply.value();
-        for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-            const QDBusObjectPath &path = it.key();
-            const InterfaceList &ifaceList = it.value();
-
-            for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-                const QString &iface = jt.key();
-
-                if (iface == QStringLiteral("org.bluez.Device1")) {
-
-                    if (path.path().indexOf(adapter->path()) != 0)
-                        continue; //devices whose path doesn't start with same path we skip
-
-                    deviceFound(path.path(), jt.value());
-                    if (!isActive()) // Can happen if stop() was called from a slot in user code.
-                      return;
-                }
-            }
-        }
+    // collect initial set of information, the session knows the devices of the adapter already
+    const QList<QString> devicePaths = scanSession->devicePaths();
+    for (const QString &path : devicePaths) {
+        const QtBluezScanSession::Device device = scanSession->device(path);
+        deviceFound(device.properties, device.info);
+        if (!isActive()) // Can happen if stop() was called from a slot in user code.
+            return;
     }
 
     // wait interval and sum up what was found
@@ -198,80 +173,79 @@ void QBluetoothDeviceDiscoveryAgentPrivate::stop()
     _q_discoveryFinished();
 }
 
-// Returns invalid QBluetoothDeviceInfo in case of error
-static QBluetoothDeviceInfo createDeviceInfoFromBluez5Device(const QVariantMap& properties)
+void QBluetoothDeviceDiscoveryAgentPrivate::startPeriodicAdvertisingSync(
+        const QBluetoothDeviceInfo &device)
 {
-    const QBluetoothAddress btAddress(properties[QStringLiteral("Address")].toString());
-    if (btAddress.isNull())
-        return QBluetoothDeviceInfo();
-
-    const QString btName = properties[QStringLiteral("Alias")].toString();
-    quint32 btClass = properties[QStringLiteral("Class")].toUInt();
-
-    QBluetoothDeviceInfo deviceInfo(btAddress, btName, btClass);
-    deviceInfo.setRssi(qvariant_cast<short>(properties[QStringLiteral("RSSI")]));
-
-    QList<QBluetoothUuid> uuids;
-    bool foundLikelyLowEnergyUuid = false;
-    const QStringList foundUuids = qvariant_cast<QStringList>(properties[QStringLiteral("UUIDs")]);
-    for (const auto &u: foundUuids) {
-        const QBluetoothUuid id(u);
-        if (id.isNull())
-            continue;
-
-        if (!foundLikelyLowEnergyUuid) {
-            //once we found one BTLE service we are done
+    Q_Q(QBluetoothDeviceDiscoveryAgent);
+
+    if (!periodicSync) {
+        QBluetoothAddress localAdapter = adapterAddress;
+        if (localAdapter.isNull()) {
             bool ok = false;
-            quint16 shortId = id.toUInt16(&ok);
-            quint16 genericAccessInt = static_cast<quint16>(QBluetoothUuid::ServiceClassUuid::GenericAccess);
-            if (ok && ((shortId & genericAccessInt) == genericAccessInt))
-                foundLikelyLowEnergyUuid = true;
+            const QString adapterPath = findAdapterForAddress(adapterAddress, &ok);
+            if (ok && !adapterPath.isEmpty()) {
+                OrgBluezAdapter1Interface defaultAdapter(QStringLiteral("org.bluez"), adapterPath,
+                                                         QDBusConnection::systemBus());
+                localAdapter = QBluetoothAddress(defaultAdapter.address());
+            }
         }
-        uuids.append(id);
-    }
-    deviceInfo.setServiceUuids(uuids);
 
-    if (!btClass) {
-        deviceInfo.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
-    } else {
-        deviceInfo.setCoreConfigurations(QBluetoothDeviceInfo::BaseRateCoreConfiguration);
-        if (foundLikelyLowEnergyUuid)
-            deviceInfo.setCoreConfigurations(QBluetoothDeviceInfo::BaseRateAndLowEnergyCoreConfiguration);
+        periodicSync = new QtBluezPeriodicAdvertisingSync(localAdapter);
+        if (!periodicSync->isValid()) {
+            delete periodicSync;
+            periodicSync = nullptr;
+            lastError = QBluetoothDeviceDiscoveryAgent::InputOutputError;
+            errorString = QBluetoothDeviceDiscoveryAgent::tr("Cannot access the Bluetooth "
+                                                             "controller for periodic advertising");
+            emit q->errorOccurred(lastError);
+            return;
+        }
+
+        QObject::connect(periodicSync, &QtBluezPeriodicAdvertisingSync::dataReceived,
+                         q, [this](const QBluetoothAddress &address, const QByteArray &data) {
+            const auto it = periodicDevices.constFind(address);
+            if (it != periodicDevices.cend())
+                emit q_ptr->periodicAdvertisingReceived(*it, data);
+        });
+        QObject::connect(periodicSync, &QtBluezPeriodicAdvertisingSync::syncLost,
+                         q, [this](const QBluetoothAddress &address) {
+            const QBluetoothDeviceInfo info = periodicDevices.take(address);
+            if (info.isValid())
+                emit q_ptr->periodicAdvertisingSyncLost(info);
+        });
+        QObject::connect(periodicSync, &QtBluezPeriodicAdvertisingSync::syncFailed,
+                         q, [this](const QBluetoothAddress &address) {
+            if (!periodicDevices.remove(address))
+                return;
+            lastError = QBluetoothDeviceDiscoveryAgent::InputOutputError;
+            errorString = QBluetoothDeviceDiscoveryAgent::tr("Cannot synchronize to the "
+                                                             "periodic advertising of %1")
+                                  .arg(address.toString());
+            emit q_ptr->errorOccurred(lastError);
+        });
     }
 
-    const ManufacturerDataList deviceManufacturerData = qdbus_cast<ManufacturerDataList>(properties[QStringLiteral("ManufacturerData")]);
-    const QList<quint16> keysManufacturer = deviceManufacturerData.keys();
-    for (quint16 key : keysManufacturer)
-        deviceInfo.setManufacturerData(
-                    key, deviceManufacturerData.value(key).variant().toByteArray());
+    periodicDevices.insert(device.address(), device);
+    periodicSync->start(device.address());
+}
 
-    const ServiceDataList deviceServiceData =
-            qdbus_cast<ServiceDataList>(properties[QStringLiteral("ServiceData")]);
-    const QList<QString> keysService = deviceServiceData.keys();
-    for (QString key : keysService)
-        deviceInfo.setServiceData(QBluetoothUuid(key),
-                                  deviceServiceData.value(key).variant().toByteArray());
+void QBluetoothDeviceDiscoveryAgentPrivate::stopPeriodicAdvertisingSync(
+        const QBluetoothDeviceInfo &device)
+{
+    if (!periodicSync || !periodicDevices.remove(device.address()))
+        return;
 
-    return deviceInfo;
+    periodicSync->stop(device.address());
 }
 
-void QBluetoothDeviceDiscoveryAgentPrivate::deviceFound(const QString &devicePath,
-                                                        const QVariantMap &properties)
+void QBluetoothDeviceDiscoveryAgentPrivate::deviceFound(const QVariantMap &properties,
+                                                        const QBluetoothDeviceInfo &deviceInfo)
 {
     Q_Q(QBluetoothDeviceDiscoveryAgent);
 
     if (!q->isActive())
         return;
 
-    auto deviceAdapter = qvariant_cast<QDBusObjectPath>(properties[QStringLiteral("Adapter")]);
-    if (deviceAdapter.path() != adapter->path())
-        return;
-
-    // read information
-    QBluetoothDeviceInfo deviceInfo = createDeviceInfoFromBluez5Device(properties);
-    if (!deviceInfo.isValid()) // no point reporting an empty address
-        return;
-
     qCDebug(QT_BT_BLUEZ) << "Discovered: " << deviceInfo.name() << deviceInfo.address()
                          << "Num UUIDs" << deviceInfo.serviceUuids().size()
                          << "total device" << discoveredDevices.size() << "cached"
@@ -279,40 +253,29 @@ void QBluetoothDeviceDiscoveryAgentPrivate::deviceFound(const QString &devicePat
                          << "Num ManufacturerData" << deviceInfo.manufacturerData().size()
                          << "Num ServiceData" << deviceInfo.serviceData().size();
 
-    // Cache the properties so we do not have to access dbus every time to get a value
-    devicesProperties[devicePath] = properties;
+    // bluetoothd only sets the RSSI of devices it received something from during discovery
+    if (isAdvertisementReportingEnabled() && properties.contains(QStringLiteral("RSSI")))
+        reportAdvertisement(deviceInfo);
 
-    for (qsizetype i = 0; i < discoveredDevices.size(); ++i) {
-        if (discoveredDevices[i].address() == deviceInfo.address()) {
-            if (lowEnergySearchTimeout > 0 && discoveredDevices[i] == deviceInfo) {
-                qCDebug(QT_BT_BLUEZ) << "Duplicate: " << deviceInfo.address();
-                return;
-            }
-            discoveredDevices.replace(i, deviceInfo);
+    // bluetoothd applies the union of the filters of all agents sharing the scan session
+    // to what it finds during this search only, the agent's own filter is checked here
+    if (!matchesDiscoveryFilter(deviceInfo))
+        return;
 
-            emit q->deviceDiscovered(deviceInfo);
-            return; // this works if the list doesn't contain duplicates. Don't let it.
+    const qsizetype i = discoveredDevices.indexOf(deviceInfo.address());
+    if (i >= 0) {
+        if (lowEnergySearchTimeout > 0 && discoveredDevices.at(i) == deviceInfo) {
+            qCDebug(QT_BT_BLUEZ) << "Duplicate: " << deviceInfo.address();
+            return;
         }
-    }
-
-    discoveredDevices.append(deviceInfo);
-    emit q->deviceDiscovered(deviceInfo);
-}
-
-void QBluetoothDeviceDiscoveryAgentPrivate::_q_InterfacesAdded(const QDBusObjectPath &object_path,
-                                                               InterfaceList interfaces_and_properties)
-{
-    Q_Q(QBluetoothDeviceDiscoveryAgent);
+        discoveredDevices.replace(i, deviceInfo);
 
-    if (!q->isActive())
+        emit q->deviceDiscovered(deviceInfo);
         return;
-
-    if (interfaces_and_properties.contains(QStringLiteral("org.bluez.Device1"))) {
-        // device interfaces belonging to different adapter
-        // will be filtered out by deviceFound();
-        deviceFound(object_path.path(),
-                    interfaces_and_properties[QStringLiteral("org.bluez.Device1")]);
     }
+
+    addDiscoveredDevice(deviceInfo);
+    emit q->deviceDiscovered(deviceInfo);
 }
 
 void QBluetoothDeviceDiscoveryAgentPrivate::_q_discoveryFinished()
@@ -323,10 +286,7 @@ void QBluetoothDeviceDiscoveryAgentPrivate::_q_discoveryFinished()
         discoveryTimer->stop();
 
     QtBluezDiscoveryManager::instance()->disconnect(q);
-    QtBluezDiscoveryManager::instance()->unregisterDiscoveryInterest(adapter->path());
-
-    qDeleteAll(propertyMonitors);
-    propertyMonitors.clear();
+    releaseScanSession();
 
     delete adapter;
     adapter = nullptr;
@@ -360,6 +320,7 @@ void QBluetoothDeviceDiscoveryAgentPrivate::_q_discoveryInterrupted(const QStrin
         QtBluezDiscoveryManager::instance()->disconnect(q);
         // no need to call unregisterDiscoveryInterest since QtBluezDiscoveryManager
         // does this automatically when emitting discoveryInterrupted(QString) signal
+        releaseScanSession();
 
         delete adapter;
         adapter = nullptr;
@@ -370,86 +331,167 @@ void QBluetoothDeviceDiscoveryAgentPrivate::_q_discoveryInterrupted(const QStrin
     }
 }
 
-void QBluetoothDeviceDiscoveryAgentPrivate::_q_PropertiesChanged(const QString &interface,
-                                                                 const QString &path,
-                                                                 const QVariantMap &changed_properties,
-                                                                 const QStringList &invalidated_properties)
+void QBluetoothDeviceDiscoveryAgentPrivate::releaseScanSession()
 {
     Q_Q(QBluetoothDeviceDiscoveryAgent);
-    if (interface != QStringLiteral("org.bluez.Device1"))
+    if (!scanSession)
         return;
 
-    if (!devicesProperties.contains(path))
+    QObject::disconnect(scanSession, nullptr, q, nullptr);
+    scanSession->release(this);
+    scanSession = nullptr;
+}
+
+void QBluetoothDeviceDiscoveryAgentPrivate::_q_mgmtDeviceFound(const QBluetoothDeviceInfo &info,
+                                                               const QByteArray &eirData)
+{
+    Q_Q(QBluetoothDeviceDiscoveryAgent);
+
+    if (!q->isActive())
         return;
 
-    // Update the cached properties before checking changed_properties for RSSI and ManufacturerData
-    // so the cached properties are always up to date.
-    QVariantMap & properties = devicesProperties[path];
-    for (QVariantMap::const_iterator it = changed_properties.constBegin();
-         it != changed_properties.constEnd(); ++it) {
-        properties[it.key()] = it.value();
+    if (QBluetoothAdvertisementReport *report = nextAdvertisementReport()) {
+        report->address = info.address().toUInt64();
+        report->deviceUuid = quint128();
+        report->rssi = info.rssi();
+        report->dataSize = quint16(qMin<qsizetype>(eirData.size(),
+                                                   QBluetoothAdvertisementReport::MaximumDataSize));
+        memcpy(report->data, eirData.constData(), report->dataSize);
     }
 
-    for (const QString & property : invalidated_properties)
-        properties.remove(property);
+    const qsizetype i = discoveredDevices.indexOf(info.address());
+    if (i < 0) {
+        if (!matchesDiscoveryFilter(info))
+            return;
+        addDiscoveredDevice(info);
+        emit q->deviceDiscovered(info);
+        return;
+    }
+
+    // Advertisements and scan responses are reported separately and only carry part of
+    // the data, accumulate them instead of replacing the device information.
+    const QBluetoothDeviceInfo::Fields updatedFields =
+            discoveredDevices.mergeAdvertisementData(i, info);
+    QBluetoothDeviceInfo &device = discoveredDevices[i];
+    bool changed = false;
+    if (!info.name().isEmpty() && info.name() != device.name()) {
+        device.setName(info.name());
+        changed = true;
+    }
+    QList<QBluetoothUuid> uuids = device.serviceUuids();
+    for (const QBluetoothUuid &uuid : info.serviceUuids()) {
+        if (!uuids.contains(uuid)) {
+            uuids.append(uuid);
+            changed = true;
+        }
+    }
+    if (changed)
+        device.setServiceUuids(uuids);
+
+    if (changed || lowEnergySearchTimeout == 0)
+        emit q->deviceDiscovered(device);
+    if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
+        emit q->deviceUpdated(device, updatedFields);
+}
+
+/*
+ * Applies the discovery filters the application has set to a device found by
+ * means other than the current search, or found for another agent sharing the
+ * scan session. The pathloss threshold is left to bluetoothd, the RSSI threshold
+ * must be met by a recent advertisement.
+ */
+bool QBluetoothDeviceDiscoveryAgentPrivate::matchesDiscoveryFilter(
+        const QBluetoothDeviceInfo &info) const
+{
+    if (rssiThreshold != 0 && (info.rssi() == 0 || info.rssi() < rssiThreshold))
+        return false;
+
+    // bluetoothd has no filter for these, they are only checked here
+    if (!nameFilter.isEmpty() && !nameFilter.contains(info.name()))
+        return false;
+
+    if (!manufacturerIdFilter.isEmpty()) {
+        const QList<quint16> ids = info.manufacturerIds();
+        if (std::none_of(ids.cbegin(), ids.cend(), [this](quint16 id) {
+                return manufacturerIdFilter.contains(id);
+            })) {
+            return false;
+        }
+    }
 
-    const auto info = createDeviceInfoFromBluez5Device(properties);
-    if (!info.isValid())
+    if (serviceUuidFilter.isEmpty())
+        return true;
+
+    const QList<QBluetoothUuid> uuids = info.serviceUuids();
+    return std::any_of(uuids.cbegin(), uuids.cend(), [this](const QBluetoothUuid &uuid) {
+        return serviceUuidFilter.contains(uuid);
+    });
+}
+
+void QBluetoothDeviceDiscoveryAgentPrivate::_q_PropertiesChanged(const QVariantMap &properties,
+                                                                 const QVariantMap &changed_properties,
+                                                                 const QBluetoothDeviceInfo &info)
+{
+    Q_Q(QBluetoothDeviceDiscoveryAgent);
+
+    const qsizetype i = discoveredDevices.indexOf(info.address());
+    if (i < 0) {
+        // the device was held back by the discovery filter or lost, it may match now
+        if (matchesDiscoveryFilter(info))
+            deviceFound(properties, info);
+        return;
+    }
+
+    if (!changed_properties.contains(QStringLiteral("RSSI"))
+        && !changed_properties.contains(QStringLiteral("ManufacturerData"))) {
         return;
+    }
 
-    if (changed_properties.contains(QStringLiteral("RSSI"))
-        || changed_properties.contains(QStringLiteral("ManufacturerData"))) {
-
-        for (qsizetype i = 0; i < discoveredDevices.size(); ++i) {
-            if (discoveredDevices[i].address() == info.address()) {
-                QBluetoothDeviceInfo::Fields updatedFields = QBluetoothDeviceInfo::Field::None;
-                if (changed_properties.contains(QStringLiteral("RSSI"))) {
-                    qCDebug(QT_BT_BLUEZ) << "Updating RSSI for" << info.address()
-                                         << changed_properties.value(QStringLiteral("RSSI"));
-                    discoveredDevices[i].setRssi(
-                                changed_properties.value(QStringLiteral("RSSI")).toInt());
-                    updatedFields.setFlag(QBluetoothDeviceInfo::Field::RSSI);
-                }
-                if (changed_properties.contains(QStringLiteral("ManufacturerData"))) {
-                    qCDebug(QT_BT_BLUEZ) << "Updating ManufacturerData for" << info.address();
-                    ManufacturerDataList changedManufacturerData =
-                            qdbus_cast< ManufacturerDataList >(changed_properties.value(QStringLiteral("ManufacturerData")));
-
-                    const QList<quint16> keys = changedManufacturerData.keys();
-                    bool wasNewValue = false;
-                    for (quint16 key : keys) {
-                        bool added = discoveredDevices[i].setManufacturerData(key, changedManufacturerData.value(key).variant().toByteArray());
-                        wasNewValue = (wasNewValue || added);
-                    }
-
-                    if (wasNewValue)
-                        updatedFields.setFlag(QBluetoothDeviceInfo::Field::ManufacturerData);
-                }
-
-                if (lowEnergySearchTimeout > 0) {
-                    if (discoveredDevices[i] != info) { // field other than manufacturer or rssi changed
-                        if (discoveredDevices.at(i).name() == info.name()) {
-                            qCDebug(QT_BT_BLUEZ) << "Almost Duplicate " << info.address()
-                                                   << info.name() << "- replacing in place";
-                            discoveredDevices.replace(i, info);
-                            emit q->deviceDiscovered(info);
-                        }
-                    } else {
-                        if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
-                            emit q->deviceUpdated(discoveredDevices[i], updatedFields);
-                    }
-
-                    return;
-                }
+    reportAdvertisement(info);
 
-                discoveredDevices.replace(i, info);
-                emit q_ptr->deviceDiscovered(discoveredDevices[i]);
+    QBluetoothDeviceInfo::Fields updatedFields = QBluetoothDeviceInfo::Field::None;
+    if (changed_properties.contains(QStringLiteral("RSSI"))) {
+        qCDebug(QT_BT_BLUEZ) << "Updating RSSI for" << info.address()
+                             << changed_properties.value(QStringLiteral("RSSI"));
+        discoveredDevices[i].setRssi(
+                    changed_properties.value(QStringLiteral("RSSI")).toInt());
+        updatedFields.setFlag(QBluetoothDeviceInfo::Field::RSSI);
+    }
+    if (changed_properties.contains(QStringLiteral("ManufacturerData"))) {
+        qCDebug(QT_BT_BLUEZ) << "Updating ManufacturerData for" << info.address();
+        const auto changedManufacturerData = bluezManufacturerData(
+                    changed_properties.value(QStringLiteral("ManufacturerData")));
+
+        bool wasNewValue = false;
+        for (const auto &entry : changedManufacturerData) {
+            bool added = discoveredDevices[i].setManufacturerData(entry.first, entry.second);
+            wasNewValue = (wasNewValue || added);
+        }
 
-                if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
-                    emit q->deviceUpdated(discoveredDevices[i], updatedFields);
-                return;
+        if (wasNewValue)
+            updatedFields.setFlag(QBluetoothDeviceInfo::Field::ManufacturerData);
+    }
+
+    if (lowEnergySearchTimeout > 0) {
+        if (discoveredDevices.at(i) != info) { // field other than manufacturer or rssi changed
+            if (discoveredDevices.at(i).name() == info.name()) {
+                qCDebug(QT_BT_BLUEZ) << "Almost Duplicate " << info.address()
+                                       << info.name() << "- replacing in place";
+                discoveredDevices.replace(i, info);
+                emit q->deviceDiscovered(info);
             }
+        } else {
+            if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
+                emit q->deviceUpdated(discoveredDevices.at(i), updatedFields);
         }
+
+        return;
     }
+
+    discoveredDevices.replace(i, info);
+    emit q_ptr->deviceDiscovered(discoveredDevices.at(i));
+
+    if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
+        emit q->deviceUpdated(discoveredDevices.at(i), updatedFields);
 }
 QT_END_NAMESPACE
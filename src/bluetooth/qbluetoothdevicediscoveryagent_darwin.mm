@@ -76,7 +76,7 @@ QBluetoothDeviceDiscoveryAgentPrivate::~QBluetoothDeviceDiscoveryAgentPrivate()
 {
     if (inquiryLE && agentState != NonActive) {
         // We want the LE scan to stop as soon as possible.
-        if (dispatch_queue_t leQueue = DarwinBluetooth::qt_LE_queue()) {
+        if (dispatch_queue_t leQueue = dispatchQueue.getAs<dispatch_queue_t>()) {
             // Local variable to be retained ...
             LEInquiryObjC *inq = inquiryLE.getAs<LEInquiryObjC>();
             dispatch_sync(leQueue, ^{
@@ -163,7 +163,7 @@ void QBluetoothDeviceDiscoveryAgentPrivate::start(QBluetoothDeviceDiscoveryAgent
     // starting from Classic if it's in 'methods' (or LE scan if not).
 
     agentState = NonActive;
-    discoveredDevices.clear();
+    clearDiscoveredDevices();
     setError(QBluetoothDeviceDiscoveryAgent::NoError);
 #ifdef Q_OS_MACOS
     if (requestedMethods & QBluetoothDeviceDiscoveryAgent::ClassicMethod)
@@ -231,12 +231,16 @@ void QBluetoothDeviceDiscoveryAgentPrivate::startLE()
                       this, DeviceMemFunPtr(&QBluetoothDeviceDiscoveryAgentPrivate::deviceFound));
 
     // Check queue and create scanner:
-    inquiryLE.reset([[LEInquiryObjC alloc] initWithNotifier:notifier.get()],
-                    DarwinBluetooth::RetainPolicy::noInitialRetain);
+    if (!dispatchQueue)
+        dispatchQueue.reset(qt_create_LE_queue("qt-bluetooth-LE-discovery-queue"));
+    dispatch_queue_t leQueue(dispatchQueue.getAs<dispatch_queue_t>());
+    if (leQueue) {
+        inquiryLE.reset([[LEInquiryObjC alloc] initWithNotifier:notifier.get() queue:leQueue],
+                        DarwinBluetooth::RetainPolicy::noInitialRetain);
+    }
     if (inquiryLE)
         notifier.release(); // Whatever happens next, inquiryLE is already the owner ...
 
-    dispatch_queue_t leQueue(qt_LE_queue());
     if (!leQueue || !inquiryLE) {
         setError(QBluetoothDeviceDiscoveryAgent::UnknownError,
                  QCoreApplication::translate(DEV_DISCOVERY, DD_NOT_STARTED_LE));
@@ -249,8 +253,9 @@ void QBluetoothDeviceDiscoveryAgentPrivate::startLE()
     agentState = LEScan;
     // We need the local variable so that it's retained ...
     LEInquiryObjC *inq = inquiryLE.getAs<LEInquiryObjC>();
+    const QList<QBluetoothUuid> serviceUuids = serviceUuidFilter;
     dispatch_async(leQueue, ^{
-        [inq startWithTimeout:lowEnergySearchTimeout];
+        [inq startWithTimeout:lowEnergySearchTimeout serviceUuids:serviceUuids];
     });
 }
 
@@ -283,7 +288,7 @@ void QBluetoothDeviceDiscoveryAgentPrivate::stop()
     {
         Q_UNUSED(prevStart);
 #endif // Q_OS_MACOS
-        dispatch_queue_t leQueue(qt_LE_queue());
+        dispatch_queue_t leQueue(dispatchQueue.getAs<dispatch_queue_t>());
         Q_ASSERT(leQueue);
         // We need the local variable so that it's retained ...
         LEInquiryObjC *inq = inquiryLE.getAs<LEInquiryObjC>();
@@ -471,6 +476,8 @@ void QBluetoothDeviceDiscoveryAgentPrivate::LEinquiryFinished()
 
 void QBluetoothDeviceDiscoveryAgentPrivate::deviceFound(const QBluetoothDeviceInfo &newDeviceInfo)
 {
+    reportAdvertisement(newDeviceInfo);
+
     // Core Bluetooth does not allow us to access addresses, we have to use uuid instead.
     // This uuid has nothing to do with uuids in Bluetooth in general (it's generated by
     // Apple's framework using some algorithm), but it's a 128-bit uuid after all.
@@ -480,70 +487,53 @@ void QBluetoothDeviceDiscoveryAgentPrivate::deviceFound(const QBluetoothDeviceIn
 #else
             true;
 #endif // Q_OS_MACOS
-    for (qsizetype i = 0, e = discoveredDevices.size(); i < e; ++i) {
-        if (isLE) {
-            if (discoveredDevices[i].deviceUuid() == newDeviceInfo.deviceUuid()) {
-                QBluetoothDeviceInfo::Fields updatedFields = QBluetoothDeviceInfo::Field::None;
-                if (discoveredDevices[i].rssi() != newDeviceInfo.rssi()) {
-                    qCDebug(QT_BT_DARWIN) << "Updating RSSI for" << newDeviceInfo.address()
-                                          << newDeviceInfo.rssi();
-                    discoveredDevices[i].setRssi(newDeviceInfo.rssi());
-                    updatedFields.setFlag(QBluetoothDeviceInfo::Field::RSSI);
-                }
-
-                if (discoveredDevices[i].manufacturerData() != newDeviceInfo.manufacturerData()) {
-                    qCDebug(QT_BT_DARWIN) << "Updating manufacturer data for" << newDeviceInfo.address();
-                    const QList<quint16> keys = newDeviceInfo.manufacturerIds();
-                    for (auto key: keys)
-                        discoveredDevices[i].setManufacturerData(key, newDeviceInfo.manufacturerData(key));
-                    updatedFields.setFlag(QBluetoothDeviceInfo::Field::ManufacturerData);
-                }
+    if (isLE) {
+        const qsizetype i = discoveredDevices.indexOfDeviceUuid(newDeviceInfo.deviceUuid());
+        if (i >= 0) {
+            const QBluetoothDeviceInfo::Fields updatedFields =
+                    discoveredDevices.mergeAdvertisementData(i, newDeviceInfo);
+            if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None)) {
+                qCDebug(QT_BT_DARWIN) << "Updating" << updatedFields << "for"
+                                      << newDeviceInfo.deviceUuid() << newDeviceInfo.rssi();
+            }
 
-                if (discoveredDevices[i].serviceData() != newDeviceInfo.serviceData()) {
-                    qCDebug(QT_BT_DARWIN) << "Updating service data for" << newDeviceInfo.address();
-                    const QList<QBluetoothUuid> keys = newDeviceInfo.serviceIds();
-                    for (auto key : keys)
-                        discoveredDevices[i].setServiceData(key, newDeviceInfo.serviceData(key));
-                    updatedFields.setFlag(QBluetoothDeviceInfo::Field::ServiceData);
+            if (lowEnergySearchTimeout > 0) {
+                if (discoveredDevices.at(i) != newDeviceInfo) {
+                    discoveredDevices.replace(i, newDeviceInfo);
+                    emit q_ptr->deviceDiscovered(newDeviceInfo);
+                } else {
+                    if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
+                        emit q_ptr->deviceUpdated(discoveredDevices.at(i), updatedFields);
                 }
 
-                if (lowEnergySearchTimeout > 0) {
-                    if (discoveredDevices[i] != newDeviceInfo) {
-                        discoveredDevices.replace(i, newDeviceInfo);
-                        emit q_ptr->deviceDiscovered(newDeviceInfo);
-                    } else {
-                        if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
-                            emit q_ptr->deviceUpdated(discoveredDevices[i], updatedFields);
-                    }
-
-                    return;
-                }
+                return;
+            }
 
-                discoveredDevices.replace(i, newDeviceInfo);
-                emit q_ptr->deviceDiscovered(newDeviceInfo);
+            discoveredDevices.replace(i, newDeviceInfo);
+            emit q_ptr->deviceDiscovered(newDeviceInfo);
 
-                if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
-                    emit q_ptr->deviceUpdated(discoveredDevices[i], updatedFields);
+            if (!updatedFields.testFlag(QBluetoothDeviceInfo::Field::None))
+                emit q_ptr->deviceUpdated(discoveredDevices.at(i), updatedFields);
 
-                return;
-            }
-        } else {
+            return;
+        }
+    } else {
 #ifdef Q_OS_MACOS
-            if (discoveredDevices[i].address() == newDeviceInfo.address()) {
-                if (discoveredDevices[i] == newDeviceInfo)
-                    return;
-
-                discoveredDevices.replace(i, newDeviceInfo);
-                emit q_ptr->deviceDiscovered(newDeviceInfo);
+        const qsizetype i = discoveredDevices.indexOf(newDeviceInfo.address());
+        if (i >= 0) {
+            if (discoveredDevices.at(i) == newDeviceInfo)
                 return;
-            }
+
+            discoveredDevices.replace(i, newDeviceInfo);
+            emit q_ptr->deviceDiscovered(newDeviceInfo);
+            return;
+        }
 #else
-            Q_UNREACHABLE();
+        Q_UNREACHABLE();
 #endif // Q_OS_MACOS
-        }
     }
 
-    discoveredDevices.append(newDeviceInfo);
+    addDiscoveredDevice(newDeviceInfo);
     emit q_ptr->deviceDiscovered(newDeviceInfo);
 }
 
@@ -28,23 +28,28 @@
 #include "darwin/btraii_p.h"
 #endif // Q_OS_DARWIN
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMultiMap>
 #include <QtCore/QVariantMap>
 
 #include <QtBluetooth/QBluetoothAddress>
 #include <QtBluetooth/QBluetoothLocalDevice>
 
+#include "leaddressresolver_p.h"
+
 #if QT_CONFIG(bluez)
 #include "bluez/bluez5_helper_p.h"
 
 class OrgBluezManagerInterface;
 class OrgBluezAdapterInterface;
-class OrgFreedesktopDBusObjectManagerInterface;
-class OrgFreedesktopDBusPropertiesInterface;
 class OrgBluezAdapter1Interface;
 class OrgBluezDevice1Interface;
 
 QT_BEGIN_NAMESPACE
 class QDBusVariant;
+class QtBluezScanSession;
+class QtBluezPeriodicAdvertisingSync;
 QT_END_NAMESPACE
 #endif
 
@@ -60,10 +65,92 @@ QT_DECL_METATYPE_EXTERN(ServiceData, Q_BLUETOOTH_EXPORT)
 
 QT_BEGIN_NAMESPACE
 
+class QTimer;
+
 #ifdef QT_WINRT_BLUETOOTH
 class QWinRTBluetoothDeviceDiscoveryWorker;
 #endif
 
+/*
+ * The devices found by a search, in the order they were found, indexed by
+ * address and, for Core Bluetooth which hides the addresses, by device UUID.
+ * Entries may be modified in place as long as their address and device UUID
+ * stay the same. Every modification counts as having seen the device.
+ *
+ * With an address resolver the entries are indexed by identity address as
+ * well, a device which rotated its resolvable private address keeps its entry.
+ * The entry takes over the new address once the backend replaces it.
+ *
+ * Entries restored from a snapshot are marked as cached until they are seen.
+ *
+ * The indexes refer to a serial number which every entry keeps for its
+ * lifetime, so removing an entry does not touch the other index entries. The
+ * serial numbers grow with the position in the list, a binary search maps them
+ * to the position. The entries are additionally ordered by the time they were
+ * last seen, which finds the least recently seen ones without scanning.
+ */
+class QBluetoothDiscoveredDevices
+{
+public:
+    QBluetoothDiscoveredDevices() { clock.start(); }
+
+    qsizetype size() const { return devices.size(); }
+    bool isEmpty() const { return devices.isEmpty(); }
+    const QBluetoothDeviceInfo &at(qsizetype i) const { return devices.at(i); }
+    QBluetoothDeviceInfo &operator[](qsizetype i)
+    {
+        markSeen(i);
+        return devices[i];
+    }
+    const QList<QBluetoothDeviceInfo> &list() const { return devices; }
+
+    // return -1 if there is no such device
+    qsizetype indexOf(const QBluetoothAddress &address) const;
+    qsizetype indexOfDeviceUuid(const QBluetoothUuid &uuid) const
+    { return indexOfSerial(uuidIndex.value(uuid)); }
+
+    void append(const QBluetoothDeviceInfo &info);
+    // last seen msecs ago
+    void appendRestored(const QBluetoothDeviceInfo &info, qint64 msecs);
+    void replace(qsizetype i, const QBluetoothDeviceInfo &info);
+    void clear();
+    qint64 msecsSinceSeen(qsizetype i) const { return clock.elapsed() - lastSeen.at(i); }
+
+    // the resolver must outlive the list, call again after changing its keys
+    void setAddressResolver(const LeAddressResolver *resolver);
+
+    QBluetoothDeviceInfo::Fields mergeAdvertisementData(qsizetype i,
+                                                        const QBluetoothDeviceInfo &info);
+
+    QBluetoothDeviceInfo takeLeastRecentlySeen();
+    QList<QBluetoothDeviceInfo> takeNotSeenFor(qint64 msecs);
+
+    // approximate heap size of the devices and their indexes
+    qsizetype memoryUsage() const;
+
+private:
+    // return -1 for the serial 0 of the indexes' default value
+    qsizetype indexOfSerial(quint64 serial) const;
+    void insert(const QBluetoothDeviceInfo &info, qint64 seen, bool isRestored);
+    void markSeen(qsizetype i);
+    void index(qsizetype i);
+    void unindex(qsizetype i);
+    void rebuildIdentityIndex();
+
+    QList<QBluetoothDeviceInfo> devices;
+    QList<quint64> serials;
+    QList<qint64> lastSeen;
+    QList<bool> restored;
+    // serials by the time they were last seen
+    QMultiMap<qint64, quint64> seenOrder;
+    quint64 nextSerial = 1;
+    QElapsedTimer clock;
+    QHash<quint64, quint64> addressIndex;
+    QHash<QBluetoothUuid, quint64> uuidIndex;
+    const LeAddressResolver *addressResolver = nullptr;
+    QHash<quint64, quint64> identityIndex;
+};
+
 class QBluetoothDeviceDiscoveryAgentPrivate
 #if defined(QT_ANDROID_BLUETOOTH) || defined(QT_WINRT_BLUETOOTH) \
             || defined(Q_OS_DARWIN)
@@ -87,19 +174,33 @@ public:
     void stop();
     bool isActive() const;
 
+    void addDiscoveredDevice(const QBluetoothDeviceInfo &info);
+    void clearDiscoveredDevices();
+    void startDeviceLostTimer();
+    void removeLostDevices();
+    void deviceLost(const QBluetoothDeviceInfo &info);
+
+    QBluetoothMemoryUsage memoryUsage() const;
+
+    bool isAdvertisementReportingEnabled() const { return !reportBuffer.isEmpty(); }
+    QBluetoothAdvertisementReport *nextAdvertisementReport();
+    void reportAdvertisement(const QBluetoothDeviceInfo &info);
+
 #if QT_CONFIG(bluez)
-    void _q_InterfacesAdded(const QDBusObjectPath &object_path,
-                            InterfaceList interfaces_and_properties);
     void _q_discoveryFinished();
     void _q_discoveryInterrupted(const QString &path);
-    void _q_PropertiesChanged(const QString &interface,
-                              const QString &path,
+    void _q_PropertiesChanged(const QVariantMap &properties,
                               const QVariantMap &changed_properties,
-                              const QStringList &invalidated_properties);
+                              const QBluetoothDeviceInfo &info);
+    void _q_mgmtDeviceFound(const QBluetoothDeviceInfo &info, const QByteArray &eirData);
+
+    void startPeriodicAdvertisingSync(const QBluetoothDeviceInfo &device);
+    void stopPeriodicAdvertisingSync(const QBluetoothDeviceInfo &device);
 #endif
 
 private:
-    QList<QBluetoothDeviceInfo> discoveredDevices;
+    LeAddressResolver addressResolver;
+    QBluetoothDiscoveredDevices discoveredDevices;
 
     QBluetoothDeviceDiscoveryAgent::Error lastError = QBluetoothDeviceDiscoveryAgent::NoError;
     QString errorString;
@@ -126,14 +227,15 @@ private:
 #elif QT_CONFIG(bluez)
     bool pendingCancel = false;
     bool pendingStart = false;
-    OrgFreedesktopDBusObjectManagerInterface *manager = nullptr;
     OrgBluezAdapter1Interface *adapter = nullptr;
     QTimer *discoveryTimer = nullptr;
-    QList<OrgFreedesktopDBusPropertiesInterface *> propertyMonitors;
-
-    void deviceFound(const QString &devicePath, const QVariantMap &properties);
+    QtBluezScanSession *scanSession = nullptr;
+    QtBluezPeriodicAdvertisingSync *periodicSync = nullptr;
+    QHash<QBluetoothAddress, QBluetoothDeviceInfo> periodicDevices;
 
-    QMap<QString, QVariantMap> devicesProperties;
+    void deviceFound(const QVariantMap &properties, const QBluetoothDeviceInfo &deviceInfo);
+    bool matchesDiscoveryFilter(const QBluetoothDeviceInfo &info) const;
+    void releaseScanSession();
 #endif
 
 #ifdef QT_WINRT_BLUETOOTH
@@ -195,11 +297,35 @@ private:
 
 #endif // Q_OS_MACOS
 
+    // Created on the first LE scan, outlives inquiryLE.
+    DarwinBluetooth::DispatchQueue dispatchQueue;
     DarwinBluetooth::ScopedPointer inquiryLE;
 
 #endif // Q_OS_DARWIN
 
     int lowEnergySearchTimeout = 40000;
+    // the devices of restoreDiscoveredDevices() survive the next start()
+    bool keepRestoredDevices = false;
+    int maximumDevices = 0;
+    int deviceLostTimeout = 0;
+    QTimer *deviceLostTimer = nullptr;
+    QList<QBluetoothAdvertisementReport> reportBuffer;
+    qsizetype reportHead = 0;
+    qsizetype reportCount = 0;
+    bool reportsNotificationPending = false;
+    QList<QBluetoothUuid> serviceUuidFilter;
+    qint16 rssiThreshold = 0;
+    quint16 pathlossThreshold = 0;
+    bool reportDuplicateData = true;
+    QStringList nameFilter;
+    QList<quint16> manufacturerIdFilter;
+    QBluetoothDeviceDiscoveryAgent::LowEnergyScanMode lowEnergyScanMode =
+            QBluetoothDeviceDiscoveryAgent::LowEnergyScanMode::Balanced;
+    int lowEnergyReportDelay = 0;
+    // 0 leaves the timing to the platform
+    int lowEnergyScanInterval = 0;
+    int lowEnergyScanWindow = 0;
+    bool lowEnergyPassiveScan = false;
     QBluetoothDeviceDiscoveryAgent::DiscoveryMethods requestedMethods;
     QBluetoothDeviceDiscoveryAgent *q_ptr;
 };
@@ -9,10 +9,13 @@
 #include <QtBluetooth/private/qtbluetoothglobal_p.h>
 #include <QtBluetooth/private/qbluetoothutils_winrt_p.h>
 #include <QtCore/QLoggingCategory>
-#include <QtCore/qmutex.h>
 #include <QtCore/private/qfunctions_winrt_p.h>
 #include <QtCore/qendian.h>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include <robuffer.h>
 #include <wrl.h>
 #include <windows.devices.enumeration.h>
@@ -142,12 +145,88 @@ static ServiceData extractServiceData(ComPtr<IBluetoothLEAdvertisement> ad)
     return ret;
 }
 
+/*
+ * An advertisement as received by the LE watcher on a thread pool thread, and
+ * the node of the queue taking it to the worker's thread.
+ */
+struct LEAdvertisement
+{
+    std::atomic<LEAdvertisement *> next = nullptr;
+    quint64 address = 0;
+    qint16 rssi = 0;
+    QList<QBluetoothUuid> services;
+    ManufacturerData manufacturerData;
+    ServiceData serviceData;
+};
+
+/*
+ * Intrusive multiple-producer, single-consumer queue after Dmitry Vyukov.
+ * Pushing takes a single atomic exchange, so thread pool threads receiving a
+ * burst of advertisements never wait for each other or for the consumer.
+ */
+class LEAdvertisementQueue
+{
+public:
+    ~LEAdvertisementQueue()
+    {
+        while (LEAdvertisement *advertisement = pop())
+            delete advertisement;
+    }
+
+    void push(LEAdvertisement *advertisement)
+    {
+        advertisement->next.store(nullptr, std::memory_order_relaxed);
+        LEAdvertisement *previous = head.exchange(advertisement, std::memory_order_acq_rel);
+        previous->next.store(advertisement, std::memory_order_release);
+    }
+
+    // Consumer only. Returns nullptr when empty, and also while the only
+    // remaining element is still being pushed.
+    LEAdvertisement *pop()
+    {
+        LEAdvertisement *current = tail;
+        LEAdvertisement *next = current->next.load(std::memory_order_acquire);
+        if (current == &stub) {
+            if (!next)
+                return nullptr;
+            tail = next;
+            current = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail = next;
+            return current;
+        }
+        if (current != head.load(std::memory_order_acquire))
+            return nullptr;
+
+        push(&stub);
+        next = current->next.load(std::memory_order_acquire);
+        if (next) {
+            tail = next;
+            return current;
+        }
+        return nullptr;
+    }
+
+private:
+    LEAdvertisement stub;
+    // written by the producers
+    std::atomic<LEAdvertisement *> head = &stub;
+    // owned by the consumer
+    LEAdvertisement *tail = &stub;
+};
+
 class QWinRTBluetoothDeviceDiscoveryWorker : public QObject
 {
     Q_OBJECT
 public:
     explicit QWinRTBluetoothDeviceDiscoveryWorker(QBluetoothDeviceDiscoveryAgent::DiscoveryMethods methods);
     ~QWinRTBluetoothDeviceDiscoveryWorker();
+    // Passed on to the LE watcher, so that the OS drops other advertisements.
+    void setLowEnergyFilter(const QList<QBluetoothUuid> &serviceUuids,
+                            const QList<quint16> &manufacturerIds, qint16 rssiThreshold);
+    void setPassiveScan(bool passive) { m_passiveScan = passive; }
     void start();
     void stopLEWatcher();
 
@@ -160,6 +239,9 @@ private:
     void gatherMultipleDeviceInformation(quint32 deviceCount, IVectorView<DeviceInformation *> *devices,
                                          QBluetoothDeviceDiscoveryAgent::DiscoveryMethod mode);
     void setupLEDeviceWatcher();
+    void setupLEAdvertisementFilter();
+    void processAdvertisements();
+    void handleAdvertisement(LEAdvertisement &advertisement);
     void classicBluetoothInfoFromDeviceIdAsync(HSTRING deviceId);
     void leBluetoothInfoFromDeviceIdAsync(HSTRING deviceId);
     void leBluetoothInfoFromAddressAsync(quint64 address);
@@ -197,7 +279,13 @@ public:
 private:
     ComPtr<IBluetoothLEAdvertisementWatcher> m_leWatcher;
     EventRegistrationToken m_leDeviceAddedToken;
-    QMutex m_foundDevicesMutex;
+    LEAdvertisementQueue m_advertisements;
+    std::atomic<bool> m_advertisementsPending = false;
+    QList<QBluetoothUuid> m_serviceUuidFilter;
+    QList<quint16> m_manufacturerIdFilter;
+    qint16 m_rssiThreshold = 0;
+    bool m_passiveScan = false;
+    // only used on the thread of the worker
     struct LEAdvertisingInfo {
         QList<QBluetoothUuid> services;
         ManufacturerData manufacturerData;
@@ -235,6 +323,15 @@ QWinRTBluetoothDeviceDiscoveryWorker::~QWinRTBluetoothDeviceDiscoveryWorker()
     stopLEWatcher();
 }
 
+void QWinRTBluetoothDeviceDiscoveryWorker::setLowEnergyFilter(
+        const QList<QBluetoothUuid> &serviceUuids, const QList<quint16> &manufacturerIds,
+        qint16 rssiThreshold)
+{
+    m_serviceUuidFilter = serviceUuids;
+    m_manufacturerIdFilter = manufacturerIds;
+    m_rssiThreshold = rssiThreshold;
+}
+
 void QWinRTBluetoothDeviceDiscoveryWorker::start()
 {
     if (requestedModes & QBluetoothDeviceDiscoveryAgent::ClassicMethod)
@@ -368,7 +465,6 @@ HRESULT QWinRTBluetoothDeviceDiscoveryWorker::onBluetoothLEAdvertisementReceived
                                    return S_OK);
     const ManufacturerData manufacturerData = extractManufacturerData(ad);
     const ServiceData serviceData = extractServiceData(ad);
-    QBluetoothDeviceInfo::Fields changedFields = QBluetoothDeviceInfo::Field::None;
     ComPtr<IVector<GUID>> guids;
     hr = ad->get_ServiceUuids(&guids);
     EMIT_WORKER_ERROR_AND_RETURN_IF_FAILED("Could not obtain service uuid list",
@@ -390,56 +486,101 @@ HRESULT QWinRTBluetoothDeviceDiscoveryWorker::onBluetoothLEAdvertisementReceived
         serviceUuids.append(uuid);
     }
 
-    { // scope for QMutexLocker
-        QMutexLocker locker(&m_foundDevicesMutex);
-        // Merge newly found services with list of currently found ones
-        if (m_foundLEDevicesMap.contains(address)) {
-            const LEAdvertisingInfo adInfo = m_foundLEDevicesMap.value(address);
-            QList<QBluetoothUuid> foundServices = adInfo.services;
-            if (adInfo.rssi != rssi) {
-                m_foundLEDevicesMap[address].rssi = rssi;
-                changedFields.setFlag(QBluetoothDeviceInfo::Field::RSSI);
-            }
-            if (adInfo.manufacturerData != manufacturerData) {
-                m_foundLEDevicesMap[address].manufacturerData.insert(manufacturerData);
-                if (adInfo.manufacturerData != m_foundLEDevicesMap[address].manufacturerData)
-                    changedFields.setFlag(QBluetoothDeviceInfo::Field::ManufacturerData);
-            }
-            if (adInfo.serviceData != serviceData) {
-                m_foundLEDevicesMap[address].serviceData.insert(serviceData);
-                if (adInfo.serviceData != m_foundLEDevicesMap[address].serviceData)
-                    changedFields.setFlag((QBluetoothDeviceInfo::Field::ServiceData));
-            }
-            bool newServiceAdded = false;
-            for (const QBluetoothUuid &uuid : qAsConst(serviceUuids)) {
-                if (!foundServices.contains(uuid)) {
-                    foundServices.append(uuid);
-                    newServiceAdded = true;
-                }
+    auto advertisement = new LEAdvertisement;
+    advertisement->address = address;
+    advertisement->rssi = rssi;
+    advertisement->services = std::move(serviceUuids);
+    advertisement->manufacturerData = manufacturerData;
+    advertisement->serviceData = serviceData;
+    m_advertisements.push(advertisement);
+
+    // The consumer clears the flag before draining, every push it might miss
+    // schedules another run.
+    if (!m_advertisementsPending.exchange(true))
+        QMetaObject::invokeMethod(this, &QWinRTBluetoothDeviceDiscoveryWorker::processAdvertisements,
+                                  Qt::QueuedConnection);
+    return S_OK;
+}
+
+void QWinRTBluetoothDeviceDiscoveryWorker::processAdvertisements()
+{
+    m_advertisementsPending.store(false);
+
+    // A burst of advertisements causes one update per device
+    std::vector<std::unique_ptr<LEAdvertisement>> merged;
+    QHash<quint64, LEAdvertisement *> byAddress;
+    while (LEAdvertisement *node = m_advertisements.pop()) {
+        std::unique_ptr<LEAdvertisement> advertisement(node);
+        LEAdvertisement *&first = byAddress[advertisement->address];
+        if (!first) {
+            first = advertisement.get();
+            merged.push_back(std::move(advertisement));
+            continue;
+        }
+
+        first->rssi = advertisement->rssi;
+        first->manufacturerData.insert(advertisement->manufacturerData);
+        first->serviceData.insert(advertisement->serviceData);
+        for (const QBluetoothUuid &uuid : std::as_const(advertisement->services)) {
+            if (!first->services.contains(uuid))
+                first->services.append(uuid);
+        }
+    }
+
+    for (const auto &advertisement : merged)
+        handleAdvertisement(*advertisement);
+}
+
+void QWinRTBluetoothDeviceDiscoveryWorker::handleAdvertisement(LEAdvertisement &advertisement)
+{
+    const quint64 address = advertisement.address;
+    const qint16 rssi = advertisement.rssi;
+    const ManufacturerData &manufacturerData = advertisement.manufacturerData;
+    const ServiceData &serviceData = advertisement.serviceData;
+    QBluetoothDeviceInfo::Fields changedFields = QBluetoothDeviceInfo::Field::None;
+
+    // Merge newly found services with list of currently found ones
+    if (m_foundLEDevicesMap.contains(address)) {
+        const LEAdvertisingInfo adInfo = m_foundLEDevicesMap.value(address);
+        QList<QBluetoothUuid> foundServices = adInfo.services;
+        if (adInfo.rssi != rssi) {
+            m_foundLEDevicesMap[address].rssi = rssi;
+            changedFields.setFlag(QBluetoothDeviceInfo::Field::RSSI);
+        }
+        if (adInfo.manufacturerData != manufacturerData) {
+            m_foundLEDevicesMap[address].manufacturerData.insert(manufacturerData);
+            if (adInfo.manufacturerData != m_foundLEDevicesMap[address].manufacturerData)
+                changedFields.setFlag(QBluetoothDeviceInfo::Field::ManufacturerData);
+        }
+        if (adInfo.serviceData != serviceData) {
+            m_foundLEDevicesMap[address].serviceData.insert(serviceData);
+            if (adInfo.serviceData != m_foundLEDevicesMap[address].serviceData)
+                changedFields.setFlag((QBluetoothDeviceInfo::Field::ServiceData));
+        }
+        bool newServiceAdded = false;
+        for (const QBluetoothUuid &uuid : qAsConst(advertisement.services)) {
+            if (!foundServices.contains(uuid)) {
+                foundServices.append(uuid);
+                newServiceAdded = true;
             }
-            if (!newServiceAdded) {
-                if (!changedFields.testFlag(QBluetoothDeviceInfo::Field::None)) {
-                    QMetaObject::invokeMethod(this, "deviceDataChanged", Qt::AutoConnection,
-                                              Q_ARG(QBluetoothAddress, QBluetoothAddress(address)),
-                                              Q_ARG(QBluetoothDeviceInfo::Fields, changedFields),
-                                              Q_ARG(qint16, rssi),
-                                              Q_ARG(ManufacturerData, manufacturerData),
-                                              Q_ARG(ServiceData, serviceData));
-                }
-                return S_OK;
+        }
+        if (!newServiceAdded) {
+            if (!changedFields.testFlag(QBluetoothDeviceInfo::Field::None)) {
+                emit deviceDataChanged(QBluetoothAddress(address), changedFields, rssi,
+                                       manufacturerData, serviceData);
             }
-            m_foundLEDevicesMap[address].services = foundServices;
-        } else {
-            LEAdvertisingInfo info;
-            info.services = std::move(serviceUuids);
-            info.manufacturerData = std::move(manufacturerData);
-            info.serviceData = std::move(serviceData);
-            info.rssi = rssi;
-            m_foundLEDevicesMap.insert(address, info);
+            return;
         }
+        m_foundLEDevicesMap[address].services = foundServices;
+    } else {
+        LEAdvertisingInfo info;
+        info.services = std::move(advertisement.services);
+        info.manufacturerData = std::move(advertisement.manufacturerData);
+        info.serviceData = std::move(advertisement.serviceData);
+        info.rssi = rssi;
+        m_foundLEDevicesMap.insert(address, info);
     }
     leBluetoothInfoFromAddressAsync(address);
-    return S_OK;
 }
 
 void QWinRTBluetoothDeviceDiscoveryWorker::setupLEDeviceWatcher()
@@ -448,10 +589,12 @@ void QWinRTBluetoothDeviceDiscoveryWorker::setupLEDeviceWatcher()
     EMIT_WORKER_ERROR_AND_RETURN_IF_FAILED("Could not create advertisment watcher",
                                            QBluetoothDeviceDiscoveryAgent::Error::UnknownError,
                                            return);
-    hr = m_leWatcher->put_ScanningMode(BluetoothLEScanningMode_Active);
+    hr = m_leWatcher->put_ScanningMode(m_passiveScan ? BluetoothLEScanningMode_Passive
+                                                     : BluetoothLEScanningMode_Active);
     EMIT_WORKER_ERROR_AND_RETURN_IF_FAILED("Could not set scanning mode",
                                            QBluetoothDeviceDiscoveryAgent::Error::UnknownError,
                                            return);
+    setupLEAdvertisementFilter();
     QPointer<QWinRTBluetoothDeviceDiscoveryWorker> thisPointer(this);
     hr = m_leWatcher->add_Received(
                 Callback<ITypedEventHandler<BluetoothLEAdvertisementWatcher *, BluetoothLEAdvertisementReceivedEventArgs *>>(
@@ -470,6 +613,62 @@ void QWinRTBluetoothDeviceDiscoveryWorker::setupLEDeviceWatcher()
                                    return);
 }
 
+void QWinRTBluetoothDeviceDiscoveryWorker::setupLEAdvertisementFilter()
+{
+    // An advertisement passes the OS filter only if it contains all elements of
+    // the pattern, while Qt's filters accept any of the listed values. So only
+    // single element lists can be handed to the OS.
+    if (m_serviceUuidFilter.size() == 1 || m_manufacturerIdFilter.size() == 1) {
+        ComPtr<IBluetoothLEAdvertisementFilter> filter;
+        HRESULT hr = m_leWatcher->get_AdvertisementFilter(&filter);
+        WARN_AND_RETURN_IF_FAILED("Could not obtain advertisement filter", return);
+        ComPtr<IBluetoothLEAdvertisement> pattern;
+        hr = filter->get_Advertisement(&pattern);
+        WARN_AND_RETURN_IF_FAILED("Could not obtain advertisement filter pattern", return);
+
+        if (m_serviceUuidFilter.size() == 1) {
+            ComPtr<IVector<GUID>> uuids;
+            hr = pattern->get_ServiceUuids(&uuids);
+            WARN_AND_RETURN_IF_FAILED("Could not obtain service uuid filter", return);
+            hr = uuids->Append(GUID(m_serviceUuidFilter.constFirst()));
+            WARN_AND_RETURN_IF_FAILED("Could not set service uuid filter", return);
+        }
+
+        if (m_manufacturerIdFilter.size() == 1) {
+            ComPtr<IInspectable> inspectable;
+            hr = RoActivateInstance(HString::MakeReference(RuntimeClass_Windows_Devices_Bluetooth_Advertisement_BluetoothLEManufacturerData).Get(), &inspectable);
+            WARN_AND_RETURN_IF_FAILED("Could not create manufacturer data filter", return);
+            ComPtr<IBluetoothLEManufacturerData> manufacturerData;
+            hr = inspectable.As(&manufacturerData);
+            WARN_AND_RETURN_IF_FAILED("Could not cast manufacturer data filter", return);
+            hr = manufacturerData->put_CompanyId(m_manufacturerIdFilter.constFirst());
+            WARN_AND_RETURN_IF_FAILED("Could not set manufacturer id filter", return);
+            ComPtr<IVector<BluetoothLEManufacturerData *>> manufacturerDataList;
+            hr = pattern->get_ManufacturerData(&manufacturerDataList);
+            WARN_AND_RETURN_IF_FAILED("Could not obtain manufacturer data filter list", return);
+            hr = manufacturerDataList->Append(manufacturerData.Get());
+            WARN_AND_RETURN_IF_FAILED("Could not set manufacturer data filter", return);
+        }
+    }
+
+    if (m_rssiThreshold != 0) {
+        ComPtr<IBluetoothSignalStrengthFilter> signalStrengthFilter;
+        HRESULT hr = m_leWatcher->get_SignalStrengthFilter(&signalStrengthFilter);
+        WARN_AND_RETURN_IF_FAILED("Could not obtain signal strength filter", return);
+        ComPtr<IPropertyValueStatics> valueStatics;
+        hr = GetActivationFactory(HString::MakeReference(RuntimeClass_Windows_Foundation_PropertyValue).Get(), &valueStatics);
+        WARN_AND_RETURN_IF_FAILED("Could not obtain property value statics", return);
+        ComPtr<IInspectable> boxedThreshold;
+        hr = valueStatics->CreateInt16(m_rssiThreshold, &boxedThreshold);
+        WARN_AND_RETURN_IF_FAILED("Could not create signal strength threshold", return);
+        ComPtr<IReference<INT16>> threshold;
+        hr = boxedThreshold.As(&threshold);
+        WARN_AND_RETURN_IF_FAILED("Could not cast signal strength threshold", return);
+        hr = signalStrengthFilter->put_InRangeThresholdInDBm(threshold.Get());
+        WARN_AND_RETURN_IF_FAILED("Could not set signal strength filter", return);
+    }
+}
+
 void QWinRTBluetoothDeviceDiscoveryWorker::finishDiscovery()
 {
     emit scanFinished();
@@ -743,7 +942,10 @@ HRESULT QWinRTBluetoothDeviceDiscoveryWorker::onPairedBluetoothLEDeviceFoundAsyn
     EMIT_WORKER_ERROR_AND_RETURN_IF_FAILED("Could not obtain bluetooth le device",
                                    QBluetoothDeviceDiscoveryAgent::Error::UnknownError,
                                    return S_OK);
-    return onBluetoothLEDeviceFound(device);
+    // the advertising data of the device is only accessed on the worker's thread
+    QMetaObject::invokeMethod(this, [this, device]() { onBluetoothLEDeviceFound(device); },
+                              Qt::QueuedConnection);
+    return S_OK;
 }
 
 HRESULT QWinRTBluetoothDeviceDiscoveryWorker::onBluetoothLEDeviceFoundAsync(IAsyncOperation<BluetoothLEDevice *> *op, AsyncStatus status)
@@ -757,7 +959,9 @@ HRESULT QWinRTBluetoothDeviceDiscoveryWorker::onBluetoothLEDeviceFoundAsync(IAsy
     EMIT_WORKER_ERROR_AND_RETURN_IF_FAILED("Could not obtain bluetooth le device",
                                    QBluetoothDeviceDiscoveryAgent::Error::UnknownError,
                                    return S_OK);
-    return onBluetoothLEDeviceFound(device);
+    QMetaObject::invokeMethod(this, [this, device]() { onBluetoothLEDeviceFound(device); },
+                              Qt::QueuedConnection);
+    return S_OK;
 }
 
 static void invokeDeviceFoundWithDebug(QWinRTBluetoothDeviceDiscoveryWorker *worker,
@@ -971,7 +1175,9 @@ void QBluetoothDeviceDiscoveryAgentPrivate::start(QBluetoothDeviceDiscoveryAgent
         return;
 
     worker = new QWinRTBluetoothDeviceDiscoveryWorker(methods);
-    discoveredDevices.clear();
+    worker->setLowEnergyFilter(serviceUuidFilter, manufacturerIdFilter, rssiThreshold);
+    worker->setPassiveScan(lowEnergyPassiveScan);
+    clearDiscoveredDevices();
     connect(worker, &QWinRTBluetoothDeviceDiscoveryWorker::deviceFound,
             this, &QBluetoothDeviceDiscoveryAgentPrivate::registerDevice);
     connect(worker, &QWinRTBluetoothDeviceDiscoveryWorker::deviceDataChanged,
@@ -1010,23 +1216,24 @@ void QBluetoothDeviceDiscoveryAgentPrivate::registerDevice(const QBluetoothDevic
 {
     Q_Q(QBluetoothDeviceDiscoveryAgent);
 
-    for (QList<QBluetoothDeviceInfo>::iterator iter = discoveredDevices.begin();
-        iter != discoveredDevices.end(); ++iter) {
-        if (iter->address() == info.address()) {
-            qCDebug(QT_BT_WINDOWS) << "Updating device" << iter->name() << iter->address();
-            // merge service uuids
-            QList<QBluetoothUuid> uuids = iter->serviceUuids();
-            uuids.append(info.serviceUuids());
-            const QSet<QBluetoothUuid> uuidSet(uuids.begin(), uuids.end());
-            if (iter->serviceUuids().size() != uuidSet.size())
-                iter->setServiceUuids(uuidSet.values().toVector());
-            if (iter->coreConfigurations() != info.coreConfigurations())
-                iter->setCoreConfigurations(QBluetoothDeviceInfo::BaseRateAndLowEnergyCoreConfiguration);
-            return;
-        }
+    reportAdvertisement(info);
+
+    const qsizetype i = discoveredDevices.indexOf(info.address());
+    if (i >= 0) {
+        QBluetoothDeviceInfo &device = discoveredDevices[i];
+        qCDebug(QT_BT_WINDOWS) << "Updating device" << device.name() << device.address();
+        // merge service uuids
+        QList<QBluetoothUuid> uuids = device.serviceUuids();
+        uuids.append(info.serviceUuids());
+        const QSet<QBluetoothUuid> uuidSet(uuids.begin(), uuids.end());
+        if (device.serviceUuids().size() != uuidSet.size())
+            device.setServiceUuids(uuidSet.values().toVector());
+        if (device.coreConfigurations() != info.coreConfigurations())
+            device.setCoreConfigurations(QBluetoothDeviceInfo::BaseRateAndLowEnergyCoreConfiguration);
+        return;
     }
 
-    discoveredDevices << info;
+    addDiscoveredDevice(info);
     emit q->deviceDiscovered(info);
 }
 
@@ -1040,22 +1247,22 @@ void QBluetoothDeviceDiscoveryAgentPrivate::updateDeviceData(const QBluetoothAdd
         return;
 
     Q_Q(QBluetoothDeviceDiscoveryAgent);
-    for (QList<QBluetoothDeviceInfo>::iterator iter = discoveredDevices.begin();
-        iter != discoveredDevices.end(); ++iter) {
-        if (iter->address() == address) {
-            qCDebug(QT_BT_WINDOWS) << "Updating data for device" << iter->name() << iter->address();
-            if (fields.testFlag(QBluetoothDeviceInfo::Field::RSSI))
-                iter->setRssi(rssi);
-            if (fields.testFlag(QBluetoothDeviceInfo::Field::ManufacturerData))
-                for (quint16 key : manufacturerData.keys())
-                    iter->setManufacturerData(key, manufacturerData.value(key));
-            if (fields.testFlag(QBluetoothDeviceInfo::Field::ServiceData))
-                for (QBluetoothUuid key : serviceData.keys())
-                    iter->setServiceData(key, serviceData.value(key));
-            emit q->deviceUpdated(*iter, fields);
-            return;
-        }
-    }
+    const qsizetype i = discoveredDevices.indexOf(address);
+    if (i < 0)
+        return;
+
+    QBluetoothDeviceInfo &device = discoveredDevices[i];
+    qCDebug(QT_BT_WINDOWS) << "Updating data for device" << device.name() << device.address();
+    if (fields.testFlag(QBluetoothDeviceInfo::Field::RSSI))
+        device.setRssi(rssi);
+    if (fields.testFlag(QBluetoothDeviceInfo::Field::ManufacturerData))
+        for (quint16 key : manufacturerData.keys())
+            device.setManufacturerData(key, manufacturerData.value(key));
+    if (fields.testFlag(QBluetoothDeviceInfo::Field::ServiceData))
+        for (QBluetoothUuid key : serviceData.keys())
+            device.setServiceData(key, serviceData.value(key));
+    reportAdvertisement(device);
+    emit q->deviceUpdated(device, fields);
 }
 
 void QBluetoothDeviceDiscoveryAgentPrivate::onErrorOccured(QBluetoothDeviceDiscoveryAgent::Error e)
@@ -0,0 +1,424 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qbluetoothdevicediscoverymodel.h"
+#include "qbluetoothdevicediscoveryagent.h"
+
+#include <QtCore/qhash.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qtimer.h>
+
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \since 6.5
+    \class QBluetoothDeviceDiscoveryModel
+    \brief The QBluetoothDeviceDiscoveryModel class provides a list model of
+           the devices found by a \l QBluetoothDeviceDiscoveryAgent.
+
+    \inmodule QtBluetooth
+
+    The model has one row per device the agent reported via
+    \l QBluetoothDeviceDiscoveryAgent::deviceDiscovered(). New devices are
+    appended, devices reported by
+    \l QBluetoothDeviceDiscoveryAgent::deviceLost() are removed. Updates of a
+    known device, for example a new RSSI value, change its row in place and
+    emit \l {QAbstractItemModel::dataChanged()}{dataChanged()} for the roles
+    which actually changed only. Finding the row of a device takes constant
+    time, independent of the number of devices.
+
+    During a discovery near many devices the agent reports hundreds of
+    updates per second. With an \l updateInterval() the model collects the
+    new rows and changes and passes them on to the views at most once per
+    interval.
+
+    \sa QBluetoothDeviceDiscoveryAgent
+*/
+
+/*!
+    \enum QBluetoothDeviceDiscoveryModel::Role
+
+    This enum describes the roles of the model. \c Qt::DisplayRole holds the
+    name of the device, or its address if the device has no name.
+
+    \value DeviceInfoRole           The \l QBluetoothDeviceInfo of the device.
+    \value AddressRole              The \l QBluetoothAddress of the device.
+    \value DeviceUuidRole           The \l QBluetoothUuid identifying the device
+                                    on \macos and iOS.
+    \value NameRole                 The name of the device.
+    \value RssiRole                 The last RSSI of the device.
+    \value ManufacturerDataRole     The manufacturer data of the device, see
+                                    \l QBluetoothDeviceInfo::manufacturerData().
+    \value ServiceDataRole          The service data of the device, see
+                                    \l QBluetoothDeviceInfo::serviceData().
+*/
+
+class QBluetoothDeviceDiscoveryModelPrivate
+{
+    Q_DECLARE_PUBLIC(QBluetoothDeviceDiscoveryModel)
+public:
+    explicit QBluetoothDeviceDiscoveryModelPrivate(QBluetoothDeviceDiscoveryModel *q) : q_ptr(q) {}
+
+    qsizetype indexOf(const QBluetoothDeviceInfo &info) const;
+    void insertIndex(const QBluetoothDeviceInfo &info, qsizetype row);
+    void removeIndex(const QBluetoothDeviceInfo &info);
+    void reset();
+    void updateDevice(const QBluetoothDeviceInfo &info);
+    void removeDevice(const QBluetoothDeviceInfo &info);
+    void scheduleUpdate();
+    void flush();
+
+    QBluetoothDeviceDiscoveryModel *q_ptr;
+    QPointer<QBluetoothDeviceDiscoveryAgent> agent;
+    QTimer *updateTimer = nullptr;
+    int updateInterval = 0;
+
+    // the rows known to the views, followed by the rows not inserted yet
+    QList<QBluetoothDeviceInfo> devices;
+    qsizetype insertedRows = 0;
+    // devices without an address are identified by their device uuid
+    QHash<QBluetoothAddress, qsizetype> addressIndex;
+    QHash<QBluetoothUuid, qsizetype> uuidIndex;
+    // roles of the inserted rows which changed since the last flush()
+    QHash<qsizetype, QList<int>> changedRoles;
+};
+
+static QList<int> differingRoles(const QBluetoothDeviceInfo &oldInfo,
+                                 const QBluetoothDeviceInfo &newInfo)
+{
+    QList<int> roles;
+    if (oldInfo.name() != newInfo.name())
+        roles << Qt::DisplayRole << QBluetoothDeviceDiscoveryModel::NameRole;
+    if (oldInfo.rssi() != newInfo.rssi())
+        roles << QBluetoothDeviceDiscoveryModel::RssiRole;
+    if (oldInfo.manufacturerData() != newInfo.manufacturerData())
+        roles << QBluetoothDeviceDiscoveryModel::ManufacturerDataRole;
+    if (oldInfo.serviceData() != newInfo.serviceData())
+        roles << QBluetoothDeviceDiscoveryModel::ServiceDataRole;
+    if (!roles.isEmpty() || oldInfo != newInfo)
+        roles << QBluetoothDeviceDiscoveryModel::DeviceInfoRole;
+    return roles;
+}
+
+qsizetype QBluetoothDeviceDiscoveryModelPrivate::indexOf(const QBluetoothDeviceInfo &info) const
+{
+    if (!info.address().isNull())
+        return addressIndex.value(info.address(), -1);
+    if (!info.deviceUuid().isNull())
+        return uuidIndex.value(info.deviceUuid(), -1);
+    return -1;
+}
+
+void QBluetoothDeviceDiscoveryModelPrivate::insertIndex(const QBluetoothDeviceInfo &info,
+                                                        qsizetype row)
+{
+    if (!info.address().isNull())
+        addressIndex.insert(info.address(), row);
+    else
+        uuidIndex.insert(info.deviceUuid(), row);
+}
+
+void QBluetoothDeviceDiscoveryModelPrivate::removeIndex(const QBluetoothDeviceInfo &info)
+{
+    if (!info.address().isNull())
+        addressIndex.remove(info.address());
+    else
+        uuidIndex.remove(info.deviceUuid());
+}
+
+void QBluetoothDeviceDiscoveryModelPrivate::reset()
+{
+    Q_Q(QBluetoothDeviceDiscoveryModel);
+
+    q->beginResetModel();
+    updateTimer->stop();
+    devices.clear();
+    addressIndex.clear();
+    uuidIndex.clear();
+    changedRoles.clear();
+    if (agent) {
+        const QList<QBluetoothDeviceInfo> discovered = agent->discoveredDevices();
+        for (const QBluetoothDeviceInfo &info : discovered) {
+            if (info.address().isNull() && info.deviceUuid().isNull())
+                continue;
+            const qsizetype row = indexOf(info);
+            if (row >= 0) {
+                devices[row] = info;
+            } else {
+                insertIndex(info, devices.size());
+                devices.append(info);
+            }
+        }
+    }
+    insertedRows = devices.size();
+    q->endResetModel();
+}
+
+void QBluetoothDeviceDiscoveryModelPrivate::updateDevice(const QBluetoothDeviceInfo &info)
+{
+    if (info.address().isNull() && info.deviceUuid().isNull())
+        return;
+
+    const qsizetype row = indexOf(info);
+    if (row < 0) {
+        insertIndex(info, devices.size());
+        devices.append(info);
+        scheduleUpdate();
+        return;
+    }
+
+    const QList<int> roles = differingRoles(devices.at(row), info);
+    if (roles.isEmpty())
+        return;
+    devices[row] = info;
+    if (row >= insertedRows)
+        return; // passed on with its insertion
+
+    QList<int> &pending = changedRoles[row];
+    for (int role : roles) {
+        if (!pending.contains(role))
+            pending.append(role);
+    }
+    scheduleUpdate();
+}
+
+void QBluetoothDeviceDiscoveryModelPrivate::removeDevice(const QBluetoothDeviceInfo &info)
+{
+    Q_Q(QBluetoothDeviceDiscoveryModel);
+
+    const qsizetype row = indexOf(info);
+    if (row < 0)
+        return;
+
+    // the row numbers of the pending changes are about to shift
+    flush();
+
+    q->beginRemoveRows(QModelIndex(), int(row), int(row));
+    removeIndex(devices.at(row));
+    devices.removeAt(row);
+    --insertedRows;
+    for (qsizetype i = row; i < devices.size(); ++i)
+        insertIndex(devices.at(i), i);
+    q->endRemoveRows();
+}
+
+void QBluetoothDeviceDiscoveryModelPrivate::scheduleUpdate()
+{
+    if (updateInterval <= 0)
+        flush();
+    else if (!updateTimer->isActive())
+        updateTimer->start(updateInterval);
+}
+
+void QBluetoothDeviceDiscoveryModelPrivate::flush()
+{
+    Q_Q(QBluetoothDeviceDiscoveryModel);
+
+    updateTimer->stop();
+
+    if (insertedRows < devices.size()) {
+        q->beginInsertRows(QModelIndex(), int(insertedRows), int(devices.size() - 1));
+        insertedRows = devices.size();
+        q->endInsertRows();
+    }
+
+    const QHash<qsizetype, QList<int>> changes = std::exchange(changedRoles, {});
+    for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+        const QModelIndex index = q->index(int(it.key()));
+        emit q->dataChanged(index, index, it.value());
+    }
+}
+
+/*!
+    Constructs a model without an agent with the given \a parent.
+
+    \sa setAgent()
+*/
+QBluetoothDeviceDiscoveryModel::QBluetoothDeviceDiscoveryModel(QObject *parent)
+    : QAbstractListModel(parent), d_ptr(new QBluetoothDeviceDiscoveryModelPrivate(this))
+{
+    Q_D(QBluetoothDeviceDiscoveryModel);
+    d->updateTimer = new QTimer(this);
+    d->updateTimer->setSingleShot(true);
+    connect(d->updateTimer, &QTimer::timeout, this, [d]() { d->flush(); });
+}
+
+/*!
+    Constructs a model of the devices found by \a agent with the given
+    \a parent.
+*/
+QBluetoothDeviceDiscoveryModel::QBluetoothDeviceDiscoveryModel(
+        QBluetoothDeviceDiscoveryAgent *agent, QObject *parent)
+    : QBluetoothDeviceDiscoveryModel(parent)
+{
+    setAgent(agent);
+}
+
+/*!
+    Destroys the model.
+*/
+QBluetoothDeviceDiscoveryModel::~QBluetoothDeviceDiscoveryModel()
+{
+    delete d_ptr;
+}
+
+/*!
+    Sets the \a agent whose devices the model holds. The model is reset with
+    the \l {QBluetoothDeviceDiscoveryAgent::discoveredDevices()}{devices}
+    the agent already found. The model does not take ownership of the agent,
+    once the agent is deleted the model is empty.
+
+    \note A new discovery of the agent drops its earlier results without
+    notification. Calling this function again with the same agent after
+    \l QBluetoothDeviceDiscoveryAgent::start() removes the rows of the
+    devices which are not found again.
+*/
+void QBluetoothDeviceDiscoveryModel::setAgent(QBluetoothDeviceDiscoveryAgent *agent)
+{
+    Q_D(QBluetoothDeviceDiscoveryModel);
+
+    if (d->agent)
+        disconnect(d->agent, nullptr, this, nullptr);
+    d->agent = agent;
+
+    if (agent) {
+        connect(agent, &QBluetoothDeviceDiscoveryAgent::deviceDiscovered, this,
+                [d](const QBluetoothDeviceInfo &info) { d->updateDevice(info); });
+        connect(agent, &QBluetoothDeviceDiscoveryAgent::deviceUpdated, this,
+                [d](const QBluetoothDeviceInfo &info) { d->updateDevice(info); });
+        connect(agent, &QBluetoothDeviceDiscoveryAgent::deviceLost, this,
+                [d](const QBluetoothDeviceInfo &info) { d->removeDevice(info); });
+        connect(agent, &QObject::destroyed, this, [d]() { d->reset(); });
+    }
+
+    d->reset();
+}
+
+/*!
+    Returns the agent whose devices the model holds.
+*/
+QBluetoothDeviceDiscoveryAgent *QBluetoothDeviceDiscoveryModel::agent() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryModel);
+    return d->agent;
+}
+
+/*!
+    Sets the update interval of the model to \a msecs milliseconds.
+
+    New devices and changes of known devices are passed on to the views at
+    most once per interval. A device which is lost removes its row right
+    away. The default of 0 passes on every change as soon as the agent
+    reports it.
+*/
+void QBluetoothDeviceDiscoveryModel::setUpdateInterval(int msecs)
+{
+    Q_D(QBluetoothDeviceDiscoveryModel);
+
+    d->updateInterval = qMax(msecs, 0);
+    if (d->updateInterval == 0 && d->updateTimer->isActive())
+        d->flush();
+}
+
+/*!
+    Returns the update interval of the model in milliseconds.
+*/
+int QBluetoothDeviceDiscoveryModel::updateInterval() const
+{
+    Q_D(const QBluetoothDeviceDiscoveryModel);
+    return d->updateInterval;
+}
+
+/*!
+    Returns the device in \a row, or an invalid \l QBluetoothDeviceInfo if
+    there is no such row.
+*/
+QBluetoothDeviceInfo QBluetoothDeviceDiscoveryModel::device(int row) const
+{
+    Q_D(const QBluetoothDeviceDiscoveryModel);
+
+    if (row < 0 || row >= d->insertedRows)
+        return QBluetoothDeviceInfo();
+    return d->devices.at(row);
+}
+
+/*!
+    Returns the row of the device \a info, or -1 if the model does not hold
+    the device. The device is identified by its address, or by its device
+    uuid on \macos and iOS.
+*/
+int QBluetoothDeviceDiscoveryModel::indexOfDevice(const QBluetoothDeviceInfo &info) const
+{
+    Q_D(const QBluetoothDeviceDiscoveryModel);
+
+    const qsizetype row = d->indexOf(info);
+    return row < d->insertedRows ? int(row) : -1;
+}
+
+/*!
+    \reimp
+*/
+int QBluetoothDeviceDiscoveryModel::rowCount(const QModelIndex &parent) const
+{
+    Q_D(const QBluetoothDeviceDiscoveryModel);
+    return parent.isValid() ? 0 : int(d->insertedRows);
+}
+
+/*!
+    \reimp
+*/
+QVariant QBluetoothDeviceDiscoveryModel::data(const QModelIndex &index, int role) const
+{
+    Q_D(const QBluetoothDeviceDiscoveryModel);
+
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid | CheckIndexOption::ParentIsInvalid))
+        return QVariant();
+
+    const QBluetoothDeviceInfo &info = d->devices.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        if (!info.name().isEmpty())
+            return info.name();
+        if (!info.address().isNull())
+            return info.address().toString();
+        return info.deviceUuid().toString();
+    case DeviceInfoRole:
+        return QVariant::fromValue(info);
+    case AddressRole:
+        return QVariant::fromValue(info.address());
+    case DeviceUuidRole:
+        return QVariant::fromValue(info.deviceUuid());
+    case NameRole:
+        return info.name();
+    case RssiRole:
+        return int(info.rssi());
+    case ManufacturerDataRole:
+        return QVariant::fromValue(info.manufacturerData());
+    case ServiceDataRole:
+        return QVariant::fromValue(info.serviceData());
+    default:
+        return QVariant();
+    }
+}
+
+/*!
+    \reimp
+*/
+QHash<int, QByteArray> QBluetoothDeviceDiscoveryModel::roleNames() const
+{
+    QHash<int, QByteArray> names = QAbstractListModel::roleNames();
+    names.insert(DeviceInfoRole, QByteArrayLiteral("deviceInfo"));
+    names.insert(AddressRole, QByteArrayLiteral("address"));
+    names.insert(DeviceUuidRole, QByteArrayLiteral("deviceUuid"));
+    names.insert(NameRole, QByteArrayLiteral("name"));
+    names.insert(RssiRole, QByteArrayLiteral("rssi"));
+    names.insert(ManufacturerDataRole, QByteArrayLiteral("manufacturerData"));
+    names.insert(ServiceDataRole, QByteArrayLiteral("serviceData"));
+    return names;
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qbluetoothdevicediscoverymodel.cpp"
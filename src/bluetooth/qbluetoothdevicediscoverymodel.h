@@ -0,0 +1,56 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QBLUETOOTHDEVICEDISCOVERYMODEL_H
+#define QBLUETOOTHDEVICEDISCOVERYMODEL_H
+
+#include <QtBluetooth/qtbluetoothglobal.h>
+#include <QtBluetooth/qbluetoothdeviceinfo.h>
+#include <QtCore/qabstractitemmodel.h>
+
+QT_BEGIN_NAMESPACE
+
+class QBluetoothDeviceDiscoveryAgent;
+class QBluetoothDeviceDiscoveryModelPrivate;
+
+class Q_BLUETOOTH_EXPORT QBluetoothDeviceDiscoveryModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Role {
+        DeviceInfoRole = Qt::UserRole + 1,
+        AddressRole,
+        DeviceUuidRole,
+        NameRole,
+        RssiRole,
+        ManufacturerDataRole,
+        ServiceDataRole
+    };
+    Q_ENUM(Role)
+
+    explicit QBluetoothDeviceDiscoveryModel(QObject *parent = nullptr);
+    explicit QBluetoothDeviceDiscoveryModel(QBluetoothDeviceDiscoveryAgent *agent,
+                                            QObject *parent = nullptr);
+    ~QBluetoothDeviceDiscoveryModel();
+
+    void setAgent(QBluetoothDeviceDiscoveryAgent *agent);
+    QBluetoothDeviceDiscoveryAgent *agent() const;
+
+    void setUpdateInterval(int msecs);
+    int updateInterval() const;
+
+    QBluetoothDeviceInfo device(int row) const;
+    int indexOfDevice(const QBluetoothDeviceInfo &info) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+private:
+    Q_DECLARE_PRIVATE(QBluetoothDeviceDiscoveryModel)
+    QBluetoothDeviceDiscoveryModelPrivate *d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif // QBLUETOOTHDEVICEDISCOVERYMODEL_H
@@ -4,6 +4,8 @@
 #include "qbluetoothdeviceinfo.h"
 #include "qbluetoothdeviceinfo_p.h"
 
+#include <QtCore/qendian.h>
+
 QT_BEGIN_NAMESPACE
 
 QT_IMPL_METATYPE_EXTERN(QBluetoothDeviceInfo)
@@ -406,8 +408,6 @@ bool QBluetoothDeviceInfo::equals(const QBluetoothDeviceInfo &a, const QBluetoot
         return false;
     if (a.d_func()->address != b.d_func()->address)
         return false;
-    if (a.d_func()->serviceUuids.size() != b.d_func()->serviceUuids.size())
-        return false;
     if (a.d_func()->serviceUuids != b.d_func()->serviceUuids)
         return false;
     if (a.d_func()->manufacturerData != b.d_func()->manufacturerData)
@@ -502,7 +502,7 @@ quint8 QBluetoothDeviceInfo::minorDeviceClass() const
 void QBluetoothDeviceInfo::setServiceUuids(const QList<QBluetoothUuid> &uuids)
 {
     Q_D(QBluetoothDeviceInfo);
-    d->serviceUuids = uuids;
+    d->serviceUuids.assign(uuids);
 }
 
 /*!
@@ -516,7 +516,7 @@ void QBluetoothDeviceInfo::setServiceUuids(const QList<QBluetoothUuid> &uuids)
 QList<QBluetoothUuid> QBluetoothDeviceInfo::serviceUuids() const
 {
     Q_D(const QBluetoothDeviceInfo);
-    return d->serviceUuids;
+    return d->serviceUuids.toList();
 }
 
 /*!
@@ -529,7 +529,7 @@ QList<QBluetoothUuid> QBluetoothDeviceInfo::serviceUuids() const
 QList<quint16> QBluetoothDeviceInfo::manufacturerIds() const
 {
     Q_D(const QBluetoothDeviceInfo);
-    return d->manufacturerData.keys().toList();
+    return d->manufacturerData.keys();
 }
 
 /*!
@@ -574,15 +574,7 @@ QByteArray QBluetoothDeviceInfo::manufacturerData(quint16 manufacturerId) const
 bool QBluetoothDeviceInfo::setManufacturerData(quint16 manufacturerId, const QByteArray &data)
 {
     Q_D(QBluetoothDeviceInfo);
-    auto it = d->manufacturerData.constFind(manufacturerId);
-    while (it != d->manufacturerData.cend() && it.key() == manufacturerId) {
-        if (*it == data)
-            return false;
-        it++;
-    }
-
-    d->manufacturerData.insert(manufacturerId, data);
-    return true;
+    return d->manufacturerData.insert(manufacturerId, data);
 }
 
 /*!
@@ -599,7 +591,7 @@ bool QBluetoothDeviceInfo::setManufacturerData(quint16 manufacturerId, const QBy
 QMultiHash<quint16, QByteArray> QBluetoothDeviceInfo::manufacturerData() const
 {
     Q_D(const QBluetoothDeviceInfo);
-    return d->manufacturerData;
+    return d->manufacturerData.toHash();
 }
 
 /*!
@@ -611,7 +603,7 @@ QMultiHash<quint16, QByteArray> QBluetoothDeviceInfo::manufacturerData() const
 QList<QBluetoothUuid> QBluetoothDeviceInfo::serviceIds() const
 {
     Q_D(const QBluetoothDeviceInfo);
-    return d->serviceData.keys().toList();
+    return d->serviceData.keys();
 }
 
 /*!
@@ -648,15 +640,7 @@ QByteArray QBluetoothDeviceInfo::serviceData(const QBluetoothUuid &serviceId) co
 bool QBluetoothDeviceInfo::setServiceData(const QBluetoothUuid &serviceId, const QByteArray &data)
 {
     Q_D(QBluetoothDeviceInfo);
-    auto it = d->serviceData.constFind(serviceId);
-    while (it != d->serviceData.cend() && it.key() == serviceId) {
-        if (*it == data)
-            return false;
-        it++;
-    }
-
-    d->serviceData.insert(serviceId, data);
-    return true;
+    return d->serviceData.insert(serviceId, data);
 }
 
 /*!
@@ -673,7 +657,7 @@ bool QBluetoothDeviceInfo::setServiceData(const QBluetoothUuid &serviceId, const
 QMultiHash<QBluetoothUuid, QByteArray> QBluetoothDeviceInfo::serviceData() const
 {
     Q_D(const QBluetoothDeviceInfo);
-    return d->serviceData;
+    return d->serviceData.toHash();
 }
 
 /*!
@@ -761,4 +745,120 @@ QBluetoothUuid QBluetoothDeviceInfo::deviceUuid() const
     return d->deviceUuid;
 }
 
+// AD types, see the Bluetooth Assigned Numbers document
+enum EirDataType : quint8 {
+    EirUuid16Incomplete = 0x02,
+    EirUuid16Complete = 0x03,
+    EirUuid32Incomplete = 0x04,
+    EirUuid32Complete = 0x05,
+    EirUuid128Incomplete = 0x06,
+    EirUuid128Complete = 0x07,
+    EirNameShort = 0x08,
+    EirNameComplete = 0x09,
+    EirClassOfDevice = 0x0d,
+    EirServiceData16 = 0x16,
+    EirServiceData32 = 0x20,
+    EirServiceData128 = 0x21,
+    EirManufacturerData = 0xff
+};
+
+// UUIDs are sent in little endian byte order
+static QBluetoothUuid uuidFromEir(const uchar *data, qsizetype size)
+{
+    switch (size) {
+    case 2:
+        return QBluetoothUuid(qFromLittleEndian<quint16>(data));
+    case 4:
+        return QBluetoothUuid(qFromLittleEndian<quint32>(data));
+    case 16: {
+        quint128 uuid;
+        for (int i = 0; i < 16; ++i)
+            uuid.data[15 - i] = data[i];
+        return QBluetoothUuid(uuid);
+    }
+    default:
+        return QBluetoothUuid();
+    }
+}
+
+QBluetoothEirData QBluetoothEirData::parse(QByteArrayView eirData)
+{
+    QBluetoothEirData result;
+
+    const uchar *data = reinterpret_cast<const uchar *>(eirData.data());
+    qsizetype offset = 0;
+    while (offset < eirData.size()) {
+        const qsizetype length = data[offset];
+        if (length == 0 || offset + 1 + length > eirData.size())
+            break; // early end of data or malformed
+        const quint8 type = data[offset + 1];
+        const uchar *value = data + offset + 2;
+        const qsizetype valueSize = length - 1;
+        offset += length + 1;
+
+        switch (type) {
+        case EirUuid16Incomplete:
+        case EirUuid16Complete:
+        case EirUuid32Incomplete:
+        case EirUuid32Complete:
+        case EirUuid128Incomplete:
+        case EirUuid128Complete: {
+            const qsizetype uuidSize = type <= EirUuid16Complete
+                    ? 2 : (type <= EirUuid32Complete ? 4 : 16);
+            for (qsizetype i = 0; i + uuidSize <= valueSize; i += uuidSize) {
+                const QBluetoothUuid uuid = uuidFromEir(value + i, uuidSize);
+                if (!result.serviceUuids.contains(uuid))
+                    result.serviceUuids.append(uuid);
+            }
+            break;
+        }
+        // the local name is UTF-8 encoded, see Core Specification 5.0, Vol 3, Part C, 12.1
+        case EirNameShort:
+            if (result.name.isEmpty())
+                result.name = QString::fromUtf8(reinterpret_cast<const char *>(value), valueSize);
+            break;
+        case EirNameComplete:
+            result.name = QString::fromUtf8(reinterpret_cast<const char *>(value), valueSize);
+            break;
+        case EirClassOfDevice:
+            if (valueSize == 3)
+                result.classOfDevice = value[0] | (value[1] << 8) | (value[2] << 16);
+            break;
+        case EirServiceData16:
+        case EirServiceData32:
+        case EirServiceData128: {
+            const qsizetype uuidSize = type == EirServiceData16
+                    ? 2 : (type == EirServiceData32 ? 4 : 16);
+            if (valueSize < uuidSize)
+                break;
+            result.serviceData.append(std::make_pair(
+                    uuidFromEir(value, uuidSize),
+                    QByteArray(reinterpret_cast<const char *>(value + uuidSize),
+                               valueSize - uuidSize)));
+            break;
+        }
+        case EirManufacturerData:
+            if (valueSize < 2)
+                break;
+            result.manufacturerData.append(std::make_pair(
+                    qFromLittleEndian<quint16>(value),
+                    QByteArray(reinterpret_cast<const char *>(value + 2), valueSize - 2)));
+            break;
+        default:
+            break;
+        }
+    }
+
+    return result;
+}
+
+void QBluetoothEirData::applyTo(QBluetoothDeviceInfo *info) const
+{
+    info->setServiceUuids(serviceUuids);
+    for (const auto &entry : manufacturerData)
+        info->setManufacturerData(entry.first, entry.second);
+    for (const auto &entry : serviceData)
+        info->setServiceData(entry.first, entry.second);
+}
+
 QT_END_NAMESPACE
@@ -20,11 +20,157 @@
 #include "qbluetoothuuid.h"
 
 #include <QString>
+#include <QtCore/qbytearrayview.h>
+#include <QtCore/qlist.h>
 #include <QtCore/qhash.h>
+#include <QtCore/qvarlengtharray.h>
 #include <QtCore/private/qglobal_p.h>
 
+#include <algorithm>
+#include <utility>
+
 QT_BEGIN_NAMESPACE
 
+/*
+ * Advertising data entries keyed by manufacturer id or service UUID.
+ *
+ * Most devices advertise a single entry, so keeping them in a small inline array
+ * avoids the span and node allocations a QMultiHash needs even for one element.
+ * Entries are kept in insertion order; like QMultiHash::value(), value() returns
+ * the most recently inserted entry for a key.
+ */
+template <typename Key>
+class QBluetoothAdvertisingDataList
+{
+public:
+    bool isEmpty() const { return entries.isEmpty(); }
+
+    bool insert(const Key &key, const QByteArray &data)
+    {
+        for (const auto &entry : entries) {
+            if (entry.first == key && entry.second == data)
+                return false;
+        }
+        entries.append(std::make_pair(key, data));
+        return true;
+    }
+
+    QByteArray value(const Key &key) const
+    {
+        for (auto it = entries.crbegin(); it != entries.crend(); ++it) {
+            if (it->first == key)
+                return it->second;
+        }
+        return QByteArray();
+    }
+
+    QList<Key> keys() const
+    {
+        QList<Key> result;
+        result.reserve(entries.size());
+        for (const auto &entry : entries)
+            result.append(entry.first);
+        return result;
+    }
+
+    QMultiHash<Key, QByteArray> toHash() const
+    {
+        QMultiHash<Key, QByteArray> result;
+        for (const auto &entry : entries)
+            result.insert(entry.first, entry.second);
+        return result;
+    }
+
+    // Entries are unique, so equal sizes and inclusion mean equal contents.
+    friend bool operator==(const QBluetoothAdvertisingDataList &a,
+                           const QBluetoothAdvertisingDataList &b)
+    {
+        if (a.entries.size() != b.entries.size())
+            return false;
+        for (const auto &entry : a.entries) {
+            if (std::find(b.entries.cbegin(), b.entries.cend(), entry) == b.entries.cend())
+                return false;
+        }
+        return true;
+    }
+    friend bool operator!=(const QBluetoothAdvertisingDataList &a,
+                           const QBluetoothAdvertisingDataList &b)
+    {
+        return !(a == b);
+    }
+
+private:
+    QVarLengthArray<std::pair<Key, QByteArray>, 1> entries;
+};
+
+/*
+ * Service UUIDs of a device. As long as all of them are based on the Bluetooth
+ * base UUID, only their 16-bit values are stored inline. Otherwise the full list
+ * is kept, preserving the order the UUIDs were set in.
+ */
+class QBluetoothServiceUuidList
+{
+public:
+    void assign(const QList<QBluetoothUuid> &uuids)
+    {
+        shortUuids.clear();
+        fullUuids.clear();
+        for (const QBluetoothUuid &uuid : uuids) {
+            bool ok = false;
+            const quint16 shortUuid = uuid.toUInt16(&ok);
+            if (!ok) {
+                shortUuids.clear();
+                fullUuids = uuids;
+                return;
+            }
+            shortUuids.append(shortUuid);
+        }
+    }
+
+    QList<QBluetoothUuid> toList() const
+    {
+        if (!fullUuids.isEmpty())
+            return fullUuids;
+        QList<QBluetoothUuid> result;
+        result.reserve(shortUuids.size());
+        for (quint16 shortUuid : shortUuids)
+            result.append(QBluetoothUuid(shortUuid));
+        return result;
+    }
+
+    friend bool operator==(const QBluetoothServiceUuidList &a, const QBluetoothServiceUuidList &b)
+    {
+        return a.shortUuids == b.shortUuids && a.fullUuids == b.fullUuids;
+    }
+    friend bool operator!=(const QBluetoothServiceUuidList &a, const QBluetoothServiceUuidList &b)
+    {
+        return !(a == b);
+    }
+
+private:
+    QVarLengthArray<quint16, 4> shortUuids;
+    QList<QBluetoothUuid> fullUuids;
+};
+
+/*
+ * The contents of an Extended Inquiry Response or of advertising data, taken
+ * from its AD structures in a single pass, see the Core Specification
+ * Supplement, Part A. Parsing stops at the first malformed structure.
+ */
+struct QBluetoothEirData
+{
+    static QBluetoothEirData parse(QByteArrayView data);
+    // Sets the service UUIDs, manufacturer data and service data of info.
+    void applyTo(QBluetoothDeviceInfo *info) const;
+
+    // the complete local name, or the shortened one if no complete one was sent
+    QString name;
+    quint32 classOfDevice = 0;
+    QList<QBluetoothUuid> serviceUuids;
+    QList<std::pair<quint16, QByteArray>> manufacturerData;
+    QList<std::pair<QBluetoothUuid, QByteArray>> serviceData;
+};
+
 class QBluetoothDeviceInfoPrivate
 {
 public:
@@ -41,9 +187,9 @@ public:
 
     QBluetoothDeviceInfo::ServiceClasses serviceClasses = QBluetoothDeviceInfo::NoService;
 
-    QList<QBluetoothUuid> serviceUuids;
-    QMultiHash<quint16, QByteArray> manufacturerData;
-    QMultiHash<QBluetoothUuid, QByteArray> serviceData;
+    QBluetoothServiceUuidList serviceUuids;
+    QBluetoothAdvertisingDataList<quint16> manufacturerData;
+    QBluetoothAdvertisingDataList<QBluetoothUuid> serviceData;
     QBluetoothDeviceInfo::CoreConfigurations deviceCoreConfiguration = QBluetoothDeviceInfo::UnknownCoreConfiguration;
 
     QBluetoothUuid deviceUuid;
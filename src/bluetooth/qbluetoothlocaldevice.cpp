@@ -142,6 +142,33 @@ bool QBluetoothLocalDevice::isValid() const
 
 #endif
 
+/*!
+    Requests the pairing status of \a address without blocking the calling
+    thread. The result is delivered by \l pairingStatusReceived(), never
+    before this function returns.
+
+    On Linux pairingStatus() may have to fetch the object tree of BlueZ over
+    D-Bus, which takes a noticeable time on hosts knowing many devices. This
+    function fetches it asynchronously instead. Subsequent calls of either
+    function are answered from a cache. On the other platforms the result of
+    pairingStatus() is reported.
+
+    \since 6.5
+    \sa pairingStatus()
+*/
+void QBluetoothLocalDevice::requestPairingStatus(const QBluetoothAddress &address)
+{
+#if QT_CONFIG(bluez) && !defined(QT_ANDROID_BLUETOOTH)
+    if (d_ptr) {
+        d_ptr->requestPairingStatus(address);
+        return;
+    }
+#endif
+    QMetaObject::invokeMethod(this, [this, address]() {
+        emit pairingStatusReceived(address, pairingStatus(address));
+    }, Qt::QueuedConnection);
+}
+
 /*!
     \fn void QBluetoothLocalDevice::setHostMode(QBluetoothLocalDevice::HostMode mode)
 
@@ -250,6 +277,10 @@ bool QBluetoothLocalDevice::isValid() const
   Therefore it is possible that this function returns an empty list shortly after creating an
   instance.
 
+  On Linux all instances share one process-wide list which follows the connection changes
+  reported by BlueZ, including a restart of bluetoothd. Creating a short-lived instance to
+  call this function is therefore cheap.
+
   \sa deviceConnected(), deviceDisconnected()
 */
 
@@ -257,6 +288,8 @@ bool QBluetoothLocalDevice::isValid() const
   \fn QBluetoothLocalDevice::pairingStatus(const QBluetoothAddress &address) const
 
   Returns the current bluetooth pairing status of \a address, if it's unpaired, paired, or paired and authorized.
+
+  \sa requestPairingStatus()
 */
 
 /*!
@@ -285,6 +318,15 @@ bool QBluetoothLocalDevice::isValid() const
   instance.
 */
 
+/*!
+  \fn QBluetoothLocalDevice::pairingStatusReceived(const QBluetoothAddress &address,
+  QBluetoothLocalDevice::Pairing pairing)
+
+  The pairing status of \a address requested by \l requestPairingStatus() is \a pairing.
+
+  \since 6.5
+*/
+
 /*!
   \fn QBluetoothLocalDevice::errorOccurred(QBluetoothLocalDevice::Error error)
   Signal emitted if there's an exceptional \a error while pairing.
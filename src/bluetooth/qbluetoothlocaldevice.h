@@ -52,6 +52,7 @@ public:
 
     void requestPairing(const QBluetoothAddress &address, Pairing pairing);
     Pairing pairingStatus(const QBluetoothAddress &address) const;
+    void requestPairingStatus(const QBluetoothAddress &address);
 
     void setHostMode(QBluetoothLocalDevice::HostMode mode);
     HostMode hostMode() const;
@@ -69,6 +70,8 @@ Q_SIGNALS:
     void deviceConnected(const QBluetoothAddress &address);
     void deviceDisconnected(const QBluetoothAddress &address);
     void pairingFinished(const QBluetoothAddress &address, QBluetoothLocalDevice::Pairing pairing);
+    void pairingStatusReceived(const QBluetoothAddress &address,
+                               QBluetoothLocalDevice::Pairing pairing);
 
     void errorOccurred(QBluetoothLocalDevice::Error error);
 
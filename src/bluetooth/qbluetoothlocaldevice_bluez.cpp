@@ -11,7 +11,6 @@
 
 #include "bluez/bluez5_helper_p.h"
 #include "bluez/objectmanager_p.h"
-#include "bluez/properties_p.h"
 #include "bluez/adapter1_bluez5_p.h"
 #include "bluez/device1_bluez5_p.h"
 
@@ -19,9 +18,22 @@ QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
 
-inline uint qHash(const QBluetoothAddress &address)
+// Taken from the object path if possible, which saves a D-Bus call per device.
+static QBluetoothAddress deviceAddress(const QDBusObjectPath &path, const QVariantMap &properties)
 {
-    return ::qHash(address.toUInt64());
+    const QBluetoothAddress address = deviceAddressFromPath(path.path());
+    if (!address.isNull())
+        return address;
+    return QBluetoothAddress(properties.value(QStringLiteral("Address")).toString());
+}
+
+static QBluetoothLocalDevice::Pairing pairingFromProperties(const QVariantMap &properties)
+{
+    if (!properties.value(QStringLiteral("Paired")).toBool())
+        return QBluetoothLocalDevice::Unpaired;
+    if (properties.value(QStringLiteral("Trusted")).toBool())
+        return QBluetoothLocalDevice::AuthorizedPaired;
+    return QBluetoothLocalDevice::Paired;
 }
 
 QBluetoothLocalDevice::QBluetoothLocalDevice(QObject *parent) :
@@ -122,14 +134,12 @@ QList<QBluetoothHostInfo> QBluetoothLocalDevice::allDevices()
     QList<QBluetoothHostInfo> localDevices;
 
     initializeBluez5();
-    OrgFreedesktopDBusObjectManagerInterface manager(
-            QStringLiteral("org.bluez"), QStringLiteral("/"), QDBusConnection::systemBus());
-    QDBusPendingReply<ManagedObjectList> reply = manager.GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError())
+    QDBusError error;
+    const ManagedObjectList managedObjectList =
+            QtBluezObjectCache::instance()->managedObjects(&error);
+    if (error.isValid())
         return localDevices;
 
-    ManagedObjectList managedObjectList = reply.value();
     for (ManagedObjectList::const_iterator it = managedObjectList.constBegin();
          it != managedObjectList.constEnd(); ++it) {
         const InterfaceList &ifaceList = it.value();
@@ -209,14 +219,14 @@ void QBluetoothLocalDevicePrivate::requestPairing(const QBluetoothAddress &targe
     // if we cannot find it we may have to turn on Discovery mode for a limited amount of time
 
     // check device doesn't already exist
-    QDBusPendingReply<ManagedObjectList> reply = manager->GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError()) {
+    QDBusError error;
+    const ManagedObjectList managedObjectList =
+            QtBluezObjectCache::instance()->managedObjects(&error);
+    if (error.isValid()) {
         emit q_ptr->errorOccurred(QBluetoothLocalDevice::PairingError);
         return;
     }
 
-    ManagedObjectList managedObjectList = reply.value();
     for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
         const QDBusObjectPath &path = it.key();
         const InterfaceList &ifaceList = it.value();
@@ -225,11 +235,7 @@ void QBluetoothLocalDevicePrivate::requestPairing(const QBluetoothAddress &targe
             const QString &iface = jt.key();
 
             if (iface == QStringLiteral("org.bluez.Device1")) {
-
-                OrgBluezDevice1Interface device(QStringLiteral("org.bluez"),
-                                                path.path(),
-                                                QDBusConnection::systemBus());
-                if (targetAddress == QBluetoothAddress(device.address())) {
+                if (targetAddress == deviceAddress(path, jt.value())) {
                     qCDebug(QT_BT_BLUEZ) << "Initiating direct pair to" << targetAddress.toString();
                     //device exist -> directly work with it
                     processPairing(path.path(), targetPairing);
@@ -344,44 +350,37 @@ void QBluetoothLocalDevicePrivate::pairingDiscoveryTimedOut()
 QBluetoothLocalDevice::Pairing QBluetoothLocalDevice::pairingStatus(
     const QBluetoothAddress &address) const
 {
-    if (address.isNull())
+    if (address.isNull() || !isValid())
         return Unpaired;
 
-    if (isValid())
-    {
-        QDBusPendingReply<ManagedObjectList> reply = d_ptr->manager->GetManagedObjects();
-        reply.waitForFinished();
-        if (reply.isError())
-            return Unpaired;
-
-        ManagedObjectList managedObjectList = reply.value();
-        for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-            const QDBusObjectPath &path = it.key();
-            const InterfaceList &ifaceList = it.value();
-
-            for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-                const QString &iface = jt.key();
-
-                if (iface == QStringLiteral("org.bluez.Device1")) {
-
-                    OrgBluezDevice1Interface device(QStringLiteral("org.bluez"),
-                                                    path.path(),
-                                                    QDBusConnection::systemBus());
-
-                    if (address == QBluetoothAddress(device.address())) {
-                        if (device.trusted() && device.paired())
-                            return AuthorizedPaired;
-                        else if (device.paired())
-                            return Paired;
-                        else
-                            return Unpaired;
-                    }
-                }
-            }
-        }
+    // served from the object cache, D-Bus is only used to fill it once
+    QDBusError error;
+    const QVariantMap properties = QtBluezObjectCache::instance()->deviceProperties(
+                d_ptr->adapter->path(), address, &error);
+    if (error.isValid())
+        return Unpaired;
+    return pairingFromProperties(properties);
+}
+
+void QBluetoothLocalDevicePrivate::requestPairingStatus(const QBluetoothAddress &address)
+{
+    Q_Q(QBluetoothLocalDevice);
+    if (address.isNull() || !isValid()) {
+        QMetaObject::invokeMethod(q, [q, address]() {
+            emit q->pairingStatusReceived(address, QBluetoothLocalDevice::Unpaired);
+        }, Qt::QueuedConnection);
+        return;
     }
 
-    return Unpaired;
+    QtBluezObjectCache::instance()->fetchDeviceProperties(
+                adapter->path(), address, this,
+                [q, address](const QVariantMap &properties, const QDBusError &error) {
+        if (error.isValid())
+            qCWarning(QT_BT_BLUEZ) << "Cannot query pairing status:" << error.message();
+        emit q->pairingStatusReceived(address, error.isValid()
+                                      ? QBluetoothLocalDevice::Unpaired
+                                      : pairingFromProperties(properties));
+    });
 }
 
 QBluetoothLocalDevicePrivate::QBluetoothLocalDevicePrivate(QBluetoothLocalDevice *q,
@@ -397,51 +396,26 @@ QBluetoothLocalDevicePrivate::QBluetoothLocalDevicePrivate(QBluetoothLocalDevice
     connectDeviceChanges();
 }
 
-bool objectPathIsForThisDevice(const QString &adapterPath, const QString &objectPath)
-{
-    return (!adapterPath.isEmpty() && objectPath.startsWith(adapterPath));
-}
-
 void QBluetoothLocalDevicePrivate::connectDeviceChanges()
 {
+    // the object cache tracks the connections of all adapters in one place
     if (isValid()) {
-        //setup property change notifications for all existing devices
-        QDBusPendingReply<ManagedObjectList> reply = manager->GetManagedObjects();
-        reply.waitForFinished();
-        if (reply.isError())
-            return;
-
-        OrgFreedesktopDBusPropertiesInterface *monitor = nullptr;
-
-        ManagedObjectList managedObjectList = reply.value();
-        for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-            const QDBusObjectPath &path = it.key();
-            const InterfaceList &ifaceList = it.value();
-
-            // don't track connected devices from other adapters but the current
-            if (!objectPathIsForThisDevice(deviceAdapterPath, path.path()))
-                continue;
-
-            for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-                const QString &iface = jt.key();
-                const QVariantMap &ifaceValues = jt.value();
+        connect(QtBluezObjectCache::instance(), &QtBluezObjectCache::deviceConnectionChanged,
+                this, &QBluetoothLocalDevicePrivate::deviceConnectionChanged);
+    }
+}
 
-                if (iface == QStringLiteral("org.bluez.Device1")) {
-                    monitor = new OrgFreedesktopDBusPropertiesInterface(QStringLiteral("org.bluez"),
-                                                                        path.path(),
-                                                                        QDBusConnection::systemBus(), this);
-                    connect(monitor, &OrgFreedesktopDBusPropertiesInterface::PropertiesChanged,
-                            this, &QBluetoothLocalDevicePrivate::PropertiesChanged);
-                    deviceChangeMonitors.insert(path.path(), monitor);
+void QBluetoothLocalDevicePrivate::deviceConnectionChanged(const QString &adapterPath,
+                                                           const QBluetoothAddress &address,
+                                                           bool connected)
+{
+    if (!isValid() || adapterPath != deviceAdapterPath)
+        return;
 
-                    if (ifaceValues.value(QStringLiteral("Connected"), false).toBool()) {
-                        QBluetoothAddress address(ifaceValues.value(QStringLiteral("Address")).toString());
-                        connectedDevicesSet.insert(address);
-                    }
-                }
-            }
-        }
-    }
+    if (connected)
+        emit q_ptr->deviceConnected(address);
+    else
+        emit q_ptr->deviceDisconnected(address);
 }
 
 QBluetoothLocalDevicePrivate::~QBluetoothLocalDevicePrivate()
@@ -450,8 +424,6 @@ QBluetoothLocalDevicePrivate::~QBluetoothLocalDevicePrivate()
     delete adapterProperties;
     delete manager;
     delete pairingTarget;
-
-    qDeleteAll(deviceChangeMonitors);
 }
 
 void QBluetoothLocalDevicePrivate::initializeAdapter()
@@ -482,10 +454,9 @@ void QBluetoothLocalDevicePrivate::initializeAdapter()
 
     if (adapter) {
         //hook up propertiesChanged for current adapter
-        adapterProperties = new OrgFreedesktopDBusPropertiesInterface(
-                QStringLiteral("org.bluez"), adapter->path(),
-                QDBusConnection::systemBus(), this);
-        connect(adapterProperties, &OrgFreedesktopDBusPropertiesInterface::PropertiesChanged,
+        adapterProperties = new QtBluezPropertiesMonitor(
+                adapter->path(), QStringLiteral("org.bluez.Adapter1"), this);
+        connect(adapterProperties, &QtBluezPropertiesMonitor::PropertiesChanged,
                 this, &QBluetoothLocalDevicePrivate::PropertiesChanged);
     }
 }
@@ -529,60 +500,17 @@ void QBluetoothLocalDevicePrivate::PropertiesChanged(const QString &interface,
 
             currentMode = mode;
         }
-    } else if (interface == QStringLiteral("org.bluez.Device1")
-               && changed_properties.contains(QStringLiteral("Connected"))) {
-        // update list of connected devices
-        OrgFreedesktopDBusPropertiesInterface *senderIface =
-                qobject_cast<OrgFreedesktopDBusPropertiesInterface*>(sender());
-        if (!senderIface)
-            return;
-
-        const QString currentPath = senderIface->path();
-        bool isConnected = changed_properties.value(QStringLiteral("Connected"), false).toBool();
-        OrgBluezDevice1Interface device(QStringLiteral("org.bluez"), currentPath,
-                                        QDBusConnection::systemBus());
-        const QBluetoothAddress changedAddress(device.address());
-        bool isInSet = connectedDevicesSet.contains(changedAddress);
-        if (isConnected && !isInSet) {
-            connectedDevicesSet.insert(changedAddress);
-            emit q_ptr->deviceConnected(changedAddress);
-        } else if (!isConnected && isInSet) {
-            connectedDevicesSet.remove(changedAddress);
-            emit q_ptr->deviceDisconnected(changedAddress);
-        }
     }
 }
 
 void QBluetoothLocalDevicePrivate::InterfacesAdded(const QDBusObjectPath &object_path, InterfaceList interfaces_and_properties)
 {
-    if (interfaces_and_properties.contains(QStringLiteral("org.bluez.Device1"))
-        && !deviceChangeMonitors.contains(object_path.path())) {
-        // a new device was added which we need to add to list of known devices
-
-        if (objectPathIsForThisDevice(deviceAdapterPath, object_path.path())) {
-            OrgFreedesktopDBusPropertiesInterface *monitor = new OrgFreedesktopDBusPropertiesInterface(
-                                               QStringLiteral("org.bluez"),
-                                               object_path.path(),
-                                               QDBusConnection::systemBus());
-            connect(monitor, &OrgFreedesktopDBusPropertiesInterface::PropertiesChanged,
-                    this, &QBluetoothLocalDevicePrivate::PropertiesChanged);
-            deviceChangeMonitors.insert(object_path.path(), monitor);
-
-            const QVariantMap ifaceValues = interfaces_and_properties.value(QStringLiteral("org.bluez.Device1"));
-            if (ifaceValues.value(QStringLiteral("Connected"), false).toBool()) {
-                QBluetoothAddress address(ifaceValues.value(QStringLiteral("Address")).toString());
-                connectedDevicesSet.insert(address);
-                emit q_ptr->deviceConnected(address);
-            }
-        }
-    }
-
     if (pairingDiscoveryTimer && pairingDiscoveryTimer->isActive()
         && interfaces_and_properties.contains(QStringLiteral("org.bluez.Device1"))) {
         //device discovery for pairing found new remote device
-        OrgBluezDevice1Interface device(QStringLiteral("org.bluez"),
-                                        object_path.path(), QDBusConnection::systemBus());
-        if (!address.isNull() && address == QBluetoothAddress(device.address()))
+        const QVariantMap properties = interfaces_and_properties.value(
+                QStringLiteral("org.bluez.Device1"));
+        if (!address.isNull() && address == deviceAddress(object_path, properties))
             processPairing(object_path.path(), pairing);
     }
 }
@@ -590,24 +518,6 @@ void QBluetoothLocalDevicePrivate::InterfacesAdded(const QDBusObjectPath &object
 void QBluetoothLocalDevicePrivate::InterfacesRemoved(const QDBusObjectPath &object_path,
                                                      const QStringList &interfaces)
 {
-    if (deviceChangeMonitors.contains(object_path.path())
-            && interfaces.contains(QLatin1String("org.bluez.Device1"))) {
-
-        if (objectPathIsForThisDevice(deviceAdapterPath, object_path.path())) {
-            //a device was removed
-            delete deviceChangeMonitors.take(object_path.path());
-
-            //the path contains the address (e.g.: /org/bluez/hci0/dev_XX_XX_XX_XX_XX_XX)
-            //-> use it to update current list of connected devices
-            QString addressString = object_path.path().right(17);
-            addressString.replace(QStringLiteral("_"), QStringLiteral(":"));
-            const QBluetoothAddress address(addressString);
-            bool found = connectedDevicesSet.remove(address);
-            if (found)
-                emit q_ptr->deviceDisconnected(address);
-        }
-    }
-
     if (adapter && object_path.path() == adapter->path()
         && interfaces.contains(QLatin1String("org.bluez.Adapter1"))) {
         qCDebug(QT_BT_BLUEZ) << "Adapter" << adapter->path() << "was removed";
@@ -621,11 +531,6 @@ void QBluetoothLocalDevicePrivate::InterfacesRemoved(const QDBusObjectPath &obje
 
         delete pairingTarget;
         pairingTarget = nullptr;
-
-        // turn  off connectivity monitoring
-        qDeleteAll(deviceChangeMonitors);
-        deviceChangeMonitors.clear();
-        connectedDevicesSet.clear();
     }
 }
 
@@ -636,7 +541,9 @@ bool QBluetoothLocalDevicePrivate::isValid() const
 
 QList<QBluetoothAddress> QBluetoothLocalDevicePrivate::connectedDevices() const
 {
-    return connectedDevicesSet.values();
+    if (!isValid())
+        return QList<QBluetoothAddress>();
+    return QtBluezObjectCache::instance()->connectedDevices(deviceAdapterPath);
 }
 
 void QBluetoothLocalDevicePrivate::pairingCompleted(QDBusPendingCallWatcher *watcher)
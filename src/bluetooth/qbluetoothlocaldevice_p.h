@@ -28,7 +28,7 @@
 #include "bluez/bluez5_helper_p.h"
 
 class OrgBluezAdapter1Interface;
-class OrgFreedesktopDBusPropertiesInterface;
+class QtBluezPropertiesMonitor;
 class OrgFreedesktopDBusObjectManagerInterface;
 class OrgBluezDevice1Interface;
 
@@ -105,11 +105,9 @@ public:
                                  QBluetoothAddress localAddress = QBluetoothAddress());
     ~QBluetoothLocalDevicePrivate();
 
-    QSet<QBluetoothAddress> connectedDevicesSet;
     OrgBluezAdapter1Interface *adapter = nullptr;
-    OrgFreedesktopDBusPropertiesInterface *adapterProperties = nullptr;
+    QtBluezPropertiesMonitor *adapterProperties = nullptr;
     OrgFreedesktopDBusObjectManagerInterface *manager = nullptr;
-    QMap<QString, OrgFreedesktopDBusPropertiesInterface *> deviceChangeMonitors;
 
     QList<QBluetoothAddress> connectedDevices() const;
 
@@ -128,6 +126,7 @@ public slots:
 
     void requestPairing(const QBluetoothAddress &address,
                         QBluetoothLocalDevice::Pairing targetPairing);
+    void requestPairingStatus(const QBluetoothAddress &address);
 
 private Q_SLOTS:
     void PropertiesChanged(const QString &interface,
@@ -140,6 +139,8 @@ private Q_SLOTS:
                            const QStringList &interfaces);
     void processPairing(const QString &objectPath, QBluetoothLocalDevice::Pairing target);
     void pairingDiscoveryTimedOut();
+    void deviceConnectionChanged(const QString &adapterPath, const QBluetoothAddress &address,
+                                 bool connected);
 
 private:
     void connectDeviceChanges();
@@ -17,6 +17,7 @@
 #include <wrl.h>
 
 #include <QtCore/private/qfunctions_winrt_p.h>
+#include <QtCore/QEventLoop>
 #include <QtCore/QPointer>
 #include <QtCore/QTimer>
 #include <QtCore/QMutex>
@@ -34,24 +35,29 @@ QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT_WINDOWS)
 
+// For the calls which have to return a result synchronously. Instead of polling
+// the operation, this waits in an event loop which the completion quits. Events
+// are still processed meanwhile, so callers may be re-entered.
 template <typename T>
 static bool await(IAsyncOperation<T> &&asyncInfo, T &result, uint timeout = 0)
 {
-    using WinRtAsyncStatus = winrt::Windows::Foundation::AsyncStatus;
-    WinRtAsyncStatus status;
-    QElapsedTimer timer;
+    QEventLoop loop;
+    std::optional<T> value;
+    bool finished = false;
+    whenCompleted(asyncInfo, &loop, [&](const std::optional<T> &operationResult) {
+        value = operationResult;
+        finished = true;
+        loop.quit();
+    });
     if (timeout)
-        timer.start();
-    do {
-        QCoreApplication::processEvents();
-        status = asyncInfo.Status();
-    } while (status == WinRtAsyncStatus::Started && (!timeout || !timer.hasExpired(timeout)));
-    if (status == WinRtAsyncStatus::Completed) {
-        result = asyncInfo.GetResults();
-        return true;
-    } else {
+        QTimer::singleShot(timeout, &loop, &QEventLoop::quit);
+    if (!finished)
+        loop.exec();
+
+    if (!value)
         return false;
-    }
+    result = *value;
+    return true;
 }
 
 static QBluetoothLocalDevice::HostMode adjustHostMode(QBluetoothLocalDevice::HostMode mode)
@@ -258,7 +264,7 @@ QBluetoothLocalDevice::HostMode AdapterManager::addClient(QBluetoothLocalDeviceP
         return modeFromWindowsBluetoothState(radioInfo.radio.State());
     } else {
         // Note that when we use await(), we need to unlock the mutex, because
-        // it calls processEvents(), so other methods that demand the mutex can
+        // it runs an event loop, so other methods that demand the mutex can
         // be invoked.
         locker.unlock();
         Radio r = getRadioFromAdapterId(adapterId);
@@ -296,19 +302,21 @@ void AdapterManager::updateMode(winrt::hstring adapterId, QBluetoothLocalDevice:
 {
     QMutexLocker locker(&mMutex);
     if (mRadios.contains(adapterId)) {
-        RadioAccessStatus status = RadioAccessStatus::Unspecified;
         auto radio = mRadios[adapterId].radio; // can be nullptr
         locker.unlock();
         if (radio) {
-            const bool res = await(radio.SetStateAsync(windowsStateFromMode(mode)), status);
-            // If operation succeeds, we will update the state in the event handler.
-            if (!res || status != RadioAccessStatus::Allowed) {
-                qCWarning(QT_BT_WINDOWS, "Failed to update adapter state: SetStateAsync() failed!");
-                if (status == RadioAccessStatus::DeniedBySystem) {
-                    qCWarning(QT_BT_WINDOWS) << "Check that the user has permissions to manipulate"
-                                                " the selected Bluetooth device";
+            whenCompleted(radio.SetStateAsync(windowsStateFromMode(mode)), this,
+                          [](const std::optional<RadioAccessStatus> &status) {
+                // If operation succeeds, we will update the state in the event handler.
+                if (!status || *status != RadioAccessStatus::Allowed) {
+                    qCWarning(QT_BT_WINDOWS,
+                              "Failed to update adapter state: SetStateAsync() failed!");
+                    if (status == RadioAccessStatus::DeniedBySystem) {
+                        qCWarning(QT_BT_WINDOWS) << "Check that the user has permissions to"
+                                                    " manipulate the selected Bluetooth device";
+                    }
                 }
-            }
+            });
         }
     }
 }
@@ -392,58 +400,68 @@ struct BluetoothInfo
     bool isConnected;
 };
 
-static BluetoothInfo getBluetoothInfo(winrt::hstring id)
+// Calls handler on the thread of context with the information about the
+// device, or with a null address if it could not be obtained.
+template <typename Handler>
+static void getBluetoothInfo(winrt::hstring id, QObject *context, Handler handler)
 {
     // We do not know if it's a BT classic or BTLE device, so we try both.
-    BluetoothDevice device(nullptr);
-    bool res = await(BluetoothDevice::FromIdAsync(id), device, 5000);
-    if (res && device) {
-        return { QBluetoothAddress(device.BluetoothAddress()),
-                 device.ConnectionStatus() == BluetoothConnectionStatus::Connected };
-    }
-
-    BluetoothLEDevice leDevice(nullptr);
-    res = await(BluetoothLEDevice::FromIdAsync(id), leDevice, 5000);
-    if (res && leDevice) {
-        return { QBluetoothAddress(leDevice.BluetoothAddress()),
-                 leDevice.ConnectionStatus() == BluetoothConnectionStatus::Connected };
-    }
+    whenCompleted(BluetoothDevice::FromIdAsync(id), context,
+                  [id, context, handler](const std::optional<BluetoothDevice> &device) {
+        if (device && *device) {
+            handler(BluetoothInfo{ QBluetoothAddress(device->BluetoothAddress()),
+                                   device->ConnectionStatus()
+                                           == BluetoothConnectionStatus::Connected });
+            return;
+        }
 
-    return {};
+        whenCompleted(BluetoothLEDevice::FromIdAsync(id), context,
+                      [handler](const std::optional<BluetoothLEDevice> &leDevice) {
+            if (leDevice && *leDevice) {
+                handler(BluetoothInfo{ QBluetoothAddress(leDevice->BluetoothAddress()),
+                                       leDevice->ConnectionStatus()
+                                               == BluetoothConnectionStatus::Connected });
+            } else {
+                handler(BluetoothInfo{});
+            }
+        });
+    });
 }
 
 void AdapterManager::onDeviceAdded(winrt::hstring id)
 {
-    const BluetoothInfo &info = getBluetoothInfo(id);
-    // In practice this callback might come even for disconnected device.
-    // So check status explicitly.
-    if (!info.address.isNull() && info.isConnected) {
-        bool found = false;
-        {
-            // A scope is needed, because we need to emit a signal when mutex is already unlocked
-            QMutexLocker locker(&mMutex);
-            found = mConnectedDevices.contains(info.address);
-            if (!found) {
-                mConnectedDevices.push_back(info.address);
+    getBluetoothInfo(id, this, [this](const BluetoothInfo &info) {
+        // In practice this callback might come even for disconnected device.
+        // So check status explicitly.
+        if (!info.address.isNull() && info.isConnected) {
+            bool found = false;
+            {
+                // A scope is needed, because we need to emit a signal when mutex is already unlocked
+                QMutexLocker locker(&mMutex);
+                found = mConnectedDevices.contains(info.address);
+                if (!found) {
+                    mConnectedDevices.push_back(info.address);
+                }
             }
+            if (!found)
+                emit deviceAdded(info.address);
         }
-        if (!found)
-            emit deviceAdded(info.address);
-    }
+    });
 }
 
 void AdapterManager::onDeviceRemoved(winrt::hstring id)
 {
-    const BluetoothInfo &info = getBluetoothInfo(id);
-    if (!info.address.isNull() && !info.isConnected) {
-        bool found = false;
-        {
-            QMutexLocker locker(&mMutex);
-            found = mConnectedDevices.removeOne(info.address);
+    getBluetoothInfo(id, this, [this](const BluetoothInfo &info) {
+        if (!info.address.isNull() && !info.isConnected) {
+            bool found = false;
+            {
+                QMutexLocker locker(&mMutex);
+                found = mConnectedDevices.removeOne(info.address);
+            }
+            if (found)
+                emit deviceRemoved(info.address);
         }
-        if (found)
-            emit deviceRemoved(info.address);
-    }
+    });
 }
 
 void AdapterManager::onAdapterAdded(winrt::hstring id)
@@ -512,6 +530,30 @@ DeviceInformationPairing pairingInfoFromAddress(const QBluetoothAddress &address
     return nullptr;
 }
 
+// The asynchronous variant of pairingInfoFromAddress(), handler receives a null
+// object if neither a classic nor an LE device has the address.
+template <typename Handler>
+static void requestPairingInfo(const QBluetoothAddress &address, QObject *context,
+                               Handler handler)
+{
+    const quint64 addr64 = address.toUInt64();
+    whenCompleted(BluetoothDevice::FromBluetoothAddressAsync(addr64), context,
+                  [addr64, context, handler](const std::optional<BluetoothDevice> &device) {
+        if (device && *device) {
+            handler(device->DeviceInformation().Pairing());
+            return;
+        }
+
+        whenCompleted(BluetoothLEDevice::FromBluetoothAddressAsync(addr64), context,
+                      [handler](const std::optional<BluetoothLEDevice> &leDevice) {
+            if (leDevice && *leDevice)
+                handler(leDevice->DeviceInformation().Pairing());
+            else
+                handler(DeviceInformationPairing(nullptr));
+        });
+    });
+}
+
 struct PairingWorker
         : public winrt::implements<PairingWorker, winrt::Windows::Foundation::IInspectable>
 {
@@ -521,6 +563,9 @@ struct PairingWorker
     void pairAsync(const QBluetoothAddress &addr, QBluetoothLocalDevice::Pairing pairing);
 
 private:
+    void pair(const QBluetoothAddress &addr, const DeviceInformationPairing &pairingInfo);
+    void unpair(const QBluetoothAddress &addr, const DeviceInformationPairing &pairingInfo);
+
     QPointer<QBluetoothLocalDevice> q;
     void onPairingRequested(DeviceInformationCustomPairing const&,
                             DevicePairingRequestedEventArgs args);
@@ -528,50 +573,59 @@ private:
 
 void PairingWorker::pairAsync(const QBluetoothAddress &addr, QBluetoothLocalDevice::Pairing pairing)
 {
-    // Note: some of the functions called here use await() in their implementation.
-    // Hence we need to verify that the 'q' is still valid after such calls, as
-    // it may have been destroyed. In that scenario the ComPtr pointing to this
-    // object is destroyed, but to protect this function's possible execution at that time,
-    // the get_strong() call below will ensure we can execute until the end.
+    // The handlers below are only called while 'q' exists. Each of them holds
+    // a strong reference, so that this object lives until the operations have
+    // finished, even if the ComPtr in 'q' is gone meanwhile.
     auto ref = get_strong();
-    DeviceInformationPairing pairingInfo = pairingInfoFromAddress(addr);
-    switch (pairing) {
-    case QBluetoothLocalDevice::Paired:
-    case QBluetoothLocalDevice::AuthorizedPaired:
-    {
-        DeviceInformationCustomPairing customPairing = pairingInfo.Custom();
-        auto token = customPairing.PairingRequested(
-                    { get_weak(), &PairingWorker::onPairingRequested });
-        DevicePairingResult result{nullptr};
-        bool res = await(customPairing.PairAsync(DevicePairingKinds::ConfirmOnly), result, 30000);
+    requestPairingInfo(addr, q.data(),
+                       [ref, addr, pairing](const DeviceInformationPairing &pairingInfo) {
+        if (!pairingInfo) {
+            emit ref->q->errorOccurred(QBluetoothLocalDevice::PairingError);
+            return;
+        }
+        if (pairing == QBluetoothLocalDevice::Unpaired)
+            ref->unpair(addr, pairingInfo);
+        else
+            ref->pair(addr, pairingInfo);
+    });
+}
+
+void PairingWorker::pair(const QBluetoothAddress &addr,
+                         const DeviceInformationPairing &pairingInfo)
+{
+    auto ref = get_strong();
+    DeviceInformationCustomPairing customPairing = pairingInfo.Custom();
+    const auto token = customPairing.PairingRequested(
+                { get_weak(), &PairingWorker::onPairingRequested });
+    whenCompleted(customPairing.PairAsync(DevicePairingKinds::ConfirmOnly), q.data(),
+                  [ref, addr, customPairing, token](
+                          const std::optional<DevicePairingResult> &result) {
         customPairing.PairingRequested(token);
-        if (!res || result.Status() != DevicePairingResultStatus::Paired) {
-            if (q)
-                emit q->errorOccurred(QBluetoothLocalDevice::PairingError);
+        if (!result || !*result || result->Status() != DevicePairingResultStatus::Paired) {
+            emit ref->q->errorOccurred(QBluetoothLocalDevice::PairingError);
             return;
         }
 
         // Check the actual protection level used and signal the success
-        if (q) {
-            const auto resultingPairingStatus = q->pairingStatus(addr);
-            // pairingStatus() uses await/spins eventloop => check 'q' validity again
-            if (q)
-                emit q->pairingFinished(addr, resultingPairingStatus);
-        }
-        return;
-    }
-    case QBluetoothLocalDevice::Unpaired:
-        DeviceUnpairingResult unpairingResult{nullptr};
-        bool res = await(pairingInfo.UnpairAsync(), unpairingResult, 10000);
-        if (!res || unpairingResult.Status() != DeviceUnpairingResultStatus::Unpaired) {
-            if (q)
-                emit q->errorOccurred(QBluetoothLocalDevice::PairingError);
+        const auto resultingPairingStatus = ref->q->pairingStatus(addr);
+        // pairingStatus() waits in an event loop => check 'q' validity again
+        if (ref->q)
+            emit ref->q->pairingFinished(addr, resultingPairingStatus);
+    });
+}
+
+void PairingWorker::unpair(const QBluetoothAddress &addr,
+                           const DeviceInformationPairing &pairingInfo)
+{
+    auto ref = get_strong();
+    whenCompleted(pairingInfo.UnpairAsync(), q.data(),
+                  [ref, addr](const std::optional<DeviceUnpairingResult> &result) {
+        if (!result || !*result || result->Status() != DeviceUnpairingResultStatus::Unpaired) {
+            emit ref->q->errorOccurred(QBluetoothLocalDevice::PairingError);
             return;
         }
-        if (q)
-            emit q->pairingFinished(addr, QBluetoothLocalDevice::Unpaired);
-        return;
-    }
+        emit ref->q->pairingFinished(addr, QBluetoothLocalDevice::Unpaired);
+    });
 }
 
 void PairingWorker::onPairingRequested(const DeviceInformationCustomPairing &,
@@ -670,15 +724,16 @@ void QBluetoothLocalDevicePrivate::updateAdapterState(QBluetoothLocalDevice::Hos
         // SetStateAsync. This is because in some regions, with some user
         // settings choices, attempting to change radio state requires user
         // permission.
-        RadioAccessStatus status = RadioAccessStatus::Unspecified;
-        bool res = await(Radio::RequestAccessAsync(), status);
-        if (res && status == RadioAccessStatus::Allowed) {
-            // Now send a signal to the AdapterWatcher. That class will manage
-            // the actual state change.
-            emit updateMode(mDeviceId, desiredMode);
-        } else {
-            qCWarning(QT_BT_WINDOWS, "Failed to update adapter state: operation denied!");
-        }
+        whenCompleted(Radio::RequestAccessAsync(), this,
+                      [this, desiredMode](const std::optional<RadioAccessStatus> &status) {
+            if (status == RadioAccessStatus::Allowed) {
+                // Now send a signal to the AdapterWatcher. That class will manage
+                // the actual state change.
+                emit updateMode(mDeviceId, desiredMode);
+            } else {
+                qCWarning(QT_BT_WINDOWS, "Failed to update adapter state: operation denied!");
+            }
+        });
     }
 }
 
@@ -0,0 +1,179 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qbluetoothmemoryusage_p.h"
+#include "qbluetoothdeviceinfo_p.h"
+
+#include <QtCore/QDebug>
+
+QT_BEGIN_NAMESPACE
+
+QT_IMPL_METATYPE_EXTERN(QBluetoothMemoryUsage)
+
+/*!
+    \since 6.5
+    \class QBluetoothMemoryUsage
+    \brief The QBluetoothMemoryUsage class reports the approximate memory held
+           by the internal structures of a Qt Bluetooth object.
+
+    An object of this class is a snapshot listing the major structures of a
+    \l QBluetoothDeviceDiscoveryAgent, \l QLowEnergyController or
+    \l QBluetoothSocket, each with the number of bytes it currently holds on the
+    heap. It helps to find out which structure is responsible when the memory
+    footprint of a long running application grows.
+
+    The numbers are estimates computed from the sizes and capacities of the
+    containers involved. They neither include the allocator's overhead nor memory
+    held by the platform's Bluetooth stack. Data which is implicitly shared
+    between several structures, such as a characteristic value held by both the
+    GATT database and a pending request, is counted for each of them.
+
+    The names of the structures are meant for diagnostics and may change between
+    Qt versions. Enabling the \c qt.bluetooth.memory logging category prints the
+    memory usage of the objects at points where it is most meaningful, for example
+    when a device discovery has finished.
+
+    \inmodule QtBluetooth
+    \ingroup shared
+
+    \sa QBluetoothDeviceDiscoveryAgent::memoryUsage(), QLowEnergyController::memoryUsage(),
+        QBluetoothSocket::memoryUsage()
+*/
+
+/*!
+   Constructs a new, empty object of this class.
+ */
+QBluetoothMemoryUsage::QBluetoothMemoryUsage()
+    : d(new QBluetoothMemoryUsagePrivate)
+{
+}
+
+/*! Constructs a new object of this class that is a copy of \a other. */
+QBluetoothMemoryUsage::QBluetoothMemoryUsage(const QBluetoothMemoryUsage &other)
+    : d(other.d)
+{
+}
+
+/*! Destroys this object. */
+QBluetoothMemoryUsage::~QBluetoothMemoryUsage()
+{
+}
+
+/*! Makes this object a copy of \a other and returns the new value of this object. */
+QBluetoothMemoryUsage &QBluetoothMemoryUsage::operator=(const QBluetoothMemoryUsage &other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+   Returns \c true if no structure is reported, otherwise returns \c false.
+ */
+bool QBluetoothMemoryUsage::isEmpty() const
+{
+    return d->entries.isEmpty();
+}
+
+/*!
+   Returns the names of the reported structures.
+   \sa bytes()
+ */
+QStringList QBluetoothMemoryUsage::structures() const
+{
+    QStringList result;
+    result.reserve(d->entries.size());
+    for (const auto &entry : std::as_const(d->entries))
+        result.append(entry.first);
+    return result;
+}
+
+/*!
+   Returns the approximate number of bytes held by \a structure, or \c 0 if
+   the structure is not reported.
+   \sa structures(), totalBytes()
+ */
+qsizetype QBluetoothMemoryUsage::bytes(const QString &structure) const
+{
+    for (const auto &entry : std::as_const(d->entries)) {
+        if (entry.first == structure)
+            return entry.second;
+    }
+    return 0;
+}
+
+/*!
+   Returns the sum of the bytes held by all reported structures.
+   \sa bytes()
+ */
+qsizetype QBluetoothMemoryUsage::totalBytes() const
+{
+    qsizetype result = 0;
+    for (const auto &entry : std::as_const(d->entries))
+        result += entry.second;
+    return result;
+}
+
+/*!
+   \fn void QBluetoothMemoryUsage::swap(QBluetoothMemoryUsage &other)
+   Swaps this object with \a other.
+ */
+
+#ifndef QT_NO_DEBUG_STREAM
+QDebug QBluetoothMemoryUsage::streamingOperator(QDebug debug, const QBluetoothMemoryUsage &usage)
+{
+    QDebugStateSaver saver(debug);
+    debug.nospace() << "QBluetoothMemoryUsage(total " << usage.totalBytes();
+    for (const auto &entry : std::as_const(usage.d->entries))
+        debug << ", " << qUtf8Printable(entry.first) << ' ' << entry.second;
+    debug << ')';
+    return debug;
+}
+#endif
+
+void QBluetoothMemoryUsagePrivate::add(QBluetoothMemoryUsage *usage, const QString &structure,
+                                       qsizetype bytes)
+{
+    Q_ASSERT(usage);
+    auto &entries = usage->d->entries;
+    for (auto &entry : entries) {
+        if (entry.first == structure) {
+            entry.second += bytes;
+            return;
+        }
+    }
+    entries.append(std::make_pair(structure, bytes));
+}
+
+/*
+ * Estimated from the public API, which returns the stored values without
+ * copying them. The inline storage of the private is part of its size.
+ */
+qsizetype QBluetoothMemory::bytes(const QBluetoothDeviceInfo &info)
+{
+    qsizetype result = qsizetype(sizeof(QBluetoothDeviceInfoPrivate)) + bytes(info.name());
+
+    const QList<QBluetoothUuid> serviceUuids = info.serviceUuids();
+    for (const QBluetoothUuid &uuid : serviceUuids) {
+        // only UUIDs outside of the Bluetooth base UUID enforce the full list
+        bool ok = false;
+        uuid.toUInt16(&ok);
+        if (!ok) {
+            result += bytes(serviceUuids);
+            break;
+        }
+    }
+
+    const QList<quint16> manufacturerIds = info.manufacturerIds();
+    for (quint16 id : manufacturerIds) {
+        result += qsizetype(sizeof(std::pair<quint16, QByteArray>))
+                + bytes(info.manufacturerData(id));
+    }
+    const QList<QBluetoothUuid> serviceIds = info.serviceIds();
+    for (const QBluetoothUuid &uuid : serviceIds) {
+        result += qsizetype(sizeof(std::pair<QBluetoothUuid, QByteArray>))
+                + bytes(info.serviceData(uuid));
+    }
+    return result;
+}
+
+QT_END_NAMESPACE
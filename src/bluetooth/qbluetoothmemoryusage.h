@@ -0,0 +1,52 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QBLUETOOTHMEMORYUSAGE_H
+#define QBLUETOOTHMEMORYUSAGE_H
+
+#include <QtBluetooth/qtbluetoothglobal.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qshareddata.h>
+#include <QtCore/qstringlist.h>
+
+QT_BEGIN_NAMESPACE
+
+class QBluetoothMemoryUsagePrivate;
+
+class Q_BLUETOOTH_EXPORT QBluetoothMemoryUsage
+{
+public:
+    QBluetoothMemoryUsage();
+    QBluetoothMemoryUsage(const QBluetoothMemoryUsage &other);
+    ~QBluetoothMemoryUsage();
+
+    QBluetoothMemoryUsage &operator=(const QBluetoothMemoryUsage &other);
+
+    bool isEmpty() const;
+
+    QStringList structures() const;
+    qsizetype bytes(const QString &structure) const;
+    qsizetype totalBytes() const;
+
+    void swap(QBluetoothMemoryUsage &other) noexcept { d.swap(other.d); }
+
+private:
+    friend class QBluetoothMemoryUsagePrivate;
+    QSharedDataPointer<QBluetoothMemoryUsagePrivate> d;
+
+#ifndef QT_NO_DEBUG_STREAM
+    friend QDebug operator<<(QDebug debug, const QBluetoothMemoryUsage &usage)
+    {
+        return streamingOperator(debug, usage);
+    }
+    static QDebug streamingOperator(QDebug debug, const QBluetoothMemoryUsage &usage);
+#endif
+};
+
+Q_DECLARE_SHARED(QBluetoothMemoryUsage)
+
+QT_END_NAMESPACE
+
+QT_DECL_METATYPE_EXTERN(QBluetoothMemoryUsage, Q_BLUETOOTH_EXPORT)
+
+#endif // Include guard
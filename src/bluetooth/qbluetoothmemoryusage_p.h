@@ -0,0 +1,106 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QBLUETOOTHMEMORYUSAGE_P_H
+#define QBLUETOOTHMEMORYUSAGE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qbluetoothmemoryusage.h"
+
+#include <QtCore/private/qglobal_p.h>
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QString>
+
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+class QBluetoothDeviceInfo;
+
+class Q_AUTOTEST_EXPORT QBluetoothMemoryUsagePrivate : public QSharedData
+{
+public:
+    // adds bytes to the entry of structure, entries keep the order they were first added in
+    static void add(QBluetoothMemoryUsage *usage, const QString &structure, qsizetype bytes);
+
+    QList<std::pair<QString, qsizetype>> entries;
+};
+
+/*
+ * Approximate heap sizes of the containers the Bluetooth classes keep. The
+ * allocator's overhead is not included, and implicitly shared data is counted
+ * for every one of its owners.
+ */
+namespace QBluetoothMemory {
+
+inline qsizetype bytes(const QByteArray &data)
+{
+    return data.capacity();
+}
+
+inline qsizetype bytes(const QString &string)
+{
+    return string.capacity() * qsizetype(sizeof(QChar));
+}
+
+template <typename T>
+qsizetype bytes(const QList<T> &list)
+{
+    return list.capacity() * qsizetype(sizeof(T));
+}
+
+// one offset byte per bucket plus the entries stored in the spans
+template <typename Key, typename T>
+qsizetype bytes(const QHash<Key, T> &hash)
+{
+    return qsizetype(hash.capacity()) + hash.size() * qsizetype(sizeof(Key) + sizeof(T));
+}
+
+// a red-black tree node holds three pointers and its color
+template <typename Key, typename T>
+qsizetype bytes(const QMap<Key, T> &map)
+{
+    return map.size() * qsizetype(sizeof(Key) + sizeof(T) + 4 * sizeof(void *));
+}
+
+template <typename Key, typename T>
+qsizetype bytes(const QMultiMap<Key, T> &map)
+{
+    return map.size() * qsizetype(sizeof(Key) + sizeof(T) + 4 * sizeof(void *));
+}
+
+// the container's own storage plus what f returns for every element
+template <typename Container, typename Function>
+qsizetype bytes(const Container &container, Function f)
+{
+    qsizetype result = bytes(container);
+    for (const auto &element : container)
+        result += f(element);
+    return result;
+}
+
+inline qsizetype bytes(const QList<QByteArray> &list)
+{
+    return bytes(list, [](const QByteArray &data) { return bytes(data); });
+}
+
+qsizetype bytes(const QBluetoothDeviceInfo &info);
+
+} // namespace QBluetoothMemory
+
+QT_END_NAMESPACE
+
+#endif // QBLUETOOTHMEMORYUSAGE_P_H
@@ -104,6 +104,18 @@ QT_BEGIN_NAMESPACE
     Sets the maximum number of pending connections to \a numConnections. If
     the number of pending sockets exceeds this limit new sockets will be rejected.
 
+    On Linux, \a numConnections is also used as the listen backlog of the
+    server socket and can be changed while the server is listening. All
+    connections which arrive together are accepted at once, until
+    \a numConnections connections wait for nextPendingConnection().
+
+    On Android, connections keep being accepted while \a numConnections
+    connections are pending. Up to four more connections wait in a backlog and
+    are announced by newConnection() as soon as pending connections are taken.
+    The size of the backlog can be changed with the
+    \c QT_BLUETOOTH_SERVER_BACKLOG environment variable, \c 0 rejects every
+    connection beyond \a numConnections.
+
     \sa maxPendingConnections()
 */
 
@@ -226,6 +238,57 @@ QBluetoothServiceInfo QBluetoothServer::listen(const QBluetoothUuid &uuid, const
     return serviceInfo;
 }
 
+/*!
+    Start listening for incoming LE credit based L2CAP channels, also known as
+    L2CAP connection-oriented channels, to \a address on \a psm.
+
+    \a address must be a local Bluetooth adapter address. If \a psm is \c 0, the
+    system chooses a free dynamic PSM which can be queried with serverPort().
+    \a receiveMtu is the largest packet accepted on the channels, \c 0 keeps the
+    system default. The flow control credits are managed by the operating system.
+
+    The server must have been created for the
+    \l {QBluetoothServiceInfo::L2capProtocol}{L2CAP} protocol. Returns \c true if
+    the server is listening for incoming channels, otherwise returns \c false.
+
+    \note Currently this is only supported on Linux with BlueZ. On other
+    platforms this function emits an \l UnsupportedProtocolError and returns
+    \c false.
+
+    \sa QBluetoothSocket::connectToLowEnergyChannel(), listen(), close()
+    \since 6.5
+*/
+bool QBluetoothServer::listenForLowEnergyChannel(const QBluetoothAddress &address, quint16 psm,
+                                                 quint16 receiveMtu)
+{
+    Q_D(QBluetoothServer);
+
+#if QT_CONFIG(bluez)
+    // already listening, close() must be called first
+    if (isListening())
+        return false;
+
+    if (d->serverType == QBluetoothServiceInfo::L2capProtocol) {
+        d->lowEnergyChannel = true;
+        d->lowEnergyReceiveMtu = receiveMtu;
+        if (listen(address, psm))
+            return true;
+
+        d->lowEnergyChannel = false;
+        d->lowEnergyReceiveMtu = 0;
+        return false;
+    }
+#else
+    Q_UNUSED(address);
+    Q_UNUSED(psm);
+    Q_UNUSED(receiveMtu);
+#endif
+
+    d->m_lastError = UnsupportedProtocolError;
+    emit errorOccurred(d->m_lastError);
+    return false;
+}
+
 /*!
     Returns true if the server is listening for incoming connections, otherwise false.
 */
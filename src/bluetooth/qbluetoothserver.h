@@ -43,6 +43,8 @@ public:
     bool listen(const QBluetoothAddress &address = QBluetoothAddress(), quint16 port = 0);
     [[nodiscard]] QBluetoothServiceInfo listen(const QBluetoothUuid &uuid,
                                                const QString &serviceName = QString());
+    bool listenForLowEnergyChannel(const QBluetoothAddress &address = QBluetoothAddress(),
+                                   quint16 psm = 0, quint16 receiveMtu = 0);
     bool isListening() const;
 
     void setMaxPendingConnections(int numConnections);
@@ -11,7 +11,10 @@
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QSocketNotifier>
 
+#include <qplatformdefs.h>
+
 #include <errno.h>
+#include <sys/socket.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -45,16 +48,47 @@ QBluetoothServerPrivate::QBluetoothServerPrivate(QBluetoothServiceInfo::Protocol
 QBluetoothServerPrivate::~QBluetoothServerPrivate()
 {
     delete socketNotifier;
+    closePendingConnections();
 
     delete socket;
 }
 
+/*
+ * Accepts every connection the kernel has queued, so that a burst of
+ * reconnecting devices is taken in one activation rather than one per event
+ * loop iteration. Only a full queue of accepted connections leaves the rest in
+ * the listen backlog, until the application took them via nextPendingConnection().
+ */
 void QBluetoothServerPrivate::_q_newConnection()
 {
+    qsizetype accepted = 0;
+    while (pendingSocketDescriptors.size() < qMax(maxPendingConnections, 1)) {
+        const int pending = ::accept4(socket->socketDescriptor(), nullptr, nullptr,
+                                      SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (pending < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                qCWarning(QT_BT_BLUEZ) << "Cannot accept connection" << qt_error_string(errno);
+            break;
+        }
+        pendingSocketDescriptors.append(pending);
+        ++accepted;
+    }
+
     // disable socket notifier until application calls nextPendingConnection().
-    socketNotifier->setEnabled(false);
+    if (pendingSocketDescriptors.size() >= qMax(maxPendingConnections, 1))
+        socketNotifier->setEnabled(false);
 
-    emit q_ptr->newConnection();
+    for (qsizetype i = 0; i < accepted; ++i)
+        emit q_ptr->newConnection();
+}
+
+void QBluetoothServerPrivate::closePendingConnections()
+{
+    for (int descriptor : std::as_const(pendingSocketDescriptors))
+        QT_CLOSE(descriptor);
+    pendingSocketDescriptors.clear();
 }
 
 void QBluetoothServerPrivate::setSocketSecurityLevel(
@@ -114,8 +148,12 @@ void QBluetoothServer::close()
 
     delete d->socketNotifier;
     d->socketNotifier = nullptr;
+    d->closePendingConnections();
 
     d->socket->close();
+
+    d->lowEnergyChannel = false;
+    d->lowEnergyReceiveMtu = 0;
 }
 
 bool QBluetoothServer::listen(const QBluetoothAddress &address, quint16 port)
@@ -191,7 +229,13 @@ bool QBluetoothServer::listen(const QBluetoothAddress &address, quint16 port)
 
         memset(&addr, 0, sizeof(sockaddr_l2));
         addr.l2_family = AF_BLUETOOTH;
-        addr.l2_psm = port;
+        if (d->lowEnergyChannel) {
+            // an LE address type makes the kernel accept LE credit based channels
+            addr.l2_psm = htobs(port);
+            addr.l2_bdaddr_type = BDADDR_LE_PUBLIC;
+        } else {
+            addr.l2_psm = port;
+        }
 
         if (!address.isNull())
             convertAddress(address.toUInt64(), addr.l2_bdaddr.b);
@@ -203,6 +247,14 @@ bool QBluetoothServer::listen(const QBluetoothAddress &address, quint16 port)
             emit errorOccurred(d->m_lastError);
             return false;
         }
+
+        // accepted channels inherit the receive MTU of the listening socket
+        if (d->lowEnergyChannel && d->lowEnergyReceiveMtu
+                && ::setsockopt(sock, SOL_BLUETOOTH, BT_RCVMTU, &d->lowEnergyReceiveMtu,
+                                sizeof(d->lowEnergyReceiveMtu)) < 0) {
+            qCWarning(QT_BT_BLUEZ) << "Cannot set receive MTU" << d->lowEnergyReceiveMtu
+                                   << qt_error_string(errno);
+        }
     }
 
     d->setSocketSecurityLevel(d->securityFlags, nullptr);
@@ -231,19 +283,30 @@ void QBluetoothServer::setMaxPendingConnections(int numConnections)
 {
     Q_D(QBluetoothServer);
 
-    if (d->socket->state() == QBluetoothSocket::SocketState::UnconnectedState)
+    if (d->socket->state() == QBluetoothSocket::SocketState::UnconnectedState) {
+        d->maxPendingConnections = numConnections;
+    } else if (d->socket->state() == QBluetoothSocket::SocketState::ListeningState) {
+        // listening again only resizes the backlog of the listening socket
+        if (::listen(d->socket->socketDescriptor(), numConnections) < 0) {
+            qCWarning(QT_BT_BLUEZ) << "Cannot change the listen backlog" << qt_error_string(errno);
+            return;
+        }
         d->maxPendingConnections = numConnections;
+        if (d->socketNotifier
+                && d->pendingSocketDescriptors.size() < qMax(numConnections, 1)) {
+            d->socketNotifier->setEnabled(true);
+        }
+    }
 }
 
 bool QBluetoothServer::hasPendingConnections() const
 {
     Q_D(const QBluetoothServer);
 
-    if (!d || !d->socketNotifier)
+    if (!d)
         return false;
 
-    // if the socket notifier is disabled there is a pending connection waiting for us to accept.
-    return !d->socketNotifier->isEnabled();
+    return !d->pendingSocketDescriptors.isEmpty();
 }
 
 QBluetoothSocket *QBluetoothServer::nextPendingConnection()
@@ -253,34 +316,19 @@ QBluetoothSocket *QBluetoothServer::nextPendingConnection()
     if (!hasPendingConnections())
         return nullptr;
 
-    int pending;
-    if (d->serverType == QBluetoothServiceInfo::RfcommProtocol) {
-        sockaddr_rc addr;
-        socklen_t length = sizeof(sockaddr_rc);
-        pending = ::accept(d->socket->socketDescriptor(),
-                               reinterpret_cast<sockaddr *>(&addr), &length);
-    } else {
-        sockaddr_l2 addr;
-        socklen_t length = sizeof(sockaddr_l2);
-        pending = ::accept(d->socket->socketDescriptor(),
-                               reinterpret_cast<sockaddr *>(&addr), &length);
-    }
-
-    if (pending >= 0) {
-        QBluetoothSocket *newSocket = QBluetoothServerPrivate::createSocketForServer();
-        if (d->serverType == QBluetoothServiceInfo::RfcommProtocol)
-            newSocket->setSocketDescriptor(pending, QBluetoothServiceInfo::RfcommProtocol);
-        else
-            newSocket->setSocketDescriptor(pending, QBluetoothServiceInfo::L2capProtocol);
-
+    const int pending = d->pendingSocketDescriptors.takeFirst();
+    if (d->socketNotifier)
         d->socketNotifier->setEnabled(true);
 
-        return newSocket;
-    } else {
-        d->socketNotifier->setEnabled(true);
-    }
+    // the descriptor replaces the native socket, don't let the new socket create one first
+    QBluetoothSocket *newSocket =
+            QBluetoothServerPrivate::createSocketForServer(QBluetoothServiceInfo::UnknownProtocol);
+    if (d->serverType == QBluetoothServiceInfo::RfcommProtocol)
+        newSocket->setSocketDescriptor(pending, QBluetoothServiceInfo::RfcommProtocol);
+    else
+        newSocket->setSocketDescriptor(pending, QBluetoothServiceInfo::L2capProtocol);
 
-    return nullptr;
+    return newSocket;
 }
 
 QBluetoothAddress QBluetoothServer::serverAddress() const
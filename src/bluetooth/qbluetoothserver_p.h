@@ -73,6 +73,7 @@ public:
     QBluetooth::SecurityFlags socketSecurityLevel() const;
     static QBluetoothSocket *createSocketForServer(
                 QBluetoothServiceInfo::Protocol socketType = QBluetoothServiceInfo::RfcommProtocol);
+    void closePendingConnections();
 #endif
 
 public:
@@ -89,6 +90,11 @@ private:
     QBluetoothServer::Error m_lastError = QBluetoothServer::NoError;
 #if QT_CONFIG(bluez)
     QSocketNotifier *socketNotifier = nullptr;
+    // accepted, but not yet taken by nextPendingConnection()
+    QList<int> pendingSocketDescriptors;
+    // set by listenForLowEnergyChannel() until close()
+    bool lowEnergyChannel = false;
+    quint16 lowEnergyReceiveMtu = 0;
 #elif defined(QT_ANDROID_BLUETOOTH)
     ServerAcceptanceThread *thread;
     QString m_serviceName;
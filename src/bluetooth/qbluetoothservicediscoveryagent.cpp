@@ -8,8 +8,54 @@
 
 #include "qbluetoothdevicediscoveryagent.h"
 
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qset.h>
+
+#include <algorithm>
+
 QT_BEGIN_NAMESPACE
 
+Q_DECLARE_LOGGING_CATEGORY(QT_BT)
+
+namespace {
+
+struct CachedServices
+{
+    QSet<QBluetoothUuid> uuidFilter;
+    QList<QBluetoothServiceInfo> services;
+    QElapsedTimer age;
+};
+
+// The results of full service discoveries, shared by all agents of the process.
+struct ServiceCache
+{
+    QMutex mutex;
+    QHash<quint64, CachedServices> entries;
+};
+
+}
+
+Q_GLOBAL_STATIC(ServiceCache, serviceCache)
+
+// beyond that many devices the oldest entry is dropped
+static constexpr qsizetype maxCachedDevices = 256;
+
+static bool matchesUuidFilter(const QBluetoothServiceInfo &serviceInfo,
+                              const QList<QBluetoothUuid> &uuidFilter)
+{
+    if (uuidFilter.isEmpty() || uuidFilter.contains(serviceInfo.serviceUuid()))
+        return true;
+
+    const QList<QBluetoothUuid> serviceClassUuids = serviceInfo.serviceClassUuids();
+    return std::any_of(serviceClassUuids.cbegin(), serviceClassUuids.cend(),
+                       [&uuidFilter](const QBluetoothUuid &uuid) {
+                           return uuidFilter.contains(uuid);
+                       });
+}
+
 /*!
     \class QBluetoothServiceDiscoveryAgent
     \inmodule QtBluetooth
@@ -41,6 +87,10 @@ QT_BEGIN_NAMESPACE
     will perform additional discovery if required.  If the full service information is required,
     pass \l FullDiscovery as the discoveryMode parameter to start().
 
+    The services found by a full discovery are kept in a cache shared by all
+    agents of the process. \l setCacheTimeout() lets an agent reuse them
+    instead of querying a device again that was queried shortly before.
+
     This class may internally utilize \l QBluetoothDeviceDiscoveryAgent to find unknown devices.
 
     The service discovery may find Bluetooth Low Energy services too if the target device
@@ -49,6 +99,10 @@ QT_BEGIN_NAMESPACE
     Energy services, it is likely to not advertise them via SDP. The \l QLowEnergyController class
     should be utilized to perform the service discovery on Low Energy devices.
 
+    On Linux, a full discovery queries the SDP server of the remote device directly.
+    If the \c QT_BLUETOOTH_USE_SDPSCANNER environment variable is set to \c 1,
+    every device is queried by the \c sdpscanner helper executable instead.
+
     On iOS, this class cannot be used because the platform does not expose
     an API which may permit access to QBluetoothServiceDiscoveryAgent related features.
 
@@ -278,6 +332,114 @@ QBluetoothAddress QBluetoothServiceDiscoveryAgent::remoteAddress() const
         return QBluetoothAddress();
 }
 
+/*!
+    Lets \l start() take the services of a device from the process-wide
+    service cache if a \l FullDiscovery of that device, by this or any other
+    agent, found them less than \a msTimeout milliseconds ago. The device is
+    not contacted in that case. A value of \c 0, the default, always queries
+    the devices.
+
+    Every full discovery stores the services it finds in the cache,
+    independently of this setting. A cache entry is only used by a search
+    with the same \l uuidFilter() as the one that stored it. Devices on which
+    no service was found are not cached. A \l MinimalDiscovery does not use
+    the cache, it relies on the cache of the platform already.
+
+    Cached services may be outdated, for example if the remote device moved a
+    service to another server channel. Call \l invalidateCache() for a device
+    once connecting to one of its cached services fails.
+
+    \sa cacheTimeout(), invalidateCache()
+    \since 6.5
+ */
+void QBluetoothServiceDiscoveryAgent::setCacheTimeout(int msTimeout)
+{
+    Q_D(QBluetoothServiceDiscoveryAgent);
+    if (msTimeout < 0) {
+        qCDebug(QT_BT) << "The service cache timeout cannot be negative.";
+        return;
+    }
+    d->cacheTimeout = msTimeout;
+}
+
+/*!
+    Returns the maximum age in milliseconds of cached services that
+    \l start() uses instead of querying a device.
+
+    \sa setCacheTimeout()
+    \since 6.5
+ */
+int QBluetoothServiceDiscoveryAgent::cacheTimeout() const
+{
+    Q_D(const QBluetoothServiceDiscoveryAgent);
+    return d->cacheTimeout;
+}
+
+/*!
+    Lets a search without \l remoteAddress() query up to \a count devices at
+    the same time during a \l FullDiscovery. The results of every device are
+    reported as soon as it has been queried. A value of \c 1, the default,
+    queries the devices one after the other.
+
+    Most of the time of a full discovery is spent waiting for devices which
+    are no longer in range. Querying several devices at once shortens that,
+    as long as the local adapter manages to page several devices at a time.
+
+    \note Currently only BlueZ queries devices in parallel; other platforms
+    ignore this setting. On BlueZ it has no effect if the \c sdpscanner helper
+    is used, see \c QT_BLUETOOTH_USE_SDPSCANNER.
+
+    \sa maximumParallelDiscoveries()
+    \since 6.5
+ */
+void QBluetoothServiceDiscoveryAgent::setMaximumParallelDiscoveries(int count)
+{
+    Q_D(QBluetoothServiceDiscoveryAgent);
+    if (count < 1) {
+        qCDebug(QT_BT) << "At least one device must be queried at a time.";
+        return;
+    }
+    d->maximumParallelDiscoveries = count;
+}
+
+/*!
+    Returns the number of devices a full discovery queries at the same time.
+
+    \sa setMaximumParallelDiscoveries()
+    \since 6.5
+ */
+int QBluetoothServiceDiscoveryAgent::maximumParallelDiscoveries() const
+{
+    Q_D(const QBluetoothServiceDiscoveryAgent);
+    return d->maximumParallelDiscoveries;
+}
+
+/*!
+    Removes the services of all devices from the process-wide service cache.
+
+    \sa setCacheTimeout()
+    \since 6.5
+ */
+void QBluetoothServiceDiscoveryAgent::invalidateCache()
+{
+    QMutexLocker locker(&serviceCache->mutex);
+    serviceCache->entries.clear();
+}
+
+/*!
+    \overload
+
+    Removes the services of the device with \a address from the process-wide
+    service cache.
+
+    \since 6.5
+ */
+void QBluetoothServiceDiscoveryAgent::invalidateCache(const QBluetoothAddress &address)
+{
+    QMutexLocker locker(&serviceCache->mutex);
+    serviceCache->entries.remove(address.toUInt64());
+}
+
 namespace DarwinBluetooth {
 
 void qt_test_iobluetooth_runloop();
@@ -523,6 +685,14 @@ void QBluetoothServiceDiscoveryAgentPrivate::startServiceDiscovery()
     }
 
     setDiscoveryState(ServiceDiscovery);
+    if (reportCachedServices(discoveredDevices.at(0))) {
+        currentDeviceFromCache = true;
+        // the application may have stopped the discovery meanwhile
+        if (discoveryState() != Inactive)
+            _q_serviceDiscoveryFinished();
+        return;
+    }
+
     start(discoveredDevices.at(0).address());
 }
 
@@ -539,12 +709,104 @@ void QBluetoothServiceDiscoveryAgentPrivate::stopServiceDiscovery()
 void QBluetoothServiceDiscoveryAgentPrivate::_q_serviceDiscoveryFinished()
 {
     if(!discoveredDevices.isEmpty()) {
+        if (!currentDeviceFromCache)
+            cacheDiscoveredServices(discoveredDevices.at(0));
         discoveredDevices.removeFirst();
     }
+    currentDeviceFromCache = false;
 
     startServiceDiscovery();
 }
 
+// Returns the cached services of device if they are recent enough, or an empty list.
+static QList<QBluetoothServiceInfo> cachedServices(const QBluetoothDeviceInfo &device,
+                                                   const QList<QBluetoothUuid> &uuidFilter,
+                                                   int cacheTimeout)
+{
+    QMutexLocker locker(&serviceCache->mutex);
+    const auto it = serviceCache->entries.constFind(device.address().toUInt64());
+    if (it == serviceCache->entries.cend() || it->age.hasExpired(cacheTimeout)
+            || it->uuidFilter != QSet<QBluetoothUuid>(uuidFilter.cbegin(), uuidFilter.cend())) {
+        return {};
+    }
+    return it->services;
+}
+
+bool QBluetoothServiceDiscoveryAgentPrivate::hasCachedServices(
+        const QBluetoothDeviceInfo &device) const
+{
+    if (mode != QBluetoothServiceDiscoveryAgent::FullDiscovery || cacheTimeout == 0)
+        return false;
+    return !cachedServices(device, uuidFilter, cacheTimeout).isEmpty();
+}
+
+/*!
+    Reports the services of \a device from the process-wide cache if they are
+    recent enough. Returns \c false if the device has to be queried.
+*/
+bool QBluetoothServiceDiscoveryAgentPrivate::reportCachedServices(
+        const QBluetoothDeviceInfo &device)
+{
+    if (mode != QBluetoothServiceDiscoveryAgent::FullDiscovery || cacheTimeout == 0)
+        return false;
+
+    const QList<QBluetoothServiceInfo> services = cachedServices(device, uuidFilter, cacheTimeout);
+    if (services.isEmpty())
+        return false;
+
+    qCDebug(QT_BT) << "Using" << services.size() << "cached services of" << device.address();
+
+    Q_Q(QBluetoothServiceDiscoveryAgent);
+    for (QBluetoothServiceInfo serviceInfo : qAsConst(services)) {
+        if (discoveryState() == Inactive)
+            break;
+
+        serviceInfo.setDevice(device);
+        if (!isDuplicatedService(serviceInfo)) {
+            discoveredServices.append(serviceInfo);
+            emit q->serviceDiscovered(serviceInfo);
+        }
+    }
+    return true;
+}
+
+/*!
+    Stores the services a full discovery found on \a device in the
+    process-wide cache.
+*/
+void QBluetoothServiceDiscoveryAgentPrivate::cacheDiscoveredServices(
+        const QBluetoothDeviceInfo &device)
+{
+    if (mode != QBluetoothServiceDiscoveryAgent::FullDiscovery)
+        return;
+
+    // services found by an earlier start() are not appended again, take them too
+    CachedServices entry;
+    entry.uuidFilter = QSet<QBluetoothUuid>(uuidFilter.cbegin(), uuidFilter.cend());
+    for (const QBluetoothServiceInfo &serviceInfo : qAsConst(discoveredServices)) {
+        if (serviceInfo.device().address() == device.address()
+                && matchesUuidFilter(serviceInfo, uuidFilter)) {
+            entry.services.append(serviceInfo);
+        }
+    }
+    // finding nothing usually means that the device could not be queried
+    if (entry.services.isEmpty())
+        return;
+    entry.age.start();
+
+    const quint64 key = device.address().toUInt64();
+    QMutexLocker locker(&serviceCache->mutex);
+    auto &entries = serviceCache->entries;
+    if (entries.size() >= maxCachedDevices && !entries.contains(key)) {
+        const auto oldest = std::min_element(entries.begin(), entries.end(),
+                                             [](const CachedServices &a, const CachedServices &b) {
+            return a.age.msecsSinceReference() < b.age.msecsSinceReference();
+        });
+        entries.erase(oldest);
+    }
+    entries.insert(key, entry);
+}
+
 bool QBluetoothServiceDiscoveryAgentPrivate::isDuplicatedService(
         const QBluetoothServiceInfo &serviceInfo) const
 {
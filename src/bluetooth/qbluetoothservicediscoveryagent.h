@@ -63,6 +63,13 @@ public:
     bool setRemoteAddress(const QBluetoothAddress &address);
     QBluetoothAddress remoteAddress() const;
 
+    void setCacheTimeout(int msTimeout);
+    int cacheTimeout() const;
+    void setMaximumParallelDiscoveries(int count);
+    int maximumParallelDiscoveries() const;
+    static void invalidateCache();
+    static void invalidateCache(const QBluetoothAddress &address);
+
 public Q_SLOTS:
     void start(DiscoveryMode mode = MinimalDiscovery);
     void stop();
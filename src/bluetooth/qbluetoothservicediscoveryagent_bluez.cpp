@@ -7,6 +7,7 @@
 #include "bluez/bluez5_helper_p.h"
 #include "bluez/objectmanager_p.h"
 #include "bluez/adapter1_bluez5_p.h"
+#include "bluez/sdpclient_p.h"
 
 #include <QtCore/QFile>
 #include <QtCore/QLibraryInfo>
@@ -16,6 +17,8 @@
 
 #include <QtDBus/QDBusPendingCallWatcher>
 
+#include <algorithm>
+
 QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
@@ -88,13 +91,121 @@ void QBluetoothServiceDiscoveryAgentPrivate::start(const QBluetoothAddress &addr
     if (DiscoveryMode() == QBluetoothServiceDiscoveryAgent::MinimalDiscovery) {
         performMinimalServiceDiscovery(address);
     } else {
-        runExternalSdpScan(address, QBluetoothAddress(adapter.address()));
+        runSdpScan(address, QBluetoothAddress(adapter.address()));
+    }
+}
+
+/* Bluez 5
+ * QtBluezSdpClient queries the remote SDP server directly, it only relies on the
+ * kernel's L2CAP sockets. The sdpscanner fallback below uses libbluetooth instead.
+ */
+void QBluetoothServiceDiscoveryAgentPrivate::runSdpScan(
+        const QBluetoothAddress &remoteAddress, const QBluetoothAddress &localAddress)
+{
+    if (!QtBluezSdpClient::isEnabled()) {
+        runExternalSdpScan(remoteAddress, localAddress);
+        return;
+    }
+
+    // remoteAddress is the first of discoveredDevices, it may be queried already
+    sdpLocalAddress = localAddress;
+    startSdpClients();
+}
+
+/*
+ * Queries the first devices of discoveredDevices, up to
+ * maximumParallelDiscoveries at a time. The first device is always among
+ * them, the others are queried ahead while waiting for it.
+ */
+void QBluetoothServiceDiscoveryAgentPrivate::startSdpClients()
+{
+    Q_Q(QBluetoothServiceDiscoveryAgent);
+
+    const qsizetype parallel = singleDevice ? 1 : maximumParallelDiscoveries;
+    qsizetype active = std::count_if(sdpClients.cbegin(), sdpClients.cend(),
+                                     [](QtBluezSdpClient *client) { return client->isActive(); });
+
+    for (qsizetype i = 0; i < discoveredDevices.size() && active < parallel; ++i) {
+        const QBluetoothDeviceInfo &device = discoveredDevices.at(i);
+        const bool queried = std::any_of(sdpClients.cbegin(), sdpClients.cend(),
+                                         [&device](QtBluezSdpClient *client) {
+            return client->isActive() && client->remoteAddress() == device.address();
+        });
+        // a cached device is served once it is the first one
+        if (queried || (i > 0 && hasCachedServices(device)))
+            continue;
+
+        const auto idle = std::find_if(sdpClients.cbegin(), sdpClients.cend(),
+                                       [](QtBluezSdpClient *client) { return !client->isActive(); });
+        QtBluezSdpClient *client = idle != sdpClients.cend() ? *idle : nullptr;
+        if (!client) {
+            client = new QtBluezSdpClient(q);
+            q->connect(client, &QtBluezSdpClient::finished,
+                       q, [this, client](const QList<QBluetoothServiceInfo> &services) {
+                finishSdpClient(client->remoteAddress(), services, true);
+            });
+            q->connect(client, &QtBluezSdpClient::errorOccurred,
+                       q, [this, client](const QString &errorString) {
+                qCWarning(QT_BT_BLUEZ) << "SDP scan failure" << client->remoteAddress()
+                                       << errorString;
+                finishSdpClient(client->remoteAddress(), QList<QBluetoothServiceInfo>(), false);
+            });
+            sdpClients.append(client);
+        }
+
+        // No filter implies PUBLIC_BROWSE_GROUP based SDP scan
+        client->start(device.address(), sdpLocalAddress, uuidFilter);
+        ++active;
+    }
+}
+
+void QBluetoothServiceDiscoveryAgentPrivate::finishSdpClient(
+        const QBluetoothAddress &address, const QList<QBluetoothServiceInfo> &services,
+        bool succeeded)
+{
+    if (discoveredDevices.isEmpty())
+        return;
+
+    // the first device continues the regular sequence of devices
+    if (discoveredDevices.at(0).address() == address) {
+        if (succeeded)
+            _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::NoError, QString(), services);
+        else
+            sdpScanFailed();
+        return;
+    }
+
+    // a device queried ahead is done with right away, errors are ignored like
+    // for any device of a search without remote address
+    const auto it = std::find_if(discoveredDevices.begin(), discoveredDevices.end(),
+                                 [&address](const QBluetoothDeviceInfo &device) {
+        return device.address() == address;
+    });
+    if (it == discoveredDevices.end())
+        return;
+
+    const QBluetoothDeviceInfo device = *it;
+    discoveredDevices.erase(it);
+    if (succeeded) {
+        reportSdpServices(device, services);
+        cacheDiscoveredServices(device);
     }
+    startSdpClients();
 }
 
+// see src/tools/sdpscanner/main.cpp
+static constexpr char sdpScannerBinaryMagic[] = "QSDP";
+static constexpr char sdpScannerBinaryVersion = 1;
+
+// cleared when the installed sdpscanner does not know the binary output yet
+static bool sdpScannerBinaryOutput = true;
+
 /* Bluez 5
  * src/tools/sdpscanner performs an SDP scan. This is
  * done out-of-process to avoid license issues. At this stage Bluez uses GPLv2.
+ *
+ * The scanner writes the records in their SDP encoding, they are decoded like
+ * those of the in-process client. Older scanners only write base64 encoded XML.
  */
 void QBluetoothServiceDiscoveryAgentPrivate::runExternalSdpScan(
         const QBluetoothAddress &remoteAddress, const QBluetoothAddress &localAddress)
@@ -107,7 +218,7 @@ void QBluetoothServiceDiscoveryAgentPrivate::runExternalSdpScan(
         if (!fileInfo.exists() || !fileInfo.isExecutable()) {
             _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::InputOutputError,
                              QBluetoothServiceDiscoveryAgent::tr("Unable to find sdpscanner"),
-                             QStringList());
+                             QList<QBluetoothServiceInfo>());
             qCWarning(QT_BT_BLUEZ) << "Cannot find sdpscanner:"
                                    << fileInfo.canonicalFilePath();
             return;
@@ -127,6 +238,8 @@ void QBluetoothServiceDiscoveryAgentPrivate::runExternalSdpScan(
 
     QStringList arguments;
     arguments << remoteAddress.toString() << localAddress.toString();
+    if (sdpScannerBinaryOutput)
+        arguments << QLatin1String("-b");
 
     // No filter implies PUBLIC_BROWSE_GROUP based SDP scan
     if (!uuidFilter.isEmpty()) {
@@ -141,21 +254,43 @@ void QBluetoothServiceDiscoveryAgentPrivate::runExternalSdpScan(
 
 void QBluetoothServiceDiscoveryAgentPrivate::_q_sdpScannerDone(int exitCode, QProcess::ExitStatus status)
 {
+    // sdpscanner returns 1 for unknown options
+    QStringList arguments = sdpScannerProcess->arguments();
+    if (status == QProcess::NormalExit && exitCode == 1
+            && arguments.removeAll(QLatin1String("-b")) > 0) {
+        qCDebug(QT_BT_BLUEZ) << "sdpscanner does not support binary output, using XML";
+        sdpScannerBinaryOutput = false;
+        sdpScannerProcess->setArguments(arguments);
+        sdpScannerProcess->start();
+        return;
+    }
+
     if (status != QProcess::NormalExit || exitCode != 0) {
         qCWarning(QT_BT_BLUEZ) << "SDP scan failure" << status << exitCode;
-        if (singleDevice) {
-            _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::InputOutputError,
-                             QBluetoothServiceDiscoveryAgent::tr("Unable to perform SDP scan"),
-                             QStringList());
-        } else {
-            // go to next device
-            _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::NoError, QString(), QStringList());
+        sdpScanFailed();
+        return;
+    }
+
+    const QByteArray output = sdpScannerProcess->readAllStandardOutput();
+    const QByteArrayView magic(sdpScannerBinaryMagic);
+    if (output.startsWith(magic)) {
+        QList<QBluetoothServiceInfo> services;
+        const QByteArrayView records = QByteArrayView(output).sliced(magic.size());
+        if (records.isEmpty() || records.front() != sdpScannerBinaryVersion) {
+            qCWarning(QT_BT_BLUEZ) << "Unsupported sdpscanner output format";
+            sdpScanFailed();
+            return;
         }
+        if (!QtBluezSdpClient::parseRecords(records.sliced(1), &services))
+            qCWarning(QT_BT_BLUEZ) << "Ignoring malformed SDP records of"
+                                   << discoveredDevices.at(0).address();
+
+        _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::NoError, QString(), services);
         return;
     }
 
     QStringList xmlRecords;
-    const QByteArray utf8Data = QByteArray::fromBase64(sdpScannerProcess->readAllStandardOutput());
+    const QByteArray utf8Data = QByteArray::fromBase64(output);
     const QByteArrayView utf8View = utf8Data;
 
     // split the various xml docs up
@@ -173,12 +308,29 @@ void QBluetoothServiceDiscoveryAgentPrivate::_q_sdpScannerDone(int exitCode, QPr
         } while ( start != -1);
     }
 
-    _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::NoError, QString(), xmlRecords);
+    QList<QBluetoothServiceInfo> services;
+    for (const QString &record : qAsConst(xmlRecords))
+        services.append(parseServiceXml(record));
+
+    _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::NoError, QString(), services);
+}
+
+void QBluetoothServiceDiscoveryAgentPrivate::sdpScanFailed()
+{
+    if (singleDevice) {
+        _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::InputOutputError,
+                         QBluetoothServiceDiscoveryAgent::tr("Unable to perform SDP scan"),
+                         QList<QBluetoothServiceInfo>());
+    } else {
+        // go to next device
+        _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::NoError, QString(),
+                         QList<QBluetoothServiceInfo>());
+    }
 }
 
 void QBluetoothServiceDiscoveryAgentPrivate::_q_finishSdpScan(QBluetoothServiceDiscoveryAgent::Error errorCode,
                                                               const QString &errorDescription,
-                                                              const QStringList &xmlRecords)
+                                                              const QList<QBluetoothServiceInfo> &services)
 {
     Q_Q(QBluetoothServiceDiscoveryAgent);
 
@@ -192,9 +344,21 @@ void QBluetoothServiceDiscoveryAgentPrivate::_q_finishSdpScan(QBluetoothServiceD
         error = errorCode;
         errorString = errorDescription;
         emit q->errorOccurred(error);
-    } else if (!xmlRecords.isEmpty() && discoveryState() != Inactive) {
-        for (const QString &record : xmlRecords) {
-            QBluetoothServiceInfo serviceInfo = parseServiceXml(record);
+    } else if (!discoveredDevices.isEmpty()) {
+        reportSdpServices(discoveredDevices.at(0), services);
+    }
+
+    _q_serviceDiscoveryFinished();
+}
+
+void QBluetoothServiceDiscoveryAgentPrivate::reportSdpServices(
+        const QBluetoothDeviceInfo &device, const QList<QBluetoothServiceInfo> &services)
+{
+    Q_Q(QBluetoothServiceDiscoveryAgent);
+
+    if (discoveryState() != Inactive) {
+        for (QBluetoothServiceInfo serviceInfo : services) {
+            serviceInfo.setDevice(device);
 
             //apply uuidFilter
             if (!uuidFilter.isEmpty()) {
@@ -216,7 +380,7 @@ void QBluetoothServiceDiscoveryAgentPrivate::_q_finishSdpScan(QBluetoothServiceD
             if (!serviceInfo.isValid())
                 continue;
 
-            // Bluez sdpscanner declares custom uuids into the service class uuid list.
+            // SDP records declare custom uuids into the service class uuid list.
             // Let's move a potential custom uuid from QBluetoothServiceInfo::serviceClassUuids()
             // to QBluetoothServiceInfo::serviceUuid(). If there is more than one, just move the first uuid
             const QList<QBluetoothUuid> serviceClassUuids = serviceInfo.serviceClassUuids();
@@ -237,7 +401,7 @@ void QBluetoothServiceDiscoveryAgentPrivate::_q_finishSdpScan(QBluetoothServiceD
 
             if (!isDuplicatedService(serviceInfo)) {
                 discoveredServices.append(serviceInfo);
-                qCDebug(QT_BT_BLUEZ) << "Discovered services" << discoveredDevices.at(0).address().toString()
+                qCDebug(QT_BT_BLUEZ) << "Discovered services" << device.address().toString()
                                      << serviceInfo.serviceName() << serviceInfo.serviceUuid()
                                      << ">>>" << serviceInfo.serviceClassUuids();
                 // Use queued connection to allow us finish the service looping; the application
@@ -247,8 +411,6 @@ void QBluetoothServiceDiscoveryAgentPrivate::_q_finishSdpScan(QBluetoothServiceD
             }
         }
     }
-
-    _q_serviceDiscoveryFinished();
 }
 
 void QBluetoothServiceDiscoveryAgentPrivate::stop()
@@ -258,6 +420,9 @@ void QBluetoothServiceDiscoveryAgentPrivate::stop()
     discoveredDevices.clear();
     setDiscoveryState(Inactive);
 
+    for (QtBluezSdpClient *client : qAsConst(sdpClients))
+        client->stop();
+
     // must happen after discoveredDevices.clear() above to avoid retrigger of next scan
     // while waitForFinished() is waiting
     if (sdpScannerProcess) { // Bluez 5
@@ -277,7 +442,6 @@ QBluetoothServiceInfo QBluetoothServiceDiscoveryAgentPrivate::parseServiceXml(
     QXmlStreamReader xml(xmlRecord);
 
     QBluetoothServiceInfo serviceInfo;
-    serviceInfo.setDevice(discoveredDevices.at(0));
 
     while (!xml.atEnd()) {
         xml.readNext();
@@ -307,12 +471,13 @@ void QBluetoothServiceDiscoveryAgentPrivate::performMinimalServiceDiscovery(cons
 
     Q_Q(QBluetoothServiceDiscoveryAgent);
 
-    QDBusPendingReply<ManagedObjectList> reply = manager->GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError()) {
+    QDBusError dbusError;
+    const ManagedObjectList managedObjectList =
+            QtBluezObjectCache::instance()->managedObjects(&dbusError);
+    if (dbusError.isValid()) {
         if (singleDevice) {
             error = QBluetoothServiceDiscoveryAgent::InputOutputError;
-            errorString = reply.error().message();
+            errorString = dbusError.message();
             emit q->errorOccurred(error);
         }
         _q_serviceDiscoveryFinished();
@@ -321,7 +486,6 @@ void QBluetoothServiceDiscoveryAgentPrivate::performMinimalServiceDiscovery(cons
 
     QStringList uuidStrings;
 
-    ManagedObjectList managedObjectList = reply.value();
     for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
         const InterfaceList &ifaceList = it.value();
 
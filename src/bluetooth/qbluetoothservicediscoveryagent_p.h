@@ -33,6 +33,7 @@ class OrgFreedesktopDBusObjectManagerInterface;
 QT_BEGIN_NAMESPACE
 class QDBusPendingCallWatcher;
 class QXmlStreamReader;
+class QtBluezSdpClient;
 QT_END_NAMESPACE
 #endif
 
@@ -102,7 +103,7 @@ public:
     void _q_sdpScannerDone(int exitCode, QProcess::ExitStatus status);
     void _q_finishSdpScan(QBluetoothServiceDiscoveryAgent::Error errorCode,
                           const QString &errorDescription,
-                          const QStringList &xmlRecords);
+                          const QList<QBluetoothServiceInfo> &services);
 #endif
 #ifdef QT_ANDROID_BLUETOOTH
     void _q_processFetchedUuids(const QBluetoothAddress &address, const QList<QBluetoothUuid> &uuids);
@@ -117,9 +118,20 @@ private:
     void start(const QBluetoothAddress &address);
     void stop();
     bool isDuplicatedService(const QBluetoothServiceInfo &serviceInfo) const;
+    bool hasCachedServices(const QBluetoothDeviceInfo &device) const;
+    bool reportCachedServices(const QBluetoothDeviceInfo &device);
+    void cacheDiscoveredServices(const QBluetoothDeviceInfo &device);
 
 #if QT_CONFIG(bluez)
     void startBluez5(const QBluetoothAddress &address);
+    void runSdpScan(const QBluetoothAddress &remoteAddress,
+                    const QBluetoothAddress &localAddress);
+    void sdpScanFailed();
+    void startSdpClients();
+    void finishSdpClient(const QBluetoothAddress &address,
+                         const QList<QBluetoothServiceInfo> &services, bool succeeded);
+    void reportSdpServices(const QBluetoothDeviceInfo &device,
+                           const QList<QBluetoothServiceInfo> &services);
     void runExternalSdpScan(const QBluetoothAddress &remoteAddress,
                     const QBluetoothAddress &localAddress);
     void sdpScannerDone(int exitCode, QProcess::ExitStatus exitStatus);
@@ -145,10 +157,16 @@ private:
     QBluetoothServiceDiscoveryAgent::DiscoveryMode mode;
 
     bool singleDevice;
+    int cacheTimeout = 0;
+    int maximumParallelDiscoveries = 1;
+    // whether the services of the current device came from the cache
+    bool currentDeviceFromCache = false;
 #if QT_CONFIG(bluez)
     QString foundHostAdapterPath;
     OrgFreedesktopDBusObjectManagerInterface *manager = nullptr;
     QProcess *sdpScannerProcess = nullptr;
+    QList<QtBluezSdpClient *> sdpClients;
+    QBluetoothAddress sdpLocalAddress;
 #endif
 
 #ifdef QT_ANDROID_BLUETOOTH
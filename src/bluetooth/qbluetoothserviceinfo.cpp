@@ -5,9 +5,15 @@
 #include "qbluetoothserviceinfo_p.h"
 
 #include <QUrl>
+#include <QtCore/qendian.h>
+#include <QtCore/qloggingcategory.h>
+
+#include <algorithm>
 
 QT_BEGIN_NAMESPACE
 
+Q_DECLARE_LOGGING_CATEGORY(QT_BT)
+
 QT_IMPL_METATYPE_EXTERN(QBluetoothServiceInfo)
 QT_IMPL_METATYPE_EXTERN_TAGGED(QBluetoothServiceInfo::Sequence, QBluetoothServiceInfo__Sequence)
 QT_IMPL_METATYPE_EXTERN_TAGGED(QBluetoothServiceInfo::Alternative,
@@ -352,7 +358,7 @@ QBluetoothServiceInfo::~QBluetoothServiceInfo()
 */
 bool QBluetoothServiceInfo::isValid() const
 {
-    return !d_ptr->attributes.isEmpty();
+    return !d_ptr->isEmpty();
 }
 
 /*!
@@ -362,7 +368,7 @@ bool QBluetoothServiceInfo::isValid() const
 */
 bool QBluetoothServiceInfo::isComplete() const
 {
-    return d_ptr->attributes.contains(ProtocolDescriptorList);
+    return d_ptr->contains(ProtocolDescriptorList);
 }
 
 /*!
@@ -394,7 +400,7 @@ void QBluetoothServiceInfo::setDevice(const QBluetoothDeviceInfo &device)
 */
 void QBluetoothServiceInfo::setAttribute(quint16 attributeId, const QVariant &value)
 {
-    d_ptr->attributes[attributeId] = value;
+    d_ptr->setAttribute(attributeId, value);
 }
 
 /*!
@@ -402,7 +408,7 @@ void QBluetoothServiceInfo::setAttribute(quint16 attributeId, const QVariant &va
 */
 QVariant QBluetoothServiceInfo::attribute(quint16 attributeId) const
 {
-    return d_ptr->attributes.value(attributeId);
+    return d_ptr->attribute(attributeId);
 }
 
 /*!
@@ -410,7 +416,7 @@ QVariant QBluetoothServiceInfo::attribute(quint16 attributeId) const
 */
 QList<quint16> QBluetoothServiceInfo::attributes() const
 {
-    return d_ptr->attributes.keys();
+    return d_ptr->attributeIds();
 }
 
 /*!
@@ -419,7 +425,7 @@ QList<quint16> QBluetoothServiceInfo::attributes() const
 */
 bool QBluetoothServiceInfo::contains(quint16 attributeId) const
 {
-    return d_ptr->attributes.contains(attributeId);
+    return d_ptr->contains(attributeId);
 }
 
 /*!
@@ -430,7 +436,7 @@ bool QBluetoothServiceInfo::contains(quint16 attributeId) const
 */
 void QBluetoothServiceInfo::removeAttribute(quint16 attributeId)
 {
-    d_ptr->attributes.remove(attributeId);
+    d_ptr->removeAttribute(attributeId);
 }
 
 /*!
@@ -438,12 +444,10 @@ void QBluetoothServiceInfo::removeAttribute(quint16 attributeId)
 */
 QBluetoothServiceInfo::Protocol QBluetoothServiceInfo::socketProtocol() const
 {
-    QBluetoothServiceInfo::Sequence parameters = protocolDescriptor(QBluetoothUuid::ProtocolUuid::Rfcomm);
-    if (!parameters.isEmpty())
+    if (d_ptr->serverChannel() != -1)
         return RfcommProtocol;
 
-    parameters = protocolDescriptor(QBluetoothUuid::ProtocolUuid::L2cap);
-    if (!parameters.isEmpty())
+    if (d_ptr->protocolServiceMultiplexer() != -1)
         return L2capProtocol;
 
     return UnknownProtocol;
@@ -459,14 +463,7 @@ QBluetoothServiceInfo::Protocol QBluetoothServiceInfo::socketProtocol() const
 */
 int QBluetoothServiceInfo::protocolServiceMultiplexer() const
 {
-    QBluetoothServiceInfo::Sequence parameters = protocolDescriptor(QBluetoothUuid::ProtocolUuid::L2cap);
-
-    if (parameters.isEmpty())
-        return -1;
-    else if (parameters.size() == 1)
-        return 0;
-    else
-        return parameters.at(1).toUInt();
+    return d_ptr->protocolServiceMultiplexer();
 }
 
 /*!
@@ -503,17 +500,7 @@ QBluetoothServiceInfo::Sequence QBluetoothServiceInfo::protocolDescriptor(QBluet
 */
 QList<QBluetoothUuid> QBluetoothServiceInfo::serviceClassUuids() const
 {
-    QList<QBluetoothUuid> results;
-
-    const QVariant var = attribute(QBluetoothServiceInfo::ServiceClassIds);
-    if (!var.isValid())
-        return results;
-
-    const QBluetoothServiceInfo::Sequence seq = var.value<QBluetoothServiceInfo::Sequence>();
-    for (qsizetype i = 0; i < seq.size(); ++i)
-        results.append(seq.at(i).value<QBluetoothUuid>());
-
-    return results;
+    return d_ptr->serviceClassUuids();
 }
 
 /*!
@@ -618,13 +605,458 @@ QDebug QBluetoothServiceInfo::streamingOperator(QDebug dbg, const QBluetoothServ
 }
 #endif
 
+// no profile nests sequences anywhere near that deep
+static constexpr int maxNestingDepth = 32;
+
+bool QBluetoothServiceInfoPrivate::takeDataElement(QByteArrayView *data, DataElement *element)
+{
+    if (data->isEmpty())
+        return false;
+
+    const quint8 descriptor = quint8(data->data()[0]);
+    element->type = descriptor >> 3;
+
+    qsizetype headerSize = 1;
+    qint64 size = 0;
+    switch (descriptor & 0x07) {
+    case 5:
+        headerSize += 1;
+        if (data->size() < headerSize)
+            return false;
+        size = quint8(data->data()[1]);
+        break;
+    case 6:
+        headerSize += 2;
+        if (data->size() < headerSize)
+            return false;
+        size = qFromBigEndian<quint16>(data->data() + 1);
+        break;
+    case 7:
+        headerSize += 4;
+        if (data->size() < headerSize)
+            return false;
+        size = qFromBigEndian<quint32>(data->data() + 1);
+        break;
+    default:
+        // nil is the only type whose size index does not imply a size
+        size = element->type == NilType ? 0 : qint64(1) << (descriptor & 0x07);
+        break;
+    }
+
+    if (data->size() - headerSize < size)
+        return false;
+
+    element->content = data->sliced(headerSize, size);
+    *data = data->sliced(headerSize + size);
+    return true;
+}
+
+/*
+ * Checks that all elements nested in a sequence or alternative are complete,
+ * decoding such an element later on cannot fail then.
+ */
+static bool isWellFormed(const QBluetoothServiceInfoPrivate::DataElement &element, int depth)
+{
+    if (element.type != QBluetoothServiceInfoPrivate::SequenceType
+            && element.type != QBluetoothServiceInfoPrivate::AlternativeType) {
+        return true;
+    }
+    if (depth >= maxNestingDepth)
+        return false;
+
+    QByteArrayView remaining = element.content;
+    while (!remaining.isEmpty()) {
+        QBluetoothServiceInfoPrivate::DataElement child;
+        if (!QBluetoothServiceInfoPrivate::takeDataElement(&remaining, &child)
+                || !isWellFormed(child, depth + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Converts a well-formed data element to the types QBluetoothServiceInfo uses
+ * for attributes. Integers which do not fit into 64 bits and element types not
+ * defined by the specification yield an invalid QVariant.
+ */
+static QVariant dataElementValue(const QBluetoothServiceInfoPrivate::DataElement &element)
+{
+    using Private = QBluetoothServiceInfoPrivate;
+
+    const QByteArrayView content = element.content;
+    const char *data = content.data();
+
+    switch (element.type) {
+    case Private::NilType:
+        return QVariant();
+    case Private::UnsignedIntType:
+        switch (content.size()) {
+        case 1:
+            return QVariant::fromValue(quint8(data[0]));
+        case 2:
+            return QVariant::fromValue(qFromBigEndian<quint16>(data));
+        case 4:
+            return QVariant::fromValue(qFromBigEndian<quint32>(data));
+        case 8:
+            return QVariant::fromValue(qFromBigEndian<quint64>(data));
+        }
+        break;
+    case Private::SignedIntType:
+        switch (content.size()) {
+        case 1:
+            return QVariant::fromValue(qint8(data[0]));
+        case 2:
+            return QVariant::fromValue(qFromBigEndian<qint16>(data));
+        case 4:
+            return QVariant::fromValue(qFromBigEndian<qint32>(data));
+        case 8:
+            return QVariant::fromValue(qFromBigEndian<qint64>(data));
+        }
+        break;
+    case Private::UuidType:
+        switch (content.size()) {
+        case 2:
+            return QVariant::fromValue(QBluetoothUuid(qFromBigEndian<quint16>(data)));
+        case 4:
+            return QVariant::fromValue(QBluetoothUuid(qFromBigEndian<quint32>(data)));
+        case 16:
+            return QVariant::fromValue(QBluetoothUuid(QUuid::fromRfc4122(content)));
+        }
+        break;
+    case Private::TextType:
+    case Private::UrlType: {
+        // some devices include a terminating null character
+        const auto end = std::find(content.begin(), content.end(), '\0');
+        return QString::fromUtf8(data, end - content.begin());
+    }
+    case Private::BoolType:
+        if (content.size() == 1)
+            return bool(data[0] != 0);
+        break;
+    case Private::SequenceType:
+    case Private::AlternativeType: {
+        QList<QVariant> values;
+        QByteArrayView remaining = content;
+        Private::DataElement child;
+        while (Private::takeDataElement(&remaining, &child))
+            values.append(dataElementValue(child));
+
+        if (element.type == Private::AlternativeType)
+            return QVariant::fromValue(QBluetoothServiceInfo::Alternative(values));
+        return QVariant::fromValue(QBluetoothServiceInfo::Sequence(values));
+    }
+    default:
+        break;
+    }
+
+    qCDebug(QT_BT) << "Ignoring SDP data element of type" << int(element.type)
+                   << "and size" << content.size();
+    return QVariant();
+}
+
+static void appendHeader(QByteArray *out, quint8 type, qsizetype size)
+{
+    char buffer[4];
+    if (size <= 0xff) {
+        out->append(char(type << 3 | 5));
+        out->append(char(size));
+    } else if (size <= 0xffff) {
+        out->append(char(type << 3 | 6));
+        qToBigEndian<quint16>(quint16(size), buffer);
+        out->append(buffer, 2);
+    } else {
+        out->append(char(type << 3 | 7));
+        qToBigEndian<quint32>(quint32(size), buffer);
+        out->append(buffer, 4);
+    }
+}
+
+template <typename T>
+static void appendInteger(QByteArray *out, quint8 type, T value)
+{
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+    constexpr quint8 sizeIndex = sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : sizeof(T) == 4 ? 2 : 3;
+    char buffer[sizeof(T)];
+    qToBigEndian<T>(value, buffer);
+    out->append(char(type << 3 | sizeIndex));
+    out->append(buffer, sizeof(T));
+}
+
+/*
+ * Encodes the types QBluetoothServiceInfo uses for attributes, the same ones
+ * dataElementValue() yields. Apart from that, raw QByteArray values are sent
+ * as text, like on the other platforms.
+ */
+bool QBluetoothServiceInfoPrivate::appendDataElement(QByteArray *out, const QVariant &value)
+{
+    switch (value.typeId()) {
+    case QMetaType::UnknownType:
+    case QMetaType::Void:
+    case QMetaType::Nullptr:
+        out->append(char(NilType << 3));
+        return true;
+    case QMetaType::UChar:
+        appendInteger(out, UnsignedIntType, value.value<quint8>());
+        return true;
+    case QMetaType::UShort:
+        appendInteger(out, UnsignedIntType, value.value<quint16>());
+        return true;
+    case QMetaType::UInt:
+        appendInteger(out, UnsignedIntType, value.value<quint32>());
+        return true;
+    case QMetaType::ULongLong:
+        appendInteger(out, UnsignedIntType, value.value<quint64>());
+        return true;
+    case QMetaType::Char:
+    case QMetaType::SChar:
+        appendInteger(out, SignedIntType, value.value<qint8>());
+        return true;
+    case QMetaType::Short:
+        appendInteger(out, SignedIntType, value.value<qint16>());
+        return true;
+    case QMetaType::Int:
+        appendInteger(out, SignedIntType, value.value<qint32>());
+        return true;
+    case QMetaType::LongLong:
+        appendInteger(out, SignedIntType, value.value<qint64>());
+        return true;
+    case QMetaType::Bool:
+        out->append(char(BoolType << 3));
+        out->append(char(value.value<bool>() ? 1 : 0));
+        return true;
+    case QMetaType::QByteArray: {
+        const QByteArray text = value.value<QByteArray>();
+        appendHeader(out, TextType, text.size());
+        out->append(text);
+        return true;
+    }
+    case QMetaType::QString: {
+        const QByteArray text = value.value<QString>().toUtf8();
+        appendHeader(out, TextType, text.size());
+        out->append(text);
+        return true;
+    }
+    case QMetaType::QUrl: {
+        const QByteArray url = value.value<QUrl>().toEncoded();
+        appendHeader(out, UrlType, url.size());
+        out->append(url);
+        return true;
+    }
+    default:
+        break;
+    }
+
+    if (value.userType() == qMetaTypeId<QBluetoothUuid>()) {
+        const QBluetoothUuid uuid = value.value<QBluetoothUuid>();
+        switch (uuid.minimumSize()) {
+        case 0:
+        case 2:
+            appendInteger(out, UuidType, uuid.toUInt16());
+            break;
+        case 4:
+            appendInteger(out, UuidType, uuid.toUInt32());
+            break;
+        default:
+            out->append(char(UuidType << 3 | 4));
+            out->append(uuid.toRfc4122());
+            break;
+        }
+        return true;
+    }
+
+    const bool isSequence = value.userType() == qMetaTypeId<QBluetoothServiceInfo::Sequence>();
+    if (isSequence || value.userType() == qMetaTypeId<QBluetoothServiceInfo::Alternative>()) {
+        const QList<QVariant> &values = isSequence
+                ? QList<QVariant>(*static_cast<const QBluetoothServiceInfo::Sequence *>(value.constData()))
+                : QList<QVariant>(*static_cast<const QBluetoothServiceInfo::Alternative *>(value.constData()));
+        QByteArray content;
+        for (const QVariant &v : values) {
+            if (!appendDataElement(&content, v))
+                return false;
+        }
+        appendHeader(out, isSequence ? SequenceType : AlternativeType, content.size());
+        out->append(content);
+        return true;
+    }
+
+    qCWarning(QT_BT) << "Cannot encode SDP attribute of type" << value.metaType().name();
+    return false;
+}
+
+bool QBluetoothServiceInfoPrivate::setEncodedAttributes(QBluetoothServiceInfo *serviceInfo,
+                                                        QByteArrayView attributeList)
+{
+    QBluetoothServiceInfoPrivate *d = serviceInfo->d_ptr.get();
+    ++d->revision;
+    d->attributes.clear();
+    d->encodedIndex.clear();
+    d->encodedAttributes = attributeList.toByteArray();
+
+    const QByteArrayView encoded = d->encodedAttributes;
+    QByteArrayView remaining = encoded;
+    bool ok = true;
+    while (ok && !remaining.isEmpty()) {
+        DataElement id;
+        DataElement value;
+        if (!takeDataElement(&remaining, &id) || id.type != UnsignedIntType
+                || id.content.size() != 2) {
+            ok = false;
+            break;
+        }
+
+        const qsizetype offset = remaining.data() - encoded.data();
+        if (!takeDataElement(&remaining, &value) || !isWellFormed(value, 0)) {
+            ok = false;
+            break;
+        }
+
+        const EncodedAttribute entry = {
+            qFromBigEndian<quint16>(id.content.data()), quint32(offset),
+            quint32(remaining.data() - encoded.data() - offset)
+        };
+        // servers send the attributes in ascending order, a repeated id replaces the former one
+        auto &index = d->encodedIndex;
+        if (index.isEmpty() || index.constLast().id < entry.id) {
+            index.append(entry);
+        } else {
+            const auto it = std::lower_bound(index.begin(), index.end(), entry.id,
+                                             [](const EncodedAttribute &a, quint16 id) {
+                return a.id < id;
+            });
+            if (it->id == entry.id)
+                *it = entry;
+            else
+                index.insert(it, entry);
+        }
+    }
+
+    if (!ok) {
+        d->encodedIndex.clear();
+        d->encodedAttributes.clear();
+    }
+    d->encodedIndex.squeeze();
+    d->updateCachedAttributes(QBluetoothServiceInfo::ProtocolDescriptorList);
+    d->updateCachedAttributes(QBluetoothServiceInfo::ServiceClassIds);
+    return ok;
+}
+
+QVariant QBluetoothServiceInfoPrivate::attribute(quint16 attributeId) const
+{
+    const auto decoded = attributes.constFind(attributeId);
+    if (decoded != attributes.cend())
+        return decoded.value();
+
+    const auto it = std::lower_bound(encodedIndex.cbegin(), encodedIndex.cend(), attributeId,
+                                     [](const EncodedAttribute &a, quint16 id) {
+        return a.id < id;
+    });
+    if (it == encodedIndex.cend() || it->id != attributeId)
+        return QVariant();
+
+    // the record was checked when it was stored, nothing is cached here
+    // because services are shared between threads without detaching
+    QByteArrayView data = QByteArrayView(encodedAttributes).sliced(it->offset, it->size);
+    DataElement element;
+    takeDataElement(&data, &element);
+    return dataElementValue(element);
+}
+
+bool QBluetoothServiceInfoPrivate::contains(quint16 attributeId) const
+{
+    if (attributes.contains(attributeId))
+        return true;
+
+    const auto it = std::lower_bound(encodedIndex.cbegin(), encodedIndex.cend(), attributeId,
+                                     [](const EncodedAttribute &a, quint16 id) {
+        return a.id < id;
+    });
+    return it != encodedIndex.cend() && it->id == attributeId;
+}
+
+QList<quint16> QBluetoothServiceInfoPrivate::attributeIds() const
+{
+    if (encodedIndex.isEmpty())
+        return attributes.keys();
+
+    QList<quint16> ids;
+    ids.reserve(attributes.size() + encodedIndex.size());
+    auto decoded = attributes.keyBegin();
+    for (const EncodedAttribute &encoded : encodedIndex) {
+        for (; decoded != attributes.keyEnd() && *decoded < encoded.id; ++decoded)
+            ids.append(*decoded);
+        ids.append(encoded.id);
+    }
+    for (; decoded != attributes.keyEnd(); ++decoded)
+        ids.append(*decoded);
+    return ids;
+}
+
+void QBluetoothServiceInfoPrivate::setAttribute(quint16 attributeId, const QVariant &value)
+{
+    ++revision;
+    attributes[attributeId] = value;
+
+    // the encoded bytes stay, they are shared by the remaining attributes
+    encodedIndex.removeIf([attributeId](const EncodedAttribute &a) {
+        return a.id == attributeId;
+    });
+    updateCachedAttributes(attributeId);
+}
+
+void QBluetoothServiceInfoPrivate::removeAttribute(quint16 attributeId)
+{
+    ++revision;
+    attributes.remove(attributeId);
+    encodedIndex.removeIf([attributeId](const EncodedAttribute &a) {
+        return a.id == attributeId;
+    });
+    if (encodedIndex.isEmpty())
+        encodedAttributes.clear();
+    updateCachedAttributes(attributeId);
+}
+
+void QBluetoothServiceInfoPrivate::updateCachedAttributes(quint16 attributeId)
+{
+    const auto parameter = [this](QBluetoothUuid::ProtocolUuid protocol) {
+        const QBluetoothServiceInfo::Sequence parameters = protocolDescriptor(protocol);
+        if (parameters.isEmpty())
+            return -1;
+        else if (parameters.size() == 1)
+            return 0;
+        else
+            return int(parameters.at(1).toUInt());
+    };
+
+    switch (attributeId) {
+    case QBluetoothServiceInfo::ProtocolDescriptorList:
+        rfcommChannel = parameter(QBluetoothUuid::ProtocolUuid::Rfcomm);
+        l2capPsm = parameter(QBluetoothUuid::ProtocolUuid::L2cap);
+        break;
+    case QBluetoothServiceInfo::ServiceClassIds: {
+        classUuids.clear();
+        const QVariant var = attribute(QBluetoothServiceInfo::ServiceClassIds);
+        if (!var.isValid())
+            break;
+
+        const QBluetoothServiceInfo::Sequence seq = var.value<QBluetoothServiceInfo::Sequence>();
+        for (qsizetype i = 0; i < seq.size(); ++i)
+            classUuids.append(seq.at(i).value<QBluetoothUuid>());
+        break;
+    }
+    default:
+        break;
+    }
+}
+
 QBluetoothServiceInfo::Sequence QBluetoothServiceInfoPrivate::protocolDescriptor(QBluetoothUuid::ProtocolUuid protocol) const
 {
-    if (!attributes.contains(QBluetoothServiceInfo::ProtocolDescriptorList))
+    const QVariant descriptorList = attribute(QBluetoothServiceInfo::ProtocolDescriptorList);
+    if (!descriptorList.isValid())
         return QBluetoothServiceInfo::Sequence();
 
     const QBluetoothServiceInfo::Sequence sequence
-            = attributes.value(QBluetoothServiceInfo::ProtocolDescriptorList).value<QBluetoothServiceInfo::Sequence>();
+            = descriptorList.value<QBluetoothServiceInfo::Sequence>();
     for (const QVariant &v : sequence) {
         QBluetoothServiceInfo::Sequence parameters = v.value<QBluetoothServiceInfo::Sequence>();
         if (parameters.empty())
@@ -638,16 +1070,4 @@ QBluetoothServiceInfo::Sequence QBluetoothServiceInfoPrivate::protocolDescriptor
     return QBluetoothServiceInfo::Sequence();
 }
 
-int QBluetoothServiceInfoPrivate::serverChannel() const
-{
-    QBluetoothServiceInfo::Sequence parameters = protocolDescriptor(QBluetoothUuid::ProtocolUuid::Rfcomm);
-
-    if (parameters.isEmpty())
-        return -1;
-    else if (parameters.size() == 1)
-        return 0;
-    else
-        return parameters.at(1).toUInt();
-}
-
 QT_END_NAMESPACE
@@ -119,6 +119,7 @@ private:
     }
     static QDebug streamingOperator(QDebug, const QBluetoothServiceInfo &);
 #endif
+    friend class QBluetoothServiceInfoPrivate;
 protected:
     QSharedPointer<QBluetoothServiceInfoPrivate> d_ptr;
 };
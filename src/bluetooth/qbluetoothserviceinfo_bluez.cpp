@@ -165,15 +165,10 @@ bool QBluetoothServiceInfoPrivate::unregisterService()
     return true;
 }
 
-// TODO Implement local adapter behavior
-bool QBluetoothServiceInfoPrivate::registerService(const QBluetoothAddress & /*localAdapter*/)
+QString QBluetoothServiceInfoPrivate::serviceRecordXml() const
 {
-    if (registered)
-        return false;
-
-    QString xmlServiceRecord;
-
-    QXmlStreamWriter stream(&xmlServiceRecord);
+    QString record;
+    QXmlStreamWriter stream(&record);
     stream.setAutoFormatting(true);
 
     stream.writeStartDocument(QStringLiteral("1.0"));
@@ -182,20 +177,35 @@ bool QBluetoothServiceInfoPrivate::registerService(const QBluetoothAddress & /*l
 
     const QString unsignedFormat(QStringLiteral("0x%1"));
 
-    QMap<quint16, QVariant>::ConstIterator i = attributes.constBegin();
-    while (i != attributes.constEnd()) {
+    // a discovered service may be registered again, its attributes can still be encoded
+    const QList<quint16> ids = attributeIds();
+    for (quint16 id : ids) {
         stream.writeStartElement(QStringLiteral("attribute"));
-        stream.writeAttribute(QStringLiteral("id"), unsignedFormat.arg(i.key(), 4, 16, QLatin1Char('0')));
-        writeAttribute(&stream, i.value());
+        stream.writeAttribute(QStringLiteral("id"), unsignedFormat.arg(id, 4, 16, QLatin1Char('0')));
+        writeAttribute(&stream, attribute(id));
         stream.writeEndElement();
-
-        ++i;
     }
 
     stream.writeEndElement();
 
     stream.writeEndDocument();
 
+    return record;
+}
+
+// TODO Implement local adapter behavior
+bool QBluetoothServiceInfoPrivate::registerService(const QBluetoothAddress & /*localAdapter*/)
+{
+    if (registered)
+        return false;
+
+    // services registered several times only serialize their record again
+    // once it changed
+    if (xmlServiceRecord.isEmpty() || xmlServiceRecordRevision != attributesRevision()) {
+        xmlServiceRecord = serviceRecordXml();
+        xmlServiceRecordRevision = attributesRevision();
+    }
+
     // create path
     profilePath = profilePathTemplate;
     profilePath.append(QString::fromLatin1("/%1%2/%3")
@@ -212,10 +222,10 @@ bool QBluetoothServiceInfoPrivate::registerService(const QBluetoothAddress & /*l
     // 2.) use first custom uuid if available
     // 3.) use first service class uuid
     QBluetoothUuid profileUuid =
-            attributes.value(QBluetoothServiceInfo::ServiceId).value<QBluetoothUuid>();
+            attribute(QBluetoothServiceInfo::ServiceId).value<QBluetoothUuid>();
     QBluetoothUuid firstCustomUuid;
     if (profileUuid.isNull()) {
-        const QVariant var = attributes.value(QBluetoothServiceInfo::ServiceClassIds);
+        const QVariant var = attribute(QBluetoothServiceInfo::ServiceClassIds);
         if (var.isValid()) {
             const QBluetoothServiceInfo::Sequence seq =
                     var.value<QBluetoothServiceInfo::Sequence>();
@@ -20,6 +20,9 @@
 #include "qbluetoothdeviceinfo.h"
 #include "qbluetoothserviceinfo.h"
 
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
 #include <QMap>
 #include <QVariant>
 
@@ -65,17 +68,86 @@ public:
 
     bool unregisterService();
 
+    // data element types, see Bluetooth Core Specification Vol 3, Part B, 3.2
+    enum DataElementType : quint8 {
+        NilType = 0,
+        UnsignedIntType = 1,
+        SignedIntType = 2,
+        UuidType = 3,
+        TextType = 4,
+        BoolType = 5,
+        SequenceType = 6,
+        AlternativeType = 7,
+        UrlType = 8
+    };
+
+    struct DataElement
+    {
+        quint8 type = NilType;
+        QByteArrayView content;
+    };
+
+    // Splits the data element at the front of data off. Returns false if data
+    // does not start with a complete data element.
+    static bool takeDataElement(QByteArrayView *data, DataElement *element);
+    // Appends value as a data element, the inverse of decoding an attribute.
+    // Returns false if value has a type that cannot be encoded.
+    static bool appendDataElement(QByteArray *out, const QVariant &value);
+
+    // Replaces the attributes of serviceInfo by those of an encoded SDP
+    // attribute list, a sequence of attribute id and value pairs without the
+    // enclosing sequence header. The values are decoded when accessed.
+    static bool setEncodedAttributes(QBluetoothServiceInfo *serviceInfo,
+                                     QByteArrayView attributeList);
+
+    QVariant attribute(quint16 attributeId) const;
+    bool contains(quint16 attributeId) const;
+    QList<quint16> attributeIds() const;
+    bool isEmpty() const { return attributes.isEmpty() && encodedIndex.isEmpty(); }
+    void setAttribute(quint16 attributeId, const QVariant &value);
+    void removeAttribute(quint16 attributeId);
+
     QBluetoothDeviceInfo deviceInfo;
+    // attributes set through setAttribute(), see encodedIndex for the others
     QMap<quint16, QVariant> attributes;
 
+    // changes whenever an attribute is set or removed
+    quint32 attributesRevision() const { return revision; }
+
     QBluetoothServiceInfo::Sequence protocolDescriptor(QBluetoothUuid::ProtocolUuid protocol) const;
-    int serverChannel() const;
+    int serverChannel() const { return rfcommChannel; }
+    int protocolServiceMultiplexer() const { return l2capPsm; }
+    QList<QBluetoothUuid> serviceClassUuids() const { return classUuids; }
 private:
+    void updateCachedAttributes(quint16 attributeId);
+
+    // Attributes received from a remote SDP server stay encoded until they are
+    // accessed. An attribute id is either in attributes or in encodedIndex.
+    struct EncodedAttribute
+    {
+        quint16 id;
+        // the value data element within encodedAttributes
+        quint32 offset;
+        quint32 size;
+    };
+    QByteArray encodedAttributes;
+    QList<EncodedAttribute> encodedIndex; // sorted by id
+    quint32 revision = 0;
+
+    // derived from ProtocolDescriptorList and ServiceClassIds whenever they change
+    int rfcommChannel = -1;
+    int l2capPsm = -1;
+    QList<QBluetoothUuid> classUuids;
+
 #if QT_CONFIG(bluez)
     OrgBluezProfileManager1Interface *service = nullptr;
     quint32 serviceRecord;
     QBluetoothAddress currentLocalAdapter;
     QString profilePath;
+    // the record passed to RegisterProfile, kept until the attributes change
+    QString serviceRecordXml() const;
+    QString xmlServiceRecord;
+    quint32 xmlServiceRecordRevision = 0;
 #endif
 
 #ifdef QT_WINRT_BLUETOOTH
@@ -18,6 +18,7 @@
 #endif
 
 #include "qbluetoothservicediscoveryagent.h"
+#include "qbluetoothmemoryusage_p.h"
 
 #include <QtCore/QLoggingCategory>
 #include <QSocketNotifier>
@@ -25,6 +26,7 @@
 QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT)
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_MEMORY)
 
 /*!
     \class QBluetoothSocket
@@ -44,6 +46,9 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT)
     \l {QBluetoothServiceInfo::RfcommProtocol}{RFCOMM} is a reliable, stream-oriented socket. RFCOMM
     sockets emulate an RS-232 serial port.
 
+    L2CAP sockets can also open LE credit based channels to Bluetooth Low Energy
+    devices using connectToLowEnergyChannel().
+
     To create a connection to a Bluetooth service, create a socket of the appropriate type and call
     connectToService() passing the Bluetooth address and port number. QBluetoothSocket will emit
     the connected() signal when the connection is established.
@@ -58,6 +63,12 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT)
     On iOS, this class cannot be used because the platform does not expose
     an API which may permit access to QBluetoothSocket related features.
 
+    On Linux, the environment variable \c QT_BLUETOOTH_SOCKET_READ_THREAD can be
+    set to \c 1 to read sockets on an internal thread. The data is then taken from
+    the kernel while the thread owning the socket is busy, and \l readyRead() is
+    emitted once it has been buffered. This does not apply to sockets connected
+    by service UUID using BlueZ 5.46 or later.
+
     \note On macOS Monterey (12) the socket data flow is paused when a
     modal dialogue is executing, or an event tracking mode is entered (for
     example by long-pressing a Window close button). This may change in the
@@ -99,6 +110,29 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT)
                                                 granted by the user.
 */
 
+/*!
+    \enum QBluetoothSocket::SocketOption
+    \since 6.5
+
+    This enum represents the options that can be set on a socket.
+
+    \value SendBufferSizeSocketOption     Sets the size of the kernel's send buffer
+                                          of the socket in bytes (SO_SNDBUF).
+    \value ReceiveBufferSizeSocketOption  Sets the size of the kernel's receive buffer
+                                          of the socket in bytes (SO_RCVBUF).
+    \value SendMtuSocketOption            The largest packet the remote device accepts on
+                                          an L2CAP channel. This option is read-only and
+                                          only available once the socket is connected.
+    \value ReceiveMtuSocketOption         The largest packet the socket accepts on an LE
+                                          L2CAP channel. It must be set before
+                                          \l connectToLowEnergyChannel() is called.
+    \value ReceiveTimestampSocketOption   Enables the kernel's receive timestamps of the
+                                          socket if set to \c true (SO_TIMESTAMP). See
+                                          \l lastReceiveTimestamp().
+
+    \sa setSocketOption(), socketOption()
+*/
+
 /*!
     \fn void QBluetoothSocket::connected()
 
@@ -420,6 +454,60 @@ void QBluetoothSocket::connectToService(const QBluetoothAddress &address, quint1
     d->connectToService(address, port, openMode);
 }
 
+/*!
+    Attempts to open an LE credit based L2CAP channel, also known as L2CAP
+    connection-oriented channel, to \a address on the given \a psm.
+
+    \a addressType specifies whether \a address is a public or random device
+    address. The socket is opened in the given \a openMode, and its type must be
+    \l {QBluetoothServiceInfo::L2capProtocol}{L2CAP}.
+
+    The socket first enters ConnectingState. Once the remote device accepted the
+    channel, QBluetoothSocket enters ConnectedState and emits connected().
+    Buffered data is sent in packets of the
+    \l {SocketOption::SendMtuSocketOption}{send MTU} of the channel. If the socket
+    is opened with QIODevice::Unbuffered, every \l write() is sent as one packet
+    and must not be larger than the send MTU.
+
+    The receive MTU can be chosen with \l setSocketOption() before calling this
+    function. The flow control credits are managed by the operating system.
+
+    \note Currently this is only supported on Linux with BlueZ. Calling this
+    function on other platforms emits an
+    \l {QBluetoothSocket::SocketError::UnsupportedProtocolError}{UnsupportedProtocolError}.
+
+    \sa QBluetoothServer::listenForLowEnergyChannel(), state()
+    \since 6.5
+*/
+void QBluetoothSocket::connectToLowEnergyChannel(const QBluetoothAddress &address, quint16 psm,
+                                                 QLowEnergyController::RemoteAddressType addressType,
+                                                 OpenMode openMode)
+{
+    if (state() != SocketState::UnconnectedState) {
+        qCWarning(QT_BT) << "QBluetoothSocket::connectToLowEnergyChannel called on busy socket";
+        d_ptr->errorString = tr("Trying to connect while connection is in progress");
+        setSocketError(SocketError::OperationError);
+        return;
+    }
+
+#if QT_CONFIG(bluez)
+    // bluetoothd's profile API, which the D-Bus socket implementation relies
+    // on, does not offer LE channels. They always need the raw socket.
+    if (qobject_cast<QBluetoothSocketPrivateBluezDBus *>(d_ptr)) {
+        QBluetoothSocketBasePrivate *rawSocketPrivate = new QBluetoothSocketPrivateBluez();
+        rawSocketPrivate->q_ptr = this;
+        rawSocketPrivate->secFlags = d_ptr->secFlags;
+        rawSocketPrivate->lowEnergyReceiveMtu = d_ptr->lowEnergyReceiveMtu;
+        rawSocketPrivate->ensureNativeSocket(d_ptr->socketType);
+        delete d_ptr;
+        d_ptr = rawSocketPrivate;
+    }
+#endif
+
+    Q_D(QBluetoothSocketBase);
+    d->connectToLowEnergyChannel(address, psm, addressType, openMode);
+}
+
 /*!
     Returns the socket type. The socket automatically adjusts to the protocol
     offered by the remote service.
@@ -534,6 +622,8 @@ void QBluetoothSocket::setSocketState(QBluetoothSocket::SocketState state)
         return;
 
     d->state = state;
+    if (state == SocketState::ClosingState)
+        qCDebug(QT_BT_MEMORY) << this << memoryUsage();
     if(old != d->state)
         emit stateChanged(state);
     if (state == QBluetoothSocket::SocketState::ConnectedState) {
@@ -751,6 +841,117 @@ void QBluetoothSocket::close()
     d->close();
 }
 
+/*!
+    Sets the given \a option to the value described by \a value.
+
+    The socket must have a native socket descriptor, which is the case after
+    construction with a protocol or once connected. A larger send buffer lets
+    the socket queue more data in the kernel, which helps to keep a link
+    saturated with fewer wake-ups. The exception is
+    \l {SocketOption::ReceiveMtuSocketOption}{ReceiveMtuSocketOption}, which is set
+    on an unconnected socket and used by the next \l connectToLowEnergyChannel().
+
+    \note Currently this is only supported on Linux with BlueZ. On other
+    platforms the call has no effect.
+
+    \sa socketOption()
+    \since 6.5
+*/
+void QBluetoothSocket::setSocketOption(SocketOption option, const QVariant &value)
+{
+    Q_D(QBluetoothSocketBase);
+    d->setSocketOption(option, value);
+}
+
+/*!
+    Returns the value of the \a option option, or an invalid QVariant if the
+    option cannot be queried.
+
+    \note Linux reports twice the buffer sizes set via \l setSocketOption(),
+    as the kernel accounts for its own bookkeeping overhead.
+
+    \sa setSocketOption()
+    \since 6.5
+*/
+QVariant QBluetoothSocket::socketOption(SocketOption option) const
+{
+    Q_D(const QBluetoothSocketBase);
+    return d->socketOption(option);
+}
+
+/*!
+    Returns a snapshot of the traffic counters of this socket.
+
+    The counters are kept from the construction of the socket on and are not
+    reset when it reconnects. They are maintained on every platform; see
+    \l QBluetoothSocketStatistics for the counters not every platform provides.
+
+    \sa QBluetoothSocketStatistics
+    \since 6.5
+*/
+QBluetoothSocketStatistics QBluetoothSocket::statistics() const
+{
+    Q_D(const QBluetoothSocketBase);
+
+    QBluetoothSocketStatistics result;
+    result.d = new QBluetoothSocketStatisticsPrivate(d->statistics);
+    result.d->valid = true;
+    if (d->writeStallTimer.isValid())
+        result.d->writeStallNSecs += d->writeStallTimer.nsecsElapsed();
+    return result;
+}
+
+/*!
+    Returns the approximate memory held by the buffers of this socket.
+
+    The reported structures are the received data which has not been read yet
+    (\c receiveBuffer) and the data which has not been handed to the platform
+    yet (\c sendBuffer). Data buffered by the platform's Bluetooth stack is not
+    included.
+
+    With the \c qt.bluetooth.memory logging category enabled, the memory usage
+    is logged whenever the socket enters the \l {SocketState::}{ClosingState}.
+
+    \sa QBluetoothMemoryUsage
+    \since 6.5
+*/
+QBluetoothMemoryUsage QBluetoothSocket::memoryUsage() const
+{
+    Q_D(const QBluetoothSocketBase);
+
+    QBluetoothMemoryUsage usage;
+    QBluetoothMemoryUsagePrivate::add(&usage, QStringLiteral("receiveBuffer"),
+                                      d->bytesAvailable());
+    QBluetoothMemoryUsagePrivate::add(&usage, QStringLiteral("sendBuffer"), d->bytesToWrite());
+    return usage;
+}
+
+/*!
+    Returns the time at which the kernel received the most recent data that
+    the socket took from it. When called from a slot connected to
+    \l {QIODevice::}{readyRead()}, this is the arrival time of the last data
+    announced by the signal. The difference to the current time is how long
+    the data waited in kernel and application buffers.
+
+    The timestamps must be enabled with
+    \l {SocketOption::ReceiveTimestampSocketOption}{ReceiveTimestampSocketOption}.
+    Otherwise, or if the kernel did not report a time, a default-constructed
+    time point is returned.
+
+    \note Currently this is only supported on Linux with BlueZ for sockets which
+    are not provided by bluetoothd. The kernel reports the timestamps of L2CAP
+    sockets; whether RFCOMM sockets get them depends on the kernel version.
+
+    \sa setSocketOption()
+    \since 6.5
+*/
+std::chrono::system_clock::time_point QBluetoothSocket::lastReceiveTimestamp() const
+{
+    Q_D(const QBluetoothSocketBase);
+    return std::chrono::system_clock::time_point(
+                std::chrono::microseconds(d->receiveTimestamp));
+}
+
 /*!
   Set the socket to use \a socketDescriptor with a type of \a socketType,
   which is in state, \a socketState, and mode, \a openMode.
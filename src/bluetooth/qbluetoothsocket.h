@@ -10,8 +10,14 @@
 #include <QtBluetooth/qbluetoothaddress.h>
 #include <QtBluetooth/qbluetoothuuid.h>
 #include <QtBluetooth/qbluetoothserviceinfo.h>
+#include <QtBluetooth/qbluetoothmemoryusage.h>
+#include <QtBluetooth/qbluetoothsocketstatistics.h>
+#include <QtBluetooth/qlowenergycontroller.h>
 
 #include <QtCore/qiodevice.h>
+#include <QtCore/qvariant.h>
+
+#include <chrono>
 
 QT_BEGIN_NAMESPACE
 
@@ -60,6 +66,15 @@ public:
     };
     Q_ENUM(SocketError)
 
+    enum class SocketOption {
+        SendBufferSizeSocketOption,
+        ReceiveBufferSizeSocketOption,
+        SendMtuSocketOption,
+        ReceiveMtuSocketOption,
+        ReceiveTimestampSocketOption
+    };
+    Q_ENUM(SocketOption)
+
     explicit QBluetoothSocket(QBluetoothServiceInfo::Protocol socketType, QObject *parent = nullptr);   // create socket of type socketType
     explicit QBluetoothSocket(QObject *parent = nullptr);  // create a blank socket
     virtual ~QBluetoothSocket();
@@ -83,6 +98,10 @@ public:
     {
         connectToService(address, QBluetoothUuid(uuid), mode);
     }
+    void connectToLowEnergyChannel(const QBluetoothAddress &address, quint16 psm,
+                                   QLowEnergyController::RemoteAddressType addressType
+                                        = QLowEnergyController::PublicAddress,
+                                   OpenMode openMode = ReadWrite);
     void disconnectFromService();
 
     //bool flush();
@@ -117,6 +136,13 @@ public:
     void setPreferredSecurityFlags(QBluetooth::SecurityFlags flags);
     QBluetooth::SecurityFlags preferredSecurityFlags() const;
 
+    void setSocketOption(SocketOption option, const QVariant &value);
+    QVariant socketOption(SocketOption option) const;
+
+    QBluetoothSocketStatistics statistics() const;
+    QBluetoothMemoryUsage memoryUsage() const;
+    std::chrono::system_clock::time_point lastReceiveTimestamp() const;
+
 Q_SIGNALS:
     void connected();
     void disconnected();
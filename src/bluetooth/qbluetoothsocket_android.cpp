@@ -437,9 +437,10 @@ void QBluetoothSocketPrivateAndroid::socketConnectSuccess(const QJniObject &sock
         return;
     }
 
+    bufferedBytesSeen = 0;
     inputThread = new InputStreamThread(this);
     QObject::connect(inputThread, SIGNAL(dataAvailable()),
-                     q, SIGNAL(readyRead()), Qt::QueuedConnection);
+                     this, SLOT(inputThreadDataAvailable()), Qt::QueuedConnection);
     QObject::connect(inputThread, SIGNAL(errorOccurred(int)), this, SLOT(inputThreadError(int)),
                      Qt::QueuedConnection);
 
@@ -458,6 +459,18 @@ void QBluetoothSocketPrivateAndroid::socketConnectSuccess(const QJniObject &sock
         return;
     }
 
+    if (!startOutputThread()) {
+        // the input thread reports the closure and sets Unconnected
+        inputThread->prepareForClosure();
+        emit closeJavaSocket();
+        socketObject = inputStream = outputStream = remoteDevice = QJniObject();
+        inputThread = 0;
+
+        errorString = QBluetoothSocket::tr("Output stream thread cannot be started");
+        q->setSocketError(QBluetoothSocket::SocketError::NetworkError);
+        return;
+    }
+
     // only unbuffered behavior supported at this stage
     q->setOpenMode(QIODevice::ReadWrite|QIODevice::Unbuffered);
 
@@ -522,6 +535,7 @@ void QBluetoothSocketPrivateAndroid::abort()
 
         if (inputThread)
             inputThread->prepareForClosure();
+        stopOutputThread();
 
         emit closeJavaSocket();
 
@@ -607,33 +621,22 @@ quint16 QBluetoothSocketPrivateAndroid::peerPort() const
 
 qint64 QBluetoothSocketPrivateAndroid::writeData(const char *data, qint64 maxSize)
 {
-    //TODO implement buffered behavior (so far only unbuffered)
     Q_Q(QBluetoothSocket);
-    if (state != QBluetoothSocket::SocketState::ConnectedState || !outputStream.isValid()) {
-        qCWarning(QT_BT_ANDROID) << "Socket::writeData: " << state << outputStream.isValid();
+    if (state != QBluetoothSocket::SocketState::ConnectedState || !outputThread) {
+        qCWarning(QT_BT_ANDROID) << "Socket::writeData: " << state << outputThread;
         errorString = QBluetoothSocket::tr("Cannot write while not connected");
         q->setSocketError(QBluetoothSocket::SocketError::OperationError);
         return -1;
     }
 
-    QJniEnvironment env;
-    jbyteArray nativeData = env->NewByteArray((qint32)maxSize);
-    env->SetByteArrayRegion(nativeData, 0, (qint32)maxSize, reinterpret_cast<const jbyte*>(data));
-    auto methodId = env.findMethod(outputStream.objectClass(),
-                                   "write",
-                                   "([BII)V");
-    if (methodId)
-        env->CallVoidMethod(outputStream.object(), methodId, nativeData, 0, (qint32)maxSize);
-    env->DeleteLocalRef(nativeData);
-
-    if (!methodId || env.checkAndClearExceptions()) {
+    // the output thread sends the data, bytesWritten() follows once it did
+    if (outputThread->writeData(data, maxSize) < 0) {
         qCWarning(QT_BT_ANDROID) << "Error while writing";
         errorString = QBluetoothSocket::tr("Error during write on socket.");
         q->setSocketError(QBluetoothSocket::SocketError::NetworkError);
         return -1;
     }
 
-    emit q->bytesWritten(maxSize);
     return maxSize;
 }
 
@@ -647,7 +650,20 @@ qint64 QBluetoothSocketPrivateAndroid::readData(char *data, qint64 maxSize)
         return -1;
     }
 
-    return inputThread->readData(data, maxSize);
+    const qint64 bytesRead = inputThread->readData(data, maxSize);
+    recordConsumed(bytesRead);
+    return bytesRead;
+}
+
+void QBluetoothSocketPrivateAndroid::inputThreadDataAvailable()
+{
+    Q_Q(QBluetoothSocket);
+
+    // the Java thread fills the receive buffer, count what it added since last time
+    if (inputThread)
+        recordBuffered(inputThread->bytesAvailable());
+    recordReadyRead();
+    emit q->readyRead();
 }
 
 void QBluetoothSocketPrivateAndroid::inputThreadError(int errorCode)
@@ -669,6 +685,7 @@ void QBluetoothSocketPrivateAndroid::inputThreadError(int errorCode)
         //cleanup internal objects
         //if it was call to local close()/abort() the objects are cleaned up already
 
+        stopOutputThread();
         emit closeJavaSocket();
 
         inputStream = outputStream = remoteDevice = socketObject = QJniObject();
@@ -683,6 +700,67 @@ void QBluetoothSocketPrivateAndroid::inputThreadError(int errorCode)
     emit q->readChannelFinished();
 }
 
+void QBluetoothSocketPrivateAndroid::outputThreadBytesWritten(qint64 bytes)
+{
+    Q_Q(QBluetoothSocket);
+
+    recordSent(bytes);
+    emit q->bytesWritten(bytes);
+}
+
+void QBluetoothSocketPrivateAndroid::outputThreadError(int errorCode)
+{
+    Q_Q(QBluetoothSocket);
+
+    // the Java thread has ended, nothing calls into the object anymore
+    OutputStreamThread *client = qobject_cast<OutputStreamThread *>(sender());
+    if (client)
+        client->deleteLater();
+    if (client != outputThread)
+        return; // stopped by close() or a previous connection
+
+    outputThread = nullptr;
+    if (errorCode != -1) {
+        qCWarning(QT_BT_ANDROID) << "Error while writing";
+        errorString = QBluetoothSocket::tr("Error during write on socket.");
+        q->setSocketError(QBluetoothSocket::SocketError::NetworkError);
+    }
+    // the input thread reports the closure
+    abort();
+}
+
+bool QBluetoothSocketPrivateAndroid::startOutputThread()
+{
+    stopOutputThread();
+
+    outputThread = new OutputStreamThread(this);
+    QObject::connect(outputThread, &OutputStreamThread::bytesWritten,
+                     this, &QBluetoothSocketPrivateAndroid::outputThreadBytesWritten,
+                     Qt::QueuedConnection);
+    QObject::connect(outputThread, &OutputStreamThread::errorOccurred,
+                     this, &QBluetoothSocketPrivateAndroid::outputThreadError,
+                     Qt::QueuedConnection);
+    if (!outputThread->run()) {
+        delete outputThread;
+        outputThread = nullptr;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * The Java thread ends asynchronously, the object deletes itself in
+ * outputThreadError() once it did.
+ */
+void QBluetoothSocketPrivateAndroid::stopOutputThread()
+{
+    if (!outputThread)
+        return;
+
+    outputThread->prepareForClosure();
+    outputThread = nullptr;
+}
+
 void QBluetoothSocketPrivateAndroid::close()
 {
     /* This function is called by QBluetoothSocket::close and softer version
@@ -739,12 +817,15 @@ bool QBluetoothSocketPrivateAndroid::setSocketDescriptor(const QJniObject &socke
         inputThread->deleteLater();
         inputThread = 0;
     }
+    bufferedBytesSeen = 0;
     inputThread = new InputStreamThread(this);
     QObject::connect(inputThread, SIGNAL(dataAvailable()),
-                     q, SIGNAL(readyRead()), Qt::QueuedConnection);
+                     this, SLOT(inputThreadDataAvailable()), Qt::QueuedConnection);
     QObject::connect(inputThread, SIGNAL(errorOccurred(int)), this, SLOT(inputThreadError(int)),
                      Qt::QueuedConnection);
     inputThread->run();
+    if (!startOutputThread())
+        qCWarning(QT_BT_ANDROID) << "Output stream thread cannot be started";
 
     // WorkerThread manages all sockets for us
     // When we come through here the socket was already connected by
@@ -771,7 +852,8 @@ qint64 QBluetoothSocketPrivateAndroid::bytesAvailable() const
 
 qint64 QBluetoothSocketPrivateAndroid::bytesToWrite() const
 {
-    return 0; // nothing because always unbuffered
+    // queued for the output thread
+    return outputThread ? outputThread->bytesToWrite() : 0;
 }
 
 /*
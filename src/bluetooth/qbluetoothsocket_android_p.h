@@ -20,7 +20,9 @@
 
 #include <QtCore/QJniObject>
 #include <QtCore/QPointer>
+#include "android/androidutils_p.h"
 #include "android/inputstreamthread_p.h"
+#include "android/outputstreamthread_p.h"
 #include <jni.h>
 
 QT_BEGIN_NAMESPACE
@@ -76,6 +78,8 @@ public:
     qint64 bytesToWrite() const override;
 
     static QBluetoothUuid reverseUuid(const QBluetoothUuid &serviceUuid);
+    bool startOutputThread();
+    void stopOutputThread();
 
     QJniObject adapter;
     QJniObject socketObject;
@@ -83,6 +87,7 @@ public:
     QJniObject inputStream;
     QJniObject outputStream;
     InputStreamThread *inputThread;
+    OutputStreamThread *outputThread = nullptr;
 
 public slots:
     void socketConnectSuccess(const QJniObject &socket);
@@ -92,6 +97,9 @@ public slots:
     void fallbackSocketConnectFailed(const QJniObject &socket,
                                      const QJniObject &targetUuid);
     void inputThreadError(int errorCode);
+    void inputThreadDataAvailable();
+    void outputThreadError(int errorCode);
+    void outputThreadBytesWritten(qint64 bytes);
 
 signals:
     void connectJavaSocket();
@@ -8,15 +8,19 @@
 #include "bluez/objectmanager_p.h"
 #include <QtBluetooth/QBluetoothLocalDevice>
 #include "bluez/bluez_data_p.h"
+#include "bluez/socketreader_p.h"
 
 #include <qplatformdefs.h>
 #include <QtCore/private/qcore_unix_p.h>
+#include <QtCore/private/qiodevice_p.h>
 
 #include <QtCore/QLoggingCategory>
 
 #include <errno.h>
 #include <unistd.h>
 #include <string.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
 
 #include <QtCore/QSocketNotifier>
 
@@ -24,6 +28,11 @@ QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
 
+// bytes taken from the socket per read notification before yielding to the event loop
+static constexpr qint64 maxReadPerNotification = 16 * QPRIVATELINEARBUFFER_BUFFERSIZE;
+// buffer chunks passed to a single writev()
+static constexpr int maxWriteVectors = 16;
+
 QBluetoothSocketPrivateBluez::QBluetoothSocketPrivateBluez()
     : QBluetoothSocketBasePrivate()
 {
@@ -32,6 +41,7 @@ QBluetoothSocketPrivateBluez::QBluetoothSocketPrivateBluez()
 
 QBluetoothSocketPrivateBluez::~QBluetoothSocketPrivateBluez()
 {
+    stopReader();
     delete readNotifier;
     readNotifier = nullptr;
     delete connectWriteNotifier;
@@ -48,6 +58,7 @@ bool QBluetoothSocketPrivateBluez::ensureNativeSocket(QBluetoothServiceInfo::Pro
         if (socketType == type)
             return true;
 
+        stopReader();
         delete readNotifier;
         readNotifier = nullptr;
         delete connectWriteNotifier;
@@ -70,18 +81,22 @@ bool QBluetoothSocketPrivateBluez::ensureNativeSocket(QBluetoothServiceInfo::Pro
 
     if (socket == -1)
         return false;
+    receiveTimestamps = false;
 
     int flags = fcntl(socket, F_GETFL, 0);
     fcntl(socket, F_SETFL, flags | O_NONBLOCK);
 
     Q_Q(QBluetoothSocket);
-    readNotifier = new QSocketNotifier(socket, QSocketNotifier::Read);
-    QObject::connect(readNotifier, SIGNAL(activated(QSocketDescriptor)), this, SLOT(_q_readNotify()));
+    // with the read thread, reading starts once connected
+    if (!QtBluezSocketReader::isEnabled()) {
+        readNotifier = new QSocketNotifier(socket, QSocketNotifier::Read);
+        QObject::connect(readNotifier, SIGNAL(activated(QSocketDescriptor)), this, SLOT(_q_readNotify()));
+        readNotifier->setEnabled(false);
+    }
     connectWriteNotifier = new QSocketNotifier(socket, QSocketNotifier::Write, q);
     QObject::connect(connectWriteNotifier, SIGNAL(activated(QSocketDescriptor)), this, SLOT(_q_writeNotify()));
 
     connectWriteNotifier->setEnabled(false);
-    readNotifier->setEnabled(false);
 
 
     return true;
@@ -129,7 +144,8 @@ void QBluetoothSocketPrivateBluez::connectToServiceHelper(const QBluetoothAddres
         convertAddress(address.toUInt64(), addr.rc_bdaddr.b);
 
         connectWriteNotifier->setEnabled(true);
-        readNotifier->setEnabled(true);
+        if (readNotifier)
+            readNotifier->setEnabled(true);
 
         result = ::connect(socket, (sockaddr *)&addr, sizeof(addr));
     } else if (socketType == QBluetoothServiceInfo::L2capProtocol) {
@@ -149,6 +165,9 @@ void QBluetoothSocketPrivateBluez::connectToServiceHelper(const QBluetoothAddres
             addr.l2_bdaddr_type = lowEnergySocketType;
         } else {
             addr.l2_psm = htobs(port);
+            // an LE address type turns the channel into an LE credit based one
+            if (lowEnergyChannelAddressType)
+                addr.l2_bdaddr_type = lowEnergyChannelAddressType;
         }
 #else
         addr.l2_psm = htobs(port);
@@ -157,7 +176,8 @@ void QBluetoothSocketPrivateBluez::connectToServiceHelper(const QBluetoothAddres
         convertAddress(address.toUInt64(), addr.l2_bdaddr.b);
 
         connectWriteNotifier->setEnabled(true);
-        readNotifier->setEnabled(true);
+        if (readNotifier)
+            readNotifier->setEnabled(true);
 
         result = ::connect(socket, (sockaddr *)&addr, sizeof(addr));
     }
@@ -172,6 +192,104 @@ void QBluetoothSocketPrivateBluez::connectToServiceHelper(const QBluetoothAddres
     }
 }
 
+void QBluetoothSocketPrivateBluez::connectToLowEnergyChannel(
+        const QBluetoothAddress &address, quint16 psm,
+        QLowEnergyController::RemoteAddressType addressType, QIODevice::OpenMode openMode)
+{
+    Q_Q(QBluetoothSocket);
+
+    if (q->state() != QBluetoothSocket::SocketState::UnconnectedState) {
+        qCWarning(QT_BT_BLUEZ) << "QBluetoothSocketPrivateBluez::connectToLowEnergyChannel called on busy socket";
+        errorString = QBluetoothSocket::tr("Trying to connect while connection is in progress");
+        q->setSocketError(QBluetoothSocket::SocketError::OperationError);
+        return;
+    }
+
+    if (socketType != QBluetoothServiceInfo::L2capProtocol) {
+        qCWarning(QT_BT_BLUEZ) << "LE channels require an L2CAP socket";
+        errorString = QBluetoothSocket::tr("Socket type not supported");
+        q->setSocketError(QBluetoothSocket::SocketError::UnsupportedProtocolError);
+        return;
+    }
+
+    if (socket == -1 && !ensureNativeSocket(socketType)) {
+        errorString = QBluetoothSocket::tr("Unknown socket error");
+        q->setSocketError(QBluetoothSocket::SocketError::UnknownSocketError);
+        return;
+    }
+
+    // The kernel accepts the receive MTU only on sockets bound to an LE address type.
+    // The credits are derived from it, there is no interface to choose them.
+    sockaddr_l2 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.l2_family = AF_BLUETOOTH;
+    addr.l2_bdaddr_type = BDADDR_LE_PUBLIC;
+    if (::bind(socket, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot bind LE channel socket" << qt_error_string(errno);
+        errorString = qt_error_string(errno);
+        q->setSocketError(QBluetoothSocket::SocketError::UnknownSocketError);
+        return;
+    }
+
+    if (lowEnergyReceiveMtu
+            && ::setsockopt(socket, SOL_BLUETOOTH, BT_RCVMTU, &lowEnergyReceiveMtu,
+                            sizeof(lowEnergyReceiveMtu)) < 0) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot set receive MTU" << lowEnergyReceiveMtu
+                               << qt_error_string(errno);
+    }
+
+    lowEnergyChannelAddressType = addressType == QLowEnergyController::RandomAddress
+            ? BDADDR_LE_RANDOM : BDADDR_LE_PUBLIC;
+    connectToServiceHelper(address, psm, openMode);
+    lowEnergyChannelAddressType = 0;
+}
+
+/*
+ * With QT_BLUETOOTH_SOCKET_READ_THREAD set, a connected socket is read on a
+ * shared worker thread, so that a busy event loop of the owning thread does not
+ * delay taking the data from the kernel. Sockets asking for a dedicated reader
+ * get a thread of their own.
+ */
+void QBluetoothSocketPrivateBluez::startReader()
+{
+    if (reader || (!QtBluezSocketReader::isEnabled() && !readerOptions.dedicatedThread))
+        return;
+
+    reader = new QtBluezSocketReader(socket, readerOptions);
+    reader->setTimestampsEnabled(receiveTimestamps);
+    connect(reader, &QtBluezSocketReader::dataAvailable,
+            this, &QBluetoothSocketPrivateBluez::_q_readQueued, Qt::QueuedConnection);
+    reader->start();
+}
+
+// must be called before the socket descriptor is closed or replaced
+void QBluetoothSocketPrivateBluez::stopReader()
+{
+    if (!reader)
+        return;
+
+    reader->stop();
+    reader->deleteLater();
+    reader = nullptr;
+}
+
+/*
+ * LE credit based channels announce the largest packet the peer accepts, fill
+ * them up to that. Classic L2CAP sockets do not report it and keep packets as
+ * small as they always were.
+ */
+void QBluetoothSocketPrivateBluez::updateL2capPacketSize()
+{
+    l2capPacketSize = 1024;
+    if (socketType != QBluetoothServiceInfo::L2capProtocol || lowEnergySocketType)
+        return;
+
+    quint16 sendMtu = 0;
+    socklen_t length = sizeof(sendMtu);
+    if (::getsockopt(socket, SOL_BLUETOOTH, BT_SNDMTU, &sendMtu, &length) == 0 && sendMtu > 0)
+        l2capPacketSize = sendMtu;
+}
+
 void QBluetoothSocketPrivateBluez::connectToService(
         const QBluetoothServiceInfo &service, QIODevice::OpenMode openMode)
 {
@@ -289,6 +407,8 @@ void QBluetoothSocketPrivateBluez::_q_writeNotify()
             return;
         }
 
+        updateL2capPacketSize();
+        startReader();
         q->setSocketState(QBluetoothSocket::SocketState::ConnectedState);
 
         connectWriteNotifier->setEnabled(false);
@@ -300,14 +420,29 @@ void QBluetoothSocketPrivateBluez::_q_writeNotify()
             return;
         }
 
-        char buf[1024];
-
-        const auto size = txBuffer.read(buf, 1024);
-        const auto writtenBytes = qt_safe_write(socket, buf, size);
+        // write straight from the buffer, whatever is not taken stays in place
+        qint64 writtenBytes;
+        if (socketType == QBluetoothServiceInfo::RfcommProtocol) {
+            // a stream, hand the socket as much of the backlog as it takes in one call
+            iovec vectors[maxWriteVectors];
+            int count = 0;
+            for (qint64 pos = 0; count < maxWriteVectors && pos < txBuffer.size(); ++count) {
+                qint64 length = 0;
+                vectors[count].iov_base = const_cast<char *>(
+                            txBuffer.readPointerAtPosition(pos, length));
+                vectors[count].iov_len = size_t(length);
+                pos += length;
+            }
+            writtenBytes = qt_safe_writev(socket, vectors, count);
+        } else {
+            // every write is a packet, never larger than the channel accepts
+            const auto size = qMin<qint64>(txBuffer.nextDataBlockSize(), l2capPacketSize);
+            writtenBytes = qt_safe_write(socket, txBuffer.readPointer(), size);
+        }
         if (writtenBytes < 0) {
             switch (errno) {
             case EAGAIN:
-                txBuffer.ungetBlock(buf, size);
+                recordWriteStalled();
                 break;
             default:
                 // every other case returns error
@@ -315,14 +450,10 @@ void QBluetoothSocketPrivateBluez::_q_writeNotify()
                 q->setSocketError(QBluetoothSocket::SocketError::NetworkError);
                 break;
             }
-        } else {
-            if (writtenBytes < size) {
-                // add remainder back to buffer
-                char* remainder = buf + writtenBytes;
-                txBuffer.ungetBlock(remainder, size - writtenBytes);
-            }
-            if (writtenBytes > 0)
-                emit q->bytesWritten(writtenBytes);
+        } else if (writtenBytes > 0) {
+            txBuffer.free(writtenBytes);
+            recordSent(writtenBytes);
+            emit q->bytesWritten(writtenBytes);
         }
 
         if (txBuffer.size()) {
@@ -338,32 +469,110 @@ void QBluetoothSocketPrivateBluez::_q_writeNotify()
 void QBluetoothSocketPrivateBluez::_q_readNotify()
 {
     Q_Q(QBluetoothSocket);
-    char *writePointer = rxBuffer.reserve(QPRIVATELINEARBUFFER_BUFFERSIZE);
-//    qint64 readFromDevice = q->readData(writePointer, QPRIVATELINEARBUFFER_BUFFERSIZE);
-    const auto readFromDevice = ::read(socket, writePointer, QPRIVATELINEARBUFFER_BUFFERSIZE);
-    rxBuffer.chop(QPRIVATELINEARBUFFER_BUFFERSIZE - (readFromDevice < 0 ? 0 : readFromDevice));
-    if(readFromDevice <= 0){
-        int errsv = errno;
-        readNotifier->setEnabled(false);
-        connectWriteNotifier->setEnabled(false);
-        errorString = qt_error_string(errsv);
-        qCWarning(QT_BT_BLUEZ) << Q_FUNC_INFO << socket << "error:" << readFromDevice << errorString;
-        if (errsv == EHOSTDOWN)
-            q->setSocketError(QBluetoothSocket::SocketError::HostNotFoundError);
-        else if (errsv == ECONNRESET)
-            q->setSocketError(QBluetoothSocket::SocketError::RemoteHostClosedError);
-        else
-            q->setSocketError(QBluetoothSocket::SocketError::UnknownSocketError);
 
-        q->disconnectFromService();
+    // Drain what the kernel has queued rather than taking one chunk per notification.
+    // FIONREAD reports the size of the next queued packet, which also keeps L2CAP
+    // packets larger than the default chunk in one piece. The readers of an L2CAP
+    // socket expect one packet per readyRead(), the notifier fires again for the next.
+    const bool packetBased = socketType == QBluetoothServiceInfo::L2capProtocol;
+    qint64 readTotal = 0;
+    ssize_t readFromDevice = 0;
+    for (;;) {
+        int available = 0;
+        if (::ioctl(socket, FIONREAD, &available) < 0)
+            available = 0;
+        if (readTotal > 0 && (available <= 0 || readTotal >= maxReadPerNotification))
+            break;
+
+        const qint64 chunkSize = qMax<qint64>(available, QPRIVATELINEARBUFFER_BUFFERSIZE);
+        char *writePointer = rxBuffer.reserve(chunkSize);
+        qint64 timestamp = 0;
+        readFromDevice = qt_bluezReadWithTimestamp(socket, writePointer, chunkSize,
+                                                   receiveTimestamps ? &timestamp : nullptr);
+        rxBuffer.chop(chunkSize - (readFromDevice < 0 ? 0 : readFromDevice));
+        if (readFromDevice <= 0)
+            break;
+        readTotal += readFromDevice;
+        if (timestamp)
+            receiveTimestamp = timestamp;
+        if (packetBased)
+            break;
     }
-    else {
+
+    if (readTotal > 0) {
+        recordReceived(readTotal);
+        recordReadyRead();
+        // a subsequent error is reported by the next notification
         emit q->readyRead();
+        return;
     }
+
+    readFailed(errno);
+}
+
+/*
+ * Takes the data queued by the read thread. Like _q_readNotify(), it reports
+ * an error only once all data received before it has been announced, and an
+ * L2CAP socket announces one packet per call.
+ */
+void QBluetoothSocketPrivateBluez::_q_readQueued()
+{
+    Q_Q(QBluetoothSocket);
+
+    if (!reader)
+        return;
+
+    reader->acknowledge();
+    const bool packetBased = socketType == QBluetoothServiceInfo::L2capProtocol;
+    qint64 readTotal = 0;
+    QByteArray chunk;
+    qint64 timestamp = 0;
+    while (reader->takeChunk(&chunk, &timestamp)) {
+        readTotal += chunk.size();
+        rxBuffer.append(std::move(chunk));
+        if (timestamp)
+            receiveTimestamp = timestamp;
+        if (packetBased)
+            break;
+    }
+    reader->resumeIfStalled();
+
+    if (readTotal > 0) {
+        recordReceived(readTotal);
+        recordReadyRead();
+        // the following packets or the error are taken by the next call
+        if (packetBased || reader->hasFinished())
+            QMetaObject::invokeMethod(this, "_q_readQueued", Qt::QueuedConnection);
+        emit q->readyRead();
+        return;
+    }
+
+    if (reader->hasFinished())
+        readFailed(reader->error());
+}
+
+void QBluetoothSocketPrivateBluez::readFailed(int errsv)
+{
+    Q_Q(QBluetoothSocket);
+
+    if (readNotifier)
+        readNotifier->setEnabled(false);
+    connectWriteNotifier->setEnabled(false);
+    errorString = qt_error_string(errsv);
+    qCWarning(QT_BT_BLUEZ) << Q_FUNC_INFO << socket << "error:" << errorString;
+    if (errsv == EHOSTDOWN)
+        q->setSocketError(QBluetoothSocket::SocketError::HostNotFoundError);
+    else if (errsv == ECONNRESET)
+        q->setSocketError(QBluetoothSocket::SocketError::RemoteHostClosedError);
+    else
+        q->setSocketError(QBluetoothSocket::SocketError::UnknownSocketError);
+
+    q->disconnectFromService();
 }
 
 void QBluetoothSocketPrivateBluez::abort()
 {
+    stopReader();
     delete readNotifier;
     readNotifier = nullptr;
     delete connectWriteNotifier;
@@ -459,14 +668,12 @@ QString QBluetoothSocketPrivateBluez::peerName() const
     const QString localAdapter = localAddress().toString();
 
     initializeBluez5();
-    OrgFreedesktopDBusObjectManagerInterface manager(
-            QStringLiteral("org.bluez"), QStringLiteral("/"), QDBusConnection::systemBus());
-    QDBusPendingReply<ManagedObjectList> reply = manager.GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError())
+    QDBusError error;
+    const ManagedObjectList managedObjectList =
+            QtBluezObjectCache::instance()->managedObjects(&error);
+    if (error.isValid())
         return QString();
 
-    ManagedObjectList managedObjectList = reply.value();
     for (ManagedObjectList::const_iterator it = managedObjectList.constBegin();
          it != managedObjectList.constEnd(); ++it) {
         const InterfaceList &ifaceList = it.value();
@@ -538,6 +745,7 @@ qint64 QBluetoothSocketPrivateBluez::writeData(const char *data, qint64 maxSize)
         if (sz < 0) {
             switch (errno) {
             case EAGAIN:
+                recordWriteStalled();
                 sz = 0;
                 break;
             default:
@@ -546,8 +754,10 @@ qint64 QBluetoothSocketPrivateBluez::writeData(const char *data, qint64 maxSize)
             }
         }
 
-        if (sz > 0)
+        if (sz > 0) {
+            recordSent(sz);
             emit q->bytesWritten(sz);
+        }
 
         return sz;
     }
@@ -561,8 +771,15 @@ qint64 QBluetoothSocketPrivateBluez::writeData(const char *data, qint64 maxSize)
             QMetaObject::invokeMethod(this, "_q_writeNotify", Qt::QueuedConnection);
         }
 
-        char *txbuf = txBuffer.reserve(maxSize);
-        memcpy(txbuf, data, maxSize);
+        // QIODevice::write(QByteArray) passes large arrays on, share them instead of copying
+        const QIODevicePrivate *device = static_cast<QIODevicePrivate *>(QObjectPrivate::get(q));
+        if (device->isWriteChunkCached(data, maxSize)) {
+            txBuffer.append(*device->currentWriteChunk);
+        } else {
+            char *txbuf = txBuffer.reserve(maxSize);
+            memcpy(txbuf, data, maxSize);
+        }
+        recordWriteBuffered(txBuffer.size());
 
         return maxSize;
     }
@@ -598,6 +815,7 @@ bool QBluetoothSocketPrivateBluez::setSocketDescriptor(int socketDescriptor, QBl
                                            QBluetoothSocket::SocketState socketState, QBluetoothSocket::OpenMode openMode)
 {
     Q_Q(QBluetoothSocket);
+    stopReader();
     delete readNotifier;
     readNotifier = nullptr;
     delete connectWriteNotifier;
@@ -614,17 +832,131 @@ bool QBluetoothSocketPrivateBluez::setSocketDescriptor(int socketDescriptor, QBl
     if (!(flags & O_NONBLOCK))
         fcntl(socket, F_SETFL, flags | O_NONBLOCK);
 
-    readNotifier = new QSocketNotifier(socket, QSocketNotifier::Read);
-    QObject::connect(readNotifier, SIGNAL(activated(QSocketDescriptor)), this, SLOT(_q_readNotify()));
+    // accepted sockets inherit the option from the listening socket
+    receiveTimestamps = qt_bluezSocketOption(
+                socket, QBluetoothSocket::SocketOption::ReceiveTimestampSocketOption).toBool();
+
+    if (QtBluezSocketReader::isEnabled()) {
+        startReader();
+    } else {
+        readNotifier = new QSocketNotifier(socket, QSocketNotifier::Read);
+        QObject::connect(readNotifier, SIGNAL(activated(QSocketDescriptor)), this, SLOT(_q_readNotify()));
+    }
     connectWriteNotifier = new QSocketNotifier(socket, QSocketNotifier::Write, q);
     QObject::connect(connectWriteNotifier, SIGNAL(activated(QSocketDescriptor)), this, SLOT(_q_writeNotify()));
 
+    if (socketState == QBluetoothSocket::SocketState::ConnectedState)
+        updateL2capPacketSize();
+
     q->setOpenMode(openMode);
     q->setSocketState(socketState);
 
     return true;
 }
 
+struct SocketOptionName
+{
+    int level;
+    int name;
+    // the MTU options are 16 bit values, the buffer sizes are ints
+    bool isMtu;
+};
+
+static SocketOptionName socketOptionName(QBluetoothSocket::SocketOption option)
+{
+    switch (option) {
+    case QBluetoothSocket::SocketOption::SendBufferSizeSocketOption:
+        return { SOL_SOCKET, SO_SNDBUF, false };
+    case QBluetoothSocket::SocketOption::ReceiveBufferSizeSocketOption:
+        return { SOL_SOCKET, SO_RCVBUF, false };
+    case QBluetoothSocket::SocketOption::SendMtuSocketOption:
+        return { SOL_BLUETOOTH, BT_SNDMTU, true };
+    case QBluetoothSocket::SocketOption::ReceiveMtuSocketOption:
+        return { SOL_BLUETOOTH, BT_RCVMTU, true };
+    case QBluetoothSocket::SocketOption::ReceiveTimestampSocketOption:
+        return { SOL_SOCKET, SO_TIMESTAMP, false };
+    }
+    return { -1, -1, false };
+}
+
+/*
+ * Sets the socket level \a option of the RFCOMM or L2CAP socket \a fd.
+ * Shared by the socket implementations of both BlueZ backends.
+ */
+bool qt_setBluezSocketOption(int fd, QBluetoothSocket::SocketOption option, const QVariant &value)
+{
+    const SocketOptionName name = socketOptionName(option);
+    if (fd == -1 || name.name == -1
+            || option == QBluetoothSocket::SocketOption::SendMtuSocketOption) {
+        return false;
+    }
+
+    int result;
+    if (name.isMtu) {
+        const quint16 optionValue = quint16(value.toUInt());
+        result = ::setsockopt(fd, name.level, name.name, &optionValue, sizeof(optionValue));
+    } else {
+        const int optionValue = value.toInt();
+        result = ::setsockopt(fd, name.level, name.name, &optionValue, sizeof(optionValue));
+    }
+    if (result < 0) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot set socket option" << option << value
+                               << qt_error_string(errno);
+        return false;
+    }
+    return true;
+}
+
+QVariant qt_bluezSocketOption(int fd, QBluetoothSocket::SocketOption option)
+{
+    const SocketOptionName name = socketOptionName(option);
+    if (fd == -1 || name.name == -1)
+        return QVariant();
+
+    if (name.isMtu) {
+        quint16 optionValue = 0;
+        socklen_t length = sizeof(optionValue);
+        if (::getsockopt(fd, name.level, name.name, &optionValue, &length) < 0)
+            return QVariant();
+        return optionValue;
+    }
+
+    int optionValue = 0;
+    socklen_t length = sizeof(optionValue);
+    if (::getsockopt(fd, name.level, name.name, &optionValue, &length) < 0)
+        return QVariant();
+    return optionValue;
+}
+
+bool QBluetoothSocketPrivateBluez::setSocketOption(QBluetoothSocket::SocketOption option,
+                                                   const QVariant &value)
+{
+    // the receive MTU of an LE channel can only be applied once the socket is bound
+    if (option == QBluetoothSocket::SocketOption::ReceiveMtuSocketOption
+            && state == QBluetoothSocket::SocketState::UnconnectedState) {
+        lowEnergyReceiveMtu = quint16(value.toUInt());
+        return true;
+    }
+    if (!qt_setBluezSocketOption(socket, option, value))
+        return false;
+
+    if (option == QBluetoothSocket::SocketOption::ReceiveTimestampSocketOption) {
+        receiveTimestamps = value.toBool();
+        if (reader)
+            reader->setTimestampsEnabled(receiveTimestamps);
+    }
+    return true;
+}
+
+QVariant QBluetoothSocketPrivateBluez::socketOption(QBluetoothSocket::SocketOption option) const
+{
+    if (option == QBluetoothSocket::SocketOption::ReceiveMtuSocketOption
+            && state == QBluetoothSocket::SocketState::UnconnectedState) {
+        return lowEnergyReceiveMtu ? QVariant(lowEnergyReceiveMtu) : QVariant();
+    }
+    return qt_bluezSocketOption(socket, option);
+}
+
 qint64 QBluetoothSocketPrivateBluez::bytesAvailable() const
 {
     return rxBuffer.size();
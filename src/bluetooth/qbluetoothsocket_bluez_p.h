@@ -16,10 +16,11 @@
 //
 
 #include "qbluetoothsocketbase_p.h"
+#include "bluez/socketreader_p.h"
 
 QT_BEGIN_NAMESPACE
 
-class QBluetoothSocketPrivateBluez final: public QBluetoothSocketBasePrivate
+class Q_AUTOTEST_EXPORT QBluetoothSocketPrivateBluez final: public QBluetoothSocketBasePrivate
 {
     Q_OBJECT
 
@@ -37,6 +38,9 @@ public:
                           QIODevice::OpenMode openMode) override;
     void connectToService(const QBluetoothAddress &address, quint16 port,
                           QIODevice::OpenMode openMode) override;
+    void connectToLowEnergyChannel(const QBluetoothAddress &address, quint16 psm,
+                                   QLowEnergyController::RemoteAddressType addressType,
+                                   QIODevice::OpenMode openMode) override;
 
     bool ensureNativeSocket(QBluetoothServiceInfo::Protocol type) override;
 
@@ -62,11 +66,38 @@ public:
     bool canReadLine() const override;
     qint64 bytesToWrite() const override;
 
+    bool setSocketOption(QBluetoothSocket::SocketOption option, const QVariant &value) override;
+    QVariant socketOption(QBluetoothSocket::SocketOption option) const override;
+
+    // Takes effect when the socket connects, a dedicated reader is used regardless
+    // of QT_BLUETOOTH_SOCKET_READ_THREAD.
+    void setReaderOptions(const QtBluezSocketReader::Options &options) { readerOptions = options; }
+
 private slots:
     void _q_readNotify();
+    void _q_readQueued();
     void _q_writeNotify();
+
+private:
+    void readFailed(int errsv);
+    void startReader();
+    void stopReader();
+    void updateL2capPacketSize();
+
+    QtBluezSocketReader *reader = nullptr;
+    QtBluezSocketReader::Options readerOptions;
+    // SO_TIMESTAMP is set on the socket, the reads take the receive time
+    bool receiveTimestamps = false;
+
+    // largest packet written to an L2CAP socket in buffered mode
+    qint64 l2capPacketSize = 1024;
+    // BDADDR_LE_PUBLIC or BDADDR_LE_RANDOM while an LE channel is being connected
+    quint8 lowEnergyChannelAddressType = 0;
 };
 
+bool qt_setBluezSocketOption(int fd, QBluetoothSocket::SocketOption option, const QVariant &value);
+QVariant qt_bluezSocketOption(int fd, QBluetoothSocket::SocketOption option);
+
 QT_END_NAMESPACE
 
 #endif // QBLUETOOTHSOCKET_BLUEZ_H
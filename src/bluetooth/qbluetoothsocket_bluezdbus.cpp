@@ -3,21 +3,19 @@
 
 #include "qbluetoothsocket.h"
 #include "qbluetoothsocket_bluezdbus_p.h"
+#include "qbluetoothsocket_bluez_p.h"
 
 #include "bluez/bluez_data_p.h"
 #include "bluez/bluez5_helper_p.h"
 #include "bluez/adapter1_bluez5_p.h"
 #include "bluez/device1_bluez5_p.h"
+#include "bluez/clientprofile_p.h"
 #include "bluez/objectmanager_p.h"
-#include "bluez/profile1_p.h"
-#include "bluez/profile1context_p.h"
-#include "bluez/profilemanager1_p.h"
 
 #include <QtBluetooth/qbluetoothdeviceinfo.h>
 #include <QtBluetooth/qbluetoothserviceinfo.h>
 
 #include <QtCore/qloggingcategory.h>
-#include <QtCore/qrandom.h>
 
 #include <QtNetwork/qlocalsocket.h>
 
@@ -27,21 +25,15 @@ QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
 
-static const QLatin1String profilePathTemplate("/qt/btsocket/%1%2/%3");
-
 QBluetoothSocketPrivateBluezDBus::QBluetoothSocketPrivateBluezDBus()
 {
     secFlags = QBluetooth::Security::NoSecurity;
-
-    profileManager = new OrgBluezProfileManager1Interface(
-                            QStringLiteral("org.bluez"),
-                            QStringLiteral("/org/bluez"),
-                            QDBusConnection::systemBus(),
-                            this);
 }
 
 QBluetoothSocketPrivateBluezDBus::~QBluetoothSocketPrivateBluezDBus()
 {
+    if (clientProfile)
+        clientProfile->release(this);
 }
 
 bool QBluetoothSocketPrivateBluezDBus::ensureNativeSocket(QBluetoothServiceInfo::Protocol type)
@@ -70,49 +62,12 @@ void QBluetoothSocketPrivateBluezDBus::connectToServiceHelper(
 
 static QString findRemoteDevicePath(const QBluetoothAddress &address)
 {
-    OrgFreedesktopDBusObjectManagerInterface manager(QStringLiteral("org.bluez"),
-                                                     QStringLiteral("/"),
-                                                     QDBusConnection::systemBus());
-
     bool ok = false;
     const QString adapterPath = findAdapterForAddress(QBluetoothAddress(), &ok);
     if (!ok)
         return QString();
 
-    auto reply = manager.GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError())
-        return QString();
-
-    QString remoteDevicePath;
-
-    ManagedObjectList objectList = reply.value();
-    for (ManagedObjectList::const_iterator it = objectList.constBegin();
-                                           it != objectList.constEnd(); ++it) {
-        const QDBusObjectPath &path = it.key();
-        const InterfaceList &ifaceList = it.value();
-
-        for (InterfaceList::const_iterator ifaceIter = ifaceList.constBegin();
-                                           ifaceIter != ifaceList.constEnd(); ++ifaceIter) {
-            if (ifaceIter.key() == QStringLiteral("org.bluez.Device1")) {
-                if (path.path().indexOf(adapterPath) != 0)
-                    continue; // devices whose path does not start with same path we skip
-
-                OrgBluezDevice1Interface device(QStringLiteral("org.bluez"),
-                                                path.path(), QDBusConnection::systemBus());
-                if (device.adapter().path() != adapterPath)
-                    continue;
-
-                const QBluetoothAddress btAddress(device.address());
-                if (btAddress.isNull() || btAddress != address)
-                    continue;
-
-                return path.path();
-            }
-        }
-    }
-
-    return QString();
+    return QtBluezObjectCache::instance()->devicePath(adapterPath, address);
 }
 
 void QBluetoothSocketPrivateBluezDBus::connectToServiceHelper(
@@ -121,69 +76,16 @@ void QBluetoothSocketPrivateBluezDBus::connectToServiceHelper(
 {
     Q_Q(QBluetoothSocket);
 
-    int i = 0;
-    bool success = false;
-    profileUuid = uuid.toString(QUuid::WithoutBraces);
-
-    if (profileContext) {
+    if (clientProfile) {
         qCDebug(QT_BT_BLUEZ) << "Profile context still active. close socket first.";
         q->setSocketError(QBluetoothSocket::SocketError::UnknownSocketError);
         return;
     }
 
-
-    profileContext = new OrgBluezProfile1ContextInterface(this);
-    connect(profileContext, &OrgBluezProfile1ContextInterface::newConnection,
-            this, &QBluetoothSocketPrivateBluezDBus::remoteConnected);
-
-    for (i = 0; i < 10 && !success; i++) {
-        // profile registration might fail in case other service uses same path
-        // try 10 times and otherwise abort
-
-        profilePath = QString(profilePathTemplate).
-                                  arg(sanitizeNameForDBus(QCoreApplication::applicationName())).
-                                  arg(QCoreApplication::applicationPid()).
-                                  arg(QRandomGenerator::global()->generate());
-
-        success = QDBusConnection::systemBus().registerObject(
-                                    profilePath, profileContext, QDBusConnection::ExportAllSlots);
-    }
-
-    if (!success) {
-        // we could not register the profile
-        qCWarning(QT_BT_BLUEZ) << "Cannot export serial client profile on DBus";
-
-        delete profileContext;
-        profileContext = nullptr;
-
-        errorString = QBluetoothSocket::tr("Cannot export profile on DBus");
-        q->setSocketError(QBluetoothSocket::SocketError::UnknownSocketError);
-
-        return;
-    }
-
-    QVariantMap profileOptions;
-    profileOptions.insert(QStringLiteral("Role"), QStringLiteral("client"));
-    profileOptions.insert(QStringLiteral("Service"), profileUuid);
-    profileOptions.insert(QStringLiteral("Name"),
-                          QStringLiteral("QBluetoothSocket-%1").arg(QCoreApplication::applicationPid()));
-
-    // TODO support more profile parameter
-    // profileOptions.insert(QStringLiteral("Channel"), 0);
-
-    qCDebug(QT_BT_BLUEZ) << "Registering client profile on" << profilePath << "with options:";
-    qCDebug(QT_BT_BLUEZ) << profileOptions;
-    QDBusPendingReply<> reply = profileManager->RegisterProfile(
-                                    QDBusObjectPath(profilePath),
-                                    profileUuid,
-                                    profileOptions);
-    reply.waitForFinished();
-    if (reply.isError()) {
-        qCWarning(QT_BT_BLUEZ) << "Client profile registration failed:"
-                               << reply.error().message();
-
-        QDBusConnection::systemBus().unregisterObject(profilePath);
-        errorString = QBluetoothSocket::tr("Cannot register profile on DBus");
+    // the profile is shared with the other sockets connecting to the service
+    clientProfile = QtBluezClientProfile::acquire(uuid.toString(QUuid::WithoutBraces), this,
+                                                  &errorString);
+    if (!clientProfile) {
         q->setSocketError(QBluetoothSocket::SocketError::UnknownSocketError);
         return;
     }
@@ -199,9 +101,14 @@ void QBluetoothSocketPrivateBluezDBus::connectToServiceHelper(
         return;
     }
 
+    clientProfile->expectConnection(this, remoteDevicePath,
+                                    [this](const QDBusUnixFileDescriptor &fd) {
+        remoteConnected(fd);
+    });
+
     OrgBluezDevice1Interface device(QStringLiteral("org.bluez"), remoteDevicePath,
                                     QDBusConnection::systemBus());
-    reply = device.ConnectProfile(profileUuid);
+    QDBusPendingReply<> reply = device.ConnectProfile(clientProfile->uuid());
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
     connect(watcher, &QDBusPendingCallWatcher::finished,
             this, &QBluetoothSocketPrivateBluezDBus::connectToServiceReplyHandler);
@@ -436,8 +343,11 @@ qint64 QBluetoothSocketPrivateBluezDBus::writeData(const char *data, qint64 maxS
         return -1;
     }
 
-    if (localSocket)
-        return localSocket->write(data, maxSize);
+    if (localSocket) {
+        const qint64 written = localSocket->write(data, maxSize);
+        recordWriteBuffered(localSocket->bytesToWrite());
+        return written;
+    }
 
     return -1;
 }
@@ -455,8 +365,12 @@ qint64 QBluetoothSocketPrivateBluezDBus::readData(char *data, qint64 maxSize)
         return -1;
     }
 
-    if (localSocket)
-        return localSocket->read(data, maxSize);
+    if (localSocket) {
+        const qint64 bytesRead = localSocket->read(data, maxSize);
+        if (bytesRead > 0)
+            recordConsumed(bytesRead);
+        return bytesRead;
+    }
 
     return -1;
 }
@@ -500,6 +414,36 @@ qint64 QBluetoothSocketPrivateBluezDBus::bytesToWrite() const
     return 0;
 }
 
+bool QBluetoothSocketPrivateBluezDBus::setSocketOption(QBluetoothSocket::SocketOption option,
+                                                       const QVariant &value)
+{
+    // remembered for the raw socket which takes over for LE channels
+    if (option == QBluetoothSocket::SocketOption::ReceiveMtuSocketOption
+            && state == QBluetoothSocket::SocketState::UnconnectedState) {
+        lowEnergyReceiveMtu = quint16(value.toUInt());
+        return true;
+    }
+
+    if (localSocket)
+        return qt_setBluezSocketOption(int(localSocket->socketDescriptor()), option, value);
+
+    return false;
+}
+
+QVariant QBluetoothSocketPrivateBluezDBus::socketOption(
+        QBluetoothSocket::SocketOption option) const
+{
+    if (option == QBluetoothSocket::SocketOption::ReceiveMtuSocketOption
+            && state == QBluetoothSocket::SocketState::UnconnectedState) {
+        return lowEnergyReceiveMtu ? QVariant(lowEnergyReceiveMtu) : QVariant();
+    }
+
+    if (localSocket)
+        return qt_bluezSocketOption(int(localSocket->socketDescriptor()), option);
+
+    return QVariant();
+}
+
 void QBluetoothSocketPrivateBluezDBus::remoteConnected(const QDBusUnixFileDescriptor &fd)
 {
     Q_Q(QBluetoothSocket);
@@ -513,12 +457,19 @@ void QBluetoothSocketPrivateBluezDBus::remoteConnected(const QDBusUnixFileDescri
         delete localSocket;
         localSocket = nullptr;
     } else {
-        connect(localSocket, &QLocalSocket::readyRead,
-                q, &QBluetoothSocket::readyRead);
+        // QLocalSocket does the buffering, the counters follow its signals
+        bufferedBytesSeen = 0;
+        connect(localSocket, &QLocalSocket::readyRead, this, [this, q]() {
+            recordBuffered(localSocket->bytesAvailable());
+            recordReadyRead();
+            emit q->readyRead();
+        });
         connect(localSocket, &QLocalSocket::stateChanged,
                 this, &QBluetoothSocketPrivateBluezDBus::socketStateChanged);
-        connect(localSocket, &QLocalSocket::bytesWritten,
-                q, &QBluetoothSocket::bytesWritten);
+        connect(localSocket, &QLocalSocket::bytesWritten, this, [this, q](qint64 bytes) {
+            recordSent(bytes);
+            emit q->bytesWritten(bytes);
+        });
 
         socket = descriptor;
         q->setSocketState(QBluetoothSocket::SocketState::ConnectedState);
@@ -550,10 +501,10 @@ void QBluetoothSocketPrivateBluezDBus::clearSocket()
 {
     Q_Q(QBluetoothSocket);
 
-    if (profilePath.isEmpty())
+    if (!clientProfile)
         return;
 
-    qCDebug(QT_BT_BLUEZ) << "Clearing profile called for" << profilePath;
+    qCDebug(QT_BT_BLUEZ) << "Clearing profile called for" << clientProfile->uuid();
 
     if (localSocket) {
         localSocket->close();
@@ -566,7 +517,7 @@ void QBluetoothSocketPrivateBluezDBus::clearSocket()
     if (q->state() == QBluetoothSocket::SocketState::ConnectedState) {
         OrgBluezDevice1Interface device(QStringLiteral("org.bluez"), remoteDevicePath,
                                         QDBusConnection::systemBus());
-        auto reply = device.DisconnectProfile(profileUuid);
+        auto reply = device.DisconnectProfile(clientProfile->uuid());
         reply.waitForFinished();
         if (reply.isError()) {
             qCWarning(QT_BT_BLUEZ) << "Disconnect profile failed:"
@@ -574,21 +525,11 @@ void QBluetoothSocketPrivateBluezDBus::clearSocket()
         }
     }
 
-    QDBusPendingReply<> reply = profileManager->UnregisterProfile(QDBusObjectPath(profilePath));
-    reply.waitForFinished();
-    if (reply.isError())
-        qCWarning(QT_BT_BLUEZ) << "Unregister profile:" << reply.error().message();
-
-    QDBusConnection::systemBus().unregisterObject(profilePath);
-
-    if (profileContext) {
-        delete profileContext;
-        profileContext = nullptr;
-    }
+    // stays registered for the next socket to the service
+    clientProfile->release(this);
+    clientProfile = nullptr;
 
     remoteDevicePath.clear();
-    profileUuid.clear();
-    profilePath.clear();
 }
 QT_END_NAMESPACE
 
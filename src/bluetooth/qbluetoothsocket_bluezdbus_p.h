@@ -22,12 +22,10 @@
 #include <QtNetwork/qlocalsocket.h>
 #include <QDBusPendingCallWatcher>
 
-class OrgBluezProfileManager1Interface;
-
 QT_BEGIN_NAMESPACE
 
 class QLocalSocket;
-class OrgBluezProfile1ContextInterface;
+class QtBluezClientProfile;
 
 class QBluetoothSocketPrivateBluezDBus final: public QBluetoothSocketBasePrivate
 {
@@ -75,6 +73,9 @@ public:
     bool canReadLine() const override;
     qint64 bytesToWrite() const override;
 
+    bool setSocketOption(QBluetoothSocket::SocketOption option, const QVariant &value) override;
+    QVariant socketOption(QBluetoothSocket::SocketOption option) const override;
+
 public slots:
     void connectToServiceReplyHandler(QDBusPendingCallWatcher *);
 
@@ -85,11 +86,8 @@ private:
     void clearSocket();
 
 private:
-    OrgBluezProfileManager1Interface *profileManager = nullptr;
-    OrgBluezProfile1ContextInterface *profileContext = nullptr;
+    QtBluezClientProfile *clientProfile = nullptr;
     QString remoteDevicePath;
-    QString profileUuid;
-    QString profilePath;
     QLocalSocket *localSocket = nullptr;
 };
 
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <limits>
+#include <utility>
 
 QT_BEGIN_NAMESPACE
 
@@ -33,9 +34,15 @@ using ObjCRFCOMMChannel = QT_MANGLE_NAMESPACE(DarwinBTRFCOMMChannel);
 } // unnamed namespace
 
 QBluetoothSocketPrivateDarwin::QBluetoothSocketPrivateDarwin()
-  : writeChunk(std::numeric_limits<UInt16>::max())
 {
     q_ptr = nullptr;
+
+    if (Q_UNLIKELY(!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_DARWIN_WRITE_WINDOW"))) {
+        bool ok = false;
+        const int value = qEnvironmentVariableIntValue("QT_BLUETOOTH_DARWIN_WRITE_WINDOW", &ok);
+        if (ok && value > 0)
+            writeWindow = value;
+    }
 }
 
 QBluetoothSocketPrivateDarwin::~QBluetoothSocketPrivateDarwin()
@@ -139,7 +146,7 @@ void QBluetoothSocketPrivateDarwin::close()
     Q_ASSERT_X(!isConnecting, Q_FUNC_INFO, "internal inconsistency - "
                "still in connectToService()");
 
-    if (!txBuffer.size())
+    if (!txBuffer.size() && writesInFlight.isEmpty())
         abort();
 }
 
@@ -163,6 +170,7 @@ qint64 QBluetoothSocketPrivateDarwin::writeData(const char *data, qint64 maxSize
 
     char *dst = txBuffer.reserve(int(maxSize));
     std::copy(data, data + maxSize, dst);
+    recordWriteBuffered(txBuffer.size());
 
     return maxSize;
 }
@@ -315,6 +323,7 @@ void QBluetoothSocketPrivateDarwin::connectToService(const QBluetoothAddress &ad
     errorString.clear();
     rxBuffer.clear();
     txBuffer.clear();
+    writesInFlight.clear();
 
     IOReturn status = kIOReturnError;
     // Setting socket state on q_ptr will emit a signal,
@@ -356,8 +365,10 @@ void QBluetoothSocketPrivateDarwin::connectToService(const QBluetoothAddress &ad
             // Connected, setOpenMode on a QBluetoothSocket.
             q_ptr->setOpenMode(openMode);
             q_ptr->setSocketState(QBluetoothSocket::SocketState::ConnectedState);
-            if (rxBuffer.size()) // We also have some data already ...
+            if (rxBuffer.size()) { // We also have some data already ...
+                recordReadyRead();
                 emit q_ptr->readyRead();
+            }
         } else if (state == QBluetoothSocket::SocketState::UnconnectedState) {
             // Even if we have some data, we can not read it if
             // state != ConnectedState.
@@ -386,29 +397,41 @@ void QBluetoothSocketPrivateDarwin::_q_writeNotify()
                "invalid socket (no open channel)");
     Q_ASSERT_X(q_ptr, Q_FUNC_INFO, "invalid q_ptr (null)");
 
-    if (txBuffer.size()) {
-        const bool isL2CAP = socketType == QBluetoothServiceInfo::L2capProtocol;
-        writeChunk.resize(isL2CAP ? std::numeric_limits<UInt16>::max() :
-                          [rfcommChannel.getAs<ObjCRFCOMMChannel>() getMTU]);
-
-        const auto size = txBuffer.read(writeChunk.data(), writeChunk.size());
+    // keep up to writeWindow chunks queued in IOBluetooth, one completion round
+    // trip per chunk would bound the throughput
+    const bool isL2CAP = socketType == QBluetoothServiceInfo::L2capProtocol;
+    while (txBuffer.size() && writesInFlight.size() < writeWindow) {
+        const qint64 chunkSize = isL2CAP ? std::numeric_limits<UInt16>::max()
+                                         : [rfcommChannel.getAs<ObjCRFCOMMChannel>() getMTU];
+        QByteArray chunk(qMin(chunkSize, qint64(txBuffer.size())), Qt::Uninitialized);
+        const auto size = txBuffer.read(chunk.data(), chunk.size());
+        // the data of the queued chunk does not move while later chunks are queued
+        writesInFlight.enqueue(std::move(chunk));
+        char *data = writesInFlight.last().data();
         IOReturn status = kIOReturnError;
         if (!isL2CAP)
-            status = [rfcommChannel.getAs<ObjCRFCOMMChannel>() writeAsync:writeChunk.data() length:UInt16(size)];
+            status = [rfcommChannel.getAs<ObjCRFCOMMChannel>() writeAsync:data length:UInt16(size)];
         else
-            status = [l2capChannel.getAs<ObjCL2CAPChannel>() writeAsync:writeChunk.data() length:UInt16(size)];
+            status = [l2capChannel.getAs<ObjCL2CAPChannel>() writeAsync:data length:UInt16(size)];
 
         if (status != kIOReturnSuccess) {
+            writesInFlight.removeLast();
             errorString = QCoreApplication::translate(SOCKET, SOC_NETWORK_ERROR);
             q_ptr->setSocketError(QBluetoothSocket::SocketError::NetworkError);
             return;
-        } else {
-            emit q_ptr->bytesWritten(size);
         }
+
+        recordSent(size);
+        emit q_ptr->bytesWritten(size);
+        // a slot connected to bytesWritten() may have aborted the socket
+        if (!(isL2CAP ? l2capChannel : rfcommChannel))
+            return;
     }
 
-    if (!txBuffer.size() && state == QBluetoothSocket::SocketState::ClosingState)
+    if (!txBuffer.size() && writesInFlight.isEmpty()
+            && state == QBluetoothSocket::SocketState::ClosingState) {
         close();
+    }
 }
 
 bool QBluetoothSocketPrivateDarwin::setRFCOMChannel(void *generic)
@@ -517,15 +540,20 @@ void QBluetoothSocketPrivateDarwin::readChannelData(void *data, std::size_t size
     const char *src = static_cast<char *>(data);
     char *dst = rxBuffer.reserve(int(size));
     std::copy(src, src + size, dst);
+    recordReceived(qint64(size));
 
     if (!isConnecting) {
         // If we're still in connectToService, do not emit.
+        recordReadyRead();
         emit q_ptr->readyRead();
     }   // else connectToService must check and emit readyRead!
 }
 
 void QBluetoothSocketPrivateDarwin::writeComplete()
 {
+    // IOBluetooth completes the writes in the order they were issued
+    if (!writesInFlight.isEmpty())
+        writesInFlight.dequeue();
     _q_writeNotify();
 }
 
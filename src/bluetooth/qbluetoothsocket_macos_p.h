@@ -34,6 +34,7 @@
 #include <QtCore/QIODevice>
 #include <QtCore/QList>
 #include <QtCore/QObject>
+#include <QtCore/QQueue>
 #include <QtCore/QScopedPointer>
 #include <QtCore/QString>
 
@@ -99,7 +100,9 @@ private:
     void readChannelData(void *data, std::size_t size) override;
     void writeComplete() override;
 
-    QList<char> writeChunk;
+    // chunks passed to writeAsync, owned until IOBluetooth completed their write
+    QQueue<QByteArray> writesInFlight;
+    qsizetype writeWindow = 4;
 
     using L2CAPChannel = DarwinBluetooth::ScopedPointer;
     L2CAPChannel l2capChannel;
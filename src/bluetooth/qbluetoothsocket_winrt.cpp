@@ -9,6 +9,7 @@
 #include <QtBluetooth/qbluetoothserviceinfo.h>
 #include <QtCore/qloggingcategory.h>
 #include <QtCore/QPointer>
+#include <QtCore/qmutex.h>
 #include <QtCore/private/qfunctions_winrt_p.h>
 
 #include <robuffer.h>
@@ -17,6 +18,9 @@
 #include <windows.storage.streams.h>
 #include <wrl.h>
 
+#include <atomic>
+#include <utility>
+
 using namespace Microsoft::WRL;
 using namespace Microsoft::WRL::Wrappers;
 using namespace ABI::Windows::Devices::Bluetooth;
@@ -49,6 +53,7 @@ struct SocketGlobal
 Q_GLOBAL_STATIC(SocketGlobal, g)
 
 #define READ_BUFFER_SIZE 65536
+#define READ_BUFFER_COUNT 2
 
 static inline QString qt_QStringFromHString(const HString &string)
 {
@@ -101,8 +106,8 @@ public:
     void close()
     {
         m_shuttingDown = true;
+        QMutexLocker locker(&m_mutex);
         if (m_readOp) {
-            onReadyRead(m_readOp.Get(), Canceled);
             ComPtr<IAsyncInfo> info;
             HRESULT hr = m_readOp.As(&info);
             Q_ASSERT_SUCCEEDED(hr);
@@ -114,6 +119,7 @@ public:
             }
             m_readOp.Reset();
         }
+        m_freeBuffers.clear();
     }
 
 signals:
@@ -123,30 +129,19 @@ signals:
 public slots:
     Q_INVOKABLE void notifyAboutNewData()
     {
-        const QList<QByteArray> newData = std::move(m_pendingData);
-        m_pendingData.clear();
+        QList<QByteArray> newData;
+        {
+            QMutexLocker locker(&m_mutex);
+            newData = std::exchange(m_pendingData, {});
+        }
         emit newDataReceived(newData);
     }
 
 public:
     void startReading()
     {
-        ComPtr<IBuffer> tempBuffer;
-        HRESULT hr = g->bufferFactory->Create(READ_BUFFER_SIZE, &tempBuffer);
-        Q_ASSERT_SUCCEEDED(hr);
-        ComPtr<IInputStream> stream;
-        hr = m_socket->get_InputStream(&stream);
-        Q_ASSERT_SUCCEEDED(hr);
-        hr = stream->ReadAsync(tempBuffer.Get(), READ_BUFFER_SIZE, InputStreamOptions_Partial, m_readOp.GetAddressOf());
-        Q_ASSERT_SUCCEEDED(hr);
-        QPointer<SocketWorker> thisPtr(this);
-        hr = m_readOp->put_Completed(
-                Callback<SocketReadCompletedHandler>([thisPtr](IAsyncBufferOperation *asyncInfo,
-                                                               AsyncStatus status) {
-                    if (thisPtr)
-                        return thisPtr->onReadyRead(asyncInfo, status);
-                    return S_OK;
-                }).Get());
+        QMutexLocker locker(&m_mutex);
+        HRESULT hr = readNext();
         Q_ASSERT_SUCCEEDED(hr);
     }
 
@@ -155,6 +150,12 @@ public:
         if (m_shuttingDown)
             return S_OK;
 
+        // The next read is issued before the data of this one is copied, its completion
+        // waits here until the data of this read was queued.
+        QMutexLocker locker(&m_mutex);
+        if (m_shuttingDown)
+            return S_OK;
+
         if (asyncInfo == m_readOp.Get())
             m_readOp.Reset();
         else
@@ -192,6 +193,13 @@ public:
             return S_OK;
         }
 
+        // Keep the stream busy while the data is copied out of the buffer
+        hr = readNext();
+        if (FAILED(hr)) {
+            emit socketErrorOccured(QBluetoothSocket::SocketError::UnknownSocketError);
+            return S_OK;
+        }
+
         ComPtr<Windows::Storage::Streams::IBufferByteAccess> byteArrayAccess;
         hr = tempBuffer.As(&byteArrayAccess);
         if (FAILED(hr)) {
@@ -212,34 +220,33 @@ public:
             QMetaObject::invokeMethod(this, "notifyAboutNewData", Qt::QueuedConnection);
         m_pendingData << newData;
 
-        UINT32 readBufferLength;
-        ComPtr<IInputStream> stream;
-        hr = m_socket->get_InputStream(&stream);
-        if (FAILED(hr)) {
-            qErrnoWarning(hr, "Failed to obtain input stream");
-            emit socketErrorOccured(QBluetoothSocket::SocketError::UnknownSocketError);
-            return S_OK;
-        }
+        releaseBuffer(tempBuffer);
+        return S_OK;
+    }
+
+    void setSocket(ComPtr<IStreamSocket> socket) { m_socket = socket; }
 
-        // Reuse the stream buffer
-        hr = tempBuffer->get_Capacity(&readBufferLength);
+private:
+    // Issues the next ReadAsync, m_mutex must be locked.
+    HRESULT readNext()
+    {
+        ComPtr<IBuffer> buffer;
+        HRESULT hr = acquireBuffer(&buffer);
         if (FAILED(hr)) {
-            qErrnoWarning(hr, "Failed to get buffer capacity");
-            emit socketErrorOccured(QBluetoothSocket::SocketError::UnknownSocketError);
-            return S_OK;
+            qErrnoWarning(hr, "Failed to create socket read buffer");
+            return hr;
         }
-        hr = tempBuffer->put_Length(0);
+        ComPtr<IInputStream> stream;
+        hr = m_socket->get_InputStream(&stream);
         if (FAILED(hr)) {
-            qErrnoWarning(hr, "Failed to set buffer length");
-            emit socketErrorOccured(QBluetoothSocket::SocketError::UnknownSocketError);
-            return S_OK;
+            qErrnoWarning(hr, "Failed to obtain input stream");
+            return hr;
         }
-
-        hr = stream->ReadAsync(tempBuffer.Get(), readBufferLength, InputStreamOptions_Partial, &m_readOp);
+        hr = stream->ReadAsync(buffer.Get(), READ_BUFFER_SIZE, InputStreamOptions_Partial,
+                               m_readOp.ReleaseAndGetAddressOf());
         if (FAILED(hr)) {
-            qErrnoWarning(hr, "onReadyRead(): Could not read into socket stream buffer.");
-            emit socketErrorOccured(QBluetoothSocket::SocketError::UnknownSocketError);
-            return S_OK;
+            qErrnoWarning(hr, "Could not read into socket stream buffer");
+            return hr;
         }
         QPointer<SocketWorker> thisPtr(this);
         hr = m_readOp->put_Completed(
@@ -249,20 +256,32 @@ public:
                         return thisPtr->onReadyRead(asyncInfo, status);
                     return S_OK;
                 }).Get());
-        if (FAILED(hr)) {
-            qErrnoWarning(hr, "onReadyRead(): Failed to set socket read callback.");
-            emit socketErrorOccured(QBluetoothSocket::SocketError::UnknownSocketError);
-            return S_OK;
-        }
+        if (FAILED(hr))
+            qErrnoWarning(hr, "Failed to set socket read callback");
+        return hr;
+    }
+
+    HRESULT acquireBuffer(ComPtr<IBuffer> *buffer)
+    {
+        if (m_freeBuffers.isEmpty())
+            return g->bufferFactory->Create(READ_BUFFER_SIZE, buffer->GetAddressOf());
+        *buffer = m_freeBuffers.takeLast();
         return S_OK;
     }
 
-    void setSocket(ComPtr<IStreamSocket> socket) { m_socket = socket; }
+    void releaseBuffer(const ComPtr<IBuffer> &buffer)
+    {
+        // one buffer is read into while the other one is copied from
+        if (m_freeBuffers.size() < READ_BUFFER_COUNT && SUCCEEDED(buffer->put_Length(0)))
+            m_freeBuffers.append(buffer);
+    }
 
-private:
     ComPtr<IStreamSocket> m_socket;
+    // Guards the read state below, the read completions run on the thread pool
+    QMutex m_mutex;
     QList<QByteArray> m_pendingData;
-    bool m_shuttingDown = false;
+    QList<ComPtr<IBuffer>> m_freeBuffers;
+    std::atomic<bool> m_shuttingDown = false;
 
     ComPtr<IAsyncOperationWithProgress<IBuffer *, UINT32>> m_readOp;
 };
@@ -650,6 +669,8 @@ qint64 QBluetoothSocketPrivateWinRT::writeData(const char *data, qint64 maxSize)
         qCWarning(QT_BT_WINDOWS) << "Socket::writeData: " << state;
         errorString = QBluetoothSocket::tr("Cannot read while not connected");
         q->setSocketError(QBluetoothSocket::SocketError::OperationError);
+    } else {
+        recordSent(bytesWritten);
     }
 
     emit q->bytesWritten(bytesWritten);
@@ -763,8 +784,10 @@ void QBluetoothSocketPrivateWinRT::addToPendingData(const QList<QByteArray> &dat
     for (const QByteArray &newData : data) {
         char *writePointer = rxBuffer.reserve(newData.length());
         memcpy(writePointer, newData.data(), size_t(newData.length()));
+        recordReceived(newData.length());
     }
     locker.unlock();
+    recordReadyRead();
     emit q->readyRead();
 }
 
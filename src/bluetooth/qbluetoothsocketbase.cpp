@@ -15,6 +15,33 @@ QBluetoothSocketBasePrivate::~QBluetoothSocketBasePrivate()
 
 }
 
+bool QBluetoothSocketBasePrivate::setSocketOption(QBluetoothSocket::SocketOption option,
+                                                  const QVariant &value)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(value);
+    return false;
+}
+
+QVariant QBluetoothSocketBasePrivate::socketOption(QBluetoothSocket::SocketOption option) const
+{
+    Q_UNUSED(option);
+    return QVariant();
+}
+
+void QBluetoothSocketBasePrivate::connectToLowEnergyChannel(
+        const QBluetoothAddress &address, quint16 psm,
+        QLowEnergyController::RemoteAddressType addressType, QIODevice::OpenMode openMode)
+{
+    Q_UNUSED(address);
+    Q_UNUSED(psm);
+    Q_UNUSED(addressType);
+    Q_UNUSED(openMode);
+
+    errorString = QBluetoothSocket::tr("LE L2CAP channels are not supported on this platform");
+    q_ptr->setSocketError(QBluetoothSocket::SocketError::UnsupportedProtocolError);
+}
+
 QT_END_NAMESPACE
 
 #include "moc_qbluetoothsocketbase_p.cpp"
@@ -18,6 +18,9 @@
 #include <qglobal.h>
 #include <QObject>
 #include <QtBluetooth/qbluetoothsocket.h>
+#include <QtCore/qelapsedtimer.h>
+
+#include "qbluetoothsocketstatistics_p.h"
 
 #if defined(QT_ANDROID_BLUETOOTH)
 #include <QtCore/QJniObject>
@@ -46,7 +49,7 @@ namespace ABI {
 #ifndef QPRIVATELINEARBUFFER_BUFFERSIZE
 #define QPRIVATELINEARBUFFER_BUFFERSIZE Q_INT64_C(16384)
 #endif
-#include "qprivatelinearbuffer_p.h"
+#include <QtCore/private/qringbuffer_p.h>
 
 QT_FORWARD_DECLARE_CLASS(QSocketNotifier)
 QT_FORWARD_DECLARE_CLASS(QBluetoothServiceDiscoveryAgent)
@@ -81,6 +84,10 @@ public:
     virtual bool canReadLine() const = 0;
     virtual qint64 bytesToWrite() const = 0;
 
+    // not supported by default
+    virtual bool setSocketOption(QBluetoothSocket::SocketOption option, const QVariant &value);
+    virtual QVariant socketOption(QBluetoothSocket::SocketOption option) const;
+
     virtual bool setSocketDescriptor(int socketDescriptor, QBluetoothServiceInfo::Protocol socketType,
                              QBluetoothSocket::SocketState socketState = QBluetoothSocket::SocketState::ConnectedState,
                              QBluetoothSocket::OpenMode openMode = QBluetoothSocket::ReadWrite) = 0;
@@ -99,6 +106,10 @@ public:
                                   QIODevice::OpenMode openMode) = 0;
     virtual void connectToService(const QBluetoothAddress &address, quint16 port,
                                   QIODevice::OpenMode openMode) = 0;
+    // not supported by default
+    virtual void connectToLowEnergyChannel(const QBluetoothAddress &address, quint16 psm,
+                                           QLowEnergyController::RemoteAddressType addressType,
+                                           QIODevice::OpenMode openMode);
 
 #ifdef QT_ANDROID_BLUETOOTH
     virtual bool setSocketDescriptor(const QJniObject &socket, QBluetoothServiceInfo::Protocol socketType,
@@ -112,8 +123,48 @@ public:
 #endif
 
 public:
-    QPrivateLinearBuffer rxBuffer;
-    QPrivateLinearBuffer txBuffer;
+    // Always-on counters behind QBluetoothSocket::statistics(), every backend fills them in.
+    void recordReceived(qint64 bytes) { statistics.bytesReceived += quint64(bytes); }
+    void recordReadyRead() { ++statistics.readyReadCount; }
+    void recordSent(qint64 bytes)
+    {
+        statistics.bytesSent += quint64(bytes);
+        if (writeStallTimer.isValid()) {
+            statistics.writeStallNSecs += writeStallTimer.nsecsElapsed();
+            writeStallTimer.invalidate();
+        }
+    }
+    void recordWriteBuffered(qint64 bufferedBytes)
+    {
+        statistics.writeBufferHighWaterMark =
+                qMax(statistics.writeBufferHighWaterMark, bufferedBytes);
+    }
+    // the platform did not take data, the stall lasts until the next recordSent()
+    void recordWriteStalled()
+    {
+        if (!writeStallTimer.isValid()) {
+            ++statistics.writeStallCount;
+            writeStallTimer.start();
+        }
+    }
+    // For backends whose receive buffer is filled by someone else: accounts
+    // for what arrived since the last call, given the bytes now available.
+    void recordBuffered(qint64 bytesAvailable)
+    {
+        recordReceived(bytesAvailable - bufferedBytesSeen);
+        bufferedBytesSeen = bytesAvailable;
+    }
+    void recordConsumed(qint64 bytes) { bufferedBytesSeen = qMax<qint64>(bufferedBytesSeen - bytes, 0); }
+
+    QBluetoothSocketStatisticsPrivate statistics;
+    QElapsedTimer writeStallTimer;
+    qint64 bufferedBytesSeen = 0;
+    // kernel receive time of the most recent data in microseconds since the epoch, 0 if unknown
+    qint64 receiveTimestamp = 0;
+
+    // chunked, so that neither appending nor consuming moves the buffered data
+    QRingBuffer rxBuffer;
+    QRingBuffer txBuffer;
     int socket = -1;
     QBluetoothServiceInfo::Protocol socketType = QBluetoothServiceInfo::UnknownProtocol;
     QBluetoothSocket::SocketState state = QBluetoothSocket::SocketState::UnconnectedState;
@@ -135,6 +186,8 @@ protected:
 #if QT_CONFIG(bluez)
 public:
     quint8 lowEnergySocketType = 0;
+    // receive MTU requested for the next LE credit based channel, 0 for the default
+    quint16 lowEnergyReceiveMtu = 0;
 #endif
 };
 
@@ -0,0 +1,136 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qbluetoothsocketstatistics_p.h"
+
+QT_BEGIN_NAMESPACE
+
+QT_IMPL_METATYPE_EXTERN(QBluetoothSocketStatistics)
+
+/*!
+    \since 6.5
+    \class QBluetoothSocketStatistics
+    \brief The QBluetoothSocketStatistics class reports traffic counters of a
+           QBluetoothSocket.
+
+    An object of this class is a snapshot of the counters a \l QBluetoothSocket
+    keeps from the moment it is created. Comparing two snapshots taken some time
+    apart yields the throughput of the socket in each direction.
+
+    The counters help to tell where a transfer is slowed down. A write buffer
+    which keeps growing while the socket stalls means that the link or the
+    remote device does not take the data fast enough. A low \l readyReadCount()
+    compared to the received bytes means that the application's event loop
+    takes a long time to return to the socket.
+
+    \note Not every platform reports write stalls. They are currently only
+    counted on Linux with the raw BlueZ socket implementation. On the other
+    platforms \l writeStallCount() and \l writeStallTime() remain \c 0.
+
+    \inmodule QtBluetooth
+    \ingroup shared
+
+    \sa QBluetoothSocket::statistics()
+*/
+
+/*!
+   Constructs a new, invalid object of this class.
+ */
+QBluetoothSocketStatistics::QBluetoothSocketStatistics()
+    : d(new QBluetoothSocketStatisticsPrivate)
+{
+}
+
+/*! Constructs a new object of this class that is a copy of \a other. */
+QBluetoothSocketStatistics::QBluetoothSocketStatistics(const QBluetoothSocketStatistics &other)
+    : d(other.d)
+{
+}
+
+/*! Destroys this object. */
+QBluetoothSocketStatistics::~QBluetoothSocketStatistics()
+{
+}
+
+/*! Makes this object a copy of \a other and returns the new value of this object. */
+QBluetoothSocketStatistics &
+QBluetoothSocketStatistics::operator=(const QBluetoothSocketStatistics &other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+   Returns \c true if the object was obtained from a socket, otherwise returns
+   \c false.
+ */
+bool QBluetoothSocketStatistics::isValid() const
+{
+    return d->valid;
+}
+
+/*!
+   Returns the number of bytes the socket handed to the platform for
+   transmission to the remote device.
+   \sa writeBufferHighWaterMark()
+ */
+quint64 QBluetoothSocketStatistics::bytesSent() const
+{
+    return d->bytesSent;
+}
+
+/*!
+   Returns the number of bytes the socket received from the remote device,
+   including those not yet read by the application.
+   \sa readyReadCount()
+ */
+quint64 QBluetoothSocketStatistics::bytesReceived() const
+{
+    return d->bytesReceived;
+}
+
+/*!
+   Returns how often the socket emitted \l QIODevice::readyRead().
+   \sa bytesReceived()
+ */
+quint64 QBluetoothSocketStatistics::readyReadCount() const
+{
+    return d->readyReadCount;
+}
+
+/*!
+   Returns the largest number of bytes that waited in the write buffer of the
+   socket at any time. Unbuffered sockets report \c 0.
+   \sa QBluetoothSocket::bytesToWrite()
+ */
+qint64 QBluetoothSocketStatistics::writeBufferHighWaterMark() const
+{
+    return d->writeBufferHighWaterMark;
+}
+
+/*!
+   Returns how often the platform refused to take more data for transmission
+   because its own buffers were full.
+   \sa writeStallTime()
+ */
+quint64 QBluetoothSocketStatistics::writeStallCount() const
+{
+    return d->writeStallCount;
+}
+
+/*!
+   Returns the total time in milliseconds the socket had data to send while
+   the platform refused to take it, including a stall that is still ongoing.
+   \sa writeStallCount()
+ */
+double QBluetoothSocketStatistics::writeStallTime() const
+{
+    return double(d->writeStallNSecs) / 1000000.0;
+}
+
+/*!
+   \fn void QBluetoothSocketStatistics::swap(QBluetoothSocketStatistics &other)
+   Swaps this object with \a other.
+ */
+
+QT_END_NAMESPACE
@@ -0,0 +1,46 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QBLUETOOTHSOCKETSTATISTICS_H
+#define QBLUETOOTHSOCKETSTATISTICS_H
+
+#include <QtBluetooth/qtbluetoothglobal.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qshareddata.h>
+
+QT_BEGIN_NAMESPACE
+
+class QBluetoothSocketStatisticsPrivate;
+
+class Q_BLUETOOTH_EXPORT QBluetoothSocketStatistics
+{
+public:
+    QBluetoothSocketStatistics();
+    QBluetoothSocketStatistics(const QBluetoothSocketStatistics &other);
+    ~QBluetoothSocketStatistics();
+
+    QBluetoothSocketStatistics &operator=(const QBluetoothSocketStatistics &other);
+
+    bool isValid() const;
+
+    quint64 bytesSent() const;
+    quint64 bytesReceived() const;
+    quint64 readyReadCount() const;
+    qint64 writeBufferHighWaterMark() const;
+    quint64 writeStallCount() const;
+    double writeStallTime() const;
+
+    void swap(QBluetoothSocketStatistics &other) noexcept { d.swap(other.d); }
+
+private:
+    friend class QBluetoothSocket;
+    QSharedDataPointer<QBluetoothSocketStatisticsPrivate> d;
+};
+
+Q_DECLARE_SHARED(QBluetoothSocketStatistics)
+
+QT_END_NAMESPACE
+
+QT_DECL_METATYPE_EXTERN(QBluetoothSocketStatistics, Q_BLUETOOTH_EXPORT)
+
+#endif // Include guard
@@ -0,0 +1,36 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QBLUETOOTHSOCKETSTATISTICS_P_H
+#define QBLUETOOTHSOCKETSTATISTICS_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qbluetoothsocketstatistics.h"
+
+QT_BEGIN_NAMESPACE
+
+class QBluetoothSocketStatisticsPrivate : public QSharedData
+{
+public:
+    bool valid = false;
+    quint64 bytesSent = 0;
+    quint64 bytesReceived = 0;
+    quint64 readyReadCount = 0;
+    qint64 writeBufferHighWaterMark = 0;
+    quint64 writeStallCount = 0;
+    qint64 writeStallNSecs = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QBLUETOOTHSOCKETSTATISTICS_P_H
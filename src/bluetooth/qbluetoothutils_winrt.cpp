@@ -84,4 +84,32 @@ void mainThreadCoUninit(void* caller)
 
 }
 
+std::shared_ptr<QWinRTAsyncReceiver> QWinRTAsyncReceiver::create(QObject *object)
+{
+    std::shared_ptr<QWinRTAsyncReceiver> receiver(new QWinRTAsyncReceiver);
+    receiver->object = object;
+    std::weak_ptr<QWinRTAsyncReceiver> weakReceiver = receiver;
+    receiver->destroyedConnection = QObject::connect(object, &QObject::destroyed,
+                                                     [weakReceiver]() {
+        if (const auto receiver = weakReceiver.lock()) {
+            QMutexLocker locker(&receiver->mutex);
+            receiver->object = nullptr;
+        }
+    });
+    return receiver;
+}
+
+void QWinRTAsyncReceiver::deliver(std::function<void()> function)
+{
+    // An object being destroyed waits for the mutex in the destroyed() handler,
+    // the event posted here is removed by ~QObject() afterwards.
+    QMutexLocker locker(&mutex);
+    if (!object)
+        return;
+
+    QObject::disconnect(destroyedConnection);
+    QMetaObject::invokeMethod(object, std::move(function), Qt::QueuedConnection);
+    object = nullptr;
+}
+
 QT_END_NAMESPACE
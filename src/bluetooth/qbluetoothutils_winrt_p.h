@@ -24,11 +24,19 @@ namespace winrt::impl
     auto wait_for(Async const& async, Windows::Foundation::TimeSpan const& timeout);
 }
 
+#include <winrt/Windows.Foundation.h>
+
 #include <QtCore/QtGlobal>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
 #include <QtCore/private/qglobal_p.h>
 
 #include <wrl/client.h>
 
+#include <functional>
+#include <memory>
+#include <optional>
+
 namespace ABI {
     namespace Windows {
         namespace Storage {
@@ -49,6 +57,45 @@ QByteArray byteArrayFromBuffer(const Microsoft::WRL::ComPtr<NativeBuffer> &buffe
 void mainThreadCoInit(void* caller);
 void mainThreadCoUninit(void* caller);
 
+/*
+ * Delivers one function from any thread to the thread of a QObject. The
+ * function is dropped if the object is destroyed before it could run.
+ */
+class QWinRTAsyncReceiver
+{
+public:
+    static std::shared_ptr<QWinRTAsyncReceiver> create(QObject *object);
+    void deliver(std::function<void()> function);
+
+private:
+    QWinRTAsyncReceiver() = default;
+
+    QMutex mutex;
+    QObject *object = nullptr;
+    QMetaObject::Connection destroyedConnection;
+};
+
+/*
+ * Calls handler on the thread of context once operation has finished, passing
+ * the results if it completed and an empty optional if it failed or was
+ * cancelled. Unlike waiting for the operation, this neither polls it nor spins
+ * an event loop. handler is not called if context is destroyed before.
+ */
+template <typename T, typename Handler>
+void whenCompleted(const winrt::Windows::Foundation::IAsyncOperation<T> &operation,
+                   QObject *context, Handler handler)
+{
+    auto receiver = QWinRTAsyncReceiver::create(context);
+    operation.Completed([receiver, handler = std::move(handler)](
+            const winrt::Windows::Foundation::IAsyncOperation<T> &op,
+            winrt::Windows::Foundation::AsyncStatus status) {
+        std::optional<T> result;
+        if (status == winrt::Windows::Foundation::AsyncStatus::Completed)
+            result = op.GetResults();
+        receiver->deliver([handler, result]() { handler(result); });
+    });
+}
+
 QT_END_NAMESPACE
 
 #endif // QBLUETOOTHSOCKET_WINRT_P_H
@@ -2,10 +2,16 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include "qbluetoothuuid.h"
+#include "qbluetoothuuid_p.h"
 #include "qbluetoothservicediscoveryagent.h"
 
 #include <QStringList>
 #include <QtEndian>
+#include <QtCore/qglobalstatic.h>
+
+#include <algorithm>
+#include <array>
+#include <iterator>
 
 #include <string.h>
 
@@ -18,8 +24,123 @@ QT_IMPL_METATYPE_EXTERN(QBluetoothUuid)
 // static inline constexpr const uint data1Reference   = 0x00000000;
 static inline constexpr const ushort data2Reference = 0x0000;
 static inline constexpr const ushort data3Reference = 0x1000;
-static inline constexpr const unsigned char data4Reference[] { 0x80, 0x00, 0x00, 0x80,
-                                                               0x5f, 0x9b, 0x34, 0xfb };
+// data4 { 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb } as loaded from memory in one go
+static inline constexpr const quint64 data4ReferenceValue =
+        QSysInfo::ByteOrder == QSysInfo::LittleEndian ? 0xfb349b5f80000080ULL
+                                                      : 0x800000805f9b34fbULL;
+
+// Whether uuid is derived from the Bluetooth base UUID, meaning that it only
+// differs from it in data1. This runs for every conversion and hash of a UUID.
+static inline bool isBaseUuidDerived(const QUuid &uuid) noexcept
+{
+    return uuid.data2 == data2Reference && uuid.data3 == data3Reference
+            && qFromUnaligned<quint64>(uuid.data4) == data4ReferenceValue;
+}
+
+// any value above 0xf marks a character which is not a hex digit
+static constexpr quint8 invalidHexDigit = 0x10;
+static constexpr std::array<quint8, 256> hexDigitValues = [] {
+    std::array<quint8, 256> values{};
+    for (int c = 0; c < 256; ++c) {
+        if (c >= '0' && c <= '9')
+            values[c] = quint8(c - '0');
+        else if (c >= 'a' && c <= 'f')
+            values[c] = quint8(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F')
+            values[c] = quint8(c - 'A' + 10);
+        else
+            values[c] = invalidHexDigit;
+    }
+    return values;
+}();
+
+// The positions of the 32 hex digits in "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx".
+static constexpr quint8 uuidDigitPositions[32] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 9, 10, 11, 12, 14, 15, 16, 17,
+    19, 20, 21, 22, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35
+};
+static constexpr qsizetype uuidStringLength = 36;
+
+// The canonical form BlueZ and Android use for UUIDs derived from the base UUID.
+static constexpr char16_t baseUuidSuffix[] = u"-0000-1000-8000-00805f9b34fb";
+static constexpr qsizetype baseUuidSuffixLength = std::size(baseUuidSuffix) - 1;
+
+// Decodes the first 2 * byteCount hex digits of the UUID string chars into bytes. The
+// errors are accumulated rather than checked per character, so that the loop does not
+// branch on the content of the string.
+static bool decodeHexDigits(const char16_t *chars, quint8 *bytes, int byteCount) noexcept
+{
+    uint invalid = 0;
+    for (int i = 0; i < byteCount; ++i) {
+        const char16_t high = chars[uuidDigitPositions[2 * i]];
+        const char16_t low = chars[uuidDigitPositions[2 * i + 1]];
+        const quint8 highValue = hexDigitValues[high & 0xff];
+        const quint8 lowValue = hexDigitValues[low & 0xff];
+        // non Latin-1 characters and the invalid marker
+        invalid |= uint(high | low) >> 8 | ((highValue | lowValue) & invalidHexDigit);
+        bytes[i] = quint8(highValue << 4 | lowValue);
+    }
+    return invalid == 0;
+}
+
+// Parses the form "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx" with optional braces. Only
+// strings which are valid in this form are accepted, all others are left to QUuid.
+static bool parseUuidString(QStringView text, QBluetoothUuid *uuid, int *minimumSize) noexcept
+{
+    if (text.size() == uuidStringLength + 2) {
+        if (text.front() != u'{' || text.back() != u'}')
+            return false;
+        text = text.sliced(1, uuidStringLength);
+    }
+    if (text.size() != uuidStringLength)
+        return false;
+
+    const char16_t *chars = text.utf16();
+    // the most common UUIDs only need their first 8 digits decoded
+    if (memcmp(chars + 8, baseUuidSuffix, baseUuidSuffixLength * sizeof(char16_t)) == 0) {
+        quint8 bytes[4];
+        if (!decodeHexDigits(chars, bytes, 4))
+            return false;
+        const quint32 value = qFromBigEndian<quint32>(bytes);
+        *uuid = QBluetoothUuid(value);
+        *minimumSize = value & 0xffff0000 ? 4 : 2;
+        return true;
+    }
+
+    const uint dashes = uint(chars[8] ^ u'-') | uint(chars[13] ^ u'-')
+            | uint(chars[18] ^ u'-') | uint(chars[23] ^ u'-');
+    quint128 bytes;
+    if (!decodeHexDigits(chars, bytes.data, 16) || dashes != 0)
+        return false;
+    *uuid = QBluetoothUuid(bytes);
+    *minimumSize = uuid->minimumSize();
+    return true;
+}
+
+QBluetoothUuid qt_bluetoothUuidFromString(QStringView text, int *minimumSize)
+{
+    QBluetoothUuid uuid;
+    int size = 0;
+    if (!parseUuidString(text, &uuid, &size)) {
+        uuid = QUuid::fromString(text);
+        size = uuid.minimumSize();
+    }
+    if (minimumSize)
+        *minimumSize = size;
+    return uuid;
+}
+
+QList<QBluetoothUuid> qt_bluetoothUuidsFromStrings(const QStringList &texts)
+{
+    QList<QBluetoothUuid> uuids;
+    uuids.reserve(texts.size());
+    for (const QString &text : texts) {
+        const QBluetoothUuid uuid = qt_bluetoothUuidFromString(text);
+        if (!uuid.isNull())
+            uuids.append(uuid);
+    }
+    return uuids;
+}
 
 void registerQBluetoothUuid()
 {
@@ -550,7 +671,7 @@ QT_WARNING_POP
     explanation of how the five hex fields map to the public data members in QUuid.
 */
 QBluetoothUuid::QBluetoothUuid(const QString &uuid)
-:   QUuid(uuid)
+:   QUuid(qt_bluetoothUuidFromString(uuid))
 {
 }
 
@@ -570,8 +691,7 @@ QBluetoothUuid::QBluetoothUuid(const QUuid &uuid)
 */
 int QBluetoothUuid::minimumSize() const
 {
-    if (data2 == data2Reference && data3 == data3Reference
-        && memcmp(data4, data4Reference, 8) == 0) {
+    if (isBaseUuidDerived(*this)) {
         // 16 or 32 bit Bluetooth UUID
         if (data1 & 0xFFFF0000)
             return 4;
@@ -592,8 +712,7 @@ int QBluetoothUuid::minimumSize() const
 */
 quint16 QBluetoothUuid::toUInt16(bool *ok) const
 {
-    if (data1 & 0xFFFF0000 || data2 != data2Reference || data3 != data3Reference
-        || memcmp(data4, data4Reference, 8) != 0) {
+    if (data1 & 0xFFFF0000 || !isBaseUuidDerived(*this)) {
         // not convertable to 16 bit Bluetooth UUID.
         if (ok)
             *ok = false;
@@ -613,8 +732,7 @@ quint16 QBluetoothUuid::toUInt16(bool *ok) const
 */
 quint32 QBluetoothUuid::toUInt32(bool *ok) const
 {
-    if (data2 != data2Reference || data3 != data3Reference
-        || memcmp(data4, data4Reference, 8) != 0) {
+    if (!isBaseUuidDerived(*this)) {
         // not convertable to 32 bit Bluetooth UUID.
         if (ok)
             *ok = false;
@@ -648,6 +766,402 @@ quint128 QBluetoothUuid::toUInt128() const
     return uuid;
 }
 
+/*!
+    \fn size_t qHash(const QBluetoothUuid &uuid, size_t seed = 0)
+    \relates QBluetoothUuid
+    \since 6.5
+
+    Returns the hash value for \a uuid, using \a seed to seed the calculation.
+
+    UUIDs derived from the Bluetooth base UUID, such as all 16 and 32 bit UUIDs,
+    are hashed by their 32 bit value only.
+*/
+size_t qHash(const QBluetoothUuid &uuid, size_t seed) noexcept
+{
+    if (isBaseUuidDerived(uuid))
+        return qHash(uuid.data1, seed);
+    return qHash(static_cast<const QUuid &>(uuid), seed);
+}
+
+namespace {
+struct UuidName
+{
+    template <typename Enum>
+    constexpr UuidName(Enum type, const char *text) noexcept
+        : uuid(quint16(type)), name(text)
+    {
+    }
+
+    quint16 uuid;
+    const char *name;
+};
+
+using ServiceClass = QBluetoothUuid::ServiceClassUuid;
+using Protocol = QBluetoothUuid::ProtocolUuid;
+using Characteristic = QBluetoothUuid::CharacteristicType;
+using Descriptor = QBluetoothUuid::DescriptorType;
+}
+
+// The names of the known UUIDs, sorted by UUID. They are translated in the
+// QBluetoothServiceDiscoveryAgent context when they are looked up.
+static constexpr UuidName protocolNames[] = {
+    { Protocol::Sdp, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Service Discovery Protocol") },
+    { Protocol::Udp, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "User Datagram Protocol") },
+    { Protocol::Rfcomm, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Radio Frequency Communication") },
+    { Protocol::Tcp, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Transmission Control Protocol") },
+    { Protocol::TcsBin, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Telephony Control Specification - Binary") },
+    { Protocol::TcsAt, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Telephony Control Specification - AT") },
+    { Protocol::Att, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Attribute Protocol") },
+    { Protocol::Obex, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Object Exchange Protocol") },
+    { Protocol::Ip, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Internet Protocol") },
+    { Protocol::Ftp, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "File Transfer Protocol") },
+    { Protocol::Http, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Hypertext Transfer Protocol") },
+    { Protocol::Wsp, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Wireless Short Packet Protocol") },
+    { Protocol::Bnep, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Bluetooth Network Encapsulation Protocol") },
+    { Protocol::Upnp, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Extended Service Discovery Protocol") },
+    { Protocol::Hidp, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Human Interface Device Protocol") },
+    { Protocol::HardcopyControlChannel, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Hardcopy Control Channel") },
+    { Protocol::HardcopyDataChannel, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Hardcopy Data Channel") },
+    { Protocol::HardcopyNotification, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Hardcopy Notification") },
+    { Protocol::Avctp, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Audio/Video Control Transport Protocol") },
+    { Protocol::Avdtp, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Audio/Video Distribution Transport Protocol") },
+    { Protocol::Cmtp, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Common ISDN Access Protocol") },
+    { Protocol::UdiCPlain, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "UdiCPlain") },
+    { Protocol::McapControlChannel, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Multi-Channel Adaptation Protocol - Control") },
+    { Protocol::McapDataChannel, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Multi-Channel Adaptation Protocol - Data") },
+    { Protocol::L2cap, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Layer 2 Control Protocol") },
+};
+
+static constexpr UuidName serviceClassNames[] = {
+    { ServiceClass::ServiceDiscoveryServer, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Service Discovery") },
+    { ServiceClass::BrowseGroupDescriptor, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Browse Group Descriptor") },
+    { ServiceClass::PublicBrowseGroup, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Public Browse Group") },
+    { ServiceClass::SerialPort, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Serial Port Profile") },
+    { ServiceClass::LANAccessUsingPPP, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "LAN Access Profile") },
+    { ServiceClass::DialupNetworking, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Dial-Up Networking") },
+    { ServiceClass::IrMCSync, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Synchronization") },
+    { ServiceClass::ObexObjectPush, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Object Push") },
+    { ServiceClass::OBEXFileTransfer, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "File Transfer") },
+    { ServiceClass::IrMCSyncCommand, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Synchronization Command") },
+    { ServiceClass::Headset, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Headset") },
+    { ServiceClass::AudioSource, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Audio Source") },
+    { ServiceClass::AudioSink, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Audio Sink") },
+    { ServiceClass::AV_RemoteControlTarget, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Audio/Video Remote Control Target") },
+    { ServiceClass::AdvancedAudioDistribution, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Advanced Audio Distribution") },
+    { ServiceClass::AV_RemoteControl, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Audio/Video Remote Control") },
+    { ServiceClass::AV_RemoteControlController, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Audio/Video Remote Control Controller") },
+    { ServiceClass::HeadsetAG, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Headset AG") },
+    { ServiceClass::PANU, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Personal Area Networking (PANU)") },
+    { ServiceClass::NAP, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Personal Area Networking (NAP)") },
+    { ServiceClass::GN, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Personal Area Networking (GN)") },
+    { ServiceClass::DirectPrinting, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Basic Direct Printing (BPP)") },
+    { ServiceClass::ReferencePrinting, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Basic Reference Printing (BPP)") },
+    { ServiceClass::BasicImage, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Basic Imaging Profile") },
+    { ServiceClass::ImagingResponder, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Basic Imaging Responder") },
+    { ServiceClass::ImagingAutomaticArchive, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Basic Imaging Archive") },
+    { ServiceClass::ImagingReferenceObjects, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Basic Imaging Ref Objects") },
+    { ServiceClass::Handsfree, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Hands-Free") },
+    { ServiceClass::HandsfreeAudioGateway, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Hands-Free AG") },
+    { ServiceClass::DirectPrintingReferenceObjectsService, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Basic Printing RefObject Service") },
+    { ServiceClass::ReflectedUI, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Basic Printing Reflected UI") },
+    { ServiceClass::BasicPrinting, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Basic Printing") },
+    { ServiceClass::PrintingStatus, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Basic Printing Status") },
+    { ServiceClass::HumanInterfaceDeviceService, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Human Interface Device") },
+    { ServiceClass::HardcopyCableReplacement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Hardcopy Cable Replacement") },
+    { ServiceClass::HCRPrint, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Hardcopy Cable Replacement Print") },
+    { ServiceClass::HCRScan, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Hardcopy Cable Replacement Scan") },
+    { ServiceClass::SIMAccess, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "SIM Access Server") },
+    { ServiceClass::PhonebookAccessPCE, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Phonebook Access PCE") },
+    { ServiceClass::PhonebookAccessPSE, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Phonebook Access PSE") },
+    { ServiceClass::PhonebookAccess, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Phonebook Access") },
+    { ServiceClass::HeadsetHS, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Headset HS") },
+    { ServiceClass::MessageAccessServer, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Message Access Server") },
+    { ServiceClass::MessageNotificationServer, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Message Notification Server") },
+    { ServiceClass::MessageAccessProfile, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Message Access") },
+    { ServiceClass::GNSS, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Global Navigation Satellite System") },
+    { ServiceClass::GNSSServer, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Global Navigation Satellite System Server") },
+    { ServiceClass::Display3D, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "3D Synchronization Display") },
+    { ServiceClass::Glasses3D, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "3D Synchronization Glasses") },
+    { ServiceClass::Synchronization3D, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "3D Synchronization") },
+    { ServiceClass::MPSProfile, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Multi-Profile Specification (Profile)") },
+    { ServiceClass::MPSService, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Multi-Profile Specification") },
+    { ServiceClass::PnPInformation, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Device Identification") },
+    { ServiceClass::GenericNetworking, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Generic Networking") },
+    { ServiceClass::GenericFileTransfer, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Generic File Transfer") },
+    { ServiceClass::GenericAudio, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Generic Audio") },
+    { ServiceClass::GenericTelephony, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Generic Telephony") },
+    { ServiceClass::VideoSource, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Video Source") },
+    { ServiceClass::VideoSink, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Video Sink") },
+    { ServiceClass::VideoDistribution, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Video Distribution") },
+    { ServiceClass::HDP, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Health Device") },
+    { ServiceClass::HDPSource, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Health Device Source") },
+    { ServiceClass::HDPSink, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Health Device Sink") },
+    { ServiceClass::GenericAccess, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Generic Access") },
+    { ServiceClass::GenericAttribute, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Generic Attribute") },
+    { ServiceClass::ImmediateAlert, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Immediate Alert") },
+    { ServiceClass::LinkLoss, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Link Loss") },
+    { ServiceClass::TxPower, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Tx Power") },
+    { ServiceClass::CurrentTimeService, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Current Time Service") },
+    { ServiceClass::ReferenceTimeUpdateService, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Reference Time Update Service") },
+    { ServiceClass::NextDSTChangeService, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Next DST Change Service") },
+    { ServiceClass::Glucose, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Glucose") },
+    { ServiceClass::HealthThermometer, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Health Thermometer") },
+    { ServiceClass::DeviceInformation, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Device Information") },
+    { ServiceClass::HeartRate, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Heart Rate") },
+    { ServiceClass::PhoneAlertStatusService, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Phone Alert Status Service") },
+    { ServiceClass::BatteryService, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Battery Service") },
+    { ServiceClass::BloodPressure, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Blood Pressure") },
+    { ServiceClass::AlertNotificationService, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Alert Notification Service") },
+    { ServiceClass::HumanInterfaceDevice, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Human Interface Device") },
+    { ServiceClass::ScanParameters, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Scan Parameters") },
+    { ServiceClass::RunningSpeedAndCadence, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Running Speed and Cadence") },
+    { ServiceClass::CyclingSpeedAndCadence, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Cycling Speed and Cadence") },
+    { ServiceClass::CyclingPower, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Cycling Power") },
+    { ServiceClass::LocationAndNavigation, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Location and Navigation") },
+    { ServiceClass::EnvironmentalSensing, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Environmental Sensing") },
+    { ServiceClass::BodyComposition, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Body Composition") },
+    { ServiceClass::UserData, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "User Data") },
+    { ServiceClass::WeightScale, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Weight Scale") },
+    //: Connection management (Bluetooth)
+    { ServiceClass::BondManagement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Bond Management") },
+    { ServiceClass::ContinuousGlucoseMonitoring, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Continuous Glucose Monitoring") },
+};
+
+static constexpr UuidName characteristicNames[] = {
+    //: GAP:  Generic Access Profile (Bluetooth)
+    { Characteristic::DeviceName, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "GAP Device Name") },
+    //: GAP:  Generic Access Profile (Bluetooth)
+    { Characteristic::Appearance, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "GAP Appearance") },
+    //: GAP:  Generic Access Profile (Bluetooth)
+    { Characteristic::PeripheralPrivacyFlag, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "GAP Peripheral Privacy Flag") },
+    //: GAP:  Generic Access Profile (Bluetooth)
+    { Characteristic::ReconnectionAddress, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "GAP Reconnection Address") },
+    { Characteristic::PeripheralPreferredConnectionParameters, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "GAP Peripheral Preferred Connection Parameters") },
+    //: GATT: _G_eneric _Att_ribute Profile (Bluetooth)
+    { Characteristic::ServiceChanged, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "GATT Service Changed") },
+    { Characteristic::AlertLevel, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Alert Level") },
+    { Characteristic::TxPowerLevel, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "TX Power") },
+    { Characteristic::DateTime, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Date Time") },
+    { Characteristic::DayOfWeek, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Day Of Week") },
+    { Characteristic::DayDateTime, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Day Date Time") },
+    { Characteristic::ExactTime256, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Exact Time 256") },
+    { Characteristic::DSTOffset, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "DST Offset") },
+    { Characteristic::TimeZone, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Time Zone") },
+    { Characteristic::LocalTimeInformation, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Local Time Information") },
+    { Characteristic::TimeWithDST, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Time With DST") },
+    { Characteristic::TimeAccuracy, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Time Accuracy") },
+    { Characteristic::TimeSource, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Time Source") },
+    { Characteristic::ReferenceTimeInformation, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Reference Time Information") },
+    { Characteristic::TimeUpdateControlPoint, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Time Update Control Point") },
+    { Characteristic::TimeUpdateState, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Time Update State") },
+    { Characteristic::GlucoseMeasurement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Glucose Measurement") },
+    { Characteristic::BatteryLevel, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Battery Level") },
+    { Characteristic::TemperatureMeasurement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Temperature Measurement") },
+    { Characteristic::TemperatureType, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Temperature Type") },
+    { Characteristic::IntermediateTemperature, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Intermediate Temperature") },
+    { Characteristic::MeasurementInterval, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Measurement Interval") },
+    { Characteristic::BootKeyboardInputReport, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Boot Keyboard Input Report") },
+    { Characteristic::SystemID, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "System ID") },
+    { Characteristic::ModelNumberString, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Model Number String") },
+    { Characteristic::SerialNumberString, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Serial Number String") },
+    { Characteristic::FirmwareRevisionString, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Firmware Revision String") },
+    { Characteristic::HardwareRevisionString, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Hardware Revision String") },
+    { Characteristic::SoftwareRevisionString, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Software Revision String") },
+    { Characteristic::ManufacturerNameString, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Manufacturer Name String") },
+    { Characteristic::IEEE1107320601RegulatoryCertificationDataList, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "IEEE 11073 20601 Regulatory Certification Data List") },
+    { Characteristic::CurrentTime, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Current Time") },
+    //: Angle between geographic and magnetic north
+    { Characteristic::MagneticDeclination, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Magnetic Declination") },
+    { Characteristic::ScanRefresh, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Scan Refresh") },
+    { Characteristic::BootKeyboardOutputReport, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Boot Keyboard Output Report") },
+    { Characteristic::BootMouseInputReport, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Boot Mouse Input Report") },
+    { Characteristic::GlucoseMeasurementContext, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Glucose Measurement Context") },
+    { Characteristic::BloodPressureMeasurement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Blood Pressure Measurement") },
+    { Characteristic::IntermediateCuffPressure, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Intermediate Cuff Pressure") },
+    { Characteristic::HeartRateMeasurement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Heart Rate Measurement") },
+    { Characteristic::BodySensorLocation, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Body Sensor Location") },
+    { Characteristic::HeartRateControlPoint, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Heart Rate Control Point") },
+    { Characteristic::AlertStatus, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Alert Status") },
+    { Characteristic::RingerControlPoint, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Ringer Control Point") },
+    { Characteristic::RingerSetting, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Ringer Setting") },
+    { Characteristic::AlertCategoryIDBitMask, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Alert Category ID Bit Mask") },
+    { Characteristic::AlertCategoryID, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Alert Category ID") },
+    { Characteristic::AlertNotificationControlPoint, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Alert Notification Control Point") },
+    { Characteristic::UnreadAlertStatus, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Unread Alert Status") },
+    { Characteristic::NewAlert, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "New Alert") },
+    { Characteristic::SupportedNewAlertCategory, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Supported New Alert Category") },
+    { Characteristic::SupportedUnreadAlertCategory, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Supported Unread Alert Category") },
+    { Characteristic::BloodPressureFeature, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Blood Pressure Feature") },
+    //: HID: Human Interface Device Profile (Bluetooth)
+    { Characteristic::HIDInformation, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "HID Information") },
+    { Characteristic::ReportMap, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Report Map") },
+    //: HID: Human Interface Device Profile (Bluetooth)
+    { Characteristic::HIDControlPoint, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "HID Control Point") },
+    { Characteristic::Report, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Report") },
+    { Characteristic::ProtocolMode, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Protocol Mode") },
+    { Characteristic::ScanIntervalWindow, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Scan Interval Window") },
+    { Characteristic::PnPID, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "PnP ID") },
+    { Characteristic::GlucoseFeature, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Glucose Feature") },
+    //: Glucose Sensor patient record database.
+    { Characteristic::RecordAccessControlPoint, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Record Access Control Point") },
+    //: RSC: Running Speed and Cadence
+    { Characteristic::RSCMeasurement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "RSC Measurement") },
+    //: RSC: Running Speed and Cadence
+    { Characteristic::RSCFeature, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "RSC Feature") },
+    { Characteristic::SCControlPoint, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "SC Control Point") },
+    //: CSC: Cycling Speed and Cadence
+    { Characteristic::CSCMeasurement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "CSC Measurement") },
+    //: CSC: Cycling Speed and Cadence
+    { Characteristic::CSCFeature, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "CSC Feature") },
+    { Characteristic::SensorLocation, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Sensor Location") },
+    { Characteristic::CyclingPowerMeasurement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Cycling Power Measurement") },
+    { Characteristic::CyclingPowerVector, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Cycling Power Vector") },
+    { Characteristic::CyclingPowerFeature, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Cycling Power Feature") },
+    { Characteristic::CyclingPowerControlPoint, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Cycling Power Control Point") },
+    { Characteristic::LocationAndSpeed, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Location And Speed") },
+    { Characteristic::Navigation, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Navigation") },
+    { Characteristic::PositionQuality, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Position Quality") },
+    { Characteristic::LNFeature, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "LN Feature") },
+    { Characteristic::LNControlPoint, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "LN Control Point") },
+    //: Above/below sea level
+    { Characteristic::Elevation, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Elevation") },
+    { Characteristic::Pressure, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Pressure") },
+    { Characteristic::Temperature, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Temperature") },
+    { Characteristic::Humidity, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Humidity") },
+    //: Wind speed while standing
+    { Characteristic::TrueWindSpeed, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "True Wind Speed") },
+    { Characteristic::TrueWindDirection, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "True Wind Direction") },
+    //: Wind speed while observer is moving
+    { Characteristic::ApparentWindSpeed, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Apparent Wind Speed") },
+    { Characteristic::ApparentWindDirection, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Apparent Wind Direction") },
+    //: Factor by which wind gust is stronger than average wind
+    { Characteristic::GustFactor, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Gust Factor") },
+    { Characteristic::PollenConcentration, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Pollen Concentration") },
+    { Characteristic::UVIndex, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "UV Index") },
+    { Characteristic::Irradiance, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Irradiance") },
+    { Characteristic::Rainfall, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Rainfall") },
+    { Characteristic::WindChill, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Wind Chill") },
+    { Characteristic::HeatIndex, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Heat Index") },
+    { Characteristic::DewPoint, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Dew Point") },
+    //: Environmental sensing related
+    { Characteristic::DescriptorValueChanged, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Descriptor Value Changed") },
+    { Characteristic::AerobicHeartRateLowerLimit, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Aerobic Heart Rate Lower Limit") },
+    { Characteristic::AerobicThreshold, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Aerobic Threshold") },
+    //: Age of person
+    { Characteristic::Age, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Age") },
+    { Characteristic::AnaerobicHeartRateLowerLimit, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Anaerobic Heart Rate Lower Limit") },
+    { Characteristic::AnaerobicHeartRateUpperLimit, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Anaerobic Heart Rate Upper Limit") },
+    { Characteristic::AnaerobicThreshold, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Anaerobic Threshold") },
+    { Characteristic::AerobicHeartRateUpperLimit, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Aerobic Heart Rate Upper Limit") },
+    { Characteristic::DateOfBirth, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Date Of Birth") },
+    { Characteristic::DateOfThresholdAssessment, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Date Of Threshold Assessment") },
+    { Characteristic::EmailAddress, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Email Address") },
+    { Characteristic::FatBurnHeartRateLowerLimit, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Fat Burn Heart Rate Lower Limit") },
+    { Characteristic::FatBurnHeartRateUpperLimit, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Fat Burn Heart Rate Upper Limit") },
+    { Characteristic::FirstName, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "First Name") },
+    { Characteristic::FiveZoneHeartRateLimits, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "5-Zone Heart Rate Limits") },
+    { Characteristic::Gender, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Gender") },
+    { Characteristic::HeartRateMax, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Heart Rate Maximum") },
+    //: Height of a person
+    { Characteristic::Height, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Height") },
+    { Characteristic::HipCircumference, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Hip Circumference") },
+    { Characteristic::LastName, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Last Name") },
+    { Characteristic::MaximumRecommendedHeartRate, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Maximum Recommended Heart Rate") },
+    { Characteristic::RestingHeartRate, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Resting Heart Rate") },
+    { Characteristic::SportTypeForAerobicAnaerobicThresholds, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Sport Type For Aerobic/Anaerobic Thresholds") },
+    { Characteristic::ThreeZoneHeartRateLimits, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "3-Zone Heart Rate Limits") },
+    { Characteristic::TwoZoneHeartRateLimits, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "2-Zone Heart Rate Limits") },
+    { Characteristic::VO2Max, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Oxygen Uptake") },
+    { Characteristic::WaistCircumference, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Waist Circumference") },
+    { Characteristic::Weight, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Weight") },
+    //: Environmental sensing related
+    { Characteristic::DatabaseChangeIncrement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Database Change Increment") },
+    { Characteristic::UserIndex, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "User Index") },
+    { Characteristic::BodyCompositionFeature, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Body Composition Feature") },
+    { Characteristic::BodyCompositionMeasurement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Body Composition Measurement") },
+    { Characteristic::WeightMeasurement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Weight Measurement") },
+    { Characteristic::UserControlPoint, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "User Control Point") },
+    { Characteristic::MagneticFluxDensity2D, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Magnetic Flux Density 2D") },
+    { Characteristic::MagneticFluxDensity3D, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Magnetic Flux Density 3D") },
+    { Characteristic::Language, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Language") },
+    { Characteristic::BarometricPressureTrend, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Barometric Pressure Trend") },
+};
+
+static constexpr UuidName descriptorNames[] = {
+    { Descriptor::CharacteristicExtendedProperties, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Characteristic Extended Properties") },
+    { Descriptor::CharacteristicUserDescription, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Characteristic User Description") },
+    { Descriptor::ClientCharacteristicConfiguration, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Client Characteristic Configuration") },
+    { Descriptor::ServerCharacteristicConfiguration, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Server Characteristic Configuration") },
+    { Descriptor::CharacteristicPresentationFormat, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Characteristic Presentation Format") },
+    { Descriptor::CharacteristicAggregateFormat, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Characteristic Aggregate Format") },
+    { Descriptor::ValidRange, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Valid Range") },
+    { Descriptor::ExternalReportReference, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "External Report Reference") },
+    { Descriptor::ReportReference, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Report Reference") },
+    { Descriptor::EnvironmentalSensingConfiguration, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Environmental Sensing Configuration") },
+    { Descriptor::EnvironmentalSensingMeasurement, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Environmental Sensing Measurement") },
+    { Descriptor::EnvironmentalSensingTriggerSetting, QT_TRANSLATE_NOOP("QBluetoothServiceDiscoveryAgent", "Environmental Sensing Trigger Setting") },
+};
+
+template <size_t N>
+static constexpr bool isSortedByUuid(const UuidName (&table)[N])
+{
+    for (size_t i = 1; i < N; ++i) {
+        if (table[i - 1].uuid >= table[i].uuid)
+            return false;
+    }
+    return true;
+}
+
+static_assert(isSortedByUuid(protocolNames));
+static_assert(isSortedByUuid(serviceClassNames));
+static_assert(isSortedByUuid(characteristicNames));
+static_assert(isSortedByUuid(descriptorNames));
+
+template <size_t N>
+static QString uuidName(const UuidName (&table)[N], uint uuid)
+{
+    const auto end = std::end(table);
+    const auto it = std::lower_bound(std::begin(table), end, uuid,
+                                     [](const UuidName &entry, uint value) {
+        return entry.uuid < value;
+    });
+    if (it == end || it->uuid != uuid)
+        return QString();
+    return QBluetoothServiceDiscoveryAgent::tr(it->name);
+}
+
+namespace {
+struct NameIndexEntry
+{
+    QLatin1String name;
+    QBluetoothUuid uuid;
+};
+
+// All names sorted by their untranslated text, built on first use.
+struct NameIndex
+{
+    NameIndex()
+    {
+        const auto append = [this](const auto &table) {
+            for (const UuidName &entry : table)
+                entries.append({ QLatin1String(entry.name), QBluetoothUuid(entry.uuid) });
+        };
+        append(protocolNames);
+        append(serviceClassNames);
+        append(characteristicNames);
+        append(descriptorNames);
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const NameIndexEntry &a, const NameIndexEntry &b) {
+            return a.name < b.name;
+        });
+    }
+
+    QList<NameIndexEntry> entries;
+};
+}
+
+Q_GLOBAL_STATIC(NameIndex, nameIndex)
+
 /*!
     Returns a human-readable and translated name for the given service class
     represented by \a uuid.
@@ -657,104 +1171,7 @@ quint128 QBluetoothUuid::toUInt128() const
  */
 QString QBluetoothUuid::serviceClassToString(QBluetoothUuid::ServiceClassUuid uuid)
 {
-    switch (uuid) {
-    case QBluetoothUuid::ServiceClassUuid::ServiceDiscoveryServer: return QBluetoothServiceDiscoveryAgent::tr("Service Discovery");
-    case QBluetoothUuid::ServiceClassUuid::BrowseGroupDescriptor: return QBluetoothServiceDiscoveryAgent::tr("Browse Group Descriptor");
-    case QBluetoothUuid::ServiceClassUuid::PublicBrowseGroup: return QBluetoothServiceDiscoveryAgent::tr("Public Browse Group");
-    case QBluetoothUuid::ServiceClassUuid::SerialPort: return QBluetoothServiceDiscoveryAgent::tr("Serial Port Profile");
-    case QBluetoothUuid::ServiceClassUuid::LANAccessUsingPPP: return QBluetoothServiceDiscoveryAgent::tr("LAN Access Profile");
-    case QBluetoothUuid::ServiceClassUuid::DialupNetworking: return QBluetoothServiceDiscoveryAgent::tr("Dial-Up Networking");
-    case QBluetoothUuid::ServiceClassUuid::IrMCSync: return QBluetoothServiceDiscoveryAgent::tr("Synchronization");
-    case QBluetoothUuid::ServiceClassUuid::ObexObjectPush: return QBluetoothServiceDiscoveryAgent::tr("Object Push");
-    case QBluetoothUuid::ServiceClassUuid::OBEXFileTransfer: return QBluetoothServiceDiscoveryAgent::tr("File Transfer");
-    case QBluetoothUuid::ServiceClassUuid::IrMCSyncCommand: return QBluetoothServiceDiscoveryAgent::tr("Synchronization Command");
-    case QBluetoothUuid::ServiceClassUuid::Headset: return QBluetoothServiceDiscoveryAgent::tr("Headset");
-    case QBluetoothUuid::ServiceClassUuid::AudioSource: return QBluetoothServiceDiscoveryAgent::tr("Audio Source");
-    case QBluetoothUuid::ServiceClassUuid::AudioSink: return QBluetoothServiceDiscoveryAgent::tr("Audio Sink");
-    case QBluetoothUuid::ServiceClassUuid::AV_RemoteControlTarget: return QBluetoothServiceDiscoveryAgent::tr("Audio/Video Remote Control Target");
-    case QBluetoothUuid::ServiceClassUuid::AdvancedAudioDistribution: return QBluetoothServiceDiscoveryAgent::tr("Advanced Audio Distribution");
-    case QBluetoothUuid::ServiceClassUuid::AV_RemoteControl: return QBluetoothServiceDiscoveryAgent::tr("Audio/Video Remote Control");
-    case QBluetoothUuid::ServiceClassUuid::AV_RemoteControlController: return QBluetoothServiceDiscoveryAgent::tr("Audio/Video Remote Control Controller");
-    case QBluetoothUuid::ServiceClassUuid::HeadsetAG: return QBluetoothServiceDiscoveryAgent::tr("Headset AG");
-    case QBluetoothUuid::ServiceClassUuid::PANU: return QBluetoothServiceDiscoveryAgent::tr("Personal Area Networking (PANU)");
-    case QBluetoothUuid::ServiceClassUuid::NAP: return QBluetoothServiceDiscoveryAgent::tr("Personal Area Networking (NAP)");
-    case QBluetoothUuid::ServiceClassUuid::GN: return QBluetoothServiceDiscoveryAgent::tr("Personal Area Networking (GN)");
-    case QBluetoothUuid::ServiceClassUuid::DirectPrinting: return QBluetoothServiceDiscoveryAgent::tr("Basic Direct Printing (BPP)");
-    case QBluetoothUuid::ServiceClassUuid::ReferencePrinting: return QBluetoothServiceDiscoveryAgent::tr("Basic Reference Printing (BPP)");
-    case QBluetoothUuid::ServiceClassUuid::BasicImage: return QBluetoothServiceDiscoveryAgent::tr("Basic Imaging Profile");
-    case QBluetoothUuid::ServiceClassUuid::ImagingResponder: return QBluetoothServiceDiscoveryAgent::tr("Basic Imaging Responder");
-    case QBluetoothUuid::ServiceClassUuid::ImagingAutomaticArchive: return QBluetoothServiceDiscoveryAgent::tr("Basic Imaging Archive");
-    case QBluetoothUuid::ServiceClassUuid::ImagingReferenceObjects: return QBluetoothServiceDiscoveryAgent::tr("Basic Imaging Ref Objects");
-    case QBluetoothUuid::ServiceClassUuid::Handsfree: return QBluetoothServiceDiscoveryAgent::tr("Hands-Free");
-    case QBluetoothUuid::ServiceClassUuid::HandsfreeAudioGateway: return QBluetoothServiceDiscoveryAgent::tr("Hands-Free AG");
-    case QBluetoothUuid::ServiceClassUuid::DirectPrintingReferenceObjectsService: return QBluetoothServiceDiscoveryAgent::tr("Basic Printing RefObject Service");
-    case QBluetoothUuid::ServiceClassUuid::ReflectedUI: return QBluetoothServiceDiscoveryAgent::tr("Basic Printing Reflected UI");
-    case QBluetoothUuid::ServiceClassUuid::BasicPrinting: return QBluetoothServiceDiscoveryAgent::tr("Basic Printing");
-    case QBluetoothUuid::ServiceClassUuid::PrintingStatus: return QBluetoothServiceDiscoveryAgent::tr("Basic Printing Status");
-    case QBluetoothUuid::ServiceClassUuid::HumanInterfaceDeviceService: return QBluetoothServiceDiscoveryAgent::tr("Human Interface Device");
-    case QBluetoothUuid::ServiceClassUuid::HardcopyCableReplacement: return QBluetoothServiceDiscoveryAgent::tr("Hardcopy Cable Replacement");
-    case QBluetoothUuid::ServiceClassUuid::HCRPrint: return QBluetoothServiceDiscoveryAgent::tr("Hardcopy Cable Replacement Print");
-    case QBluetoothUuid::ServiceClassUuid::HCRScan: return QBluetoothServiceDiscoveryAgent::tr("Hardcopy Cable Replacement Scan");
-    case QBluetoothUuid::ServiceClassUuid::SIMAccess: return QBluetoothServiceDiscoveryAgent::tr("SIM Access Server");
-    case QBluetoothUuid::ServiceClassUuid::PhonebookAccessPCE: return QBluetoothServiceDiscoveryAgent::tr("Phonebook Access PCE");
-    case QBluetoothUuid::ServiceClassUuid::PhonebookAccessPSE: return QBluetoothServiceDiscoveryAgent::tr("Phonebook Access PSE");
-    case QBluetoothUuid::ServiceClassUuid::PhonebookAccess: return QBluetoothServiceDiscoveryAgent::tr("Phonebook Access");
-    case QBluetoothUuid::ServiceClassUuid::HeadsetHS: return QBluetoothServiceDiscoveryAgent::tr("Headset HS");
-    case QBluetoothUuid::ServiceClassUuid::MessageAccessServer: return QBluetoothServiceDiscoveryAgent::tr("Message Access Server");
-    case QBluetoothUuid::ServiceClassUuid::MessageNotificationServer: return QBluetoothServiceDiscoveryAgent::tr("Message Notification Server");
-    case QBluetoothUuid::ServiceClassUuid::MessageAccessProfile: return QBluetoothServiceDiscoveryAgent::tr("Message Access");
-    case QBluetoothUuid::ServiceClassUuid::GNSS: return QBluetoothServiceDiscoveryAgent::tr("Global Navigation Satellite System");
-    case QBluetoothUuid::ServiceClassUuid::GNSSServer: return QBluetoothServiceDiscoveryAgent::tr("Global Navigation Satellite System Server");
-    case QBluetoothUuid::ServiceClassUuid::Display3D: return QBluetoothServiceDiscoveryAgent::tr("3D Synchronization Display");
-    case QBluetoothUuid::ServiceClassUuid::Glasses3D: return QBluetoothServiceDiscoveryAgent::tr("3D Synchronization Glasses");
-    case QBluetoothUuid::ServiceClassUuid::Synchronization3D: return QBluetoothServiceDiscoveryAgent::tr("3D Synchronization");
-    case QBluetoothUuid::ServiceClassUuid::MPSProfile: return QBluetoothServiceDiscoveryAgent::tr("Multi-Profile Specification (Profile)");
-    case QBluetoothUuid::ServiceClassUuid::MPSService: return QBluetoothServiceDiscoveryAgent::tr("Multi-Profile Specification");
-    case QBluetoothUuid::ServiceClassUuid::PnPInformation: return QBluetoothServiceDiscoveryAgent::tr("Device Identification");
-    case QBluetoothUuid::ServiceClassUuid::GenericNetworking: return QBluetoothServiceDiscoveryAgent::tr("Generic Networking");
-    case QBluetoothUuid::ServiceClassUuid::GenericFileTransfer: return QBluetoothServiceDiscoveryAgent::tr("Generic File Transfer");
-    case QBluetoothUuid::ServiceClassUuid::GenericAudio: return QBluetoothServiceDiscoveryAgent::tr("Generic Audio");
-    case QBluetoothUuid::ServiceClassUuid::GenericTelephony: return QBluetoothServiceDiscoveryAgent::tr("Generic Telephony");
-    case QBluetoothUuid::ServiceClassUuid::VideoSource: return QBluetoothServiceDiscoveryAgent::tr("Video Source");
-    case QBluetoothUuid::ServiceClassUuid::VideoSink: return QBluetoothServiceDiscoveryAgent::tr("Video Sink");
-    case QBluetoothUuid::ServiceClassUuid::VideoDistribution: return QBluetoothServiceDiscoveryAgent::tr("Video Distribution");
-    case QBluetoothUuid::ServiceClassUuid::HDP: return QBluetoothServiceDiscoveryAgent::tr("Health Device");
-    case QBluetoothUuid::ServiceClassUuid::HDPSource: return QBluetoothServiceDiscoveryAgent::tr("Health Device Source");
-    case QBluetoothUuid::ServiceClassUuid::HDPSink: return QBluetoothServiceDiscoveryAgent::tr("Health Device Sink");
-    case QBluetoothUuid::ServiceClassUuid::GenericAccess: return QBluetoothServiceDiscoveryAgent::tr("Generic Access");
-    case QBluetoothUuid::ServiceClassUuid::GenericAttribute: return QBluetoothServiceDiscoveryAgent::tr("Generic Attribute");
-    case QBluetoothUuid::ServiceClassUuid::ImmediateAlert: return QBluetoothServiceDiscoveryAgent::tr("Immediate Alert");
-    case QBluetoothUuid::ServiceClassUuid::LinkLoss: return QBluetoothServiceDiscoveryAgent::tr("Link Loss");
-    case QBluetoothUuid::ServiceClassUuid::TxPower: return QBluetoothServiceDiscoveryAgent::tr("Tx Power");
-    case QBluetoothUuid::ServiceClassUuid::CurrentTimeService: return QBluetoothServiceDiscoveryAgent::tr("Current Time Service");
-    case QBluetoothUuid::ServiceClassUuid::ReferenceTimeUpdateService: return QBluetoothServiceDiscoveryAgent::tr("Reference Time Update Service");
-    case QBluetoothUuid::ServiceClassUuid::NextDSTChangeService: return QBluetoothServiceDiscoveryAgent::tr("Next DST Change Service");
-    case QBluetoothUuid::ServiceClassUuid::Glucose: return QBluetoothServiceDiscoveryAgent::tr("Glucose");
-    case QBluetoothUuid::ServiceClassUuid::HealthThermometer: return QBluetoothServiceDiscoveryAgent::tr("Health Thermometer");
-    case QBluetoothUuid::ServiceClassUuid::DeviceInformation: return QBluetoothServiceDiscoveryAgent::tr("Device Information");
-    case QBluetoothUuid::ServiceClassUuid::HeartRate: return QBluetoothServiceDiscoveryAgent::tr("Heart Rate");
-    case QBluetoothUuid::ServiceClassUuid::PhoneAlertStatusService: return QBluetoothServiceDiscoveryAgent::tr("Phone Alert Status Service");
-    case QBluetoothUuid::ServiceClassUuid::BatteryService: return QBluetoothServiceDiscoveryAgent::tr("Battery Service");
-    case QBluetoothUuid::ServiceClassUuid::BloodPressure: return QBluetoothServiceDiscoveryAgent::tr("Blood Pressure");
-    case QBluetoothUuid::ServiceClassUuid::AlertNotificationService: return QBluetoothServiceDiscoveryAgent::tr("Alert Notification Service");
-    case QBluetoothUuid::ServiceClassUuid::HumanInterfaceDevice: return QBluetoothServiceDiscoveryAgent::tr("Human Interface Device");
-    case QBluetoothUuid::ServiceClassUuid::ScanParameters: return QBluetoothServiceDiscoveryAgent::tr("Scan Parameters");
-    case QBluetoothUuid::ServiceClassUuid::RunningSpeedAndCadence: return QBluetoothServiceDiscoveryAgent::tr("Running Speed and Cadence");
-    case QBluetoothUuid::ServiceClassUuid::CyclingSpeedAndCadence: return QBluetoothServiceDiscoveryAgent::tr("Cycling Speed and Cadence");
-    case QBluetoothUuid::ServiceClassUuid::CyclingPower: return QBluetoothServiceDiscoveryAgent::tr("Cycling Power");
-    case QBluetoothUuid::ServiceClassUuid::LocationAndNavigation: return QBluetoothServiceDiscoveryAgent::tr("Location and Navigation");
-    case QBluetoothUuid::ServiceClassUuid::EnvironmentalSensing: return QBluetoothServiceDiscoveryAgent::tr("Environmental Sensing");
-    case QBluetoothUuid::ServiceClassUuid::BodyComposition: return QBluetoothServiceDiscoveryAgent::tr("Body Composition");
-    case QBluetoothUuid::ServiceClassUuid::UserData: return QBluetoothServiceDiscoveryAgent::tr("User Data");
-    case QBluetoothUuid::ServiceClassUuid::WeightScale: return QBluetoothServiceDiscoveryAgent::tr("Weight Scale");
-    //: Connection management (Bluetooth)
-    case QBluetoothUuid::ServiceClassUuid::BondManagement: return QBluetoothServiceDiscoveryAgent::tr("Bond Management");
-    case QBluetoothUuid::ServiceClassUuid::ContinuousGlucoseMonitoring: return QBluetoothServiceDiscoveryAgent::tr("Continuous Glucose Monitoring");
-    default:
-        break;
-    }
-
-    return QString();
+    return uuidName(serviceClassNames, uint(uuid));
 }
 
 
@@ -768,37 +1185,7 @@ QString QBluetoothUuid::serviceClassToString(QBluetoothUuid::ServiceClassUuid uu
  */
 QString QBluetoothUuid::protocolToString(QBluetoothUuid::ProtocolUuid uuid)
 {
-    switch (uuid) {
-    case QBluetoothUuid::ProtocolUuid::Sdp: return QBluetoothServiceDiscoveryAgent::tr("Service Discovery Protocol");
-    case QBluetoothUuid::ProtocolUuid::Udp: return QBluetoothServiceDiscoveryAgent::tr("User Datagram Protocol");
-    case QBluetoothUuid::ProtocolUuid::Rfcomm: return QBluetoothServiceDiscoveryAgent::tr("Radio Frequency Communication");
-    case QBluetoothUuid::ProtocolUuid::Tcp: return QBluetoothServiceDiscoveryAgent::tr("Transmission Control Protocol");
-    case QBluetoothUuid::ProtocolUuid::TcsBin: return QBluetoothServiceDiscoveryAgent::tr("Telephony Control Specification - Binary");
-    case QBluetoothUuid::ProtocolUuid::TcsAt: return QBluetoothServiceDiscoveryAgent::tr("Telephony Control Specification - AT");
-    case QBluetoothUuid::ProtocolUuid::Att: return QBluetoothServiceDiscoveryAgent::tr("Attribute Protocol");
-    case QBluetoothUuid::ProtocolUuid::Obex: return QBluetoothServiceDiscoveryAgent::tr("Object Exchange Protocol");
-    case QBluetoothUuid::ProtocolUuid::Ip: return QBluetoothServiceDiscoveryAgent::tr("Internet Protocol");
-    case QBluetoothUuid::ProtocolUuid::Ftp: return QBluetoothServiceDiscoveryAgent::tr("File Transfer Protocol");
-    case QBluetoothUuid::ProtocolUuid::Http: return QBluetoothServiceDiscoveryAgent::tr("Hypertext Transfer Protocol");
-    case QBluetoothUuid::ProtocolUuid::Wsp: return QBluetoothServiceDiscoveryAgent::tr("Wireless Short Packet Protocol");
-    case QBluetoothUuid::ProtocolUuid::Bnep: return QBluetoothServiceDiscoveryAgent::tr("Bluetooth Network Encapsulation Protocol");
-    case QBluetoothUuid::ProtocolUuid::Upnp: return QBluetoothServiceDiscoveryAgent::tr("Extended Service Discovery Protocol");
-    case QBluetoothUuid::ProtocolUuid::Hidp: return QBluetoothServiceDiscoveryAgent::tr("Human Interface Device Protocol");
-    case QBluetoothUuid::ProtocolUuid::HardcopyControlChannel: return QBluetoothServiceDiscoveryAgent::tr("Hardcopy Control Channel");
-    case QBluetoothUuid::ProtocolUuid::HardcopyDataChannel: return QBluetoothServiceDiscoveryAgent::tr("Hardcopy Data Channel");
-    case QBluetoothUuid::ProtocolUuid::HardcopyNotification: return QBluetoothServiceDiscoveryAgent::tr("Hardcopy Notification");
-    case QBluetoothUuid::ProtocolUuid::Avctp: return QBluetoothServiceDiscoveryAgent::tr("Audio/Video Control Transport Protocol");
-    case QBluetoothUuid::ProtocolUuid::Avdtp: return QBluetoothServiceDiscoveryAgent::tr("Audio/Video Distribution Transport Protocol");
-    case QBluetoothUuid::ProtocolUuid::Cmtp: return QBluetoothServiceDiscoveryAgent::tr("Common ISDN Access Protocol");
-    case QBluetoothUuid::ProtocolUuid::UdiCPlain: return QBluetoothServiceDiscoveryAgent::tr("UdiCPlain");
-    case QBluetoothUuid::ProtocolUuid::McapControlChannel: return QBluetoothServiceDiscoveryAgent::tr("Multi-Channel Adaptation Protocol - Control");
-    case QBluetoothUuid::ProtocolUuid::McapDataChannel: return QBluetoothServiceDiscoveryAgent::tr("Multi-Channel Adaptation Protocol - Data");
-    case QBluetoothUuid::ProtocolUuid::L2cap: return QBluetoothServiceDiscoveryAgent::tr("Layer 2 Control Protocol");
-    default:
-        break;
-    }
-
-    return QString();
+    return uuidName(protocolNames, uint(uuid));
 }
 
 /*!
@@ -811,202 +1198,7 @@ QString QBluetoothUuid::protocolToString(QBluetoothUuid::ProtocolUuid uuid)
 */
 QString QBluetoothUuid::characteristicToString(CharacteristicType uuid)
 {
-    switch (uuid) {
-    //: GAP:  Generic Access Profile (Bluetooth)
-    case QBluetoothUuid::CharacteristicType::DeviceName: return QBluetoothServiceDiscoveryAgent::tr("GAP Device Name");
-    //: GAP:  Generic Access Profile (Bluetooth)
-    case QBluetoothUuid::CharacteristicType::Appearance: return QBluetoothServiceDiscoveryAgent::tr("GAP Appearance");
-    case QBluetoothUuid::CharacteristicType::PeripheralPrivacyFlag:
-        //: GAP:  Generic Access Profile (Bluetooth)
-        return QBluetoothServiceDiscoveryAgent::tr("GAP Peripheral Privacy Flag");
-    case QBluetoothUuid::CharacteristicType::ReconnectionAddress:
-        //: GAP:  Generic Access Profile (Bluetooth)
-        return QBluetoothServiceDiscoveryAgent::tr("GAP Reconnection Address");
-    case QBluetoothUuid::CharacteristicType::PeripheralPreferredConnectionParameters:
-        return QBluetoothServiceDiscoveryAgent::tr("GAP Peripheral Preferred Connection Parameters");
-    //: GATT: _G_eneric _Att_ribute Profile (Bluetooth)
-    case QBluetoothUuid::CharacteristicType::ServiceChanged: return QBluetoothServiceDiscoveryAgent::tr("GATT Service Changed");
-    case QBluetoothUuid::CharacteristicType::AlertLevel: return QBluetoothServiceDiscoveryAgent::tr("Alert Level");
-    case QBluetoothUuid::CharacteristicType::TxPowerLevel: return QBluetoothServiceDiscoveryAgent::tr("TX Power");
-    case QBluetoothUuid::CharacteristicType::DateTime: return QBluetoothServiceDiscoveryAgent::tr("Date Time");
-    case QBluetoothUuid::CharacteristicType::DayOfWeek: return QBluetoothServiceDiscoveryAgent::tr("Day Of Week");
-    case QBluetoothUuid::CharacteristicType::DayDateTime: return QBluetoothServiceDiscoveryAgent::tr("Day Date Time");
-    case QBluetoothUuid::CharacteristicType::ExactTime256: return QBluetoothServiceDiscoveryAgent::tr("Exact Time 256");
-    case QBluetoothUuid::CharacteristicType::DSTOffset: return QBluetoothServiceDiscoveryAgent::tr("DST Offset");
-    case QBluetoothUuid::CharacteristicType::TimeZone: return QBluetoothServiceDiscoveryAgent::tr("Time Zone");
-    case QBluetoothUuid::CharacteristicType::LocalTimeInformation:
-        return QBluetoothServiceDiscoveryAgent::tr("Local Time Information");
-    case QBluetoothUuid::CharacteristicType::TimeWithDST: return QBluetoothServiceDiscoveryAgent::tr("Time With DST");
-    case QBluetoothUuid::CharacteristicType::TimeAccuracy: return QBluetoothServiceDiscoveryAgent::tr("Time Accuracy");
-    case QBluetoothUuid::CharacteristicType::TimeSource: return QBluetoothServiceDiscoveryAgent::tr("Time Source");
-    case QBluetoothUuid::CharacteristicType::ReferenceTimeInformation:
-        return QBluetoothServiceDiscoveryAgent::tr("Reference Time Information");
-    case QBluetoothUuid::CharacteristicType::TimeUpdateControlPoint:
-        return QBluetoothServiceDiscoveryAgent::tr("Time Update Control Point");
-    case QBluetoothUuid::CharacteristicType::TimeUpdateState: return QBluetoothServiceDiscoveryAgent::tr("Time Update State");
-    case QBluetoothUuid::CharacteristicType::GlucoseMeasurement: return QBluetoothServiceDiscoveryAgent::tr("Glucose Measurement");
-    case QBluetoothUuid::CharacteristicType::BatteryLevel: return QBluetoothServiceDiscoveryAgent::tr("Battery Level");
-    case QBluetoothUuid::CharacteristicType::TemperatureMeasurement:
-        return QBluetoothServiceDiscoveryAgent::tr("Temperature Measurement");
-    case QBluetoothUuid::CharacteristicType::TemperatureType: return QBluetoothServiceDiscoveryAgent::tr("Temperature Type");
-    case QBluetoothUuid::CharacteristicType::IntermediateTemperature:
-        return QBluetoothServiceDiscoveryAgent::tr("Intermediate Temperature");
-    case QBluetoothUuid::CharacteristicType::MeasurementInterval: return QBluetoothServiceDiscoveryAgent::tr("Measurement Interval");
-    case QBluetoothUuid::CharacteristicType::BootKeyboardInputReport: return QBluetoothServiceDiscoveryAgent::tr("Boot Keyboard Input Report");
-    case QBluetoothUuid::CharacteristicType::SystemID: return QBluetoothServiceDiscoveryAgent::tr("System ID");
-    case QBluetoothUuid::CharacteristicType::ModelNumberString: return QBluetoothServiceDiscoveryAgent::tr("Model Number String");
-    case QBluetoothUuid::CharacteristicType::SerialNumberString: return QBluetoothServiceDiscoveryAgent::tr("Serial Number String");
-    case QBluetoothUuid::CharacteristicType::FirmwareRevisionString: return QBluetoothServiceDiscoveryAgent::tr("Firmware Revision String");
-    case QBluetoothUuid::CharacteristicType::HardwareRevisionString: return QBluetoothServiceDiscoveryAgent::tr("Hardware Revision String");
-    case QBluetoothUuid::CharacteristicType::SoftwareRevisionString: return QBluetoothServiceDiscoveryAgent::tr("Software Revision String");
-    case QBluetoothUuid::CharacteristicType::ManufacturerNameString: return QBluetoothServiceDiscoveryAgent::tr("Manufacturer Name String");
-    case QBluetoothUuid::CharacteristicType::IEEE1107320601RegulatoryCertificationDataList:
-        return QBluetoothServiceDiscoveryAgent::tr("IEEE 11073 20601 Regulatory Certification Data List");
-    case QBluetoothUuid::CharacteristicType::CurrentTime: return QBluetoothServiceDiscoveryAgent::tr("Current Time");
-    case QBluetoothUuid::CharacteristicType::ScanRefresh: return QBluetoothServiceDiscoveryAgent::tr("Scan Refresh");
-    case QBluetoothUuid::CharacteristicType::BootKeyboardOutputReport:
-        return QBluetoothServiceDiscoveryAgent::tr("Boot Keyboard Output Report");
-    case QBluetoothUuid::CharacteristicType::BootMouseInputReport: return QBluetoothServiceDiscoveryAgent::tr("Boot Mouse Input Report");
-    case QBluetoothUuid::CharacteristicType::GlucoseMeasurementContext:
-        return QBluetoothServiceDiscoveryAgent::tr("Glucose Measurement Context");
-    case QBluetoothUuid::CharacteristicType::BloodPressureMeasurement:
-        return QBluetoothServiceDiscoveryAgent::tr("Blood Pressure Measurement");
-    case QBluetoothUuid::CharacteristicType::IntermediateCuffPressure:
-        return QBluetoothServiceDiscoveryAgent::tr("Intermediate Cuff Pressure");
-    case QBluetoothUuid::CharacteristicType::HeartRateMeasurement: return QBluetoothServiceDiscoveryAgent::tr("Heart Rate Measurement");
-    case QBluetoothUuid::CharacteristicType::BodySensorLocation: return QBluetoothServiceDiscoveryAgent::tr("Body Sensor Location");
-    case QBluetoothUuid::CharacteristicType::HeartRateControlPoint: return QBluetoothServiceDiscoveryAgent::tr("Heart Rate Control Point");
-    case QBluetoothUuid::CharacteristicType::AlertStatus: return QBluetoothServiceDiscoveryAgent::tr("Alert Status");
-    case QBluetoothUuid::CharacteristicType::RingerControlPoint: return QBluetoothServiceDiscoveryAgent::tr("Ringer Control Point");
-    case QBluetoothUuid::CharacteristicType::RingerSetting: return QBluetoothServiceDiscoveryAgent::tr("Ringer Setting");
-    case QBluetoothUuid::CharacteristicType::AlertCategoryIDBitMask:
-        return QBluetoothServiceDiscoveryAgent::tr("Alert Category ID Bit Mask");
-    case QBluetoothUuid::CharacteristicType::AlertCategoryID: return QBluetoothServiceDiscoveryAgent::tr("Alert Category ID");
-    case QBluetoothUuid::CharacteristicType::AlertNotificationControlPoint:
-        return QBluetoothServiceDiscoveryAgent::tr("Alert Notification Control Point");
-    case QBluetoothUuid::CharacteristicType::UnreadAlertStatus: return QBluetoothServiceDiscoveryAgent::tr("Unread Alert Status");
-    case QBluetoothUuid::CharacteristicType::NewAlert: return QBluetoothServiceDiscoveryAgent::tr("New Alert");
-    case QBluetoothUuid::CharacteristicType::SupportedNewAlertCategory:
-        return QBluetoothServiceDiscoveryAgent::tr("Supported New Alert Category");
-    case QBluetoothUuid::CharacteristicType::SupportedUnreadAlertCategory:
-        return QBluetoothServiceDiscoveryAgent::tr("Supported Unread Alert Category");
-    case QBluetoothUuid::CharacteristicType::BloodPressureFeature: return QBluetoothServiceDiscoveryAgent::tr("Blood Pressure Feature");
-        //: HID: Human Interface Device Profile (Bluetooth)
-    case QBluetoothUuid::CharacteristicType::HIDInformation: return QBluetoothServiceDiscoveryAgent::tr("HID Information");
-    case QBluetoothUuid::CharacteristicType::ReportMap: return QBluetoothServiceDiscoveryAgent::tr("Report Map");
-        //: HID: Human Interface Device Profile (Bluetooth)
-    case QBluetoothUuid::CharacteristicType::HIDControlPoint: return QBluetoothServiceDiscoveryAgent::tr("HID Control Point");
-    case QBluetoothUuid::CharacteristicType::Report: return QBluetoothServiceDiscoveryAgent::tr("Report");
-    case QBluetoothUuid::CharacteristicType::ProtocolMode: return QBluetoothServiceDiscoveryAgent::tr("Protocol Mode");
-    case QBluetoothUuid::CharacteristicType::ScanIntervalWindow: return QBluetoothServiceDiscoveryAgent::tr("Scan Interval Window");
-    case QBluetoothUuid::CharacteristicType::PnPID: return QBluetoothServiceDiscoveryAgent::tr("PnP ID");
-    case QBluetoothUuid::CharacteristicType::GlucoseFeature: return QBluetoothServiceDiscoveryAgent::tr("Glucose Feature");
-    case QBluetoothUuid::CharacteristicType::RecordAccessControlPoint:
-        //: Glucose Sensor patient record database.
-        return QBluetoothServiceDiscoveryAgent::tr("Record Access Control Point");
-    //: RSC: Running Speed and Cadence
-    case QBluetoothUuid::CharacteristicType::RSCMeasurement: return QBluetoothServiceDiscoveryAgent::tr("RSC Measurement");
-    //: RSC: Running Speed and Cadence
-    case QBluetoothUuid::CharacteristicType::RSCFeature: return QBluetoothServiceDiscoveryAgent::tr("RSC Feature");
-    case QBluetoothUuid::CharacteristicType::SCControlPoint: return QBluetoothServiceDiscoveryAgent::tr("SC Control Point");
-    //: CSC: Cycling Speed and Cadence
-    case QBluetoothUuid::CharacteristicType::CSCMeasurement: return QBluetoothServiceDiscoveryAgent::tr("CSC Measurement");
-    //: CSC: Cycling Speed and Cadence
-    case QBluetoothUuid::CharacteristicType::CSCFeature: return QBluetoothServiceDiscoveryAgent::tr("CSC Feature");
-    case QBluetoothUuid::CharacteristicType::SensorLocation: return QBluetoothServiceDiscoveryAgent::tr("Sensor Location");
-    case QBluetoothUuid::CharacteristicType::CyclingPowerMeasurement:
-        return QBluetoothServiceDiscoveryAgent::tr("Cycling Power Measurement");
-    case QBluetoothUuid::CharacteristicType::CyclingPowerVector: return QBluetoothServiceDiscoveryAgent::tr("Cycling Power Vector");
-    case QBluetoothUuid::CharacteristicType::CyclingPowerFeature: return QBluetoothServiceDiscoveryAgent::tr("Cycling Power Feature");
-    case QBluetoothUuid::CharacteristicType::CyclingPowerControlPoint:
-        return QBluetoothServiceDiscoveryAgent::tr("Cycling Power Control Point");
-    case QBluetoothUuid::CharacteristicType::LocationAndSpeed: return QBluetoothServiceDiscoveryAgent::tr("Location And Speed");
-    case QBluetoothUuid::CharacteristicType::Navigation: return QBluetoothServiceDiscoveryAgent::tr("Navigation");
-    case QBluetoothUuid::CharacteristicType::PositionQuality: return QBluetoothServiceDiscoveryAgent::tr("Position Quality");
-    case QBluetoothUuid::CharacteristicType::LNFeature: return QBluetoothServiceDiscoveryAgent::tr("LN Feature");
-    case QBluetoothUuid::CharacteristicType::LNControlPoint: return QBluetoothServiceDiscoveryAgent::tr("LN Control Point");
-    case QBluetoothUuid::CharacteristicType::MagneticDeclination:
-        //: Angle between geographic and magnetic north
-        return QBluetoothServiceDiscoveryAgent::tr("Magnetic Declination");
-    //: Above/below sea level
-    case QBluetoothUuid::CharacteristicType::Elevation: return QBluetoothServiceDiscoveryAgent::tr("Elevation");
-    case QBluetoothUuid::CharacteristicType::Pressure: return QBluetoothServiceDiscoveryAgent::tr("Pressure");
-    case QBluetoothUuid::CharacteristicType::Temperature: return QBluetoothServiceDiscoveryAgent::tr("Temperature");
-    case QBluetoothUuid::CharacteristicType::Humidity: return QBluetoothServiceDiscoveryAgent::tr("Humidity");
-    //: Wind speed while standing
-    case QBluetoothUuid::CharacteristicType::TrueWindSpeed: return QBluetoothServiceDiscoveryAgent::tr("True Wind Speed");
-    case QBluetoothUuid::CharacteristicType::TrueWindDirection : return QBluetoothServiceDiscoveryAgent::tr("True Wind Direction");
-    case QBluetoothUuid::CharacteristicType::ApparentWindSpeed:
-        //: Wind speed while observer is moving
-        return QBluetoothServiceDiscoveryAgent::tr("Apparent Wind Speed");
-    case QBluetoothUuid::CharacteristicType::ApparentWindDirection: return QBluetoothServiceDiscoveryAgent::tr("Apparent Wind Direction");
-    case QBluetoothUuid::CharacteristicType::GustFactor:
-        //: Factor by which wind gust is stronger than average wind
-        return QBluetoothServiceDiscoveryAgent::tr("Gust Factor");
-    case QBluetoothUuid::CharacteristicType::PollenConcentration: return QBluetoothServiceDiscoveryAgent::tr("Pollen Concentration");
-    case QBluetoothUuid::CharacteristicType::UVIndex: return QBluetoothServiceDiscoveryAgent::tr("UV Index");
-    case QBluetoothUuid::CharacteristicType::Irradiance: return QBluetoothServiceDiscoveryAgent::tr("Irradiance");
-    case QBluetoothUuid::CharacteristicType::Rainfall: return QBluetoothServiceDiscoveryAgent::tr("Rainfall");
-    case QBluetoothUuid::CharacteristicType::WindChill: return QBluetoothServiceDiscoveryAgent::tr("Wind Chill");
-    case QBluetoothUuid::CharacteristicType::HeatIndex: return QBluetoothServiceDiscoveryAgent::tr("Heat Index");
-    case QBluetoothUuid::CharacteristicType::DewPoint: return QBluetoothServiceDiscoveryAgent::tr("Dew Point");
-    case QBluetoothUuid::CharacteristicType::DescriptorValueChanged:
-        //: Environmental sensing related
-        return QBluetoothServiceDiscoveryAgent::tr("Descriptor Value Changed");
-    case QBluetoothUuid::CharacteristicType::AerobicHeartRateLowerLimit:
-        return QBluetoothServiceDiscoveryAgent::tr("Aerobic Heart Rate Lower Limit");
-    case QBluetoothUuid::CharacteristicType::AerobicHeartRateUpperLimit:
-        return QBluetoothServiceDiscoveryAgent::tr("Aerobic Heart Rate Upper Limit");
-    case QBluetoothUuid::CharacteristicType::AerobicThreshold: return QBluetoothServiceDiscoveryAgent::tr("Aerobic Threshold");
-    //: Age of person
-    case QBluetoothUuid::CharacteristicType::Age: return QBluetoothServiceDiscoveryAgent::tr("Age");
-    case QBluetoothUuid::CharacteristicType::AnaerobicHeartRateLowerLimit:
-        return QBluetoothServiceDiscoveryAgent::tr("Anaerobic Heart Rate Lower Limit");
-    case QBluetoothUuid::CharacteristicType::AnaerobicHeartRateUpperLimit:
-        return QBluetoothServiceDiscoveryAgent::tr("Anaerobic Heart Rate Upper Limit");
-    case QBluetoothUuid::CharacteristicType::AnaerobicThreshold: return QBluetoothServiceDiscoveryAgent::tr("Anaerobic Threshold");
-    case QBluetoothUuid::CharacteristicType::DateOfBirth: return QBluetoothServiceDiscoveryAgent::tr("Date Of Birth");
-    case QBluetoothUuid::CharacteristicType::DateOfThresholdAssessment: return QBluetoothServiceDiscoveryAgent::tr("Date Of Threshold Assessment");
-    case QBluetoothUuid::CharacteristicType::EmailAddress: return QBluetoothServiceDiscoveryAgent::tr("Email Address");
-    case QBluetoothUuid::CharacteristicType::FatBurnHeartRateLowerLimit:
-        return QBluetoothServiceDiscoveryAgent::tr("Fat Burn Heart Rate Lower Limit");
-    case QBluetoothUuid::CharacteristicType::FatBurnHeartRateUpperLimit:
-        return QBluetoothServiceDiscoveryAgent::tr("Fat Burn Heart Rate Upper Limit");
-    case QBluetoothUuid::CharacteristicType::FirstName: return QBluetoothServiceDiscoveryAgent::tr("First Name");
-    case QBluetoothUuid::CharacteristicType::FiveZoneHeartRateLimits: return QBluetoothServiceDiscoveryAgent::tr("5-Zone Heart Rate Limits");
-    case QBluetoothUuid::CharacteristicType::Gender: return QBluetoothServiceDiscoveryAgent::tr("Gender");
-    case QBluetoothUuid::CharacteristicType::HeartRateMax: return QBluetoothServiceDiscoveryAgent::tr("Heart Rate Maximum");
-    //: Height of a person
-    case QBluetoothUuid::CharacteristicType::Height: return QBluetoothServiceDiscoveryAgent::tr("Height");
-    case QBluetoothUuid::CharacteristicType::HipCircumference: return QBluetoothServiceDiscoveryAgent::tr("Hip Circumference");
-    case QBluetoothUuid::CharacteristicType::LastName: return QBluetoothServiceDiscoveryAgent::tr("Last Name");
-    case QBluetoothUuid::CharacteristicType::MaximumRecommendedHeartRate:
-        return QBluetoothServiceDiscoveryAgent::tr("Maximum Recommended Heart Rate");
-    case QBluetoothUuid::CharacteristicType::RestingHeartRate: return QBluetoothServiceDiscoveryAgent::tr("Resting Heart Rate");
-    case QBluetoothUuid::CharacteristicType::SportTypeForAerobicAnaerobicThresholds:
-          return QBluetoothServiceDiscoveryAgent::tr("Sport Type For Aerobic/Anaerobic Thresholds");
-    case QBluetoothUuid::CharacteristicType::ThreeZoneHeartRateLimits: return QBluetoothServiceDiscoveryAgent::tr("3-Zone Heart Rate Limits");
-    case QBluetoothUuid::CharacteristicType::TwoZoneHeartRateLimits: return QBluetoothServiceDiscoveryAgent::tr("2-Zone Heart Rate Limits");
-    case QBluetoothUuid::CharacteristicType::VO2Max: return QBluetoothServiceDiscoveryAgent::tr("Oxygen Uptake");
-    case QBluetoothUuid::CharacteristicType::WaistCircumference: return QBluetoothServiceDiscoveryAgent::tr("Waist Circumference");
-    case QBluetoothUuid::CharacteristicType::Weight: return QBluetoothServiceDiscoveryAgent::tr("Weight");
-    case QBluetoothUuid::CharacteristicType::DatabaseChangeIncrement:
-        //: Environmental sensing related
-        return QBluetoothServiceDiscoveryAgent::tr("Database Change Increment");
-    case QBluetoothUuid::CharacteristicType::UserIndex: return QBluetoothServiceDiscoveryAgent::tr("User Index");
-    case QBluetoothUuid::CharacteristicType::BodyCompositionFeature: return QBluetoothServiceDiscoveryAgent::tr("Body Composition Feature");
-    case QBluetoothUuid::CharacteristicType::BodyCompositionMeasurement: return QBluetoothServiceDiscoveryAgent::tr("Body Composition Measurement");
-    case QBluetoothUuid::CharacteristicType::WeightMeasurement: return QBluetoothServiceDiscoveryAgent::tr("Weight Measurement");
-    case QBluetoothUuid::CharacteristicType::UserControlPoint: return QBluetoothServiceDiscoveryAgent::tr("User Control Point");
-    case QBluetoothUuid::CharacteristicType::MagneticFluxDensity2D: return QBluetoothServiceDiscoveryAgent::tr("Magnetic Flux Density 2D");
-    case QBluetoothUuid::CharacteristicType::MagneticFluxDensity3D: return QBluetoothServiceDiscoveryAgent::tr("Magnetic Flux Density 3D");
-    case QBluetoothUuid::CharacteristicType::Language: return QBluetoothServiceDiscoveryAgent::tr("Language");
-    case QBluetoothUuid::CharacteristicType::BarometricPressureTrend: return QBluetoothServiceDiscoveryAgent::tr("Barometric Pressure Trend");
-    default:
-        break;
-    }
-
-    return QString();
+    return uuidName(characteristicNames, uint(uuid));
 }
 
 /*!
@@ -1019,36 +1211,29 @@ QString QBluetoothUuid::characteristicToString(CharacteristicType uuid)
 */
 QString QBluetoothUuid::descriptorToString(QBluetoothUuid::DescriptorType uuid)
 {
-    switch (uuid) {
-    case QBluetoothUuid::DescriptorType::CharacteristicExtendedProperties:
-        return QBluetoothServiceDiscoveryAgent::tr("Characteristic Extended Properties");
-    case QBluetoothUuid::DescriptorType::CharacteristicUserDescription:
-        return QBluetoothServiceDiscoveryAgent::tr("Characteristic User Description");
-    case QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration:
-        return QBluetoothServiceDiscoveryAgent::tr("Client Characteristic Configuration");
-    case QBluetoothUuid::DescriptorType::ServerCharacteristicConfiguration:
-        return QBluetoothServiceDiscoveryAgent::tr("Server Characteristic Configuration");
-    case QBluetoothUuid::DescriptorType::CharacteristicPresentationFormat:
-        return QBluetoothServiceDiscoveryAgent::tr("Characteristic Presentation Format");
-    case QBluetoothUuid::DescriptorType::CharacteristicAggregateFormat:
-        return QBluetoothServiceDiscoveryAgent::tr("Characteristic Aggregate Format");
-    case QBluetoothUuid::DescriptorType::ValidRange:
-        return QBluetoothServiceDiscoveryAgent::tr("Valid Range");
-    case QBluetoothUuid::DescriptorType::ExternalReportReference:
-        return QBluetoothServiceDiscoveryAgent::tr("External Report Reference");
-    case QBluetoothUuid::DescriptorType::ReportReference:
-        return QBluetoothServiceDiscoveryAgent::tr("Report Reference");
-    case QBluetoothUuid::DescriptorType::EnvironmentalSensingConfiguration:
-        return QBluetoothServiceDiscoveryAgent::tr("Environmental Sensing Configuration");
-    case QBluetoothUuid::DescriptorType::EnvironmentalSensingMeasurement:
-        return QBluetoothServiceDiscoveryAgent::tr("Environmental Sensing Measurement");
-    case QBluetoothUuid::DescriptorType::EnvironmentalSensingTriggerSetting:
-        return QBluetoothServiceDiscoveryAgent::tr("Environmental Sensing Trigger Setting");
-    default:
-        break;
-    }
+    return uuidName(descriptorNames, uint(uuid));
+}
 
-    return QString();
+/*!
+    Returns the UUID of the protocol, service class, characteristic type or
+    descriptor type whose untranslated name is \a name, or a null UUID if there
+    is no such UUID. If several UUIDs share a name, the smallest one is returned.
+
+    This is the reverse of serviceClassToString(), protocolToString(),
+    characteristicToString() and descriptorToString() without translation.
+
+    \since 6.5
+*/
+QBluetoothUuid QBluetoothUuid::fromName(QStringView name)
+{
+    const QList<NameIndexEntry> &entries = nameIndex->entries;
+    const auto it = std::lower_bound(entries.cbegin(), entries.cend(), name,
+                                     [](const NameIndexEntry &entry, QStringView value) {
+        return entry.name.compare(value) < 0;
+    });
+    if (it == entries.cend() || it->name != name)
+        return QBluetoothUuid();
+    return it->uuid;
 }
 
 /*!
@@ -375,11 +375,14 @@ public:
     static QString protocolToString(ProtocolUuid uuid);
     static QString characteristicToString(CharacteristicType uuid);
     static QString descriptorToString(DescriptorType uuid);
+    static QBluetoothUuid fromName(QStringView name);
 
 private:
     static bool equals(const QBluetoothUuid &a, const QBluetoothUuid &b);
 };
 
+Q_BLUETOOTH_EXPORT size_t qHash(const QBluetoothUuid &uuid, size_t seed = 0) noexcept;
+
 #ifndef QT_NO_DATASTREAM
 inline QDataStream &operator<<(QDataStream &s, const QBluetoothUuid &uuid)
 {
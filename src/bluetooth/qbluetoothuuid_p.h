@@ -0,0 +1,38 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QBLUETOOTHUUID_P_H
+#define QBLUETOOTHUUID_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qbluetoothuuid.h"
+
+#include <QtCore/qlist.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qstringview.h>
+
+QT_BEGIN_NAMESPACE
+
+// Converts a UUID string like the QBluetoothUuid constructor does. The form the
+// platforms report, "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx", is parsed without
+// QUuid, and UUIDs derived from the base UUID only have their first field decoded.
+// If minimumSize is set, QBluetoothUuid::minimumSize() of the result is stored in it.
+QBluetoothUuid qt_bluetoothUuidFromString(QStringView text, int *minimumSize = nullptr);
+
+// Converts a list of UUID strings, such as the UUIDs property of a BlueZ device,
+// leaving out the invalid ones.
+QList<QBluetoothUuid> qt_bluetoothUuidsFromStrings(const QStringList &texts);
+
+QT_END_NAMESPACE
+
+#endif // QBLUETOOTHUUID_P_H
@@ -9,6 +9,7 @@
 
 #include <QtCore/qloggingcategory.h>
 
+#include <algorithm>
 #include <cstring>
 
 QT_BEGIN_NAMESPACE
@@ -29,9 +30,46 @@ struct AdvParams {
     quint8 filterPolicy;
 } __attribute__ ((packed));
 
+struct ExtAdvParams {
+    quint8 handle;
+    quint16 eventProperties;
+    quint8 minInterval[3];
+    quint8 maxInterval[3];
+    quint8 channelMap;
+    quint8 ownAddrType;
+    quint8 peerAddrType;
+    bdaddr_t peerAddr;
+    quint8 filterPolicy;
+    qint8 txPower;
+    quint8 primaryPhy;
+    quint8 secondaryMaxSkip;
+    quint8 secondaryPhy;
+    quint8 sid;
+    quint8 scanRequestNotification;
+} __attribute__ ((packed));
+
+struct ExtAdvEnableSet {
+    quint8 handle;
+    quint16 duration;
+    quint8 maxEvents;
+} __attribute__ ((packed));
+
+static constexpr qsizetype legacyDataLength = 31;
+// Spec v5.3, Vol 4, Part E, 7.8.57, the most a controller may support
+static constexpr qsizetype maxExtendedDataLength = 1650;
+static constexpr qsizetype maxExtendedDataFragment = 251;
+// Spec v5.3, Vol 4, Part E, 7.8.62, the data cannot be fragmented while periodic advertising runs
+static constexpr qsizetype maxPeriodicDataLength = 252;
+// BlueZ allocates its advertising instances from the bottom of the range
+static constexpr quint8 lastAdvertisingHandle = 0xef;
+
+// The data is built in place, with room for the largest extended advertising data.
 struct AdvData {
-    quint8 length;
-    quint8 data[31];
+    explicit AdvData(qsizetype capacity) : capacity(capacity) {}
+
+    const qsizetype capacity;
+    qsizetype length = 0;
+    quint8 data[maxExtendedDataLength];
 };
 
 struct WhiteListParams {
@@ -46,27 +84,42 @@ static QByteArray byteArrayFromStruct(const T &data)
     return QByteArray(reinterpret_cast<const char *>(&data), sizeof data);
 }
 
-QLeAdvertiserBluez::QLeAdvertiserBluez(const QLowEnergyAdvertisingParameters &params,
-                                       const QLowEnergyAdvertisingData &advertisingData,
-                                       const QLowEnergyAdvertisingData &scanResponseData,
+static QByteArray significantBytes(const AdvData &data)
+{
+    return QByteArray(reinterpret_cast<const char *>(data.data), data.length);
+}
+
+static quint8 advertisingHandle(qsizetype set)
+{
+    return lastAdvertisingHandle - quint8(set);
+}
+
+QLeAdvertiserBluez::QLeAdvertiserBluez(const QList<QLowEnergyAdvertisingParameters> &params,
+                                       const QList<QLowEnergyAdvertisingData> &advertisingData,
+                                       const QList<QLowEnergyAdvertisingData> &scanResponseData,
                                        HciManager &hciManager, QObject *parent)
     : QLeAdvertiser(params, advertisingData, scanResponseData, parent), m_hciManager(hciManager)
 {
-    connect(&m_hciManager, &HciManager::commandCompleted, this,
-            &QLeAdvertiserBluez::handleCommandCompleted);
 }
 
 QLeAdvertiserBluez::~QLeAdvertiserBluez()
 {
-    disconnect(&m_hciManager, &HciManager::commandCompleted, this,
-               &QLeAdvertiserBluez::handleCommandCompleted);
     doStopAdvertising();
+    // nobody waits for the results anymore, the rest follows the command in flight
+    for (qsizetype i = 1; i < m_pendingCommands.size(); ++i) {
+        const Command &c = m_pendingCommands.at(i);
+        m_hciManager.queueCommand(QBluezConst::OgfLinkControl, c.ocf, c.data);
+    }
 }
 
 void QLeAdvertiserBluez::doStartAdvertising()
 {
-    if (!m_hciManager.monitorEvent(HciManager::HciEvent::EVT_CMD_COMPLETE)) {
-        handleError();
+    m_advertising = true;
+    m_sentAdvData.clear();
+    m_sentResponseData.clear();
+    if (usesExtendedCommands()) {
+        queueExtendedAdvertisingCommands();
+        sendNextCommand();
         return;
     }
 
@@ -81,13 +134,61 @@ void QLeAdvertiserBluez::doStartAdvertising()
 
 void QLeAdvertiserBluez::doStopAdvertising()
 {
-    toggleAdvertising(false);
+    m_advertising = false;
+    m_sentAdvData.clear();
+    m_sentResponseData.clear();
+    if (usesExtendedCommands()) {
+        for (qsizetype set = 0; set < setCount(); ++set) {
+            if (isPeriodic(set))
+                togglePeriodicAdvertising(set, false);
+        }
+        toggleExtendedAdvertising(false);
+        // Spec v5.3, Vol 4, Part E, 7.8.59
+        for (qsizetype set = 0; set < setCount(); ++set)
+            queueCommand(QBluezConst::OcfLeRemoveAdvSet, QByteArray(1, advertisingHandle(set)));
+    } else {
+        toggleAdvertising(false);
+    }
     sendNextCommand();
 }
 
-void QLeAdvertiserBluez::queueCommand(QBluezConst::OpCodeCommandField ocf, const QByteArray &data)
+void QLeAdvertiserBluez::doSetPeriodicAdvertisingData(qsizetype set,
+                                                      const QLowEnergyAdvertisingData &data)
+{
+    m_periodicData.insert(set, data);
+    if (!m_advertising || set >= setCount() || !isPeriodic(set))
+        return; // queued along with the set, see setExtendedData()
+
+    const bool isIdle = m_pendingCommands.isEmpty();
+    setPeriodicData(set);
+    if (isIdle)
+        sendNextCommand();
+}
+
+/*
+ * Sends the changed data of set while it keeps advertising. Nothing is sent if
+ * the data encodes to the bytes the controller already has.
+ */
+void QLeAdvertiserBluez::doUpdateAdvertisingData(qsizetype set)
+{
+    if (!m_advertising || !m_sentAdvData.contains(set))
+        return; // queued along with the set, see setData() and setExtendedData()
+
+    const bool isIdle = m_pendingCommands.isEmpty();
+    if (usesExtendedCommands()) {
+        queueExtendedSetData(set, true);
+    } else {
+        setData(false, true);
+        setData(true, true);
+    }
+    if (isIdle)
+        sendNextCommand();
+}
+
+void QLeAdvertiserBluez::queueCommand(QBluezConst::OpCodeCommandField ocf, const QByteArray &data,
+                                      qsizetype set)
 {
-    m_pendingCommands << Command(ocf, data);
+    m_pendingCommands << Command(ocf, data, set);
 }
 
 void QLeAdvertiserBluez::sendNextCommand()
@@ -96,8 +197,15 @@ void QLeAdvertiserBluez::sendNextCommand()
         // TODO: Unmonitor event.
         return;
     }
+    // the commands depend on each other's results, the next one waits for this one
     const Command &c = m_pendingCommands.first();
-    if (!m_hciManager.sendCommand(QBluezConst::OgfLinkControl, c.ocf, c.data)) {
+    const auto handleResult = [this, generation = m_commandGeneration](
+                                      const HciManager::CommandResult &result) {
+        if (generation == m_commandGeneration)
+            handleCommandCompleted(result);
+    };
+    if (!m_hciManager.queueCommand(QBluezConst::OgfLinkControl, c.ocf, c.data, this,
+                                   handleResult)) {
         handleError();
         return;
     }
@@ -155,42 +263,57 @@ void QLeAdvertiserBluez::setAdvertisingParams()
     queueCommand(QBluezConst::OcfLeSetAdvParams, paramsData);
 }
 
-static quint16 forceIntoRange(quint16 val, quint16 min, quint16 max)
+static quint32 forceIntoRange(quint32 val, quint32 min, quint32 max)
 {
     return qMin(qMax(val, min), max);
 }
 
-void QLeAdvertiserBluez::setAdvertisingInterval(AdvParams &params)
+// the advertising interval in units of 0.625 ms
+static void advertisingInterval(const QLowEnergyAdvertisingParameters &parameters,
+                                quint32 specMinimum, quint32 specMaximum,
+                                quint32 *minInterval, quint32 *maxInterval)
 {
     const double multiplier = 0.625;
-    const quint16 minVal = parameters().minimumInterval() / multiplier;
-    const quint16 maxVal = parameters().maximumInterval() / multiplier;
+    const quint32 minVal = parameters.minimumInterval() / multiplier;
+    const quint32 maxVal = parameters.maximumInterval() / multiplier;
     Q_ASSERT(minVal <= maxVal);
-    const quint16 specMinimum =
+    *minInterval = forceIntoRange(minVal, specMinimum, specMaximum);
+    *maxInterval = forceIntoRange(maxVal, specMinimum, specMaximum);
+    Q_ASSERT(*minInterval <= *maxInterval);
+}
+
+void QLeAdvertiserBluez::setAdvertisingInterval(AdvParams &params)
+{
+    const quint32 specMinimum =
             parameters().mode() == QLowEnergyAdvertisingParameters::AdvScanInd
             || parameters().mode() == QLowEnergyAdvertisingParameters::AdvNonConnInd ? 0xa0 : 0x20;
-    const quint16 specMaximum = 0x4000;
-    params.minInterval = qToLittleEndian(forceIntoRange(minVal, specMinimum, specMaximum));
-    params.maxInterval = qToLittleEndian(forceIntoRange(maxVal, specMinimum, specMaximum));
-    Q_ASSERT(params.minInterval <= params.maxInterval);
+    const quint32 specMaximum = 0x4000;
+    quint32 minInterval;
+    quint32 maxInterval;
+    advertisingInterval(parameters(), specMinimum, specMaximum, &minInterval, &maxInterval);
+    params.minInterval = qToLittleEndian(quint16(minInterval));
+    params.maxInterval = qToLittleEndian(quint16(maxInterval));
 }
 
-void QLeAdvertiserBluez::setPowerLevel(AdvData &advData)
+void QLeAdvertiserBluez::setPowerLevel(AdvData &advData, quint8 powerLevel)
 {
-    if (m_sendPowerLevel) {
-        advData.data[advData.length++] = 2;
-        advData.data[advData.length++]= 0xa;
-        advData.data[advData.length++] = m_powerLevel;
-    }
+    if (advData.capacity - advData.length < 3)
+        return;
+    advData.data[advData.length++] = 2;
+    advData.data[advData.length++]= 0xa;
+    advData.data[advData.length++] = powerLevel;
 }
 
-void QLeAdvertiserBluez::setFlags(AdvData &advData)
+void QLeAdvertiserBluez::setFlags(const QLowEnergyAdvertisingData &src, AdvData &advData)
 {
     // TODO: Discoverability flags are incompatible with ADV_DIRECT_IND
+    if (advData.capacity - advData.length < 3)
+        return;
+    const QLowEnergyAdvertisingData::Discoverability discoverability = src.discoverability();
     quint8 flags = 0;
-    if (advertisingData().discoverability() == QLowEnergyAdvertisingData::DiscoverabilityLimited)
+    if (discoverability == QLowEnergyAdvertisingData::DiscoverabilityLimited)
         flags |= 0x1;
-    else if (advertisingData().discoverability() == QLowEnergyAdvertisingData::DiscoverabilityGeneral)
+    else if (discoverability == QLowEnergyAdvertisingData::DiscoverabilityGeneral)
         flags |= 0x2;
     flags |= 0x4; // "BR/EDR not supported". Otherwise clients might try to connect over Bluetooth classic.
     if (flags) {
@@ -220,8 +343,10 @@ static void addServicesData(AdvData &data, const QList<T> &services)
     if (services.isEmpty())
         return;
     constexpr auto sizeofT = static_cast<int>(sizeof(T)); // signed is more convenient
-    const qsizetype spaceAvailable = sizeof data.data - data.length;
-    const qsizetype maxServices = (std::max)((spaceAvailable - 2) / sizeofT, services.size());
+    const qsizetype spaceAvailable = data.capacity - data.length;
+    // the length of a data structure is a single byte
+    const qsizetype maxServices = (std::min)({ (spaceAvailable - 2) / sizeofT, services.size(),
+                                               qsizetype((0xff - 1) / sizeofT) });
     if (maxServices <= 0) {
         qCWarning(QT_BT_BLUEZ) << "services data does not fit into advertising data packet";
         return;
@@ -276,7 +401,8 @@ void QLeAdvertiserBluez::setManufacturerData(const QLowEnergyAdvertisingData &sr
         return;
 
     const QByteArray manufacturerData = src.manufacturerData();
-    if (dest.length >= sizeof dest.data - 1 - 1 - 2 - manufacturerData.size()) {
+    if (dest.length >= dest.capacity - 1 - 1 - 2 - manufacturerData.size()
+            || manufacturerData.size() > 0xff - 1 - 2) {
         qCWarning(QT_BT_BLUEZ) << "manufacturer data does not fit into advertising data packet";
         return;
     }
@@ -293,14 +419,14 @@ void QLeAdvertiserBluez::setLocalNameData(const QLowEnergyAdvertisingData &src,
 {
     if (src.localName().isEmpty())
         return;
-    if (dest.length >= sizeof dest.data - 3) {
+    if (dest.length >= dest.capacity - 3) {
         qCWarning(QT_BT_BLUEZ) << "local name does not fit into advertising data";
         return;
     }
 
     const QByteArray localNameUtf8 = src.localName().toUtf8();
     const qsizetype fullSize = localNameUtf8.size() + 1 + 1;
-    const qsizetype size = (std::min)(fullSize, qsizetype(sizeof dest.data - dest.length));
+    const qsizetype size = (std::min)({ fullSize, dest.capacity - dest.length, qsizetype(0xff + 1) });
     const bool isComplete = size == fullSize;
     dest.data[dest.length++] = size - 1;
     const int dataType = isComplete ? 0x9 : 0x8;
@@ -309,24 +435,26 @@ void QLeAdvertiserBluez::setLocalNameData(const QLowEnergyAdvertisingData &src,
     dest.length += size - 2;
 }
 
-void QLeAdvertiserBluez::setData(bool isScanResponseData)
+/*!
+    \internal
+
+    Appends \a sourceData to \a theData, the flags only if \a includeFlags is \c true.
+    The TX power level is left out if \a powerLevel is \nullptr.
+ */
+void QLeAdvertiserBluez::buildData(const QLowEnergyAdvertisingData &sourceData, bool includeFlags,
+                                   const quint8 *powerLevel, AdvData &theData)
 {
     // Spec v4.2, Vol 3, Part C, 11 and Supplement, Part 1
-    AdvData theData;
-    static_assert(sizeof theData == 32, "unexpected struct size");
-    theData.length = 0;
-
-    const QLowEnergyAdvertisingData &sourceData = isScanResponseData
-            ? scanResponseData() : advertisingData();
 
     if (const QByteArray rawData = sourceData.rawData(); !rawData.isEmpty()) {
-        theData.length = (std::min)(qsizetype(sizeof theData.data), rawData.size());
-        std::memcpy(theData.data, rawData.data(), theData.length);
+        const qsizetype size = (std::min)(theData.capacity - theData.length, rawData.size());
+        std::memcpy(theData.data + theData.length, rawData.data(), size);
+        theData.length += size;
     } else {
-        if (sourceData.includePowerLevel())
-            setPowerLevel(theData);
-        if (!isScanResponseData)
-            setFlags(theData);
+        if (sourceData.includePowerLevel() && powerLevel)
+            setPowerLevel(theData, *powerLevel);
+        if (includeFlags)
+            setFlags(sourceData, theData);
 
         // Insert new constant-length data here.
 
@@ -334,18 +462,34 @@ void QLeAdvertiserBluez::setData(bool isScanResponseData)
         setServicesData(sourceData, theData);
         setManufacturerData(sourceData, theData);
     }
+}
+
+void QLeAdvertiserBluez::setData(bool isScanResponseData, bool onlyIfChanged)
+{
+    AdvData theData(legacyDataLength);
+    buildData(isScanResponseData ? scanResponseData() : advertisingData(), !isScanResponseData,
+              m_sendPowerLevel ? &m_powerLevel : nullptr, theData);
 
-    std::memset(theData.data + theData.length, 0, sizeof theData.data - theData.length);
-    const QByteArray dataToSend = byteArrayFromStruct(theData);
+    QByteArray &sentData = isScanResponseData ? m_sentResponseData[0] : m_sentAdvData[0];
+    const QByteArray payload = significantBytes(theData);
+    if (onlyIfChanged && payload == sentData)
+        return;
+
+    // the length is followed by the significant part, padded with zeros
+    QByteArray dataToSend(1 + legacyDataLength, '\0');
+    dataToSend[0] = char(theData.length);
+    std::memcpy(dataToSend.data() + 1, theData.data, theData.length);
 
     if (!isScanResponseData) {
         qCDebug(QT_BT_BLUEZ) << "advertising data:" << dataToSend.toHex();
         queueCommand(QBluezConst::OcfLeSetAdvData, dataToSend);
+        sentData = payload;
     } else if ((parameters().mode() == QLowEnergyAdvertisingParameters::AdvScanInd
                || parameters().mode() == QLowEnergyAdvertisingParameters::AdvInd)
-               && theData.length > 0) {
+               && (theData.length > 0 || onlyIfChanged)) {
         qCDebug(QT_BT_BLUEZ) << "scan response data:" << dataToSend.toHex();
         queueCommand(QBluezConst::OcfLeSetScanResponseData, dataToSend);
+        sentData = payload;
     }
 }
 
@@ -364,12 +508,24 @@ void QLeAdvertiserBluez::setScanResponseData()
 void QLeAdvertiserBluez::setWhiteList()
 {
     // Spec v4.2, Vol 2, Part E, 7.8.15-16
-    if (parameters().filterPolicy() == QLowEnergyAdvertisingParameters::IgnoreWhiteList)
+    // the controller has a single white list, which all advertising sets share
+    QList<QLowEnergyAdvertisingParameters::AddressInfo> whiteListInfos;
+    bool usesWhiteList = false;
+    for (qsizetype set = 0; set < setCount(); ++set) {
+        if (parameters(set).filterPolicy() == QLowEnergyAdvertisingParameters::IgnoreWhiteList)
+            continue;
+        usesWhiteList = true;
+        const QList<QLowEnergyAdvertisingParameters::AddressInfo> setWhiteList
+                = parameters(set).whiteList();
+        for (const auto &addressInfo : setWhiteList) {
+            if (!whiteListInfos.contains(addressInfo))
+                whiteListInfos.append(addressInfo);
+        }
+    }
+    if (!usesWhiteList)
         return;
     queueCommand(QBluezConst::OcfLeClearWhiteList, QByteArray());
-    const QList<QLowEnergyAdvertisingParameters::AddressInfo> whiteListInfos
-            = parameters().whiteList();
-    for (const auto &addressInfo : whiteListInfos) {
+    for (const auto &addressInfo : std::as_const(whiteListInfos)) {
         WhiteListParams commandParam;
         static_assert(sizeof commandParam == 7, "unexpected struct size");
         commandParam.addrType = addressInfo.type;
@@ -378,21 +534,296 @@ void QLeAdvertiserBluez::setWhiteList()
     }
 }
 
-void QLeAdvertiserBluez::handleCommandCompleted(quint16 opCode, quint8 status,
-                                                const QByteArray &data)
+bool QLeAdvertiserBluez::usesExtendedCommands() const
+{
+    return setCount() > 1 || parameters().isExtendedAdvertisingEnabled() || isPeriodic(0);
+}
+
+void QLeAdvertiserBluez::queueExtendedAdvertisingCommands()
+{
+    // Stop advertising first, in case it's currently active. The data of each set
+    // is queued once its parameters are set, see handleCommandCompleted().
+    for (qsizetype set = 0; set < setCount(); ++set) {
+        if (isPeriodic(set))
+            togglePeriodicAdvertising(set, false);
+    }
+    toggleExtendedAdvertising(false);
+    setWhiteList();
+    m_setPowerLevels.fill(0, setCount());
+    for (qsizetype set = 0; set < setCount(); ++set)
+        setExtendedAdvertisingParams(set);
+    toggleExtendedAdvertising(true);
+}
+
+/*!
+    \internal
+
+    Enables or disables \a set, or all sets if \a set is \c -1.
+ */
+void QLeAdvertiserBluez::toggleExtendedAdvertising(bool enable, qsizetype set)
+{
+    // Spec v5.3, Vol 4, Part E, 7.8.56
+    const qsizetype first = set < 0 ? 0 : set;
+    const qsizetype count = set < 0 ? setCount() : 1;
+    QByteArray data(2 + count * sizeof(ExtAdvEnableSet), Qt::Uninitialized);
+    data[0] = enable;
+    data[1] = char(count);
+    for (qsizetype i = 0; i < count; ++i) {
+        ExtAdvEnableSet enableSet;
+        static_assert(sizeof enableSet == 4, "unexpected struct size");
+        enableSet.handle = advertisingHandle(first + i);
+        enableSet.duration = 0; // until disabled
+        enableSet.maxEvents = 0;
+        std::memcpy(data.data() + 2 + i * sizeof enableSet, &enableSet, sizeof enableSet);
+    }
+    queueCommand(QBluezConst::OcfLeSetExtAdvEnable, data);
+}
+
+void QLeAdvertiserBluez::setExtendedAdvertisingParams(qsizetype set)
+{
+    // Spec v5.3, Vol 4, Part E, 7.8.53
+    const QLowEnergyAdvertisingParameters &setParameters = parameters(set);
+    const bool extended = setParameters.isExtendedAdvertisingEnabled();
+    ExtAdvParams params;
+    static_assert(sizeof params == 25, "unexpected struct size");
+    std::memset(&params, 0, sizeof params);
+    params.handle = advertisingHandle(set);
+
+    // extended advertising cannot be connectable and scannable at the same time
+    quint16 properties = 0;
+    switch (setParameters.mode()) {
+    case QLowEnergyAdvertisingParameters::AdvInd:
+        properties = extended ? 0x01 : 0x13;
+        break;
+    case QLowEnergyAdvertisingParameters::AdvScanInd:
+        properties = extended ? 0x02 : 0x12;
+        break;
+    case QLowEnergyAdvertisingParameters::AdvNonConnInd:
+        properties = extended ? 0x00 : 0x10;
+        break;
+    }
+    params.eventProperties = qToLittleEndian(properties);
+
+    quint32 minInterval;
+    quint32 maxInterval;
+    advertisingInterval(setParameters, 0x20, 0xffffff, &minInterval, &maxInterval);
+    for (int i = 0; i < 3; ++i) {
+        params.minInterval[i] = quint8(minInterval >> (8 * i));
+        params.maxInterval[i] = quint8(maxInterval >> (8 * i));
+    }
+
+    params.channelMap = 0x7; // All channels.
+    params.ownAddrType = QLowEnergyController::PublicAddress; // TODO: Make configurable.
+    params.filterPolicy = setParameters.filterPolicy();
+    if (params.filterPolicy != QLowEnergyAdvertisingParameters::IgnoreWhiteList
+            && advertisingData(set).discoverability()
+                    == QLowEnergyAdvertisingData::DiscoverabilityLimited) {
+        qCWarning(QT_BT_BLUEZ) << "limited discoverability is incompatible with "
+                                  "using a white list; disabling filtering";
+        params.filterPolicy = QLowEnergyAdvertisingParameters::IgnoreWhiteList;
+    }
+    params.txPower = 0x7f; // No preference.
+    params.primaryPhy = quint8(QLowEnergyController::Phy::Le1M);
+    // the PHY values match the ones of the specification
+    params.secondaryPhy = extended ? quint8(setParameters.secondaryPhy())
+                                   : quint8(QLowEnergyController::Phy::Le1M);
+    params.sid = quint8(set & 0xf);
+
+    const QByteArray paramsData = byteArrayFromStruct(params);
+    qCDebug(QT_BT_BLUEZ) << "extended advertising parameters:" << paramsData.toHex();
+    queueCommand(QBluezConst::OcfLeSetExtAdvParams, paramsData, set);
+}
+
+void QLeAdvertiserBluez::setExtendedData(qsizetype set)
+{
+    queueExtendedSetData(set, false);
+
+    if (isPeriodic(set)) {
+        setPeriodicAdvertisingParams(set);
+        setPeriodicData(set);
+        togglePeriodicAdvertising(set, true);
+    } else if (parameters(set).periodicMinimumInterval() > 0) {
+        qCWarning(QT_BT_BLUEZ) << "periodic advertising requires non-connectable "
+                                  "extended advertising, ignoring it";
+    }
+}
+
+/*!
+    \internal
+
+    Queues the advertising and scan response data of \a set. With \a onlyIfChanged
+    the set is advertising already, and data the controller has is not sent again.
+ */
+void QLeAdvertiserBluez::queueExtendedSetData(qsizetype set, bool onlyIfChanged)
+{
+    const QLowEnergyAdvertisingParameters::Mode mode = parameters(set).mode();
+    const bool extended = parameters(set).isExtendedAdvertisingEnabled();
+    const qsizetype capacity = extended ? maxExtendedDataLength : legacyDataLength;
+    const quint8 *powerLevel = &m_setPowerLevels.at(set);
+
+    AdvData advData(capacity);
+    AdvData responseData(capacity);
+    if (extended && mode == QLowEnergyAdvertisingParameters::AdvScanInd) {
+        // scannable extended advertising carries all of its data in the scan response
+        buildData(advertisingData(set), true, powerLevel, responseData);
+        buildData(scanResponseData(set), false, powerLevel, responseData);
+    } else {
+        buildData(advertisingData(set), true, powerLevel, advData);
+        if (mode == QLowEnergyAdvertisingParameters::AdvScanInd
+                || (!extended && mode == QLowEnergyAdvertisingParameters::AdvInd)) {
+            buildData(scanResponseData(set), false, powerLevel, responseData);
+        } else if (extended && mode == QLowEnergyAdvertisingParameters::AdvInd
+                   && scanResponseData(set) != QLowEnergyAdvertisingData()) {
+            qCWarning(QT_BT_BLUEZ) << "connectable extended advertising cannot be scanned, "
+                                      "leaving out the scan response data";
+        }
+    }
+
+    const QByteArray advPayload = significantBytes(advData);
+    const QByteArray responsePayload = significantBytes(responseData);
+    const bool sendAdvData = (!extended || mode != QLowEnergyAdvertisingParameters::AdvScanInd)
+            && !(onlyIfChanged && advPayload == m_sentAdvData.value(set));
+    // an emptied scan response has to reach the controller as well
+    const bool sendResponseData = (responseData.length > 0
+                                   || !m_sentResponseData.value(set).isEmpty())
+            && !(onlyIfChanged && responsePayload == m_sentResponseData.value(set));
+    m_sentAdvData.insert(set, advPayload);
+    m_sentResponseData.insert(set, responsePayload);
+
+    // Spec v5.3, Vol 4, Part E, 7.8.54-55, the data of an enabled set cannot be fragmented
+    const bool needsRestart = onlyIfChanged
+            && ((sendAdvData && advData.length > maxExtendedDataFragment)
+                || (sendResponseData && responseData.length > maxExtendedDataFragment));
+    if (needsRestart)
+        toggleExtendedAdvertising(false, set);
+    if (sendAdvData)
+        queueExtendedData(QBluezConst::OcfLeSetExtAdvData, set, advData);
+    if (sendResponseData)
+        queueExtendedData(QBluezConst::OcfLeSetExtScanResponseData, set, responseData);
+    if (needsRestart)
+        toggleExtendedAdvertising(true, set);
+}
+
+/*!
+    \internal
+
+    Queues \a data for \a set in as many fragments as an HCI command can carry.
+ */
+void QLeAdvertiserBluez::queueExtendedData(QBluezConst::OpCodeCommandField ocf, qsizetype set,
+                                           const AdvData &data)
+{
+    // Spec v5.3, Vol 4, Part E, 7.8.54-55
+    enum Operation : quint8 {
+        IntermediateFragment = 0x0,
+        FirstFragment = 0x1,
+        LastFragment = 0x2,
+        CompleteData = 0x3
+    };
+
+    qsizetype offset = 0;
+    do {
+        const qsizetype size = (std::min)(data.length - offset, maxExtendedDataFragment);
+        const bool isFirst = offset == 0;
+        const bool isLast = offset + size == data.length;
+        quint8 operation = IntermediateFragment;
+        if (isFirst && isLast)
+            operation = CompleteData;
+        else if (isFirst)
+            operation = FirstFragment;
+        else if (isLast)
+            operation = LastFragment;
+
+        QByteArray command(4 + size, Qt::Uninitialized);
+        command[0] = advertisingHandle(set);
+        command[1] = operation;
+        command[2] = 0x1; // The controller should not fragment the data.
+        command[3] = char(size);
+        std::memcpy(command.data() + 4, data.data + offset, size);
+        qCDebug(QT_BT_BLUEZ) << (ocf == QBluezConst::OcfLeSetExtAdvData
+                                 ? "extended advertising data:" : "extended scan response data:")
+                             << command.toHex();
+        queueCommand(ocf, command);
+        offset += size;
+    } while (offset < data.length);
+}
+
+bool QLeAdvertiserBluez::isPeriodic(qsizetype set) const
+{
+    const QLowEnergyAdvertisingParameters &setParameters = parameters(set);
+    return setParameters.periodicMinimumInterval() > 0
+            && setParameters.isExtendedAdvertisingEnabled()
+            && setParameters.mode() == QLowEnergyAdvertisingParameters::AdvNonConnInd;
+}
+
+void QLeAdvertiserBluez::togglePeriodicAdvertising(qsizetype set, bool enable)
+{
+    // Spec v5.3, Vol 4, Part E, 7.8.63
+    QByteArray data(2, Qt::Uninitialized);
+    data[0] = enable;
+    data[1] = advertisingHandle(set);
+    queueCommand(QBluezConst::OcfLeSetPeriodicAdvEnable, data);
+}
+
+void QLeAdvertiserBluez::setPeriodicAdvertisingParams(qsizetype set)
+{
+    // Spec v5.3, Vol 4, Part E, 7.8.61
+    struct PeriodicAdvParams {
+        quint8 handle;
+        quint16 minInterval;
+        quint16 maxInterval;
+        quint16 properties;
+    } __attribute__ ((packed)) params;
+    static_assert(sizeof params == 7, "unexpected struct size");
+
+    // the interval in units of 1.25 ms
+    const QLowEnergyAdvertisingParameters &setParameters = parameters(set);
+    const double multiplier = 1.25;
+    const quint32 minVal = setParameters.periodicMinimumInterval() / multiplier;
+    const quint32 maxVal = setParameters.periodicMaximumInterval() / multiplier;
+    const quint32 minInterval = forceIntoRange(minVal, 0x6, 0xffff);
+    const quint32 maxInterval = forceIntoRange(maxVal, minInterval, 0xffff);
+    params.handle = advertisingHandle(set);
+    params.minInterval = qToLittleEndian(quint16(minInterval));
+    params.maxInterval = qToLittleEndian(quint16(maxInterval));
+    // the controller adds the TX power to the packet header
+    const quint16 includeTxPower = 0x40;
+    params.properties = qToLittleEndian(quint16(
+            m_periodicData.value(set).includePowerLevel() ? includeTxPower : 0));
+
+    const QByteArray paramsData = byteArrayFromStruct(params);
+    qCDebug(QT_BT_BLUEZ) << "periodic advertising parameters:" << paramsData.toHex();
+    queueCommand(QBluezConst::OcfLeSetPeriodicAdvParams, paramsData);
+}
+
+void QLeAdvertiserBluez::setPeriodicData(qsizetype set)
+{
+    // Spec v5.3, Vol 4, Part E, 7.8.62
+    AdvData periodicData(maxPeriodicDataLength);
+    buildData(m_periodicData.value(set), false, nullptr, periodicData);
+
+    QByteArray command(3 + periodicData.length, Qt::Uninitialized);
+    command[0] = advertisingHandle(set);
+    command[1] = 0x3; // Complete data.
+    command[2] = char(periodicData.length);
+    std::memcpy(command.data() + 3, periodicData.data, periodicData.length);
+    qCDebug(QT_BT_BLUEZ) << "periodic advertising data:" << command.toHex();
+    queueCommand(QBluezConst::OcfLeSetPeriodicAdvData, command);
+}
+
+void QLeAdvertiserBluez::handleCommandCompleted(const HciManager::CommandResult &result)
 {
     if (m_pendingCommands.isEmpty())
         return;
-    const QBluezConst::OpCodeCommandField ocf = QBluezConst::OpCodeCommandField(ocfFromOpCode(opCode));
-    const Command currentCmd = m_pendingCommands.first();
-    if (currentCmd.ocf != ocf)
-        return; // Not one of our commands.
-    m_pendingCommands.takeFirst();
-    if (status != 0) {
+    const QBluezConst::OpCodeCommandField ocf = QBluezConst::OpCodeCommandField(ocfFromOpCode(result.opCode));
+    if (m_pendingCommands.first().ocf != ocf)
+        return; // a command that was sent twice, its first result took it already
+    const Command currentCmd = m_pendingCommands.takeFirst();
+    const QByteArray &data = result.returnParameters;
+    if (!result.isSuccess()) {
         qCDebug(QT_BT_BLUEZ) << "command" << ocf
-                             << "failed with status" << (HciManager::HciError)status
-                             << "status code" << status;
-        if (ocf == QBluezConst::OcfLeSetAdvEnable && status == 0xc && currentCmd.data == QByteArray(1, '\0')) {
+                             << "failed with status" << result.error()
+                             << "status code" << result.status;
+        if (ocf == QBluezConst::OcfLeSetAdvEnable && result.status == 0xc && currentCmd.data == QByteArray(1, '\0')) {
             // we ignore OcfLeSetAdvEnable if it tries to disable an active advertisement
             // it seems the platform often automatically turns off advertisements
             // subsequently the explicit stopAdvertisement call fails when re-issued
@@ -400,6 +831,14 @@ void QLeAdvertiserBluez::handleCommandCompleted(quint16 opCode, quint8 status,
             sendNextCommand();
             return;
         }
+        if (((ocf == QBluezConst::OcfLeSetExtAdvEnable
+              || ocf == QBluezConst::OcfLeSetPeriodicAdvEnable) && currentCmd.data.at(0) == 0)
+                || ocf == QBluezConst::OcfLeRemoveAdvSet) {
+            // the sets do not exist before the first start and after the last stop
+            qCDebug(QT_BT_BLUEZ) << "Disabling or removing advertising sets failed, ignoring";
+            sendNextCommand();
+            return;
+        }
         if (ocf == QBluezConst::OcfLeReadTxPowerLevel) {
             qCDebug(QT_BT_BLUEZ) << "reading power level failed, leaving it out of the "
                                     "advertising data";
@@ -420,6 +859,17 @@ void QLeAdvertiserBluez::handleCommandCompleted(quint16 opCode, quint8 status,
         }
         queueAdvertisingCommands();
         break;
+    case QBluezConst::OcfLeSetExtAdvParams: {
+        // the controller reports the TX power it selected for the set
+        if (!data.isEmpty())
+            m_setPowerLevels[currentCmd.set] = data.at(0);
+        // the data goes right after the parameters of its set
+        QList<Command> remainingCommands;
+        remainingCommands.swap(m_pendingCommands);
+        setExtendedData(currentCmd.set);
+        m_pendingCommands.append(remainingCommands);
+        break;
+    }
     default:
         break;
     }
@@ -430,6 +880,7 @@ void QLeAdvertiserBluez::handleCommandCompleted(quint16 opCode, quint8 status,
 void QLeAdvertiserBluez::handleError()
 {
     m_pendingCommands.clear();
+    ++m_commandGeneration;
     // TODO: Unmonitor event
     emit errorOccurred();
 }
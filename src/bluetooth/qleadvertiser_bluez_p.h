@@ -21,7 +21,9 @@
 QT_REQUIRE_CONFIG(bluez);
 
 #include "bluez/bluez_data_p.h"
+#include "bluez/hcimanager_p.h"
 
+#include <QtCore/qhash.h>
 #include <QtCore/qlist.h>
 #include <QtCore/qobject.h>
 
@@ -33,82 +35,157 @@ class QLeAdvertiser : public QObject
 public:
     void startAdvertising() { doStartAdvertising(); }
     void stopAdvertising() { doStopAdvertising(); }
+    void setPeriodicAdvertisingData(qsizetype set, const QLowEnergyAdvertisingData &data)
+    {
+        doSetPeriodicAdvertisingData(set, data);
+    }
+    // Returns false if there is no advertising set with the index set.
+    bool updateAdvertisingData(qsizetype set, const QLowEnergyAdvertisingData &advData,
+                               const QLowEnergyAdvertisingData &responseData)
+    {
+        if (set >= m_params.size())
+            return false;
+        m_advData[set] = advData;
+        m_responseData[set] = responseData;
+        doUpdateAdvertisingData(set);
+        return true;
+    }
 
 signals:
     void errorOccurred();
 
 public:
-    QLeAdvertiser(const QLowEnergyAdvertisingParameters &params,
-                  const QLowEnergyAdvertisingData &advData,
-                  const QLowEnergyAdvertisingData &responseData, QObject *parent)
+    // One advertising set per index, all lists have the same length.
+    QLeAdvertiser(const QList<QLowEnergyAdvertisingParameters> &params,
+                  const QList<QLowEnergyAdvertisingData> &advData,
+                  const QList<QLowEnergyAdvertisingData> &responseData, QObject *parent)
         : QObject(parent), m_params(params), m_advData(advData), m_responseData(responseData) {}
     ~QLeAdvertiser() override;
 
+    bool hasSets(const QList<QLowEnergyAdvertisingParameters> &params,
+                 const QList<QLowEnergyAdvertisingData> &advData,
+                 const QList<QLowEnergyAdvertisingData> &responseData) const
+    {
+        return m_params == params && m_advData == advData && m_responseData == responseData;
+    }
+
 protected:
-    const QLowEnergyAdvertisingParameters &parameters() const { return m_params; }
-    const QLowEnergyAdvertisingData &advertisingData() const { return m_advData; }
-    const QLowEnergyAdvertisingData &scanResponseData() const { return m_responseData; }
+    qsizetype setCount() const { return m_params.size(); }
+    const QLowEnergyAdvertisingParameters &parameters(qsizetype set = 0) const
+    {
+        return m_params.at(set);
+    }
+    const QLowEnergyAdvertisingData &advertisingData(qsizetype set = 0) const
+    {
+        return m_advData.at(set);
+    }
+    const QLowEnergyAdvertisingData &scanResponseData(qsizetype set = 0) const
+    {
+        return m_responseData.at(set);
+    }
 
 private:
     virtual void doStartAdvertising() = 0;
     virtual void doStopAdvertising() = 0;
+    virtual void doSetPeriodicAdvertisingData(qsizetype set,
+                                              const QLowEnergyAdvertisingData &data) = 0;
+    virtual void doUpdateAdvertisingData(qsizetype set) = 0;
 
-    const QLowEnergyAdvertisingParameters m_params;
-    const QLowEnergyAdvertisingData m_advData;
-    const QLowEnergyAdvertisingData m_responseData;
+    const QList<QLowEnergyAdvertisingParameters> m_params;
+    QList<QLowEnergyAdvertisingData> m_advData;
+    QList<QLowEnergyAdvertisingData> m_responseData;
 };
 
 struct AdvData;
 struct AdvParams;
-class HciManager;
 
+/*
+ * Uses the legacy advertising commands for a single set without extended
+ * advertising. Otherwise all sets are configured using the LE Extended
+ * Advertising commands, since a controller rejects legacy commands once it has
+ * seen extended ones. Sets without extended advertising use legacy PDUs then.
+ * Periodic advertising is configured right after the data of its set.
+ */
 class QLeAdvertiserBluez : public QLeAdvertiser
 {
     Q_OBJECT
 public:
-    QLeAdvertiserBluez(const QLowEnergyAdvertisingParameters &params,
-                       const QLowEnergyAdvertisingData &advertisingData,
-                       const QLowEnergyAdvertisingData &scanResponseData, HciManager &hciManager,
-                       QObject *parent = nullptr);
+    QLeAdvertiserBluez(const QList<QLowEnergyAdvertisingParameters> &params,
+                       const QList<QLowEnergyAdvertisingData> &advertisingData,
+                       const QList<QLowEnergyAdvertisingData> &scanResponseData,
+                       HciManager &hciManager, QObject *parent = nullptr);
     ~QLeAdvertiserBluez() override;
 
 private:
     void doStartAdvertising() override;
     void doStopAdvertising() override;
+    void doSetPeriodicAdvertisingData(qsizetype set,
+                                      const QLowEnergyAdvertisingData &data) override;
+    void doUpdateAdvertisingData(qsizetype set) override;
 
-    void setPowerLevel(AdvData &advData);
-    void setFlags(AdvData &advData);
+    void setPowerLevel(AdvData &advData, quint8 powerLevel);
+    void setFlags(const QLowEnergyAdvertisingData &src, AdvData &advData);
     void setServicesData(const QLowEnergyAdvertisingData &src, AdvData &dest);
     void setManufacturerData(const QLowEnergyAdvertisingData &src, AdvData &dest);
     void setLocalNameData(const QLowEnergyAdvertisingData &src, AdvData &dest);
 
-    void queueCommand(QBluezConst::OpCodeCommandField ocf, const QByteArray &advertisingData);
+    void queueCommand(QBluezConst::OpCodeCommandField ocf, const QByteArray &advertisingData,
+                      qsizetype set = -1);
     void sendNextCommand();
     void queueAdvertisingCommands();
     void queueReadTxPowerLevelCommand();
     void toggleAdvertising(bool enable);
     void setAdvertisingParams();
     void setAdvertisingInterval(AdvParams &params);
-    void setData(bool isScanResponseData);
+    void buildData(const QLowEnergyAdvertisingData &sourceData, bool includeFlags,
+                   const quint8 *powerLevel, AdvData &theData);
+    void setData(bool isScanResponseData, bool onlyIfChanged = false);
     void setAdvertisingData();
     void setScanResponseData();
     void setWhiteList();
 
-    void handleCommandCompleted(quint16 opCode, quint8 status, const QByteArray &advertisingData);
+    bool usesExtendedCommands() const;
+    void queueExtendedAdvertisingCommands();
+    void toggleExtendedAdvertising(bool enable, qsizetype set = -1);
+    void setExtendedAdvertisingParams(qsizetype set);
+    void setExtendedData(qsizetype set);
+    void queueExtendedSetData(qsizetype set, bool onlyIfChanged);
+    void queueExtendedData(QBluezConst::OpCodeCommandField ocf, qsizetype set,
+                           const AdvData &data);
+
+    bool isPeriodic(qsizetype set) const;
+    void togglePeriodicAdvertising(qsizetype set, bool enable);
+    void setPeriodicAdvertisingParams(qsizetype set);
+    void setPeriodicData(qsizetype set);
+
+    void handleCommandCompleted(const HciManager::CommandResult &result);
     void handleError();
 
     HciManager &m_hciManager;
 
     struct Command {
         Command() {}
-        Command(QBluezConst::OpCodeCommandField ocf, const QByteArray &data) : ocf(ocf), data(data) { }
+        Command(QBluezConst::OpCodeCommandField ocf, const QByteArray &data, qsizetype set)
+            : ocf(ocf), data(data), set(set) { }
         QBluezConst::OpCodeCommandField ocf;
         QByteArray data;
+        // the advertising set whose parameters are set, -1 for everything else
+        qsizetype set = -1;
     };
     QList<Command> m_pendingCommands;
+    // results of commands sent before the queue was last cleared are ignored
+    int m_commandGeneration = 0;
 
     quint8 m_powerLevel;
     bool m_sendPowerLevel;
+    // the TX power the controller selected for each extended advertising set
+    QList<quint8> m_setPowerLevels;
+    QHash<qsizetype, QLowEnergyAdvertisingData> m_periodicData;
+    // the encoded data the controller has for each set, updates which encode
+    // to the same bytes are not sent
+    QHash<qsizetype, QByteArray> m_sentAdvData;
+    QHash<qsizetype, QByteArray> m_sentResponseData;
+    bool m_advertising = false;
 };
 
 QT_END_NAMESPACE
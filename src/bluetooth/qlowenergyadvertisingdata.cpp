@@ -42,6 +42,8 @@ public:
           bytes. If the variable-length data set via this class exceeds that limit, it will
           be left out of the packet or truncated, depending on the type.
           On Android, advertising will fail if advertising data is larger than 31 bytes.
+          With extended advertising, the limit is 1650 bytes, see
+          \l QLowEnergyAdvertisingParameters::setExtendedAdvertisingEnabled().
 
     \sa QLowEnergyAdvertisingParameters
     \sa QLowEnergyController::startAdvertising()
@@ -78,6 +80,14 @@ QLowEnergyAdvertisingData::QLowEnergyAdvertisingData(const QLowEnergyAdvertising
 {
 }
 
+/*!
+    \fn QLowEnergyAdvertisingData::QLowEnergyAdvertisingData(QLowEnergyAdvertisingData &&other)
+    \since 6.5
+
+    Move-constructs a new object from \a other. The moved-from object can only
+    be assigned to or destroyed.
+*/
+
 /*! Destroys this object. */
 QLowEnergyAdvertisingData::~QLowEnergyAdvertisingData()
 {
@@ -90,6 +100,13 @@ QLowEnergyAdvertisingData &QLowEnergyAdvertisingData::operator=(const QLowEnergy
     return *this;
 }
 
+/*!
+    \fn QLowEnergyAdvertisingData &QLowEnergyAdvertisingData::operator=(QLowEnergyAdvertisingData &&other)
+    \since 6.5
+
+    Move-assigns \a other to this object and returns a reference to this object.
+*/
+
 /*!
    Specifies that \a name should be broadcast as the name of the device. If the full name does not
    fit into the advertising data packet, an abbreviated name is sent, as described by the
@@ -127,6 +144,18 @@ void QLowEnergyAdvertisingData::setManufacturerData(quint16 id, const QByteArray
     d->manufacturerData = data;
 }
 
+/*!
+   \overload
+   \since 6.5
+
+   Sets the manufacturer id to \a id and moves \a data into this object.
+ */
+void QLowEnergyAdvertisingData::setManufacturerData(quint16 id, QByteArray &&data)
+{
+    d->manufacturerId = id;
+    d->manufacturerData = std::move(data);
+}
+
 /*!
    Returns the manufacturer id.
    The default is \l QLowEnergyAdvertisingData::invalidManufacturerId(), which means
@@ -193,6 +222,17 @@ void QLowEnergyAdvertisingData::setServices(const QList<QBluetoothUuid> &service
     d->services = services;
 }
 
+/*!
+   \overload
+   \since 6.5
+
+   Moves \a services into this object.
+ */
+void QLowEnergyAdvertisingData::setServices(QList<QBluetoothUuid> &&services)
+{
+    d->services = std::move(services);
+}
+
 /*!
    Returns the list of service UUIDs to be advertised.
    By default, this list is empty.
@@ -206,14 +246,27 @@ QList<QBluetoothUuid> QLowEnergyAdvertisingData::services() const
   Sets the data to be advertised to \a data. If the value is not an empty byte array, it will
   be sent as-is as the advertising data and all other data in this object will be ignored.
   This can be used to send non-standard data.
-  \note If \a data is longer than 31 bytes, it will be truncated. It is the caller's responsibility
-        to ensure that \a data is well-formed.
+  \note If \a data is longer than 31 bytes, or 1650 bytes with extended advertising, it will be
+        truncated. It is the caller's responsibility to ensure that \a data is well-formed.
+
+  \sa QLowEnergyAdvertisingParameters::setExtendedAdvertisingEnabled()
  */
 void QLowEnergyAdvertisingData::setRawData(const QByteArray &data)
 {
     d->rawData = data;
 }
 
+/*!
+  \overload
+  \since 6.5
+
+  Moves \a data into this object.
+ */
+void QLowEnergyAdvertisingData::setRawData(QByteArray &&data)
+{
+    d->rawData = std::move(data);
+}
+
 /*!
   Returns the user-supplied raw data to be advertised. The default is an empty byte array.
  */
@@ -17,9 +17,11 @@ class Q_BLUETOOTH_EXPORT QLowEnergyAdvertisingData
 public:
     QLowEnergyAdvertisingData();
     QLowEnergyAdvertisingData(const QLowEnergyAdvertisingData &other);
+    QLowEnergyAdvertisingData(QLowEnergyAdvertisingData &&other) noexcept = default;
     ~QLowEnergyAdvertisingData();
 
     QLowEnergyAdvertisingData &operator=(const QLowEnergyAdvertisingData &other);
+    QT_MOVE_ASSIGNMENT_OPERATOR_IMPL_VIA_PURE_SWAP(QLowEnergyAdvertisingData)
     friend bool operator==(const QLowEnergyAdvertisingData &a, const QLowEnergyAdvertisingData &b)
     {
         return equals(a, b);
@@ -34,6 +36,7 @@ public:
 
     static quint16 invalidManufacturerId() { return 0xffff; }
     void setManufacturerData(quint16 id, const QByteArray &data);
+    void setManufacturerData(quint16 id, QByteArray &&data);
     quint16 manufacturerId() const;
     QByteArray manufacturerData() const;
 
@@ -47,11 +50,13 @@ public:
     Discoverability discoverability() const;
 
     void setServices(const QList<QBluetoothUuid> &services);
+    void setServices(QList<QBluetoothUuid> &&services);
     QList<QBluetoothUuid> services() const;
 
     // TODO: BR/EDR capability flag?
 
     void setRawData(const QByteArray &data);
+    void setRawData(QByteArray &&data);
     QByteArray rawData() const;
 
     void swap(QLowEnergyAdvertisingData &other) noexcept { d.swap(other.d); }
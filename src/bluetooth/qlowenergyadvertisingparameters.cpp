@@ -13,6 +13,10 @@ public:
         , mode(QLowEnergyAdvertisingParameters::AdvInd)
         , minInterval(1280)
         , maxInterval(1280)
+        , periodicMinInterval(0)
+        , periodicMaxInterval(0)
+        , secondaryPhy(QLowEnergyController::Phy::Le1M)
+        , extendedAdvertising(false)
     {
     }
 
@@ -21,6 +25,10 @@ public:
     QLowEnergyAdvertisingParameters::Mode mode;
     int minInterval;
     int maxInterval;
+    int periodicMinInterval;
+    int periodicMaxInterval;
+    QLowEnergyController::Phy secondaryPhy;
+    bool extendedAdvertising;
 };
 
 /*!
@@ -227,6 +235,131 @@ int QLowEnergyAdvertisingParameters::maximumInterval() const
     return d->maxInterval;
 }
 
+/*!
+   \since 6.5
+
+   Sets whether the advertising set uses the extended advertising PDUs introduced
+   with Bluetooth 5 to \a enabled.
+
+   Extended advertising carries up to 1650 bytes of advertising or scan response data
+   instead of 31, depending on the local adapter, and sends it on a secondary
+   advertising channel, see
+   \l setSecondaryPhy(). Connectable extended advertising cannot be scanned, so the
+   scan response data is not sent in the \l AdvInd mode. In the \l AdvScanInd mode,
+   the advertising data is sent ahead of the scan response data in the scan response.
+
+   Only devices supporting Bluetooth 5 can see extended advertising. If the local
+   adapter does not support it, advertising fails with
+   \l QLowEnergyController::AdvertisingError.
+
+   \note This is currently only supported on Linux with the ATT-socket-based BlueZ
+   implementation. Other platforms ignore it.
+
+   \sa isExtendedAdvertisingEnabled(), QLowEnergyController::startAdvertising()
+ */
+void QLowEnergyAdvertisingParameters::setExtendedAdvertisingEnabled(bool enabled)
+{
+    d->extendedAdvertising = enabled;
+}
+
+/*!
+   \since 6.5
+
+   Returns whether extended advertising is used. The default is \c false.
+
+   \sa setExtendedAdvertisingEnabled()
+ */
+bool QLowEnergyAdvertisingParameters::isExtendedAdvertisingEnabled() const
+{
+    return d->extendedAdvertising;
+}
+
+/*!
+   \since 6.5
+
+   Sets the PHY used on the secondary advertising channel to \a phy. The primary
+   advertising channel always uses \l QLowEnergyController::Phy::Le1M.
+
+   \l QLowEnergyController::Phy::Le2M shortens the time on air of large payloads,
+   \l QLowEnergyController::Phy::LeCoded extends the range. The value only takes
+   effect if extended advertising is enabled.
+
+   \sa secondaryPhy(), setExtendedAdvertisingEnabled()
+ */
+void QLowEnergyAdvertisingParameters::setSecondaryPhy(QLowEnergyController::Phy phy)
+{
+    d->secondaryPhy = phy;
+}
+
+/*!
+   \since 6.5
+
+   Returns the PHY used on the secondary advertising channel. The default is
+   \l QLowEnergyController::Phy::Le1M.
+
+   \sa setSecondaryPhy()
+ */
+QLowEnergyController::Phy QLowEnergyAdvertisingParameters::secondaryPhy() const
+{
+    return d->secondaryPhy;
+}
+
+/*!
+   \since 6.5
+
+   Enables periodic advertising with an interval between \a minimum and
+   \a maximum milliseconds. A \a minimum of \c 0 disables it.
+   If \a maximum is smaller than \a minimum, it will be set to the value of \a minimum.
+
+   Periodic advertising broadcasts the data set via
+   \l QLowEnergyController::setPeriodicAdvertisingData() at fixed intervals.
+   Scanners synchronize to it, see
+   \l QBluetoothDeviceDiscoveryAgent::startPeriodicAdvertisingSync(), and receive
+   every update without connecting. This suits data which changes regularly,
+   such as sensor readings, and many receivers. The interval must be at least
+   7.5 milliseconds; larger values cut the controller's time on air.
+
+   Periodic advertising requires extended advertising and the \l AdvNonConnInd
+   mode, other modes ignore it.
+
+   \note This is currently only supported on Linux with the ATT-socket-based BlueZ
+   implementation. Other platforms ignore it.
+
+   \sa periodicMinimumInterval(), periodicMaximumInterval(), setExtendedAdvertisingEnabled()
+ */
+void QLowEnergyAdvertisingParameters::setPeriodicAdvertisingInterval(quint16 minimum,
+                                                                     quint16 maximum)
+{
+    d->periodicMinInterval = minimum;
+    d->periodicMaxInterval = minimum == 0 ? 0 : qMax(minimum, maximum);
+}
+
+/*!
+   \since 6.5
+
+   Returns the minimum periodic advertising interval in milliseconds. The default
+   is \c 0, which means periodic advertising is disabled.
+
+   \sa setPeriodicAdvertisingInterval()
+ */
+int QLowEnergyAdvertisingParameters::periodicMinimumInterval() const
+{
+    return d->periodicMinInterval;
+}
+
+/*!
+   \since 6.5
+
+   Returns the maximum periodic advertising interval in milliseconds. The default
+   is \c 0.
+
+   \sa setPeriodicAdvertisingInterval()
+ */
+int QLowEnergyAdvertisingParameters::periodicMaximumInterval() const
+{
+    return d->periodicMaxInterval;
+}
+
 /*!
    \fn void QLowEnergyAdvertisingParameters::swap(QLowEnergyAdvertisingParameters &other)
    Swaps this object with \a other.
@@ -244,7 +377,11 @@ bool QLowEnergyAdvertisingParameters::equals(const QLowEnergyAdvertisingParamete
         return true;
     return a.filterPolicy() == b.filterPolicy() && a.minimumInterval() == b.minimumInterval()
             && a.maximumInterval() == b.maximumInterval() && a.mode() == b.mode()
-            && a.whiteList() == b.whiteList();
+            && a.whiteList() == b.whiteList()
+            && a.isExtendedAdvertisingEnabled() == b.isExtendedAdvertisingEnabled()
+            && a.secondaryPhy() == b.secondaryPhy()
+            && a.periodicMinimumInterval() == b.periodicMinimumInterval()
+            && a.periodicMaximumInterval() == b.periodicMaximumInterval();
 }
 
 bool QLowEnergyAdvertisingParameters::AddressInfo::equals(
@@ -68,6 +68,14 @@ public:
     int minimumInterval() const;
     int maximumInterval() const;
 
+    void setExtendedAdvertisingEnabled(bool enabled);
+    bool isExtendedAdvertisingEnabled() const;
+    void setSecondaryPhy(QLowEnergyController::Phy phy);
+    QLowEnergyController::Phy secondaryPhy() const;
+    void setPeriodicAdvertisingInterval(quint16 minimum, quint16 maximum);
+    int periodicMinimumInterval() const;
+    int periodicMaximumInterval() const;
+
     // TODO: own address type
     // TODO: For ADV_DIRECT_IND: peer address + peer address type
 
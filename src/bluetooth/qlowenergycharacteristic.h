@@ -78,6 +78,7 @@ private:
     friend class QLowEnergyControllerPrivateBluezDBus;
     friend class QLowEnergyControllerPrivateCommon;
     friend class QLowEnergyControllerPrivateDarwin;
+    friend class QLowEnergyControllerPrivateLoopback;
     friend class QLowEnergyControllerPrivateWinRT;
     QLowEnergyCharacteristicPrivate *data = nullptr;
     QLowEnergyCharacteristic(QSharedPointer<QLowEnergyServicePrivate> p,
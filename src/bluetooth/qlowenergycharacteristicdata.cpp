@@ -59,6 +59,14 @@ QLowEnergyCharacteristicData::QLowEnergyCharacteristicData(const QLowEnergyChara
 {
 }
 
+/*!
+    \fn QLowEnergyCharacteristicData::QLowEnergyCharacteristicData(QLowEnergyCharacteristicData &&other)
+    \since 6.5
+
+    Move-constructs a new object from \a other. The moved-from object can only
+    be assigned to or destroyed.
+*/
+
 /*! Destroys this object. */
 QLowEnergyCharacteristicData::~QLowEnergyCharacteristicData()
 {
@@ -71,6 +79,13 @@ QLowEnergyCharacteristicData &QLowEnergyCharacteristicData::operator=(const QLow
     return *this;
 }
 
+/*!
+    \fn QLowEnergyCharacteristicData &QLowEnergyCharacteristicData::operator=(QLowEnergyCharacteristicData &&other)
+    \since 6.5
+
+    Move-assigns \a other to this object and returns a reference to this object.
+*/
+
 /*! Returns the UUID of this characteristic. */
 QBluetoothUuid QLowEnergyCharacteristicData::uuid() const
 {
@@ -95,6 +110,17 @@ void QLowEnergyCharacteristicData::setValue(const QByteArray &value)
     d->value = value;
 }
 
+/*!
+    \overload
+    \since 6.5
+
+    Moves \a value into this characteristic.
+ */
+void QLowEnergyCharacteristicData::setValue(QByteArray &&value)
+{
+    d->value = std::move(value);
+}
+
 /*! Returns the properties of this characteristic. */
 QLowEnergyCharacteristic::PropertyTypes QLowEnergyCharacteristicData::properties() const
 {
@@ -123,9 +149,25 @@ QList<QLowEnergyDescriptorData> QLowEnergyCharacteristicData::descriptors() cons
   */
 void QLowEnergyCharacteristicData::setDescriptors(const QList<QLowEnergyDescriptorData> &descriptors)
 {
-    d->descriptors.clear();
-    for (const QLowEnergyDescriptorData &desc : descriptors)
-        addDescriptor(desc);
+    setDescriptors(QList<QLowEnergyDescriptorData>(descriptors));
+}
+
+/*!
+  \overload
+  \since 6.5
+
+  Moves \a descriptors into this object. If all of them are valid, the
+  list is taken over without copying its elements.
+ */
+void QLowEnergyCharacteristicData::setDescriptors(QList<QLowEnergyDescriptorData> &&descriptors)
+{
+    d->descriptors = std::move(descriptors);
+    d->descriptors.removeIf([](const QLowEnergyDescriptorData &desc) {
+        if (desc.isValid())
+            return false;
+        qCWarning(QT_BT) << "not adding invalid descriptor to characteristic";
+        return true;
+    });
 }
 
 /*!
@@ -140,6 +182,20 @@ void QLowEnergyCharacteristicData::addDescriptor(const QLowEnergyDescriptorData
         qCWarning(QT_BT) << "not adding invalid descriptor to characteristic";
 }
 
+/*!
+  \overload
+  \since 6.5
+
+  Moves \a descriptor into the list of descriptors, if it is valid.
+ */
+void QLowEnergyCharacteristicData::addDescriptor(QLowEnergyDescriptorData &&descriptor)
+{
+    if (descriptor.isValid())
+        d->descriptors.append(std::move(descriptor));
+    else
+        qCWarning(QT_BT) << "not adding invalid descriptor to characteristic";
+}
+
 /*!
   Specifies that clients need to fulfill \a constraints to read the value of this characteristic.
  */
@@ -15,9 +15,11 @@ class Q_BLUETOOTH_EXPORT QLowEnergyCharacteristicData
 public:
     QLowEnergyCharacteristicData();
     QLowEnergyCharacteristicData(const QLowEnergyCharacteristicData &other);
+    QLowEnergyCharacteristicData(QLowEnergyCharacteristicData &&other) noexcept = default;
     ~QLowEnergyCharacteristicData();
 
     QLowEnergyCharacteristicData &operator=(const QLowEnergyCharacteristicData &other);
+    QT_MOVE_ASSIGNMENT_OPERATOR_IMPL_VIA_PURE_SWAP(QLowEnergyCharacteristicData)
     friend bool operator==(const QLowEnergyCharacteristicData &a,
                            const QLowEnergyCharacteristicData &b)
     {
@@ -34,13 +36,16 @@ public:
 
     QByteArray value() const;
     void setValue(const QByteArray &value);
+    void setValue(QByteArray &&value);
 
     QLowEnergyCharacteristic::PropertyTypes properties() const;
     void setProperties(QLowEnergyCharacteristic::PropertyTypes properties);
 
     QList<QLowEnergyDescriptorData> descriptors() const;
     void setDescriptors(const QList<QLowEnergyDescriptorData> &descriptors);
+    void setDescriptors(QList<QLowEnergyDescriptorData> &&descriptors);
     void addDescriptor(const QLowEnergyDescriptorData &descriptor);
+    void addDescriptor(QLowEnergyDescriptorData &&descriptor);
 
     void setReadConstraints(QBluetooth::AttAccessConstraints constraints);
     QBluetooth::AttAccessConstraints readConstraints() const;
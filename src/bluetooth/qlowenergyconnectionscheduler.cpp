@@ -0,0 +1,569 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qlowenergyconnectionscheduler_p.h"
+#include "qlowenergycontrollerbase_p.h"
+
+#include <QtBluetooth/qbluetoothdeviceinfo.h>
+#include <QtBluetooth/qbluetoothlocaldevice.h>
+#include <QtCore/qloggingcategory.h>
+
+#include <algorithm>
+#include <optional>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT)
+
+// adapters which heard a device this much weaker than the best one are used as a fallback only
+static constexpr int adapterRssiMargin = 10;
+
+/*!
+    \since 6.5
+    \class QLowEnergyConnectionScheduler
+    \brief The QLowEnergyConnectionScheduler class schedules the connection
+           attempts of many \l QLowEnergyController objects.
+
+    \inmodule QtBluetooth
+
+    Every \l QLowEnergyController connects to its device independently. The
+    local Bluetooth controller however supports only a limited number of
+    simultaneous connections, and most platforms process only one connection
+    attempt at a time. Applications which talk to many peripherals, for
+    example to read the firmware version of every device in a fleet, would
+    otherwise have to sequence the connections themselves.
+
+    Controllers passed to \l connectToDevice() are queued by their priority.
+    The scheduler starts the connection of the next controller in the queue as
+    long as fewer than \l maximumConnections() controllers are connecting or
+    connected and fewer than \l maximumConnectionAttempts() of them are still
+    connecting. A controller gives up its slot once it returns to the
+    \l {QLowEnergyController::UnconnectedState}{UnconnectedState}, either
+    because the application called
+    \l QLowEnergyController::disconnectFromDevice() after it was done with the
+    device or because the connection failed.
+
+    The scheduler does not take ownership of the controllers. A controller
+    which is deleted is removed from the scheduler.
+
+    On hosts with several Bluetooth adapters the
+    \l {QLowEnergyConnectionScheduler::AdapterPolicy}{BalancedAdapters}
+    policy spreads the connections across all of them rather than connecting
+    every controller via the adapter it was created for, see
+    \l setAdapterPolicy().
+
+    \note Only controllers in the central role can be scheduled.
+
+    \sa QLowEnergyController
+*/
+
+/*!
+    \enum QLowEnergyConnectionScheduler::AdapterPolicy
+    \since 6.5
+
+    This enum describes how the scheduler chooses the local adapter of a
+    connection.
+
+    \value ControllerAdapter   Each controller connects via the local adapter
+                               it was created for. This is the default.
+    \value BalancedAdapters    Each controller connects via the local adapter
+                               which is best suited at the time its
+                               connection is started, see \l setAdapterPolicy().
+*/
+
+/*!
+    \fn void QLowEnergyConnectionScheduler::connectionAttemptStarted(QLowEnergyController *controller)
+
+    This signal is emitted right before the scheduler calls
+    \l QLowEnergyController::connectToDevice() on \a controller.
+*/
+
+/*!
+    \fn void QLowEnergyConnectionScheduler::idle()
+
+    This signal is emitted once no controller is queued, connecting or
+    connected anymore.
+*/
+
+/*!
+    Constructs a new connection scheduler with \a parent.
+*/
+QLowEnergyConnectionScheduler::QLowEnergyConnectionScheduler(QObject *parent)
+    : QObject(parent), d_ptr(new QLowEnergyConnectionSchedulerPrivate(this))
+{
+}
+
+/*!
+    Destroys the scheduler. Queued controllers are not connected anymore,
+    established connections are not affected.
+*/
+QLowEnergyConnectionScheduler::~QLowEnergyConnectionScheduler()
+{
+    delete d_ptr;
+}
+
+/*!
+    Sets the maximum number of controllers which are connecting or connected
+    at the same time to \a count. The default is \c 5.
+
+    The number of simultaneous connections the local Bluetooth controller
+    supports depends on the hardware, typical values range from 5 to 20.
+    Lowering the limit does not affect controllers which are already
+    connected.
+
+    \sa maximumConnections()
+*/
+void QLowEnergyConnectionScheduler::setMaximumConnections(int count)
+{
+    Q_D(QLowEnergyConnectionScheduler);
+    if (count < 1) {
+        qCWarning(QT_BT) << "Invalid maximum number of connections" << count;
+        return;
+    }
+    d->maximumConnections = count;
+    d->scheduleNext();
+}
+
+/*!
+    Returns the maximum number of controllers which are connecting or
+    connected at the same time.
+
+    \sa setMaximumConnections()
+*/
+int QLowEnergyConnectionScheduler::maximumConnections() const
+{
+    return d_ptr->maximumConnections;
+}
+
+/*!
+    Sets the maximum number of controllers which are connecting at the same
+    time to \a count. The default is \c 1, because most Bluetooth stacks
+    serialize connection attempts anyway and time out queued attempts.
+
+    \sa maximumConnectionAttempts()
+*/
+void QLowEnergyConnectionScheduler::setMaximumConnectionAttempts(int count)
+{
+    Q_D(QLowEnergyConnectionScheduler);
+    if (count < 1) {
+        qCWarning(QT_BT) << "Invalid maximum number of connection attempts" << count;
+        return;
+    }
+    d->maximumConnectionAttempts = count;
+    d->scheduleNext();
+}
+
+/*!
+    Returns the maximum number of controllers which are connecting at the
+    same time.
+
+    \sa setMaximumConnectionAttempts()
+*/
+int QLowEnergyConnectionScheduler::maximumConnectionAttempts() const
+{
+    return d_ptr->maximumConnectionAttempts;
+}
+
+/*!
+    \since 6.5
+
+    Sets the adapter selection \a policy. The default is
+    \l {QLowEnergyConnectionScheduler::AdapterPolicy}{ControllerAdapter}.
+
+    With \l {QLowEnergyConnectionScheduler::AdapterPolicy}{BalancedAdapters}
+    the scheduler chooses the local adapter right before it starts the
+    connection of a controller. Adapters which are powered off or which
+    already have \l maximumConnectionsPerAdapter() links, counting the
+    connections of other applications too, are skipped. Among the remaining
+    adapters those which reported the device via \l addDiscoveredDevice() at
+    most 10 dB weaker than the adapter with the strongest signal are
+    preferred, and among those the adapter with the smallest share of its
+    connection limit in use is chosen. Equally suited adapters favor the
+    signal strength and then the adapter the controller was created for.
+
+    Once every adapter is saturated the queued controllers wait until one of
+    the scheduled connections ends.
+
+    \note Moving a controller to another adapter is supported by the BlueZ
+    backends only. On other platforms the controllers keep their adapter.
+
+    \sa adapterPolicy(), setMaximumConnectionsPerAdapter()
+*/
+void QLowEnergyConnectionScheduler::setAdapterPolicy(AdapterPolicy policy)
+{
+    Q_D(QLowEnergyConnectionScheduler);
+    d->adapterPolicy = policy;
+    d->scheduleNext();
+}
+
+/*!
+    \since 6.5
+
+    Returns the adapter selection policy.
+
+    \sa setAdapterPolicy()
+*/
+QLowEnergyConnectionScheduler::AdapterPolicy QLowEnergyConnectionScheduler::adapterPolicy() const
+{
+    return d_ptr->adapterPolicy;
+}
+
+/*!
+    \since 6.5
+
+    Sets the maximum number of links of the local \a adapter to \a count.
+    The \l {QLowEnergyConnectionScheduler::AdapterPolicy}{BalancedAdapters}
+    policy does not start connections via an adapter which reached its limit.
+    A \a count of \c 0 restores the default, which is
+    \l maximumConnections().
+
+    The number of simultaneous connections an adapter supports is not
+    reported by its controller, set it according to the hardware.
+
+    \sa maximumConnectionsPerAdapter()
+*/
+void QLowEnergyConnectionScheduler::setMaximumConnectionsPerAdapter(
+        const QBluetoothAddress &adapter, int count)
+{
+    Q_D(QLowEnergyConnectionScheduler);
+    if (count < 0) {
+        qCWarning(QT_BT) << "Invalid maximum number of connections" << count << "for" << adapter;
+        return;
+    }
+    if (count == 0)
+        d->adapterLimits.remove(adapter);
+    else
+        d->adapterLimits.insert(adapter, count);
+    d->scheduleNext();
+}
+
+/*!
+    \since 6.5
+
+    Returns the maximum number of links of the local \a adapter.
+
+    \sa setMaximumConnectionsPerAdapter()
+*/
+int QLowEnergyConnectionScheduler::maximumConnectionsPerAdapter(
+        const QBluetoothAddress &adapter) const
+{
+    return d_ptr->adapterLimits.value(adapter, d_ptr->maximumConnections);
+}
+
+/*!
+    \since 6.5
+
+    Records the signal strength of the device \a info as seen by the local
+    \a adapter. The \l {QLowEnergyConnectionScheduler::AdapterPolicy}{BalancedAdapters}
+    policy prefers the adapters which receive a device well.
+
+    Typically the \l QBluetoothDeviceDiscoveryAgent::deviceDiscovered() and
+    \l QBluetoothDeviceDiscoveryAgent::deviceUpdated() signals of one
+    discovery agent per adapter are connected to this function. Devices
+    without a valid RSSI are ignored.
+*/
+void QLowEnergyConnectionScheduler::addDiscoveredDevice(const QBluetoothAddress &adapter,
+                                                        const QBluetoothDeviceInfo &info)
+{
+    Q_D(QLowEnergyConnectionScheduler);
+    if (adapter.isNull() || info.address().isNull() || info.rssi() == 0)
+        return;
+    d->adapterRssi[adapter].insert(info.address(), info.rssi());
+}
+
+/*!
+    Queues \a controller to be connected with \a priority. Controllers with a
+    higher priority are connected first, controllers with the same priority in
+    the order they were queued.
+
+    Queuing a controller again changes its priority. A controller which is
+    already connecting or connected is not queued but counts towards the
+    limits until it is disconnected.
+
+    \sa cancel()
+*/
+void QLowEnergyConnectionScheduler::connectToDevice(QLowEnergyController *controller, int priority)
+{
+    Q_D(QLowEnergyConnectionScheduler);
+    if (!controller)
+        return;
+
+    if (controller->role() != QLowEnergyController::CentralRole) {
+        qCWarning(QT_BT) << "Only central controllers can be scheduled";
+        return;
+    }
+
+    if (d->active.contains(controller))
+        return;
+
+    d->busy = true;
+    if (controller->state() != QLowEnergyController::UnconnectedState) {
+        cancel(controller);
+        d->track(controller);
+        return;
+    }
+
+    d->enqueue(controller, priority);
+    d->scheduleNext();
+}
+
+/*!
+    Removes \a controller from the queue. Controllers whose connection was
+    already started are not affected, call
+    \l QLowEnergyController::disconnectFromDevice() to end their connection.
+*/
+void QLowEnergyConnectionScheduler::cancel(QLowEnergyController *controller)
+{
+    Q_D(QLowEnergyConnectionScheduler);
+    const auto it = std::find_if(d->queue.begin(), d->queue.end(),
+                                 [controller](const auto &entry) {
+        return entry.controller == controller;
+    });
+    if (it == d->queue.end())
+        return;
+
+    d->queue.erase(it);
+    d->release(controller);
+    d->scheduleNext();
+}
+
+/*!
+    Returns the controllers which wait for their connection to be started,
+    in the order they will be started.
+*/
+QList<QLowEnergyController *> QLowEnergyConnectionScheduler::queuedControllers() const
+{
+    QList<QLowEnergyController *> controllers;
+    for (const auto &entry : d_ptr->queue) {
+        if (entry.controller)
+            controllers.append(entry.controller);
+    }
+    return controllers;
+}
+
+/*!
+    Returns the controllers which are connecting or connected.
+*/
+QList<QLowEnergyController *> QLowEnergyConnectionScheduler::activeControllers() const
+{
+    QList<QLowEnergyController *> controllers;
+    for (const auto &controller : d_ptr->active) {
+        if (controller)
+            controllers.append(controller);
+    }
+    return controllers;
+}
+
+void QLowEnergyConnectionSchedulerPrivate::enqueue(QLowEnergyController *controller, int priority)
+{
+    Q_Q(QLowEnergyConnectionScheduler);
+
+    const auto it = std::find_if(queue.begin(), queue.end(), [controller](const auto &entry) {
+        return entry.controller == controller;
+    });
+    if (it != queue.end()) {
+        queue.erase(it);
+    } else {
+        QObject::connect(controller, &QObject::destroyed, q, [this]() {
+            removeDestroyed();
+        });
+    }
+
+    const auto position = std::upper_bound(queue.begin(), queue.end(), priority,
+                                           [](int priority, const QueuedConnection &entry) {
+        return priority > entry.priority;
+    });
+    queue.insert(position, QueuedConnection{ controller, priority });
+}
+
+void QLowEnergyConnectionSchedulerPrivate::track(QLowEnergyController *controller)
+{
+    Q_Q(QLowEnergyConnectionScheduler);
+
+    active.append(controller);
+    QObject::connect(controller, &QObject::destroyed, q, [this]() {
+        removeDestroyed();
+    });
+    QObject::connect(controller, &QLowEnergyController::stateChanged, q, [this, controller]() {
+        controllerStateChanged(controller);
+    });
+}
+
+void QLowEnergyConnectionSchedulerPrivate::release(QLowEnergyController *controller)
+{
+    active.removeAll(controller);
+    QObject::disconnect(controller, nullptr, q_ptr, nullptr);
+}
+
+void QLowEnergyConnectionSchedulerPrivate::removeDestroyed()
+{
+    queue.removeIf([](const QueuedConnection &entry) { return entry.controller.isNull(); });
+    active.removeIf([](const QPointer<QLowEnergyController> &c) { return c.isNull(); });
+    scheduleNext();
+}
+
+void QLowEnergyConnectionSchedulerPrivate::controllerStateChanged(QLowEnergyController *controller)
+{
+    // a connection was established or given up, either frees a slot
+    if (controller->state() == QLowEnergyController::UnconnectedState)
+        release(controller);
+    scheduleNext();
+}
+
+void QLowEnergyConnectionSchedulerPrivate::scheduleNext()
+{
+    Q_Q(QLowEnergyConnectionScheduler);
+
+    // controllers change their state from within connectToDevice(), starting
+    // from the event loop avoids reentering startNext()
+    if (startPending)
+        return;
+    startPending = true;
+    QMetaObject::invokeMethod(q, [this]() { startNext(); }, Qt::QueuedConnection);
+}
+
+qsizetype QLowEnergyConnectionSchedulerPrivate::pendingAttempts() const
+{
+    return std::count_if(active.cbegin(), active.cend(), [](const auto &controller) {
+        return controller && controller->state() == QLowEnergyController::ConnectingState;
+    });
+}
+
+QList<QBluetoothAddress> QLowEnergyConnectionSchedulerPrivate::rankAdapters(
+        const QLowEnergyController *controller, const QList<QBluetoothHostInfo> &hosts) const
+{
+    struct Candidate
+    {
+        QBluetoothAddress adapter;
+        qsizetype links = 0;
+        int limit = 0;
+        std::optional<qint16> rssi;
+        bool weak = false;
+    };
+
+    const QBluetoothAddress remote = controller->remoteAddress();
+    QList<Candidate> candidates;
+    std::optional<qint16> strongest;
+    for (const QBluetoothHostInfo &host : hosts) {
+        const QBluetoothLocalDevice device(host.address());
+        if (!device.isValid() || device.hostMode() == QBluetoothLocalDevice::HostPoweredOff)
+            continue;
+
+        // links of other applications count as well
+        QList<QBluetoothAddress> linked = device.connectedDevices();
+        for (const auto &other : active) {
+            if (other && other->localAddress() == host.address()
+                    && !linked.contains(other->remoteAddress())) {
+                linked.append(other->remoteAddress());
+            }
+        }
+
+        Candidate candidate{ host.address() };
+        candidate.links = linked.size();
+        candidate.limit = adapterLimits.value(host.address(), maximumConnections);
+        if (candidate.links >= candidate.limit)
+            continue;
+
+        const auto seen = adapterRssi.constFind(host.address());
+        if (seen != adapterRssi.cend() && seen->contains(remote)) {
+            candidate.rssi = seen->value(remote);
+            if (!strongest || *candidate.rssi > *strongest)
+                strongest = candidate.rssi;
+        }
+        candidates.append(candidate);
+    }
+
+    if (strongest) {
+        for (Candidate &candidate : candidates)
+            candidate.weak = !candidate.rssi || *candidate.rssi < *strongest - adapterRssiMargin;
+    }
+
+    const QBluetoothAddress current = controller->localAddress();
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [&current](const Candidate &a, const Candidate &b) {
+        if (a.weak != b.weak)
+            return !a.weak;
+        // the smaller share of the connection limit in use
+        const qint64 loadA = qint64(a.links) * b.limit;
+        const qint64 loadB = qint64(b.links) * a.limit;
+        if (loadA != loadB)
+            return loadA < loadB;
+        if (a.rssi.value_or(-127) != b.rssi.value_or(-127))
+            return a.rssi.value_or(-127) > b.rssi.value_or(-127);
+        return a.adapter == current && b.adapter != current;
+    });
+
+    QList<QBluetoothAddress> adapters;
+    adapters.reserve(candidates.size());
+    for (const Candidate &candidate : std::as_const(candidates))
+        adapters.append(candidate.adapter);
+    return adapters;
+}
+
+bool QLowEnergyConnectionSchedulerPrivate::assignAdapter(QLowEnergyController *controller,
+                                                         const QList<QBluetoothHostInfo> &hosts)
+{
+    // the platform does not enumerate its adapters
+    if (hosts.isEmpty())
+        return true;
+
+    const QList<QBluetoothAddress> adapters = rankAdapters(controller, hosts);
+    for (const QBluetoothAddress &adapter : adapters) {
+        if (adapter == controller->localAddress())
+            return true;
+        if (controller->d_func()->setLocalAdapter(adapter)) {
+            qCDebug(QT_BT) << "Connecting" << controller->remoteAddress() << "via" << adapter;
+            return true;
+        }
+    }
+    return false;
+}
+
+void QLowEnergyConnectionSchedulerPrivate::startNext()
+{
+    Q_Q(QLowEnergyConnectionScheduler);
+    startPending = false;
+
+    QList<QBluetoothHostInfo> hosts;
+    if (adapterPolicy == QLowEnergyConnectionScheduler::AdapterPolicy::BalancedAdapters)
+        hosts = QBluetoothLocalDevice::allDevices();
+
+    while (!queue.isEmpty() && active.size() < maximumConnections
+           && pendingAttempts() < maximumConnectionAttempts) {
+        const QPointer<QLowEnergyController> controller = queue.first().controller;
+        if (!controller) {
+            queue.removeFirst();
+            continue;
+        }
+
+        if (adapterPolicy == QLowEnergyConnectionScheduler::AdapterPolicy::BalancedAdapters
+                && controller->state() == QLowEnergyController::UnconnectedState
+                && !assignAdapter(controller, hosts)) {
+            // every adapter is saturated, wait until a scheduled connection ends
+            break;
+        }
+        queue.removeFirst();
+
+        QObject::disconnect(controller, nullptr, q, nullptr);
+        track(controller);
+        if (controller->state() != QLowEnergyController::UnconnectedState)
+            continue;
+
+        emit q->connectionAttemptStarted(controller);
+        if (controller)
+            controller->connectToDevice();
+        // connectToDevice() may fail without leaving the unconnected state
+        if (controller && controller->state() == QLowEnergyController::UnconnectedState)
+            release(controller);
+        active.removeIf([](const QPointer<QLowEnergyController> &c) { return c.isNull(); });
+    }
+
+    if (busy && queue.isEmpty() && active.isEmpty()) {
+        busy = false;
+        emit q->idle();
+    }
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qlowenergyconnectionscheduler.cpp"
@@ -0,0 +1,59 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QLOWENERGYCONNECTIONSCHEDULER_H
+#define QLOWENERGYCONNECTIONSCHEDULER_H
+
+#include <QtBluetooth/qbluetoothaddress.h>
+#include <QtBluetooth/qtbluetoothglobal.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qobject.h>
+
+QT_BEGIN_NAMESPACE
+
+class QBluetoothDeviceInfo;
+class QLowEnergyController;
+class QLowEnergyConnectionSchedulerPrivate;
+
+class Q_BLUETOOTH_EXPORT QLowEnergyConnectionScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum class AdapterPolicy {
+        ControllerAdapter,
+        BalancedAdapters
+    };
+    Q_ENUM(AdapterPolicy)
+
+    explicit QLowEnergyConnectionScheduler(QObject *parent = nullptr);
+    ~QLowEnergyConnectionScheduler();
+
+    void setMaximumConnections(int count);
+    int maximumConnections() const;
+    void setMaximumConnectionAttempts(int count);
+    int maximumConnectionAttempts() const;
+
+    void setAdapterPolicy(AdapterPolicy policy);
+    AdapterPolicy adapterPolicy() const;
+    void setMaximumConnectionsPerAdapter(const QBluetoothAddress &adapter, int count);
+    int maximumConnectionsPerAdapter(const QBluetoothAddress &adapter) const;
+    void addDiscoveredDevice(const QBluetoothAddress &adapter, const QBluetoothDeviceInfo &info);
+
+    void connectToDevice(QLowEnergyController *controller, int priority = 0);
+    void cancel(QLowEnergyController *controller);
+
+    QList<QLowEnergyController *> queuedControllers() const;
+    QList<QLowEnergyController *> activeControllers() const;
+
+Q_SIGNALS:
+    void connectionAttemptStarted(QLowEnergyController *controller);
+    void idle();
+
+private:
+    Q_DECLARE_PRIVATE(QLowEnergyConnectionScheduler)
+    QLowEnergyConnectionSchedulerPrivate *d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif // QLOWENERGYCONNECTIONSCHEDULER_H
@@ -0,0 +1,71 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QLOWENERGYCONNECTIONSCHEDULER_P_H
+#define QLOWENERGYCONNECTIONSCHEDULER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qlowenergyconnectionscheduler.h"
+
+#include <QtBluetooth/qbluetoothhostinfo.h>
+#include <QtBluetooth/qlowenergycontroller.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qpointer.h>
+
+QT_BEGIN_NAMESPACE
+
+class QLowEnergyConnectionSchedulerPrivate
+{
+    Q_DECLARE_PUBLIC(QLowEnergyConnectionScheduler)
+public:
+    explicit QLowEnergyConnectionSchedulerPrivate(QLowEnergyConnectionScheduler *q) : q_ptr(q) {}
+
+    struct QueuedConnection {
+        QPointer<QLowEnergyController> controller;
+        int priority = 0;
+    };
+
+    void enqueue(QLowEnergyController *controller, int priority);
+    void track(QLowEnergyController *controller);
+    void release(QLowEnergyController *controller);
+    void removeDestroyed();
+    void controllerStateChanged(QLowEnergyController *controller);
+    void scheduleNext();
+    void startNext();
+    qsizetype pendingAttempts() const;
+    QList<QBluetoothAddress> rankAdapters(const QLowEnergyController *controller,
+                                          const QList<QBluetoothHostInfo> &hosts) const;
+    bool assignAdapter(QLowEnergyController *controller, const QList<QBluetoothHostInfo> &hosts);
+
+    QLowEnergyConnectionScheduler *q_ptr;
+
+    int maximumConnections = 5;
+    int maximumConnectionAttempts = 1;
+    QLowEnergyConnectionScheduler::AdapterPolicy adapterPolicy =
+            QLowEnergyConnectionScheduler::AdapterPolicy::ControllerAdapter;
+    QHash<QBluetoothAddress, int> adapterLimits;
+    // last RSSI each adapter reported for a remote device
+    QHash<QBluetoothAddress, QHash<QBluetoothAddress, qint16>> adapterRssi;
+
+    // sorted by descending priority, equal priorities in the order they were queued
+    QList<QueuedConnection> queue;
+    // controllers which were started and are not unconnected yet
+    QList<QPointer<QLowEnergyController>> active;
+    bool startPending = false;
+    // whether idle() is due once nothing is queued or active anymore
+    bool busy = false;
+};
+
+QT_END_NAMESPACE
+
+#endif // QLOWENERGYCONNECTIONSCHEDULER_P_H
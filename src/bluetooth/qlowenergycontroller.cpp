@@ -7,6 +7,8 @@
 #include "qlowenergyconnectionparameters.h"
 #include "qlowenergydescriptordata.h"
 #include "qlowenergyservicedata.h"
+#include "qlowenergystaticservicedata.h"
+#include "qtbluetoothglobal_p.h"
 
 #include <QtBluetooth/QBluetoothLocalDevice>
 #include <QtCore/QLoggingCategory>
@@ -27,6 +29,9 @@
 #else
 #include "qlowenergycontroller_dummy_p.h"
 #endif
+#if QT_CONFIG(bluetooth_loopback)
+#include "qlowenergycontroller_loopback_p.h"
+#endif
 
 #include <algorithm>
 
@@ -38,6 +43,7 @@ QT_IMPL_METATYPE_EXTERN_TAGGED(QLowEnergyController::ControllerState,
 QT_IMPL_METATYPE_EXTERN_TAGGED(QLowEnergyController::RemoteAddressType,
                                QLowEnergyController__RemoteAddressType)
 QT_IMPL_METATYPE_EXTERN_TAGGED(QLowEnergyController::Role, QLowEnergyController__Role)
+QT_IMPL_METATYPE_EXTERN_TAGGED(QLowEnergyController::Phy, QLowEnergyController__Phy)
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT)
 #if defined(QT_ANDROID_BLUETOOTH)
@@ -105,6 +111,53 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT_ANDROID)
     and, depending on the type of advertising being done, also listen for incoming connections
     from GATT clients.
 
+    On Linux the peripheral role uses the kernel ATT server of Qt Bluetooth by default.
+    With BlueZ 5.56 or later, setting \c QT_BLUETOOTH_USE_DBUS_PERIPHERAL before the
+    controller is created registers the services with bluetoothd instead, which serves any
+    number of GATT clients at once. The controller then enters the \l ConnectedState with
+    the first request of a client and \l remoteAddress() is the address of one of the
+    connected clients. Notifications are sent through sockets acquired from bluetoothd.
+    That backend cannot apply the advertising interval, filter policy and white list of
+    \l QLowEnergyAdvertisingParameters, and bluetoothd takes care of the connection
+    parameters, security and the client configurations itself.
+
+    In Qt builds with the \c bluetooth_loopback feature, which developer builds enable by
+    default, setting the \c QT_BLUETOOTH_LOOPBACK environment variable to \c 1 before any
+    controller is created replaces the platform backend with an in-process loopback, which
+    needs no Bluetooth hardware. A controller in the central role then connects to the
+    advertising peripheral controller of the same process whose \l localAddress() it was
+    given as remote device. Each exchange on the simulated link takes one connection interval. The link is
+    configured via \c QT_BLUETOOTH_LOOPBACK_MTU (the largest MTU, 517 by default),
+    \c QT_BLUETOOTH_LOOPBACK_INTERVAL (the connection interval in milliseconds, 0 by default)
+    and \c QT_BLUETOOTH_LOOPBACK_LOSS (the percentage of PDUs which are lost and repeated in
+    the next connection event, 0 by default). This is meant for tests and benchmarks of
+    the GATT code paths.
+
+    On Linux the \c QT_BLUETOOTH_ATT_CAPTURE environment variable names a file into which
+    the BlueZ kernel ATT backend records the ATT PDUs of its connections together with their
+    timestamps. The file uses the btsnoop format and can be inspected with Wireshark or
+    btmon. A central controller created while \c QT_BLUETOOTH_ATT_REPLAY names such a
+    capture, or one written by \c{btmon -w}, does not use any Bluetooth hardware. Instead the
+    recorded peer answers the requests of the controller. Only the fixed ATT channel is
+    recorded and replayed, Enhanced ATT bearers are not.
+
+    \section1 Threads
+
+    A controller may be moved to another thread with \l {QObject::}{moveToThread()},
+    for example to spread the connections of a gateway over several worker threads.
+    The move is supported while the controller is unconnected and neither has
+    services added nor discovered, ideally right after its creation. The objects the
+    controller uses internally follow it to the new thread. Afterwards the controller
+    and the services created by it must only be used from the controller's thread,
+    typically via \l {QMetaObject::}{invokeMethod()}.
+
+    A \l QLowEnergyService can be consumed from another thread by moving it there
+    right after \l createServiceObject() returned it without a parent. Its signals are
+    then delivered in its own thread and carry the values they report. Requests such
+    as \l QLowEnergyService::writeCharacteristic() must still be issued from the
+    controller's thread. Moving controllers is supported by the BlueZ backends and
+    the loopback backend.
+
     \sa QLowEnergyService, QLowEnergyCharacteristic, QLowEnergyDescriptor
     \sa QLowEnergyAdvertisingParameters, QLowEnergyAdvertisingData
 */
@@ -182,6 +235,18 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT_ANDROID)
    \note The peripheral role is not supported on Windows. In addition on Linux, handling the
          "Signed Write" ATT command on the server side requires BlueZ 5 and kernel version 3.7
          or newer.
+   \note On Linux with the ATT-socket-based BlueZ implementation, a peripheral serves a single
+         client by default. Setting the \c QT_BLUETOOTH_MAX_PERIPHERAL_CLIENTS environment
+         variable to a larger value keeps advertising after the first connection and serves
+         up to that many clients on the same set of services. Each client has its own MTU and
+         client characteristic configuration. \l connected() and \l disconnected() are emitted
+         for the first and last client only, while \l remoteAddress() refers to the client
+         which sent the most recent request.
+   \note On iOS and macOS all controllers and device discovery agents share a single
+         Core Bluetooth dispatch queue by default. Setting the
+         \c QT_BLUETOOTH_DEDICATED_LE_QUEUES environment variable to \c 1 gives each of
+         them a serial queue of its own, so that the callbacks of unrelated devices are
+         no longer processed one after the other.
  */
 
 
@@ -198,6 +263,57 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT_ANDROID)
     devices.
 */
 
+/*!
+    \enum QLowEnergyController::Phy
+    \since 6.5
+
+    Indicates the physical layer (PHY) used by a Bluetooth Low Energy connection.
+
+    \value Le1M     The LE 1M PHY supported by all Bluetooth Low Energy devices.
+    \value Le2M     The LE 2M PHY which doubles the symbol rate and thus the
+                    achievable throughput. It requires Bluetooth 5 on both sides.
+    \value LeCoded  The LE Coded PHY which trades throughput for range.
+                    It requires Bluetooth 5 on both sides.
+
+    \sa requestPhy(), phyChanged()
+*/
+
+/*!
+    \enum QLowEnergyController::GattCachePolicy
+    \since 6.5
+
+    Determines whether service discovery may use the attribute data which the
+    operating system cached during earlier connections to the same device.
+
+    \value PlatformDefault  The operating system decides.
+    \value Cached           Cached services, characteristics and descriptors are
+                            used if available. This makes reconnecting to a known
+                            device fast, but the result can be outdated if the
+                            device changed its attribute table meanwhile.
+    \value Uncached         The attribute table is always read from the device.
+
+    \sa setGattCachePolicy()
+*/
+
+/*!
+    \enum QLowEnergyController::ConnectionPreset
+    \since 6.5
+
+    Describes a set of connection parameters by the purpose of the connection
+    rather than by raw values.
+
+    \value Balanced        A compromise between throughput, latency and power
+                           consumption.
+    \value HighThroughput  Short connection intervals for transferring large
+                           amounts of data.
+    \value LowLatency      The shortest connection intervals with a short
+                           supervision timeout, for interactive use.
+    \value LowPower        Long connection intervals and a peripheral latency
+                           that lets the remote device skip connection events.
+
+    \sa requestConnectionUpdate(), connectionParameters()
+*/
+
 /*!
     \fn void QLowEnergyController::mtuChanged(int mtu)
 
@@ -211,6 +327,56 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT_ANDROID)
     \sa mtu()
 */
 
+/*!
+    \fn void QLowEnergyController::congestionChanged(bool congested)
+    \since 6.5
+
+    This signal is emitted when the outbound queue of the controller becomes
+    congested or drains again. While \a congested is \c true the local Bluetooth
+    stack cannot keep up with the packets the application sends, for example
+    notifications in the \l PeripheralRole or write commands in the
+    \l CentralRole. No data is lost, but the application should reduce its
+    send rate until the signal is emitted with \a congested set to \c false.
+
+    The queue is considered congested once it holds 64 packets. This limit can
+    be changed via the \c QT_BLUETOOTH_SEND_QUEUE_HIGH_WATER_MARK environment
+    variable.
+
+    On macOS and iOS the signal is emitted in the \l PeripheralRole while
+    CoreBluetooth's transmit queue for notifications and indications is full.
+    Meanwhile only the latest value of each characteristic is kept and sent
+    once the queue has space again.
+
+    \note This signal is currently only emitted on Linux with the
+    ATT-socket-based BlueZ implementation, on macOS, on iOS and by the loopback
+    backend. The loopback backend counts the exchanges waiting for the
+    simulated link.
+*/
+
+/*!
+    \fn void QLowEnergyController::phyChanged(QLowEnergyController::Phy txPhy, QLowEnergyController::Phy rxPhy)
+    \since 6.5
+
+    This signal is emitted when the PHY of the connection changes. This can happen as a
+    result of calling \l requestPhy() or because the remote device requested a different PHY.
+    \a txPhy is the PHY used for sending and \a rxPhy the PHY used for receiving.
+
+    \sa requestPhy()
+*/
+
+/*!
+    \fn void QLowEnergyController::dataLengthChanged(int txOctets, int rxOctets)
+    \since 6.5
+
+    This signal is emitted when the maximum link layer payload size of the connection
+    changes. This can happen as a result of calling \l requestDataLength() or because
+    the remote device requested a different data length. \a txOctets is the maximum
+    number of payload octets per packet sent and \a rxOctets the maximum number of
+    payload octets per packet received.
+
+    \sa requestDataLength()
+*/
+
 /*!
     \fn void QLowEnergyController::disconnected()
 
@@ -257,6 +423,13 @@ Q_DECLARE_LOGGING_CATEGORY(QT_BT_ANDROID)
     The signal is not emitted if the discovery process finishes with
     an error.
 
+    With the ATT-socket-based BlueZ implementation, the signal is emitted
+    again once the services of a Service Changed indication of the remote
+    device have been discovered again. Only the services within the handle
+    range of the indication become \l {QLowEnergyService::InvalidService}{invalid}.
+    The services found again within the range are reported via
+    \l serviceDiscovered() before the signal. All other services keep working.
+
     This signal can only be emitted if the controller is in the \l CentralRole.
 
     \sa discoverServices(), error()
@@ -281,6 +454,7 @@ void registerQLowEnergyControllerMetaType()
     if (!initDone) {
         qRegisterMetaType<QLowEnergyController::ControllerState>();
         qRegisterMetaType<QLowEnergyController::Error>();
+        qRegisterMetaType<QLowEnergyController::Phy>();
         qRegisterMetaType<QLowEnergyConnectionParameters>();
         qRegisterMetaType<QLowEnergyCharacteristic>();
         qRegisterMetaType<QLowEnergyDescriptor>();
@@ -290,11 +464,26 @@ void registerQLowEnergyControllerMetaType()
 
 static QLowEnergyControllerPrivate *privateController(QLowEnergyController::Role role)
 {
+#if QT_CONFIG(bluetooth_loopback)
+    if (QLowEnergyControllerPrivateLoopback::isEnabled()) {
+        qCWarning(QT_BT) << "Using the in-process loopback backend";
+        return new QLowEnergyControllerPrivateLoopback();
+    }
+#endif
+
 #if QT_CONFIG(bluez) && !defined(QT_BLUEZ_NO_BTLE)
-    // The new DBUS implementation only supports Central role for now
-    // For Peripheral role support see QTBUG-66909
-    if (role == QLowEnergyController::CentralRole
-            && bluetoothdVersion() >= QVersionNumber(5, 42)) {
+    // The DBus peripheral role needs AcquireNotify and the advertising
+    // manager of bluetoothd 5.56. It lacks features of the kernel ATT server,
+    // QT_BLUETOOTH_USE_DBUS_PERIPHERAL opts into it.
+    // Capturing and replaying ATT traffic requires the kernel ATT interface
+    const QVersionNumber version = bluetoothdVersion();
+    const bool useDBus = role == QLowEnergyController::CentralRole
+            ? version >= QVersionNumber(5, 42)
+            : version >= QVersionNumber(5, 56)
+                    && !qEnvironmentVariableIsEmpty("QT_BLUETOOTH_USE_DBUS_PERIPHERAL");
+    if (useDBus
+            && qEnvironmentVariableIsEmpty("QT_BLUETOOTH_ATT_CAPTURE")
+            && qEnvironmentVariableIsEmpty("QT_BLUETOOTH_ATT_REPLAY")) {
         qCWarning(QT_BT) << "Using BlueZ LE DBus API";
         return new QLowEnergyControllerPrivateBluezDBus();
     } else {
@@ -338,6 +527,9 @@ QLowEnergyController::QLowEnergyController(
     : QObject(parent)
 {
     d_ptr = privateController(CentralRole);
+    // the backend follows the controller to other threads
+    d_ptr->setParent(this);
+    registerQLowEnergyControllerMetaType();
 
     Q_D(QLowEnergyController);
     d->q_ptr = this;
@@ -438,6 +630,9 @@ QLowEnergyController::QLowEnergyController(const QBluetoothAddress &localDevice,
     : QObject(parent)
 {
     d_ptr = privateController(PeripheralRole);
+    // the backend follows the controller to other threads
+    d_ptr->setParent(this);
+    registerQLowEnergyControllerMetaType();
 
     Q_D(QLowEnergyController);
     d->q_ptr = this;
@@ -623,6 +818,51 @@ void QLowEnergyController::disconnectFromDevice()
     d->disconnectFromDevice();
 }
 
+/*!
+    \since 6.5
+
+    Sets whether the next \l connectToDevice() waits for the remote device
+    to advertise to \a enabled. The default is \c false.
+
+    A regular connection attempt fails with a timeout if the remote device does
+    not advertise at that moment. With auto-connect enabled, the Bluetooth
+    controller of the local device keeps listening for the remote device in
+    the background and connects on its first advertisement. The controller
+    stays in the \l ConnectingState meanwhile, which ends with
+    \l disconnectFromDevice(). Reconnecting to a known device which comes back
+    into range therefore requires one connectToDevice() call only, rather
+    than a loop of attempts.
+
+    \note Currently, this functionality is implemented on Linux with the
+    ATT-socket-based BlueZ implementation and on Android. BlueZ programs the
+    accept list of the local Bluetooth controller, which requires the
+    \c CAP_NET_ADMIN capability. Without it, or if the controller rejects
+    the accept list, a regular connection attempt is made. Connection attempts
+    on macOS and iOS never time out, they behave as if auto-connect was
+    enabled. The loopback backend waits until the peripheral starts
+    advertising.
+
+    \sa isAutoConnectEnabled()
+ */
+void QLowEnergyController::setAutoConnectEnabled(bool enabled)
+{
+    Q_D(QLowEnergyController);
+    d->autoConnect = enabled;
+}
+
+/*!
+    \since 6.5
+
+    Returns \c true if \l connectToDevice() waits for the remote device to
+    advertise; otherwise returns \c false.
+
+    \sa setAutoConnectEnabled()
+ */
+bool QLowEnergyController::isAutoConnectEnabled() const
+{
+    return d_ptr->autoConnect;
+}
+
 /*!
     Initiates the service discovery process.
 
@@ -640,6 +880,34 @@ void QLowEnergyController::disconnectFromDevice()
     cache behavior.
  */
 void QLowEnergyController::discoverServices()
+{
+    discoverServices(QList<QBluetoothUuid>());
+}
+
+/*!
+    \since 6.5
+
+    Initiates the discovery of the primary services in \a serviceUuids
+    only. An empty list discovers all services, which is equivalent to
+    calling \l discoverServices() without arguments.
+
+    Only the listed services are reported via \l serviceDiscovered() and
+    returned by \l services(); the \l discoveryFinished() signal is emitted
+    once all of them have been looked up, even if the remote device offers
+    none of them. Depending on the platform, services included by one of the
+    listed services may be reported as well.
+
+    Restricting the discovery to the services an application actually uses
+    can considerably shorten the time until the first service is available,
+    in particular for devices with large GATT databases.
+
+    \note Currently, only the ATT-socket-based BlueZ implementation and
+    Darwin ask the remote device for the listed services alone. The other
+    platforms still discover all services and drop the ones not listed.
+
+    \sa discoverServices()
+ */
+void QLowEnergyController::discoverServices(const QList<QBluetoothUuid> &serviceUuids)
 {
     Q_D(QLowEnergyController);
 
@@ -650,6 +918,12 @@ void QLowEnergyController::discoverServices()
     if (d->state != QLowEnergyController::ConnectedState)
         return;
 
+    d->serviceDiscoveryFilter.clear();
+    for (const QBluetoothUuid &uuid : serviceUuids) {
+        if (!uuid.isNull() && !d->serviceDiscoveryFilter.contains(uuid))
+            d->serviceDiscoveryFilter.append(uuid);
+    }
+
     d->setState(QLowEnergyController::DiscoveringState);
     d->discoverServices();
 }
@@ -719,6 +993,8 @@ QLowEnergyService *QLowEnergyController::createServiceObject(
    to 31 byte user data. If, for example, several 128bit uuids are added to \a advertisingData,
    the advertised packets may not contain all uuids. The existing limit may have caused the truncation
    of uuids. In such cases \a scanResponseData may be used for additional information.
+   Extended advertising raises the limit, see
+   \l QLowEnergyAdvertisingParameters::setExtendedAdvertisingEnabled().
 
    If this object is currently not in the \l UnconnectedState, nothing happens.
 
@@ -741,6 +1017,57 @@ void QLowEnergyController::startAdvertising(const QLowEnergyAdvertisingParameter
     d->startAdvertising(parameters, advertisingData, scanResponseData);
 }
 
+/*!
+   \since 6.5
+
+   Starts advertising several advertising sets at the same time. Each set is made of
+   the parameters, the advertising data and the scan response data at the same index
+   of \a parameters, \a advertisingData and \a scanResponseData. The first two lists
+   must have the same length, \a scanResponseData may be shorter, in which case the
+   remaining sets have no scan response data.
+
+   If any of the sets is connectable, this function also starts listening for incoming
+   client connections. All sets are stopped together by \l stopAdvertising().
+
+   Multiple advertising sets require the LE Extended Advertising support of Bluetooth 5.
+   Sets which do not enable \l QLowEnergyAdvertisingParameters::isExtendedAdvertisingEnabled()
+   use legacy advertising PDUs with the usual limit of 31 bytes. The number of sets which
+   can be active at the same time depends on the local adapter. If it is exceeded, the
+   \l AdvertisingError is set.
+
+   If this object is currently not in the \l UnconnectedState, nothing happens.
+
+   \note Multiple advertising sets are currently only supported on Linux with the
+   ATT-socket-based BlueZ implementation. Elsewhere, a single set is started as with the
+   other overload and more than one set results in the \l AdvertisingError.
+
+   \sa stopAdvertising()
+ */
+void QLowEnergyController::startAdvertising(
+        const QList<QLowEnergyAdvertisingParameters> &parameters,
+        const QList<QLowEnergyAdvertisingData> &advertisingData,
+        const QList<QLowEnergyAdvertisingData> &scanResponseData)
+{
+    Q_D(QLowEnergyController);
+    if (role() != PeripheralRole) {
+        qCWarning(QT_BT) << "Cannot start advertising in central role" << state();
+        return;
+    }
+    if (state() != UnconnectedState) {
+        qCWarning(QT_BT) << "Cannot start advertising in state" << state();
+        return;
+    }
+    if (parameters.isEmpty() || parameters.size() != advertisingData.size()
+            || scanResponseData.size() > parameters.size()) {
+        qCWarning(QT_BT) << "Cannot start advertising with mismatching advertising sets";
+        return;
+    }
+
+    QList<QLowEnergyAdvertisingData> responseData = scanResponseData;
+    responseData.resize(parameters.size());
+    d->startAdvertisingSets(parameters, advertisingData, responseData);
+}
+
 /*!
    Stops advertising, if this object is currently in the advertising state.
 
@@ -760,6 +1087,108 @@ void QLowEnergyController::stopAdvertising()
     d->stopAdvertising();
 }
 
+/*!
+   Sets the periodic advertising data of the advertising set with the index
+   \a advertisingSet in the list passed to \l startAdvertising() to \a data.
+   The first, or only, advertising set has the index \c 0.
+
+   Periodic advertising must be enabled for the set via
+   \l QLowEnergyAdvertisingParameters::setPeriodicAdvertisingInterval(). The data
+   may be set before advertising starts and updated at any time while it runs;
+   synchronized receivers see each update with the next periodic advertising
+   event, without connecting. At most 252 bytes of periodic advertising data are
+   sent, the rest is left out.
+
+   The controller has to be in the \l PeripheralRole for this function to work.
+
+   \note Periodic advertising is currently only supported on Linux with the
+   ATT-socket-based BlueZ implementation.
+
+   \since 6.5
+   \sa QBluetoothDeviceDiscoveryAgent::startPeriodicAdvertisingSync()
+ */
+void QLowEnergyController::setPeriodicAdvertisingData(const QLowEnergyAdvertisingData &data,
+                                                      int advertisingSet)
+{
+    Q_D(QLowEnergyController);
+    if (role() != PeripheralRole) {
+        qCWarning(QT_BT) << "Cannot set periodic advertising data in central role";
+        return;
+    }
+    if (advertisingSet < 0) {
+        qCWarning(QT_BT) << "Invalid advertising set" << advertisingSet;
+        return;
+    }
+    d->setPeriodicAdvertisingData(advertisingSet, data);
+}
+
+/*!
+   Replaces the advertising data and the scan response data of the advertising
+   set with the index \a advertisingSet in the list passed to
+   \l startAdvertising() by \a advertisingData and \a scanResponseData,
+   while advertising continues. The first, or only, advertising set has the
+   index \c 0.
+
+   Unlike a call to \l stopAdvertising() followed by \l startAdvertising(), this
+   leaves no gap in the advertising, which makes it suitable for broadcasting
+   frequently changing values such as a sensor reading in the manufacturer data.
+   Data which encodes to the bytes already advertised is not sent to the
+   adapter again. The data of a connectable advertising set is also updated
+   for the time after a central has disconnected, when advertising resumes.
+
+   The controller has to be in the \l AdvertisingState for this function to work.
+
+   \note Extended advertising data of more than 251 bytes cannot be changed
+   while the set is advertising. Such a set stops advertising briefly.
+
+   \note Updating the advertising data is currently only supported on Linux with
+   the ATT-socket-based BlueZ implementation. Elsewhere, advertising has to be
+   restarted.
+
+   \since 6.5
+   \sa startAdvertising()
+ */
+void QLowEnergyController::updateAdvertisingData(
+        const QLowEnergyAdvertisingData &advertisingData,
+        const QLowEnergyAdvertisingData &scanResponseData, int advertisingSet)
+{
+    Q_D(QLowEnergyController);
+    if (state() != AdvertisingState) {
+        qCWarning(QT_BT) << "Cannot update advertising data in state" << state();
+        return;
+    }
+    if (advertisingSet < 0) {
+        qCWarning(QT_BT) << "Invalid advertising set" << advertisingSet;
+        return;
+    }
+    d->updateAdvertisingData(advertisingSet, advertisingData, scanResponseData);
+}
+
+static bool canAddService(const QLowEnergyController *controller, bool serviceIsValid)
+{
+    if (controller->role() != QLowEnergyController::PeripheralRole) {
+        qCWarning(QT_BT) << "Services can only be added in the peripheral role";
+        return false;
+    }
+    if (controller->state() != QLowEnergyController::UnconnectedState) {
+        qCWarning(QT_BT) << "Services can only be added in unconnected state";
+        return false;
+    }
+    if (!serviceIsValid) {
+        qCWarning(QT_BT) << "Not adding invalid service";
+        return false;
+    }
+
+#if defined(QT_ANDROID_BLUETOOTH)
+    if (!ensureAndroidPermission(BluetoothPermission::Connect)) {
+        qCWarning(QT_BT_ANDROID) << "addService() failed due to missing permissions";
+        return false;
+    }
+#endif
+
+    return true;
+}
+
 /*!
   Constructs and returns a \l QLowEnergyService object with \a parent from \a service.
   The controller must be in the \l PeripheralRole and in the \l UnconnectedState. The \a service
@@ -778,28 +1207,38 @@ void QLowEnergyController::stopAdvertising()
 QLowEnergyService *QLowEnergyController::addService(const QLowEnergyServiceData &service,
                                                     QObject *parent)
 {
-    if (role() != PeripheralRole) {
-        qCWarning(QT_BT) << "Services can only be added in the peripheral role";
+    if (!canAddService(this, service.isValid()))
         return nullptr;
-    }
-    if (state() != UnconnectedState) {
-        qCWarning(QT_BT) << "Services can only be added in unconnected state";
-        return nullptr;
-    }
-    if (!service.isValid()) {
-        qCWarning(QT_BT) << "Not adding invalid service";
-        return nullptr;
-    }
 
-#if defined(QT_ANDROID_BLUETOOTH)
-    if (!ensureAndroidPermission(BluetoothPermission::Connect)) {
-        qCWarning(QT_BT_ANDROID) << "addService() failed due to missing permissions";
+    Q_D(QLowEnergyController);
+    QLowEnergyService *newService = d->addServiceHelper(service);
+    if (newService)
+        newService->setParent(parent);
+
+    return newService;
+}
+
+/*!
+  \overload
+
+  Constructs and returns a \l QLowEnergyService object with  parent from the
+  static definition  service. The same conditions as for the other overload apply.
+
+  With the ATT-socket-based BlueZ implementation the attribute table of the
+  service is built directly from  service, referencing its values instead of
+  copying them. Other platforms convert it to a \l QLowEnergyServiceData first.
+
+  \since 6.5
+  \sa QLowEnergyStaticServiceData
+ */
+QLowEnergyService *QLowEnergyController::addService(const QLowEnergyStaticServiceData &service,
+                                                    QObject *parent)
+{
+    if (!canAddService(this, service.isValid()))
         return nullptr;
-    }
-#endif
 
     Q_D(QLowEnergyController);
-    QLowEnergyService *newService = d->addServiceHelper(service);
+    QLowEnergyService *newService = d->addStaticServiceHelper(service);
     if (newService)
         newService->setParent(parent);
 
@@ -841,6 +1280,160 @@ void QLowEnergyController::requestConnectionUpdate(const QLowEnergyConnectionPar
     }
 }
 
+/*!
+  \overload
+  \since 6.5
+
+  Requests the controller to update the connection according to \a preset.
+  This is the same as calling \l requestConnectionUpdate() with the
+  parameters returned by \l connectionParameters() for \a preset.
+
+  On Android, each preset maps onto the matching connection priority.
+
+  \sa setConnectionPresetSwitchingEnabled()
+ */
+void QLowEnergyController::requestConnectionUpdate(ConnectionPreset preset)
+{
+    requestConnectionUpdate(connectionParameters(preset));
+}
+
+/*!
+  \since 6.5
+
+  Returns the connection parameters used for \a preset.
+
+  \sa requestConnectionUpdate()
+ */
+QLowEnergyConnectionParameters QLowEnergyController::connectionParameters(ConnectionPreset preset)
+{
+    QLowEnergyConnectionParameters parameters;
+    switch (preset) {
+    case ConnectionPreset::Balanced:
+        parameters.setIntervalRange(30, 50);
+        parameters.setLatency(0);
+        parameters.setSupervisionTimeout(5000);
+        break;
+    case ConnectionPreset::HighThroughput:
+        parameters.setIntervalRange(15, 30);
+        parameters.setLatency(0);
+        parameters.setSupervisionTimeout(5000);
+        break;
+    case ConnectionPreset::LowLatency:
+        parameters.setIntervalRange(7.5, 15);
+        parameters.setLatency(0);
+        parameters.setSupervisionTimeout(2000);
+        break;
+    case ConnectionPreset::LowPower:
+        // above 100 ms to map onto the low power priority on Android
+        parameters.setIntervalRange(112.5, 150);
+        parameters.setLatency(2);
+        parameters.setSupervisionTimeout(6000);
+        break;
+    }
+    return parameters;
+}
+
+/*!
+  \since 6.5
+
+  Sets whether the controller switches between connection presets by
+  itself to \a enabled. The default is \c false.
+
+  When enabled, a central controller requests the
+  \l {QLowEnergyController::ConnectionPreset}{HighThroughput} preset as
+  soon as several GATT operations were issued via \l QLowEnergyService
+  within a short time. Once no further operation was issued for two seconds,
+  it requests the \l {QLowEnergyController::ConnectionPreset}{LowPower}
+  preset. This lets bulk transfers run fast without the application
+  managing the connection parameters. The connection parameters are left
+  alone until the first such burst of operations.
+
+  The requests are subject to the same platform limitations as
+  \l requestConnectionUpdate().
+
+  \sa isConnectionPresetSwitchingEnabled()
+ */
+void QLowEnergyController::setConnectionPresetSwitchingEnabled(bool enabled)
+{
+    Q_D(QLowEnergyController);
+    d->setConnectionPresetSwitching(enabled);
+}
+
+/*!
+  \since 6.5
+
+  Returns \c true if the controller switches between connection presets by
+  itself; otherwise returns \c false.
+
+  \sa setConnectionPresetSwitchingEnabled()
+ */
+bool QLowEnergyController::isConnectionPresetSwitchingEnabled() const
+{
+    return d_ptr->connectionPresetSwitching;
+}
+
+/*!
+  Requests the controller to use \a txPhy for sending and \a rxPhy for receiving on the
+  current connection. Using \l Phy::Le2M roughly doubles the throughput of the link if
+  both devices support it. The request is a preference only; the local and the remote
+  Bluetooth controller may choose a different PHY. If the PHY changes, the
+  \l phyChanged() signal is emitted with the PHYs actually in use.
+
+  \note Currently, this functionality is only implemented on Linux with the
+  ATT-socket-based BlueZ implementation, which requires the \c CAP_NET_ADMIN capability,
+  and on Android 8.0 (API level 26) or later. Other platforms do not permit applications
+  to influence the PHY. The loopback backend grants every request.
+
+  \sa phyChanged()
+  \since 6.5
+ */
+void QLowEnergyController::requestPhy(Phy txPhy, Phy rxPhy)
+{
+    switch (state()) {
+    case ConnectedState:
+    case DiscoveredState:
+    case DiscoveringState:
+        d_ptr->requestPhy(txPhy, rxPhy);
+        break;
+    default:
+        qCWarning(QT_BT) << "PHY update request only possible in connected state";
+    }
+}
+
+/*!
+  Requests the controller to send link layer packets with up to \a txOctets payload
+  octets on the current connection. Valid values range from 27 to 251. Larger packets
+  reduce the per-packet overhead and, together with a larger \l mtu(), considerably
+  increase the throughput. If the data length changes, the \l dataLengthChanged()
+  signal is emitted with the actual new values.
+
+  \note Currently, this functionality is only implemented on Linux with the
+  ATT-socket-based BlueZ implementation, which requires the \c CAP_NET_ADMIN capability.
+  Android, iOS and macOS negotiate the data length automatically. The loopback backend
+  grants every request.
+
+  \sa dataLengthChanged()
+  \since 6.5
+ */
+void QLowEnergyController::requestDataLength(int txOctets)
+{
+    if (txOctets < 27 || txOctets > 251) {
+        qCWarning(QT_BT) << "Invalid data length" << txOctets
+                         << "requested, valid range is 27 to 251";
+        return;
+    }
+
+    switch (state()) {
+    case ConnectedState:
+    case DiscoveredState:
+    case DiscoveringState:
+        d_ptr->requestDataLength(txOctets);
+        break;
+    default:
+        qCWarning(QT_BT) << "Data length request only possible in connected state";
+    }
+}
+
 /*!
     Returns the last occurred error or \l NoError.
 */
@@ -898,6 +1491,257 @@ int QLowEnergyController::mtu() const
     return d_ptr->mtu();
 }
 
+/*!
+    Sets the ATT MTU this device asks for during the MTU exchange to \a mtu.
+    Valid values range from \c 23 to \c 517; \c -1 restores the platform's default.
+    The MTU eventually used is the smaller of this value and the one of the remote
+    device, and is reported via \l mtuChanged().
+
+    A large MTU speeds up bulk transfers as each ATT packet can carry up to
+    \b {mtu-3} bytes of payload. Devices with little memory can use a small value
+    to cap the size of the packets they have to buffer.
+
+    The MTU is exchanged when the connection is established. The value has to be
+    set before \l connectToDevice() is called if the controller is in the
+    \l CentralRole. In the \l PeripheralRole it applies to MTU exchanges
+    initiated by clients afterwards.
+
+    \note Currently, this setting is honored on Linux with the ATT-socket-based
+    BlueZ implementation and, in the \l CentralRole, on Android. BlueZ's D-Bus API,
+    iOS, macOS and Windows negotiate the MTU without letting applications
+    influence it.
+
+    \sa preferredMtu(), mtu()
+    \since 6.5
+*/
+void QLowEnergyController::setPreferredMtu(int mtu)
+{
+    if (mtu != -1 && (mtu < 23 || mtu > 517)) {
+        qCWarning(QT_BT) << "Invalid preferred MTU" << mtu << "valid range is 23 to 517";
+        return;
+    }
+    d_ptr->preferredMtu = mtu;
+}
+
+/*!
+    Returns the ATT MTU requested via \l setPreferredMtu(), or \c -1 if the
+    platform's default is used.
+
+    \sa setPreferredMtu()
+    \since 6.5
+*/
+int QLowEnergyController::preferredMtu() const
+{
+    return d_ptr->preferredMtu;
+}
+
+/*!
+    Sets the cache policy used by subsequent service discoveries to \a policy.
+    The default is \l {QLowEnergyController::GattCachePolicy}{PlatformDefault}.
+
+    The policy applies to the discovery of the services as well as to the
+    discovery of their characteristics and descriptors. Characteristic and
+    descriptor values are always read from the device, except on macOS and
+    iOS with the \l {QLowEnergyController::GattCachePolicy}{Cached} policy.
+
+    On macOS and iOS, the attributes discovered before are reused after a
+    reconnect until the device reports a change of its services, unless the
+    policy is \l {QLowEnergyController::GattCachePolicy}{Uncached}. With the
+    \l {QLowEnergyController::GattCachePolicy}{Cached} policy the values
+    read or notified during the earlier connection are reused as well.
+
+    On Linux, the backend for the kernel ATT interface, which is used with
+    bluetoothd older than 5.42, keeps the discovered attributes on disk and
+    reuses them as long as the Database Hash of the device does not change.
+    With newer versions bluetoothd maintains its own cache. The \l {QLowEnergyController::GattCachePolicy}{Cached} policy
+    enables this cache and the \l {QLowEnergyController::GattCachePolicy}{Uncached}
+    policy disables it. With the
+    \l {QLowEnergyController::GattCachePolicy}{PlatformDefault} policy it is
+    enabled only if the \c QT_BLUETOOTH_GATT_CACHE environment variable is
+    set to a positive value.
+
+    \note Currently, this setting is only honored on Windows, macOS, iOS and
+    by the kernel ATT backend on Linux.
+
+    \sa gattCachePolicy(), discoverServices(), QLowEnergyService::discoverDetails()
+    \since 6.5
+*/
+void QLowEnergyController::setGattCachePolicy(GattCachePolicy policy)
+{
+    d_ptr->gattCachePolicy = policy;
+}
+
+/*!
+    Returns the cache policy used by service discovery.
+
+    \sa setGattCachePolicy()
+    \since 6.5
+*/
+QLowEnergyController::GattCachePolicy QLowEnergyController::gattCachePolicy() const
+{
+    return d_ptr->gattCachePolicy;
+}
+
+/*!
+    Returns a snapshot of the traffic counters of the current connection.
+
+    Sampling this function periodically yields the throughput of the
+    link in each direction. The returned object is invalid if the controller is
+    not connected or the platform does not provide link statistics.
+
+    \note If the controller is in the \l PeripheralRole and serves several clients,
+    the statistics refer to the client \l remoteAddress() currently points to.
+
+    \sa QLowEnergyLinkStatistics
+    \since 6.5
+*/
+QLowEnergyLinkStatistics QLowEnergyController::linkStatistics() const
+{
+    if (state() == UnconnectedState || state() == AdvertisingState)
+        return QLowEnergyLinkStatistics();
+
+    return d_ptr->linkStatistics();
+}
+
+/*!
+    Enables the collection of request statistics if \a enabled is \c true,
+    otherwise disables it. The collection is disabled by default.
+
+    While enabled, the controller records how long each GATT request waits in
+    its queue and how long the remote device takes to answer it. Disabling the
+    collection keeps the statistics recorded so far, but \l requestStatistics()
+    returns an invalid object until the collection is enabled again.
+
+    \sa isRequestStatisticsEnabled(), resetRequestStatistics()
+    \since 6.5
+*/
+void QLowEnergyController::setRequestStatisticsEnabled(bool enabled)
+{
+    d_ptr->requestStatistics.setEnabled(enabled);
+}
+
+/*!
+    Returns \c true if the controller collects request statistics.
+
+    \sa setRequestStatisticsEnabled()
+    \since 6.5
+*/
+bool QLowEnergyController::isRequestStatisticsEnabled() const
+{
+    return d_ptr->requestStatistics.isEnabled();
+}
+
+/*!
+    Returns a snapshot of the request statistics collected since they were
+    enabled or last reset. The returned object is invalid if the collection is
+    disabled.
+
+    This function may be called at any time, including while requests are
+    pending.
+
+    \sa QLowEnergyRequestStatistics, resetRequestStatistics()
+    \since 6.5
+*/
+QLowEnergyRequestStatistics QLowEnergyController::requestStatistics() const
+{
+    return d_ptr->requestStatistics.statistics(&d_ptr->requestTimeouts);
+}
+
+/*!
+    Discards all request statistics collected so far.
+
+    \sa requestStatistics()
+    \since 6.5
+*/
+void QLowEnergyController::resetRequestStatistics()
+{
+    d_ptr->requestStatistics.reset();
+}
+
+/*!
+    Returns the approximate memory held by the internal structures of this controller.
+
+    All backends report the discovered remote services including their
+    characteristic and descriptor values (\c serviceList), the services added
+    in the \l PeripheralRole (\c localServices) and the handle index used to
+    look up services (\c serviceHandleIndex). The ATT-socket-based BlueZ
+    implementation additionally reports its local GATT database, the per-client
+    configurations and the buffers and queues of its ATT bearers.
+
+    With the \c qt.bluetooth.memory logging category enabled, the memory usage
+    is logged whenever the controller enters the \l DiscoveredState or the
+    \l UnconnectedState.
+
+    \sa QBluetoothMemoryUsage
+    \since 6.5
+*/
+QBluetoothMemoryUsage QLowEnergyController::memoryUsage() const
+{
+    QBluetoothMemoryUsage usage;
+    d_ptr->addMemoryUsage(&usage);
+    return usage;
+}
+
+/*!
+    Returns the time at which the kernel received the most recent ATT PDU
+    processed by the controller. When called from a slot connected to
+    \l QLowEnergyService::characteristicChanged(), this is the arrival time of
+    the notification or indication that triggered the signal, which allows
+    measuring the latency added by the application without clock skew of the
+    remote device.
+
+    The timestamp is only available with the kernel ATT backend of BlueZ.
+    Other backends and controllers that did not receive any PDU yet return a
+    default constructed time point.
+
+    \since 6.5
+*/
+std::chrono::system_clock::time_point QLowEnergyController::lastReceiveTimestamp() const
+{
+    return d_ptr->receiveTimestamp;
+}
+
+/*!
+    \typedef QLowEnergyController::LowLatencyNotificationHandler
+    \since 6.5
+
+    A callable receiving the value handle of a characteristic, as returned by
+    QLowEnergyCharacteristic::handle(), and the value of a notification or
+    indication. The value is only valid during the call.
+*/
+
+/*!
+    Sets the \a handler that is called for every notification and indication
+    of the remote device as soon as it was taken from the kernel. This enables
+    a low latency mode in which the ATT sockets of the connection are read on
+    dedicated threads with time critical priority, so that neither the event
+    loop of the controller's thread nor other sockets delay the data.
+
+    The handler is called on those reading threads and must be thread-safe;
+    it must neither block nor access the controller or its services. The
+    regular processing, such as updating the characteristic value and emitting
+    QLowEnergyService::characteristicChanged(), takes place afterwards as usual.
+    Passing an empty handler disables the low latency mode.
+
+    The handler takes effect with the next call to connectToDevice(). It is
+    only supported by the kernel ATT backend of BlueZ in the central role. The
+    loopback backend calls the handler in the controller's thread, right before
+    the regular processing.
+
+    On Linux, setting \c QT_BLUETOOTH_ATT_LOW_LATENCY to a positive value
+    enables the dedicated reading threads without a handler. Setting
+    \c QT_BLUETOOTH_ATT_BUSY_POLL to a number of microseconds makes the
+    threads keep polling the socket for that long after it ran dry, trading
+    CPU time for wakeup latency.
+
+    \sa lastReceiveTimestamp()
+    \since 6.5
+*/
+void QLowEnergyController::setLowLatencyNotificationHandler(LowLatencyNotificationHandler handler)
+{
+    d_ptr->lowLatencyNotificationHandler = std::move(handler);
+}
+
 QT_END_NAMESPACE
 
 #include "moc_qlowenergycontroller.cpp"
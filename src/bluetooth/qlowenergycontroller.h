@@ -7,16 +7,23 @@
 #include <QtCore/QObject>
 #include <QtBluetooth/QBluetoothAddress>
 #include <QtBluetooth/QBluetoothDeviceInfo>
+#include <QtBluetooth/QBluetoothMemoryUsage>
 #include <QtBluetooth/QBluetoothUuid>
 #include <QtBluetooth/QLowEnergyAdvertisingData>
 #include <QtBluetooth/QLowEnergyConnectionParameters>
+#include <QtBluetooth/QLowEnergyLinkStatistics>
+#include <QtBluetooth/QLowEnergyRequestStatistics>
 #include <QtBluetooth/QLowEnergyService>
 
+#include <chrono>
+#include <functional>
+
 QT_BEGIN_NAMESPACE
 
 class QLowEnergyAdvertisingParameters;
 class QLowEnergyControllerPrivate;
 class QLowEnergyServiceData;
+struct QLowEnergyStaticServiceData;
 
 class Q_BLUETOOTH_EXPORT QLowEnergyController : public QObject
 {
@@ -56,6 +63,28 @@ public:
     enum Role { CentralRole, PeripheralRole };
     Q_ENUM(Role)
 
+    enum class Phy {
+        Le1M = 1,
+        Le2M,
+        LeCoded
+    };
+    Q_ENUM(Phy)
+
+    enum class GattCachePolicy {
+        PlatformDefault,
+        Cached,
+        Uncached
+    };
+    Q_ENUM(GattCachePolicy)
+
+    enum class ConnectionPreset {
+        Balanced,
+        HighThroughput,
+        LowLatency,
+        LowPower
+    };
+    Q_ENUM(ConnectionPreset)
+
     static QLowEnergyController *createCentral(const QBluetoothDeviceInfo &remoteDevice,
                                                QObject *parent = nullptr);
     static QLowEnergyController *createCentral(const QBluetoothDeviceInfo &remoteDevice,
@@ -83,19 +112,37 @@ public:
 
     void connectToDevice();
     void disconnectFromDevice();
+    void setAutoConnectEnabled(bool enabled);
+    bool isAutoConnectEnabled() const;
 
     void discoverServices();
+    void discoverServices(const QList<QBluetoothUuid> &serviceUuids);
     QList<QBluetoothUuid> services() const;
     QLowEnergyService *createServiceObject(const QBluetoothUuid &service, QObject *parent = nullptr);
 
     void startAdvertising(const QLowEnergyAdvertisingParameters &parameters,
                           const QLowEnergyAdvertisingData &advertisingData,
                           const QLowEnergyAdvertisingData &scanResponseData = QLowEnergyAdvertisingData());
+    void startAdvertising(const QList<QLowEnergyAdvertisingParameters> &parameters,
+                          const QList<QLowEnergyAdvertisingData> &advertisingData,
+                          const QList<QLowEnergyAdvertisingData> &scanResponseData = {});
     void stopAdvertising();
+    void setPeriodicAdvertisingData(const QLowEnergyAdvertisingData &data, int advertisingSet = 0);
+    void updateAdvertisingData(const QLowEnergyAdvertisingData &advertisingData,
+                               const QLowEnergyAdvertisingData &scanResponseData = QLowEnergyAdvertisingData(),
+                               int advertisingSet = 0);
 
     QLowEnergyService *addService(const QLowEnergyServiceData &service, QObject *parent = nullptr);
+    QLowEnergyService *addService(const QLowEnergyStaticServiceData &service,
+                                  QObject *parent = nullptr);
 
     void requestConnectionUpdate(const QLowEnergyConnectionParameters &parameters);
+    void requestConnectionUpdate(ConnectionPreset preset);
+    static QLowEnergyConnectionParameters connectionParameters(ConnectionPreset preset);
+    void setConnectionPresetSwitchingEnabled(bool enabled);
+    bool isConnectionPresetSwitchingEnabled() const;
+    void requestPhy(Phy txPhy, Phy rxPhy);
+    void requestDataLength(int txOctets);
 
     Error error() const;
     QString errorString() const;
@@ -103,6 +150,26 @@ public:
     Role role() const;
 
     int mtu() const;
+    void setPreferredMtu(int mtu);
+    int preferredMtu() const;
+
+    void setGattCachePolicy(GattCachePolicy policy);
+    GattCachePolicy gattCachePolicy() const;
+
+    QLowEnergyLinkStatistics linkStatistics() const;
+
+    void setRequestStatisticsEnabled(bool enabled);
+    bool isRequestStatisticsEnabled() const;
+    QLowEnergyRequestStatistics requestStatistics() const;
+    void resetRequestStatistics();
+
+    QBluetoothMemoryUsage memoryUsage() const;
+
+    std::chrono::system_clock::time_point lastReceiveTimestamp() const;
+
+    using LowLatencyNotificationHandler =
+            std::function<void(QLowEnergyHandle characteristicHandle, QByteArrayView value)>;
+    void setLowLatencyNotificationHandler(LowLatencyNotificationHandler handler);
 
 Q_SIGNALS:
     void connected();
@@ -114,6 +181,9 @@ Q_SIGNALS:
     void serviceDiscovered(const QBluetoothUuid &newService);
     void discoveryFinished();
     void connectionUpdated(const QLowEnergyConnectionParameters &parameters);
+    void congestionChanged(bool congested);
+    void phyChanged(QLowEnergyController::Phy txPhy, QLowEnergyController::Phy rxPhy);
+    void dataLengthChanged(int txOctets, int rxOctets);
 
 private:
     // peripheral role ctor
@@ -124,6 +194,8 @@ private:
                                   const QBluetoothAddress &localDevice,
                                   QObject *parent = nullptr);
 
+    // moves queued controllers between adapters
+    friend class QLowEnergyConnectionSchedulerPrivate;
 
     Q_DECLARE_PRIVATE(QLowEnergyController)
     QLowEnergyControllerPrivate *d_ptr;
@@ -141,5 +213,7 @@ QT_DECL_METATYPE_EXTERN_TAGGED(QLowEnergyController::RemoteAddressType,
                                Q_BLUETOOTH_EXPORT)
 QT_DECL_METATYPE_EXTERN_TAGGED(QLowEnergyController::Role, QLowEnergyController__Role,
                                Q_BLUETOOTH_EXPORT)
+QT_DECL_METATYPE_EXTERN_TAGGED(QLowEnergyController::Phy, QLowEnergyController__Phy,
+                               Q_BLUETOOTH_EXPORT)
 
 #endif // QLOWENERGYCONTROLLER_H
@@ -3,10 +3,12 @@
 
 #include "qlowenergycontroller_android_p.h"
 #include "android/androidutils_p.h"
+#include <qtbluetooth_tracepoints_p.h>
 #include <QCoreApplication>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QJniEnvironment>
 #include <QtCore/QJniObject>
+#include <QtCore/qendian.h>
 #include <QtBluetooth/QLowEnergyServiceData>
 #include <QtBluetooth/QLowEnergyCharacteristicData>
 #include <QtBluetooth/QLowEnergyDescriptorData>
@@ -81,6 +83,8 @@ void QLowEnergyControllerPrivateAndroid::init()
                 this, &QLowEnergyControllerPrivateAndroid::connectionUpdated);
         connect(hub, &LowEnergyNotificationHub::mtuChanged,
                 this, &QLowEnergyControllerPrivateAndroid::mtuChanged);
+        connect(hub, &LowEnergyNotificationHub::phyUpdated,
+                this, &QLowEnergyControllerPrivateAndroid::phyUpdated);
         connect(hub, &LowEnergyNotificationHub::servicesDiscovered,
                 this, &QLowEnergyControllerPrivateAndroid::servicesDiscovered);
         connect(hub, &LowEnergyNotificationHub::serviceDetailsDiscoveryFinished,
@@ -130,6 +134,8 @@ void QLowEnergyControllerPrivateAndroid::connectToDevice()
         return;
     }
 
+    hub->javaObject().callMethod<void>("setPreferredMtu", "(I)V", jint(preferredMtu));
+    hub->javaObject().callMethod<void>("setAutoConnect", "(Z)V", jboolean(autoConnect));
     bool result = hub->javaObject().callMethod<jboolean>("connect");
     if (!result) {
         setError(QLowEnergyController::ConnectionError);
@@ -177,7 +183,8 @@ void QLowEnergyControllerPrivateAndroid::discoverServiceDetails(
         const QBluetoothUuid &service, QLowEnergyService::DiscoveryMode mode)
 {
     Q_UNUSED(mode);
-    if (!serviceList.contains(service)) {
+    const QSharedPointer<QLowEnergyServicePrivate> servicePrivate = serviceList.value(service);
+    if (!servicePrivate) {
         qCWarning(QT_BT_ANDROID) << "Discovery of unknown service" << service.toString()
                                  << "not possible";
         return;
@@ -190,18 +197,30 @@ void QLowEnergyControllerPrivateAndroid::discoverServiceDetails(
 
     QJniEnvironment env;
     QJniObject uuid = QJniObject::fromString(tempUuid);
-    bool readAllValues = mode == QLowEnergyService::FullDiscovery;
+    // the descriptors are part of the Android service object, only their values are optional
+    const bool readCharacteristics = servicePrivate->discoveryTargets.testFlag(
+            QLowEnergyService::CharacteristicValueDiscovery);
+    const bool readDescriptors = servicePrivate->discoveryTargets.testFlag(
+            QLowEnergyService::DescriptorValueDiscovery);
+    const QList<QBluetoothUuid> &filter = servicePrivate->discoveryFilter;
+    jobjectArray characteristicUuids = env->NewObjectArray(jsize(filter.size()),
+                                                           env->FindClass("java/lang/String"),
+                                                           nullptr);
+    for (qsizetype i = 0; i < filter.size(); ++i) {
+        QJniObject characteristicUuid =
+                QJniObject::fromString(filter.at(i).toString(QUuid::WithoutBraces));
+        env->SetObjectArrayElement(characteristicUuids, jsize(i),
+                                   characteristicUuid.object<jstring>());
+    }
     bool result = hub->javaObject().callMethod<jboolean>("discoverServiceDetails",
-                                                         "(Ljava/lang/String;Z)Z",
+                                                         "(Ljava/lang/String;ZZ[Ljava/lang/String;)Z",
                                                          uuid.object<jstring>(),
-                                                         readAllValues);
+                                                         readCharacteristics, readDescriptors,
+                                                         characteristicUuids);
+    env->DeleteLocalRef(characteristicUuids);
     if (!result) {
-        QSharedPointer<QLowEnergyServicePrivate> servicePrivate =
-                serviceList.value(service);
-        if (!servicePrivate.isNull()) {
-            servicePrivate->setError(QLowEnergyService::UnknownError);
-            servicePrivate->setState(QLowEnergyService::RemoteService);
-        }
+        servicePrivate->setError(QLowEnergyService::UnknownError);
+        servicePrivate->setState(QLowEnergyService::RemoteService);
         qCWarning(QT_BT_ANDROID) << "Cannot discover details for" << service.toString();
         return;
     }
@@ -209,6 +228,16 @@ void QLowEnergyControllerPrivateAndroid::discoverServiceDetails(
     qCDebug(QT_BT_ANDROID) << "Discovery of" << service << "started";
 }
 
+bool QLowEnergyControllerPrivateAndroid::cancelRequests(QLowEnergyServicePrivate *service)
+{
+    if (!hub || role != QLowEnergyController::CentralRole)
+        return false;
+
+    QJniObject uuid = QJniObject::fromString(service->uuid.toString(QUuid::WithoutBraces));
+    return hub->javaObject().callMethod<jboolean>("cancelServiceJobs", "(Ljava/lang/String;)Z",
+                                                  uuid.object<jstring>());
+}
+
 void QLowEnergyControllerPrivateAndroid::writeCharacteristic(
         const QSharedPointer<QLowEnergyServicePrivate> service,
         const QLowEnergyHandle charHandle,
@@ -222,10 +251,7 @@ void QLowEnergyControllerPrivateAndroid::writeCharacteristic(
         return;
 
     QJniEnvironment env;
-    jbyteArray payload;
-    payload = env->NewByteArray(newValue.size());
-    env->SetByteArrayRegion(payload, 0, newValue.size(),
-                            (jbyte *)newValue.constData());
+    jbyteArray payload = toJavaByteArray(env.jniEnv(), newValue);
 
     bool result = false;
     if (hub) {
@@ -234,6 +260,10 @@ void QLowEnergyControllerPrivateAndroid::writeCharacteristic(
                      << newValue.toHex() << "(service:" << service->uuid
                      << ", writeWithResponse:" << (mode == QLowEnergyService::WriteWithResponse)
                      << ", signed:" << (mode == QLowEnergyService::WriteSigned) << ")";
+            Q_TRACE(QLowEnergyController_requestQueued,
+                    mode == QLowEnergyService::WriteWithResponse ? TraceWriteRequest
+                                                                 : TraceWriteCommand,
+                    charHandle, int(newValue.size()));
             result = hub->javaObject().callMethod<jboolean>("writeCharacteristic", "(I[BI)Z",
                           charHandle, payload, mode);
         } else { // peripheral mode
@@ -266,16 +296,15 @@ void QLowEnergyControllerPrivateAndroid::writeDescriptor(
     Q_ASSERT(!service.isNull());
 
     QJniEnvironment env;
-    jbyteArray payload;
-    payload = env->NewByteArray(newValue.size());
-    env->SetByteArrayRegion(payload, 0, newValue.size(),
-                            (jbyte *)newValue.constData());
+    jbyteArray payload = toJavaByteArray(env.jniEnv(), newValue);
 
     bool result = false;
     if (hub) {
         if (role == QLowEnergyController::CentralRole) {
             qCDebug(QT_BT_ANDROID) << "Write descriptor with handle " << descHandle
                      << newValue.toHex() << "(service:" << service->uuid << ")";
+            Q_TRACE(QLowEnergyController_requestQueued, TraceWriteRequest, descHandle,
+                    int(newValue.size()));
             result = hub->javaObject().callMethod<jboolean>("writeDescriptor", "(I[B)Z",
                                                             descHandle, payload);
         } else {
@@ -316,6 +345,7 @@ void QLowEnergyControllerPrivateAndroid::readCharacteristic(
     if (hub) {
         qCDebug(QT_BT_ANDROID) << "Read characteristic with handle"
                                <<  charHandle << service->uuid;
+        Q_TRACE(QLowEnergyController_requestQueued, TraceReadRequest, charHandle, 0);
         result = hub->javaObject().callMethod<jboolean>("readCharacteristic",
                       "(I)Z", charHandle);
     }
@@ -336,6 +366,7 @@ void QLowEnergyControllerPrivateAndroid::readDescriptor(
     if (hub) {
         qCDebug(QT_BT_ANDROID) << "Read descriptor with handle"
                                <<  descriptorHandle << service->uuid;
+        Q_TRACE(QLowEnergyController_requestQueued, TraceReadRequest, descriptorHandle, 0);
         result = hub->javaObject().callMethod<jboolean>("readDescriptor",
                       "(I)Z", descriptorHandle);
     }
@@ -367,6 +398,14 @@ void QLowEnergyControllerPrivateAndroid::mtuChanged(int mtu)
     emit q->mtuChanged(mtu);
 }
 
+void QLowEnergyControllerPrivateAndroid::phyUpdated(int txPhy, int rxPhy)
+{
+    Q_Q(QLowEnergyController);
+    qCDebug(QT_BT_ANDROID) << "PHY updated:"
+                           << "tx:" << txPhy << "rx:" << rxPhy;
+    emit q->phyChanged(QLowEnergyController::Phy(txPhy), QLowEnergyController::Phy(rxPhy));
+}
+
 
 // called if server/peripheral
 void QLowEnergyControllerPrivateAndroid::peripheralConnectionUpdated(
@@ -462,6 +501,8 @@ void QLowEnergyControllerPrivateAndroid::servicesDiscovered(
             const QBluetoothUuid service(entry);
             if (service.isNull())
                 return;
+            if (!isServiceInDiscoveryFilter(service))
+                continue;
 
             QLowEnergyServicePrivate *priv = new QLowEnergyServicePrivate();
             priv->uuid = service;
@@ -481,8 +522,57 @@ void QLowEnergyControllerPrivateAndroid::servicesDiscovered(
     }
 }
 
+/*
+    Fills the characteristics and descriptors of \a service from the entries
+    QtBluetoothLE.java collected during the discovery. Each entry is its type,
+    handle, properties, UUID and value length in big endian order, followed by
+    the value. Descriptors follow their characteristic.
+ */
+static bool decodeServiceDetails(QLowEnergyServicePrivate *service, QByteArrayView details)
+{
+    enum EntryType : quint8 { CharacteristicEntry = 0, DescriptorEntry = 1 };
+    constexpr qsizetype headerSize = 1 + 4 + 4 + 16 + 4;
+
+    QLowEnergyHandle charHandle = 0;
+    for (qsizetype offset = 0; offset < details.size();) {
+        if (details.size() - offset < headerSize)
+            return false;
+        const char *header = details.data() + offset;
+        const quint8 type = quint8(header[0]);
+        const QLowEnergyHandle handle = qFromBigEndian<quint32>(header + 1);
+        const int properties = qFromBigEndian<qint32>(header + 5);
+        const QBluetoothUuid uuid = QUuid::fromRfc4122(QByteArrayView(header + 9, 16));
+        const qint32 valueLength = qFromBigEndian<qint32>(header + 25);
+        offset += headerSize;
+        if (valueLength < 0 || details.size() - offset < valueLength)
+            return false;
+        const QByteArray value = details.sliced(offset, valueLength).toByteArray();
+        offset += valueLength;
+
+        if (type == CharacteristicEntry) {
+            charHandle = handle;
+            QLowEnergyServicePrivate::CharData &charDetails =
+                    service->characteristicList[charHandle];
+            //Android uses same property value as Qt which is the Bluetooth LE standard
+            charDetails.properties = QLowEnergyCharacteristic::PropertyType(properties);
+            charDetails.uuid = uuid;
+            charDetails.value = value;
+            //value handle always one larger than characteristics value handle
+            charDetails.valueHandle = charHandle + 1;
+        } else if (type == DescriptorEntry && charHandle) {
+            QLowEnergyServicePrivate::DescData &descDetails =
+                    service->characteristicList[charHandle].descriptorList[handle];
+            descDetails.uuid = uuid;
+            descDetails.value = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
 void QLowEnergyControllerPrivateAndroid::serviceDetailsDiscoveryFinished(
-        const QString &serviceUuid, int startHandle, int endHandle)
+        const QString &serviceUuid, int startHandle, int endHandle, const QByteArray &details)
 {
     const QBluetoothUuid service(serviceUuid);
     if (!serviceList.contains(service)) {
@@ -496,6 +586,8 @@ void QLowEnergyControllerPrivateAndroid::serviceDetailsDiscoveryFinished(
             serviceList.value(service);
     pointer->startHandle = startHandle;
     pointer->endHandle = endHandle;
+    if (!decodeServiceDetails(pointer.data(), details))
+        qCWarning(QT_BT_ANDROID) << "Invalid details for service" << serviceUuid;
 
     if (hub && hub->javaObject().isValid()) {
         QJniObject uuid = QJniObject::fromString(serviceUuid);
@@ -532,6 +624,8 @@ void QLowEnergyControllerPrivateAndroid::characteristicRead(
         const QBluetoothUuid &serviceUuid, int handle,
         const QBluetoothUuid &charUuid, int properties, const QByteArray &data)
 {
+    Q_TRACE(QLowEnergyController_responseReceived, TraceReadResponse, handle, int(data.size()));
+
     if (!serviceList.contains(serviceUuid))
         return;
 
@@ -563,6 +657,9 @@ void QLowEnergyControllerPrivateAndroid::descriptorRead(
         const QBluetoothUuid &serviceUuid, const QBluetoothUuid &charUuid,
         int descHandle, const QBluetoothUuid &descUuid, const QByteArray &data)
 {
+    Q_TRACE(QLowEnergyController_responseReceived, TraceReadResponse, descHandle,
+            int(data.size()));
+
     if (!serviceList.contains(serviceUuid))
         return;
 
@@ -603,6 +700,9 @@ void QLowEnergyControllerPrivateAndroid::descriptorRead(
 void QLowEnergyControllerPrivateAndroid::characteristicWritten(
         int charHandle, const QByteArray &data, QLowEnergyService::ServiceError errorCode)
 {
+    Q_TRACE(QLowEnergyController_responseReceived, TraceWriteResponse, charHandle,
+            int(data.size()));
+
     QSharedPointer<QLowEnergyServicePrivate> service =
             serviceForHandle(charHandle);
     if (service.isNull())
@@ -632,6 +732,9 @@ void QLowEnergyControllerPrivateAndroid::characteristicWritten(
 void QLowEnergyControllerPrivateAndroid::descriptorWritten(
         int descHandle, const QByteArray &data, QLowEnergyService::ServiceError errorCode)
 {
+    Q_TRACE(QLowEnergyController_responseReceived, TraceWriteResponse, descHandle,
+            int(data.size()));
+
     QSharedPointer<QLowEnergyServicePrivate> service =
             serviceForHandle(descHandle);
     if (service.isNull())
@@ -724,6 +827,10 @@ void QLowEnergyControllerPrivateAndroid::serverDescriptorWritten(
 void QLowEnergyControllerPrivateAndroid::characteristicChanged(
         int charHandle, const QByteArray &data)
 {
+    Q_TRACE(QLowEnergyController_notificationReceived, TraceNotification, charHandle,
+            int(data.size()));
+    requestStatistics.recordNotification();
+
     QSharedPointer<QLowEnergyServicePrivate> service =
             serviceForHandle(charHandle);
     if (service.isNull())
@@ -740,10 +847,8 @@ void QLowEnergyControllerPrivateAndroid::characteristicChanged(
 
     // only update cache when property is readable. Otherwise it remains
     // empty.
-    if (characteristic.properties() & QLowEnergyCharacteristic::Read)
-        updateValueOfCharacteristic(characteristic.attributeHandle(),
-                                data, false);
-    emit service->characteristicChanged(characteristic, data);
+    updateValueOfChangedCharacteristic(characteristic, data);
+    service->notifyCharacteristicChanged(characteristic, data);
 }
 
 void QLowEnergyControllerPrivateAndroid::serverCharacteristicChanged(
@@ -792,7 +897,7 @@ void QLowEnergyControllerPrivateAndroid::serverCharacteristicChanged(
     if (!foundHandle)
         return;
 
-    emit servicePrivate->characteristicChanged(
+    servicePrivate->notifyCharacteristicChanged(
                 QLowEnergyCharacteristic(servicePrivate, foundHandle), newValue);
 }
 
@@ -892,10 +997,7 @@ static QJniObject createJavaAdvertiseData(const QLowEnergyAdvertisingData &data)
 
     if (!data.manufacturerData().isEmpty()) {
         QJniEnvironment env;
-        const qint32 nativeSize = data.manufacturerData().size();
-        jbyteArray nativeData = env->NewByteArray(nativeSize);
-        env->SetByteArrayRegion(nativeData, 0, nativeSize,
-                                reinterpret_cast<const jbyte*>(data.manufacturerData().constData()));
+        jbyteArray nativeData = toJavaByteArray(env.jniEnv(), data.manufacturerData());
         builder = builder.callObjectMethod("addManufacturerData",
                                        "(I[B)Landroid/bluetooth/le/AdvertiseData$Builder;",
                                        data.manufacturerId(), nativeData);
@@ -1022,6 +1124,23 @@ void QLowEnergyControllerPrivateAndroid::requestConnectionUpdate(const QLowEnerg
         qCWarning(QT_BT_ANDROID) << "Cannot set connection update priority";
 }
 
+void QLowEnergyControllerPrivateAndroid::requestPhy(QLowEnergyController::Phy txPhy,
+                                                    QLowEnergyController::Phy rxPhy)
+{
+    if (role != QLowEnergyController::CentralRole) {
+        qCWarning(QT_BT_ANDROID) << "On Android, PHY update requests only work for central role";
+        return;
+    }
+
+    // BluetoothDevice.PHY_LE_*_MASK
+    const jint txMask = 1 << (int(txPhy) - 1);
+    const jint rxMask = 1 << (int(rxPhy) - 1);
+    const bool result = hub->javaObject().callMethod<jboolean>("requestPhy", "(II)Z",
+                                                               txMask, rxMask);
+    if (!result)
+        qCWarning(QT_BT_ANDROID) << "Cannot request PHY update, requires Android 8.0 or later";
+}
+
 /*
  * Returns the Java char permissions based on the given characteristic data.
  */
@@ -1210,8 +1329,7 @@ void QLowEnergyControllerPrivateAndroid::addToGenericAttributeList(const QLowEne
                            charData.maximumValueLength());
 
         QJniEnvironment env;
-        jbyteArray jb = env->NewByteArray(charData.value().size());
-        env->SetByteArrayRegion(jb, 0, charData.value().size(), (jbyte*)charData.value().data());
+        jbyteArray jb = toJavaByteArray(env.jniEnv(), charData.value());
         jboolean success = javaChar.callMethod<jboolean>("setValue", "([B)Z", jb);
         if (!success)
             qCWarning(QT_BT_ANDROID) << "Cannot setup initial characteristic value for " << charData.uuid();
@@ -1225,8 +1343,7 @@ void QLowEnergyControllerPrivateAndroid::addToGenericAttributeList(const QLowEne
                                                            javaUuidfromQtUuid(descData.uuid()).object(),
                                                            setupDescPermissions(descData));
 
-            jb = env->NewByteArray(descData.value().size());
-            env->SetByteArrayRegion(jb, 0, descData.value().size(), (jbyte*)descData.value().data());
+            jb = toJavaByteArray(env.jniEnv(), descData.value());
             success = javaDesc.callMethod<jboolean>("setValue", "([B)Z", jb);
             if (!success) {
                 qCWarning(QT_BT_ANDROID) << "Cannot setup initial descriptor value for "
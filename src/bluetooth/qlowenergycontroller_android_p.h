@@ -59,6 +59,7 @@ public:
     void stopAdvertising() override;
 
     void requestConnectionUpdate(const QLowEnergyConnectionParameters &params) override;
+    void requestPhy(QLowEnergyController::Phy txPhy, QLowEnergyController::Phy rxPhy) override;
 
     // read data
     void readCharacteristic(const QSharedPointer<QLowEnergyServicePrivate> service,
@@ -75,6 +76,7 @@ public:
                          const QLowEnergyHandle charHandle,
                          const QLowEnergyHandle descriptorHandle,
                          const QByteArray &newValue) override;
+    bool cancelRequests(QLowEnergyServicePrivate *service) override;
 
     void addToGenericAttributeList(const QLowEnergyServiceData &service,
                                    QLowEnergyHandle startHandle) override;
@@ -89,10 +91,12 @@ private slots:
     void connectionUpdated(QLowEnergyController::ControllerState newState,
                            QLowEnergyController::Error errorCode);
     void mtuChanged(int mtu);
+    void phyUpdated(int txPhy, int rxPhy);
     void servicesDiscovered(QLowEnergyController::Error errorCode,
                             const QString &foundServices);
     void serviceDetailsDiscoveryFinished(const QString& serviceUuid,
-                                         int startHandle, int endHandle);
+                                         int startHandle, int endHandle,
+                                         const QByteArray &details);
     void characteristicRead(const QBluetoothUuid &serviceUuid, int handle,
                             const QBluetoothUuid &charUuid, int properties,
                             const QByteArray& data);
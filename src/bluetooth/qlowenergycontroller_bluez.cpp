@@ -3,31 +3,43 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include "lecmaccalculator_p.h"
+#include "qbluetoothmemoryusage_p.h"
+#include "qlowenergylinkstatistics_p.h"
 #include "qlowenergycontroller_bluez_p.h"
 #include "qbluetoothsocketbase_p.h"
 #include "qbluetoothsocket_bluez_p.h"
 #include "qleadvertiser_bluez_p.h"
+#include "bluez/attpdu_p.h"
 #include "bluez/bluez_data_p.h"
 #include "bluez/hcimanager_p.h"
 #include "bluez/objectmanager_p.h"
 #include "bluez/remotedevicemanager_p.h"
 #include "bluez/bluez5_helper_p.h"
 #include "bluez/bluetoothmanagement_p.h"
+#include <qtbluetooth_tracepoints_p.h>
 
+#include <QtCore/QDataStream>
+#include <QtCore/QFile>
 #include <QtCore/QFileInfo>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QPointer>
+#include <QtCore/QScopeGuard>
 #include <QtCore/QSettings>
+#include <QtCore/QStandardPaths>
 #include <QtCore/QTimer>
+#include <QtCore/QVarLengthArray>
 #include <QtBluetooth/QBluetoothLocalDevice>
 #include <QtBluetooth/QBluetoothSocket>
 #include <QtBluetooth/QLowEnergyCharacteristicData>
 #include <QtBluetooth/QLowEnergyDescriptorData>
 #include <QtBluetooth/QLowEnergyService>
 #include <QtBluetooth/QLowEnergyServiceData>
+#include <QtBluetooth/qlowenergystaticservicedata.h>
 
 #include <algorithm>
 #include <climits>
 #include <cstring>
+#include <limits>
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -40,18 +52,11 @@ constexpr quint16 ATT_MAX_LE_MTU = 0x200;
 #define GATT_SECONDARY_SERVICE  quint16(0x2801)
 #define GATT_INCLUDED_SERVICE   quint16(0x2802)
 #define GATT_CHARACTERISTIC     quint16(0x2803)
+#define GATT_DATABASE_HASH      quint16(0x2b2a)
 
 //GATT command sizes in bytes
-#define ERROR_RESPONSE_HEADER_SIZE 5
-#define FIND_INFO_REQUEST_HEADER_SIZE 5
-#define GRP_TYPE_REQ_HEADER_SIZE 7
-#define READ_BY_TYPE_REQ_HEADER_SIZE 7
-#define READ_REQUEST_HEADER_SIZE 3
-#define READ_BLOB_REQUEST_HEADER_SIZE 5
 #define WRITE_REQUEST_HEADER_SIZE 3    // same size for WRITE_COMMAND header
 #define PREPARE_WRITE_HEADER_SIZE 5
-#define EXECUTE_WRITE_HEADER_SIZE 2
-#define MTU_EXCHANGE_HEADER_SIZE 3
 
 #define APPEND_VALUE true
 #define NEW_VALUE false
@@ -64,35 +69,17 @@ using namespace QBluetooth;
 
 const int maxPrepareQueueSize = 1024;
 
-static inline QBluetoothUuid convert_uuid128(const quint128 *p)
-{
-    quint128 dst_hostOrder, dst_bigEndian;
-
-    // Bluetooth LE data comes as little endian
-    // uuids are constructed using high endian
-    btoh128(p, &dst_hostOrder);
-    hton128(&dst_hostOrder, &dst_bigEndian);
-
-    // convert to Qt's own data type
-    quint128 qtdst;
-    memcpy(&qtdst, &dst_bigEndian, sizeof(quint128));
-
-    return QBluetoothUuid(qtdst);
-}
-
 static void dumpErrorInformation(const QByteArray &response)
 {
-    const char *data = response.constData();
-    if (response.size() != 5
-        || (static_cast<QBluezConst::AttCommand>(data[0])
-            != QBluezConst::AttCommand::ATT_OP_ERROR_RESPONSE)) {
+    QBluezAtt::ErrorResponse error;
+    if (!QBluezAtt::parseErrorResponse(response, &error)) {
         qCWarning(QT_BT_BLUEZ) << QLatin1String("Not a valid error response");
         return;
     }
 
-    QBluezConst::AttCommand lastCommand = static_cast<QBluezConst::AttCommand>(data[1]);
-    quint16 handle = bt_get_le16(&data[2]);
-    QBluezConst::AttError errorCode = static_cast<QBluezConst::AttError>(data[4]);
+    const QBluezConst::AttCommand lastCommand = error.request;
+    const quint16 handle = error.handle;
+    const QBluezConst::AttError errorCode = error.code;
 
     QString errorString;
     switch (errorCode) {
@@ -149,6 +136,44 @@ static int getUuidSize(const QBluetoothUuid &uuid)
     return uuid.minimumSize() == 2 ? 2 : 16;
 }
 
+static QByteArray uuidToByteArray(const QBluetoothUuid &uuid)
+{
+    QByteArray ba;
+    if (uuid.minimumSize() == 2) {
+        ba.resize(2);
+        putBtData(uuid.toUInt16(), ba.data());
+    } else {
+        ba.resize(16);
+        quint128 hostOrder;
+        quint128 qtUuidOrder = uuid.toUInt128();
+        ntoh128(&qtUuidOrder, &hostOrder);
+        putBtData(hostOrder, ba.data());
+    }
+    return ba;
+}
+
+static QLowEnergyRequestStatistics::Operation requestOperation(QBluezConst::AttCommand command)
+{
+    using Operation = QLowEnergyRequestStatistics::Operation;
+
+    switch (command) {
+    case QBluezConst::AttCommand::ATT_OP_READ_REQUEST:
+    case QBluezConst::AttCommand::ATT_OP_READ_BLOB_REQUEST:
+    case QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_REQUEST:
+    case QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST:
+        return Operation::Read;
+    case QBluezConst::AttCommand::ATT_OP_WRITE_REQUEST:
+    case QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_REQUEST:
+    case QBluezConst::AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST:
+        return Operation::Write;
+    case QBluezConst::AttCommand::ATT_OP_WRITE_COMMAND:
+    case QBluezConst::AttCommand::ATT_OP_SIGNED_WRITE_COMMAND:
+        return Operation::WriteWithoutResponse;
+    default:
+        return Operation::Discovery;
+    }
+}
+
 template<typename T> static void putDataAndIncrement(const T &src, char *&dst)
 {
     putBtData(src, dst);
@@ -177,8 +202,6 @@ template<> void putDataAndIncrement(const QByteArray &value, char *&dst)
 QLowEnergyControllerPrivateBluez::QLowEnergyControllerPrivateBluez()
     : QLowEnergyControllerPrivate(),
       requestPending(false),
-      mtuSize(ATT_DEFAULT_LE_MTU),
-      securityLevelValue(-1),
       encryptionChangePending(false)
 {
     registerQLowEnergyControllerMetaType();
@@ -187,41 +210,47 @@ QLowEnergyControllerPrivateBluez::QLowEnergyControllerPrivateBluez()
 
 void QLowEnergyControllerPrivateBluez::init()
 {
-    hciManager = new HciManager(localAdapter, this);
-    if (!hciManager->isValid()){
+    // a replayed capture takes the place of the remote device and the local adapter
+    if (role == QLowEnergyController::CentralRole
+            && Q_UNLIKELY(!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_ATT_REPLAY"))) {
+        attReplayFileName = qEnvironmentVariable("QT_BLUETOOTH_ATT_REPLAY");
+        qCWarning(QT_BT_BLUEZ) << "Replaying ATT capture" << attReplayFileName;
+    }
+
+    hciManager = HciManager::forAdapter(localAdapter);
+    if (!hciManager->isValid() && !isReplaying()) {
         setError(QLowEnergyController::InvalidBluetoothAdapterError);
         return;
     }
 
-    hciManager->monitorEvent(HciManager::HciEvent::EVT_ENCRYPT_CHANGE);
-    connect(hciManager, SIGNAL(encryptionChangedEvent(QBluetoothAddress,bool)),
-            this, SLOT(encryptionChangedEvent(QBluetoothAddress,bool)));
-    hciManager->monitorEvent(HciManager::HciEvent::EVT_LE_META_EVENT);
-    hciManager->monitorAclPackets();
-    connect(hciManager, &HciManager::connectionComplete, [this](quint16 handle) {
-        connectionHandle = handle;
-        qCDebug(QT_BT_BLUEZ) << "received connection complete event, handle:" << handle;
-    });
-    connect(hciManager, &HciManager::connectionUpdate,
-            [this](quint16 handle, const QLowEnergyConnectionParameters &params) {
-                if (handle == connectionHandle)
-                    emit q_ptr->connectionUpdated(params);
-            }
-    );
-    connect(hciManager, &HciManager::signatureResolvingKeyReceived,
-            [this](quint16 handle, bool remoteKey, const quint128 &csrk) {
-                if (handle != connectionHandle)
-                    return;
-                if ((remoteKey && role == QLowEnergyController::CentralRole)
-                        || (!remoteKey && role == QLowEnergyController::PeripheralRole)) {
-                    return;
-                }
-                qCDebug(QT_BT_BLUEZ) << "received new signature resolving key"
-                                     << QByteArray(reinterpret_cast<const char *>(csrk.data),
-                                                   sizeof csrk).toHex();
-                signingData.insert(remoteDevice.toUInt64(), SigningData(csrk));
-        }
-    );
+    connectHciManager();
+
+    if (Q_UNLIKELY(!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_SEND_QUEUE_HIGH_WATER_MARK"))) {
+        bool ok = false;
+        const int value = qEnvironmentVariableIntValue("QT_BLUETOOTH_SEND_QUEUE_HIGH_WATER_MARK",
+                                                       &ok);
+        if (ok && value > 0)
+            sendQueueHighWaterMark = value;
+    }
+
+    if (Q_UNLIKELY(!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_INDICATION_QUEUE_LIMIT"))) {
+        bool ok = false;
+        const int value = qEnvironmentVariableIntValue("QT_BLUETOOTH_INDICATION_QUEUE_LIMIT",
+                                                       &ok);
+        if (ok && value > 0)
+            indicationQueueLimit = value;
+    }
+
+    if (Q_UNLIKELY(!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_ATT_CAPTURE")) && !isReplaying())
+        attCapture.open(qEnvironmentVariable("QT_BLUETOOTH_ATT_CAPTURE"));
+
+    if (role == QLowEnergyController::PeripheralRole
+            && Q_UNLIKELY(!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_MAX_PERIPHERAL_CLIENTS"))) {
+        bool ok = false;
+        const int value = qEnvironmentVariableIntValue("QT_BLUETOOTH_MAX_PERIPHERAL_CLIENTS", &ok);
+        if (ok && value > 0)
+            maxPeripheralClients = value;
+    }
 
     if (role == QLowEnergyController::CentralRole) {
         if (Q_UNLIKELY(!qEnvironmentVariableIsEmpty("BLUETOOTH_GATT_TIMEOUT"))) {
@@ -230,19 +259,198 @@ void QLowEnergyControllerPrivateBluez::init()
             if (ok)
                 gattRequestTimeout = value;
         }
+        requestTimeouts.setMaximumTimeout(std::chrono::milliseconds(qMax(gattRequestTimeout, 0)));
+        // opt-in to timeouts following the measured latency, a response
+        // arriving after its timeout is mistaken for the next one
+        requestTimeouts.setAdaptive(
+                qEnvironmentVariableIntValue("QT_BLUETOOTH_GATT_ADAPTIVE_TIMEOUT") > 0);
 
         // permit disabling of timeout behavior via environment variable
         if (gattRequestTimeout > 0) {
             qCWarning(QT_BT_BLUEZ) << "Enabling GATT request timeout behavior" << gattRequestTimeout;
-            requestTimer = new QTimer(this);
-            requestTimer->setSingleShot(true);
-            requestTimer->setInterval(gattRequestTimeout);
-            connect(requestTimer, &QTimer::timeout,
-                    this, &QLowEnergyControllerPrivateBluez::handleGattRequestTimeout);
+            requestTimer = std::make_unique<QLowEnergyRequestTimeout>([this]() {
+                handleGattRequestTimeout();
+            });
+        }
+
+        // reuse the discovered GATT database across connections
+        gattCacheByDefault = qEnvironmentVariableIntValue("QT_BLUETOOTH_GATT_CACHE") > 0;
+
+        // opt-in to Enhanced ATT bearers in addition to the fixed ATT channel
+        if (Q_UNLIKELY(!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_EATT_BEARERS"))) {
+            bool ok = false;
+            const int value = qEnvironmentVariableIntValue("QT_BLUETOOTH_EATT_BEARERS", &ok);
+            if (ok)
+                requestedEattBearers = std::clamp(value, 0, 5);
+        }
+
+        // opt-in to reading the ATT sockets on dedicated real-time threads
+        attLowLatency = qEnvironmentVariableIntValue("QT_BLUETOOTH_ATT_LOW_LATENCY") > 0;
+        if (Q_UNLIKELY(!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_ATT_BUSY_POLL"))) {
+            bool ok = false;
+            const int value = qEnvironmentVariableIntValue("QT_BLUETOOTH_ATT_BUSY_POLL", &ok);
+            if (ok && value > 0)
+                attBusyPollMicroseconds = value;
+        }
+    }
+}
+
+void QLowEnergyControllerPrivateBluez::connectHciManager()
+{
+    hciManager->monitorEvent(HciManager::HciEvent::EVT_ENCRYPT_CHANGE);
+    hciManager->monitorEvent(HciManager::HciEvent::EVT_LE_META_EVENT);
+    hciManager->monitorEvent(HciManager::HciEvent::EVT_NUM_COMP_PKTS);
+    hciManager->monitorEvent(HciManager::HciEvent::EVT_DISCONN_COMPLETE);
+    hciManager->monitorAclPackets();
+    connect(hciManager.data(), &HciManager::connectionComplete, this,
+            [this](quint16 handle, const QBluetoothAddress &address) {
+        if (role == QLowEnergyController::CentralRole) {
+            // the manager is shared, the other controllers of the adapter connect as well
+            if (state != QLowEnergyController::ConnectingState
+                    || (!address.isNull() && address != remoteDevice)) {
+                return;
+            }
+            if (autoConnectPending) {
+                // a failed attempt of someone else, the background connection goes on
+                if (address.isNull())
+                    return;
+                autoConnectPending = false;
+                mainConnection.handle = handle;
+                hciManager->subscribe(handle, this);
+                qCDebug(QT_BT_BLUEZ) << "background connection complete, handle:" << handle;
+                // the socket picks up the existing link
+                establishL2cpClientSocket();
+                return;
+            }
+            mainConnection.handle = handle;
+        } else if (state == QLowEnergyController::ConnectedState) {
+            // a further GATT client is about to connect, the handle is picked up on accept()
+            pendingConnectionHandle = handle;
+        } else {
+            mainConnection.handle = handle;
         }
+        hciManager->subscribe(handle, this);
+        qCDebug(QT_BT_BLUEZ) << "received connection complete event, handle:" << handle;
+    });
+    connect(hciManager.data(), &HciManager::autoConnectFailed, this, [this]() {
+        if (!autoConnectPending)
+            return;
+        autoConnectPending = false;
+        qCDebug(QT_BT_BLUEZ) << "Background connection unavailable, connecting directly";
+        establishL2cpClientSocket();
+    });
+
+    // connections which were established before the manager was replaced
+    if (mainConnection.handle)
+        hciManager->subscribe(mainConnection.handle, this);
+    if (pendingConnectionHandle)
+        hciManager->subscribe(pendingConnectionHandle, this);
+    for (const Connection *client : std::as_const(peripheralClients)) {
+        if (client->handle)
+            hciManager->subscribe(client->handle, this);
+    }
+}
+
+void QLowEnergyControllerPrivateBluez::hciConnectionUpdated(
+        quint16 handle, const QLowEnergyConnectionParameters &parameters)
+{
+    if (handle != mainConnection.handle)
+        return;
+    requestTimeouts.setConnectionParameters(parameters.minimumInterval(), parameters.latency(),
+                                            parameters.supervisionTimeout());
+    emit q_ptr->connectionUpdated(parameters);
+}
+
+void QLowEnergyControllerPrivateBluez::hciDataLengthChanged(quint16 handle, quint16 maxTxOctets,
+                                                            quint16 maxRxOctets)
+{
+    if (handle == mainConnection.handle)
+        emit q_ptr->dataLengthChanged(maxTxOctets, maxRxOctets);
+}
+
+void QLowEnergyControllerPrivateBluez::hciPhyUpdated(quint16 handle, quint8 txPhy, quint8 rxPhy)
+{
+    if (handle == mainConnection.handle)
+        emit q_ptr->phyChanged(QLowEnergyController::Phy(txPhy), QLowEnergyController::Phy(rxPhy));
+}
+
+void QLowEnergyControllerPrivateBluez::hciSignatureResolvingKeyReceived(quint16 handle,
+                                                                        bool remoteKey,
+                                                                        const quint128 &csrk)
+{
+    const Connection *client = connectionForHandle(handle);
+    if (!client)
+        return;
+    const QBluetoothAddress address = client == &mainConnection ? remoteDevice
+                                                                : client->address;
+    if ((remoteKey && role == QLowEnergyController::CentralRole)
+            || (!remoteKey && role == QLowEnergyController::PeripheralRole)) {
+        return;
+    }
+    qCDebug(QT_BT_BLUEZ) << "received new signature resolving key"
+                         << QByteArray(reinterpret_cast<const char *>(csrk.data),
+                                       sizeof csrk).toHex();
+    signingData.insert(address.toUInt64(), SigningData(csrk));
+}
+
+bool QLowEnergyControllerPrivateBluez::event(QEvent *event)
+{
+    // HCI managers are per thread, the queued call runs once the move completed
+    if (event->type() == QEvent::ThreadChange && hciManager) {
+        QMetaObject::invokeMethod(this, &QLowEnergyControllerPrivateBluez::rebindHciManager,
+                                  Qt::QueuedConnection);
+    }
+    return QLowEnergyControllerPrivate::event(event);
+}
+
+void QLowEnergyControllerPrivateBluez::rebindHciManager()
+{
+    const QSharedPointer<HciManager> manager = HciManager::forAdapter(localAdapter);
+    if (manager == hciManager)
+        return;
+
+    hciManager->disconnect(this);
+    hciManager->unsubscribe(this);
+    if (autoConnectPending)
+        hciManager->removeAutoConnectDevice(remoteDevice);
+    hciManager = manager;
+    if (hciManager->isValid())
+        connectHciManager();
+    if (autoConnectPending) {
+        autoConnectPending = false;
+        startL2cpClientConnection();
     }
 }
 
+/*
+ * Sockets carrying ATT PDUs from the remote GATT server are read on a
+ * dedicated thread in low latency mode. The notifications and indications are
+ * handed to the low latency handler right on that thread, before the regular
+ * processing on the controller's thread takes place.
+ */
+QtBluezSocketReader::Options QLowEnergyControllerPrivateBluez::attReaderOptions() const
+{
+    QtBluezSocketReader::Options options;
+    options.dedicatedThread = attLowLatency || lowLatencyNotificationHandler
+            || attBusyPollMicroseconds > 0;
+    options.busyPollMicroseconds = attBusyPollMicroseconds;
+    if (!lowLatencyNotificationHandler)
+        return options;
+
+    options.packetHandler = [handler = lowLatencyNotificationHandler](const QByteArray &packet,
+                                                                       qint64) {
+        if (packet.size() < 3)
+            return;
+        const auto command = static_cast<QBluezConst::AttCommand>(packet.constData()[0]);
+        if (command != QBluezConst::AttCommand::ATT_OP_HANDLE_VAL_NOTIFICATION
+                && command != QBluezConst::AttCommand::ATT_OP_HANDLE_VAL_INDICATION) {
+            return;
+        }
+        handler(bt_get_le16(packet.constData() + 1), QByteArrayView(packet).sliced(3));
+    };
+    return options;
+}
+
 void QLowEnergyControllerPrivateBluez::handleGattRequestTimeout()
 {
     // antyhing open that might require cancellation or a warning?
@@ -256,79 +464,101 @@ void QLowEnergyControllerPrivateBluez::handleGattRequestTimeout()
         const Request currentRequest = openRequests.dequeue();
         requestPending = false; // reset pending flag
 
-        qCWarning(QT_BT_BLUEZ).nospace() << "****** Request type 0x" << currentRequest.command
-                                         << " to server/peripheral timed out";
-        qCWarning(QT_BT_BLUEZ) << "****** Looks like the characteristic or descriptor does NOT act in"
-                               <<  "accordance to Bluetooth 4.x spec.";
-        qCWarning(QT_BT_BLUEZ) << "****** Please check server implementation."
-                               << "Continuing under reservation.";
-
-        QBluezConst::AttCommand command = currentRequest.command;
-        const auto createRequestErrorMessage = [](QBluezConst::AttCommand opcodeWithError,
-                                                  QLowEnergyHandle handle) {
-            QByteArray errorPackage(ERROR_RESPONSE_HEADER_SIZE, Qt::Uninitialized);
-            errorPackage[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_ERROR_RESPONSE);
-            errorPackage[1] = static_cast<quint8>(
-                    opcodeWithError); // e.g. QBluezConst::AttCommand::ATT_OP_READ_REQUEST
-            putBtData(handle, errorPackage.data() + 2); //
-            errorPackage[4] = static_cast<quint8>(QBluezConst::AttError::ATT_ERROR_REQUEST_STALLED);
-
-            return errorPackage;
-        };
-
-        switch (command) {
-        case QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST: // MTU change request
-            // never received reply to MTU request
-            // it is safe to skip and go to next request
-            break;
-        case QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_REQUEST: // primary or secondary service
-                                                                    // discovery
-        case QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_REQUEST: // characteristic or included
-                                                                   // service discovery
-            // jump back into usual response handling with custom error code
-            // 2nd param "0" as required by spec
-            processReply(currentRequest, createRequestErrorMessage(command, 0));
-            break;
-        case QBluezConst::AttCommand::ATT_OP_READ_REQUEST: // read descriptor or characteristic
-                                                           // value
-        case QBluezConst::AttCommand::ATT_OP_READ_BLOB_REQUEST: // read long descriptor or
-                                                                // characteristic
-        case QBluezConst::AttCommand::ATT_OP_WRITE_REQUEST: // write descriptor or characteristic
-        {
-            uint handleData = currentRequest.reference.toUInt();
-            const QLowEnergyHandle charHandle = (handleData & 0xffff);
-            const QLowEnergyHandle descriptorHandle = ((handleData >> 16) & 0xffff);
-            processReply(currentRequest, createRequestErrorMessage(command,
-                                descriptorHandle ? descriptorHandle : charHandle));
-        } break;
-        case QBluezConst::AttCommand::ATT_OP_FIND_INFORMATION_REQUEST: // get descriptor information
-            processReply(currentRequest, createRequestErrorMessage(
-                                            command, currentRequest.reference2.toUInt()));
-            break;
-        case QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_REQUEST: // prepare to write long desc or
-                                                                    // char
-        case QBluezConst::AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST: // execute long write of desc or
-                                                                    // char
-        {
-            uint handleData = currentRequest.reference.toUInt();
-            const QLowEnergyHandle attrHandle = (handleData & 0xffff);
-            processReply(currentRequest,
-                         createRequestErrorMessage(command, attrHandle));
-        } break;
-        default:
-            // not a command used by central role implementation
-            qCWarning(QT_BT_BLUEZ) << "Missing response for ATT peripheral command: "
-                                   << Qt::hex << command;
-            break;
-        }
+        processTimedOutRequest(currentRequest);
 
         // spin openRequest queue further
         sendNextPendingRequest();
     }
 }
 
+/*!
+    \internal
+
+    Finishes the processing of \a currentRequest whose response did not arrive
+    in time.
+ */
+void QLowEnergyControllerPrivateBluez::processTimedOutRequest(const Request &currentRequest)
+{
+    requestStatistics.recordTimeout();
+    requestTimeouts.recordTimeout(requestOperation(currentRequest.command));
+    if (currentRequest.cancelled)
+        return;
+
+    qCWarning(QT_BT_BLUEZ).nospace() << "****** Request type 0x" << currentRequest.command
+                                     << " to server/peripheral timed out";
+    qCWarning(QT_BT_BLUEZ) << "****** Looks like the characteristic or descriptor does NOT act in"
+                           <<  "accordance to Bluetooth 4.x spec.";
+    qCWarning(QT_BT_BLUEZ) << "****** Please check server implementation."
+                           << "Continuing under reservation.";
+
+    QBluezConst::AttCommand command = currentRequest.command;
+    const auto createRequestErrorMessage = [](QBluezConst::AttCommand opcodeWithError,
+                                              QLowEnergyHandle handle) {
+        QByteArray errorPackage;
+        QBluezAtt::buildErrorResponse(errorPackage, opcodeWithError, handle,
+                                      QBluezConst::AttError::ATT_ERROR_REQUEST_STALLED);
+        return errorPackage;
+    };
+
+    switch (command) {
+    case QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST: // MTU change request
+        // never received reply to MTU request
+        // it is safe to skip and go to next request
+        break;
+    case QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_REQUEST: // primary or secondary service
+                                                                // discovery
+    case QBluezConst::AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_REQUEST: // filtered primary
+                                                                     // service discovery
+    case QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_REQUEST: // characteristic or included
+                                                               // service discovery
+        // jump back into usual response handling with custom error code
+        // 2nd param "0" as required by spec
+        processReply(currentRequest, createRequestErrorMessage(command, 0));
+        break;
+    case QBluezConst::AttCommand::ATT_OP_READ_REQUEST: // read descriptor or characteristic
+                                                       // value
+    case QBluezConst::AttCommand::ATT_OP_READ_BLOB_REQUEST: // read long descriptor or
+                                                            // characteristic
+    case QBluezConst::AttCommand::ATT_OP_WRITE_REQUEST: // write descriptor or characteristic
+    {
+        uint handleData = currentRequest.reference.toUInt();
+        const QLowEnergyHandle charHandle = (handleData & 0xffff);
+        const QLowEnergyHandle descriptorHandle = ((handleData >> 16) & 0xffff);
+        processReply(currentRequest, createRequestErrorMessage(command,
+                            descriptorHandle ? descriptorHandle : charHandle));
+    } break;
+    case QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_REQUEST: // batched value reads
+    case QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST:
+        // falls back to individual read requests
+        processReply(currentRequest, createRequestErrorMessage(command, 0));
+        break;
+    case QBluezConst::AttCommand::ATT_OP_FIND_INFORMATION_REQUEST: // get descriptor information
+        processReply(currentRequest, createRequestErrorMessage(
+                                        command, currentRequest.reference2.toUInt()));
+        break;
+    case QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_REQUEST: // prepare to write long desc or
+                                                                // char
+    case QBluezConst::AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST: // execute long write of desc or
+                                                                // char
+    {
+        uint handleData = currentRequest.reference.toUInt();
+        const QLowEnergyHandle attrHandle = (handleData & 0xffff);
+        processReply(currentRequest,
+                     createRequestErrorMessage(command, attrHandle));
+    } break;
+    default:
+        // not a command used by central role implementation
+        qCWarning(QT_BT_BLUEZ) << "Missing response for ATT peripheral command: "
+                               << Qt::hex << command;
+        break;
+    }
+}
+
 QLowEnergyControllerPrivateBluez::~QLowEnergyControllerPrivateBluez()
 {
+    cancelAutoConnect();
+    if (hciManager)
+        hciManager->unsubscribe(this);
     closeServerSocket();
     delete cmacCalculator;
 }
@@ -387,33 +617,58 @@ void QLowEnergyControllerPrivateBluez::startAdvertising(const QLowEnergyAdvertis
         const QLowEnergyAdvertisingData &advertisingData,
         const QLowEnergyAdvertisingData &scanResponseData)
 {
-    qCDebug(QT_BT_BLUEZ) << "Starting to advertise";
+    startAdvertisingSets({ params }, { advertisingData }, { scanResponseData });
+}
+
+void QLowEnergyControllerPrivateBluez::startAdvertisingSets(
+        const QList<QLowEnergyAdvertisingParameters> &params,
+        const QList<QLowEnergyAdvertisingData> &advertisingData,
+        const QList<QLowEnergyAdvertisingData> &scanResponseData)
+{
+    qCDebug(QT_BT_BLUEZ) << "Starting to advertise" << params.size() << "advertising set(s)";
+    if (advertiser && !advertiser->hasSets(params, advertisingData, scanResponseData)) {
+        delete advertiser;
+        advertiser = nullptr;
+    }
     if (!advertiser) {
         advertiser = new QLeAdvertiserBluez(params, advertisingData, scanResponseData, *hciManager,
                                             this);
         connect(advertiser, &QLeAdvertiser::errorOccurred, this,
                 &QLowEnergyControllerPrivateBluez::handleAdvertisingError);
+        for (auto it = periodicAdvertisingData.cbegin(); it != periodicAdvertisingData.cend(); ++it) {
+            if (it.key() < params.size())
+                advertiser->setPeriodicAdvertisingData(it.key(), it.value());
+        }
     }
     setState(QLowEnergyController::AdvertisingState);
     advertiser->startAdvertising();
-    if (params.mode() == QLowEnergyAdvertisingParameters::AdvNonConnInd
-            || params.mode() == QLowEnergyAdvertisingParameters::AdvScanInd) {
+    const bool isConnectable = std::any_of(params.cbegin(), params.cend(),
+                                           [](const QLowEnergyAdvertisingParameters &p) {
+        return p.mode() == QLowEnergyAdvertisingParameters::AdvInd;
+    });
+    if (!isConnectable) {
         qCDebug(QT_BT_BLUEZ) << "Non-connectable advertising requested, "
                                 "not listening for connections.";
         return;
     }
 
-    ServerSocket serverSocket;
-    if (!serverSocket.listen(localAdapter)) {
+    if (!listenForConnections()) {
         setError(QLowEnergyController::AdvertisingError);
         setState(QLowEnergyController::UnconnectedState);
-        return;
     }
+}
+
+bool QLowEnergyControllerPrivateBluez::listenForConnections()
+{
+    ServerSocket serverSocket;
+    if (!serverSocket.listen(localAdapter))
+        return false;
 
     const int socketFd = serverSocket.takeSocket();
     serverSocketNotifier = new QSocketNotifier(socketFd, QSocketNotifier::Read, this);
     connect(serverSocketNotifier, &QSocketNotifier::activated, this,
             &QLowEnergyControllerPrivateBluez::handleConnectionRequest);
+    return true;
 }
 
 void QLowEnergyControllerPrivateBluez::stopAdvertising()
@@ -422,6 +677,25 @@ void QLowEnergyControllerPrivateBluez::stopAdvertising()
     advertiser->stopAdvertising();
 }
 
+void QLowEnergyControllerPrivateBluez::setPeriodicAdvertisingData(
+        int advertisingSet, const QLowEnergyAdvertisingData &data)
+{
+    periodicAdvertisingData.insert(advertisingSet, data);
+    if (advertiser)
+        advertiser->setPeriodicAdvertisingData(advertisingSet, data);
+}
+
+void QLowEnergyControllerPrivateBluez::updateAdvertisingData(
+        int advertisingSet, const QLowEnergyAdvertisingData &advertisingData,
+        const QLowEnergyAdvertisingData &scanResponseData)
+{
+    if (!advertiser
+            || !advertiser->updateAdvertisingData(advertisingSet, advertisingData,
+                                                  scanResponseData)) {
+        qCWarning(QT_BT_BLUEZ) << "Invalid advertising set" << advertisingSet;
+    }
+}
+
 void QLowEnergyControllerPrivateBluez::requestConnectionUpdate(const QLowEnergyConnectionParameters &params)
 {
     // The spec says that the connection update command can be used by both slave and master
@@ -429,9 +703,117 @@ void QLowEnergyControllerPrivateBluez::requestConnectionUpdate(const QLowEnergyC
     // connection parameter update request, which we need to wrap in an ACL command, as BlueZ
     // does not allow user-space sockets for the signaling channel.
     if (role == QLowEnergyController::CentralRole)
-        hciManager->sendConnectionUpdateCommand(connectionHandle, params);
+        hciManager->sendConnectionUpdateCommand(connection->handle, params);
     else
-        hciManager->sendConnectionParameterUpdateRequest(connectionHandle, params);
+        hciManager->sendConnectionParameterUpdateRequest(connection->handle, params);
+}
+
+static quint8 phyMask(QLowEnergyController::Phy phy)
+{
+    // Spec v5.3, Vol 4, part E, 7.8.49
+    return quint8(1u << (int(phy) - 1));
+}
+
+void QLowEnergyControllerPrivateBluez::requestPhy(QLowEnergyController::Phy txPhy,
+                                                  QLowEnergyController::Phy rxPhy)
+{
+    if (!hciManager->sendSetPhyCommand(connection->handle, phyMask(txPhy), phyMask(rxPhy)))
+        qCWarning(QT_BT_BLUEZ) << "Cannot send LE Set PHY command";
+}
+
+void QLowEnergyControllerPrivateBluez::requestDataLength(int txOctets)
+{
+    if (!hciManager->sendSetDataLengthCommand(connection->handle, quint16(txOctets)))
+        qCWarning(QT_BT_BLUEZ) << "Cannot send LE Set Data Length command";
+}
+
+QLowEnergyLinkStatistics QLowEnergyControllerPrivateBluez::linkStatistics() const
+{
+    QLowEnergyLinkStatistics statistics;
+    HciManager::LinkCounters counters;
+    if (!hciManager || !hciManager->linkCounters(connection->handle, &counters))
+        return statistics;
+
+    statistics.d->valid = true;
+    statistics.d->bytesSent = counters.bytesSent;
+    statistics.d->bytesReceived = counters.bytesReceived;
+    statistics.d->packetsSent = counters.packetsSent;
+    statistics.d->packetsReceived = counters.packetsReceived;
+    statistics.d->completedPackets = counters.completedPackets;
+    statistics.d->connectionInterval = counters.connectionInterval * 1.25;
+    return statistics;
+}
+
+void QLowEnergyControllerPrivateBluez::addMemoryUsage(QBluetoothMemoryUsage *usage) const
+{
+    using namespace QBluetoothMemory;
+
+    QLowEnergyControllerPrivate::addMemoryUsage(usage);
+
+    const auto listBytes = [](const auto &list) { return bytes(list); };
+    const auto packetBytes = [](const QByteArray &packet) { return bytes(packet); };
+    const auto payloadBytes = [](const Request &request) { return bytes(request.payload); };
+    const auto preparedWriteBytes = [](const PreparedWrite &write) { return bytes(write.value); };
+
+    // the local GATT database and its indexes
+    QBluetoothMemoryUsagePrivate::add(usage, QStringLiteral("localAttributes"),
+                                      bytes(localAttributes, [](const Attribute &attribute) {
+                                          return bytes(attribute.value);
+                                      }));
+    qsizetype indexBytes = bytes(attributeHandlesByType, listBytes)
+            + bytes(discoveryResponseCache);
+    for (auto it = discoveryResponseCache.cbegin(); it != discoveryResponseCache.cend(); ++it)
+        indexBytes += bytes(it.key()) + bytes(it.value());
+    QBluetoothMemoryUsagePrivate::add(usage, QStringLiteral("attributeIndex"), indexBytes);
+
+    // state kept per client of the local peripheral
+    QBluetoothMemoryUsagePrivate::add(usage, QStringLiteral("clientConfigData"),
+                                      bytes(clientConfigData, listBytes));
+    QBluetoothMemoryUsagePrivate::add(usage, QStringLiteral("signingData"), bytes(signingData));
+    QBluetoothMemoryUsagePrivate::add(
+            usage, QStringLiteral("peripheralClients"),
+            bytes(peripheralClients, [&](const Connection *client) {
+                return qsizetype(sizeof(Connection)) + bytes(client->name)
+                        + bytes(client->openPrepareWriteRequests, preparedWriteBytes)
+                        + bytes(client->scheduledIndications)
+                        + bytes(client->configValues, packetBytes)
+                        + bytes(client->outboundQueue, packetBytes);
+            }));
+
+    // requests and transactions in progress, on all bearers
+    qsizetype requestBytes = bytes(openRequests, payloadBytes) + bytes(eattBearers);
+    for (const EattBearer *bearer : std::as_const(eattBearers))
+        requestBytes += qsizetype(sizeof(EattBearer)) + bytes(bearer->openRequests, payloadBytes);
+    requestBytes += bytes(reliableWrites, [](const ReliableWrite &write) {
+        return bytes(write.charHandles) + bytes(write.values);
+    });
+    requestBytes += bytes(longReads, [&](const LongRead &read) {
+        return bytes(read.value) + bytes(read.fragments, packetBytes);
+    });
+    requestBytes += bytes(mainConnection.openPrepareWriteRequests, preparedWriteBytes)
+            + bytes(mainConnection.scheduledIndications);
+    QBluetoothMemoryUsagePrivate::add(usage, QStringLiteral("requests"), requestBytes);
+
+    // the GATT cache of the remote device
+    const auto cachedServiceBytes = [](const CachedServiceDetails &details) {
+        return bytes(details.includedServices)
+                + bytes(details.characteristicList,
+                        [](const QLowEnergyServicePrivate::CharData &data) {
+                            return QLowEnergyServicePrivate::memoryUsage(data);
+                        });
+    };
+    QBluetoothMemoryUsagePrivate::add(usage, QStringLiteral("gattCache"),
+                                      bytes(cachedServiceDetails, cachedServiceBytes)
+                                      + bytes(databaseHash));
+
+    // buffers of the fixed ATT channel
+    QBluetoothMemoryUsagePrivate::add(
+            usage, QStringLiteral("attBuffers"),
+            bytes(receiveBuffer) + bytes(notificationBuffer)
+                    + bytes(mainConnection.outboundQueue, packetBytes)
+                    + bytes(attReplayRecords, [](const BtSnoopAttRecord &record) {
+                          return bytes(record.pdu);
+                      }));
 }
 
 void QLowEnergyControllerPrivateBluez::connectToDevice()
@@ -443,13 +825,18 @@ void QLowEnergyControllerPrivateBluez::connectToDevice()
     }
 
     setState(QLowEnergyController::ConnectingState);
-    if (l2cpSocket) {
-        delete l2cpSocket;
-        l2cpSocket = nullptr;
+    if (connection->socket) {
+        delete connection->socket;
+        connection->socket = nullptr;
     }
 
     createServicesForCentralIfRequired();
 
+    if (isReplaying()) {
+        startReplay();
+        return;
+    }
+
     // check for active running connections
     // BlueZ 5.37+ (maybe even earlier versions) can have pending BTLE connections
     // Only one active L2CP socket to CID 0x4 possible at a time
@@ -472,7 +859,7 @@ void QLowEnergyControllerPrivateBluez::connectToDevice()
         }
         device1Manager->scheduleJob(RemoteDeviceManager::JobType::JobDisconnectDevice, connectedAddresses);
     } else {
-        establishL2cpClientSocket();
+        startL2cpClientConnection();
     }
 }
 
@@ -495,8 +882,45 @@ void QLowEnergyControllerPrivateBluez::activeConnectionTerminationDone()
         l2cpDisconnected();
         return;
     } else {
-        establishL2cpClientSocket();
+        startL2cpClientConnection();
+    }
+}
+
+/*!
+ * Connects right away, or once the remote device advertises if auto-connect
+ * is enabled. The adapter waits for the advertisement of the devices in its
+ * accept list, a direct connection attempt would time out meanwhile.
+ */
+void QLowEnergyControllerPrivateBluez::startL2cpClientConnection()
+{
+    if (autoConnect && hciManager->isValid()
+            && hciManager->addAutoConnectDevice(remoteDevice, isRemoteAddressRandom())) {
+        qCDebug(QT_BT_BLUEZ) << "Waiting for an advertisement of" << remoteDevice;
+        autoConnectPending = true;
+        return;
     }
+    if (autoConnect)
+        qCDebug(QT_BT_BLUEZ) << "Cannot connect in the background, connecting directly";
+    establishL2cpClientSocket();
+}
+
+void QLowEnergyControllerPrivateBluez::cancelAutoConnect()
+{
+    if (!autoConnectPending)
+        return;
+    autoConnectPending = false;
+    if (hciManager)
+        hciManager->removeAutoConnectDevice(remoteDevice);
+}
+
+bool QLowEnergyControllerPrivateBluez::isRemoteAddressRandom() const
+{
+    // if monitoring is possible and it's private then we force it to the relevant option
+    if (BluetoothManagement::instance()->isMonitoringEnabled()
+            && BluetoothManagement::instance()->isAddressRandom(remoteDevice)) {
+        return true;
+    }
+    return addressType != QLowEnergyController::PublicAddress;
 }
 
 /*!
@@ -506,35 +930,35 @@ void QLowEnergyControllerPrivateBluez::establishL2cpClientSocket()
 {
     //we are already in Connecting state
 
-    l2cpSocket = new QBluetoothSocket(QBluetoothServiceInfo::L2capProtocol, this);
-    connect(l2cpSocket, SIGNAL(connected()), this, SLOT(l2cpConnected()));
-    connect(l2cpSocket, SIGNAL(disconnected()), this, SLOT(l2cpDisconnected()));
-    connect(l2cpSocket, SIGNAL(errorOccurred(QBluetoothSocket::SocketError)), this,
+    // the raw socket is required to talk ATT on the fixed channel
+    QBluetoothSocketPrivateBluez *rawSocketPrivate = new QBluetoothSocketPrivateBluez();
+    rawSocketPrivate->setReaderOptions(attReaderOptions());
+    connection->socket = new QBluetoothSocket(rawSocketPrivate,
+                                              QBluetoothServiceInfo::L2capProtocol, this);
+    connect(connection->socket, SIGNAL(connected()), this, SLOT(l2cpConnected()));
+    connect(connection->socket, SIGNAL(disconnected()), this, SLOT(l2cpDisconnected()));
+    connect(connection->socket, SIGNAL(errorOccurred(QBluetoothSocket::SocketError)), this,
             SLOT(l2cpErrorChanged(QBluetoothSocket::SocketError)));
-    connect(l2cpSocket, SIGNAL(readyRead()), this, SLOT(l2cpReadyRead()));
+    connect(connection->socket, SIGNAL(readyRead()), this, SLOT(l2cpReadyRead()));
 
-    quint32 addressTypeToUse = (addressType == QLowEnergyController::PublicAddress)
-                                    ? BDADDR_LE_PUBLIC : BDADDR_LE_RANDOM;
-    if (BluetoothManagement::instance()->isMonitoringEnabled()) {
-        // if monitoring is possible and it's private then we force it to the relevant option
-        if (BluetoothManagement::instance()->isAddressRandom(remoteDevice)) {
-            addressTypeToUse = BDADDR_LE_RANDOM;
-        }
-    }
+    const quint32 addressTypeToUse = isRemoteAddressRandom() ? BDADDR_LE_RANDOM
+                                                             : BDADDR_LE_PUBLIC;
 
     qCDebug(QT_BT_BLUEZ) << "addresstypeToUse:"
                          << (addressTypeToUse == BDADDR_LE_RANDOM
                                  ? QStringLiteral("Random") : QStringLiteral("Public"));
 
-    l2cpSocket->d_ptr->lowEnergySocketType = addressTypeToUse;
+    connection->socket->d_ptr->lowEnergySocketType = addressTypeToUse;
 
-    int sockfd = l2cpSocket->socketDescriptor();
+    int sockfd = connection->socket->socketDescriptor();
     if (sockfd < 0) {
         qCWarning(QT_BT_BLUEZ) << "l2cp socket not initialised";
         setError(QLowEnergyController::ConnectionError);
         setState(QLowEnergyController::UnconnectedState);
         return;
     }
+    connection->socket->setSocketOption(
+            QBluetoothSocket::SocketOption::ReceiveTimestampSocketOption, true);
 
     struct sockaddr_l2 addr;
     memset(&addr, 0, sizeof(addr));
@@ -553,8 +977,8 @@ void QLowEnergyControllerPrivateBluez::establishL2cpClientSocket()
 
     // connect
     // Unbuffered mode required to separate each GATT packet
-    l2cpSocket->connectToService(remoteDevice, ATTRIBUTE_CHANNEL_ID,
-                                 QIODevice::ReadWrite | QIODevice::Unbuffered);
+    connection->socket->connectToService(remoteDevice, ATTRIBUTE_CHANNEL_ID,
+                                         QIODevice::ReadWrite | QIODevice::Unbuffered);
     loadSigningDataIfNecessary(LocalSigningKey);
 }
 
@@ -628,44 +1052,144 @@ void QLowEnergyControllerPrivateBluez::l2cpConnected()
 {
     Q_Q(QLowEnergyController);
 
-    securityLevelValue = securityLevel();
+    connection->securityLevelValue = securityLevel(connection->socket);
+
+    // the estimates of the previous connection do not apply to the new link
+    requestTimeouts.reset();
+    HciManager::LinkCounters counters;
+    if (hciManager && hciManager->linkCounters(connection->handle, &counters)) {
+        requestTimeouts.setConnectionParameters(counters.connectionInterval * 1.25,
+                                                counters.peripheralLatency,
+                                                counters.supervisionTimeout * 10);
+    }
+
     exchangeMTU();
+    establishEattBearers();
 
     setState(QLowEnergyController::ConnectedState);
     emit q->connected();
 }
 
-void QLowEnergyControllerPrivateBluez::disconnectFromDevice()
+/*!
+    \internal
+
+    Connects to the peer recorded in the capture given by QT_BLUETOOTH_ATT_REPLAY.
+    The received PDUs of the capture are handed to the controller in their
+    recorded order. Where the capture shows a PDU sent by the local side the
+    replay waits until the controller sent the corresponding PDU. Timing is
+    not replayed, the next PDU is delivered as soon as the event loop is idle.
+ */
+void QLowEnergyControllerPrivateBluez::startReplay()
 {
-    setState(QLowEnergyController::ClosingState);
-    if (l2cpSocket)
-        l2cpSocket->close();
-    resetController();
+    Q_Q(QLowEnergyController);
 
-    // this may happen when RemoteDeviceManager::JobType::JobDisconnectDevice
-    // is pending.
-    if (!l2cpSocket) {
-        qWarning(QT_BT_BLUEZ) << "Unexpected closure of device. Cleaning up internal states.";
-        l2cpDisconnected();
+    if (!BtSnoopReader::readAttRecords(attReplayFileName, &attReplayRecords)) {
+        setError(QLowEnergyController::ConnectionError);
+        setState(QLowEnergyController::UnconnectedState);
+        return;
     }
+    qCDebug(QT_BT_BLUEZ) << "Replaying" << attReplayRecords.size() << "ATT PDUs";
+    attReplayPosition = 0;
+
+    // there is no socket to query, behave like an unencrypted link
+    connection->securityLevelValue = -1;
+    exchangeMTU();
+
+    setState(QLowEnergyController::ConnectedState);
+    emit q->connected();
+    scheduleReplay();
 }
 
-void QLowEnergyControllerPrivateBluez::l2cpDisconnected()
+void QLowEnergyControllerPrivateBluez::scheduleReplay()
 {
-    Q_Q(QLowEnergyController);
-
-    if (role == QLowEnergyController::PeripheralRole) {
-        storeClientConfigurations();
-        remoteDevice.clear();
-        remoteName.clear();
+    if (attReplayScheduled || attReplayPosition >= attReplayRecords.size()
+            || !attReplayRecords.at(attReplayPosition).received) {
+        return;
     }
-    invalidateServices();
-    resetController();
-    setState(QLowEnergyController::UnconnectedState);
-    emit q->disconnected();
+
+    attReplayScheduled = true;
+    QTimer::singleShot(0, this, &QLowEnergyControllerPrivateBluez::replayNextPacket);
 }
 
-void QLowEnergyControllerPrivateBluez::l2cpErrorChanged(QBluetoothSocket::SocketError e)
+void QLowEnergyControllerPrivateBluez::replayNextPacket()
+{
+    attReplayScheduled = false;
+    if (state == QLowEnergyController::UnconnectedState
+            || state == QLowEnergyController::ClosingState
+            || attReplayPosition >= attReplayRecords.size()
+            || !attReplayRecords.at(attReplayPosition).received) {
+        return;
+    }
+
+    const QByteArray packet = attReplayRecords.at(attReplayPosition++).pdu;
+    qCDebug(QT_BT_BLUEZ) << "Replayed size:" << packet.size() << "data:" << packet.toHex();
+    processIncomingPacket(packet);
+    scheduleReplay();
+}
+
+/*!
+    \internal
+
+    Matches \a packet sent by the controller with the next PDU the capture
+    shows as sent. Received PDUs recorded before it are still delivered, the
+    controller may send earlier than the recorded host did.
+ */
+void QLowEnergyControllerPrivateBluez::replaySentPacket(const QByteArray &packet)
+{
+    const auto sent = std::find_if(attReplayRecords.cbegin() + attReplayPosition,
+                                   attReplayRecords.cend(),
+                                   [](const BtSnoopAttRecord &record) {
+                                       return !record.received;
+                                   });
+    if (sent == attReplayRecords.cend()) {
+        qCWarning(QT_BT_BLUEZ) << "ATT replay: packet sent beyond the end of the capture:"
+                               << packet.toHex();
+        return;
+    }
+
+    if (sent->pdu.at(0) != packet.at(0)) {
+        qCWarning(QT_BT_BLUEZ) << "ATT replay diverges from the capture, sent:"
+                               << packet.toHex() << "recorded:" << sent->pdu.toHex();
+    }
+    attReplayRecords.erase(sent);
+    scheduleReplay();
+}
+
+void QLowEnergyControllerPrivateBluez::disconnectFromDevice()
+{
+    setState(QLowEnergyController::ClosingState);
+    if (role == QLowEnergyController::PeripheralRole)
+        closeFurtherPeripheralClients();
+    if (connection->socket)
+        connection->socket->close();
+    const bool awaitedAdvertisement = autoConnectPending;
+    resetController();
+
+    // this may happen when RemoteDeviceManager::JobType::JobDisconnectDevice
+    // is pending.
+    if (!connection->socket) {
+        if (!isReplaying() && !awaitedAdvertisement)
+            qWarning(QT_BT_BLUEZ) << "Unexpected closure of device. Cleaning up internal states.";
+        l2cpDisconnected();
+    }
+}
+
+void QLowEnergyControllerPrivateBluez::l2cpDisconnected()
+{
+    Q_Q(QLowEnergyController);
+
+    if (role == QLowEnergyController::PeripheralRole) {
+        storeClientConfigurations();
+        remoteDevice.clear();
+        remoteName.clear();
+    }
+    invalidateServices();
+    resetController();
+    setState(QLowEnergyController::UnconnectedState);
+    emit q->disconnected();
+}
+
+void QLowEnergyControllerPrivateBluez::l2cpErrorChanged(QBluetoothSocket::SocketError e)
 {
     switch (e) {
     case QBluetoothSocket::SocketError::HostNotFoundError:
@@ -687,7 +1211,8 @@ void QLowEnergyControllerPrivateBluez::l2cpErrorChanged(QBluetoothSocket::Socket
     default:
         // these errors shouldn't happen -> as it means
         // the code in this file has bugs
-        qCDebug(QT_BT_BLUEZ) << "Unknown l2cp socket error: " << e << l2cpSocket->errorString();
+        qCDebug(QT_BT_BLUEZ) << "Unknown l2cp socket error: " << e
+                             << connection->socket->errorString();
         setError(QLowEnergyController::UnknownError);
         break;
     }
@@ -700,18 +1225,52 @@ void QLowEnergyControllerPrivateBluez::l2cpErrorChanged(QBluetoothSocket::Socket
 
 void QLowEnergyControllerPrivateBluez::resetController()
 {
+    cancelAutoConnect();
+    while (!eattBearers.isEmpty()) {
+        EattBearer *bearer = eattBearers.last();
+        bearer->openRequests.clear();
+        removeEattBearer(bearer);
+    }
+    activeBearer = nullptr;
+    longReads.clear();
+
     openRequests.clear();
-    openPrepareWriteRequests.clear();
-    scheduledIndications.clear();
-    indicationInFlight = false;
+    reliableWrites.clear();
     requestPending = false;
     encryptionChangePending = false;
-    receivedMtuExchangeRequest = false;
-    mtuSize = ATT_DEFAULT_LE_MTU;
-    securityLevelValue = -1;
-    connectionHandle = 0;
+    readMultipleSupported = true;
+    readMultipleVariableSupported = true;
+    serviceRangeDiscovery = false;
+    pendingRangeStart = 0;
+    pendingRangeEnd = 0;
+    cachedServiceDetails.clear();
+    databaseHash.clear();
+    if (hciManager)
+        hciManager->unsubscribe(this);
+    attReplayRecords.clear();
+    attReplayPosition = 0;
+
+    // the socket is closed by its own disconnect handling
+    connection = &mainConnection;
+    if (mainConnection.writeNotifier) {
+        mainConnection.writeNotifier->setEnabled(false);
+        mainConnection.writeNotifier->deleteLater();
+    }
+    QBluetoothSocket *socket = mainConnection.socket;
+    mainConnection = Connection();
+    mainConnection.socket = socket;
+    configurationOwner = nullptr;
 
     if (role == QLowEnergyController::PeripheralRole) {
+        for (Connection *client : std::as_const(peripheralClients)) {
+            discardConnection(*client);
+            delete client;
+        }
+        peripheralClients.clear();
+        pendingConnectionHandle = 0;
+        // only open while further GATT clients may connect
+        closeServerSocket();
+
         // public API behavior requires stop of advertisement
         if (advertiser) {
             advertiser->stopAdvertising();
@@ -719,26 +1278,84 @@ void QLowEnergyControllerPrivateBluez::resetController()
             advertiser = nullptr;
         }
         localAttributes.clear();
+        attributeHandlesByType.clear();
+        discoveryResponseCache.clear();
     }
 }
 
 void QLowEnergyControllerPrivateBluez::restartRequestTimer()
 {
-    if (!requestTimer)
+    if (!requestTimer || openRequests.isEmpty())
         return;
 
-    if (gattRequestTimeout > 0)
-        requestTimer->start(gattRequestTimeout);
+    // raising the security level may involve the user, allow the full timeout
+    const std::chrono::milliseconds timeout = encryptionChangePending
+            ? requestTimeouts.maximumTimeout()
+            : requestTimeouts.timeout(requestOperation(openRequests.head().command));
+    if (timeout > std::chrono::milliseconds(0))
+        requestTimer->start(timeout);
+}
+
+/*!
+    \internal
+
+    Reads the pending packet of \a socket into the receive buffer of the
+    controller and returns it. The buffer is handed out by value while the
+    packet is dispatched. A slot which spins a nested event loop may read the
+    next packet then, which gets a fresh buffer instead of overwriting this
+    one. recyclePacket() returns the buffer for the next packet. It only
+    reallocates if a previous packet is still referenced or a larger packet
+    arrives.
+ */
+QByteArray QLowEnergyControllerPrivateBluez::readPacket(QBluetoothSocket *socket)
+{
+    QByteArray packet = std::exchange(receiveBuffer, QByteArray());
+    const qint64 available = socket->bytesAvailable();
+    if (available <= 0) {
+        packet.resize(0);
+        return packet;
+    }
+
+    packet.resize(available);
+    const qint64 result = socket->read(packet.data(), available);
+    packet.resize(qMax<qint64>(result, 0));
+    return packet;
+}
+
+/*!
+    \internal
+
+    Keeps the buffer of \a packet for the next readPacket() call, unless a
+    nested read already provided a larger one.
+ */
+void QLowEnergyControllerPrivateBluez::recyclePacket(QByteArray &&packet)
+{
+    if (packet.capacity() > receiveBuffer.capacity())
+        receiveBuffer = std::move(packet);
 }
 
 void QLowEnergyControllerPrivateBluez::l2cpReadyRead()
 {
-    const QByteArray incomingPacket = l2cpSocket->readAll();
+    QByteArray incomingPacket = readPacket(connection->socket);
+    const auto recycle = qScopeGuard([&]() { recyclePacket(std::move(incomingPacket)); });
     qCDebug(QT_BT_BLUEZ) << "Received size:" << incomingPacket.size() << "data:"
                          << incomingPacket.toHex();
     if (incomingPacket.isEmpty())
         return;
+    receiveTimestamp = connection->socket->lastReceiveTimestamp();
+
+    attCapture.writeAttPdu(connection->handle, true, incomingPacket);
+    processIncomingPacket(incomingPacket);
+}
 
+/*!
+    \internal
+
+    Handles \a incomingPacket received on the fixed ATT channel, either from
+    the socket or from a replayed capture.
+ */
+void QLowEnergyControllerPrivateBluez::processIncomingPacket(const QByteArray &incomingPacket)
+{
     const QBluezConst::AttCommand command =
             static_cast<QBluezConst::AttCommand>(incomingPacket.constData()[0]);
     switch (command) {
@@ -778,6 +1395,9 @@ void QLowEnergyControllerPrivateBluez::l2cpReadyRead()
     case QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_REQUEST:
         handleReadMultipleRequest(incomingPacket);
         return;
+    case QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST:
+        handleReadMultipleVariableRequest(incomingPacket);
+        return;
     case QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_REQUEST:
         handleReadByGroupTypeRequest(incomingPacket);
         return;
@@ -793,8 +1413,8 @@ void QLowEnergyControllerPrivateBluez::l2cpReadyRead()
         handleExecuteWriteRequest(incomingPacket);
         return;
     case QBluezConst::AttCommand::ATT_OP_HANDLE_VAL_CONFIRMATION:
-        if (indicationInFlight) {
-            indicationInFlight = false;
+        if (connection->indicationInFlight) {
+            connection->indicationInFlight = false;
             sendNextIndication();
         } else {
             qCWarning(QT_BT_BLUEZ) << "received unexpected handle value confirmation";
@@ -814,7 +1434,14 @@ void QLowEnergyControllerPrivateBluez::l2cpReadyRead()
     }
 
     const Request request = openRequests.dequeue();
-    processReply(request, incomingPacket);
+    Q_TRACE(QLowEnergyController_responseReceived, quint8(incomingPacket.at(0)),
+            attHandleOfPdu(request.payload), int(incomingPacket.size()));
+    requestStatistics.recordRequest(requestOperation(request.command), request.queuedAt,
+                                    request.sentAt);
+    requestTimeouts.recordResponse(requestOperation(request.command),
+                                   QLowEnergyRequestRecorder::Clock::now() - request.sentAt);
+    if (!request.cancelled)
+        processReply(request, incomingPacket);
 
     sendNextPendingRequest();
 }
@@ -828,16 +1455,19 @@ void QLowEnergyControllerPrivateBluez::l2cpReadyRead()
  * callback is called. The first pending request in the queue is the request
  * that triggered the encryption request.
  */
-void QLowEnergyControllerPrivateBluez::encryptionChangedEvent(
-        const QBluetoothAddress &address, bool wasSuccess)
+void QLowEnergyControllerPrivateBluez::hciEncryptionChanged(quint16 handle, bool wasSuccess)
 {
-    if (!encryptionChangePending) // somebody else caused change event
+    if (handle != mainConnection.handle) {
+        // a further central changed the security of its link
+        if (Connection *client = connectionForHandle(handle))
+            client->securityLevelValue = securityLevel(client->socket);
         return;
+    }
 
-    if (remoteDevice != address)
-        return;
+    mainConnection.securityLevelValue = securityLevel(mainConnection.socket);
 
-    securityLevelValue = securityLevel();
+    if (!encryptionChangePending) // somebody else caused change event
+        return;
 
     // On success continue to process ATT command queue
     if (!wasSuccess) {
@@ -861,6 +1491,11 @@ void QLowEnergyControllerPrivateBluez::encryptionChangedEvent(
                 else
                     service->setError(QLowEnergyService::DescriptorWriteError);
             }
+        } else if (failedRequest.reliableWriteId) {
+            if (failedRequest.command == QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_REQUEST)
+                cancelReliableWrite(failedRequest.reliableWriteId);
+            else
+                finishReliableWrite(failedRequest, true);
         } else if (failedRequest.command == QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_REQUEST) {
             uint handleData = failedRequest.reference.toUInt();
             const QLowEnergyHandle attrHandle = (handleData & 0xffff);
@@ -877,207 +1512,893 @@ void QLowEnergyControllerPrivateBluez::encryptionChangedEvent(
     sendNextPendingRequest();
 }
 
+/*!
+    \internal
+
+    Sends \a packet or appends it to the outbound queue if the socket cannot
+    accept it right now. Queued packets are sent in order once the socket
+    becomes writable again. Packets are never dropped due to a full kernel
+    send buffer.
+ */
 void QLowEnergyControllerPrivateBluez::sendPacket(const QByteArray &packet)
 {
-    qint64 result = l2cpSocket->write(packet.constData(),
-                                      packet.size());
-    // We ignore result == 0 which is likely to be caused by EAGAIN.
-    // This packet is effectively discarded but the controller can still recover
+    // preserve the order in relation to earlier packets which are still queued
+    if (!connection->outboundQueue.isEmpty() || !writePacket(packet))
+        enqueueOutboundPacket(packet);
+}
+
+/*!
+    \internal
+
+    Writes \a packet to the socket. Returns \c false if the kernel send buffer
+    is full. In this case the write notifier is armed and the caller must retry
+    later. Write errors are reported via the controller error.
+ */
+bool QLowEnergyControllerPrivateBluez::writePacket(const QByteArray &packet)
+{
+    if (isReplaying()) {
+        replaySentPacket(packet);
+        return true;
+    }
+
+    const qint64 result = connection->socket->write(packet.constData(), packet.size());
+    if (result == 0) {
+        // EAGAIN -> kernel send buffer is full, wait until we can write again
+        if (!connection->writeNotifier) {
+            connection->writeNotifier = new QSocketNotifier(connection->socket->socketDescriptor(),
+                                                    QSocketNotifier::Write, this);
+            connect(connection->writeNotifier, &QSocketNotifier::activated, this,
+                    [this, socket = connection->socket]() {
+                        servePeripheralClient(socket,
+                                              &QLowEnergyControllerPrivateBluez::l2cpReadyWrite);
+                    });
+        }
+        connection->writeNotifier->setEnabled(true);
+        return false;
+    }
 
     if (result == -1) {
         qCDebug(QT_BT_BLUEZ) << "Cannot write L2CP packet:" << Qt::hex
                              << packet.toHex()
-                             << l2cpSocket->errorString();
+                             << connection->socket->errorString();
         setError(QLowEnergyController::NetworkError);
     } else if (result < packet.size()) {
+        // cannot happen for SOCK_SEQPACKET as the kernel sends packets as a whole
         qCWarning(QT_BT_BLUEZ) << "L2CP write request incomplete:"
                                << result << "of" << packet.size();
     }
-
+    if (result > 0)
+        attCapture.writeAttPdu(connection->handle, false, packet);
+    return true;
 }
 
-void QLowEnergyControllerPrivateBluez::sendNextPendingRequest()
+void QLowEnergyControllerPrivateBluez::enqueueOutboundPacket(const QByteArray &packet)
 {
-    if (openRequests.isEmpty() || requestPending || encryptionChangePending)
-        return;
+    Q_Q(QLowEnergyController);
 
-    const Request &request = openRequests.head();
-//    qCDebug(QT_BT_BLUEZ) << "Sending request, type:" << Qt::hex << request.command
-//             << request.payload.toHex();
+    // the write notifier was armed by the write attempt which stalled the queue
+    connection->outboundQueue.enqueue(packet);
 
-    requestPending = true;
-    restartRequestTimer();
-    sendPacket(request.payload);
+    if (!connection->sendQueueCongested
+            && connection->outboundQueue.size() >= sendQueueHighWaterMark) {
+        qCDebug(QT_BT_BLUEZ) << "Outbound ATT queue congested:"
+                             << connection->outboundQueue.size();
+        connection->sendQueueCongested = true;
+        emit q->congestionChanged(true);
+    }
 }
 
-QLowEnergyHandle parseReadByTypeCharDiscovery(
-        QLowEnergyServicePrivate::CharData *charData,
-        const char *data, quint16 elementLength)
+/*!
+    \internal
+
+    Sends the queued outbound packets. Returns \c false if the socket cannot
+    accept further packets at the moment.
+ */
+bool QLowEnergyControllerPrivateBluez::flushOutboundQueue()
 {
-    Q_ASSERT(charData);
-    Q_ASSERT(data);
+    Q_Q(QLowEnergyController);
 
-    QLowEnergyHandle attributeHandle = bt_get_le16(&data[0]);
-    charData->properties =
-            (QLowEnergyCharacteristic::PropertyTypes)(data[2] & 0xff);
-    charData->valueHandle = bt_get_le16(&data[3]);
+    while (!connection->outboundQueue.isEmpty()) {
+        if (!writePacket(connection->outboundQueue.head()))
+            return false;
+        connection->outboundQueue.dequeue();
+
+        if (connection->sendQueueCongested
+                && connection->outboundQueue.size() <= sendQueueHighWaterMark / 2) {
+            qCDebug(QT_BT_BLUEZ) << "Outbound ATT queue drained:"
+                                 << connection->outboundQueue.size();
+            connection->sendQueueCongested = false;
+            emit q->congestionChanged(false);
+        }
+    }
+    return true;
+}
 
-    if (elementLength == 7) // 16 bit uuid
-        charData->uuid = QBluetoothUuid(bt_get_le16(&data[5]));
-    else
-        charData->uuid = convert_uuid128((quint128 *)&data[5]);
+/*
+    Returns the attribute handle, or the first handle of the handle range, which
+    follows the opcode of \a pdu. Returns \c 0 for PDUs without a handle.
+ */
+static int attHandleOfPdu(const QByteArray &pdu)
+{
+    if (pdu.size() < 3)
+        return 0;
 
-    qCDebug(QT_BT_BLUEZ) << "Found handle:" << Qt::hex << attributeHandle
-             << "properties:" << charData->properties
-             << "value handle:" << charData->valueHandle
-             << "uuid:" << charData->uuid.toString();
+    switch (static_cast<QBluezConst::AttCommand>(pdu.at(0))) {
+    case QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST:
+    case QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_RESPONSE:
+    case QBluezConst::AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST:
+        return 0;
+    default:
+        return bt_get_le16(pdu.constData() + 1);
+    }
+}
 
-    return attributeHandle;
+static inline void traceRequestQueued(const QByteArray &pdu)
+{
+    Q_TRACE(QLowEnergyController_requestQueued, quint8(pdu.at(0)), attHandleOfPdu(pdu),
+            int(pdu.size()));
 }
 
-QLowEnergyHandle parseReadByTypeIncludeDiscovery(
-        QList<QBluetoothUuid> *foundServices,
-        const char *data, quint16 elementLength)
+static bool isWriteCommand(QBluezConst::AttCommand command)
 {
-    Q_ASSERT(foundServices);
-    Q_ASSERT(data);
+    return command == QBluezConst::AttCommand::ATT_OP_WRITE_COMMAND
+            || command == QBluezConst::AttCommand::ATT_OP_SIGNED_WRITE_COMMAND;
+}
 
-    QLowEnergyHandle attributeHandle = bt_get_le16(&data[0]);
+/*!
+    \internal
 
-    // the next 2 elements are not required as we have discovered
-    // all (primary/secondary) services already. Now we are only
-    // interested in their relationship to each other
-    // data[2] -> included service start handle
-    // data[4] -> included service end handle
+    Sends all write commands which are queued directly behind the currently
+    pending request (or at the front of the queue if no request is pending).
+    Write commands do not expect a response. Therefore they can be streamed
+    back-to-back without waiting for the request slot.
 
-    if (elementLength == 8) //16 bit uuid
-        foundServices->append(QBluetoothUuid(bt_get_le16(&data[6])));
-    else
-        foundServices->append(convert_uuid128((quint128 *) &data[6]));
+    Returns \c false if the socket cannot accept further packets at the moment.
+    In this case the remaining packets stay queued and the queue is resumed once
+    the socket becomes writable again.
+ */
+bool QLowEnergyControllerPrivateBluez::flushWriteCommands()
+{
+    // packets which stalled earlier go first
+    if (!flushOutboundQueue())
+        return false;
 
-    qCDebug(QT_BT_BLUEZ) << "Found included service: " << Qt::hex
-                         << attributeHandle << "uuid:" << *foundServices;
+    const qsizetype firstIndex = requestPending ? 1 : 0;
+    while (firstIndex < openRequests.size()
+           && isWriteCommand(openRequests.at(firstIndex).command)) {
+        const Request &request = openRequests.at(firstIndex);
+        if (!writePacket(request.payload))
+            return false;
+        Q_TRACE(QLowEnergyController_requestSent, quint8(request.payload.at(0)),
+                attHandleOfPdu(request.payload), int(request.payload.size()));
+        requestStatistics.recordWaitTime(requestOperation(request.command),
+                                         QLowEnergyRequestRecorder::Clock::now()
+                                                 - request.queuedAt);
+        openRequests.removeAt(firstIndex);
+    }
 
-    return attributeHandle;
+    return true;
 }
 
-void QLowEnergyControllerPrivateBluez::processReply(
-        const Request &request, const QByteArray &response)
+void QLowEnergyControllerPrivateBluez::l2cpReadyWrite()
 {
-    Q_Q(QLowEnergyController);
+    if (connection->writeNotifier)
+        connection->writeNotifier->setEnabled(false);
+    if (!flushOutboundQueue())
+        return;
+    sendNextPendingRequest();
+}
 
-    QBluezConst::AttCommand command = static_cast<QBluezConst::AttCommand>(response.constData()[0]);
+void QLowEnergyControllerPrivateBluez::sendNextPendingRequest()
+{
+    if (openRequests.isEmpty() || encryptionChangePending)
+        return;
 
-    bool isErrorResponse = false;
-    // if error occurred 2. byte is previous request type
-    if (command == QBluezConst::AttCommand::ATT_OP_ERROR_RESPONSE) {
-        dumpErrorInformation(response);
-        command = static_cast<QBluezConst::AttCommand>(response.constData()[1]);
-        isErrorResponse = true;
+    if (!flushWriteCommands() || openRequests.isEmpty() || requestPending)
+        return;
+
+    Request &request = openRequests.head();
+//    qCDebug(QT_BT_BLUEZ) << "Sending request, type:" << Qt::hex << request.command
+//             << request.payload.toHex();
+
+    requestStatistics.recordQueueDepth(openRequests.size());
+    request.sentAt = QLowEnergyRequestRecorder::Clock::now();
+    requestPending = true;
+    restartRequestTimer();
+    Q_TRACE(QLowEnergyController_requestSent, quint8(request.payload.at(0)),
+            attHandleOfPdu(request.payload), int(request.payload.size()));
+    sendPacket(request.payload);
+}
+
+/*!
+    \internal
+
+    Opens the Enhanced ATT bearers requested via the \c QT_BLUETOOTH_EATT_BEARERS
+    environment variable. Each bearer is an L2CAP enhanced credit based channel on
+    PSM 0x27 with its own request slot. The fixed ATT channel remains in use for
+    MTU exchange, service discovery and any request which does not fit a bearer.
+
+    The kernel must support enhanced credit based flow control and the remote
+    device must accept the channel. Otherwise the controller silently continues
+    with the fixed ATT channel only.
+ */
+void QLowEnergyControllerPrivateBluez::establishEattBearers()
+{
+    if (role != QLowEnergyController::CentralRole || requestedEattBearers <= 0
+            || !connection->socket) {
+        return;
     }
 
-    switch (command) {
-    case QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST: // in case of error
-    case QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_RESPONSE: {
-        Q_ASSERT(request.command == QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST);
-        quint16 oldMtuSize = mtuSize;
-        if (isErrorResponse) {
-            mtuSize = ATT_DEFAULT_LE_MTU;
-        } else {
-            const char *data = response.constData();
-            quint16 mtu = bt_get_le16(&data[1]);
-            mtuSize = mtu;
-            if (mtuSize < ATT_DEFAULT_LE_MTU)
-                mtuSize = ATT_DEFAULT_LE_MTU;
+    for (int i = 0; i < requestedEattBearers; ++i) {
+        const int fd = ::socket(AF_BLUETOOTH, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                                BTPROTO_L2CAP);
+        if (fd == -1) {
+            qCWarning(QT_BT_BLUEZ) << "EATT socket creation failed:" << qt_error_string(errno);
+            return;
+        }
 
-            qCDebug(QT_BT_BLUEZ) << "Server MTU:" << mtu << "resulting mtu:" << mtuSize;
+        struct bt_security secData;
+        memset(&secData, 0, sizeof(secData));
+        secData.level = BT_SECURITY_MEDIUM;
+        quint8 mode = BT_MODE_EXT_FLOWCTL;
+        if (::setsockopt(fd, SOL_BLUETOOTH, BT_SECURITY, &secData, sizeof(secData)) < 0
+                || ::setsockopt(fd, SOL_BLUETOOTH, BT_MODE, &mode, sizeof(mode)) < 0) {
+            qCDebug(QT_BT_BLUEZ) << "Kernel does not support EATT bearers:"
+                                 << qt_error_string(errno);
+            close(fd);
+            return;
         }
-        if (oldMtuSize != mtuSize)
-            emit q->mtuChanged(mtuSize);
-    } break;
-    case QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_REQUEST: // in case of error
-    case QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_RESPONSE: {
-        // Discovering services
-        Q_ASSERT(request.command == QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_REQUEST);
 
-        const quint16 type = request.reference.toUInt();
+        struct sockaddr_l2 addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.l2_family = AF_BLUETOOTH;
+        addr.l2_bdaddr_type = BDADDR_LE_PUBLIC;
+        convertAddress(localAdapter.toUInt64(), addr.l2_bdaddr.b);
+        if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+            qCWarning(QT_BT_BLUEZ) << "EATT bind() failed:" << qt_error_string(errno);
+            close(fd);
+            return;
+        }
 
-        if (isErrorResponse) {
-            if (type == GATT_SECONDARY_SERVICE) {
-                setState(QLowEnergyController::DiscoveredState);
-                q->discoveryFinished();
-            } else { // search for secondary services
-                sendReadByGroupRequest(0x0001, 0xFFFF, GATT_SECONDARY_SERVICE);
-            }
-            break;
+        memset(&addr, 0, sizeof(addr));
+        addr.l2_family = AF_BLUETOOTH;
+        addr.l2_psm = htobs(EATT_PSM);
+        addr.l2_bdaddr_type = connection->socket->d_ptr->lowEnergySocketType;
+        convertAddress(remoteDevice.toUInt64(), addr.l2_bdaddr.b);
+        if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0
+                && errno != EINPROGRESS) {
+            qCDebug(QT_BT_BLUEZ) << "EATT connect() failed:" << qt_error_string(errno);
+            close(fd);
+            return;
         }
 
-        QLowEnergyHandle start = 0, end = 0;
-        const quint16 elementLength = response.constData()[1];
-        const quint16 numElements = (response.size() - 2) / elementLength;
-        quint16 offset = 2;
-        const char *data = response.constData();
-        for (int i = 0; i < numElements; i++) {
-            start = bt_get_le16(&data[offset]);
-            end = bt_get_le16(&data[offset+2]);
+        EattBearer *bearer = new EattBearer;
+        bearer->socketDescriptor = fd;
+        bearer->connectNotifier = new QSocketNotifier(fd, QSocketNotifier::Write, this);
+        connect(bearer->connectNotifier, &QSocketNotifier::activated, this, [this, bearer]() {
+            eattBearerConnected(bearer);
+        });
+        eattBearers.append(bearer);
+    }
+}
 
-            QBluetoothUuid uuid;
-            if (elementLength == 6) //16 bit uuid
-                uuid = QBluetoothUuid(bt_get_le16(&data[offset+4]));
-            else if (elementLength == 20) //128 bit uuid
-                uuid = convert_uuid128((quint128 *)&data[offset+4]);
-            //else -> do nothing
+void QLowEnergyControllerPrivateBluez::eattBearerConnected(EattBearer *bearer)
+{
+    bearer->connectNotifier->setEnabled(false);
+    bearer->connectNotifier->deleteLater();
+    bearer->connectNotifier = nullptr;
+
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (::getsockopt(bearer->socketDescriptor, SOL_SOCKET, SO_ERROR, &error, &length) < 0
+            || error != 0) {
+        qCDebug(QT_BT_BLUEZ) << "EATT bearer rejected by remote device:" << qt_error_string(error);
+        removeEattBearer(bearer);
+        return;
+    }
 
-            offset += elementLength;
+    quint16 sendMtu = 0;
+    quint16 receiveMtu = 0;
+    length = sizeof(sendMtu);
+    ::getsockopt(bearer->socketDescriptor, SOL_BLUETOOTH, BT_SNDMTU, &sendMtu, &length);
+    length = sizeof(receiveMtu);
+    ::getsockopt(bearer->socketDescriptor, SOL_BLUETOOTH, BT_RCVMTU, &receiveMtu, &length);
+    bearer->mtu = std::clamp<quint16>((std::min)(sendMtu, receiveMtu),
+                                      ATT_DEFAULT_LE_MTU, localRxMtu());
 
+    QBluetoothSocketPrivateBluez *rawSocketPrivate = new QBluetoothSocketPrivateBluez();
+    rawSocketPrivate->setReaderOptions(attReaderOptions());
+    bearer->socket = new QBluetoothSocket(rawSocketPrivate, QBluetoothServiceInfo::L2capProtocol,
+                                          this);
+    // Unbuffered mode required to separate each GATT packet
+    bearer->socket->setSocketDescriptor(bearer->socketDescriptor,
+                                        QBluetoothServiceInfo::L2capProtocol,
+                                        QBluetoothSocket::SocketState::ConnectedState,
+                                        QIODevice::ReadWrite | QIODevice::Unbuffered);
+    bearer->socket->setSocketOption(
+                QBluetoothSocket::SocketOption::ReceiveTimestampSocketOption, true);
+    connect(bearer->socket, &QBluetoothSocket::readyRead, this, [this, bearer]() {
+        eattReadyRead(bearer);
+    });
+    connect(bearer->socket, &QBluetoothSocket::disconnected, this, [this, bearer]() {
+        qCDebug(QT_BT_BLUEZ) << "EATT bearer disconnected";
+        removeEattBearer(bearer);
+        sendNextPendingRequest();
+    });
+    connect(bearer->socket, &QBluetoothSocket::errorOccurred, this, [this, bearer]() {
+        qCDebug(QT_BT_BLUEZ) << "EATT bearer error:" << bearer->socket->errorString();
+        removeEattBearer(bearer);
+        sendNextPendingRequest();
+    });
 
-            qCDebug(QT_BT_BLUEZ) << "Found uuid:" << uuid << "start handle:" << Qt::hex
-                     << start << "end handle:" << end;
+    if (gattRequestTimeout > 0) {
+        bearer->requestTimer = std::make_unique<QLowEnergyRequestTimeout>([this, bearer]() {
+            handleEattRequestTimeout(bearer);
+        });
+    }
 
-            QLowEnergyServicePrivate *priv = new QLowEnergyServicePrivate();
-            priv->uuid = uuid;
-            priv->startHandle = start;
-            priv->endHandle = end;
-            if (type != GATT_PRIMARY_SERVICE) //unset PrimaryService bit
-                priv->type &= ~QLowEnergyService::PrimaryService;
-            priv->setController(this);
+    qCDebug(QT_BT_BLUEZ) << "EATT bearer connected, mtu:" << bearer->mtu;
+}
 
-            QSharedPointer<QLowEnergyServicePrivate> pointer(priv);
+void QLowEnergyControllerPrivateBluez::eattReadyRead(EattBearer *bearer)
+{
+    QByteArray incomingPacket = readPacket(bearer->socket);
+    const auto recycle = qScopeGuard([&]() { recyclePacket(std::move(incomingPacket)); });
+    qCDebug(QT_BT_BLUEZ) << "Received EATT size:" << incomingPacket.size() << "data:"
+                         << incomingPacket.toHex();
+    if (incomingPacket.isEmpty())
+        return;
+    receiveTimestamp = bearer->socket->lastReceiveTimestamp();
 
-            serviceList.insert(uuid, pointer);
-            emit q->serviceDiscovered(uuid);
+    const QBluezConst::AttCommand command =
+            static_cast<QBluezConst::AttCommand>(incomingPacket.constData()[0]);
+    switch (command) {
+    case QBluezConst::AttCommand::ATT_OP_HANDLE_VAL_NOTIFICATION:
+        processUnsolicitedReply(incomingPacket);
+        return;
+    case QBluezConst::AttCommand::ATT_OP_HANDLE_VAL_INDICATION: {
+        // the confirmation must be sent on the bearer which carried the indication
+        const char confirmation =
+                static_cast<char>(QBluezConst::AttCommand::ATT_OP_HANDLE_VAL_CONFIRMATION);
+        if (bearer->socket->write(&confirmation, sizeof(confirmation)) == 0) {
+            bearer->confirmationPending = true;
+            waitForEattWritable(bearer);
         }
 
-        if (end != 0xFFFF) {
-            sendReadByGroupRequest(end+1, 0xFFFF, type);
-        } else {
-            if (type == GATT_SECONDARY_SERVICE) {
-                setState(QLowEnergyController::DiscoveredState);
-                emit q->discoveryFinished();
-            } else { // search for secondary services
-                sendReadByGroupRequest(0x0001, 0xFFFF, GATT_SECONDARY_SERVICE);
-            }
-        }
-    } break;
-    case QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_REQUEST: // in case of error
-    case QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_RESPONSE: {
-        // Discovering characteristics
-        Q_ASSERT(request.command == QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_REQUEST);
+        processUnsolicitedReply(incomingPacket);
+        return;
+    }
+    default:
+        break;
+    }
 
-        QSharedPointer<QLowEnergyServicePrivate> p =
-                request.reference.value<QSharedPointer<QLowEnergyServicePrivate> >();
-        const quint16 attributeType = request.reference2.toUInt();
+    if (!bearer->requestPending || bearer->openRequests.isEmpty()) {
+        // The peripheral side is not served on EATT bearers
+        qCWarning(QT_BT_BLUEZ) << "Ignoring unexpected packet on EATT bearer:" << Qt::hex
+                               << command;
+        return;
+    }
 
-        if (isErrorResponse) {
-            if (attributeType == GATT_CHARACTERISTIC) {
-                // we reached end of service handle
-                // just finished up characteristic discovery
-                // continue with values of characteristics
-                if (!p->characteristicList.isEmpty()) {
-                    readServiceValues(p->uuid, true);
-                } else {
-                    // discovery finished since the service doesn't have any
-                    // characteristics
+    if (bearer->requestTimer)
+        bearer->requestTimer->stop();
+    bearer->requestPending = false;
+
+    const Request request = bearer->openRequests.dequeue();
+    Q_TRACE(QLowEnergyController_responseReceived, quint8(incomingPacket.at(0)),
+            attHandleOfPdu(request.payload), int(incomingPacket.size()));
+    requestStatistics.recordRequest(requestOperation(request.command), request.queuedAt,
+                                    request.sentAt);
+    requestTimeouts.recordResponse(requestOperation(request.command),
+                                   QLowEnergyRequestRecorder::Clock::now() - request.sentAt);
+    activeBearer = bearer;
+    if (!request.cancelled)
+        processReply(request, incomingPacket);
+    activeBearer = nullptr;
+
+    sendNextEattRequest(bearer);
+    sendNextPendingRequest();
+}
+
+void QLowEnergyControllerPrivateBluez::sendNextEattRequest(EattBearer *bearer)
+{
+    if (!bearer->socket || bearer->requestPending || bearer->openRequests.isEmpty()
+            || (bearer->writeNotifier && bearer->writeNotifier->isEnabled())) {
+        return;
+    }
+
+    Request &request = bearer->openRequests.head();
+    const qint64 result = bearer->socket->write(request.payload.constData(),
+                                                request.payload.size());
+    if (result == 0) {
+        // EAGAIN -> the request stays queued until the bearer is writable again
+        waitForEattWritable(bearer);
+        return;
+    }
+    if (result == -1) {
+        qCDebug(QT_BT_BLUEZ) << "Cannot write EATT packet:" << Qt::hex
+                             << request.payload.toHex()
+                             << bearer->socket->errorString();
+        // nothing was sent, retry everything on the fixed channel
+        removeEattBearer(bearer);
+        sendNextPendingRequest();
+        return;
+    }
+
+    requestStatistics.recordQueueDepth(bearer->openRequests.size());
+    request.sentAt = QLowEnergyRequestRecorder::Clock::now();
+    bearer->requestPending = true;
+    if (bearer->requestTimer)
+        bearer->requestTimer->start(requestTimeouts.timeout(requestOperation(request.command)));
+
+    Q_TRACE(QLowEnergyController_requestSent, quint8(request.payload.at(0)),
+            attHandleOfPdu(request.payload), int(request.payload.size()));
+}
+
+/*!
+    \internal
+
+    Arms the write notifier of \a bearer after a write failed with a full
+    kernel send buffer. No further request is sent on \a bearer until
+    eattReadyWrite() resumes it.
+ */
+void QLowEnergyControllerPrivateBluez::waitForEattWritable(EattBearer *bearer)
+{
+    if (!bearer->writeNotifier) {
+        bearer->writeNotifier = new QSocketNotifier(bearer->socketDescriptor,
+                                                    QSocketNotifier::Write, this);
+        connect(bearer->writeNotifier, &QSocketNotifier::activated, this, [this, bearer]() {
+            eattReadyWrite(bearer);
+        });
+    }
+    bearer->writeNotifier->setEnabled(true);
+}
+
+void QLowEnergyControllerPrivateBluez::eattReadyWrite(EattBearer *bearer)
+{
+    bearer->writeNotifier->setEnabled(false);
+
+    if (bearer->confirmationPending) {
+        const char confirmation =
+                static_cast<char>(QBluezConst::AttCommand::ATT_OP_HANDLE_VAL_CONFIRMATION);
+        if (bearer->socket->write(&confirmation, sizeof(confirmation)) == 0) {
+            waitForEattWritable(bearer);
+            return;
+        }
+        bearer->confirmationPending = false;
+    }
+
+    sendNextEattRequest(bearer);
+}
+
+void QLowEnergyControllerPrivateBluez::handleEattRequestTimeout(EattBearer *bearer)
+{
+    if (!bearer->requestPending || bearer->openRequests.isEmpty())
+        return;
+
+    const Request currentRequest = bearer->openRequests.dequeue();
+    bearer->requestPending = false;
+
+    activeBearer = bearer;
+    processTimedOutRequest(currentRequest);
+    activeBearer = nullptr;
+
+    sendNextEattRequest(bearer);
+    sendNextPendingRequest();
+}
+
+/*!
+    \internal
+
+    Closes \a bearer and moves its unsent requests to the fixed ATT channel.
+    A request which was already sent on the bearer fails like a timed out
+    request. The peer may have applied it, and writes are not idempotent.
+ */
+void QLowEnergyControllerPrivateBluez::removeEattBearer(EattBearer *bearer)
+{
+    eattBearers.removeOne(bearer);
+
+    if (bearer->connectNotifier) {
+        bearer->connectNotifier->setEnabled(false);
+        bearer->connectNotifier->deleteLater();
+    }
+    if (bearer->writeNotifier) {
+        bearer->writeNotifier->setEnabled(false);
+        bearer->writeNotifier->deleteLater();
+    }
+    if (bearer->socket) {
+        bearer->socket->disconnect(this);
+        bearer->socket->abort();
+        bearer->socket->deleteLater();
+        // follow-up requests of the failed request must not be sent on it
+        bearer->socket = nullptr;
+    } else if (bearer->socketDescriptor != -1) {
+        close(bearer->socketDescriptor);
+    }
+    if (bearer->requestTimer)
+        bearer->requestTimer->stop();
+
+    if (bearer->requestPending && !bearer->openRequests.isEmpty()) {
+        const Request sentRequest = bearer->openRequests.dequeue();
+        bearer->requestPending = false;
+
+        // follow-up requests are prepended to bearer->openRequests and moved below
+        activeBearer = bearer;
+        processTimedOutRequest(sentRequest);
+        activeBearer = nullptr;
+    }
+
+    for (const Request &request : qAsConst(bearer->openRequests))
+        queueRequest(openRequests, requestPending || encryptionChangePending, request);
+
+    delete bearer;
+}
+
+/*!
+    \internal
+
+    Returns the EATT bearer which carries the requests of \a service or \c nullptr
+    if the fixed ATT channel is to be used. Each service is bound to one bearer to
+    preserve the order of its requests.
+ */
+QLowEnergyControllerPrivateBluez::EattBearer *
+QLowEnergyControllerPrivateBluez::bearerForService(
+        const QSharedPointer<QLowEnergyServicePrivate> &service, qsizetype packetSize) const
+{
+    if (eattBearers.isEmpty() || service.isNull() || encryptionChangePending)
+        return nullptr;
+
+    const qsizetype connectedCount = std::count_if(
+            eattBearers.cbegin(), eattBearers.cend(),
+            [](const EattBearer *bearer) { return bearer->socket != nullptr; });
+    if (connectedCount == 0)
+        return nullptr;
+
+    // index 0 refers to the fixed ATT channel
+    qsizetype index = service->startHandle % (connectedCount + 1);
+    if (index == 0)
+        return nullptr;
+
+    for (EattBearer *bearer : eattBearers) {
+        if (bearer->socket && --index == 0)
+            return packetSize <= bearer->mtu ? bearer : nullptr;
+    }
+    return nullptr;
+}
+
+void QLowEnergyControllerPrivateBluez::enqueueRequest(
+        const QSharedPointer<QLowEnergyServicePrivate> &service, Request request)
+{
+    traceRequestQueued(request.payload);
+
+    request.owner = service.data();
+
+    EattBearer *bearer = bearerForService(service, request.payload.size());
+    if (!bearer) {
+        queueRequest(openRequests, requestPending || encryptionChangePending,
+                     std::move(request));
+        sendNextPendingRequest();
+        return;
+    }
+
+    queueRequest(bearer->openRequests, bearer->requestPending, std::move(request));
+    sendNextEattRequest(bearer);
+}
+
+/*!
+    \internal
+
+    Schedules \a request as next request on the bearer whose response
+    is currently processed.
+ */
+void QLowEnergyControllerPrivateBluez::prependRequest(Request request)
+{
+    traceRequestQueued(request.payload);
+    if (activeBearer)
+        activeBearer->openRequests.prepend(std::move(request));
+    else
+        openRequests.prepend(std::move(request));
+}
+
+/*!
+    \internal
+
+    Queues \a request behind all requests of the same or a higher priority
+    in \a queue. The head of \a queue stays in place if \a headInFlight is set.
+
+    A request is overtaken by at most MaxRequestOvertakes requests of a
+    higher priority, afterwards it keeps its place. A busy application
+    therefore delays the service discovery but cannot stall it.
+ */
+void QLowEnergyControllerPrivateBluez::queueRequest(QQueue<Request> &queue, bool headInFlight,
+                                                    Request request)
+{
+    const qsizetype first = headInFlight && !queue.isEmpty() ? 1 : 0;
+    qsizetype index = queue.size();
+    while (index > first && queue.at(index - 1).priority > request.priority
+           && queue.at(index - 1).overtaken < MaxRequestOvertakes) {
+        --index;
+    }
+    for (qsizetype i = index; i < queue.size(); ++i)
+        ++queue[i].overtaken;
+    queue.insert(index, std::move(request));
+}
+
+void QLowEnergyControllerPrivateBluez::queueRequest(Request request)
+{
+    traceRequestQueued(request.payload);
+    queueRequest(openRequests, requestPending || encryptionChangePending, std::move(request));
+}
+
+/*!
+    \internal
+
+    Returns \c true if \a request is a discovery or read request issued
+    on behalf of \a service. Writes change the remote device and are always sent.
+ */
+bool QLowEnergyControllerPrivateBluez::isCancellableRequest(const Request &request,
+                                                            QLowEnergyServicePrivate *service)
+{
+    if (request.owner != service)
+        return false;
+
+    switch (request.command) {
+    case QBluezConst::AttCommand::ATT_OP_FIND_INFORMATION_REQUEST:
+    case QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_REQUEST:
+    case QBluezConst::AttCommand::ATT_OP_READ_REQUEST:
+    case QBluezConst::AttCommand::ATT_OP_READ_BLOB_REQUEST:
+    case QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_REQUEST:
+    case QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*!
+    \internal
+
+    Drops the queued discovery and read requests of \a service on all bearers.
+    The response of such a request which is already in flight is ignored.
+    The pipelined long reads are not owned by a service and run to completion.
+ */
+bool QLowEnergyControllerPrivateBluez::cancelRequests(QLowEnergyServicePrivate *service)
+{
+    const auto cancel = [service](QQueue<Request> &queue, bool headInFlight) {
+        qsizetype first = 0;
+        if (headInFlight && !queue.isEmpty()) {
+            if (isCancellableRequest(queue.head(), service))
+                queue.head().cancelled = true;
+            first = 1;
+        }
+        const auto isCancelled = [service](const Request &request) {
+            return isCancellableRequest(request, service);
+        };
+        queue.erase(std::remove_if(queue.begin() + first, queue.end(), isCancelled),
+                    queue.end());
+    };
+
+    cancel(openRequests, requestPending || encryptionChangePending);
+    for (EattBearer *bearer : qAsConst(eattBearers))
+        cancel(bearer->openRequests, bearer->requestPending);
+    return true;
+}
+
+/*!
+    \internal
+
+    Returns the ATT_MTU of the bearer whose response is currently processed.
+ */
+quint16 QLowEnergyControllerPrivateBluez::attMtu() const
+{
+    return activeBearer ? activeBearer->mtu : connection->mtu;
+}
+
+/*!
+    \internal
+
+    Requeues \a request if \a errorCode indicates that a higher security
+    level is required. Returns \c true if the request was requeued.
+
+    The security upgrade of the link is always driven by the fixed ATT channel.
+    Therefore requests which failed on an EATT bearer are moved to it.
+ */
+bool QLowEnergyControllerPrivateBluez::retryRequestWithHigherSecurity(
+        const Request &request, QBluezConst::AttError errorCode)
+{
+    if (activeBearer) {
+        switch (errorCode) {
+        case QBluezConst::AttError::ATT_ERROR_INSUF_ENCRYPTION:
+        case QBluezConst::AttError::ATT_ERROR_INSUF_AUTHENTICATION:
+        case QBluezConst::AttError::ATT_ERROR_INSUF_ENCR_KEY_SIZE:
+            if (connection->securityLevelValue == BT_SECURITY_HIGH)
+                return false;
+            requestStatistics.recordRetry();
+            queueRequest(openRequests, requestPending || encryptionChangePending, request);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    Q_ASSERT(!encryptionChangePending);
+    encryptionChangePending = increaseEncryptLevelfRequired(errorCode);
+    if (encryptionChangePending) {
+        // Just requested a security level change.
+        // Retry the same command again once the change has happened
+        requestStatistics.recordRetry();
+        openRequests.prepend(request);
+    }
+    return encryptionChangePending;
+}
+
+static bool parseReadByTypeCharDiscovery(
+        QLowEnergyServicePrivate::CharData *charData, QLowEnergyHandle *attributeHandle,
+        QByteArrayView element)
+{
+    Q_ASSERT(charData);
+    Q_ASSERT(attributeHandle);
+
+    QBluezAtt::CharacteristicDeclaration declaration;
+    if (!QBluezAtt::parseCharacteristicDeclaration(element, &declaration))
+        return false;
+
+    *attributeHandle = declaration.declarationHandle;
+    charData->properties = QLowEnergyCharacteristic::PropertyTypes(declaration.properties);
+    charData->valueHandle = declaration.valueHandle;
+    charData->uuid = declaration.uuid;
+
+    qCDebug(QT_BT_BLUEZ) << "Found handle:" << Qt::hex << *attributeHandle
+             << "properties:" << charData->properties
+             << "value handle:" << charData->valueHandle
+             << "uuid:" << charData->uuid.toString();
+
+    return true;
+}
+
+static bool parseReadByTypeIncludeDiscovery(
+        QList<QBluetoothUuid> *foundServices, QLowEnergyHandle *attributeHandle,
+        QByteArrayView element)
+{
+    Q_ASSERT(foundServices);
+    Q_ASSERT(attributeHandle);
+
+    // the included service handle range is not required as we have discovered
+    // all (primary/secondary) services already. Now we are only
+    // interested in their relationship to each other
+    QBluezAtt::IncludeDeclaration declaration;
+    if (!QBluezAtt::parseIncludeDeclaration(element, &declaration))
+        return false;
+
+    *attributeHandle = declaration.declarationHandle;
+    if (!declaration.uuid.isNull())
+        foundServices->append(declaration.uuid);
+
+    qCDebug(QT_BT_BLUEZ) << "Found included service: " << Qt::hex
+                         << *attributeHandle << "uuid:" << *foundServices;
+
+    return true;
+}
+
+void QLowEnergyControllerPrivateBluez::processReply(
+        const Request &request, const QByteArray &response)
+{
+    Q_Q(QLowEnergyController);
+
+    QBluezConst::AttCommand command = static_cast<QBluezConst::AttCommand>(response.constData()[0]);
+
+    bool isErrorResponse = false;
+    // if error occurred 2. byte is previous request type
+    if (command == QBluezConst::AttCommand::ATT_OP_ERROR_RESPONSE) {
+        dumpErrorInformation(response);
+        command = static_cast<QBluezConst::AttCommand>(response.constData()[1]);
+        isErrorResponse = true;
+    }
+
+    switch (command) {
+    case QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST: // in case of error
+    case QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_RESPONSE: {
+        Q_ASSERT(request.command == QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST);
+        quint16 oldMtuSize = connection->mtu;
+        if (isErrorResponse) {
+            connection->mtu = ATT_DEFAULT_LE_MTU;
+        } else {
+            quint16 mtu = ATT_DEFAULT_LE_MTU;
+            QBluezAtt::parseMtu(response, &mtu);
+            // the smaller of both RX MTUs applies, see Spec v5.3, Vol 3, Part F, 3.4.2.2
+            connection->mtu = std::clamp(mtu, ATT_DEFAULT_LE_MTU, localRxMtu());
+
+            qCDebug(QT_BT_BLUEZ) << "Server MTU:" << mtu << "resulting mtu:" << connection->mtu;
+        }
+        if (oldMtuSize != connection->mtu)
+            emit q->mtuChanged(connection->mtu);
+    } break;
+    case QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_REQUEST: // in case of error
+    case QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_RESPONSE: {
+        // Discovering services
+        Q_ASSERT(request.command == QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_REQUEST);
+
+        const quint16 type = request.reference.toUInt();
+
+        if (isErrorResponse) {
+            finishServiceGroupDiscovery(type);
+            break;
+        }
+
+        QLowEnergyHandle end = 0;
+        for (const QByteArrayView element : QBluezAtt::AttributeDataList(response)) {
+            QBluezAtt::GroupData group;
+            if (!QBluezAtt::parseGroupData(element, &group))
+                break;
+            end = group.endingHandle;
+
+            // other value sizes leave a null uuid
+            const QBluetoothUuid uuid = QBluezAtt::uuidFromData(group.value);
+
+            // the full discovery filters by UUID via ATT_OP_FIND_BY_TYPE_VALUE_REQUEST
+            if (serviceRangeDiscovery && !isServiceInDiscoveryFilter(uuid))
+                continue;
+            addDiscoveredService(uuid, group.startingHandle, end, type == GATT_PRIMARY_SERVICE);
+        }
+
+        if (end < discoveryRangeEnd)
+            sendReadByGroupRequest(end+1, discoveryRangeEnd, type);
+        else
+            finishServiceGroupDiscovery(type);
+    } break;
+    case QBluezConst::AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_REQUEST: // in case of error
+    case QBluezConst::AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_RESPONSE: {
+        // Discovering the primary services of the discovery filter
+        Q_ASSERT(request.command == QBluezConst::AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_REQUEST);
+
+        const qsizetype filterIndex = request.reference.toLongLong();
+        const QBluetoothUuid uuid = serviceDiscoveryFilter.value(filterIndex);
+
+        // the response is a list of (found attribute handle, group end handle) pairs
+        QLowEnergyHandle end = 0xFFFF;
+        if (!isErrorResponse) {
+            for (const QByteArrayView element : QBluezAtt::AttributeDataList(response)) {
+                const QLowEnergyHandle start = bt_get_le16(element.data());
+                end = bt_get_le16(element.data() + 2);
+                addDiscoveredService(uuid, start, end, true);
+            }
+        }
+
+        // an error response (usually ATT_ERROR_ATTRIBUTE_NOT_FOUND) means there are no
+        // further instances of this service
+        if (!isErrorResponse && end < 0xFFFF) {
+            sendFindByTypeValueRequest(end + 1, filterIndex);
+        } else if (filterIndex + 1 < serviceDiscoveryFilter.size()) {
+            sendFindByTypeValueRequest(0x0001, filterIndex + 1);
+        } else {
+            // secondary services are only reachable via the included services
+            // of the discovered services
+            finishServiceDiscovery();
+        }
+    } break;
+    case QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_REQUEST: // in case of error
+    case QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_RESPONSE: {
+        // Discovering characteristics
+        Q_ASSERT(request.command == QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_REQUEST);
+
+        const quint16 attributeType = request.reference2.toUInt();
+        if (attributeType == GATT_DATABASE_HASH) {
+            processDatabaseHashReply(response, isErrorResponse);
+            break;
+        }
+
+        QSharedPointer<QLowEnergyServicePrivate> p =
+                request.reference.value<QSharedPointer<QLowEnergyServicePrivate> >();
+
+        if (isErrorResponse) {
+            if (attributeType == GATT_CHARACTERISTIC) {
+                // we reached end of service handle
+                // just finished up characteristic discovery
+                // continue with values of characteristics
+                if (!p->characteristicList.isEmpty()) {
+                    readServiceValues(p->uuid, true);
+                } else {
+                    // discovery finished since the service doesn't have any
+                    // characteristics
                     p->setState(QLowEnergyService::RemoteServiceDiscovered);
                 }
             } else if (attributeType == GATT_INCLUDED_SERVICE) {
@@ -1099,27 +2420,27 @@ void QLowEnergyControllerPrivateBluez::processReply(
          *
          *  The uuid can be 16 or 128 bit.
          */
-        QLowEnergyHandle lastHandle;
-        const quint16 elementLength = response.constData()[1];
-        const quint16 numElements = (response.size() - 2) / elementLength;
-        quint16 offset = 2;
-        const char *data = response.constData();
-        for (int i = 0; i < numElements; i++) {
+        // a malformed response ends the discovery of the current attribute type
+        QLowEnergyHandle lastHandle = p->endHandle;
+        QList<QBluetoothUuid> includedServices;
+        for (const QByteArrayView element : QBluezAtt::AttributeDataList(response)) {
+            QLowEnergyHandle handle = 0;
             if (attributeType == GATT_CHARACTERISTIC) {
                 QLowEnergyServicePrivate::CharData characteristic;
-                lastHandle = parseReadByTypeCharDiscovery(
-                            &characteristic, &data[offset], elementLength);
-                p->characteristicList[lastHandle] = characteristic;
-                offset += elementLength;
+                if (!parseReadByTypeCharDiscovery(&characteristic, &handle, element))
+                    break;
+                p->characteristicList[handle] = characteristic;
             } else if (attributeType == GATT_INCLUDED_SERVICE) {
-                QList<QBluetoothUuid> includedServices;
-                lastHandle = parseReadByTypeIncludeDiscovery(
-                            &includedServices, &data[offset], elementLength);
-                p->includedServices = includedServices;
-                for (const QBluetoothUuid &uuid : qAsConst(includedServices)) {
-                    if (serviceList.contains(uuid))
-                        serviceList[uuid]->type |= QLowEnergyService::IncludedService;
-                }
+                if (!parseReadByTypeIncludeDiscovery(&includedServices, &handle, element))
+                    break;
+            }
+            lastHandle = handle;
+        }
+        if (attributeType == GATT_INCLUDED_SERVICE) {
+            p->includedServices = includedServices;
+            for (const QBluetoothUuid &uuid : qAsConst(includedServices)) {
+                if (serviceList.contains(uuid))
+                    serviceList[uuid]->type |= QLowEnergyService::IncludedService;
             }
         }
 
@@ -1143,17 +2464,12 @@ void QLowEnergyControllerPrivateBluez::processReply(
 
         QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
         Q_ASSERT(!service.isNull());
-        bool isServiceDiscoveryRun
-                = !(service->state == QLowEnergyService::RemoteServiceDiscovered);
+        // an incremental discovery reads the values after the service was discovered
+        const bool isServiceDiscoveryRun = request.valueDiscovery;
 
         if (isErrorResponse) {
-            Q_ASSERT(!encryptionChangePending);
             QBluezConst::AttError err = static_cast<QBluezConst::AttError>(response.constData()[4]);
-            encryptionChangePending = increaseEncryptLevelfRequired(err);
-            if (encryptionChangePending) {
-                // Just requested a security level change.
-                // Retry the same command again once the change has happened
-                openRequests.prepend(request);
+            if (retryRequestWithHigherSecurity(request, err)) {
                 break;
             } else if (!isServiceDiscoveryRun) {
                 // not encryption problem -> abort readCharacteristic()/readDescriptor() run
@@ -1163,28 +2479,31 @@ void QLowEnergyControllerPrivateBluez::processReply(
                     service->setError(QLowEnergyService::DescriptorReadError);
             }
         } else {
+            // shared between the service data and the emitted signal
+            const QByteArray value = response.mid(1);
             if (!descriptorHandle)
-                updateValueOfCharacteristic(charHandle, response.mid(1), NEW_VALUE);
+                updateValueOfCharacteristic(charHandle, value, NEW_VALUE);
             else
-                updateValueOfDescriptor(charHandle, descriptorHandle,
-                                        response.mid(1), NEW_VALUE);
+                updateValueOfDescriptor(charHandle, descriptorHandle, value, NEW_VALUE);
 
-            if (response.size() == mtuSize) {
+            if (response.size() == attMtu()) {
                 qCDebug(QT_BT_BLUEZ) << "Switching to blob reads for"
                          << charHandle << descriptorHandle
                          << service->characteristicList[charHandle].uuid.toString();
                 // Potentially more data -> switch to blob reads
-                readServiceValuesByOffset(handleData, mtuSize-1,
-                                          request.reference2.toBool());
+                if (!isServiceDiscoveryRun && startLongRead(handleData, value))
+                    break;
+                readServiceValuesByOffset(handleData, attMtu() - 1,
+                                          request.reference2.toBool(), isServiceDiscoveryRun);
                 break;
             } else if (!isServiceDiscoveryRun) {
                 // readCharacteristic() or readDescriptor() ongoing
                 if (!descriptorHandle) {
                     QLowEnergyCharacteristic ch(service, charHandle);
-                    emit service->characteristicRead(ch, response.mid(1));
+                    emit service->characteristicRead(ch, value);
                 } else {
                     QLowEnergyDescriptor descriptor(service, charHandle, descriptorHandle);
-                    emit service->descriptorRead(descriptor, response.mid(1));
+                    emit service->descriptorRead(descriptor, value);
                 }
                 break;
             }
@@ -1214,6 +2533,11 @@ void QLowEnergyControllerPrivateBluez::processReply(
         QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
         Q_ASSERT(!service.isNull());
 
+        if (longReads.contains(handleData)) {
+            processLongReadResponse(request, response, isErrorResponse);
+            break;
+        }
+
         /*
          * READ_BLOB does not require encryption setup code. BLOB commands
          * are only issued after read request if the read request is too long
@@ -1228,11 +2552,15 @@ void QLowEnergyControllerPrivateBluez::processReply(
                 length = updateValueOfDescriptor(charHandle, descriptorHandle,
                                         response.mid(1), APPEND_VALUE);
 
-            if (response.size() == mtuSize) {
+            if (response.size() == attMtu()) {
+                if (!descriptorHandle && !request.valueDiscovery) {
+                    emit service->characteristicReadProgress(
+                            QLowEnergyCharacteristic(service, charHandle), length);
+                }
                 readServiceValuesByOffset(handleData, length,
-                                          request.reference2.toBool());
+                                          request.reference2.toBool(), request.valueDiscovery);
                 break;
-            } else if (service->state == QLowEnergyService::RemoteServiceDiscovered) {
+            } else if (!request.valueDiscovery) {
                 // readCharacteristic() or readDescriptor() ongoing
                 if (!descriptorHandle) {
                     QLowEnergyCharacteristic ch(service, charHandle);
@@ -1247,10 +2575,10 @@ void QLowEnergyControllerPrivateBluez::processReply(
             qWarning() << "READ BLOB for char:" << charHandle
                        << "descriptor:" << descriptorHandle << "on service"
                        << service->uuid.toString() << "failed (service discovery run:"
-                       << (service->state == QLowEnergyService::RemoteServiceDiscovered) << ")";
+                       << request.valueDiscovery << ")";
         }
 
-        if (request.reference2.toBool()) {
+        if (request.reference2.toBool() && request.valueDiscovery) {
             //last overlong characteristic -> progress to descriptor discovery
             //last overlong descriptor -> service discovery is done
 
@@ -1261,6 +2589,16 @@ void QLowEnergyControllerPrivateBluez::processReply(
         }
 
     } break;
+    case QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_REQUEST: // error case
+    case QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_RESPONSE:
+    case QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST: // error case
+    case QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_RESPONSE:
+        // Reading several characteristic or descriptor values during service discovery
+        Q_ASSERT(request.command == QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_REQUEST
+                 || request.command
+                         == QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST);
+        processReadMultipleReply(request, response, isErrorResponse);
+        break;
     case QBluezConst::AttCommand::ATT_OP_FIND_INFORMATION_REQUEST: // error case
     case QBluezConst::AttCommand::ATT_OP_FIND_INFORMATION_RESPONSE: {
         //Discovering descriptors
@@ -1295,35 +2633,16 @@ void QLowEnergyControllerPrivateBluez::processReply(
             break;
         }
 
-        const quint8 format = response[1];
-        quint16 elementLength;
-        switch (format) {
-        case 0x01:
-            elementLength = 2 + 2; //sizeof(QLowEnergyHandle) + 16bit uuid
-            break;
-        case 0x02:
-            elementLength = 2 + 16; //sizeof(QLowEnergyHandle) + 128bit uuid
-            break;
-        default:
+        const QBluezAtt::AttributeDataList elements(response);
+        if (!elements.isValid()) {
             qCWarning(QT_BT_BLUEZ) << "Unknown format in FIND_INFORMATION_RESPONSE";
             return;
         }
 
-        const quint16 numElements = (response.size() - 2) / elementLength;
-
-        quint16 offset = 2;
         QLowEnergyHandle descriptorHandle {};
-        QBluetoothUuid uuid;
-        const char *data = response.constData();
-        for (int i = 0; i < numElements; i++) {
-            descriptorHandle = bt_get_le16(&data[offset]);
-
-            if (format == 0x01)
-                uuid = QBluetoothUuid(bt_get_le16(&data[offset+2]));
-            else if (format == 0x02)
-                uuid = convert_uuid128((quint128 *)&data[offset+2]);
-
-            offset += elementLength;
+        for (const QByteArrayView element : elements) {
+            descriptorHandle = bt_get_le16(element.data());
+            const QBluetoothUuid uuid = QBluezAtt::uuidFromData(element.sliced(2));
 
             // ignore all attributes which are not of type descriptor
             // examples are the characteristics value or
@@ -1390,13 +2709,9 @@ void QLowEnergyControllerPrivateBluez::processReply(
             break;
 
         if (isErrorResponse) {
-            Q_ASSERT(!encryptionChangePending);
             QBluezConst::AttError err = static_cast<QBluezConst::AttError>(response.constData()[4]);
-            encryptionChangePending = increaseEncryptLevelfRequired(err);
-            if (encryptionChangePending) {
-                openRequests.prepend(request);
+            if (retryRequestWithHigherSecurity(request, err))
                 break;
-            }
 
             if (!descriptorHandle)
                 service->setError(QLowEnergyService::CharacteristicWriteError);
@@ -1422,19 +2737,29 @@ void QLowEnergyControllerPrivateBluez::processReply(
         //Prepare write command response
         Q_ASSERT(request.command == QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_REQUEST);
 
+        if (request.reliableWriteId) {
+            if (isErrorResponse) {
+                QBluezConst::AttError err = static_cast<QBluezConst::AttError>(response.constData()[4]);
+                if (retryRequestWithHigherSecurity(request, err))
+                    break;
+                cancelReliableWrite(request.reliableWriteId);
+            } else if (response.mid(1) != request.payload.mid(1)) {
+                // the server must echo the queued value, anything else breaks the transaction
+                qCWarning(QT_BT_BLUEZ) << "Reliable write: prepared value was altered by the server";
+                cancelReliableWrite(request.reliableWriteId);
+            }
+            break;
+        }
+
         uint handleData = request.reference.toUInt();
         const QLowEnergyHandle attrHandle = (handleData & 0xffff);
         const QByteArray newValue = request.reference2.toByteArray();
         const int writtenPayload = ((handleData >> 16) & 0xffff);
 
         if (isErrorResponse) {
-            Q_ASSERT(!encryptionChangePending);
             QBluezConst::AttError err = static_cast<QBluezConst::AttError>(response.constData()[4]);
-            encryptionChangePending = increaseEncryptLevelfRequired(err);
-            if (encryptionChangePending) {
-                openRequests.prepend(request);
+            if (retryRequestWithHigherSecurity(request, err))
                 break;
-            }
             //emits error on cancellation and aborts existing prepare reuqests
             sendExecuteWriteRequest(attrHandle, newValue, true);
         } else {
@@ -1447,10 +2772,15 @@ void QLowEnergyControllerPrivateBluez::processReply(
     } break;
     case QBluezConst::AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST: // error case
     case QBluezConst::AttCommand::ATT_OP_EXECUTE_WRITE_RESPONSE: {
-        // right now used in connection with long characteristic/descriptor value writes
-        // not catering for reliable writes
+        // used in connection with long characteristic/descriptor value writes
+        // and reliable write transactions
         Q_ASSERT(request.command == QBluezConst::AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST);
 
+        if (request.reliableWriteId) {
+            finishReliableWrite(request, isErrorResponse);
+            break;
+        }
+
         uint handleData = request.reference.toUInt();
         const QLowEnergyHandle attrHandle = handleData & 0xffff;
         bool wasCancellation = !((handleData >> 16) & 0xffff);
@@ -1479,31 +2809,167 @@ void QLowEnergyControllerPrivateBluez::processReply(
                 emit service->characteristicWritten(ch, newValue);
             }
         }
-    } break;
-    default:
-        qCDebug(QT_BT_BLUEZ) << "Unknown packet: " << response.toHex();
-        break;
+    } break;
+    default:
+        qCDebug(QT_BT_BLUEZ) << "Unknown packet: " << response.toHex();
+        break;
+    }
+}
+
+void QLowEnergyControllerPrivateBluez::discoverServices()
+{
+    if (isGattCacheEnabled()) {
+        // the Database Hash decides whether the GATT cache can be used
+        readDatabaseHash();
+        return;
+    }
+
+    discoverPrimaryServices();
+}
+
+/*!
+    \internal
+
+    Starts the discovery of the primary services on the remote device. Without
+    discovery filter all services are enumerated, otherwise each service of the
+    filter is looked up by its UUID.
+ */
+void QLowEnergyControllerPrivateBluez::discoverPrimaryServices()
+{
+    discoveryRangeStart = 0x0001;
+    discoveryRangeEnd = 0xFFFF;
+    if (serviceDiscoveryFilter.isEmpty())
+        sendReadByGroupRequest(discoveryRangeStart, discoveryRangeEnd, GATT_PRIMARY_SERVICE);
+    else
+        sendFindByTypeValueRequest(0x0001, 0);
+}
+
+/*!
+    \internal
+
+    Continues with the secondary services once the primary services of the
+    current handle range are known, finishes the discovery otherwise.
+ */
+void QLowEnergyControllerPrivateBluez::finishServiceGroupDiscovery(quint16 type)
+{
+    Q_Q(QLowEnergyController);
+
+    if (type == GATT_PRIMARY_SERVICE) {
+        // search for secondary services
+        sendReadByGroupRequest(discoveryRangeStart, discoveryRangeEnd, GATT_SECONDARY_SERVICE);
+    } else if (serviceRangeDiscovery) {
+        qCDebug(QT_BT_BLUEZ) << "Re-discovered services in handle range" << Qt::hex
+                             << discoveryRangeStart << discoveryRangeEnd;
+        serviceRangeDiscovery = false;
+        emit q->discoveryFinished();
+        startPendingRangeDiscovery();
+    } else {
+        finishServiceDiscovery();
+    }
+}
+
+void QLowEnergyControllerPrivateBluez::finishServiceDiscovery()
+{
+    Q_Q(QLowEnergyController);
+
+    storeServicesInCache();
+    setState(QLowEnergyController::DiscoveredState);
+    emit q->discoveryFinished();
+    startPendingRangeDiscovery();
+}
+
+/*!
+    \internal
+
+    Handles a Service Changed indication for the handle range \a start to
+    \a end, see Bluetooth Core Specification v5.3, Vol 3, Part G, 7.1.
+    Only the services overlapping the range are invalidated and discovered
+    again, all other services keep their state and details.
+ */
+void QLowEnergyControllerPrivateBluez::rediscoverServiceRange(QLowEnergyHandle start,
+                                                             QLowEnergyHandle end)
+{
+    if (start == 0 || start > end) {
+        qCWarning(QT_BT_BLUEZ) << "Ignoring invalid Service Changed range" << Qt::hex
+                               << start << end;
+        return;
+    }
+
+    if (state == QLowEnergyController::DiscoveringState || serviceRangeDiscovery) {
+        // the running discovery may have passed the range already
+        pendingRangeStart = pendingRangeEnd ? qMin(pendingRangeStart, start) : start;
+        pendingRangeEnd = qMax(pendingRangeEnd, end);
+        return;
+    }
+    if (state != QLowEnergyController::DiscoveredState)
+        return; // a later discoverServices() sees the changed database
+
+    qCDebug(QT_BT_BLUEZ) << "Services changed in handle range" << Qt::hex << start << end;
+
+    QList<QSharedPointer<QLowEnergyServicePrivate>> changedServices;
+    for (auto it = serviceList.begin(); it != serviceList.end();) {
+        if (it.value()->startHandle <= end && it.value()->endHandle >= start) {
+            changedServices.append(it.value());
+            it = serviceList.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // the handle index is rebuilt with the next lookup
+    indexedServiceList = nullptr;
+    for (const auto &service : qAsConst(changedServices)) {
+        cancelRequests(service.data());
+        service->setController(nullptr);
     }
+
+    serviceRangeDiscovery = true;
+    discoveryRangeStart = start;
+    discoveryRangeEnd = end;
+    sendReadByGroupRequest(start, end, GATT_PRIMARY_SERVICE);
 }
 
-void QLowEnergyControllerPrivateBluez::discoverServices()
+void QLowEnergyControllerPrivateBluez::startPendingRangeDiscovery()
 {
-    sendReadByGroupRequest(0x0001, 0xFFFF, GATT_PRIMARY_SERVICE);
+    if (!pendingRangeEnd)
+        return;
+
+    const QLowEnergyHandle start = std::exchange(pendingRangeStart, 0);
+    const QLowEnergyHandle end = std::exchange(pendingRangeEnd, 0);
+    rediscoverServiceRange(start, end);
+}
+
+void QLowEnergyControllerPrivateBluez::addDiscoveredService(const QBluetoothUuid &uuid,
+                                                            QLowEnergyHandle start,
+                                                            QLowEnergyHandle end, bool primary)
+{
+    Q_Q(QLowEnergyController);
+
+    qCDebug(QT_BT_BLUEZ) << "Found uuid:" << uuid << "start handle:" << Qt::hex
+             << start << "end handle:" << end;
+
+    QLowEnergyServicePrivate *priv = new QLowEnergyServicePrivate();
+    priv->uuid = uuid;
+    priv->startHandle = start;
+    priv->endHandle = end;
+    if (!primary) //unset PrimaryService bit
+        priv->type &= ~QLowEnergyService::PrimaryService;
+    priv->setController(this);
+
+    QSharedPointer<QLowEnergyServicePrivate> pointer(priv);
+
+    serviceList.insert(uuid, pointer);
+    // a service of the same UUID may have been replaced
+    indexedServiceList = nullptr;
+    emit q->serviceDiscovered(uuid);
 }
 
 void QLowEnergyControllerPrivateBluez::sendReadByGroupRequest(
         QLowEnergyHandle start, QLowEnergyHandle end, quint16 type)
 {
     //call for primary and secondary services
-    quint8 packet[GRP_TYPE_REQ_HEADER_SIZE];
-
-    packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_REQUEST);
-    putBtData(start, &packet[1]);
-    putBtData(end, &packet[3]);
-    putBtData(type, &packet[5]);
-
-    QByteArray data(GRP_TYPE_REQ_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet,  GRP_TYPE_REQ_HEADER_SIZE);
+    QByteArray data;
+    QBluezAtt::buildHandleRangeRequest(data, QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_REQUEST,
+                                       start, end, QBluetoothUuid(type));
     qCDebug(QT_BT_BLUEZ) << "Sending read_by_group_type request, startHandle:" << Qt::hex
              << start << "endHandle:" << end << type;
 
@@ -1511,7 +2977,31 @@ void QLowEnergyControllerPrivateBluez::sendReadByGroupRequest(
     request.payload = data;
     request.command = QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_REQUEST;
     request.reference = type;
-    openRequests.enqueue(request);
+    request.priority = RequestPriority::Discovery;
+    queueRequest(request);
+
+    sendNextPendingRequest();
+}
+
+void QLowEnergyControllerPrivateBluez::sendFindByTypeValueRequest(QLowEnergyHandle start,
+                                                                  qsizetype filterIndex)
+{
+    // primary services are grouped by their declaration whose value is the service UUID
+    char uuid[16];
+    const qsizetype uuidSize = QBluezAtt::putUuid(serviceDiscoveryFilter.at(filterIndex), uuid);
+
+    QByteArray data;
+    QBluezAtt::buildFindByTypeValueRequest(data, start, 0xFFFF, GATT_PRIMARY_SERVICE,
+                                           QByteArrayView(uuid, uuidSize));
+    qCDebug(QT_BT_BLUEZ) << "Sending find_by_type_value request, startHandle:" << Qt::hex
+             << start << "uuid:" << serviceDiscoveryFilter.at(filterIndex);
+
+    Request request;
+    request.payload = data;
+    request.command = QBluezConst::AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_REQUEST;
+    request.reference = filterIndex;
+    request.priority = RequestPriority::Discovery;
+    queueRequest(request);
 
     sendNextPendingRequest();
 }
@@ -1528,6 +3018,24 @@ void QLowEnergyControllerPrivateBluez::discoverServiceDetails(const QBluetoothUu
     QSharedPointer<QLowEnergyServicePrivate> serviceData = serviceList.value(service);
     serviceData->mode = mode;
     serviceData->characteristicList.clear();
+
+    const auto cacheIt = cachedServiceDetails.constFind(service);
+    if (cacheIt != cachedServiceDetails.constEnd()) {
+        qCDebug(QT_BT_BLUEZ) << "Restoring details of" << service.toString()
+                             << "from GATT cache";
+        serviceData->includedServices = cacheIt->includedServices;
+        for (const QBluetoothUuid &uuid : qAsConst(serviceData->includedServices)) {
+            if (serviceList.contains(uuid))
+                serviceList[uuid]->type |= QLowEnergyService::IncludedService;
+        }
+        serviceData->characteristicList = cacheIt->characteristicList;
+        if (serviceData->characteristicList.isEmpty())
+            serviceData->setState(QLowEnergyService::RemoteServiceDiscovered);
+        else
+            readServiceValues(service, true);
+        return;
+    }
+
     sendReadByTypeRequest(serviceData, serviceData->startHandle, GATT_INCLUDED_SERVICE);
 }
 
@@ -1535,15 +3043,10 @@ void QLowEnergyControllerPrivateBluez::sendReadByTypeRequest(
         QSharedPointer<QLowEnergyServicePrivate> serviceData,
         QLowEnergyHandle nextHandle, quint16 attributeType)
 {
-    quint8 packet[READ_BY_TYPE_REQ_HEADER_SIZE];
-
-    packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_REQUEST);
-    putBtData(nextHandle, &packet[1]);
-    putBtData(serviceData->endHandle, &packet[3]);
-    putBtData(attributeType, &packet[5]);
-
-    QByteArray data(READ_BY_TYPE_REQ_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet,  READ_BY_TYPE_REQ_HEADER_SIZE);
+    QByteArray data;
+    QBluezAtt::buildHandleRangeRequest(data, QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_REQUEST,
+                                       nextHandle, serviceData->endHandle,
+                                       QBluetoothUuid(attributeType));
     qCDebug(QT_BT_BLUEZ) << "Sending read_by_type request, startHandle:" << Qt::hex
              << nextHandle << "endHandle:" << serviceData->endHandle
              << "type:" << attributeType << "packet:" << data.toHex();
@@ -1553,7 +3056,9 @@ void QLowEnergyControllerPrivateBluez::sendReadByTypeRequest(
     request.command = QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_REQUEST;
     request.reference = QVariant::fromValue(serviceData);
     request.reference2 = attributeType;
-    openRequests.enqueue(request);
+    request.priority = RequestPriority::Discovery;
+    request.owner = serviceData.data();
+    queueRequest(request);
 
     sendNextPendingRequest();
 }
@@ -1570,7 +3075,6 @@ void QLowEnergyControllerPrivateBluez::sendReadByTypeRequest(
 void QLowEnergyControllerPrivateBluez::readServiceValues(
         const QBluetoothUuid &serviceUuid, bool readCharacteristics)
 {
-    quint8 packet[READ_REQUEST_HEADER_SIZE];
     if (QT_BT_BLUEZ().isDebugEnabled()) {
         if (readCharacteristics)
             qCDebug(QT_BT_BLUEZ) << "Reading all characteristic values for"
@@ -1582,12 +3086,17 @@ void QLowEnergyControllerPrivateBluez::readServiceValues(
 
     QSharedPointer<QLowEnergyServicePrivate> service = serviceList.value(serviceUuid);
 
-    if (service->mode == QLowEnergyService::SkipValueDiscovery) {
+    const bool incremental = service->mode == QLowEnergyService::IncrementalDiscovery;
+    if (service->mode == QLowEnergyService::SkipValueDiscovery
+            || (incremental && service->state != QLowEnergyService::RemoteServiceDiscovered)) {
         if (readCharacteristics) {
             // -> continue with descriptor discovery
             discoverServiceDescriptors(service->uuid);
         } else {
             service->setState(QLowEnergyService::RemoteServiceDiscovered);
+            // the values follow the requests the application queued on stateChanged()
+            if (incremental && service->state == QLowEnergyService::RemoteServiceDiscovered)
+                readServiceValues(service->uuid, true);
         }
         return;
     }
@@ -1610,12 +3119,21 @@ void QLowEnergyControllerPrivateBluez::readServiceValues(
             // Don't try to read writeOnly characteristic
             if (!(charDetails.properties & QLowEnergyCharacteristic::Read))
                 continue;
+            if (!service->isDiscoveryTarget(charDetails.uuid,
+                                            QLowEnergyService::CharacteristicValueDiscovery)) {
+                continue;
+            }
 
             pair.first = charDetails.valueHandle;
             pair.second  = charHandle;
             targetHandles.append(pair);
 
         } else {
+            if (!service->isDiscoveryTarget(charDetails.uuid,
+                                            QLowEnergyService::DescriptorValueDiscovery)) {
+                continue;
+            }
+
             // Collect handles of all descriptor attributes
             DescriptorDataMap::const_iterator descIt = charDetails.descriptorList.constBegin();
             for ( ; descIt != charDetails.descriptorList.constEnd(); ++descIt) {
@@ -1641,45 +3159,271 @@ void QLowEnergyControllerPrivateBluez::readServiceValues(
         return;
     }
 
-    for (qsizetype i = 0; i < targetHandles.size(); i++) {
-        pair = targetHandles.at(i);
-        packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_READ_REQUEST);
-        putBtData(pair.first, &packet[1]);
+    // Values which can be fetched via Read Multiple (Variable Length) requests.
+    // Plain Read Multiple requires the length of each value to be known upfront.
+    QList<QPair<QLowEnergyHandle, quint32> > batchedHandles;
+    QList<QPair<QLowEnergyHandle, quint32> > singleHandles;
+    for (const auto &target : qAsConst(targetHandles)) {
+        if (readMultipleVariableSupported
+                || (readMultipleSupported && fixedValueLength(service, target.second) >= 0)) {
+            batchedHandles.append(target);
+        } else {
+            singleHandles.append(target);
+        }
+    }
+    if (batchedHandles.size() < 2) {
+        singleHandles = targetHandles;
+        batchedHandles.clear();
+    }
+
+    QList<Request> requests;
+    const bool useVariableLength = readMultipleVariableSupported;
+    // Each value of a Read Multiple Variable Length response is preceded by its
+    // length. Limit the number of handles per request such that an average
+    // value is not truncated by the MTU.
+    const qsizetype maxPayload = qsizetype(connection->mtu) - 1;
+    const qsizetype maxHandles = std::clamp<qsizetype>(maxPayload / 10, 2,
+                                                       maxPayload / qsizetype(sizeof(QLowEnergyHandle)));
+    const QBluezConst::AttCommand command = useVariableLength
+            ? QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST
+            : QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_REQUEST;
+    QVarLengthArray<QLowEnergyHandle, 64> handles;
+    for (qsizetype i = 0; i < batchedHandles.size();) {
+        QList<uint> handleDataList;
+        handles.clear();
+        qsizetype expectedResponseSize = 0;
+        for (; i < batchedHandles.size() && handleDataList.size() < maxHandles; ++i) {
+            pair = batchedHandles.at(i);
+            if (!useVariableLength) {
+                const int length = fixedValueLength(service, pair.second);
+                if (!handleDataList.isEmpty() && expectedResponseSize + length > maxPayload)
+                    break;
+                expectedResponseSize += length;
+            }
+
+            handles.append(pair.first);
+            handleDataList.append(pair.second);
+        }
 
-        QByteArray data(READ_REQUEST_HEADER_SIZE, Qt::Uninitialized);
-        memcpy(data.data(), packet,  READ_REQUEST_HEADER_SIZE);
+        if (handleDataList.size() < 2) {
+            requests.append(createReadRequest(batchedHandles.at(i - 1).first,
+                                              batchedHandles.at(i - 1).second));
+            continue;
+        }
 
         Request request;
-        request.payload = data;
-        request.command = QBluezConst::AttCommand::ATT_OP_READ_REQUEST;
-        request.reference = pair.second;
+        QBluezAtt::buildHandleList(request.payload, command, handles.constData(), handles.size());
+        request.command = command;
+        request.reference = QVariant::fromValue(handleDataList);
+        requests.append(request);
+    }
+
+    for (const auto &target : qAsConst(singleHandles))
+        requests.append(createReadRequest(target.first, target.second));
+
+    for (qsizetype i = 0; i < requests.size(); i++) {
+        Request &request = requests[i];
+        request.valueDiscovery = true;
         // last entry?
-        request.reference2 = QVariant((bool)(i + 1 == targetHandles.size()));
-        openRequests.enqueue(request);
+        request.reference2 = QVariant((bool)(i + 1 == requests.size()));
+        request.priority = RequestPriority::Prefetch;
+        request.owner = service.data();
+        queueRequest(request);
     }
 
     sendNextPendingRequest();
 }
 
+/*!
+    \internal
+
+    Creates a read request for \a attributeHandle which is used during the
+    service discovery. \a handleData contains the characteristic handle and
+    optionally the descriptor handle in its upper 16 bits.
+ */
+QLowEnergyControllerPrivateBluez::Request QLowEnergyControllerPrivateBluez::createReadRequest(
+        QLowEnergyHandle attributeHandle, uint handleData, bool isLastValue) const
+{
+    QByteArray data;
+    QBluezAtt::buildHandleValue(data, QBluezConst::AttCommand::ATT_OP_READ_REQUEST,
+                                attributeHandle);
+
+    Request request;
+    request.payload = data;
+    request.command = QBluezConst::AttCommand::ATT_OP_READ_REQUEST;
+    request.reference = handleData;
+    request.reference2 = isLastValue;
+    return request;
+}
+
+/*!
+    \internal
+
+    Returns the fixed value length of the attribute referenced by \a handleData
+    or \c -1 if the attribute does not have a value length defined by the spec.
+    Only descriptors have such well known value lengths.
+ */
+int QLowEnergyControllerPrivateBluez::fixedValueLength(
+        const QSharedPointer<QLowEnergyServicePrivate> &service, uint handleData) const
+{
+    const QLowEnergyHandle charHandle = (handleData & 0xffff);
+    const QLowEnergyHandle descriptorHandle = ((handleData >> 16) & 0xffff);
+    if (!descriptorHandle)
+        return -1;
+
+    const auto charIt = service->characteristicList.constFind(charHandle);
+    if (charIt == service->characteristicList.constEnd())
+        return -1;
+    const auto descIt = charIt->descriptorList.constFind(descriptorHandle);
+    if (descIt == charIt->descriptorList.constEnd())
+        return -1;
+
+    // Spec v4.2, Vol. 3, Part G, 3.3.3.x
+    const QBluetoothUuid &type = descIt->uuid;
+    if (type == QBluetoothUuid::DescriptorType::CharacteristicExtendedProperties
+            || type == QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration
+            || type == QBluetoothUuid::DescriptorType::ServerCharacteristicConfiguration) {
+        return 2;
+    }
+    if (type == QBluetoothUuid::DescriptorType::CharacteristicPresentationFormat)
+        return 7;
+
+    return -1;
+}
+
+/*!
+    \internal
+
+    Processes the response to a Read Multiple or Read Multiple Variable Length
+    request sent by readServiceValues() or readCharacteristics(). Values which
+    were not (entirely) part of the response are fetched via individual read
+    requests. The same happens if the request failed, because a single
+    unreadable attribute causes the entire request to fail.
+ */
+void QLowEnergyControllerPrivateBluez::processReadMultipleReply(const Request &request,
+                                                                const QByteArray &response,
+                                                                bool isErrorResponse)
+{
+    const QList<uint> handleDataList = request.reference.value<QList<uint>>();
+    const bool isLastValue = request.reference2.toBool();
+    const bool isVariableLength = request.command
+            == QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST;
+    Q_ASSERT(!handleDataList.isEmpty());
+
+    QSharedPointer<QLowEnergyServicePrivate> service =
+            serviceForHandle(handleDataList.first() & 0xffff);
+    Q_ASSERT(!service.isNull());
+    const bool isServiceDiscoveryRun = request.valueDiscovery;
+
+    QList<uint> pendingReads;
+    if (isErrorResponse) {
+        QBluezAtt::ErrorResponse error;
+        QBluezAtt::parseErrorResponse(response, &error);
+        const QBluezConst::AttError err = error.code;
+        if (err == QBluezConst::AttError::ATT_ERROR_REQUEST_NOT_SUPPORTED
+                || err == QBluezConst::AttError::ATT_ERROR_INVALID_PDU
+                || err == QBluezConst::AttError::ATT_ERROR_REQUEST_STALLED) {
+            qCDebug(QT_BT_BLUEZ) << "Peer does not support" << request.command;
+            if (isVariableLength)
+                readMultipleVariableSupported = false;
+            else
+                readMultipleSupported = false;
+        }
+        pendingReads = handleDataList;
+    } else {
+        QByteArrayView values = QByteArrayView(response).sliced(QBluezAtt::OpcodeSize);
+        for (const uint handleData : handleDataList) {
+            // Values truncated due to the MTU are read again from the start.
+            // The read response handling switches to blob reads if required.
+            QByteArrayView valueView;
+            if (isVariableLength) {
+                quint16 length = 0;
+                if (!QBluezAtt::takeLengthValue(&values, &valueView, &length)
+                        || valueView.size() < length) {
+                    pendingReads.append(handleData);
+                    continue;
+                }
+            } else {
+                const qsizetype length = fixedValueLength(service, handleData);
+                Q_ASSERT(length >= 0);
+                if (!QBluezAtt::takeValue(&values, length, &valueView)) {
+                    pendingReads.append(handleData);
+                    continue;
+                }
+            }
+            const QByteArray value = valueView.toByteArray();
+
+            const QLowEnergyHandle charHandle = (handleData & 0xffff);
+            const QLowEnergyHandle descriptorHandle = ((handleData >> 16) & 0xffff);
+            if (!descriptorHandle)
+                updateValueOfCharacteristic(charHandle, value, NEW_VALUE);
+            else
+                updateValueOfDescriptor(charHandle, descriptorHandle, value, NEW_VALUE);
+
+            if (!isServiceDiscoveryRun) {
+                // readCharacteristics() ongoing
+                QLowEnergyCharacteristic ch(service, charHandle);
+                emit service->characteristicRead(ch, value);
+            }
+        }
+    }
+
+    if (!pendingReads.isEmpty()) {
+        qCDebug(QT_BT_BLUEZ) << "Read multiple did not return" << pendingReads.size()
+                             << "values, falling back to single reads";
+        // prepend in reverse order to keep the order of the reads
+        for (qsizetype i = pendingReads.size() - 1; i >= 0; --i) {
+            const uint handleData = pendingReads.at(i);
+            const QLowEnergyHandle charHandle = (handleData & 0xffff);
+            const QLowEnergyHandle descriptorHandle = ((handleData >> 16) & 0xffff);
+            const QLowEnergyHandle attributeHandle = descriptorHandle
+                    ? descriptorHandle : service->characteristicList[charHandle].valueHandle;
+            Request read = createReadRequest(attributeHandle, handleData,
+                                             isLastValue && i + 1 == pendingReads.size());
+            read.valueDiscovery = isServiceDiscoveryRun;
+            prependRequest(read);
+        }
+        return;
+    }
+
+    if (isLastValue && isServiceDiscoveryRun) {
+        //last characteristic -> progress to descriptor discovery
+        //last descriptor -> service discovery is done
+        if (!((handleDataList.first() >> 16) & 0xffff))
+            discoverServiceDescriptors(service->uuid);
+        else
+            service->setState(QLowEnergyService::RemoteServiceDiscovered);
+    }
+}
+
 /*!
     \internal
 
     This function is used when reading a handle value that is
-    longer than the mtuSize.
+    longer than the connection->mtu.
 
     The BLOB read request is prepended to the list of
     open requests to finish the current value read up before
     starting the next read request.
  */
 void QLowEnergyControllerPrivateBluez::readServiceValuesByOffset(
-        uint handleData, quint16 offset, bool isLastValue)
+        uint handleData, quint16 offset, bool isLastValue, bool valueDiscovery)
+{
+    Request request = createReadBlobRequest(handleData, offset, isLastValue);
+    request.valueDiscovery = valueDiscovery;
+    if (valueDiscovery)
+        request.priority = RequestPriority::Prefetch;
+    request.owner = serviceForHandle(handleData & 0xffff).data();
+    prependRequest(request);
+}
+
+QLowEnergyControllerPrivateBluez::Request
+QLowEnergyControllerPrivateBluez::createReadBlobRequest(uint handleData, quint16 offset,
+                                                        bool isLastValue)
 {
     const QLowEnergyHandle charHandle = (handleData & 0xffff);
     const QLowEnergyHandle descriptorHandle = ((handleData >> 16) & 0xffff);
 
-    QByteArray data(READ_BLOB_REQUEST_HEADER_SIZE, Qt::Uninitialized);
-    data[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_READ_BLOB_REQUEST);
-
     QLowEnergyHandle handleToRead = charHandle;
     if (descriptorHandle) {
         handleToRead = descriptorHandle;
@@ -1699,15 +3443,159 @@ void QLowEnergyControllerPrivateBluez::readServiceValuesByOffset(
         }
     }
 
-    putBtData(handleToRead, data.data() + 1);
-    putBtData(offset, data.data() + 3);
+    QByteArray data;
+    QBluezAtt::buildHandleOffsetValue(data, QBluezConst::AttCommand::ATT_OP_READ_BLOB_REQUEST,
+                                      handleToRead, offset);
 
     Request request;
     request.payload = data;
     request.command = QBluezConst::AttCommand::ATT_OP_READ_BLOB_REQUEST;
     request.reference = handleData;
     request.reference2 = isLastValue;
-    openRequests.prepend(request);
+    return request;
+}
+
+/*!
+    \internal
+
+    Continues the read of the long value identified by \a handleData, whose
+    first \a initialValue bytes were returned by a read request, with Read Blob
+    requests on the fixed ATT channel and all connected EATT bearers at once.
+    As ATT permits a single outstanding request per bearer, pipelining requires
+    EATT. Without connected bearers \c false is returned and the caller falls
+    back to sequential Read Blob requests.
+
+    This is only used for readCharacteristic() and readDescriptor(); reads that
+    are part of the service discovery rely on the order of the request queue.
+ */
+bool QLowEnergyControllerPrivateBluez::startLongRead(uint handleData,
+                                                     const QByteArray &initialValue)
+{
+    quint16 chunkSize = connection->mtu;
+    QList<EattBearer *> channels{ nullptr }; // nullptr is the fixed ATT channel
+    for (EattBearer *bearer : qAsConst(eattBearers)) {
+        if (!bearer->socket)
+            continue;
+        channels.append(bearer);
+        chunkSize = qMin(chunkSize, bearer->mtu);
+    }
+    if (channels.size() < 2 || longReads.contains(handleData))
+        return false;
+
+    LongRead &read = longReads[handleData];
+    read.value = initialValue;
+    // Spec v5.3, Vol 3, Part F, 3.2.9: attribute values are at most 512 bytes long.
+    // Detaches from initialValue, which the fragments must not be appended to anyway.
+    read.value.reserve(qMax<qsizetype>(512, initialValue.size() * 2));
+    // every response carries at least that many bytes unless the value ends
+    read.chunkSize = chunkSize - 1;
+    read.nextOffset = initialValue.size();
+
+    qCDebug(QT_BT_BLUEZ) << "Pipelining long read of" << Qt::hex << handleData << Qt::dec
+                         << "on" << channels.size() << "bearers";
+    for (EattBearer *bearer : qAsConst(channels))
+        sendLongReadRequest(handleData, read, bearer);
+    return true;
+}
+
+void QLowEnergyControllerPrivateBluez::sendLongReadRequest(uint handleData, LongRead &read,
+                                                           EattBearer *bearer)
+{
+    if (read.failed || read.nextOffset > 0xffff
+            || (read.endOffset >= 0 && read.nextOffset >= read.endOffset)) {
+        return;
+    }
+
+    const Request request = createReadBlobRequest(handleData, quint16(read.nextOffset), false);
+    read.nextOffset += read.chunkSize;
+    ++read.requestsInFlight;
+
+    // Queue it right behind the request in flight on that bearer, if any
+    QQueue<Request> &queue = bearer ? bearer->openRequests : openRequests;
+    const bool pending = bearer ? bearer->requestPending : requestPending;
+    queue.insert(pending && !queue.isEmpty() ? 1 : 0, request);
+    if (bearer)
+        sendNextEattRequest(bearer);
+    else
+        sendNextPendingRequest();
+}
+
+void QLowEnergyControllerPrivateBluez::processLongReadResponse(const Request &request,
+                                                               const QByteArray &response,
+                                                               bool isErrorResponse)
+{
+    const uint handleData = request.reference.toUInt();
+    LongRead &read = longReads[handleData];
+    --read.requestsInFlight;
+    const quint16 offset = bt_get_le16(request.payload.constData() + 3);
+
+    if (isErrorResponse) {
+        const auto error = static_cast<QBluezConst::AttError>(response.constData()[4]);
+        if (error == QBluezConst::AttError::ATT_ERROR_INVALID_OFFSET
+                || error == QBluezConst::AttError::ATT_ERROR_ATTRIBUTE_NOT_LONG) {
+            // a request beyond the end of the value
+            if (read.endOffset < 0 || offset < read.endOffset)
+                read.endOffset = offset;
+        } else if (read.endOffset < 0 || offset < read.endOffset) {
+            read.failed = true;
+        }
+    } else {
+        const QByteArray fragment = response.mid(1);
+        if (response.size() < attMtu())
+            read.endOffset = offset + fragment.size();
+        read.fragments.insert(offset, fragment);
+
+        // append everything that became contiguous
+        const qsizetype oldSize = read.value.size();
+        for (auto it = read.fragments.begin(); it != read.fragments.end()
+                     && it.key() <= read.value.size();
+             it = read.fragments.erase(it)) {
+            read.value.append(it.value().mid(read.value.size() - it.key()));
+        }
+        const QLowEnergyHandle charHandle = (handleData & 0xffff);
+        if (read.value.size() != oldSize && !(handleData >> 16)) {
+            QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
+            if (!service.isNull()) {
+                emit service->characteristicReadProgress(QLowEnergyCharacteristic(service,
+                                                                                  charHandle),
+                                                         read.value.size());
+            }
+        }
+    }
+
+    // keep this bearer busy with the next part of the value
+    sendLongReadRequest(handleData, read, activeBearer);
+
+    if (read.requestsInFlight == 0)
+        finishLongRead(handleData);
+}
+
+void QLowEnergyControllerPrivateBluez::finishLongRead(uint handleData)
+{
+    const LongRead read = longReads.take(handleData);
+    const QLowEnergyHandle charHandle = (handleData & 0xffff);
+    const QLowEnergyHandle descriptorHandle = ((handleData >> 16) & 0xffff);
+    QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
+    if (service.isNull())
+        return;
+
+    if (read.failed || read.value.size() != read.endOffset) {
+        qCWarning(QT_BT_BLUEZ) << "Pipelined long read of" << Qt::hex << charHandle
+                               << descriptorHandle << "failed";
+        service->setError(descriptorHandle ? QLowEnergyService::DescriptorReadError
+                                           : QLowEnergyService::CharacteristicReadError);
+        return;
+    }
+
+    if (!descriptorHandle) {
+        updateValueOfCharacteristic(charHandle, read.value, NEW_VALUE);
+        QLowEnergyCharacteristic ch(service, charHandle);
+        emit service->characteristicRead(ch, read.value);
+    } else {
+        updateValueOfDescriptor(charHandle, descriptorHandle, read.value, NEW_VALUE);
+        QLowEnergyDescriptor descriptor(service, charHandle, descriptorHandle);
+        emit service->descriptorRead(descriptor, read.value);
+    }
 }
 
 void QLowEnergyControllerPrivateBluez::discoverServiceDescriptors(
@@ -1723,6 +3611,15 @@ void QLowEnergyControllerPrivateBluez::discoverServiceDescriptors(
         return;
     }
 
+    if (cachedServiceDetails.contains(serviceUuid)
+            || (service->mode == QLowEnergyService::IncrementalDiscovery
+                && service->state == QLowEnergyService::RemoteServiceDiscovered)) {
+        // descriptors are known from the GATT cache or the incremental discovery
+        // -> continue with their values
+        readServiceValues(serviceUuid, false);
+        return;
+    }
+
     // start handle of all known characteristics
     QList<QLowEnergyHandle> keys = service->characteristicList.keys();
     std::sort(keys.begin(), keys.end());
@@ -1736,6 +3633,9 @@ void QLowEnergyControllerPrivateBluez::processUnsolicitedReply(const QByteArray
     bool isNotification = (static_cast<QBluezConst::AttCommand>(data[0])
                            == QBluezConst::AttCommand::ATT_OP_HANDLE_VAL_NOTIFICATION);
     const QLowEnergyHandle changedHandle = bt_get_le16(&data[1]);
+    Q_TRACE(QLowEnergyController_notificationReceived, quint8(data[0]), changedHandle,
+            int(payload.size()));
+    requestStatistics.recordNotification();
 
     if (QT_BT_BLUEZ().isDebugEnabled()) {
         if (isNotification)
@@ -1746,9 +3646,21 @@ void QLowEnergyControllerPrivateBluez::processUnsolicitedReply(const QByteArray
 
     const QLowEnergyCharacteristic ch = characteristicForHandle(changedHandle);
     if (ch.isValid() && ch.handle() == changedHandle) {
-        if (ch.properties() & QLowEnergyCharacteristic::Read)
-            updateValueOfCharacteristic(ch.attributeHandle(), payload.mid(3), NEW_VALUE);
-        emit ch.d_ptr->characteristicChanged(ch, payload.mid(3));
+        const bool serviceChanged =
+                ch.uuid() == QBluetoothUuid(QBluetoothUuid::CharacteristicType::ServiceChanged);
+        // a cache from an earlier connection may exist whatever the current policy is
+        if (serviceChanged) {
+            qCDebug(QT_BT_BLUEZ) << "Remote GATT database changed, dropping GATT cache";
+            removeGattCache();
+        }
+        // shared between the service data and the emitted signal
+        const QByteArray value = payload.mid(3);
+        updateValueOfChangedCharacteristic(ch, value);
+        ch.d_ptr->notifyCharacteristicChanged(ch, value);
+        // <start handle><end handle> of the affected attributes
+        if (serviceChanged && value.size() >= 4)
+            rediscoverServiceRange(bt_get_le16(value.constData()),
+                                   bt_get_le16(value.constData() + 2));
     } else {
         qCWarning(QT_BT_BLUEZ) << "Cannot find matching characteristic for "
                                   "notification/indication";
@@ -1759,24 +3671,28 @@ void QLowEnergyControllerPrivateBluez::exchangeMTU()
 {
     qCDebug(QT_BT_BLUEZ) << "Exchanging MTU";
 
-    quint8 packet[MTU_EXCHANGE_HEADER_SIZE];
-    packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST);
-    putBtData(ATT_MAX_LE_MTU, &packet[1]);
-
-    QByteArray data(MTU_EXCHANGE_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet, MTU_EXCHANGE_HEADER_SIZE);
+    QByteArray data;
+    QBluezAtt::buildMtu(data, QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST, localRxMtu());
 
     Request request;
     request.payload = data;
     request.command = QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST;
-    openRequests.enqueue(request);
+    request.priority = RequestPriority::Configuration;
+    queueRequest(request);
 
     sendNextPendingRequest();
 }
 
-int QLowEnergyControllerPrivateBluez::securityLevel() const
+/*!
+    \internal
+
+    Queries the security level of the link of \a l2capSocket. The ATT code
+    uses the level cached in connection->securityLevelValue instead, which is refreshed
+    on connection setup and on each encryption change of the link.
+ */
+int QLowEnergyControllerPrivateBluez::securityLevel(const QBluetoothSocket *l2capSocket) const
 {
-    int socket = l2cpSocket->socketDescriptor();
+    int socket = l2capSocket ? l2capSocket->socketDescriptor() : -1;
     if (socket < 0) {
         qCWarning(QT_BT_BLUEZ) << "Invalid l2cp socket, aborting getting of sec level";
         return -1;
@@ -1818,7 +3734,7 @@ bool QLowEnergyControllerPrivateBluez::setSecurityLevel(int level)
     if (level > BT_SECURITY_HIGH || level < BT_SECURITY_LOW)
         return false;
 
-    int socket = l2cpSocket->socketDescriptor();
+    int socket = connection->socket ? connection->socket->socketDescriptor() : -1;
     if (socket < 0) {
         qCWarning(QT_BT_BLUEZ) << "Invalid l2cp socket, aborting setting of sec level";
         return false;
@@ -1868,31 +3784,43 @@ void QLowEnergyControllerPrivateBluez::discoverNextDescriptor(
     Q_ASSERT(!pendingCharHandles.isEmpty());
     Q_ASSERT(!serviceData.isNull());
 
-    qCDebug(QT_BT_BLUEZ) << "Sending find_info request" << Qt::hex
-                         << pendingCharHandles << startingHandle;
+    // skip the characteristics whose descriptors were not asked for
+    QList<QLowEnergyHandle> pendingHandles = pendingCharHandles;
+    QLowEnergyHandle charStartHandle = startingHandle;
+    while (charStartHandle == pendingHandles.first()
+           && !serviceData->isDiscoveryTarget(
+                   serviceData->characteristicList.value(charStartHandle).uuid,
+                   QLowEnergyService::DescriptorDiscovery)) {
+        pendingHandles.removeFirst();
+        if (pendingHandles.isEmpty()) {
+            readServiceValues(serviceData->uuid, false);
+            return;
+        }
+        charStartHandle = pendingHandles.first();
+    }
 
-    quint8 packet[FIND_INFO_REQUEST_HEADER_SIZE];
-    packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_FIND_INFORMATION_REQUEST);
+    qCDebug(QT_BT_BLUEZ) << "Sending find_info request" << Qt::hex
+                         << pendingHandles << charStartHandle;
 
-    const QLowEnergyHandle charStartHandle = startingHandle;
     QLowEnergyHandle charEndHandle = 0;
-    if (pendingCharHandles.size() == 1) //single characteristic
+    if (pendingHandles.size() == 1) //single characteristic
         charEndHandle = serviceData->endHandle;
     else
-        charEndHandle = pendingCharHandles[1] - 1;
-
-    putBtData(charStartHandle, &packet[1]);
-    putBtData(charEndHandle, &packet[3]);
+        charEndHandle = pendingHandles[1] - 1;
 
-    QByteArray data(FIND_INFO_REQUEST_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet, FIND_INFO_REQUEST_HEADER_SIZE);
+    QByteArray data;
+    QBluezAtt::buildHandleRangeRequest(data,
+                                       QBluezConst::AttCommand::ATT_OP_FIND_INFORMATION_REQUEST,
+                                       charStartHandle, charEndHandle);
 
     Request request;
     request.payload = data;
     request.command = QBluezConst::AttCommand::ATT_OP_FIND_INFORMATION_REQUEST;
-    request.reference = QVariant::fromValue<QList<QLowEnergyHandle> >(pendingCharHandles);
-    request.reference2 = startingHandle;
-    openRequests.enqueue(request);
+    request.reference = QVariant::fromValue<QList<QLowEnergyHandle> >(pendingHandles);
+    request.reference2 = charStartHandle;
+    request.priority = RequestPriority::Discovery;
+    request.owner = serviceData.data();
+    queueRequest(request);
 
     sendNextPendingRequest();
 }
@@ -1915,33 +3843,23 @@ void QLowEnergyControllerPrivateBluez::sendNextPrepareWriteRequest(
         return;
     }
 
-    quint8 packet[PREPARE_WRITE_HEADER_SIZE];
-    packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_REQUEST);
-    putBtData(targetHandle, &packet[1]); // attribute handle
-    putBtData(offset, &packet[3]); // offset into newValue
-
     qCDebug(QT_BT_BLUEZ) << "Writing long characteristic (prepare):"
                          << Qt::hex << handle;
 
-
-    const qsizetype maxAvailablePayload = qsizetype(mtuSize) - PREPARE_WRITE_HEADER_SIZE;
-    const qsizetype requiredPayload = (std::min)(newValue.size() - offset, maxAvailablePayload);
-    const qsizetype dataSize = PREPARE_WRITE_HEADER_SIZE + requiredPayload;
-
+    // the value fragment is truncated to the MTU
+    QByteArray data;
+    QBluezAtt::buildHandleOffsetValue(data, QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_REQUEST,
+                                      targetHandle, offset, QByteArrayView(newValue).sliced(offset),
+                                      connection->mtu);
+    const qsizetype requiredPayload = data.size() - PREPARE_WRITE_HEADER_SIZE;
     Q_ASSERT((offset + requiredPayload) <= newValue.size());
-    Q_ASSERT(dataSize <= mtuSize);
-
-    QByteArray data(dataSize, Qt::Uninitialized);
-    memcpy(data.data(), packet, PREPARE_WRITE_HEADER_SIZE);
-    memcpy(&(data.data()[PREPARE_WRITE_HEADER_SIZE]), &(newValue.constData()[offset]),
-                                               requiredPayload);
 
     Request request;
-    request.payload = data;
+    request.payload = std::move(data);
     request.command = QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_REQUEST;
     request.reference = (handle | ((offset + requiredPayload) << 16));
     request.reference2 = newValue;
-    openRequests.enqueue(request);
+    queueRequest(std::move(request));
 }
 
 /*!
@@ -1956,15 +3874,9 @@ void QLowEnergyControllerPrivateBluez::sendExecuteWriteRequest(
         const QLowEnergyHandle attrHandle, const QByteArray &newValue,
         bool isCancelation)
 {
-    quint8 packet[EXECUTE_WRITE_HEADER_SIZE];
-    packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST);
-    if (isCancelation)
-        packet[1] = 0x00; // cancel pending write prepare requests
-    else
-        packet[1] = 0x01; // execute pending write prepare requests
-
-    QByteArray data(EXECUTE_WRITE_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet, EXECUTE_WRITE_HEADER_SIZE);
+    // cancels or executes the pending write prepare requests
+    QByteArray data;
+    QBluezAtt::buildExecuteWriteRequest(data, !isCancelation);
 
     qCDebug(QT_BT_BLUEZ) << "Sending Execute Write Request for long characteristic value"
                          << Qt::hex << attrHandle;
@@ -1974,15 +3886,120 @@ void QLowEnergyControllerPrivateBluez::sendExecuteWriteRequest(
     request.command = QBluezConst::AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST;
     request.reference  = (attrHandle | ((isCancelation ? 0x00 : 0x01) << 16));
     request.reference2 = newValue;
+    traceRequestQueued(request.payload);
+    openRequests.prepend(request);
+}
+
+/*!
+    \internal
+
+    Queues the prepare write requests for all \a newValues followed by the
+    execute request as one contiguous block. Long writes add their prepare
+    requests one at a time, keeping the block together ensures that no other
+    prepared value is committed by this transaction's execute request.
+ */
+void QLowEnergyControllerPrivateBluez::writeCharacteristicsReliably(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QList<QLowEnergyHandle> &charHandles,
+        const QList<QByteArray> &newValues)
+{
+    Q_ASSERT(!service.isNull());
+    Q_ASSERT(charHandles.size() == newValues.size());
+
+    // zero marks requests which do not belong to a reliable write
+    if (++lastReliableWriteId == 0)
+        ++lastReliableWriteId;
+    const quint32 id = lastReliableWriteId;
+
+    const qsizetype maxAvailablePayload = qsizetype(connection->mtu) - PREPARE_WRITE_HEADER_SIZE;
+    for (qsizetype i = 0; i < charHandles.size(); ++i) {
+        const QLowEnergyHandle valueHandle =
+                service->characteristicList.value(charHandles.at(i)).valueHandle;
+        const QByteArray &newValue = newValues.at(i);
+
+        // an empty value still needs one request
+        qsizetype offset = 0;
+        do {
+            const qsizetype requiredPayload =
+                    (std::min)(newValue.size() - offset, maxAvailablePayload);
+            QByteArray data;
+            QBluezAtt::buildHandleOffsetValue(
+                    data, QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_REQUEST, valueHandle,
+                    quint16(offset), QByteArrayView(newValue).sliced(offset, requiredPayload));
+
+            Request request;
+            request.payload = std::move(data);
+            request.command = QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_REQUEST;
+            request.reliableWriteId = id;
+            queueRequest(std::move(request));
+            offset += requiredPayload;
+        } while (offset < newValue.size());
+    }
+
+    qCDebug(QT_BT_BLUEZ) << "Queued reliable write of" << charHandles.size()
+                         << "characteristics";
+
+    Request request;
+    QBluezAtt::buildExecuteWriteRequest(request.payload, true);
+    request.command = QBluezConst::AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST;
+    request.reliableWriteId = id;
+    queueRequest(std::move(request));
+
+    reliableWrites.insert(id, ReliableWrite{ service, charHandles, newValues });
+
+    sendNextPendingRequest();
+}
+
+/*!
+    \internal
+
+    Drops the remaining requests of the reliable write \a id and clears
+    the prepare queue on the server before anything else is sent.
+ */
+void QLowEnergyControllerPrivateBluez::cancelReliableWrite(quint32 id)
+{
+    openRequests.removeIf([id](const Request &request) {
+        return request.reliableWriteId == id;
+    });
+
+    Request request;
+    QBluezAtt::buildExecuteWriteRequest(request.payload, false);
+    request.command = QBluezConst::AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST;
+    request.reliableWriteId = id;
+    traceRequestQueued(request.payload);
     openRequests.prepend(request);
 }
 
+void QLowEnergyControllerPrivateBluez::finishReliableWrite(const Request &request,
+                                                           bool isErrorResponse)
+{
+    const ReliableWrite transaction = reliableWrites.take(request.reliableWriteId);
+    if (transaction.service.isNull())
+        return;
+
+    const bool wasCancellation = request.payload.at(1) == 0x00;
+    if (isErrorResponse || wasCancellation) {
+        transaction.service->setError(QLowEnergyService::CharacteristicWriteError);
+        return;
+    }
+
+    for (qsizetype i = 0; i < transaction.charHandles.size(); ++i) {
+        const QLowEnergyHandle charHandle = transaction.charHandles.at(i);
+        const QByteArray &newValue = transaction.values.at(i);
+        QLowEnergyCharacteristic ch(transaction.service, charHandle);
+        if (ch.properties() & QLowEnergyCharacteristic::Read)
+            updateValueOfCharacteristic(charHandle, newValue, NEW_VALUE);
+        emit transaction.service->characteristicWritten(ch, newValue);
+    }
+}
+
 
 /*!
     Writes long (prepare write request), short (write request)
     and writeWithoutResponse characteristic values.
 
-    TODO Reliable/prepare write across multiple characteristics is not supported
+    Reliable writes across multiple characteristics are handled by
+    writeCharacteristicsReliably().
  */
 void QLowEnergyControllerPrivateBluez::writeCharacteristic(
         const QSharedPointer<QLowEnergyServicePrivate> service,
@@ -2013,7 +4030,7 @@ void QLowEnergyControllerPrivateBluez::writeDescriptor(
     if (role == QLowEnergyController::PeripheralRole)
         writeDescriptorForPeripheral(service, charHandle, descriptorHandle, newValue);
     else
-        writeDescriptorForCentral(charHandle, descriptorHandle, newValue);
+        writeDescriptorForCentral(service, charHandle, descriptorHandle, newValue);
 }
 
 /*!
@@ -2038,25 +4055,79 @@ void QLowEnergyControllerPrivateBluez::readCharacteristic(
         qCWarning(QT_BT_BLUEZ) << "Reading non-readable char" << charHandle;
     }
 
-    quint8 packet[READ_REQUEST_HEADER_SIZE];
-    packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_READ_REQUEST);
-    putBtData(charDetails.valueHandle, &packet[1]);
+    QByteArray data;
+    QBluezAtt::buildHandleValue(data, QBluezConst::AttCommand::ATT_OP_READ_REQUEST,
+                                charDetails.valueHandle);
+
+    qCDebug(QT_BT_BLUEZ) << "Targeted reading characteristic" << Qt::hex << charHandle;
+
+    Request request;
+    request.payload = data;
+    request.command = QBluezConst::AttCommand::ATT_OP_READ_REQUEST;
+    request.reference = charHandle;
+    // reference2 not really required but false prevents service discovery
+    // code from running in QBluezConst::AttCommand::ATT_OP_READ_RESPONSE handler
+    request.reference2 = false;
+    enqueueRequest(service, request);
+}
+
+/*!
+    \internal
+
+    Reads several characteristic values using Read Multiple Variable Length
+    requests. Plain Read Multiple requests are not an option because the
+    length of a characteristic value is not known upfront. The replies are
+    processed by processReadMultipleReply(), which falls back to individual
+    reads for values that were not returned.
+ */
+void QLowEnergyControllerPrivateBluez::readCharacteristics(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QList<QLowEnergyHandle> &charHandles)
+{
+    Q_ASSERT(!service.isNull());
+    if (!readMultipleVariableSupported || charHandles.size() < 2) {
+        QLowEnergyControllerPrivate::readCharacteristics(service, charHandles);
+        return;
+    }
+
+    // see readServiceValues()
+    const qsizetype maxPayload = qsizetype(connection->mtu) - 1;
+    const qsizetype maxHandles = std::clamp<qsizetype>(maxPayload / 10, 2,
+                                                       maxPayload / qsizetype(sizeof(QLowEnergyHandle)));
+    for (qsizetype i = 0; i < charHandles.size();) {
+        const qsizetype count = std::min(maxHandles, charHandles.size() - i);
+        if (count < 2) {
+            readCharacteristic(service, charHandles.at(i++));
+            continue;
+        }
 
-    QByteArray data(READ_REQUEST_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet,  READ_REQUEST_HEADER_SIZE);
+        QVarLengthArray<QLowEnergyHandle, 64> valueHandles;
+        QList<uint> handleDataList;
+        handleDataList.reserve(count);
+        for (const qsizetype end = i + count; i < end; ++i) {
+            const auto charIt = service->characteristicList.constFind(charHandles.at(i));
+            if (charIt == service->characteristicList.constEnd())
+                continue;
 
-    qCDebug(QT_BT_BLUEZ) << "Targeted reading characteristic" << Qt::hex << charHandle;
+            valueHandles.append(charIt->valueHandle);
+            handleDataList.append(charIt.key());
+        }
+        if (handleDataList.isEmpty())
+            continue;
 
-    Request request;
-    request.payload = data;
-    request.command = QBluezConst::AttCommand::ATT_OP_READ_REQUEST;
-    request.reference = charHandle;
-    // reference2 not really required but false prevents service discovery
-    // code from running in QBluezConst::AttCommand::ATT_OP_READ_RESPONSE handler
-    request.reference2 = false;
-    openRequests.enqueue(request);
+        qCDebug(QT_BT_BLUEZ) << "Targeted reading of" << handleDataList.size()
+                             << "characteristics";
 
-    sendNextPendingRequest();
+        Request request;
+        QBluezAtt::buildHandleList(request.payload,
+                                   QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST,
+                                   valueHandles.constData(), valueHandles.size());
+        request.command = QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST;
+        request.reference = QVariant::fromValue(handleDataList);
+        // false prevents the service discovery code from running, see readCharacteristic()
+        request.reference2 = false;
+        enqueueRequest(service, request);
+    }
 }
 
 void QLowEnergyControllerPrivateBluez::readDescriptor(
@@ -2073,12 +4144,9 @@ void QLowEnergyControllerPrivateBluez::readDescriptor(
     if (!charDetails.descriptorList.contains(descriptorHandle))
         return;
 
-    quint8 packet[READ_REQUEST_HEADER_SIZE];
-    packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_READ_REQUEST);
-    putBtData(descriptorHandle, &packet[1]);
-
-    QByteArray data(READ_REQUEST_HEADER_SIZE, Qt::Uninitialized);
-    memcpy(data.data(), packet,  READ_REQUEST_HEADER_SIZE);
+    QByteArray data;
+    QBluezAtt::buildHandleValue(data, QBluezConst::AttCommand::ATT_OP_READ_REQUEST,
+                                descriptorHandle);
 
     qCDebug(QT_BT_BLUEZ) << "Targeted reading descriptor" << Qt::hex << descriptorHandle;
 
@@ -2089,9 +4157,7 @@ void QLowEnergyControllerPrivateBluez::readDescriptor(
     // reference2 not really required but false prevents service discovery
     // code from running in QBluezConst::AttCommand::ATT_OP_READ_RESPONSE handler
     request.reference2 = false;
-    openRequests.enqueue(request);
-
-    sendNextPendingRequest();
+    enqueueRequest(service, request);
 }
 
 /*!
@@ -2101,7 +4167,7 @@ void QLowEnergyControllerPrivateBluez::readDescriptor(
 bool QLowEnergyControllerPrivateBluez::increaseEncryptLevelfRequired(
         QBluezConst::AttError errorCode)
 {
-    if (securityLevelValue == BT_SECURITY_HIGH)
+    if (connection->securityLevelValue == BT_SECURITY_HIGH)
         return false;
 
     switch (errorCode) {
@@ -2112,7 +4178,7 @@ bool QLowEnergyControllerPrivateBluez::increaseEncryptLevelfRequired(
             return false;
         if (!hciManager->monitorEvent(HciManager::HciEvent::EVT_ENCRYPT_CHANGE))
             return false;
-        if (securityLevelValue != BT_SECURITY_HIGH) {
+        if (connection->securityLevelValue != BT_SECURITY_HIGH) {
             qCDebug(QT_BT_BLUEZ) << "Requesting encrypted link";
             if (setSecurityLevel(BT_SECURITY_HIGH)) {
                 restartRequestTimer();
@@ -2175,43 +4241,56 @@ void QLowEnergyControllerPrivateBluez::handleExchangeMtuRequest(const QByteArray
 
     if (!checkPacketSize(packet, 3))
         return;
-    if (receivedMtuExchangeRequest) { // Client must only send this once per connection.
+    if (connection->receivedMtuExchangeRequest) { // Client must only send this once per connection.
         qCDebug(QT_BT_BLUEZ) << "Client sent extraneous MTU exchange packet";
         sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), 0,
                           QBluezConst::AttError::ATT_ERROR_REQUEST_NOT_SUPPORTED);
         return;
     }
-    receivedMtuExchangeRequest = true;
+    connection->receivedMtuExchangeRequest = true;
 
     // Send reply.
-    QByteArray reply(MTU_EXCHANGE_HEADER_SIZE, Qt::Uninitialized);
-    reply[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_RESPONSE);
-    putBtData(ATT_MAX_LE_MTU, reply.data() + 1);
+    QByteArray reply;
+    QBluezAtt::buildMtu(reply, QBluezConst::AttCommand::ATT_OP_EXCHANGE_MTU_RESPONSE, localRxMtu());
     sendPacket(reply);
 
     // Apply requested MTU.
-    const quint16 clientRxMtu = bt_get_le16(packet.constData() + 1);
-    mtuSize = std::clamp(clientRxMtu, ATT_DEFAULT_LE_MTU, ATT_MAX_LE_MTU);
+    quint16 clientRxMtu = ATT_DEFAULT_LE_MTU;
+    QBluezAtt::parseMtu(packet, &clientRxMtu);
+    connection->mtu = std::clamp(clientRxMtu, ATT_DEFAULT_LE_MTU, localRxMtu());
     qCDebug(QT_BT_BLUEZ) << "MTU request from client:" << clientRxMtu
-                         << "effective client RX MTU:" << mtuSize;
-    qCDebug(QT_BT_BLUEZ) << "Sending server RX MTU" << ATT_MAX_LE_MTU;
+                         << "effective client RX MTU:" << connection->mtu;
+    qCDebug(QT_BT_BLUEZ) << "Sending server RX MTU" << localRxMtu();
+}
+
+/*
+ * The ATT MTU offered to the remote device, see QLowEnergyController::setPreferredMtu().
+ */
+quint16 QLowEnergyControllerPrivateBluez::localRxMtu() const
+{
+    return preferredMtu > 0 ? quint16(preferredMtu) : ATT_MAX_LE_MTU;
 }
 
 void QLowEnergyControllerPrivateBluez::handleFindInformationRequest(const QByteArray &packet)
 {
     // Spec v4.2, Vol 3, Part F, 3.4.3.1-2
 
-    if (!checkPacketSize(packet, 5))
+    QBluezAtt::HandleRangeRequest range;
+    if (!checkPacketSize(packet, 5) || !QBluezAtt::parseHandleRangeRequest(packet, &range))
         return;
-    const QLowEnergyHandle startingHandle = bt_get_le16(packet.constData() + 1);
-    const QLowEnergyHandle endingHandle = bt_get_le16(packet.constData() + 3);
+    const QLowEnergyHandle startingHandle = range.startingHandle;
+    const QLowEnergyHandle endingHandle = range.endingHandle;
     qCDebug(QT_BT_BLUEZ) << "client sends find information request; start:" << startingHandle
                          << "end:" << endingHandle;
+    if (sendCachedDiscoveryResponse(packet))
+        return;
     if (!checkHandlePair(static_cast<QBluezConst::AttCommand>(packet.at(0)), startingHandle,
                          endingHandle))
         return;
 
-    QList<Attribute> results = getAttributes(startingHandle, endingHandle);
+    // <opcode><format>[<handle><16 bit uuid>]+
+    const qsizetype maxResults = (connection->mtu - 2) / 4;
+    AttributeList results = getAttributes(startingHandle, endingHandle, maxResults);
     if (results.isEmpty()) {
         sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), startingHandle,
                           QBluezConst::AttError::ATT_ERROR_ATTRIBUTE_NOT_FOUND);
@@ -2219,30 +4298,30 @@ void QLowEnergyControllerPrivateBluez::handleFindInformationRequest(const QByteA
     }
     ensureUniformUuidSizes(results);
 
-    QByteArray responsePrefix(2, Qt::Uninitialized);
-    const int uuidSize = getUuidSize(results.first().type);
-    responsePrefix[0] =
-            static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_FIND_INFORMATION_RESPONSE);
-    responsePrefix[1] = uuidSize == 2 ? 0x1 : 0x2;
-    const int elementSize = sizeof(QLowEnergyHandle) + uuidSize;
+    const int elementSize = sizeof(QLowEnergyHandle) + getUuidSize(results.first()->type);
     const auto elemWriter = [](const Attribute &attr, char *&data) {
         putDataAndIncrement(attr.handle, data);
         putDataAndIncrement(attr.type, data);
     };
-    sendListResponse(responsePrefix, elementSize, results, elemWriter);
-
+    const QByteArray response = sendListResponse(
+            QBluezConst::AttCommand::ATT_OP_FIND_INFORMATION_RESPONSE, elementSize, results,
+            elemWriter);
+    cacheDiscoveryResponse(packet, response);
 }
 
 void QLowEnergyControllerPrivateBluez::handleFindByTypeValueRequest(const QByteArray &packet)
 {
     // Spec v4.2, Vol 3, Part F, 3.4.3.3-4
 
-    if (!checkPacketSize(packet, 7, mtuSize))
+    QBluezAtt::HandleRangeRequest range;
+    if (!checkPacketSize(packet, 7, connection->mtu)
+            || !QBluezAtt::parseHandleRangeRequest(packet, &range)) {
         return;
-    const QLowEnergyHandle startingHandle = bt_get_le16(packet.constData() + 1);
-    const QLowEnergyHandle endingHandle = bt_get_le16(packet.constData() + 3);
-    const quint16 type = bt_get_le16(packet.constData() + 5);
-    const QByteArray value = QByteArray::fromRawData(packet.constData() + 7, packet.size() - 7);
+    }
+    const QLowEnergyHandle startingHandle = range.startingHandle;
+    const QLowEnergyHandle endingHandle = range.endingHandle;
+    const quint16 type = bt_get_le16(range.tail.data());
+    const QByteArray value = QByteArray::fromRawData(range.tail.data() + 2, range.tail.size() - 2);
     qCDebug(QT_BT_BLUEZ) << "client sends find by type value request; start:" << startingHandle
                          << "end:" << endingHandle << "type:" << type
                          << "value:" << value.toHex();
@@ -2250,25 +4329,27 @@ void QLowEnergyControllerPrivateBluez::handleFindByTypeValueRequest(const QByteA
                          endingHandle))
         return;
 
-    const auto predicate = [value, this, type](const Attribute &attr) {
-        return attr.type == QBluetoothUuid(type) && attr.value == value
+    const auto predicate = [&value, this](const Attribute &attr) {
+        return attr.value == value
                 && checkReadPermissions(attr) == QBluezConst::AttError::ATT_ERROR_NO_ERROR;
     };
-    const QList<Attribute> results = getAttributes(startingHandle, endingHandle, predicate);
+    // <opcode>[<handle><group end handle>]+
+    const qsizetype maxResults = (connection->mtu - 1) / 4;
+    const AttributeList results = getAttributesOfType(startingHandle, endingHandle, maxResults,
+                                                      QBluetoothUuid(type), predicate);
     if (results.isEmpty()) {
         sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), startingHandle,
                           QBluezConst::AttError::ATT_ERROR_ATTRIBUTE_NOT_FOUND);
         return;
     }
 
-    QByteArray responsePrefix(
-            1, static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_RESPONSE));
     const int elemSize = 2 * sizeof(QLowEnergyHandle);
     const auto elemWriter = [](const Attribute &attr, char *&data) {
         putDataAndIncrement(attr.handle, data);
         putDataAndIncrement(attr.groupEndHandle, data);
     };
-    sendListResponse(responsePrefix, elemSize, results, elemWriter);
+    sendListResponse(QBluezConst::AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_RESPONSE, elemSize,
+                     results, elemWriter);
 }
 
 void QLowEnergyControllerPrivateBluez::handleReadByTypeRequest(const QByteArray &packet)
@@ -2277,32 +4358,31 @@ void QLowEnergyControllerPrivateBluez::handleReadByTypeRequest(const QByteArray
 
     if (!checkPacketSize(packet, 7, 21))
         return;
-    const QLowEnergyHandle startingHandle = bt_get_le16(packet.constData() + 1);
-    const QLowEnergyHandle endingHandle = bt_get_le16(packet.constData() + 3);
-    const void * const typeStart = packet.constData() + 5;
-    const bool is16BitUuid = packet.size() == 7;
-    const bool is128BitUuid = packet.size() == 21;
-    QBluetoothUuid type;
-    if (is16BitUuid) {
-        type = QBluetoothUuid(bt_get_le16(typeStart));
-    } else if (is128BitUuid) {
-        type = QBluetoothUuid(convert_uuid128(reinterpret_cast<const quint128 *>(typeStart)));
-    } else {
+    QBluezAtt::HandleRangeRequest range;
+    if (!QBluezAtt::parseHandleRangeRequest(packet, &range)) {
         qCWarning(QT_BT_BLUEZ) << "read by type request has invalid packet size" << packet.size();
         sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), 0,
                           QBluezConst::AttError::ATT_ERROR_INVALID_PDU);
         return;
     }
+    const QLowEnergyHandle startingHandle = range.startingHandle;
+    const QLowEnergyHandle endingHandle = range.endingHandle;
+    const QBluetoothUuid type = QBluezAtt::uuidFromData(range.tail);
     qCDebug(QT_BT_BLUEZ) << "client sends read by type request, start:" << startingHandle
                          << "end:" << endingHandle << "type:" << type;
+    // only declarations are static, characteristic values may change at any time
+    const bool isDeclaration = type == QBluetoothUuid(GATT_CHARACTERISTIC)
+            || type == QBluetoothUuid(GATT_INCLUDED_SERVICE);
+    if (isDeclaration && sendCachedDiscoveryResponse(packet))
+        return;
     if (!checkHandlePair(static_cast<QBluezConst::AttCommand>(packet.at(0)), startingHandle,
                          endingHandle))
         return;
 
-    // Get all attributes with matching type.
-    QList<Attribute> results =
-            getAttributes(startingHandle, endingHandle,
-                          [type](const Attribute &attr) { return attr.type == type; });
+    // Get all attributes with matching type which may fit into the response.
+    // <opcode><length>[<handle><value>]+
+    const qsizetype maxResults = (connection->mtu - 2) / 2;
+    AttributeList results = getAttributesOfType(startingHandle, endingHandle, maxResults, type);
     ensureUniformValueSizes(results);
 
     if (results.isEmpty()) {
@@ -2314,28 +4394,30 @@ void QLowEnergyControllerPrivateBluez::handleReadByTypeRequest(const QByteArray
     const QBluezConst::AttError error = checkReadPermissions(results);
     if (error != QBluezConst::AttError::ATT_ERROR_NO_ERROR) {
         sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)),
-                          results.first().handle, error);
+                          results.first()->handle, error);
         return;
     }
 
-    const qsizetype elementSize = sizeof(QLowEnergyHandle) + results.first().value.size();
-    QByteArray responsePrefix(2, Qt::Uninitialized);
-    responsePrefix[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_RESPONSE);
-    responsePrefix[1] = elementSize;
+    const qsizetype elementSize = sizeof(QLowEnergyHandle) + results.first()->value.size();
     const auto elemWriter = [](const Attribute &attr, char *&data) {
         putDataAndIncrement(attr.handle, data);
         putDataAndIncrement(attr.value, data);
     };
-    sendListResponse(responsePrefix, elementSize, results, elemWriter);
+    const QByteArray response = sendListResponse(
+            QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_RESPONSE, elementSize, results,
+            elemWriter);
+    if (isDeclaration)
+        cacheDiscoveryResponse(packet, response);
 }
 
 void QLowEnergyControllerPrivateBluez::handleReadRequest(const QByteArray &packet)
 {
     // Spec v4.2, Vol 3, Part F, 3.4.4.3-4
 
-    if (!checkPacketSize(packet, 3))
+    QBluezAtt::HandleValue request;
+    if (!checkPacketSize(packet, 3) || !QBluezAtt::parseHandleValue(packet, &request))
         return;
-    const QLowEnergyHandle handle = bt_get_le16(packet.constData() + 1);
+    const QLowEnergyHandle handle = request.handle;
     qCDebug(QT_BT_BLUEZ) << "client sends read request; handle:" << handle;
 
     if (!checkHandle(packet, handle))
@@ -2348,11 +4430,9 @@ void QLowEnergyControllerPrivateBluez::handleReadRequest(const QByteArray &packe
         return;
     }
 
-    const qsizetype sentValueLength = (std::min)(attribute.value.size(), qsizetype(mtuSize) - 1);
-    QByteArray response(1 + sentValueLength, Qt::Uninitialized);
-    response[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_READ_RESPONSE);
-    using namespace std;
-    memcpy(response.data() + 1, attribute.value.constData(), sentValueLength);
+    QByteArray response;
+    QBluezAtt::buildValue(response, QBluezConst::AttCommand::ATT_OP_READ_RESPONSE,
+                          attribute.value, connection->mtu);
     qCDebug(QT_BT_BLUEZ) << "sending response:" << response.toHex();
     sendPacket(response);
 }
@@ -2361,10 +4441,11 @@ void QLowEnergyControllerPrivateBluez::handleReadBlobRequest(const QByteArray &p
 {
     // Spec v4.2, Vol 3, Part F, 3.4.4.5-6
 
-    if (!checkPacketSize(packet, 5))
+    QBluezAtt::HandleValue request;
+    if (!checkPacketSize(packet, 5) || !QBluezAtt::parseHandleValue(packet, &request))
         return;
-    const QLowEnergyHandle handle = bt_get_le16(packet.constData() + 1);
-    const quint16 valueOffset = bt_get_le16(packet.constData() + 3);
+    const QLowEnergyHandle handle = request.handle;
+    const quint16 valueOffset = request.offset;
     qCDebug(QT_BT_BLUEZ) << "client sends read blob request; handle:" << handle
                          << "offset:" << valueOffset;
 
@@ -2382,20 +4463,16 @@ void QLowEnergyControllerPrivateBluez::handleReadBlobRequest(const QByteArray &p
                           QBluezConst::AttError::ATT_ERROR_INVALID_OFFSET);
         return;
     }
-    if (attribute.value.size() <= mtuSize - 3) {
+    if (attribute.value.size() <= connection->mtu - 3) {
         sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), handle,
                           QBluezConst::AttError::ATT_ERROR_ATTRIBUTE_NOT_LONG);
         return;
     }
 
-    // Yes, this value can be zero.
-    const qsizetype sentValueLength = (std::min)(attribute.value.size() - valueOffset,
-                                                 qsizetype(mtuSize) - 1);
-
-    QByteArray response(1 + sentValueLength, Qt::Uninitialized);
-    response[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_READ_BLOB_RESPONSE);
-    using namespace std;
-    memcpy(response.data() + 1, attribute.value.constData() + valueOffset, sentValueLength);
+    // Yes, the sent value length can be zero.
+    QByteArray response;
+    QBluezAtt::buildValue(response, QBluezConst::AttCommand::ATT_OP_READ_BLOB_RESPONSE,
+                          QByteArrayView(attribute.value).sliced(valueOffset), connection->mtu);
     qCDebug(QT_BT_BLUEZ) << "sending response:" << response.toHex();
     sendPacket(response);
 }
@@ -2404,25 +4481,24 @@ void QLowEnergyControllerPrivateBluez::handleReadMultipleRequest(const QByteArra
 {
     // Spec v4.2, Vol 3, Part F, 3.4.4.7-8
 
-    if (!checkPacketSize(packet, 5, mtuSize))
+    if (!checkPacketSize(packet, 5, connection->mtu))
         return;
-    QList<QLowEnergyHandle> handles((packet.size() - 1) / sizeof(QLowEnergyHandle));
-    auto *packetPtr = reinterpret_cast<const QLowEnergyHandle *>(packet.constData() + 1);
-    for (qsizetype i = 0; i < handles.size(); ++i, ++packetPtr)
-        handles[i] = bt_get_le16(packetPtr);
+    QList<QLowEnergyHandle> handles(QBluezAtt::handleCount(packet));
+    for (qsizetype i = 0; i < handles.size(); ++i)
+        handles[i] = QBluezAtt::handleAt(packet, i);
     qCDebug(QT_BT_BLUEZ) << "client sends read multiple request for handles" << handles;
 
     const auto it = std::find_if(handles.constBegin(), handles.constEnd(),
-            [this](QLowEnergyHandle handle) { return handle >= lastLocalHandle; });
+            [this](QLowEnergyHandle handle) { return handle == 0 || handle > lastLocalHandle; });
     if (it != handles.constEnd()) {
         sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), *it,
                           QBluezConst::AttError::ATT_ERROR_INVALID_HANDLE);
         return;
     }
-    const QList<Attribute> results = getAttributes(handles.first(), handles.last());
-    QByteArray response(
-            1, static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_RESPONSE));
-    for (const Attribute &attr : results) {
+    QByteArray response;
+    QBluezAtt::buildOpcode(response, QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_RESPONSE);
+    for (const QLowEnergyHandle handle : qAsConst(handles)) {
+        const Attribute &attr = localAttributes.at(handle);
         const QBluezConst::AttError error = checkReadPermissions(attr);
         if (error != QBluezConst::AttError::ATT_ERROR_NO_ERROR) {
             sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), attr.handle,
@@ -2432,7 +4508,43 @@ void QLowEnergyControllerPrivateBluez::handleReadMultipleRequest(const QByteArra
 
         // Note: We do not abort if no more values fit into the packet, because we still have to
         //       report possible permission errors for the other handles.
-        response += attr.value.left(mtuSize - response.size());
+        QBluezAtt::appendValue(response, attr.value, connection->mtu);
+    }
+
+    qCDebug(QT_BT_BLUEZ) << "sending response:" << response.toHex();
+    sendPacket(response);
+}
+
+void QLowEnergyControllerPrivateBluez::handleReadMultipleVariableRequest(const QByteArray &packet)
+{
+    // Spec v5.2, Vol 3, Part F, 3.4.4.11-12
+
+    if (!checkPacketSize(packet, 5, connection->mtu))
+        return;
+    QList<QLowEnergyHandle> handles(QBluezAtt::handleCount(packet));
+    for (qsizetype i = 0; i < handles.size(); ++i)
+        handles[i] = QBluezAtt::handleAt(packet, i);
+    qCDebug(QT_BT_BLUEZ) << "client sends read multiple variable request for handles" << handles;
+
+    QByteArray response;
+    QBluezAtt::buildOpcode(response,
+                           QBluezConst::AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_RESPONSE);
+    for (const QLowEnergyHandle handle : qAsConst(handles)) {
+        if (handle == 0 || handle > lastLocalHandle) {
+            sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), handle,
+                              QBluezConst::AttError::ATT_ERROR_INVALID_HANDLE);
+            return;
+        }
+        const Attribute &attr = localAttributes.at(handle);
+        const QBluezConst::AttError error = checkReadPermissions(attr);
+        if (error != QBluezConst::AttError::ATT_ERROR_NO_ERROR) {
+            sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), handle, error);
+            return;
+        }
+
+        // Note: We do not abort if no more values fit into the packet, because we still have to
+        //       report possible permission errors for the other handles.
+        QBluezAtt::appendLengthValue(response, attr.value, connection->mtu);
     }
 
     qCDebug(QT_BT_BLUEZ) << "sending response:" << response.toHex();
@@ -2445,25 +4557,21 @@ void QLowEnergyControllerPrivateBluez::handleReadByGroupTypeRequest(const QByteA
 
     if (!checkPacketSize(packet, 7, 21))
         return;
-    const QLowEnergyHandle startingHandle = bt_get_le16(packet.constData() + 1);
-    const QLowEnergyHandle endingHandle = bt_get_le16(packet.constData() + 3);
-    const bool is16BitUuid = packet.size() == 7;
-    const bool is128BitUuid = packet.size() == 21;
-    const void * const typeStart = packet.constData() + 5;
-    QBluetoothUuid type;
-    if (is16BitUuid) {
-        type = QBluetoothUuid(bt_get_le16(typeStart));
-    } else if (is128BitUuid) {
-        type = QBluetoothUuid(convert_uuid128(reinterpret_cast<const quint128 *>(typeStart)));
-    } else {
+    QBluezAtt::HandleRangeRequest range;
+    if (!QBluezAtt::parseHandleRangeRequest(packet, &range)) {
         qCWarning(QT_BT_BLUEZ) << "read by group type request has invalid packet size"
                                << packet.size();
         sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), 0,
                           QBluezConst::AttError::ATT_ERROR_INVALID_PDU);
         return;
     }
+    const QLowEnergyHandle startingHandle = range.startingHandle;
+    const QLowEnergyHandle endingHandle = range.endingHandle;
+    const QBluetoothUuid type = QBluezAtt::uuidFromData(range.tail);
     qCDebug(QT_BT_BLUEZ) << "client sends read by group type request, start:" << startingHandle
                          << "end:" << endingHandle << "type:" << type;
+    if (sendCachedDiscoveryResponse(packet))
+        return;
 
     if (!checkHandlePair(static_cast<QBluezConst::AttCommand>(packet.at(0)), startingHandle,
                          endingHandle))
@@ -2475,9 +4583,9 @@ void QLowEnergyControllerPrivateBluez::handleReadByGroupTypeRequest(const QByteA
         return;
     }
 
-    QList<Attribute> results =
-            getAttributes(startingHandle, endingHandle,
-                          [type](const Attribute &attr) { return attr.type == type; });
+    // <opcode><length>[<handle><group end handle><value>]+
+    const qsizetype maxResults = (connection->mtu - 2) / 4;
+    AttributeList results = getAttributesOfType(startingHandle, endingHandle, maxResults, type);
     if (results.isEmpty()) {
         sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), startingHandle,
                           QBluezConst::AttError::ATT_ERROR_ATTRIBUTE_NOT_FOUND);
@@ -2486,22 +4594,21 @@ void QLowEnergyControllerPrivateBluez::handleReadByGroupTypeRequest(const QByteA
     const QBluezConst::AttError error = checkReadPermissions(results);
     if (error != QBluezConst::AttError::ATT_ERROR_NO_ERROR) {
         sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)),
-                          results.first().handle, error);
+                          results.first()->handle, error);
         return;
     }
 
     ensureUniformValueSizes(results);
 
-    const qsizetype elementSize = 2 * sizeof(QLowEnergyHandle) + results.first().value.size();
-    QByteArray responsePrefix(2, Qt::Uninitialized);
-    responsePrefix[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_RESPONSE);
-    responsePrefix[1] = elementSize;
+    const qsizetype elementSize = 2 * sizeof(QLowEnergyHandle) + results.first()->value.size();
     const auto elemWriter = [](const Attribute &attr, char *&data) {
         putDataAndIncrement(attr.handle, data);
         putDataAndIncrement(attr.groupEndHandle, data);
         putDataAndIncrement(attr.value, data);
     };
-    sendListResponse(responsePrefix, elementSize, results, elemWriter);
+    cacheDiscoveryResponse(packet,
+                           sendListResponse(QBluezConst::AttCommand::ATT_OP_READ_BY_GROUP_RESPONSE,
+                                            elementSize, results, elemWriter));
 }
 
 void QLowEnergyControllerPrivateBluez::updateLocalAttributeValue(
@@ -2552,46 +4659,130 @@ void QLowEnergyControllerPrivateBluez::writeCharacteristicForPeripheral(
     }
     attribute.value = newValue;
     charData.value = newValue;
+    notifyPeripheralClients(charData, attribute);
+}
+
+/*!
+    \internal
+
+    Stores \a value in the local database like writeCharacteristicForPeripheral(),
+    but copies it into the buffer the attribute already owns. The characteristic
+    shares that buffer, so that the value is not copied again. Once the value has
+    reached its final length, publishing it neither allocates nor detaches unless
+    the application still holds the previous value.
+ */
+void QLowEnergyControllerPrivateBluez::publishCharacteristicValue(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QLowEnergyHandle charHandle,
+        QByteArrayView value)
+{
+    Q_ASSERT(!service.isNull());
+
+    if (role != QLowEnergyController::PeripheralRole) {
+        QLowEnergyControllerPrivate::publishCharacteristicValue(service, charHandle, value);
+        return;
+    }
+
+    const auto charIt = service->characteristicList.find(charHandle);
+    if (charIt == service->characteristicList.end())
+        return;
+
+    QLowEnergyServicePrivate::CharData &charData = charIt.value();
+    const QLowEnergyHandle valueHandle = charData.valueHandle;
+    Q_ASSERT(valueHandle <= lastLocalHandle);
+    Attribute &attribute = localAttributes[valueHandle];
+    if (value.size() < attribute.minLength || value.size() > attribute.maxLength) {
+        qCWarning(QT_BT_BLUEZ) << "ignoring value of invalid length" << value.size()
+                               << "for attribute" << valueHandle;
+        return;
+    }
+
+    // drop the characteristic's reference first, the attribute's buffer is not shared then
+    charData.value = QByteArray();
+    attribute.value.resize(value.size());
+    if (!value.isEmpty())
+        memcpy(attribute.value.data(), value.data(), value.size());
+    charData.value = attribute.value;
+    notifyPeripheralClients(charData, attribute);
+}
+
+/*!
+    \internal
+
+    Notifies or indicates the new value of \a charData, which is stored in
+    \a attribute, to the connected clients which subscribed to it and marks it
+    as updated for the bonded clients which are not connected.
+ */
+void QLowEnergyControllerPrivateBluez::notifyPeripheralClients(
+        const QLowEnergyServicePrivate::CharData &charData, const Attribute &attribute)
+{
+    const QLowEnergyHandle valueHandle = charData.valueHandle;
     const bool hasNotifyProperty = attribute.properties & QLowEnergyCharacteristic::Notify;
     const bool hasIndicateProperty
             = attribute.properties & QLowEnergyCharacteristic::Indicate;
     if (!hasNotifyProperty && !hasIndicateProperty)
         return;
-    for (const QLowEnergyServicePrivate::DescData &desc : qAsConst(charData.descriptorList)) {
-        if (desc.uuid != QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration)
-            continue;
+    QLowEnergyHandle configHandle = 0;
+    for (auto it = charData.descriptorList.cbegin(); it != charData.descriptorList.cend(); ++it) {
+        if (it.value().uuid == QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration) {
+            configHandle = it.key();
+            break;
+        }
+    }
+    if (!configHandle)
+        return;
 
-        // Notify/indicate currently connected client.
-        const bool isConnected = state == QLowEnergyController::ConnectedState;
-        if (isConnected) {
-            Q_ASSERT(desc.value.size() == 2);
-            quint16 configValue = bt_get_le16(desc.value.constData());
-            if (isNotificationEnabled(configValue) && hasNotifyProperty) {
-                sendNotification(valueHandle);
-            } else if (isIndicationEnabled(configValue) && hasIndicateProperty) {
-                if (indicationInFlight)
-                    scheduledIndications << valueHandle;
-                else
-                    sendIndication(valueHandle);
-            }
+    // Notify/indicate currently connected clients.
+    const bool isConnected = state == QLowEnergyController::ConnectedState;
+    if (isConnected) {
+        Connection *const current = connection;
+        connection = &mainConnection;
+        notifyPeripheralClient(valueHandle, configHandle, hasNotifyProperty, hasIndicateProperty);
+        for (Connection *client : std::as_const(peripheralClients)) {
+            connection = client;
+            notifyPeripheralClient(valueHandle, configHandle, hasNotifyProperty,
+                                   hasIndicateProperty);
         }
+        connection = current;
+    }
 
-        // Prepare notification/indication of unconnected, bonded clients.
-        for (auto it = clientConfigData.begin(); it != clientConfigData.end(); ++it) {
-            if (isConnected && it.key() == remoteDevice.toUInt64())
+    // Prepare notification/indication of unconnected, bonded clients.
+    for (auto it = clientConfigData.begin(); it != clientConfigData.end(); ++it) {
+        if (isConnected && isConnectedPeripheralClient(it.key()))
+            continue;
+        QList<ClientConfigurationData> &configDataList = it.value();
+        for (ClientConfigurationData &configData : configDataList) {
+            if (configData.charValueHandle != valueHandle)
                 continue;
-            QList<ClientConfigurationData> &configDataList = it.value();
-            for (ClientConfigurationData &configData : configDataList) {
-                if (configData.charValueHandle != valueHandle)
-                    continue;
-                if ((isNotificationEnabled(configData.configValue) && hasNotifyProperty)
-                        || (isIndicationEnabled(configData.configValue) && hasIndicateProperty)) {
-                    configData.charValueWasUpdated = true;
-                    break;
-                }
+            if ((isNotificationEnabled(configData.configValue) && hasNotifyProperty)
+                    || (isIndicationEnabled(configData.configValue) && hasIndicateProperty)) {
+                configData.charValueWasUpdated = true;
+                break;
             }
         }
-        break;
+    }
+}
+
+/*!
+    \internal
+
+    Sends a notification or indication for \a valueHandle on the current
+    connection, depending on its client characteristic configuration stored at
+    \a configHandle.
+ */
+void QLowEnergyControllerPrivateBluez::notifyPeripheralClient(QLowEnergyHandle valueHandle,
+                                                             QLowEnergyHandle configHandle,
+                                                             bool hasNotifyProperty,
+                                                             bool hasIndicateProperty)
+{
+    const quint16 configValue = clientConfiguration(configHandle);
+    if (isNotificationEnabled(configValue) && hasNotifyProperty) {
+        sendNotification(valueHandle);
+    } else if (isIndicationEnabled(configValue) && hasIndicateProperty) {
+        if (connection->indicationInFlight)
+            scheduleIndication(valueHandle);
+        else
+            sendIndication(valueHandle);
     }
 }
 
@@ -2601,32 +4792,33 @@ void QLowEnergyControllerPrivateBluez::writeCharacteristicForCentral(const QShar
         const QByteArray &newValue,
         QLowEnergyService::WriteMode mode)
 {
-    QByteArray packet(WRITE_REQUEST_HEADER_SIZE + newValue.size(), Qt::Uninitialized);
-    putBtData(valueHandle, packet.data() + 1);
-    memcpy(packet.data() + 3, newValue.constData(), newValue.size());
+    QByteArray packet;
     bool writeWithResponse = false;
     switch (mode) {
     case QLowEnergyService::WriteWithResponse:
-        if (newValue.size() > (mtuSize - WRITE_REQUEST_HEADER_SIZE)) {
+        if (newValue.size() > (connection->mtu - WRITE_REQUEST_HEADER_SIZE)) {
             sendNextPrepareWriteRequest(charHandle, newValue, 0);
             sendNextPendingRequest();
             return;
         }
         // write value fits into single package
-        packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_WRITE_REQUEST);
+        QBluezAtt::buildHandleValue(packet, QBluezConst::AttCommand::ATT_OP_WRITE_REQUEST,
+                                    valueHandle, newValue);
         writeWithResponse = true;
         break;
     case QLowEnergyService::WriteWithoutResponse:
-        packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_WRITE_COMMAND);
+        QBluezAtt::buildHandleValue(packet, QBluezConst::AttCommand::ATT_OP_WRITE_COMMAND,
+                                    valueHandle, newValue);
         break;
     case QLowEnergyService::WriteSigned:
-        packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_SIGNED_WRITE_COMMAND);
+        QBluezAtt::buildHandleValue(packet, QBluezConst::AttCommand::ATT_OP_SIGNED_WRITE_COMMAND,
+                                    valueHandle, newValue);
         if (!isBonded()) {
             qCWarning(QT_BT_BLUEZ) << "signed write not possible: requires bond between devices";
             service->setError(QLowEnergyService::CharacteristicWriteError);
             return;
         }
-        if (securityLevel() >= BT_SECURITY_MEDIUM) {
+        if (connection->securityLevelValue >= BT_SECURITY_MEDIUM) {
             qCWarning(QT_BT_BLUEZ) << "signed write not possible: not allowed on encrypted link";
             service->setError(QLowEnergyService::CharacteristicWriteError);
             return;
@@ -2637,12 +4829,12 @@ void QLowEnergyControllerPrivateBluez::writeCharacteristicForCentral(const QShar
             service->setError(QLowEnergyService::CharacteristicWriteError);
             return;
         }
-        ++signingDataIt.value().counter;
-        packet = LeCmacCalculator::createFullMessage(packet, signingDataIt.value().counter);
-        const quint64 mac = LeCmacCalculator().calculateMac(packet, signingDataIt.value().key);
-        packet.resize(packet.size() + sizeof mac);
-        putBtData(mac, packet.data() + packet.size() - sizeof mac);
-        storeSignCounter(LocalSigningKey);
+        const quint32 signCounter = reserveSignCounter(signingDataIt.value());
+        if (!cmacCalculator)
+            cmacCalculator = new LeCmacCalculator;
+        const quint64 mac = cmacCalculator->calculateMac(packet, signCounter,
+                                                         signingDataIt.value().key);
+        QBluezAtt::appendSignature(packet, signCounter, mac);
         break;
     }
 
@@ -2651,22 +4843,23 @@ void QLowEnergyControllerPrivateBluez::writeCharacteristicForCentral(const QShar
                          << (mode == QLowEnergyService::WriteWithResponse)
                          << "signed:" << (mode == QLowEnergyService::WriteSigned) << ")";
 
+    Request request;
+    request.command = static_cast<QBluezConst::AttCommand>(packet.at(0));
+    request.payload = std::move(packet);
+    request.reference = charHandle;
+
     // Advantage of write without response is the quick turnaround.
-    // It can be sent at any time and does not produce responses.
-    // Therefore we will not put them into the openRequest queue at all.
+    // It does not produce responses and therefore never occupies the single
+    // request slot. It is queued nevertheless to keep the order in relation to
+    // earlier requests and to be able to wait for socket buffer space.
     if (!writeWithResponse) {
-        sendPacket(packet);
+        queueRequest(std::move(request));
+        sendNextPendingRequest();
         return;
     }
 
-    Request request;
-    request.payload = packet;
-    request.command = QBluezConst::AttCommand::ATT_OP_WRITE_REQUEST;
-    request.reference = charHandle;
     request.reference2 = newValue;
-    openRequests.enqueue(request);
-
-    sendNextPendingRequest();
+    enqueueRequest(service, std::move(request));
 }
 
 void QLowEnergyControllerPrivateBluez::writeDescriptorForPeripheral(
@@ -2687,36 +4880,35 @@ void QLowEnergyControllerPrivateBluez::writeDescriptorForPeripheral(
 }
 
 void QLowEnergyControllerPrivateBluez::writeDescriptorForCentral(
+        const QSharedPointer<QLowEnergyServicePrivate> &service,
         const QLowEnergyHandle charHandle,
         const QLowEnergyHandle descriptorHandle,
         const QByteArray &newValue)
 {
-    if (newValue.size() > (mtuSize - WRITE_REQUEST_HEADER_SIZE)) {
+    if (newValue.size() > (connection->mtu - WRITE_REQUEST_HEADER_SIZE)) {
         sendNextPrepareWriteRequest(descriptorHandle, newValue, 0);
         sendNextPendingRequest();
         return;
     }
 
-    quint8 packet[WRITE_REQUEST_HEADER_SIZE];
-    packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_WRITE_REQUEST);
-    putBtData(descriptorHandle, &packet[1]);
-
-    const qsizetype size = WRITE_REQUEST_HEADER_SIZE + newValue.size();
-    QByteArray data(size, Qt::Uninitialized);
-    memcpy(data.data(), packet, WRITE_REQUEST_HEADER_SIZE);
-    memcpy(&(data.data()[WRITE_REQUEST_HEADER_SIZE]), newValue.constData(), newValue.size());
+    QByteArray data;
+    QBluezAtt::buildHandleValue(data, QBluezConst::AttCommand::ATT_OP_WRITE_REQUEST,
+                                descriptorHandle, newValue);
+    const qsizetype size = data.size();
 
     qCDebug(QT_BT_BLUEZ) << "Writing descriptor" << Qt::hex << descriptorHandle
                          << "(size:" << size << ")";
 
     Request request;
-    request.payload = data;
+    request.payload = std::move(data);
     request.command = QBluezConst::AttCommand::ATT_OP_WRITE_REQUEST;
     request.reference = (charHandle | (descriptorHandle << 16));
     request.reference2 = newValue;
-    openRequests.enqueue(request);
-
-    sendNextPendingRequest();
+    if (service->characteristicList[charHandle].descriptorList[descriptorHandle].uuid
+            == QBluetoothUuid(QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration)) {
+        request.priority = RequestPriority::Configuration;
+    }
+    enqueueRequest(service, std::move(request));
 }
 
 void QLowEnergyControllerPrivateBluez::handleWriteRequestOrCommand(const QByteArray &packet)
@@ -2727,9 +4919,19 @@ void QLowEnergyControllerPrivateBluez::handleWriteRequestOrCommand(const QByteAr
             == QBluezConst::AttCommand::ATT_OP_WRITE_REQUEST;
     const bool isSigned = static_cast<QBluezConst::AttCommand>(packet.at(0))
             == QBluezConst::AttCommand::ATT_OP_SIGNED_WRITE_COMMAND;
-    if (!checkPacketSize(packet, isSigned ? 15 : 3, mtuSize))
+    if (!checkPacketSize(packet, isSigned ? 15 : 3, connection->mtu))
         return;
-    const QLowEnergyHandle handle = bt_get_le16(packet.constData() + 1);
+    // a write without signature leaves the sign counter and the MAC empty
+    QBluezAtt::SignedWrite write;
+    if (isSigned) {
+        QBluezAtt::parseSignedWrite(packet, &write);
+    } else {
+        QBluezAtt::HandleValue request;
+        QBluezAtt::parseHandleValue(packet, &request);
+        write.handle = request.handle;
+        write.value = request.value;
+    }
+    const QLowEnergyHandle handle = write.handle;
     qCDebug(QT_BT_BLUEZ) << "client sends" << (isSigned ? "signed" : "") << "write"
                          << (isRequest ? "request" : "command") << "for handle" << handle;
 
@@ -2747,23 +4949,22 @@ void QLowEnergyControllerPrivateBluez::handleWriteRequestOrCommand(const QByteAr
         return;
     }
 
-    int valueLength;
     if (isSigned) {
         if (!isBonded()) {
             qCWarning(QT_BT_BLUEZ) << "Ignoring signed write from non-bonded device.";
             return;
         }
-        if (securityLevel() >= BT_SECURITY_MEDIUM) {
+        if (connection->securityLevelValue >= BT_SECURITY_MEDIUM) {
             qCWarning(QT_BT_BLUEZ) << "Ignoring signed write on encrypted link.";
             return;
         }
-        const auto signingDataIt = signingData.find(remoteDevice.toUInt64());
+        const auto signingDataIt = signingData.find(peerAddress().toUInt64());
         if (signingDataIt == signingData.constEnd()) {
             qCWarning(QT_BT_BLUEZ) << "No CSRK found for peer device, ignoring signed write";
             return;
         }
 
-        const quint32 signCounter = getBtData<quint32>(packet.data() + packet.size() - 12);
+        const quint32 signCounter = write.signCounter;
         if (signCounter < signingDataIt.value().counter + 1) {
             qCWarning(QT_BT_BLUEZ) << "Client's' sign counter" << signCounter
                                    << "not greater than local sign counter"
@@ -2772,9 +4973,8 @@ void QLowEnergyControllerPrivateBluez::handleWriteRequestOrCommand(const QByteAr
             return;
         }
 
-        const quint64 macFromClient = getBtData<quint64>(packet.data() + packet.size() - 8);
-        const bool signatureCorrect = verifyMac(packet.left(packet.size() - 12),
-                signingDataIt.value().key, signCounter, macFromClient);
+        const bool signatureCorrect = verifyMac(write.signedData, signingDataIt.value().key,
+                                                signCounter, write.mac);
         if (!signatureCorrect) {
             qCWarning(QT_BT_BLUEZ) << "Signed Write packet has wrong signature, disconnecting";
             disconnectFromDevice(); // Recommended by spec v4.2, Vol 3, part C, 10.4.2
@@ -2783,11 +4983,10 @@ void QLowEnergyControllerPrivateBluez::handleWriteRequestOrCommand(const QByteAr
 
         signingDataIt.value().counter = signCounter;
         storeSignCounter(RemoteSigningKey);
-        valueLength = packet.size() - 15;
-    } else {
-        valueLength = packet.size() - 3;
     }
 
+    const qsizetype valueLength = write.value.size();
+
     if (valueLength > attribute.maxLength) {
         sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), handle,
                           QBluezConst::AttError::ATT_ERROR_INVAL_ATTR_VALUE_LEN);
@@ -2796,7 +4995,7 @@ void QLowEnergyControllerPrivateBluez::handleWriteRequestOrCommand(const QByteAr
 
     // If the attribute value has a fixed size and the value in the packet is shorter,
     // then we overwrite only the start of the attribute value and keep the rest.
-    QByteArray value = packet.mid(3, valueLength);
+    QByteArray value = write.value.toByteArray();
     if (attribute.minLength == attribute.maxLength && valueLength < attribute.minLength)
         value += attribute.value.mid(valueLength, attribute.maxLength - valueLength);
 
@@ -2805,13 +5004,13 @@ void QLowEnergyControllerPrivateBluez::handleWriteRequestOrCommand(const QByteAr
     updateLocalAttributeValue(handle, value, characteristic, descriptor);
 
     if (isRequest) {
-        const QByteArray response =
-                QByteArray(1, static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_WRITE_RESPONSE));
+        QByteArray response;
+        QBluezAtt::buildOpcode(response, QBluezConst::AttCommand::ATT_OP_WRITE_RESPONSE);
         sendPacket(response);
     }
 
     if (characteristic.isValid()) {
-        emit characteristic.d_ptr->characteristicChanged(characteristic, value);
+        characteristic.d_ptr->notifyCharacteristicChanged(characteristic, value);
     } else {
         Q_ASSERT(descriptor.isValid());
         emit descriptor.d_ptr->descriptorWritten(descriptor, value);
@@ -2822,9 +5021,11 @@ void QLowEnergyControllerPrivateBluez::handlePrepareWriteRequest(const QByteArra
 {
     // Spec v4.2, Vol 3, Part F, 3.4.6.1
 
-    if (!checkPacketSize(packet, 5, mtuSize))
+    if (!checkPacketSize(packet, 5, connection->mtu))
         return;
-    const quint16 handle = bt_get_le16(packet.constData() + 1);
+    QBluezAtt::HandleValue request;
+    QBluezAtt::parseHandleValue(packet, &request);
+    const quint16 handle = request.handle;
     qCDebug(QT_BT_BLUEZ) << "client sends prepare write request for handle" << handle;
 
     if (!checkHandle(packet, handle))
@@ -2837,18 +5038,45 @@ void QLowEnergyControllerPrivateBluez::handlePrepareWriteRequest(const QByteArra
                           permissionsError);
         return;
     }
-    if (openPrepareWriteRequests.size() >= maxPrepareQueueSize) {
+    if (connection->preparedWriteFragments >= maxPrepareQueueSize) {
         sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)), handle,
                           QBluezConst::AttError::ATT_ERROR_PREPARE_QUEUE_FULL);
         return;
     }
 
-    // The value is not checked here, but on the Execute request.
-    openPrepareWriteRequests << WriteRequest(handle, bt_get_le16(packet.constData() + 3),
-                                                    packet.mid(5));
+    QList<PreparedWrite> &prepareWrites = connection->openPrepareWriteRequests;
+    auto it = std::find_if(prepareWrites.begin(), prepareWrites.end(),
+                           [handle](const PreparedWrite &write) {
+                               return write.handle == handle;
+                           });
+    if (it == prepareWrites.end()) {
+        // Reserve the complete value up front, attribute values cannot exceed 512 bytes.
+        constexpr qsizetype maxAttributeValueLength = 512;
+        const qsizetype capacity = (std::min)(qsizetype(attribute.maxLength),
+                                              maxAttributeValueLength);
+        prepareWrites.append(PreparedWrite(handle, attribute.value, capacity));
+        it = std::prev(prepareWrites.end());
+    }
+    ++connection->preparedWriteFragments;
+
+    // Offset and length are validated right away, but errors must only be
+    // reported in response to the Execute request.
+    if (it->error == QBluezConst::AttError::ATT_ERROR_NO_ERROR) {
+        if (request.offset > it->value.size()) {
+            it->error = QBluezConst::AttError::ATT_ERROR_INVALID_OFFSET;
+        } else if (request.offset + request.value.size() > attribute.maxLength) {
+            it->error = QBluezConst::AttError::ATT_ERROR_INVAL_ATTR_VALUE_LEN;
+        } else {
+            it->value.resize(request.offset);
+            it->value.append(request.value);
+        }
+    }
 
-    QByteArray response = packet;
-    response[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_RESPONSE);
+    // the response echoes the request
+    QByteArray response;
+    QBluezAtt::buildHandleOffsetValue(response,
+                                      QBluezConst::AttCommand::ATT_OP_PREPARE_WRITE_RESPONSE,
+                                      handle, request.offset, request.value);
     sendPacket(response);
 }
 
@@ -2858,34 +5086,26 @@ void QLowEnergyControllerPrivateBluez::handleExecuteWriteRequest(const QByteArra
 
     if (!checkPacketSize(packet, 2))
         return;
-    const bool cancel = packet.at(1) == 0;
+    bool execute = false;
+    QBluezAtt::parseExecuteWriteRequest(packet, &execute);
+    const bool cancel = !execute;
     qCDebug(QT_BT_BLUEZ) << "client sends execute write request; flag is"
                          << (cancel ? "cancel" : "flush");
 
-    QList<WriteRequest> requests = openPrepareWriteRequests;
-    openPrepareWriteRequests.clear();
+    const QList<PreparedWrite> requests = std::exchange(connection->openPrepareWriteRequests, {});
+    connection->preparedWriteFragments = 0;
     QList<QLowEnergyCharacteristic> characteristics;
     QList<QLowEnergyDescriptor> descriptors;
     if (!cancel) {
-        for (const WriteRequest &request : qAsConst(requests)) {
-            Attribute &attribute = localAttributes[request.handle];
-            if (request.valueOffset > attribute.value.size()) {
-                sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)),
-                                  request.handle, QBluezConst::AttError::ATT_ERROR_INVALID_OFFSET);
-                return;
-            }
-            const QByteArray newValue = attribute.value.left(request.valueOffset) + request.value;
-            if (newValue.size() > attribute.maxLength) {
+        for (const PreparedWrite &request : requests) {
+            if (request.error != QBluezConst::AttError::ATT_ERROR_NO_ERROR) {
                 sendErrorResponse(static_cast<QBluezConst::AttCommand>(packet.at(0)),
-                                  request.handle,
-                                  QBluezConst::AttError::ATT_ERROR_INVAL_ATTR_VALUE_LEN);
+                                  request.handle, request.error);
                 return;
             }
             QLowEnergyCharacteristic characteristic;
             QLowEnergyDescriptor descriptor;
-            // TODO: Redundant attribute lookup for the case of the same handle appearing
-            //       more than once.
-            updateLocalAttributeValue(request.handle, newValue, characteristic, descriptor);
+            updateLocalAttributeValue(request.handle, request.value, characteristic, descriptor);
             if (characteristic.isValid()) {
                 characteristics << characteristic;
             } else if (descriptor.isValid()) {
@@ -2899,7 +5119,7 @@ void QLowEnergyControllerPrivateBluez::handleExecuteWriteRequest(const QByteArra
             1, static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_EXECUTE_WRITE_RESPONSE)));
 
     for (const QLowEnergyCharacteristic &characteristic : qAsConst(characteristics))
-        emit characteristic.d_ptr->characteristicChanged(characteristic, characteristic.value());
+        characteristic.d_ptr->notifyCharacteristicChanged(characteristic, characteristic.value());
     for (const QLowEnergyDescriptor &descriptor : qAsConst(descriptors))
         emit descriptor.d_ptr->descriptorWritten(descriptor, descriptor.value());
 }
@@ -2912,33 +5132,69 @@ void QLowEnergyControllerPrivateBluez::sendErrorResponse(QBluezConst::AttCommand
         || request == QBluezConst::AttCommand::ATT_OP_SIGNED_WRITE_COMMAND)
         return;
 
-    QByteArray packet(ERROR_RESPONSE_HEADER_SIZE, Qt::Uninitialized);
-    packet[0] = static_cast<quint8>(QBluezConst::AttCommand::ATT_OP_ERROR_RESPONSE);
-    packet[1] = static_cast<quint8>(request);
-    putBtData(handle, packet.data() + 2);
-    packet[4] = static_cast<quint8>(code);
+    QByteArray packet;
+    QBluezAtt::buildErrorResponse(packet, request, handle, code);
     qCWarning(QT_BT_BLUEZ) << "sending error response; request:"
                            << request << "handle:" << handle
                            << "code:" << code;
     sendPacket(packet);
 }
 
-void QLowEnergyControllerPrivateBluez::sendListResponse(const QByteArray &packetStart,
-                                                        qsizetype elemSize,
-                                                        const QList<Attribute> &attributes,
-                                                        const ElemWriter &elemWriter)
+QByteArray QLowEnergyControllerPrivateBluez::sendListResponse(QBluezConst::AttCommand opcode,
+                                                              qsizetype elemSize,
+                                                              const AttributeList &attributes,
+                                                              const ElemWriter &elemWriter)
 {
-    const qsizetype offset = packetStart.size();
-    const qsizetype elemCount = (std::min)(attributes.size(), (mtuSize - offset) / elemSize);
-    const qsizetype totalPacketSize = offset + elemCount * elemSize;
-    QByteArray response(totalPacketSize, Qt::Uninitialized);
-    using namespace std;
-    memcpy(response.data(), packetStart.constData(), offset);
-    char *data = response.data() + offset;
-    for_each(attributes.constBegin(), attributes.constBegin() + elemCount,
-             [&data, elemWriter](const Attribute &attr) { elemWriter(attr, data); });
+    QByteArray response;
+    response.reserve(connection->mtu);
+    QBluezAtt::AttributeDataListBuilder builder(response, opcode, elemSize, connection->mtu);
+    for (const Attribute *attr : attributes) {
+        char *data = builder.appendElement();
+        if (!data)
+            break;
+        elemWriter(*attr, data);
+    }
     qCDebug(QT_BT_BLUEZ) << "sending response:" << response.toHex();
     sendPacket(response);
+    return response;
+}
+
+QByteArray QLowEnergyControllerPrivateBluez::discoveryCacheKey(const QByteArray &request) const
+{
+    QByteArray key(request.size() + qsizetype(sizeof(connection->mtu)), Qt::Uninitialized);
+    memcpy(key.data(), request.constData(), request.size());
+    putBtData(connection->mtu, key.data() + request.size());
+    return key;
+}
+
+/*!
+    \internal
+
+    Sends the cached response for the discovery \a request if there is one.
+    Discovery responses only depend on the request, the MTU and the service
+    and characteristic declarations of the local database. The latter never
+    change after addToGenericAttributeList(). Error responses are not cached.
+ */
+bool QLowEnergyControllerPrivateBluez::sendCachedDiscoveryResponse(const QByteArray &request)
+{
+    const auto it = discoveryResponseCache.constFind(discoveryCacheKey(request));
+    if (it == discoveryResponseCache.constEnd())
+        return false;
+
+    qCDebug(QT_BT_BLUEZ) << "sending cached response:" << it->toHex();
+    sendPacket(*it);
+    return true;
+}
+
+void QLowEnergyControllerPrivateBluez::cacheDiscoveryResponse(const QByteArray &request,
+                                                              const QByteArray &response)
+{
+    // A central walks the database with a few dozen distinct requests.
+    // Avoid unbounded growth in case of a misbehaving peer.
+    constexpr qsizetype maxCachedResponses = 256;
+    if (discoveryResponseCache.size() >= maxCachedResponses)
+        discoveryResponseCache.clear();
+    discoveryResponseCache.insert(discoveryCacheKey(request), response);
 }
 
 void QLowEnergyControllerPrivateBluez::sendNotification(QLowEnergyHandle handle)
@@ -2948,8 +5204,8 @@ void QLowEnergyControllerPrivateBluez::sendNotification(QLowEnergyHandle handle)
 
 void QLowEnergyControllerPrivateBluez::sendIndication(QLowEnergyHandle handle)
 {
-    Q_ASSERT(!indicationInFlight);
-    indicationInFlight = true;
+    Q_ASSERT(!connection->indicationInFlight);
+    connection->indicationInFlight = true;
     sendNotificationOrIndication(QBluezConst::AttCommand::ATT_OP_HANDLE_VAL_INDICATION, handle);
 }
 
@@ -2958,54 +5214,80 @@ void QLowEnergyControllerPrivateBluez::sendNotificationOrIndication(QBluezConst:
 {
     Q_ASSERT(handle <= lastLocalHandle);
     const Attribute &attribute = localAttributes.at(handle);
-    const qsizetype maxValueLength = (std::min)(attribute.value.size(), qsizetype(mtuSize) - 3);
-    QByteArray packet(3 + maxValueLength, Qt::Uninitialized);
-    packet[0] = static_cast<quint8>(opCode);
-    putBtData(handle, packet.data() + 1);
-    using namespace std;
-    memcpy(packet.data() + 3, attribute.value.constData(), maxValueLength);
-    qCDebug(QT_BT_BLUEZ) << "sending notification/indication:" << packet.toHex();
-    sendPacket(packet);
+    // the buffer only detaches if the previous packet is still queued for sending
+    QBluezAtt::buildHandleValue(notificationBuffer, opCode, handle, attribute.value,
+                                connection->mtu);
+    qCDebug(QT_BT_BLUEZ) << "sending notification/indication:" << notificationBuffer.toHex();
+    sendPacket(notificationBuffer);
 }
 
 void QLowEnergyControllerPrivateBluez::sendNextIndication()
 {
-    if (!scheduledIndications.isEmpty())
-        sendIndication(scheduledIndications.takeFirst());
+    if (!connection->scheduledIndications.isEmpty())
+        sendIndication(connection->scheduledIndications.takeFirst());
+}
+
+/*!
+    \internal
+
+    Queues an indication for \a handle until the confirmation for the indication
+    in flight arrives. The value is read from the attribute when the indication
+    is actually sent. Hence, when coalescing is enabled, an already scheduled
+    indication for the same handle delivers the newest value and a second entry
+    is not needed. The queue is then also capped to \c indicationQueueLimit
+    entries, dropping the oldest pending indication once the cap is reached.
+ */
+void QLowEnergyControllerPrivateBluez::scheduleIndication(QLowEnergyHandle handle)
+{
+    if (indicationQueueLimit <= 0) {
+        connection->scheduledIndications << handle;
+        return;
+    }
+
+    if (connection->scheduledIndications.contains(handle))
+        return;
+
+    if (connection->scheduledIndications.size() >= indicationQueueLimit) {
+        qCDebug(QT_BT_BLUEZ) << "indication queue full, dropping pending indication for handle"
+                             << connection->scheduledIndications.constFirst();
+        connection->scheduledIndications.removeFirst();
+    }
+    connection->scheduledIndications << handle;
 }
 
-static QString nameOfRemoteCentral(const QBluetoothAddress &peerAddress)
+/*!
+    \internal
+
+    Looks up the alias of the central which connected from \a address in the
+    shared BlueZ object cache. The lookup does not block, the ATT requests of
+    the central are served in the meantime and remoteName() is empty until the
+    name is known.
+ */
+void QLowEnergyControllerPrivateBluez::resolveRemoteCentralName(const QBluetoothAddress &address)
 {
-    const QString peerAddressString = peerAddress.toString();
     initializeBluez5();
-    OrgFreedesktopDBusObjectManagerInterface manager(QStringLiteral("org.bluez"),
-                                                     QStringLiteral("/"),
-                                                     QDBusConnection::systemBus());
-    QDBusPendingReply<ManagedObjectList> reply = manager.GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError())
-        return QString();
-
-    ManagedObjectList managedObjectList = reply.value();
-    for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
-        const InterfaceList &ifaceList = it.value();
-
-        for (InterfaceList::const_iterator jt = ifaceList.constBegin(); jt != ifaceList.constEnd(); ++jt) {
-            const QString &iface = jt.key();
-            const QVariantMap &ifaceValues = jt.value();
-
-            if (iface == QStringLiteral("org.bluez.Device1")) {
-                if (ifaceValues.value(QStringLiteral("Address")).toString() == peerAddressString)
-                    return ifaceValues.value(QStringLiteral("Alias")).toString();
-            }
+    QtBluezObjectCache::instance()->fetchDeviceProperties(localAdapter, address, this,
+            [this, address](const QVariantMap &properties, const QDBusError &error) {
+        if (error.isValid())
+            return;
+        const QString name = properties.value(QStringLiteral("Alias")).toString();
+        qCDebug(QT_BT_BLUEZ) << "Name of GATT client" << address << "is" << name;
+        if (remoteDevice == address) {
+            remoteName = name;
+            return;
         }
-    }
-    return QString();
+        for (Connection *client : std::as_const(peripheralClients)) {
+            if (client->address == address)
+                client->name = name;
+        }
+    });
 }
 
 void QLowEnergyControllerPrivateBluez::handleConnectionRequest()
 {
-    if (state != QLowEnergyController::AdvertisingState) {
+    const bool isAdditionalClient = state == QLowEnergyController::ConnectedState;
+    if (state != QLowEnergyController::AdvertisingState
+            && !(isAdditionalClient && peripheralClients.size() + 1 < maxPeripheralClients)) {
         qCWarning(QT_BT_BLUEZ) << "Incoming connection request in unexpected state" << state;
         return;
     }
@@ -3022,58 +5304,284 @@ void QLowEnergyControllerPrivateBluez::handleConnectionRequest()
         return;
     }
 
-    remoteDevice = QBluetoothAddress(convertAddress(clientAddr.l2_bdaddr.b));
-    remoteName = nameOfRemoteCentral(remoteDevice);
-    qCDebug(QT_BT_BLUEZ) << "GATT connection from device" << remoteDevice << remoteName;
+    const QBluetoothAddress address(convertAddress(clientAddr.l2_bdaddr.b));
+    if (isAdditionalClient) {
+        Connection *client = new Connection;
+        client->address = address;
+        client->handle = std::exchange(pendingConnectionHandle, 0);
+        peripheralClients.append(client);
+        selectConnection(client);
+    } else {
+        remoteDevice = address;
+        remoteName.clear();
+        if (mainConnection.socket) {
+            disconnect(mainConnection.socket);
+            if (mainConnection.socket->isOpen())
+                mainConnection.socket->close();
+
+            mainConnection.socket->deleteLater();
+            mainConnection.socket = nullptr;
+        }
+    }
+    resolveRemoteCentralName(address);
+    qCDebug(QT_BT_BLUEZ) << "GATT connection from device" << address;
+
+    if (connection->handle == 0)
+        qCWarning(QT_BT_BLUEZ) << "Received client connection, but no connection complete event";
+
+    const bool acceptsFurtherClients = peripheralClients.size() + 1 < maxPeripheralClients;
+    if (acceptsFurtherClients)
+        serverSocketNotifier->setEnabled(true);
+    else
+        closeServerSocket();
+
+    QBluetoothSocketPrivateBluez *rawSocketPrivate = new QBluetoothSocketPrivateBluez();
+    QBluetoothSocket *socket = new QBluetoothSocket(
+                rawSocketPrivate, QBluetoothServiceInfo::L2capProtocol, this);
+    connection->socket = socket;
+    connect(socket, &QBluetoothSocket::disconnected, this, [this, socket]() {
+        if (peripheralClients.isEmpty()) {
+            handlePeripheralClientDisconnected(socket);
+            return;
+        }
+        // the state of the client must outlive the event which is processed for it
+        QMetaObject::invokeMethod(this, [this, socket = QPointer<QBluetoothSocket>(socket)]() {
+            if (socket)
+                handlePeripheralClientDisconnected(socket);
+        }, Qt::QueuedConnection);
+    });
+    connect(socket, &QBluetoothSocket::errorOccurred, this,
+            [this, socket](QBluetoothSocket::SocketError error) {
+        if (peripheralClients.isEmpty() && socket == mainConnection.socket) {
+            l2cpErrorChanged(error);
+            return;
+        }
+        // other clients are still served, only drop the failing connection
+        qCWarning(QT_BT_BLUEZ) << "GATT client connection error:" << error
+                               << socket->errorString();
+        socket->close();
+    });
+    connect(socket, &QIODevice::readyRead, this, [this, socket]() {
+        servePeripheralClient(socket, &QLowEnergyControllerPrivateBluez::l2cpReadyRead);
+    });
+    socket->d_ptr->lowEnergySocketType = addressType == QLowEnergyController::PublicAddress
+            ? BDADDR_LE_PUBLIC : BDADDR_LE_RANDOM;
+    socket->setSocketDescriptor(clientSocket, QBluetoothServiceInfo::L2capProtocol,
+            QBluetoothSocket::SocketState::ConnectedState, QIODevice::ReadWrite | QIODevice::Unbuffered);
+    socket->setSocketOption(QBluetoothSocket::SocketOption::ReceiveTimestampSocketOption, true);
+    connection->securityLevelValue = securityLevel(socket);
+    restoreClientConfigurations();
+    loadSigningDataIfNecessary(RemoteSigningKey);
+
+    // the link layer stops advertising once a central connected
+    if (acceptsFurtherClients && advertiser)
+        advertiser->startAdvertising();
+
+    if (isAdditionalClient) {
+        connection = &mainConnection;
+        return;
+    }
+
+    Q_Q(QLowEnergyController);
+    configurationOwner = &mainConnection;
+    setState(QLowEnergyController::ConnectedState);
+    emit q->connected();
+}
+
+void QLowEnergyControllerPrivateBluez::closeServerSocket()
+{
+    if (!serverSocketNotifier)
+        return;
+    serverSocketNotifier->disconnect();
+    close(serverSocketNotifier->socket());
+    serverSocketNotifier->deleteLater();
+    serverSocketNotifier = nullptr;
+}
+
+QLowEnergyControllerPrivateBluez::Connection *
+QLowEnergyControllerPrivateBluez::connectionForSocket(QBluetoothSocket *socket)
+{
+    if (socket == mainConnection.socket)
+        return &mainConnection;
+    for (Connection *client : std::as_const(peripheralClients)) {
+        if (client->socket == socket)
+            return client;
+    }
+    return nullptr;
+}
+
+QLowEnergyControllerPrivateBluez::Connection *
+QLowEnergyControllerPrivateBluez::connectionForHandle(quint16 handle)
+{
+    if (handle == mainConnection.handle)
+        return &mainConnection;
+    for (Connection *client : std::as_const(peripheralClients)) {
+        if (client->handle == handle)
+            return client;
+    }
+    return nullptr;
+}
+
+// the remote device of the link which is currently processed
+const QBluetoothAddress &QLowEnergyControllerPrivateBluez::peerAddress() const
+{
+    return connection == &mainConnection ? remoteDevice : connection->address;
+}
+
+/*!
+    \internal
+
+    Makes \a client the current connection. All GATT clients share the
+    attribute table, but each of them has its own set of client characteristic
+    configuration values. If the table holds the values of another client, they
+    are stored in that client's Connection and the ones of \a client are loaded.
+ */
+void QLowEnergyControllerPrivateBluez::selectConnection(Connection *client)
+{
+    connection = client;
+    if (role != QLowEnergyController::PeripheralRole || configurationOwner == client)
+        return;
+
+    const QList<TempClientConfigurationData> &tempConfigList = gatherClientConfigData();
+    for (const auto &tempConfigData : tempConfigList) {
+        const QLowEnergyHandle configHandle = tempConfigData.configHandle;
+        if (configurationOwner)
+            configurationOwner->configValues.insert(configHandle, tempConfigData.descData->value);
+        const QByteArray value = client->configValues.value(configHandle, QByteArray(2, 0));
+        tempConfigData.descData->value = value;
+        localAttributes[configHandle].value = value;
+    }
+    client->configValues.clear();
+    configurationOwner = client;
+}
+
+/*!
+    \internal
+
+    Calls \a handler with the GATT client connected via \a socket as the
+    current connection, the main connection is current again afterwards.
+ */
+void QLowEnergyControllerPrivateBluez::servePeripheralClient(
+        QBluetoothSocket *socket, void (QLowEnergyControllerPrivateBluez::*handler)())
+{
+    Connection *client = connectionForSocket(socket);
+    if (!client)
+        return;
+    selectConnection(client);
+    (this->*handler)();
+    connection = &mainConnection;
+}
+
+/*!
+    \internal
+
+    Returns the client characteristic configuration stored at \a configHandle
+    for the current connection.
+ */
+quint16 QLowEnergyControllerPrivateBluez::clientConfiguration(QLowEnergyHandle configHandle) const
+{
+    if (connection == configurationOwner) {
+        const QByteArray &config = localAttributes.at(configHandle).value;
+        Q_ASSERT(config.size() == 2);
+        return bt_get_le16(config.constData());
+    }
+    const auto it = connection->configValues.constFind(configHandle);
+    return it == connection->configValues.cend() ? 0 : bt_get_le16(it->constData());
+}
+
+void QLowEnergyControllerPrivateBluez::handlePeripheralClientDisconnected(QBluetoothSocket *socket)
+{
+    if (peripheralClients.isEmpty()) {
+        if (socket == mainConnection.socket)
+            l2cpDisconnected();
+        return;
+    }
 
-    if (connectionHandle == 0)
-        qCWarning(QT_BT_BLUEZ) << "Received client connection, but no connection complete event";
+    Connection *client = connectionForSocket(socket);
+    if (!client)
+        return;
 
-    if (l2cpSocket) {
-        disconnect(l2cpSocket);
-        if (l2cpSocket->isOpen())
-            l2cpSocket->close();
+    selectConnection(client);
+    qCDebug(QT_BT_BLUEZ) << "GATT client" << peerAddress() << "disconnected,"
+                         << peripheralClients.size() << "client(s) remaining";
+    storeClientConfigurations();
+    discardConnection(*client);
+    configurationOwner = nullptr;
+
+    if (client == &mainConnection) {
+        // one of the further clients becomes the main connection
+        Connection *next = peripheralClients.takeLast();
+        mainConnection = std::move(*next);
+        delete next;
+        remoteDevice = mainConnection.address;
+        remoteName = mainConnection.name;
+    } else {
+        peripheralClients.removeOne(client);
+        delete client;
+    }
+    selectConnection(&mainConnection);
 
-        l2cpSocket->deleteLater();
-        l2cpSocket = nullptr;
+    if (!serverSocketNotifier && peripheralClients.size() + 1 < maxPeripheralClients) {
+        if (listenForConnections()) {
+            if (advertiser)
+                advertiser->startAdvertising();
+        } else {
+            qCWarning(QT_BT_BLUEZ) << "Cannot listen for further GATT clients";
+        }
     }
-    closeServerSocket();
+}
 
-    QBluetoothSocketPrivateBluez *rawSocketPrivate = new QBluetoothSocketPrivateBluez();
-    l2cpSocket = new QBluetoothSocket(
-                rawSocketPrivate, QBluetoothServiceInfo::L2capProtocol, this);
-    connect(l2cpSocket, &QBluetoothSocket::disconnected,
-            this, &QLowEnergyControllerPrivateBluez::l2cpDisconnected);
-    connect(l2cpSocket, &QBluetoothSocket::errorOccurred, this,
-            &QLowEnergyControllerPrivateBluez::l2cpErrorChanged);
-    connect(l2cpSocket, &QIODevice::readyRead, this, &QLowEnergyControllerPrivateBluez::l2cpReadyRead);
-    l2cpSocket->d_ptr->lowEnergySocketType = addressType == QLowEnergyController::PublicAddress
-            ? BDADDR_LE_PUBLIC : BDADDR_LE_RANDOM;
-    l2cpSocket->setSocketDescriptor(clientSocket, QBluetoothServiceInfo::L2capProtocol,
-            QBluetoothSocket::SocketState::ConnectedState, QIODevice::ReadWrite | QIODevice::Unbuffered);
-    restoreClientConfigurations();
-    loadSigningDataIfNecessary(RemoteSigningKey);
+/*!
+    \internal
 
-    Q_Q(QLowEnergyController);
-    setState(QLowEnergyController::ConnectedState);
-    emit q->connected();
+    Closes all client connections except the main one. Their client
+    configurations are stored first.
+ */
+void QLowEnergyControllerPrivateBluez::closeFurtherPeripheralClients()
+{
+    for (Connection *client : std::as_const(peripheralClients)) {
+        selectConnection(client);
+        storeClientConfigurations();
+        discardConnection(*client);
+        delete client;
+    }
+    peripheralClients.clear();
+    if (configurationOwner != &mainConnection)
+        configurationOwner = nullptr;
+    selectConnection(&mainConnection);
 }
 
-void QLowEnergyControllerPrivateBluez::closeServerSocket()
+void QLowEnergyControllerPrivateBluez::discardConnection(Connection &client)
 {
-    if (!serverSocketNotifier)
-        return;
-    serverSocketNotifier->disconnect();
-    close(serverSocketNotifier->socket());
-    serverSocketNotifier->deleteLater();
-    serverSocketNotifier = nullptr;
+    if (client.writeNotifier) {
+        client.writeNotifier->setEnabled(false);
+        client.writeNotifier->deleteLater();
+        client.writeNotifier = nullptr;
+    }
+    if (client.socket) {
+        client.socket->disconnect(this);
+        if (client.socket->isOpen())
+            client.socket->close();
+        client.socket->deleteLater();
+        client.socket = nullptr;
+    }
+}
+
+bool QLowEnergyControllerPrivateBluez::isConnectedPeripheralClient(quint64 address) const
+{
+    if (remoteDevice.toUInt64() == address)
+        return true;
+    return std::any_of(peripheralClients.cbegin(), peripheralClients.cend(),
+                       [address](const Connection *client) {
+                           return client->address.toUInt64() == address;
+                       });
 }
 
 bool QLowEnergyControllerPrivateBluez::isBonded() const
 {
     // Pairing does not necessarily imply bonding, but we don't know whether the
     // bonding flag was set in the original pairing request.
-    return QBluetoothLocalDevice(localAdapter).pairingStatus(remoteDevice)
+    return QBluetoothLocalDevice(localAdapter).pairingStatus(peerAddress())
             != QBluetoothLocalDevice::Unpaired;
 }
 
@@ -3102,7 +5610,9 @@ QLowEnergyControllerPrivateBluez::gatherClientConfigData()
 void QLowEnergyControllerPrivateBluez::storeClientConfigurations()
 {
     if (!isBonded()) {
-        clientConfigData.remove(remoteDevice.toUInt64());
+        clientConfigData.remove(peerAddress().toUInt64());
+        LeBondStore::instance()->setValue(
+                bondStoreKey(LeBondStore::RecordType::ClientConfigurations), QByteArray());
         return;
     }
     QList<ClientConfigurationData> clientConfigs;
@@ -3115,14 +5625,41 @@ void QLowEnergyControllerPrivateBluez::storeClientConfigurations()
                                                      tempConfigData.configHandle, value);
         }
     }
-    clientConfigData.insert(remoteDevice.toUInt64(), clientConfigs);
+    clientConfigData.insert(peerAddress().toUInt64(), clientConfigs);
+
+    QByteArray persistentData(clientConfigs.size() * 3 * sizeof(quint16), Qt::Uninitialized);
+    char *data = persistentData.data();
+    for (const ClientConfigurationData &config : qAsConst(clientConfigs)) {
+        putBtData(config.charValueHandle, data);
+        putBtData(config.configHandle, data + 2);
+        putBtData(config.configValue, data + 4);
+        data += 3 * sizeof(quint16);
+    }
+    LeBondStore::instance()->setValue(bondStoreKey(LeBondStore::RecordType::ClientConfigurations),
+                                      persistentData);
 }
 
 void QLowEnergyControllerPrivateBluez::restoreClientConfigurations()
 {
+    if (isBonded() && !clientConfigData.contains(peerAddress().toUInt64())) {
+        // bonded client known from a previous run of the application
+        const QByteArray persistentData = LeBondStore::instance()->value(
+                bondStoreKey(LeBondStore::RecordType::ClientConfigurations));
+        QList<ClientConfigurationData> clientConfigs;
+        const qsizetype entrySize = 3 * sizeof(quint16);
+        for (qsizetype offset = 0; offset + entrySize <= persistentData.size();
+             offset += entrySize) {
+            const char *data = persistentData.constData() + offset;
+            clientConfigs << ClientConfigurationData(bt_get_le16(data), bt_get_le16(data + 2),
+                                                     bt_get_le16(data + 4));
+        }
+        if (!clientConfigs.isEmpty())
+            clientConfigData.insert(peerAddress().toUInt64(), clientConfigs);
+    }
+
     const QList<TempClientConfigurationData> &tempConfigList = gatherClientConfigData();
     const QList<ClientConfigurationData> &restoredClientConfigs = isBonded()
-            ? clientConfigData.value(remoteDevice.toUInt64())
+            ? clientConfigData.value(peerAddress().toUInt64())
             : QList<ClientConfigurationData>();
     QList<QLowEnergyHandle> notifications;
     for (const auto &tempConfigData : tempConfigList) {
@@ -3136,7 +5673,7 @@ void QLowEnergyControllerPrivateBluez::restoreClientConfigurations()
                     if (isNotificationEnabled(restoredData.configValue))
                         notifications << restoredData.charValueHandle;
                     else if (isIndicationEnabled(restoredData.configValue))
-                        scheduledIndications << restoredData.charValueHandle;
+                        scheduleIndication(restoredData.charValueHandle);
                 }
                 break;
             }
@@ -3155,7 +5692,7 @@ void QLowEnergyControllerPrivateBluez::restoreClientConfigurations()
 
 void QLowEnergyControllerPrivateBluez::loadSigningDataIfNecessary(SigningKeyType keyType)
 {
-    const auto signingDataIt = signingData.constFind(remoteDevice.toUInt64());
+    const auto signingDataIt = signingData.constFind(peerAddress().toUInt64());
     if (signingDataIt != signingData.constEnd())
         return; // We are up to date for this device.
     const QString settingsFilePath = keySettingsFilePath();
@@ -3178,32 +5715,64 @@ void QLowEnergyControllerPrivateBluez::loadSigningDataIfNecessary(SigningKeyType
         return;
     }
     qCDebug(QT_BT_BLUEZ) << "CSRK of peer device is" << keyString;
-    const quint32 counter = settings.value(QLatin1String("Counter"), 0).toUInt();
+    quint32 counter = settings.value(QLatin1String("Counter"), 0).toUInt();
+
+    // BlueZ owns the key file, our own counter updates go to the bond store
+    const QByteArray storedCounter = LeBondStore::instance()->value(
+            bondStoreKey(signCounterRecordType(keyType)));
+    if (storedCounter.size() == sizeof(quint32))
+        counter = qMax(counter, qFromLittleEndian<quint32>(storedCounter.constData()));
+
     quint128 csrk;
     using namespace std;
     memcpy(csrk.data, keyData.constData(), keyData.size());
-    signingData.insert(remoteDevice.toUInt64(), SigningData(csrk, counter - 1));
+    signingData.insert(peerAddress().toUInt64(), SigningData(csrk, counter - 1));
 }
 
 void QLowEnergyControllerPrivateBluez::storeSignCounter(SigningKeyType keyType) const
 {
-    const auto signingDataIt = signingData.constFind(remoteDevice.toUInt64());
+    const auto signingDataIt = signingData.constFind(peerAddress().toUInt64());
     if (signingDataIt == signingData.constEnd())
         return;
-    const QString settingsFilePath = keySettingsFilePath();
-    if (!QFileInfo(settingsFilePath).exists())
-        return;
-    QSettings settings(settingsFilePath, QSettings::IniFormat);
-    if (!settings.isWritable())
-        return;
-    settings.beginGroup(signingKeySettingsGroup(keyType));
-    const QString counterKey = QLatin1String("Counter");
-    if (!settings.allKeys().contains(counterKey))
-        return;
-    const quint32 counterValue = signingDataIt.value().counter + 1;
-    if (counterValue == settings.value(counterKey).toUInt())
-        return;
-    settings.setValue(counterKey, counterValue);
+    QByteArray counterData(sizeof(quint32), Qt::Uninitialized);
+    putBtData(quint32(signingDataIt.value().counter + 1), counterData.data());
+    LeBondStore::instance()->setValue(bondStoreKey(signCounterRecordType(keyType)), counterData);
+}
+
+/*!
+    \internal
+
+    Returns the next local sign counter of \a data. Rather than storing every
+    counter, the stored value reserves a block of counters and is only updated
+    once the block is used up. After a crash signing resumes behind the block,
+    which the remote device accepts as the counter merely has to increase.
+ */
+quint32 QLowEnergyControllerPrivateBluez::reserveSignCounter(SigningData &data) const
+{
+    constexpr quint32 SignCounterBlockSize = 64;
+
+    const quint32 signCounter = ++data.counter;
+    if (signCounter >= data.reservedCounter) {
+        data.reservedCounter = quint32(qMin<quint64>(quint64(signCounter) + SignCounterBlockSize,
+                                                     std::numeric_limits<quint32>::max()));
+        QByteArray counterData(sizeof(quint32), Qt::Uninitialized);
+        putBtData(data.reservedCounter, counterData.data());
+        LeBondStore::instance()->setValue(bondStoreKey(LeBondStore::RecordType::LocalSignCounter),
+                                          counterData);
+    }
+    return signCounter;
+}
+
+LeBondStore::RecordType
+QLowEnergyControllerPrivateBluez::signCounterRecordType(SigningKeyType keyType)
+{
+    return keyType == LocalSigningKey ? LeBondStore::RecordType::LocalSignCounter
+                                      : LeBondStore::RecordType::RemoteSignCounter;
+}
+
+LeBondStore::Key QLowEnergyControllerPrivateBluez::bondStoreKey(LeBondStore::RecordType type) const
+{
+    return LeBondStore::Key{ type, localAdapter.toUInt64(), peerAddress().toUInt64() };
 }
 
 QString QLowEnergyControllerPrivateBluez::signingKeySettingsGroup(SigningKeyType keyType) const
@@ -3214,23 +5783,287 @@ QString QLowEnergyControllerPrivateBluez::signingKeySettingsGroup(SigningKeyType
 QString QLowEnergyControllerPrivateBluez::keySettingsFilePath() const
 {
     return QString::fromLatin1("/var/lib/bluetooth/%1/%2/info")
-            .arg(localAdapter.toString(), remoteDevice.toString());
+            .arg(localAdapter.toString(), peerAddress().toString());
 }
 
-static QByteArray uuidToByteArray(const QBluetoothUuid &uuid)
+/*
+    The GATT cache follows the cache policy of the controller. It is disabled
+    by default, setting QT_BLUETOOTH_GATT_CACHE to a positive value enables it
+    for the PlatformDefault policy.
+*/
+bool QLowEnergyControllerPrivateBluez::isGattCacheEnabled() const
 {
-    QByteArray ba;
-    if (uuid.minimumSize() == 2) {
-        ba.resize(2);
-        putBtData(uuid.toUInt16(), ba.data());
-    } else {
-        ba.resize(16);
-        quint128 hostOrder;
-        quint128 qtUuidOrder = uuid.toUInt128();
-        ntoh128(&qtUuidOrder, &hostOrder);
-        putBtData(hostOrder, ba.data());
+    switch (gattCachePolicy) {
+    case QLowEnergyController::GattCachePolicy::Cached:
+        return true;
+    case QLowEnergyController::GattCachePolicy::Uncached:
+        return false;
+    case QLowEnergyController::GattCachePolicy::PlatformDefault:
+        break;
     }
-    return ba;
+    return gattCacheByDefault;
+}
+
+QString QLowEnergyControllerPrivateBluez::gattCacheFilePath() const
+{
+    return QString::fromLatin1("%1/qtbluetooth/gatt/%2/%3")
+            .arg(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation),
+                 localAdapter.toString(), peerAddress().toString());
+}
+
+/*!
+    \internal
+
+    Reads the Database Hash characteristic of the remote device. Its value
+    changes whenever the remote GATT database changes and therefore decides
+    whether the GATT cache of the device can be used.
+ */
+void QLowEnergyControllerPrivateBluez::readDatabaseHash()
+{
+    QByteArray data;
+    QBluezAtt::buildHandleRangeRequest(data, QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_REQUEST,
+                                       0x0001, 0xFFFF, QBluetoothUuid(GATT_DATABASE_HASH));
+    qCDebug(QT_BT_BLUEZ) << "Reading database hash";
+
+    Request request;
+    request.payload = data;
+    request.command = QBluezConst::AttCommand::ATT_OP_READ_BY_TYPE_REQUEST;
+    request.reference2 = GATT_DATABASE_HASH;
+    request.priority = RequestPriority::Discovery;
+    queueRequest(request);
+
+    sendNextPendingRequest();
+}
+
+void QLowEnergyControllerPrivateBluez::processDatabaseHashReply(const QByteArray &response,
+                                                                bool isErrorResponse)
+{
+    // <opcode><elementLength = 18><handle><128 bit hash>
+    constexpr qsizetype hashSize = 16;
+    cachedServiceDetails.clear();
+    databaseHash.clear();
+    if (!isErrorResponse && response.size() >= 4 + hashSize
+            && quint8(response.at(1)) == 2 + hashSize) {
+        databaseHash = response.mid(4, hashSize);
+    }
+
+    qCDebug(QT_BT_BLUEZ) << "Database hash:" << databaseHash.toHex();
+    if (databaseHash.isEmpty()) {
+        // the GATT cache cannot be validated without hash
+        removeGattCache();
+    } else if (restoreServicesFromCache()) {
+        return;
+    }
+
+    discoverPrimaryServices();
+}
+
+/*!
+    \internal
+
+    Recreates the service list from the GATT cache if the cache belongs to the
+    current Database Hash of the remote device. The characteristics and
+    descriptors of the services are restored by discoverServiceDetails().
+ */
+bool QLowEnergyControllerPrivateBluez::restoreServicesFromCache()
+{
+    Q_Q(QLowEnergyController);
+
+    const QString cacheFilePath = gattCacheFilePath();
+    if (!QFileInfo(cacheFilePath).exists())
+        return false;
+
+    QSettings settings(cacheFilePath, QSettings::IniFormat);
+    if (settings.value(QLatin1String("Version")).toInt() != 1
+            || settings.value(QLatin1String("DatabaseHash")).toByteArray() != databaseHash) {
+        qCDebug(QT_BT_BLUEZ) << "GATT cache is outdated";
+        return false;
+    }
+
+    QDataStream serviceStream(settings.value(QLatin1String("Services")).toByteArray());
+    serviceStream.setVersion(QDataStream::Qt_6_0);
+    quint32 serviceCount = 0;
+    serviceStream >> serviceCount;
+
+    QList<QSharedPointer<QLowEnergyServicePrivate>> services;
+    for (quint32 i = 0; i < serviceCount && serviceStream.status() == QDataStream::Ok; ++i) {
+        QUuid uuid;
+        quint16 startHandle = 0;
+        quint16 endHandle = 0;
+        qint32 type = 0;
+        serviceStream >> uuid >> startHandle >> endHandle >> type;
+
+        QLowEnergyServicePrivate *priv = new QLowEnergyServicePrivate();
+        priv->uuid = QBluetoothUuid(uuid);
+        priv->startHandle = startHandle;
+        priv->endHandle = endHandle;
+        priv->type = QLowEnergyService::ServiceTypes(type);
+        priv->setController(this);
+        services.append(QSharedPointer<QLowEnergyServicePrivate>(priv));
+    }
+    if (serviceStream.status() != QDataStream::Ok || services.isEmpty()) {
+        qCWarning(QT_BT_BLUEZ) << "Ignoring corrupt GATT cache" << cacheFilePath;
+        return false;
+    }
+
+    settings.beginGroup(QLatin1String("ServiceDetails"));
+    for (const auto &service : qAsConst(services)) {
+        const QByteArray details =
+                settings.value(service->uuid.toString(QUuid::WithoutBraces)).toByteArray();
+        if (details.isEmpty())
+            continue;
+
+        QDataStream stream(details);
+        stream.setVersion(QDataStream::Qt_6_0);
+        CachedServiceDetails cached;
+        quint32 includedCount = 0;
+        stream >> includedCount;
+        for (quint32 i = 0; i < includedCount && stream.status() == QDataStream::Ok; ++i) {
+            QUuid uuid;
+            stream >> uuid;
+            cached.includedServices.append(QBluetoothUuid(uuid));
+        }
+        quint32 charCount = 0;
+        stream >> charCount;
+        for (quint32 i = 0; i < charCount && stream.status() == QDataStream::Ok; ++i) {
+            QLowEnergyHandle charHandle = 0;
+            QUuid uuid;
+            qint32 properties = 0;
+            quint32 descriptorCount = 0;
+            QLowEnergyServicePrivate::CharData charData;
+            stream >> charHandle >> charData.valueHandle >> uuid >> properties
+                   >> descriptorCount;
+            charData.uuid = QBluetoothUuid(uuid);
+            charData.properties = QLowEnergyCharacteristic::PropertyTypes(properties);
+            for (quint32 j = 0; j < descriptorCount && stream.status() == QDataStream::Ok; ++j) {
+                QLowEnergyHandle descriptorHandle = 0;
+                QLowEnergyServicePrivate::DescData descData;
+                stream >> descriptorHandle >> uuid;
+                descData.uuid = QBluetoothUuid(uuid);
+                charData.descriptorList.insert(descriptorHandle, descData);
+            }
+            cached.characteristicList.insert(charHandle, charData);
+        }
+
+        if (stream.status() == QDataStream::Ok)
+            cachedServiceDetails.insert(service->uuid, cached);
+    }
+
+    qCDebug(QT_BT_BLUEZ) << "Restored" << services.size() << "services from GATT cache";
+    for (const auto &service : qAsConst(services)) {
+        if (!isServiceInDiscoveryFilter(service->uuid))
+            continue;
+        serviceList.insert(service->uuid, service);
+        watchServiceForCache(service.data());
+        emit q->serviceDiscovered(service->uuid);
+    }
+
+    setState(QLowEnergyController::DiscoveredState);
+    emit q->discoveryFinished();
+    startPendingRangeDiscovery();
+    return true;
+}
+
+void QLowEnergyControllerPrivateBluez::storeServicesInCache()
+{
+    if (!isGattCacheEnabled() || databaseHash.isEmpty())
+        return;
+
+    if (!serviceDiscoveryFilter.isEmpty()) {
+        // a filtered discovery must not replace the complete list of the cache,
+        // the details of the discovered services can still be cached
+        for (const auto &service : qAsConst(serviceList))
+            watchServiceForCache(service.data());
+        return;
+    }
+
+    QByteArray services;
+    QDataStream stream(&services, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << quint32(serviceList.size());
+    for (const auto &service : qAsConst(serviceList)) {
+        stream << QUuid(service->uuid) << quint16(service->startHandle)
+               << quint16(service->endHandle) << qint32(service->type.toInt());
+        watchServiceForCache(service.data());
+    }
+
+    QSettings settings(gattCacheFilePath(), QSettings::IniFormat);
+    if (!settings.isWritable()) {
+        qCDebug(QT_BT_BLUEZ) << "GATT cache not writable:" << settings.fileName();
+        return;
+    }
+    settings.clear();
+    settings.setValue(QLatin1String("Version"), 1);
+    settings.setValue(QLatin1String("DatabaseHash"), databaseHash);
+    settings.setValue(QLatin1String("Services"), services);
+}
+
+void QLowEnergyControllerPrivateBluez::storeServiceDetailsInCache(
+        const QLowEnergyServicePrivate *service)
+{
+    if (!isGattCacheEnabled() || databaseHash.isEmpty())
+        return;
+
+    CachedServiceDetails cached;
+    cached.includedServices = service->includedServices;
+    cached.characteristicList = service->characteristicList;
+
+    QByteArray details;
+    QDataStream stream(&details, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << quint32(cached.includedServices.size());
+    for (const QBluetoothUuid &uuid : qAsConst(cached.includedServices))
+        stream << QUuid(uuid);
+    stream << quint32(cached.characteristicList.size());
+    for (auto charIt = cached.characteristicList.begin();
+         charIt != cached.characteristicList.end(); ++charIt) {
+        // values are always read from the device
+        QLowEnergyServicePrivate::CharData &charData = charIt.value();
+        charData.value.clear();
+        stream << charIt.key() << charData.valueHandle << QUuid(charData.uuid)
+               << qint32(charData.properties.toInt())
+               << quint32(charData.descriptorList.size());
+        for (auto descIt = charData.descriptorList.begin();
+             descIt != charData.descriptorList.end(); ++descIt) {
+            descIt.value().value.clear();
+            stream << descIt.key() << QUuid(descIt.value().uuid);
+        }
+    }
+    cachedServiceDetails.insert(service->uuid, cached);
+
+    QSettings settings(gattCacheFilePath(), QSettings::IniFormat);
+    if (!settings.isWritable()
+            || settings.value(QLatin1String("DatabaseHash")).toByteArray() != databaseHash) {
+        return;
+    }
+    settings.beginGroup(QLatin1String("ServiceDetails"));
+    settings.setValue(service->uuid.toString(QUuid::WithoutBraces), details);
+}
+
+void QLowEnergyControllerPrivateBluez::watchServiceForCache(QLowEnergyServicePrivate *service)
+{
+    // called on every store and restore of the cache, connect only once
+    connect(service, &QLowEnergyServicePrivate::stateChanged,
+            this, &QLowEnergyControllerPrivateBluez::cachedServiceStateChanged,
+            Qt::UniqueConnection);
+}
+
+void QLowEnergyControllerPrivateBluez::cachedServiceStateChanged(
+        QLowEnergyService::ServiceState newState)
+{
+    auto *service = qobject_cast<QLowEnergyServicePrivate *>(sender());
+    // a partial discovery lacks descriptors the cache promises
+    if (service && newState == QLowEnergyService::RemoteServiceDiscovered
+            && service->discoversAllDescriptors()) {
+        storeServiceDetailsInCache(service);
+    }
+}
+
+void QLowEnergyControllerPrivateBluez::removeGattCache()
+{
+    cachedServiceDetails.clear();
+    databaseHash.clear();
+    QFile::remove(gattCacheFilePath());
 }
 
 void QLowEnergyControllerPrivateBluez::addToGenericAttributeList(const QLowEnergyServiceData &service,
@@ -3240,6 +6073,7 @@ void QLowEnergyControllerPrivateBluez::addToGenericAttributeList(const QLowEnerg
     // Otherwise a number of request handling functions will be awkward to write
     // as well as computationally inefficient.
 
+    discoveryResponseCache.clear();
     localAttributes.resize(lastLocalHandle + 1);
     Attribute serviceAttribute;
     serviceAttribute.handle = startHandle;
@@ -3264,124 +6098,269 @@ void QLowEnergyControllerPrivateBluez::addToGenericAttributeList(const QLowEnerg
     }
     const QList<QLowEnergyCharacteristicData> characteristics = service.characteristics();
     for (const QLowEnergyCharacteristicData &cd : characteristics) {
-        Attribute attribute;
-
-        // Characteristic declaration;
-        attribute.handle = ++currentHandle;
-        attribute.groupEndHandle = attribute.handle + 1 + cd.descriptors().size();
-        attribute.type = QBluetoothUuid(GATT_CHARACTERISTIC);
-        attribute.properties = QLowEnergyCharacteristic::Read;
-        attribute.value.resize(1 + sizeof(QLowEnergyHandle) + cd.uuid().minimumSize());
-        char *valueData = attribute.value.data();
-        putDataAndIncrement(static_cast<quint8>(cd.properties()), valueData);
-        putDataAndIncrement(QLowEnergyHandle(currentHandle + 1), valueData);
-        putDataAndIncrement(cd.uuid(), valueData);
-        localAttributes[attribute.handle] = attribute;
+        const QList<QLowEnergyDescriptorData> descriptors = cd.descriptors();
+        setCharacteristicAttributes(++currentHandle, cd.uuid(), cd.properties(),
+                                    descriptors.size());
 
         // Characteristic value declaration.
-        attribute.handle = ++currentHandle;
-        attribute.groupEndHandle = attribute.handle;
-        attribute.type = cd.uuid();
-        attribute.properties = cd.properties();
+        Attribute &attribute = localAttributes[++currentHandle];
         attribute.readConstraints = cd.readConstraints();
         attribute.writeConstraints = cd.writeConstraints();
         attribute.value = cd.value();
         attribute.minLength = cd.minimumValueLength();
         attribute.maxLength = cd.maximumValueLength();
-        localAttributes[attribute.handle] = attribute;
 
-        const QList<QLowEnergyDescriptorData> descriptors = cd.descriptors();
         for (const QLowEnergyDescriptorData &dd : descriptors) {
-            attribute.handle = ++currentHandle;
-            attribute.groupEndHandle = attribute.handle;
-            attribute.type = dd.uuid();
-            attribute.properties = QLowEnergyCharacteristic::PropertyTypes();
-            attribute.readConstraints = AttAccessConstraints();
-            attribute.writeConstraints = AttAccessConstraints();
-            attribute.minLength = 0;
-            attribute.maxLength = INT_MAX;
-
-            // Spec v4.2, Vol. 3, Part G, 3.3.3.x
-            if (attribute.type == QBluetoothUuid::DescriptorType::CharacteristicExtendedProperties) {
-                attribute.properties = QLowEnergyCharacteristic::Read;
-                attribute.minLength = attribute.maxLength = 2;
-            } else if (attribute.type == QBluetoothUuid::DescriptorType::CharacteristicPresentationFormat) {
-                attribute.properties = QLowEnergyCharacteristic::Read;
-                attribute.minLength = attribute.maxLength = 7;
-            } else if (attribute.type == QBluetoothUuid::DescriptorType::CharacteristicAggregateFormat) {
-                attribute.properties = QLowEnergyCharacteristic::Read;
-                attribute.minLength = 4;
-            } else if (attribute.type == QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration
-                       || attribute.type == QBluetoothUuid::DescriptorType::ServerCharacteristicConfiguration) {
-                attribute.properties = QLowEnergyCharacteristic::Read
-                        | QLowEnergyCharacteristic::Write
-                        | QLowEnergyCharacteristic::WriteNoResponse
-                        | QLowEnergyCharacteristic::WriteSigned;
-                attribute.writeConstraints = dd.writeConstraints();
-                attribute.minLength = attribute.maxLength = 2;
-            } else {
-                if (dd.isReadable())
-                    attribute.properties |= QLowEnergyCharacteristic::Read;
-                if (dd.isWritable()) {
-                    attribute.properties |= QLowEnergyCharacteristic::Write;
-                    attribute.properties |= QLowEnergyCharacteristic::WriteNoResponse;
-                    attribute.properties |= QLowEnergyCharacteristic::WriteSigned;
-                }
-                attribute.readConstraints = dd.readConstraints();
-                attribute.writeConstraints = dd.writeConstraints();
-            }
-
-            attribute.value = dd.value();
-            if (attribute.value.size() < attribute.minLength
-                    || attribute.value.size() > attribute.maxLength) {
-                qCWarning(QT_BT_BLUEZ) << "attribute of type" << attribute.type
-                                       << "has invalid length of" << attribute.value.size()
-                                       << "bytes";
-                attribute.value = QByteArray(attribute.minLength, 0);
-            }
-            localAttributes[attribute.handle] = attribute;
+            setDescriptorAttribute(++currentHandle, dd.uuid(), dd.value(), dd.isReadable(),
+                                   dd.isWritable(), dd.readConstraints(), dd.writeConstraints());
         }
     }
     serviceAttribute.groupEndHandle = currentHandle;
     localAttributes[serviceAttribute.handle] = serviceAttribute;
+
+    indexLocalAttributes(startHandle, currentHandle);
+}
+
+/*
+ * Sets up the declaration and the value attribute of a characteristic, apart
+ * from the properties specific to the value.
+ */
+void QLowEnergyControllerPrivateBluez::setCharacteristicAttributes(
+        QLowEnergyHandle declarationHandle, const QBluetoothUuid &uuid,
+        QLowEnergyCharacteristic::PropertyTypes properties, qsizetype descriptorCount)
+{
+    Attribute attribute;
+    attribute.handle = declarationHandle;
+    attribute.groupEndHandle = attribute.handle + 1 + descriptorCount;
+    attribute.type = QBluetoothUuid(GATT_CHARACTERISTIC);
+    attribute.properties = QLowEnergyCharacteristic::Read;
+    attribute.value.resize(1 + sizeof(QLowEnergyHandle) + uuid.minimumSize());
+    char *valueData = attribute.value.data();
+    putDataAndIncrement(static_cast<quint8>(properties), valueData);
+    putDataAndIncrement(QLowEnergyHandle(declarationHandle + 1), valueData);
+    putDataAndIncrement(uuid, valueData);
+    localAttributes[attribute.handle] = attribute;
+
+    Attribute valueAttribute;
+    valueAttribute.handle = declarationHandle + 1;
+    valueAttribute.groupEndHandle = valueAttribute.handle;
+    valueAttribute.type = uuid;
+    valueAttribute.properties = properties;
+    localAttributes[valueAttribute.handle] = valueAttribute;
+}
+
+void QLowEnergyControllerPrivateBluez::setDescriptorAttribute(
+        QLowEnergyHandle handle, const QBluetoothUuid &uuid, const QByteArray &value,
+        bool readable, bool writable, AttAccessConstraints readConstraints,
+        AttAccessConstraints writeConstraints)
+{
+    Attribute attribute;
+    attribute.handle = handle;
+    attribute.groupEndHandle = attribute.handle;
+    attribute.type = uuid;
+    attribute.properties = QLowEnergyCharacteristic::PropertyTypes();
+    attribute.readConstraints = AttAccessConstraints();
+    attribute.writeConstraints = AttAccessConstraints();
+    attribute.minLength = 0;
+    attribute.maxLength = INT_MAX;
+
+    // Spec v4.2, Vol. 3, Part G, 3.3.3.x
+    if (attribute.type == QBluetoothUuid::DescriptorType::CharacteristicExtendedProperties) {
+        attribute.properties = QLowEnergyCharacteristic::Read;
+        attribute.minLength = attribute.maxLength = 2;
+    } else if (attribute.type == QBluetoothUuid::DescriptorType::CharacteristicPresentationFormat) {
+        attribute.properties = QLowEnergyCharacteristic::Read;
+        attribute.minLength = attribute.maxLength = 7;
+    } else if (attribute.type == QBluetoothUuid::DescriptorType::CharacteristicAggregateFormat) {
+        attribute.properties = QLowEnergyCharacteristic::Read;
+        attribute.minLength = 4;
+    } else if (attribute.type == QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration
+               || attribute.type == QBluetoothUuid::DescriptorType::ServerCharacteristicConfiguration) {
+        attribute.properties = QLowEnergyCharacteristic::Read
+                | QLowEnergyCharacteristic::Write
+                | QLowEnergyCharacteristic::WriteNoResponse
+                | QLowEnergyCharacteristic::WriteSigned;
+        attribute.writeConstraints = writeConstraints;
+        attribute.minLength = attribute.maxLength = 2;
+    } else {
+        if (readable)
+            attribute.properties |= QLowEnergyCharacteristic::Read;
+        if (writable) {
+            attribute.properties |= QLowEnergyCharacteristic::Write;
+            attribute.properties |= QLowEnergyCharacteristic::WriteNoResponse;
+            attribute.properties |= QLowEnergyCharacteristic::WriteSigned;
+        }
+        attribute.readConstraints = readConstraints;
+        attribute.writeConstraints = writeConstraints;
+    }
+
+    attribute.value = value;
+    if (attribute.value.size() < attribute.minLength
+            || attribute.value.size() > attribute.maxLength) {
+        qCWarning(QT_BT_BLUEZ) << "attribute of type" << attribute.type
+                               << "has invalid length of" << attribute.value.size()
+                               << "bytes";
+        attribute.value = QByteArray(attribute.minLength, 0);
+    }
+    localAttributes[attribute.handle] = attribute;
+}
+
+void QLowEnergyControllerPrivateBluez::indexLocalAttributes(QLowEnergyHandle startHandle,
+                                                            QLowEnergyHandle endHandle)
+{
+    for (uint handle = startHandle; handle <= endHandle; ++handle) {
+        QList<QLowEnergyHandle> &handles = attributeHandlesByType[localAttributes.at(handle).type];
+        handles.insert(std::lower_bound(handles.begin(), handles.end(), handle), handle);
+    }
+}
+
+/*
+ * Builds the attribute table of a static service in place. The values of the
+ * service have static storage duration, they are referenced until written.
+ */
+QLowEnergyService *QLowEnergyControllerPrivateBluez::addStaticServiceHelper(
+        const QLowEnergyStaticServiceData &service)
+{
+    const int attributeCount = service.attributeCount();
+    if (attributeCount > std::numeric_limits<QLowEnergyHandle>::max() - lastLocalHandle) {
+        qCWarning(QT_BT_BLUEZ) << "Not enough attribute handles left to create this service";
+        return nullptr;
+    }
+
+    const auto servicePrivate = QSharedPointer<QLowEnergyServicePrivate>::create();
+    servicePrivate->setController(this);
+    servicePrivate->state = QLowEnergyService::LocalService;
+    servicePrivate->uuid = service.uuid;
+    servicePrivate->type = service.type == QLowEnergyServiceData::ServiceTypePrimary
+            ? QLowEnergyService::PrimaryService : QLowEnergyService::IncludedService;
+
+    const QLowEnergyHandle startHandle = lastLocalHandle + 1;
+    lastLocalHandle += QLowEnergyHandle(attributeCount);
+    servicePrivate->startHandle = startHandle;
+    servicePrivate->endHandle = lastLocalHandle;
+
+    discoveryResponseCache.clear();
+    localAttributes.resize(lastLocalHandle + 1);
+
+    Attribute &serviceAttribute = localAttributes[startHandle];
+    serviceAttribute.handle = startHandle;
+    serviceAttribute.groupEndHandle = lastLocalHandle;
+    serviceAttribute.type = QBluetoothUuid(static_cast<quint16>(service.type));
+    serviceAttribute.properties = QLowEnergyCharacteristic::Read;
+    serviceAttribute.value = uuidToByteArray(service.uuid);
+
+    QLowEnergyHandle currentHandle = startHandle;
+    for (const QLowEnergyStaticCharacteristicData &cd : service.characteristics) {
+        const QLowEnergyHandle declHandle = ++currentHandle;
+        setCharacteristicAttributes(declHandle, cd.uuid, cd.properties, cd.descriptors.size());
+
+        const QByteArray value = QByteArray::fromRawData(cd.value.data(), cd.value.size());
+        Attribute &attribute = localAttributes[++currentHandle];
+        attribute.readConstraints = cd.readConstraints;
+        attribute.writeConstraints = cd.writeConstraints;
+        attribute.value = value;
+        attribute.minLength = cd.minimumValueLength;
+        attribute.maxLength = qMax(cd.minimumValueLength, cd.maximumValueLength);
+
+        QLowEnergyServicePrivate::CharData charData;
+        charData.valueHandle = currentHandle;
+        charData.uuid = cd.uuid;
+        charData.properties = cd.properties;
+        charData.value = value;
+        for (const QLowEnergyStaticDescriptorData &dd : cd.descriptors) {
+            const QByteArray descriptorValue =
+                    QByteArray::fromRawData(dd.value.data(), dd.value.size());
+            setDescriptorAttribute(++currentHandle, dd.uuid, descriptorValue, dd.readable,
+                                   dd.writable, dd.readConstraints, dd.writeConstraints);
+
+            QLowEnergyServicePrivate::DescData descData;
+            descData.uuid = dd.uuid;
+            descData.value = descriptorValue;
+            charData.descriptorList.insert(currentHandle, descData);
+        }
+        servicePrivate->characteristicList.insert(declHandle, charData);
+    }
+    Q_ASSERT(currentHandle == lastLocalHandle);
+
+    indexLocalAttributes(startHandle, lastLocalHandle);
+
+    if (localServices.contains(servicePrivate->uuid)) {
+        qCWarning(QT_BT_BLUEZ) << "Overriding existing local service with uuid"
+                               << servicePrivate->uuid;
+    }
+    localServices.insert(servicePrivate->uuid, servicePrivate);
+    return new QLowEnergyService(servicePrivate);
+}
+
+bool QLowEnergyControllerPrivateBluez::isValidLocalAdapter()
+{
+    return isReplaying() || QLowEnergyControllerPrivate::isValidLocalAdapter();
+}
+
+bool QLowEnergyControllerPrivateBluez::setLocalAdapter(const QBluetoothAddress &adapter)
+{
+    if (adapter == localAdapter)
+        return true;
+    if (role != QLowEnergyController::CentralRole || isReplaying()
+            || state != QLowEnergyController::UnconnectedState) {
+        return false;
+    }
+    if (!HciManager::forAdapter(adapter)->isValid())
+        return false;
+
+    localAdapter = adapter;
+    rebindHciManager();
+    // bound to the previous adapter's Device1 objects
+    delete device1Manager;
+    device1Manager = nullptr;
+    return true;
 }
 
 int QLowEnergyControllerPrivateBluez::mtu() const
 {
-    return mtuSize;
+    return connection->mtu;
 }
 
 void QLowEnergyControllerPrivateBluez::ensureUniformAttributes(
-        QList<Attribute> &attributes, const std::function<int(const Attribute &)> &getSize)
+        AttributeList &attributes, const std::function<int(const Attribute &)> &getSize)
 {
     if (attributes.isEmpty())
         return;
-    const int firstSize = getSize(attributes.first());
+    const int firstSize = getSize(*attributes.first());
     const auto it = std::find_if(attributes.begin() + 1, attributes.end(),
-            [firstSize, getSize](const Attribute &attr) { return getSize(attr) != firstSize; });
+            [firstSize, getSize](const Attribute *attr) { return getSize(*attr) != firstSize; });
     if (it != attributes.end())
         attributes.erase(it, attributes.end());
 
 }
 
-void QLowEnergyControllerPrivateBluez::ensureUniformUuidSizes(QList<Attribute> &attributes)
+void QLowEnergyControllerPrivateBluez::ensureUniformUuidSizes(AttributeList &attributes)
 {
     ensureUniformAttributes(attributes,
                             [](const Attribute &attr) { return getUuidSize(attr.type); });
 }
 
-void QLowEnergyControllerPrivateBluez::ensureUniformValueSizes(QList<Attribute> &attributes)
+void QLowEnergyControllerPrivateBluez::ensureUniformValueSizes(AttributeList &attributes)
 {
     ensureUniformAttributes(attributes,
                             [](const Attribute &attr) { return attr.value.size(); });
 }
 
-QList<QLowEnergyControllerPrivateBluez::Attribute>
+/*!
+    \internal
+
+    Returns views of up to \a maxCount attributes in the given handle range
+    which satisfy \a attributePredicate. The attributes are not copied.
+    Callers limit \a maxCount to the number of elements which can fit
+    into their response.
+ */
+QLowEnergyControllerPrivateBluez::AttributeList
 QLowEnergyControllerPrivateBluez::getAttributes(QLowEnergyHandle startHandle,
                                                 QLowEnergyHandle endHandle,
+                                                qsizetype maxCount,
                                                 const AttributePredicate &attributePredicate)
 {
-    QList<Attribute> results;
+    AttributeList results;
     if (startHandle > lastLocalHandle)
         return results;
     if (lastLocalHandle == 0) // We have no services at all.
@@ -3389,10 +6368,38 @@ QLowEnergyControllerPrivateBluez::getAttributes(QLowEnergyHandle startHandle,
     Q_ASSERT(startHandle <= endHandle); // Must have been checked before.
     const QLowEnergyHandle firstHandle = qMin(startHandle, lastLocalHandle);
     const QLowEnergyHandle lastHandle = qMin(endHandle, lastLocalHandle);
-    for (QLowEnergyHandle i = firstHandle; i <= lastHandle; ++i) {
+    for (uint i = firstHandle; i <= lastHandle && results.size() < maxCount; ++i) {
         const Attribute &attr = localAttributes.at(i);
         if (attributePredicate(attr))
-            results << attr;
+            results << &attr;
+    }
+    return results;
+}
+
+/*!
+    \internal
+
+    Like getAttributes() but only visits the attributes of the given \a type,
+    as looked up in attributeHandlesByType. Discovery requests filter by
+    type, this spares them the walk over every handle of the range.
+ */
+QLowEnergyControllerPrivateBluez::AttributeList
+QLowEnergyControllerPrivateBluez::getAttributesOfType(QLowEnergyHandle startHandle,
+                                                      QLowEnergyHandle endHandle,
+                                                      qsizetype maxCount,
+                                                      const QBluetoothUuid &type,
+                                                      const AttributePredicate &attributePredicate)
+{
+    AttributeList results;
+    const auto it = attributeHandlesByType.constFind(type);
+    if (it == attributeHandlesByType.cend())
+        return results;
+    Q_ASSERT(startHandle <= endHandle); // Must have been checked before.
+    for (auto handle = std::lower_bound(it->cbegin(), it->cend(), startHandle);
+         handle != it->cend() && *handle <= endHandle && results.size() < maxCount; ++handle) {
+        const Attribute &attr = localAttributes.at(*handle);
+        if (attributePredicate(attr))
+            results << &attr;
     }
     return results;
 }
@@ -3415,7 +6422,7 @@ QLowEnergyControllerPrivateBluez::checkPermissions(const Attribute &attr,
         // can also be used if the link is encrypted.
         const bool unsignedWriteOk = isWriteCommand
                 && (attr.properties & QLowEnergyCharacteristic::WriteSigned)
-                && securityLevel() >= BT_SECURITY_MEDIUM;
+                && connection->securityLevelValue >= BT_SECURITY_MEDIUM;
         if (!unsignedWriteOk)
             return QBluezConst::AttError::ATT_ERROR_WRITE_NOT_PERM;
     }
@@ -3425,10 +6432,10 @@ QLowEnergyControllerPrivateBluez::checkPermissions(const Attribute &attr,
         return QBluezConst::AttError::ATT_ERROR_INSUF_AUTHORIZATION; // TODO: emit signal (and offer
                                                                      // authorization function)?
     if (constraints.testFlag(AttAccessConstraint::AttEncryptionRequired)
-        && securityLevel() < BT_SECURITY_MEDIUM)
+        && connection->securityLevelValue < BT_SECURITY_MEDIUM)
         return QBluezConst::AttError::ATT_ERROR_INSUF_ENCRYPTION;
     if (constraints.testFlag(AttAccessConstraint::AttAuthenticationRequired)
-        && securityLevel() < BT_SECURITY_HIGH)
+        && connection->securityLevelValue < BT_SECURITY_HIGH)
         return QBluezConst::AttError::ATT_ERROR_INSUF_AUTHENTICATION;
     if (false)
         return QBluezConst::AttError::ATT_ERROR_INSUF_ENCR_KEY_SIZE;
@@ -3441,7 +6448,7 @@ QBluezConst::AttError QLowEnergyControllerPrivateBluez::checkReadPermissions(con
 }
 
 QBluezConst::AttError
-QLowEnergyControllerPrivateBluez::checkReadPermissions(QList<Attribute> &attributes)
+QLowEnergyControllerPrivateBluez::checkReadPermissions(AttributeList &attributes)
 {
     if (attributes.isEmpty())
         return QBluezConst::AttError::ATT_ERROR_NO_ERROR;
@@ -3451,25 +6458,24 @@ QLowEnergyControllerPrivateBluez::checkReadPermissions(QList<Attribute> &attribu
     //       then that error is returned via an error response.
     //    2) If any other element of that list would cause a permissions error, then all
     //       attributes from this one on are not part of the result set, but no error is returned.
-    const QBluezConst::AttError error = checkReadPermissions(attributes.first());
+    const QBluezConst::AttError error = checkReadPermissions(*attributes.first());
     if (error != QBluezConst::AttError::ATT_ERROR_NO_ERROR)
         return error;
     const auto it =
-            std::find_if(attributes.begin() + 1, attributes.end(), [this](const Attribute &attr) {
-                return checkReadPermissions(attr) != QBluezConst::AttError::ATT_ERROR_NO_ERROR;
+            std::find_if(attributes.begin() + 1, attributes.end(), [this](const Attribute *attr) {
+                return checkReadPermissions(*attr) != QBluezConst::AttError::ATT_ERROR_NO_ERROR;
             });
     if (it != attributes.end())
         attributes.erase(it, attributes.end());
     return QBluezConst::AttError::ATT_ERROR_NO_ERROR;
 }
 
-bool QLowEnergyControllerPrivateBluez::verifyMac(const QByteArray &message, const quint128 &csrk,
+bool QLowEnergyControllerPrivateBluez::verifyMac(QByteArrayView message, const quint128 &csrk,
                                              quint32 signCounter, quint64 expectedMac)
 {
     if (!cmacCalculator)
         cmacCalculator = new LeCmacCalculator;
-    return cmacCalculator->verify(LeCmacCalculator::createFullMessage(message, signCounter), csrk,
-                                expectedMac);
+    return cmacCalculator->verify(message, signCounter, csrk, expectedMac);
 }
 
 QT_END_NAMESPACE
@@ -22,17 +22,22 @@
 #include <QtBluetooth/qlowenergycharacteristic.h>
 #include "qlowenergycontroller.h"
 #include "qlowenergycontrollerbase_p.h"
+#include "qlowenergytimeoutwheel_p.h"
 #include "bluez/bluez_data_p.h"
+#include "bluez/btsnoop_p.h"
+#include "bluez/hcimanager_p.h"
+#include "bluez/socketreader_p.h"
+#include "lebondstore_p.h"
 
 #include <QtBluetooth/QBluetoothSocket>
 #include <functional>
+#include <memory>
 
 QT_BEGIN_NAMESPACE
 
 class QLowEnergyServiceData;
 class QTimer;
 
-class HciManager;
 class LeCmacCalculator;
 class QSocketNotifier;
 class RemoteDeviceManager;
@@ -41,7 +46,8 @@ extern void registerQLowEnergyControllerMetaType();
 
 class QLeAdvertiser;
 
-class QLowEnergyControllerPrivateBluez final: public QLowEnergyControllerPrivate
+class QLowEnergyControllerPrivateBluez final: public QLowEnergyControllerPrivate,
+                                              public HciConnectionSubscriber
 {
     Q_OBJECT
 public:
@@ -60,9 +66,21 @@ public:
     void startAdvertising(const QLowEnergyAdvertisingParameters &params,
                           const QLowEnergyAdvertisingData &advertisingData,
                           const QLowEnergyAdvertisingData &scanResponseData) override;
+    void startAdvertisingSets(const QList<QLowEnergyAdvertisingParameters> &params,
+                              const QList<QLowEnergyAdvertisingData> &advertisingData,
+                              const QList<QLowEnergyAdvertisingData> &scanResponseData) override;
     void stopAdvertising() override;
+    void updateAdvertisingData(int advertisingSet,
+                               const QLowEnergyAdvertisingData &advertisingData,
+                               const QLowEnergyAdvertisingData &scanResponseData) override;
+    void setPeriodicAdvertisingData(int advertisingSet,
+                                    const QLowEnergyAdvertisingData &data) override;
 
     void requestConnectionUpdate(const QLowEnergyConnectionParameters &params) override;
+    void requestPhy(QLowEnergyController::Phy txPhy, QLowEnergyController::Phy rxPhy) override;
+    void requestDataLength(int txOctets) override;
+    QLowEnergyLinkStatistics linkStatistics() const override;
+    void addMemoryUsage(QBluetoothMemoryUsage *usage) const override;
 
     // read data
     void readCharacteristic(const QSharedPointer<QLowEnergyServicePrivate> service,
@@ -80,9 +98,22 @@ public:
                          const QLowEnergyHandle descriptorHandle,
                          const QByteArray &newValue) override;
 
+    void readCharacteristics(const QSharedPointer<QLowEnergyServicePrivate> service,
+                             const QList<QLowEnergyHandle> &charHandles) override;
+    void writeCharacteristicsReliably(const QSharedPointer<QLowEnergyServicePrivate> service,
+                                      const QList<QLowEnergyHandle> &charHandles,
+                                      const QList<QByteArray> &newValues) override;
+    bool cancelRequests(QLowEnergyServicePrivate *service) override;
+    void publishCharacteristicValue(const QSharedPointer<QLowEnergyServicePrivate> service,
+                                    const QLowEnergyHandle charHandle,
+                                    QByteArrayView value) override;
+
     void addToGenericAttributeList(const QLowEnergyServiceData &service,
                                    QLowEnergyHandle startHandle) override;
+    QLowEnergyService *addStaticServiceHelper(const QLowEnergyStaticServiceData &service) override;
 
+    bool isValidLocalAdapter() override;
+    bool setLocalAdapter(const QBluetoothAddress &adapter) override;
     int mtu() const override;
 
     struct Attribute {
@@ -99,10 +130,43 @@ public:
         int maxLength;
     };
     QList<Attribute> localAttributes;
+    void setCharacteristicAttributes(QLowEnergyHandle declarationHandle,
+                                     const QBluetoothUuid &uuid,
+                                     QLowEnergyCharacteristic::PropertyTypes properties,
+                                     qsizetype descriptorCount);
+    void setDescriptorAttribute(QLowEnergyHandle handle, const QBluetoothUuid &uuid,
+                                const QByteArray &value, bool readable, bool writable,
+                                QBluetooth::AttAccessConstraints readConstraints,
+                                QBluetooth::AttAccessConstraints writeConstraints);
+    void indexLocalAttributes(QLowEnergyHandle startHandle, QLowEnergyHandle endHandle);
+    // sorted handles of localAttributes by attribute type
+    QHash<QBluetoothUuid, QList<QLowEnergyHandle>> attributeHandlesByType;
+    // discovery responses for the static part of localAttributes, keyed by request and MTU
+    QHash<QByteArray, QByteArray> discoveryResponseCache;
+
+protected:
+    bool event(QEvent *event) override;
 
 private:
-    quint16 connectionHandle = 0;
-    QBluetoothSocket *l2cpSocket = nullptr;
+    QByteArray receiveBuffer; // reused for every inbound ATT packet, see readPacket()
+
+    // ATT PDUs of the fixed channel, see QT_BLUETOOTH_ATT_CAPTURE and QT_BLUETOOTH_ATT_REPLAY
+    BtSnoopWriter attCapture;
+    QString attReplayFileName;
+    QList<BtSnoopAttRecord> attReplayRecords;
+    qsizetype attReplayPosition = 0;
+    bool attReplayScheduled = false;
+    bool isReplaying() const { return !attReplayFileName.isEmpty(); }
+    QByteArray notificationBuffer; // reused for every outbound notification and indication
+    // Queueing class of a request, smaller values are sent first
+    enum class RequestPriority : quint8 {
+        Interactive,    // reads and writes of the application
+        Configuration,  // MTU exchange and client characteristic configuration
+        Discovery,      // service, characteristic and descriptor discovery
+        Prefetch        // values read by the service discovery
+    };
+    // Number of later requests which may overtake a queued request
+    static constexpr quint8 MaxRequestOvertakes = 8;
     struct Request {
         QBluezConst::AttCommand command;
         QByteArray payload;
@@ -110,22 +174,115 @@ private:
         // requirements this is WIP
         QVariant reference;
         QVariant reference2;
+        // non-zero for the prepare and execute requests of a reliable write
+        quint32 reliableWriteId = 0;
+        // read sent by readServiceValues(), its response continues the service discovery
+        bool valueDiscovery = false;
+        RequestPriority priority = RequestPriority::Interactive;
+        quint8 overtaken = 0;
+        // service whose discovery or read issued the request, only compared
+        QLowEnergyServicePrivate *owner = nullptr;
+        // the service canceled the request after it was sent, its response is dropped
+        bool cancelled = false;
+        // for the request statistics, requests are queued right after their creation
+        QLowEnergyRequestRecorder::Clock::time_point queuedAt =
+                QLowEnergyRequestRecorder::Clock::now();
+        QLowEnergyRequestRecorder::Clock::time_point sentAt;
     };
     QQueue<Request> openRequests;
 
-    struct WriteRequest {
-        WriteRequest() {}
-        WriteRequest(quint16 h, quint16 o, const QByteArray &v)
-            : handle(h), valueOffset(o), value(v) {}
-        quint16 handle;
-        quint16 valueOffset;
+    // Reliable write transactions whose requests are still in openRequests
+    struct ReliableWrite {
+        QSharedPointer<QLowEnergyServicePrivate> service;
+        QList<QLowEnergyHandle> charHandles;
+        QList<QByteArray> values;
+    };
+    QHash<quint32, ReliableWrite> reliableWrites;
+    quint32 lastReliableWriteId = 0;
+
+    // Enhanced ATT bearer (L2CAP credit based channel) with its own request slot
+    struct EattBearer {
+        int socketDescriptor = -1;
+        QSocketNotifier *connectNotifier = nullptr;
+        QBluetoothSocket *socket = nullptr; // set once the channel is connected
+        QQueue<Request> openRequests;
+        bool requestPending = false;
+        // armed while the kernel send buffer of the channel is full
+        QSocketNotifier *writeNotifier = nullptr;
+        bool confirmationPending = false; // indication confirmation not sent yet
+        quint16 mtu = 23; // default LE ATT_MTU
+        std::unique_ptr<QLowEnergyRequestTimeout> requestTimer;
+    };
+    QList<EattBearer *> eattBearers;
+
+    // Read of a long value with one Read Blob request in flight per bearer
+    struct LongRead {
+        QByteArray value; // contiguous part received so far
+        QMap<quint16, QByteArray> fragments; // received ahead of value, by offset
+        quint16 chunkSize = 0;
+        qsizetype nextOffset = 0;
+        qsizetype endOffset = -1; // known once the peer signals the end of the value
+        int requestsInFlight = 0;
+        bool failed = false;
+    };
+    QHash<uint, LongRead> longReads;
+    // bearer whose response is currently processed, nullptr for the fixed channel
+    EattBearer *activeBearer = nullptr;
+    int requestedEattBearers = 0;
+
+    // see QT_BLUETOOTH_ATT_LOW_LATENCY and setLowLatencyNotificationHandler()
+    bool attLowLatency = false;
+    int attBusyPollMicroseconds = 0;
+    QtBluezSocketReader::Options attReaderOptions() const;
+
+    // Long write of one attribute, reassembled while the fragments arrive
+    struct PreparedWrite {
+        PreparedWrite() {}
+        PreparedWrite(quint16 h, const QByteArray &initialValue, qsizetype capacity)
+            : handle(h), value(initialValue)
+        {
+            value.reserve(capacity);
+        }
+        quint16 handle = 0;
         QByteArray value;
+        // reported on the Execute Write request, as required by the spec
+        QBluezConst::AttError error = QBluezConst::AttError::ATT_ERROR_NO_ERROR;
     };
-    QList<WriteRequest> openPrepareWriteRequests;
-
-    // Invariant: !scheduledIndications.isEmpty => indicationInFlight == true
-    QList<QLowEnergyHandle> scheduledIndications;
-    bool indicationInFlight = false;
+    // > 0 enables coalescing of scheduled indications and caps the queue
+    qsizetype indicationQueueLimit = 0;
+
+    // State of one link on the fixed ATT channel. The central role and the first
+    // GATT client of the local peripheral use mainConnection, further clients
+    // get an entry in peripheralClients. 'connection' points to the link whose
+    // event is being processed and to mainConnection otherwise.
+    struct Connection {
+        QBluetoothSocket *socket = nullptr;
+        // of further clients, mainConnection uses remoteDevice and remoteName
+        QBluetoothAddress address;
+        QString name;
+        quint16 handle = 0;
+        quint16 mtu = 23; // default LE ATT_MTU
+        bool receivedMtuExchangeRequest = false;
+        int securityLevelValue = -1; // of the link, see securityLevel()
+        QList<PreparedWrite> openPrepareWriteRequests; // one entry per handle
+        qsizetype preparedWriteFragments = 0;
+        // Invariant: !scheduledIndications.isEmpty => indicationInFlight == true
+        QList<QLowEnergyHandle> scheduledIndications;
+        bool indicationInFlight = false;
+        // CCCD handle -> value, while the attribute table holds another client's
+        QHash<QLowEnergyHandle, QByteArray> configValues;
+        // packets which could not be written yet due to a full kernel send buffer
+        QQueue<QByteArray> outboundQueue;
+        QSocketNotifier *writeNotifier = nullptr;
+        bool sendQueueCongested = false;
+    };
+    Connection mainConnection;
+    QList<Connection *> peripheralClients;
+    Connection *connection = &mainConnection;
+    // the client whose CCCD values are in localAttributes, see selectConnection()
+    Connection *configurationOwner = nullptr;
+    int maxPeripheralClients = 1;
+    quint16 pendingConnectionHandle = 0;
 
     struct TempClientConfigurationData {
         TempClientConfigurationData(QLowEnergyServicePrivate::DescData *dd = nullptr,
@@ -156,20 +313,44 @@ private:
 
         quint128 key;
         quint32 counter = quint32(-1);
+        // local counters below this value are persisted as used, see reserveSignCounter()
+        quint32 reservedCounter = 0;
     };
     QHash<quint64, SigningData> signingData;
     LeCmacCalculator *cmacCalculator = nullptr;
 
+    // On-disk GATT cache validated by the Database Hash of the remote device
+    struct CachedServiceDetails {
+        QList<QBluetoothUuid> includedServices;
+        QHash<QLowEnergyHandle, QLowEnergyServicePrivate::CharData> characteristicList;
+    };
+    QHash<QBluetoothUuid, CachedServiceDetails> cachedServiceDetails;
+    QByteArray databaseHash;
+    // used with the PlatformDefault cache policy
+    bool gattCacheByDefault = false;
+
     bool requestPending;
-    quint16 mtuSize;
-    int securityLevelValue;
     bool encryptionChangePending;
-    bool receivedMtuExchangeRequest = false;
-
-    HciManager *hciManager = nullptr;
+    // optimistic until the peer rejects the respective request
+    bool readMultipleSupported = true;
+    bool readMultipleVariableSupported = true;
+    // handle range of the running service discovery, see rediscoverServiceRange()
+    QLowEnergyHandle discoveryRangeStart = 0x0001;
+    QLowEnergyHandle discoveryRangeEnd = 0xFFFF;
+    bool serviceRangeDiscovery = false;
+    // range of Service Changed indications received while another discovery runs
+    QLowEnergyHandle pendingRangeStart = 0;
+    QLowEnergyHandle pendingRangeEnd = 0;
+
+    QSharedPointer<HciManager> hciManager;
+    // the remote device is in the accept list, the socket follows its connection
+    bool autoConnectPending = false;
     QLeAdvertiser *advertiser = nullptr;
+    // kept across advertisers, the data may be set before advertising starts
+    QHash<int, QLowEnergyAdvertisingData> periodicAdvertisingData;
     QSocketNotifier *serverSocketNotifier = nullptr;
-    QTimer *requestTimer = nullptr;
+    qsizetype sendQueueHighWaterMark = 64;
+    std::unique_ptr<QLowEnergyRequestTimeout> requestTimer;
     RemoteDeviceManager* device1Manager = nullptr;
 
     /*
@@ -190,8 +371,22 @@ private:
     int gattRequestTimeout = 20000;
 
     void handleConnectionRequest();
+    void resolveRemoteCentralName(const QBluetoothAddress &address);
+    bool listenForConnections();
     void closeServerSocket();
 
+    Connection *connectionForSocket(QBluetoothSocket *socket);
+    Connection *connectionForHandle(quint16 handle);
+    const QBluetoothAddress &peerAddress() const;
+    void selectConnection(Connection *client);
+    void servePeripheralClient(QBluetoothSocket *socket,
+                               void (QLowEnergyControllerPrivateBluez::*handler)());
+    void handlePeripheralClientDisconnected(QBluetoothSocket *socket);
+    void closeFurtherPeripheralClients();
+    void discardConnection(Connection &client);
+    bool isConnectedPeripheralClient(quint64 address) const;
+    quint16 clientConfiguration(QLowEnergyHandle configHandle) const;
+
     bool isBonded() const;
     QList<TempClientConfigurationData> gatherClientConfigData();
     void storeClientConfigurations();
@@ -200,22 +395,82 @@ private:
     enum SigningKeyType { LocalSigningKey, RemoteSigningKey };
     void loadSigningDataIfNecessary(SigningKeyType keyType);
     void storeSignCounter(SigningKeyType keyType) const;
+    quint32 reserveSignCounter(SigningData &data) const;
+    static LeBondStore::RecordType signCounterRecordType(SigningKeyType keyType);
+    LeBondStore::Key bondStoreKey(LeBondStore::RecordType type) const;
     QString signingKeySettingsGroup(SigningKeyType keyType) const;
     QString keySettingsFilePath() const;
 
+    bool isGattCacheEnabled() const;
+    QString gattCacheFilePath() const;
+    void readDatabaseHash();
+    void processDatabaseHashReply(const QByteArray &response, bool isErrorResponse);
+    bool restoreServicesFromCache();
+    void storeServicesInCache();
+    void storeServiceDetailsInCache(const QLowEnergyServicePrivate *service);
+    void watchServiceForCache(QLowEnergyServicePrivate *service);
+    void removeGattCache();
+
+    QByteArray readPacket(QBluetoothSocket *socket);
+    void recyclePacket(QByteArray &&packet);
+    void processIncomingPacket(const QByteArray &incomingPacket);
     void sendPacket(const QByteArray &packet);
+    bool writePacket(const QByteArray &packet);
+    void enqueueOutboundPacket(const QByteArray &packet);
+    bool flushOutboundQueue();
     void sendNextPendingRequest();
+    bool flushWriteCommands();
     void processReply(const Request &request, const QByteArray &reply);
-
+    void processTimedOutRequest(const Request &currentRequest);
+    void enqueueRequest(const QSharedPointer<QLowEnergyServicePrivate> &service,
+                        Request request);
+    void prependRequest(Request request);
+    static void queueRequest(QQueue<Request> &queue, bool headInFlight, Request request);
+    void queueRequest(Request request);
+    static bool isCancellableRequest(const Request &request, QLowEnergyServicePrivate *service);
+    quint16 attMtu() const;
+    bool retryRequestWithHigherSecurity(const Request &request, QBluezConst::AttError errorCode);
+
+    void establishEattBearers();
+    void eattBearerConnected(EattBearer *bearer);
+    void eattReadyRead(EattBearer *bearer);
+    void eattReadyWrite(EattBearer *bearer);
+    void waitForEattWritable(EattBearer *bearer);
+    void sendNextEattRequest(EattBearer *bearer);
+    void handleEattRequestTimeout(EattBearer *bearer);
+    void removeEattBearer(EattBearer *bearer);
+    EattBearer *bearerForService(const QSharedPointer<QLowEnergyServicePrivate> &service,
+                                 qsizetype packetSize) const;
+
+    void discoverPrimaryServices();
+    void finishServiceGroupDiscovery(quint16 type);
+    void finishServiceDiscovery();
+    void rediscoverServiceRange(QLowEnergyHandle start, QLowEnergyHandle end);
+    void startPendingRangeDiscovery();
+    void addDiscoveredService(const QBluetoothUuid &uuid, QLowEnergyHandle start,
+                              QLowEnergyHandle end, bool primary);
     void sendReadByGroupRequest(QLowEnergyHandle start, QLowEnergyHandle end,
                                 quint16 type);
+    void sendFindByTypeValueRequest(QLowEnergyHandle start, qsizetype filterIndex);
     void sendReadByTypeRequest(QSharedPointer<QLowEnergyServicePrivate> serviceData,
                                QLowEnergyHandle nextHandle, quint16 attributeType);
     void sendReadValueRequest(QLowEnergyHandle attributeHandle, bool isDescriptor);
     void readServiceValues(const QBluetoothUuid &service,
                            bool readCharacteristics);
     void readServiceValuesByOffset(uint handleData, quint16 offset,
-                                   bool isLastValue);
+                                   bool isLastValue, bool valueDiscovery);
+    Request createReadBlobRequest(uint handleData, quint16 offset, bool isLastValue);
+    bool startLongRead(uint handleData, const QByteArray &initialValue);
+    void sendLongReadRequest(uint handleData, LongRead &read, EattBearer *bearer);
+    void processLongReadResponse(const Request &request, const QByteArray &response,
+                                 bool isErrorResponse);
+    void finishLongRead(uint handleData);
+    Request createReadRequest(QLowEnergyHandle attributeHandle, uint handleData,
+                              bool isLastValue = false) const;
+    int fixedValueLength(const QSharedPointer<QLowEnergyServicePrivate> &service,
+                         uint handleData) const;
+    void processReadMultipleReply(const Request &request, const QByteArray &response,
+                                  bool isErrorResponse);
 
     void discoverServiceDescriptors(const QBluetoothUuid &serviceUuid);
     void discoverNextDescriptor(QSharedPointer<QLowEnergyServicePrivate> serviceData,
@@ -223,13 +478,16 @@ private:
                                 QLowEnergyHandle startingHandle);
     void processUnsolicitedReply(const QByteArray &msg);
     void exchangeMTU();
+    quint16 localRxMtu() const;
     bool setSecurityLevel(int level);
-    int securityLevel() const;
+    int securityLevel(const QBluetoothSocket *l2capSocket) const;
     void sendExecuteWriteRequest(const QLowEnergyHandle attrHandle,
                                  const QByteArray &newValue,
                                  bool isCancelation);
     void sendNextPrepareWriteRequest(const QLowEnergyHandle handle,
                                      const QByteArray &newValue, quint16 offset);
+    void cancelReliableWrite(quint32 id);
+    void finishReliableWrite(const Request &request, bool isErrorResponse);
     bool increaseEncryptLevelfRequired(QBluezConst::AttError errorCode);
 
     void resetController();
@@ -248,6 +506,7 @@ private:
     void handleReadRequest(const QByteArray &packet);
     void handleReadBlobRequest(const QByteArray &packet);
     void handleReadMultipleRequest(const QByteArray &packet);
+    void handleReadMultipleVariableRequest(const QByteArray &packet);
     void handleReadByGroupTypeRequest(const QByteArray &packet);
     void handleWriteRequestOrCommand(const QByteArray &packet);
     void handlePrepareWriteRequest(const QByteArray &packet);
@@ -256,31 +515,41 @@ private:
     void sendErrorResponse(QBluezConst::AttCommand request, quint16 handle,
                            QBluezConst::AttError code);
 
+    // read-only views into localAttributes
+    using AttributeList = QList<const Attribute *>;
     using ElemWriter = std::function<void(const Attribute &, char *&)>;
-    void sendListResponse(const QByteArray &packetStart, qsizetype elemSize,
-                          const QList<Attribute> &attributes, const ElemWriter &elemWriter);
+    QByteArray sendListResponse(QBluezConst::AttCommand opcode, qsizetype elemSize,
+                                const AttributeList &attributes, const ElemWriter &elemWriter);
+    QByteArray discoveryCacheKey(const QByteArray &request) const;
+    bool sendCachedDiscoveryResponse(const QByteArray &request);
+    void cacheDiscoveryResponse(const QByteArray &request, const QByteArray &response);
 
     void sendNotification(QLowEnergyHandle handle);
     void sendIndication(QLowEnergyHandle handle);
     void sendNotificationOrIndication(QBluezConst::AttCommand opCode, QLowEnergyHandle handle);
     void sendNextIndication();
+    void scheduleIndication(QLowEnergyHandle handle);
 
-    void ensureUniformAttributes(QList<Attribute> &attributes,
+    void ensureUniformAttributes(AttributeList &attributes,
                                  const std::function<int(const Attribute &)> &getSize);
-    void ensureUniformUuidSizes(QList<Attribute> &attributes);
-    void ensureUniformValueSizes(QList<Attribute> &attributes);
+    void ensureUniformUuidSizes(AttributeList &attributes);
+    void ensureUniformValueSizes(AttributeList &attributes);
 
     using AttributePredicate = std::function<bool(const Attribute &)>;
-    QList<Attribute> getAttributes(
-            QLowEnergyHandle startHandle, QLowEnergyHandle endHandle,
+    AttributeList getAttributes(
+            QLowEnergyHandle startHandle, QLowEnergyHandle endHandle, qsizetype maxCount,
+            const AttributePredicate &attributePredicate = [](const Attribute &) { return true; });
+    AttributeList getAttributesOfType(
+            QLowEnergyHandle startHandle, QLowEnergyHandle endHandle, qsizetype maxCount,
+            const QBluetoothUuid &type,
             const AttributePredicate &attributePredicate = [](const Attribute &) { return true; });
 
     QBluezConst::AttError checkPermissions(const Attribute &attr,
                                            QLowEnergyCharacteristic::PropertyType type);
     QBluezConst::AttError checkReadPermissions(const Attribute &attr);
-    QBluezConst::AttError checkReadPermissions(QList<Attribute> &attributes);
+    QBluezConst::AttError checkReadPermissions(AttributeList &attributes);
 
-    bool verifyMac(const QByteArray &message, const quint128 &csrk, quint32 signCounter,
+    bool verifyMac(QByteArrayView message, const quint128 &csrk, quint32 signCounter,
                    quint64 expectedMac);
 
     void updateLocalAttributeValue(
@@ -292,6 +561,10 @@ private:
     void writeCharacteristicForPeripheral(
             QLowEnergyServicePrivate::CharData &charData,
             const QByteArray &newValue);
+    void notifyPeripheralClients(const QLowEnergyServicePrivate::CharData &charData,
+                                 const Attribute &attribute);
+    void notifyPeripheralClient(QLowEnergyHandle valueHandle, QLowEnergyHandle configHandle,
+                                bool hasNotifyProperty, bool hasIndicateProperty);
     void writeCharacteristicForCentral(const QSharedPointer<QLowEnergyServicePrivate> &service,
             QLowEnergyHandle charHandle,
             QLowEnergyHandle valueHandle,
@@ -304,22 +577,41 @@ private:
             const QLowEnergyHandle descriptorHandle,
             const QByteArray &newValue);
     void writeDescriptorForCentral(
+            const QSharedPointer<QLowEnergyServicePrivate> &service,
             const QLowEnergyHandle charHandle,
             const QLowEnergyHandle descriptorHandle,
             const QByteArray &newValue);
 
     void restartRequestTimer();
     void establishL2cpClientSocket();
+    void startL2cpClientConnection();
+    void cancelAutoConnect();
+    bool isRemoteAddressRandom() const;
+    void connectHciManager();
+    void rebindHciManager();
+    void hciConnectionUpdated(quint16 handle,
+                              const QLowEnergyConnectionParameters &parameters) override;
+    void hciDataLengthChanged(quint16 handle, quint16 maxTxOctets, quint16 maxRxOctets) override;
+    void hciPhyUpdated(quint16 handle, quint8 txPhy, quint8 rxPhy) override;
+    void hciEncryptionChanged(quint16 handle, bool wasSuccess) override;
+    void hciSignatureResolvingKeyReceived(quint16 handle, bool remoteKey,
+                                          const quint128 &csrk) override;
     void createServicesForCentralIfRequired();
 
+    void startReplay();
+    void replaySentPacket(const QByteArray &packet);
+    void scheduleReplay();
+
 private slots:
     void l2cpConnected();
     void l2cpDisconnected();
     void l2cpErrorChanged(QBluetoothSocket::SocketError);
     void l2cpReadyRead();
-    void encryptionChangedEvent(const QBluetoothAddress&, bool);
+    void l2cpReadyWrite();
     void handleGattRequestTimeout();
     void activeConnectionTerminationDone();
+    void replayNextPacket();
+    void cachedServiceStateChanged(QLowEnergyService::ServiceState newState);
 };
 
 Q_DECLARE_TYPEINFO(QLowEnergyControllerPrivateBluez::Attribute, Q_RELOCATABLE_TYPE);
@@ -10,8 +10,21 @@
 #include "bluez/gattdesc1_p.h"
 #include "bluez/battery1_p.h"
 #include "bluez/objectmanager_p.h"
-#include "bluez/properties_p.h"
+#include "bluez/remotedevicemanager_p.h"
+#include "qbluetoothuuid_p.h"
+#include "qlowenergycharacteristicdata.h"
+#include "qlowenergydescriptordata.h"
+#include "qlowenergyservicedata.h"
+#include <qtbluetooth_tracepoints_p.h>
 
+#include <QtCore/qset.h>
+#include <QtCore/qsocketnotifier.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <errno.h>
+#include <sys/socket.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -27,10 +40,27 @@ QLowEnergyControllerPrivateBluezDBus::~QLowEnergyControllerPrivateBluezDBus()
     if (state != QLowEnergyController::UnconnectedState) {
         qCWarning(QT_BT_BLUEZ) << "Low Energy Controller deleted while connected.";
     }
+    // the application calls back into us
+    delete peripheralApplication;
+}
+
+QLowEnergyControllerPrivateBluezDBus::AcquiredSocket::~AcquiredSocket()
+{
+    // the notifier may be the sender of the signal we are called from
+    if (notifier) {
+        notifier->setEnabled(false);
+        notifier->deleteLater();
+    }
 }
 
 void QLowEnergyControllerPrivateBluezDBus::init()
 {
+    if (Q_UNLIKELY(!qEnvironmentVariableIsEmpty("QT_BLUETOOTH_DBUS_MAX_PENDING_JOBS"))) {
+        bool ok = false;
+        const int value = qEnvironmentVariableIntValue("QT_BLUETOOTH_DBUS_MAX_PENDING_JOBS", &ok);
+        if (ok && value > 0)
+            maxRunningJobs = value;
+    }
 }
 
 void QLowEnergyControllerPrivateBluezDBus::devicePropertiesChanged(
@@ -82,9 +112,8 @@ void QLowEnergyControllerPrivateBluezDBus::devicePropertiesChanged(
 
         if (changedProperties.contains(QStringLiteral("UUIDs"))) {
             const QStringList newUuidStringList = changedProperties.value(QStringLiteral("UUIDs")).toStringList();
-            QList<QBluetoothUuid> newUuidList;
-            for (const QString &uuidString : newUuidStringList)
-                newUuidList.append(QBluetoothUuid(uuidString));
+            const QList<QBluetoothUuid> newUuidList =
+                    qt_bluetoothUuidsFromStrings(newUuidStringList);
 
             for (const QBluetoothUuid &uuid : serviceList.keys()) {
                 if (!newUuidList.contains(uuid)) {
@@ -136,8 +165,11 @@ void QLowEnergyControllerPrivateBluezDBus::devicePropertiesChanged(
                 if (cccActive && newValue != charData.value) {
                     qCDebug(QT_BT_BLUEZ) << "Property update for Battery1";
                     charData.value = newValue;
+                    Q_TRACE(QLowEnergyController_notificationReceived, TraceNotification,
+                            iter.key(), int(newValue.size()));
+                    requestStatistics.recordNotification();
                     QLowEnergyCharacteristic ch(serviceData, iter.key());
-                    emit serviceData->characteristicChanged(ch, newValue);
+                    serviceData->notifyCharacteristicChanged(ch, newValue);
                 }
 
                 break;
@@ -159,20 +191,33 @@ void QLowEnergyControllerPrivateBluezDBus::characteristicPropertiesChanged(
     if (!changedProperties.contains(QStringLiteral("Value")))
         return;
 
+    characteristicValueChanged(charHandle,
+                               changedProperties.value(QStringLiteral("Value")).toByteArray());
+}
+
+/*
+    Handles a notification or indication, either received as change of the
+    Value property or via the socket returned by AcquireNotify().
+ */
+void QLowEnergyControllerPrivateBluezDBus::characteristicValueChanged(
+        QLowEnergyHandle charHandle, const QByteArray &newValue)
+{
+    Q_TRACE(QLowEnergyController_notificationReceived, TraceNotification, charHandle,
+            int(newValue.size()));
+    requestStatistics.recordNotification();
+
     const QLowEnergyCharacteristic changedChar = characteristicForHandle(charHandle);
     const QLowEnergyDescriptor ccnDescriptor = changedChar.descriptor(
                                     QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration);
     if (!ccnDescriptor.isValid())
         return;
 
-    const QByteArray newValue = changedProperties.value(QStringLiteral("Value")).toByteArray();
-    if (changedChar.properties() & QLowEnergyCharacteristic::Read)
-        updateValueOfCharacteristic(charHandle, newValue, false); //TODO upgrade to NEW_VALUE/APPEND_VALUE
+    updateValueOfChangedCharacteristic(changedChar, newValue);
 
     auto service = serviceForHandle(charHandle);
 
     if (!service.isNull())
-        emit service->characteristicChanged(changedChar, newValue);
+        service->notifyCharacteristicChanged(changedChar, newValue);
 }
 
 void QLowEnergyControllerPrivateBluezDBus::interfacesRemoved(const QDBusObjectPath &objectPath,
@@ -214,12 +259,17 @@ void QLowEnergyControllerPrivateBluezDBus::resetController()
         deviceMonitor = nullptr;
     }
 
+    if (batteryMonitor) {
+        delete batteryMonitor;
+        batteryMonitor = nullptr;
+    }
+
     dbusServices.clear();
     jobs.clear();
+    runningJobs.clear();
     invalidateServices();
 
     pendingConnect = disconnectSignalRequired = false;
-    jobPending = false;
 }
 
 void QLowEnergyControllerPrivateBluezDBus::connectToDeviceHelper()
@@ -237,16 +287,16 @@ void QLowEnergyControllerPrivateBluezDBus::connectToDeviceHelper()
     auto manager = std::make_unique<OrgFreedesktopDBusObjectManagerInterface>(
             QStringLiteral("org.bluez"), QStringLiteral("/"), QDBusConnection::systemBus());
 
-    QDBusPendingReply<ManagedObjectList> reply = manager->GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError()) {
+    QDBusError error;
+    const ManagedObjectList managedObjectList =
+            QtBluezObjectCache::instance()->managedObjects(&error);
+    if (error.isValid()) {
         qCWarning(QT_BT_BLUEZ) << "Cannot enumerate Bluetooth devices for GATT connect";
         setError(QLowEnergyController::ConnectionError);
         return;
     }
 
     QString devicePath;
-    ManagedObjectList managedObjectList = reply.value();
     for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
         const InterfaceList &ifaceList = it.value();
 
@@ -278,6 +328,7 @@ void QLowEnergyControllerPrivateBluezDBus::connectToDeviceHelper()
     }
 
     managerBluez = manager.release();
+    managerBluez->setParent(this);
     connect(managerBluez, &OrgFreedesktopDBusObjectManagerInterface::InterfacesRemoved,
             this, &QLowEnergyControllerPrivateBluezDBus::interfacesRemoved);
     adapter = new OrgBluezAdapter1Interface(
@@ -286,10 +337,14 @@ void QLowEnergyControllerPrivateBluezDBus::connectToDeviceHelper()
     device = new OrgBluezDevice1Interface(
                                 QStringLiteral("org.bluez"), devicePath,
                                 QDBusConnection::systemBus(), this);
-    deviceMonitor = new OrgFreedesktopDBusPropertiesInterface(
-                                QStringLiteral("org.bluez"), devicePath,
-                                QDBusConnection::systemBus(), this);
-    connect(deviceMonitor, &OrgFreedesktopDBusPropertiesInterface::PropertiesChanged,
+    deviceMonitor = new QtBluezPropertiesMonitor(
+                                devicePath, QStringLiteral("org.bluez.Device1"), this);
+    connect(deviceMonitor, &QtBluezPropertiesMonitor::PropertiesChanged,
+            this, &QLowEnergyControllerPrivateBluezDBus::devicePropertiesChanged);
+    // Battery1 lives on the device object too, see devicePropertiesChanged()
+    batteryMonitor = new QtBluezPropertiesMonitor(
+                                devicePath, QStringLiteral("org.bluez.Battery1"), this);
+    connect(batteryMonitor, &QtBluezPropertiesMonitor::PropertiesChanged,
             this, &QLowEnergyControllerPrivateBluezDBus::devicePropertiesChanged);
 }
 
@@ -341,6 +396,26 @@ void QLowEnergyControllerPrivateBluezDBus::connectToDevice()
 
 void QLowEnergyControllerPrivateBluezDBus::disconnectFromDevice()
 {
+    if (role == QLowEnergyController::PeripheralRole) {
+        if (peripheralCentrals.isEmpty())
+            return;
+
+        setState(QLowEnergyController::ClosingState);
+        auto manager = new RemoteDeviceManager(localAdapter, this);
+        connect(manager, &RemoteDeviceManager::finished, this, [this, manager]() {
+            manager->deleteLater();
+            // the disconnects may have been reported already
+            if (state == QLowEnergyController::ClosingState)
+                peripheralDisconnected();
+        });
+        if (!manager->scheduleJob(RemoteDeviceManager::JobType::JobDisconnectDevice,
+                                  peripheralCentrals.values())) {
+            manager->deleteLater();
+            peripheralDisconnected();
+        }
+        return;
+    }
+
     if (!device)
         return;
 
@@ -365,9 +440,10 @@ void QLowEnergyControllerPrivateBluezDBus::disconnectFromDevice()
 
 void QLowEnergyControllerPrivateBluezDBus::discoverServices()
 {
-    QDBusPendingReply<ManagedObjectList> reply = managerBluez->GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError()) {
+    QDBusError error;
+    const ManagedObjectList managedObjectList =
+            QtBluezObjectCache::instance()->managedObjects(&error);
+    if (error.isValid()) {
         qCWarning(QT_BT_BLUEZ) << "Cannot discover services";
         setError(QLowEnergyController::UnknownError);
         setState(QLowEnergyController::DiscoveredState);
@@ -379,6 +455,9 @@ void QLowEnergyControllerPrivateBluezDBus::discoverServices()
     auto setupServicePrivate = [&, q](
             QLowEnergyService::ServiceType type, const QBluetoothUuid &uuid,
             const QString &path, const bool battery1Interface = false){
+        if (!isServiceInDiscoveryFilter(uuid))
+            return;
+
         QSharedPointer<QLowEnergyServicePrivate> priv = QSharedPointer<QLowEnergyServicePrivate>::create();
         priv->uuid = uuid;
         priv->type = type; // we make a guess we cannot validate
@@ -398,7 +477,6 @@ void QLowEnergyControllerPrivateBluezDBus::discoverServices()
         emit q->serviceDiscovered(priv->uuid);
     };
 
-    const ManagedObjectList managedObjectList = reply.value();
     const QString servicePathPrefix = device->path().append(QStringLiteral("/service"));
 
     // The Bluez battery service (0x180f) support has evolved over time and needs additional logic:
@@ -570,9 +648,10 @@ void QLowEnergyControllerPrivateBluezDBus::discoverServiceDetails(
         return;
     }
 
-    QDBusPendingReply<ManagedObjectList> reply = managerBluez->GetManagedObjects();
-    reply.waitForFinished();
-    if (reply.isError()) {
+    QDBusError error;
+    const ManagedObjectList managedObjectList =
+            QtBluezObjectCache::instance()->managedObjects(&error);
+    if (error.isValid()) {
         qCWarning(QT_BT_BLUEZ) << "Cannot discover services";
         setError(QLowEnergyController::UnknownError);
         setState(QLowEnergyController::DiscoveredState);
@@ -580,7 +659,6 @@ void QLowEnergyControllerPrivateBluezDBus::discoverServiceDetails(
     }
 
     QStringList descriptorPaths;
-    const ManagedObjectList managedObjectList = reply.value();
     for (ManagedObjectList::const_iterator it = managedObjectList.constBegin(); it != managedObjectList.constEnd(); ++it) {
         const InterfaceList &ifaceList = it.value();
         if (!it.key().path().startsWith(dbusData.servicePath))
@@ -621,6 +699,7 @@ void QLowEnergyControllerPrivateBluezDBus::discoverServiceDetails(
     serviceData->startHandle = runningHandle++;
     for (GattCharacteristic &dbusChar : dbusData.characteristics) {
         const QLowEnergyHandle indexHandle = runningHandle++;
+        dbusChar.handle = indexHandle;
         QLowEnergyServicePrivate::CharData charData;
 
         // characteristic data
@@ -652,13 +731,14 @@ void QLowEnergyControllerPrivateBluezDBus::discoverServiceDetails(
         charData.uuid = QBluetoothUuid(dbusChar.characteristic->uUID());
 
         // schedule read for initial char value
-        if (mode == QLowEnergyService::FullDiscovery
+        if (serviceData->isDiscoveryTarget(charData.uuid,
+                                           QLowEnergyService::CharacteristicValueDiscovery)
             && charData.properties.testFlag(QLowEnergyCharacteristic::Read)) {
             GattJob job;
             job.flags = GattJob::JobFlags({GattJob::CharRead, GattJob::ServiceDiscovery});
             job.service = serviceData;
             job.handle = indexHandle;
-            jobs.append(job);
+            appendJob(job);
         }
 
         // descriptor data
@@ -672,11 +752,11 @@ void QLowEnergyControllerPrivateBluezDBus::discoverServiceDetails(
             // every ClientCharacteristicConfiguration needs to track property changes
             if (descData.uuid
                         == QBluetoothUuid(QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration)) {
-                dbusChar.charMonitor = QSharedPointer<OrgFreedesktopDBusPropertiesInterface>::create(
-                                                QStringLiteral("org.bluez"),
+                dbusChar.charMonitor = QSharedPointer<QtBluezPropertiesMonitor>::create(
                                                 dbusChar.characteristic->path(),
-                                                QDBusConnection::systemBus(), this);
-                connect(dbusChar.charMonitor.data(), &OrgFreedesktopDBusPropertiesInterface::PropertiesChanged,
+                                                QStringLiteral("org.bluez.GattCharacteristic1"),
+                                                this);
+                connect(dbusChar.charMonitor.data(), &QtBluezPropertiesMonitor::PropertiesChanged,
                         this, [this, indexHandle](const QString &interface, const QVariantMap &changedProperties,
                         const QStringList &removedProperties) {
 
@@ -685,13 +765,14 @@ void QLowEnergyControllerPrivateBluezDBus::discoverServiceDetails(
                 });
             }
 
-            if (mode == QLowEnergyService::FullDiscovery) {
+            if (serviceData->isDiscoveryTarget(charData.uuid,
+                                               QLowEnergyService::DescriptorValueDiscovery)) {
                 // schedule read for initial descriptor value
                 GattJob job;
                 job.flags = GattJob::JobFlags({ GattJob::DescRead, GattJob::ServiceDiscovery });
                 job.service = serviceData;
                 job.handle = descriptorHandle;
-                jobs.append(job);
+                appendJob(job);
             }
         }
 
@@ -700,42 +781,65 @@ void QLowEnergyControllerPrivateBluezDBus::discoverServiceDetails(
 
     serviceData->endHandle = runningHandle++;
 
-    // last job is last step of service discovery
-    if (!jobs.isEmpty()) {
-        GattJob &lastJob = jobs.last();
-        lastJob.flags.setFlag(GattJob::LastServiceDiscovery, true);
-    } else {
+    // the service is discovered once the last of its jobs has finished
+    if (!hasPendingDiscoveryJobs(serviceData))
         serviceData->setState(QLowEnergyService::RemoteServiceDiscovered);
-    }
 
     scheduleNextJob();
 }
 
-void QLowEnergyControllerPrivateBluezDBus::prepareNextJob()
+bool QLowEnergyControllerPrivateBluezDBus::hasPendingDiscoveryJobs(
+        const QSharedPointer<QLowEnergyServicePrivate> &service) const
 {
-    jobs.takeFirst(); // finish last job
-    jobPending = false;
+    const auto isDiscoveryJob = [&service](const GattJob &job) {
+        return job.flags.testFlag(GattJob::ServiceDiscovery) && job.service == service
+                && !job.cancelled;
+    };
+    return std::any_of(jobs.cbegin(), jobs.cend(), isDiscoveryJob)
+            || std::any_of(runningJobs.cbegin(), runningJobs.cend(), isDiscoveryJob);
+}
+
+void QLowEnergyControllerPrivateBluezDBus::jobFinished(const GattJob &job)
+{
+    if (job.flags.testFlag(GattJob::ServiceDiscovery) && !job.cancelled && !job.service.isNull()
+            && job.service->state == QLowEnergyService::RemoteServiceDiscovering
+            && !hasPendingDiscoveryJobs(job.service)) {
+        job.service->setState(QLowEnergyService::RemoteServiceDiscovered);
+    }
+}
+
+void QLowEnergyControllerPrivateBluezDBus::prepareNextJob(QDBusPendingCallWatcher *call)
+{
+    const GattJob job = runningJobs.take(call);
+    requestStatistics.recordRequest(operationOfJob(job), job.queuedAt, job.sentAt);
+    jobFinished(job); // finish last job
 
     scheduleNextJob(); // continue with next job - if available
 }
 
 void QLowEnergyControllerPrivateBluezDBus::onCharReadFinished(QDBusPendingCallWatcher *call)
 {
-    if (!jobPending || jobs.isEmpty()) {
+    if (!runningJobs.contains(call)) {
         // this may happen when service disconnects before dbus watcher returns later on
         qCWarning(QT_BT_BLUEZ) << "Aborting onCharReadFinished due to disconnect";
         Q_ASSERT(state == QLowEnergyController::UnconnectedState);
         return;
     }
 
-    const GattJob nextJob = jobs.constFirst();
+    const GattJob nextJob = runningJobs.value(call);
     Q_ASSERT(nextJob.flags.testFlag(GattJob::CharRead));
 
+    if (nextJob.cancelled) {
+        call->deleteLater();
+        prepareNextJob(call);
+        return;
+    }
+
     QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(nextJob.handle);
     if (service.isNull() || !dbusServices.contains(service->uuid)) {
         qCWarning(QT_BT_BLUEZ) << "onCharReadFinished: Invalid GATT job. Skipping.";
         call->deleteLater();
-        prepareNextJob();
+        prepareNextJob(call);
         return;
     }
     const QLowEnergyServicePrivate::CharData &charData =
@@ -743,6 +847,8 @@ void QLowEnergyControllerPrivateBluezDBus::onCharReadFinished(QDBusPendingCallWa
 
     bool isServiceDiscovery = nextJob.flags.testFlag(GattJob::ServiceDiscovery);
     QDBusPendingReply<QByteArray> reply = *call;
+    Q_TRACE(QLowEnergyController_responseReceived, TraceReadResponse, nextJob.handle,
+            int(reply.value().size()));
     if (reply.isError()) {
         qCWarning(QT_BT_BLUEZ) << "Cannot initiate reading of" << charData.uuid
                                << "of service" << service->uuid
@@ -754,36 +860,39 @@ void QLowEnergyControllerPrivateBluezDBus::onCharReadFinished(QDBusPendingCallWa
         if (charData.properties.testFlag(QLowEnergyCharacteristic::Read))
             updateValueOfCharacteristic(nextJob.handle, reply.value(), false);
 
-        if (isServiceDiscovery) {
-            if (nextJob.flags.testFlag(GattJob::LastServiceDiscovery))
-                service->setState(QLowEnergyService::RemoteServiceDiscovered);
-        } else {
+        if (!isServiceDiscovery) {
             QLowEnergyCharacteristic ch(service, nextJob.handle);
             emit service->characteristicRead(ch, reply.value());
         }
     }
 
     call->deleteLater();
-    prepareNextJob();
+    prepareNextJob(call);
 }
 
 void QLowEnergyControllerPrivateBluezDBus::onDescReadFinished(QDBusPendingCallWatcher *call)
 {
-    if (!jobPending || jobs.isEmpty()) {
+    if (!runningJobs.contains(call)) {
         // this may happen when service disconnects before dbus watcher returns later on
         qCWarning(QT_BT_BLUEZ) << "Aborting onDescReadFinished due to disconnect";
         Q_ASSERT(state == QLowEnergyController::UnconnectedState);
         return;
     }
 
-    const GattJob nextJob = jobs.constFirst();
+    const GattJob nextJob = runningJobs.value(call);
     Q_ASSERT(nextJob.flags.testFlag(GattJob::DescRead));
 
+    if (nextJob.cancelled) {
+        call->deleteLater();
+        prepareNextJob(call);
+        return;
+    }
+
     QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(nextJob.handle);
     if (service.isNull() || !dbusServices.contains(service->uuid)) {
         qCWarning(QT_BT_BLUEZ) << "onDescReadFinished: Invalid GATT job. Skipping.";
         call->deleteLater();
-        prepareNextJob();
+        prepareNextJob(call);
         return;
     }
 
@@ -791,7 +900,7 @@ void QLowEnergyControllerPrivateBluezDBus::onDescReadFinished(QDBusPendingCallWa
     if (!ch.isValid()) {
         qCWarning(QT_BT_BLUEZ) << "Cannot find char for desc read (onDescReadFinished 1).";
         call->deleteLater();
-        prepareNextJob();
+        prepareNextJob(call);
         return;
     }
 
@@ -801,13 +910,15 @@ void QLowEnergyControllerPrivateBluezDBus::onDescReadFinished(QDBusPendingCallWa
     if (!charData.descriptorList.contains(nextJob.handle)) {
         qCWarning(QT_BT_BLUEZ) << "Cannot find descriptor (onDescReadFinished 2).";
         call->deleteLater();
-        prepareNextJob();
+        prepareNextJob(call);
         return;
     }
 
     bool isServiceDiscovery = nextJob.flags.testFlag(GattJob::ServiceDiscovery);
 
     QDBusPendingReply<QByteArray> reply = *call;
+    Q_TRACE(QLowEnergyController_responseReceived, TraceReadResponse, nextJob.handle,
+            int(reply.value().size()));
     if (reply.isError()) {
         qCWarning(QT_BT_BLUEZ) << "Cannot read descriptor (onDescReadFinished 3): "
                              << charData.descriptorList[nextJob.handle].uuid
@@ -819,36 +930,33 @@ void QLowEnergyControllerPrivateBluezDBus::onDescReadFinished(QDBusPendingCallWa
         qCDebug(QT_BT_BLUEZ) << "Read Desc:" << reply.value();
         updateValueOfDescriptor(ch.attributeHandle(), nextJob.handle, reply.value(), false);
 
-        if (isServiceDiscovery) {
-            if (nextJob.flags.testFlag(GattJob::LastServiceDiscovery))
-                service->setState(QLowEnergyService::RemoteServiceDiscovered);
-        } else {
+        if (!isServiceDiscovery) {
             QLowEnergyDescriptor desc(service, ch.attributeHandle(), nextJob.handle);
             emit service->descriptorRead(desc, reply.value());
         }
     }
 
     call->deleteLater();
-    prepareNextJob();
+    prepareNextJob(call);
 }
 
 void QLowEnergyControllerPrivateBluezDBus::onCharWriteFinished(QDBusPendingCallWatcher *call)
 {
-    if (!jobPending || jobs.isEmpty()) {
+    if (!runningJobs.contains(call)) {
         // this may happen when service disconnects before dbus watcher returns later on
         qCWarning(QT_BT_BLUEZ) << "Aborting onCharWriteFinished due to disconnect";
         Q_ASSERT(state == QLowEnergyController::UnconnectedState);
         return;
     }
 
-    const GattJob nextJob = jobs.constFirst();
+    const GattJob nextJob = runningJobs.value(call);
     Q_ASSERT(nextJob.flags.testFlag(GattJob::CharWrite));
 
     QSharedPointer<QLowEnergyServicePrivate> service = nextJob.service;
     if (!dbusServices.contains(service->uuid)) {
         qCWarning(QT_BT_BLUEZ) << "onCharWriteFinished: Invalid GATT job. Skipping.";
         call->deleteLater();
-        prepareNextJob();
+        prepareNextJob(call);
         return;
     }
 
@@ -856,6 +964,8 @@ void QLowEnergyControllerPrivateBluezDBus::onCharWriteFinished(QDBusPendingCallW
                         service->characteristicList.value(nextJob.handle);
 
     QDBusPendingReply<> reply = *call;
+    Q_TRACE(QLowEnergyController_responseReceived, TraceWriteResponse, nextJob.handle,
+            int(nextJob.value.size()));
     if (reply.isError()) {
         qCWarning(QT_BT_BLUEZ) << "Cannot initiate writing of" << charData.uuid
                                << "of service" << service->uuid
@@ -874,26 +984,26 @@ void QLowEnergyControllerPrivateBluezDBus::onCharWriteFinished(QDBusPendingCallW
     }
 
     call->deleteLater();
-    prepareNextJob();
+    prepareNextJob(call);
 }
 
 void QLowEnergyControllerPrivateBluezDBus::onDescWriteFinished(QDBusPendingCallWatcher *call)
 {
-    if (!jobPending || jobs.isEmpty()) {
+    if (!runningJobs.contains(call)) {
         // this may happen when service disconnects before dbus watcher returns later on
         qCWarning(QT_BT_BLUEZ) << "Aborting onDescWriteFinished due to disconnect";
         Q_ASSERT(state == QLowEnergyController::UnconnectedState);
         return;
     }
 
-    const GattJob nextJob = jobs.constFirst();
+    const GattJob nextJob = runningJobs.value(call);
     Q_ASSERT(nextJob.flags.testFlag(GattJob::DescWrite));
 
     QSharedPointer<QLowEnergyServicePrivate> service = nextJob.service;
     if (!dbusServices.contains(service->uuid)) {
         qCWarning(QT_BT_BLUEZ) << "onDescWriteFinished: Invalid GATT job. Skipping.";
         call->deleteLater();
-        prepareNextJob();
+        prepareNextJob(call);
         return;
     }
 
@@ -903,11 +1013,13 @@ void QLowEnergyControllerPrivateBluezDBus::onDescWriteFinished(QDBusPendingCallW
         qCWarning(QT_BT_BLUEZ) << "onDescWriteFinished: Cannot find associated char/desc: "
                                << associatedChar.isValid();
         call->deleteLater();
-        prepareNextJob();
+        prepareNextJob(call);
         return;
     }
 
     QDBusPendingReply<> reply = *call;
+    Q_TRACE(QLowEnergyController_responseReceived, TraceWriteResponse, nextJob.handle,
+            int(nextJob.value.size()));
     if (reply.isError()) {
         qCWarning(QT_BT_BLUEZ) << "Cannot initiate writing of" << descriptor.uuid()
                                << "of char" << associatedChar.uuid()
@@ -915,39 +1027,360 @@ void QLowEnergyControllerPrivateBluezDBus::onDescWriteFinished(QDBusPendingCallW
                                << reply.error().name() << reply.error().message();
         service->setError(QLowEnergyService::DescriptorWriteError);
     } else {
-        qCDebug(QT_BT_BLUEZ) << "Write Desc:" << descriptor.uuid() << nextJob.value.toHex();
-        updateValueOfDescriptor(associatedChar.attributeHandle(), nextJob.handle,
-                                nextJob.value, false);
-        emit service->descriptorWritten(descriptor, nextJob.value);
+        finishDescriptorWrite(nextJob);
     }
 
     call->deleteLater();
-    prepareNextJob();
+    prepareNextJob(call);
+}
+
+void QLowEnergyControllerPrivateBluezDBus::finishDescriptorWrite(const GattJob &job)
+{
+    const QLowEnergyCharacteristic associatedChar = characteristicForHandle(job.handle);
+    const QLowEnergyDescriptor descriptor = descriptorForHandle(job.handle);
+
+    qCDebug(QT_BT_BLUEZ) << "Write Desc:" << descriptor.uuid() << job.value.toHex();
+    updateValueOfDescriptor(associatedChar.attributeHandle(), job.handle, job.value, false);
+    emit job.service->descriptorWritten(descriptor, job.value);
+}
+
+void QLowEnergyControllerPrivateBluezDBus::onAcquireNotifyFinished(QDBusPendingCallWatcher *call)
+{
+    if (!runningJobs.contains(call)) {
+        // this may happen when service disconnects before dbus watcher returns later on
+        qCWarning(QT_BT_BLUEZ) << "Aborting onAcquireNotifyFinished due to disconnect";
+        Q_ASSERT(state == QLowEnergyController::UnconnectedState);
+        return;
+    }
+
+    const GattJob nextJob = runningJobs.value(call);
+    Q_ASSERT(nextJob.flags.testFlag(GattJob::DescWrite));
+
+    QDBusPendingReply<QDBusUnixFileDescriptor, ushort> reply = *call;
+    Q_TRACE(QLowEnergyController_responseReceived, TraceWriteResponse, nextJob.handle,
+            int(nextJob.value.size()));
+    call->deleteLater();
+
+    const QLowEnergyCharacteristic associatedChar = characteristicForHandle(nextJob.handle);
+    GattCharacteristic *gattChar = associatedChar.isValid()
+            ? dbusCharacteristic(associatedChar.attributeHandle()) : nullptr;
+    if (!gattChar || !dbusServices.contains(nextJob.service->uuid)) {
+        qCWarning(QT_BT_BLUEZ) << "onAcquireNotifyFinished: Invalid GATT job. Skipping.";
+        prepareNextJob(call);
+        return;
+    }
+
+    if (reply.isError()) {
+        // BlueZ older than 5.46, or another client uses StartNotify() already
+        qCDebug(QT_BT_BLUEZ) << "AcquireNotify failed for" << associatedChar.uuid()
+                             << reply.error().name() << "- falling back to StartNotify";
+        gattChar->notifyAcquireFailed = true;
+        QDBusPendingReply<> startReply = gattChar->characteristic->StartNotify();
+        QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(startReply, this);
+        connect(watcher, &QDBusPendingCallWatcher::finished,
+                this, &QLowEnergyControllerPrivateBluezDBus::onDescWriteFinished);
+        runningJobs.insert(watcher, runningJobs.take(call));
+        return;
+    }
+
+    gattChar->notifySocket = createAcquiredSocket(reply.argumentAt<0>(), reply.argumentAt<1>(),
+                                                  associatedChar.attributeHandle(), true);
+    finishDescriptorWrite(nextJob);
+    prepareNextJob(call);
+}
+
+/*
+    Returns the D-Bus data of the characteristic \a charHandle without
+    calling into D-Bus, or \c nullptr if there is none.
+ */
+QLowEnergyControllerPrivateBluezDBus::GattCharacteristic *
+QLowEnergyControllerPrivateBluezDBus::dbusCharacteristic(QLowEnergyHandle charHandle)
+{
+    const QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
+    if (service.isNull())
+        return nullptr;
+
+    auto it = dbusServices.find(service->uuid);
+    if (it == dbusServices.end())
+        return nullptr;
+
+    for (GattCharacteristic &gattChar : it->characteristics) {
+        if (gattChar.handle == charHandle)
+            return &gattChar;
+    }
+    return nullptr;
+}
+
+bool QLowEnergyControllerPrivateBluezDBus::canAcquireSockets() const
+{
+    return QDBusConnection::systemBus().connectionCapabilities()
+            .testFlag(QDBusConnection::UnixFileDescriptorPassing);
+}
+
+/*
+    Sends a Write Without Response via the socket returned by AcquireWrite(),
+    which avoids the D-Bus round trip per packet. Returns \c false if the
+    write has to go through WriteValue() instead.
+ */
+bool QLowEnergyControllerPrivateBluezDBus::writeWithoutResponseViaSocket(const GattJob &job)
+{
+    GattCharacteristic *gattChar = dbusCharacteristic(job.handle);
+    if (!gattChar)
+        return false;
+
+    const QLowEnergyServicePrivate::CharData &charData =
+                        job.service->characteristicList.value(job.handle);
+    if (!charData.properties.testFlag(QLowEnergyCharacteristic::WriteNoResponse))
+        return false;
+
+    const QSharedPointer<AcquiredSocket> socket = gattChar->writeSocket;
+    if (!socket) {
+        // this write still goes via D-Bus, the following ones may use the socket
+        acquireWriteSocket(gattChar);
+        return false;
+    }
+
+    // the socket never fragments, longer values are truncated by WriteValue() as well
+    if (socket->mtu > 3 && job.value.size() > socket->mtu - 3)
+        return false;
+
+    const ssize_t written = ::send(socket->fd.fileDescriptor(), job.value.constData(),
+                                   job.value.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (written != job.value.size()) {
+        if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            qCDebug(QT_BT_BLUEZ) << "Releasing write socket of" << charData.uuid
+                                 << qt_error_string(errno);
+            gattChar->writeSocket.reset();
+        }
+        return false;
+    }
+
+    if (charData.properties.testFlag(QLowEnergyCharacteristic::Read))
+        updateValueOfCharacteristic(job.handle, job.value, false);
+    return true;
+}
+
+void QLowEnergyControllerPrivateBluezDBus::acquireWriteSocket(GattCharacteristic *gattChar)
+{
+    if (gattChar->writeAcquireAttempted || !canAcquireSockets())
+        return;
+    gattChar->writeAcquireAttempted = true;
+
+    const QLowEnergyHandle charHandle = gattChar->handle;
+    const QString path = gattChar->characteristic->path();
+    QDBusPendingReply<QDBusUnixFileDescriptor, ushort> reply =
+            gattChar->characteristic->AcquireWrite(QVariantMap());
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this,
+            [this, charHandle, path](QDBusPendingCallWatcher *call) {
+        QDBusPendingReply<QDBusUnixFileDescriptor, ushort> reply = *call;
+        call->deleteLater();
+
+        // the service may have been rediscovered or the device disconnected meanwhile
+        GattCharacteristic *gattChar = dbusCharacteristic(charHandle);
+        if (!gattChar || gattChar->characteristic->path() != path)
+            return;
+
+        if (reply.isError()) {
+            qCDebug(QT_BT_BLUEZ) << "AcquireWrite not available for" << path
+                                 << reply.error().name();
+            return;
+        }
+
+        gattChar->writeSocket = createAcquiredSocket(reply.argumentAt<0>(), reply.argumentAt<1>(),
+                                                     charHandle, false);
+    });
+}
+
+QSharedPointer<QLowEnergyControllerPrivateBluezDBus::AcquiredSocket>
+QLowEnergyControllerPrivateBluezDBus::createAcquiredSocket(const QDBusUnixFileDescriptor &fd,
+                                                           quint16 mtu,
+                                                           QLowEnergyHandle charHandle,
+                                                           bool notify)
+{
+    qCDebug(QT_BT_BLUEZ) << "Acquired" << (notify ? "notify" : "write") << "socket for handle"
+                         << charHandle << "mtu:" << mtu;
+
+    auto socket = QSharedPointer<AcquiredSocket>::create();
+    socket->fd = fd;
+    socket->mtu = mtu;
+    // BlueZ closes its end when the link goes down, which also wakes up the write socket
+    socket->notifier = new QSocketNotifier(fd.fileDescriptor(), QSocketNotifier::Read, this);
+    connect(socket->notifier, &QSocketNotifier::activated, this, [this, charHandle, notify]() {
+        readAcquiredSocket(charHandle, notify);
+    });
+    return socket;
+}
+
+void QLowEnergyControllerPrivateBluezDBus::readAcquiredSocket(QLowEnergyHandle charHandle,
+                                                              bool notify)
+{
+    GattCharacteristic *gattChar = dbusCharacteristic(charHandle);
+    if (!gattChar)
+        return;
+
+    // keeps the socket alive even if a slot connected to a signal emitted below releases it
+    const QSharedPointer<AcquiredSocket> socket = notify ? gattChar->notifySocket
+                                                         : gattChar->writeSocket;
+    if (!socket)
+        return;
+
+    // each datagram carries exactly one value
+    QByteArray buffer(qMax<int>(socket->mtu, 512), Qt::Uninitialized);
+    while (true) {
+        const ssize_t size = ::recv(socket->fd.fileDescriptor(), buffer.data(), buffer.size(),
+                                    MSG_DONTWAIT);
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+
+        if (size <= 0) {
+            qCDebug(QT_BT_BLUEZ) << "BlueZ released the" << (notify ? "notify" : "write")
+                                 << "socket of handle" << charHandle;
+            gattChar = dbusCharacteristic(charHandle);
+            if (gattChar && notify && gattChar->notifySocket == socket)
+                gattChar->notifySocket.reset();
+            else if (gattChar && !notify && gattChar->writeSocket == socket)
+                gattChar->writeSocket.reset();
+            return;
+        }
+
+        if (notify)
+            characteristicValueChanged(charHandle, QByteArray(buffer.constData(), size));
+
+        // the signal handlers may have disconnected or rediscovered the service
+        gattChar = dbusCharacteristic(charHandle);
+        if (!gattChar || (notify ? gattChar->notifySocket : gattChar->writeSocket) != socket)
+            return;
+    }
+}
+
+/*
+    Starts as many queued jobs as the limit of concurrently running jobs permits.
+    BlueZ queues the resulting ATT requests itself, running several jobs hides the
+    D-Bus round trips. Jobs are only ordered per characteristic, a job has to wait
+    while an earlier one for the same characteristic or its descriptors is queued
+    or running.
+ */
+void QLowEnergyControllerPrivateBluezDBus::appendJob(const GattJob &job)
+{
+    Q_TRACE(QLowEnergyController_requestQueued, traceOpcodeOfJob(job), job.handle,
+            int(job.value.size()));
+    jobs.append(job);
+    jobs.last().queuedAt = QLowEnergyRequestRecorder::Clock::now();
+}
+
+/*
+    Returns the opcode of the ATT request which BlueZ sends for \a job.
+ */
+int QLowEnergyControllerPrivateBluezDBus::traceOpcodeOfJob(const GattJob &job)
+{
+    if (job.flags & (GattJob::CharRead | GattJob::DescRead))
+        return TraceReadRequest;
+    if (job.flags.testFlag(GattJob::CharWrite)
+            && job.writeMode == QLowEnergyService::WriteWithoutResponse) {
+        return TraceWriteCommand;
+    }
+    return TraceWriteRequest;
+}
+
+QLowEnergyRequestStatistics::Operation
+QLowEnergyControllerPrivateBluezDBus::operationOfJob(const GattJob &job)
+{
+    using Operation = QLowEnergyRequestStatistics::Operation;
+
+    if (job.flags.testFlag(GattJob::ServiceDiscovery))
+        return Operation::Discovery;
+    if (job.flags & (GattJob::CharRead | GattJob::DescRead))
+        return Operation::Read;
+    if (job.flags.testFlag(GattJob::CharWrite)
+            && job.writeMode == QLowEnergyService::WriteWithoutResponse) {
+        return Operation::WriteWithoutResponse;
+    }
+    return Operation::Write;
 }
 
 void QLowEnergyControllerPrivateBluezDBus::scheduleNextJob()
 {
-    if (jobPending || jobs.isEmpty())
+    // a job that finishes synchronously may emit signals whose slots queue new jobs
+    if (schedulingJobs)
         return;
+    schedulingJobs = true;
+
+    QSet<QLowEnergyHandle> busyCharacteristics;
+    for (const GattJob &job : qAsConst(runningJobs))
+        busyCharacteristics.insert(characteristicHandleOfJob(job));
 
-    jobPending = true;
+    requestStatistics.recordQueueDepth(jobs.size() + runningJobs.size());
+
+    qsizetype index = 0;
+    while (index < jobs.size() && runningJobs.size() < maxRunningJobs) {
+        const QLowEnergyHandle charHandle = characteristicHandleOfJob(jobs.at(index));
+        if (busyCharacteristics.contains(charHandle)) {
+            ++index;
+            continue;
+        }
+
+        GattJob nextJob = jobs.takeAt(index);
+        Q_TRACE(QLowEnergyController_requestSent, traceOpcodeOfJob(nextJob), nextJob.handle,
+                int(nextJob.value.size()));
+        nextJob.sentAt = QLowEnergyRequestRecorder::Clock::now();
+        QDBusPendingCallWatcher *watcher = startJob(nextJob);
+        if (watcher) {
+            runningJobs.insert(watcher, nextJob);
+            busyCharacteristics.insert(charHandle);
+        } else {
+            // skipped or done already, following jobs of the characteristic may run
+            const auto operation = operationOfJob(nextJob);
+            if (operation == QLowEnergyRequestStatistics::Operation::WriteWithoutResponse)
+                requestStatistics.recordWaitTime(operation, nextJob.sentAt - nextJob.queuedAt);
+            jobFinished(nextJob);
+        }
+    }
+
+    schedulingJobs = false;
+}
+
+QLowEnergyHandle QLowEnergyControllerPrivateBluezDBus::characteristicHandleOfJob(
+        const GattJob &job)
+{
+    if (job.flags & (GattJob::DescRead | GattJob::DescWrite)) {
+        const QLowEnergyCharacteristic ch = characteristicForHandle(job.handle);
+        if (ch.isValid())
+            return ch.attributeHandle();
+    }
+    return job.handle;
+}
+
+/*
+    Issues the D-Bus call of \a nextJob and returns the watcher of the call.
+    Returns \c nullptr if the job was skipped or has been finished already.
+ */
+QDBusPendingCallWatcher *QLowEnergyControllerPrivateBluezDBus::startJob(const GattJob &nextJob)
+{
+    // writes without response go straight to the acquired socket, if there is one
+    if (nextJob.flags.testFlag(GattJob::CharWrite)
+            && nextJob.writeMode == QLowEnergyService::WriteWithoutResponse
+            && writeWithoutResponseViaSocket(nextJob)) {
+        return nullptr;
+    }
 
-    const GattJob nextJob = jobs.constFirst();
     QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(nextJob.handle);
     if (service.isNull() || !dbusServices.contains(service->uuid)) {
         qCWarning(QT_BT_BLUEZ) << "Invalid GATT job (scheduleNextJob). Skipping.";
-        prepareNextJob();
-        return;
+        return nullptr;
     }
 
+    QDBusPendingCallWatcher *watcher = nullptr;
+
     const GattService &dbusServiceData = dbusServices[service->uuid];
 
     if (nextJob.flags.testFlag(GattJob::CharRead)) {
         // characteristic reading ***************************************
         if (!service->characteristicList.contains(nextJob.handle)) {
             qCWarning(QT_BT_BLUEZ) << "Invalid Char handle when reading. Skipping.";
-            prepareNextJob();
-            return;
+            return nullptr;
         }
 
         const QLowEnergyServicePrivate::CharData &charData =
@@ -958,7 +1391,7 @@ void QLowEnergyControllerPrivateBluezDBus::scheduleNextJob()
                 continue;
 
             QDBusPendingReply<QByteArray> reply = gattChar.characteristic->ReadValue(QVariantMap());
-            QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(reply, this);
+            watcher = new QDBusPendingCallWatcher(reply, this);
             connect(watcher, &QDBusPendingCallWatcher::finished,
                     this, &QLowEnergyControllerPrivateBluezDBus::onCharReadFinished);
 
@@ -968,15 +1401,13 @@ void QLowEnergyControllerPrivateBluezDBus::scheduleNextJob()
 
         if (!foundChar) {
             qCWarning(QT_BT_BLUEZ) << "Cannot find char for reading. Skipping.";
-            prepareNextJob();
-            return;
+            return nullptr;
         }
     } else if (nextJob.flags.testFlag(GattJob::CharWrite)) {
         // characteristic writing ***************************************
         if (!service->characteristicList.contains(nextJob.handle)) {
             qCWarning(QT_BT_BLUEZ) << "Invalid Char handle when writing. Skipping.";
-            prepareNextJob();
-            return;
+            return nullptr;
         }
 
         const QLowEnergyServicePrivate::CharData &charData =
@@ -992,7 +1423,7 @@ void QLowEnergyControllerPrivateBluezDBus::scheduleNextJob()
                 QStringLiteral("command") : QStringLiteral("request");
             QDBusPendingReply<> reply = gattChar.characteristic->WriteValue(nextJob.value, options);
 
-            QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(reply, this);
+            watcher = new QDBusPendingCallWatcher(reply, this);
             connect(watcher, &QDBusPendingCallWatcher::finished,
                     this, &QLowEnergyControllerPrivateBluezDBus::onCharWriteFinished);
 
@@ -1002,24 +1433,21 @@ void QLowEnergyControllerPrivateBluezDBus::scheduleNextJob()
 
         if (!foundChar) {
             qCWarning(QT_BT_BLUEZ) << "Cannot find char for writing. Skipping.";
-            prepareNextJob();
-            return;
+            return nullptr;
         }
     } else if (nextJob.flags.testFlag(GattJob::DescRead)) {
         // descriptor reading ***************************************
         QLowEnergyCharacteristic ch = characteristicForHandle(nextJob.handle);
         if (!ch.isValid()) {
             qCWarning(QT_BT_BLUEZ) << "Invalid GATT job (scheduleReadDesc 1). Skipping.";
-            prepareNextJob();
-            return;
+            return nullptr;
         }
 
         const QLowEnergyServicePrivate::CharData &charData =
                                 service->characteristicList.value(ch.attributeHandle());
         if (!charData.descriptorList.contains(nextJob.handle)) {
             qCWarning(QT_BT_BLUEZ) << "Invalid GATT job (scheduleReadDesc 2). Skipping.";
-            prepareNextJob();
-            return;
+            return nullptr;
         }
 
         const QBluetoothUuid descUuid = charData.descriptorList[nextJob.handle].uuid;
@@ -1033,7 +1461,7 @@ void QLowEnergyControllerPrivateBluezDBus::scheduleNextJob()
                     continue;
 
                 QDBusPendingReply<QByteArray> reply = gattDesc->ReadValue(QVariantMap());
-                QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(reply, this);
+                watcher = new QDBusPendingCallWatcher(reply, this);
                 connect(watcher, &QDBusPendingCallWatcher::finished,
                         this, &QLowEnergyControllerPrivateBluezDBus::onDescReadFinished);
                 foundDesc = true;
@@ -1046,24 +1474,21 @@ void QLowEnergyControllerPrivateBluezDBus::scheduleNextJob()
 
         if (!foundDesc) {
             qCWarning(QT_BT_BLUEZ) << "Cannot find descriptor for reading. Skipping.";
-            prepareNextJob();
-            return;
+            return nullptr;
         }
     } else if (nextJob.flags.testFlag(GattJob::DescWrite)) {
         // descriptor writing ***************************************
         const QLowEnergyCharacteristic ch = characteristicForHandle(nextJob.handle);
         if (!ch.isValid()) {
             qCWarning(QT_BT_BLUEZ) << "Invalid GATT job (scheduleWriteDesc 1). Skipping.";
-            prepareNextJob();
-            return;
+            return nullptr;
         }
 
         const QLowEnergyServicePrivate::CharData &charData =
                                 service->characteristicList.value(ch.attributeHandle());
         if (!charData.descriptorList.contains(nextJob.handle)) {
             qCWarning(QT_BT_BLUEZ) << "Invalid GATT job (scheduleWriteDesc 2). Skipping.";
-            prepareNextJob();
-            return;
+            return nullptr;
         }
 
         const QBluetoothUuid descUuid = charData.descriptorList[nextJob.handle].uuid;
@@ -1080,20 +1505,43 @@ void QLowEnergyControllerPrivateBluezDBus::scheduleNextJob()
                 //otherwise regular WriteValue() calls on descriptor interface
                 if (descUuid == QBluetoothUuid(QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration)) {
                     const QByteArray value = nextJob.value;
-
-                    QDBusPendingReply<> reply;
+                    GattCharacteristic *acquireChar = dbusCharacteristic(ch.attributeHandle());
                     qCDebug(QT_BT_BLUEZ) << "Init CCC change to" << value.toHex()
                                          << charData.uuid << service->uuid;
+
+                    // notifications via AcquireNotify() bypass the Value property,
+                    // closing the socket disables them again
+                    if (acquireChar && acquireChar->notifySocket) {
+                        if (value != QByteArray::fromHex("0100"))
+                            acquireChar->notifySocket.reset();
+                        if (value == QByteArray::fromHex("0100")
+                                || value == QByteArray::fromHex("0000")) {
+                            finishDescriptorWrite(nextJob);
+                            return nullptr;
+                        }
+                    } else if (acquireChar && value == QByteArray::fromHex("0100")
+                               && charData.properties.testFlag(QLowEnergyCharacteristic::Notify)
+                               && !acquireChar->notifyAcquireFailed && canAcquireSockets()) {
+                        QDBusPendingReply<QDBusUnixFileDescriptor, ushort> reply =
+                                gattChar.characteristic->AcquireNotify(QVariantMap());
+                        watcher = new QDBusPendingCallWatcher(reply, this);
+                        connect(watcher, &QDBusPendingCallWatcher::finished,
+                                this, &QLowEnergyControllerPrivateBluezDBus::onAcquireNotifyFinished);
+                        foundDesc = true;
+                        break;
+                    }
+
+                    QDBusPendingReply<> reply;
                     if (value == QByteArray::fromHex("0100") || value == QByteArray::fromHex("0200"))
                         reply = gattChar.characteristic->StartNotify();
                     else
                         reply = gattChar.characteristic->StopNotify();
-                    QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(reply, this);
+                    watcher = new QDBusPendingCallWatcher(reply, this);
                     connect(watcher, &QDBusPendingCallWatcher::finished,
                             this, &QLowEnergyControllerPrivateBluezDBus::onDescWriteFinished);
                 } else {
                     QDBusPendingReply<> reply = gattDesc->WriteValue(nextJob.value, QVariantMap());
-                    QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(reply, this);
+                    watcher = new QDBusPendingCallWatcher(reply, this);
                     connect(watcher, &QDBusPendingCallWatcher::finished,
                             this, &QLowEnergyControllerPrivateBluezDBus::onDescWriteFinished);
 
@@ -1109,13 +1557,13 @@ void QLowEnergyControllerPrivateBluezDBus::scheduleNextJob()
 
         if (!foundDesc) {
             qCWarning(QT_BT_BLUEZ) << "Cannot find descriptor for writing. Skipping.";
-            prepareNextJob();
-            return;
+            return nullptr;
         }
     } else {
         qCWarning(QT_BT_BLUEZ) << "Unknown gatt job type. Skipping.";
-        prepareNextJob();
     }
+
+    return watcher;
 }
 
 void QLowEnergyControllerPrivateBluezDBus::readCharacteristic(
@@ -1156,7 +1604,7 @@ void QLowEnergyControllerPrivateBluezDBus::readCharacteristic(
     job.flags = GattJob::JobFlags({GattJob::CharRead});
     job.service = service;
     job.handle = charHandle;
-    jobs.append(job);
+    appendJob(job);
 
     scheduleNextJob();
 }
@@ -1190,7 +1638,7 @@ void QLowEnergyControllerPrivateBluezDBus::readDescriptor(
     job.flags = GattJob::JobFlags({GattJob::DescRead});
     job.service = service;
     job.handle = descriptorHandle;
-    jobs.append(job);
+    appendJob(job);
 
     scheduleNextJob();
 }
@@ -1223,12 +1671,11 @@ void QLowEnergyControllerPrivateBluezDBus::writeCharacteristic(
         job.handle = charHandle;
         job.value = newValue;
         job.writeMode = writeMode;
-        jobs.append(job);
+        appendJob(job);
 
         scheduleNextJob();
     } else {
-        qWarning(QT_BT_BLUEZ) << "writeCharacteristic() not implemented for DBus Bluez GATT";
-        service->setError(QLowEnergyService::CharacteristicWriteError);
+        storePeripheralValue(service->characteristicList[charHandle], charHandle, newValue);
     }
 }
 
@@ -1272,24 +1719,114 @@ void QLowEnergyControllerPrivateBluezDBus::writeDescriptor(
         job.service = service;
         job.handle = descriptorHandle;
         job.value = newValue;
-        jobs.append(job);
+        appendJob(job);
 
         scheduleNextJob();
     } else {
-        qWarning(QT_BT_BLUEZ) << "writeDescriptor() peripheral not implemented for DBus Bluez GATT";
-        service->setError(QLowEnergyService::CharacteristicWriteError);
+        // bluetoothd keeps the CCCD of each central, our copy only mirrors them
+        updateValueOfDescriptor(charHandle, descriptorHandle, newValue, false);
+    }
+}
+
+/*
+    Drops the queued read jobs of \a service, including those of its detail
+    discovery. The results of the reads BlueZ already runs are ignored.
+ */
+bool QLowEnergyControllerPrivateBluezDBus::cancelRequests(QLowEnergyServicePrivate *service)
+{
+    const auto isCancellable = [service](const GattJob &job) {
+        return job.service.data() == service
+                && (job.flags & (GattJob::CharRead | GattJob::DescRead));
+    };
+    jobs.removeIf(isCancellable);
+    for (GattJob &job : runningJobs) {
+        if (isCancellable(job))
+            job.cancelled = true;
     }
+    return true;
 }
 
+static void appendSecurityFlags(QStringList *flags, QBluetooth::AttAccessConstraints constraints,
+                                QLatin1String operation)
+{
+    if (constraints & QBluetooth::AttAccessConstraint::AttAuthenticationRequired)
+        flags->append(QLatin1String("encrypt-authenticated-") + operation);
+    else if (constraints & QBluetooth::AttAccessConstraint::AttEncryptionRequired)
+        flags->append(QLatin1String("encrypt-") + operation);
+}
+
+static QStringList characteristicFlags(const QLowEnergyCharacteristicData &data)
+{
+    const QLowEnergyCharacteristic::PropertyTypes properties = data.properties();
+    QStringList flags;
+    if (properties & QLowEnergyCharacteristic::Broadcasting)
+        flags << QStringLiteral("broadcast");
+    if (properties & QLowEnergyCharacteristic::Read) {
+        flags << QStringLiteral("read");
+        appendSecurityFlags(&flags, data.readConstraints(), QLatin1String("read"));
+    }
+    if (properties & QLowEnergyCharacteristic::WriteNoResponse)
+        flags << QStringLiteral("write-without-response");
+    if (properties & QLowEnergyCharacteristic::Write)
+        flags << QStringLiteral("write");
+    if (properties & (QLowEnergyCharacteristic::Write | QLowEnergyCharacteristic::WriteNoResponse))
+        appendSecurityFlags(&flags, data.writeConstraints(), QLatin1String("write"));
+    if (properties & QLowEnergyCharacteristic::Notify)
+        flags << QStringLiteral("notify");
+    if (properties & QLowEnergyCharacteristic::Indicate)
+        flags << QStringLiteral("indicate");
+    if (properties & QLowEnergyCharacteristic::WriteSigned)
+        flags << QStringLiteral("authenticated-signed-writes");
+    return flags;
+}
+
+static QStringList descriptorFlags(const QLowEnergyDescriptorData &data)
+{
+    QStringList flags;
+    if (data.isReadable()) {
+        flags << QStringLiteral("read");
+        appendSecurityFlags(&flags, data.readConstraints(), QLatin1String("read"));
+    }
+    if (data.isWritable()) {
+        flags << QStringLiteral("write");
+        appendSecurityFlags(&flags, data.writeConstraints(), QLatin1String("write"));
+    }
+    return flags;
+}
+
+/*!
+    \internal
+
+    Exports the local services to bluetoothd and registers the advertisement.
+    Both registrations are confirmed asynchronously, a failure moves the
+    controller back to the unconnected state.
+ */
 void QLowEnergyControllerPrivateBluezDBus::startAdvertising(
-                    const QLowEnergyAdvertisingParameters &/* params */,
-                    const QLowEnergyAdvertisingData &/* advertisingData */,
-                    const QLowEnergyAdvertisingData &/* scanResponseData */)
+                    const QLowEnergyAdvertisingParameters &params,
+                    const QLowEnergyAdvertisingData &advertisingData,
+                    const QLowEnergyAdvertisingData &scanResponseData)
 {
+    if (!createPeripheralApplication()
+            || !peripheralApplication->registerApplication(peripheralServices)
+            || !peripheralApplication->registerAdvertisement(params, advertisingData,
+                                                             scanResponseData)) {
+        setError(QLowEnergyController::AdvertisingError);
+        return;
+    }
+
+    setState(QLowEnergyController::AdvertisingState);
 }
 
 void QLowEnergyControllerPrivateBluezDBus::stopAdvertising()
 {
+    if (!peripheralApplication)
+        return;
+
+    peripheralApplication->unregisterAdvertisement();
+    if (state == QLowEnergyController::AdvertisingState) {
+        peripheralApplication->unregisterApplication();
+        setState(QLowEnergyController::UnconnectedState);
+    }
 }
 
 void QLowEnergyControllerPrivateBluezDBus::requestConnectionUpdate(
@@ -1298,21 +1835,292 @@ void QLowEnergyControllerPrivateBluezDBus::requestConnectionUpdate(
 }
 
 void QLowEnergyControllerPrivateBluezDBus::addToGenericAttributeList(
-                    const QLowEnergyServiceData &/* service */,
-                    QLowEnergyHandle /* startHandle */)
+                    const QLowEnergyServiceData &service,
+                    QLowEnergyHandle startHandle)
 {
+    QtBluezPeripheralService peripheralService;
+    peripheralService.uuid = service.uuid();
+    peripheralService.primary = service.type() == QLowEnergyServiceData::ServiceTypePrimary;
+    const QList<QLowEnergyService *> includedServices = service.includedServices();
+    for (QLowEnergyService * const includedService : includedServices)
+        peripheralService.includedServices << includedService->serviceUuid();
+
+    // same handle layout as addServiceHelper()
+    QLowEnergyHandle handle = startHandle + includedServices.size();
+    const QList<QLowEnergyCharacteristicData> characteristics = service.characteristics();
+    for (const QLowEnergyCharacteristicData &cd : characteristics) {
+        QtBluezPeripheralCharacteristic peripheralChar;
+        peripheralChar.handle = ++handle;
+        ++handle; // value
+        peripheralChar.uuid = cd.uuid();
+        peripheralChar.properties = cd.properties();
+        peripheralChar.flags = characteristicFlags(cd);
+        peripheralValueLengths.insert(peripheralChar.handle,
+                                      { cd.minimumValueLength(), cd.maximumValueLength() });
+
+        const QList<QLowEnergyDescriptorData> descriptors = cd.descriptors();
+        for (const QLowEnergyDescriptorData &dd : descriptors) {
+            ++handle;
+            // bluetoothd adds these by itself
+            if (dd.uuid() == QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration
+                    || dd.uuid() == QBluetoothUuid::DescriptorType::CharacteristicExtendedProperties) {
+                continue;
+            }
+            QtBluezPeripheralDescriptor peripheralDesc;
+            peripheralDesc.handle = handle;
+            peripheralDesc.uuid = dd.uuid();
+            peripheralDesc.flags = descriptorFlags(dd);
+            peripheralChar.descriptors << peripheralDesc;
+        }
+        peripheralService.characteristics << peripheralChar;
+    }
+
+    // addServiceHelper() overrides services with the same uuid
+    peripheralServices.removeIf([&service](const QtBluezPeripheralService &existing) {
+        return existing.uuid == service.uuid();
+    });
+    peripheralServices << peripheralService;
 }
 
 int QLowEnergyControllerPrivateBluezDBus::mtu() const
 {
+    // bluetoothd tells the MTU of the central with each request
+    if (role == QLowEnergyController::PeripheralRole && peripheralMtu)
+        return peripheralMtu;
     // currently not supported
     return -1;
 }
 
-QLowEnergyService *QLowEnergyControllerPrivateBluezDBus::addServiceHelper(
-                    const QLowEnergyServiceData &/*service*/)
+bool QLowEnergyControllerPrivateBluezDBus::setLocalAdapter(const QBluetoothAddress &adapter)
 {
-    return nullptr;
+    if (adapter == localAdapter)
+        return true;
+    // the adapter path is looked up once a connection is started
+    if (role != QLowEnergyController::CentralRole
+            || state != QLowEnergyController::UnconnectedState) {
+        return false;
+    }
+    localAdapter = adapter;
+    return true;
+}
+
+/*!
+    \internal
+
+    Stores \a value like writeCharacteristic() but reuses the buffer of the
+    characteristic, the subscribed centrals get the value from the view.
+ */
+void QLowEnergyControllerPrivateBluezDBus::publishCharacteristicValue(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QLowEnergyHandle charHandle,
+        QByteArrayView value)
+{
+    Q_ASSERT(!service.isNull());
+
+    if (role != QLowEnergyController::PeripheralRole) {
+        QLowEnergyControllerPrivate::publishCharacteristicValue(service, charHandle, value);
+        return;
+    }
+
+    const auto charIt = service->characteristicList.find(charHandle);
+    if (charIt != service->characteristicList.end())
+        storePeripheralValue(charIt.value(), charHandle, value);
+}
+
+QString QLowEnergyControllerPrivateBluezDBus::peripheralRead(
+        QLowEnergyHandle charHandle, QLowEnergyHandle descHandle,
+        const QtBluezPeripheralRequest &request, QByteArray *value)
+{
+    // bluetoothd checked the permissions against the flags already
+    const QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
+    if (service.isNull() || !service->characteristicList.contains(charHandle))
+        return QStringLiteral("org.bluez.Error.Failed");
+
+    peripheralCentralActive(request);
+
+    const QLowEnergyServicePrivate::CharData &charData = service->characteristicList[charHandle];
+    if (descHandle)
+        *value = charData.descriptorList.value(descHandle).value;
+    else
+        *value = charData.value;
+    return QString();
+}
+
+QString QLowEnergyControllerPrivateBluezDBus::peripheralWrite(
+        QLowEnergyHandle charHandle, QLowEnergyHandle descHandle,
+        const QtBluezPeripheralRequest &request, const QByteArray &value)
+{
+    const QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
+    if (service.isNull() || !service->characteristicList.contains(charHandle))
+        return QStringLiteral("org.bluez.Error.Failed");
+
+    peripheralCentralActive(request);
+
+    const QLowEnergyServicePrivate::CharData &charData = service->characteristicList[charHandle];
+    const QByteArray oldValue = descHandle ? charData.descriptorList.value(descHandle).value
+                                           : charData.value;
+    // long writes arrive in pieces
+    if (request.offset > oldValue.size())
+        return QStringLiteral("org.bluez.Error.InvalidOffset");
+    QByteArray newValue = oldValue.left(request.offset) + value;
+
+    if (descHandle) {
+        updateValueOfDescriptor(charHandle, descHandle, newValue, false);
+        const QLowEnergyDescriptor descriptor = descriptorForHandle(descHandle);
+        emit service->descriptorWritten(descriptor, newValue);
+        return QString();
+    }
+
+    const auto lengths = peripheralValueLengths.value(charHandle);
+    if (newValue.size() > lengths.second)
+        return QStringLiteral("org.bluez.Error.InvalidValueLength");
+    // a shorter value only overwrites the start of a fixed size value
+    if (lengths.first == lengths.second && newValue.size() < lengths.first)
+        newValue += oldValue.mid(newValue.size(), lengths.second - newValue.size());
+
+    updateValueOfCharacteristic(charHandle, newValue, false);
+    const QLowEnergyCharacteristic characteristic = characteristicForHandle(charHandle);
+    service->notifyCharacteristicChanged(characteristic, newValue);
+    return QString();
+}
+
+void QLowEnergyControllerPrivateBluezDBus::peripheralNotificationsChanged(
+        QLowEnergyHandle charHandle, bool enabled)
+{
+    const QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
+    if (service.isNull() || !service->characteristicList.contains(charHandle))
+        return;
+
+    const QLowEnergyServicePrivate::CharData &charData = service->characteristicList[charHandle];
+    for (auto it = charData.descriptorList.cbegin(); it != charData.descriptorList.cend(); ++it) {
+        if (it.value().uuid != QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration)
+            continue;
+
+        QByteArray value = QByteArray::fromHex("0000");
+        if (enabled) {
+            value = (charData.properties & QLowEnergyCharacteristic::Notify)
+                    ? QByteArray::fromHex("0100") : QByteArray::fromHex("0200");
+        }
+        const QLowEnergyHandle descHandle = it.key();
+        updateValueOfDescriptor(charHandle, descHandle, value, false);
+        emit service->descriptorWritten(descriptorForHandle(descHandle), value);
+        return;
+    }
+}
+
+bool QLowEnergyControllerPrivateBluezDBus::createPeripheralApplication()
+{
+    if (peripheralApplication)
+        return true;
+
+    bool ok = false;
+    const QString adapterPath = findAdapterForAddress(localAdapter, &ok);
+    if (!ok || adapterPath.isEmpty()) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot find suitable bluetooth adapter for advertising";
+        return false;
+    }
+
+    peripheralAdapterPath = adapterPath;
+    peripheralApplication = new QtBluezPeripheralApplication(adapterPath, this, this);
+    connect(peripheralApplication, &QtBluezPeripheralApplication::errorOccurred, this,
+            [this](const QString &errorName, const QString &errorMessage) {
+        qCWarning(QT_BT_BLUEZ) << "Cannot advertise:" << errorName << errorMessage;
+        setError(QLowEnergyController::AdvertisingError);
+        if (state == QLowEnergyController::AdvertisingState) {
+            peripheralApplication->unregisterAdvertisement();
+            peripheralApplication->unregisterApplication();
+            setState(QLowEnergyController::UnconnectedState);
+        }
+    });
+    connect(peripheralApplication, &QtBluezPeripheralApplication::advertisementReleased, this,
+            [this]() {
+        if (state == QLowEnergyController::AdvertisingState) {
+            peripheralApplication->unregisterApplication();
+            setState(QLowEnergyController::UnconnectedState);
+        }
+    });
+    connect(QtBluezObjectCache::instance(), &QtBluezObjectCache::deviceConnectionChanged,
+            this, &QLowEnergyControllerPrivateBluezDBus::peripheralConnectionChanged);
+    return true;
+}
+
+/*
+ * bluetoothd has no signal for centrals which connect to the GATT database,
+ * the first request of a central tells us about it.
+ */
+void QLowEnergyControllerPrivateBluezDBus::peripheralCentralActive(
+        const QtBluezPeripheralRequest &request)
+{
+    Q_Q(QLowEnergyController);
+
+    if (request.mtu && request.mtu != peripheralMtu) {
+        peripheralMtu = request.mtu;
+        emit q->mtuChanged(peripheralMtu);
+    }
+
+    if (request.central.isNull() || peripheralCentrals.contains(request.central))
+        return;
+
+    peripheralCentrals.insert(request.central);
+    if (state == QLowEnergyController::ConnectedState)
+        return;
+
+    qCDebug(QT_BT_BLUEZ) << "Central" << request.central << "uses the GATT database";
+    remoteDevice = request.central;
+    setState(QLowEnergyController::ConnectedState);
+    emit q->connected();
+}
+
+void QLowEnergyControllerPrivateBluezDBus::peripheralConnectionChanged(
+        const QString &adapterPath, const QBluetoothAddress &address, bool connected)
+{
+    if (connected || adapterPath != peripheralAdapterPath || !peripheralCentrals.remove(address))
+        return;
+
+    if (!peripheralCentrals.isEmpty()) {
+        if (remoteDevice == address)
+            remoteDevice = *peripheralCentrals.cbegin();
+        return;
+    }
+    peripheralDisconnected();
+}
+
+void QLowEnergyControllerPrivateBluezDBus::peripheralDisconnected()
+{
+    peripheralCentrals.clear();
+    peripheralMtu = 0;
+
+    // bluetoothd keeps advertising while centrals are connected
+    if (peripheralApplication && peripheralApplication->isAdvertising()) {
+        setState(QLowEnergyController::AdvertisingState);
+    } else {
+        if (peripheralApplication)
+            peripheralApplication->unregisterApplication();
+        setState(QLowEnergyController::UnconnectedState);
+    }
+    Q_Q(QLowEnergyController);
+    emit q->disconnected();
+}
+
+bool QLowEnergyControllerPrivateBluezDBus::storePeripheralValue(
+        QLowEnergyServicePrivate::CharData &charData, QLowEnergyHandle charHandle,
+        QByteArrayView value)
+{
+    const auto lengths = peripheralValueLengths.value(charHandle);
+    if (value.size() < lengths.first || value.size() > lengths.second) {
+        qCWarning(QT_BT_BLUEZ) << "ignoring value of invalid length" << value.size()
+                               << "for characteristic" << charHandle;
+        return false;
+    }
+
+    // the buffer is only reallocated if the application still holds the old value
+    charData.value.resize(value.size());
+    if (!value.isEmpty() && value.data() != charData.value.constData())
+        memcpy(charData.value.data(), value.data(), value.size());
+
+    if (peripheralApplication && peripheralApplication->isNotifying(charHandle))
+        peripheralApplication->notify(charHandle, value);
+    return true;
 }
 
 QT_END_NAMESPACE
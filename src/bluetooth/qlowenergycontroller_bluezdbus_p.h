@@ -18,8 +18,11 @@
 
 #include "qlowenergycontroller.h"
 #include "qlowenergycontrollerbase_p.h"
+#include "bluez/peripheralapplication_p.h"
 
+#include <QtCore/QSet>
 #include <QtDBus/QDBusObjectPath>
+#include <QtDBus/QDBusUnixFileDescriptor>
 
 class OrgBluezAdapter1Interface;
 class OrgBluezBattery1Interface;
@@ -28,13 +31,15 @@ class OrgBluezGattCharacteristic1Interface;
 class OrgBluezGattDescriptor1Interface;
 class OrgBluezGattService1Interface;
 class OrgFreedesktopDBusObjectManagerInterface;
-class OrgFreedesktopDBusPropertiesInterface;
+class QtBluezPropertiesMonitor;
 
 QT_BEGIN_NAMESPACE
 
 class QDBusPendingCallWatcher;
+class QSocketNotifier;
 
-class QLowEnergyControllerPrivateBluezDBus final : public QLowEnergyControllerPrivate
+class QLowEnergyControllerPrivateBluezDBus final : public QLowEnergyControllerPrivate,
+                                                   public QtBluezPeripheralDelegate
 {
     Q_OBJECT
 public:
@@ -67,6 +72,7 @@ public:
                 const QLowEnergyHandle charHandle,
                 const QLowEnergyHandle descriptorHandle,
                 const QByteArray &newValue) override;
+    bool cancelRequests(QLowEnergyServicePrivate *service) override;
 
     void startAdvertising(
                 const QLowEnergyAdvertisingParameters &params,
@@ -81,9 +87,19 @@ public:
                         QLowEnergyHandle startHandle) override;
 
     int mtu() const override;
+    bool setLocalAdapter(const QBluetoothAddress &adapter) override;
 
-    QLowEnergyService *addServiceHelper(const QLowEnergyServiceData &service) override;
+    void publishCharacteristicValue(const QSharedPointer<QLowEnergyServicePrivate> service,
+                                    const QLowEnergyHandle charHandle,
+                                    QByteArrayView value) override;
 
+    // QtBluezPeripheralDelegate
+    QString peripheralRead(QLowEnergyHandle charHandle, QLowEnergyHandle descHandle,
+                           const QtBluezPeripheralRequest &request, QByteArray *value) override;
+    QString peripheralWrite(QLowEnergyHandle charHandle, QLowEnergyHandle descHandle,
+                            const QtBluezPeripheralRequest &request,
+                            const QByteArray &value) override;
+    void peripheralNotificationsChanged(QLowEnergyHandle charHandle, bool enabled) override;
 
 private:
     void connectToDeviceHelper();
@@ -91,6 +107,12 @@ private:
 
     void scheduleNextJob();
 
+    bool createPeripheralApplication();
+    void peripheralCentralActive(const QtBluezPeripheralRequest &request);
+    void peripheralDisconnected();
+    bool storePeripheralValue(QLowEnergyServicePrivate::CharData &charData,
+                              QLowEnergyHandle charHandle, QByteArrayView value);
+
 private slots:
     void devicePropertiesChanged(const QString &interface, const QVariantMap &changedProperties,
                                  const QStringList &invalidatedProperties);
@@ -98,25 +120,55 @@ private slots:
                                     const QVariantMap &changedProperties,
                                     const QStringList &invalidatedProperties);
     void interfacesRemoved(const QDBusObjectPath &objectPath, const QStringList &interfaces);
+    void peripheralConnectionChanged(const QString &adapterPath, const QBluetoothAddress &address,
+                                     bool connected);
 
     void onCharReadFinished(QDBusPendingCallWatcher *call);
     void onDescReadFinished(QDBusPendingCallWatcher *call);
     void onCharWriteFinished(QDBusPendingCallWatcher *call);
     void onDescWriteFinished(QDBusPendingCallWatcher *call);
+    void onAcquireNotifyFinished(QDBusPendingCallWatcher *call);
 private:
     OrgBluezAdapter1Interface* adapter{};
     OrgBluezDevice1Interface* device{};
     OrgFreedesktopDBusObjectManagerInterface* managerBluez{};
-    OrgFreedesktopDBusPropertiesInterface* deviceMonitor{};
+    QtBluezPropertiesMonitor* deviceMonitor{};
+    QtBluezPropertiesMonitor* batteryMonitor{};
 
     bool pendingConnect = false;
     bool disconnectSignalRequired = false;
 
+    // PeripheralRole, bluetoothd serves the database and reports the centrals
+    // which use it along with their requests
+    QtBluezPeripheralApplication *peripheralApplication = nullptr;
+    QString peripheralAdapterPath;
+    QList<QtBluezPeripheralService> peripheralServices;
+    QHash<QLowEnergyHandle, std::pair<int, int>> peripheralValueLengths; // min and max
+    QSet<QBluetoothAddress> peripheralCentrals;
+    quint16 peripheralMtu = 0;
+
+    // socket obtained via AcquireWrite() or AcquireNotify(), closing it releases it
+    struct AcquiredSocket
+    {
+        ~AcquiredSocket();
+
+        QDBusUnixFileDescriptor fd;
+        quint16 mtu = 0;
+        QSocketNotifier *notifier = nullptr;
+    };
+
     struct GattCharacteristic
     {
         QSharedPointer<OrgBluezGattCharacteristic1Interface> characteristic;
-        QSharedPointer<OrgFreedesktopDBusPropertiesInterface> charMonitor;
+        QSharedPointer<QtBluezPropertiesMonitor> charMonitor;
         QList<QSharedPointer<OrgBluezGattDescriptor1Interface>> descriptors;
+        QLowEnergyHandle handle = 0;
+
+        // Write Without Response and notifications bypass D-Bus once acquired
+        QSharedPointer<AcquiredSocket> writeSocket;
+        QSharedPointer<AcquiredSocket> notifySocket;
+        bool writeAcquireAttempted = false;
+        bool notifyAcquireFailed = false;
     };
 
     struct GattService
@@ -138,8 +190,7 @@ private:
             CharWrite               = 0x02,
             DescRead                = 0x04,
             DescWrite               = 0x08,
-            ServiceDiscovery        = 0x10,
-            LastServiceDiscovery    = 0x20
+            ServiceDiscovery        = 0x10
         };
         Q_DECLARE_FLAGS(JobFlags, JobFlag)
 
@@ -148,12 +199,37 @@ private:
         QByteArray value;
         QLowEnergyService::WriteMode writeMode = QLowEnergyService::WriteWithResponse;
         QSharedPointer<QLowEnergyServicePrivate> service;
+        // the service canceled the running read, its result is dropped
+        bool cancelled = false;
+        // for the request statistics
+        QLowEnergyRequestRecorder::Clock::time_point queuedAt;
+        QLowEnergyRequestRecorder::Clock::time_point sentAt;
     };
 
-    QList<GattJob> jobs;
-    bool jobPending = false;
-
-    void prepareNextJob();
+    QList<GattJob> jobs; // not started yet
+    QHash<QDBusPendingCallWatcher *, GattJob> runningJobs;
+    int maxRunningJobs = 4;
+    bool schedulingJobs = false;
+
+    void appendJob(const GattJob &job);
+    static int traceOpcodeOfJob(const GattJob &job);
+    static QLowEnergyRequestStatistics::Operation operationOfJob(const GattJob &job);
+    QDBusPendingCallWatcher *startJob(const GattJob &nextJob);
+    QLowEnergyHandle characteristicHandleOfJob(const GattJob &job);
+    bool hasPendingDiscoveryJobs(const QSharedPointer<QLowEnergyServicePrivate> &service) const;
+    void jobFinished(const GattJob &job);
+    void prepareNextJob(QDBusPendingCallWatcher *call);
+    void finishDescriptorWrite(const GattJob &job);
+    void characteristicValueChanged(QLowEnergyHandle charHandle, const QByteArray &newValue);
+
+    GattCharacteristic *dbusCharacteristic(QLowEnergyHandle charHandle);
+    bool canAcquireSockets() const;
+    bool writeWithoutResponseViaSocket(const GattJob &job);
+    void acquireWriteSocket(GattCharacteristic *gattChar);
+    QSharedPointer<AcquiredSocket> createAcquiredSocket(const QDBusUnixFileDescriptor &fd,
+                                                        quint16 mtu, QLowEnergyHandle charHandle,
+                                                        bool notify);
+    void readAcquiredSocket(QLowEnergyHandle charHandle, bool notify);
     void discoverBatteryServiceDetails(GattService &dbusData,
                                        QSharedPointer<QLowEnergyServicePrivate> serviceData);
     void executeClose(QLowEnergyController::Error newError);
@@ -12,6 +12,7 @@
 #include "qlowenergycontroller_darwin_p.h"
 #include "qlowenergyserviceprivate_p.h"
 #include "darwin/btcentralmanager_p.h"
+#include <qtbluetooth_tracepoints_p.h>
 
 #include "qlowenergyservicedata.h"
 #include "qbluetoothlocaldevice.h"
@@ -101,7 +102,7 @@ QLowEnergyControllerPrivateDarwin::QLowEnergyControllerPrivateDarwin()
 
 QLowEnergyControllerPrivateDarwin::~QLowEnergyControllerPrivateDarwin()
 {
-    if (const auto leQueue = DarwinBluetooth::qt_LE_queue()) {
+    if (const auto leQueue = dispatchQueue.getAs<dispatch_queue_t>()) {
         if (role == QLowEnergyController::CentralRole) {
             const auto manager = centralManager.getAs<ObjCCentralManager>();
             dispatch_sync(leQueue, ^{
@@ -138,10 +139,18 @@ void QLowEnergyControllerPrivateDarwin::init()
         return;
     }
 
+    dispatchQueue.reset(qt_create_LE_queue("qt-bluetooth-LE-controller-queue"));
+    const auto leQueue = dispatchQueue.getAs<dispatch_queue_t>();
+    if (!leQueue) {
+        qCWarning(QT_BT_DARWIN) << "no LE queue found";
+        return;
+    }
+
     std::unique_ptr<LECBManagerNotifier> notifier = std::make_unique<LECBManagerNotifier>();
     if (role == QLowEnergyController::PeripheralRole) {
 #ifndef Q_OS_TVOS
-        peripheralManager.reset([[ObjCPeripheralManager alloc] initWith:notifier.get()],
+        peripheralManager.reset([[ObjCPeripheralManager alloc] initWith:notifier.get()
+                                                                  queue:leQueue],
                                 DarwinBluetooth::RetainPolicy::noInitialRetain);
         if (!peripheralManager) {
             qCWarning(QT_BT_DARWIN) << "failed to create a peripheral manager";
@@ -152,7 +161,8 @@ void QLowEnergyControllerPrivateDarwin::init()
         return;
 #endif // Q_OS_TVOS
     } else {
-        centralManager.reset([[ObjCCentralManager alloc] initWith:notifier.get()],
+        centralManager.reset([[ObjCCentralManager alloc] initWith:notifier.get()
+                                                            queue:leQueue],
                              DarwinBluetooth::RetainPolicy::noInitialRetain);
         if (!centralManager) {
             qCWarning(QT_BT_DARWIN) << "failed to initialize a central manager";
@@ -194,7 +204,7 @@ void QLowEnergyControllerPrivateDarwin::connectToDevice()
     Q_ASSERT_X(role != QLowEnergyController::PeripheralRole,
                Q_FUNC_INFO, "invalid role (peripheral)");
 
-    dispatch_queue_t leQueue(DarwinBluetooth::qt_LE_queue());
+    dispatch_queue_t leQueue(dispatchQueue.getAs<dispatch_queue_t>());
     if (!leQueue) {
         qCWarning(QT_BT_DARWIN) << "no LE queue found";
         setErrorDescription(QLowEnergyController::UnknownError);
@@ -224,7 +234,7 @@ void QLowEnergyControllerPrivateDarwin::disconnectFromDevice()
 
     const auto oldState = state;
 
-    if (dispatch_queue_t leQueue = DarwinBluetooth::qt_LE_queue()) {
+    if (dispatch_queue_t leQueue = dispatchQueue.getAs<dispatch_queue_t>()) {
         setState(QLowEnergyController::ClosingState);
         invalidateServices();
 
@@ -255,14 +265,17 @@ void QLowEnergyControllerPrivateDarwin::discoverServices()
 
     Q_ASSERT(isValid()); // Check we're in a proper state is in q's code.
 
-    dispatch_queue_t leQueue(DarwinBluetooth::qt_LE_queue());
+    dispatch_queue_t leQueue(dispatchQueue.getAs<dispatch_queue_t>());
     Q_ASSERT_X(leQueue, Q_FUNC_INFO, "LE queue not found");
 
     setState(QLowEnergyController::DiscoveringState);
 
     ObjCCentralManager *manager = centralManager.getAs<ObjCCentralManager>();
+    const QList<QBluetoothUuid> serviceUuids(serviceDiscoveryFilter);
+    const auto policy = gattCachePolicy;
     dispatch_async(leQueue, ^{
-        [manager discoverServices];
+        [manager setGattCachePolicy:policy];
+        [manager discoverServices:serviceUuids];
     });
 }
 
@@ -281,7 +294,7 @@ void QLowEnergyControllerPrivateDarwin::discoverServiceDetails(
         return;
     }
 
-    dispatch_queue_t leQueue(DarwinBluetooth::qt_LE_queue());
+    dispatch_queue_t leQueue(dispatchQueue.getAs<dispatch_queue_t>());
     Q_ASSERT(leQueue);
 
     ServicePrivate qtService(serviceList.value(serviceUuid));
@@ -289,7 +302,9 @@ void QLowEnergyControllerPrivateDarwin::discoverServiceDetails(
     // Copy objects ...
     ObjCCentralManager *manager = centralManager.getAs<ObjCCentralManager>();
     const QBluetoothUuid serviceUuidCopy(serviceUuid);
+    const auto policy = gattCachePolicy;
     dispatch_async(leQueue, ^{
+        [manager setGattCachePolicy:policy];
         [manager discoverServiceDetails:serviceUuidCopy readValues:mode == QLowEnergyService::FullDiscovery];
     });
 }
@@ -313,7 +328,7 @@ void QLowEnergyControllerPrivateDarwin::addToGenericAttributeList(const QLowEner
 int QLowEnergyControllerPrivateDarwin::mtu() const
 {
     __block int mtu = DarwinBluetooth::defaultMtu;
-    if (const auto leQueue = DarwinBluetooth::qt_LE_queue()) {
+    if (const auto leQueue = dispatchQueue.getAs<dispatch_queue_t>()) {
         const auto *manager = centralManager.getAs<ObjCCentralManager>();
         dispatch_sync(leQueue, ^{
             mtu = [manager mtu];
@@ -385,6 +400,11 @@ void QLowEnergyControllerPrivateDarwin::_q_mtuChanged(int newValue)
     emit q_ptr->mtuChanged(newValue);
 }
 
+void QLowEnergyControllerPrivateDarwin::_q_congestionChanged(bool congested)
+{
+    emit q_ptr->congestionChanged(congested);
+}
+
 void QLowEnergyControllerPrivateDarwin::_q_serviceDiscoveryFinished()
 {
     Q_ASSERT_X(state == QLowEnergyController::DiscoveringState,
@@ -518,6 +538,8 @@ void QLowEnergyControllerPrivateDarwin::_q_characteristicRead(QLowEnergyHandle c
                                                               const QByteArray &value)
 {
     Q_ASSERT_X(charHandle, Q_FUNC_INFO, "invalid characteristic handle(0)");
+    Q_TRACE(QLowEnergyController_responseReceived, TraceReadResponse, charHandle,
+            int(value.size()));
 
     ServicePrivate service(serviceForHandle(charHandle));
     if (service.isNull())
@@ -539,6 +561,8 @@ void QLowEnergyControllerPrivateDarwin::_q_characteristicWritten(QLowEnergyHandl
                                                                  const QByteArray &value)
 {
     Q_ASSERT_X(charHandle, Q_FUNC_INFO, "invalid characteristic handle(0)");
+    Q_TRACE(QLowEnergyController_responseReceived, TraceWriteResponse, charHandle,
+            int(value.size()));
 
     ServicePrivate service(serviceForHandle(charHandle));
     if (service.isNull()) {
@@ -565,6 +589,9 @@ void QLowEnergyControllerPrivateDarwin::_q_characteristicUpdated(QLowEnergyHandl
     // TODO: write/update notifications are quite similar (except asserts/warnings messages
     // and different signals emitted). Merge them into one function?
     Q_ASSERT_X(charHandle, Q_FUNC_INFO, "invalid characteristic handle(0)");
+    Q_TRACE(QLowEnergyController_notificationReceived, TraceNotification, charHandle,
+            int(value.size()));
+    requestStatistics.recordNotification();
 
     ServicePrivate service(serviceForHandle(charHandle));
     if (service.isNull()) {
@@ -582,16 +609,16 @@ void QLowEnergyControllerPrivateDarwin::_q_characteristicUpdated(QLowEnergyHandl
         return;
     }
 
-    if (characteristic.properties() & QLowEnergyCharacteristic::Read)
-        updateValueOfCharacteristic(charHandle, value, false);
+    updateValueOfChangedCharacteristic(characteristic, value);
 
-    emit service->characteristicChanged(characteristic, value);
+    service->notifyCharacteristicChanged(characteristic, value);
 }
 
 void QLowEnergyControllerPrivateDarwin::_q_descriptorRead(QLowEnergyHandle dHandle,
                                                           const QByteArray &value)
 {
     Q_ASSERT_X(dHandle, Q_FUNC_INFO, "invalid descriptor handle (0)");
+    Q_TRACE(QLowEnergyController_responseReceived, TraceReadResponse, dHandle, int(value.size()));
 
     const QLowEnergyDescriptor qtDescriptor(descriptorForHandle(dHandle));
     if (!qtDescriptor.isValid()) {
@@ -608,6 +635,7 @@ void QLowEnergyControllerPrivateDarwin::_q_descriptorWritten(QLowEnergyHandle dH
                                                              const QByteArray &value)
 {
     Q_ASSERT_X(dHandle, Q_FUNC_INFO, "invalid descriptor handle (0)");
+    Q_TRACE(QLowEnergyController_responseReceived, TraceWriteResponse, dHandle, int(value.size()));
 
     const QLowEnergyDescriptor qtDescriptor(descriptorForHandle(dHandle));
     if (!qtDescriptor.isValid()) {
@@ -752,7 +780,7 @@ void QLowEnergyControllerPrivateDarwin::setNotifyValue(QSharedPointer<QLowEnergy
         return;
     }
 
-    dispatch_queue_t leQueue(DarwinBluetooth::qt_LE_queue());
+    dispatch_queue_t leQueue(dispatchQueue.getAs<dispatch_queue_t>());
     Q_ASSERT_X(leQueue, Q_FUNC_INFO, "no LE queue found");
 
     ObjCCentralManager *manager = centralManager.getAs<ObjCCentralManager>();
@@ -787,12 +815,13 @@ void QLowEnergyControllerPrivateDarwin::readCharacteristic(const QSharedPointer<
         return;
     }
 
-    dispatch_queue_t leQueue(DarwinBluetooth::qt_LE_queue());
+    dispatch_queue_t leQueue(dispatchQueue.getAs<dispatch_queue_t>());
     Q_ASSERT_X(leQueue, Q_FUNC_INFO, "no LE queue found");
 
     // Attention! We have to copy UUID.
     ObjCCentralManager *manager = centralManager.getAs<ObjCCentralManager>();
     const QBluetoothUuid serviceUuid(service->uuid);
+    Q_TRACE(QLowEnergyController_requestQueued, TraceReadRequest, charHandle, 0);
     dispatch_async(leQueue, ^{
         [manager readCharacteristic:charHandle onService:serviceUuid];
     });
@@ -819,10 +848,13 @@ void QLowEnergyControllerPrivateDarwin::writeCharacteristic(const QSharedPointer
         return;
     }
 
-    dispatch_queue_t leQueue(DarwinBluetooth::qt_LE_queue());
+    dispatch_queue_t leQueue(dispatchQueue.getAs<dispatch_queue_t>());
     Q_ASSERT_X(leQueue, Q_FUNC_INFO, "no LE queue found");
     // Attention! We have to copy objects!
     const QByteArray newValueCopy(newValue);
+    Q_TRACE(QLowEnergyController_requestQueued,
+            mode == QLowEnergyService::WriteWithResponse ? TraceWriteRequest : TraceWriteCommand,
+            charHandle, int(newValue.size()));
     if (role == QLowEnergyController::CentralRole) {
         const QBluetoothUuid serviceUuid(service->uuid);
         const auto manager = centralManager.getAs<ObjCCentralManager>();
@@ -844,6 +876,73 @@ void QLowEnergyControllerPrivateDarwin::writeCharacteristic(const QSharedPointer
     }
 }
 
+void QLowEnergyControllerPrivateDarwin::readCharacteristics(const QSharedPointer<QLowEnergyServicePrivate> service,
+                                                            const QList<QLowEnergyHandle> &charHandles)
+{
+    Q_ASSERT_X(!service.isNull(), Q_FUNC_INFO, "invalid service (null)");
+
+    if (role == QLowEnergyController::PeripheralRole) {
+        qCWarning(QT_BT_DARWIN) << "invalid role (peripheral)";
+        return;
+    }
+
+    if (!serviceList.contains(service->uuid)) {
+        qCWarning(QT_BT_DARWIN) << "no service with uuid:"
+                                << service->uuid << "found";
+        return;
+    }
+
+    dispatch_queue_t leQueue(dispatchQueue.getAs<dispatch_queue_t>());
+    Q_ASSERT_X(leQueue, Q_FUNC_INFO, "no LE queue found");
+
+    // One block for the whole batch, the manager serializes the reads anyway.
+    ObjCCentralManager *manager = centralManager.getAs<ObjCCentralManager>();
+    const QBluetoothUuid serviceUuid(service->uuid);
+    const QList<QLowEnergyHandle> handlesCopy(charHandles);
+    dispatch_async(leQueue, ^{
+        for (const QLowEnergyHandle charHandle : handlesCopy) {
+            Q_TRACE(QLowEnergyController_requestQueued, TraceReadRequest, charHandle, 0);
+            [manager readCharacteristic:charHandle onService:serviceUuid];
+        }
+    });
+}
+
+void QLowEnergyControllerPrivateDarwin::writeCharacteristics(const QSharedPointer<QLowEnergyServicePrivate> service,
+                                                             const QList<QLowEnergyHandle> &charHandles,
+                                                             const QList<QByteArray> &newValues,
+                                                             QLowEnergyService::WriteMode mode)
+{
+    Q_ASSERT_X(!service.isNull(), Q_FUNC_INFO, "invalid service (null)");
+    Q_ASSERT(charHandles.size() == newValues.size());
+
+    if (role != QLowEnergyController::CentralRole || !serviceList.contains(service->uuid)) {
+        // The peripheral manager has no batching worth speaking of.
+        QLowEnergyControllerPrivate::writeCharacteristics(service, charHandles, newValues, mode);
+        return;
+    }
+
+    dispatch_queue_t leQueue(dispatchQueue.getAs<dispatch_queue_t>());
+    Q_ASSERT_X(leQueue, Q_FUNC_INFO, "no LE queue found");
+
+    // Attention! We have to copy objects!
+    ObjCCentralManager *manager = centralManager.getAs<ObjCCentralManager>();
+    const QBluetoothUuid serviceUuid(service->uuid);
+    const QList<QLowEnergyHandle> handlesCopy(charHandles);
+    const QList<QByteArray> valuesCopy(newValues);
+    dispatch_async(leQueue, ^{
+        for (qsizetype i = 0; i < handlesCopy.size(); ++i) {
+            Q_TRACE(QLowEnergyController_requestQueued,
+                    mode == QLowEnergyService::WriteWithResponse ? TraceWriteRequest
+                                                                 : TraceWriteCommand,
+                    handlesCopy.at(i), int(valuesCopy.at(i).size()));
+            [manager write:valuesCopy.at(i)
+                charHandle:handlesCopy.at(i)
+                 onService:serviceUuid
+                 withResponse:mode == QLowEnergyService::WriteWithResponse];
+        }
+    });
+}
+
 quint16 QLowEnergyControllerPrivateDarwin::updateValueOfCharacteristic(QLowEnergyHandle charHandle,
                                                                        const QByteArray &value,
                                                                        bool appendValue)
@@ -884,7 +983,7 @@ void QLowEnergyControllerPrivateDarwin::readDescriptor(const QSharedPointer<QLow
         return;
     }
 
-    dispatch_queue_t leQueue(DarwinBluetooth::qt_LE_queue());
+    dispatch_queue_t leQueue(dispatchQueue.getAs<dispatch_queue_t>());
     if (!leQueue) {
         qCWarning(QT_BT_DARWIN) << "no LE queue found";
         return;
@@ -892,6 +991,7 @@ void QLowEnergyControllerPrivateDarwin::readDescriptor(const QSharedPointer<QLow
     // Attention! Copy objects!
     const QBluetoothUuid serviceUuid(service->uuid);
     ObjCCentralManager * const manager = centralManager.getAs<ObjCCentralManager>();
+    Q_TRACE(QLowEnergyController_requestQueued, TraceReadRequest, descriptorHandle, 0);
     dispatch_async(leQueue, ^{
         [manager readDescriptor:descriptorHandle
                  onService:serviceUuid];
@@ -921,12 +1021,14 @@ void QLowEnergyControllerPrivateDarwin::writeDescriptor(const QSharedPointer<QLo
         return;
     }
 
-    dispatch_queue_t leQueue(DarwinBluetooth::qt_LE_queue());
+    dispatch_queue_t leQueue(dispatchQueue.getAs<dispatch_queue_t>());
     Q_ASSERT_X(leQueue, Q_FUNC_INFO, "no LE queue found");
     // Attention! Copy objects!
     const QBluetoothUuid serviceUuid(service->uuid);
     ObjCCentralManager * const manager = centralManager.getAs<ObjCCentralManager>();
     const QByteArray newValueCopy(newValue);
+    Q_TRACE(QLowEnergyController_requestQueued, TraceWriteRequest, descriptorHandle,
+            int(newValue.size()));
     dispatch_async(leQueue, ^{
         [manager write:newValueCopy
                  descHandle:descriptorHandle
@@ -1035,6 +1137,8 @@ bool QLowEnergyControllerPrivateDarwin::connectSlots(DarwinBluetooth::LECBManage
                        this, SLOT(_q_CBManagerError(const QBluetoothUuid &, QLowEnergyService::ServiceError)));
     ok = ok && connect(notifier, &LECBManagerNotifier::mtuChanged, this,
                        &QLowEnergyControllerPrivateDarwin::_q_mtuChanged);
+    ok = ok && connect(notifier, &LECBManagerNotifier::congestionChanged, this,
+                       &QLowEnergyControllerPrivateDarwin::_q_congestionChanged);
 
     if (!ok)
         notifier->disconnect();
@@ -1068,7 +1172,7 @@ void QLowEnergyControllerPrivateDarwin::startAdvertising(const QLowEnergyAdverti
         return;
     }
 
-    auto leQueue(DarwinBluetooth::qt_LE_queue());
+    auto leQueue(dispatchQueue.getAs<dispatch_queue_t>());
     if (!leQueue) {
         qCWarning(QT_BT_DARWIN) << "no LE queue found";
         setErrorDescription(QLowEnergyController::UnknownError);
@@ -1099,7 +1203,7 @@ void QLowEnergyControllerPrivateDarwin::stopAdvertising()
         return;
     }
 
-    if (const auto leQueue = DarwinBluetooth::qt_LE_queue()) {
+    if (const auto leQueue = dispatchQueue.getAs<dispatch_queue_t>()) {
         const auto manager = peripheralManager.getAs<ObjCPeripheralManager>();
         dispatch_sync(leQueue, ^{
             [manager stopAdvertising];
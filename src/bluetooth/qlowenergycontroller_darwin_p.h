@@ -63,6 +63,12 @@ public:
                          const QLowEnergyHandle descriptorHandle,
                          const QByteArray &newValue) override;
 
+    void readCharacteristics(const QSharedPointer<QLowEnergyServicePrivate> service,
+                             const QList<QLowEnergyHandle> &charHandles) override;
+    void writeCharacteristics(const QSharedPointer<QLowEnergyServicePrivate> service,
+                              const QList<QLowEnergyHandle> &charHandles,
+                              const QList<QByteArray> &newValues,
+                              QLowEnergyService::WriteMode mode) override;
 
     void requestConnectionUpdate(const QLowEnergyConnectionParameters &params) override;
     void addToGenericAttributeList(const QLowEnergyServiceData &service,
@@ -85,6 +91,7 @@ private Q_SLOTS:
     void _q_disconnected();
 
     void _q_mtuChanged(int newValue);
+    void _q_congestionChanged(bool congested);
     void _q_serviceDiscoveryFinished();
     void _q_serviceDetailsDiscoveryFinished(QSharedPointer<QLowEnergyServicePrivate> service);
     void _q_servicesWereModified();
@@ -117,6 +124,8 @@ private:
     void setErrorDescription(QLowEnergyController::Error errorCode);
     bool connectSlots(DarwinBluetooth::LECBManagerNotifier *notifier);
 
+    // Outlives the managers, they are dispatched to on this queue.
+    DarwinBluetooth::DispatchQueue dispatchQueue;
     DarwinBluetooth::ScopedPointer centralManager;
 
 #ifndef Q_OS_TVOS
@@ -0,0 +1,1089 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qlowenergycontroller_loopback_p.h"
+#include "qlowenergylinkstatistics_p.h"
+
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QMutex>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QTimer>
+#include <QtCore/QtEndian>
+
+#include <QtBluetooth/QLowEnergyCharacteristicData>
+#include <QtBluetooth/QLowEnergyConnectionParameters>
+#include <QtBluetooth/QLowEnergyServiceData>
+
+#include <qtbluetooth_tracepoints_p.h>
+
+#include <algorithm>
+#include <climits>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT)
+
+namespace {
+
+// The advertising peripherals of the process, by their synthetic address.
+struct LoopbackRegistry
+{
+    QMutex mutex;
+    QHash<QBluetoothAddress, QPointer<QLowEnergyControllerPrivateLoopback>> peripherals;
+    // auto-connecting centrals, by the address of the peripheral they wait for
+    QHash<QBluetoothAddress, QPointer<QLowEnergyControllerPrivateLoopback>> waitingCentrals;
+    // static random addresses, the upper two bits are set
+    quint64 nextAddress = Q_UINT64_C(0xC00000000001);
+};
+
+}
+
+Q_GLOBAL_STATIC(LoopbackRegistry, loopbackRegistry)
+
+static constexpr int defaultMtu = 23;
+static constexpr int largestMtu = 517;
+// link layer payload octets until a data length update
+static constexpr int defaultDataLength = 27;
+// keeps the number of repeated exchanges finite
+static constexpr int largestLossPercent = 90;
+
+static int loopbackSetting(const char *name, int defaultValue, int minimum, int maximum)
+{
+    if (Q_LIKELY(qEnvironmentVariableIsEmpty(name)))
+        return defaultValue;
+
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    if (!ok) {
+        qCWarning(QT_BT) << "Ignoring invalid value of" << name;
+        return defaultValue;
+    }
+    return qBound(minimum, value, maximum);
+}
+
+static bool isClientCharacteristicConfiguration(const QBluetoothUuid &uuid)
+{
+    return uuid == QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration;
+}
+
+QLowEnergyControllerPrivateLoopback::QLowEnergyControllerPrivateLoopback()
+    : QLowEnergyControllerPrivate()
+{
+    registerQLowEnergyControllerMetaType();
+}
+
+QLowEnergyControllerPrivateLoopback::~QLowEnergyControllerPrivateLoopback()
+{
+    if (!loopbackRegistry.isDestroyed()) {
+        QMutexLocker locker(&loopbackRegistry->mutex);
+        loopbackRegistry->peripherals.remove(localAdapter);
+    }
+
+    if (peer) {
+        peer->closeConnection(remoteDisconnectReason());
+        peer = nullptr;
+    }
+}
+
+/*!
+    Returns \c true if the loopback backend was selected via the
+    QT_BLUETOOTH_LOOPBACK environment variable.
+ */
+bool QLowEnergyControllerPrivateLoopback::isEnabled()
+{
+    return Q_UNLIKELY(qEnvironmentVariableIntValue("QT_BLUETOOTH_LOOPBACK") > 0);
+}
+
+void QLowEnergyControllerPrivateLoopback::init()
+{
+    // Each controller gets its own address, it is the only way to tell the
+    // controllers of one process apart.
+    {
+        QMutexLocker locker(&loopbackRegistry->mutex);
+        localAdapter = QBluetoothAddress(loopbackRegistry->nextAddress++);
+    }
+
+    maximumMtu = loopbackSetting("QT_BLUETOOTH_LOOPBACK_MTU", largestMtu,
+                                 defaultMtu, largestMtu);
+    connectionInterval = loopbackSetting("QT_BLUETOOTH_LOOPBACK_INTERVAL", 0, 0, 4000);
+    lossPercent = loopbackSetting("QT_BLUETOOTH_LOOPBACK_LOSS", 0, 0, largestLossPercent);
+    sendQueueHighWaterMark = loopbackSetting("QT_BLUETOOTH_SEND_QUEUE_HIGH_WATER_MARK",
+                                             int(sendQueueHighWaterMark), 1, INT_MAX);
+
+    transferTimer = new QTimer(this);
+    transferTimer->setSingleShot(true);
+    transferTimer->setTimerType(Qt::PreciseTimer);
+    connect(transferTimer, &QTimer::timeout,
+            this, &QLowEnergyControllerPrivateLoopback::finishTransfer);
+}
+
+bool QLowEnergyControllerPrivateLoopback::isValidLocalAdapter()
+{
+    // the address assigned by init() is all there is
+    return true;
+}
+
+void QLowEnergyControllerPrivateLoopback::connectToDevice()
+{
+    if (remoteDevice.isNull()) {
+        qCWarning(QT_BT) << "Invalid/null remote device address";
+        setError(QLowEnergyController::UnknownRemoteDeviceError);
+        return;
+    }
+
+    QPointer<QLowEnergyControllerPrivateLoopback> peripheral;
+    {
+        QMutexLocker locker(&loopbackRegistry->mutex);
+        // the peripheral stops advertising once a central connects
+        peripheral = loopbackRegistry->peripherals.take(remoteDevice);
+    }
+    if (!peripheral || peripheral->state != QLowEnergyController::AdvertisingState) {
+        if (autoConnect) {
+            // connects as soon as the peripheral advertises, see startAdvertising()
+            {
+                QMutexLocker locker(&loopbackRegistry->mutex);
+                loopbackRegistry->waitingCentrals.insert(remoteDevice, this);
+            }
+            setState(QLowEnergyController::ConnectingState);
+            return;
+        }
+        qCWarning(QT_BT) << "No loopback peripheral advertises as" << remoteDevice;
+        setError(QLowEnergyController::UnknownRemoteDeviceError);
+        return;
+    }
+
+    connectToPeripheral(peripheral);
+}
+
+void QLowEnergyControllerPrivateLoopback::connectToPeripheral(
+        QLowEnergyControllerPrivateLoopback *peripheral)
+{
+    peer = peripheral;
+    peripheral->peer = this;
+    notificationHandler = lowLatencyNotificationHandler;
+    peripheral->connectionInterval = connectionInterval;
+    peripheral->lossPercent = lossPercent;
+    linkMtu = preferredMtu > 0 ? qBound(defaultMtu, preferredMtu, maximumMtu) : maximumMtu;
+    peripheral->linkMtu = linkMtu;
+
+    setState(QLowEnergyController::ConnectingState);
+
+    // the connect indication goes out with the next advertising event
+    QTimer::singleShot(transferDelay(1), this,
+                       &QLowEnergyControllerPrivateLoopback::establishConnection);
+}
+
+void QLowEnergyControllerPrivateLoopback::establishConnection()
+{
+    if (!peer || state != QLowEnergyController::ConnectingState)
+        return;
+
+    peer->remoteDevice = localAdapter;
+    peer->setState(QLowEnergyController::ConnectedState);
+    emit peer->q_ptr->connected();
+
+    setState(QLowEnergyController::ConnectedState);
+    Q_Q(QLowEnergyController);
+    emit q->connected();
+
+    if (linkMtu != defaultMtu) {
+        emit peer->q_ptr->mtuChanged(linkMtu);
+        emit q->mtuChanged(linkMtu);
+    }
+}
+
+void QLowEnergyControllerPrivateLoopback::disconnectFromDevice()
+{
+    QPointer<QLowEnergyControllerPrivateLoopback> remote = peer;
+    peer = nullptr;
+    if (remote)
+        remote->closeConnection(remoteDisconnectReason());
+
+    {
+        QMutexLocker locker(&loopbackRegistry->mutex);
+        if (role == QLowEnergyController::PeripheralRole)
+            loopbackRegistry->peripherals.remove(localAdapter);
+        else if (loopbackRegistry->waitingCentrals.value(remoteDevice) == this)
+            loopbackRegistry->waitingCentrals.remove(remoteDevice);
+    }
+
+    closeConnection(QLowEnergyController::NoError);
+}
+
+/*!
+    Returns the error the peer sees when this side closes the connection.
+    A peripheral does not report the disconnection of its client as error.
+ */
+QLowEnergyController::Error QLowEnergyControllerPrivateLoopback::remoteDisconnectReason() const
+{
+    return role == QLowEnergyController::PeripheralRole
+            ? QLowEnergyController::RemoteHostClosedError
+            : QLowEnergyController::NoError;
+}
+
+/*!
+    Drops the connection on this side, \a reason is set as error unless it is
+    \l QLowEnergyController::NoError.
+ */
+void QLowEnergyControllerPrivateLoopback::closeConnection(QLowEnergyController::Error reason)
+{
+    peer = nullptr;
+    transferTimer->stop();
+    pendingTransfers.clear();
+    sendQueueCongested = false;
+    clientConfigurations.clear();
+    notificationHandler = nullptr;
+    linkMtu = defaultMtu;
+    txPhy = rxPhy = QLowEnergyController::Phy::Le1M;
+    txOctets = rxOctets = defaultDataLength;
+    bytesSent = bytesReceived = 0;
+    packetsSent = packetsReceived = 0;
+
+    if (state == QLowEnergyController::UnconnectedState)
+        return;
+
+    const bool wasConnected = state != QLowEnergyController::ConnectingState
+            && state != QLowEnergyController::AdvertisingState;
+    // the peripheral keeps its services for the next connection
+    if (role == QLowEnergyController::CentralRole)
+        invalidateServices();
+    else
+        remoteDevice.clear();
+
+    if (reason != QLowEnergyController::NoError)
+        setError(reason);
+    setState(QLowEnergyController::UnconnectedState);
+    if (wasConnected) {
+        Q_Q(QLowEnergyController);
+        emit q->disconnected();
+    }
+}
+
+void QLowEnergyControllerPrivateLoopback::discoverServices()
+{
+    if (!peer)
+        return;
+
+    Transfer transfer;
+    transfer.operation = Operation::Discovery;
+    // one Read By Group Type exchange per service and the final empty one
+    transfer.pduCount = int(peer->localServices.size()) + 1;
+    transfer.deliver = [this]() {
+        if (!peer)
+            return;
+
+        Q_Q(QLowEnergyController);
+        // ServiceDataMap is sorted by uuid, the services are reported in
+        // the order of their handles as on a remote device
+        QList<QSharedPointer<QLowEnergyServicePrivate>> remoteServices =
+                peer->localServices.values();
+        std::sort(remoteServices.begin(), remoteServices.end(),
+                  [](const auto &a, const auto &b) { return a->startHandle < b->startHandle; });
+        for (const auto &remoteService : std::as_const(remoteServices)) {
+            if (!isServiceInDiscoveryFilter(remoteService->uuid)
+                    || serviceList.contains(remoteService->uuid)) {
+                continue;
+            }
+
+            const auto priv = QSharedPointer<QLowEnergyServicePrivate>::create();
+            priv->uuid = remoteService->uuid;
+            priv->type = remoteService->type;
+            priv->includedServices = remoteService->includedServices;
+            priv->startHandle = remoteService->startHandle;
+            priv->endHandle = remoteService->endHandle;
+            priv->setController(this);
+            serviceList.insert(priv->uuid, priv);
+
+            emit q->serviceDiscovered(priv->uuid);
+        }
+
+        setState(QLowEnergyController::DiscoveredState);
+        emit q->discoveryFinished();
+    };
+    enqueueTransfer(std::move(transfer));
+}
+
+void QLowEnergyControllerPrivateLoopback::discoverServiceDetails(
+        const QBluetoothUuid &service, QLowEnergyService::DiscoveryMode mode)
+{
+    if (!peer || !serviceList.contains(service) || !peer->localServices.contains(service)) {
+        qCWarning(QT_BT) << "Discovery of unknown service" << service.toString()
+                         << "not possible";
+        return;
+    }
+
+    Q_UNUSED(mode);
+    const QSharedPointer<QLowEnergyServicePrivate> localService = serviceList.value(service);
+    const QLowEnergyService::DiscoveryTargets targets = localService->discoveryTargets;
+    const QList<QBluetoothUuid> filter = localService->discoveryFilter;
+    const auto isTarget = [targets, filter](const QBluetoothUuid &charUuid,
+                                            QLowEnergyService::DiscoveryTarget target) {
+        return QLowEnergyServicePrivate::isDiscoveryTarget(targets, filter, charUuid, target);
+    };
+
+    const QSharedPointer<QLowEnergyServicePrivate> remoteService = peer->localServices.value(service);
+    Transfer transfer;
+    transfer.operation = Operation::Discovery;
+    transfer.owner = localService.data();
+    // the characteristic and descriptor discoveries and the value reads
+    transfer.pduCount = 2;
+    for (const auto &charData : std::as_const(remoteService->characteristicList)) {
+        transfer.pduCount += 1;
+        if (isTarget(charData.uuid, QLowEnergyService::DescriptorDiscovery))
+            transfer.pduCount += int(charData.descriptorList.size());
+        if ((charData.properties & QLowEnergyCharacteristic::Read)
+                && isTarget(charData.uuid, QLowEnergyService::CharacteristicValueDiscovery)) {
+            transfer.pduCount += readPduCount(charData.value.size());
+        }
+        if (isTarget(charData.uuid, QLowEnergyService::DescriptorValueDiscovery)) {
+            for (const auto &descData : charData.descriptorList)
+                transfer.pduCount += readPduCount(descData.value.size());
+        }
+    }
+    transfer.deliver = [this, service, isTarget]() {
+        const QSharedPointer<QLowEnergyServicePrivate> serviceData = serviceList.value(service);
+        if (!peer || !serviceData)
+            return;
+        const QSharedPointer<QLowEnergyServicePrivate> remoteService =
+                peer->localServices.value(service);
+        if (!remoteService) {
+            serviceData->setError(QLowEnergyService::UnknownError);
+            serviceData->setState(QLowEnergyService::RemoteService);
+            return;
+        }
+
+        serviceData->characteristicList = remoteService->characteristicList;
+        for (auto &charData : serviceData->characteristicList) {
+            if (!isTarget(charData.uuid, QLowEnergyService::CharacteristicValueDiscovery)
+                    || !(charData.properties & QLowEnergyCharacteristic::Read)) {
+                charData.value.clear();
+            }
+            // like the ATT backend, skipped descriptors are not known at all
+            if (!isTarget(charData.uuid, QLowEnergyService::DescriptorDiscovery)) {
+                charData.descriptorList.clear();
+                continue;
+            }
+            const bool readDescriptors =
+                    isTarget(charData.uuid, QLowEnergyService::DescriptorValueDiscovery);
+            for (auto &descData : charData.descriptorList) {
+                if (!readDescriptors)
+                    descData.value.clear();
+                else if (isClientCharacteristicConfiguration(descData.uuid))
+                    descData.value = QByteArray(2, 0); // configured per connection
+            }
+        }
+        serviceData->setState(QLowEnergyService::RemoteServiceDiscovered);
+    };
+    enqueueTransfer(std::move(transfer));
+}
+
+void QLowEnergyControllerPrivateLoopback::readCharacteristic(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QLowEnergyHandle charHandle)
+{
+    Q_ASSERT(!service.isNull());
+    if (role == QLowEnergyController::PeripheralRole || !peer
+            || !service->characteristicList.contains(charHandle)) {
+        return;
+    }
+
+    enqueueTransfer(characteristicReadTransfer(service, charHandle));
+}
+
+/*!
+    Reads the characteristics \a charHandles with a single Read Multiple
+    Variable Length exchange, like the ATT backend of BlueZ. The peer rejects
+    the request if one of the characteristics is not readable and the response
+    ends with the first value which does not fit into it. The characteristics
+    which were not read this way are read one by one right afterwards.
+ */
+void QLowEnergyControllerPrivateLoopback::readCharacteristics(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QList<QLowEnergyHandle> &charHandles)
+{
+    Q_ASSERT(!service.isNull());
+    if (role == QLowEnergyController::PeripheralRole || !peer || charHandles.size() < 2) {
+        QLowEnergyControllerPrivate::readCharacteristics(service, charHandles);
+        return;
+    }
+
+    QList<QLowEnergyHandle> handles;
+    handles.reserve(charHandles.size());
+    for (const QLowEnergyHandle charHandle : charHandles) {
+        if (service->characteristicList.contains(charHandle))
+            handles.append(charHandle);
+    }
+    if (handles.isEmpty())
+        return;
+
+    Transfer transfer;
+    transfer.operation = Operation::Read;
+    transfer.opcode = TraceReadMultipleVariableRequest;
+    transfer.handle = service->characteristicList.value(handles.first()).valueHandle;
+    transfer.owner = service.data();
+    transfer.deliver = [this, service, handles]() {
+        if (!peer) {
+            service->setError(QLowEnergyService::CharacteristicReadError);
+            return;
+        }
+
+        QList<QLowEnergyHandle> pendingReads;
+        const bool permitted = std::all_of(handles.cbegin(), handles.cend(),
+                                           [this](QLowEnergyHandle charHandle) {
+            return peer->isRemoteReadPermitted(charHandle);
+        });
+        if (!permitted) {
+            pendingReads = handles;
+        } else {
+            // each value is preceded by its length
+            qsizetype space = linkMtu - 1;
+            for (const QLowEnergyHandle charHandle : handles) {
+                const QByteArray value = peer->remoteReadValue(charHandle, 0);
+                if (!pendingReads.isEmpty() || value.size() + 2 > space) {
+                    pendingReads.append(charHandle);
+                    continue;
+                }
+                space -= value.size() + 2;
+                updateValueOfCharacteristic(charHandle, value, false);
+                emit service->characteristicRead(QLowEnergyCharacteristic(service, charHandle),
+                                                 value);
+            }
+        }
+
+        // in reverse order to keep the order of the reads
+        for (qsizetype i = pendingReads.size() - 1; i >= 0; --i)
+            enqueueTransfer(characteristicReadTransfer(service, pendingReads.at(i)), true);
+    };
+    enqueueTransfer(std::move(transfer));
+}
+
+QLowEnergyControllerPrivateLoopback::Transfer
+QLowEnergyControllerPrivateLoopback::characteristicReadTransfer(
+        const QSharedPointer<QLowEnergyServicePrivate> &service, QLowEnergyHandle charHandle)
+{
+    Transfer transfer;
+    transfer.operation = Operation::Read;
+    transfer.opcode = TraceReadRequest;
+    transfer.handle = service->characteristicList.value(charHandle).valueHandle;
+    transfer.pduCount = readPduCount(peer->remoteReadValue(charHandle, 0).size());
+    transfer.owner = service.data();
+    transfer.deliver = [this, service, charHandle]() {
+        if (!peer || !peer->isRemoteReadPermitted(charHandle)) {
+            service->setError(QLowEnergyService::CharacteristicReadError);
+            return;
+        }
+
+        const QByteArray value = peer->remoteReadValue(charHandle, 0);
+        updateValueOfCharacteristic(charHandle, value, false);
+        emit service->characteristicRead(QLowEnergyCharacteristic(service, charHandle), value);
+    };
+    return transfer;
+}
+
+void QLowEnergyControllerPrivateLoopback::readDescriptor(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QLowEnergyHandle charHandle,
+        const QLowEnergyHandle descriptorHandle)
+{
+    Q_ASSERT(!service.isNull());
+    if (role == QLowEnergyController::PeripheralRole || !peer
+            || !service->characteristicList.contains(charHandle)) {
+        return;
+    }
+
+    Transfer transfer;
+    transfer.operation = Operation::Read;
+    transfer.opcode = TraceReadRequest;
+    transfer.handle = descriptorHandle;
+    transfer.pduCount = readPduCount(peer->remoteReadValue(charHandle, descriptorHandle).size());
+    transfer.owner = service.data();
+    transfer.deliver = [this, service, charHandle, descriptorHandle]() {
+        if (!peer) {
+            service->setError(QLowEnergyService::DescriptorReadError);
+            return;
+        }
+
+        const QByteArray value = peer->remoteReadValue(charHandle, descriptorHandle);
+        updateValueOfDescriptor(charHandle, descriptorHandle, value, false);
+        emit service->descriptorRead(QLowEnergyDescriptor(service, charHandle, descriptorHandle),
+                                     value);
+    };
+    enqueueTransfer(std::move(transfer));
+}
+
+void QLowEnergyControllerPrivateLoopback::writeCharacteristic(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QLowEnergyHandle charHandle,
+        const QByteArray &newValue,
+        QLowEnergyService::WriteMode mode)
+{
+    Q_ASSERT(!service.isNull());
+    if (!service->characteristicList.contains(charHandle))
+        return;
+
+    if (role == QLowEnergyController::PeripheralRole) {
+        QLowEnergyServicePrivate::CharData &charData = service->characteristicList[charHandle];
+        charData.value = newValue;
+        notifyCentral(charData, charHandle);
+        return;
+    }
+
+    if (!peer)
+        return;
+
+    const bool writeWithResponse = mode == QLowEnergyService::WriteWithResponse;
+    if (!writeWithResponse && newValue.size() > linkMtu - 3) {
+        qCWarning(QT_BT) << "Write without response of" << newValue.size()
+                         << "bytes exceeds the MTU of" << linkMtu;
+        service->setError(QLowEnergyService::CharacteristicWriteError);
+        return;
+    }
+
+    Transfer transfer;
+    transfer.operation = writeWithResponse ? Operation::Write : Operation::WriteWithoutResponse;
+    transfer.opcode = writeWithResponse ? TraceWriteRequest : TraceWriteCommand;
+    transfer.handle = service->characteristicList.value(charHandle).valueHandle;
+    transfer.size = int(newValue.size());
+    transfer.pduCount = writeWithResponse ? writePduCount(newValue.size()) : 1;
+    transfer.deliver = [this, service, charHandle, newValue, mode, writeWithResponse]() {
+        const bool written = peer && peer->remoteWrite(charHandle, 0, newValue, mode);
+        // write commands are not confirmed
+        if (!writeWithResponse)
+            return;
+
+        if (!written) {
+            service->setError(QLowEnergyService::CharacteristicWriteError);
+            return;
+        }
+
+        const QLowEnergyCharacteristic characteristic(service, charHandle);
+        if (characteristic.properties() & QLowEnergyCharacteristic::Read)
+            updateValueOfCharacteristic(charHandle, newValue, false);
+        emit service->characteristicWritten(characteristic, newValue);
+    };
+    enqueueTransfer(std::move(transfer));
+}
+
+/*!
+    Writes \a newValues to the characteristics \a charHandles as one reliable
+    write transaction. The prepare and execute requests go over the link as a
+    single transfer. The peer queues every value, at most up to the maximum
+    length of the characteristic, and echoes what it queued. If an echo differs
+    from the value or the peer rejects a value, the transaction is cancelled
+    and none of the characteristics changes.
+ */
+void QLowEnergyControllerPrivateLoopback::writeCharacteristicsReliably(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QList<QLowEnergyHandle> &charHandles,
+        const QList<QByteArray> &newValues)
+{
+    Q_ASSERT(!service.isNull());
+    Q_ASSERT(charHandles.size() == newValues.size());
+    if (!peer) {
+        service->setError(QLowEnergyService::CharacteristicWriteError);
+        return;
+    }
+
+    Transfer transfer;
+    transfer.operation = Operation::Write;
+    // the Prepare Write Requests and the Execute Write Request, an empty
+    // value still needs one request
+    const qsizetype chunk = linkMtu - 5;
+    transfer.pduCount = 1;
+    for (const QByteArray &newValue : newValues) {
+        transfer.pduCount += qMax(1, int((newValue.size() + chunk - 1) / chunk));
+        transfer.size += int(newValue.size());
+    }
+    transfer.deliver = [this, service, charHandles, newValues]() {
+        if (!peer) {
+            service->setError(QLowEnergyService::CharacteristicWriteError);
+            return;
+        }
+
+        for (qsizetype i = 0; i < charHandles.size(); ++i) {
+            QByteArray queuedValue;
+            if (!peer->remotePrepareWrite(charHandles.at(i), newValues.at(i), &queuedValue)) {
+                service->setError(QLowEnergyService::CharacteristicWriteError);
+                return;
+            }
+            if (queuedValue != newValues.at(i)) {
+                qCWarning(QT_BT) << "Reliable write: prepared value was altered by the peer";
+                service->setError(QLowEnergyService::CharacteristicWriteError);
+                return;
+            }
+        }
+
+        for (qsizetype i = 0; i < charHandles.size(); ++i) {
+            peer->remoteWrite(charHandles.at(i), 0, newValues.at(i),
+                              QLowEnergyService::WriteWithResponse);
+        }
+        for (qsizetype i = 0; i < charHandles.size(); ++i) {
+            const QLowEnergyCharacteristic characteristic(service, charHandles.at(i));
+            if (characteristic.properties() & QLowEnergyCharacteristic::Read)
+                updateValueOfCharacteristic(charHandles.at(i), newValues.at(i), false);
+            emit service->characteristicWritten(characteristic, newValues.at(i));
+        }
+    };
+    enqueueTransfer(std::move(transfer));
+}
+
+void QLowEnergyControllerPrivateLoopback::writeDescriptor(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QLowEnergyHandle charHandle,
+        const QLowEnergyHandle descriptorHandle,
+        const QByteArray &newValue)
+{
+    Q_ASSERT(!service.isNull());
+    if (!service->characteristicList.contains(charHandle))
+        return;
+
+    if (role == QLowEnergyController::PeripheralRole) {
+        service->characteristicList[charHandle].descriptorList[descriptorHandle].value = newValue;
+        return;
+    }
+
+    if (!peer)
+        return;
+
+    Transfer transfer;
+    transfer.operation = Operation::Write;
+    transfer.opcode = TraceWriteRequest;
+    transfer.handle = descriptorHandle;
+    transfer.size = int(newValue.size());
+    transfer.pduCount = writePduCount(newValue.size());
+    transfer.deliver = [this, service, charHandle, descriptorHandle, newValue]() {
+        if (!peer || !peer->remoteWrite(charHandle, descriptorHandle, newValue,
+                                        QLowEnergyService::WriteWithResponse)) {
+            service->setError(QLowEnergyService::DescriptorWriteError);
+            return;
+        }
+
+        updateValueOfDescriptor(charHandle, descriptorHandle, newValue, false);
+        emit service->descriptorWritten(
+                QLowEnergyDescriptor(service, charHandle, descriptorHandle), newValue);
+    };
+    enqueueTransfer(std::move(transfer));
+}
+
+void QLowEnergyControllerPrivateLoopback::startAdvertising(
+        const QLowEnergyAdvertisingParameters &/* params */,
+        const QLowEnergyAdvertisingData &/* advertisingData */,
+        const QLowEnergyAdvertisingData &/* scanResponseData */)
+{
+    QPointer<QLowEnergyControllerPrivateLoopback> central;
+    {
+        QMutexLocker locker(&loopbackRegistry->mutex);
+        central = loopbackRegistry->waitingCentrals.take(localAdapter);
+        if (!central)
+            loopbackRegistry->peripherals.insert(localAdapter, this);
+    }
+    setState(QLowEnergyController::AdvertisingState);
+
+    // an auto-connecting central connects on the first advertisement
+    if (central && central->state == QLowEnergyController::ConnectingState && !central->peer)
+        central->connectToPeripheral(this);
+}
+
+void QLowEnergyControllerPrivateLoopback::stopAdvertising()
+{
+    {
+        QMutexLocker locker(&loopbackRegistry->mutex);
+        loopbackRegistry->peripherals.remove(localAdapter);
+    }
+    setState(QLowEnergyController::UnconnectedState);
+}
+
+void QLowEnergyControllerPrivateLoopback::requestConnectionUpdate(
+        const QLowEnergyConnectionParameters &params)
+{
+    if (!peer)
+        return;
+
+    // the update takes effect at the next connection event
+    QTimer::singleShot(transferDelay(1), this, [this, params]() {
+        if (!peer)
+            return;
+
+        connectionInterval = qBound(0, qRound(params.minimumInterval()), 4000);
+        peer->connectionInterval = connectionInterval;
+
+        QLowEnergyConnectionParameters updated;
+        updated.setIntervalRange(connectionInterval, connectionInterval);
+        updated.setLatency(params.latency());
+        updated.setSupervisionTimeout(params.supervisionTimeout());
+        Q_Q(QLowEnergyController);
+        emit q->connectionUpdated(updated);
+        emit peer->q_ptr->connectionUpdated(updated);
+    });
+}
+
+void QLowEnergyControllerPrivateLoopback::requestPhy(QLowEnergyController::Phy newTxPhy,
+                                                     QLowEnergyController::Phy newRxPhy)
+{
+    if (!peer)
+        return;
+
+    // both PHYs are always supported, the update takes effect at the next connection event
+    QTimer::singleShot(transferDelay(1), this, [this, newTxPhy, newRxPhy]() {
+        if (!peer || (txPhy == newTxPhy && rxPhy == newRxPhy))
+            return;
+
+        txPhy = peer->rxPhy = newTxPhy;
+        rxPhy = peer->txPhy = newRxPhy;
+        Q_Q(QLowEnergyController);
+        emit q->phyChanged(txPhy, rxPhy);
+        emit peer->q_ptr->phyChanged(peer->txPhy, peer->rxPhy);
+    });
+}
+
+void QLowEnergyControllerPrivateLoopback::requestDataLength(int newTxOctets)
+{
+    if (!peer)
+        return;
+
+    QTimer::singleShot(transferDelay(1), this, [this, newTxOctets]() {
+        if (!peer || txOctets == newTxOctets)
+            return;
+
+        txOctets = peer->rxOctets = newTxOctets;
+        Q_Q(QLowEnergyController);
+        emit q->dataLengthChanged(txOctets, rxOctets);
+        emit peer->q_ptr->dataLengthChanged(peer->txOctets, peer->rxOctets);
+    });
+}
+
+void QLowEnergyControllerPrivateLoopback::addToGenericAttributeList(
+        const QLowEnergyServiceData &service, QLowEnergyHandle startHandle)
+{
+    // The central reads localServices directly. Only the value limits are
+    // not part of it, the handles are assigned as in addServiceHelper().
+    QLowEnergyHandle handle = startHandle + QLowEnergyHandle(service.includedServices().size());
+    const QList<QLowEnergyCharacteristicData> characteristics = service.characteristics();
+    for (const QLowEnergyCharacteristicData &cd : characteristics) {
+        const QLowEnergyHandle declHandle = ++handle;
+        ++handle; // value
+        handle += QLowEnergyHandle(cd.descriptors().size());
+        if (cd.maximumValueLength() < INT_MAX)
+            maximumValueLengths.insert(declHandle, cd.maximumValueLength());
+    }
+}
+
+int QLowEnergyControllerPrivateLoopback::mtu() const
+{
+    return linkMtu;
+}
+
+QLowEnergyLinkStatistics QLowEnergyControllerPrivateLoopback::linkStatistics() const
+{
+    QLowEnergyLinkStatistics statistics;
+    if (!peer)
+        return statistics;
+
+    statistics.d->valid = true;
+    statistics.d->bytesSent = bytesSent;
+    statistics.d->bytesReceived = bytesReceived;
+    statistics.d->packetsSent = packetsSent;
+    statistics.d->packetsReceived = packetsReceived;
+    // nothing gets lost for good on the simulated link
+    statistics.d->completedPackets = packetsSent;
+    statistics.d->connectionInterval = connectionInterval;
+    return statistics;
+}
+
+void QLowEnergyControllerPrivateLoopback::enqueueTransfer(Transfer transfer, bool first)
+{
+    transfer.queuedAt = QLowEnergyRequestRecorder::Clock::now();
+    if (transfer.opcode) {
+        Q_TRACE(QLowEnergyController_requestQueued, transfer.opcode, transfer.handle,
+                transfer.size);
+    }
+    if (first) {
+        // nothing is on the air while a transfer is delivered
+        Q_ASSERT(!transferTimer->isActive());
+        pendingTransfers.prepend(std::move(transfer));
+    } else {
+        pendingTransfers.enqueue(std::move(transfer));
+    }
+    requestStatistics.recordQueueDepth(pendingTransfers.size());
+
+    if (!sendQueueCongested && pendingTransfers.size() >= sendQueueHighWaterMark) {
+        sendQueueCongested = true;
+        Q_Q(QLowEnergyController);
+        emit q->congestionChanged(true);
+    }
+
+    // finishTransfer() starts it after the delivery which queued it
+    if (!first)
+        startNextTransfer();
+}
+
+void QLowEnergyControllerPrivateLoopback::startNextTransfer()
+{
+    // a single exchange at a time, as on an ATT bearer
+    if (transferTimer->isActive() || pendingTransfers.isEmpty())
+        return;
+
+    const Transfer &transfer = pendingTransfers.head();
+    if (transfer.opcode) {
+        Q_TRACE(QLowEnergyController_requestSent, transfer.opcode, transfer.handle,
+                transfer.size);
+    }
+    transferSentAt = QLowEnergyRequestRecorder::Clock::now();
+    transferTimer->start(transferDelay(transfer.pduCount));
+}
+
+void QLowEnergyControllerPrivateLoopback::finishTransfer()
+{
+    if (pendingTransfers.isEmpty())
+        return;
+
+    const Transfer transfer = pendingTransfers.dequeue();
+    countTransfer(transfer);
+    if (sendQueueCongested && pendingTransfers.size() <= sendQueueHighWaterMark / 2) {
+        sendQueueCongested = false;
+        Q_Q(QLowEnergyController);
+        emit q->congestionChanged(false);
+    }
+    if (transfer.operation != Operation::Notification) {
+        if (transfer.opcode && transfer.operation != Operation::WriteWithoutResponse) {
+            Q_TRACE(QLowEnergyController_responseReceived, transfer.opcode + 1,
+                    transfer.handle, transfer.size);
+        }
+        requestStatistics.recordRequest(transfer.operation, transfer.queuedAt, transferSentAt);
+    }
+    // may close the connection and with it the queue
+    if (!transfer.cancelled)
+        transfer.deliver();
+    startNextTransfer();
+}
+
+bool QLowEnergyControllerPrivateLoopback::cancelRequests(QLowEnergyServicePrivate *service)
+{
+    const auto isCancellable = [service](const Transfer &transfer) {
+        return transfer.owner == service
+                && (transfer.operation == Operation::Discovery
+                    || transfer.operation == Operation::Read);
+    };
+
+    qsizetype first = 0;
+    if (transferTimer->isActive() && !pendingTransfers.isEmpty()) {
+        // the transfer on the air takes its time nevertheless
+        if (isCancellable(pendingTransfers.head()))
+            pendingTransfers.head().cancelled = true;
+        first = 1;
+    }
+    pendingTransfers.erase(std::remove_if(pendingTransfers.begin() + first,
+                                          pendingTransfers.end(), isCancellable),
+                           pendingTransfers.end());
+    return true;
+}
+
+/*!
+    Adds \a transfer to the link statistics of both ends. A cancelled transfer
+    went over the air all the same.
+
+    All PDUs of an exchange count as sent by the side which started it and its
+    bytes are the value bytes it carries to the peer, responses are not counted.
+ */
+void QLowEnergyControllerPrivateLoopback::countTransfer(const Transfer &transfer)
+{
+    if (!peer)
+        return;
+
+    packetsSent += transfer.pduCount;
+    bytesSent += transfer.size;
+    peer->packetsReceived += transfer.pduCount;
+    peer->bytesReceived += transfer.size;
+}
+
+/*!
+    Returns the simulated time in milliseconds it takes to send \a pduCount PDUs.
+
+    Each PDU takes one connection interval, a lost PDU is repeated in the next one.
+ */
+int QLowEnergyControllerPrivateLoopback::transferDelay(int pduCount) const
+{
+    int intervals = pduCount;
+    if (lossPercent > 0) {
+        for (int i = 0; i < pduCount; ++i) {
+            while (QRandomGenerator::global()->bounded(100) < lossPercent)
+                ++intervals;
+        }
+    }
+    return intervals * connectionInterval;
+}
+
+int QLowEnergyControllerPrivateLoopback::readPduCount(qsizetype valueSize) const
+{
+    // Read Request and Read Blob Requests until a response is not full
+    const qsizetype chunk = linkMtu - 1;
+    return 1 + int(valueSize / chunk);
+}
+
+int QLowEnergyControllerPrivateLoopback::writePduCount(qsizetype valueSize) const
+{
+    if (valueSize <= linkMtu - 3)
+        return 1;
+    // Prepare Write Requests and the Execute Write Request
+    const qsizetype chunk = linkMtu - 5;
+    return int((valueSize + chunk - 1) / chunk) + 1;
+}
+
+bool QLowEnergyControllerPrivateLoopback::isRemoteReadPermitted(QLowEnergyHandle charHandle) const
+{
+    const auto service = const_cast<QLowEnergyControllerPrivateLoopback *>(this)
+            ->serviceForHandle(charHandle);
+    return service && service->characteristicList.contains(charHandle)
+            && (service->characteristicList.value(charHandle).properties
+                & QLowEnergyCharacteristic::Read);
+}
+
+/*!
+    Returns the value of the local characteristic \a charHandle, or of its
+    descriptor \a descriptorHandle if that is not \c 0.
+ */
+QByteArray QLowEnergyControllerPrivateLoopback::remoteReadValue(
+        QLowEnergyHandle charHandle, QLowEnergyHandle descriptorHandle) const
+{
+    const auto service = const_cast<QLowEnergyControllerPrivateLoopback *>(this)
+            ->serviceForHandle(charHandle);
+    if (!service)
+        return QByteArray();
+
+    const QLowEnergyServicePrivate::CharData charData =
+            service->characteristicList.value(charHandle);
+    if (!descriptorHandle)
+        return charData.value;
+
+    const QLowEnergyServicePrivate::DescData descData =
+            charData.descriptorList.value(descriptorHandle);
+    if (isClientCharacteristicConfiguration(descData.uuid)) {
+        QByteArray value(2, Qt::Uninitialized);
+        qToLittleEndian<quint16>(clientConfigurations.value(charHandle), value.data());
+        return value;
+    }
+    return descData.value;
+}
+
+/*!
+    Applies the write of the connected central to the local characteristic
+    \a charHandle, or to its descriptor \a descriptorHandle if that is not \c 0.
+    Returns \c false if the attribute does not permit the write.
+ */
+bool QLowEnergyControllerPrivateLoopback::remoteWrite(
+        QLowEnergyHandle charHandle, QLowEnergyHandle descriptorHandle,
+        const QByteArray &value, QLowEnergyService::WriteMode mode)
+{
+    const auto service = serviceForHandle(charHandle);
+    if (!service || !service->characteristicList.contains(charHandle))
+        return false;
+
+    QLowEnergyServicePrivate::CharData &charData = service->characteristicList[charHandle];
+    if (!descriptorHandle) {
+        const QLowEnergyCharacteristic::PropertyType requiredProperty =
+                mode == QLowEnergyService::WriteWithResponse
+                    ? QLowEnergyCharacteristic::Write
+                    : mode == QLowEnergyService::WriteSigned
+                      ? QLowEnergyCharacteristic::WriteSigned
+                      : QLowEnergyCharacteristic::WriteNoResponse;
+        if (!(charData.properties & requiredProperty))
+            return false;
+
+        charData.value = value;
+        const QLowEnergyCharacteristic characteristic(service, charHandle);
+        characteristic.d_ptr->notifyCharacteristicChanged(characteristic, value);
+        return true;
+    }
+
+    const auto descIt = charData.descriptorList.find(descriptorHandle);
+    if (descIt == charData.descriptorList.end())
+        return false;
+
+    if (isClientCharacteristicConfiguration(descIt->uuid)) {
+        if (value.size() != 2)
+            return false;
+        clientConfigurations.insert(charHandle, qFromLittleEndian<quint16>(value.constData()));
+    }
+    descIt->value = value;
+    emit service->descriptorWritten(QLowEnergyDescriptor(service, charHandle, descriptorHandle),
+                                    value);
+    return true;
+}
+
+/*!
+    Queues \a value for the local characteristic \a charHandle on behalf of
+    a reliable write of the connected central and sets \a queuedValue to the
+    part of it which was queued. Returns \c false if the characteristic cannot
+    be written.
+ */
+bool QLowEnergyControllerPrivateLoopback::remotePrepareWrite(
+        QLowEnergyHandle charHandle, const QByteArray &value, QByteArray *queuedValue) const
+{
+    const auto service = const_cast<QLowEnergyControllerPrivateLoopback *>(this)
+            ->serviceForHandle(charHandle);
+    if (!service || !service->characteristicList.contains(charHandle)
+            || !(service->characteristicList.value(charHandle).properties
+                 & QLowEnergyCharacteristic::Write)) {
+        return false;
+    }
+
+    *queuedValue = value.left(maximumValueLengths.value(charHandle, INT_MAX));
+    return true;
+}
+
+/*!
+    Sends the new value of the local characteristic \a charData to the connected
+    central if it enabled notifications or indications of it.
+ */
+void QLowEnergyControllerPrivateLoopback::notifyCentral(
+        const QLowEnergyServicePrivate::CharData &charData, QLowEnergyHandle charHandle)
+{
+    if (!peer)
+        return;
+
+    const quint16 configuration = clientConfigurations.value(charHandle);
+    const bool notify = (configuration & 0x1)
+            && (charData.properties & QLowEnergyCharacteristic::Notify);
+    const bool indicate = (configuration & 0x2)
+            && (charData.properties & QLowEnergyCharacteristic::Indicate);
+    if (!notify && !indicate)
+        return;
+
+    // notifications and indications carry at most MTU - 3 bytes of the value
+    const QByteArray value = charData.value.left(linkMtu - 3);
+    Transfer transfer;
+    transfer.operation = Operation::Notification;
+    transfer.opcode = TraceNotification;
+    transfer.handle = charData.valueHandle;
+    transfer.size = int(value.size());
+    // an indication waits for its confirmation
+    transfer.pduCount = notify ? 1 : 2;
+    transfer.deliver = [this, charHandle, valueHandle = charData.valueHandle, value]() {
+        if (peer)
+            peer->handleNotification(charHandle, valueHandle, value);
+    };
+    enqueueTransfer(std::move(transfer));
+}
+
+void QLowEnergyControllerPrivateLoopback::handleNotification(
+        QLowEnergyHandle charHandle, QLowEnergyHandle valueHandle, const QByteArray &value)
+{
+    // there is no reading thread, the handler runs ahead of the regular processing
+    if (notificationHandler)
+        notificationHandler(valueHandle, value);
+
+    const QLowEnergyCharacteristic characteristic = characteristicForHandle(charHandle);
+    // services whose details were not discovered ignore notifications
+    if (!characteristic.isValid())
+        return;
+
+    requestStatistics.recordNotification();
+    Q_TRACE(QLowEnergyController_notificationReceived, TraceNotification,
+            characteristic.handle(), int(value.size()));
+    updateValueOfChangedCharacteristic(characteristic, value);
+    characteristic.d_ptr->notifyCharacteristicChanged(characteristic, value);
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qlowenergycontroller_loopback_p.cpp"
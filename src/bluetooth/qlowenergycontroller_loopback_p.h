@@ -0,0 +1,191 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QLOWENERGYCONTROLLERPRIVATELOOPBACK_P_H
+#define QLOWENERGYCONTROLLERPRIVATELOOPBACK_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qglobal.h>
+#include <QtCore/QHash>
+#include <QtCore/QPointer>
+#include <QtCore/QQueue>
+#include <QtBluetooth/qbluetooth.h>
+#include "qlowenergycontroller.h"
+#include "qlowenergycontrollerbase_p.h"
+
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+
+extern void registerQLowEnergyControllerMetaType();
+
+/*
+    A backend without any Bluetooth hardware. A central controller connects
+    in-process to a peripheral controller of the same process which advertises
+    at the address it was given as remote device. Every ATT exchange is delayed
+    by one simulated connection interval, requests are serialized as on a real
+    ATT bearer and a configurable share of the exchanges has to be repeated.
+
+    The backend is selected by setting QT_BLUETOOTH_LOOPBACK, the link is
+    configured by QT_BLUETOOTH_LOOPBACK_MTU, QT_BLUETOOTH_LOOPBACK_INTERVAL
+    (in milliseconds) and QT_BLUETOOTH_LOOPBACK_LOSS (in percent). The queue
+    of exchanges waiting for the link counts as congested from
+    QT_BLUETOOTH_SEND_QUEUE_HIGH_WATER_MARK entries on, as with BlueZ. Both
+    controllers must live in the same thread.
+*/
+class QLowEnergyControllerPrivateLoopback final : public QLowEnergyControllerPrivate
+{
+    Q_OBJECT
+public:
+    QLowEnergyControllerPrivateLoopback();
+    ~QLowEnergyControllerPrivateLoopback() override;
+
+    static bool isEnabled();
+
+    void init() override;
+
+    void connectToDevice() override;
+    void disconnectFromDevice() override;
+
+    void discoverServices() override;
+    void discoverServiceDetails(const QBluetoothUuid &service,
+                                QLowEnergyService::DiscoveryMode mode) override;
+
+    void startAdvertising(const QLowEnergyAdvertisingParameters &params,
+                          const QLowEnergyAdvertisingData &advertisingData,
+                          const QLowEnergyAdvertisingData &scanResponseData) override;
+    void stopAdvertising() override;
+
+    void requestConnectionUpdate(const QLowEnergyConnectionParameters &params) override;
+    void requestPhy(QLowEnergyController::Phy txPhy, QLowEnergyController::Phy rxPhy) override;
+    void requestDataLength(int txOctets) override;
+
+    // read data
+    void readCharacteristic(const QSharedPointer<QLowEnergyServicePrivate> service,
+                            const QLowEnergyHandle charHandle) override;
+    void readCharacteristics(const QSharedPointer<QLowEnergyServicePrivate> service,
+                             const QList<QLowEnergyHandle> &charHandles) override;
+    void readDescriptor(const QSharedPointer<QLowEnergyServicePrivate> service,
+                        const QLowEnergyHandle charHandle,
+                        const QLowEnergyHandle descriptorHandle) override;
+
+    // write data
+    void writeCharacteristic(const QSharedPointer<QLowEnergyServicePrivate> service,
+                             const QLowEnergyHandle charHandle,
+                             const QByteArray &newValue, QLowEnergyService::WriteMode mode) override;
+    void writeCharacteristicsReliably(const QSharedPointer<QLowEnergyServicePrivate> service,
+                                      const QList<QLowEnergyHandle> &charHandles,
+                                      const QList<QByteArray> &newValues) override;
+    void writeDescriptor(const QSharedPointer<QLowEnergyServicePrivate> service,
+                         const QLowEnergyHandle charHandle,
+                         const QLowEnergyHandle descriptorHandle,
+                         const QByteArray &newValue) override;
+    bool cancelRequests(QLowEnergyServicePrivate *service) override;
+
+    void addToGenericAttributeList(const QLowEnergyServiceData &service,
+                                   QLowEnergyHandle startHandle) override;
+
+    bool isValidLocalAdapter() override;
+    int mtu() const override;
+    QLowEnergyLinkStatistics linkStatistics() const override;
+
+private slots:
+    void finishTransfer();
+
+private:
+    using Operation = QLowEnergyRequestStatistics::Operation;
+
+    // One ATT exchange on the simulated link, delivered once all of its
+    // PDUs went over the air.
+    struct Transfer {
+        Operation operation;
+        int opcode = 0; // for the tracepoints, 0 if not traced
+        QLowEnergyHandle handle = 0;
+        int size = 0;
+        int pduCount = 1;
+        std::function<void()> deliver;
+        QLowEnergyRequestRecorder::Clock::time_point queuedAt;
+        // service whose discovery or read issued the transfer, only compared
+        QLowEnergyServicePrivate *owner = nullptr;
+        bool cancelled = false; // delivered without calling deliver
+    };
+    // first puts the transfer ahead of all waiting transfers, only while delivering one
+    void enqueueTransfer(Transfer transfer, bool first = false);
+    Transfer characteristicReadTransfer(const QSharedPointer<QLowEnergyServicePrivate> &service,
+                                        QLowEnergyHandle charHandle);
+    void startNextTransfer();
+    int transferDelay(int pduCount) const;
+    int readPduCount(qsizetype valueSize) const;
+    int writePduCount(qsizetype valueSize) const;
+
+    void countTransfer(const Transfer &transfer);
+    void connectToPeripheral(QLowEnergyControllerPrivateLoopback *peripheral);
+    void establishConnection();
+    QLowEnergyController::Error remoteDisconnectReason() const;
+    void closeConnection(QLowEnergyController::Error reason);
+
+    // executed on the peripheral on behalf of the connected central
+    bool isRemoteReadPermitted(QLowEnergyHandle charHandle) const;
+    QByteArray remoteReadValue(QLowEnergyHandle charHandle,
+                               QLowEnergyHandle descriptorHandle) const;
+    bool remoteWrite(QLowEnergyHandle charHandle, QLowEnergyHandle descriptorHandle,
+                     const QByteArray &value, QLowEnergyService::WriteMode mode);
+    bool remotePrepareWrite(QLowEnergyHandle charHandle, const QByteArray &value,
+                            QByteArray *queuedValue) const;
+    void notifyCentral(const QLowEnergyServicePrivate::CharData &charData,
+                       QLowEnergyHandle charHandle);
+    // executed on the central
+    void handleNotification(QLowEnergyHandle charHandle, QLowEnergyHandle valueHandle,
+                            const QByteArray &value);
+
+    QPointer<QLowEnergyControllerPrivateLoopback> peer;
+    QQueue<Transfer> pendingTransfers;
+    QTimer *transferTimer = nullptr;
+    QLowEnergyRequestRecorder::Clock::time_point transferSentAt;
+
+    // link parameters, the peripheral takes those of the central when it connects
+    int linkMtu = 23;
+    int maximumMtu = 517;
+    int connectionInterval = 0; // in milliseconds
+    int lossPercent = 0;
+    // as seen from this side, the peer uses them the other way around
+    QLowEnergyController::Phy txPhy = QLowEnergyController::Phy::Le1M;
+    QLowEnergyController::Phy rxPhy = QLowEnergyController::Phy::Le1M;
+    int txOctets = 27;
+    int rxOctets = 27;
+
+    // traffic of the current connection, see linkStatistics()
+    quint64 bytesSent = 0;
+    quint64 bytesReceived = 0;
+    quint64 packetsSent = 0;
+    quint64 packetsReceived = 0;
+
+    // see QLowEnergyController::congestionChanged()
+    qsizetype sendQueueHighWaterMark = 64;
+    bool sendQueueCongested = false;
+
+    // limits of the local characteristic values which have one, by characteristic
+    QHash<QLowEnergyHandle, int> maximumValueLengths;
+
+    // taken from lowLatencyNotificationHandler when connecting
+    QLowEnergyController::LowLatencyNotificationHandler notificationHandler;
+
+    // client characteristic configurations of the connected central, by characteristic
+    QHash<QLowEnergyHandle, quint16> clientConfigurations;
+};
+
+QT_END_NAMESPACE
+
+#endif // QLOWENERGYCONTROLLERPRIVATELOOPBACK_P_H
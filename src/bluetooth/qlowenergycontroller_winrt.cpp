@@ -3,6 +3,7 @@
 
 #include "qlowenergycontroller_winrt_p.h"
 #include "qbluetoothutils_winrt_p.h"
+#include <qtbluetooth_tracepoints_p.h>
 
 #include <QtBluetooth/qbluetoothlocaldevice.h>
 #include <QtBluetooth/QLowEnergyCharacteristicData>
@@ -14,8 +15,13 @@
 #include <QtCore/QLoggingCategory>
 #include <QtCore/private/qfunctions_winrt_p.h>
 #include <QtCore/QDeadlineTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QPointer>
 
+#include <algorithm>
 #include <functional>
+#include <utility>
 #include <robuffer.h>
 #include <windows.devices.enumeration.h>
 #include <windows.devices.bluetooth.h>
@@ -43,15 +49,15 @@ typedef ITypedEventHandler<GattCharacteristic *, GattValueChangedEventArgs *> Va
 typedef GattReadClientCharacteristicConfigurationDescriptorResult ClientCharConfigDescriptorResult;
 typedef IGattReadClientCharacteristicConfigurationDescriptorResult IClientCharConfigDescriptorResult;
 
-#define EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED(hr) \
+#define EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED(hr) \
     if (FAILED(hr)) { \
-        emitErrorAndQuitThread(hr); \
+        emitErrorAndFinish(hr); \
         return; \
     }
 
-#define EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, message) \
+#define EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, message) \
     if (FAILED(hr)) { \
-        emitErrorAndQuitThread(message); \
+        emitErrorAndFinish(message); \
         return; \
     }
 
@@ -111,14 +117,86 @@ static void closeDeviceService(ComPtr<IGattDeviceService> service)
     RETURN_IF_FAILED("Service Close() failed", return);
 }
 
+/*
+ * Connecting and discovering the details of a service block on WinRT
+ * operations, which is why they run on worker threads. A few threads are shared
+ * by all controllers and kept running, so that connecting to many devices does
+ * not create and destroy a thread each time. A new worker goes to the thread
+ * with the fewest workers and deletes itself once it is done.
+ */
+class QWinRTLowEnergyWorkerThreads
+{
+public:
+    QWinRTLowEnergyWorkerThreads()
+    {
+        for (QThread &thread : threads) {
+            thread.setObjectName(QStringLiteral("QtBluetoothLEWorker"));
+            thread.start();
+        }
+    }
+    ~QWinRTLowEnergyWorkerThreads()
+    {
+        for (QThread &thread : threads)
+            thread.quit();
+        for (QThread &thread : threads)
+            thread.wait();
+    }
+
+    template <typename Worker>
+    void start(Worker *worker, void (Worker::*entryPoint)())
+    {
+        QMutexLocker locker(&mutex);
+        const int index = int(std::min_element(std::begin(workerCounts), std::end(workerCounts))
+                              - std::begin(workerCounts));
+        ++workerCounts[index];
+        locker.unlock();
+
+        worker->moveToThread(&threads[index]);
+        QObject::connect(worker, &QObject::destroyed, [this, index]() {
+            QMutexLocker locker(&mutex);
+            --workerCounts[index];
+        });
+        QMetaObject::invokeMethod(worker, entryPoint, Qt::QueuedConnection);
+    }
+
+private:
+    static constexpr int threadCount = 4;
+
+    QThread threads[threadCount];
+    QMutex mutex;
+    int workerCounts[threadCount] = {};
+};
+
+Q_GLOBAL_STATIC(QWinRTLowEnergyWorkerThreads, workerThreads)
+
+// Returns false if the platform's default cache mode is to be used.
+static bool cacheModeForPolicy(QLowEnergyController::GattCachePolicy policy,
+                               BluetoothCacheMode *mode)
+{
+    switch (policy) {
+    case QLowEnergyController::GattCachePolicy::Cached:
+        *mode = BluetoothCacheMode_Cached;
+        return true;
+    case QLowEnergyController::GattCachePolicy::Uncached:
+        *mode = BluetoothCacheMode_Uncached;
+        return true;
+    case QLowEnergyController::GattCachePolicy::PlatformDefault:
+        break;
+    }
+    return false;
+}
+
 class QWinRTLowEnergyServiceHandler : public QObject
 {
     Q_OBJECT
 public:
     QWinRTLowEnergyServiceHandler(const QBluetoothUuid &service,
                                      const ComPtr<IGattDeviceService3> &deviceService,
-                                     QLowEnergyService::DiscoveryMode mode)
-        : mService(service), mMode(mode), mDeviceService(deviceService)
+                                     QLowEnergyService::DiscoveryTargets targets,
+                                     const QList<QBluetoothUuid> &filter,
+                                     QLowEnergyController::GattCachePolicy cachePolicy)
+        : mService(service), mTargets(targets), mFilter(filter), mCachePolicy(cachePolicy),
+          mDeviceService(deviceService)
     {
         qCDebug(QT_BT_WINDOWS) << __FUNCTION__;
     }
@@ -135,25 +213,29 @@ public slots:
         qCDebug(QT_BT_WINDOWS) << __FUNCTION__;
         ComPtr<IAsyncOperation<GattCharacteristicsResult *>> characteristicsOp;
         ComPtr<IGattCharacteristicsResult> characteristicsResult;
-        HRESULT hr = mDeviceService->GetCharacteristicsAsync(&characteristicsOp);
-        EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED(hr);
+        BluetoothCacheMode cacheMode;
+        HRESULT hr = cacheModeForPolicy(mCachePolicy, &cacheMode)
+                ? mDeviceService->GetCharacteristicsWithCacheModeAsync(cacheMode,
+                                                                    &characteristicsOp)
+                : mDeviceService->GetCharacteristicsAsync(&characteristicsOp);
+        EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED(hr);
         hr = QWinRTFunctions::await(characteristicsOp, characteristicsResult.GetAddressOf(),
                                     QWinRTFunctions::ProcessMainThreadEvents, 5000);
-        EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED(hr);
+        EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED(hr);
         GattCommunicationStatus status;
         hr = characteristicsResult->get_Status(&status);
-        EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED(hr);
+        EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED(hr);
         if (status != GattCommunicationStatus_Success) {
-            emitErrorAndQuitThread(QLatin1String("Could not obtain char list"));
+            emitErrorAndFinish(QLatin1String("Could not obtain char list"));
             return;
         }
         ComPtr<IVectorView<GattCharacteristic *>> characteristics;
         hr = characteristicsResult->get_Characteristics(&characteristics);
-        EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED(hr);
+        EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED(hr);
 
         uint characteristicsCount;
         hr = characteristics->get_Size(&characteristicsCount);
-        EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED(hr);
+        EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED(hr);
 
         mCharacteristicsCountToBeDiscovered = characteristicsCount;
         for (uint i = 0; i < characteristicsCount; ++i) {
@@ -178,7 +260,9 @@ public slots:
             // So we start 'GetDescriptorsAsync' for each discovered characteristic and finish only
             // when GetDescriptorsAsync for all characteristics return.
             ComPtr<IAsyncOperation<GattDescriptorsResult *>> descAsyncOp;
-            hr = characteristic3->GetDescriptorsAsync(&descAsyncOp);
+            hr = cacheModeForPolicy(mCachePolicy, &cacheMode)
+                    ? characteristic3->GetDescriptorsWithCacheModeAsync(cacheMode, &descAsyncOp)
+                    : characteristic3->GetDescriptorsAsync(&descAsyncOp);
             DEC_CHAR_COUNT_AND_CONTINUE_IF_FAILED(hr, "Could not obtain list of descriptors")
 
             ComPtr<IGattDescriptorsResult> descResult;
@@ -205,7 +289,9 @@ public slots:
                                                   "Could not obtain characteristic's properties")
             charData.properties = QLowEnergyCharacteristic::PropertyTypes(properties & 0xff);
             if (charData.properties & QLowEnergyCharacteristic::Read
-                && mMode == QLowEnergyService::FullDiscovery) {
+                && QLowEnergyServicePrivate::isDiscoveryTarget(
+                        mTargets, mFilter, charData.uuid,
+                        QLowEnergyService::CharacteristicValueDiscovery)) {
                 ComPtr<IAsyncOperation<GattReadResult *>> readOp;
                 hr = characteristic->ReadValueWithCacheModeAsync(BluetoothCacheMode_Uncached,
                                                                  &readOp);
@@ -237,6 +323,8 @@ public slots:
             uint descriptorCount;
             hr = descriptors->get_Size(&descriptorCount);
             DEC_CHAR_COUNT_AND_CONTINUE_IF_FAILED(hr, "Could not obtain list of descriptors' size")
+            const bool readDescriptors = QLowEnergyServicePrivate::isDiscoveryTarget(
+                    mTargets, mFilter, charData.uuid, QLowEnergyService::DescriptorValueDiscovery);
             for (uint j = 0; j < descriptorCount; ++j) {
                 QLowEnergyServicePrivate::DescData descData;
                 ComPtr<IGattDescriptor> descriptor;
@@ -251,7 +339,7 @@ public slots:
                 descData.uuid = QBluetoothUuid(descriptorUuid);
                 charData.descriptorList.insert(descHandle, descData);
                 if (descData.uuid == QBluetoothUuid(QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration)) {
-                    if (mMode == QLowEnergyService::FullDiscovery) {
+                    if (readDescriptors) {
                         ComPtr<IAsyncOperation<ClientCharConfigDescriptorResult *>> readOp;
                         hr = characteristic->ReadClientCharacteristicConfigurationDescriptorAsync(
                                 &readOp);
@@ -283,7 +371,7 @@ public slots:
                     }
                     mIndicateChars << charData.uuid;
                 } else {
-                    if (mMode == QLowEnergyService::FullDiscovery) {
+                    if (readDescriptors) {
                         ComPtr<IAsyncOperation<GattReadResult *>> readOp;
                         hr = descriptor->ReadValueWithCacheModeAsync(BluetoothCacheMode_Uncached,
                                                                      &readOp);
@@ -308,12 +396,15 @@ public slots:
 
 private:
     bool checkAllCharacteristicsDiscovered();
-    void emitErrorAndQuitThread(HRESULT hr);
-    void emitErrorAndQuitThread(const QString &error);
+    void emitErrorAndFinish(HRESULT hr);
+    void emitErrorAndFinish(const QString &error);
 
 public:
     QBluetoothUuid mService;
-    QLowEnergyService::DiscoveryMode mMode;
+    // copies, the handler runs in its own thread
+    QLowEnergyService::DiscoveryTargets mTargets;
+    QList<QBluetoothUuid> mFilter;
+    QLowEnergyController::GattCachePolicy mCachePolicy;
     ComPtr<IGattDeviceService3> mDeviceService;
     QHash<QLowEnergyHandle, QLowEnergyServicePrivate::CharData> mCharacteristicList;
     uint mCharacteristicsCountToBeDiscovered;
@@ -334,22 +425,22 @@ bool QWinRTLowEnergyServiceHandler::checkAllCharacteristicsDiscovered()
     if (mCharacteristicsCountToBeDiscovered == 0) {
         emit charListObtained(mService, mCharacteristicList, mIndicateChars,
                               mStartHandle, mEndHandle);
-        QThread::currentThread()->quit();
+        deleteLater();
         return true;
     }
 
     return false;
 }
 
-void QWinRTLowEnergyServiceHandler::emitErrorAndQuitThread(HRESULT hr)
+void QWinRTLowEnergyServiceHandler::emitErrorAndFinish(HRESULT hr)
 {
-    emitErrorAndQuitThread(qt_error_string(hr));
+    emitErrorAndFinish(qt_error_string(hr));
 }
 
-void QWinRTLowEnergyServiceHandler::emitErrorAndQuitThread(const QString &error)
+void QWinRTLowEnergyServiceHandler::emitErrorAndFinish(const QString &error)
 {
     emit errorOccured(error);
-    QThread::currentThread()->quit();
+    deleteLater();
 }
 
 class QWinRTLowEnergyConnectionHandler : public QObject
@@ -385,9 +476,9 @@ signals:
 private:
     void connectToPairedDevice();
     void connectToUnpairedDevice();
-    void emitErrorAndQuitThread(const QString &error);
-    void emitErrorAndQuitThread(const char *error);
-    void emitConnectedAndQuitThread();
+    void emitErrorAndFinish(const QString &error);
+    void emitErrorAndFinish(const char *error);
+    void emitConnectedAndFinish();
 
     ComPtr<IBluetoothLEDevice> mDevice = nullptr;
     ComPtr<IGattSession> mGattSession = nullptr;
@@ -407,25 +498,25 @@ void QWinRTLowEnergyConnectionHandler::connectToDevice()
     HRESULT hr = GetActivationFactory(
             HString::MakeReference(RuntimeClass_Windows_Devices_Bluetooth_BluetoothLEDevice).Get(),
             &deviceStatics);
-    EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not obtain device factory");
+    EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not obtain device factory");
     ComPtr<IAsyncOperation<BluetoothLEDevice *>> deviceFromIdOperation;
     hr = deviceStatics->FromBluetoothAddressAsync(mAddress.toUInt64(), &deviceFromIdOperation);
-    EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not find LE device from address");
+    EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not find LE device from address");
     hr = QWinRTFunctions::await(deviceFromIdOperation, mDevice.GetAddressOf(),
                                 QWinRTFunctions::ProcessMainThreadEvents, 5000, earlyExit);
     if (FAILED(hr) || !mDevice) {
-        emitErrorAndQuitThread("Could not find LE device");
+        emitErrorAndFinish("Could not find LE device");
         return;
     }
 
     // get GattSession: 1. get device id
     ComPtr<IBluetoothLEDevice4> device4;
     hr = mDevice.As(&device4);
-    EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not cast device");
+    EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not cast device");
 
     ComPtr<IBluetoothDeviceId> deviceId;
     hr = device4->get_BluetoothDeviceId(&deviceId);
-    EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not get bluetooth device id");
+    EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not get bluetooth device id");
 
     // get GattSession: 2. get session statics
     ComPtr<IGattSessionStatics> sessionStatics;
@@ -434,21 +525,21 @@ void QWinRTLowEnergyConnectionHandler::connectToDevice()
                     RuntimeClass_Windows_Devices_Bluetooth_GenericAttributeProfile_GattSession)
                     .Get(),
             &sessionStatics);
-    EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not obtain GattSession statics");
+    EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not obtain GattSession statics");
 
     // get GattSession: 3. get session
     ComPtr<IAsyncOperation<GattSession *>> gattSessionFromIdOperation;
     hr = sessionStatics->FromDeviceIdAsync(deviceId.Get(), &gattSessionFromIdOperation);
-    EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not get GattSession from id");
+    EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not get GattSession from id");
     hr = QWinRTFunctions::await(gattSessionFromIdOperation, mGattSession.GetAddressOf(),
                                 QWinRTFunctions::ProcessMainThreadEvents, 5000, earlyExit);
-    EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not complete Gatt session acquire");
+    EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not complete Gatt session acquire");
 
     BluetoothConnectionStatus status;
     hr = mDevice->get_ConnectionStatus(&status);
-    EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not obtain device's connection status");
+    EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not obtain device's connection status");
     if (status == BluetoothConnectionStatus::BluetoothConnectionStatus_Connected) {
-        emitConnectedAndQuitThread();
+        emitConnectedAndFinish();
         return;
     }
 
@@ -476,34 +567,34 @@ void QWinRTLowEnergyConnectionHandler::connectToPairedDevice()
     qCDebug(QT_BT_WINDOWS) << __FUNCTION__;
     ComPtr<IBluetoothLEDevice3> device3;
     HRESULT hr = mDevice.As(&device3);
-    EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not cast device");
+    EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not cast device");
     ComPtr<IAsyncOperation<GattDeviceServicesResult *>> deviceServicesOp;
     auto earlyExit = [this]() { return mAbortConnection; };
     QDeadlineTimer deadline(kMaxConnectTimeout);
     while (!mAbortConnection && !deadline.hasExpired()) {
         hr = device3->GetGattServicesAsync(&deviceServicesOp);
-        EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not obtain services");
+        EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not obtain services");
         ComPtr<IGattDeviceServicesResult> deviceServicesResult;
         hr = QWinRTFunctions::await(deviceServicesOp, deviceServicesResult.GetAddressOf(),
                                     QWinRTFunctions::ProcessThreadEvents, 5000, earlyExit);
-        EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not await services operation");
+        EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not await services operation");
 
         GattCommunicationStatus commStatus;
         hr = deviceServicesResult->get_Status(&commStatus);
         if (FAILED(hr) || commStatus != GattCommunicationStatus_Success) {
-            emitErrorAndQuitThread("Service operation failed");
+            emitErrorAndFinish("Service operation failed");
             return;
         }
 
         ComPtr<IVectorView<GattDeviceService *>> deviceServices;
         hr = deviceServicesResult->get_Services(&deviceServices);
-        EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not obtain list of services");
+        EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not obtain list of services");
         uint serviceCount;
         hr = deviceServices->get_Size(&serviceCount);
-        EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not obtain service count");
+        EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not obtain service count");
 
         if (serviceCount == 0) {
-            emitErrorAndQuitThread("Found devices without services");
+            emitErrorAndFinish("Found devices without services");
             return;
         }
 
@@ -512,17 +603,17 @@ void QWinRTLowEnergyConnectionHandler::connectToPairedDevice()
         for (uint i = 0; i < serviceCount; ++i) {
             ComPtr<IGattDeviceService> service;
             hr = deviceServices->GetAt(i, &service);
-            EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not obtain service");
+            EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not obtain service");
             ComPtr<IGattDeviceService3> service3;
             hr = service.As(&service3);
-            EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not cast service");
+            EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not cast service");
             ComPtr<IAsyncOperation<GattCharacteristicsResult *>> characteristicsOp;
             hr = service3->GetCharacteristicsAsync(&characteristicsOp);
-            EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not obtain characteristic");
+            EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not obtain characteristic");
             ComPtr<IGattCharacteristicsResult> characteristicsResult;
             hr = QWinRTFunctions::await(characteristicsOp, characteristicsResult.GetAddressOf(),
                                         QWinRTFunctions::ProcessThreadEvents, 5000, earlyExit);
-            EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not await characteristic operation");
+            EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not await characteristic operation");
             GattCommunicationStatus commStatus;
             hr = characteristicsResult->get_Status(&commStatus);
             if (FAILED(hr) || commStatus != GattCommunicationStatus_Success) {
@@ -534,29 +625,29 @@ void QWinRTLowEnergyConnectionHandler::connectToPairedDevice()
             if (hr == E_ACCESSDENIED) {
                 // Everything will work as expected up until this point if the
                 // manifest capabilties for bluetooth LE are not set.
-                emitErrorAndQuitThread("Could not obtain characteristic list. "
+                emitErrorAndFinish("Could not obtain characteristic list. "
                                        "Please check your manifest capabilities");
                 return;
             }
-            EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not obtain characteristic list");
+            EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not obtain characteristic list");
             uint characteristicsCount;
             hr = characteristics->get_Size(&characteristicsCount);
-            EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr,
+            EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr,
                                                    "Could not obtain characteristic list's size");
             for (uint j = 0; j < characteristicsCount; ++j) {
                 ComPtr<IGattCharacteristic> characteristic;
                 hr = characteristics->GetAt(j, &characteristic);
-                EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not obtain characteristic");
+                EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not obtain characteristic");
                 ComPtr<IAsyncOperation<GattReadResult *>> op;
                 GattCharacteristicProperties props;
                 hr = characteristic->get_CharacteristicProperties(&props);
-                EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(
+                EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(
                         hr, "Could not obtain characteristic's properties");
                 if (!(props & GattCharacteristicProperties_Read))
                     continue;
                 hr = characteristic->ReadValueWithCacheModeAsync(
                         BluetoothCacheMode::BluetoothCacheMode_Uncached, &op);
-                EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not read characteristic value");
+                EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not read characteristic value");
                 ComPtr<IGattReadResult> result;
                 // Reading characteristics can take surprisingly long at the
                 // first time, so we need to have a large the timeout here.
@@ -566,24 +657,24 @@ void QWinRTLowEnergyConnectionHandler::connectToPairedDevice()
                 // the moment. In this case we should jump back into the outer loop and keep trying.
                 if (hr == E_ILLEGAL_METHOD_CALL)
                     break;
-                EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not await characteristic read");
+                EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not await characteristic read");
                 ComPtr<ABI::Windows::Storage::Streams::IBuffer> buffer;
                 hr = result->get_Value(&buffer);
-                EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not obtain characteristic value");
+                EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not obtain characteristic value");
                 if (!buffer) {
                     qCDebug(QT_BT_WINDOWS) << "Problem reading value";
                     break;
                 }
 
-                emitConnectedAndQuitThread();
+                emitConnectedAndFinish();
                 return;
             }
         }
     }
     // If we got here because of mAbortConnection == true, the error message
-    // will not be delivered, so it does not matter. But we need to terminate
-    // the thread anyway!
-    emitErrorAndQuitThread("Connect to device failed due to timeout!");
+    // will not be delivered, so it does not matter. But the worker has to
+    // finish anyway!
+    emitErrorAndFinish("Connect to device failed due to timeout!");
 }
 
 void QWinRTLowEnergyConnectionHandler::connectToUnpairedDevice()
@@ -591,17 +682,17 @@ void QWinRTLowEnergyConnectionHandler::connectToUnpairedDevice()
     qCDebug(QT_BT_WINDOWS) << __FUNCTION__;
     ComPtr<IBluetoothLEDevice3> device3;
     HRESULT hr = mDevice.As(&device3);
-    EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not cast device");
+    EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not cast device");
     ComPtr<IGattDeviceServicesResult> deviceServicesResult;
     auto earlyExit = [this]() { return mAbortConnection; };
     QDeadlineTimer deadline(kMaxConnectTimeout);
     while (!mAbortConnection && !deadline.hasExpired()) {
         ComPtr<IAsyncOperation<GattDeviceServicesResult *>> deviceServicesOp;
         hr = device3->GetGattServicesAsync(&deviceServicesOp);
-        EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not obtain services");
+        EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not obtain services");
         hr = QWinRTFunctions::await(deviceServicesOp, deviceServicesResult.GetAddressOf(),
                                     QWinRTFunctions::ProcessMainThreadEvents, 0, earlyExit);
-        EMIT_WORKER_ERROR_AND_QUIT_IF_FAILED_2(hr, "Could not await services operation");
+        EMIT_WORKER_ERROR_AND_FINISH_IF_FAILED_2(hr, "Could not await services operation");
 
         GattCommunicationStatus commStatus;
         hr = deviceServicesResult->get_Status(&commStatus);
@@ -609,43 +700,40 @@ void QWinRTLowEnergyConnectionHandler::connectToUnpairedDevice()
             continue;
 
         if (FAILED(hr) || commStatus != GattCommunicationStatus_Success) {
-            emitErrorAndQuitThread("Service operation failed");
+            emitErrorAndFinish("Service operation failed");
             return;
         }
 
-        emitConnectedAndQuitThread();
+        emitConnectedAndFinish();
         return;
     }
     // If we got here because of mAbortConnection == true, the error message
-    // will not be delivered, so it does not matter. But we need to terminate
-    // the thread anyway!
-    emitErrorAndQuitThread("Connect to device failed due to timeout!");
+    // will not be delivered, so it does not matter. But the worker has to
+    // finish anyway!
+    emitErrorAndFinish("Connect to device failed due to timeout!");
 }
 
-void QWinRTLowEnergyConnectionHandler::emitErrorAndQuitThread(const QString &error)
+void QWinRTLowEnergyConnectionHandler::emitErrorAndFinish(const QString &error)
 {
     emit errorOccurred(error);
-    QThread::currentThread()->quit();
+    deleteLater();
 }
 
-void QWinRTLowEnergyConnectionHandler::emitErrorAndQuitThread(const char *error)
+void QWinRTLowEnergyConnectionHandler::emitErrorAndFinish(const char *error)
 {
-    emitErrorAndQuitThread(QString::fromUtf8(error));
+    emitErrorAndFinish(QString::fromUtf8(error));
 }
 
-void QWinRTLowEnergyConnectionHandler::emitConnectedAndQuitThread()
+void QWinRTLowEnergyConnectionHandler::emitConnectedAndFinish()
 {
     emit deviceConnected(mDevice, mGattSession);
-    QThread::currentThread()->quit();
+    deleteLater();
 }
 
 QLowEnergyControllerPrivateWinRT::QLowEnergyControllerPrivateWinRT()
     : QLowEnergyControllerPrivate()
 {
     registerQLowEnergyControllerMetaType();
-    connect(this, &QLowEnergyControllerPrivateWinRT::characteristicChanged,
-            this, &QLowEnergyControllerPrivateWinRT::handleCharacteristicChanged,
-            Qt::QueuedConnection);
 }
 
 QLowEnergyControllerPrivateWinRT::~QLowEnergyControllerPrivateWinRT()
@@ -669,13 +757,8 @@ void QLowEnergyControllerPrivateWinRT::connectToDevice()
     setState(QLowEnergyController::ConnectingState);
 
     QWinRTLowEnergyConnectionHandler *worker = new QWinRTLowEnergyConnectionHandler(remoteDevice);
-    QThread *thread = new QThread;
-    worker->moveToThread(thread);
     connect(this, &QLowEnergyControllerPrivateWinRT::abortConnection, worker,
             &QWinRTLowEnergyConnectionHandler::handleDeviceDisconnectRequest);
-    connect(thread, &QThread::started, worker, &QWinRTLowEnergyConnectionHandler::connectToDevice);
-    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
-    connect(worker, &QObject::destroyed, thread, &QObject::deleteLater);
     connect(worker, &QWinRTLowEnergyConnectionHandler::errorOccurred, this,
             [this](const QString &msg) { handleConnectionError(msg.toUtf8().constData()); });
     connect(worker, &QWinRTLowEnergyConnectionHandler::deviceConnected, this,
@@ -696,7 +779,7 @@ void QLowEnergyControllerPrivateWinRT::connectToDevice()
                 setState(QLowEnergyController::ConnectedState);
                 emit q->connected();
             });
-    thread->start();
+    workerThreads()->start(worker, &QWinRTLowEnergyConnectionHandler::connectToDevice);
 }
 
 void QLowEnergyControllerPrivateWinRT::disconnectFromDevice()
@@ -769,6 +852,11 @@ ComPtr<IGattDeviceService> QLowEnergyControllerPrivateWinRT::getNativeService(
 ComPtr<IGattCharacteristic> QLowEnergyControllerPrivateWinRT::getNativeCharacteristic(
         const QBluetoothUuid &serviceUuid, const QBluetoothUuid &charUuid)
 {
+    const auto key = qMakePair(serviceUuid, charUuid);
+    const auto cached = m_nativeCharacteristics.constFind(key);
+    if (cached != m_nativeCharacteristics.cend())
+        return cached.value();
+
     ComPtr<IGattDeviceService> service = getNativeService(serviceUuid);
     if (!service)
         return nullptr;
@@ -800,39 +888,83 @@ ComPtr<IGattCharacteristic> QLowEnergyControllerPrivateWinRT::getNativeCharacter
     ComPtr<IGattCharacteristic> characteristic;
     hr = characteristics->GetAt(0, &characteristic);
     RETURN_IF_FAILED("Could not obtain first characteristic for service", return nullptr);
+    m_nativeCharacteristics.insert(key, characteristic);
     return characteristic;
 }
 
-void QLowEnergyControllerPrivateWinRT::registerForValueChanges(const QBluetoothUuid &serviceUuid,
-                                                                  const QBluetoothUuid &charUuid)
+/*
+    Registers the characteristics \a charUuids of \a serviceUuid for value changes.
+    All characteristics of the service are obtained with a single request rather
+    than awaiting a lookup per characteristic.
+*/
+void QLowEnergyControllerPrivateWinRT::registerForValueChanges(
+        const QBluetoothUuid &serviceUuid, const QList<QBluetoothUuid> &charUuids)
 {
-    qCDebug(QT_BT_WINDOWS) << "Registering characteristic" << charUuid << "in service"
-                         << serviceUuid << "for value changes";
-    for (const ValueChangedEntry &entry : qAsConst(mValueChangedTokens)) {
-        GUID guuid;
-        HRESULT hr;
-        hr = entry.characteristic->get_Uuid(&guuid);
-        WARN_AND_CONTINUE_IF_FAILED(hr, "Could not obtain characteristic's Uuid")
-        if (QBluetoothUuid(guuid) == charUuid)
-            return;
-    }
-    ComPtr<IGattCharacteristic> characteristic = getNativeCharacteristic(serviceUuid, charUuid);
-    if (!characteristic) {
-        qCDebug(QT_BT_WINDOWS).nospace() << "Could not obtain native characteristic " << charUuid
-                             << " from service " << serviceUuid << ". Qt will not be able to signal"
-                             << " changes for this characteristic.";
+    if (charUuids.isEmpty())
+        return;
+
+    qCDebug(QT_BT_WINDOWS) << "Registering characteristics" << charUuids << "in service"
+                           << serviceUuid << "for value changes";
+    ComPtr<IGattDeviceService> service = getNativeService(serviceUuid);
+    if (!service)
+        return;
+    ComPtr<IGattDeviceService3> service3;
+    HRESULT hr = service.As(&service3);
+    RETURN_IF_FAILED("Could not cast service to service3", return);
+    ComPtr<IAsyncOperation<GattCharacteristicsResult *>> op;
+    hr = service3->GetCharacteristicsAsync(&op);
+    RETURN_IF_FAILED("Could not obtain native characteristics for service", return);
+    ComPtr<IGattCharacteristicsResult> result;
+    QPointer<QLowEnergyControllerPrivateWinRT> thisPtr(this);
+    hr = QWinRTFunctions::await(op, result.GetAddressOf(), QWinRTFunctions::ProcessMainThreadEvents, 5000);
+    if (!thisPtr)
+        return;
+    RETURN_IF_FAILED("Could not await completion of characteristic operation", return);
+    GattCommunicationStatus status;
+    hr = result->get_Status(&status);
+    if (FAILED(hr) || status != GattCommunicationStatus_Success) {
+        qErrnoWarning(hr, "Native characteristic operation failed.");
         return;
     }
+    ComPtr<IVectorView<GattCharacteristic *>> characteristics;
+    hr = result->get_Characteristics(&characteristics);
+    RETURN_IF_FAILED("Could not obtain characteristic list.", return);
+    uint size;
+    hr = characteristics->get_Size(&size);
+    RETURN_IF_FAILED("Could not obtain characteristic list's size.", return);
 
-    EventRegistrationToken token;
-    HRESULT hr;
-    hr = characteristic->add_ValueChanged(
-                Callback<ValueChangedHandler>(this, &QLowEnergyControllerPrivateWinRT::onValueChange).Get(),
-                &token);
-    RETURN_IF_FAILED("Could not register characteristic for value changes", return)
-    mValueChangedTokens.append(ValueChangedEntry(characteristic, token));
-    qCDebug(QT_BT_WINDOWS) << "Characteristic" << charUuid << "in service"
-        << serviceUuid << "registered for value changes";
+    for (uint i = 0; i < size; ++i) {
+        ComPtr<IGattCharacteristic> characteristic;
+        hr = characteristics->GetAt(i, &characteristic);
+        WARN_AND_CONTINUE_IF_FAILED(hr, "Could not obtain characteristic")
+        GUID guuid;
+        hr = characteristic->get_Uuid(&guuid);
+        WARN_AND_CONTINUE_IF_FAILED(hr, "Could not obtain characteristic's Uuid")
+        const QBluetoothUuid charUuid(guuid);
+        if (!charUuids.contains(charUuid))
+            continue;
+        // the first instance of a uuid is used, like getNativeCharacteristic() does
+        const auto key = qMakePair(serviceUuid, charUuid);
+        if (m_nativeCharacteristics.contains(key))
+            characteristic = m_nativeCharacteristics.value(key);
+        else
+            m_nativeCharacteristics.insert(key, characteristic);
+
+        const auto isRegistered = [&characteristic](const ValueChangedEntry &entry) {
+            return entry.characteristic.Get() == characteristic.Get();
+        };
+        if (std::any_of(mValueChangedTokens.cbegin(), mValueChangedTokens.cend(), isRegistered))
+            continue;
+
+        EventRegistrationToken token;
+        hr = characteristic->add_ValueChanged(
+                    Callback<ValueChangedHandler>(this, &QLowEnergyControllerPrivateWinRT::onValueChange).Get(),
+                    &token);
+        WARN_AND_CONTINUE_IF_FAILED(hr, "Could not register characteristic for value changes")
+        mValueChangedTokens.append(ValueChangedEntry(characteristic, token));
+        qCDebug(QT_BT_WINDOWS) << "Characteristic" << charUuid << "in service"
+            << serviceUuid << "registered for value changes";
+    }
 }
 
 void QLowEnergyControllerPrivateWinRT::unregisterFromValueChanges()
@@ -861,9 +993,34 @@ HRESULT QLowEnergyControllerPrivateWinRT::onValueChange(IGattCharacteristic *cha
     ComPtr<IBuffer> buffer;
     hr = args->get_CharacteristicValue(&buffer);
     RETURN_IF_FAILED("Could not obtain characteristic's value", return S_OK)
-    emit characteristicChanged(handle, byteArrayFromBuffer(buffer));
+    // the only copy of the value, shared by the service data and the emitted signal
+    const QByteArray value = byteArrayFromBuffer(buffer);
+
+    // the changes received until the controller's thread gets to them are delivered at once
+    QMutexLocker locker(&mChangedValuesMutex);
+    if (mChangedValues.isEmpty()) {
+        QMetaObject::invokeMethod(this, &QLowEnergyControllerPrivateWinRT::deliverCharacteristicChanges,
+                                  Qt::QueuedConnection);
+    }
+    mChangedValues.append(qMakePair(handle, value));
     return S_OK;
 }
+
+void QLowEnergyControllerPrivateWinRT::deliverCharacteristicChanges()
+{
+    QList<QPair<quint16, QByteArray>> changedValues;
+    {
+        QMutexLocker locker(&mChangedValuesMutex);
+        changedValues = std::exchange(mChangedValues, {});
+    }
+    QPointer<QLowEnergyControllerPrivateWinRT> thisPtr(this);
+    for (const auto &change : qAsConst(changedValues)) {
+        // a slot connected to characteristicChanged() may delete the controller
+        if (!thisPtr)
+            return;
+        handleCharacteristicChanged(change.first, change.second);
+    }
+}
 HRESULT QLowEnergyControllerPrivateWinRT::onMtuChange(IGattSession *session, IInspectable *args)
 {
     qCDebug(QT_BT_WINDOWS) << __FUNCTION__;
@@ -1057,6 +1214,8 @@ HRESULT QLowEnergyControllerPrivateWinRT::onServiceDiscoveryFinished(ABI::Window
         hr = deviceService->get_Uuid(&guuid);
         WARN_AND_CONTINUE_IF_FAILED(hr, "Could not obtain service's Uuid");
         const QBluetoothUuid service(guuid);
+        if (!isServiceInDiscoveryFilter(service))
+            continue;
 
         qCDebug(QT_BT_WINDOWS_SERVICE_THREAD) << __FUNCTION__
                                             << "Changing service pointer from thread"
@@ -1099,10 +1258,12 @@ void QLowEnergyControllerPrivateWinRT::clearAllServices()
         closeDeviceService(service);
     }
     m_openedServices.clear();
+    m_nativeCharacteristics.clear();
 }
 
 void QLowEnergyControllerPrivateWinRT::closeAndRemoveService(const QBluetoothUuid &uuid)
 {
+    m_nativeCharacteristics.removeIf([&uuid](const auto &it) { return it.key().first == uuid; });
     auto service = m_openedServices.take(uuid);
     if (service)
         closeDeviceService(service);
@@ -1117,7 +1278,10 @@ void QLowEnergyControllerPrivateWinRT::discoverServices()
     HRESULT hr = mDevice.As(&device3);
     CHECK_FOR_DEVICE_CONNECTION_ERROR(hr, "Could not cast device", return);
     ComPtr<IAsyncOperation<GenericAttributeProfile::GattDeviceServicesResult *>> asyncResult;
-    hr = device3->GetGattServicesAsync(&asyncResult);
+    BluetoothCacheMode cacheMode;
+    hr = cacheModeForPolicy(gattCachePolicy, &cacheMode)
+            ? device3->GetGattServicesWithCacheModeAsync(cacheMode, &asyncResult)
+            : device3->GetGattServicesAsync(&asyncResult);
     CHECK_FOR_DEVICE_CONNECTION_ERROR(hr, "Could not obtain services", return);
     hr = asyncResult->put_Completed(
         Callback<IAsyncOperationCompletedHandler<GenericAttributeProfile::GattDeviceServicesResult *>>(
@@ -1129,6 +1293,8 @@ void QLowEnergyControllerPrivateWinRT::discoverServices()
 void QLowEnergyControllerPrivateWinRT::discoverServiceDetails(
         const QBluetoothUuid &service, QLowEnergyService::DiscoveryMode mode)
 {
+    // the attributes to read are taken from the service
+    Q_UNUSED(mode);
     qCDebug(QT_BT_WINDOWS) << __FUNCTION__ << service;
     if (!serviceList.contains(service)) {
         qCWarning(QT_BT_WINDOWS) << "Discovery done of unknown service:"
@@ -1219,12 +1385,8 @@ void QLowEnergyControllerPrivateWinRT::discoverServiceDetails(
     }
 
     QWinRTLowEnergyServiceHandler *worker =
-            new QWinRTLowEnergyServiceHandler(service, deviceService3, mode);
-    QThread *thread = new QThread;
-    worker->moveToThread(thread);
-    connect(thread, &QThread::started, worker, &QWinRTLowEnergyServiceHandler::obtainCharList);
-    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
-    connect(worker, &QObject::destroyed, thread, &QObject::deleteLater);
+            new QWinRTLowEnergyServiceHandler(service, deviceService3, pointer->discoveryTargets,
+                                              pointer->discoveryFilter, gattCachePolicy);
     connect(worker, &QWinRTLowEnergyServiceHandler::errorOccured,
             this, &QLowEnergyControllerPrivateWinRT::handleServiceHandlerError);
     connect(worker, &QWinRTLowEnergyServiceHandler::charListObtained, this,
@@ -1242,12 +1404,11 @@ void QLowEnergyControllerPrivateWinRT::discoverServiceDetails(
         pointer->endHandle = endHandle;
         pointer->characteristicList = charList;
 
-        for (const QBluetoothUuid &indicateChar : qAsConst(indicateChars))
-            registerForValueChanges(service, indicateChar);
+        registerForValueChanges(service, indicateChars);
 
         pointer->setState(QLowEnergyService::RemoteServiceDiscovered);
     });
-    thread->start();
+    workerThreads()->start(worker, &QWinRTLowEnergyServiceHandler::obtainCharList);
 }
 
 void QLowEnergyControllerPrivateWinRT::startAdvertising(
@@ -1301,6 +1462,7 @@ void QLowEnergyControllerPrivateWinRT::readCharacteristic(
         return;
     }
     ComPtr<IAsyncOperation<GattReadResult*>> readOp;
+    Q_TRACE(QLowEnergyController_requestSent, TraceReadRequest, charHandle, 0);
     HRESULT hr = characteristic->ReadValueWithCacheModeAsync(BluetoothCacheMode_Uncached, &readOp);
     CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not read characteristic",
                                    service, QLowEnergyService::CharacteristicReadError, return)
@@ -1322,6 +1484,8 @@ void QLowEnergyControllerPrivateWinRT::readCharacteristic(
         QLowEnergyServicePrivate::CharData charData = service->characteristicList.value(charHandle);
         charData.value = value;
         service->characteristicList.insert(charHandle, charData);
+        Q_TRACE(QLowEnergyController_responseReceived, TraceReadResponse, charHandle,
+                int(value.size()));
         emit service->characteristicRead(QLowEnergyCharacteristic(service, charHandle), value);
         return S_OK;
     };
@@ -1369,6 +1533,7 @@ void QLowEnergyControllerPrivateWinRT::readDescriptor(
     const QBluetoothUuid descUuid = descData.uuid;
     if (descUuid == QBluetoothUuid(QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration)) {
         ComPtr<IAsyncOperation<ClientCharConfigDescriptorResult *>> readOp;
+        Q_TRACE(QLowEnergyController_requestSent, TraceReadRequest, descHandle, 0);
         HRESULT hr = characteristic->ReadClientCharacteristicConfigurationDescriptorAsync(&readOp);
         CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not read client characteristic configuration",
                                        service, QLowEnergyService::DescriptorReadError, return)
@@ -1412,6 +1577,8 @@ void QLowEnergyControllerPrivateWinRT::readDescriptor(
             descData.value = QByteArray(2, Qt::Uninitialized);
             qToLittleEndian(result, descData.value.data());
             service->characteristicList[charHandle].descriptorList[descHandle] = descData;
+            Q_TRACE(QLowEnergyController_responseReceived, TraceReadResponse, descHandle,
+                    int(descData.value.size()));
             emit service->descriptorRead(QLowEnergyDescriptor(service, charHandle, descHandle),
                 descData.value);
             return S_OK;
@@ -1466,6 +1633,7 @@ void QLowEnergyControllerPrivateWinRT::readDescriptor(
     CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not obtain descritpor from list",
                                    service, QLowEnergyService::DescriptorReadError, return)
     ComPtr<IAsyncOperation<GattReadResult*>> readOp;
+    Q_TRACE(QLowEnergyController_requestSent, TraceReadRequest, descHandle, 0);
     hr = descriptor->ReadValueWithCacheModeAsync(BluetoothCacheMode_Uncached, &readOp);
     CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not read descriptor value",
                                    service, QLowEnergyService::DescriptorReadError, return)
@@ -1492,6 +1660,8 @@ void QLowEnergyControllerPrivateWinRT::readDescriptor(
         else
             descData.value = byteArrayFromGattResult(descriptorValue);
         service->characteristicList[charHandle].descriptorList[descHandle] = descData;
+        Q_TRACE(QLowEnergyController_responseReceived, TraceReadResponse, descHandle,
+                int(descData.value.size()));
         emit service->descriptorRead(QLowEnergyDescriptor(service, charHandle, descHandle),
             descData.value);
         return S_OK;
@@ -1564,6 +1734,9 @@ void QLowEnergyControllerPrivateWinRT::writeCharacteristic(
     ComPtr<IAsyncOperation<GattCommunicationStatus>> writeOp;
     GattWriteOption option = writeWithResponse ? GattWriteOption_WriteWithResponse
                                                : GattWriteOption_WriteWithoutResponse;
+    Q_TRACE(QLowEnergyController_requestSent,
+            writeWithResponse ? TraceWriteRequest : TraceWriteCommand, charHandle,
+            int(newValue.size()));
     hr = characteristic->WriteValueWithOptionAsync(buffer.Get(), option, &writeOp);
     CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could write characteristic",
                                    service, QLowEnergyService::CharacteristicWriteError, return)
@@ -1592,6 +1765,10 @@ void QLowEnergyControllerPrivateWinRT::writeCharacteristic(
             service->setError(QLowEnergyService::CharacteristicWriteError);
             return S_OK;
         }
+        if (writeWithResponse) {
+            Q_TRACE(QLowEnergyController_responseReceived, TraceWriteResponse, charHandle,
+                    int(newValue.size()));
+        }
         // only update cache when property is readable. Otherwise it remains
         // empty.
         if (thisPtr && charData.properties & QLowEnergyCharacteristic::Read)
@@ -1608,6 +1785,111 @@ void QLowEnergyControllerPrivateWinRT::writeCharacteristic(
                                    service, QLowEnergyService::CharacteristicWriteError, return)
 }
 
+void QLowEnergyControllerPrivateWinRT::writeCharacteristicsReliably(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QList<QLowEnergyHandle> &charHandles,
+        const QList<QByteArray> &newValues)
+{
+    qCDebug(QT_BT_WINDOWS) << __FUNCTION__ << service << charHandles << newValues;
+    qCDebug(QT_BT_WINDOWS_SERVICE_THREAD) << __FUNCTION__ << "Changing service pointer from thread"
+                                        << QThread::currentThread();
+    Q_ASSERT(!service.isNull());
+    Q_ASSERT(charHandles.size() == newValues.size());
+
+    ComPtr<IInspectable> inspectable;
+    HRESULT hr = RoActivateInstance(HString::MakeReference(
+            RuntimeClass_Windows_Devices_Bluetooth_GenericAttributeProfile_GattReliableWriteTransaction).Get(),
+            &inspectable);
+    CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not create reliable write transaction",
+                                   service, QLowEnergyService::CharacteristicWriteError, return)
+    ComPtr<IGattReliableWriteTransaction> transaction;
+    hr = inspectable.As(&transaction);
+    CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not cast reliable write transaction",
+                                   service, QLowEnergyService::CharacteristicWriteError, return)
+    ComPtr<IBufferFactory> bufferFactory;
+    hr = GetActivationFactory(HStringReference(RuntimeClass_Windows_Storage_Streams_Buffer).Get(),
+                              &bufferFactory);
+    CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not obtain buffer factory",
+                                   service, QLowEnergyService::CharacteristicWriteError, return)
+
+    for (qsizetype i = 0; i < charHandles.size(); ++i) {
+        const QLowEnergyServicePrivate::CharData charData =
+                service->characteristicList.value(charHandles.at(i));
+        ComPtr<IGattCharacteristic> characteristic = getNativeCharacteristic(service->uuid,
+                                                                             charData.uuid);
+        if (!characteristic) {
+            qCDebug(QT_BT_WINDOWS) << "Could not obtain native characteristic" << charData.uuid
+                                 << "from service" << service->uuid;
+            service->setError(QLowEnergyService::CharacteristicWriteError);
+            return;
+        }
+
+        const QByteArray &newValue = newValues.at(i);
+        ComPtr<IBuffer> buffer;
+        const quint32 length = quint32(newValue.length());
+        hr = bufferFactory->Create(length, &buffer);
+        CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not create buffer",
+                                       service, QLowEnergyService::CharacteristicWriteError, return)
+        hr = buffer->put_Length(length);
+        CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not set buffer length",
+                                       service, QLowEnergyService::CharacteristicWriteError, return)
+        ComPtr<Windows::Storage::Streams::IBufferByteAccess> byteAccess;
+        hr = buffer.As(&byteAccess);
+        CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not cast buffer",
+                                       service, QLowEnergyService::CharacteristicWriteError, return)
+        byte *bytes;
+        hr = byteAccess->Buffer(&bytes);
+        CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not set buffer",
+                                       service, QLowEnergyService::CharacteristicWriteError, return)
+        memcpy(bytes, newValue, length);
+        hr = transaction->WriteValue(characteristic.Get(), buffer.Get());
+        CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not add value to reliable write transaction",
+                                       service, QLowEnergyService::CharacteristicWriteError, return)
+    }
+
+    ComPtr<IAsyncOperation<GattCommunicationStatus>> commitOp;
+    hr = transaction->CommitAsync(&commitOp);
+    CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not commit reliable write transaction",
+                                   service, QLowEnergyService::CharacteristicWriteError, return)
+    QPointer<QLowEnergyControllerPrivateWinRT> thisPtr(this);
+    auto commitCompletedLambda = [charHandles, newValues, service, thisPtr]
+            (IAsyncOperation<GattCommunicationStatus> *op, AsyncStatus status)
+    {
+        if (status == AsyncStatus::Canceled || status == AsyncStatus::Error) {
+            qCDebug(QT_BT_WINDOWS) << "Reliable write transaction failed";
+            service->setError(QLowEnergyService::CharacteristicWriteError);
+            return S_OK;
+        }
+        GattCommunicationStatus result;
+        HRESULT hr = op->GetResults(&result);
+        CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not obtain reliable write result",
+                                       service, QLowEnergyService::CharacteristicWriteError, return S_OK)
+        if (result != GattCommunicationStatus_Success) {
+            qCDebug(QT_BT_WINDOWS) << "Reliable write transaction failed";
+            service->setError(QLowEnergyService::CharacteristicWriteError);
+            return S_OK;
+        }
+        for (qsizetype i = 0; i < charHandles.size(); ++i) {
+            const QLowEnergyHandle charHandle = charHandles.at(i);
+            const QByteArray &newValue = newValues.at(i);
+            // only update cache when property is readable. Otherwise it remains
+            // empty.
+            if (thisPtr && service->characteristicList.value(charHandle).properties
+                    & QLowEnergyCharacteristic::Read) {
+                thisPtr->updateValueOfCharacteristic(charHandle, newValue, false);
+            }
+            emit service->characteristicWritten(QLowEnergyCharacteristic(service, charHandle),
+                                                newValue);
+        }
+        return S_OK;
+    };
+    hr = commitOp->put_Completed(
+                Callback<IAsyncOperationCompletedHandler<GattCommunicationStatus>>(
+                    commitCompletedLambda).Get());
+    CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not register reliable write callback",
+                                   service, QLowEnergyService::CharacteristicWriteError, return)
+}
+
 void QLowEnergyControllerPrivateWinRT::writeDescriptor(
         const QSharedPointer<QLowEnergyServicePrivate> service,
         const QLowEnergyHandle charHandle,
@@ -1668,6 +1950,8 @@ void QLowEnergyControllerPrivateWinRT::writeDescriptor(
             return;
         }
         ComPtr<IAsyncOperation<enum GattCommunicationStatus>> writeOp;
+        Q_TRACE(QLowEnergyController_requestSent, TraceWriteRequest, descHandle,
+                int(newValue.size()));
         HRESULT hr = characteristic->WriteClientCharacteristicConfigurationDescriptorAsync(value, &writeOp);
         CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not write client characteristic configuration",
                                        service, QLowEnergyService::DescriptorWriteError, return)
@@ -1692,6 +1976,8 @@ void QLowEnergyControllerPrivateWinRT::writeDescriptor(
             }
             if (thisPtr)
                 thisPtr->updateValueOfDescriptor(charHandle, descHandle, newValue, false);
+            Q_TRACE(QLowEnergyController_responseReceived, TraceWriteResponse, descHandle,
+                    int(newValue.size()));
             emit service->descriptorWritten(QLowEnergyDescriptor(service, charHandle, descHandle),
                                             newValue);
             return S_OK;
@@ -1765,6 +2051,8 @@ void QLowEnergyControllerPrivateWinRT::writeDescriptor(
                                    service, QLowEnergyService::DescriptorWriteError, return)
     memcpy(bytes, newValue, length);
     ComPtr<IAsyncOperation<GattCommunicationStatus>> writeOp;
+    Q_TRACE(QLowEnergyController_requestSent, TraceWriteRequest, descHandle,
+            int(newValue.size()));
     hr = descriptor->WriteValueAsync(buffer.Get(), &writeOp);
     CHECK_HR_AND_SET_SERVICE_ERROR(hr, "Could not write descriptor value",
                                    service, QLowEnergyService::DescriptorWriteError, return)
@@ -1789,6 +2077,8 @@ void QLowEnergyControllerPrivateWinRT::writeDescriptor(
         }
         if (thisPtr)
             thisPtr->updateValueOfDescriptor(charHandle, descHandle, newValue, false);
+        Q_TRACE(QLowEnergyController_responseReceived, TraceWriteResponse, descHandle,
+                int(newValue.size()));
         emit service->descriptorWritten(QLowEnergyDescriptor(service, charHandle, descHandle),
                                         newValue);
         return S_OK;
@@ -1824,6 +2114,9 @@ int QLowEnergyControllerPrivateWinRT::mtu() const
 void QLowEnergyControllerPrivateWinRT::handleCharacteristicChanged(
         quint16 charHandle, const QByteArray &data)
 {
+    Q_TRACE(QLowEnergyController_notificationReceived, TraceNotification, charHandle,
+            int(data.size()));
+    requestStatistics.recordNotification();
     qCDebug(QT_BT_WINDOWS) << __FUNCTION__ << charHandle << data;
     qCDebug(QT_BT_WINDOWS_SERVICE_THREAD) << __FUNCTION__ << "Changing service pointer from thread"
                                         << QThread::currentThread();
@@ -1843,10 +2136,8 @@ void QLowEnergyControllerPrivateWinRT::handleCharacteristicChanged(
 
     // only update cache when property is readable. Otherwise it remains
     // empty.
-    if (characteristic.properties() & QLowEnergyCharacteristic::Read)
-        updateValueOfCharacteristic(characteristic.attributeHandle(),
-                                data, false);
-    emit service->characteristicChanged(characteristic, data);
+    updateValueOfChangedCharacteristic(characteristic, data);
+    service->notifyCharacteristicChanged(characteristic, data);
 }
 
 void QLowEnergyControllerPrivateWinRT::handleServiceHandlerError(const QString &error)
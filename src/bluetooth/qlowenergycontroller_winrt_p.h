@@ -16,7 +16,10 @@
 //
 
 #include <qglobal.h>
+#include <QtCore/QHash>
 #include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QPair>
 #include <QtCore/QQueue>
 #include <QtBluetooth/qbluetooth.h>
 #include <QtBluetooth/qlowenergycharacteristic.h>
@@ -88,6 +91,9 @@ public:
                          const QLowEnergyHandle charHandle,
                          const QLowEnergyHandle descriptorHandle,
                          const QByteArray &newValue) override;
+    void writeCharacteristicsReliably(const QSharedPointer<QLowEnergyServicePrivate> service,
+                                      const QList<QLowEnergyHandle> &charHandles,
+                                      const QList<QByteArray> &newValues) override;
 
     void addToGenericAttributeList(const QLowEnergyServiceData &service,
                                    QLowEnergyHandle startHandle) override;
@@ -95,11 +101,11 @@ public:
     int mtu() const override;
 
 signals:
-    void characteristicChanged(quint16 charHandle, const QByteArray &data);
     void abortConnection();
 
 private slots:
     void handleCharacteristicChanged(quint16 charHandle, const QByteArray &data);
+    void deliverCharacteristicChanges();
     void handleServiceHandlerError(const QString &error);
 
 private:
@@ -124,11 +130,19 @@ private:
     };
     QList<ValueChangedEntry> mValueChangedTokens;
     QMap<QBluetoothUuid, Microsoft::WRL::ComPtr<ABI::Windows::Devices::Bluetooth::GenericAttributeProfile::IGattDeviceService>> m_openedServices;
+    // native characteristics by service and characteristic uuid, saves an await per request
+    QHash<QPair<QBluetoothUuid, QBluetoothUuid>,
+          Microsoft::WRL::ComPtr<ABI::Windows::Devices::Bluetooth::GenericAttributeProfile::IGattCharacteristic>>
+            m_nativeCharacteristics;
+    // value changes received on the WinRT threads, delivered by deliverCharacteristicChanges()
+    QMutex mChangedValuesMutex;
+    QList<QPair<quint16, QByteArray>> mChangedValues;
 
     Microsoft::WRL::ComPtr<ABI::Windows::Devices::Bluetooth::GenericAttributeProfile::IGattDeviceService> getNativeService(const QBluetoothUuid &serviceUuid);
     Microsoft::WRL::ComPtr<ABI::Windows::Devices::Bluetooth::GenericAttributeProfile::IGattCharacteristic> getNativeCharacteristic(const QBluetoothUuid &serviceUuid, const QBluetoothUuid &charUuid);
 
-    void registerForValueChanges(const QBluetoothUuid &serviceUuid, const QBluetoothUuid &charUuid);
+    void registerForValueChanges(const QBluetoothUuid &serviceUuid,
+                                 const QList<QBluetoothUuid> &charUuids);
     void unregisterFromValueChanges();
     HRESULT onValueChange(ABI::Windows::Devices::Bluetooth::GenericAttributeProfile::IGattCharacteristic *characteristic,
                           ABI::Windows::Devices::Bluetooth::GenericAttributeProfile::IGattValueChangedEventArgs *args);
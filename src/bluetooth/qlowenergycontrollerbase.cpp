@@ -2,17 +2,28 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include "qlowenergycontrollerbase_p.h"
+#include "qbluetoothmemoryusage_p.h"
 
+#include <QtCore/QEvent>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QTimer>
 
 #include <QtBluetooth/QBluetoothLocalDevice>
 #include <QtBluetooth/QLowEnergyCharacteristicData>
 #include <QtBluetooth/QLowEnergyDescriptorData>
 #include <QtBluetooth/QLowEnergyServiceData>
+#include <QtBluetooth/qlowenergystaticservicedata.h>
+
+#include <algorithm>
 
 QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_BT)
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_MEMORY)
+
+// operations within one idle interval that switch to the high throughput preset
+static constexpr qsizetype gattBurstThreshold = 4;
+static constexpr int gattIdleInterval = 2000;
 
 QLowEnergyControllerPrivate::QLowEnergyControllerPrivate()
     : QObject()
@@ -23,6 +34,22 @@ QLowEnergyControllerPrivate::~QLowEnergyControllerPrivate()
 {
 }
 
+/*
+ * The private is a child of the controller and follows it to other threads,
+ * the objects it created itself are its children. Service privates are shared
+ * with the QLowEnergyService objects and stay in the thread that created them.
+ */
+bool QLowEnergyControllerPrivate::event(QEvent *event)
+{
+    if (event->type() == QEvent::ThreadChange
+            && (state != QLowEnergyController::UnconnectedState
+                || !serviceList.isEmpty() || !localServices.isEmpty())) {
+        qCWarning(QT_BT) << "Moving a QLowEnergyController to another thread is only supported"
+                            " while it is unconnected and has no services";
+    }
+    return QObject::event(event);
+}
+
 bool QLowEnergyControllerPrivate::isValidLocalAdapter()
 {
 #if defined(QT_WINRT_BLUETOOTH) || defined(Q_OS_DARWIN)
@@ -44,6 +71,12 @@ bool QLowEnergyControllerPrivate::isValidLocalAdapter()
     return adapterFound;
 }
 
+bool QLowEnergyControllerPrivate::setLocalAdapter(const QBluetoothAddress &adapter)
+{
+    // most backends bind to their adapter once created
+    return adapter == localAdapter;
+}
+
 
 void QLowEnergyControllerPrivate::setError(
         QLowEnergyController::Error newError)
@@ -100,22 +133,142 @@ void QLowEnergyControllerPrivate::setState(
             && role == QLowEnergyController::PeripheralRole) {
         remoteDevice.clear();
     }
+    if (state == QLowEnergyController::UnconnectedState) {
+        recentGattRequests = 0;
+        highThroughputRequested = false;
+        if (gattIdleTimer)
+            gattIdleTimer->stop();
+    }
+    if (state == QLowEnergyController::DiscoveredState
+            || state == QLowEnergyController::UnconnectedState) {
+        qCDebug(QT_BT_MEMORY) << q << state << q->memoryUsage();
+    }
     emit q->stateChanged(state);
 }
 
+void QLowEnergyControllerPrivate::setConnectionPresetSwitching(bool enabled)
+{
+    if (connectionPresetSwitching == enabled)
+        return;
+
+    connectionPresetSwitching = enabled;
+    if (!enabled) {
+        recentGattRequests = 0;
+        highThroughputRequested = false;
+        if (gattIdleTimer)
+            gattIdleTimer->stop();
+    }
+}
+
+void QLowEnergyControllerPrivate::noteGattRequests(qsizetype count)
+{
+    if (!connectionPresetSwitching || role != QLowEnergyController::CentralRole)
+        return;
+    if (state != QLowEnergyController::ConnectedState
+            && state != QLowEnergyController::DiscoveringState
+            && state != QLowEnergyController::DiscoveredState) {
+        return;
+    }
+
+    if (!gattIdleTimer) {
+        gattIdleTimer = new QTimer(this);
+        gattIdleTimer->setSingleShot(true);
+        gattIdleTimer->setInterval(gattIdleInterval);
+        connect(gattIdleTimer, &QTimer::timeout,
+                this, &QLowEnergyControllerPrivate::applyIdleConnectionPreset);
+    }
+    gattIdleTimer->start();
+
+    recentGattRequests += count;
+    if (!highThroughputRequested && recentGattRequests >= gattBurstThreshold) {
+        qCDebug(QT_BT) << "GATT request burst, switching to the high throughput preset";
+        highThroughputRequested = true;
+        requestConnectionUpdate(QLowEnergyController::connectionParameters(
+                QLowEnergyController::ConnectionPreset::HighThroughput));
+    }
+}
+
+void QLowEnergyControllerPrivate::applyIdleConnectionPreset()
+{
+    recentGattRequests = 0;
+    if (!highThroughputRequested)
+        return;
+
+    qCDebug(QT_BT) << "GATT requests idle, switching to the low power preset";
+    highThroughputRequested = false;
+    requestConnectionUpdate(QLowEnergyController::connectionParameters(
+            QLowEnergyController::ConnectionPreset::LowPower));
+}
+
+void QLowEnergyControllerPrivate::rebuildServiceHandleIndex(const ServiceDataMap &services)
+{
+    serviceHandleIndex.clear();
+    serviceHandleIndex.reserve(services.size());
+    for (const auto &service : services)
+        serviceHandleIndex.append({ service->startHandle, service->endHandle, service });
+    std::sort(serviceHandleIndex.begin(), serviceHandleIndex.end(),
+              [](const ServiceHandleRange &a, const ServiceHandleRange &b) {
+                  return a.startHandle < b.startHandle;
+              });
+    indexedServiceList = &services;
+}
+
 QSharedPointer<QLowEnergyServicePrivate> QLowEnergyControllerPrivate::serviceForHandle(
         QLowEnergyHandle handle)
 {
-    ServiceDataMap &currentList = serviceList;
-    if (role == QLowEnergyController::PeripheralRole)
-        currentList = localServices;
+    const QSharedPointer<QLowEnergyServicePrivate> *service = findService(handle);
+    return service ? *service : QSharedPointer<QLowEnergyServicePrivate>();
+}
+
+/*
+    Like serviceForHandle() but returns a pointer to the stored service
+    pointer, so that the hot paths of the GATT operations do not touch the
+    reference count. The pointer is valid until the service lists change.
+ */
+const QSharedPointer<QLowEnergyServicePrivate> *QLowEnergyControllerPrivate::findService(
+        QLowEnergyHandle handle)
+{
+    const ServiceDataMap &currentList = (role == QLowEnergyController::PeripheralRole)
+            ? localServices : serviceList;
+
+    // The handles of a service may be assigned after it was added to the list.
+    // Therefore each hit is validated against the current service data.
+    if (indexedServiceList != &currentList || serviceHandleIndex.size() != currentList.size())
+        rebuildServiceHandleIndex(currentList);
+
+    auto it = std::upper_bound(serviceHandleIndex.cbegin(), serviceHandleIndex.cend(), handle,
+                               [](QLowEnergyHandle h, const ServiceHandleRange &range) {
+                                   return h < range.startHandle;
+                               });
+    if (it != serviceHandleIndex.cbegin()) {
+        const ServiceHandleRange &range = *(--it);
+        if (range.startHandle == range.service->startHandle
+                && range.endHandle == range.service->endHandle
+                && handle <= range.endHandle) {
+            const auto current = currentList.constFind(range.service->uuid);
+            if (current != currentList.cend() && *current == range.service)
+                return &range.service;
+        }
+    }
 
-    const QList<QSharedPointer<QLowEnergyServicePrivate>> values = currentList.values();
-    for (auto service: values)
-        if (service->startHandle <= handle && handle <= service->endHandle)
-            return service;
+    // unknown handle or outdated index
+    for (const auto &service : currentList) {
+        if (service->startHandle <= handle && handle <= service->endHandle) {
+            rebuildServiceHandleIndex(currentList);
+            return &service;
+        }
+    }
 
-    return QSharedPointer<QLowEnergyServicePrivate>();
+    return nullptr;
+}
+
+/*!
+    Returns \c true if the service \a uuid was requested by the current
+    service discovery.
+ */
+bool QLowEnergyControllerPrivate::isServiceInDiscoveryFilter(const QBluetoothUuid &uuid) const
+{
+    return serviceDiscoveryFilter.isEmpty() || serviceDiscoveryFilter.contains(uuid);
 }
 
 /*!
@@ -125,9 +278,10 @@ QSharedPointer<QLowEnergyServicePrivate> QLowEnergyControllerPrivate::serviceFor
 QLowEnergyCharacteristic QLowEnergyControllerPrivate::characteristicForHandle(
         QLowEnergyHandle handle)
 {
-    QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(handle);
-    if (service.isNull())
+    const QSharedPointer<QLowEnergyServicePrivate> *found = findService(handle);
+    if (!found)
         return QLowEnergyCharacteristic();
+    const QSharedPointer<QLowEnergyServicePrivate> &service = *found;
 
     if (service->characteristicList.isEmpty())
         return QLowEnergyCharacteristic();
@@ -136,16 +290,23 @@ QLowEnergyCharacteristic QLowEnergyControllerPrivate::characteristicForHandle(
     if (service->characteristicList.contains(handle))
         return QLowEnergyCharacteristic(service, handle);
 
-    // check whether it is the handle of the characteristic value or its descriptors
-    QList<QLowEnergyHandle> charHandles = service->characteristicList.keys();
-    std::sort(charHandles.begin(), charHandles.end());
-    for (qsizetype i = charHandles.size() - 1; i >= 0; --i) {
-        if (charHandles.at(i) > handle)
-            continue;
+    // the value attribute usually follows the characteristic header
+    const auto charIt = service->characteristicList.constFind(handle - 1);
+    if (charIt != service->characteristicList.constEnd() && charIt->valueHandle == handle)
+        return QLowEnergyCharacteristic(service, charIt.key());
 
-        return QLowEnergyCharacteristic(service, charHandles.at(i));
+    // check whether it is the handle of the characteristic value or its descriptors
+    // -> closest characteristic header before the handle
+    QLowEnergyHandle closestHandle = 0;
+    for (auto it = service->characteristicList.keyBegin();
+         it != service->characteristicList.keyEnd(); ++it) {
+        if (*it <= handle && *it > closestHandle)
+            closestHandle = *it;
     }
 
+    if (closestHandle)
+        return QLowEnergyCharacteristic(service, closestHandle);
+
     return QLowEnergyCharacteristic();
 }
 
@@ -176,10 +337,9 @@ QLowEnergyDescriptor QLowEnergyControllerPrivate::descriptorForHandle(
 quint16 QLowEnergyControllerPrivate::updateValueOfCharacteristic(
         QLowEnergyHandle charHandle,const QByteArray &value, bool appendValue)
 {
-    QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
-    if (!service.isNull()) {
-        CharacteristicDataMap::iterator charIt = service->characteristicList.find(charHandle);
-        if (charIt != service->characteristicList.end()) {
+    if (const auto service = findService(charHandle)) {
+        CharacteristicDataMap::iterator charIt = (*service)->characteristicList.find(charHandle);
+        if (charIt != (*service)->characteristicList.end()) {
             QLowEnergyServicePrivate::CharData &charDetails = charIt.value();
 
             if (appendValue)
@@ -194,6 +354,30 @@ quint16 QLowEnergyControllerPrivate::updateValueOfCharacteristic(
     return 0;
 }
 
+/*!
+    Stores a \a value received via notification or indication of \a characteristic.
+
+    Only readable characteristics keep their value. If the service disabled
+    the caching of notified values, the stored value is dropped instead.
+ */
+void QLowEnergyControllerPrivate::updateValueOfChangedCharacteristic(
+        const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
+{
+    if (!characteristic.d_ptr)
+        return;
+
+    // the characteristic knows its service already, no need to resolve the handle again
+    const auto charIt = characteristic.d_ptr->characteristicList.find(
+                characteristic.attributeHandle());
+    if (charIt == characteristic.d_ptr->characteristicList.end())
+        return;
+
+    if (!characteristic.d_ptr->notifiedValueCaching)
+        charIt->value.clear();
+    else if (charIt->properties & QLowEnergyCharacteristic::Read)
+        charIt->value = value;
+}
+
 /*!
     Returns the length of the updated descriptor value.
  */
@@ -201,10 +385,9 @@ quint16 QLowEnergyControllerPrivate::updateValueOfDescriptor(
         QLowEnergyHandle charHandle, QLowEnergyHandle descriptorHandle,
         const QByteArray &value, bool appendValue)
 {
-    QSharedPointer<QLowEnergyServicePrivate> service = serviceForHandle(charHandle);
-    if (!service.isNull()) {
-        CharacteristicDataMap::iterator charIt = service->characteristicList.find(charHandle);
-        if (charIt != service->characteristicList.end()) {
+    if (const auto service = findService(charHandle)) {
+        CharacteristicDataMap::iterator charIt = (*service)->characteristicList.find(charHandle);
+        if (charIt != (*service)->characteristicList.end()) {
             QLowEnergyServicePrivate::CharData &charDetails = charIt.value();
 
             DescriptorDataMap::iterator descIt = charDetails.descriptorList.find(descriptorHandle);
@@ -234,9 +417,127 @@ void QLowEnergyControllerPrivate::invalidateServices()
 
     serviceList.clear();
     localServices.clear();
+    serviceHandleIndex.clear();
+    indexedServiceList = nullptr;
     lastLocalHandle = {};
 }
 
+void QLowEnergyControllerPrivate::readCharacteristics(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QList<QLowEnergyHandle> &charHandles)
+{
+    for (const QLowEnergyHandle charHandle : charHandles)
+        readCharacteristic(service, charHandle);
+}
+
+void QLowEnergyControllerPrivate::writeCharacteristics(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QList<QLowEnergyHandle> &charHandles, const QList<QByteArray> &newValues,
+        QLowEnergyService::WriteMode writeMode)
+{
+    Q_ASSERT(charHandles.size() == newValues.size());
+    for (qsizetype i = 0; i < charHandles.size(); ++i)
+        writeCharacteristic(service, charHandles.at(i), newValues.at(i), writeMode);
+}
+
+void QLowEnergyControllerPrivate::writeCharacteristicsReliably(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QList<QLowEnergyHandle> &charHandles, const QList<QByteArray> &newValues)
+{
+    Q_UNUSED(charHandles);
+    Q_UNUSED(newValues);
+    qCWarning(QT_BT) << "Reliable writes are not supported on this platform";
+    service->setError(QLowEnergyService::CharacteristicWriteError);
+}
+
+bool QLowEnergyControllerPrivate::cancelRequests(QLowEnergyServicePrivate *service)
+{
+    Q_UNUSED(service);
+    return false;
+}
+
+void QLowEnergyControllerPrivate::publishCharacteristicValue(
+        const QSharedPointer<QLowEnergyServicePrivate> service,
+        const QLowEnergyHandle charHandle, QByteArrayView value)
+{
+    writeCharacteristic(service, charHandle, value.toByteArray(),
+                        QLowEnergyService::WriteWithResponse);
+}
+
+void QLowEnergyControllerPrivate::startAdvertisingSets(
+        const QList<QLowEnergyAdvertisingParameters> &params,
+        const QList<QLowEnergyAdvertisingData> &advertisingData,
+        const QList<QLowEnergyAdvertisingData> &scanResponseData)
+{
+    if (params.size() == 1) {
+        startAdvertising(params.constFirst(), advertisingData.constFirst(),
+                         scanResponseData.constFirst());
+        return;
+    }
+
+    qCWarning(QT_BT) << "Multiple advertising sets are not supported on this platform";
+    setError(QLowEnergyController::AdvertisingError);
+}
+
+void QLowEnergyControllerPrivate::setPeriodicAdvertisingData(
+        int advertisingSet, const QLowEnergyAdvertisingData &data)
+{
+    Q_UNUSED(advertisingSet);
+    Q_UNUSED(data);
+    qCWarning(QT_BT) << "Periodic advertising is not supported on this platform";
+}
+
+void QLowEnergyControllerPrivate::updateAdvertisingData(
+        int advertisingSet, const QLowEnergyAdvertisingData &advertisingData,
+        const QLowEnergyAdvertisingData &scanResponseData)
+{
+    Q_UNUSED(advertisingSet);
+    Q_UNUSED(advertisingData);
+    Q_UNUSED(scanResponseData);
+    qCWarning(QT_BT) << "Updating the advertising data is not supported on this platform, "
+                        "restart advertising instead";
+}
+
+void QLowEnergyControllerPrivate::requestPhy(QLowEnergyController::Phy txPhy,
+                                             QLowEnergyController::Phy rxPhy)
+{
+    Q_UNUSED(txPhy);
+    Q_UNUSED(rxPhy);
+    qCWarning(QT_BT) << "PHY update requests are not supported on this platform";
+}
+
+void QLowEnergyControllerPrivate::requestDataLength(int txOctets)
+{
+    Q_UNUSED(txOctets);
+    qCWarning(QT_BT) << "Data length requests are not supported on this platform";
+}
+
+QLowEnergyLinkStatistics QLowEnergyControllerPrivate::linkStatistics() const
+{
+    return QLowEnergyLinkStatistics();
+}
+
+void QLowEnergyControllerPrivate::addMemoryUsage(QBluetoothMemoryUsage *usage) const
+{
+    using namespace QBluetoothMemory;
+
+    const auto serviceBytes = [](const QSharedPointer<QLowEnergyServicePrivate> &service) {
+        return service ? service->memoryUsage() : 0;
+    };
+    QBluetoothMemoryUsagePrivate::add(usage, QStringLiteral("serviceList"),
+                                      bytes(serviceList, serviceBytes));
+    QBluetoothMemoryUsagePrivate::add(usage, QStringLiteral("localServices"),
+                                      bytes(localServices, serviceBytes));
+    QBluetoothMemoryUsagePrivate::add(usage, QStringLiteral("serviceHandleIndex"),
+                                      bytes(serviceHandleIndex));
+}
+
+QLowEnergyService *QLowEnergyControllerPrivate::addStaticServiceHelper(
+                            const QLowEnergyStaticServiceData &service)
+{
+    return addServiceHelper(service.toServiceData());
+}
+
 QLowEnergyService *QLowEnergyControllerPrivate::addServiceHelper(
                             const QLowEnergyServiceData &service)
 {
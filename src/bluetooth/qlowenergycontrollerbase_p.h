@@ -20,6 +20,7 @@
 
 #include <QtBluetooth/qlowenergycontroller.h>
 
+#include "qlowenergyrequeststatistics_p.h"
 #include "qlowenergyserviceprivate_p.h"
 
 QT_BEGIN_NAMESPACE
@@ -38,6 +39,19 @@ public:
     QLowEnergyControllerPrivate();
     virtual ~QLowEnergyControllerPrivate();
 
+    // The opcode argument of the request lifecycle tracepoints. The BlueZ
+    // ATT stack passes the opcodes of its PDUs, the other backends pass the
+    // opcode of the ATT request the platform call corresponds to.
+    enum TraceOpcode {
+        TraceReadRequest = 0x0A,
+        TraceReadResponse = 0x0B,
+        TraceWriteRequest = 0x12,
+        TraceWriteResponse = 0x13,
+        TraceNotification = 0x1b,
+        TraceReadMultipleVariableRequest = 0x20,
+        TraceWriteCommand = 0x52
+    };
+
     // interface definition
     virtual void init() = 0;
     virtual void connectToDevice() = 0;
@@ -66,14 +80,55 @@ public:
                         const QLowEnergyHandle descriptorHandle,
                         const QByteArray &newValue) = 0;
 
+    // QLowEnergyService::readCharacteristics() and writeCharacteristics(),
+    // by default each characteristic is handled as a separate operation.
+    virtual void readCharacteristics(
+                        const QSharedPointer<QLowEnergyServicePrivate> service,
+                        const QList<QLowEnergyHandle> &charHandles);
+    virtual void writeCharacteristics(
+                        const QSharedPointer<QLowEnergyServicePrivate> service,
+                        const QList<QLowEnergyHandle> &charHandles,
+                        const QList<QByteArray> &newValues,
+                        QLowEnergyService::WriteMode writeMode);
+    // QLowEnergyService::writeCharacteristicsReliably(), unsupported by default
+    virtual void writeCharacteristicsReliably(
+                        const QSharedPointer<QLowEnergyServicePrivate> service,
+                        const QList<QLowEnergyHandle> &charHandles,
+                        const QList<QByteArray> &newValues);
+    // drops the queued discovery and read requests of service, false if the backend cannot
+    virtual bool cancelRequests(QLowEnergyServicePrivate *service);
+    // QLowEnergyService::publishCharacteristicValue(), peripheral role only,
+    // by default the same as writeCharacteristic()
+    virtual void publishCharacteristicValue(
+                        const QSharedPointer<QLowEnergyServicePrivate> service,
+                        const QLowEnergyHandle charHandle,
+                        QByteArrayView value);
+
     virtual void startAdvertising(
                         const QLowEnergyAdvertisingParameters &params,
                         const QLowEnergyAdvertisingData &advertisingData,
                         const QLowEnergyAdvertisingData &scanResponseData) = 0;
+    // multiple advertising sets, by default only a single set is supported
+    virtual void startAdvertisingSets(
+                        const QList<QLowEnergyAdvertisingParameters> &params,
+                        const QList<QLowEnergyAdvertisingData> &advertisingData,
+                        const QList<QLowEnergyAdvertisingData> &scanResponseData);
     virtual void stopAdvertising() = 0;
+    // by default periodic advertising is not supported
+    virtual void setPeriodicAdvertisingData(int advertisingSet,
+                                            const QLowEnergyAdvertisingData &data);
+    virtual void updateAdvertisingData(int advertisingSet,
+                                       const QLowEnergyAdvertisingData &advertisingData,
+                                       const QLowEnergyAdvertisingData &scanResponseData);
 
     virtual void requestConnectionUpdate(
                         const QLowEnergyConnectionParameters & params) = 0;
+    virtual void requestPhy(QLowEnergyController::Phy txPhy,
+                            QLowEnergyController::Phy rxPhy);
+    virtual void requestDataLength(int txOctets);
+    virtual QLowEnergyLinkStatistics linkStatistics() const;
+    // backends with structures of their own add them after calling the base
+    virtual void addMemoryUsage(QBluetoothMemoryUsage *usage) const;
     virtual void addToGenericAttributeList(
                         const QLowEnergyServiceData &service,
                         QLowEnergyHandle startHandle) = 0;
@@ -82,15 +137,39 @@ public:
 
     virtual QLowEnergyService *addServiceHelper(
                         const QLowEnergyServiceData &service);
+    // by default converted to a QLowEnergyServiceData for addServiceHelper()
+    virtual QLowEnergyService *addStaticServiceHelper(
+                        const QLowEnergyStaticServiceData &service);
 
     // common backend methods
-    bool isValidLocalAdapter();
+    virtual bool isValidLocalAdapter();
+    // moves an unconnected central to another adapter, false if the backend cannot
+    virtual bool setLocalAdapter(const QBluetoothAddress &adapter);
     void setError(QLowEnergyController::Error newError);
     void setState(QLowEnergyController::ControllerState newState);
+    // GATT operations issued by QLowEnergyService, drive the automatic presets
+    void noteGattRequests(qsizetype count);
+    void setConnectionPresetSwitching(bool enabled);
 
     // public variables
     QLowEnergyController::Role role;
     QLowEnergyController::RemoteAddressType addressType;
+    int preferredMtu = -1; // -1 means the platform's choice
+    QLowEnergyController::GattCachePolicy gattCachePolicy =
+            QLowEnergyController::GattCachePolicy::PlatformDefault;
+    // primary services requested by the current discovery, empty means all
+    QList<QBluetoothUuid> serviceDiscoveryFilter;
+    bool connectionPresetSwitching = false;
+    // taken by the next connectToDevice(), see setAutoConnectEnabled()
+    bool autoConnect = false;
+    // enabled via QLowEnergyController::setRequestStatisticsEnabled()
+    QLowEnergyRequestRecorder requestStatistics;
+    // fed by the backends which time out requests themselves
+    QLowEnergyRequestTimeoutEstimator requestTimeouts;
+    // kernel receive time of the last ATT PDU, see lastReceiveTimestamp()
+    std::chrono::system_clock::time_point receiveTimestamp;
+    // taken by the next connection, see setLowLatencyNotificationHandler()
+    QLowEnergyController::LowLatencyNotificationHandler lowLatencyNotificationHandler;
 
     // list of all found service uuids on remote device
     ServiceDataMap serviceList;
@@ -98,6 +177,7 @@ public:
     ServiceDataMap localServices;
 
     //common helper functions
+    bool isServiceInDiscoveryFilter(const QBluetoothUuid &uuid) const;
     QSharedPointer<QLowEnergyServicePrivate> serviceForHandle(QLowEnergyHandle handle);
     QLowEnergyCharacteristic characteristicForHandle(QLowEnergyHandle handle);
     QLowEnergyDescriptor descriptorForHandle(QLowEnergyHandle handle);
@@ -108,9 +188,13 @@ public:
                                  QLowEnergyHandle descriptorHandle,
                                  const QByteArray &value,
                                  bool appendValue);
+    void updateValueOfChangedCharacteristic(const QLowEnergyCharacteristic &characteristic,
+                                            const QByteArray &value);
     void invalidateServices();
 
 protected:
+    bool event(QEvent *event) override;
+
     QLowEnergyController::ControllerState state = QLowEnergyController::UnconnectedState;
     QLowEnergyController::Error error = QLowEnergyController::NoError;
     QString errorString;
@@ -125,6 +209,24 @@ protected:
 
     Q_DECLARE_PUBLIC(QLowEnergyController)
     QLowEnergyController *q_ptr;
+
+private:
+    struct ServiceHandleRange {
+        QLowEnergyHandle startHandle;
+        QLowEnergyHandle endHandle;
+        QSharedPointer<QLowEnergyServicePrivate> service;
+    };
+    // sorted by start handle, rebuilt on demand by serviceForHandle()
+    QList<ServiceHandleRange> serviceHandleIndex;
+    const ServiceDataMap *indexedServiceList = nullptr;
+    void rebuildServiceHandleIndex(const ServiceDataMap &services);
+    const QSharedPointer<QLowEnergyServicePrivate> *findService(QLowEnergyHandle handle);
+
+    void applyIdleConnectionPreset();
+    // operations since the connection has been idle for the last time
+    qsizetype recentGattRequests = 0;
+    bool highThroughputRequested = false;
+    QTimer *gattIdleTimer = nullptr;
 };
 
 QT_END_NAMESPACE
@@ -54,6 +54,7 @@ private:
     friend class QLowEnergyControllerPrivateBluezDBus;
     friend class QLowEnergyControllerPrivateCommon;
     friend class QLowEnergyControllerPrivateDarwin;
+    friend class QLowEnergyControllerPrivateLoopback;
     friend class QLowEnergyControllerPrivateWinRT;
     QLowEnergyDescriptorPrivate *data = nullptr;
 
@@ -55,12 +55,33 @@ QLowEnergyDescriptorData::QLowEnergyDescriptorData(const QBluetoothUuid &uuid,
     setValue(value);
 }
 
+/*!
+  \overload
+  \since 6.5
+
+  Creates a new object of this class with UUID \a uuid, moving \a value into it.
+ */
+QLowEnergyDescriptorData::QLowEnergyDescriptorData(const QBluetoothUuid &uuid, QByteArray &&value)
+    : d(new QLowEnergyDescriptorDataPrivate)
+{
+    setUuid(uuid);
+    setValue(std::move(value));
+}
+
 /*! Constructs a new object of this class that is a copy of \a other. */
 QLowEnergyDescriptorData::QLowEnergyDescriptorData(const QLowEnergyDescriptorData &other)
     : d(other.d)
 {
 }
 
+/*!
+    \fn QLowEnergyDescriptorData::QLowEnergyDescriptorData(QLowEnergyDescriptorData &&other)
+    \since 6.5
+
+    Move-constructs a new object from \a other. The moved-from object can only
+    be assigned to or destroyed.
+*/
+
 /*! Destroys this object. */
 QLowEnergyDescriptorData::~QLowEnergyDescriptorData()
 {
@@ -73,6 +94,13 @@ QLowEnergyDescriptorData &QLowEnergyDescriptorData::operator=(const QLowEnergyDe
     return *this;
 }
 
+/*!
+    \fn QLowEnergyDescriptorData &QLowEnergyDescriptorData::operator=(QLowEnergyDescriptorData &&other)
+    \since 6.5
+
+    Move-assigns \a other to this object and returns a reference to this object.
+*/
+
 /*! Returns the value of this descriptor. */
 QByteArray QLowEnergyDescriptorData::value() const
 {
@@ -88,6 +116,17 @@ void QLowEnergyDescriptorData::setValue(const QByteArray &value)
     d->value = value;
 }
 
+/*!
+  \overload
+  \since 6.5
+
+  Moves \a value into this descriptor.
+ */
+void QLowEnergyDescriptorData::setValue(QByteArray &&value)
+{
+    d->value = std::move(value);
+}
+
 /*! Returns the UUID of this descriptor. */
 QBluetoothUuid QLowEnergyDescriptorData::uuid() const
 {
@@ -19,10 +19,13 @@ public:
     QLowEnergyDescriptorData();
     QLowEnergyDescriptorData(const QBluetoothUuid &uuid,
                              const QByteArray &value);
+    QLowEnergyDescriptorData(const QBluetoothUuid &uuid, QByteArray &&value);
     QLowEnergyDescriptorData(const QLowEnergyDescriptorData &other);
+    QLowEnergyDescriptorData(QLowEnergyDescriptorData &&other) noexcept = default;
     ~QLowEnergyDescriptorData();
 
     QLowEnergyDescriptorData &operator=(const QLowEnergyDescriptorData &other);
+    QT_MOVE_ASSIGNMENT_OPERATOR_IMPL_VIA_PURE_SWAP(QLowEnergyDescriptorData)
     friend bool operator==(const QLowEnergyDescriptorData &a, const QLowEnergyDescriptorData &b)
     {
         return equals(a, b);
@@ -35,6 +38,7 @@ public:
 
     QByteArray value() const;
     void setValue(const QByteArray &value);
+    void setValue(QByteArray &&value);
 
     QBluetoothUuid uuid() const;
     void setUuid(const QBluetoothUuid &uuid);
@@ -0,0 +1,599 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qlowenergyisochronouschannel_p.h"
+
+#include <QtCore/qloggingcategory.h>
+
+#include <cerrno>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT)
+
+// limits of the LE Set CIG/Create BIG parameters, Bluetooth Core 5.3 Vol 4 Part E 7.8.97/7.8.103
+static constexpr std::chrono::microseconds minimumSduInterval{0xff};
+static constexpr std::chrono::microseconds maximumSduInterval{0xfffff};
+static constexpr int maximumSduLength = 0xfff;
+static constexpr std::chrono::milliseconds minimumTransportLatency{0x5};
+static constexpr std::chrono::milliseconds maximumTransportLatencyLimit{0xfa0};
+
+/*!
+    \since 6.5
+    \class QLowEnergyIsochronousChannel
+    \brief The QLowEnergyIsochronousChannel class transfers periodic data over
+           an LE isochronous channel.
+
+    \inmodule QtBluetooth
+
+    Isochronous channels, introduced with Bluetooth 5.2, carry data which is
+    only useful within a bounded time, such as audio or sensor samples. Every
+    \l {sduInterval()}{SDU interval} the local controller sends at most one
+    service data unit (SDU) of up to \l maximumSduSize() bytes. SDUs which
+    cannot be delivered within the \l maximumTransportLatency() are flushed by
+    the controllers rather than delaying the following ones.
+
+    A channel is either a connected isochronous stream (CIS) to the device of
+    an existing \l QLowEnergyController connection, see \l connectToPeer(), or
+    a broadcast isochronous stream (BIS) which any number of devices can
+    receive, see \l startBroadcast() and \l synchronizeToBroadcast().
+
+    \l writeSdu() hands one SDU to the kernel without blocking and without
+    queueing it in the application, an SDU which arrives late is not worth
+    sending. Received SDUs are kept in a queue of \l receiveQueueLength()
+    SDUs, whose buffers are reused as long as the application releases the
+    SDUs it has read. Each SDU carries the time it was received by the kernel.
+    Should the application not keep up, the oldest SDUs are dropped, see
+    \l droppedSduCount().
+
+    \note Isochronous channels are supported on Linux with BlueZ only. They
+    require a kernel with ISO socket support (Linux 6.0 or later, with the
+    \c iso_socket experimental feature of the Bluetooth management interface
+    enabled) and an adapter supporting the feature. On other platforms, every
+    attempt to open a channel fails with \l UnsupportedPlatformError.
+
+    \sa QLowEnergyController
+*/
+
+/*!
+    \enum QLowEnergyIsochronousChannel::Type
+
+    This enum describes the kind of channel.
+
+    \value ConnectedStream  A connected isochronous stream to the device of a
+                            \l QLowEnergyController.
+    \value BroadcastSource  A broadcast isochronous stream sent by the local
+                            device.
+    \value BroadcastSink    A broadcast isochronous stream received from a
+                            remote broadcaster.
+*/
+
+/*!
+    \enum QLowEnergyIsochronousChannel::State
+
+    This enum describes the state of the channel.
+
+    \value UnconnectedState The channel is closed.
+    \value ConnectingState  The channel is being established.
+    \value ConnectedState   SDUs can be sent and received.
+*/
+
+/*!
+    \enum QLowEnergyIsochronousChannel::Error
+
+    This enum describes the errors which can occur.
+
+    \value NoError                  No error has occurred.
+    \value UnsupportedPlatformError Isochronous channels are not supported by
+                                    the platform, the kernel or the adapter.
+    \value InvalidParametersError   The channel parameters or the arguments
+                                    of the operation are invalid.
+    \value ConnectionError          The channel could not be established.
+    \value AccessError              The process lacks the permission to open
+                                    the channel.
+    \value RemoteHostClosedError    The remote device closed the channel.
+    \value UnknownError             An unknown error has occurred.
+*/
+
+/*!
+    \class QLowEnergyIsochronousChannel::Sdu
+    \inmodule QtBluetooth
+    \since 6.5
+
+    \brief The Sdu struct holds a received service data unit.
+*/
+
+/*!
+    \variable QLowEnergyIsochronousChannel::Sdu::data
+    The payload of the SDU.
+*/
+
+/*!
+    \variable QLowEnergyIsochronousChannel::Sdu::timestamp
+    The time the SDU was received by the kernel, or the time it was read
+    by the application if the kernel did not report one.
+*/
+
+/*!
+    \fn void QLowEnergyIsochronousChannel::connected()
+
+    This signal is emitted once the channel is established.
+*/
+
+/*!
+    \fn void QLowEnergyIsochronousChannel::disconnected()
+
+    This signal is emitted when an established channel was closed, either
+    by \l close() or by the remote device.
+*/
+
+/*!
+    \fn void QLowEnergyIsochronousChannel::stateChanged(QLowEnergyIsochronousChannel::State state)
+
+    This signal is emitted when the state of the channel changes to \a state.
+*/
+
+/*!
+    \fn void QLowEnergyIsochronousChannel::errorOccurred(QLowEnergyIsochronousChannel::Error error)
+
+    This signal is emitted when \a error occurred.
+*/
+
+/*!
+    \fn void QLowEnergyIsochronousChannel::readyRead()
+
+    This signal is emitted once for every batch of SDUs which were received.
+*/
+
+/*!
+    Constructs a closed channel with \a parent.
+*/
+QLowEnergyIsochronousChannel::QLowEnergyIsochronousChannel(QObject *parent)
+    : QObject(parent), d_ptr(new QLowEnergyIsochronousChannelPrivate(this))
+{
+}
+
+/*!
+    Closes and destroys the channel.
+*/
+QLowEnergyIsochronousChannel::~QLowEnergyIsochronousChannel()
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    d->closeChannel();
+    delete d_ptr;
+}
+
+/*!
+    Sets the SDU interval to \a interval, in the range of 255 µs to about
+    1.05 s. The default is 10 ms.
+
+    The parameters of the channel take effect when it is opened.
+*/
+void QLowEnergyIsochronousChannel::setSduInterval(std::chrono::microseconds interval)
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    d->sduInterval = interval;
+}
+
+/*!
+    Returns the SDU interval.
+*/
+std::chrono::microseconds QLowEnergyIsochronousChannel::sduInterval() const
+{
+    Q_D(const QLowEnergyIsochronousChannel);
+    return d->sduInterval;
+}
+
+/*!
+    Sets the maximum size of an SDU to \a size bytes, up to 4095. The default
+    is 40.
+
+    It also determines the size of the receive buffers.
+*/
+void QLowEnergyIsochronousChannel::setMaximumSduSize(int size)
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    d->maximumSduSize = size;
+}
+
+/*!
+    Returns the maximum size of an SDU.
+*/
+int QLowEnergyIsochronousChannel::maximumSduSize() const
+{
+    Q_D(const QLowEnergyIsochronousChannel);
+    return d->maximumSduSize;
+}
+
+/*!
+    Sets the maximum transport latency to \a latency, in the range of 5 ms to
+    4 s. The default is 10 ms.
+*/
+void QLowEnergyIsochronousChannel::setMaximumTransportLatency(std::chrono::milliseconds latency)
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    d->maximumTransportLatency = latency;
+}
+
+/*!
+    Returns the maximum transport latency.
+*/
+std::chrono::milliseconds QLowEnergyIsochronousChannel::maximumTransportLatency() const
+{
+    Q_D(const QLowEnergyIsochronousChannel);
+    return d->maximumTransportLatency;
+}
+
+/*!
+    Sets the number of times every SDU is retransmitted to \a count, up to
+    255. The default is 2.
+
+    The controller may use a different number.
+*/
+void QLowEnergyIsochronousChannel::setRetransmissionCount(int count)
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    d->retransmissionCount = count;
+}
+
+/*!
+    Returns the number of retransmissions.
+*/
+int QLowEnergyIsochronousChannel::retransmissionCount() const
+{
+    Q_D(const QLowEnergyIsochronousChannel);
+    return d->retransmissionCount;
+}
+
+/*!
+    Sets the PHY the channel prefers to \a phy. The default is
+    \l {QLowEnergyController::Phy}{Le2M}.
+*/
+void QLowEnergyIsochronousChannel::setPhy(QLowEnergyController::Phy phy)
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    d->phy = phy;
+}
+
+/*!
+    Returns the preferred PHY.
+*/
+QLowEnergyController::Phy QLowEnergyIsochronousChannel::phy() const
+{
+    Q_D(const QLowEnergyIsochronousChannel);
+    return d->phy;
+}
+
+/*!
+    Sets the number of received SDUs which are kept until they are read to
+    \a count. The default is 8.
+
+    The receive buffers are allocated when the channel is opened.
+*/
+void QLowEnergyIsochronousChannel::setReceiveQueueLength(int count)
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    d->receiveQueueLength = count;
+}
+
+/*!
+    Returns the number of received SDUs which are kept until they are read.
+*/
+int QLowEnergyIsochronousChannel::receiveQueueLength() const
+{
+    Q_D(const QLowEnergyIsochronousChannel);
+    return d->receiveQueueLength;
+}
+
+/*!
+    Opens a connected isochronous stream to the device \a controller is
+    connected to.
+
+    In the \l {QLowEnergyController::CentralRole}{CentralRole} the stream is
+    created by the local device. In the
+    \l {QLowEnergyController::PeripheralRole}{PeripheralRole} the channel
+    waits for the central device to create it.
+
+    The controller must be connected.
+*/
+void QLowEnergyIsochronousChannel::connectToPeer(QLowEnergyController *controller)
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    if (d->state != State::UnconnectedState) {
+        qCWarning(QT_BT) << "QLowEnergyIsochronousChannel::connectToPeer(): channel is not closed";
+        return;
+    }
+    if (!controller || controller->state() == QLowEnergyController::UnconnectedState
+        || controller->state() == QLowEnergyController::ConnectingState
+        || controller->state() == QLowEnergyController::ClosingState
+        || controller->state() == QLowEnergyController::AdvertisingState) {
+        d->setError(Error::InvalidParametersError, tr("The controller is not connected"));
+        return;
+    }
+    if (!d->checkParameters())
+        return;
+
+    d->type = Type::ConnectedStream;
+    d->openConnectedStream(controller);
+}
+
+/*!
+    Starts to broadcast an isochronous stream from the adapter
+    \a localAdapter, or the default adapter if it is null.
+
+    The stream is announced by the periodic advertising of the advertising set
+    \a advertisingSid, which the kernel sets up as well.
+*/
+void QLowEnergyIsochronousChannel::startBroadcast(quint8 advertisingSid,
+                                                  const QBluetoothAddress &localAdapter)
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    if (d->state != State::UnconnectedState) {
+        qCWarning(QT_BT) << "QLowEnergyIsochronousChannel::startBroadcast(): channel is not closed";
+        return;
+    }
+    if (advertisingSid > 0x0f) {
+        d->setError(Error::InvalidParametersError, tr("Invalid advertising set identifier"));
+        return;
+    }
+    if (!d->checkParameters())
+        return;
+
+    d->type = Type::BroadcastSource;
+    d->openBroadcastSource(advertisingSid, localAdapter);
+}
+
+/*!
+    Receives the broadcast isochronous stream \a streamIndex, starting at 1,
+    of \a broadcaster with the address type \a addressType on the adapter
+    \a localAdapter, or the default adapter if it is null.
+
+    \a advertisingSid identifies the advertising set of the broadcaster whose
+    periodic advertising announces the stream. The SDU interval of the stream
+    is determined by the broadcaster, the other parameters of the channel are
+    ignored.
+*/
+void QLowEnergyIsochronousChannel::synchronizeToBroadcast(
+        const QBluetoothAddress &broadcaster, QLowEnergyController::RemoteAddressType addressType,
+        quint8 advertisingSid, int streamIndex, const QBluetoothAddress &localAdapter)
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    if (d->state != State::UnconnectedState) {
+        qCWarning(QT_BT) << "QLowEnergyIsochronousChannel::synchronizeToBroadcast(): "
+                            "channel is not closed";
+        return;
+    }
+    if (broadcaster.isNull() || advertisingSid > 0x0f || streamIndex < 1 || streamIndex > 0x1f) {
+        d->setError(Error::InvalidParametersError, tr("Invalid broadcast stream"));
+        return;
+    }
+    if (!d->checkParameters())
+        return;
+
+    d->type = Type::BroadcastSink;
+    d->openBroadcastSink(broadcaster, addressType, advertisingSid, streamIndex, localAdapter);
+}
+
+/*!
+    Closes the channel. SDUs which were received but not read yet are
+    discarded.
+*/
+void QLowEnergyIsochronousChannel::close()
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    if (d->state == State::UnconnectedState)
+        return;
+
+    const bool wasConnected = d->state == State::ConnectedState;
+    d->closeChannel();
+    d->resetReceiveQueue();
+    d->setState(State::UnconnectedState);
+    if (wasConnected)
+        emit disconnected();
+}
+
+/*!
+    Returns the type of the channel which was opened last.
+*/
+QLowEnergyIsochronousChannel::Type QLowEnergyIsochronousChannel::type() const
+{
+    Q_D(const QLowEnergyIsochronousChannel);
+    return d->type;
+}
+
+/*!
+    Returns the state of the channel.
+*/
+QLowEnergyIsochronousChannel::State QLowEnergyIsochronousChannel::state() const
+{
+    Q_D(const QLowEnergyIsochronousChannel);
+    return d->state;
+}
+
+/*!
+    Returns the last error which occurred.
+*/
+QLowEnergyIsochronousChannel::Error QLowEnergyIsochronousChannel::error() const
+{
+    Q_D(const QLowEnergyIsochronousChannel);
+    return d->error;
+}
+
+/*!
+    Returns a textual description of the last error.
+*/
+QString QLowEnergyIsochronousChannel::errorString() const
+{
+    Q_D(const QLowEnergyIsochronousChannel);
+    return d->errorString;
+}
+
+/*!
+    Sends \a sdu in the next free SDU interval and returns \c true, or returns
+    \c false if the channel is not connected, \a sdu is larger than
+    \l maximumSduSize() or the kernel's send buffer is full.
+
+    The function never blocks and does not queue \a sdu if it cannot be sent
+    right away. A broadcast sink cannot send.
+*/
+bool QLowEnergyIsochronousChannel::writeSdu(QByteArrayView sdu)
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    if (d->state != State::ConnectedState || d->type == Type::BroadcastSink)
+        return false;
+    if (sdu.size() > d->maximumSduSize) {
+        qCWarning(QT_BT) << "QLowEnergyIsochronousChannel::writeSdu(): SDU of" << sdu.size()
+                         << "bytes exceeds the maximum size of" << d->maximumSduSize;
+        return false;
+    }
+    return d->writeToChannel(sdu);
+}
+
+/*!
+    Returns the number of received SDUs which were not read yet.
+*/
+qsizetype QLowEnergyIsochronousChannel::pendingSduCount() const
+{
+    Q_D(const QLowEnergyIsochronousChannel);
+    return d->receiveCount;
+}
+
+/*!
+    Returns the oldest received SDU which was not read yet, or an empty SDU
+    if there is none.
+
+    The returned data shares the receive buffer. Releasing it before the
+    next SDU arrives lets the channel reuse the buffer without allocating.
+*/
+QLowEnergyIsochronousChannel::Sdu QLowEnergyIsochronousChannel::readSdu()
+{
+    Q_D(QLowEnergyIsochronousChannel);
+    if (d->receiveCount == 0)
+        return {};
+
+    const Sdu &sdu = d->receiveQueue.at(d->receiveHead);
+    d->receiveHead = (d->receiveHead + 1) % d->receiveQueue.size();
+    --d->receiveCount;
+    return sdu;
+}
+
+/*!
+    Returns the number of received SDUs which were dropped because the
+    receive queue was full, since the channel was opened.
+*/
+quint64 QLowEnergyIsochronousChannel::droppedSduCount() const
+{
+    Q_D(const QLowEnergyIsochronousChannel);
+    return d->droppedSdus;
+}
+
+bool QLowEnergyIsochronousChannelPrivate::checkParameters()
+{
+    if (sduInterval < minimumSduInterval || sduInterval > maximumSduInterval
+        || maximumSduSize < 1 || maximumSduSize > maximumSduLength
+        || maximumTransportLatency < minimumTransportLatency
+        || maximumTransportLatency > maximumTransportLatencyLimit
+        || retransmissionCount < 0 || retransmissionCount > 0xff || receiveQueueLength < 1) {
+        setError(QLowEnergyIsochronousChannel::Error::InvalidParametersError,
+                 QLowEnergyIsochronousChannel::tr("Invalid channel parameters"));
+        return false;
+    }
+
+    error = QLowEnergyIsochronousChannel::Error::NoError;
+    errorString.clear();
+    droppedSdus = 0;
+    resetReceiveQueue();
+    receiveQueue.resize(receiveQueueLength);
+    for (QLowEnergyIsochronousChannel::Sdu &sdu : receiveQueue)
+        sdu.data.reserve(maximumSduSize);
+    receiveBuffer.reserve(maximumSduSize);
+    return true;
+}
+
+void QLowEnergyIsochronousChannelPrivate::setState(QLowEnergyIsochronousChannel::State newState)
+{
+    Q_Q(QLowEnergyIsochronousChannel);
+    if (state == newState)
+        return;
+
+    state = newState;
+    emit q->stateChanged(state);
+}
+
+void QLowEnergyIsochronousChannelPrivate::setError(QLowEnergyIsochronousChannel::Error newError,
+                                                   const QString &message)
+{
+    Q_Q(QLowEnergyIsochronousChannel);
+    error = newError;
+    errorString = message;
+    qCDebug(QT_BT) << "Isochronous channel error" << newError << message;
+    emit q->errorOccurred(newError);
+}
+
+void QLowEnergyIsochronousChannelPrivate::setConnected()
+{
+    Q_Q(QLowEnergyIsochronousChannel);
+    setState(QLowEnergyIsochronousChannel::State::ConnectedState);
+    emit q->connected();
+}
+
+QByteArray &QLowEnergyIsochronousChannelPrivate::nextReceiveBuffer()
+{
+    // detaches only if the application still holds the SDU last stored in the buffer
+    receiveBuffer.resize(maximumSduSize);
+    return receiveBuffer;
+}
+
+void QLowEnergyIsochronousChannelPrivate::commitReceived(
+        qsizetype size, std::chrono::system_clock::time_point timestamp)
+{
+    if (receiveCount == receiveQueue.size()) {
+        // the oldest SDU makes room
+        receiveHead = (receiveHead + 1) % receiveQueue.size();
+        --receiveCount;
+        ++droppedSdus;
+    }
+
+    const qsizetype tail = (receiveHead + receiveCount) % receiveQueue.size();
+    QLowEnergyIsochronousChannel::Sdu &sdu = receiveQueue[tail];
+    sdu.data.swap(receiveBuffer);
+    // keeps the capacity for a later SDU
+    sdu.data.resize(size);
+    sdu.timestamp = timestamp;
+    ++receiveCount;
+}
+
+void QLowEnergyIsochronousChannelPrivate::resetReceiveQueue()
+{
+    receiveHead = 0;
+    receiveCount = 0;
+}
+
+void QLowEnergyIsochronousChannelPrivate::handleDisconnect(int errorCode)
+{
+    Q_Q(QLowEnergyIsochronousChannel);
+    const bool wasConnected = state == QLowEnergyIsochronousChannel::State::ConnectedState;
+    // SDUs received before remain readable until the channel is opened again
+    closeChannel();
+    if (wasConnected) {
+        setError(QLowEnergyIsochronousChannel::Error::RemoteHostClosedError,
+                 QLowEnergyIsochronousChannel::tr("The remote device closed the channel"));
+    } else if (errorCode == EPROTONOSUPPORT || errorCode == EAFNOSUPPORT
+               || errorCode == EOPNOTSUPP || errorCode == ENOPROTOOPT) {
+        // the kernel lacks ISO sockets or the adapter lacks isochronous channels
+        setError(QLowEnergyIsochronousChannel::Error::UnsupportedPlatformError,
+                 qt_error_string(errorCode));
+    } else if (errorCode == EACCES || errorCode == EPERM) {
+        setError(QLowEnergyIsochronousChannel::Error::AccessError, qt_error_string(errorCode));
+    } else {
+        setError(QLowEnergyIsochronousChannel::Error::ConnectionError,
+                 qt_error_string(errorCode));
+    }
+    setState(QLowEnergyIsochronousChannel::State::UnconnectedState);
+    if (wasConnected)
+        emit q->disconnected();
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qlowenergyisochronouschannel.cpp"
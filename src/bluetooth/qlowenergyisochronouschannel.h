@@ -0,0 +1,103 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QLOWENERGYISOCHRONOUSCHANNEL_H
+#define QLOWENERGYISOCHRONOUSCHANNEL_H
+
+#include <QtBluetooth/qbluetoothaddress.h>
+#include <QtBluetooth/qlowenergycontroller.h>
+#include <QtBluetooth/qtbluetoothglobal.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qbytearrayview.h>
+#include <QtCore/qobject.h>
+
+#include <chrono>
+
+QT_BEGIN_NAMESPACE
+
+class QLowEnergyIsochronousChannelPrivate;
+
+class Q_BLUETOOTH_EXPORT QLowEnergyIsochronousChannel : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Type {
+        ConnectedStream,
+        BroadcastSource,
+        BroadcastSink
+    };
+    Q_ENUM(Type)
+
+    enum class State {
+        UnconnectedState,
+        ConnectingState,
+        ConnectedState
+    };
+    Q_ENUM(State)
+
+    enum class Error {
+        NoError,
+        UnsupportedPlatformError,
+        InvalidParametersError,
+        ConnectionError,
+        AccessError,
+        RemoteHostClosedError,
+        UnknownError
+    };
+    Q_ENUM(Error)
+
+    struct Sdu {
+        QByteArray data;
+        std::chrono::system_clock::time_point timestamp;
+    };
+
+    explicit QLowEnergyIsochronousChannel(QObject *parent = nullptr);
+    ~QLowEnergyIsochronousChannel();
+
+    void setSduInterval(std::chrono::microseconds interval);
+    std::chrono::microseconds sduInterval() const;
+    void setMaximumSduSize(int size);
+    int maximumSduSize() const;
+    void setMaximumTransportLatency(std::chrono::milliseconds latency);
+    std::chrono::milliseconds maximumTransportLatency() const;
+    void setRetransmissionCount(int count);
+    int retransmissionCount() const;
+    void setPhy(QLowEnergyController::Phy phy);
+    QLowEnergyController::Phy phy() const;
+    void setReceiveQueueLength(int count);
+    int receiveQueueLength() const;
+
+    void connectToPeer(QLowEnergyController *controller);
+    void startBroadcast(quint8 advertisingSid = 0,
+                        const QBluetoothAddress &localAdapter = QBluetoothAddress());
+    void synchronizeToBroadcast(const QBluetoothAddress &broadcaster,
+                                QLowEnergyController::RemoteAddressType addressType,
+                                quint8 advertisingSid, int streamIndex = 1,
+                                const QBluetoothAddress &localAdapter = QBluetoothAddress());
+    void close();
+
+    Type type() const;
+    State state() const;
+    Error error() const;
+    QString errorString() const;
+
+    bool writeSdu(QByteArrayView sdu);
+    qsizetype pendingSduCount() const;
+    Sdu readSdu();
+    quint64 droppedSduCount() const;
+
+Q_SIGNALS:
+    void connected();
+    void disconnected();
+    void stateChanged(QLowEnergyIsochronousChannel::State state);
+    void errorOccurred(QLowEnergyIsochronousChannel::Error error);
+    void readyRead();
+
+private:
+    Q_DECLARE_PRIVATE(QLowEnergyIsochronousChannel)
+    QLowEnergyIsochronousChannelPrivate *d_ptr;
+};
+
+QT_END_NAMESPACE
+
+#endif // QLOWENERGYISOCHRONOUSCHANNEL_H
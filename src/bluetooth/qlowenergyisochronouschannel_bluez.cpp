@@ -0,0 +1,344 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qlowenergyisochronouschannel_p.h"
+#include "qbluetoothsocketbase_p.h"
+#include "bluez/bluez_data_p.h"
+#include "bluez/socketreader_p.h"
+
+#include <QtCore/private/qcore_unix_p.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qsocketnotifier.h>
+
+#include <cstddef>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_BT_BLUEZ)
+
+// the kernel's sizeof(struct sockaddr_iso) without the broadcast part, including its padding
+static constexpr socklen_t unicastAddressLength = offsetof(sockaddr_iso, iso_bc) + 1;
+
+static quint8 addressType(QLowEnergyController::RemoteAddressType type)
+{
+    return type == QLowEnergyController::RandomAddress ? BDADDR_LE_RANDOM : BDADDR_LE_PUBLIC;
+}
+
+static sockaddr_iso isoAddress(const QBluetoothAddress &address, quint8 type)
+{
+    sockaddr_iso addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.iso_family = AF_BLUETOOTH;
+    convertAddress(address.toUInt64(), addr.iso_bdaddr.b);
+    addr.iso_bdaddr_type = type;
+    return addr;
+}
+
+static bt_iso_io_qos ioQos(const QLowEnergyIsochronousChannelPrivate *d)
+{
+    bt_iso_io_qos qos;
+    qos.interval = quint32(d->sduInterval.count());
+    qos.latency = quint16(d->maximumTransportLatency.count());
+    qos.sdu = quint16(d->maximumSduSize);
+    // a bit mask of the PHYs, in the order of QLowEnergyController::Phy
+    qos.phy = quint8(1 << (int(d->phy) - 1));
+    qos.rtn = quint8(d->retransmissionCount);
+    return qos;
+}
+
+static int openIsoSocket()
+{
+    int fd = ::socket(AF_BLUETOOTH, SOCK_SEQPACKET | SOCK_CLOEXEC, BTPROTO_ISO);
+    if (fd < 0)
+        return -1;
+
+    const int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    return fd;
+}
+
+void QLowEnergyIsochronousChannelPrivate::openConnectedStream(QLowEnergyController *controller)
+{
+    Q_Q(QLowEnergyIsochronousChannel);
+    const QBluetoothAddress peer = controller->remoteAddress();
+    if (controller->role() == QLowEnergyController::PeripheralRole) {
+        listen(controller->localAddress(), peer);
+        return;
+    }
+
+    socket = openIsoSocket();
+    if (socket < 0) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    sockaddr_iso local = isoAddress(controller->localAddress(), BDADDR_LE_PUBLIC);
+    if (::bind(socket, reinterpret_cast<sockaddr *>(&local), unicastAddressLength) < 0) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    bt_iso_qos qos;
+    memset(&qos, 0, sizeof(qos));
+    qos.ucast.cig = BT_ISO_QOS_CIG_UNSET;
+    qos.ucast.cis = BT_ISO_QOS_CIS_UNSET;
+    qos.ucast.in = ioQos(this);
+    qos.ucast.out = ioQos(this);
+    if (::setsockopt(socket, SOL_BLUETOOTH, BT_ISO_QOS, &qos, sizeof(qos)) < 0) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    setState(QLowEnergyIsochronousChannel::State::ConnectingState);
+    sockaddr_iso remote = isoAddress(peer, addressType(controller->remoteAddressType()));
+    if (::connect(socket, reinterpret_cast<sockaddr *>(&remote), unicastAddressLength) < 0
+        && errno != EINPROGRESS && errno != EAGAIN) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    writeNotifier = new QSocketNotifier(socket, QSocketNotifier::Write, q);
+    QObject::connect(writeNotifier, &QSocketNotifier::activated, q,
+                     [this]() { connectionFinished(); });
+}
+
+void QLowEnergyIsochronousChannelPrivate::openBroadcastSource(quint8 advertisingSid,
+                                                              const QBluetoothAddress &localAdapter)
+{
+    socket = openIsoSocket();
+    if (socket < 0) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    // the broadcast part makes the socket a BIS, the kernel assigns the stream index
+    sockaddr_iso local = isoAddress(localAdapter, BDADDR_LE_PUBLIC);
+    local.iso_bc.bc_sid = advertisingSid;
+    if (::bind(socket, reinterpret_cast<sockaddr *>(&local), sizeof(local)) < 0) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    bt_iso_qos qos;
+    memset(&qos, 0, sizeof(qos));
+    qos.bcast.big = BT_ISO_QOS_BIG_UNSET;
+    qos.bcast.bis = BT_ISO_QOS_BIS_UNSET;
+    qos.bcast.out = ioQos(this);
+    qos.bcast.sync_timeout = BT_ISO_SYNC_TIMEOUT;
+    qos.bcast.timeout = BT_ISO_SYNC_TIMEOUT;
+    if (::setsockopt(socket, SOL_BLUETOOTH, BT_ISO_QOS, &qos, sizeof(qos)) < 0) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    setState(QLowEnergyIsochronousChannel::State::ConnectingState);
+    // connecting to BDADDR_ANY creates the BIG
+    sockaddr_iso any = isoAddress(QBluetoothAddress(), BDADDR_LE_PUBLIC);
+    if (::connect(socket, reinterpret_cast<sockaddr *>(&any), unicastAddressLength) < 0
+        && errno != EINPROGRESS && errno != EAGAIN) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    Q_Q(QLowEnergyIsochronousChannel);
+    writeNotifier = new QSocketNotifier(socket, QSocketNotifier::Write, q);
+    QObject::connect(writeNotifier, &QSocketNotifier::activated, q,
+                     [this]() { connectionFinished(); });
+}
+
+void QLowEnergyIsochronousChannelPrivate::openBroadcastSink(
+        const QBluetoothAddress &broadcaster, QLowEnergyController::RemoteAddressType type,
+        quint8 advertisingSid, int streamIndex, const QBluetoothAddress &localAdapter)
+{
+    Q_Q(QLowEnergyIsochronousChannel);
+    listenSocket = openIsoSocket();
+    if (listenSocket < 0) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    sockaddr_iso local = isoAddress(localAdapter, BDADDR_LE_PUBLIC);
+    convertAddress(broadcaster.toUInt64(), local.iso_bc.bc_bdaddr.b);
+    local.iso_bc.bc_bdaddr_type = addressType(type);
+    local.iso_bc.bc_sid = advertisingSid;
+    local.iso_bc.bc_num_bis = 1;
+    local.iso_bc.bc_bis[0] = quint8(streamIndex);
+    if (::bind(listenSocket, reinterpret_cast<sockaddr *>(&local), sizeof(local)) < 0) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    bt_iso_qos qos;
+    memset(&qos, 0, sizeof(qos));
+    qos.bcast.big = BT_ISO_QOS_BIG_UNSET;
+    qos.bcast.bis = BT_ISO_QOS_BIS_UNSET;
+    qos.bcast.in = ioQos(this);
+    qos.bcast.sync_timeout = BT_ISO_SYNC_TIMEOUT;
+    qos.bcast.timeout = BT_ISO_SYNC_TIMEOUT;
+    if (::setsockopt(listenSocket, SOL_BLUETOOTH, BT_ISO_QOS, &qos, sizeof(qos)) < 0
+        || ::listen(listenSocket, 1) < 0) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    // the kernel synchronizes to the periodic advertising and the BIG before it accepts
+    setState(QLowEnergyIsochronousChannel::State::ConnectingState);
+    readNotifier = new QSocketNotifier(listenSocket, QSocketNotifier::Read, q);
+    QObject::connect(readNotifier, &QSocketNotifier::activated, q,
+                     [this]() { acceptConnection(); });
+}
+
+void QLowEnergyIsochronousChannelPrivate::listen(const QBluetoothAddress &localAdapter,
+                                                 const QBluetoothAddress &peer)
+{
+    Q_Q(QLowEnergyIsochronousChannel);
+    listenSocket = openIsoSocket();
+    if (listenSocket < 0) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    sockaddr_iso local = isoAddress(localAdapter, BDADDR_LE_PUBLIC);
+    if (::bind(listenSocket, reinterpret_cast<sockaddr *>(&local), unicastAddressLength) < 0) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    bt_iso_qos qos;
+    memset(&qos, 0, sizeof(qos));
+    qos.ucast.cig = BT_ISO_QOS_CIG_UNSET;
+    qos.ucast.cis = BT_ISO_QOS_CIS_UNSET;
+    qos.ucast.in = ioQos(this);
+    qos.ucast.out = ioQos(this);
+    if (::setsockopt(listenSocket, SOL_BLUETOOTH, BT_ISO_QOS, &qos, sizeof(qos)) < 0
+        || ::listen(listenSocket, 1) < 0) {
+        handleDisconnect(errno);
+        return;
+    }
+
+    acceptedPeer = peer;
+    setState(QLowEnergyIsochronousChannel::State::ConnectingState);
+    readNotifier = new QSocketNotifier(listenSocket, QSocketNotifier::Read, q);
+    QObject::connect(readNotifier, &QSocketNotifier::activated, q,
+                     [this]() { acceptConnection(); });
+}
+
+void QLowEnergyIsochronousChannelPrivate::acceptConnection()
+{
+    sockaddr_iso remote;
+    memset(&remote, 0, sizeof(remote));
+    socklen_t length = sizeof(remote);
+    const int fd = ::accept4(listenSocket, reinterpret_cast<sockaddr *>(&remote), &length,
+                             SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+        if (errno != EAGAIN)
+            handleDisconnect(errno);
+        return;
+    }
+
+    // a listening peripheral accepts the streams of any connected central
+    const QBluetoothAddress address(convertAddress(remote.iso_bdaddr.b));
+    if (!acceptedPeer.isNull() && address != acceptedPeer) {
+        qCDebug(QT_BT_BLUEZ) << "Ignoring isochronous stream from" << address;
+        qt_safe_close(fd);
+        return;
+    }
+
+    delete readNotifier;
+    readNotifier = nullptr;
+    qt_safe_close(listenSocket);
+    listenSocket = -1;
+
+    socket = fd;
+    connectionFinished();
+}
+
+void QLowEnergyIsochronousChannelPrivate::connectionFinished()
+{
+    Q_Q(QLowEnergyIsochronousChannel);
+    delete writeNotifier;
+    writeNotifier = nullptr;
+
+    int errorCode = 0;
+    socklen_t length = sizeof(errorCode);
+    if (::getsockopt(socket, SOL_SOCKET, SO_ERROR, &errorCode, &length) < 0)
+        errorCode = errno;
+    if (errorCode != 0) {
+        handleDisconnect(errorCode);
+        return;
+    }
+
+    // every SDU carries the time it was received, see qt_bluezReadWithTimestamp()
+    const int enable = 1;
+    if (::setsockopt(socket, SOL_SOCKET, SO_TIMESTAMP, &enable, sizeof(enable)) < 0)
+        qCDebug(QT_BT_BLUEZ) << "Cannot enable timestamps of isochronous socket" << errno;
+
+    readNotifier = new QSocketNotifier(socket, QSocketNotifier::Read, q);
+    QObject::connect(readNotifier, &QSocketNotifier::activated, q, [this]() { readSdus(); });
+    setConnected();
+}
+
+void QLowEnergyIsochronousChannelPrivate::readSdus()
+{
+    Q_Q(QLowEnergyIsochronousChannel);
+    bool received = false;
+    int errorCode = 0;
+    for (;;) {
+        QByteArray &buffer = nextReceiveBuffer();
+        qint64 timestamp = 0;
+        const qint64 size = qt_bluezReadWithTimestamp(socket, buffer.data(), buffer.size(),
+                                                      &timestamp);
+        if (size < 0 && errno == EAGAIN)
+            break;
+        if (size <= 0) {
+            // a read of 0 bytes means the remote device closed the stream
+            errorCode = size < 0 ? errno : ECONNRESET;
+            break;
+        }
+
+        commitReceived(size, timestamp > 0
+                ? std::chrono::system_clock::time_point(std::chrono::microseconds(timestamp))
+                : std::chrono::system_clock::now());
+        received = true;
+    }
+
+    if (received)
+        emit q->readyRead();
+    if (errorCode != 0)
+        handleDisconnect(errorCode);
+}
+
+bool QLowEnergyIsochronousChannelPrivate::writeToChannel(QByteArrayView sdu)
+{
+    const qint64 written = qt_safe_write(socket, sdu.data(), sdu.size());
+    if (written < 0) {
+        if (errno != EAGAIN)
+            qCWarning(QT_BT_BLUEZ) << "Cannot send isochronous SDU:" << qt_error_string(errno);
+        return false;
+    }
+    return true;
+}
+
+void QLowEnergyIsochronousChannelPrivate::closeChannel()
+{
+    delete readNotifier;
+    readNotifier = nullptr;
+    delete writeNotifier;
+    writeNotifier = nullptr;
+
+    if (socket >= 0) {
+        qt_safe_close(socket);
+        socket = -1;
+    }
+    if (listenSocket >= 0) {
+        qt_safe_close(listenSocket);
+        listenSocket = -1;
+    }
+    acceptedPeer.clear();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,41 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qlowenergyisochronouschannel_p.h"
+
+QT_BEGIN_NAMESPACE
+
+static void setUnsupported(QLowEnergyIsochronousChannelPrivate *d)
+{
+    d->setError(QLowEnergyIsochronousChannel::Error::UnsupportedPlatformError,
+                QLowEnergyIsochronousChannel::tr(
+                        "Isochronous channels are not supported on this platform"));
+}
+
+void QLowEnergyIsochronousChannelPrivate::openConnectedStream(QLowEnergyController *)
+{
+    setUnsupported(this);
+}
+
+void QLowEnergyIsochronousChannelPrivate::openBroadcastSource(quint8, const QBluetoothAddress &)
+{
+    setUnsupported(this);
+}
+
+void QLowEnergyIsochronousChannelPrivate::openBroadcastSink(
+        const QBluetoothAddress &, QLowEnergyController::RemoteAddressType, quint8, int,
+        const QBluetoothAddress &)
+{
+    setUnsupported(this);
+}
+
+void QLowEnergyIsochronousChannelPrivate::closeChannel()
+{
+}
+
+bool QLowEnergyIsochronousChannelPrivate::writeToChannel(QByteArrayView)
+{
+    return false;
+}
+
+QT_END_NAMESPACE
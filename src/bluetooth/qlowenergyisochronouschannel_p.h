@@ -0,0 +1,99 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QLOWENERGYISOCHRONOUSCHANNEL_P_H
+#define QLOWENERGYISOCHRONOUSCHANNEL_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qlowenergyisochronouschannel.h"
+
+#include <QtCore/qlist.h>
+#include <QtCore/private/qglobal_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QSocketNotifier;
+
+class Q_AUTOTEST_EXPORT QLowEnergyIsochronousChannelPrivate
+{
+    Q_DECLARE_PUBLIC(QLowEnergyIsochronousChannel)
+public:
+    explicit QLowEnergyIsochronousChannelPrivate(QLowEnergyIsochronousChannel *q) : q_ptr(q) {}
+
+    static QLowEnergyIsochronousChannelPrivate *get(QLowEnergyIsochronousChannel *q)
+    { return q->d_func(); }
+
+    // the platform specific part, see qlowenergyisochronouschannel_bluez.cpp
+    void openConnectedStream(QLowEnergyController *controller);
+    void openBroadcastSource(quint8 advertisingSid, const QBluetoothAddress &localAdapter);
+    void openBroadcastSink(const QBluetoothAddress &broadcaster,
+                           QLowEnergyController::RemoteAddressType addressType,
+                           quint8 advertisingSid, int streamIndex,
+                           const QBluetoothAddress &localAdapter);
+    void closeChannel();
+    bool writeToChannel(QByteArrayView sdu);
+
+    bool checkParameters();
+    void setState(QLowEnergyIsochronousChannel::State newState);
+    void setError(QLowEnergyIsochronousChannel::Error newError, const QString &message = QString());
+    void setConnected();
+    // closes the channel after it failed or was closed by the remote device
+    void handleDisconnect(int errorCode);
+
+    // Returns the buffer to read the next SDU into, capable of maximumSduSize bytes.
+    // The queue is only touched by commitReceived() once the read succeeded.
+    QByteArray &nextReceiveBuffer();
+    void commitReceived(qsizetype size, std::chrono::system_clock::time_point timestamp);
+    void resetReceiveQueue();
+
+    QLowEnergyIsochronousChannel *q_ptr;
+
+    std::chrono::microseconds sduInterval{10000};
+    int maximumSduSize = 40;
+    std::chrono::milliseconds maximumTransportLatency{10};
+    int retransmissionCount = 2;
+    QLowEnergyController::Phy phy = QLowEnergyController::Phy::Le2M;
+    int receiveQueueLength = 8;
+
+    QLowEnergyIsochronousChannel::Type type = QLowEnergyIsochronousChannel::Type::ConnectedStream;
+    QLowEnergyIsochronousChannel::State state = QLowEnergyIsochronousChannel::State::UnconnectedState;
+    QLowEnergyIsochronousChannel::Error error = QLowEnergyIsochronousChannel::Error::NoError;
+    QString errorString;
+
+    // Ring of receiveQueueLength slots. A received SDU swaps its buffer with the
+    // one of the slot it is stored in, which becomes the next receive buffer. The
+    // buffers are reused unless the application still holds on to an SDU.
+    QList<QLowEnergyIsochronousChannel::Sdu> receiveQueue;
+    QByteArray receiveBuffer;
+    qsizetype receiveHead = 0;
+    qsizetype receiveCount = 0;
+    quint64 droppedSdus = 0;
+
+#if QT_CONFIG(bluez) && !defined(QT_BLUEZ_NO_BTLE)
+    void listen(const QBluetoothAddress &localAdapter, const QBluetoothAddress &peer);
+    void acceptConnection();
+    void connectionFinished();
+    void readSdus();
+
+    int socket = -1;
+    // the listening socket of a peripheral or broadcast sink
+    int listenSocket = -1;
+    QBluetoothAddress acceptedPeer;
+    QSocketNotifier *readNotifier = nullptr;
+    QSocketNotifier *writeNotifier = nullptr;
+#endif
+};
+
+QT_END_NAMESPACE
+
+#endif // QLOWENERGYISOCHRONOUSCHANNEL_P_H
@@ -0,0 +1,135 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qlowenergylinkstatistics_p.h"
+
+QT_BEGIN_NAMESPACE
+
+QT_IMPL_METATYPE_EXTERN(QLowEnergyLinkStatistics)
+
+/*!
+    \since 6.5
+    \class QLowEnergyLinkStatistics
+    \brief The QLowEnergyLinkStatistics class reports traffic counters of a
+           Bluetooth LE connection.
+
+    An object of this class is a snapshot of the counters the local Bluetooth stack
+    keeps for the connection of a \l QLowEnergyController. Comparing two snapshots
+    taken some time apart yields the throughput of the link in each direction.
+
+    The counters refer to HCI ACL packets exchanged between the host and the local
+    Bluetooth controller. They include all L2CAP traffic of the connection, not only
+    the ATT traffic generated by Qt. Retransmissions on the radio link are handled
+    by the Bluetooth controller itself and are therefore not visible to the host.
+
+    \note Currently, link statistics are only available on Linux with the
+    ATT-socket-based BlueZ implementation, which requires the \c CAP_NET_RAW
+    capability. On other platforms \l isValid() always returns \c false. The
+    loopback backend of developer builds, selected by \c QT_BLUETOOTH_LOOPBACK,
+    counts the ATT PDUs of its simulated link instead.
+
+    \inmodule QtBluetooth
+    \ingroup shared
+
+    \sa QLowEnergyController::linkStatistics()
+*/
+
+/*!
+   Constructs a new, invalid object of this class.
+ */
+QLowEnergyLinkStatistics::QLowEnergyLinkStatistics()
+    : d(new QLowEnergyLinkStatisticsPrivate)
+{
+}
+
+/*! Constructs a new object of this class that is a copy of \a other. */
+QLowEnergyLinkStatistics::QLowEnergyLinkStatistics(const QLowEnergyLinkStatistics &other)
+    : d(other.d)
+{
+}
+
+/*! Destroys this object. */
+QLowEnergyLinkStatistics::~QLowEnergyLinkStatistics()
+{
+}
+
+/*! Makes this object a copy of \a other and returns the new value of this object. */
+QLowEnergyLinkStatistics &QLowEnergyLinkStatistics::operator=(const QLowEnergyLinkStatistics &other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+   Returns \c true if the platform provided statistics for the connection,
+   otherwise returns \c false.
+ */
+bool QLowEnergyLinkStatistics::isValid() const
+{
+    return d->valid;
+}
+
+/*!
+   Returns the number of payload bytes sent to the remote device.
+   \sa packetsSent()
+ */
+quint64 QLowEnergyLinkStatistics::bytesSent() const
+{
+    return d->bytesSent;
+}
+
+/*!
+   Returns the number of payload bytes received from the remote device.
+   \sa packetsReceived()
+ */
+quint64 QLowEnergyLinkStatistics::bytesReceived() const
+{
+    return d->bytesReceived;
+}
+
+/*!
+   Returns the number of ACL packets handed to the local Bluetooth controller
+   for transmission to the remote device.
+   \sa completedPackets(), bytesSent()
+ */
+quint64 QLowEnergyLinkStatistics::packetsSent() const
+{
+    return d->packetsSent;
+}
+
+/*!
+   Returns the number of ACL packets received from the remote device.
+   \sa bytesReceived()
+ */
+quint64 QLowEnergyLinkStatistics::packetsReceived() const
+{
+    return d->packetsReceived;
+}
+
+/*!
+   Returns the number of sent packets the local Bluetooth controller reported as
+   completed. The difference to \l packetsSent() is the number of packets still
+   waiting in the controller's buffers, which grows when the link is the bottleneck.
+   \sa packetsSent()
+ */
+quint64 QLowEnergyLinkStatistics::completedPackets() const
+{
+    return d->completedPackets;
+}
+
+/*!
+   Returns the connection interval currently in use in milliseconds, or \c 0 if
+   it is not known.
+   \sa QLowEnergyController::connectionUpdated()
+ */
+double QLowEnergyLinkStatistics::connectionInterval() const
+{
+    return d->connectionInterval;
+}
+
+/*!
+   \fn void QLowEnergyLinkStatistics::swap(QLowEnergyLinkStatistics &other)
+   Swaps this object with \a other.
+ */
+
+QT_END_NAMESPACE
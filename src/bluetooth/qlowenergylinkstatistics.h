@@ -0,0 +1,47 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QLOWENERGYLINKSTATISTICS_H
+#define QLOWENERGYLINKSTATISTICS_H
+
+#include <QtBluetooth/qtbluetoothglobal.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qshareddata.h>
+
+QT_BEGIN_NAMESPACE
+
+class QLowEnergyLinkStatisticsPrivate;
+
+class Q_BLUETOOTH_EXPORT QLowEnergyLinkStatistics
+{
+public:
+    QLowEnergyLinkStatistics();
+    QLowEnergyLinkStatistics(const QLowEnergyLinkStatistics &other);
+    ~QLowEnergyLinkStatistics();
+
+    QLowEnergyLinkStatistics &operator=(const QLowEnergyLinkStatistics &other);
+
+    bool isValid() const;
+
+    quint64 bytesSent() const;
+    quint64 bytesReceived() const;
+    quint64 packetsSent() const;
+    quint64 packetsReceived() const;
+    quint64 completedPackets() const;
+    double connectionInterval() const;
+
+    void swap(QLowEnergyLinkStatistics &other) noexcept { d.swap(other.d); }
+
+private:
+    friend class QLowEnergyControllerPrivateBluez;
+    friend class QLowEnergyControllerPrivateLoopback;
+    QSharedDataPointer<QLowEnergyLinkStatisticsPrivate> d;
+};
+
+Q_DECLARE_SHARED(QLowEnergyLinkStatistics)
+
+QT_END_NAMESPACE
+
+QT_DECL_METATYPE_EXTERN(QLowEnergyLinkStatistics, Q_BLUETOOTH_EXPORT)
+
+#endif // Include guard
@@ -0,0 +1,36 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QLOWENERGYLINKSTATISTICS_P_H
+#define QLOWENERGYLINKSTATISTICS_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qlowenergylinkstatistics.h"
+
+QT_BEGIN_NAMESPACE
+
+class QLowEnergyLinkStatisticsPrivate : public QSharedData
+{
+public:
+    bool valid = false;
+    quint64 bytesSent = 0;
+    quint64 bytesReceived = 0;
+    quint64 packetsSent = 0;
+    quint64 packetsReceived = 0;
+    quint64 completedPackets = 0;
+    double connectionInterval = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QLOWENERGYLINKSTATISTICS_P_H
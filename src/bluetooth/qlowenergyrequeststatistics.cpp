@@ -0,0 +1,453 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qlowenergyrequeststatistics_p.h"
+
+QT_BEGIN_NAMESPACE
+
+QT_IMPL_METATYPE_EXTERN(QLowEnergyRequestStatistics)
+
+/*!
+    \since 6.5
+    \class QLowEnergyRequestStatistics
+    \brief The QLowEnergyRequestStatistics class reports the latencies of the
+           GATT operations of a Bluetooth LE connection.
+
+    An object of this class is a snapshot of the statistics a \l QLowEnergyController
+    collects once \l QLowEnergyController::setRequestStatisticsEnabled() has been
+    called. For each \l Operation the time a request waited in the queue of the
+    controller and the time from sending it until its response arrived are recorded
+    as \l Histogram.
+
+    \note Currently, the wait times and latencies of requests are measured by the
+    BlueZ backends on Linux. The other platforms queue the requests internally and
+    only report the intervals between notifications.
+
+    \inmodule QtBluetooth
+    \ingroup shared
+
+    \sa QLowEnergyController::requestStatistics()
+*/
+
+/*!
+    \enum QLowEnergyRequestStatistics::Operation
+
+    This enum describes the kind of GATT operation a measurement belongs to.
+
+    \value Read                 Reading a characteristic or descriptor value,
+                                including the reads of long values.
+    \value Write                Writing a characteristic or descriptor value with
+                                response, including prepared and reliable writes.
+    \value WriteWithoutResponse Writing a characteristic value without response. These
+                                requests have no latency, only a wait time.
+    \value Discovery            Service, characteristic and descriptor discovery as
+                                well as the MTU exchange.
+    \value Notification         Notifications and indications received from the remote
+                                device. Their latency is the interval since the previous
+                                notification or indication.
+*/
+
+/*!
+    \class QLowEnergyRequestStatistics::Histogram
+    \inmodule QtBluetooth
+    \since 6.5
+
+    \brief The Histogram struct summarizes the durations recorded for one operation.
+
+    \variable QLowEnergyRequestStatistics::Histogram::count
+    \brief The number of recorded durations.
+
+    \variable QLowEnergyRequestStatistics::Histogram::total
+    \brief The sum of all recorded durations.
+
+    \variable QLowEnergyRequestStatistics::Histogram::minimum
+    \brief The shortest recorded duration.
+
+    \variable QLowEnergyRequestStatistics::Histogram::maximum
+    \brief The longest recorded duration.
+
+    \variable QLowEnergyRequestStatistics::Histogram::buckets
+    \brief The number of durations per power-of-two bucket.
+
+    Bucket \c 0 counts the durations below one microsecond, bucket \c i the
+    durations from 2^(i-1) up to 2^i microseconds. The last bucket also takes
+    all longer durations.
+*/
+
+/*!
+   Constructs a new, invalid object of this class.
+ */
+QLowEnergyRequestStatistics::QLowEnergyRequestStatistics()
+    : d(new QLowEnergyRequestStatisticsPrivate)
+{
+}
+
+/*! Constructs a new object of this class that is a copy of \a other. */
+QLowEnergyRequestStatistics::QLowEnergyRequestStatistics(const QLowEnergyRequestStatistics &other)
+    : d(other.d)
+{
+}
+
+/*! Destroys this object. */
+QLowEnergyRequestStatistics::~QLowEnergyRequestStatistics()
+{
+}
+
+/*! Makes this object a copy of \a other and returns the new value of this object. */
+QLowEnergyRequestStatistics &
+QLowEnergyRequestStatistics::operator=(const QLowEnergyRequestStatistics &other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+   Returns \c true if the statistics were enabled when this snapshot was taken,
+   otherwise returns \c false.
+ */
+bool QLowEnergyRequestStatistics::isValid() const
+{
+    return d->valid;
+}
+
+/*!
+   Returns the times requests of \a operation waited in the queue of the
+   controller before they were sent.
+   \sa latency()
+ */
+QLowEnergyRequestStatistics::Histogram
+QLowEnergyRequestStatistics::waitTime(Operation operation) const
+{
+    return d->waitTimes.at(size_t(operation));
+}
+
+/*!
+   Returns the times from sending a request of \a operation until its
+   response arrived. For \l Notification the intervals between notifications
+   are returned.
+   \sa waitTime()
+ */
+QLowEnergyRequestStatistics::Histogram
+QLowEnergyRequestStatistics::latency(Operation operation) const
+{
+    return d->latencies.at(size_t(operation));
+}
+
+/*!
+   Returns the smoothed latency of the responses to requests of \a operation
+   which the controller uses to time out requests. Recent responses weigh more
+   than older ones.
+
+   Returns \c 0 if no response was measured yet or the backend does not time
+   out requests itself.
+   \sa requestTimeout(), latency()
+ */
+std::chrono::nanoseconds QLowEnergyRequestStatistics::smoothedLatency(Operation operation) const
+{
+    return d->smoothedLatencies.at(size_t(operation));
+}
+
+/*!
+   Returns the time the controller waits for the response to the next request
+   of \a operation before it gives the request up.
+
+   The BlueZ kernel backend uses the timeout configured via the
+   \c BLUETOOTH_GATT_TIMEOUT environment variable. Setting
+   \c QT_BLUETOOTH_GATT_ADAPTIVE_TIMEOUT to \c 1 derives the timeout from the
+   smoothed latency and its deviation, the negotiated connection parameters
+   and the limits of the operation, bounded by the configured timeout.
+
+   \note ATT responses carry no request id. A response which arrives after
+   its request timed out is taken for the response to the next request, so
+   short adaptive timeouts suit only links with a steady latency.
+
+   Returns \c 0 if requests do not time out or the backend does not time out
+   requests itself.
+   \sa smoothedLatency(), timeoutCount()
+ */
+std::chrono::milliseconds QLowEnergyRequestStatistics::requestTimeout(Operation operation) const
+{
+    return d->requestTimeouts.at(size_t(operation));
+}
+
+/*!
+   Returns the largest number of requests which were queued at the same time.
+ */
+qsizetype QLowEnergyRequestStatistics::queueHighWaterMark() const
+{
+    return d->queueHighWaterMark;
+}
+
+/*!
+   Returns the number of requests which were sent again, for example after the
+   security level of the link had to be raised.
+ */
+quint64 QLowEnergyRequestStatistics::retryCount() const
+{
+    return d->retries;
+}
+
+/*!
+   Returns the number of requests whose response did not arrive in time.
+ */
+quint64 QLowEnergyRequestStatistics::timeoutCount() const
+{
+    return d->timeouts;
+}
+
+/*!
+   \fn void QLowEnergyRequestStatistics::swap(QLowEnergyRequestStatistics &other)
+   Swaps this object with \a other.
+ */
+
+void QLowEnergyRequestRecorder::Histogram::record(qint64 nsecs)
+{
+    const qint64 usecs = nsecs / 1000;
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && usecs >= (qint64(1) << bucket))
+        ++bucket;
+
+    qint64 current = minimum.load(std::memory_order_relaxed);
+    while (nsecs < current
+           && !minimum.compare_exchange_weak(current, nsecs, std::memory_order_relaxed)) {
+    }
+    current = maximum.load(std::memory_order_relaxed);
+    while (nsecs > current
+           && !maximum.compare_exchange_weak(current, nsecs, std::memory_order_relaxed)) {
+    }
+    total.fetch_add(nsecs, std::memory_order_relaxed);
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+}
+
+QLowEnergyRequestStatistics::Histogram QLowEnergyRequestRecorder::Histogram::load() const
+{
+    QLowEnergyRequestStatistics::Histogram result;
+    result.count = count.load(std::memory_order_relaxed);
+    if (result.count == 0)
+        return result;
+
+    result.total = std::chrono::nanoseconds(total.load(std::memory_order_relaxed));
+    result.minimum = std::chrono::nanoseconds(minimum.load(std::memory_order_relaxed));
+    result.maximum = std::chrono::nanoseconds(maximum.load(std::memory_order_relaxed));
+    result.buckets.reserve(BucketCount);
+    for (const auto &bucket : buckets)
+        result.buckets.append(bucket.load(std::memory_order_relaxed));
+    return result;
+}
+
+void QLowEnergyRequestRecorder::Histogram::reset()
+{
+    count.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    minimum.store(std::numeric_limits<qint64>::max(), std::memory_order_relaxed);
+    maximum.store(0, std::memory_order_relaxed);
+    for (auto &bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+void QLowEnergyRequestRecorder::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void QLowEnergyRequestRecorder::recordWaitTime(Operation operation, Clock::duration duration)
+{
+    if (!isEnabled())
+        return;
+    const auto nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    m_waitTimes[size_t(operation)].record(qMax(nsecs, qint64(0)));
+}
+
+void QLowEnergyRequestRecorder::recordLatency(Operation operation, Clock::duration duration)
+{
+    if (!isEnabled())
+        return;
+    const auto nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    m_latencies[size_t(operation)].record(qMax(nsecs, qint64(0)));
+}
+
+void QLowEnergyRequestRecorder::recordRequest(Operation operation, Clock::time_point queuedAt,
+                                              Clock::time_point sentAt)
+{
+    if (!isEnabled())
+        return;
+    recordWaitTime(operation, sentAt - queuedAt);
+    if (operation != Operation::WriteWithoutResponse)
+        recordLatency(operation, Clock::now() - sentAt);
+}
+
+void QLowEnergyRequestRecorder::recordNotification(Clock::time_point arrival)
+{
+    if (!isEnabled())
+        return;
+
+    const qint64 now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                arrival.time_since_epoch()).count();
+    const qint64 previous = m_lastNotification.exchange(now, std::memory_order_relaxed);
+    if (previous != 0)
+        m_latencies[size_t(Operation::Notification)].record(qMax(now - previous, qint64(0)));
+}
+
+void QLowEnergyRequestRecorder::recordQueueDepth(qsizetype depth)
+{
+    if (!isEnabled())
+        return;
+
+    qsizetype current = m_queueHighWaterMark.load(std::memory_order_relaxed);
+    while (depth > current
+           && !m_queueHighWaterMark.compare_exchange_weak(current, depth,
+                                                          std::memory_order_relaxed)) {
+    }
+}
+
+void QLowEnergyRequestRecorder::recordRetry()
+{
+    if (isEnabled())
+        m_retries.fetch_add(1, std::memory_order_relaxed);
+}
+
+void QLowEnergyRequestRecorder::recordTimeout()
+{
+    if (isEnabled())
+        m_timeouts.fetch_add(1, std::memory_order_relaxed);
+}
+
+QLowEnergyRequestStatistics
+QLowEnergyRequestRecorder::statistics(const QLowEnergyRequestTimeoutEstimator *timeouts) const
+{
+    QLowEnergyRequestStatistics result;
+    if (!isEnabled())
+        return result;
+
+    QLowEnergyRequestStatisticsPrivate *d = result.d.data();
+    d->valid = true;
+    for (size_t i = 0; i < m_waitTimes.size(); ++i) {
+        d->waitTimes[i] = m_waitTimes[i].load();
+        d->latencies[i] = m_latencies[i].load();
+    }
+    d->queueHighWaterMark = m_queueHighWaterMark.load(std::memory_order_relaxed);
+    d->retries = m_retries.load(std::memory_order_relaxed);
+    d->timeouts = m_timeouts.load(std::memory_order_relaxed);
+    if (timeouts) {
+        for (size_t i = 0; i < d->requestTimeouts.size(); ++i) {
+            const auto operation = QLowEnergyRequestStatistics::Operation(i);
+            d->smoothedLatencies[i] = timeouts->smoothedLatency(operation);
+            d->requestTimeouts[i] = timeouts->timeout(operation);
+        }
+    }
+    return result;
+}
+
+void QLowEnergyRequestRecorder::reset()
+{
+    for (size_t i = 0; i < m_waitTimes.size(); ++i) {
+        m_waitTimes[i].reset();
+        m_latencies[i].reset();
+    }
+    m_queueHighWaterMark.store(0, std::memory_order_relaxed);
+    m_retries.store(0, std::memory_order_relaxed);
+    m_timeouts.store(0, std::memory_order_relaxed);
+    m_lastNotification.store(0, std::memory_order_relaxed);
+}
+
+// The lower bound per operation, answering requests may involve the application
+// on the remote device and write requests may have to wait for its storage.
+static std::chrono::milliseconds operationMinimum(QLowEnergyRequestStatistics::Operation operation)
+{
+    using namespace std::chrono_literals;
+    using Operation = QLowEnergyRequestStatistics::Operation;
+
+    switch (operation) {
+    case Operation::Read:
+        return 2s;
+    case Operation::Write:
+        return 3s;
+    case Operation::Discovery:
+        return 2s;
+    case Operation::WriteWithoutResponse:
+    case Operation::Notification:
+        break;
+    }
+    return 0ms;
+}
+
+/*
+    Takes the parameters of the connection, \a interval in ms and
+    \a supervisionTimeout in ms. The remote device may skip \a latency
+    connection events before it sees a request and has to answer within a
+    further event. Until the supervision timeout passed, silence on the link
+    may still be a healthy link.
+*/
+void QLowEnergyRequestTimeoutEstimator::setConnectionParameters(double interval, int latency,
+                                                                int supervisionTimeout)
+{
+    using namespace std::chrono;
+
+    // twice the events needed for the request and its response
+    const auto events = milliseconds(qint64(4 * (qMax(latency, 0) + 1) * qMax(interval, 0.0)));
+    m_linkMinimum = qMax(events, milliseconds(qMax(supervisionTimeout, 0)));
+}
+
+void QLowEnergyRequestTimeoutEstimator::recordResponse(Operation operation,
+                                                       std::chrono::steady_clock::duration latency)
+{
+    Estimate &estimate = m_estimates[size_t(operation)];
+    const qint64 sample = qMax<qint64>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count(), 0);
+    if (estimate.samples == 0) {
+        estimate.smoothed = sample;
+        estimate.deviation = sample / 2;
+    } else {
+        // gains of 1/8 and 1/4, see RFC 6298
+        const qint64 error = sample - estimate.smoothed;
+        estimate.smoothed += error / 8;
+        estimate.deviation += (qAbs(error) - estimate.deviation) / 4;
+    }
+    if (estimate.samples < MinimumSamples)
+        ++estimate.samples;
+    estimate.backoff = 0;
+}
+
+void QLowEnergyRequestTimeoutEstimator::recordTimeout(Operation operation)
+{
+    Estimate &estimate = m_estimates[size_t(operation)];
+    estimate.backoff = qMin(estimate.backoff + 1, MaximumBackoff);
+}
+
+std::chrono::milliseconds QLowEnergyRequestTimeoutEstimator::timeout(Operation operation) const
+{
+    using namespace std::chrono;
+    using namespace std::chrono_literals;
+
+    if (m_maximum <= 0ms)
+        return 0ms;
+
+    // slow links may exceed the configured maximum, but not the ATT transaction timeout
+    const milliseconds maximum = qMax(m_maximum, qMin(m_linkMinimum, milliseconds(30s)));
+    const Estimate &estimate = m_estimates.at(size_t(operation));
+    if (!m_adaptive || estimate.samples < MinimumSamples)
+        return maximum;
+
+    const auto measured = duration_cast<milliseconds>(
+            nanoseconds(estimate.smoothed + 4 * estimate.deviation));
+    const milliseconds minimum = qMax(operationMinimum(operation), m_linkMinimum);
+    const milliseconds result = qMax(measured, minimum) * (1 << estimate.backoff);
+    return qMin(result, maximum);
+}
+
+std::chrono::nanoseconds
+QLowEnergyRequestTimeoutEstimator::smoothedLatency(Operation operation) const
+{
+    return std::chrono::nanoseconds(m_estimates.at(size_t(operation)).smoothed);
+}
+
+void QLowEnergyRequestTimeoutEstimator::reset()
+{
+    m_estimates = {};
+    m_linkMinimum = std::chrono::milliseconds(0);
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qlowenergyrequeststatistics.cpp"
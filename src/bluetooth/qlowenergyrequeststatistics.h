@@ -0,0 +1,70 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QLOWENERGYREQUESTSTATISTICS_H
+#define QLOWENERGYREQUESTSTATISTICS_H
+
+#include <QtBluetooth/qtbluetoothglobal.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qobjectdefs.h>
+#include <QtCore/qshareddata.h>
+
+#include <chrono>
+
+QT_BEGIN_NAMESPACE
+
+class QLowEnergyRequestStatisticsPrivate;
+
+class Q_BLUETOOTH_EXPORT QLowEnergyRequestStatistics
+{
+    Q_GADGET
+public:
+    enum class Operation {
+        Read,
+        Write,
+        WriteWithoutResponse,
+        Discovery,
+        Notification
+    };
+    Q_ENUM(Operation)
+
+    struct Histogram
+    {
+        quint64 count = 0;
+        std::chrono::nanoseconds total{};
+        std::chrono::nanoseconds minimum{};
+        std::chrono::nanoseconds maximum{};
+        QList<quint64> buckets;
+    };
+
+    QLowEnergyRequestStatistics();
+    QLowEnergyRequestStatistics(const QLowEnergyRequestStatistics &other);
+    ~QLowEnergyRequestStatistics();
+
+    QLowEnergyRequestStatistics &operator=(const QLowEnergyRequestStatistics &other);
+
+    bool isValid() const;
+
+    Histogram waitTime(Operation operation) const;
+    Histogram latency(Operation operation) const;
+    std::chrono::nanoseconds smoothedLatency(Operation operation) const;
+    std::chrono::milliseconds requestTimeout(Operation operation) const;
+    qsizetype queueHighWaterMark() const;
+    quint64 retryCount() const;
+    quint64 timeoutCount() const;
+
+    void swap(QLowEnergyRequestStatistics &other) noexcept { d.swap(other.d); }
+
+private:
+    friend class QLowEnergyRequestRecorder;
+    QSharedDataPointer<QLowEnergyRequestStatisticsPrivate> d;
+};
+
+Q_DECLARE_SHARED(QLowEnergyRequestStatistics)
+
+QT_END_NAMESPACE
+
+QT_DECL_METATYPE_EXTERN(QLowEnergyRequestStatistics, Q_BLUETOOTH_EXPORT)
+
+#endif // Include guard
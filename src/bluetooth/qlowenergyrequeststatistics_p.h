@@ -0,0 +1,157 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QLOWENERGYREQUESTSTATISTICS_P_H
+#define QLOWENERGYREQUESTSTATISTICS_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qlowenergyrequeststatistics.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+class QLowEnergyRequestStatisticsPrivate : public QSharedData
+{
+public:
+    static constexpr int OperationCount = 5;
+
+    bool valid = false;
+    std::array<QLowEnergyRequestStatistics::Histogram, OperationCount> waitTimes;
+    std::array<QLowEnergyRequestStatistics::Histogram, OperationCount> latencies;
+    std::array<std::chrono::nanoseconds, OperationCount> smoothedLatencies{};
+    std::array<std::chrono::milliseconds, OperationCount> requestTimeouts{};
+    qsizetype queueHighWaterMark = 0;
+    quint64 retries = 0;
+    quint64 timeouts = 0;
+};
+
+/*
+    Collects the request statistics of one controller. Recording is lock-free
+    and does nothing unless the statistics are enabled, so the backends may
+    call it from any thread and on every request.
+*/
+class QLowEnergyRequestTimeoutEstimator;
+
+class Q_AUTOTEST_EXPORT QLowEnergyRequestRecorder
+{
+public:
+    using Operation = QLowEnergyRequestStatistics::Operation;
+    using Clock = std::chrono::steady_clock;
+
+    // Number of histogram buckets, the last one takes everything above 2^22 us
+    static constexpr int BucketCount = 24;
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    void recordWaitTime(Operation operation, Clock::duration duration);
+    void recordLatency(Operation operation, Clock::duration duration);
+    // A request which was queued at queuedAt, sent at sentAt and answered now
+    void recordRequest(Operation operation, Clock::time_point queuedAt,
+                       Clock::time_point sentAt);
+    // The latency of notifications is the time since the previous one
+    void recordNotification(Clock::time_point arrival = Clock::now());
+    void recordQueueDepth(qsizetype depth);
+    void recordRetry();
+    void recordTimeout();
+
+    // The timeouts are only part of the snapshot if an estimator is given
+    QLowEnergyRequestStatistics statistics(
+            const QLowEnergyRequestTimeoutEstimator *timeouts = nullptr) const;
+    void reset();
+
+private:
+    struct Histogram
+    {
+        std::atomic<quint64> count{0};
+        std::atomic<qint64> total{0};
+        std::atomic<qint64> minimum{std::numeric_limits<qint64>::max()};
+        std::atomic<qint64> maximum{0};
+        std::array<std::atomic<quint64>, BucketCount> buckets{};
+
+        void record(qint64 nsecs);
+        QLowEnergyRequestStatistics::Histogram load() const;
+        void reset();
+    };
+
+    std::atomic<bool> m_enabled{false};
+    std::array<Histogram, QLowEnergyRequestStatisticsPrivate::OperationCount> m_waitTimes;
+    std::array<Histogram, QLowEnergyRequestStatisticsPrivate::OperationCount> m_latencies;
+    std::atomic<qsizetype> m_queueHighWaterMark{0};
+    std::atomic<quint64> m_retries{0};
+    std::atomic<quint64> m_timeouts{0};
+    // nanoseconds since the epoch of Clock, 0 if there was no notification yet
+    std::atomic<qint64> m_lastNotification{0};
+};
+
+/*
+    Derives the timeout of the next request from the response latencies seen
+    on the link, following the retransmission timer of TCP (RFC 6298): the
+    timeout is the smoothed latency plus four times its mean deviation. It
+    never drops below the per operation minimum or the time the negotiated
+    connection parameters need for a request and its response, and never
+    exceeds the configured maximum. Each timeout doubles the next one until
+    a response arrives again.
+
+    ATT has no transaction ids, a response which arrives after its request
+    timed out is taken for the response to the next request. Short timeouts
+    are therefore opt-in, without setAdaptive() the configured maximum is
+    used.
+
+    Used on the thread of the controller only.
+*/
+class Q_AUTOTEST_EXPORT QLowEnergyRequestTimeoutEstimator
+{
+public:
+    using Operation = QLowEnergyRequestStatistics::Operation;
+
+    // Responses required before the measured latency is trusted
+    static constexpr int MinimumSamples = 8;
+    static constexpr int MaximumBackoff = 3;
+
+    void setAdaptive(bool adaptive) { m_adaptive = adaptive; }
+    bool isAdaptive() const { return m_adaptive; }
+    // 0 disables the timeouts
+    void setMaximumTimeout(std::chrono::milliseconds timeout) { m_maximum = timeout; }
+    std::chrono::milliseconds maximumTimeout() const { return m_maximum; }
+    void setConnectionParameters(double interval, int latency, int supervisionTimeout);
+
+    void recordResponse(Operation operation, std::chrono::steady_clock::duration latency);
+    void recordTimeout(Operation operation);
+
+    std::chrono::milliseconds timeout(Operation operation) const;
+    std::chrono::nanoseconds smoothedLatency(Operation operation) const;
+    void reset();
+
+private:
+    struct Estimate
+    {
+        qint64 smoothed = 0; // in ns
+        qint64 deviation = 0; // in ns
+        int samples = 0;
+        int backoff = 0;
+    };
+
+    std::array<Estimate, QLowEnergyRequestStatisticsPrivate::OperationCount> m_estimates;
+    std::chrono::milliseconds m_maximum{0};
+    std::chrono::milliseconds m_linkMinimum{0};
+    bool m_adaptive = false;
+};
+
+QT_END_NAMESPACE
+
+#endif // QLOWENERGYREQUESTSTATISTICS_P_H
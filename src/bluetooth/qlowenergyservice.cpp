@@ -10,6 +10,7 @@
 
 #include "qlowenergycontrollerbase_p.h"
 #include "qlowenergyserviceprivate_p.h"
+#include <qtbluetooth_tracepoints_p.h>
 
 #ifdef Q_OS_DARWIN
 #include "qlowenergycontroller_darwin_p.h"
@@ -105,7 +106,15 @@ QT_IMPL_METATYPE_EXTERN_TAGGED(QLowEnergyService::WriteMode, QLowEnergyService__
     For example, issuing a second write request, before the previous
     write request has finished, is delayed until the first write request has finished.
 
-    \note Currently, it is not possible to send signed write or reliable write requests.
+    Besides the signals, \l readCharacteristicAsync(), \l writeCharacteristicAsync(),
+    \l readDescriptorAsync() and \l writeDescriptorAsync() return a QFuture
+    which is fulfilled by the request it belongs to.
+
+    A set of characteristics can be written as one transaction, which the remote
+    device either applies as a whole or not at all, by calling
+    \l writeCharacteristicsReliably().
+
+    \note Currently, it is not possible to send signed write requests.
 
     \target notifications
 
@@ -221,11 +230,41 @@ QT_IMPL_METATYPE_EXTERN_TAGGED(QLowEnergyService::WriteMode, QLowEnergyService__
     \value SkipValueDiscovery   During a minimal discovery, all characteristics
                                 are discovered. Characteristic values and
                                 descriptors are not read.
+    \value IncrementalDiscovery The service is discovered as with
+                                \l SkipValueDiscovery. Once it entered the
+                                \l RemoteServiceDiscovered state, the
+                                characteristic values and descriptors are
+                                read in the background. Requests issued in
+                                response to the state change, such as enabling
+                                notifications, are sent before these reads.
+                                The values become available as they arrive,
+                                without \l characteristicRead() or
+                                \l descriptorRead() being emitted. Backends
+                                other than the BlueZ kernel backend perform a
+                                \l FullDiscovery. This value was introduced
+                                in Qt 6.5.
 
     \sa discoverDetails()
     \since 6.2
 */
 
+/*!
+    \enum QLowEnergyService::DiscoveryTarget
+
+    This enum lists the attributes a discovery fetches in addition to the
+    characteristic declarations, which are always discovered.
+
+    \value DescriptorDiscovery          The descriptors of the characteristics
+                                        are discovered.
+    \value CharacteristicValueDiscovery The values of the readable
+                                        characteristics are read.
+    \value DescriptorValueDiscovery     The values of the discovered descriptors
+                                        are read.
+
+    \sa discoverDetails()
+    \since 6.5
+*/
+
 /*!
   \enum QLowEnergyService::WriteMode
 
@@ -295,6 +334,23 @@ QT_IMPL_METATYPE_EXTERN_TAGGED(QLowEnergyService::WriteMode, QLowEnergyService__
     \since 5.5
  */
 
+/*!
+    \fn void QLowEnergyService::characteristicReadProgress(const QLowEnergyCharacteristic &characteristic, qsizetype bytesRead)
+
+    This signal is emitted while the value of \a characteristic is read in several
+    parts because it is longer than the MTU allows for one packet. \a bytesRead is the
+    number of bytes received so far. The complete value is reported via
+    \l characteristicRead() once the read operation has finished.
+
+    \note Currently, this signal is only emitted on Linux with the ATT-socket-based
+    BlueZ implementation. If Enhanced ATT bearers are enabled there, the parts of a
+    long value are requested on all bearers at once, which reduces the time the read
+    operation takes.
+
+    \sa readCharacteristic()
+    \since 6.5
+ */
+
 /*!
     \fn void QLowEnergyService::characteristicWritten(const QLowEnergyCharacteristic &characteristic, const QByteArray &newValue)
 
@@ -332,6 +388,49 @@ QT_IMPL_METATYPE_EXTERN_TAGGED(QLowEnergyService::WriteMode, QLowEnergyService__
 
     The \a newValue parameter contains the updated value of the \a characteristic.
 
+    \note This signal is not emitted while notification batching is enabled.
+    Refer to \l characteristicsChanged() for details.
+
+ */
+
+/*!
+    \fn void QLowEnergyService::characteristicsChanged(const QList<QLowEnergyCharacteristic>
+   &characteristics, const QList<QByteArray> &values)
+    \since 6.5
+
+    This signal replaces \l characteristicChanged() while notification batching
+    is enabled via \l setNotificationBatchInterval(). It delivers all value
+    changes which arrived during one batch window. The \a characteristics and
+    \a values lists have the same length; the value at a given index belongs
+    to the characteristic at the same index. The changes are listed in the
+    order of their arrival and a characteristic may appear more than once.
+
+    \sa setNotificationBatchInterval()
+ */
+
+/*!
+    \fn void QLowEnergyService::characteristicsRead(const QList<QLowEnergyCharacteristic>
+   &characteristics, const QList<QByteArray> &values)
+    \since 6.5
+
+    This signal is emitted once all \a characteristics passed to one
+    \l readCharacteristics() call have been read. The value at a given index of
+    \a values belongs to the characteristic at the same index.
+
+    \sa readCharacteristics()
+ */
+
+/*!
+    \fn void QLowEnergyService::characteristicsWritten(const QList<QLowEnergyCharacteristic>
+   &characteristics, const QList<QByteArray> &values)
+    \since 6.5
+
+    This signal is emitted once all \a characteristics passed to one
+    \l writeCharacteristics() call in the \l WriteWithResponse mode, or to one
+    \l writeCharacteristicsReliably() call, have been written. The value at a given index of \a values belongs to the characteristic
+    at the same index.
+
+    \sa writeCharacteristics(), writeCharacteristicsReliably()
  */
 
 /*!
@@ -372,6 +471,8 @@ QLowEnergyService::QLowEnergyService(QSharedPointer<QLowEnergyServicePrivate> p,
     : QObject(parent),
       d_ptr(p)
 {
+    p->serviceObjects.ref();
+
     qRegisterMetaType<QLowEnergyService::ServiceState>();
     qRegisterMetaType<QLowEnergyService::ServiceError>();
     qRegisterMetaType<QLowEnergyService::ServiceType>();
@@ -381,16 +482,44 @@ QLowEnergyService::QLowEnergyService(QSharedPointer<QLowEnergyServicePrivate> p,
             &QLowEnergyService::errorOccurred);
     connect(p.data(), &QLowEnergyServicePrivate::stateChanged,
             this, &QLowEnergyService::stateChanged);
-    connect(p.data(), &QLowEnergyServicePrivate::characteristicChanged,
-            this, &QLowEnergyService::characteristicChanged);
-    connect(p.data(), &QLowEnergyServicePrivate::characteristicWritten,
-            this, &QLowEnergyService::characteristicWritten);
-    connect(p.data(), &QLowEnergyServicePrivate::descriptorWritten,
-            this, &QLowEnergyService::descriptorWritten);
-    connect(p.data(), &QLowEnergyServicePrivate::characteristicRead,
-            this, &QLowEnergyService::characteristicRead);
-    connect(p.data(), &QLowEnergyServicePrivate::descriptorRead,
-            this, &QLowEnergyService::descriptorRead);
+    connect(p.data(), &QLowEnergyServicePrivate::characteristicChanged, this,
+            [this](const QLowEnergyCharacteristic &characteristic, const QByteArray &value) {
+                Q_TRACE(QLowEnergyService_signalEmitted, "characteristicChanged",
+                        characteristic.handle(), int(value.size()));
+                emit characteristicChanged(characteristic, value);
+            });
+    connect(p.data(), &QLowEnergyServicePrivate::characteristicsChanged,
+            this, &QLowEnergyService::characteristicsChanged);
+    connect(p.data(), &QLowEnergyServicePrivate::characteristicWritten, this,
+            [this](const QLowEnergyCharacteristic &characteristic, const QByteArray &value) {
+                Q_TRACE(QLowEnergyService_signalEmitted, "characteristicWritten",
+                        characteristic.handle(), int(value.size()));
+                emit characteristicWritten(characteristic, value);
+            });
+    connect(p.data(), &QLowEnergyServicePrivate::descriptorWritten, this,
+            [this](const QLowEnergyDescriptor &descriptor, const QByteArray &value) {
+                Q_TRACE(QLowEnergyService_signalEmitted, "descriptorWritten",
+                        descriptor.handle(), int(value.size()));
+                emit descriptorWritten(descriptor, value);
+            });
+    connect(p.data(), &QLowEnergyServicePrivate::characteristicRead, this,
+            [this](const QLowEnergyCharacteristic &characteristic, const QByteArray &value) {
+                Q_TRACE(QLowEnergyService_signalEmitted, "characteristicRead",
+                        characteristic.handle(), int(value.size()));
+                emit characteristicRead(characteristic, value);
+            });
+    connect(p.data(), &QLowEnergyServicePrivate::characteristicReadProgress,
+            this, &QLowEnergyService::characteristicReadProgress);
+    connect(p.data(), &QLowEnergyServicePrivate::descriptorRead, this,
+            [this](const QLowEnergyDescriptor &descriptor, const QByteArray &value) {
+                Q_TRACE(QLowEnergyService_signalEmitted, "descriptorRead",
+                        descriptor.handle(), int(value.size()));
+                emit descriptorRead(descriptor, value);
+            });
+    connect(p.data(), &QLowEnergyServicePrivate::characteristicsRead,
+            this, &QLowEnergyService::characteristicsRead);
+    connect(p.data(), &QLowEnergyServicePrivate::characteristicsWritten,
+            this, &QLowEnergyService::characteristicsWritten);
 }
 
 /*!
@@ -398,6 +527,12 @@ QLowEnergyService::QLowEnergyService(QSharedPointer<QLowEnergyServicePrivate> p,
  */
 QLowEnergyService::~QLowEnergyService()
 {
+    // nobody is left to take the results of the pending reads
+    if (!d_ptr->serviceObjects.deref()) {
+        QMetaObject::invokeMethod(d_ptr.data(), [service = d_ptr]() {
+            service->cancelPendingReads();
+        });
+    }
 }
 
 /*!
@@ -479,16 +614,11 @@ QLowEnergyService::ServiceTypes QLowEnergyService::type() const
 */
 QLowEnergyCharacteristic QLowEnergyService::characteristic(const QBluetoothUuid &uuid) const
 {
-    CharacteristicDataMap::const_iterator charIt = d_ptr->characteristicList.constBegin();
-    for ( ; charIt != d_ptr->characteristicList.constEnd(); ++charIt) {
-        const QLowEnergyHandle charHandle = charIt.key();
-        const QLowEnergyServicePrivate::CharData &charDetails = charIt.value();
-
-        if (charDetails.uuid == uuid)
-            return QLowEnergyCharacteristic(d_ptr, charHandle);
-    }
+    const QLowEnergyHandle charHandle = d_ptr->characteristicHandle(uuid);
+    if (!charHandle)
+        return QLowEnergyCharacteristic();
 
-    return QLowEnergyCharacteristic();
+    return QLowEnergyCharacteristic(d_ptr, charHandle);
 }
 
 /*!
@@ -564,6 +694,8 @@ QString QLowEnergyService::serviceName() const
     faster. Second, it circumvents bugs in some devices which wrongly advertise
     characteristics or descriptors as readable but nevertheless do not permit
     reads on them. This can trigger unpredictable behavior.
+    An \l IncrementalDiscovery makes the service usable as early as a
+    \l SkipValueDiscovery and reads the values afterwards.
     After a \l SkipValueDiscovery, it is necessary to call
     \l readCharacteristic() / \l readDescriptor() and wait for them to
     finish successfully before accessing the value of a characteristic or
@@ -585,11 +717,91 @@ void QLowEnergyService::discoverDetails(DiscoveryMode mode)
     if (d->state != QLowEnergyService::RemoteService)
         return;
 
+    d->discoveryTargets = DescriptorDiscovery;
+    if (mode != SkipValueDiscovery)
+        d->discoveryTargets |= CharacteristicValueDiscovery | DescriptorValueDiscovery;
+    d->discoveryFilter.clear();
     d->setState(QLowEnergyService::RemoteServiceDiscovering);
 
     d->controller->discoverServiceDetails(d->uuid, mode);
 }
 
+/*!
+    \overload
+    \since 6.5
+
+    Initiates a partial discovery of the service's included services and
+    characteristics. Besides the characteristic declarations only the
+    attributes given by \a targets are fetched. If \a characteristicUuids is
+    not empty, descriptors and values are only fetched for the characteristics
+    with one of these UUIDs. The other characteristics are still listed by
+    \l characteristics(), without descriptors and values.
+
+    The discovery is indicated via the \l stateChanged() signal as with a
+    \l FullDiscovery. For example, the following only discovers the
+    descriptors of the heart rate measurement characteristic, which is
+    sufficient to enable its notifications:
+
+    \code
+    service->discoverDetails(QLowEnergyService::DescriptorDiscovery,
+                             { QBluetoothUuid::CharacteristicType::HeartRateMeasurement });
+    \endcode
+
+    \note Platforms which report the descriptors together with the
+    characteristics, such as Android, Windows and the BlueZ D-Bus API, list them
+    even without \l DescriptorDiscovery. On macOS and iOS the values of all
+    characteristics and descriptors are read if \a targets contains any of the
+    value targets.
+
+    \sa DiscoveryTarget, state()
+ */
+void QLowEnergyService::discoverDetails(DiscoveryTargets targets,
+                                        const QList<QBluetoothUuid> &characteristicUuids)
+{
+    Q_D(QLowEnergyService);
+
+    if (!d->controller || d->state == QLowEnergyService::InvalidService) {
+        d->setError(QLowEnergyService::OperationError);
+        return;
+    }
+
+    if (d->state != QLowEnergyService::RemoteService)
+        return;
+
+    d->discoveryTargets = targets;
+    d->discoveryFilter = characteristicUuids;
+    d->setState(QLowEnergyService::RemoteServiceDiscovering);
+
+    // backends which cannot select single attributes use the closest mode
+    const bool readsValues = targets & (CharacteristicValueDiscovery | DescriptorValueDiscovery);
+    d->controller->discoverServiceDetails(d->uuid,
+                                          readsValues ? FullDiscovery : SkipValueDiscovery);
+}
+
+/*!
+    \since 6.5
+
+    Drops the discovery and read requests of this service which were not sent
+    to the remote device yet. The results of the requests which are already on
+    the air are discarded. A running \l discoverDetails() is aborted and the
+    service returns to the \l RemoteService state. Canceled reads neither
+    emit \l characteristicRead() nor \l descriptorRead(), their futures are
+    canceled. Write requests are not affected.
+
+    The reads of a service are canceled as well once its last
+    QLowEnergyService instance is destroyed.
+
+    Cancellation is supported by the BlueZ backends, on Android and by the
+    loopback backend. Otherwise the function does nothing.
+
+    \sa discoverDetails(), readCharacteristic(), readDescriptor()
+ */
+void QLowEnergyService::cancelPendingReads()
+{
+    Q_D(QLowEnergyService);
+    d->cancelPendingReads();
+}
+
 /*!
     Returns the last occurred error or \l NoError.
  */
@@ -651,6 +863,7 @@ void QLowEnergyService::readCharacteristic(
         return;
     }
 
+    d->controller->noteGattRequests(1);
     d->controller->readCharacteristic(characteristic.d_ptr,
                                       characteristic.attributeHandle());
 }
@@ -679,8 +892,9 @@ void QLowEnergyService::readCharacteristic(
     For example, if the same descriptor is set to the value A and immediately afterwards
     to B, the two write request are executed in the given order.
 
-    \note Currently, it is not possible to use signed or reliable writes as defined by the
-    Bluetooth specification.
+    \note Currently, it is not possible to use signed writes as defined by the
+    Bluetooth specification. Reliable writes are available through
+    \l writeCharacteristicsReliably().
 
     A characteristic can only be written if this service is in the \l ServiceDiscovered state
     and belongs to the service. If one of these conditions is
@@ -692,6 +906,11 @@ void QLowEnergyService::readCharacteristic(
     characteristic may only support \l WriteWithResponse. If the hardware returns
     with an error the \l CharacteristicWriteError is set.
 
+    \note On Linux, iOS and macOS, \l WriteWithoutResponse commands are queued
+    while the platform's transmit buffer is full and sent as soon as there is room
+    again, in the order they were issued. Commands are therefore not lost when this
+    function is called faster than the link can carry them.
+
     \b {Peripheral role}
 
     The call results in the value of the characteristic getting updated in the local database.
@@ -726,12 +945,204 @@ void QLowEnergyService::writeCharacteristic(
     }
 
     // don't write if properties don't permit it
+    d->controller->noteGattRequests(1);
     d->controller->writeCharacteristic(characteristic.d_ptr,
                                        characteristic.attributeHandle(),
                                        newValue,
                                        mode);
 }
 
+/*!
+    \since 6.5
+
+    Reads the values of all \a characteristics with as few requests as the
+    platform permits. On Linux with the ATT-socket-based BlueZ implementation
+    the values are fetched using Read Multiple Variable Length requests where
+    the peripheral supports them.
+
+    Each value is reported via \l characteristicRead() as with
+    \l readCharacteristic(). Once all of them have been read, the
+    \l characteristicsRead() signal delivers the complete result set. If one of
+    the reads fails the \l CharacteristicReadError is set and
+    \l characteristicsRead() is not emitted for any pending batch.
+
+    The same conditions as for \l readCharacteristic() apply to every
+    characteristic in the list. If one of them is not met, nothing is read and
+    the \l QLowEnergyService::OperationError is set.
+
+    \sa readCharacteristic(), characteristicsRead()
+ */
+void QLowEnergyService::readCharacteristics(
+        const QList<QLowEnergyCharacteristic> &characteristics)
+{
+    Q_D(QLowEnergyService);
+
+    if (d->controller == nullptr || state() != RemoteServiceDiscovered) {
+        d->setError(QLowEnergyService::OperationError);
+        return;
+    }
+    QList<QLowEnergyHandle> handles;
+    handles.reserve(characteristics.size());
+    for (const QLowEnergyCharacteristic &characteristic : characteristics) {
+        if (!contains(characteristic)) {
+            d->setError(QLowEnergyService::OperationError);
+            return;
+        }
+        handles.append(characteristic.attributeHandle());
+    }
+    if (handles.isEmpty())
+        return;
+
+    d->startCharacteristicBatch(&d->readBatches, characteristics);
+    d->controller->noteGattRequests(handles.size());
+    d->controller->readCharacteristics(d_ptr, handles);
+}
+
+/*!
+    \since 6.5
+
+    Writes each value of \a newValues to the characteristic at the same index
+    of \a characteristics using \a mode. Both lists must have the same length.
+
+    Each write behaves like a call to \l writeCharacteristic(), in the order of
+    the list. In the central role with \l WriteWithResponse, the
+    \l characteristicsWritten() signal is emitted once all of the writes have
+    been confirmed. If one of them fails the \l CharacteristicWriteError is set
+    and \l characteristicsWritten() is not emitted for any pending batch.
+
+    If one of the conditions of \l writeCharacteristic() is not met for any of
+    the characteristics, nothing is written and the
+    \l QLowEnergyService::OperationError is set.
+
+    \sa writeCharacteristic(), characteristicsWritten()
+ */
+void QLowEnergyService::writeCharacteristics(
+        const QList<QLowEnergyCharacteristic> &characteristics,
+        const QList<QByteArray> &newValues, QLowEnergyService::WriteMode mode)
+{
+    Q_D(QLowEnergyService);
+
+    if (d->controller == nullptr
+            || (d->controller->role == QLowEnergyController::CentralRole
+                && state() != RemoteServiceDiscovered)
+            || characteristics.size() != newValues.size()) {
+        d->setError(QLowEnergyService::OperationError);
+        return;
+    }
+    QList<QLowEnergyHandle> handles;
+    handles.reserve(characteristics.size());
+    for (const QLowEnergyCharacteristic &characteristic : characteristics) {
+        if (!contains(characteristic)) {
+            d->setError(QLowEnergyService::OperationError);
+            return;
+        }
+        handles.append(characteristic.attributeHandle());
+    }
+    if (handles.isEmpty())
+        return;
+
+    if (d->controller->role == QLowEnergyController::CentralRole && mode == WriteWithResponse)
+        d->startCharacteristicBatch(&d->writeBatches, characteristics);
+    d->controller->noteGattRequests(handles.size());
+    d->controller->writeCharacteristics(d_ptr, handles, newValues, mode);
+}
+
+/*!
+    \since 6.5
+
+    Writes each value of \a newValues to the characteristic at the same index
+    of \a characteristics as one reliable write transaction. Both lists must
+    have the same length and a characteristic may appear more than once.
+
+    All values are queued on the remote device using prepared writes and
+    committed together by a single execute request. If the remote device
+    rejects or alters any of the queued values, the whole transaction is
+    cancelled and none of the characteristics is changed. In that case the
+    \l CharacteristicWriteError is set.
+
+    On success \l characteristicWritten() is emitted for every characteristic
+    in the order of the list, followed by \l characteristicsWritten().
+
+    Reliable writes are only possible in the central role and require the
+    remote characteristics to support prepared writes, which is indicated by
+    the \l QLowEnergyCharacteristic::ExtendedProperty property together with
+    the reliable write bit of the extended properties descriptor. The
+    operation is supported by the BlueZ, WinRT and loopback backends. On other
+    platforms the \l CharacteristicWriteError is set.
+
+    If one of the conditions of \l writeCharacteristic() is not met for any of
+    the characteristics, nothing is written and the
+    \l QLowEnergyService::OperationError is set.
+
+    \sa writeCharacteristics(), characteristicsWritten()
+ */
+void QLowEnergyService::writeCharacteristicsReliably(
+        const QList<QLowEnergyCharacteristic> &characteristics,
+        const QList<QByteArray> &newValues)
+{
+    Q_D(QLowEnergyService);
+
+    if (d->controller == nullptr
+            || d->controller->role != QLowEnergyController::CentralRole
+            || state() != RemoteServiceDiscovered
+            || characteristics.size() != newValues.size()) {
+        d->setError(QLowEnergyService::OperationError);
+        return;
+    }
+    QList<QLowEnergyHandle> handles;
+    handles.reserve(characteristics.size());
+    for (const QLowEnergyCharacteristic &characteristic : characteristics) {
+        if (!contains(characteristic)) {
+            d->setError(QLowEnergyService::OperationError);
+            return;
+        }
+        handles.append(characteristic.attributeHandle());
+    }
+    if (handles.isEmpty())
+        return;
+
+    d->startCharacteristicBatch(&d->writeBatches, characteristics);
+    d->controller->noteGattRequests(handles.size());
+    d->controller->writeCharacteristicsReliably(d_ptr, handles, newValues);
+}
+
+/*!
+    \since 6.5
+
+    Updates the value of the local \a characteristic to \a value and notifies or
+    indicates it to subscribed clients, exactly like \l writeCharacteristic() does
+    in the peripheral role.
+
+    This function is meant for characteristics which are updated at a high rate,
+    such as sensor readings. On Linux with the ATT-socket-based BlueZ
+    implementation, the value is copied straight into the storage of the local
+    attribute, which is reused as long as the length of the value does not
+    change, and sent without any further intermediate copy. On other platforms
+    it is equivalent to \l writeCharacteristic().
+
+    Holding on to the QByteArray returned by \l QLowEnergyCharacteristic::value()
+    for the previous value forces a copy on the next update.
+
+    If the service is not a local service or \a characteristic does not belong to
+    it, the \l QLowEnergyService::OperationError is set.
+
+    \sa writeCharacteristic()
+ */
+void QLowEnergyService::publishCharacteristicValue(
+        const QLowEnergyCharacteristic &characteristic, QByteArrayView value)
+{
+    Q_D(QLowEnergyService);
+
+    if (d->controller == nullptr
+            || d->controller->role != QLowEnergyController::PeripheralRole
+            || !contains(characteristic)) {
+        d->setError(QLowEnergyService::OperationError);
+        return;
+    }
+
+    d->controller->publishCharacteristicValue(d_ptr, characteristic.attributeHandle(), value);
+}
+
 /*!
     Returns \c true if \a descriptor belongs to this service; otherwise \c false.
  */
@@ -781,6 +1192,7 @@ void QLowEnergyService::readDescriptor(
         return;
     }
 
+    d->controller->noteGattRequests(1);
     d->controller->readDescriptor(descriptor.d_ptr,
                                   descriptor.characteristicHandle(),
                                   descriptor.handle());
@@ -825,6 +1237,7 @@ void QLowEnergyService::writeDescriptor(const QLowEnergyDescriptor &descriptor,
         d->setError(QLowEnergyService::OperationError);
         return;
     }
+    d->controller->noteGattRequests(1);
 #ifdef Q_OS_DARWIN
     if (descriptor.uuid() == QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration) {
         // We have to identify a special case - ClientCharacteristicConfiguration
@@ -847,6 +1260,244 @@ void QLowEnergyService::writeDescriptor(const QLowEnergyDescriptor &descriptor,
                                    newValue);
 }
 
+/*!
+    \since 6.5
+
+    Reads the value of \a characteristic like \l readCharacteristic() and
+    returns a future which receives the value once the read has finished.
+
+    The future is canceled if the read fails, in addition to the
+    \l CharacteristicReadError being set, or if the service is invalidated
+    before the read finished. If one of the conditions of
+    \l readCharacteristic() is not met, the returned future is canceled right
+    away and the \l OperationError is set.
+
+    Canceling the returned future discards the result. The read request itself
+    is still sent to the device, as are the \l characteristicRead() signals.
+
+    Results are assigned to futures in the order the requests were made for
+    the same characteristic. Mixing this function with \l readCharacteristic()
+    for the same characteristic may therefore deliver the value of an earlier
+    read to the future.
+
+    \sa readCharacteristic(), writeCharacteristicAsync()
+ */
+QFuture<QByteArray> QLowEnergyService::readCharacteristicAsync(
+        const QLowEnergyCharacteristic &characteristic)
+{
+    Q_D(QLowEnergyService);
+
+    if (d->controller == nullptr || state() != RemoteServiceDiscovered || !contains(characteristic)) {
+        d->setError(QLowEnergyService::OperationError);
+        return QLowEnergyServicePrivate::canceledFuture();
+    }
+
+    QFuture<QByteArray> future = d->startAsyncRequest(
+            QLowEnergyServicePrivate::AsyncOperation::CharacteristicRead,
+            characteristic.attributeHandle());
+    d->issuingRequest = d->asyncRequests.constLast().promise;
+    readCharacteristic(characteristic);
+    d->issuingRequest.reset();
+    return future;
+}
+
+/*!
+    \since 6.5
+
+    Writes \a newValue to \a characteristic using \a mode like
+    \l writeCharacteristic() and returns a future which receives the written
+    value once the write has been confirmed.
+
+    Writes in the \l WriteWithoutResponse and \l WriteSigned modes and writes
+    in the peripheral role are never confirmed; their future finishes as soon
+    as the value was passed to the controller.
+
+    The same rules as for \l readCharacteristicAsync() apply to failures and
+    cancellation, failed writes set the \l CharacteristicWriteError.
+
+    \sa writeCharacteristic(), readCharacteristicAsync()
+ */
+QFuture<QByteArray> QLowEnergyService::writeCharacteristicAsync(
+        const QLowEnergyCharacteristic &characteristic, const QByteArray &newValue,
+        QLowEnergyService::WriteMode mode)
+{
+    Q_D(QLowEnergyService);
+
+    if (d->controller == nullptr
+            || (d->controller->role == QLowEnergyController::CentralRole
+                && state() != RemoteServiceDiscovered)
+            || !contains(characteristic)) {
+        d->setError(QLowEnergyService::OperationError);
+        return QLowEnergyServicePrivate::canceledFuture();
+    }
+
+    QFuture<QByteArray> future = d->startAsyncRequest(
+            QLowEnergyServicePrivate::AsyncOperation::CharacteristicWrite,
+            characteristic.attributeHandle());
+    const auto promise = d->asyncRequests.constLast().promise;
+    d->issuingRequest = promise;
+    writeCharacteristic(characteristic, newValue, mode);
+    d->issuingRequest.reset();
+
+    // unconfirmed writes are done once the controller took them
+    if (d->controller && (d->controller->role != QLowEnergyController::CentralRole
+                          || mode != WriteWithResponse)) {
+        d->completeAsyncRequest(promise, newValue);
+    }
+    return future;
+}
+
+/*!
+    \since 6.5
+
+    Reads the value of \a descriptor like \l readDescriptor() and returns a
+    future which receives the value once the read has finished.
+
+    The same rules as for \l readCharacteristicAsync() apply to failures and
+    cancellation, failed reads set the \l DescriptorReadError.
+
+    \sa readDescriptor(), writeDescriptorAsync()
+ */
+QFuture<QByteArray> QLowEnergyService::readDescriptorAsync(const QLowEnergyDescriptor &descriptor)
+{
+    Q_D(QLowEnergyService);
+
+    if (d->controller == nullptr || state() != RemoteServiceDiscovered || !contains(descriptor)) {
+        d->setError(QLowEnergyService::OperationError);
+        return QLowEnergyServicePrivate::canceledFuture();
+    }
+
+    QFuture<QByteArray> future = d->startAsyncRequest(
+            QLowEnergyServicePrivate::AsyncOperation::DescriptorRead, descriptor.handle());
+    d->issuingRequest = d->asyncRequests.constLast().promise;
+    readDescriptor(descriptor);
+    d->issuingRequest.reset();
+    return future;
+}
+
+/*!
+    \since 6.5
+
+    Writes \a newValue to \a descriptor like \l writeDescriptor() and returns
+    a future which receives the written value once the write has been
+    confirmed. In the peripheral role the future finishes as soon as the value
+    was passed to the controller.
+
+    The same rules as for \l readCharacteristicAsync() apply to failures and
+    cancellation, failed writes set the \l DescriptorWriteError.
+
+    \sa writeDescriptor(), readDescriptorAsync()
+ */
+QFuture<QByteArray> QLowEnergyService::writeDescriptorAsync(const QLowEnergyDescriptor &descriptor,
+                                                            const QByteArray &newValue)
+{
+    Q_D(QLowEnergyService);
+
+    if (d->controller == nullptr
+            || (d->controller->role == QLowEnergyController::CentralRole
+                && state() != RemoteServiceDiscovered)
+            || !contains(descriptor)) {
+        d->setError(QLowEnergyService::OperationError);
+        return QLowEnergyServicePrivate::canceledFuture();
+    }
+
+    QFuture<QByteArray> future = d->startAsyncRequest(
+            QLowEnergyServicePrivate::AsyncOperation::DescriptorWrite, descriptor.handle());
+    const auto promise = d->asyncRequests.constLast().promise;
+    d->issuingRequest = promise;
+    writeDescriptor(descriptor, newValue);
+    d->issuingRequest.reset();
+
+    if (d->controller && d->controller->role != QLowEnergyController::CentralRole)
+        d->completeAsyncRequest(promise, newValue);
+    return future;
+}
+
+/*!
+    \since 6.5
+
+    Enables batched delivery of characteristic change notifications.
+
+    By default (\a msecs set to \c -1) every change notification or indication
+    received from the peripheral (or every write by a remote GATT client in the
+    peripheral role) is reported individually via \l characteristicChanged().
+    Devices which stream data at a high rate may cause a large number of
+    signal emissions that way.
+
+    If \a msecs is \c 0 or larger, changes are collected and reported via a
+    single \l characteristicsChanged() emission once \a msecs milliseconds
+    have elapsed since the first change of the batch. An interval of \c 0
+    delivers all changes that arrived before control returned to the event
+    loop. While batching is enabled \l characteristicChanged() is not emitted.
+
+    Disabling batching again delivers any pending changes immediately.
+
+    The setting is shared between all service objects referring to the same
+    service.
+
+    \sa notificationBatchInterval(), characteristicsChanged()
+ */
+void QLowEnergyService::setNotificationBatchInterval(int msecs)
+{
+    Q_D(QLowEnergyService);
+    d->setNotificationBatchInterval(msecs);
+}
+
+/*!
+    \since 6.5
+
+    Returns the notification batch interval in milliseconds, or \c -1 if
+    batching is disabled.
+
+    \sa setNotificationBatchInterval()
+ */
+int QLowEnergyService::notificationBatchInterval() const
+{
+    return d_ptr->notificationBatchInterval;
+}
+
+/*!
+    \since 6.5
+
+    Sets whether values received via change notifications or indications are
+    stored by the service to \a enabled.
+
+    By default every notified value of a readable characteristic replaces the
+    value returned by \l QLowEnergyCharacteristic::value(). Applications which
+    stream data through notifications and only consume the values passed to
+    \l characteristicChanged() or \l characteristicsChanged() can disable the
+    caching to avoid keeping a copy of every value.
+
+    While caching is disabled, a notification discards the stored value of the
+    characteristic and \l QLowEnergyCharacteristic::value() returns an empty
+    byte array until the characteristic is read or written again. Values
+    obtained via \l readCharacteristic() and \l writeCharacteristic() are
+    always stored.
+
+    The setting is shared between all service objects referring to the same
+    service.
+
+    \sa isNotifiedValueCachingEnabled()
+ */
+void QLowEnergyService::setNotifiedValueCachingEnabled(bool enabled)
+{
+    Q_D(QLowEnergyService);
+    d->notifiedValueCaching = enabled;
+}
+
+/*!
+    \since 6.5
+
+    Returns \c true if values received via change notifications or indications
+    are stored by the service; otherwise returns \c false. The default is \c true.
+
+    \sa setNotifiedValueCachingEnabled()
+ */
+bool QLowEnergyService::isNotifiedValueCachingEnabled() const
+{
+    return d_ptr->notifiedValueCaching;
+}
+
 QT_END_NAMESPACE
 
 #include "moc_qlowenergyservice.cpp"
@@ -8,6 +8,8 @@
 #include <QtBluetooth/QBluetoothUuid>
 #include <QtBluetooth/QLowEnergyCharacteristic>
 
+#include <QtCore/qfuture.h>
+
 QT_BEGIN_NAMESPACE
 
 class QLowEnergyServicePrivate;
@@ -60,10 +62,19 @@ public:
 
     enum DiscoveryMode {
         FullDiscovery,      // standard, reads all attributes
-        SkipValueDiscovery  // does not read characteristic values and descriptors
+        SkipValueDiscovery, // does not read characteristic values and descriptors
+        IncrementalDiscovery // reads the values after the service was discovered
     };
     Q_ENUM(DiscoveryMode)
 
+    enum DiscoveryTarget {
+        DescriptorDiscovery = 0x0001,
+        CharacteristicValueDiscovery = 0x0002,
+        DescriptorValueDiscovery = 0x0004
+    };
+    Q_ENUM(DiscoveryTarget)
+    Q_DECLARE_FLAGS(DiscoveryTargets, DiscoveryTarget)
+
     enum WriteMode {
         WriteWithResponse = 0,
         WriteWithoutResponse,
@@ -84,6 +95,9 @@ public:
     QString serviceName() const;
 
     void discoverDetails(DiscoveryMode mode = FullDiscovery);
+    void discoverDetails(DiscoveryTargets targets,
+                         const QList<QBluetoothUuid> &characteristicUuids = {});
+    void cancelPendingReads();
 
     ServiceError error() const;
 
@@ -92,20 +106,49 @@ public:
     void writeCharacteristic(const QLowEnergyCharacteristic &characteristic,
                              const QByteArray &newValue,
                              WriteMode mode = WriteWithResponse);
+    void readCharacteristics(const QList<QLowEnergyCharacteristic> &characteristics);
+    void writeCharacteristics(const QList<QLowEnergyCharacteristic> &characteristics,
+                              const QList<QByteArray> &newValues,
+                              WriteMode mode = WriteWithResponse);
+    void writeCharacteristicsReliably(const QList<QLowEnergyCharacteristic> &characteristics,
+                                      const QList<QByteArray> &newValues);
+    void publishCharacteristicValue(const QLowEnergyCharacteristic &characteristic,
+                                    QByteArrayView value);
 
     bool contains(const QLowEnergyDescriptor &descriptor) const;
     void readDescriptor(const QLowEnergyDescriptor &descriptor);
     void writeDescriptor(const QLowEnergyDescriptor &descriptor,
                          const QByteArray &newValue);
 
+    QFuture<QByteArray> readCharacteristicAsync(const QLowEnergyCharacteristic &characteristic);
+    QFuture<QByteArray> writeCharacteristicAsync(const QLowEnergyCharacteristic &characteristic,
+                                                 const QByteArray &newValue,
+                                                 WriteMode mode = WriteWithResponse);
+    QFuture<QByteArray> readDescriptorAsync(const QLowEnergyDescriptor &descriptor);
+    QFuture<QByteArray> writeDescriptorAsync(const QLowEnergyDescriptor &descriptor,
+                                             const QByteArray &newValue);
+
+    void setNotificationBatchInterval(int msecs);
+    int notificationBatchInterval() const;
+    void setNotifiedValueCachingEnabled(bool enabled);
+    bool isNotifiedValueCachingEnabled() const;
+
 Q_SIGNALS:
     void stateChanged(QLowEnergyService::ServiceState newState);
     void characteristicChanged(const QLowEnergyCharacteristic &info,
                                const QByteArray &value);
+    void characteristicsChanged(const QList<QLowEnergyCharacteristic> &characteristics,
+                                const QList<QByteArray> &values);
     void characteristicRead(const QLowEnergyCharacteristic &info,
                             const QByteArray &value);
+    void characteristicReadProgress(const QLowEnergyCharacteristic &info,
+                                    qsizetype bytesRead);
     void characteristicWritten(const QLowEnergyCharacteristic &info,
                                const QByteArray &value);
+    void characteristicsRead(const QList<QLowEnergyCharacteristic> &characteristics,
+                             const QList<QByteArray> &values);
+    void characteristicsWritten(const QList<QLowEnergyCharacteristic> &characteristics,
+                                const QList<QByteArray> &values);
     void descriptorRead(const QLowEnergyDescriptor &info,
                         const QByteArray &value);
     void descriptorWritten(const QLowEnergyDescriptor &info,
@@ -127,6 +170,7 @@ private:
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(QLowEnergyService::ServiceTypes)
+Q_DECLARE_OPERATORS_FOR_FLAGS(QLowEnergyService::DiscoveryTargets)
 
 QT_END_NAMESPACE
 
@@ -54,6 +54,14 @@ QLowEnergyServiceData::QLowEnergyServiceData(const QLowEnergyServiceData &other)
 {
 }
 
+/*!
+    \fn QLowEnergyServiceData::QLowEnergyServiceData(QLowEnergyServiceData &&other)
+    \since 6.5
+
+    Move-constructs a new object from \a other. The moved-from object can only
+    be assigned to or destroyed.
+*/
+
 /*! Destroys this object. */
 QLowEnergyServiceData::~QLowEnergyServiceData()
 {
@@ -66,6 +74,13 @@ QLowEnergyServiceData &QLowEnergyServiceData::operator=(const QLowEnergyServiceD
     return *this;
 }
 
+/*!
+    \fn QLowEnergyServiceData &QLowEnergyServiceData::operator=(QLowEnergyServiceData &&other)
+    \since 6.5
+
+    Move-assigns \a other to this object and returns a reference to this object.
+*/
+
 /*! Returns the type of this service. */
 QLowEnergyServiceData::ServiceType QLowEnergyServiceData::type() const
 {
@@ -133,9 +148,25 @@ QList<QLowEnergyCharacteristicData> QLowEnergyServiceData::characteristics() con
  */
 void QLowEnergyServiceData::setCharacteristics(const QList<QLowEnergyCharacteristicData> &characteristics)
 {
-    d->characteristics.clear();
-    for (const QLowEnergyCharacteristicData &cd : characteristics)
-        addCharacteristic(cd);
+    setCharacteristics(QList<QLowEnergyCharacteristicData>(characteristics));
+}
+
+/*!
+  \overload
+  \since 6.5
+
+  Moves \a characteristics into this object. If all of them are valid, the
+  list is taken over without copying its elements.
+ */
+void QLowEnergyServiceData::setCharacteristics(QList<QLowEnergyCharacteristicData> &&characteristics)
+{
+    d->characteristics = std::move(characteristics);
+    d->characteristics.removeIf([](const QLowEnergyCharacteristicData &cd) {
+        if (cd.isValid())
+            return false;
+        qCWarning(QT_BT) << "not adding invalid characteristic to service";
+        return true;
+    });
 }
 
 /*!
@@ -150,6 +181,20 @@ void QLowEnergyServiceData::addCharacteristic(const QLowEnergyCharacteristicData
         qCWarning(QT_BT) << "not adding invalid characteristic to service";
 }
 
+/*!
+  \overload
+  \since 6.5
+
+  Moves \a characteristic into the list of characteristics, if it is valid.
+ */
+void QLowEnergyServiceData::addCharacteristic(QLowEnergyCharacteristicData &&characteristic)
+{
+    if (characteristic.isValid())
+        d->characteristics.append(std::move(characteristic));
+    else
+        qCWarning(QT_BT) << "not adding invalid characteristic to service";
+}
+
 /*! Returns \c true if this service is has a non-null UUID. */
 bool QLowEnergyServiceData::isValid() const
 {
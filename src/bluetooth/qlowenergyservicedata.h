@@ -19,9 +19,11 @@ class Q_BLUETOOTH_EXPORT QLowEnergyServiceData
 public:
     QLowEnergyServiceData();
     QLowEnergyServiceData(const QLowEnergyServiceData &other);
+    QLowEnergyServiceData(QLowEnergyServiceData &&other) noexcept = default;
     ~QLowEnergyServiceData();
 
     QLowEnergyServiceData &operator=(const QLowEnergyServiceData &other);
+    QT_MOVE_ASSIGNMENT_OPERATOR_IMPL_VIA_PURE_SWAP(QLowEnergyServiceData)
     friend bool operator==(const QLowEnergyServiceData &a, const QLowEnergyServiceData &b)
     {
         return equals(a, b);
@@ -44,7 +46,9 @@ public:
 
     QList<QLowEnergyCharacteristicData> characteristics() const;
     void setCharacteristics(const QList<QLowEnergyCharacteristicData> &characteristics);
+    void setCharacteristics(QList<QLowEnergyCharacteristicData> &&characteristics);
     void addCharacteristic(const QLowEnergyCharacteristicData &characteristic);
+    void addCharacteristic(QLowEnergyCharacteristicData &&characteristic);
 
     bool isValid() const;
 
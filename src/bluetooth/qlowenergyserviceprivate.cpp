@@ -3,6 +3,7 @@
 
 #include "qlowenergyserviceprivate_p.h"
 
+#include "qbluetoothmemoryusage_p.h"
 #include "qlowenergycontrollerbase_p.h"
 
 QT_BEGIN_NAMESPACE
@@ -10,10 +11,39 @@ QT_BEGIN_NAMESPACE
 QT_IMPL_METATYPE_EXTERN_TAGGED(QSharedPointer<QLowEnergyServicePrivate>,
                                QSharedPointer_QLowEnergyServicePrivate)
 
-QLowEnergyServicePrivate::QLowEnergyServicePrivate(QObject *parent) : QObject(parent) { }
+QLowEnergyServicePrivate::QLowEnergyServicePrivate(QObject *parent) : QObject(parent)
+{
+    connect(this, &QLowEnergyServicePrivate::characteristicRead,
+            this, [this](const QLowEnergyCharacteristic &characteristic, const QByteArray &value) {
+        completeBatchedCharacteristic(&readBatches, true, characteristic, value);
+    });
+    connect(this, &QLowEnergyServicePrivate::characteristicWritten,
+            this, [this](const QLowEnergyCharacteristic &characteristic, const QByteArray &value) {
+        completeBatchedCharacteristic(&writeBatches, false, characteristic, value);
+    });
+    connect(this, &QLowEnergyServicePrivate::characteristicRead,
+            this, [this](const QLowEnergyCharacteristic &characteristic, const QByteArray &value) {
+        completeAsyncRequest(AsyncOperation::CharacteristicRead,
+                             characteristic.attributeHandle(), value);
+    });
+    connect(this, &QLowEnergyServicePrivate::characteristicWritten,
+            this, [this](const QLowEnergyCharacteristic &characteristic, const QByteArray &value) {
+        completeAsyncRequest(AsyncOperation::CharacteristicWrite,
+                             characteristic.attributeHandle(), value);
+    });
+    connect(this, &QLowEnergyServicePrivate::descriptorRead,
+            this, [this](const QLowEnergyDescriptor &descriptor, const QByteArray &value) {
+        completeAsyncRequest(AsyncOperation::DescriptorRead, descriptor.handle(), value);
+    });
+    connect(this, &QLowEnergyServicePrivate::descriptorWritten,
+            this, [this](const QLowEnergyDescriptor &descriptor, const QByteArray &value) {
+        completeAsyncRequest(AsyncOperation::DescriptorWrite, descriptor.handle(), value);
+    });
+}
 
 QLowEnergyServicePrivate::~QLowEnergyServicePrivate()
 {
+    failAllAsyncRequests();
 }
 
 void QLowEnergyServicePrivate::setController(QLowEnergyControllerPrivate *control)
@@ -29,6 +59,30 @@ void QLowEnergyServicePrivate::setController(QLowEnergyControllerPrivate *contro
 void QLowEnergyServicePrivate::setError(QLowEnergyService::ServiceError newError)
 {
     lastError = newError;
+
+    // The failing characteristic is unknown, none of the pending batches can complete.
+    if (newError == QLowEnergyService::CharacteristicReadError)
+        readBatches.clear();
+    else if (newError == QLowEnergyService::CharacteristicWriteError)
+        writeBatches.clear();
+
+    switch (newError) {
+    case QLowEnergyService::CharacteristicReadError:
+        failAsyncRequest(AsyncOperation::CharacteristicRead);
+        break;
+    case QLowEnergyService::CharacteristicWriteError:
+        failAsyncRequest(AsyncOperation::CharacteristicWrite);
+        break;
+    case QLowEnergyService::DescriptorReadError:
+        failAsyncRequest(AsyncOperation::DescriptorRead);
+        break;
+    case QLowEnergyService::DescriptorWriteError:
+        failAsyncRequest(AsyncOperation::DescriptorWrite);
+        break;
+    default:
+        break;
+    }
+
     emit errorOccurred(newError);
 }
 
@@ -38,9 +92,329 @@ void QLowEnergyServicePrivate::setState(QLowEnergyService::ServiceState newState
         return;
 
     state = newState;
+    characteristicUuidIndex.clear();
+    if (newState != QLowEnergyService::RemoteServiceDiscovered) {
+        readBatches.clear();
+        writeBatches.clear();
+        failAllAsyncRequests();
+    }
     emit stateChanged(newState);
 }
 
+/*!
+    \internal
+
+    Returns the handle of the characteristic with \a uuid, or \c 0 if there
+    is none. If several characteristics share the uuid, the one with the
+    lowest handle is returned.
+
+    The characteristic list only changes while the service details are being
+    discovered, which is why the index is only used in the discovered states.
+ */
+QLowEnergyHandle QLowEnergyServicePrivate::characteristicHandle(const QBluetoothUuid &uuid) const
+{
+    const auto findLinear = [this](const QBluetoothUuid &uuid) {
+        QLowEnergyHandle found = 0;
+        for (auto it = characteristicList.cbegin(); it != characteristicList.cend(); ++it) {
+            if (it.value().uuid == uuid && (!found || it.key() < found))
+                found = it.key();
+        }
+        return found;
+    };
+
+    if (state != QLowEnergyService::RemoteServiceDiscovered
+            && state != QLowEnergyService::LocalService) {
+        return findLinear(uuid);
+    }
+
+    if (characteristicUuidIndex.isEmpty() && !characteristicList.isEmpty()) {
+        characteristicUuidIndex.reserve(characteristicList.size());
+        for (auto it = characteristicList.cbegin(); it != characteristicList.cend(); ++it) {
+            QLowEnergyHandle &handle = characteristicUuidIndex[it.value().uuid];
+            if (!handle || it.key() < handle)
+                handle = it.key();
+        }
+    }
+
+    return characteristicUuidIndex.value(uuid);
+}
+
+void QLowEnergyServicePrivate::setNotificationBatchInterval(int msecs)
+{
+    if (msecs < 0)
+        msecs = -1;
+    if (notificationBatchInterval == msecs)
+        return;
+
+    notificationBatchInterval = msecs;
+    if (msecs < 0) {
+        // pending values must not be lost when batching gets switched off
+        if (notificationBatchTimer)
+            notificationBatchTimer->stop();
+        flushNotificationBatch();
+        return;
+    }
+
+    if (notificationBatchTimer)
+        notificationBatchTimer->setInterval(msecs);
+}
+
+/*!
+    \internal
+
+    Reports a changed characteristic value to the service objects. Unless
+    batching is enabled via setNotificationBatchInterval() this emits
+    characteristicChanged() directly. Otherwise the value is queued and
+    delivered together with all other changes of the current batch window
+    via characteristicsChanged().
+ */
+void QLowEnergyServicePrivate::notifyCharacteristicChanged(
+        const QLowEnergyCharacteristic &characteristic, const QByteArray &newValue)
+{
+    if (notificationBatchInterval < 0) {
+        emit characteristicChanged(characteristic, newValue);
+        return;
+    }
+
+    batchedCharacteristics.append(characteristic);
+    batchedValues.append(newValue);
+
+    if (!notificationBatchTimer) {
+        notificationBatchTimer = new QTimer(this);
+        notificationBatchTimer->setSingleShot(true);
+        connect(notificationBatchTimer, &QTimer::timeout,
+                this, &QLowEnergyServicePrivate::flushNotificationBatch);
+    }
+    if (!notificationBatchTimer->isActive())
+        notificationBatchTimer->start(notificationBatchInterval);
+}
+
+void QLowEnergyServicePrivate::flushNotificationBatch()
+{
+    if (batchedCharacteristics.isEmpty())
+        return;
+
+    const QList<QLowEnergyCharacteristic> characteristics = std::exchange(batchedCharacteristics, {});
+    const QList<QByteArray> values = std::exchange(batchedValues, {});
+    emit characteristicsChanged(characteristics, values);
+}
+
+void QLowEnergyServicePrivate::startCharacteristicBatch(
+        QList<CharacteristicBatch> *batches, const QList<QLowEnergyCharacteristic> &characteristics)
+{
+    CharacteristicBatch batch;
+    batch.characteristics = characteristics;
+    batch.values.resize(characteristics.size());
+    batch.completed.resize(characteristics.size(), false);
+    batch.remaining = characteristics.size();
+    batches->append(std::move(batch));
+}
+
+/*!
+    \internal
+
+    Records the result of a single read or write for the oldest batch which
+    still waits for \a characteristic. A batch is reported once all of its
+    characteristics are done, after the individual characteristicRead() or
+    characteristicWritten() emissions.
+ */
+void QLowEnergyServicePrivate::completeBatchedCharacteristic(
+        QList<CharacteristicBatch> *batches, bool isRead,
+        const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
+{
+    const QLowEnergyHandle handle = characteristic.attributeHandle();
+    for (qsizetype i = 0; i < batches->size(); ++i) {
+        CharacteristicBatch &batch = (*batches)[i];
+        qsizetype index = 0;
+        for (; index < batch.characteristics.size(); ++index) {
+            if (!batch.completed.at(index)
+                    && batch.characteristics.at(index).attributeHandle() == handle) {
+                break;
+            }
+        }
+        if (index == batch.characteristics.size())
+            continue;
+
+        batch.values[index] = value;
+        batch.completed[index] = true;
+        if (--batch.remaining > 0)
+            return;
+
+        const CharacteristicBatch done = batches->takeAt(i);
+        QMetaObject::invokeMethod(this, [this, isRead, done]() {
+            if (isRead)
+                emit characteristicsRead(done.characteristics, done.values);
+            else
+                emit characteristicsWritten(done.characteristics, done.values);
+        }, Qt::QueuedConnection);
+        return;
+    }
+}
+
+static void finishPromise(QPromise<QByteArray> *promise, const QByteArray *value)
+{
+    if (value && !promise->isCanceled())
+        promise->addResult(*value);
+    else
+        promise->future().cancel();
+    promise->finish();
+}
+
+/*!
+    \internal
+
+    Returns a future which is already canceled, for requests rejected before
+    they reached the controller.
+ */
+QFuture<QByteArray> QLowEnergyServicePrivate::canceledFuture()
+{
+    QPromise<QByteArray> promise;
+    QFuture<QByteArray> future = promise.future();
+    promise.start();
+    finishPromise(&promise, nullptr);
+    return future;
+}
+
+/*!
+    \internal
+
+    Registers an asynchronous \a operation on the characteristic or descriptor
+    \a handle. The request is completed by the first matching completion
+    signal, all operations of a device are processed in order.
+ */
+QFuture<QByteArray> QLowEnergyServicePrivate::startAsyncRequest(AsyncOperation operation,
+                                                                QLowEnergyHandle handle)
+{
+    auto promise = std::make_shared<QPromise<QByteArray>>();
+    QFuture<QByteArray> future = promise->future();
+    promise->start();
+    asyncRequests.append(AsyncRequest{ operation, handle, promise });
+    return future;
+}
+
+void QLowEnergyServicePrivate::completeAsyncRequest(AsyncOperation operation,
+                                                    QLowEnergyHandle handle,
+                                                    const QByteArray &value)
+{
+    for (qsizetype i = 0; i < asyncRequests.size(); ++i) {
+        const AsyncRequest &request = asyncRequests.at(i);
+        if (request.operation == operation && request.handle == handle) {
+            // a canceled future keeps its place, the operation itself still runs
+            const AsyncRequest done = asyncRequests.takeAt(i);
+            finishPromise(done.promise.get(), &value);
+            return;
+        }
+    }
+}
+
+// Completes a request which is not confirmed by any signal, unless it failed already.
+void QLowEnergyServicePrivate::completeAsyncRequest(
+        const std::shared_ptr<QPromise<QByteArray>> &promise, const QByteArray &value)
+{
+    for (qsizetype i = 0; i < asyncRequests.size(); ++i) {
+        if (asyncRequests.at(i).promise == promise) {
+            const AsyncRequest done = asyncRequests.takeAt(i);
+            finishPromise(done.promise.get(), &value);
+            return;
+        }
+    }
+}
+
+/*!
+    \internal
+
+    Fails the request an error of \a operation belongs to. The error signals
+    do not name the attribute, which is why the oldest pending request of the
+    same kind is failed, unless the error was raised while a request was
+    handed to the controller.
+ */
+void QLowEnergyServicePrivate::failAsyncRequest(AsyncOperation operation)
+{
+    qsizetype index = -1;
+    for (qsizetype i = 0; i < asyncRequests.size(); ++i) {
+        const AsyncRequest &request = asyncRequests.at(i);
+        if (request.operation != operation)
+            continue;
+        if (request.promise == issuingRequest) {
+            index = i;
+            break;
+        }
+        if (index < 0)
+            index = i;
+    }
+    if (index < 0)
+        return;
+
+    const AsyncRequest failed = asyncRequests.takeAt(index);
+    finishPromise(failed.promise.get(), nullptr);
+}
+
+void QLowEnergyServicePrivate::failAllAsyncRequests()
+{
+    const QList<AsyncRequest> requests = std::exchange(asyncRequests, {});
+    for (const AsyncRequest &request : requests)
+        finishPromise(request.promise.get(), nullptr);
+}
+
+/*!
+    \internal
+
+    Lets the controller drop the queued discovery and read requests of this
+    service and forgets about the reads which are still pending.
+ */
+void QLowEnergyServicePrivate::cancelPendingReads()
+{
+    if (!controller || state == QLowEnergyService::InvalidService
+            || !controller->cancelRequests(this)) {
+        return;
+    }
+
+    if (state == QLowEnergyService::RemoteServiceDiscovering) {
+        // the next discovery starts from scratch, the batches and futures go with the state
+        characteristicList.clear();
+        setState(QLowEnergyService::RemoteService);
+        return;
+    }
+
+    readBatches.clear();
+    QList<AsyncRequest> canceled;
+    for (qsizetype i = 0; i < asyncRequests.size();) {
+        const AsyncOperation operation = asyncRequests.at(i).operation;
+        if (operation == AsyncOperation::CharacteristicRead
+                || operation == AsyncOperation::DescriptorRead) {
+            canceled.append(asyncRequests.takeAt(i));
+        } else {
+            ++i;
+        }
+    }
+    for (const AsyncRequest &request : std::as_const(canceled))
+        finishPromise(request.promise.get(), nullptr);
+}
+
+qsizetype QLowEnergyServicePrivate::memoryUsage(const CharData &data)
+{
+    using namespace QBluetoothMemory;
+
+    return bytes(data.value) + bytes(data.descriptorList, [](const DescData &descriptor) {
+               return bytes(descriptor.value);
+           });
+}
+
+qsizetype QLowEnergyServicePrivate::memoryUsage() const
+{
+    using namespace QBluetoothMemory;
+
+    const auto charBytes = [](const CharData &data) { return memoryUsage(data); };
+    const auto batchBytes = [](const CharacteristicBatch &batch) {
+        return bytes(batch.characteristics) + bytes(batch.values) + bytes(batch.completed);
+    };
+    return qsizetype(sizeof(QLowEnergyServicePrivate)) + bytes(includedServices)
+            + bytes(discoveryFilter) + bytes(characteristicList, charBytes)
+            + bytes(characteristicUuidIndex) + bytes(batchedCharacteristics)
+            + bytes(batchedValues) + bytes(readBatches, batchBytes)
+            + bytes(writeBatches, batchBytes) + bytes(asyncRequests);
+}
+
 QT_END_NAMESPACE
 
 #include "moc_qlowenergyserviceprivate_p.cpp"
@@ -15,8 +15,12 @@
 // We mean it.
 //
 
+#include <QtCore/QAtomicInt>
+#include <QtCore/QFuture>
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
+#include <QtCore/QPromise>
+#include <QtCore/QTimer>
 #include <QtBluetooth/qbluetooth.h>
 #include <QtBluetooth/QLowEnergyService>
 #include <QtBluetooth/QLowEnergyCharacteristic>
@@ -26,6 +30,8 @@
 #include <QtCore/QJniObject>
 #endif
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
 class QLowEnergyControllerPrivate;
@@ -61,19 +67,94 @@ public:
     void setError(QLowEnergyService::ServiceError newError);
     void setState(QLowEnergyService::ServiceState newState);
 
+    QLowEnergyHandle characteristicHandle(const QBluetoothUuid &uuid) const;
+
+    static bool isDiscoveryTarget(QLowEnergyService::DiscoveryTargets targets,
+                                  const QList<QBluetoothUuid> &filter,
+                                  const QBluetoothUuid &characteristicUuid,
+                                  QLowEnergyService::DiscoveryTarget target)
+    {
+        return targets.testFlag(target) && (filter.isEmpty() || filter.contains(characteristicUuid));
+    }
+    bool isDiscoveryTarget(const QBluetoothUuid &characteristicUuid,
+                           QLowEnergyService::DiscoveryTarget target) const
+    {
+        return isDiscoveryTarget(discoveryTargets, discoveryFilter, characteristicUuid, target);
+    }
+    // whether the discovery fetches the descriptors of all characteristics
+    bool discoversAllDescriptors() const
+    {
+        return discoveryTargets.testFlag(QLowEnergyService::DescriptorDiscovery)
+                && discoveryFilter.isEmpty();
+    }
+
+    void setNotificationBatchInterval(int msecs);
+    void notifyCharacteristicChanged(const QLowEnergyCharacteristic &characteristic,
+                                     const QByteArray &newValue);
+    void flushNotificationBatch();
+
+    // Operations started by readCharacteristics() and writeCharacteristics()
+    struct CharacteristicBatch {
+        QList<QLowEnergyCharacteristic> characteristics;
+        QList<QByteArray> values;
+        QList<bool> completed;
+        qsizetype remaining = 0;
+    };
+    void startCharacteristicBatch(QList<CharacteristicBatch> *batches,
+                                  const QList<QLowEnergyCharacteristic> &characteristics);
+    void completeBatchedCharacteristic(QList<CharacteristicBatch> *batches, bool isRead,
+                                       const QLowEnergyCharacteristic &characteristic,
+                                       const QByteArray &value);
+
+    // Operations started by the QFuture based functions of QLowEnergyService
+    enum class AsyncOperation {
+        CharacteristicRead,
+        CharacteristicWrite,
+        DescriptorRead,
+        DescriptorWrite
+    };
+    struct AsyncRequest {
+        AsyncOperation operation;
+        QLowEnergyHandle handle;
+        std::shared_ptr<QPromise<QByteArray>> promise;
+    };
+    static QFuture<QByteArray> canceledFuture();
+    QFuture<QByteArray> startAsyncRequest(AsyncOperation operation, QLowEnergyHandle handle);
+    void completeAsyncRequest(AsyncOperation operation, QLowEnergyHandle handle,
+                              const QByteArray &value);
+    void completeAsyncRequest(const std::shared_ptr<QPromise<QByteArray>> &promise,
+                              const QByteArray &value);
+    void failAsyncRequest(AsyncOperation operation);
+    void failAllAsyncRequests();
+
+    void cancelPendingReads();
+
+    // approximate heap size of the GATT data, batches and requests of this service
+    qsizetype memoryUsage() const;
+    // the value and the descriptors of a characteristic
+    static qsizetype memoryUsage(const CharData &data);
+
 signals:
     void stateChanged(QLowEnergyService::ServiceState newState);
     void errorOccurred(QLowEnergyService::ServiceError error);
     void characteristicChanged(const QLowEnergyCharacteristic &characteristic,
                                const QByteArray &newValue);
+    void characteristicsChanged(const QList<QLowEnergyCharacteristic> &characteristics,
+                                const QList<QByteArray> &newValues);
     void characteristicRead(const QLowEnergyCharacteristic &info,
                             const QByteArray &value);
+    void characteristicReadProgress(const QLowEnergyCharacteristic &info,
+                                    qsizetype bytesRead);
     void characteristicWritten(const QLowEnergyCharacteristic &characteristic,
                                const QByteArray &newValue);
     void descriptorRead(const QLowEnergyDescriptor &info,
                         const QByteArray &value);
     void descriptorWritten(const QLowEnergyDescriptor &descriptor,
                            const QByteArray &newValue);
+    void characteristicsRead(const QList<QLowEnergyCharacteristic> &characteristics,
+                             const QList<QByteArray> &values);
+    void characteristicsWritten(const QList<QLowEnergyCharacteristic> &characteristics,
+                                const QList<QByteArray> &newValues);
 
 public:
     QLowEnergyHandle startHandle = 0;
@@ -85,10 +166,41 @@ public:
     QLowEnergyService::ServiceState state = QLowEnergyService::InvalidService;
     QLowEnergyService::ServiceError lastError = QLowEnergyService::NoError;
     QLowEnergyService::DiscoveryMode mode = QLowEnergyService::FullDiscovery;
+    // what discoverDetails() fetches in addition to the characteristic declarations
+    QLowEnergyService::DiscoveryTargets discoveryTargets =
+            QLowEnergyService::DescriptorDiscovery
+            | QLowEnergyService::CharacteristicValueDiscovery
+            | QLowEnergyService::DescriptorValueDiscovery;
+    // characteristics whose descriptors and values are fetched, empty means all
+    QList<QBluetoothUuid> discoveryFilter;
 
     QHash<QLowEnergyHandle, CharData> characteristicList;
+    // lowest handle per characteristic uuid, built on demand once the
+    // characteristics are known and dropped whenever the state changes
+    mutable QHash<QBluetoothUuid, QLowEnergyHandle> characteristicUuidIndex;
 
     QPointer<QLowEnergyControllerPrivate> controller;
+    // QLowEnergyService instances sharing this object
+    QAtomicInt serviceObjects;
+
+    // -1 disables batching, 0 batches per event loop iteration
+    int notificationBatchInterval = -1;
+    QTimer *notificationBatchTimer = nullptr;
+    QList<QLowEnergyCharacteristic> batchedCharacteristics;
+    QList<QByteArray> batchedValues;
+
+    // whether notified values are stored in characteristicList
+    bool notifiedValueCaching = true;
+
+    // in the order they were started
+    QList<CharacteristicBatch> readBatches;
+    QList<CharacteristicBatch> writeBatches;
+
+    // in the order they were started
+    QList<AsyncRequest> asyncRequests;
+    // the request whose operation is being handed to the controller, errors
+    // reported synchronously by the controller belong to it
+    std::shared_ptr<QPromise<QByteArray>> issuingRequest;
 
 #if defined(QT_ANDROID_BLUETOOTH)
     // reference to the BluetoothGattService object
@@ -0,0 +1,271 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qlowenergystaticservicedata.h"
+
+#include "qlowenergycharacteristicdata.h"
+#include "qlowenergydescriptordata.h"
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \since 6.5
+    \class QLowEnergyStaticList
+    \brief The QLowEnergyStaticList class refers to a constant array of
+           static GATT attribute definitions.
+
+    A QLowEnergyStaticList is implicitly constructed from a C array, it stores
+    a pointer to the array and its size only. The array must therefore outlive
+    the list, which is the case for arrays with static storage duration.
+
+    \inmodule QtBluetooth
+
+    \sa QLowEnergyStaticServiceData
+*/
+
+/*!
+    \fn template <typename T> QLowEnergyStaticList<T>::QLowEnergyStaticList()
+
+    Constructs an empty list.
+*/
+
+/*!
+    \fn template <typename T> template <qsizetype N> QLowEnergyStaticList<T>::QLowEnergyStaticList(const T (&array)[N])
+
+    Constructs a list referring to the \c N elements of \a array.
+*/
+
+/*!
+    \fn template <typename T> const T *QLowEnergyStaticList<T>::begin() const
+
+    Returns a pointer to the first element of the list.
+*/
+
+/*!
+    \fn template <typename T> const T *QLowEnergyStaticList<T>::end() const
+
+    Returns a pointer just past the last element of the list.
+*/
+
+/*!
+    \fn template <typename T> qsizetype QLowEnergyStaticList<T>::size() const
+
+    Returns the number of elements in the list.
+*/
+
+/*!
+    \fn template <typename T> bool QLowEnergyStaticList<T>::isEmpty() const
+
+    Returns \c true if the list has no elements.
+*/
+
+/*!
+    \fn template <typename T> const T &QLowEnergyStaticList<T>::operator[](qsizetype i) const
+
+    Returns the element at index position \a i.
+*/
+
+/*!
+    \since 6.5
+    \class QLowEnergyStaticDescriptorData
+    \brief The QLowEnergyStaticDescriptorData class defines a descriptor of a
+           static GATT service.
+
+    The members correspond to the properties of \l QLowEnergyDescriptorData.
+    The value is referenced, not copied, and must have static storage duration.
+
+    \inmodule QtBluetooth
+
+    \sa QLowEnergyStaticServiceData
+*/
+
+/*!
+    \variable QLowEnergyStaticDescriptorData::uuid
+    The UUID of the descriptor.
+*/
+
+/*!
+    \variable QLowEnergyStaticDescriptorData::value
+    The initial value of the descriptor.
+*/
+
+/*!
+    \variable QLowEnergyStaticDescriptorData::readable
+    Whether the value can be read, \c true by default.
+*/
+
+/*!
+    \variable QLowEnergyStaticDescriptorData::writable
+    Whether the value can be written, \c false by default.
+*/
+
+/*!
+    \variable QLowEnergyStaticDescriptorData::readConstraints
+    The constraints for reading the value.
+*/
+
+/*!
+    \variable QLowEnergyStaticDescriptorData::writeConstraints
+    The constraints for writing the value.
+*/
+
+/*!
+    \since 6.5
+    \class QLowEnergyStaticCharacteristicData
+    \brief The QLowEnergyStaticCharacteristicData class defines a characteristic
+           of a static GATT service.
+
+    The members correspond to the properties of \l QLowEnergyCharacteristicData.
+    The value is referenced, not copied, and must have static storage duration.
+
+    \inmodule QtBluetooth
+
+    \sa QLowEnergyStaticServiceData
+*/
+
+/*!
+    \variable QLowEnergyStaticCharacteristicData::uuid
+    The UUID of the characteristic.
+*/
+
+/*!
+    \variable QLowEnergyStaticCharacteristicData::properties
+    The properties of the characteristic.
+*/
+
+/*!
+    \variable QLowEnergyStaticCharacteristicData::value
+    The initial value of the characteristic.
+*/
+
+/*!
+    \variable QLowEnergyStaticCharacteristicData::descriptors
+    The descriptors of the characteristic.
+*/
+
+/*!
+    \variable QLowEnergyStaticCharacteristicData::minimumValueLength
+    The minimum length of the value, \c 0 by default.
+*/
+
+/*!
+    \variable QLowEnergyStaticCharacteristicData::maximumValueLength
+    The maximum length of the value, \c INT_MAX by default.
+*/
+
+/*!
+    \variable QLowEnergyStaticCharacteristicData::readConstraints
+    The constraints for reading the value.
+*/
+
+/*!
+    \variable QLowEnergyStaticCharacteristicData::writeConstraints
+    The constraints for writing the value.
+*/
+
+/*!
+    \since 6.5
+    \class QLowEnergyStaticServiceData
+    \brief The QLowEnergyStaticServiceData class defines a GATT service whose
+           structure is known at compile time.
+
+    Unlike \l QLowEnergyServiceData, this class and the classes of its
+    characteristics and descriptors are literal types which do not allocate
+    memory. A service database can therefore be declared as a set of
+    \c constexpr arrays, which end up in the read-only data of the application:
+
+    \code
+    static constexpr char batteryLevel[] = { 100 };
+    static constexpr QLowEnergyStaticDescriptorData batteryDescriptors[] = {
+        { QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration,
+          QByteArrayView("\x00\x00", 2), true, true },
+    };
+    static constexpr QLowEnergyStaticCharacteristicData batteryCharacteristics[] = {
+        { QBluetoothUuid::CharacteristicType::BatteryLevel,
+          QLowEnergyCharacteristic::Read | QLowEnergyCharacteristic::Notify,
+          QByteArrayView(batteryLevel, sizeof(batteryLevel)), batteryDescriptors, 1, 1 },
+    };
+    static constexpr QLowEnergyStaticServiceData batteryService = {
+        QLowEnergyServiceData::ServiceTypePrimary,
+        QBluetoothUuid::ServiceClassUuid::BatteryService,
+        batteryCharacteristics
+    };
+
+    controller->addService(batteryService);
+    \endcode
+
+    All referenced values must have static storage duration. Values with
+    embedded null bytes need the size to be passed to \l QByteArrayView
+    explicitly.
+
+    Included services are not supported, these have to be declared with
+    \l QLowEnergyServiceData.
+
+    \inmodule QtBluetooth
+
+    \sa QLowEnergyController::addService()
+*/
+
+/*!
+    \variable QLowEnergyStaticServiceData::type
+    The type of the service.
+*/
+
+/*!
+    \variable QLowEnergyStaticServiceData::uuid
+    The UUID of the service.
+*/
+
+/*!
+    \variable QLowEnergyStaticServiceData::characteristics
+    The characteristics of the service.
+*/
+
+/*!
+    \fn bool QLowEnergyStaticServiceData::isValid() const
+
+    Returns true if the service has a UUID, like \l QLowEnergyServiceData::isValid().
+*/
+
+/*!
+    \fn int QLowEnergyStaticServiceData::attributeCount() const
+
+    Returns the number of attribute handles the service occupies.
+*/
+
+/*!
+    Returns a \l QLowEnergyServiceData with the same content.
+*/
+QLowEnergyServiceData QLowEnergyStaticServiceData::toServiceData() const
+{
+    QLowEnergyServiceData serviceData;
+    serviceData.setType(type);
+    serviceData.setUuid(uuid);
+
+    QList<QLowEnergyCharacteristicData> characteristicList;
+    characteristicList.reserve(characteristics.size());
+    for (const QLowEnergyStaticCharacteristicData &c : characteristics) {
+        QLowEnergyCharacteristicData characteristicData;
+        characteristicData.setUuid(c.uuid);
+        characteristicData.setProperties(c.properties);
+        characteristicData.setValue(c.value.toByteArray());
+        characteristicData.setValueLength(c.minimumValueLength, c.maximumValueLength);
+        characteristicData.setReadConstraints(c.readConstraints);
+        characteristicData.setWriteConstraints(c.writeConstraints);
+
+        QList<QLowEnergyDescriptorData> descriptorList;
+        descriptorList.reserve(c.descriptors.size());
+        for (const QLowEnergyStaticDescriptorData &d : c.descriptors) {
+            QLowEnergyDescriptorData descriptorData(d.uuid, d.value.toByteArray());
+            descriptorData.setReadPermissions(d.readable, d.readConstraints);
+            descriptorData.setWritePermissions(d.writable, d.writeConstraints);
+            descriptorList.append(std::move(descriptorData));
+        }
+        characteristicData.setDescriptors(std::move(descriptorList));
+        characteristicList.append(std::move(characteristicData));
+    }
+    serviceData.setCharacteristics(std::move(characteristicList));
+    return serviceData;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,83 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QLOWENERGYSTATICSERVICEDATA_H
+#define QLOWENERGYSTATICSERVICEDATA_H
+
+#include <QtBluetooth/qtbluetoothglobal.h>
+#include <QtBluetooth/qbluetooth.h>
+#include <QtBluetooth/qbluetoothuuid.h>
+#include <QtBluetooth/qlowenergycharacteristic.h>
+#include <QtBluetooth/qlowenergyservicedata.h>
+#include <QtCore/qbytearrayview.h>
+
+#include <climits>
+
+QT_BEGIN_NAMESPACE
+
+template <typename T>
+class QLowEnergyStaticList
+{
+public:
+    constexpr QLowEnergyStaticList() noexcept = default;
+    template <qsizetype N>
+    constexpr QLowEnergyStaticList(const T (&array)[N]) noexcept
+        : m_data(array), m_size(N)
+    {
+    }
+
+    constexpr const T *begin() const noexcept { return m_data; }
+    constexpr const T *end() const noexcept { return m_data + m_size; }
+    constexpr qsizetype size() const noexcept { return m_size; }
+    constexpr bool isEmpty() const noexcept { return m_size == 0; }
+    constexpr const T &operator[](qsizetype i) const noexcept { return m_data[i]; }
+
+private:
+    const T *m_data = nullptr;
+    qsizetype m_size = 0;
+};
+
+struct QLowEnergyStaticDescriptorData
+{
+    QBluetoothUuid uuid;
+    QByteArrayView value;
+    bool readable = true;
+    bool writable = false;
+    QBluetooth::AttAccessConstraints readConstraints = {};
+    QBluetooth::AttAccessConstraints writeConstraints = {};
+};
+
+struct QLowEnergyStaticCharacteristicData
+{
+    QBluetoothUuid uuid;
+    QLowEnergyCharacteristic::PropertyTypes properties;
+    QByteArrayView value;
+    QLowEnergyStaticList<QLowEnergyStaticDescriptorData> descriptors = {};
+    int minimumValueLength = 0;
+    int maximumValueLength = INT_MAX;
+    QBluetooth::AttAccessConstraints readConstraints = {};
+    QBluetooth::AttAccessConstraints writeConstraints = {};
+};
+
+struct QLowEnergyStaticServiceData
+{
+    QLowEnergyServiceData::ServiceType type;
+    QBluetoothUuid uuid;
+    QLowEnergyStaticList<QLowEnergyStaticCharacteristicData> characteristics = {};
+
+    bool isValid() const noexcept { return !uuid.isNull(); }
+
+    constexpr int attributeCount() const noexcept
+    {
+        int count = 1; // the service declaration
+        for (const QLowEnergyStaticCharacteristicData &characteristic : characteristics)
+            count += 2 + int(characteristic.descriptors.size());
+        return count;
+    }
+
+    Q_BLUETOOTH_EXPORT QLowEnergyServiceData toServiceData() const;
+};
+
+QT_END_NAMESPACE
+
+#endif // Include guard
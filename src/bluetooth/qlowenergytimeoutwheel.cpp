@@ -0,0 +1,175 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qlowenergytimeoutwheel_p.h"
+
+#include <QtCore/qthread.h>
+
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+QLowEnergyTimeoutWheel::QLowEnergyTimeoutWheel()
+{
+    clock.start();
+    timer.setTimerType(Qt::CoarseTimer);
+    timer.setInterval(Tick);
+    connect(&timer, &QTimer::timeout, this, &QLowEnergyTimeoutWheel::advance);
+}
+
+QSharedPointer<QLowEnergyTimeoutWheel> QLowEnergyTimeoutWheel::forCurrentThread()
+{
+    // the timer is bound to the thread which created the wheel
+    static thread_local QWeakPointer<QLowEnergyTimeoutWheel> currentWheel;
+
+    QSharedPointer<QLowEnergyTimeoutWheel> wheel = currentWheel.toStrongRef();
+    if (!wheel) {
+        // the last timeout may be released from within a callback of the wheel
+        wheel = QSharedPointer<QLowEnergyTimeoutWheel>(new QLowEnergyTimeoutWheel,
+                                                       &QObject::deleteLater);
+        currentWheel = wheel;
+    }
+    return wheel;
+}
+
+quint64 QLowEnergyTimeoutWheel::elapsedTicks() const
+{
+    return quint64(clock.elapsed()) / quint64(Tick.count());
+}
+
+/*
+    Schedules \a callback to be called once \a timeout expired. The returned
+    id is never 0.
+*/
+QLowEnergyTimeoutWheel::Id QLowEnergyTimeoutWheel::schedule(std::chrono::milliseconds timeout,
+                                                            std::function<void()> callback)
+{
+    // an idle wheel does not advance, skip the ticks it missed
+    if (entries.isEmpty())
+        currentTick = elapsedTicks();
+
+    const quint64 ticks = (qMax<qint64>(timeout.count(), 0) + Tick.count() - 1) / Tick.count();
+    const Id id = ++lastId;
+    const quint64 expiry = elapsedTicks() + qMax<quint64>(ticks, 1);
+    insert(id, *entries.insert(id, Entry{ expiry, std::move(callback) }));
+
+    if (!timer.isActive())
+        timer.start();
+    return id;
+}
+
+/*
+    Cancels the timeout \a id and removes it from its slot, so that a wheel
+    which is not advanced does not collect cancelled ids.
+*/
+void QLowEnergyTimeoutWheel::cancel(Id id)
+{
+    const auto it = entries.constFind(id);
+    if (it == entries.cend())
+        return;
+
+    // the slot advance() currently works on was taken out of the wheel, the
+    // id is then skipped there
+    it->slot->removeOne(id);
+    entries.erase(it);
+    if (entries.isEmpty())
+        timer.stop();
+}
+
+void QLowEnergyTimeoutWheel::insert(Id id, Entry &entry)
+{
+    const quint64 delta = entry.expiry > currentTick ? entry.expiry - currentTick : 0;
+    if (delta < quint64(SlotCount)) {
+        entry.slot = &nearSlots[entry.expiry & SlotMask];
+    } else if (delta < quint64(SlotCount) * SlotCount) {
+        entry.slot = &farSlots[(entry.expiry >> SlotBits) & SlotMask];
+    } else {
+        // beyond the range of the wheel, the cascade of the last slot places it again
+        entry.slot = &farSlots[((currentTick >> SlotBits) + SlotMask) & SlotMask];
+    }
+    entry.slot->append(id);
+}
+
+void QLowEnergyTimeoutWheel::advance()
+{
+    // a callback may release the last timeout and with it the wheel
+    const QSharedPointer<QLowEnergyTimeoutWheel> guard = sharedFromThis();
+
+    // the timer may fire late, catch up with the ticks which passed meanwhile
+    const quint64 target = elapsedTicks();
+    while (currentTick < target && !entries.isEmpty()) {
+        ++currentTick;
+        if ((currentTick & SlotMask) == 0) {
+            // move the timeouts of the next SlotCount ticks to level 0
+            QList<Id> slot = std::exchange(farSlots[(currentTick >> SlotBits) & SlotMask], {});
+            for (Id id : std::as_const(slot)) {
+                const auto it = entries.find(id);
+                if (it != entries.end())
+                    insert(id, *it);
+            }
+        }
+        QList<Id> slot = std::exchange(nearSlots[currentTick & SlotMask], {});
+        expireSlot(slot);
+    }
+    if (currentTick < target)
+        currentTick = target;
+
+    if (entries.isEmpty())
+        timer.stop();
+}
+
+void QLowEnergyTimeoutWheel::expireSlot(QList<Id> &slot)
+{
+    for (Id id : std::as_const(slot)) {
+        auto it = entries.find(id);
+        if (it == entries.end())
+            continue; // cancelled
+        if (it->expiry > currentTick) {
+            insert(id, *it);
+            continue;
+        }
+        const std::function<void()> callback = std::move(it->callback);
+        entries.erase(it);
+        // may schedule and cancel further timeouts
+        callback();
+    }
+}
+
+QLowEnergyRequestTimeout::QLowEnergyRequestTimeout(std::function<void()> callback)
+    : callback(std::move(callback))
+{
+}
+
+QLowEnergyRequestTimeout::~QLowEnergyRequestTimeout()
+{
+    stop();
+}
+
+/*
+    (Re)starts the timeout with \a timeout. The wheel of the current thread is
+    used, a controller which was moved to another thread picks up the wheel of
+    that thread with the next start().
+*/
+void QLowEnergyRequestTimeout::start(std::chrono::milliseconds timeout)
+{
+    stop();
+    if (!wheel || wheel->thread() != QThread::currentThread())
+        wheel = QLowEnergyTimeoutWheel::forCurrentThread();
+    id = wheel->schedule(timeout, [this]() {
+        id = 0;
+        // the callback may destroy this timeout
+        const std::function<void()> expired = callback;
+        expired();
+    });
+}
+
+void QLowEnergyRequestTimeout::stop()
+{
+    if (id && wheel)
+        wheel->cancel(id);
+    id = 0;
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qlowenergytimeoutwheel_p.cpp"
@@ -0,0 +1,107 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QLOWENERGYTIMEOUTWHEEL_P_H
+#define QLOWENERGYTIMEOUTWHEEL_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtBluetooth/qtbluetoothglobal.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qsharedpointer.h>
+#include <QtCore/qtimer.h>
+
+#include <array>
+#include <chrono>
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Protocol timeouts of all controllers of a thread, kept in a hierarchical
+    timing wheel. Starting and stopping a timeout only touches a hash and a
+    slot list, the event dispatcher sees a single coarse timer which runs
+    while any timeout is pending. Timeouts fire up to one tick late.
+*/
+class Q_AUTOTEST_EXPORT QLowEnergyTimeoutWheel : public QObject,
+                                                 public QEnableSharedFromThis<QLowEnergyTimeoutWheel>
+{
+    Q_OBJECT
+public:
+    using Id = quint64;
+    static constexpr std::chrono::milliseconds Tick{50};
+
+    // One wheel per thread, shared by all its timeouts
+    static QSharedPointer<QLowEnergyTimeoutWheel> forCurrentThread();
+
+    Id schedule(std::chrono::milliseconds timeout, std::function<void()> callback);
+    void cancel(Id id);
+    qsizetype pendingTimeouts() const { return entries.size(); }
+
+private:
+    QLowEnergyTimeoutWheel();
+
+    static constexpr int SlotBits = 8;
+    static constexpr int SlotCount = 1 << SlotBits;
+    static constexpr quint64 SlotMask = SlotCount - 1;
+
+    struct Entry
+    {
+        quint64 expiry = 0; // in ticks
+        std::function<void()> callback;
+        // the slot list which holds the id, lets cancel() remove it
+        QList<Id> *slot = nullptr;
+    };
+
+    quint64 elapsedTicks() const;
+    void insert(Id id, Entry &entry);
+    void advance();
+    void expireSlot(QList<Id> &slot);
+
+    QHash<Id, Entry> entries;
+    // level 0 holds the next SlotCount ticks, level 1 the next SlotCount^2 ticks
+    std::array<QList<Id>, SlotCount> nearSlots;
+    std::array<QList<Id>, SlotCount> farSlots;
+    quint64 currentTick = 0;
+    Id lastId = 0;
+    QElapsedTimer clock;
+    QTimer timer;
+};
+
+/*
+    Single shot timeout on the wheel of the current thread. Mirrors the parts
+    of QTimer the controllers use, the callback runs on the thread which
+    started the timeout.
+*/
+class Q_AUTOTEST_EXPORT QLowEnergyRequestTimeout
+{
+    Q_DISABLE_COPY_MOVE(QLowEnergyRequestTimeout)
+public:
+    explicit QLowEnergyRequestTimeout(std::function<void()> callback);
+    ~QLowEnergyRequestTimeout();
+
+    void start(std::chrono::milliseconds timeout);
+    void stop();
+    bool isActive() const { return id != 0; }
+
+private:
+    std::function<void()> callback;
+    QSharedPointer<QLowEnergyTimeoutWheel> wheel;
+    QLowEnergyTimeoutWheel::Id id = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QLOWENERGYTIMEOUTWHEEL_P_H
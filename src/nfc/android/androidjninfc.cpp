@@ -15,13 +15,44 @@ static const char *nfcClassName = "org/qtproject/qt/android/nfc/QtNfc";
 
 static AndroidNfc::MainNfcNewIntentListener mainListener;
 
+static bool readerMode = false;
+static bool readerModeSkipNdefCheck = false;
+
+extern "C"
+{
+    JNIEXPORT void JNICALL Java_org_qtproject_qt_android_nfc_QtNfc_jniOnTagDiscovered(
+        JNIEnv *env, jclass /*javaClass*/, jobject intent)
+    {
+        // Called on a binder thread of the reader mode callback
+        mainListener.handleNewIntent(env, intent);
+    }
+}
+
 QT_BEGIN_ANDROIDNFC_NAMESPACE
 
 bool startDiscovery()
 {
+    if (readerMode) {
+        return QJniObject::callStaticMethod<jboolean>(nfcClassName, "startReaderMode", "(Z)Z",
+                                                      jboolean(readerModeSkipNdefCheck));
+    }
     return QJniObject::callStaticMethod<jboolean>(nfcClassName,"start");
 }
 
+/*
+    Selects between foreground dispatch and reader mode for the next
+    discovery. A running discovery is restarted with the new mode.
+*/
+void setReaderMode(bool enabled, bool skipNdefCheck)
+{
+    if (readerMode == enabled && readerModeSkipNdefCheck == skipNdefCheck)
+        return;
+
+    readerMode = enabled;
+    readerModeSkipNdefCheck = skipNdefCheck;
+    mainListener.restartReceiving();
+}
+
 bool isEnabled()
 {
     return QJniObject::callStaticMethod<jboolean>(nfcClassName,"isEnabled");
@@ -33,6 +33,7 @@ public:
 
 bool startDiscovery();
 bool stopDiscovery();
+void setReaderMode(bool enabled, bool skipNdefCheck);
 QJniObject getStartIntent();
 bool isEnabled();
 bool isSupported();
@@ -65,6 +65,15 @@ bool MainNfcNewIntentListener::unregisterListener(AndroidNfcListenerInterface *l
     return true;
 }
 
+void MainNfcNewIntentListener::restartReceiving()
+{
+    if (!receiving)
+        return;
+
+    AndroidNfc::stopDiscovery();
+    receiving = AndroidNfc::startDiscovery();
+}
+
 void MainNfcNewIntentListener::handleResume()
 {
     paused = false;
@@ -34,6 +34,7 @@ public:
 
     bool registerListener(AndroidNfcListenerInterface *listener);
     bool unregisterListener(AndroidNfcListenerInterface *listener);
+    void restartReceiving();
 
     //QtAndroidPrivate::ResumePauseListener
     void handleResume();
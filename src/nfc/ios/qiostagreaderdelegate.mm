@@ -58,6 +58,16 @@ QT_USE_NAMESPACE
     }
 }
 
+- (bool)restartPolling
+{
+    // Keeps the session and its system sheet for the next tag
+    if (!self.session || self.sessionStoppedByApplication || !self.session.ready)
+        return false;
+
+    [self.session restartPolling];
+    return true;
+}
+
 - (void)alertMessage:(QString)message
 {
     if (self.session && !self.sessionStoppedByApplication)
@@ -40,6 +40,7 @@ API_AVAILABLE(ios(13.0))
 
 - (void)startSession;
 - (void)stopSession:(QString)message;
+- (bool)restartPolling;
 
 - (void)alertMessage:(QString)message;
 
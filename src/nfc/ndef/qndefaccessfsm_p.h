@@ -17,8 +17,12 @@
 
 #include "qndefmessage.h"
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
+class QNdefMessageCache;
+
 /*
     Base class for FSMs that can be used to exchange NDEF messages with cards.
 
@@ -44,6 +48,9 @@ public:
         Failed,
         // An NDEF message was successfully read. The user must call getMessage().
         GetMessage,
+        // Records of the NDEF message being read were decoded. The user must
+        // call getRecords().
+        GetRecords,
         // The user's call was unexpected. The FSM may be in an invalid state.
         Unexpected,
         // The user must call getCommand() and then send the returned command to the card.
@@ -65,10 +72,10 @@ public:
         This method must be called by the user to provide response for
         a completed command.
 
-        An empty QByteArray can be provided to indicate that the command
-        has failed.
+        An empty response can be provided to indicate that the command
+        has failed. The response is not referred to after the call returns.
     */
-    virtual Action provideResponse(const QByteArray &response) = 0;
+    virtual Action provideResponse(QByteArrayView response) = 0;
 
     /*
         Returns an NDEF message that was read from the card.
@@ -77,6 +84,15 @@ public:
     */
     virtual QNdefMessage getMessage(Action &nextAction) = 0;
 
+    /*
+        Returns the records of the NDEF message that were decoded while it
+        is being read. They are part of the message returned by getMessage(),
+        too.
+
+        This method must be called if the FSM has requested GetRecords action.
+    */
+    virtual QList<QNdefRecord> getRecords(Action &nextAction) = 0;
+
     /*
         Start NDEF support detection.
     */
@@ -96,6 +112,29 @@ public:
         This call also performs NDEF detection if is was not performed earlier.
     */
     virtual Action writeMessages(const QList<QNdefMessage> &messages) = 0;
+
+    /*
+        Sets the cache of the messages read from the card with the given UID.
+        Reading a message that is in \a cache may then skip reading its data.
+    */
+    virtual void setMessageCache(std::shared_ptr<QNdefMessageCache> cache,
+                                 const QByteArray &uid) = 0;
+
+    /*
+        Tells the FSM that commands it did not create were sent to the card,
+        or that the card was reset. Whatever application or file the FSM
+        selected earlier is selected again by the next task, and content it
+        read or wrote earlier is no longer assumed to be on the card.
+    */
+    virtual void invalidateSelection() { }
+
+    /*
+        Tells the FSM that the transaction which kept other applications away
+        from the card has ended. Another application may change the card
+        before the next task, so content the FSM read or wrote earlier is no
+        longer assumed to be on the card.
+    */
+    virtual void endTransaction() { }
 };
 
 QT_END_NAMESPACE
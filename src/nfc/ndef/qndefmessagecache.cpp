@@ -0,0 +1,101 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qndefmessagecache_p.h"
+#include "qndefrecord_p.h"
+
+#include <QtCore/QLoggingCategory>
+
+QT_BEGIN_NAMESPACE
+
+Q_LOGGING_CATEGORY(QT_NFC_MEMORY, "qt.nfc.memory")
+
+// Tags seen in one session rarely exceed this, an arbitrary entry is dropped
+// when more are cached.
+static constexpr qsizetype MaxCachedMessages = 64;
+
+void QNdefMessageCache::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_enabled = enabled;
+    if (!enabled)
+        m_entries.clear();
+}
+
+bool QNdefMessageCache::isEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_enabled;
+}
+
+/*
+    Returns the message cached for the tag \a uid if it was cached with the
+    same \a validationKey.
+*/
+std::optional<QNdefMessage> QNdefMessageCache::find(const QByteArray &uid,
+                                                    const QByteArray &validationKey) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    const auto it = m_entries.constFind(uid);
+    if (it == m_entries.cend() || it->validationKey != validationKey)
+        return std::nullopt;
+
+    return it->message;
+}
+
+void QNdefMessageCache::insert(const QByteArray &uid, const QByteArray &validationKey,
+                               const QNdefMessage &message)
+{
+    if (uid.isEmpty())
+        return;
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_enabled)
+        return;
+
+    if (m_entries.size() >= MaxCachedMessages && !m_entries.contains(uid))
+        m_entries.erase(m_entries.begin());
+    m_entries.insert(uid, { validationKey, message });
+    qCDebug(QT_NFC_MEMORY) << "NDEF message cache holds" << m_entries.size() << "messages in"
+                           << memoryUsageLocked() << "bytes";
+}
+
+void QNdefMessageCache::remove(const QByteArray &uid)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_entries.remove(uid);
+}
+
+qsizetype QNdefMessageCache::memoryUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return memoryUsageLocked();
+}
+
+/*
+    Estimated from the capacities of the containers, data shared with the
+    messages handed out by find() is counted as well.
+*/
+qsizetype QNdefMessageCache::memoryUsageLocked() const
+{
+    // one offset byte per bucket plus the entries stored in the spans
+    qsizetype result = qsizetype(m_entries.capacity())
+            + m_entries.size() * qsizetype(sizeof(QByteArray) + sizeof(Entry));
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        result += it.key().capacity() + it->validationKey.capacity()
+                + it->message.capacity() * qsizetype(sizeof(QNdefRecord));
+        for (const QNdefRecord &record : it->message) {
+            result += qsizetype(sizeof(QNdefRecordPrivate)) + record.type().capacity()
+                    + record.id().capacity() + record.payload().capacity();
+        }
+    }
+    return result;
+}
+
+QT_END_NAMESPACE
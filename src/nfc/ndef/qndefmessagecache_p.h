@@ -0,0 +1,71 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QNDEFMESSAGECACHE_P_H
+#define QNDEFMESSAGECACHE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qndefmessage.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+
+#include <optional>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Keeps the NDEF messages read from tags, keyed by the UID of the tag, so
+    that reading a tag again only needs to check whether its message has
+    changed.
+
+    The cached message is only used if the tag still has the same validation
+    key, a cheap to read piece of data such as the length of the message.
+    The FSMs of all the cards detected by a QNearFieldManager share one cache,
+    and they may run in different threads.
+*/
+class QNdefMessageCache
+{
+    Q_DISABLE_COPY_MOVE(QNdefMessageCache)
+public:
+    QNdefMessageCache() = default;
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    std::optional<QNdefMessage> find(const QByteArray &uid, const QByteArray &validationKey) const;
+    void insert(const QByteArray &uid, const QByteArray &validationKey,
+                const QNdefMessage &message);
+    void remove(const QByteArray &uid);
+
+    // approximate heap size of the cached entries
+    qsizetype memoryUsage() const;
+
+private:
+    struct Entry
+    {
+        QByteArray validationKey;
+        QNdefMessage message;
+    };
+
+    qsizetype memoryUsageLocked() const;
+
+    mutable QMutex m_mutex;
+    bool m_enabled = false;
+    QHash<QByteArray, Entry> m_entries;
+};
+
+QT_END_NAMESPACE
+
+#endif // QNDEFMESSAGECACHE_P_H
@@ -0,0 +1,461 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qnfctagtype2ndeffsm_p.h"
+#include "qndefmessagecache_p.h"
+#include "qnfctlv_p.h"
+#include <QtCore/QLoggingCategory>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+Q_LOGGING_CATEGORY(QT_NFC_T2T, "qt.nfc.t2t")
+
+/*
+    NDEF support for NFC Type 2 tags, like NTAG21x and MIFARE Ultralight.
+
+    Based on Type 2 Tag Operation Specification, Version 1.2 (T2TOP 1.2).
+
+    The pages of the tag are accessed with the READ BINARY and UPDATE BINARY
+    pseudo APDUs of PC/SC part 3 for storage cards. A READ BINARY for more
+    than 4 pages lets readers that support it use FAST_READ or several READ
+    commands, so that small messages are read with a single command. If the
+    reader fails such a read, the FSM falls back to reading 4 pages at once.
+*/
+
+static constexpr int PageSize = 4;
+// The capability container is on page 3, the data area starts on page 4
+static constexpr int CapabilityContainerPage = 3;
+static constexpr int DataAreaPage = 4;
+
+// READ BINARY with a short Le, rounded down to whole pages
+static constexpr int MaxReadBinaryLength = 252;
+
+QNfcTagType2NdefFsm::QNfcTagType2NdefFsm(int maxResponseLength)
+    : m_maxReadLength(qBound(MinReadLength, (maxResponseLength - 2) & ~(PageSize - 1),
+                             MaxReadBinaryLength)),
+      m_readLength(m_maxReadLength)
+{
+}
+
+static QByteArray readPagesCommand(int page, int length)
+{
+    return QCommandApdu::build(0xFF, QCommandApdu::ReadBinary, page >> 8, page & 0xFF, {},
+                               length);
+}
+
+QByteArray QNfcTagType2NdefFsm::getCommand(QNdefAccessFsm::Action &nextAction)
+{
+    nextAction = ProvideResponse;
+
+    switch (m_currentState) {
+    case ReadCapabilityContainer:
+        m_requestedLength = MinReadLength;
+        return readPagesCommand(CapabilityContainerPage, m_requestedLength);
+    case ReadData: {
+        // Read up to the end of the NDEF message if its length is known yet
+        const qsizetype end = m_ndefLength >= 0 ? m_ndefValueOffset + m_ndefLength
+                                                : m_dataAreaSize;
+        const qsizetype missing = qMin(end, m_dataAreaSize) - m_data.size();
+        const qsizetype missingPages = (missing + PageSize - 1) / PageSize;
+        m_requestedLength = int(qMin<qsizetype>(m_readLength, missingPages * PageSize));
+
+        return readPagesCommand(DataAreaPage + int(m_data.size() / PageSize), m_requestedLength);
+    }
+    case WriteData:
+        return m_writeCommands.at(m_writeIndex);
+    default:
+        nextAction = Unexpected;
+        return {};
+    }
+}
+
+QNdefMessage QNfcTagType2NdefFsm::getMessage(QNdefAccessFsm::Action &nextAction)
+{
+    if (m_currentState == NdefMessageRead) {
+        QNdefMessage message;
+        if (m_cachedMessage) {
+            message = *m_cachedMessage;
+            m_cachedMessage.reset();
+        } else {
+            const bool decoded = m_decoder.finish() == QNdefMessageDecoder::Finished;
+            message = m_decoder.takeMessage();
+            m_decoder = QNdefMessageDecoder();
+            if (decoded && m_cache) {
+                m_cache->insert(m_uid, m_data.sliced(m_ndefOffset, m_ndefValueOffset - m_ndefOffset),
+                                message);
+            }
+        }
+        m_currentState = NdefSupportDetected;
+        nextAction = Done;
+        return message;
+    }
+
+    nextAction = Unexpected;
+    return {};
+}
+
+QList<QNdefRecord> QNfcTagType2NdefFsm::getRecords(QNdefAccessFsm::Action &nextAction)
+{
+    if (m_currentState == ReadData) {
+        nextAction = SendCommand;
+        return m_decoder.takeNewRecords();
+    } else if (m_currentState == NdefMessageRead) {
+        nextAction = GetMessage;
+        if (m_cachedMessage)
+            return *m_cachedMessage;
+        return m_decoder.takeNewRecords();
+    }
+
+    nextAction = Unexpected;
+    return {};
+}
+
+void QNfcTagType2NdefFsm::setMessageCache(std::shared_ptr<QNdefMessageCache> cache,
+                                          const QByteArray &uid)
+{
+    if (uid.isEmpty())
+        return;
+
+    m_cache = std::move(cache);
+    m_uid = uid;
+}
+
+QNdefAccessFsm::Action QNfcTagType2NdefFsm::detectNdefSupport()
+{
+    switch (m_currentState) {
+    case ReadCapabilityContainer:
+        m_targetState = NdefSupportDetected;
+        return SendCommand;
+    case NdefSupportDetected:
+        return Done;
+    case NdefNotSupported:
+        return Failed;
+    default:
+        return Unexpected;
+    }
+}
+
+QNdefAccessFsm::Action QNfcTagType2NdefFsm::readMessages()
+{
+    switch (m_currentState) {
+    case ReadCapabilityContainer:
+        m_targetState = NdefMessageRead;
+        return SendCommand;
+    case NdefSupportDetected:
+        m_targetState = NdefMessageRead;
+        return startDataRead();
+    case NdefNotSupported:
+        return Failed;
+    default:
+        return Unexpected;
+    }
+}
+
+QNdefAccessFsm::Action QNfcTagType2NdefFsm::writeMessages(const QList<QNdefMessage> &messages)
+{
+    // Only one message per tag is supported
+    if (messages.isEmpty() || messages.size() > 1)
+        return Failed;
+
+    auto messageData = messages.first().toByteArray();
+    if (messageData.size() > 0xFFFE)
+        return Failed;
+
+    m_ndefData = messageData;
+
+    m_targetState = NdefMessageWritten;
+
+    // Whatever happens, the cached message is no longer valid
+    if (m_cache)
+        m_cache->remove(m_uid);
+
+    switch (m_currentState) {
+    case ReadCapabilityContainer:
+        return SendCommand;
+
+    case NdefNotSupported:
+        return Failed;
+
+    case NdefSupportDetected:
+        if (!m_writable)
+            return Failed;
+
+        // The position of the NDEF TLV is found by reading the data area
+        return startDataRead();
+
+    default:
+        return Unexpected;
+    };
+}
+
+QNdefAccessFsm::Action QNfcTagType2NdefFsm::provideResponse(QByteArrayView response)
+{
+    QResponseApdu apdu(response);
+
+    switch (m_currentState) {
+    case ReadCapabilityContainer:
+        return handleReadCCResponse(apdu);
+    case ReadData:
+        return handleReadDataResponse(apdu);
+    case WriteData:
+        return handleWriteResponse(apdu);
+    default:
+        return Unexpected;
+    }
+}
+
+QNdefAccessFsm::Action QNfcTagType2NdefFsm::startDataRead()
+{
+    m_data.clear();
+    m_ndefOffset = -1;
+    m_ndefValueOffset = 0;
+    m_ndefLength = -1;
+    m_decodedLength = 0;
+    m_decoder = QNdefMessageDecoder();
+    m_tlvReader = QNfcTlvReader();
+
+    m_currentState = ReadData;
+    return SendCommand;
+}
+
+/*
+    Looks for the NDEF message TLV in the data read so far. Lock control,
+    memory control and proprietary TLVs are skipped.
+*/
+QNfcTagType2NdefFsm::TlvSearch QNfcTagType2NdefFsm::findNdefTlv()
+{
+    m_tlvReader.setData(m_data);
+
+    while (true) {
+        switch (m_tlvReader.readNext()) {
+        case QNfcTlvReader::NeedMoreData:
+            if (m_tlvReader.position() >= m_dataAreaSize) {
+                // There is neither an NDEF message nor a terminator TLV
+                m_ndefOffset = m_tlvReader.position() == m_dataAreaSize ? m_dataAreaSize : -1;
+                return TlvSearch::NotFound;
+            }
+            return TlvSearch::NeedMoreData;
+        case QNfcTlvReader::Terminator:
+            m_ndefOffset = m_tlvReader.offset();
+            return TlvSearch::NotFound;
+        case QNfcTlvReader::Tlv:
+            if (m_tlvReader.tag() == QNfcTlv::NdefMessageTlv) {
+                m_ndefOffset = m_tlvReader.offset();
+                m_ndefValueOffset = m_tlvReader.valueOffset();
+                m_ndefLength = m_tlvReader.length();
+                return TlvSearch::Found;
+            }
+            break;
+        }
+    }
+}
+
+QNdefAccessFsm::Action QNfcTagType2NdefFsm::handleReadCCResponse(const QResponseApdu &response)
+{
+    m_currentState = NdefNotSupported;
+
+    if (!response.isOk() || response.data().size() < PageSize) {
+        qCDebug(QT_NFC_T2T) << "Reading the capability container failed";
+        return Failed;
+    }
+
+    const QByteArrayView cc = response.data();
+    if (uint8_t(cc.at(0)) != 0xE1) {
+        qCDebug(QT_NFC_T2T) << "Invalid NDEF magic number";
+        return Failed;
+    }
+    const uint8_t version = cc.at(1);
+    if ((version >> 4) != 1) {
+        qCDebug(QT_NFC_T2T) << "Unsupported mapping version:" << Qt::hex << version;
+        return Failed;
+    }
+    m_dataAreaSize = uint8_t(cc.at(2)) * 8;
+
+    /*
+        The specification defines value 0 for the read and the write access
+        conditions to mean that access is granted, other values are either
+        reserved, proprietary, or indicate that no access is granted.
+    */
+    const uint8_t access = cc.at(3);
+    if ((access >> 4) != 0) {
+        qCDebug(QT_NFC_T2T) << "No read access";
+        return Failed;
+    }
+    m_writable = (access & 0x0F) == 0;
+
+    qCDebug(QT_NFC_T2T) << "Data area size" << m_dataAreaSize << "read size" << m_readLength;
+
+    m_currentState = NdefSupportDetected;
+
+    if (m_targetState == NdefSupportDetected)
+        return Done;
+    else if (m_targetState == NdefMessageRead)
+        return startDataRead();
+    else if (m_targetState == NdefMessageWritten)
+        return m_writable ? startDataRead() : Failed;
+
+    return Unexpected;
+}
+
+QNdefAccessFsm::Action QNfcTagType2NdefFsm::handleReadDataResponse(const QResponseApdu &response)
+{
+    if (!response.isOk() || response.data().size() < m_requestedLength) {
+        if (m_readLength > MinReadLength) {
+            qCDebug(QT_NFC_T2T) << "Reading" << m_requestedLength
+                                << "bytes failed, falling back to single READ commands";
+            m_readLength = MinReadLength;
+            return SendCommand;
+        }
+
+        m_currentState = NdefSupportDetected;
+        return Failed;
+    }
+
+    const qsizetype readSize = qMin<qsizetype>(m_requestedLength, m_dataAreaSize - m_data.size());
+    m_data.append(response.data().first(readSize));
+
+    return continueRead();
+}
+
+QNdefAccessFsm::Action QNfcTagType2NdefFsm::continueRead()
+{
+    if (m_ndefOffset < 0) {
+        switch (findNdefTlv()) {
+        case TlvSearch::NeedMoreData:
+            if (m_data.size() >= m_dataAreaSize) {
+                m_currentState = NdefSupportDetected;
+                return Failed;
+            }
+            // The pages that only hold the value of a skipped TLV are not read
+            if (const qsizetype next = m_tlvReader.position() & ~qsizetype(PageSize - 1);
+                next > m_data.size()) {
+                m_data.resize(next, char(QNfcTlv::NullTlv));
+            }
+            return SendCommand;
+        case TlvSearch::NotFound:
+            if (m_ndefOffset < 0) {
+                m_currentState = NdefSupportDetected;
+                return Failed;
+            }
+            if (m_targetState == NdefMessageWritten)
+                return startWrite();
+
+            // There is no NDEF message on the tag
+            m_currentState = NdefMessageRead;
+            return GetMessage;
+        case TlvSearch::Found:
+            if (m_ndefValueOffset + m_ndefLength > m_dataAreaSize) {
+                qCDebug(QT_NFC_T2T) << "NDEF message exceeds the data area";
+                m_currentState = NdefSupportDetected;
+                return Failed;
+            }
+            if (m_targetState == NdefMessageWritten)
+                return startWrite();
+
+            // A message of the same length is assumed to be unchanged
+            if (m_cache && m_ndefLength != 0) {
+                m_cachedMessage = m_cache->find(
+                        m_uid, m_data.sliced(m_ndefOffset, m_ndefValueOffset - m_ndefOffset));
+                if (m_cachedMessage) {
+                    qCDebug(QT_NFC_T2T) << "Using the cached NDEF message";
+                    m_currentState = NdefMessageRead;
+                    return GetRecords;
+                }
+            }
+            break;
+        }
+    }
+
+    // Decode the part of the message that was read since the last response
+    const qsizetype end = qMin(m_data.size(), m_ndefValueOffset + m_ndefLength);
+    const qsizetype start = m_ndefValueOffset + m_decodedLength;
+    if (end > start) {
+        m_decoder.addData(QByteArrayView(m_data).sliced(start, end - start));
+        m_decodedLength += end - start;
+    }
+
+    // There is no need to read the rest of a message that cannot be decoded
+    if (m_decodedLength == m_ndefLength || m_decoder.status() != QNdefMessageDecoder::NeedMoreData)
+        m_currentState = NdefMessageRead;
+    else
+        m_currentState = ReadData;
+
+    if (m_decoder.hasNewRecords())
+        return GetRecords;
+
+    return m_currentState == NdefMessageRead ? GetMessage : SendCommand;
+}
+
+/*
+    Prepares the commands that replace the NDEF TLV found while reading.
+
+    The TLV is first written with a zero length, then the message, and
+    finally the actual length, so that an interrupted write leaves an empty
+    message rather than a broken one.
+*/
+QNdefAccessFsm::Action QNfcTagType2NdefFsm::startWrite()
+{
+    m_currentState = NdefSupportDetected;
+
+    // Writing starts with the page that contains the TLV, keep the bytes that precede it
+    const qsizetype firstPageOffset = m_ndefOffset & ~qsizetype(PageSize - 1);
+    QByteArray data = m_data.sliced(firstPageOffset, m_ndefOffset - firstPageOffset);
+
+    const qsizetype lengthOffset = data.size() + 1;
+    data.reserve(data.size() + QNfcTlv::encodedSize(m_ndefData.size()) + PageSize);
+    QNfcTlvWriter writer(&data);
+    writer.writeTlv(QNfcTlv::NdefMessageTlv, m_ndefData);
+    const qsizetype lengthSize = QNfcTlv::encodedSize(m_ndefData.size()) - m_ndefData.size() - 1;
+
+    // The terminator may be omitted if the message fills the data area
+    if (firstPageOffset + data.size() < m_dataAreaSize)
+        writer.writeTerminator();
+    if (firstPageOffset + data.size() > m_dataAreaSize) {
+        qCDebug(QT_NFC_T2T) << "Message is too large";
+        return Failed;
+    }
+    data.resize((data.size() + PageSize - 1) & ~qsizetype(PageSize - 1), char(QNfcTlv::NullTlv));
+
+    const auto writePage = [firstPageOffset](QByteArrayView data, qsizetype offset) {
+        const int page = DataAreaPage + int((firstPageOffset + offset) / PageSize);
+        return QCommandApdu::build(0xFF, QCommandApdu::UpdateBinary, page >> 8, page & 0xFF,
+                                   data.sliced(offset, PageSize));
+    };
+
+    // Pages that contain the length field
+    const qsizetype lengthPages = (lengthOffset + lengthSize + PageSize - 1) / PageSize;
+
+    QByteArray emptyTlv = data.first(lengthPages * PageSize);
+    std::fill_n(emptyTlv.begin() + lengthOffset, lengthSize, char(0));
+
+    m_writeCommands.clear();
+    for (qsizetype page = 0; page < lengthPages; ++page)
+        m_writeCommands.append(writePage(emptyTlv, page * PageSize));
+    for (qsizetype offset = lengthPages * PageSize; offset < data.size(); offset += PageSize)
+        m_writeCommands.append(writePage(data, offset));
+    for (qsizetype page = 0; page < lengthPages; ++page)
+        m_writeCommands.append(writePage(data, page * PageSize));
+
+    m_writeIndex = 0;
+    m_currentState = WriteData;
+    return SendCommand;
+}
+
+QNdefAccessFsm::Action QNfcTagType2NdefFsm::handleWriteResponse(const QResponseApdu &response)
+{
+    if (!response.isOk()) {
+        m_currentState = NdefSupportDetected;
+        return Failed;
+    }
+
+    if (++m_writeIndex < m_writeCommands.size())
+        return SendCommand;
+
+    m_writeCommands.clear();
+    m_currentState = NdefSupportDetected;
+    return Done;
+}
+
+QT_END_NAMESPACE
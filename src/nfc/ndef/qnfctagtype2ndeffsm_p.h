@@ -0,0 +1,105 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QNFCTAGTYPE2NDEFFSM_P_H
+#define QNFCTAGTYPE2NDEFFSM_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qndefaccessfsm_p.h"
+#include "qapduutils_p.h"
+#include "qndefmessagedecoder_p.h"
+#include "qnfctlv_p.h"
+
+#include <optional>
+
+QT_BEGIN_NAMESPACE
+
+class QNfcTagType2NdefFsm : public QNdefAccessFsm
+{
+public:
+    explicit QNfcTagType2NdefFsm(int maxResponseLength = MinReadLength + 2);
+
+    QByteArray getCommand(Action &nextAction) override;
+    QNdefMessage getMessage(Action &nextAction) override;
+    QList<QNdefRecord> getRecords(Action &nextAction) override;
+    void setMessageCache(std::shared_ptr<QNdefMessageCache> cache, const QByteArray &uid) override;
+    Action provideResponse(QByteArrayView response) override;
+
+    Action detectNdefSupport() override;
+    Action readMessages() override;
+    Action writeMessages(const QList<QNdefMessage> &messages) override;
+
+private:
+    // Every tag answers a READ with 4 pages
+    static constexpr int MinReadLength = 16;
+
+    enum State {
+        ReadCapabilityContainer,
+        NdefSupportDetected,
+        NdefNotSupported,
+
+        ReadData,
+        NdefMessageRead,
+
+        WriteData,
+        NdefMessageWritten // Only for target state, it is never actually reached
+    };
+
+    enum class TlvSearch { NeedMoreData, Found, NotFound };
+
+    State m_currentState = ReadCapabilityContainer;
+    State m_targetState = ReadCapabilityContainer;
+
+    // The most bytes a single READ BINARY may request
+    const int m_maxReadLength;
+    // Falls back to MinReadLength if the reader fails to read more
+    int m_readLength;
+    int m_requestedLength = 0;
+
+    // Initialized during the detection phase
+    qsizetype m_dataAreaSize = 0;
+    bool m_writable = false;
+
+    // The data area from its first page as far as it was read
+    QByteArray m_data;
+    // Position of the NDEF TLV in m_data, or of the terminator TLV if there is none
+    qsizetype m_ndefOffset = -1;
+    qsizetype m_ndefValueOffset = 0;
+    qsizetype m_ndefLength = -1;
+    qsizetype m_decodedLength = 0;
+    QNdefMessageDecoder m_decoder;
+    QNfcTlvReader m_tlvReader;
+
+    // Used during the write operation
+    QByteArray m_ndefData;
+    QList<QByteArray> m_writeCommands;
+    qsizetype m_writeIndex = 0;
+
+    // The NDEF TLV length field validates the cached message
+    std::shared_ptr<QNdefMessageCache> m_cache;
+    QByteArray m_uid;
+    std::optional<QNdefMessage> m_cachedMessage;
+
+    Action startDataRead();
+    TlvSearch findNdefTlv();
+
+    Action handleReadCCResponse(const QResponseApdu &response);
+    Action handleReadDataResponse(const QResponseApdu &response);
+    Action continueRead();
+    Action startWrite();
+    Action handleWriteResponse(const QResponseApdu &response);
+};
+
+QT_END_NAMESPACE
+
+#endif // QNFCTAGTYPE2NDEFFSM_P_H
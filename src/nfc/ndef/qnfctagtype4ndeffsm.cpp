@@ -2,9 +2,12 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include "qnfctagtype4ndeffsm_p.h"
+#include "qndefmessagecache_p.h"
 #include <QtCore/QtEndian>
 #include <QtCore/QLoggingCategory>
 
+#include <utility>
+
 QT_BEGIN_NAMESPACE
 
 Q_LOGGING_CATEGORY(QT_NFC_T4T, "qt.nfc.t4t")
@@ -15,6 +18,18 @@ Q_LOGGING_CATEGORY(QT_NFC_T4T, "qt.nfc.t4t")
     Based on Type 4 Tag Operation Specification, Version 2.0 (T4TOP 2.0).
 */
 
+/*
+    Builds the command into m_command. Its memory is reused once the user has
+    released the previous command, which is the case for a card that sends
+    the commands one by one.
+*/
+QByteArray QNfcTagType4NdefFsm::buildCommand(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2,
+                                             QByteArrayView data, uint16_t ne)
+{
+    QCommandApdu::build(m_command, cla, ins, p1, p2, data, ne);
+    return m_command;
+}
+
 QByteArray QNfcTagType4NdefFsm::getCommand(QNdefAccessFsm::Action &nextAction)
 {
     // ID of the NDEF Tag Application
@@ -30,29 +45,29 @@ QByteArray QNfcTagType4NdefFsm::getCommand(QNdefAccessFsm::Action &nextAction)
     case SelectApplicationForProbe:
     case SelectApplicationForRead:
     case SelectApplicationForWrite:
-        return QCommandApdu::build(0x00, QCommandApdu::Select, 0x04, 0x00,
-                                   QByteArrayView::fromArray(NtagApplicationIdV2), 256);
+        return buildCommand(0x00, QCommandApdu::Select, 0x04, 0x00,
+                            QByteArrayView::fromArray(NtagApplicationIdV2), 256);
     case SelectCCFile:
-        return QCommandApdu::build(0x00, QCommandApdu::Select, 0x00, 0x0C,
-                                   QByteArrayView::fromArray(CapabilityContainerId));
+        return buildCommand(0x00, QCommandApdu::Select, 0x00, 0x0C,
+                            QByteArrayView::fromArray(CapabilityContainerId));
     case ReadCCFile:
-        return QCommandApdu::build(0x00, QCommandApdu::ReadBinary, 0x00, 0x00, {}, 15);
+        return buildCommand(0x00, QCommandApdu::ReadBinary, 0x00, 0x00, {}, 15);
     case SelectNdefFileForRead:
     case SelectNdefFileForWrite:
-        return QCommandApdu::build(0x00, QCommandApdu::Select, 0x00, 0x0C, m_ndefFileId);
+        return buildCommand(0x00, QCommandApdu::Select, 0x00, 0x0C, m_ndefFileId);
     case ReadNdefMessageLength:
-        return QCommandApdu::build(0x00, QCommandApdu::ReadBinary, 0x00, 0x00, {}, 2);
+        return buildCommand(0x00, QCommandApdu::ReadBinary, 0x00, 0x00, {}, 2);
     case ReadNdefMessage: {
         uint16_t readSize = qMin(m_fileSize, m_maxReadSize);
 
-        return QCommandApdu::build(0x00, QCommandApdu::ReadBinary, m_fileOffset >> 8,
-                                   m_fileOffset & 0xFF, {}, readSize);
+        return buildCommand(0x00, QCommandApdu::ReadBinary, m_fileOffset >> 8,
+                            m_fileOffset & 0xFF, {}, readSize);
     }
     case ClearNdefLength:
         m_fileOffset = 2;
         m_fileSize = m_ndefData.size();
-        return QCommandApdu::build(0x00, QCommandApdu::UpdateBinary, 0x00, 0x00,
-                                   QByteArrayView::fromArray(ZeroLength));
+        return buildCommand(0x00, QCommandApdu::UpdateBinary, 0x00, 0x00,
+                            QByteArrayView::fromArray(ZeroLength));
     case WriteNdefFile: {
         uint16_t updateSize = qMin(m_fileSize, m_maxUpdateSize);
         uint16_t fileOffset = m_fileOffset;
@@ -60,14 +75,16 @@ QByteArray QNfcTagType4NdefFsm::getCommand(QNdefAccessFsm::Action &nextAction)
         m_fileOffset += updateSize;
         m_fileSize -= updateSize;
 
-        return QCommandApdu::build(0x00, QCommandApdu::UpdateBinary, fileOffset >> 8,
-                                   fileOffset & 0xFF, m_ndefData.mid(fileOffset - 2, updateSize));
+        return buildCommand(0x00, QCommandApdu::UpdateBinary, fileOffset >> 8,
+                            fileOffset & 0xFF,
+                            QByteArrayView(m_ndefData).sliced(fileOffset - 2, updateSize));
     }
     case WriteNdefLength: {
-        QByteArray data(2, Qt::Uninitialized);
-        qToUnaligned(qToBigEndian<uint16_t>(m_ndefData.size()), data.data());
+        char data[2];
+        qToUnaligned(qToBigEndian<uint16_t>(m_ndefData.size()), data);
 
-        return QCommandApdu::build(0x00, QCommandApdu::UpdateBinary, 0x00, 0x00, data);
+        return buildCommand(0x00, QCommandApdu::UpdateBinary, 0x00, 0x00,
+                            QByteArrayView(data, sizeof(data)));
     }
     default:
         nextAction = Unexpected;
@@ -78,8 +95,17 @@ QByteArray QNfcTagType4NdefFsm::getCommand(QNdefAccessFsm::Action &nextAction)
 QNdefMessage QNfcTagType4NdefFsm::getMessage(QNdefAccessFsm::Action &nextAction)
 {
     if (m_currentState == NdefMessageRead) {
-        auto message = QNdefMessage::fromByteArray(m_ndefData);
-        m_ndefData.clear();
+        QNdefMessage message;
+        if (m_cachedMessage) {
+            message = *m_cachedMessage;
+            m_cachedMessage.reset();
+        } else {
+            const bool decoded = m_decoder.finish() == QNdefMessageDecoder::Finished;
+            message = m_decoder.takeMessage();
+            m_decoder = QNdefMessageDecoder();
+            if (decoded && m_cache)
+                m_cache->insert(m_uid, m_ndefLengthField, message);
+        }
         m_currentState = NdefSupportDetected;
         nextAction = Done;
         return message;
@@ -89,6 +115,49 @@ QNdefMessage QNfcTagType4NdefFsm::getMessage(QNdefAccessFsm::Action &nextAction)
     return {};
 }
 
+QList<QNdefRecord> QNfcTagType4NdefFsm::getRecords(QNdefAccessFsm::Action &nextAction)
+{
+    if (m_currentState == ReadNdefMessage) {
+        nextAction = SendCommand;
+        return m_decoder.takeNewRecords();
+    } else if (m_currentState == NdefMessageRead) {
+        nextAction = GetMessage;
+        if (m_cachedMessage)
+            return *m_cachedMessage;
+        return m_decoder.takeNewRecords();
+    }
+
+    nextAction = Unexpected;
+    return {};
+}
+
+void QNfcTagType4NdefFsm::setMessageCache(std::shared_ptr<QNdefMessageCache> cache,
+                                          const QByteArray &uid)
+{
+    if (uid.isEmpty())
+        return;
+
+    m_cache = std::move(cache);
+    m_uid = uid;
+}
+
+void QNfcTagType4NdefFsm::invalidateSelection()
+{
+    m_ndefFileSelected = false;
+    m_knownData.reset();
+}
+
+/*
+    The selection is kept, a read that finds another file selected repeats
+    its SELECTs and a write always sends them. The known content is not kept,
+    the cache validates only the length of a message and a write must not
+    skip chunks based on content that may have been changed.
+*/
+void QNfcTagType4NdefFsm::endTransaction()
+{
+    m_knownData.reset();
+}
+
 QNdefAccessFsm::Action QNfcTagType4NdefFsm::detectNdefSupport()
 {
     switch (m_currentState) {
@@ -111,8 +180,14 @@ QNdefAccessFsm::Action QNfcTagType4NdefFsm::readMessages()
         m_targetState = NdefMessageRead;
         return SendCommand;
     case NdefSupportDetected:
-        m_currentState = SelectApplicationForRead;
         m_targetState = NdefMessageRead;
+        if (m_ndefFileSelected) {
+            qCDebug(QT_NFC_T4T) << "NDEF file is still selected";
+            m_selectionSkipped = true;
+            m_currentState = ReadNdefMessageLength;
+        } else {
+            m_currentState = SelectApplicationForRead;
+        }
         return SendCommand;
     case NdefNotSupported:
         return Failed;
@@ -131,10 +206,25 @@ QNdefAccessFsm::Action QNfcTagType4NdefFsm::writeMessages(const QList<QNdefMessa
     if (messageData.size() > m_maxNdefSize - 2)
         return Failed;
 
+    // The known content was read or written in this transaction, nobody else
+    // could have changed it since
+    if (m_currentState == NdefSupportDetected && m_writable && m_knownData == messageData) {
+        qCDebug(QT_NFC_T4T) << "NDEF message is unchanged, not writing it";
+        return Done;
+    }
+
     m_ndefData = messageData;
+    m_writtenMessage = messages.first();
 
     m_targetState = NdefMessageWritten;
 
+    // Whatever happens, the cached message is no longer valid
+    if (m_cache)
+        m_cache->remove(m_uid);
+
+    // Neither is the known content, a failed write may leave any of it behind
+    m_writeBase = std::exchange(m_knownData, std::nullopt);
+
     switch (m_currentState) {
     case SelectApplicationForProbe:
         return SendCommand;
@@ -146,6 +236,9 @@ QNdefAccessFsm::Action QNfcTagType4NdefFsm::writeMessages(const QList<QNdefMessa
         if (!m_writable)
             return Failed;
 
+        // A write always selects the NDEF file again. Another process
+        // sharing the reader may have selected a different file since the
+        // last operation, and an UPDATE BINARY would then overwrite it.
         m_currentState = SelectApplicationForWrite;
         return SendCommand;
 
@@ -154,21 +247,29 @@ QNdefAccessFsm::Action QNfcTagType4NdefFsm::writeMessages(const QList<QNdefMessa
     };
 }
 
-QNdefAccessFsm::Action QNfcTagType4NdefFsm::provideResponse(const QByteArray &response)
+QNdefAccessFsm::Action QNfcTagType4NdefFsm::provideResponse(QByteArrayView response)
 {
     QResponseApdu apdu(response);
 
+    // A failed command may leave any file selected
+    if (!apdu.isOk())
+        m_ndefFileSelected = false;
+
     switch (m_currentState) {
     case SelectApplicationForProbe:
+        m_ndefFileSelected = false;
         return handleSimpleResponse(apdu, SelectCCFile, NdefNotSupported);
     case SelectCCFile:
+        m_ndefFileSelected = false;
         return handleSimpleResponse(apdu, ReadCCFile, NdefNotSupported);
     case ReadCCFile:
         return handleReadCCResponse(apdu);
 
     case SelectApplicationForRead:
+        m_ndefFileSelected = false;
         return handleSimpleResponse(apdu, SelectNdefFileForRead, NdefSupportDetected);
     case SelectNdefFileForRead:
+        m_ndefFileSelected = apdu.isOk();
         return handleSimpleResponse(apdu, ReadNdefMessageLength, NdefSupportDetected);
     case ReadNdefMessageLength:
         return handleReadFileLengthResponse(apdu);
@@ -176,15 +277,17 @@ QNdefAccessFsm::Action QNfcTagType4NdefFsm::provideResponse(const QByteArray &re
         return handleReadFileResponse(apdu);
 
     case SelectApplicationForWrite:
+        m_ndefFileSelected = false;
         return handleSimpleResponse(apdu, SelectNdefFileForWrite, NdefSupportDetected);
     case SelectNdefFileForWrite:
+        m_ndefFileSelected = apdu.isOk();
         return handleSimpleResponse(apdu, ClearNdefLength, NdefSupportDetected);
     case ClearNdefLength:
-        return handleSimpleResponse(apdu, WriteNdefFile, NdefSupportDetected);
+        return handleClearNdefLengthResponse(apdu);
     case WriteNdefFile:
         return handleWriteNdefFileResponse(apdu);
     case WriteNdefLength:
-        return handleSimpleResponse(apdu, NdefSupportDetected, NdefSupportDetected, Done);
+        return handleWriteNdefLengthResponse(apdu);
 
     default:
         return Unexpected;
@@ -204,6 +307,18 @@ QNdefAccessFsm::Action QNfcTagType4NdefFsm::handleSimpleResponse(
     return okAction;
 }
 
+/*
+    Starts the current task again with the SELECTs it skipped, the card may
+    have been used by someone else in between.
+*/
+QNdefAccessFsm::Action QNfcTagType4NdefFsm::retryWithSelection(State selectState)
+{
+    qCDebug(QT_NFC_T4T) << "Command failed without SELECT, selecting the NDEF file again";
+    m_ndefFileSelected = false;
+    m_currentState = selectState;
+    return SendCommand;
+}
+
 QNdefAccessFsm::Action QNfcTagType4NdefFsm::handleReadCCResponse(const QResponseApdu &response)
 {
     m_currentState = NdefNotSupported;
@@ -217,16 +332,16 @@ QNdefAccessFsm::Action QNfcTagType4NdefFsm::handleReadCCResponse(const QResponse
     }
 
     qsizetype idx = 0;
-    auto readU8 = [&data = response.data(), &idx]() {
+    auto readU8 = [data = response.data(), &idx]() {
         return static_cast<uint8_t>(data.at(idx++));
     };
-    auto readU16 = [&data = response.data(), &idx]() {
+    auto readU16 = [data = response.data(), &idx]() {
         Q_ASSERT(idx >= 0 && idx <= data.size() - 2);
         uint16_t res = qFromBigEndian(qFromUnaligned<uint16_t>(data.constData() + idx));
         idx += 2;
         return res;
     };
-    auto readBytes = [&data = response.data(), &idx](qsizetype count) {
+    auto readBytes = [data = response.data(), &idx](qsizetype count) {
         auto res = data.sliced(idx, count);
         idx += count;
         return res;
@@ -248,6 +363,19 @@ QNdefAccessFsm::Action QNfcTagType4NdefFsm::handleReadCCResponse(const QResponse
     }
 
     m_maxUpdateSize = readU16();
+
+    // Use extended length APDUs if both the tag and the reader support them,
+    // so that large messages need fewer commands.
+    if (m_maxCommandLength > QCommandApdu::MaxShortLength) {
+        m_maxUpdateSize = qMin<int>(m_maxUpdateSize,
+                                    m_maxCommandLength - QCommandApdu::ExtendedHeaderLength);
+    } else {
+        m_maxReadSize = qMin(m_maxReadSize, QCommandApdu::MaxShortNe);
+        m_maxUpdateSize = qMin(m_maxUpdateSize, QCommandApdu::MaxShortNc);
+    }
+    qCDebug(QT_NFC_T4T) << "Maximum read size" << m_maxReadSize << "update size"
+                        << m_maxUpdateSize;
+
     auto tlvTag = readU8();
     if (tlvTag != 0x04) {
         qCDebug(QT_NFC_T4T) << "Invalid TLV tag";
@@ -258,7 +386,7 @@ QNdefAccessFsm::Action QNfcTagType4NdefFsm::handleReadCCResponse(const QResponse
         qCDebug(QT_NFC_T4T) << "Invalid TLV size";
         return Failed;
     }
-    m_ndefFileId = readBytes(2);
+    m_ndefFileId = readBytes(2).toByteArray();
 
     m_maxNdefSize = readU16();
     if (m_maxNdefSize < 2) {
@@ -314,25 +442,47 @@ QNdefAccessFsm::Action QNfcTagType4NdefFsm::handleReadCCResponse(const QResponse
 QNdefAccessFsm::Action
 QNfcTagType4NdefFsm::handleReadFileLengthResponse(const QResponseApdu &response)
 {
+    const bool selectionSkipped = std::exchange(m_selectionSkipped, false);
     if (!response.isOk() || response.data().size() < 2) {
+        if (selectionSkipped)
+            return retryWithSelection(SelectApplicationForRead);
         m_currentState = NdefSupportDetected;
         return Failed;
     }
 
     m_fileSize = qFromBigEndian(qFromUnaligned<uint16_t>(response.data().constData()));
     if (m_fileSize > m_maxNdefSize - 2) {
+        if (selectionSkipped)
+            return retryWithSelection(SelectApplicationForRead);
         m_currentState = NdefSupportDetected;
         return Failed;
     }
 
     m_fileOffset = 2;
-    m_ndefData.clear();
+    m_decoder = QNdefMessageDecoder();
+    m_ndefLengthField = response.data().first(2).toByteArray();
+    m_readData.clear();
+    if (m_knownData && m_knownData->size() != m_fileSize)
+        m_knownData.reset();
+
+    // A message of the same length is assumed to be unchanged
+    if (m_cache && m_fileSize != 0) {
+        m_cachedMessage = m_cache->find(m_uid, m_ndefLengthField);
+        if (m_cachedMessage) {
+            qCDebug(QT_NFC_T4T) << "Using the cached NDEF message";
+            m_currentState = NdefMessageRead;
+            return GetRecords;
+        }
+    }
 
     if (m_fileSize == 0) {
+        m_knownData = QByteArray();
         m_currentState = NdefMessageRead;
         return GetMessage;
     }
 
+    m_knownData.reset();
+
     m_currentState = ReadNdefMessage;
     return SendCommand;
 }
@@ -345,16 +495,21 @@ QNdefAccessFsm::Action QNfcTagType4NdefFsm::handleReadFileResponse(const QRespon
     }
 
     auto readSize = qMin<qsizetype>(m_fileSize, response.data().size());
-    m_ndefData.append(response.data().first(readSize));
+    m_decoder.addData(response.data().first(readSize));
+    m_readData.append(response.data().first(readSize));
     m_fileOffset += readSize;
     m_fileSize -= readSize;
 
-    if (m_fileSize == 0) {
+    // There is no need to read the rest of a message that cannot be decoded
+    if (m_fileSize == 0 || m_decoder.status() != QNdefMessageDecoder::NeedMoreData)
         m_currentState = NdefMessageRead;
-        return GetMessage;
-    }
+    if (m_fileSize == 0)
+        m_knownData = std::exchange(m_readData, QByteArray());
 
-    return SendCommand;
+    if (m_decoder.hasNewRecords())
+        return GetRecords;
+
+    return m_currentState == NdefMessageRead ? GetMessage : SendCommand;
 }
 
 QNdefAccessFsm::Action
@@ -365,10 +520,61 @@ QNfcTagType4NdefFsm::handleWriteNdefFileResponse(const QResponseApdu &response)
         return Failed;
     }
 
+    skipUnchangedData();
     if (m_fileSize == 0)
         m_currentState = WriteNdefLength;
 
     return SendCommand;
 }
 
+/*
+    Moves the write position past the data which the NDEF file already has.
+    The chunks written afterwards may still contain unchanged bytes, which is
+    cheaper than an extra command.
+*/
+void QNfcTagType4NdefFsm::skipUnchangedData()
+{
+    if (!m_writeBase)
+        return;
+
+    const QByteArray &base = *m_writeBase;
+    qsizetype index = m_fileOffset - 2;
+    while (m_fileSize > 0 && index < base.size() && base.at(index) == m_ndefData.at(index)) {
+        ++index;
+        ++m_fileOffset;
+        --m_fileSize;
+    }
+}
+
+QNdefAccessFsm::Action
+QNfcTagType4NdefFsm::handleClearNdefLengthResponse(const QResponseApdu &response)
+{
+    if (!response.isOk()) {
+        m_currentState = NdefSupportDetected;
+        return Failed;
+    }
+
+    skipUnchangedData();
+    m_currentState = m_fileSize == 0 ? WriteNdefLength : WriteNdefFile;
+    return SendCommand;
+}
+
+QNdefAccessFsm::Action
+QNfcTagType4NdefFsm::handleWriteNdefLengthResponse(const QResponseApdu &response)
+{
+    m_currentState = NdefSupportDetected;
+    m_writeBase.reset();
+    if (!response.isOk())
+        return Failed;
+
+    // The data now on the tag is known exactly
+    m_knownData = m_ndefData;
+    if (m_cache) {
+        QByteArray lengthField(2, Qt::Uninitialized);
+        qToUnaligned(qToBigEndian<uint16_t>(m_ndefData.size()), lengthField.data());
+        m_cache->insert(m_uid, lengthField, m_writtenMessage);
+    }
+    return Done;
+}
+
 QT_END_NAMESPACE
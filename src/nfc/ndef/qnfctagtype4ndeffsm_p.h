@@ -17,15 +17,27 @@
 
 #include "qndefaccessfsm_p.h"
 #include "qapduutils_p.h"
+#include "qndefmessagedecoder_p.h"
+
+#include <optional>
 
 QT_BEGIN_NAMESPACE
 
 class QNfcTagType4NdefFsm : public QNdefAccessFsm
 {
 public:
+    explicit QNfcTagType4NdefFsm(int maxCommandLength = QCommandApdu::MaxShortLength)
+        : m_maxCommandLength(maxCommandLength)
+    {
+    }
+
     QByteArray getCommand(Action &nextAction) override;
     QNdefMessage getMessage(Action &nextAction) override;
-    Action provideResponse(const QByteArray &response) override;
+    QList<QNdefRecord> getRecords(Action &nextAction) override;
+    void setMessageCache(std::shared_ptr<QNdefMessageCache> cache, const QByteArray &uid) override;
+    void invalidateSelection() override;
+    void endTransaction() override;
+    Action provideResponse(QByteArrayView response) override;
 
     Action detectNdefSupport() override;
     Action readMessages() override;
@@ -56,6 +68,9 @@ private:
     State m_currentState = SelectApplicationForProbe;
     State m_targetState = SelectApplicationForProbe;
 
+    // The longest command APDU the reader accepts
+    const int m_maxCommandLength;
+
     // Initialized during the detection phase
     uint16_t m_maxReadSize;
     uint16_t m_maxUpdateSize;
@@ -63,14 +78,43 @@ private:
     uint16_t m_maxNdefSize = 0xFFFF;
     bool m_writable;
 
+    // The NDEF file stays selected between the tasks, unless the selection
+    // is invalidated. A read which skipped the SELECTs repeats them once if
+    // its first command fails. A write never skips them.
+    bool m_ndefFileSelected = false;
+    bool m_selectionSkipped = false;
+
+    // The content of the NDEF file after NLEN, as read or written earlier in
+    // the current PC/SC transaction. A write then only updates the chunks
+    // which differ.
+    std::optional<QByteArray> m_knownData;
+    std::optional<QByteArray> m_writeBase;
+
     // Used during the read and write operations
     uint16_t m_fileSize;
     uint16_t m_fileOffset;
     QByteArray m_ndefData;
-
+    QByteArray m_readData;
+    QNdefMessage m_writtenMessage;
+    QNdefMessageDecoder m_decoder;
+    // Holds the last command, see buildCommand()
+    QByteArray m_command;
+
+    // The NLEN field validates the cached message
+    std::shared_ptr<QNdefMessageCache> m_cache;
+    QByteArray m_uid;
+    QByteArray m_ndefLengthField;
+    std::optional<QNdefMessage> m_cachedMessage;
+
+    QByteArray buildCommand(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2,
+                            QByteArrayView data = {}, uint16_t ne = 0);
     Action handleSimpleResponse(const QResponseApdu &response, State okState, State failedState,
                                 Action okAction = SendCommand);
 
+    Action retryWithSelection(State selectState);
+    void skipUnchangedData();
+    Action handleClearNdefLengthResponse(const QResponseApdu &response);
+    Action handleWriteNdefLengthResponse(const QResponseApdu &response);
     Action handleReadCCResponse(const QResponseApdu &response);
     Action handleReadFileLengthResponse(const QResponseApdu &response);
     Action handleReadFileResponse(const QResponseApdu &response);
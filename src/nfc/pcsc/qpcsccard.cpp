@@ -2,8 +2,11 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include "qpcsccard_p.h"
+#include "ndef/qnfctagtype2ndeffsm_p.h"
 #include "ndef/qnfctagtype4ndeffsm_p.h"
 #include "qapduutils_p.h"
+#include "qnfctimings_p.h"
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QTimer>
 
@@ -31,35 +34,45 @@ Q_DECLARE_LOGGING_CATEGORY(QT_NFC_PCSC)
 static constexpr int KeepAliveIntervalMs = 2500;
 
 /*
-    Start a temporary transaction if a persistent transaction was not already
-    started due to call to onSendCommandRequest().
+    Start a temporary transaction if neither a persistent transaction was
+    started due to call to onSendCommandRequest(), nor an enclosing temporary
+    transaction is active.
 
-    If a temporary transaction was initiated, it is ended when this object is
-    destroyed.
+    Nested objects share the transaction of the outermost one, so that a whole
+    operation made of several steps costs a single begin/end pair. It is ended
+    when the outermost object is destroyed.
 */
 QPcscCard::Transaction::Transaction(QPcscCard *card) : m_card(card)
 {
     qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
-    if (!m_card->isValid() || m_card->m_inAutoTransaction)
+    if (!m_card->isValid())
         return;
 
-    auto ret = SCardBeginTransaction(m_card->m_handle);
-    if (ret != SCARD_S_SUCCESS) {
-        qCWarning(QT_NFC_PCSC) << "SCardBeginTransaction failed:" << QPcsc::errorMessage(ret);
-        m_card->invalidate();
-        return;
+    if (m_card->m_transactionDepth == 0 && !m_card->m_inAutoTransaction) {
+        auto ret = SCardBeginTransaction(m_card->m_handle);
+        if (ret != SCARD_S_SUCCESS) {
+            qCWarning(QT_NFC_PCSC) << "SCardBeginTransaction failed:" << QPcsc::errorMessage(ret);
+            m_card->invalidate();
+            return;
+        }
     }
 
+    ++m_card->m_transactionDepth;
     m_initiated = true;
 }
 
 QPcscCard::Transaction::~Transaction()
 {
     qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
-    if (!m_initiated || !m_card->isValid())
+    if (!m_initiated)
+        return;
+
+    if (--m_card->m_transactionDepth > 0 || !m_card->isValid() || m_card->m_inAutoTransaction)
         return;
 
     auto ret = SCardEndTransaction(m_card->m_handle, SCARD_LEAVE_CARD);
+    if (m_card->m_tagDetectionFsm)
+        m_card->m_tagDetectionFsm->endTransaction();
 
     if (ret != SCARD_S_SUCCESS) {
         qCWarning(QT_NFC_PCSC) << "SCardEndTransaction failed:" << QPcsc::errorMessage(ret);
@@ -68,7 +81,7 @@ QPcscCard::Transaction::~Transaction()
 }
 
 QPcscCard::QPcscCard(SCARDHANDLE handle, DWORD protocol, QObject *parent)
-    : QObject(parent), m_handle(handle)
+    : QObject(parent), m_handle(handle), m_timings(std::make_shared<QNfcTimings>())
 {
     qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
 
@@ -79,10 +92,41 @@ QPcscCard::QPcscCard(SCARDHANDLE handle, DWORD protocol, QObject *parent)
     m_ioPci.dwProtocol = protocol;
     m_ioPci.cbPciLength = sizeof(m_ioPci);
 
-    // Assume that everything is NFC Tag Type 4 for now
-    m_tagDetectionFsm = std::make_unique<QNfcTagType4NdefFsm>();
+    // Everything that is needed to announce the card is read in one transaction
+    Transaction transaction(this);
+
+    m_maxInputLength = readMaxInputLength();
+    m_uid = readUid();
 
+    // Try NFC Tag Type 4 first, then Type 2. The reader limits the size of
+    // the APDUs.
+    m_tagDetectionFsm = std::make_unique<QNfcTagType4NdefFsm>(m_maxInputLength);
     performNdefDetection();
+
+    if (m_supportsNdef) {
+        m_tagType = QNearFieldTarget::NfcTagType4;
+    } else if (m_isValid) {
+        m_tagDetectionFsm = std::make_unique<QNfcTagType2NdefFsm>(m_maxInputLength);
+        performNdefDetection();
+        if (m_supportsNdef)
+            m_tagType = QNearFieldTarget::NfcTagType2;
+    }
+}
+
+/*
+    Measures the time an NDEF operation spends outside of SCardTransmit().
+*/
+QPcscCard::NdefTiming::NdefTiming(QPcscCard *card)
+    : m_card(card), m_transmitNsecs(card->m_transmitNsecs)
+{
+    m_timer.start();
+}
+
+QPcscCard::NdefTiming::~NdefTiming()
+{
+    const qint64 transmitNsecs = m_card->m_transmitNsecs - m_transmitNsecs;
+    m_card->m_timings->record(QNearFieldTarget::Timing::NdefProcessing,
+                              m_timer.nsecsElapsed() - transmitNsecs);
 }
 
 QPcscCard::~QPcscCard()
@@ -99,6 +143,7 @@ void QPcscCard::performNdefDetection()
         return;
 
     Transaction transaction(this);
+    NdefTiming timing(this);
 
     auto action = m_tagDetectionFsm->detectNdefSupport();
 
@@ -106,8 +151,7 @@ void QPcscCard::performNdefDetection()
         auto command = m_tagDetectionFsm->getCommand(action);
 
         if (action == QNdefAccessFsm::ProvideResponse) {
-            auto result = sendCommand(command, NoAutoTransaction);
-            action = m_tagDetectionFsm->provideResponse(result.response);
+            action = m_tagDetectionFsm->provideResponse(transmit(command));
         }
     }
 
@@ -152,7 +196,7 @@ void QPcscCard::invalidate()
     that either the command is atomic or that a temporary transaction is started
     using Transaction object.
 */
-QPcsc::RawCommandResult QPcscCard::sendCommand(const QByteArray &command,
+QPcsc::RawCommandResult QPcscCard::sendCommand(QByteArrayView command,
                                                QPcscCard::AutoTransaction autoTransaction)
 {
     if (!m_isValid)
@@ -161,36 +205,79 @@ QPcsc::RawCommandResult QPcscCard::sendCommand(const QByteArray &command,
     if (!m_inAutoTransaction && autoTransaction == StartAutoTransaction) {
         qCDebug(QT_NFC_PCSC) << "Starting transaction";
 
-        // FIXME: Is there a timeout on this?
-        auto ret = SCardBeginTransaction(m_handle);
-        if (ret != SCARD_S_SUCCESS) {
-            qCWarning(QT_NFC_PCSC) << "SCardBeginTransaction failed:" << QPcsc::errorMessage(ret);
-            invalidate();
-            return {};
+        // A temporary transaction that is already active is taken over
+        if (m_transactionDepth == 0) {
+            // FIXME: Is there a timeout on this?
+            auto ret = SCardBeginTransaction(m_handle);
+            if (ret != SCARD_S_SUCCESS) {
+                qCWarning(QT_NFC_PCSC)
+                        << "SCardBeginTransaction failed:" << QPcsc::errorMessage(ret);
+                invalidate();
+                return {};
+            }
         }
         m_inAutoTransaction = true;
-        m_keepAliveTimer->start();
     }
 
     QPcsc::RawCommandResult result;
-    result.response.resize(0xFFFF + 2);
-    DWORD recvLength = result.response.size();
+    QByteArrayView response = transmit(command, &result.ret);
+    // Copy only the response, the buffer is reused
+    if (result.isOk())
+        result.response = response.toByteArray();
 
-    qCDebug(QT_NFC_PCSC) << "TX:" << command.toHex(':');
+    return result;
+}
+
+/*
+    Sends the given command to the card in the current transaction.
+
+    Returns the response, or an empty view if the transmission failed. The
+    view refers to the receive buffer and is valid until the next command is
+    sent, which lets the NDEF access parse responses without copying them.
+*/
+QByteArrayView QPcscCard::transmit(QByteArrayView command, LONG *ret)
+{
+    if (!m_isValid) {
+        if (ret)
+            *ret = SCARD_E_READER_UNAVAILABLE;
+        return {};
+    }
 
-    result.ret = SCardTransmit(m_handle, &m_ioPci, reinterpret_cast<LPCBYTE>(command.constData()),
-                               command.size(), nullptr,
-                               reinterpret_cast<LPBYTE>(result.response.data()), &recvLength);
-    if (result.ret != SCARD_S_SUCCESS) {
-        qCWarning(QT_NFC_PCSC) << "SCardTransmit failed:" << QPcsc::errorMessage(result.ret);
-        result.response.clear();
+    if (m_receiveBuffer.isEmpty())
+        m_receiveBuffer.resize(0xFFFF + 2);
+    DWORD recvLength = m_receiveBuffer.size();
+
+    qCDebug(QT_NFC_PCSC) << "TX:" << command.toByteArray().toHex(':');
+
+    QElapsedTimer timer;
+    timer.start();
+    const LONG result =
+            SCardTransmit(m_handle, &m_ioPci, reinterpret_cast<LPCBYTE>(command.constData()),
+                          command.size(), nullptr,
+                          reinterpret_cast<LPBYTE>(m_receiveBuffer.data()), &recvLength);
+    const qint64 elapsed = timer.nsecsElapsed();
+    m_transmitNsecs += elapsed;
+    m_timings->record(QNearFieldTarget::Timing::CommandRoundTrip, elapsed);
+    if (ret)
+        *ret = result;
+    if (result != SCARD_S_SUCCESS) {
+        // A transmit error is how a removed card is noticed during an operation
+        if (result == SCARD_W_REMOVED_CARD)
+            qCDebug(QT_NFC_PCSC) << "Card removed";
+        else
+            qCWarning(QT_NFC_PCSC) << "SCardTransmit failed:" << QPcsc::errorMessage(result);
         invalidate();
-    } else {
-        result.response.resize(recvLength);
-        qCDebug(QT_NFC_PCSC) << "RX:" << result.response.toHex(':');
+        return {};
     }
 
-    return result;
+    const QByteArrayView response = QByteArrayView(m_receiveBuffer).first(recvLength);
+    qCDebug(QT_NFC_PCSC) << "RX:" << response.toByteArray().toHex(':');
+
+    // The transmission kept the transaction alive, check the card only when idle
+    if (m_inAutoTransaction)
+        m_keepAliveTimer->start();
+
+    return response;
 }
 
 void QPcscCard::onKeepAliveTimeout()
@@ -203,15 +290,34 @@ void QPcscCard::onKeepAliveTimeout()
     checkCardPresent();
 }
 
+/*
+    Lets the NDEF access use the cached message of the card, if its content
+    has not changed. The cache is shared by all cards of the manager.
+*/
+void QPcscCard::setNdefMessageCache(std::shared_ptr<QNdefMessageCache> cache,
+                                    const QByteArray &uid)
+{
+    m_tagDetectionFsm->setMessageCache(std::move(cache), uid);
+}
+
+/*
+    Commands sent by the user, or a reset, may select anything on the card.
+*/
+void QPcscCard::invalidateNdefSelection()
+{
+    if (m_tagDetectionFsm)
+        m_tagDetectionFsm->invalidateSelection();
+}
+
 QByteArray QPcscCard::readUid()
 {
     QByteArray command = QCommandApdu::build(0xFF, QCommandApdu::GetData, 0x00, 0x00, {}, 256);
 
-    // Atomic command, no need for transaction.
-    QResponseApdu res(sendCommand(command, NoAutoTransaction).response);
+    // Atomic command, no need for transaction of its own.
+    QResponseApdu res(transmit(command));
     if (!res.isOk())
         return {};
-    return res.data();
+    return res.data().toByteArray();
 }
 
 void QPcscCard::onReadNdefMessagesRequest(const QNearFieldTarget::RequestId &request)
@@ -227,6 +333,7 @@ void QPcscCard::onReadNdefMessagesRequest(const QNearFieldTarget::RequestId &req
     }
 
     Transaction transaction(this);
+    NdefTiming timing(this);
 
     QList<QNdefMessage> messages;
 
@@ -237,12 +344,15 @@ void QPcscCard::onReadNdefMessagesRequest(const QNearFieldTarget::RequestId &req
             auto command = m_tagDetectionFsm->getCommand(nextState);
 
             if (nextState == QNdefAccessFsm::ProvideResponse) {
-                auto result = sendCommand(command, NoAutoTransaction);
-                nextState = m_tagDetectionFsm->provideResponse(result.response);
+                nextState = m_tagDetectionFsm->provideResponse(transmit(command));
             }
         } else if (nextState == QNdefAccessFsm::GetMessage) {
             auto message = m_tagDetectionFsm->getMessage(nextState);
             Q_EMIT ndefMessageRead(message);
+        } else if (nextState == QNdefAccessFsm::GetRecords) {
+            const auto records = m_tagDetectionFsm->getRecords(nextState);
+            for (const auto &record : records)
+                Q_EMIT ndefRecordRead(record);
         } else {
             break;
         }
@@ -280,6 +390,7 @@ void QPcscCard::onDisconnectRequest()
         }
 
         m_inAutoTransaction = false;
+        invalidateNdefSelection();
     }
 
     DWORD activeProtocol;
@@ -310,6 +421,7 @@ void QPcscCard::onSendCommandRequest(const QNearFieldTarget::RequestId &request,
         return;
     }
 
+    invalidateNdefSelection();
     auto result = sendCommand(command, StartAutoTransaction);
     if (result.isOk())
         Q_EMIT requestCompleted(request, QNearFieldTarget::NoError, result.response);
@@ -317,6 +429,43 @@ void QPcscCard::onSendCommandRequest(const QNearFieldTarget::RequestId &request,
         Q_EMIT requestCompleted(request, QNearFieldTarget::CommandError, {});
 }
 
+/*
+    Sends the commands of a batch back to back in the transaction of the
+    commands sent by the user. The batch stops early if a response does not
+    have the expected status word.
+*/
+void QPcscCard::onSendCommandsRequest(const QNearFieldTarget::RequestId &request,
+                                      const QList<QByteArray> &commands,
+                                      const QList<quint16> &expectedStatusWords)
+{
+    qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
+
+    if (!m_isValid) {
+        Q_EMIT requestCompleted(request, QNearFieldTarget::ConnectionError, {});
+        return;
+    }
+
+    invalidateNdefSelection();
+    QList<QByteArray> responses;
+    responses.reserve(commands.size());
+    for (qsizetype i = 0; i < commands.size(); ++i) {
+        auto result = sendCommand(commands.at(i), StartAutoTransaction);
+        if (!result.isOk()) {
+            Q_EMIT requestCompleted(request, QNearFieldTarget::CommandError, {});
+            return;
+        }
+        responses.append(result.response);
+        if (!QNearFieldTargetPrivate::hasExpectedStatusWord(result.response, expectedStatusWords,
+                                                            i)) {
+            qCDebug(QT_NFC_PCSC) << "Unexpected status, batch stopped after" << i + 1 << "of"
+                                 << commands.size() << "commands";
+            break;
+        }
+    }
+
+    Q_EMIT requestCompleted(request, QNearFieldTarget::NoError, QVariant::fromValue(responses));
+}
+
 void QPcscCard::onWriteNdefMessagesRequest(const QNearFieldTarget::RequestId &request,
                                            const QList<QNdefMessage> &messages)
 {
@@ -333,14 +482,14 @@ void QPcscCard::onWriteNdefMessagesRequest(const QNearFieldTarget::RequestId &re
     }
 
     Transaction transaction(this);
+    NdefTiming timing(this);
 
     auto nextState = m_tagDetectionFsm->writeMessages(messages);
 
     while (nextState == QNdefAccessFsm::SendCommand) {
         auto command = m_tagDetectionFsm->getCommand(nextState);
         if (nextState == QNdefAccessFsm::ProvideResponse) {
-            auto result = sendCommand(command, NoAutoTransaction);
-            nextState = m_tagDetectionFsm->provideResponse(result.response);
+            nextState = m_tagDetectionFsm->provideResponse(transmit(command));
         }
     }
 
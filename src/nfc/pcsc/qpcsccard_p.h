@@ -20,8 +20,11 @@
 #include "qnearfieldtarget.h"
 #include "ndef/qndefaccessfsm_p.h"
 
+#include <QtCore/QElapsedTimer>
+
 QT_BEGIN_NAMESPACE
 
+class QNfcTimings;
 class QTimer;
 
 class QPcscCard : public QObject
@@ -37,27 +40,45 @@ public:
     bool checkCardPresent();
     Q_INVOKABLE void enableAutodelete();
 
-    QByteArray readUid();
-    int readMaxInputLength();
+    QByteArray uid() const { return m_uid; }
+    int maxInputLength() const { return m_maxInputLength; }
+    // Created with the card, so that it covers the NDEF detection
+    std::shared_ptr<QNfcTimings> timings() const { return m_timings; }
 
     bool supportsNdef() const { return m_supportsNdef; }
+    QNearFieldTarget::Type tagType() const { return m_tagType; }
+    void setNdefMessageCache(std::shared_ptr<QNdefMessageCache> cache, const QByteArray &uid);
 
 private:
     SCARDHANDLE m_handle;
     SCARD_IO_REQUEST m_ioPci;
     bool m_isValid = true;
-    bool m_supportsNdef;
+    QByteArray m_uid;
+    int m_maxInputLength = 0;
+    bool m_supportsNdef = false;
+    QNearFieldTarget::Type m_tagType = QNearFieldTarget::ProprietaryTag;
     bool m_autodelete = false;
     // Indicates that an _automatic_ transaction was started
     bool m_inAutoTransaction = false;
+    // Number of active Transaction objects
+    int m_transactionDepth = 0;
     QTimer *m_keepAliveTimer;
+    // Large enough for any response, allocated once
+    QByteArray m_receiveBuffer;
+    std::shared_ptr<QNfcTimings> m_timings;
+    // Time spent in SCardTransmit() so far
+    qint64 m_transmitNsecs = 0;
 
     std::unique_ptr<QNdefAccessFsm> m_tagDetectionFsm;
 
     enum AutoTransaction { NoAutoTransaction, StartAutoTransaction };
 
-    QPcsc::RawCommandResult sendCommand(const QByteArray &command, AutoTransaction autoTransaction);
+    QPcsc::RawCommandResult sendCommand(QByteArrayView command, AutoTransaction autoTransaction);
+    QByteArrayView transmit(QByteArrayView command, LONG *ret = nullptr);
+    QByteArray readUid();
+    int readMaxInputLength();
     void performNdefDetection();
+    void invalidateNdefSelection();
 
     class Transaction
     {
@@ -70,11 +91,26 @@ private:
         bool m_initiated = false;
     };
 
+    class NdefTiming
+    {
+    public:
+        NdefTiming(QPcscCard *card);
+        ~NdefTiming();
+
+    private:
+        QPcscCard *m_card;
+        qint64 m_transmitNsecs;
+        QElapsedTimer m_timer;
+    };
+
 public Q_SLOTS:
     void onDisconnectRequest();
     void onTargetDestroyed();
     void onSendCommandRequest(const QNearFieldTarget::RequestId &request,
                               const QByteArray &command);
+    void onSendCommandsRequest(const QNearFieldTarget::RequestId &request,
+                               const QList<QByteArray> &commands,
+                               const QList<quint16> &expectedStatusWords);
     void onReadNdefMessagesRequest(const QNearFieldTarget::RequestId &request);
     void onWriteNdefMessagesRequest(const QNearFieldTarget::RequestId &request,
                                     const QList<QNdefMessage> &messages);
@@ -89,6 +125,7 @@ Q_SIGNALS:
     void requestCompleted(const QNearFieldTarget::RequestId &request,
                           QNearFieldTarget::Error reason, const QVariant &result);
     void ndefMessageRead(const QNdefMessage &message);
+    void ndefRecordRead(const QNdefRecord &record);
 };
 
 QT_END_NAMESPACE
@@ -3,8 +3,9 @@
 
 #include "qpcscmanager_p.h"
 #include "qpcscslot_p.h"
-#include "qpcsccard_p.h"
+#include "qpcscmonitor_p.h"
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QSet>
 #include <QtCore/QThread>
 #include <QtCore/QTimer>
 
@@ -12,9 +13,11 @@ QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_NFC_PCSC)
 
+// Used if the state changes cannot be monitored, and for retrying cards.
 static constexpr int StateUpdateIntervalMs = 1000;
 
-QPcscManager::QPcscManager(QObject *parent) : QObject(parent)
+QPcscManager::QPcscManager(std::shared_ptr<QNdefMessageCache> ndefCache, QObject *parent)
+    : QObject(parent), m_ndefCache(std::move(ndefCache))
 {
     qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
 
@@ -26,12 +29,11 @@ QPcscManager::QPcscManager(QObject *parent) : QObject(parent)
 QPcscManager::~QPcscManager()
 {
     qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
-    if (m_hasContext) {
-        // Destroy all card handles before destroying the PCSC context.
-        for (auto slot : std::as_const(m_slots))
-            slot->invalidateInsertedCard();
+    stopMonitor();
+    // The cards use the contexts of their slots, which invalidate them when
+    // the slots are destroyed.
+    if (m_hasContext)
         SCardReleaseContext(m_context);
-    }
 
     // Stop the worker thread.
     thread()->quit();
@@ -53,7 +55,7 @@ void QPcscManager::processSlotUpdates()
                              << slot->name();
 
         state.dwCurrentState = state.dwEventState;
-        slot->processStateChange(state.dwEventState, m_targetDetectionRunning);
+        slot->processStateChange(state.dwEventState, m_targetDetectionRunning, m_requestedMethod);
     }
 }
 
@@ -92,65 +94,14 @@ void QPcscManager::updateSlotList()
 {
     Q_ASSERT(m_hasContext);
 
-#ifndef SCARD_AUTOALLOCATE
-    // macOS does not support automatic allocation. Try using a fixed-size
-    // buffer first, extending it if it is not sufficient.
-#define LIST_READER_BUFFER_EXTRA 1024
-    QPcscSlotName buf(nullptr);
-    DWORD listSize = LIST_READER_BUFFER_EXTRA;
-    buf.resize(listSize);
-    QPcscSlotName::Ptr list = buf.ptr();
-
-    auto ret = SCardListReaders(m_context, nullptr, list, &listSize);
-#else
-    QPcscSlotName::Ptr list;
-    DWORD listSize = SCARD_AUTOALLOCATE;
-    auto ret = SCardListReaders(m_context, nullptr, reinterpret_cast<QPcscSlotName::Ptr>(&list),
-                                &listSize);
-#endif
-
-    if (ret == LONG(SCARD_E_NO_READERS_AVAILABLE)) {
-        list = nullptr;
-        ret = SCARD_S_SUCCESS;
-    }
-#ifndef SCARD_AUTOALLOCATE
-    else if (ret == LONG(SCARD_E_INSUFFICIENT_BUFFER)) {
-        // SCardListReaders() has set listSize to the required size. We add
-        // extra space to reduce possibility of failure if the reader list has
-        // changed since the last call.
-        listSize += LIST_READER_BUFFER_EXTRA;
-        buf.resize(listSize);
-        list = buf.ptr();
-
-        ret = SCardListReaders(m_context, nullptr, list, &listSize);
-        if (ret == LONG(SCARD_E_NO_READERS_AVAILABLE)) {
-            list = nullptr;
-            ret = SCARD_S_SUCCESS;
-        }
-    }
-#undef LIST_READER_BUFFER_EXTRA
-#endif
-
+    QList<QPcscSlotName> readers;
+    const LONG ret = QPcsc::listReaders(m_context, &readers);
     if (ret != SCARD_S_SUCCESS) {
         qCDebug(QT_NFC_PCSC) << "Failed to list readers:" << QPcsc::errorMessage(ret);
         return;
     }
 
-#ifdef SCARD_AUTOALLOCATE
-    auto freeList = qScopeGuard([this, list] {
-        if (list) {
-            Q_ASSERT(m_hasContext);
-            SCardFreeMemory(m_context, list);
-        }
-    });
-#endif
-
-    QSet<QPcscSlotName> presentSlots;
-
-    if (list != nullptr) {
-        for (const auto *p = list; *p; p += QPcscSlotName::nameSize(p) + 1)
-            presentSlots.insert(QPcscSlotName(p));
-    }
+    QSet<QPcscSlotName> presentSlots(readers.cbegin(), readers.cend());
 
     // Check current state list and mark slots that are not present anymore to
     // be removed later.
@@ -169,7 +120,7 @@ void QPcscManager::updateSlotList()
 
     // Add new slots
     for (auto &&slotName : std::as_const(presentSlots)) {
-        QPcscSlot *slot = new QPcscSlot(slotName, this);
+        QPcscSlot *slot = new QPcscSlot(slotName, m_ndefCache, this);
         qCDebug(QT_NFC_PCSC) << "New slot:" << slot;
 
         m_slots[slotName] = slot;
@@ -199,18 +150,65 @@ bool QPcscManager::establishContext()
     return true;
 }
 
+/*
+    Starts waiting for state changes in a separate thread, falling back to
+    polling if that is not possible.
+*/
+void QPcscManager::startMonitor()
+{
+    if (m_monitor || m_monitorFailed)
+        return;
+
+    m_monitor = new QPcscMonitor(this);
+    if (!m_monitor->isValid()) {
+        delete m_monitor;
+        m_monitor = nullptr;
+        m_stateUpdateTimer->start();
+        return;
+    }
+
+    connect(m_monitor, &QPcscMonitor::stateChanged, this, &QPcscManager::onStateUpdate);
+    connect(m_monitor, &QPcscMonitor::failed, this, [this] {
+        qCDebug(QT_NFC_PCSC) << "Polling for state changes";
+        m_monitorFailed = true;
+        stopMonitor();
+        m_stateUpdateTimer->start();
+    });
+    m_monitor->start();
+    m_stateUpdateTimer->stop();
+}
+
+void QPcscManager::stopMonitor()
+{
+    if (!m_monitor)
+        return;
+
+    m_monitor->disconnect(this);
+    m_monitor->stop();
+    delete m_monitor;
+    m_monitor = nullptr;
+}
+
 void QPcscManager::onStateUpdate()
 {
     if (!m_hasContext) {
         if (!m_targetDetectionRunning) {
+            stopMonitor();
             m_stateUpdateTimer->stop();
             return;
         }
 
-        if (!establishContext())
+        if (!establishContext()) {
+            // The monitor only reports state changes, retry anyway.
+            if (m_monitor)
+                QTimer::singleShot(StateUpdateIntervalMs, this, &QPcscManager::onStateUpdate);
             return;
+        }
     }
 
+    if (m_targetDetectionRunning)
+        startMonitor();
+
     updateSlotList();
     removeSlots();
 
@@ -220,21 +218,14 @@ void QPcscManager::onStateUpdate()
             SCardReleaseContext(m_context);
             m_hasContext = false;
 
+            stopMonitor();
             m_stateUpdateTimer->stop();
         }
         return;
     }
 
-    // Both Windows and PCSCLite support interruptable continuos state detection
-    // where SCardCancel() can be used to abort it from another thread.
-    // But that introduces a problem of reliable cancelling of the status change
-    // call and no other. Reliable use of SCardCancel() would probably require
-    // some form of synchronization and polling, and would make the code much
-    // more complicated.
-    // Alternatively, the state detection code could run in a yet another thread
-    // that will not need to be cancelled too often.
-    // For simplicity, the current code just checks for status changes every
-    // second.
+    // The blocking wait for state changes runs in QPcscMonitor, which calls
+    // this whenever something changed. The states are only collected here.
     LONG ret = SCardGetStatusChange(m_context, 0, m_slotStates.data(), m_slotStates.size());
 
     if (ret == SCARD_S_SUCCESS || ret == LONG(SCARD_E_UNKNOWN_READER)) {
@@ -258,6 +249,9 @@ void QPcscManager::onStateUpdate()
         SCardReleaseContext(m_context);
         m_slots.clear();
         m_slotStates.clear();
+
+        if (m_monitor)
+            QTimer::singleShot(StateUpdateIntervalMs, this, &QPcscManager::onStateUpdate);
     }
 }
 
@@ -271,7 +265,10 @@ void QPcscManager::onStartTargetDetectionRequest(QNearFieldTarget::AccessMethod
         return;
 
     m_targetDetectionRunning = true;
-    m_stateUpdateTimer->start();
+    m_monitorFailed = false;
+    onStateUpdate();
+    if (!m_monitor)
+        m_stateUpdateTimer->start();
 }
 
 void QPcscManager::onStopTargetDetectionRequest()
@@ -280,52 +277,6 @@ void QPcscManager::onStopTargetDetectionRequest()
     m_targetDetectionRunning = false;
 }
 
-QPcscCard *QPcscManager::connectToCard(QPcscSlot *slot)
-{
-    qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
-    Q_ASSERT(slot != nullptr);
-    Q_ASSERT(m_hasContext);
-
-    SCARDHANDLE cardHandle;
-    DWORD activeProtocol;
-
-    LONG ret = SCardConnect(m_context, slot->name().ptr(), SCARD_SHARE_SHARED,
-                            SCARD_PROTOCOL_T0 | SCARD_PROTOCOL_T1, &cardHandle, &activeProtocol);
-    if (ret != SCARD_S_SUCCESS) {
-        qCDebug(QT_NFC_PCSC) << "Failed to connect to card:" << QPcsc::errorMessage(ret);
-        retryCardDetection(slot);
-        return nullptr;
-    }
-
-    auto card = new QPcscCard(cardHandle, activeProtocol, this);
-    auto uid = card->readUid();
-    auto maxInputLength = card->readMaxInputLength();
-
-    QNearFieldTarget::AccessMethods accessMethods = QNearFieldTarget::TagTypeSpecificAccess;
-    if (card->supportsNdef())
-        accessMethods |= QNearFieldTarget::NdefAccess;
-
-    if (m_requestedMethod != QNearFieldTarget::UnknownAccess
-        && (accessMethods & m_requestedMethod) == 0) {
-        qCDebug(QT_NFC_PCSC) << "Dropping card without required access support";
-        card->deleteLater();
-        return nullptr;
-    }
-
-    if (!card->isValid()) {
-        qCDebug(QT_NFC_PCSC) << "Card became invalid";
-        card->deleteLater();
-
-        retryCardDetection(slot);
-
-        return nullptr;
-    }
-
-    Q_EMIT cardInserted(card, uid, accessMethods, maxInputLength);
-
-    return card;
-}
-
 /*
     Setup states list so that the card detection for the given slot will
     be retried on the next iteration.
@@ -342,6 +293,10 @@ void QPcscManager::retryCardDetection(const QPcscSlot *slot)
             break;
         }
     }
+
+    // The monitor only reports new changes.
+    if (m_monitor)
+        QTimer::singleShot(StateUpdateIntervalMs, this, &QPcscManager::onStateUpdate);
 }
 
 QT_END_NAMESPACE
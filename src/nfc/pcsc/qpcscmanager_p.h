@@ -18,35 +18,44 @@
 #include "qpcsc_p.h"
 #include "qnearfieldtarget.h"
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
+class QNdefMessageCache;
 class QPcscSlot;
 class QPcscCard;
+class QPcscMonitor;
 class QTimer;
 
 class QPcscManager : public QObject
 {
     Q_OBJECT
 public:
-    explicit QPcscManager(QObject *parent = nullptr);
+    explicit QPcscManager(std::shared_ptr<QNdefMessageCache> ndefCache,
+                          QObject *parent = nullptr);
     ~QPcscManager() override;
 
-    QPcscCard *connectToCard(QPcscSlot *slot);
+    void retryCardDetection(const QPcscSlot *slot);
 
 private:
     QTimer *m_stateUpdateTimer;
+    QPcscMonitor *m_monitor = nullptr;
+    bool m_monitorFailed = false;
     bool m_targetDetectionRunning = false;
     bool m_hasContext = false;
     SCARDCONTEXT m_context;
     QMap<QPcscSlotName, QPcscSlot *> m_slots;
     QList<SCARD_READERSTATE> m_slotStates;
     QNearFieldTarget::AccessMethod m_requestedMethod;
+    const std::shared_ptr<QNdefMessageCache> m_ndefCache;
 
     [[nodiscard]] bool establishContext();
     void processSlotUpdates();
     void updateSlotList();
     void removeSlots();
-    void retryCardDetection(const QPcscSlot *slot);
+    void startMonitor();
+    void stopMonitor();
 
 public Q_SLOTS:
     void onStartTargetDetectionRequest(QNearFieldTarget::AccessMethod accessMethod);
@@ -56,7 +65,7 @@ private Q_SLOTS:
     void onStateUpdate();
 
 Q_SIGNALS:
-    void cardInserted(QPcscCard *card, const QByteArray &uid,
+    void cardInserted(QPcscCard *card, const QByteArray &uid, QNearFieldTarget::Type type,
                       QNearFieldTarget::AccessMethods accessMethods, int maxInputLength);
 };
 
@@ -0,0 +1,150 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qpcscmonitor_p.h"
+#include <QtCore/QHash>
+#include <QtCore/QLoggingCategory>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_NFC_PCSC)
+
+// Used for checking for new readers if the reader notifications are not
+// supported, as on macOS.
+static constexpr int FallbackIntervalMs = 1000;
+static constexpr int CancelRetryIntervalMs = 50;
+
+// The pseudo reader that changes its state when a reader is added or removed.
+#ifdef Q_OS_WIN
+static constexpr QPcscSlotName::CPtr PnPNotification = L"\\\\?PnP?\\Notification";
+#else
+static constexpr QPcscSlotName::CPtr PnPNotification = "\\\\?PnP?\\Notification";
+#endif
+
+QPcscMonitor::QPcscMonitor(QObject *parent) : QThread(parent)
+{
+    setObjectName(QStringLiteral("QtNfcMonitorThread"));
+
+    LONG ret = SCardEstablishContext(SCARD_SCOPE_USER, nullptr, nullptr, &m_context);
+    if (ret != SCARD_S_SUCCESS) {
+        qCDebug(QT_NFC_PCSC) << "Failed to establish monitor context:" << QPcsc::errorMessage(ret);
+        return;
+    }
+    m_hasContext = true;
+}
+
+QPcscMonitor::~QPcscMonitor()
+{
+    stop();
+    if (m_hasContext)
+        SCardReleaseContext(m_context);
+}
+
+void QPcscMonitor::stop()
+{
+    m_stopRequested.storeRelaxed(true);
+    m_stopSemaphore.release();
+
+    // SCardCancel() only aborts a wait which is in progress, repeat it in case
+    // the thread was about to start waiting.
+    do {
+        if (m_hasContext)
+            SCardCancel(m_context);
+    } while (!wait(CancelRetryIntervalMs));
+}
+
+void QPcscMonitor::run()
+{
+    Q_ASSERT(m_hasContext);
+
+    bool pnpSupported = true;
+    bool readersChanged = true;
+    DWORD pnpState = SCARD_STATE_UNAWARE;
+    QList<QPcscSlotName> readers;
+    QList<SCARD_READERSTATE> states;
+
+    while (!m_stopRequested.loadRelaxed()) {
+        if (readersChanged) {
+            readersChanged = false;
+
+            QList<QPcscSlotName> presentReaders;
+            const LONG ret = QPcsc::listReaders(m_context, &presentReaders);
+            if (ret != SCARD_S_SUCCESS) {
+                qCWarning(QT_NFC_PCSC) << "Failed to list readers:" << QPcsc::errorMessage(ret);
+                Q_EMIT failed();
+                return;
+            }
+            if (!pnpSupported && presentReaders != readers)
+                Q_EMIT stateChanged();
+
+            // Keep the known states, so that only new changes wake us up.
+            QHash<QPcscSlotName, DWORD> knownStates;
+            for (const auto &state : std::as_const(states)) {
+                if (state.szReader != PnPNotification)
+                    knownStates.insert(QPcscSlotName(state.szReader), state.dwCurrentState);
+                else
+                    pnpState = state.dwCurrentState;
+            }
+
+            readers = presentReaders;
+            states.clear();
+            if (pnpSupported) {
+                SCARD_READERSTATE state {};
+                state.szReader = PnPNotification;
+                state.dwCurrentState = pnpState;
+                states.append(state);
+            }
+            for (const auto &reader : std::as_const(readers)) {
+                SCARD_READERSTATE state {};
+                state.szReader = reader.ptr();
+                state.dwCurrentState = knownStates.value(reader, SCARD_STATE_UNAWARE);
+                states.append(state);
+            }
+        }
+
+        if (states.isEmpty()) {
+            // Neither readers nor reader notifications to wait for.
+            if (m_stopSemaphore.tryAcquire(1, FallbackIntervalMs))
+                return;
+            readersChanged = true;
+            continue;
+        }
+
+        const DWORD timeout = pnpSupported ? INFINITE : FallbackIntervalMs;
+        const LONG ret = SCardGetStatusChange(m_context, timeout, states.data(), states.size());
+
+        if (ret == SCARD_S_SUCCESS) {
+            bool changed = false;
+            for (auto &state : states) {
+                if ((state.dwEventState & SCARD_STATE_CHANGED) == 0)
+                    continue;
+                changed = true;
+                if (state.szReader == PnPNotification
+                    || (state.dwEventState & SCARD_STATE_UNKNOWN) != 0) {
+                    readersChanged = true;
+                }
+                state.dwCurrentState = state.dwEventState & ~DWORD(SCARD_STATE_CHANGED);
+            }
+            if (changed)
+                Q_EMIT stateChanged();
+        } else if (ret == LONG(SCARD_E_TIMEOUT)) {
+            readersChanged = !pnpSupported;
+        } else if (ret == LONG(SCARD_E_CANCELLED)) {
+            /* stop() was called */
+        } else if (ret == LONG(SCARD_E_UNKNOWN_READER)) {
+            if (pnpSupported && (states.first().dwEventState & SCARD_STATE_UNKNOWN) != 0) {
+                qCDebug(QT_NFC_PCSC) << "Reader notifications are not supported, checking for "
+                                        "new readers every" << FallbackIntervalMs << "ms";
+                pnpSupported = false;
+            }
+            readersChanged = true;
+            Q_EMIT stateChanged();
+        } else {
+            qCWarning(QT_NFC_PCSC) << "SCardGetStatusChange failed:" << QPcsc::errorMessage(ret);
+            Q_EMIT failed();
+            return;
+        }
+    }
+}
+
+QT_END_NAMESPACE
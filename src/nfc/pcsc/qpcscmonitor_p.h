@@ -0,0 +1,56 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QPCSCMONITOR_P_H
+#define QPCSCMONITOR_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qpcsc_p.h"
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Waits for reader and card state changes in a thread of its own, so that
+    the manager does not need to poll for them. It uses a separate context,
+    SCardCancel() aborts the blocking wait of this context only.
+*/
+class QPcscMonitor : public QThread
+{
+    Q_OBJECT
+public:
+    explicit QPcscMonitor(QObject *parent = nullptr);
+    ~QPcscMonitor() override;
+
+    bool isValid() const { return m_hasContext; }
+    void stop();
+
+Q_SIGNALS:
+    void stateChanged();
+    void failed();
+
+protected:
+    void run() override;
+
+private:
+    bool m_hasContext = false;
+    SCARDCONTEXT m_context;
+    QAtomicInteger<bool> m_stopRequested = false;
+    QSemaphore m_stopSemaphore;
+};
+
+QT_END_NAMESPACE
+
+#endif // QPCSCMONITOR_P_H
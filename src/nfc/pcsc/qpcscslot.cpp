@@ -5,24 +5,95 @@
 #include "qpcscmanager_p.h"
 #include "qpcsccard_p.h"
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QThread>
 
 QT_BEGIN_NAMESPACE
 
+using namespace Qt::StringLiterals;
+
 Q_DECLARE_LOGGING_CATEGORY(QT_NFC_PCSC)
 
-QPcscSlot::QPcscSlot(const QPcscSlotName &name, QPcscManager *manager)
+QPcscSlot::QPcscSlot(const QPcscSlotName &name, std::shared_ptr<QNdefMessageCache> ndefCache,
+                     QPcscManager *manager)
     : QObject(manager), m_name(name)
 {
+    m_thread = new QThread(this);
+    m_thread->setObjectName(u"QtNfcSlotThread"_s);
+    m_worker = new QPcscSlotWorker(name, std::move(ndefCache));
+    m_worker->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+
+    connect(m_worker, &QPcscSlotWorker::cardInserted, manager, &QPcscManager::cardInserted);
+    connect(m_worker, &QPcscSlotWorker::hasCardChanged, this,
+            [this](bool hasCard) { m_hasCard = hasCard; });
+    connect(m_worker, &QPcscSlotWorker::retryRequested, this,
+            [this, manager] { manager->retryCardDetection(this); });
+
+    m_thread->start();
 }
 
 QPcscSlot::~QPcscSlot()
 {
     qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO << this;
-    if (m_insertedCard)
-        m_insertedCard->invalidate();
+
+    // The worker invalidates the inserted card when it is deleted.
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void QPcscSlot::processStateChange(DWORD eventId, bool createCards,
+                                   QNearFieldTarget::AccessMethod requestedMethod)
+{
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, eventId, createCards, requestedMethod] {
+        worker->processStateChange(eventId, createCards, requestedMethod);
+    });
+}
+
+void QPcscSlot::invalidateInsertedCard()
+{
+    QMetaObject::invokeMethod(m_worker, &QPcscSlotWorker::invalidateInsertedCard);
 }
 
-void QPcscSlot::processStateChange(DWORD eventId, bool createCards)
+QPcscSlotWorker::QPcscSlotWorker(const QPcscSlotName &name,
+                                 std::shared_ptr<QNdefMessageCache> ndefCache)
+    : m_name(name), m_ndefCache(std::move(ndefCache)), m_ownerThread(QThread::currentThread())
+{
+}
+
+QPcscSlotWorker::~QPcscSlotWorker()
+{
+    qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
+
+    if (m_insertedCard) {
+        QPcscCard *card = m_insertedCard;
+        card->invalidate();
+        // A pending cardInserted() signal may still refer to the card. It is
+        // deleted once the automatic deletion is enabled, in the thread of the
+        // slot which outlives this one.
+        card->moveToThread(m_ownerThread);
+    }
+
+    if (m_hasContext)
+        SCardReleaseContext(m_context);
+}
+
+bool QPcscSlotWorker::establishContext()
+{
+    if (m_hasContext)
+        return true;
+
+    LONG ret = SCardEstablishContext(SCARD_SCOPE_USER, nullptr, nullptr, &m_context);
+    if (ret != SCARD_S_SUCCESS) {
+        qCWarning(QT_NFC_PCSC) << "Failed to establish context:" << QPcsc::errorMessage(ret);
+        return false;
+    }
+    m_hasContext = true;
+
+    return true;
+}
+
+void QPcscSlotWorker::processStateChange(DWORD eventId, bool createCards,
+                                         QNearFieldTarget::AccessMethod requestedMethod)
 {
     qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
 
@@ -33,25 +104,83 @@ void QPcscSlot::processStateChange(DWORD eventId, bool createCards)
         qCDebug(QT_NFC_PCSC) << "Removing card from slot" << m_name;
         m_insertedCard->invalidate();
         m_insertedCard.clear();
+        Q_EMIT hasCardChanged(false);
     }
 
-    auto manager = qobject_cast<QPcscManager *>(parent());
-
-    if (manager != nullptr && createCards
+    if (createCards
         && (eventId
             & (SCARD_STATE_PRESENT | SCARD_STATE_MUTE | SCARD_STATE_UNPOWERED
                | SCARD_STATE_EXCLUSIVE))
                 == SCARD_STATE_PRESENT) {
         qCDebug(QT_NFC_PCSC) << "New card in slot" << m_name;
 
-        m_insertedCard = manager->connectToCard(this);
+        m_insertedCard = connectToCard(requestedMethod);
+        if (m_insertedCard) {
+            connect(m_insertedCard, &QObject::destroyed, this, [this] {
+                if (m_insertedCard.isNull())
+                    Q_EMIT hasCardChanged(false);
+            });
+            Q_EMIT hasCardChanged(true);
+        }
     }
 }
 
-void QPcscSlot::invalidateInsertedCard()
+void QPcscSlotWorker::invalidateInsertedCard()
 {
     if (m_insertedCard)
         m_insertedCard->invalidate();
 }
 
+QPcscCard *QPcscSlotWorker::connectToCard(QNearFieldTarget::AccessMethod requestedMethod)
+{
+    qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
+
+    if (!establishContext()) {
+        Q_EMIT retryRequested();
+        return nullptr;
+    }
+
+    SCARDHANDLE cardHandle;
+    DWORD activeProtocol;
+
+    LONG ret = SCardConnect(m_context, m_name.ptr(), SCARD_SHARE_SHARED,
+                            SCARD_PROTOCOL_T0 | SCARD_PROTOCOL_T1, &cardHandle, &activeProtocol);
+    if (ret != SCARD_S_SUCCESS) {
+        qCDebug(QT_NFC_PCSC) << "Failed to connect to card:" << QPcsc::errorMessage(ret);
+        Q_EMIT retryRequested();
+        return nullptr;
+    }
+
+    // Without a parent, so that the card can outlive this object.
+    auto card = new QPcscCard(cardHandle, activeProtocol);
+    auto uid = card->uid();
+    auto maxInputLength = card->maxInputLength();
+
+    QNearFieldTarget::AccessMethods accessMethods = QNearFieldTarget::TagTypeSpecificAccess;
+    if (card->supportsNdef())
+        accessMethods |= QNearFieldTarget::NdefAccess;
+
+    if (requestedMethod != QNearFieldTarget::UnknownAccess
+        && (accessMethods & requestedMethod) == 0) {
+        qCDebug(QT_NFC_PCSC) << "Dropping card without required access support";
+        card->deleteLater();
+        return nullptr;
+    }
+
+    if (!card->isValid()) {
+        qCDebug(QT_NFC_PCSC) << "Card became invalid";
+        card->deleteLater();
+
+        Q_EMIT retryRequested();
+
+        return nullptr;
+    }
+
+    card->setNdefMessageCache(m_ndefCache, uid);
+
+    Q_EMIT cardInserted(card, uid, card->tagType(), accessMethods, maxInputLength);
+
+    return card;
+}
+
 QT_END_NAMESPACE
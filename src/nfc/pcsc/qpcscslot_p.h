@@ -16,28 +16,76 @@
 //
 
 #include "qpcsc_p.h"
+#include "qnearfieldtarget.h"
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
+class QNdefMessageCache;
 class QPcscManager;
 class QPcscCard;
+class QPcscSlotWorker;
+class QThread;
 
+/*
+    Tracks a reader for QPcscManager. Everything involving the card in the
+    reader is done by a QPcscSlotWorker in a thread of its own, so that a
+    slow card does not hold up the cards in other readers.
+*/
 class QPcscSlot : public QObject
 {
     Q_OBJECT
 public:
-    QPcscSlot(const QPcscSlotName &name, QPcscManager *manager);
+    QPcscSlot(const QPcscSlotName &name, std::shared_ptr<QNdefMessageCache> ndefCache,
+              QPcscManager *manager);
     ~QPcscSlot() override;
 
     const QPcscSlotName &name() const { return m_name; }
-    void processStateChange(DWORD eventId, bool createCards);
-    bool hasCard() const { return !m_insertedCard.isNull(); }
+    void processStateChange(DWORD eventId, bool createCards,
+                            QNearFieldTarget::AccessMethod requestedMethod);
+    bool hasCard() const { return m_hasCard; }
     void invalidateInsertedCard();
 
 private:
     const QPcscSlotName m_name;
+    bool m_hasCard = false;
+    QThread *m_thread;
+    QPcscSlotWorker *m_worker;
+};
+
+/*
+    Lives in the thread of a QPcscSlot. It uses a PC/SC context of its own,
+    since PCSCLite serializes the calls using the same context.
+*/
+class QPcscSlotWorker : public QObject
+{
+    Q_OBJECT
+public:
+    QPcscSlotWorker(const QPcscSlotName &name, std::shared_ptr<QNdefMessageCache> ndefCache);
+    ~QPcscSlotWorker() override;
+
+    void processStateChange(DWORD eventId, bool createCards,
+                            QNearFieldTarget::AccessMethod requestedMethod);
+    void invalidateInsertedCard();
+
+Q_SIGNALS:
+    void cardInserted(QPcscCard *card, const QByteArray &uid, QNearFieldTarget::Type type,
+                      QNearFieldTarget::AccessMethods accessMethods, int maxInputLength);
+    void hasCardChanged(bool hasCard);
+    void retryRequested();
+
+private:
+    [[nodiscard]] bool establishContext();
+    QPcscCard *connectToCard(QNearFieldTarget::AccessMethod requestedMethod);
+
+    const QPcscSlotName m_name;
+    const std::shared_ptr<QNdefMessageCache> m_ndefCache;
+    QThread *const m_ownerThread;
+    bool m_hasContext = false;
+    SCARDCONTEXT m_context;
     QPointer<QPcscCard> m_insertedCard;
 };
 
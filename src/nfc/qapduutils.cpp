@@ -18,10 +18,11 @@ QT_BEGIN_NAMESPACE
 /*
     Parses a response APDU from the raw data.
 
-    If the data is too short to contain SW bytes, the returned responses SW
-    is set to QResponseApdu::Empty.
+    The data and the status word are not copied, the returned response refers
+    to the raw data. If the data is too short to contain SW bytes, the
+    returned responses SW is set to QResponseApdu::Empty.
 */
-QResponseApdu::QResponseApdu(const QByteArray &response)
+QResponseApdu::QResponseApdu(QByteArrayView response)
 {
     if (response.size() < 2) {
         m_status = Empty;
@@ -29,52 +30,89 @@ QResponseApdu::QResponseApdu(const QByteArray &response)
     } else {
         const auto dataSize = response.size() - 2;
         m_status = qFromBigEndian(qFromUnaligned<uint16_t>(response.constData() + dataSize));
-        m_data = response.left(dataSize);
+        m_data = response.first(dataSize);
     }
 }
 
 /*
-    Builds a command APDU from components according to ISO/IEC 7816.
+    Returns the size of the command APDU with the given command data and
+    expected response length.
 */
-QByteArray QCommandApdu::build(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2,
-                               QByteArrayView data, uint16_t ne)
+qsizetype QCommandApdu::size(QByteArrayView data, uint16_t ne)
+{
+    const qsizetype nc = data.size();
+    const bool extended = nc > MaxShortNc || ne > MaxShortNe;
+
+    qsizetype size = 4;
+    if (nc > 0)
+        size += (extended ? 3 : 1) + nc;
+    if (ne)
+        size += extended ? (nc == 0 ? 3 : 2) : 1;
+    return size;
+}
+
+/*
+    Builds a command APDU from components according to ISO/IEC 7816 into apdu.
+
+    Extended length fields are used if either the command data or the expected
+    response data do not fit into a short APDU. Then both Lc and Le are
+    extended, as the standard does not allow mixing them.
+
+    The previous content of apdu is replaced. Its memory is reused if it is
+    large enough and not shared, so a caller that keeps one buffer for all its
+    commands builds them without allocating.
+*/
+void QCommandApdu::build(QByteArray &apdu, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2,
+                         QByteArrayView data, uint16_t ne)
 {
     Q_ASSERT(data.size() <= 0xFFFF);
 
-    QByteArray apdu;
-    apdu.append(static_cast<char>(cla));
-    apdu.append(static_cast<char>(ins));
-    apdu.append(static_cast<char>(p1));
-    apdu.append(static_cast<char>(p2));
+    apdu.resize(size(data, ne));
+    char *out = apdu.data();
+    *out++ = static_cast<char>(cla);
+    *out++ = static_cast<char>(ins);
+    *out++ = static_cast<char>(p1);
+    *out++ = static_cast<char>(p2);
 
-    bool extendedLc = false;
-    uint16_t nc = data.size();
+    const uint16_t nc = data.size();
+    const bool extended = nc > MaxShortNc || ne > MaxShortNe;
 
     if (nc > 0) {
-        if (nc < 256) {
-            apdu.append(static_cast<char>(nc));
+        if (!extended) {
+            *out++ = static_cast<char>(nc);
         } else {
-            extendedLc = true;
-            apdu.append('\0');
-            apdu.append(static_cast<char>(nc >> 8));
-            apdu.append(static_cast<char>(nc & 0xFF));
+            *out++ = '\0';
+            *out++ = static_cast<char>(nc >> 8);
+            *out++ = static_cast<char>(nc & 0xFF);
         }
-        apdu.append(data);
+        memcpy(out, data.data(), nc);
+        out += nc;
     }
 
     if (ne) {
-        if (ne < 256) {
-            apdu.append(static_cast<char>(ne));
-        } else if (ne == 256) {
-            apdu.append(static_cast<char>('\0'));
+        if (!extended) {
+            // 256 is encoded as 0
+            *out++ = static_cast<char>(ne & 0xFF);
         } else {
-            if (!extendedLc)
-                apdu.append('\0');
-            apdu.append(static_cast<char>(ne >> 8));
-            apdu.append(static_cast<char>(ne & 0xFF));
+            // The leading zero byte is shared with Lc, if present
+            if (nc == 0)
+                *out++ = '\0';
+            *out++ = static_cast<char>(ne >> 8);
+            *out++ = static_cast<char>(ne & 0xFF);
         }
     }
 
+    Q_ASSERT(out == apdu.constData() + apdu.size());
+}
+
+/*
+    Builds a command APDU from components into a new array of the exact size.
+*/
+QByteArray QCommandApdu::build(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2,
+                               QByteArrayView data, uint16_t ne)
+{
+    QByteArray apdu;
+    build(apdu, cla, ins, p1, p2, data, ne);
     return apdu;
 }
 
@@ -16,23 +16,25 @@
 //
 
 #include <QtCore/QByteArray>
+#include <QtCore/QByteArrayView>
 
 QT_BEGIN_NAMESPACE
 
+// Refers to the response it was constructed from, which must outlive it
 class QResponseApdu
 {
 public:
     static constexpr uint16_t Empty = 0x0000;
     static constexpr uint16_t Success = 0x9000;
 
-    explicit QResponseApdu(const QByteArray &response = {});
+    explicit QResponseApdu(QByteArrayView response = {});
 
-    const QByteArray &data() const { return m_data; }
+    QByteArrayView data() const { return m_data; }
     uint16_t status() const { return m_status; }
     bool isOk() const { return m_status == Success; }
 
 private:
-    QByteArray m_data;
+    QByteArrayView m_data;
     uint16_t m_status;
 };
 
@@ -44,6 +46,16 @@ constexpr uint8_t ReadBinary = 0xB0;
 constexpr uint8_t GetData = 0xCA;
 constexpr uint8_t UpdateBinary = 0xD6;
 
+// The longest short APDU: header, Lc, 255 bytes of data and Le
+constexpr int MaxShortLength = 261;
+constexpr uint16_t MaxShortNc = 255;
+constexpr uint16_t MaxShortNe = 256;
+// Header and the three byte Lc of an extended length APDU
+constexpr int ExtendedHeaderLength = 7;
+
+qsizetype size(QByteArrayView data, uint16_t ne = 0);
+void build(QByteArray &apdu, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2,
+           QByteArrayView data, uint16_t ne = 0);
 QByteArray build(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, QByteArrayView data,
                  uint16_t ne = 0);
 };
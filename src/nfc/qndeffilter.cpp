@@ -4,8 +4,12 @@
 #include "qndeffilter.h"
 #include "qndefmessage.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QList>
-#include <QtCore/QMap>
+#include <QtCore/QVarLengthArray>
+
+#include <algorithm>
+#include <utility>
 
 QT_BEGIN_NAMESPACE
 
@@ -223,8 +227,20 @@ class QNdefFilterPrivate : public QSharedData
 public:
     QNdefFilterPrivate();
 
+    void compile();
+
     bool orderMatching;
     QList<QNdefFilter::Record> filterRecords;
+
+    // The form of the filter used by match(), updated by compile() whenever
+    // the filter changes, so that it is not rebuilt for every message.
+    //
+    // For unordered matching, equal records are joined and indexed by their
+    // type name format and type. For ordered matching, consecutive equal
+    // records are merged.
+    using RecordKey = std::pair<int, QByteArray>;
+    QList<QNdefFilter::Record> compiledRecords;
+    QHash<RecordKey, qsizetype> compiledIndex;
 };
 
 QNdefFilterPrivate::QNdefFilterPrivate()
@@ -232,6 +248,37 @@ QNdefFilterPrivate::QNdefFilterPrivate()
 {
 }
 
+void QNdefFilterPrivate::compile()
+{
+    compiledRecords.clear();
+    compiledIndex.clear();
+
+    if (!orderMatching) {
+        for (const auto &rec : std::as_const(filterRecords)) {
+            const auto key = RecordKey(rec.typeNameFormat, rec.type);
+            const auto it = compiledIndex.constFind(key);
+            if (it != compiledIndex.cend()) {
+                compiledRecords[*it].minimum += rec.minimum;
+                compiledRecords[*it].maximum += rec.maximum;
+            } else {
+                compiledIndex.insert(key, compiledRecords.size());
+                compiledRecords.append(rec);
+            }
+        }
+    } else {
+        for (const auto &rec : std::as_const(filterRecords)) {
+            if (!compiledRecords.isEmpty()
+                && rec.typeNameFormat == compiledRecords.constLast().typeNameFormat
+                && rec.type == compiledRecords.constLast().type) {
+                compiledRecords.last().minimum += rec.minimum;
+                compiledRecords.last().maximum += rec.maximum;
+            } else {
+                compiledRecords.append(rec);
+            }
+        }
+    }
+}
+
 /*!
     Constructs a new NDEF filter.
 */
@@ -283,65 +330,38 @@ bool QNdefFilter::match(const QNdefMessage &message) const
     bool matched = true;
     int totalCount = 0;
 
+    const QList<Record> &compiledRecords = d->compiledRecords;
+    // The current number of occurrences of each compiled record.
+    QVarLengthArray<unsigned int, 16> counts(compiledRecords.size());
+    std::fill(counts.begin(), counts.end(), 0u);
+
     if (!d->orderMatching) {
-        // Order is not important. The most reliable way is to merge all the
-        // similar records, and then simply check the amount of occurrences.
-        using MapKey = QPair<QNdefRecord::TypeNameFormat, QByteArray>;
-
-        // Creating a map from the list of filter records.
-        QMap<MapKey, Record> joinedFilterRecords;
-        for (const auto &rec : d->filterRecords) {
-            const auto key = qMakePair(rec.typeNameFormat, rec.type);
-            if (joinedFilterRecords.contains(key)) {
-                joinedFilterRecords[key].minimum += rec.minimum;
-                joinedFilterRecords[key].maximum += rec.maximum;
-            } else {
-                joinedFilterRecords.insert(key, rec);
-            }
-        }
-        // Checking the message, calculate occurrences.
-        QMap<MapKey, unsigned int> counts; // current number of occurrences
+        using RecordKey = QNdefFilterPrivate::RecordKey;
+
+        // Order is not important. All the similar records are merged, so
+        // simply check the amount of occurrences.
         for (const auto &record : message) {
-            const auto key = qMakePair(record.typeNameFormat(), record.type());
+            auto it = d->compiledIndex.constFind(
+                    RecordKey(record.typeNameFormat(), record.type()));
             // Do not forget that we handle an empty type as "any type".
-            const auto emptyTypeKey = qMakePair(record.typeNameFormat(), QByteArray());
+            if (it == d->compiledIndex.cend())
+                it = d->compiledIndex.constFind(RecordKey(record.typeNameFormat(), QByteArray()));
 
-            if (joinedFilterRecords.contains(key))
-                counts[key] += 1;
-            else if (joinedFilterRecords.contains(emptyTypeKey))
-                counts[emptyTypeKey] += 1;
+            if (it != d->compiledIndex.cend())
+                counts[*it] += 1;
         }
         // Check that the occurrences match [min; max] range.
-        for (auto it = joinedFilterRecords.cbegin(); it != joinedFilterRecords.cend(); ++it) {
-            const auto count = counts.value(it.key(), 0);
-            totalCount += count;
-            if (count < it.value().minimum || count > it.value().maximum) {
+        for (qsizetype i = 0; i < compiledRecords.size(); ++i) {
+            const auto &rec = compiledRecords.at(i);
+            totalCount += counts[i];
+            if (counts[i] < rec.minimum || counts[i] > rec.maximum) {
                 matched = false;
                 break;
             }
         }
     } else {
-        // Order *is* important. Need to iterate the list.
-
-        // Here we need to merge consecutive records with the same parameters.
-        QList<Record> mergedRecords;
-        // we know that filer is not empty here
-        Record currentRecord = d->filterRecords.first();
-        for (qsizetype i = 1; i < d->filterRecords.size(); ++i) {
-            const auto &rec = d->filterRecords.at(i);
-            if (rec.typeNameFormat == currentRecord.typeNameFormat
-                && rec.type == currentRecord.type) {
-                currentRecord.minimum += rec.minimum;
-                currentRecord.maximum += rec.maximum;
-            } else {
-                mergedRecords.push_back(currentRecord);
-                currentRecord = rec;
-            }
-        }
-        mergedRecords.push_back(currentRecord);
-
-        // The list contains the current number of occurrences of each record.
-        QList<unsigned int> counts(mergedRecords.size(), 0);
+        // Order *is* important. Need to iterate the list, the consecutive
+        // records with the same parameters are merged.
 
         // Iterate through the messages and calculate the number of occurrences.
         qsizetype filterIndex = 0;
@@ -351,8 +371,8 @@ bool QNdefFilter::match(const QNdefMessage &message) const
             // We start from the last processed filter record, not from the very
             // beginning (because the order matters).
             qsizetype idx = filterIndex;
-            for (; idx < mergedRecords.size(); ++idx) {
-                const auto &filterRec = mergedRecords.at(idx);
+            for (; idx < compiledRecords.size(); ++idx) {
+                const auto &filterRec = compiledRecords.at(idx);
                 if (filterRec.typeNameFormat == messageRec.typeNameFormat()
                     && (filterRec.type == messageRec.type() || filterRec.type.isEmpty())) {
                     counts[idx] += 1;
@@ -370,8 +390,8 @@ bool QNdefFilter::match(const QNdefMessage &message) const
 
         if (matched) {
             // Check that the occurrences match [min; max] range.
-            for (qsizetype i = 0; i < mergedRecords.size(); ++i) {
-                const auto &rec = mergedRecords.at(i);
+            for (qsizetype i = 0; i < compiledRecords.size(); ++i) {
+                const auto &rec = compiledRecords.at(i);
                 totalCount += counts[i];
                 if (counts[i] < rec.minimum || counts[i] > rec.maximum) {
                     matched = false;
@@ -399,6 +419,7 @@ void QNdefFilter::clear()
 {
     d->orderMatching = false;
     d->filterRecords.clear();
+    d->compile();
 }
 
 /*!
@@ -412,6 +433,7 @@ void QNdefFilter::clear()
 void QNdefFilter::setOrderMatch(bool on)
 {
     d->orderMatching = on;
+    d->compile();
 }
 
 /*!
@@ -459,6 +481,7 @@ bool QNdefFilter::appendRecord(const Record &record)
 {
     if (verifyRecord(record)) {
         d->filterRecords.append(record);
+        d->compile();
         return true;
     }
     return false;
@@ -0,0 +1,250 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qndefmessagedecoder_p.h"
+
+#include <QtCore/qendian.h>
+
+#include <limits>
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Returns the combined payload length of the chunked record starting at
+    \a idx, so that the reassembled payload can be allocated once. Only the
+    chunks that are contained in \a message are counted. Stops at the first
+    malformed chunk; the decoder reports the error.
+*/
+static qsizetype chunkedPayloadLength(QByteArrayView message, qsizetype idx)
+{
+    qsizetype total = 0;
+    while (idx < message.size()) {
+        const quint8 flags = message[idx];
+        const bool cf = flags & 0x20;
+        const bool sr = flags & 0x10;
+        const bool il = flags & 0x08;
+
+        const qsizetype headerLength = 2 + (sr ? 1 : 4) + (il ? 1 : 0);
+        if (idx + headerLength > message.size())
+            break;
+
+        const quint8 typeLength = message[idx + 1];
+        quint32 payloadLength;
+        if (sr) {
+            payloadLength = quint8(message[idx + 2]);
+        } else {
+            payloadLength = qFromBigEndian<quint32>(message.data() + idx + 2);
+        }
+        const quint8 idLength = il ? quint8(message[idx + headerLength - 1]) : 0;
+
+        const qsizetype remaining = message.size() - idx - headerLength - typeLength - idLength;
+        if (remaining < 0 || payloadLength > quint64(remaining))
+            break;
+
+        total += payloadLength;
+        if (!cf)
+            break;
+        idx += headerLength + typeLength + idLength + payloadLength;
+    }
+    return total;
+}
+
+/*
+    Adds \a data to the message and decodes all records it completes.
+*/
+QNdefMessageDecoder::Status QNdefMessageDecoder::addData(QByteArrayView data)
+{
+    if (m_status != NeedMoreData)
+        return m_status;
+
+    if (m_buffer.isEmpty()) {
+        const qsizetype decoded = decode(data);
+        if (m_status == NeedMoreData)
+            m_buffer = data.sliced(decoded).toByteArray();
+    } else {
+        m_buffer.append(data);
+        const qsizetype decoded = decode(m_buffer);
+        if (m_status == NeedMoreData)
+            m_buffer.remove(0, decoded);
+        else
+            m_buffer.clear();
+    }
+
+    return m_status;
+}
+
+QNdefMessageDecoder::Status QNdefMessageDecoder::finish()
+{
+    if (m_status != NeedMoreData)
+        return m_status;
+
+    if (!m_buffer.isEmpty()) {
+        qWarning("Unexpected end of message");
+        m_status = Failed;
+    } else if (!m_seenMessageBegin || !m_seenMessageEnd) {
+        qWarning("Malformed NDEF Message, missing begin or end");
+        m_status = Failed;
+    } else {
+        // The message end flag was set on a chunk, the incomplete record is dropped
+        m_status = Finished;
+    }
+    m_buffer.clear();
+
+    return m_status;
+}
+
+QList<QNdefRecord> QNdefMessageDecoder::takeNewRecords()
+{
+    QList<QNdefRecord> records = m_message.mid(m_reportedRecords);
+    m_reportedRecords = m_message.size();
+    return records;
+}
+
+QNdefMessage QNdefMessageDecoder::takeMessage()
+{
+    if (m_status != Finished)
+        return QNdefMessage();
+
+    m_reportedRecords = 0;
+    return std::exchange(m_message, QNdefMessage());
+}
+
+/*
+    Decodes the complete records at the beginning of \a message and returns
+    the number of bytes they take. The state of the decoder is only updated
+    for complete records, so an incomplete one can be decoded again once
+    more data is available.
+*/
+qsizetype QNdefMessageDecoder::decode(QByteArrayView message)
+{
+    const auto fail = [this](const char *warning) {
+        qWarning("%s", warning);
+        m_status = Failed;
+        return 0;
+    };
+
+    qsizetype idx = 0;
+    while (idx < message.size()) {
+        const qsizetype recordStart = idx;
+        const quint8 flags = message[idx];
+
+        const bool messageBegin = flags & 0x80;
+        const bool messageEnd = flags & 0x40;
+
+        const bool cf = flags & 0x20;
+        const bool sr = flags & 0x10;
+        const bool il = flags & 0x08;
+        const quint8 typeNameFormat = flags & 0x07;
+
+        if (messageBegin && m_seenMessageBegin)
+            return fail("Got message begin but already parsed some records");
+        else if (!messageBegin && !m_seenMessageBegin)
+            return fail("Haven't got message begin yet");
+        if (messageEnd && m_seenMessageEnd)
+            return fail("Got message end but already parsed final record");
+        // TNF must be 0x06 even for the last chunk, when cf == 0.
+        if ((typeNameFormat != 0x06) && !m_partialChunk.isEmpty())
+            return fail("Partial chunk not empty, but TNF not 0x06 as expected");
+
+        int headerLength = 1;
+        headerLength += (sr) ? 1 : 4;
+        headerLength += (il) ? 1 : 0;
+
+        if (idx + headerLength >= message.size())
+            return recordStart;
+
+        const quint8 typeLength = message[++idx];
+
+        if ((typeNameFormat == 0x06) && (typeLength != 0))
+            return fail("Invalid chunked data, TYPE_LENGTH != 0");
+
+        quint32 payloadLength;
+        if (sr) {
+            payloadLength = quint8(message[++idx]);
+        } else {
+            payloadLength = qFromBigEndian<quint32>(message.data() + idx + 1);
+            idx += 4;
+        }
+
+        quint8 idLength;
+        if (il)
+            idLength = message[++idx];
+        else
+            idLength = 0;
+
+        // On 32-bit systems this can overflow
+        const qsizetype convertedPayloadLength = static_cast<qsizetype>(payloadLength);
+        const qsizetype contentLength = convertedPayloadLength + typeLength + idLength;
+
+        // On a 32 bit platform the payload can theoretically exceed the max.
+        // size of a QByteArray. This will never happen in practice with correct
+        // data because there are no NFC tags that can store such data sizes,
+        // but still can be possible if the data is corrupted.
+        if ((contentLength < 0) || (convertedPayloadLength < 0)
+            || ((std::numeric_limits<qsizetype>::max() - idx) < contentLength)) {
+            return fail("Payload can't fit into QByteArray");
+        }
+
+        if (idx + contentLength >= message.size())
+            return recordStart;
+
+        if ((typeNameFormat == 0x06) && il)
+            return fail("Invalid chunked data, IL != 0");
+
+        // The record is complete
+        m_seenMessageBegin = true;
+        m_seenMessageEnd = m_seenMessageEnd || messageEnd;
+
+        if (typeNameFormat != 0x06)
+            m_record.setTypeNameFormat(QNdefRecord::TypeNameFormat(typeNameFormat));
+
+        if (typeLength > 0) {
+            m_record.setType(message.sliced(++idx, typeLength).toByteArray());
+            idx += typeLength - 1;
+        }
+
+        if (idLength > 0) {
+            m_record.setId(message.sliced(++idx, idLength).toByteArray());
+            idx += idLength - 1;
+        }
+
+        if (cf && typeNameFormat != 0x06)
+            m_partialChunk.reserve(chunkedPayloadLength(message, recordStart));
+
+        if (payloadLength > 0) {
+            const QByteArrayView payload = message.sliced(++idx, payloadLength);
+
+            if (cf || typeNameFormat == 0x06) {
+                // chunk of a chunked payload
+                m_partialChunk.append(payload);
+            } else {
+                // non-chunked payload
+                m_record.setPayload(payload.toByteArray());
+            }
+
+            idx += payloadLength - 1;
+        }
+
+        // last chunk of chunked payload, which may be empty
+        if (!cf && typeNameFormat == 0x06)
+            m_record.setPayload(std::exchange(m_partialChunk, QByteArray()));
+
+        if (!cf) {
+            m_message.append(m_record);
+            m_record = QNdefRecord();
+        }
+
+        // move to start of next record
+        ++idx;
+
+        if (!cf && m_seenMessageEnd) {
+            m_status = Finished;
+            break;
+        }
+    }
+
+    return idx;
+}
+
+QT_END_NAMESPACE
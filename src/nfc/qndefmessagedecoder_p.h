@@ -0,0 +1,84 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QNDEFMESSAGEDECODER_P_H
+#define QNDEFMESSAGEDECODER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qtnfcglobal_p.h"
+#include "qndefmessage.h"
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qbytearrayview.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Decodes an NDEF message from data that arrives in pieces, for example
+    while a tag is being read.
+
+    Records become available as soon as their last byte has been added, so
+    they can be handled before the rest of the message is read. Complete
+    records are decoded directly from the added data; only the incomplete
+    tail is buffered until more data arrives.
+*/
+class Q_AUTOTEST_EXPORT QNdefMessageDecoder
+{
+public:
+    enum Status {
+        // The message is not complete yet.
+        NeedMoreData,
+        // The last record of the message was decoded. Further data is ignored.
+        Finished,
+        // The data is not a valid NDEF message.
+        Failed
+    };
+
+    Status addData(QByteArrayView data);
+
+    /*
+        Tells the decoder that no more data will be added. Fails if the
+        message is incomplete.
+    */
+    Status finish();
+
+    Status status() const { return m_status; }
+
+    bool hasNewRecords() const { return m_reportedRecords < m_message.size(); }
+    // Returns the records decoded since the last call.
+    QList<QNdefRecord> takeNewRecords();
+
+    // Returns the message if finish() succeeded, otherwise an empty message.
+    QNdefMessage takeMessage();
+
+private:
+    qsizetype decode(QByteArrayView data);
+
+    Status m_status = NeedMoreData;
+
+    bool m_seenMessageBegin = false;
+    bool m_seenMessageEnd = false;
+
+    // data of an incomplete record
+    QByteArray m_buffer;
+
+    QByteArray m_partialChunk;
+    QNdefRecord m_record;
+
+    QNdefMessage m_message;
+    qsizetype m_reportedRecords = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QNDEFMESSAGEDECODER_P_H
@@ -8,6 +8,7 @@
 #include <QtCore/QString>
 #include <QtCore/QStringList>
 #include <QtCore/QUrl>
+#include <QtCore/QtEndian>
 
 QT_BEGIN_NAMESPACE
 
@@ -46,6 +47,10 @@ QT_BEGIN_NAMESPACE
     \since Qt 5.2
 
     RTD-SmartPoster encapsulates a Smart Poster.
+
+    The records embedded in the smart poster are decoded when one of them is
+    accessed for the first time. Icons are only copied out of the payload
+    when they are requested.
  */
 
 /*!
@@ -106,19 +111,6 @@ QNdefNfcSmartPosterRecord::~QNdefNfcSmartPosterRecord()
 {
 }
 
-void QNdefNfcSmartPosterRecord::cleanup()
-{
-    if (d) {
-        // Clean-up existing internal structure
-        d->m_titleList.clear();
-        if (d->m_uri) delete d->m_uri;
-        if (d->m_action) delete d->m_action;
-        d->m_iconList.clear();
-        if (d->m_size) delete d->m_size;
-        if (d->m_type) delete d->m_type;
-    }
-}
-
 /*!
     \internal
     Sets the payload of the NDEF record to \a payload
@@ -127,49 +119,14 @@ void QNdefNfcSmartPosterRecord::setPayload(const QByteArray &payload)
 {
     QNdefRecord::setPayload(payload);
 
-    cleanup();
-
-    if (!payload.isEmpty()) {
-        // Create new structure
-        const QNdefMessage message = QNdefMessage::fromByteArray(payload);
-
-        // Iterate through all the records contained in the payload's message.
-        for (const QNdefRecord& record : message) {
-            // Title
-            if (record.isRecordType<QNdefNfcTextRecord>()) {
-                addTitleInternal(record);
-            }
-
-            // URI
-            else if (record.isRecordType<QNdefNfcUriRecord>()) {
-                d->m_uri = new QNdefNfcUriRecord(record);
-            }
-
-            // Action
-            else if (record.isRecordType<QNdefNfcActRecord>()) {
-                d->m_action = new QNdefNfcActRecord(record);
-            }
-
-            // Icon
-            else if (record.isRecordType<QNdefNfcIconRecord>()) {
-                addIconInternal(record);
-            }
-
-            // Size
-            else if (record.isRecordType<QNdefNfcSizeRecord>()) {
-                d->m_size = new QNdefNfcSizeRecord(record);
-            }
-
-            // Type
-            else if (record.isRecordType<QNdefNfcTypeRecord>()) {
-                d->m_type = new QNdefNfcTypeRecord(record);
-            }
-        }
-    }
+    // The structure is created when it is accessed
+    d->setPayload(payload);
 }
 
 void QNdefNfcSmartPosterRecord::convertToPayload()
 {
+    d->decodeIcons();
+
     QNdefMessage message;
 
     // Title
@@ -178,11 +135,11 @@ void QNdefNfcSmartPosterRecord::convertToPayload()
 
     // URI
     if (d->m_uri)
-        message.append(*(d->m_uri));
+        message.append(*d->m_uri);
 
     // Action
     if (d->m_action)
-        message.append(*(d->m_action));
+        message.append(*d->m_action);
 
     // Icon
     for (qsizetype i = 0; i < iconCount(); i++)
@@ -190,11 +147,11 @@ void QNdefNfcSmartPosterRecord::convertToPayload()
 
     // Size
     if (d->m_size)
-        message.append(*(d->m_size));
+        message.append(*d->m_size);
 
     // Type
     if (d->m_type)
-        message.append(*(d->m_type));
+        message.append(*d->m_type);
 
     QNdefRecord::setPayload(message.toByteArray());
 }
@@ -207,6 +164,8 @@ void QNdefNfcSmartPosterRecord::convertToPayload()
  */
 bool QNdefNfcSmartPosterRecord::hasTitle(const QString &locale) const
 {
+    d->decode();
+
     for (qsizetype i = 0; i < d->m_titleList.length(); ++i) {
         const QNdefNfcTextRecord &text = d->m_titleList[i];
 
@@ -223,7 +182,8 @@ bool QNdefNfcSmartPosterRecord::hasTitle(const QString &locale) const
  */
 bool QNdefNfcSmartPosterRecord::hasAction() const
 {
-    return d->m_action != nullptr;
+    d->decode();
+    return d->m_action.has_value();
 }
 
 /*!
@@ -234,10 +194,9 @@ bool QNdefNfcSmartPosterRecord::hasAction() const
  */
 bool QNdefNfcSmartPosterRecord::hasIcon(const QByteArray &mimetype) const
 {
-    for (qsizetype i = 0; i < d->m_iconList.length(); ++i) {
-        const QNdefNfcIconRecord &icon = d->m_iconList[i];
-
-        if (mimetype.isEmpty() || icon.type() == mimetype)
+    const qsizetype count = d->iconCount();
+    for (qsizetype i = 0; i < count; ++i) {
+        if (mimetype.isEmpty() || d->iconType(i) == mimetype)
             return true;
     }
 
@@ -250,7 +209,8 @@ bool QNdefNfcSmartPosterRecord::hasIcon(const QByteArray &mimetype) const
  */
 bool QNdefNfcSmartPosterRecord::hasSize() const
 {
-    return d->m_size != nullptr;
+    d->decode();
+    return d->m_size.has_value();
 }
 
 /*!
@@ -259,7 +219,8 @@ bool QNdefNfcSmartPosterRecord::hasSize() const
  */
 bool QNdefNfcSmartPosterRecord::hasTypeInfo() const
 {
-    return d->m_type != nullptr;
+    d->decode();
+    return d->m_type.has_value();
 }
 
 /*!
@@ -267,6 +228,7 @@ bool QNdefNfcSmartPosterRecord::hasTypeInfo() const
  */
 qsizetype QNdefNfcSmartPosterRecord::titleCount() const
 {
+    d->decode();
     return d->m_titleList.length();
 }
 
@@ -277,6 +239,8 @@ qsizetype QNdefNfcSmartPosterRecord::titleCount() const
  */
 QNdefNfcTextRecord QNdefNfcSmartPosterRecord::titleRecord(qsizetype index) const
 {
+    d->decode();
+
     if (index >= 0 && index < d->m_titleList.length())
         return d->m_titleList[index];
 
@@ -290,6 +254,8 @@ QNdefNfcTextRecord QNdefNfcSmartPosterRecord::titleRecord(qsizetype index) const
  */
 QString QNdefNfcSmartPosterRecord::title(const QString &locale) const
 {
+    d->decode();
+
     for (qsizetype i = 0; i < d->m_titleList.length(); ++i) {
         const QNdefNfcTextRecord &text = d->m_titleList[i];
 
@@ -305,6 +271,7 @@ QString QNdefNfcSmartPosterRecord::title(const QString &locale) const
  */
 QList<QNdefNfcTextRecord> QNdefNfcSmartPosterRecord::titleRecords() const
 {
+    d->decode();
     return d->m_titleList;
 }
 
@@ -326,15 +293,8 @@ bool QNdefNfcSmartPosterRecord::addTitle(const QNdefNfcTextRecord &text)
 
 bool QNdefNfcSmartPosterRecord::addTitleInternal(const QNdefNfcTextRecord &text)
 {
-    for (qsizetype i = 0; i < d->m_titleList.length(); ++i) {
-        const QNdefNfcTextRecord &rec = d->m_titleList[i];
-
-        if (rec.locale() == text.locale())
-            return false;
-    }
-
-    d->m_titleList.append(text);
-    return true;
+    d->decode();
+    return d->addTitle(text);
 }
 
 /*!
@@ -359,6 +319,8 @@ bool QNdefNfcSmartPosterRecord::addTitle(const QString &text, const QString &loc
  */
 bool QNdefNfcSmartPosterRecord::removeTitle(const QNdefNfcTextRecord &text)
 {
+    d->decode();
+
     bool status = false;
 
     for (qsizetype i = 0; i < d->m_titleList.length(); ++i) {
@@ -385,6 +347,8 @@ bool QNdefNfcSmartPosterRecord::removeTitle(const QNdefNfcTextRecord &text)
  */
 bool QNdefNfcSmartPosterRecord::removeTitle(const QString &locale)
 {
+    d->decode();
+
     bool status = false;
 
     for (qsizetype i = 0; i < d->m_titleList.length(); ++i) {
@@ -409,6 +373,7 @@ bool QNdefNfcSmartPosterRecord::removeTitle(const QString &locale)
  */
 void QNdefNfcSmartPosterRecord::setTitles(const QList<QNdefNfcTextRecord> &titles)
 {
+    d->decode();
     d->m_titleList.clear();
 
     for (qsizetype i = 0; i < titles.length(); ++i) {
@@ -424,6 +389,7 @@ void QNdefNfcSmartPosterRecord::setTitles(const QList<QNdefNfcTextRecord> &title
  */
 QUrl QNdefNfcSmartPosterRecord::uri() const
 {
+    d->decode();
     if (d->m_uri)
         return d->m_uri->uri();
 
@@ -435,8 +401,9 @@ QUrl QNdefNfcSmartPosterRecord::uri() const
  */
 QNdefNfcUriRecord QNdefNfcSmartPosterRecord::uriRecord() const
 {
+    d->decode();
     if (d->m_uri)
-        return *(d->m_uri);
+        return *d->m_uri;
 
     return QNdefNfcUriRecord();
 }
@@ -446,10 +413,8 @@ QNdefNfcUriRecord QNdefNfcSmartPosterRecord::uriRecord() const
  */
 void QNdefNfcSmartPosterRecord::setUri(const QNdefNfcUriRecord &url)
 {
-    if (d->m_uri)
-        delete d->m_uri;
-
-    d->m_uri = new QNdefNfcUriRecord(url);
+    d->decode();
+    d->m_uri = url;
 
     // Convert to payload
     convertToPayload();
@@ -471,6 +436,7 @@ void QNdefNfcSmartPosterRecord::setUri(const QUrl &url)
  */
 QNdefNfcSmartPosterRecord::Action QNdefNfcSmartPosterRecord::action() const
 {
+    d->decode();
     if (d->m_action)
         return d->m_action->action();
 
@@ -482,8 +448,9 @@ QNdefNfcSmartPosterRecord::Action QNdefNfcSmartPosterRecord::action() const
  */
 void QNdefNfcSmartPosterRecord::setAction(Action act)
 {
+    d->decode();
     if (!d->m_action)
-        d->m_action = new QNdefNfcActRecord();
+        d->m_action.emplace();
 
     d->m_action->setAction(act);
 
@@ -496,7 +463,7 @@ void QNdefNfcSmartPosterRecord::setAction(Action act)
  */
 qsizetype QNdefNfcSmartPosterRecord::iconCount() const
 {
-    return d->m_iconList.length();
+    return d->iconCount();
 }
 
 /*!
@@ -506,8 +473,8 @@ qsizetype QNdefNfcSmartPosterRecord::iconCount() const
  */
 QNdefNfcIconRecord QNdefNfcSmartPosterRecord::iconRecord(qsizetype index) const
 {
-    if (index >= 0 && index < d->m_iconList.length())
-        return d->m_iconList[index];
+    if (index >= 0 && index < d->iconCount())
+        return d->iconRecord(index);
 
     return QNdefNfcIconRecord();
 }
@@ -518,11 +485,11 @@ QNdefNfcIconRecord QNdefNfcSmartPosterRecord::iconRecord(qsizetype index) const
  */
 QByteArray QNdefNfcSmartPosterRecord::icon(const QByteArray& mimetype) const
 {
-    for (qsizetype i = 0; i < d->m_iconList.length(); ++i) {
-        const QNdefNfcIconRecord &icon = d->m_iconList[i];
-
-        if (mimetype.isEmpty() || icon.type() == mimetype)
-            return icon.data();
+    // Only the requested icon is copied out of the payload
+    const qsizetype count = d->iconCount();
+    for (qsizetype i = 0; i < count; ++i) {
+        if (mimetype.isEmpty() || d->iconType(i) == mimetype)
+            return d->iconRecord(i).data();
     }
 
     return QByteArray();
@@ -533,6 +500,7 @@ QByteArray QNdefNfcSmartPosterRecord::icon(const QByteArray& mimetype) const
  */
 QList<QNdefNfcIconRecord> QNdefNfcSmartPosterRecord::iconRecords() const
 {
+    d->decodeIcons();
     return d->m_iconList;
 }
 
@@ -550,14 +518,8 @@ void QNdefNfcSmartPosterRecord::addIcon(const QNdefNfcIconRecord &icon)
 
 void QNdefNfcSmartPosterRecord::addIconInternal(const QNdefNfcIconRecord &icon)
 {
-    for (qsizetype i = 0; i < d->m_iconList.length(); ++i) {
-        const QNdefNfcIconRecord &rec = d->m_iconList[i];
-
-        if (rec.type() == icon.type())
-            d->m_iconList.removeAt(i);
-    }
-
-    d->m_iconList.append(icon);
+    d->decodeIcons();
+    d->addIcon(icon);
 }
 
 /*!
@@ -580,6 +542,8 @@ void QNdefNfcSmartPosterRecord::addIcon(const QByteArray &type, const QByteArray
  */
 bool QNdefNfcSmartPosterRecord::removeIcon(const QNdefNfcIconRecord &icon)
 {
+    d->decodeIcons();
+
     bool status = false;
 
     for (qsizetype i = 0; i < d->m_iconList.length(); ++i) {
@@ -606,6 +570,8 @@ bool QNdefNfcSmartPosterRecord::removeIcon(const QNdefNfcIconRecord &icon)
  */
 bool QNdefNfcSmartPosterRecord::removeIcon(const QByteArray &type)
 {
+    d->decodeIcons();
+
     bool status = false;
 
     for (qsizetype i = 0; i < d->m_iconList.length(); ++i) {
@@ -633,6 +599,7 @@ bool QNdefNfcSmartPosterRecord::removeIcon(const QByteArray &type)
  */
 void QNdefNfcSmartPosterRecord::setIcons(const QList<QNdefNfcIconRecord> &icons)
 {
+    d->decodeIcons();
     d->m_iconList.clear();
 
     for (qsizetype i = 0; i < icons.length(); ++i) {
@@ -654,6 +621,7 @@ void QNdefNfcSmartPosterRecord::setIcons(const QList<QNdefNfcIconRecord> &icons)
  */
 quint32 QNdefNfcSmartPosterRecord::size() const
 {
+    d->decode();
     if (d->m_size)
         return d->m_size->size();
 
@@ -668,8 +636,9 @@ quint32 QNdefNfcSmartPosterRecord::size() const
  */
 void QNdefNfcSmartPosterRecord::setSize(quint32 size)
 {
+    d->decode();
     if (!d->m_size)
-        d->m_size = new QNdefNfcSizeRecord();
+        d->m_size.emplace();
 
     d->m_size->setSize(size);
 
@@ -687,6 +656,7 @@ void QNdefNfcSmartPosterRecord::setSize(quint32 size)
  */
 QString QNdefNfcSmartPosterRecord::typeInfo() const
 {
+    d->decode();
     if (d->m_type)
         return d->m_type->typeInfo();
 
@@ -701,10 +671,8 @@ QString QNdefNfcSmartPosterRecord::typeInfo() const
  */
 void QNdefNfcSmartPosterRecord::setTypeInfo(const QString &type)
 {
-    if (d->m_type)
-        delete d->m_type;
-
-    d->m_type = new QNdefNfcTypeRecord();
+    d->decode();
+    d->m_type.emplace();
     d->m_type->setTypeInfo(type);
 
     // Convert to payload
@@ -779,4 +747,234 @@ QString QNdefNfcTypeRecord::typeInfo() const
     return QString::fromUtf8(payload());
 }
 
+QNdefNfcSmartPosterRecordPrivate::QNdefNfcSmartPosterRecordPrivate(
+        const QNdefNfcSmartPosterRecordPrivate &other)
+    : QSharedData(other)
+{
+    QMutexLocker locker(&other.m_mutex);
+
+    m_titleList = other.m_titleList;
+    m_uri = other.m_uri;
+    m_action = other.m_action;
+    m_iconList = other.m_iconList;
+    m_size = other.m_size;
+    m_type = other.m_type;
+
+    m_payload = other.m_payload;
+    m_iconLocations = other.m_iconLocations;
+    m_decoded.storeRelaxed(other.m_decoded.loadRelaxed());
+    m_iconsDecoded.storeRelaxed(other.m_iconsDecoded.loadRelaxed());
+}
+
+void QNdefNfcSmartPosterRecordPrivate::setPayload(const QByteArray &payload)
+{
+    clearRecords();
+
+    m_payload = payload;
+    m_decoded.storeRelaxed(payload.isEmpty());
+    m_iconsDecoded.storeRelaxed(payload.isEmpty());
+}
+
+void QNdefNfcSmartPosterRecordPrivate::decode() const
+{
+    if (m_decoded.loadAcquire())
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_decoded.loadRelaxed())
+        return;
+
+    if (!scanPayload()) {
+        // Leave the chunked or malformed records to the message decoder
+        clearRecords();
+
+        const QNdefMessage message = QNdefMessage::fromByteArray(m_payload);
+        for (const QNdefRecord &record : message)
+            addRecord(record);
+
+        m_payload.clear();
+        m_iconsDecoded.storeRelease(true);
+    }
+
+    m_decoded.storeRelease(true);
+}
+
+void QNdefNfcSmartPosterRecordPrivate::decodeIcons() const
+{
+    decode();
+
+    if (m_iconsDecoded.loadAcquire())
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_iconsDecoded.loadRelaxed())
+        return;
+
+    for (qsizetype i = 0; i < m_iconLocations.size(); ++i)
+        m_iconList.append(iconAt(i));
+
+    m_iconLocations.clear();
+    m_payload.clear();
+    m_iconsDecoded.storeRelease(true);
+}
+
+qsizetype QNdefNfcSmartPosterRecordPrivate::iconCount() const
+{
+    decode();
+
+    QMutexLocker locker(&m_mutex);
+    return m_iconsDecoded.loadRelaxed() ? m_iconList.size() : m_iconLocations.size();
+}
+
+QByteArray QNdefNfcSmartPosterRecordPrivate::iconType(qsizetype index) const
+{
+    decode();
+
+    QMutexLocker locker(&m_mutex);
+    return m_iconsDecoded.loadRelaxed() ? m_iconList.at(index).type()
+                                        : m_iconLocations.at(index).type;
+}
+
+QNdefNfcIconRecord QNdefNfcSmartPosterRecordPrivate::iconRecord(qsizetype index) const
+{
+    decode();
+
+    QMutexLocker locker(&m_mutex);
+    return m_iconsDecoded.loadRelaxed() ? m_iconList.at(index) : iconAt(index);
+}
+
+bool QNdefNfcSmartPosterRecordPrivate::addTitle(const QNdefNfcTextRecord &text) const
+{
+    for (qsizetype i = 0; i < m_titleList.length(); ++i) {
+        const QNdefNfcTextRecord &rec = m_titleList[i];
+
+        if (rec.locale() == text.locale())
+            return false;
+    }
+
+    m_titleList.append(text);
+    return true;
+}
+
+void QNdefNfcSmartPosterRecordPrivate::addIcon(const QNdefNfcIconRecord &icon) const
+{
+    m_iconList.removeIf([&icon](const QNdefNfcIconRecord &rec) {
+        return rec.type() == icon.type();
+    });
+
+    m_iconList.append(icon);
+}
+
+void QNdefNfcSmartPosterRecordPrivate::clearRecords() const
+{
+    m_titleList.clear();
+    m_uri.reset();
+    m_action.reset();
+    m_iconList.clear();
+    m_size.reset();
+    m_type.reset();
+    m_iconLocations.clear();
+}
+
+void QNdefNfcSmartPosterRecordPrivate::addRecord(const QNdefRecord &record) const
+{
+    // Title
+    if (record.isRecordType<QNdefNfcTextRecord>())
+        addTitle(record);
+
+    // URI
+    else if (record.isRecordType<QNdefNfcUriRecord>())
+        m_uri = QNdefNfcUriRecord(record);
+
+    // Action
+    else if (record.isRecordType<QNdefNfcActRecord>())
+        m_action = QNdefNfcActRecord(record);
+
+    // Icon
+    else if (record.isRecordType<QNdefNfcIconRecord>())
+        addIcon(record);
+
+    // Size
+    else if (record.isRecordType<QNdefNfcSizeRecord>())
+        m_size = QNdefNfcSizeRecord(record);
+
+    // Type
+    else if (record.isRecordType<QNdefNfcTypeRecord>())
+        m_type = QNdefNfcTypeRecord(record);
+}
+
+/*
+    Decodes the records in m_payload, except for the payloads of the icons,
+    which are copied out of it only when they are requested.
+
+    Returns false if the records are chunked or malformed.
+*/
+bool QNdefNfcSmartPosterRecordPrivate::scanPayload() const
+{
+    const QByteArrayView data(m_payload);
+
+    qsizetype idx = 0;
+    bool messageEnd = false;
+    while (!messageEnd && idx < data.size()) {
+        const quint8 flags = data[idx];
+        const bool messageBegin = flags & 0x80;
+        const bool chunked = flags & 0x20;
+        const bool shortRecord = flags & 0x10;
+        const bool hasId = flags & 0x08;
+        const quint8 typeNameFormat = flags & 0x07;
+        messageEnd = flags & 0x40;
+
+        if (messageBegin != (idx == 0) || chunked || typeNameFormat == 0x06)
+            return false;
+
+        const qsizetype headerLength = 2 + (shortRecord ? 1 : 4) + (hasId ? 1 : 0);
+        if (data.size() - idx < headerLength)
+            return false;
+
+        const quint8 typeLength = data[idx + 1];
+        qsizetype pos = idx + 2;
+        const quint32 payloadLength = shortRecord ? quint8(data[pos])
+                                                  : qFromBigEndian<quint32>(data.data() + pos);
+        pos += shortRecord ? 1 : 4;
+        const quint8 idLength = hasId ? quint8(data[pos++]) : 0;
+
+        if (quint64(typeLength) + idLength + payloadLength > quint64(data.size() - pos))
+            return false;
+
+        QNdefRecord record;
+        record.setTypeNameFormat(QNdefRecord::TypeNameFormat(typeNameFormat));
+        if (typeLength > 0)
+            record.setType(data.sliced(pos, typeLength).toByteArray());
+        pos += typeLength;
+        if (idLength > 0)
+            record.setId(data.sliced(pos, idLength).toByteArray());
+        pos += idLength;
+
+        if (record.isRecordType<QNdefNfcIconRecord>()) {
+            m_iconLocations.removeIf([&record](const IconLocation &icon) {
+                return icon.type == record.type();
+            });
+            m_iconLocations.append({ record.type(), record.id(), pos, qsizetype(payloadLength) });
+        } else {
+            record.setPayload(data.sliced(pos, payloadLength).toByteArray());
+            addRecord(record);
+        }
+
+        idx = pos + payloadLength;
+    }
+
+    return messageEnd && idx == data.size();
+}
+
+QNdefNfcIconRecord QNdefNfcSmartPosterRecordPrivate::iconAt(qsizetype index) const
+{
+    const IconLocation &location = m_iconLocations.at(index);
+
+    QNdefNfcIconRecord icon;
+    icon.setType(location.type);
+    icon.setId(location.id);
+    icon.setData(m_payload.sliced(location.offset, location.length));
+    return icon;
+}
+
 QT_END_NAMESPACE
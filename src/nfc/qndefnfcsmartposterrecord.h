@@ -102,7 +102,6 @@ public:
 private:
     QSharedDataPointer<QNdefNfcSmartPosterRecordPrivate> d;
 
-    void cleanup();
     void convertToPayload();
 
     bool addTitleInternal(const QNdefNfcTextRecord &text);
@@ -15,6 +15,13 @@
 // We mean it.
 //
 
+#include <qndefnfcsmartposterrecord.h>
+
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QMutex>
+
+#include <optional>
+
 QT_BEGIN_NAMESPACE
 
 class QNdefNfcActRecord : public QNdefRecord
@@ -48,14 +55,52 @@ class QNdefNfcSmartPosterRecordPrivate : public QSharedData
 {
 public:
     QNdefNfcSmartPosterRecordPrivate() {}
+    QNdefNfcSmartPosterRecordPrivate(const QNdefNfcSmartPosterRecordPrivate &other);
+
+    void setPayload(const QByteArray &payload);
+
+    // Decode the payload on first access, the icons are only located
+    void decode() const;
+    void decodeIcons() const;
+
+    qsizetype iconCount() const;
+    QByteArray iconType(qsizetype index) const;
+    QNdefNfcIconRecord iconRecord(qsizetype index) const;
+
+    bool addTitle(const QNdefNfcTextRecord &text) const;
+    void addIcon(const QNdefNfcIconRecord &icon) const;
 
 public:
-    QList<QNdefNfcTextRecord> m_titleList;
-    QNdefNfcUriRecord *m_uri = nullptr;
-    QNdefNfcActRecord *m_action = nullptr;
-    QList<QNdefNfcIconRecord> m_iconList;
-    QNdefNfcSizeRecord *m_size = nullptr;
-    QNdefNfcTypeRecord *m_type = nullptr;
+    // Everything below is only modified once decoded or while decoding
+    mutable QList<QNdefNfcTextRecord> m_titleList;
+    mutable std::optional<QNdefNfcUriRecord> m_uri;
+    mutable std::optional<QNdefNfcActRecord> m_action;
+    mutable QList<QNdefNfcIconRecord> m_iconList;
+    mutable std::optional<QNdefNfcSizeRecord> m_size;
+    mutable std::optional<QNdefNfcTypeRecord> m_type;
+
+private:
+    // An icon that was not copied out of m_payload yet
+    struct IconLocation
+    {
+        QByteArray type;
+        QByteArray id;
+        qsizetype offset;
+        qsizetype length;
+    };
+
+    void clearRecords() const;
+    void addRecord(const QNdefRecord &record) const;
+    bool scanPayload() const;
+    QNdefNfcIconRecord iconAt(qsizetype index) const;
+
+    // The payload the sub-records are decoded from, until all of them are
+    mutable QByteArray m_payload;
+    mutable QList<IconLocation> m_iconLocations;
+
+    mutable QMutex m_mutex;
+    mutable QAtomicInteger<bool> m_decoded = true;
+    mutable QAtomicInteger<bool> m_iconsDecoded = true;
 };
 
 QT_END_NAMESPACE
@@ -256,6 +256,153 @@ void QNearFieldManager::setUserInformation(const QString &message)
     d->setUserInformation(message);
 }
 
+/*!
+    \since 6.5
+
+    Sets whether the NDEF messages read from targets are cached to \a enabled. By default the
+    cache is disabled.
+
+    The cached message of a target is identified by its \l {QNearFieldTarget::}{uid()}. When the
+    message of a target is read again, only the length of the stored message is read at first. If
+    it is unchanged, the cached message is reported instead of reading the message again. This
+    speeds up repeated reads of the same tags considerably.
+
+    \note A message that was changed by another device without changing its length is not
+    detected. Only enable the cache if the messages of the tags are not modified elsewhere, or if
+    outdated messages are acceptable. Writing a message with QNearFieldTarget::writeNdefMessages()
+    always invalidates the cached message of the target.
+
+    \note Currently, this function only has an effect with the \l {PC/SC in Qt NFC}{PC/SC}
+    backend, for NFC Forum Type 4 tags. Other platforms always read the complete message.
+
+    Disabling the cache clears it.
+
+    \sa isNdefCacheEnabled(), QNearFieldTarget::readNdefMessages()
+*/
+void QNearFieldManager::setNdefCacheEnabled(bool enabled)
+{
+    Q_D(QNearFieldManager);
+
+    d->setNdefCacheEnabled(enabled);
+}
+
+/*!
+    \since 6.5
+
+    Returns \c true if the NDEF messages read from targets are cached, otherwise returns
+    \c false.
+
+    \sa setNdefCacheEnabled()
+*/
+bool QNearFieldManager::isNdefCacheEnabled() const
+{
+    Q_D(const QNearFieldManager);
+
+    return d->isNdefCacheEnabled();
+}
+
+/*!
+    \since 6.5
+
+    Returns the approximate number of bytes held by the cached NDEF messages, including the
+    UIDs and validation data they are cached with. Returns \c 0 if the cache is disabled or
+    not supported by the platform.
+
+    With the \c qt.nfc.memory logging category enabled, the size of the cache is logged
+    whenever a message is added to it.
+
+    \sa setNdefCacheEnabled()
+*/
+qsizetype QNearFieldManager::ndefCacheMemoryUsage() const
+{
+    Q_D(const QNearFieldManager);
+
+    return d->ndefCacheMemoryUsage();
+}
+
+/*!
+    \since 6.5
+
+    Sets the interval in which the presence of idle targets is checked to \a msecs
+    milliseconds. The targetLost() signal is emitted after the check fails. The default
+    interval is 1000 milliseconds.
+
+    A target that answers requests is not checked, so that busy targets are not polled. A
+    request that fails because the target was removed emits targetLost() immediately.
+    An interval of 0 disables the checks. Then the loss of a target is only reported when a
+    request to it fails.
+
+    Shorter intervals report removal sooner, but wake up the NFC stack more often.
+
+    \note Currently, this function only has an effect on Android. Other platforms are notified
+    by the system when a target is removed, and targetPresenceCheckInterval() returns 0.
+
+    \sa targetPresenceCheckInterval(), targetLost()
+*/
+void QNearFieldManager::setTargetPresenceCheckInterval(int msecs)
+{
+    Q_D(QNearFieldManager);
+
+    d->setTargetPresenceCheckInterval(msecs);
+}
+
+/*!
+    \since 6.5
+
+    Returns the interval in milliseconds in which the presence of idle targets is checked, or 0
+    if it is not checked.
+
+    \sa setTargetPresenceCheckInterval()
+*/
+int QNearFieldManager::targetPresenceCheckInterval() const
+{
+    Q_D(const QNearFieldManager);
+
+    return d->targetPresenceCheckInterval();
+}
+
+/*!
+    \since 6.5
+
+    Sets whether targets are detected in reader mode to \a enabled. By default reader mode is
+    disabled.
+
+    In reader mode, the application has exclusive access to the NFC adapter while target
+    detection is running and the application is in the foreground. Detected tags are handed to
+    the application directly, instead of being dispatched by the system first. If
+    startTargetDetection() is called without QNearFieldTarget::NdefAccess, the system also skips
+    checking the tag for an NDEF message. Both reduce the time until targetDetected() is emitted.
+
+    While reader mode is enabled, other applications and the system do not receive tags, and the
+    application is not started by tags.
+
+    If target detection is running, the new mode takes effect immediately.
+
+    \note Currently, this function only has an effect on Android.
+
+    \sa isReaderModeEnabled(), startTargetDetection()
+*/
+void QNearFieldManager::setReaderModeEnabled(bool enabled)
+{
+    Q_D(QNearFieldManager);
+
+    d->setReaderModeEnabled(enabled);
+}
+
+/*!
+    \since 6.5
+
+    Returns \c true if targets are detected in reader mode, otherwise returns \c false.
+
+    \sa setReaderModeEnabled()
+*/
+bool QNearFieldManager::isReaderModeEnabled() const
+{
+    Q_D(const QNearFieldManager);
+
+    return d->isReaderModeEnabled();
+}
+
 QT_END_NAMESPACE
 
 #include "moc_qnearfieldmanager_p.cpp"
@@ -41,6 +41,16 @@ public:
 
     void setUserInformation(const QString &message);
 
+    void setNdefCacheEnabled(bool enabled);
+    bool isNdefCacheEnabled() const;
+    qsizetype ndefCacheMemoryUsage() const;
+
+    void setTargetPresenceCheckInterval(int msecs);
+    int targetPresenceCheckInterval() const;
+
+    void setReaderModeEnabled(bool enabled);
+    bool isReaderModeEnabled() const;
+
 Q_SIGNALS:
     void adapterStateChanged(QNearFieldManager::AdapterState state);
     void targetDetectionStopped();
@@ -91,6 +91,7 @@ bool QNearFieldManagerPrivateImpl::startTargetDetection(QNearFieldTarget::Access
 
     detecting = true;
     requestedMethod = accessMethod;
+    updateReaderMode();
     updateReceiveState();
     return true;
 }
@@ -102,6 +103,30 @@ void QNearFieldManagerPrivateImpl::stopTargetDetection(const QString &)
     Q_EMIT targetDetectionStopped();
 }
 
+void QNearFieldManagerPrivateImpl::setTargetPresenceCheckInterval(int msecs)
+{
+    presenceCheckInterval = qMax(msecs, 0);
+    for (QNearFieldTargetPrivateImpl *target : std::as_const(detectedTargets))
+        target->setTargetCheckInterval(presenceCheckInterval);
+}
+
+int QNearFieldManagerPrivateImpl::targetPresenceCheckInterval() const
+{
+    return presenceCheckInterval;
+}
+
+void QNearFieldManagerPrivateImpl::setReaderModeEnabled(bool enabled)
+{
+    readerMode = enabled;
+    if (detecting)
+        updateReaderMode();
+}
+
+bool QNearFieldManagerPrivateImpl::isReaderModeEnabled() const
+{
+    return readerMode;
+}
+
 void QNearFieldManagerPrivateImpl::newIntent(QJniObject intent)
 {
     // This function is called from different thread and is used to move intent to main thread.
@@ -130,6 +155,7 @@ void QNearFieldManagerPrivateImpl::onTargetDiscovered(QJniObject intent)
         target->setIntent(intent);  // Updating existing target
     } else {
         target = new QNearFieldTargetPrivateImpl(intent, uid);
+        target->setTargetCheckInterval(presenceCheckInterval);
 
         if (target->accessMethods() & requestedMethod) {
             connect(target, &QNearFieldTargetPrivateImpl::targetDestroyed, this, &QNearFieldManagerPrivateImpl::onTargetDestroyed);
@@ -161,6 +187,12 @@ QByteArray QNearFieldManagerPrivateImpl::getUidforTag(const QJniObject &tag)
     return uid;
 }
 
+void QNearFieldManagerPrivateImpl::updateReaderMode()
+{
+    // NDEF access needs the NDEF check, it adds the Ndef technology to the tag
+    AndroidNfc::setReaderMode(readerMode, !(requestedMethod & QNearFieldTarget::NdefAccess));
+}
+
 void QNearFieldManagerPrivateImpl::updateReceiveState()
 {
     if (detecting) {
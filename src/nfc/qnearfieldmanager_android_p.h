@@ -42,16 +42,23 @@ public:
     bool isSupported(QNearFieldTarget::AccessMethod accessMethod) const override;
     bool startTargetDetection(QNearFieldTarget::AccessMethod accessMethod) override;
     void stopTargetDetection(const QString &errorMessage) override;
+    void setTargetPresenceCheckInterval(int msecs) override;
+    int targetPresenceCheckInterval() const override;
+    void setReaderModeEnabled(bool enabled) override;
+    bool isReaderModeEnabled() const override;
     void newIntent(QJniObject intent) override;
     QByteArray getUid(const QJniObject &intent);
 
 protected:
     static QByteArray getUidforTag(const QJniObject &tag);
     void updateReceiveState();
+    void updateReaderMode();
 
 private:
     bool detecting;
     QNearFieldTarget::AccessMethod requestedMethod;
+    int presenceCheckInterval = 1000;
+    bool readerMode = false;
     QHash<QByteArray, QNearFieldTargetPrivateImpl*> detectedTargets;
 
 private slots:
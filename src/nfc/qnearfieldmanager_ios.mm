@@ -125,8 +125,16 @@ void QNearFieldManagerPrivateImpl::onTargetLost(QNearFieldTargetPrivateImpl *tar
     detectedTargets.removeOne(target);
     Q_EMIT targetLost(target->q_ptr);
 
-    if (detectionRunning && detectedTargets.isEmpty())
-        onDidInvalidateWithError(true);
+    if (!detectionRunning || !detectedTargets.isEmpty())
+        return;
+
+    // Poll for the next tag in the running session, a new session would show the sheet again
+    if (@available(iOS 13, *)) {
+        if ([delegate restartPolling])
+            return;
+    }
+
+    onDidInvalidateWithError(true);
 }
 
 void QNearFieldManagerPrivateImpl::onDidInvalidateWithError(bool doRestart)
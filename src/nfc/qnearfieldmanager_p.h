@@ -64,6 +64,38 @@ public:
     {
     }
 
+    virtual void setNdefCacheEnabled(bool)
+    {
+    }
+
+    virtual bool isNdefCacheEnabled() const
+    {
+        return false;
+    }
+
+    virtual qsizetype ndefCacheMemoryUsage() const
+    {
+        return 0;
+    }
+
+    virtual void setTargetPresenceCheckInterval(int)
+    {
+    }
+
+    virtual int targetPresenceCheckInterval() const
+    {
+        return 0;
+    }
+
+    virtual void setReaderModeEnabled(bool)
+    {
+    }
+
+    virtual bool isReaderModeEnabled() const
+    {
+        return false;
+    }
+
 signals:
     void adapterStateChanged(QNearFieldManager::AdapterState state);
     void targetDetectionStopped();
@@ -5,6 +5,7 @@
 #include "qnearfieldtarget_pcsc_p.h"
 #include "pcsc/qpcscmanager_p.h"
 #include "pcsc/qpcsccard_p.h"
+#include "ndef/qndefmessagecache_p.h"
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QThread>
 
@@ -19,13 +20,14 @@ Q_DECLARE_LOGGING_CATEGORY(QT_NFC_PCSC)
 
     This object creates a worker thread with an instance of QPcscManager in
     it. All the communication with QPcscManager is done using signal-slot
-    mechanism.
+    mechanism. The cards live in a thread per reader, see QPcscSlot.
 */
 QNearFieldManagerPrivateImpl::QNearFieldManagerPrivateImpl()
+    : m_ndefCache(std::make_shared<QNdefMessageCache>())
 {
     qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
 
-    m_worker = new QPcscManager;
+    m_worker = new QPcscManager(m_ndefCache);
     m_workerThread = new QThread(this);
     m_workerThread->setObjectName(u"QtNfcThread"_s);
     m_worker->moveToThread(m_workerThread);
@@ -87,6 +89,21 @@ void QNearFieldManagerPrivateImpl::stopTargetDetection(const QString &errorMessa
     Q_EMIT stopTargetDetectionRequest();
 }
 
+void QNearFieldManagerPrivateImpl::setNdefCacheEnabled(bool enabled)
+{
+    m_ndefCache->setEnabled(enabled);
+}
+
+bool QNearFieldManagerPrivateImpl::isNdefCacheEnabled() const
+{
+    return m_ndefCache->isEnabled();
+}
+
+qsizetype QNearFieldManagerPrivateImpl::ndefCacheMemoryUsage() const
+{
+    return m_ndefCache->memoryUsage();
+}
+
 /*
     Invoked when the worker has detected a new card.
 
@@ -94,18 +111,22 @@ void QNearFieldManagerPrivateImpl::stopTargetDetection(const QString &errorMessa
     emits targetCreatedForCard() signal.
 */
 void QNearFieldManagerPrivateImpl::onCardInserted(QPcscCard *card, const QByteArray &uid,
+                                                  QNearFieldTarget::Type type,
                                                   QNearFieldTarget::AccessMethods accessMethods,
                                                   int maxInputLength)
 {
     qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
 
-    auto priv = new QNearFieldTargetPrivateImpl(uid, accessMethods, maxInputLength, this);
+    auto priv = new QNearFieldTargetPrivateImpl(uid, type, accessMethods, maxInputLength, this);
+    priv->setTimings(card->timings());
 
     connect(priv, &QNearFieldTargetPrivateImpl::disconnectRequest, card,
             &QPcscCard::onDisconnectRequest);
     connect(priv, &QNearFieldTargetPrivateImpl::destroyed, card, &QPcscCard::onTargetDestroyed);
     connect(priv, &QNearFieldTargetPrivateImpl::sendCommandRequest, card,
             &QPcscCard::onSendCommandRequest);
+    connect(priv, &QNearFieldTargetPrivateImpl::sendCommandsRequest, card,
+            &QPcscCard::onSendCommandsRequest);
     connect(priv, &QNearFieldTargetPrivateImpl::readNdefMessagesRequest, card,
             &QPcscCard::onReadNdefMessagesRequest);
     connect(priv, &QNearFieldTargetPrivateImpl::writeNdefMessagesRequest, card,
@@ -120,6 +141,8 @@ void QNearFieldManagerPrivateImpl::onCardInserted(QPcscCard *card, const QByteAr
             &QNearFieldTargetPrivateImpl::onRequestCompleted);
     connect(card, &QPcscCard::ndefMessageRead, priv,
             &QNearFieldTargetPrivateImpl::onNdefMessageRead);
+    connect(card, &QPcscCard::ndefRecordRead, priv,
+            &QNearFieldTargetPrivateImpl::onNdefRecordRead);
 
     auto target = new QNearFieldTarget(priv, this);
 
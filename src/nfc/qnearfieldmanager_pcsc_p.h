@@ -17,8 +17,11 @@
 
 #include "qnearfieldmanager_p.h"
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
+class QNdefMessageCache;
 class QPcscManager;
 class QPcscCard;
 class QThread;
@@ -36,8 +39,12 @@ public:
     bool startTargetDetection(QNearFieldTarget::AccessMethod accessMethod) override;
     void stopTargetDetection(const QString &errorMessage) override;
 
+    void setNdefCacheEnabled(bool enabled) override;
+    bool isNdefCacheEnabled() const override;
+    qsizetype ndefCacheMemoryUsage() const override;
+
 public Q_SLOTS:
-    void onCardInserted(QPcscCard *card, const QByteArray &uid,
+    void onCardInserted(QPcscCard *card, const QByteArray &uid, QNearFieldTarget::Type type,
                         QNearFieldTarget::AccessMethods accessMethods, int maxInputLength);
     void onTargetLost(QNearFieldTargetPrivate *target);
 
@@ -48,6 +55,8 @@ Q_SIGNALS:
 private:
     QThread *m_workerThread;
     QPcscManager *m_worker;
+    // Shared with the card threads
+    const std::shared_ptr<QNdefMessageCache> m_ndefCache;
 };
 
 QT_END_NAMESPACE
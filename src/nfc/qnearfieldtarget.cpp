@@ -3,6 +3,7 @@
 
 #include "qnearfieldtarget.h"
 #include "qnearfieldtarget_p.h"
+#include "qnfctimings_p.h"
 #include "qndefmessage.h"
 
 #include <QtCore/QString>
@@ -106,6 +107,20 @@ QT_IMPL_METATYPE_EXTERN_TAGGED(QNearFieldTarget::RequestId, QNearFieldTarget__Re
     \sa readNdefMessages()
 */
 
+/*!
+    \fn void QNearFieldTarget::ndefRecordRead(const QNdefRecord &record)
+    \since 6.5
+
+    This signal is emitted when a complete NDEF \a record has been read from the target.
+
+    Where the backend decodes the message while reading it, the signal is emitted as soon
+    as the data of the record has been read, so that the first records can be handled
+    before the rest of the message is read. The records are also part of the message
+    reported by the ndefMessageRead() signal that follows.
+
+    \sa readNdefMessages()
+*/
+
 /*!
     \fn void QNearFieldTarget::requestCompleted(const QNearFieldTarget::RequestId &id)
 
@@ -292,7 +307,8 @@ bool QNearFieldTarget::hasNdefMessage()
     be used to track the completion status of the request. An invalid request id will be returned
     if the target does not support reading NDEF messages.
 
-    An ndefMessageRead() signal will be emitted for each NDEF message. The requestCompleted()
+    An ndefMessageRead() signal will be emitted for each NDEF message, preceded by an
+    ndefRecordRead() signal for each of its records. The requestCompleted()
     signal will be emitted was all NDEF messages have been read. The error() signal is emitted if
     an error occurs.
 
@@ -357,6 +373,113 @@ QNearFieldTarget::RequestId QNearFieldTarget::sendCommand(const QByteArray &comm
     return d->sendCommand(command);
 }
 
+/*!
+    \since 6.5
+
+    Sends the \a commands to the near field target one after another, without waiting for the
+    application in between. Returns a request id which can be used to track the completion status
+    of the request. An invalid request id will be returned if the target does not support sending
+    tag type specific commands, or if \a commands is empty.
+
+    If \a expectedStatusWords is not empty, it must contain the expected ISO/IEC 7816-4 status word
+    for each command, for example \c 0x9000. The remaining commands are not sent once a response
+    does not end with the expected status word. This way, a sequence of commands can be aborted
+    when one of them fails.
+
+    The requestCompleted() signal will be emitted once the commands were sent; the error() signal
+    will be emitted if a command could not be sent.
+
+    Once the request completes successfully the responses can be retrieved from the
+    requestResponse() function. The response of this request will be a QList<QByteArray> with the
+    response to each command that was sent. It is shorter than \a commands if the sequence was
+    aborted, the last response is then the unexpected one.
+
+    With \l {PC/SC in Qt NFC}{PC/SC}, all the commands are sent within the transaction that
+    sendCommand() uses, so that no other application can access the card in between.
+
+    \sa sendCommand(), requestCompleted(), waitForRequestCompleted()
+*/
+QNearFieldTarget::RequestId QNearFieldTarget::sendCommands(const QList<QByteArray> &commands,
+                                                           const QList<quint16> &expectedStatusWords)
+{
+    Q_D(QNearFieldTarget);
+
+    if (commands.isEmpty()
+        || (!expectedStatusWords.isEmpty() && expectedStatusWords.size() != commands.size())) {
+        const RequestId id;
+        Q_EMIT error(InvalidParametersError, id);
+        return id;
+    }
+
+    return d->sendCommands(commands, expectedStatusWords);
+}
+
+/*!
+    \enum QNearFieldTarget::Timing
+    \since 6.5
+
+    This enum describes the durations that are measured for a target.
+
+    \value CommandRoundTrip        The time from sending a single command to the tag until its
+                                   response arrives. This is the share of the reader and the tag.
+    \value NdefProcessing          The time the backend spends in its own NDEF handling, without
+                                   the round trips of the commands it sends. This includes
+                                   choosing the commands and decoding the message.
+    \value DetectionToNdefMessage  The time from the detection of the target until its first NDEF
+                                   message has been read.
+
+    \sa timingStatistics()
+*/
+
+/*!
+    \class QNearFieldTarget::TimingStatistics
+    \inmodule QtNfc
+    \inheaderfile QNearFieldTarget
+    \since 6.5
+    \brief The TimingStatistics struct holds the measurements of one kind of duration.
+
+    \c count is the number of measurements, \c total, \c minimum and \c maximum summarize
+    them. \c histogram counts the measurements per range of durations: the first bucket holds
+    those below one microsecond, bucket \c i those from 2\sup{i - 1} up to 2\sup{i}
+    microseconds, and the last bucket all longer ones.
+
+    \sa QNearFieldTarget::timingStatistics()
+*/
+
+/*!
+    \since 6.5
+
+    Returns the statistics of the durations of kind \a timing that were measured since the
+    target was detected or resetTimingStatistics() was called.
+
+    The durations are also reported by the \c QNfcTimings_record tracepoint when Qt is built with
+    tracing support, so that they can be related to the events of the rest of the system.
+
+    Not every backend measures every kind of duration. The Android and iOS backends do not
+    implement NDEF access themselves, so NdefProcessing only covers their conversion of the
+    messages.
+*/
+QNearFieldTarget::TimingStatistics QNearFieldTarget::timingStatistics(Timing timing) const
+{
+    Q_D(const QNearFieldTarget);
+
+    return d->timings()->statistics(timing);
+}
+
+/*!
+    \since 6.5
+
+    Discards the statistics collected so far.
+
+    \sa timingStatistics()
+*/
+void QNearFieldTarget::resetTimingStatistics()
+{
+    Q_D(QNearFieldTarget);
+
+    d->timings()->reset();
+}
+
 /*!
     Waits up to \a msecs milliseconds for the request \a id to complete.
     Returns \c true if the request completes successfully and the
@@ -394,11 +517,19 @@ QNearFieldTarget::QNearFieldTarget(QNearFieldTargetPrivate *backend, QObject *pa
     qRegisterMetaType<QNearFieldTarget::RequestId>();
     qRegisterMetaType<QNearFieldTarget::Error>();
     qRegisterMetaType<QNdefMessage>();
+    qRegisterMetaType<QNdefRecord>();
+
+    // All backends report their messages through this signal eventually
+    connect(this, &QNearFieldTarget::ndefMessageRead, d, [d] {
+        d->timings()->recordNdefMessage();
+    });
 
     connect(d, &QNearFieldTargetPrivate::disconnected,
             this, &QNearFieldTarget::disconnected);
     connect(d, &QNearFieldTargetPrivate::ndefMessageRead,
             this, &QNearFieldTarget::ndefMessageRead);
+    connect(d, &QNearFieldTargetPrivate::ndefRecordRead,
+            this, &QNearFieldTarget::ndefRecordRead);
     connect(d, &QNearFieldTargetPrivate::requestCompleted,
             this, &QNearFieldTarget::requestCompleted);
     connect(d, &QNearFieldTargetPrivate::error,
@@ -12,9 +12,12 @@
 #include <QtCore/QVariant>
 #include <QtNfc/qtnfcglobal.h>
 
+#include <chrono>
+
 QT_BEGIN_NAMESPACE
 
 class QNdefMessage;
+class QNdefRecord;
 class QNearFieldTargetPrivate;
 class QNearFieldManagerPrivateImpl;
 
@@ -84,6 +87,22 @@ public:
         QSharedDataPointer<RequestIdPrivate> d;
     };
 
+    enum class Timing {
+        CommandRoundTrip,
+        NdefProcessing,
+        DetectionToNdefMessage
+    };
+    Q_ENUM(Timing)
+
+    struct TimingStatistics
+    {
+        quint64 count = 0;
+        std::chrono::nanoseconds total = {};
+        std::chrono::nanoseconds minimum = {};
+        std::chrono::nanoseconds maximum = {};
+        QList<quint64> histogram;
+    };
+
     explicit QNearFieldTarget(QObject *parent = nullptr);
     ~QNearFieldTarget();
 
@@ -101,14 +120,20 @@ public:
     // TagTypeSpecificAccess
     int maxCommandLength() const;
     RequestId sendCommand(const QByteArray &command);
+    RequestId sendCommands(const QList<QByteArray> &commands,
+                           const QList<quint16> &expectedStatusWords = {});
 
     bool waitForRequestCompleted(const RequestId &id, int msecs = 5000);
     QVariant requestResponse(const RequestId &id) const;
 
+    TimingStatistics timingStatistics(Timing timing) const;
+    void resetTimingStatistics();
+
 Q_SIGNALS:
     void disconnected();
 
     void ndefMessageRead(const QNdefMessage &message);
+    void ndefRecordRead(const QNdefRecord &record);
 
     void requestCompleted(const QNearFieldTarget::RequestId &id);
 
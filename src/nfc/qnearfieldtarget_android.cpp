@@ -3,8 +3,12 @@
 
 #include "qnearfieldtarget_android_p.h"
 #include "android/androidjninfc_p.h"
+#include "qnfctimings_p.h"
 #include "qdebug.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+
 #define NDEFTECHNOLOGY              QStringLiteral("android.nfc.tech.Ndef")
 #define NDEFFORMATABLETECHNOLOGY    QStringLiteral("android.nfc.tech.NdefFormatable")
 #define ISODEPTECHNOLOGY            QStringLiteral("android.nfc.tech.IsoDep")
@@ -21,6 +25,82 @@
 #define NFCTAGTYPE3 QStringLiteral("org.nfcforum.ndef.type3")
 #define NFCTAGTYPE4 QStringLiteral("org.nfcforum.ndef.type4")
 
+static QByteArray jbyteArrayToQByteArray(const jbyteArray &byteArray)
+{
+    QJniEnvironment env;
+    jsize len = env->GetArrayLength(byteArray);
+    QByteArray resultArray(len, Qt::Uninitialized);
+    env->GetByteArrayRegion(byteArray, 0, len, reinterpret_cast<jbyte*>(resultArray.data()));
+    return resultArray;
+}
+
+static bool setCommandTimeout(const QJniObject &tagTech, int timeout)
+{
+    if (!tagTech.isValid())
+        return false;
+
+    QJniEnvironment env;
+    auto methodId = env.findMethod(tagTech.objectClass(), "setTimeout", "(I)V");
+    if (methodId)
+        env->CallVoidMethod(tagTech.object(), methodId, timeout);
+    return methodId && !env.checkAndClearExceptions();
+}
+
+/*
+    Connects the tag technology unless it is connected already. This talks
+    to the tag, so it is only called on the I/O thread.
+*/
+static bool connectTagTechnology(const QJniObject &tagTech)
+{
+    if (!tagTech.isValid())
+        return false;
+
+    QJniEnvironment env;
+    auto methodId = env.findMethod(tagTech.objectClass(), "isConnected", "()Z");
+    bool connected = false;
+    if (methodId)
+        connected = env->CallBooleanMethod(tagTech.object(), methodId);
+    if (!methodId || env.checkAndClearExceptions())
+        return false;
+
+    if (connected)
+        return true;
+
+    setCommandTimeout(tagTech, 2000);
+    methodId = env.findMethod(tagTech.objectClass(), "connect", "()V");
+    if (!methodId)
+        return false;
+    env->CallVoidMethod(tagTech.object(), methodId);
+    return !env.checkAndClearExceptions();
+}
+
+/*
+    Sends command to the connected tag technology and stores its answer in
+    response. Returns false if the tag did not answer.
+*/
+static bool transceive(const QJniObject &tagTech, QByteArrayView command, QByteArray *response,
+                       QNfcTimings *timings)
+{
+    QJniEnvironment env;
+
+    // Making QByteArray
+    jbyteArray jba = env->NewByteArray(command.size());
+    env->SetByteArrayRegion(jba, 0, command.size(),
+                            reinterpret_cast<const jbyte *>(command.constData()));
+
+    // Writing
+    QElapsedTimer timer;
+    timer.start();
+    QJniObject myNewVal = tagTech.callObjectMethod("transceive", "([B)[B", jba);
+    timings->record(QNearFieldTarget::Timing::CommandRoundTrip, timer.nsecsElapsed());
+    env->DeleteLocalRef(jba);
+    if (!myNewVal.isValid())
+        return false;
+
+    *response = jbyteArrayToQByteArray(myNewVal.object<jbyteArray>());
+    return true;
+}
+
 QNearFieldTargetPrivateImpl::QNearFieldTargetPrivateImpl(QJniObject intent,
                                                          const QByteArray uid,
                                                          QObject *parent)
@@ -36,6 +116,12 @@ QNearFieldTargetPrivateImpl::QNearFieldTargetPrivateImpl(QJniObject intent,
 QNearFieldTargetPrivateImpl::~QNearFieldTargetPrivateImpl()
 {
     releaseIntent();
+    if (ioThread) {
+        // Let a running exchange finish, the queued ones are dropped with ioContext
+        ioThread->quit();
+        ioThread->wait();
+        delete ioContext;
+    }
     Q_EMIT targetDestroyed(targetUid);
 }
 
@@ -106,36 +192,42 @@ QNearFieldTarget::RequestId QNearFieldTargetPrivateImpl::readNdefMessages()
         return requestId;
     }
 
-    // Connect
-    if (!connect()) {
-        reportError(QNearFieldTarget::ConnectionError, requestId);
-        return requestId;
-    }
+    queueIoRequest([this, tech = tagTech, requestId]() {
+        // Connect
+        if (!connectTagTechnology(tech)) {
+            postError(QNearFieldTarget::ConnectionError, requestId);
+            return;
+        }
 
-    // Get NdefMessage object
-    QJniObject ndefMessage = tagTech.callObjectMethod("getNdefMessage", "()Landroid/nfc/NdefMessage;");
-    if (!ndefMessage.isValid()) {
-        reportError(QNearFieldTarget::NdefReadError, requestId);
-        return requestId;
-    }
+        // Get NdefMessage object
+        QJniObject ndefMessage = tech.callObjectMethod("getNdefMessage", "()Landroid/nfc/NdefMessage;");
+        if (!ndefMessage.isValid()) {
+            postError(QNearFieldTarget::NdefReadError, requestId);
+            return;
+        }
 
-    // Convert to byte array
-    QJniObject ndefMessageBA = ndefMessage.callObjectMethod("toByteArray", "()[B");
-    QByteArray ndefMessageQBA = jbyteArrayToQByteArray(ndefMessageBA.object<jbyteArray>());
+        // Convert to byte array
+        QElapsedTimer timer;
+        timer.start();
+        QJniObject ndefMessageBA = ndefMessage.callObjectMethod("toByteArray", "()[B");
+        QByteArray ndefMessageQBA = jbyteArrayToQByteArray(ndefMessageBA.object<jbyteArray>());
+
+        // Sending QNdefMessage, requestCompleted and exit.
+        QNdefMessage qNdefMessage = QNdefMessage::fromByteArray(ndefMessageQBA);
+        timings()->record(QNearFieldTarget::Timing::NdefProcessing, timer.nsecsElapsed());
+        QMetaObject::invokeMethod(this, [this, qNdefMessage, requestId]() {
+            postponeTargetCheck();
+            // The message is read at once, so the records are only available now
+            for (const QNdefRecord &record : qNdefMessage)
+                Q_EMIT this->q_ptr->ndefRecordRead(record);
+            Q_EMIT this->q_ptr->ndefMessageRead(qNdefMessage);
+            Q_EMIT this->requestCompleted(requestId);
+            //TODO This is an Android specific signal in NearFieldTarget.
+            //     We need to check if it is still necessary.
+            Q_EMIT this->ndefMessageRead(qNdefMessage, requestId);
+        }, Qt::QueuedConnection);
+    });
 
-    // Sending QNdefMessage, requestCompleted and exit.
-    QNdefMessage qNdefMessage = QNdefMessage::fromByteArray(ndefMessageQBA);
-    QMetaObject::invokeMethod(this, [this, qNdefMessage]() {
-        Q_EMIT this->q_ptr->ndefMessageRead(qNdefMessage);
-    }, Qt::QueuedConnection);
-    QMetaObject::invokeMethod(this, [this, requestId]() {
-        Q_EMIT this->requestCompleted(requestId);
-    }, Qt::QueuedConnection);
-    QMetaObject::invokeMethod(this, [this, qNdefMessage, requestId]() {
-        //TODO This is an Android specific signal in NearFieldTarget.
-        //     We need to check if it is still necessary.
-        Q_EMIT this->ndefMessageRead(qNdefMessage, requestId);
-    }, Qt::QueuedConnection);
     return requestId;
 }
 
@@ -158,6 +250,11 @@ int QNearFieldTargetPrivateImpl::maxCommandLength() const
     return tagTech.callMethod<jint>("getMaxTransceiveLength");
 }
 
+static QStringList commandTechnologies()
+{
+    return { ISODEPTECHNOLOGY, NFCATECHNOLOGY, NFCBTECHNOLOGY, NFCFTECHNOLOGY, NFCVTECHNOLOGY };
+}
+
 QNearFieldTarget::RequestId QNearFieldTargetPrivateImpl::sendCommand(const QByteArray &command)
 {
     if (command.size() == 0 || command.size() > maxCommandLength()) {
@@ -169,45 +266,82 @@ QNearFieldTarget::RequestId QNearFieldTargetPrivateImpl::sendCommand(const QByte
     if (!(accessMethods() & QNearFieldTarget::TagTypeSpecificAccess))
         return QNearFieldTarget::RequestId();
 
-    QJniEnvironment env;
-
-    if (!setTagTechnology({ISODEPTECHNOLOGY, NFCATECHNOLOGY, NFCBTECHNOLOGY, NFCFTECHNOLOGY, NFCVTECHNOLOGY})) {
+    if (!setTagTechnology(commandTechnologies())) {
         Q_EMIT error(QNearFieldTarget::UnsupportedError, QNearFieldTarget::RequestId());
         return QNearFieldTarget::RequestId();
     }
 
-    // Connecting
     QNearFieldTarget::RequestId requestId = QNearFieldTarget::RequestId(new QNearFieldTarget::RequestIdPrivate());
-    if (!connect()) {
-        reportError(QNearFieldTarget::ConnectionError, requestId);
-        return requestId;
-    }
+    queueIoRequest([this, tech = tagTech, command, requestId]() {
+        // Connecting
+        if (!connectTagTechnology(tech)) {
+            postError(QNearFieldTarget::ConnectionError, requestId);
+            return;
+        }
 
-    // Making QByteArray
-    QByteArray ba(command);
-    jbyteArray jba = env->NewByteArray(ba.size());
-    env->SetByteArrayRegion(jba, 0, ba.size(), reinterpret_cast<jbyte*>(ba.data()));
+        QByteArray result;
+        if (!transceive(tech, command, &result, timings().get())) {
+            postTargetLost(requestId);
+            return;
+        }
 
-    // Writing
-    QJniObject myNewVal = tagTech.callObjectMethod("transceive", "([B)[B", jba);
-    if (!myNewVal.isValid()) {
-        // Some devices (Samsung, Huawei) throw an exception when the card is lost:
-        // "android.nfc.TagLostException: Tag was lost". But there seems to be a bug that
-        // isConnected still reports true. So we need to invalidate the target as soon as
-        // possible and treat the card as lost.
-        handleTargetLost();
+        QMetaObject::invokeMethod(this, [this, requestId, result = std::move(result)]() {
+            postponeTargetCheck();
+            setResponseForRequest(requestId, result);
+        }, Qt::QueuedConnection);
+    });
 
-        reportError(QNearFieldTarget::CommandError, requestId);
-        return requestId;
+    return requestId;
+}
+
+QNearFieldTarget::RequestId
+QNearFieldTargetPrivateImpl::sendCommands(const QList<QByteArray> &commands,
+                                          const QList<quint16> &expectedStatusWords)
+{
+    const int maxLength = maxCommandLength();
+    for (const QByteArray &command : commands) {
+        if (command.size() == 0 || command.size() > maxLength) {
+            Q_EMIT error(QNearFieldTarget::InvalidParametersError, QNearFieldTarget::RequestId());
+            return QNearFieldTarget::RequestId();
+        }
     }
-    QByteArray result = jbyteArrayToQByteArray(myNewVal.object<jbyteArray>());
-    env->DeleteLocalRef(jba);
 
-    setResponseForRequest(requestId, result, false);
+    // Making sure that target has commands
+    if (!(accessMethods() & QNearFieldTarget::TagTypeSpecificAccess))
+        return QNearFieldTarget::RequestId();
 
-    QMetaObject::invokeMethod(this, [this, requestId]() {
-        Q_EMIT this->requestCompleted(requestId);
-    }, Qt::QueuedConnection);
+    if (!setTagTechnology(commandTechnologies())) {
+        Q_EMIT error(QNearFieldTarget::UnsupportedError, QNearFieldTarget::RequestId());
+        return QNearFieldTarget::RequestId();
+    }
+
+    QNearFieldTarget::RequestId requestId = QNearFieldTarget::RequestId(new QNearFieldTarget::RequestIdPrivate());
+    queueIoRequest([this, tech = tagTech, commands, expectedStatusWords, requestId]() {
+        // Connecting once for all the commands
+        if (!connectTagTechnology(tech)) {
+            postError(QNearFieldTarget::ConnectionError, requestId);
+            return;
+        }
+
+        QList<QByteArray> responses;
+        responses.reserve(commands.size());
+        for (qsizetype i = 0; i < commands.size(); ++i) {
+            QByteArray response;
+            if (!transceive(tech, commands.at(i), &response, timings().get())) {
+                postTargetLost(requestId);
+                return;
+            }
+            const bool expected = hasExpectedStatusWord(response, expectedStatusWords, i);
+            responses.append(std::move(response));
+            if (!expected)
+                break;
+        }
+
+        QMetaObject::invokeMethod(this, [this, requestId, responses = std::move(responses)]() {
+            postponeTargetCheck();
+            setResponseForRequest(requestId, QVariant::fromValue(responses));
+        }, Qt::QueuedConnection);
+    });
 
     return requestId;
 }
@@ -220,7 +354,6 @@ QNearFieldTarget::RequestId QNearFieldTargetPrivateImpl::writeNdefMessages(const
     if (messages.size() > 1)
         qWarning("QNearFieldTarget::writeNdefMessages: Android supports writing only one NDEF message per tag.");
 
-    QJniEnvironment env;
     const char *writeMethod;
 
     if (!setTagTechnology({NDEFFORMATABLETECHNOLOGY, NDEFTECHNOLOGY}))
@@ -232,37 +365,81 @@ QNearFieldTarget::RequestId QNearFieldTargetPrivateImpl::writeNdefMessages(const
     else
         writeMethod = "writeNdefMessage";
 
-    // Connecting
     QNearFieldTarget::RequestId requestId = QNearFieldTarget::RequestId(new QNearFieldTarget::RequestIdPrivate());
-    if (!connect()) {
-        reportError(QNearFieldTarget::ConnectionError, requestId);
-        return requestId;
-    }
+    const QByteArray ba = messages.first().toByteArray();
+    queueIoRequest([this, tech = tagTech, writeMethod, ba, requestId]() {
+        // Connecting
+        if (!connectTagTechnology(tech)) {
+            postError(QNearFieldTarget::ConnectionError, requestId);
+            return;
+        }
 
-    // Making NdefMessage object
-    const QNdefMessage &message = messages.first();
-    QByteArray ba = message.toByteArray();
-    QJniObject jba = env->NewByteArray(ba.size());
-    env->SetByteArrayRegion(jba.object<jbyteArray>(), 0, ba.size(), reinterpret_cast<jbyte*>(ba.data()));
-    QJniObject jmessage = QJniObject("android/nfc/NdefMessage", "([B)V", jba.object<jbyteArray>());
-    if (!jmessage.isValid()) {
-        reportError(QNearFieldTarget::UnknownError, requestId);
-        return requestId;
-    }
+        // Making NdefMessage object
+        QJniEnvironment env;
+        QJniObject jba = env->NewByteArray(ba.size());
+        env->SetByteArrayRegion(jba.object<jbyteArray>(), 0, ba.size(), reinterpret_cast<const jbyte*>(ba.constData()));
+        QJniObject jmessage = QJniObject("android/nfc/NdefMessage", "([B)V", jba.object<jbyteArray>());
+        if (!jmessage.isValid()) {
+            postError(QNearFieldTarget::UnknownError, requestId);
+            return;
+        }
 
-    // Writing
-    auto methodId = env.findMethod(tagTech.objectClass(), writeMethod, "(Landroid/nfc/NdefMessage;)V");
-    if (methodId)
-        env->CallVoidMethod(tagTech.object(), methodId, jmessage.object<jobject>());
-    if (!methodId || env.checkAndClearExceptions()) {
-        reportError(QNearFieldTarget::NdefWriteError, requestId);
-        return requestId;
+        // Writing
+        auto methodId = env.findMethod(tech.objectClass(), writeMethod, "(Landroid/nfc/NdefMessage;)V");
+        if (methodId)
+            env->CallVoidMethod(tech.object(), methodId, jmessage.object<jobject>());
+        if (!methodId || env.checkAndClearExceptions()) {
+            postError(QNearFieldTarget::NdefWriteError, requestId);
+            return;
+        }
+
+        QMetaObject::invokeMethod(this, [this, requestId]() {
+            postponeTargetCheck();
+            Q_EMIT this->requestCompleted(requestId);
+        }, Qt::QueuedConnection);
+    });
+
+    return requestId;
+}
+
+/*
+    Queues work that talks to the tag on the I/O thread of the target, so
+    that the RF exchange does not block the calling thread. The work runs
+    in the order it was queued. It must only use the tag technology that it
+    captured and report back through postError(), postTargetLost() or
+    queued calls on this object.
+*/
+void QNearFieldTargetPrivateImpl::queueIoRequest(std::function<void()> work)
+{
+    if (!ioThread) {
+        ioThread = new QThread(this);
+        ioThread->setObjectName(QStringLiteral("QtNfcTargetThread"));
+        ioContext = new QObject;
+        ioContext->moveToThread(ioThread);
+        ioThread->start();
     }
 
-    QMetaObject::invokeMethod(this, [this, requestId]() {
-        Q_EMIT this->requestCompleted(requestId);
+    QMetaObject::invokeMethod(ioContext, std::move(work), Qt::QueuedConnection);
+}
+
+void QNearFieldTargetPrivateImpl::postError(QNearFieldTarget::Error error,
+                                            const QNearFieldTarget::RequestId &id)
+{
+    QMetaObject::invokeMethod(this, [this, error, id]() {
+        reportError(error, id);
+    }, Qt::QueuedConnection);
+}
+
+void QNearFieldTargetPrivateImpl::postTargetLost(const QNearFieldTarget::RequestId &id)
+{
+    QMetaObject::invokeMethod(this, [this, id]() {
+        // Some devices (Samsung, Huawei) throw an exception when the card is lost:
+        // "android.nfc.TagLostException: Tag was lost". But there seems to be a bug that
+        // isConnected still reports true. So we need to invalidate the target as soon as
+        // possible and treat the card as lost.
+        handleTargetLost();
+        reportError(QNearFieldTarget::CommandError, id);
     }, Qt::QueuedConnection);
-    return requestId;
 }
 
 void QNearFieldTargetPrivateImpl::setIntent(QJniObject intent)
@@ -276,7 +453,8 @@ void QNearFieldTargetPrivateImpl::setIntent(QJniObject intent)
         // Updating tech list and type in case of there is another tag with same UID as one before.
         updateTechList();
         updateType();
-        targetCheckTimer->start();
+        if (targetCheckInterval > 0)
+            targetCheckTimer->start();
     }
 }
 
@@ -287,31 +465,43 @@ void QNearFieldTargetPrivateImpl::checkIsTargetLost()
         return;
     }
 
-    QJniEnvironment env;
-    bool connected = false;
-    auto methodId = env.findMethod(tagTech.objectClass(), "isConnected", "()Z");
-    if (methodId)
-        connected = env->CallBooleanMethod(tagTech.object(), methodId);
-    if (!methodId || env.checkAndClearExceptions()) {
-        handleTargetLost();
-        return;
-    }
-
-    if (connected)
+    // The check talks to the tag, it runs after the pending requests
+    if (targetCheckPending)
         return;
+    targetCheckPending = true;
+
+    queueIoRequest([this, tech = tagTech, intent = targetIntent]() {
+        const auto isPresent = [&tech]() {
+            QJniEnvironment env;
+            bool connected = false;
+            auto methodId = env.findMethod(tech.objectClass(), "isConnected", "()Z");
+            if (methodId)
+                connected = env->CallBooleanMethod(tech.object(), methodId);
+            if (!methodId || env.checkAndClearExceptions())
+                return false;
+
+            if (connected)
+                return true;
 
-    methodId = env.findMethod(tagTech.objectClass(), "connect", "()V");
-    if (methodId)
-        env->CallVoidMethod(tagTech.object(), methodId);
-    if (!methodId || env.checkAndClearExceptions()) {
-        handleTargetLost();
-        return;
-    }
-    methodId = env.findMethod(tagTech.objectClass(), "close", "()V");
-    if (methodId)
-        env->CallVoidMethod(tagTech.object(), methodId);
-    if (!methodId || env.checkAndClearExceptions())
-        handleTargetLost();
+            methodId = env.findMethod(tech.objectClass(), "connect", "()V");
+            if (methodId)
+                env->CallVoidMethod(tech.object(), methodId);
+            if (!methodId || env.checkAndClearExceptions())
+                return false;
+            methodId = env.findMethod(tech.objectClass(), "close", "()V");
+            if (methodId)
+                env->CallVoidMethod(tech.object(), methodId);
+            return methodId && !env.checkAndClearExceptions();
+        };
+
+        const bool present = isPresent();
+        QMetaObject::invokeMethod(this, [this, present, intent]() {
+            targetCheckPending = false;
+            // Ignore the result if the tag was presented again meanwhile
+            if (!present && targetIntent == intent)
+                handleTargetLost();
+        }, Qt::QueuedConnection);
+    });
 }
 
 void QNearFieldTargetPrivateImpl::releaseIntent()
@@ -403,11 +593,39 @@ QNearFieldTarget::Type QNearFieldTargetPrivateImpl::getTagType() const
 void QNearFieldTargetPrivateImpl::setupTargetCheckTimer()
 {
     targetCheckTimer = new QTimer(this);
-    targetCheckTimer->setInterval(1000);
+    targetCheckTimer->setInterval(targetCheckInterval);
     QObject::connect(targetCheckTimer, &QTimer::timeout, this, &QNearFieldTargetPrivateImpl::checkIsTargetLost);
     targetCheckTimer->start();
 }
 
+/*
+    Sets the interval in which the presence of the tag is checked while it is
+    idle. With an interval of 0, the loss of the tag is only noticed when an
+    exchange with it fails.
+*/
+void QNearFieldTargetPrivateImpl::setTargetCheckInterval(int msecs)
+{
+    targetCheckInterval = qMax(msecs, 0);
+    if (targetCheckInterval == 0) {
+        targetCheckTimer->stop();
+        return;
+    }
+
+    targetCheckTimer->setInterval(targetCheckInterval);
+    if (targetIntent.isValid())
+        targetCheckTimer->start();
+}
+
+/*
+    The tag just answered, so the next presence check is only needed one
+    interval later. Busy tags are therefore not polled at all.
+*/
+void QNearFieldTargetPrivateImpl::postponeTargetCheck()
+{
+    if (targetCheckTimer->isActive())
+        targetCheckTimer->start();
+}
+
 void QNearFieldTargetPrivateImpl::handleTargetLost()
 {
     releaseIntent();
@@ -445,49 +663,3 @@ bool QNearFieldTargetPrivateImpl::setTagTechnology(const QStringList &technologi
 
     return false;
 }
-
-bool QNearFieldTargetPrivateImpl::connect()
-{
-    if (!tagTech.isValid())
-        return false;
-
-    QJniEnvironment env;
-    auto methodId = env.findMethod(tagTech.objectClass(), "isConnected", "()Z");
-    bool connected = false;
-    if (methodId)
-        connected = env->CallBooleanMethod(tagTech.object(), methodId);
-    if (!methodId || env.checkAndClearExceptions())
-        return false;
-
-    if (connected)
-        return true;
-
-    setCommandTimeout(2000);
-    methodId = env.findMethod(tagTech.objectClass(), "connect", "()V");
-    if (!methodId)
-        return false;
-    env->CallVoidMethod(tagTech.object(), methodId);
-    return !env.checkAndClearExceptions();
-}
-
-bool QNearFieldTargetPrivateImpl::setCommandTimeout(int timeout)
-{
-    if (!tagTech.isValid())
-        return false;
-
-    QJniEnvironment env;
-    auto methodId = env.findMethod(tagTech.objectClass(), "setTimeout", "(I)V");
-    if (methodId)
-        env->CallVoidMethod(tagTech.object(), methodId, timeout);
-    return methodId && !env.checkAndClearExceptions();
-}
-
-QByteArray QNearFieldTargetPrivateImpl::jbyteArrayToQByteArray(const jbyteArray &byteArray) const
-{
-    QJniEnvironment env;
-    QByteArray resultArray;
-    jsize len = env->GetArrayLength(byteArray);
-    resultArray.resize(len);
-    env->GetByteArrayRegion(byteArray, 0, len, reinterpret_cast<jbyte*>(resultArray.data()));
-    return resultArray;
-}
@@ -25,8 +25,12 @@
 #include <QtCore/QJniObject>
 #include <QtCore/QJniEnvironment>
 
+#include <functional>
+
 QT_BEGIN_NAMESPACE
 
+class QThread;
+
 class QNearFieldTargetPrivateImpl : public QNearFieldTargetPrivate
 {
     Q_OBJECT
@@ -48,8 +52,11 @@ public:
 
     int maxCommandLength() const override;
     QNearFieldTarget::RequestId sendCommand(const QByteArray &command) override;
+    QNearFieldTarget::RequestId sendCommands(const QList<QByteArray> &commands,
+                                             const QList<quint16> &expectedStatusWords) override;
 
     void setIntent(QJniObject intent);
+    void setTargetCheckInterval(int msecs);
 
 signals:
     void targetDestroyed(const QByteArray &tagId);
@@ -65,22 +72,29 @@ protected:
     void updateType();
     QNearFieldTarget::Type getTagType() const;
     void setupTargetCheckTimer();
+    void postponeTargetCheck();
     void handleTargetLost();
     QJniObject getTagTechnology(const QString &tech) const;
     bool setTagTechnology(const QStringList &technologies);
-    bool connect();
-    bool setCommandTimeout(int timeout);
-    QByteArray jbyteArrayToQByteArray(const jbyteArray &byteArray) const;
+    void queueIoRequest(std::function<void()> work);
+    void postError(QNearFieldTarget::Error error, const QNearFieldTarget::RequestId &id);
+    void postTargetLost(const QNearFieldTarget::RequestId &id);
 
 protected:
     QJniObject targetIntent;
     QByteArray targetUid;
     QTimer *targetCheckTimer;
+    int targetCheckInterval = 1000;
 
     QString selectedTech;
     QStringList techList;
     QNearFieldTarget::Type tagType;
     QJniObject tagTech;
+
+    // Talks to the tag, created with the first request
+    QThread *ioThread = nullptr;
+    QObject *ioContext = nullptr;
+    bool targetCheckPending = false;
 };
 
 QT_END_NAMESPACE
@@ -8,7 +8,10 @@
 #import <CoreNFC/NFCISO7816Tag.h>
 #import <CoreNFC/NFCTag.h>
 
+#include "qnfctimings_p.h"
+
 #include <QtCore/qapplicationstatic.h>
+#include <QtCore/qelapsedtimer.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -18,6 +21,10 @@ void ResponseProvider::provideResponse(QNearFieldTarget::RequestId requestId, bo
     Q_EMIT responseReceived(requestId, success, recvBuffer);
 }
 
+void ResponseProvider::provideResponses(QNearFieldTarget::RequestId requestId, bool success, QList<QByteArray> recvBuffers) {
+    Q_EMIT responsesReceived(requestId, success, recvBuffers);
+}
+
 void NfcTagDeleter::operator()(void *tag)
 {
     [static_cast<id<NFCTag>>(tag) release];
@@ -31,6 +38,7 @@ QNearFieldTargetPrivateImpl:: QNearFieldTargetPrivateImpl(void *tag, QObject *pa
 
     QObject::connect(this, &QNearFieldTargetPrivate::error, this, &QNearFieldTargetPrivateImpl::onTargetError);
     QObject::connect(responseProvider, &ResponseProvider::responseReceived, this, &QNearFieldTargetPrivateImpl::onResponseReceived);
+    QObject::connect(responseProvider, &ResponseProvider::responsesReceived, this, &QNearFieldTargetPrivateImpl::onResponsesReceived);
     QObject::connect(&targetCheckTimer, &QTimer::timeout, this, &QNearFieldTargetPrivateImpl::onTargetCheck);
     targetCheckTimer.start(500);
 }
@@ -105,6 +113,18 @@ int QNearFieldTargetPrivateImpl::maxCommandLength() const
 }
 
 QNearFieldTarget::RequestId QNearFieldTargetPrivateImpl::sendCommand(const QByteArray &command)
+{
+    return enqueue({ QNearFieldTarget::RequestId(), { command }, {}, false });
+}
+
+QNearFieldTarget::RequestId
+QNearFieldTargetPrivateImpl::sendCommands(const QList<QByteArray> &commands,
+                                          const QList<quint16> &expectedStatusWords)
+{
+    return enqueue({ QNearFieldTarget::RequestId(), commands, expectedStatusWords, true });
+}
+
+QNearFieldTarget::RequestId QNearFieldTargetPrivateImpl::enqueue(Request request)
 {
     QNearFieldTarget::RequestId requestId = QNearFieldTarget::RequestId(new QNearFieldTarget::RequestIdPrivate());
 
@@ -113,7 +133,9 @@ QNearFieldTarget::RequestId QNearFieldTargetPrivateImpl::sendCommand(const QByte
         return requestId;
     }
 
-    queue.enqueue(std::pair(requestId, command));
+    request.id = requestId;
+    request.timings = timings();
+    queue.enqueue(std::move(request));
 
     if (!connect()) {
         reportError(QNearFieldTarget::TargetOutOfRangeError, requestId);
@@ -146,7 +168,7 @@ bool QNearFieldTargetPrivateImpl::connect()
         return false;
 
     if (@available(iOS 13, *)) {
-        requestInProgress = queue.head().first;
+        requestInProgress = queue.head().id;
         id<NFCTag> tag = static_cast<id<NFCTag>>(nfcTag.get());
         NFCTagReaderSession* session = tag.session;
         [session connectToTag: tag completionHandler: ^(NSError* error){
@@ -157,7 +179,7 @@ bool QNearFieldTargetPrivateImpl::connect()
                     connected = true;
                     onExecuteRequest();
                 } else {
-                    const auto requestId = queue.dequeue().first;
+                    const auto requestId = queue.dequeue().id;
                     invalidate();
                     Q_EMIT targetLost(this);
                     reportError(QNearFieldTarget::ConnectionError, requestId);
@@ -192,16 +214,62 @@ void QNearFieldTargetPrivateImpl::onExecuteRequest()
         return;
 
     if (@available(iOS 13, *)) {
-        const auto request = queue.dequeue();
-        requestInProgress = request.first;
+        auto request = std::make_shared<Request>(queue.dequeue());
+        requestInProgress = request->id;
         const auto tag = static_cast<id<NFCISO7816Tag>>(nfcTag.get());
-        auto *apdu = [[[NFCISO7816APDU alloc] initWithData: request.second.toNSData()] autorelease];
+        if (!request->isBatch) {
+            auto *apdu = [[[NFCISO7816APDU alloc] initWithData: request->commands.first().toNSData()] autorelease];
+            QElapsedTimer timer;
+            timer.start();
+            [tag sendCommandAPDU: apdu completionHandler: ^(NSData* responseData, uint8_t sw1, uint8_t sw2, NSError* error){
+                request->timings->record(QNearFieldTarget::Timing::CommandRoundTrip,
+                                         timer.nsecsElapsed());
+                QByteArray recvBuffer = QByteArray::fromNSData(responseData);
+                recvBuffer += static_cast<char>(sw1);
+                recvBuffer += static_cast<char>(sw2);
+                const bool success = error == nil;
+                responseProvider->provideResponse(request->id, success, recvBuffer);
+            }];
+            return;
+        }
+
+        sendBatchCommand(nfcTag.get(), request, std::make_shared<QList<QByteArray>>());
+    }
+}
+
+/*
+    Sends the next command of a batch from the completion handler of the
+    previous one, without waiting for the thread of the target in between.
+*/
+void QNearFieldTargetPrivateImpl::sendBatchCommand(void *nfcTag, std::shared_ptr<Request> request,
+                                                   std::shared_ptr<QList<QByteArray>> responses)
+{
+    if (@available(iOS 13, *)) {
+        const auto tag = static_cast<id<NFCISO7816Tag>>(nfcTag);
+        const QByteArray &command = request->commands.at(responses->size());
+        auto *apdu = [[[NFCISO7816APDU alloc] initWithData: command.toNSData()] autorelease];
+        QElapsedTimer timer;
+        timer.start();
         [tag sendCommandAPDU: apdu completionHandler: ^(NSData* responseData, uint8_t sw1, uint8_t sw2, NSError* error){
+            request->timings->record(QNearFieldTarget::Timing::CommandRoundTrip,
+                                     timer.nsecsElapsed());
+            if (error != nil) {
+                responseProvider->provideResponses(request->id, false, {});
+                return;
+            }
+
             QByteArray recvBuffer = QByteArray::fromNSData(responseData);
             recvBuffer += static_cast<char>(sw1);
             recvBuffer += static_cast<char>(sw2);
-            const bool success = error == nil;
-            responseProvider->provideResponse(request.first, success, recvBuffer);
+            responses->append(recvBuffer);
+
+            const qsizetype index = responses->size() - 1;
+            if (responses->size() < request->commands.size()
+                && hasExpectedStatusWord(recvBuffer, request->expectedStatusWords, index)) {
+                sendBatchCommand(tag, request, responses);
+            } else {
+                responseProvider->provideResponses(request->id, true, *responses);
+            }
         }];
     }
 }
@@ -222,4 +290,20 @@ void  QNearFieldTargetPrivateImpl::onResponseReceived(QNearFieldTarget::RequestI
     }
 }
 
+void QNearFieldTargetPrivateImpl::onResponsesReceived(QNearFieldTarget::RequestId requestId, bool success, QList<QByteArray> recvBuffers)
+{
+    if (requestInProgress != requestId)
+        return;
+
+    requestInProgress = QNearFieldTarget::RequestId();
+    if (success) {
+        setResponseForRequest(requestId, QVariant::fromValue(recvBuffers), true);
+        onExecuteRequest();
+    } else {
+        invalidate();
+        Q_EMIT targetLost(this);
+        reportError(QNearFieldTarget::CommandError, requestId);
+    }
+}
+
 QT_END_NAMESPACE
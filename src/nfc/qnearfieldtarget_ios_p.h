@@ -29,9 +29,11 @@ class ResponseProvider : public QObject
 
     public:
         void provideResponse(QNearFieldTarget::RequestId requestId, bool success, QByteArray recvBuffer);
+        void provideResponses(QNearFieldTarget::RequestId requestId, bool success, QList<QByteArray> recvBuffers);
 
     Q_SIGNALS:
         void responseReceived(QNearFieldTarget::RequestId requestId, bool success, QByteArray recvBuffer);
+        void responsesReceived(QNearFieldTarget::RequestId requestId, bool success, QList<QByteArray> recvBuffers);
 };
 
 struct NfcTagDeleter
@@ -54,6 +56,8 @@ public:
 
     int maxCommandLength() const override;
     QNearFieldTarget::RequestId sendCommand(const QByteArray &command) override;
+    QNearFieldTarget::RequestId sendCommands(const QList<QByteArray> &commands,
+                                             const QList<quint16> &expectedStatusWords) override;
 
     bool isAvailable() const;
 
@@ -65,15 +69,29 @@ private:
     bool connected = false;
     QTimer targetCheckTimer;
     QNearFieldTarget::RequestId requestInProgress;
-    QQueue<std::pair<QNearFieldTarget::RequestId, QByteArray>> queue;
+    struct Request
+    {
+        QNearFieldTarget::RequestId id;
+        QList<QByteArray> commands;
+        QList<quint16> expectedStatusWords;
+        // A batch reports all responses at once
+        bool isBatch = false;
+        // The completion handlers run outside of the thread of the target
+        std::shared_ptr<QNfcTimings> timings;
+    };
+    QQueue<Request> queue;
 
     bool connect();
+    QNearFieldTarget::RequestId enqueue(Request request);
+    static void sendBatchCommand(void *tag, std::shared_ptr<Request> request,
+                                 std::shared_ptr<QList<QByteArray>> responses);
 
 private Q_SLOTS:
     void onTargetCheck();
     void onTargetError(QNearFieldTarget::Error error, const QNearFieldTarget::RequestId &id);
     void onExecuteRequest();
     void onResponseReceived(QNearFieldTarget::RequestId requestId, bool success, QByteArray recvBuffer);
+    void onResponsesReceived(QNearFieldTarget::RequestId requestId, bool success, QList<QByteArray> recvBuffers);
 };
 
 QT_END_NAMESPACE
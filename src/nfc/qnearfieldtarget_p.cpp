@@ -2,10 +2,12 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include "qnearfieldtarget_p.h"
+#include "qnfctimings_p.h"
 
-#include <QtCore/QCoreApplication>
-#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
 #include <QtCore/QPointer>
+#include <QtCore/QTimer>
+#include <QtCore/QtEndian>
 
 QT_BEGIN_NAMESPACE
 
@@ -13,9 +15,17 @@ QT_BEGIN_NAMESPACE
 QNearFieldTargetPrivate::QNearFieldTargetPrivate(QObject *parent)
 :   QObject(parent)
 ,   q_ptr(nullptr)
+,   m_timings(std::make_shared<QNfcTimings>())
 {
 }
 
+QNearFieldTargetPrivate::~QNearFieldTargetPrivate()
+{
+    // Let pending waits return, they notice that the target is gone
+    for (QEventLoop *loop : std::as_const(m_waitingLoops))
+        loop->quit();
+}
+
 QByteArray QNearFieldTargetPrivate::uid() const
 {
     return QByteArray();
@@ -74,23 +84,61 @@ QNearFieldTarget::RequestId QNearFieldTargetPrivate::sendCommand(const QByteArra
     return id;
 }
 
+QNearFieldTarget::RequestId
+QNearFieldTargetPrivate::sendCommands(const QList<QByteArray> &commands,
+                                      const QList<quint16> &expectedStatusWords)
+{
+    Q_UNUSED(commands);
+    Q_UNUSED(expectedStatusWords);
+
+    const QNearFieldTarget::RequestId id;
+    Q_EMIT error(QNearFieldTarget::UnsupportedError, id);
+    return id;
+}
+
+/*
+    Returns true if a batch of commands may continue after the command at
+    index, that is if no status words are expected or if the response ends
+    with the expected one.
+*/
+bool QNearFieldTargetPrivate::hasExpectedStatusWord(QByteArrayView response,
+                                                    const QList<quint16> &expectedStatusWords,
+                                                    qsizetype index)
+{
+    if (expectedStatusWords.isEmpty())
+        return true;
+    if (response.size() < 2)
+        return false;
+
+    const auto statusWord = qFromBigEndian<quint16>(response.constData() + response.size() - 2);
+    return statusWord == expectedStatusWords.at(index);
+}
+
 bool QNearFieldTargetPrivate::waitForRequestCompleted(const QNearFieldTarget::RequestId &id,
                                                       int msecs)
 {
-    QElapsedTimer timer;
-    timer.start();
+    if (m_decodedResponses.contains(id))
+        return true;
+
+    // Wait in a local event loop that setResponseForRequest() quits, rather
+    // than polling for the response
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
+    timer.start(qMax(msecs, 0));
 
     const QPointer<QNearFieldTargetPrivate> weakThis = this;
+    m_waitingLoops.insert(id, &loop);
+    loop.exec();
 
-    do {
-        if (!weakThis)
-            return false;
+    if (!weakThis)
+        return false;
 
-        if (m_decodedResponses.contains(id))
-            return true;
-        else
-            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 1);
-    } while (timer.elapsed() <= msecs);
+    m_waitingLoops.remove(id, &loop);
+
+    if (m_decodedResponses.contains(id))
+        return true;
 
     reportError(QNearFieldTarget::TimeoutError, id);
 
@@ -116,6 +164,9 @@ void QNearFieldTargetPrivate::setResponseForRequest(const QNearFieldTarget::Requ
 
     m_decodedResponses.insert(id, response);
 
+    for (auto i = m_waitingLoops.constFind(id); i != m_waitingLoops.cend() && i.key() == id; ++i)
+        i.value()->quit();
+
     if (emitRequestCompleted)
         Q_EMIT requestCompleted(id);
 }
@@ -23,9 +23,15 @@
 #include <QtCore/QSharedData>
 #include <QtCore/QVariant>
 #include <QtCore/QMap>
+#include <QtCore/QMultiMap>
+
+#include <memory>
 
 QT_BEGIN_NAMESPACE
 
+class QEventLoop;
+class QNfcTimings;
+
 class QNearFieldTarget::RequestIdPrivate : public QSharedData
 {
 };
@@ -38,7 +44,7 @@ public:
     QNearFieldTarget *q_ptr;
 
     explicit QNearFieldTargetPrivate(QObject *parent = nullptr);
-    virtual ~QNearFieldTargetPrivate() = default;
+    virtual ~QNearFieldTargetPrivate();
 
     virtual QByteArray uid() const;
     virtual QNearFieldTarget::Type type() const;
@@ -54,14 +60,23 @@ public:
     // TagTypeSpecificAccess
     virtual int maxCommandLength() const;
     virtual QNearFieldTarget::RequestId sendCommand(const QByteArray &command);
+    virtual QNearFieldTarget::RequestId sendCommands(const QList<QByteArray> &commands,
+                                                     const QList<quint16> &expectedStatusWords);
+    static bool hasExpectedStatusWord(QByteArrayView response,
+                                      const QList<quint16> &expectedStatusWords, qsizetype index);
 
     bool waitForRequestCompleted(const QNearFieldTarget::RequestId &id, int msecs = 5000);
     QVariant requestResponse(const QNearFieldTarget::RequestId &id) const;
 
+    // Shared with the code that talks to the tag, which may run in another thread
+    std::shared_ptr<QNfcTimings> timings() const { return m_timings; }
+    void setTimings(std::shared_ptr<QNfcTimings> timings) { m_timings = std::move(timings); }
+
 Q_SIGNALS:
     void disconnected();
 
     void ndefMessageRead(const QNdefMessage &message);
+    void ndefRecordRead(const QNdefRecord &record);
 
     void requestCompleted(const QNearFieldTarget::RequestId &id);
 
@@ -75,6 +90,11 @@ protected:
                                        bool emitRequestCompleted = true);
 
     void reportError(QNearFieldTarget::Error error, const QNearFieldTarget::RequestId &id);
+
+private:
+    // Event loops of waitForRequestCompleted(), quit once their request has a response
+    QMultiMap<QNearFieldTarget::RequestId, QEventLoop *> m_waitingLoops;
+    std::shared_ptr<QNfcTimings> m_timings;
 };
 
 QT_END_NAMESPACE
@@ -13,13 +13,14 @@ Q_DECLARE_LOGGING_CATEGORY(QT_NFC_PCSC)
     Construct QNearFieldTargetPrivateImpl instance.
 
     This object communicates with a QPcscCard object that lives inside the
-    worker thread via signal-slot mechanism.
+    thread of its reader via signal-slot mechanism.
 */
 QNearFieldTargetPrivateImpl::QNearFieldTargetPrivateImpl(
-        const QByteArray &uid, QNearFieldTarget::AccessMethods accessMethods, int maxInputLength,
-        QObject *parent)
+        const QByteArray &uid, QNearFieldTarget::Type type,
+        QNearFieldTarget::AccessMethods accessMethods, int maxInputLength, QObject *parent)
     : QNearFieldTargetPrivate(parent),
       m_uid(uid),
+      m_type(type),
       m_accessMethods(accessMethods),
       m_maxInputLength(maxInputLength)
 {
@@ -41,11 +42,8 @@ QNearFieldTarget::Type QNearFieldTargetPrivateImpl::type() const
 {
     qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
 
-    // Currently NDEF access is only supported for Type 4 tags
-    if (m_accessMethods & QNearFieldTarget::NdefAccess)
-        return QNearFieldTarget::NfcTagType4;
-
-    return QNearFieldTarget::ProprietaryTag;
+    // The type is only known for the tags with NDEF access
+    return m_type;
 }
 
 QNearFieldTarget::AccessMethods QNearFieldTargetPrivateImpl::accessMethods() const
@@ -88,6 +86,11 @@ void QNearFieldTargetPrivateImpl::onNdefMessageRead(const QNdefMessage &message)
     Q_EMIT ndefMessageRead(message);
 }
 
+void QNearFieldTargetPrivateImpl::onNdefRecordRead(const QNdefRecord &record)
+{
+    Q_EMIT ndefRecordRead(record);
+}
+
 QNearFieldTarget::RequestId QNearFieldTargetPrivateImpl::sendCommand(const QByteArray &command)
 {
     qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
@@ -103,6 +106,23 @@ QNearFieldTarget::RequestId QNearFieldTargetPrivateImpl::sendCommand(const QByte
     return reqId;
 }
 
+QNearFieldTarget::RequestId
+QNearFieldTargetPrivateImpl::sendCommands(const QList<QByteArray> &commands,
+                                          const QList<quint16> &expectedStatusWords)
+{
+    qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
+
+    if (!m_isValid)
+        return QNearFieldTarget::RequestId(nullptr);
+
+    m_connected = true;
+
+    QNearFieldTarget::RequestId reqId(new QNearFieldTarget::RequestIdPrivate);
+    Q_EMIT sendCommandsRequest(reqId, commands, expectedStatusWords);
+
+    return reqId;
+}
+
 QNearFieldTarget::RequestId QNearFieldTargetPrivateImpl::readNdefMessages()
 {
     qCDebug(QT_NFC_PCSC) << Q_FUNC_INFO;
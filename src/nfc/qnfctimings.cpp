@@ -0,0 +1,69 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qnfctimings_p.h"
+
+#include <qtnfc_tracepoints_p.h>
+
+QT_BEGIN_NAMESPACE
+
+QNfcTimings::QNfcTimings()
+{
+    m_detectionTimer.start();
+}
+
+void QNfcTimings::record(QNearFieldTarget::Timing timing, qint64 nsecs)
+{
+    Q_TRACE(QNfcTimings_record, int(timing), nsecs);
+
+    const qint64 usecs = nsecs / 1000;
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && usecs >= (qint64(1) << bucket))
+        ++bucket;
+
+    QMutexLocker locker(&m_mutex);
+
+    Entry &entry = m_entries[size_t(timing)];
+    if (entry.count == 0 || nsecs < entry.minimum)
+        entry.minimum = nsecs;
+    if (nsecs > entry.maximum)
+        entry.maximum = nsecs;
+    entry.total += nsecs;
+    ++entry.count;
+    ++entry.histogram[bucket];
+}
+
+void QNfcTimings::recordNdefMessage()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_ndefMessageRecorded)
+            return;
+        m_ndefMessageRecorded = true;
+    }
+
+    record(QNearFieldTarget::Timing::DetectionToNdefMessage, m_detectionTimer.nsecsElapsed());
+}
+
+QNearFieldTarget::TimingStatistics QNfcTimings::statistics(QNearFieldTarget::Timing timing) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    const Entry &entry = m_entries[size_t(timing)];
+
+    QNearFieldTarget::TimingStatistics result;
+    result.count = entry.count;
+    result.total = std::chrono::nanoseconds(entry.total);
+    result.minimum = std::chrono::nanoseconds(entry.minimum);
+    result.maximum = std::chrono::nanoseconds(entry.maximum);
+    result.histogram = QList<quint64>(entry.histogram.begin(), entry.histogram.end());
+    return result;
+}
+
+void QNfcTimings::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries = {};
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,65 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QNFCTIMINGS_P_H
+#define QNFCTIMINGS_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qnearfieldtarget.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+
+#include <array>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Collects the timing statistics of one target. The backends record from
+    whatever thread talks to the tag, so all functions are thread-safe.
+*/
+class Q_AUTOTEST_EXPORT QNfcTimings
+{
+public:
+    // Number of histogram buckets, the last one takes everything above 2^22 us
+    static constexpr int BucketCount = 24;
+
+    QNfcTimings();
+
+    void record(QNearFieldTarget::Timing timing, qint64 nsecs);
+    // Records DetectionToNdefMessage, but only for the first message
+    void recordNdefMessage();
+
+    QNearFieldTarget::TimingStatistics statistics(QNearFieldTarget::Timing timing) const;
+    void reset();
+
+private:
+    struct Entry
+    {
+        quint64 count = 0;
+        qint64 total = 0;
+        qint64 minimum = 0;
+        qint64 maximum = 0;
+        std::array<quint64, BucketCount> histogram = {};
+    };
+
+    mutable QMutex m_mutex;
+    std::array<Entry, 3> m_entries;
+    // Started when the target is detected
+    QElapsedTimer m_detectionTimer;
+    bool m_ndefMessageRecorded = false;
+};
+
+QT_END_NAMESPACE
+
+#endif // QNFCTIMINGS_P_H
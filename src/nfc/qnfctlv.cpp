@@ -0,0 +1,78 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qnfctlv_p.h"
+
+#include <QtCore/qendian.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Based on the TLV blocks of the Type 2 Tag Operation Specification,
+    Version 1.2 (T2TOP 1.2), which Type 1 tags share.
+*/
+
+QNfcTlvReader::Status QNfcTlvReader::readNext()
+{
+    m_needed = 0;
+
+    // NULL TLVs have neither a length nor a value
+    qsizetype idx = m_next;
+    while (idx < m_data.size() && quint8(m_data[idx]) == QNfcTlv::NullTlv)
+        ++idx;
+    m_next = idx;
+
+    if (idx >= m_data.size()) {
+        m_needed = 1;
+        return NeedMoreData;
+    }
+
+    const quint8 tag = m_data[idx];
+    if (tag == QNfcTlv::TerminatorTlv) {
+        m_tag = tag;
+        m_offset = idx;
+        m_headerLength = 1;
+        m_length = 0;
+        m_next = idx + 1;
+        return Terminator;
+    }
+
+    if (idx + 2 > m_data.size()) {
+        m_needed = 2 - (m_data.size() - idx);
+        return NeedMoreData;
+    }
+
+    qsizetype headerLength = 2;
+    qsizetype length = quint8(m_data[idx + 1]);
+    if (length == 0xFF) {
+        if (idx + 4 > m_data.size()) {
+            m_needed = 4 - (m_data.size() - idx);
+            return NeedMoreData;
+        }
+        headerLength = 4;
+        length = qFromBigEndian<quint16>(m_data.data() + idx + 2);
+    }
+
+    m_tag = tag;
+    m_offset = idx;
+    m_headerLength = headerLength;
+    m_length = length;
+    m_next = idx + headerLength + length;
+    return Tlv;
+}
+
+void QNfcTlvWriter::writeTlv(quint8 tag, QByteArrayView value)
+{
+    m_buffer->append(char(tag));
+    if (value.size() < 0xFF) {
+        m_buffer->append(char(value.size()));
+    } else {
+        Q_ASSERT(value.size() <= 0xFFFE);
+        m_buffer->append(char(0xFF));
+        m_buffer->append(char(value.size() >> 8));
+        m_buffer->append(char(value.size() & 0xFF));
+    }
+    m_buffer->append(value);
+}
+
+QT_END_NAMESPACE
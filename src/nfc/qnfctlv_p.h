@@ -0,0 +1,122 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QNFCTLV_P_H
+#define QNFCTLV_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qtnfcglobal_p.h"
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qbytearrayview.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace QNfcTlv {
+
+// TLV blocks of the memory-mapped NFC Forum tag types 1 and 2
+enum Tag : quint8 {
+    NullTlv = 0x00,
+    LockControlTlv = 0x01,
+    MemoryControlTlv = 0x02,
+    NdefMessageTlv = 0x03,
+    ProprietaryTlv = 0xFD,
+    TerminatorTlv = 0xFE
+};
+
+// Returns the size of a TLV with a value of valueLength bytes.
+constexpr qsizetype encodedSize(qsizetype valueLength)
+{
+    return (valueLength < 0xFF ? 2 : 4) + valueLength;
+}
+
+} // namespace QNfcTlv
+
+/*
+    Reads TLV blocks from the data area of a tag without copying it.
+
+    The data may be incomplete, for example while it is read from the tag.
+    readNext() then returns NeedMoreData, and position() and bytesNeeded()
+    tell which part of the data area is needed to continue. Values of
+    skipped TLVs are never needed, so the caller does not have to read them
+    from the tag at all.
+*/
+class Q_AUTOTEST_EXPORT QNfcTlvReader
+{
+public:
+    enum Status {
+        // The header of the next TLV is not available yet.
+        NeedMoreData,
+        // The header of a TLV was read. Its value may not be available yet.
+        Tlv,
+        // The terminator TLV was read.
+        Terminator
+    };
+
+    explicit QNfcTlvReader(QByteArrayView data = {}) : m_data(data) { }
+
+    /*
+        Replaces the data. It must start at the same offset of the data
+        area as before, for example after more data was appended.
+    */
+    void setData(QByteArrayView data) { m_data = data; }
+    QByteArrayView data() const { return m_data; }
+
+    // Skips the value of the current TLV and reads the next header.
+    Status readNext();
+
+    quint8 tag() const { return m_tag; }
+    qsizetype offset() const { return m_offset; }
+    qsizetype headerLength() const { return m_headerLength; }
+    qsizetype length() const { return m_length; }
+    qsizetype valueOffset() const { return m_offset + m_headerLength; }
+
+    bool hasValue() const { return valueOffset() + m_length <= m_data.size(); }
+    // Returns the value of the current TLV, it must be available.
+    QByteArrayView value() const { return m_data.sliced(valueOffset(), m_length); }
+
+    // The offset in the data area at which readNext() continues.
+    qsizetype position() const { return m_next; }
+    // The number of bytes from position() that the next readNext() needs at least.
+    qsizetype bytesNeeded() const { return m_needed; }
+
+private:
+    QByteArrayView m_data;
+    qsizetype m_next = 0;
+    qsizetype m_needed = 0;
+
+    quint8 m_tag = QNfcTlv::NullTlv;
+    qsizetype m_offset = 0;
+    qsizetype m_headerLength = 0;
+    qsizetype m_length = 0;
+};
+
+/*
+    Appends TLV blocks to a buffer. The values are copied once, directly
+    into it, so the caller should reserve the encoded size up front.
+*/
+class Q_AUTOTEST_EXPORT QNfcTlvWriter
+{
+public:
+    explicit QNfcTlvWriter(QByteArray *buffer) : m_buffer(buffer) { }
+
+    void writeTlv(quint8 tag, QByteArrayView value);
+    void writeTerminator() { m_buffer->append(char(QNfcTlv::TerminatorTlv)); }
+
+private:
+    QByteArray *m_buffer;
+};
+
+QT_END_NAMESPACE
+
+#endif // QNFCTLV_P_H
@@ -22,6 +22,7 @@ void usage()
                     "represented by the local Bluetooth device.\n\n"
                     "Options:\n"
                     "   -p                  Show scan results in human-readable form\n"
+                    "   -b                  Write scan results in the binary format\n"
                     "   -u [list of uuids]  List of uuids which should be scanned for.\n"
                     "                       Each uuid must be enclosed in {}.\n"
                     "                       If the list is empty PUBLIC_BROWSE_GROUP scan is used.\n");
@@ -29,6 +30,12 @@ void usage()
 
 #define BUFFER_SIZE 1024
 
+// The binary output starts with BINARY_MAGIC and the format version, followed by
+// each record as a sequence of attribute id and value pairs, encoded like in
+// SDP PDUs. Incompatible format changes must increase the version.
+#define BINARY_MAGIC        "QSDP"
+#define BINARY_VERSION      1
+
 static void parseAttributeValues(sdp_data_t *data, int indentation, QByteArray &xmlOutput)
 {
     if (!data)
@@ -218,6 +225,23 @@ QByteArray parseSdpRecord(sdp_record_t *record)
     return xmlOutput;
 }
 
+// appends the record encoded as SDP data element sequence
+static void appendBinarySdpRecord(sdp_record_t *record, QByteArray &output)
+{
+    if (!record || !record->attrlist)
+        return;
+
+    sdp_buf_t buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    if (sdp_gen_record_pdu(record, &buffer) < 0) {
+        fprintf(stderr, "Cannot encode SDP record 0x%08x\n", record->handle);
+        return;
+    }
+
+    output.append(reinterpret_cast<const char *>(buffer.data), buffer.data_size);
+    free(buffer.data);
+}
+
 
 int main(int argc, char **argv)
 {
@@ -243,6 +267,7 @@ int main(int argc, char **argv)
     }
 
     bool showHumanReadable = false;
+    bool writeBinary = false;
     std::vector<std::string> targetServices;
 
     for (int i = 3; i < argc; i++) {
@@ -256,6 +281,9 @@ int main(int argc, char **argv)
         case 'p':
             showHumanReadable = true;
             break;
+        case 'b':
+            writeBinary = true;
+            break;
         case 'u':
             i++;
 
@@ -364,15 +392,27 @@ int main(int argc, char **argv)
     }
     sdp_list_free(attributes, nullptr);
 
-    // start XML generation from the front
+    // start output generation from the front
     sdpResults = totalResults;
 
+    // human-readable output is XML in any case
+    writeBinary = writeBinary && !showHumanReadable;
+
     QByteArray total;
+    if (writeBinary) {
+        total.append(BINARY_MAGIC);
+        total.append(char(BINARY_VERSION));
+    }
+
     while (sdpResults) {
         sdp_record_t *record = (sdp_record_t *) sdpResults->data;
 
-        const QByteArray xml = parseSdpRecord(record);
-        total += xml;
+        if (writeBinary) {
+            appendBinarySdpRecord(record, total);
+        } else {
+            const QByteArray xml = parseSdpRecord(record);
+            total += xml;
+        }
 
         sdpIter = sdpResults;
         sdpResults = sdpResults->next;
@@ -380,7 +420,9 @@ int main(int argc, char **argv)
         sdp_record_free(record);
     }
 
-    if (!total.isEmpty()) {
+    if (writeBinary) {
+        fwrite(total.constData(), 1, total.size(), stdout);
+    } else if (!total.isEmpty()) {
         if (showHumanReadable)
             printf("%s", total.constData());
         else
@@ -20,6 +20,8 @@ public:
 private slots:
     void tst_construction_data();
     void tst_construction();
+    void tst_invalidConstruction_data();
+    void tst_invalidConstruction();
 
     void tst_assignment();
 
@@ -114,6 +116,26 @@ void tst_QBluetoothAddress::tst_construction()
     }
 }
 
+void tst_QBluetoothAddress::tst_invalidConstruction_data()
+{
+    QTest::addColumn<QString>("address");
+
+    QTest::newRow("too short") << QString("11:22:33:44:55");
+    QTest::newRow("too long") << QString("11:22:33:44:55:66:77");
+    QTest::newRow("no hex digit") << QString("11:22:33:44:55:6G");
+    QTest::newRow("other separator") << QString("11-22-33-44-55-66");
+    QTest::newRow("misplaced separator") << QString("112:2:33:44:55:66");
+    QTest::newRow("no hex digits") << QString("11223344556G");
+    QTest::newRow("whitespace") << QString(" 1223344556");
+}
+
+void tst_QBluetoothAddress::tst_invalidConstruction()
+{
+    QFETCH(QString, address);
+
+    QVERIFY(QBluetoothAddress(address).isNull());
+}
+
 void tst_QBluetoothAddress::tst_assignment()
 {
     QBluetoothAddress address(Q_UINT64_C(0x112233445566));
@@ -166,6 +188,8 @@ void tst_QBluetoothAddress::tst_comparison()
     QCOMPARE(address2 == address1, result);
     QCOMPARE(address1 != address2, !result);
     QCOMPARE(address2 != address1, !result);
+    if (result)
+        QCOMPARE(qHash(address1), qHash(address2));
 }
 
 void tst_QBluetoothAddress::tst_lessThan_data()
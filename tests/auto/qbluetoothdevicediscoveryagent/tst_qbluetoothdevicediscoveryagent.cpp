@@ -11,6 +11,7 @@
 #include <private/qtbluetoothglobal_p.h>
 #include <qbluetoothaddress.h>
 #include <qbluetoothdevicediscoveryagent.h>
+#include <qbluetoothdevicediscoverymodel.h>
 #include <qbluetoothlocaldevice.h>
 
 QT_USE_NAMESPACE
@@ -58,6 +59,18 @@ private slots:
 
     void tst_discoveryTimeout();
 
+    void tst_discoveryFilters();
+
+    void tst_deviceLimits();
+
+    void tst_advertisementReportBuffer();
+
+    void tst_deviceSnapshot();
+
+    void tst_deviceDiscoveryModel();
+
+    void tst_identityResolvingKeys();
+
     void tst_discoveryMethods();
 private:
     qsizetype noOfLocalDevices;
@@ -398,6 +411,203 @@ void tst_QBluetoothDeviceDiscoveryAgent::tst_discoveryTimeout()
 #endif
 }
 
+void tst_QBluetoothDeviceDiscoveryAgent::tst_discoveryFilters()
+{
+    QBluetoothDeviceDiscoveryAgent agent;
+
+    // check default values
+    QVERIFY(agent.serviceUuidFilter().isEmpty());
+    QCOMPARE(agent.rssiThreshold(), qint16(0));
+    QCOMPARE(agent.pathlossThreshold(), quint16(0));
+    QVERIFY(agent.reportsDuplicateData());
+    QVERIFY(agent.nameFilter().isEmpty());
+    QVERIFY(agent.manufacturerIdFilter().isEmpty());
+    QCOMPARE(agent.lowEnergyScanMode(), QBluetoothDeviceDiscoveryAgent::LowEnergyScanMode::Balanced);
+    QCOMPARE(agent.lowEnergyReportDelay(), 0);
+    QCOMPARE(agent.lowEnergyScanInterval(), 0);
+    QCOMPARE(agent.lowEnergyScanWindow(), 0);
+    QVERIFY(!agent.isLowEnergyPassiveScanEnabled());
+
+    const QList<QBluetoothUuid> uuids
+            = { QBluetoothUuid(QBluetoothUuid::ServiceClassUuid::HeartRate) };
+    agent.setServiceUuidFilter(uuids);
+    QCOMPARE(agent.serviceUuidFilter(), uuids);
+    agent.setRssiThreshold(-70);
+    QCOMPARE(agent.rssiThreshold(), qint16(-70));
+    agent.setPathlossThreshold(40);
+    QCOMPARE(agent.pathlossThreshold(), quint16(40));
+    agent.setReportDuplicateData(false);
+    QVERIFY(!agent.reportsDuplicateData());
+    agent.setNameFilter({ QStringLiteral("Scanner") });
+    QCOMPARE(agent.nameFilter(), QStringList(QStringLiteral("Scanner")));
+    agent.setManufacturerIdFilter({ 0x004c, 0x0059 });
+    QCOMPARE(agent.manufacturerIdFilter(), QList<quint16>({ 0x004c, 0x0059 }));
+
+    agent.setLowEnergyScanMode(QBluetoothDeviceDiscoveryAgent::LowEnergyScanMode::LowPower);
+    QCOMPARE(agent.lowEnergyScanMode(), QBluetoothDeviceDiscoveryAgent::LowEnergyScanMode::LowPower);
+    agent.setLowEnergyReportDelay(5000);
+    QCOMPARE(agent.lowEnergyReportDelay(), 5000);
+    agent.setLowEnergyReportDelay(-1); // negative ignored
+    QCOMPARE(agent.lowEnergyReportDelay(), 5000);
+
+    agent.setLowEnergyScanParameters(1000, 100);
+    QCOMPARE(agent.lowEnergyScanInterval(), 1000);
+    QCOMPARE(agent.lowEnergyScanWindow(), 100);
+    agent.setLowEnergyScanParameters(100, 1000); // window beyond interval ignored
+    QCOMPARE(agent.lowEnergyScanInterval(), 1000);
+    QCOMPARE(agent.lowEnergyScanWindow(), 100);
+    agent.setLowEnergyScanParameters(20000, 100); // out of range ignored
+    QCOMPARE(agent.lowEnergyScanInterval(), 1000);
+    agent.setLowEnergyScanParameters(0, 0);
+    QCOMPARE(agent.lowEnergyScanInterval(), 0);
+    QCOMPARE(agent.lowEnergyScanWindow(), 0);
+    agent.setLowEnergyPassiveScanEnabled(true);
+    QVERIFY(agent.isLowEnergyPassiveScanEnabled());
+}
+
+void tst_QBluetoothDeviceDiscoveryAgent::tst_deviceLimits()
+{
+    QBluetoothDeviceDiscoveryAgent agent;
+
+    // check default values
+    QCOMPARE(agent.maximumDiscoveredDevices(), 0);
+    QCOMPARE(agent.deviceLostTimeout(), 0);
+
+    agent.setMaximumDiscoveredDevices(500);
+    QCOMPARE(agent.maximumDiscoveredDevices(), 500);
+    agent.setMaximumDiscoveredDevices(-1); // negative ignored
+    QCOMPARE(agent.maximumDiscoveredDevices(), 500);
+
+    agent.setDeviceLostTimeout(30000);
+    QCOMPARE(agent.deviceLostTimeout(), 30000);
+    agent.setDeviceLostTimeout(-1); // negative ignored
+    QCOMPARE(agent.deviceLostTimeout(), 30000);
+    agent.setDeviceLostTimeout(0);
+    QCOMPARE(agent.deviceLostTimeout(), 0);
+}
+
+void tst_QBluetoothDeviceDiscoveryAgent::tst_advertisementReportBuffer()
+{
+    QBluetoothDeviceDiscoveryAgent agent;
+    QBluetoothAdvertisementReport reports[4];
+
+    QCOMPARE(agent.advertisementReportBufferSize(), 0);
+    QCOMPARE(agent.takeAdvertisementReports(reports, 4), 0);
+
+    agent.setAdvertisementReportBufferSize(128);
+    QCOMPARE(agent.advertisementReportBufferSize(), 128);
+    agent.setAdvertisementReportBufferSize(-1); // negative ignored
+    QCOMPARE(agent.advertisementReportBufferSize(), 128);
+    QCOMPARE(agent.takeAdvertisementReports(reports, 4), 0);
+
+    agent.setAdvertisementReportBufferSize(0);
+    QCOMPARE(agent.advertisementReportBufferSize(), 0);
+}
+
+void tst_QBluetoothDeviceDiscoveryAgent::tst_deviceSnapshot()
+{
+    QBluetoothDeviceDiscoveryAgent agent;
+
+    const QByteArray snapshot = agent.saveDiscoveredDevices();
+    QVERIFY(!snapshot.isEmpty());
+
+    QBluetoothDeviceDiscoveryAgent restoredAgent;
+    QVERIFY(restoredAgent.restoreDiscoveredDevices(snapshot));
+    QVERIFY(restoredAgent.discoveredDevices().isEmpty());
+    QCOMPARE(restoredAgent.saveDiscoveredDevices(), snapshot);
+
+    QTest::ignoreMessage(QtWarningMsg, "Invalid snapshot of discovered devices");
+    QVERIFY(!restoredAgent.restoreDiscoveredDevices(QByteArray("garbage")));
+    QTest::ignoreMessage(QtWarningMsg, "Invalid snapshot of discovered devices");
+    QVERIFY(!restoredAgent.restoreDiscoveredDevices(QByteArray()));
+}
+
+void tst_QBluetoothDeviceDiscoveryAgent::tst_deviceDiscoveryModel()
+{
+    QBluetoothDeviceDiscoveryAgent agent;
+    QBluetoothDeviceDiscoveryModel model(&agent);
+    QCOMPARE(model.agent(), &agent);
+    QCOMPARE(model.rowCount(), 0);
+
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy changedSpy(&model, &QAbstractItemModel::dataChanged);
+    QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+
+    QBluetoothDeviceInfo first(QBluetoothAddress(QStringLiteral("00:11:22:33:44:55")),
+                               QStringLiteral("first"), 0);
+    first.setRssi(-60);
+    const QBluetoothDeviceInfo second(QBluetoothAddress(QStringLiteral("00:11:22:33:44:66")),
+                                      QString(), 0);
+    emit agent.deviceDiscovered(first);
+    emit agent.deviceDiscovered(second);
+    QCOMPARE(insertedSpy.size(), 2);
+    QCOMPARE(model.rowCount(), 2);
+    QCOMPARE(model.indexOfDevice(second), 1);
+    QCOMPARE(model.data(model.index(0)).toString(), QStringLiteral("first"));
+    QCOMPARE(model.data(model.index(1)).toString(), second.address().toString());
+    QCOMPARE(model.data(model.index(0), QBluetoothDeviceDiscoveryModel::RssiRole).toInt(), -60);
+
+    // only the changed roles are reported
+    first.setRssi(-50);
+    emit agent.deviceUpdated(first, QBluetoothDeviceInfo::Field::RSSI);
+    QCOMPARE(changedSpy.size(), 1);
+    QCOMPARE(changedSpy.at(0).at(0).toModelIndex().row(), 0);
+    const auto roles = changedSpy.at(0).at(2).value<QList<int>>();
+    QVERIFY(roles.contains(QBluetoothDeviceDiscoveryModel::RssiRole));
+    QVERIFY(!roles.contains(QBluetoothDeviceDiscoveryModel::NameRole));
+    emit agent.deviceUpdated(first, QBluetoothDeviceInfo::Field::RSSI);
+    QCOMPARE(changedSpy.size(), 1);
+
+    emit agent.deviceLost(first);
+    QCOMPARE(removedSpy.size(), 1);
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(model.indexOfDevice(first), -1);
+    QCOMPARE(model.indexOfDevice(second), 0);
+
+    // rate limited updates are passed on together
+    model.setUpdateInterval(50);
+    insertedSpy.clear();
+    changedSpy.clear();
+    emit agent.deviceDiscovered(first);
+    first.setRssi(-40);
+    emit agent.deviceUpdated(first, QBluetoothDeviceInfo::Field::RSSI);
+    QCOMPARE(model.rowCount(), 1);
+    QTRY_COMPARE(model.rowCount(), 2);
+    QCOMPARE(insertedSpy.size(), 1);
+    QCOMPARE(changedSpy.size(), 0);
+    QCOMPARE(model.device(1).rssi(), qint16(-40));
+
+    model.setAgent(nullptr);
+    QCOMPARE(model.rowCount(), 0);
+}
+
+void tst_QBluetoothDeviceDiscoveryAgent::tst_identityResolvingKeys()
+{
+    QBluetoothDeviceDiscoveryAgent agent;
+
+    // sample data of the Core Specification, Vol 3, Part H, D.7
+    const QByteArray irk = QByteArray::fromHex("ec0234a357c8ad05341010a60a397d9b");
+    const QBluetoothAddress identity(QStringLiteral("00:1A:7D:DA:71:13"));
+    const QBluetoothAddress resolvable(QStringLiteral("70:81:94:0D:FB:AA"));
+    const QBluetoothAddress other(QStringLiteral("70:81:94:0D:FB:AB"));
+
+    QVERIFY(agent.identityAddress(resolvable).isNull());
+
+    QVERIFY(!agent.addIdentityResolvingKey(identity, irk.left(8)));
+    QVERIFY(!agent.addIdentityResolvingKey(QBluetoothAddress(), irk));
+    QVERIFY(agent.addIdentityResolvingKey(identity, irk));
+
+    QCOMPARE(agent.identityAddress(resolvable), identity);
+    QCOMPARE(agent.identityAddress(identity), identity);
+    QVERIFY(agent.identityAddress(other).isNull());
+    // cached results
+    QCOMPARE(agent.identityAddress(resolvable), identity);
+    QVERIFY(agent.identityAddress(other).isNull());
+
+    agent.removeIdentityResolvingKey(identity);
+    QVERIFY(agent.identityAddress(resolvable).isNull());
+}
+
 void tst_QBluetoothDeviceDiscoveryAgent::tst_discoveryMethods()
 {
     const QBluetoothLocalDevice localDevice;
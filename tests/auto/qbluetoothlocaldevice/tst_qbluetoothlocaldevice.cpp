@@ -499,6 +499,13 @@ void tst_QBluetoothLocalDevice::tst_pairingStatus()
 
     QBluetoothLocalDevice localDevice;
     QCOMPARE(pairingExpected, localDevice.pairingStatus(deviceAddress));
+
+    QSignalSpy statusSpy(&localDevice, &QBluetoothLocalDevice::pairingStatusReceived);
+    localDevice.requestPairingStatus(deviceAddress);
+    QCOMPARE(statusSpy.count(), 0);
+    QTRY_COMPARE(statusSpy.count(), 1);
+    QCOMPARE(statusSpy.at(0).at(0).value<QBluetoothAddress>(), deviceAddress);
+    QCOMPARE(statusSpy.at(0).at(1).value<QBluetoothLocalDevice::Pairing>(), pairingExpected);
 }
 QTEST_MAIN(tst_QBluetoothLocalDevice)
 
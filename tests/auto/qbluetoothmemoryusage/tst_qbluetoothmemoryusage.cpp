@@ -0,0 +1,145 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/QBluetoothMemoryUsage>
+#ifdef QT_BUILD_INTERNAL
+#include <QtBluetooth/private/qbluetoothmemoryusage_p.h>
+#endif
+
+QT_USE_NAMESPACE
+
+class tst_QBluetoothMemoryUsage : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void tst_construction();
+    void tst_structures();
+    void tst_copy();
+    void tst_swap();
+    void tst_debugStreaming();
+    void tst_variant();
+
+#ifdef QT_BUILD_INTERNAL
+private:
+    static QBluetoothMemoryUsage sampleUsage();
+#endif
+};
+
+#ifdef QT_BUILD_INTERNAL
+QBluetoothMemoryUsage tst_QBluetoothMemoryUsage::sampleUsage()
+{
+    QBluetoothMemoryUsage usage;
+    QBluetoothMemoryUsagePrivate::add(&usage, QStringLiteral("services"), 100);
+    QBluetoothMemoryUsagePrivate::add(&usage, QStringLiteral("buffers"), 20);
+    return usage;
+}
+#endif
+
+void tst_QBluetoothMemoryUsage::tst_construction()
+{
+    const QBluetoothMemoryUsage usage;
+    QVERIFY(usage.isEmpty());
+    QVERIFY(usage.structures().isEmpty());
+    QCOMPARE(usage.bytes(QStringLiteral("services")), qsizetype(0));
+    QCOMPARE(usage.totalBytes(), qsizetype(0));
+}
+
+void tst_QBluetoothMemoryUsage::tst_structures()
+{
+#ifdef QT_BUILD_INTERNAL
+    QBluetoothMemoryUsage usage = sampleUsage();
+    QVERIFY(!usage.isEmpty());
+    QCOMPARE(usage.structures(), QStringList({ "services", "buffers" }));
+    QCOMPARE(usage.bytes(QStringLiteral("services")), qsizetype(100));
+    QCOMPARE(usage.bytes(QStringLiteral("buffers")), qsizetype(20));
+    QCOMPARE(usage.bytes(QStringLiteral("unknown")), qsizetype(0));
+    QCOMPARE(usage.totalBytes(), qsizetype(120));
+
+    // adding to a known structure keeps its position
+    QBluetoothMemoryUsagePrivate::add(&usage, QStringLiteral("services"), 5);
+    QBluetoothMemoryUsagePrivate::add(&usage, QStringLiteral("empty"), 0);
+    QCOMPARE(usage.structures(), QStringList({ "services", "buffers", "empty" }));
+    QCOMPARE(usage.bytes(QStringLiteral("services")), qsizetype(105));
+    QCOMPARE(usage.bytes(QStringLiteral("empty")), qsizetype(0));
+    QCOMPARE(usage.totalBytes(), qsizetype(125));
+#else
+    QSKIP("This test requires a developer build");
+#endif
+}
+
+void tst_QBluetoothMemoryUsage::tst_copy()
+{
+#ifdef QT_BUILD_INTERNAL
+    const QBluetoothMemoryUsage usage = sampleUsage();
+    QBluetoothMemoryUsage copy(usage);
+    QCOMPARE(copy.structures(), usage.structures());
+    QCOMPARE(copy.totalBytes(), qsizetype(120));
+
+    // the copy detaches from the original when it changes
+    QBluetoothMemoryUsagePrivate::add(&copy, QStringLiteral("buffers"), 10);
+    QCOMPARE(copy.bytes(QStringLiteral("buffers")), qsizetype(30));
+    QCOMPARE(usage.bytes(QStringLiteral("buffers")), qsizetype(20));
+
+    QBluetoothMemoryUsage assigned;
+    assigned = usage;
+    QCOMPARE(assigned.structures(), usage.structures());
+    QCOMPARE(assigned.totalBytes(), qsizetype(120));
+
+    assigned = QBluetoothMemoryUsage();
+    QVERIFY(assigned.isEmpty());
+    QVERIFY(!usage.isEmpty());
+#else
+    QSKIP("This test requires a developer build");
+#endif
+}
+
+void tst_QBluetoothMemoryUsage::tst_swap()
+{
+#ifdef QT_BUILD_INTERNAL
+    QBluetoothMemoryUsage usage = sampleUsage();
+    QBluetoothMemoryUsage other;
+    QBluetoothMemoryUsagePrivate::add(&other, QStringLiteral("cache"), 7);
+
+    usage.swap(other);
+    QCOMPARE(usage.structures(), QStringList({ "cache" }));
+    QCOMPARE(usage.totalBytes(), qsizetype(7));
+    QCOMPARE(other.structures(), QStringList({ "services", "buffers" }));
+    QCOMPARE(other.totalBytes(), qsizetype(120));
+
+    QBluetoothMemoryUsage empty;
+    swap(usage, empty);
+    QVERIFY(usage.isEmpty());
+    QCOMPARE(empty.bytes(QStringLiteral("cache")), qsizetype(7));
+#else
+    QSKIP("This test requires a developer build");
+#endif
+}
+
+void tst_QBluetoothMemoryUsage::tst_debugStreaming()
+{
+    QTest::ignoreMessage(QtDebugMsg, "QBluetoothMemoryUsage(total 0)");
+    qDebug() << QBluetoothMemoryUsage();
+#ifdef QT_BUILD_INTERNAL
+    QTest::ignoreMessage(QtDebugMsg, "QBluetoothMemoryUsage(total 120, services 100, buffers 20)");
+    qDebug() << sampleUsage();
+#endif
+}
+
+void tst_QBluetoothMemoryUsage::tst_variant()
+{
+    const QVariant variant = QVariant::fromValue(QBluetoothMemoryUsage());
+    QCOMPARE(variant.metaType(), QMetaType::fromType<QBluetoothMemoryUsage>());
+    QVERIFY(variant.value<QBluetoothMemoryUsage>().isEmpty());
+#ifdef QT_BUILD_INTERNAL
+    const QBluetoothMemoryUsage usage =
+            QVariant::fromValue(sampleUsage()).value<QBluetoothMemoryUsage>();
+    QCOMPARE(usage.totalBytes(), qsizetype(120));
+#endif
+}
+
+QTEST_MAIN(tst_QBluetoothMemoryUsage)
+
+#include "tst_qbluetoothmemoryusage.moc"
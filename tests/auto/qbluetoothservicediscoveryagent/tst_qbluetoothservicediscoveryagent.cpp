@@ -41,6 +41,8 @@ private slots:
     void tst_serviceDiscovery();
     void tst_serviceDiscoveryStop();
     void tst_serviceDiscoveryAdapters();
+    void tst_cacheTimeout();
+    void tst_maximumParallelDiscoveries();
 
 private:
     QList<QBluetoothDeviceInfo> devices;
@@ -137,6 +139,40 @@ void tst_QBluetoothServiceDiscoveryAgent::tst_serviceDiscoveryStop()
 }
 
 
+void tst_QBluetoothServiceDiscoveryAgent::tst_cacheTimeout()
+{
+    QBluetoothServiceDiscoveryAgent discoveryAgent;
+    QCOMPARE(discoveryAgent.cacheTimeout(), 0);
+
+    discoveryAgent.setCacheTimeout(30000);
+    QCOMPARE(discoveryAgent.cacheTimeout(), 30000);
+
+    // negative values are ignored
+    discoveryAgent.setCacheTimeout(-1);
+    QCOMPARE(discoveryAgent.cacheTimeout(), 30000);
+
+    discoveryAgent.setCacheTimeout(0);
+    QCOMPARE(discoveryAgent.cacheTimeout(), 0);
+
+    QBluetoothServiceDiscoveryAgent::invalidateCache(QBluetoothAddress("11:22:33:44:55:66"));
+    QBluetoothServiceDiscoveryAgent::invalidateCache();
+}
+
+void tst_QBluetoothServiceDiscoveryAgent::tst_maximumParallelDiscoveries()
+{
+    QBluetoothServiceDiscoveryAgent discoveryAgent;
+    QCOMPARE(discoveryAgent.maximumParallelDiscoveries(), 1);
+
+    discoveryAgent.setMaximumParallelDiscoveries(4);
+    QCOMPARE(discoveryAgent.maximumParallelDiscoveries(), 4);
+
+    // at least one device is always queried
+    discoveryAgent.setMaximumParallelDiscoveries(0);
+    QCOMPARE(discoveryAgent.maximumParallelDiscoveries(), 4);
+    discoveryAgent.setMaximumParallelDiscoveries(-1);
+    QCOMPARE(discoveryAgent.maximumParallelDiscoveries(), 4);
+}
+
 void tst_QBluetoothServiceDiscoveryAgent::tst_invalidBtAddress()
 {
 #ifdef Q_OS_OSX
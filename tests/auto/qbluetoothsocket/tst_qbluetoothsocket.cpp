@@ -12,6 +12,12 @@
 #include <qbluetoothlocaldevice.h>
 #if QT_CONFIG(bluez)
 #include <QtBluetooth/private/bluez5_helper_p.h>
+#ifdef QT_BUILD_INTERNAL
+#include <QtBluetooth/private/qbluetoothsocket_bluez_p.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 #endif
 
 QT_USE_NAMESPACE
@@ -54,6 +60,11 @@ private slots:
 
     void tst_error();
 
+    void tst_statistics();
+    void tst_memoryUsage();
+    void tst_memoryUsageBuffers();
+    void tst_l2capPacketBoundaries();
+
     void tst_preferredSecurityFlags();
 
     void tst_unsupportedProtocolError();
@@ -73,6 +84,18 @@ private:
 
 Q_DECLARE_METATYPE(tst_QBluetoothSocket::ClientConnectionShutdown)
 
+#if QT_CONFIG(bluez) && defined(QT_BUILD_INTERNAL)
+// the raw socket implementation, which the BlueZ controller uses for ATT
+class RawBluetoothSocket : public QBluetoothSocket
+{
+public:
+    RawBluetoothSocket()
+        : QBluetoothSocket(new QBluetoothSocketPrivateBluez, QBluetoothServiceInfo::L2capProtocol)
+    {
+    }
+};
+#endif
+
 tst_QBluetoothSocket::tst_QBluetoothSocket()
 {
     qRegisterMetaType<QBluetoothSocket::SocketState>();
@@ -483,6 +506,111 @@ void tst_QBluetoothSocket::tst_error()
     QVERIFY(socket.errorString() == QString());
 }
 
+void tst_QBluetoothSocket::tst_statistics()
+{
+    QBluetoothSocketStatistics defaultStatistics;
+    QVERIFY(!defaultStatistics.isValid());
+
+    QBluetoothSocket socket;
+    const QBluetoothSocketStatistics statistics = socket.statistics();
+    QVERIFY(statistics.isValid());
+    QCOMPARE(statistics.bytesSent(), quint64(0));
+    QCOMPARE(statistics.bytesReceived(), quint64(0));
+    QCOMPARE(statistics.readyReadCount(), quint64(0));
+    QCOMPARE(statistics.writeBufferHighWaterMark(), qint64(0));
+    QCOMPARE(statistics.writeStallCount(), quint64(0));
+    QCOMPARE(statistics.writeStallTime(), 0.0);
+
+    defaultStatistics = statistics;
+    QVERIFY(defaultStatistics.isValid());
+}
+
+void tst_QBluetoothSocket::tst_memoryUsage()
+{
+    QBluetoothMemoryUsage defaultUsage;
+    QVERIFY(defaultUsage.isEmpty());
+    QCOMPARE(defaultUsage.totalBytes(), qsizetype(0));
+
+    QBluetoothSocket socket;
+    const QBluetoothMemoryUsage usage = socket.memoryUsage();
+    QVERIFY(!usage.isEmpty());
+    QCOMPARE(usage.structures(), QStringList({ "receiveBuffer", "sendBuffer" }));
+    QCOMPARE(usage.bytes("receiveBuffer"), qsizetype(0));
+    QCOMPARE(usage.bytes("sendBuffer"), qsizetype(0));
+    QCOMPARE(usage.bytes("unknown"), qsizetype(0));
+    QCOMPARE(usage.totalBytes(), qsizetype(0));
+
+    defaultUsage = usage;
+    QVERIFY(!defaultUsage.isEmpty());
+}
+
+void tst_QBluetoothSocket::tst_memoryUsageBuffers()
+{
+#if QT_CONFIG(bluez) && defined(QT_BUILD_INTERNAL)
+    int descriptors[2];
+    QCOMPARE(::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, descriptors), 0);
+
+    RawBluetoothSocket socket;
+    QVERIFY(socket.setSocketDescriptor(descriptors[0], QBluetoothServiceInfo::L2capProtocol));
+
+    // received data is reported until it is read
+    const QByteArray notification = QByteArray::fromHex("1b2a00010203");
+    QCOMPARE(::write(descriptors[1], notification.constData(), notification.size()),
+             ssize_t(notification.size()));
+    QTRY_COMPARE(socket.bytesAvailable(), qint64(notification.size()));
+    QCOMPARE(socket.memoryUsage().bytes("receiveBuffer"), qsizetype(notification.size()));
+    QCOMPARE(socket.memoryUsage().totalBytes(), qsizetype(notification.size()));
+
+    QCOMPARE(socket.readAll(), notification);
+    QCOMPARE(socket.memoryUsage().bytes("receiveBuffer"), qsizetype(0));
+
+    // written data is reported until it is handed to the kernel
+    const QByteArray request = QByteArray::fromHex("0a2a00");
+    QCOMPARE(socket.write(request), qint64(request.size()));
+    QCOMPARE(socket.memoryUsage().bytes("sendBuffer"), qsizetype(request.size()));
+    QTRY_COMPARE(socket.bytesToWrite(), qint64(0));
+    QCOMPARE(socket.memoryUsage().bytes("sendBuffer"), qsizetype(0));
+    QCOMPARE(socket.memoryUsage().totalBytes(), qsizetype(0));
+
+    ::close(descriptors[1]);
+#else
+    QSKIP("This test requires the raw BlueZ socket of a developer build");
+#endif
+}
+
+void tst_QBluetoothSocket::tst_l2capPacketBoundaries()
+{
+#if QT_CONFIG(bluez) && defined(QT_BUILD_INTERNAL)
+    // a local SOCK_SEQPACKET pair keeps the packet boundaries like an L2CAP socket
+    int descriptors[2];
+    QCOMPARE(::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, descriptors), 0);
+
+    RawBluetoothSocket socket;
+    QVERIFY(socket.setSocketDescriptor(descriptors[0], QBluetoothServiceInfo::L2capProtocol));
+    QList<QByteArray> received;
+    connect(&socket, &QIODevice::readyRead, this, [&received, &socket]() {
+        received.append(socket.readAll());
+    });
+
+    // both PDUs are queued before the socket is notified
+    const QByteArray notification = QByteArray::fromHex("1b2a00010203");
+    const QByteArray indication = QByteArray::fromHex("1d2c000405");
+    QCOMPARE(::write(descriptors[1], notification.constData(), notification.size()),
+             ssize_t(notification.size()));
+    QCOMPARE(::write(descriptors[1], indication.constData(), indication.size()),
+             ssize_t(indication.size()));
+
+    QTRY_COMPARE(received.size(), 2);
+    QCOMPARE(received.at(0), notification);
+    QCOMPARE(received.at(1), indication);
+    QCOMPARE(socket.statistics().readyReadCount(), quint64(2));
+
+    ::close(descriptors[1]);
+#else
+    QSKIP("This test requires the raw BlueZ socket of a developer build");
+#endif
+}
+
 void tst_QBluetoothSocket::tst_preferredSecurityFlags()
 {
     QBluetoothSocket socket;
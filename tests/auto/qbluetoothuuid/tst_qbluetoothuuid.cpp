@@ -35,6 +35,9 @@ private slots:
     void tst_comparison_data();
     void tst_comparison();
     void tst_quint128ToUuid();
+    void tst_fromString_data();
+    void tst_fromString();
+    void tst_names();
 };
 
 tst_QBluetoothUuid::tst_QBluetoothUuid()
@@ -326,6 +329,9 @@ void tst_QBluetoothUuid::tst_comparison()
 
         QVERIFY(quuid32 == quuid16);
         QVERIFY(quuid128 == quuid16);
+
+        QCOMPARE(qHash(quuid16), qHash(quuid32));
+        QCOMPARE(qHash(quuid16), qHash(quuid128));
     }
 
     if (constructUuid32) {
@@ -336,6 +342,7 @@ void tst_QBluetoothUuid::tst_comparison()
         QVERIFY(quuid32 == quuid128);
 
         QVERIFY(quuid128 == quuid32);
+        QCOMPARE(qHash(quuid32, 42), qHash(quuid128, 42));
     }
 
     if (constructUuid128) {
@@ -358,6 +365,63 @@ void tst_QBluetoothUuid::tst_quint128ToUuid()
         QBluetoothUuid u(array);
     }
 }
+
+void tst_QBluetoothUuid::tst_fromString_data()
+{
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("16 bit") << QStringLiteral("0000180f-0000-1000-8000-00805f9b34fb");
+    QTest::newRow("32 bit") << QStringLiteral("1234180f-0000-1000-8000-00805f9b34fb");
+    QTest::newRow("16 bit upper case") << QStringLiteral("0000180F-0000-1000-8000-00805F9B34FB");
+    QTest::newRow("16 bit braces") << QStringLiteral("{0000180f-0000-1000-8000-00805f9b34fb}");
+    QTest::newRow("128 bit") << QStringLiteral("67c8770b-44f1-410a-ab9a-f9b5446f13ee");
+    QTest::newRow("128 bit mixed case") << QStringLiteral("{67C8770b-44F1-410a-AB9A-f9b5446f13EE}");
+    QTest::newRow("null") << QStringLiteral("00000000-0000-0000-0000-000000000000");
+    QTest::newRow("empty") << QString();
+    QTest::newRow("short") << QStringLiteral("0000180f-0000-1000-8000-00805f9b34f");
+    QTest::newRow("invalid digit") << QStringLiteral("0000180g-0000-1000-8000-00805f9b34fb");
+    QTest::newRow("invalid suffix") << QStringLiteral("0000180f-0000-1000-8000-00805f9b34fx");
+    QTest::newRow("missing dash") << QStringLiteral("67c8770b-44f1-410a0ab9a-f9b5446f13ee");
+    QTest::newRow("unbalanced brace") << QStringLiteral("{67c8770b-44f1-410a-ab9a-f9b5446f13ee");
+    QTest::newRow("non Latin-1") << (QStringLiteral("67c8770b-44f1-410a-ab9a-f9b5446f13e")
+                                     + QChar(0x0165));
+}
+
+void tst_QBluetoothUuid::tst_fromString()
+{
+    QFETCH(QString, text);
+
+    // the dedicated parser must not differ from QUuid
+    const QUuid expected(text);
+    const QBluetoothUuid uuid(text);
+    QCOMPARE(static_cast<const QUuid &>(uuid), expected);
+    QCOMPARE(uuid.minimumSize(), QBluetoothUuid(expected).minimumSize());
+}
+
+void tst_QBluetoothUuid::tst_names()
+{
+    QCOMPARE(QBluetoothUuid::protocolToString(QBluetoothUuid::ProtocolUuid::Rfcomm),
+             QStringLiteral("Radio Frequency Communication"));
+    QCOMPARE(QBluetoothUuid::serviceClassToString(QBluetoothUuid::ServiceClassUuid::SerialPort),
+             QStringLiteral("Serial Port Profile"));
+    QCOMPARE(QBluetoothUuid::characteristicToString(
+                     QBluetoothUuid::CharacteristicType::TrueWindDirection),
+             QStringLiteral("True Wind Direction"));
+    QCOMPARE(QBluetoothUuid::descriptorToString(QBluetoothUuid::DescriptorType::ValidRange),
+             QStringLiteral("Valid Range"));
+    QVERIFY(QBluetoothUuid::serviceClassToString(QBluetoothUuid::ServiceClassUuid(0x1234))
+                    .isEmpty());
+
+    QCOMPARE(QBluetoothUuid::fromName(u"Serial Port Profile"),
+             QBluetoothUuid(QBluetoothUuid::ServiceClassUuid::SerialPort));
+    QCOMPARE(QBluetoothUuid::fromName(u"Valid Range"),
+             QBluetoothUuid(QBluetoothUuid::DescriptorType::ValidRange));
+    QCOMPARE(QBluetoothUuid::fromName(u"Human Interface Device"),
+             QBluetoothUuid(QBluetoothUuid::ServiceClassUuid::HumanInterfaceDeviceService));
+    QVERIFY(QBluetoothUuid::fromName(u"No Such Service").isNull());
+    QVERIFY(QBluetoothUuid::fromName(u"").isNull());
+}
+
 QTEST_MAIN(tst_QBluetoothUuid)
 
 #include "tst_qbluetoothuuid.moc"
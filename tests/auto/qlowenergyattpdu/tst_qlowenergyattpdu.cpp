@@ -0,0 +1,453 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/private/attpdu_p.h>
+
+QT_USE_NAMESPACE
+
+using AttCommand = QBluezConst::AttCommand;
+using AttError = QBluezConst::AttError;
+
+class tst_QLowEnergyAttPdu : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void uuid_data();
+    void uuid();
+    void errorResponse();
+    void mtu();
+    void handleRangeRequest();
+    void malformedHandleRangeRequest_data();
+    void malformedHandleRangeRequest();
+    void handleValue();
+    void malformedHandleValue_data();
+    void malformedHandleValue();
+    void truncatedValue();
+    void signedWrite();
+    void executeWriteRequest();
+    void readMultiple();
+    void readMultipleVariable();
+    void attributeDataList();
+    void characteristicDeclaration();
+    void includeDeclaration_data();
+    void includeDeclaration();
+    void groupData();
+};
+
+void tst_QLowEnergyAttPdu::uuid_data()
+{
+    QTest::addColumn<QBluetoothUuid>("uuid");
+    QTest::addColumn<QByteArray>("data");
+
+    QTest::newRow("16 bit") << QBluetoothUuid(quint16(0x2a37)) << QByteArray::fromHex("372a");
+    QTest::newRow("128 bit")
+            << QBluetoothUuid(QStringLiteral("{e8e10f95-1a70-4b27-9ccf-02010264e9c8}"))
+            << QByteArray::fromHex("c8e964020102cf9c274b701a950fe1e8");
+}
+
+void tst_QLowEnergyAttPdu::uuid()
+{
+    QFETCH(QBluetoothUuid, uuid);
+    QFETCH(QByteArray, data);
+
+    char buffer[16];
+    QCOMPARE(QBluezAtt::putUuid(uuid, buffer), data.size());
+    QCOMPARE(QByteArray(buffer, data.size()), data);
+    QCOMPARE(QBluezAtt::uuidFromData(data), uuid);
+
+    // only 2 and 16 bytes are valid sizes
+    QVERIFY(QBluezAtt::uuidFromData(QByteArrayView(data).chopped(1)).isNull());
+}
+
+void tst_QLowEnergyAttPdu::errorResponse()
+{
+    QByteArray pdu;
+    QBluezAtt::buildErrorResponse(pdu, AttCommand::ATT_OP_READ_REQUEST, 0x0102,
+                                  AttError::ATT_ERROR_READ_NOT_PERM);
+    QCOMPARE(pdu, QByteArray::fromHex("010a020102"));
+
+    QBluezAtt::ErrorResponse error;
+    QVERIFY(QBluezAtt::parseErrorResponse(pdu, &error));
+    QCOMPARE(error.request, AttCommand::ATT_OP_READ_REQUEST);
+    QCOMPARE(error.handle, quint16(0x0102));
+    QCOMPARE(error.code, AttError::ATT_ERROR_READ_NOT_PERM);
+
+    QVERIFY(!QBluezAtt::parseErrorResponse(QByteArrayView(pdu).chopped(1), &error));
+    QVERIFY(!QBluezAtt::parseErrorResponse(QByteArray::fromHex("0b0a020102"), &error));
+    QVERIFY(!QBluezAtt::parseErrorResponse(QByteArrayView(), &error));
+}
+
+void tst_QLowEnergyAttPdu::mtu()
+{
+    QByteArray pdu;
+    QBluezAtt::buildMtu(pdu, AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST, 517);
+    QCOMPARE(pdu, QByteArray::fromHex("020502"));
+
+    quint16 mtu = 0;
+    QVERIFY(QBluezAtt::parseMtu(pdu, &mtu));
+    QCOMPARE(mtu, quint16(517));
+    QVERIFY(!QBluezAtt::parseMtu(QByteArrayView(pdu).chopped(1), &mtu));
+    QVERIFY(!QBluezAtt::parseMtu(pdu + '\0', &mtu));
+}
+
+void tst_QLowEnergyAttPdu::handleRangeRequest()
+{
+    QByteArray pdu;
+    QBluezAtt::HandleRangeRequest range;
+
+    QBluezAtt::buildHandleRangeRequest(pdu, AttCommand::ATT_OP_FIND_INFORMATION_REQUEST,
+                                       0x0001, 0xffff);
+    QCOMPARE(pdu, QByteArray::fromHex("040100ffff"));
+    QVERIFY(QBluezAtt::parseHandleRangeRequest(pdu, &range));
+    QCOMPARE(range.startingHandle, quint16(0x0001));
+    QCOMPARE(range.endingHandle, quint16(0xffff));
+    QVERIFY(range.tail.isEmpty());
+
+    const QBluetoothUuid type(quint16(0x2803));
+    QBluezAtt::buildHandleRangeRequest(pdu, AttCommand::ATT_OP_READ_BY_TYPE_REQUEST,
+                                       0x0010, 0x0020, type);
+    QCOMPARE(pdu, QByteArray::fromHex("08100020000328"));
+    QVERIFY(QBluezAtt::parseHandleRangeRequest(pdu, &range));
+    QCOMPARE(range.startingHandle, quint16(0x0010));
+    QCOMPARE(range.endingHandle, quint16(0x0020));
+    QCOMPARE(QBluezAtt::uuidFromData(range.tail), type);
+
+    const QByteArray service = QByteArray::fromHex("0d18");
+    QBluezAtt::buildFindByTypeValueRequest(pdu, 0x0001, 0xffff, 0x2800, service);
+    QCOMPARE(pdu, QByteArray::fromHex("060100ffff00280d18"));
+    QVERIFY(QBluezAtt::parseHandleRangeRequest(pdu, &range));
+    QCOMPARE(range.tail.toByteArray(), QByteArray::fromHex("00280d18"));
+}
+
+void tst_QLowEnergyAttPdu::malformedHandleRangeRequest_data()
+{
+    QTest::addColumn<QByteArray>("pdu");
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("truncated header") << QByteArray::fromHex("040100ff");
+    QTest::newRow("find information with tail") << QByteArray::fromHex("040100ffff00");
+    QTest::newRow("find by type value without type") << QByteArray::fromHex("060100ffff00");
+    QTest::newRow("read by type with 3 byte type") << QByteArray::fromHex("080100ffff032800");
+    QTest::newRow("read by group without type") << QByteArray::fromHex("100100ffff");
+    QTest::newRow("other opcode") << QByteArray::fromHex("0a0100ffff");
+}
+
+void tst_QLowEnergyAttPdu::malformedHandleRangeRequest()
+{
+    QFETCH(QByteArray, pdu);
+
+    QBluezAtt::HandleRangeRequest range;
+    QVERIFY(!QBluezAtt::parseHandleRangeRequest(pdu, &range));
+}
+
+void tst_QLowEnergyAttPdu::handleValue()
+{
+    const QByteArray value = QByteArray::fromHex("0102030405");
+    QByteArray pdu;
+    QBluezAtt::HandleValue parsed;
+
+    QBluezAtt::buildHandleValue(pdu, AttCommand::ATT_OP_WRITE_REQUEST, 0x002a, value);
+    QCOMPARE(pdu, QByteArray::fromHex("122a000102030405"));
+    QVERIFY(QBluezAtt::parseHandleValue(pdu, &parsed));
+    QCOMPARE(parsed.handle, quint16(0x002a));
+    QCOMPARE(parsed.offset, quint16(0));
+    QCOMPARE(parsed.value.toByteArray(), value);
+
+    QBluezAtt::buildHandleOffsetValue(pdu, AttCommand::ATT_OP_PREPARE_WRITE_REQUEST, 0x002a,
+                                      0x0102, value);
+    QCOMPARE(pdu, QByteArray::fromHex("162a0002010102030405"));
+    QVERIFY(QBluezAtt::parseHandleValue(pdu, &parsed));
+    QCOMPARE(parsed.handle, quint16(0x002a));
+    QCOMPARE(parsed.offset, quint16(0x0102));
+    QCOMPARE(parsed.value.toByteArray(), value);
+
+    QBluezAtt::buildHandleOffsetValue(pdu, AttCommand::ATT_OP_READ_BLOB_REQUEST, 0x002a, 22);
+    QCOMPARE(pdu, QByteArray::fromHex("0c2a001600"));
+    QVERIFY(QBluezAtt::parseHandleValue(pdu, &parsed));
+    QCOMPARE(parsed.offset, quint16(22));
+    QVERIFY(parsed.value.isEmpty());
+}
+
+void tst_QLowEnergyAttPdu::malformedHandleValue_data()
+{
+    QTest::addColumn<QByteArray>("pdu");
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("read without handle") << QByteArray::fromHex("0a2a");
+    QTest::newRow("read with value") << QByteArray::fromHex("0a2a0001");
+    QTest::newRow("read blob without offset") << QByteArray::fromHex("0c2a00");
+    QTest::newRow("prepare write without offset") << QByteArray::fromHex("162a0002");
+    QTest::newRow("notification without handle") << QByteArray::fromHex("1b2a");
+    QTest::newRow("response opcode") << QByteArray::fromHex("0b2a00");
+}
+
+void tst_QLowEnergyAttPdu::malformedHandleValue()
+{
+    QFETCH(QByteArray, pdu);
+
+    QBluezAtt::HandleValue parsed;
+    QVERIFY(!QBluezAtt::parseHandleValue(pdu, &parsed));
+}
+
+void tst_QLowEnergyAttPdu::truncatedValue()
+{
+    // the value is cut to the MTU
+    const QByteArray value(30, 'x');
+    QByteArray pdu;
+    QBluezAtt::buildHandleValue(pdu, AttCommand::ATT_OP_HANDLE_VAL_NOTIFICATION, 0x0003,
+                                value, 23);
+    QCOMPARE(pdu.size(), 23);
+    QCOMPARE(pdu.sliced(3), value.first(20));
+
+    QBluezAtt::buildHandleOffsetValue(pdu, AttCommand::ATT_OP_PREPARE_WRITE_REQUEST, 0x0003,
+                                      0, value, 23);
+    QCOMPARE(pdu.size(), 23);
+
+    QBluezAtt::buildValue(pdu, AttCommand::ATT_OP_READ_RESPONSE, value, 23);
+    QCOMPARE(pdu.size(), 23);
+    QCOMPARE(pdu.sliced(1), value.first(22));
+
+    // a reused buffer keeps its capacity
+    const qsizetype capacity = pdu.capacity();
+    QBluezAtt::buildOpcode(pdu, AttCommand::ATT_OP_WRITE_RESPONSE);
+    QCOMPARE(pdu, QByteArray::fromHex("13"));
+    QCOMPARE(pdu.capacity(), capacity);
+}
+
+void tst_QLowEnergyAttPdu::signedWrite()
+{
+    const QByteArray value = QByteArray::fromHex("0102");
+    QByteArray pdu;
+    QBluezAtt::buildHandleValue(pdu, AttCommand::ATT_OP_SIGNED_WRITE_COMMAND, 0x0010, value);
+    const QByteArray signedData = pdu;
+    QBluezAtt::appendSignature(pdu, 0x04030201, Q_UINT64_C(0x0c0b0a0908070605));
+    QCOMPARE(pdu, QByteArray::fromHex("d2100001020102030405060708090a0b0c"));
+
+    QBluezAtt::SignedWrite write;
+    QVERIFY(QBluezAtt::parseSignedWrite(pdu, &write));
+    QCOMPARE(write.handle, quint16(0x0010));
+    QCOMPARE(write.value.toByteArray(), value);
+    QCOMPARE(write.signedData.toByteArray(), signedData);
+    QCOMPARE(write.signCounter, quint32(0x04030201));
+    QCOMPARE(write.mac, Q_UINT64_C(0x0c0b0a0908070605));
+
+    // an empty value is fine, a missing signature byte is not
+    QBluezAtt::buildHandleValue(pdu, AttCommand::ATT_OP_SIGNED_WRITE_COMMAND, 0x0010);
+    QBluezAtt::appendSignature(pdu, 1, 2);
+    QVERIFY(QBluezAtt::parseSignedWrite(pdu, &write));
+    QVERIFY(write.value.isEmpty());
+    QVERIFY(!QBluezAtt::parseSignedWrite(QByteArrayView(pdu).chopped(1), &write));
+
+    pdu[0] = char(AttCommand::ATT_OP_WRITE_COMMAND);
+    QVERIFY(!QBluezAtt::parseSignedWrite(pdu, &write));
+}
+
+void tst_QLowEnergyAttPdu::executeWriteRequest()
+{
+    QByteArray pdu;
+    bool execute = false;
+
+    QBluezAtt::buildExecuteWriteRequest(pdu, true);
+    QCOMPARE(pdu, QByteArray::fromHex("1801"));
+    QVERIFY(QBluezAtt::parseExecuteWriteRequest(pdu, &execute));
+    QVERIFY(execute);
+
+    QBluezAtt::buildExecuteWriteRequest(pdu, false);
+    QCOMPARE(pdu, QByteArray::fromHex("1800"));
+    QVERIFY(QBluezAtt::parseExecuteWriteRequest(pdu, &execute));
+    QVERIFY(!execute);
+
+    QVERIFY(!QBluezAtt::parseExecuteWriteRequest(QByteArray::fromHex("18"), &execute));
+    QVERIFY(!QBluezAtt::parseExecuteWriteRequest(QByteArray::fromHex("180100"), &execute));
+    QVERIFY(!QBluezAtt::parseExecuteWriteRequest(QByteArray::fromHex("1901"), &execute));
+}
+
+void tst_QLowEnergyAttPdu::readMultiple()
+{
+    const quint16 handles[] = { 0x0003, 0x0005, 0x0107 };
+    QByteArray pdu;
+    QBluezAtt::buildHandleList(pdu, AttCommand::ATT_OP_READ_MULTIPLE_REQUEST, handles, 3);
+    QCOMPARE(pdu, QByteArray::fromHex("0e030005000701"));
+    QCOMPARE(QBluezAtt::handleCount(pdu), qsizetype(3));
+    for (qsizetype i = 0; i < 3; ++i)
+        QCOMPARE(QBluezAtt::handleAt(pdu, i), handles[i]);
+    // a trailing partial handle is ignored
+    QCOMPARE(QBluezAtt::handleCount(pdu + '\x01'), qsizetype(3));
+    QCOMPARE(QBluezAtt::handleCount(QByteArrayView()), qsizetype(0));
+
+    QBluezAtt::buildOpcode(pdu, AttCommand::ATT_OP_READ_MULTIPLE_RESPONSE);
+    QBluezAtt::appendValue(pdu, QByteArray::fromHex("0102"), 23);
+    QBluezAtt::appendValue(pdu, QByteArray(30, 'x'), 23);
+    QCOMPARE(pdu.size(), 23);
+
+    QByteArrayView values = QByteArrayView(pdu).sliced(QBluezAtt::OpcodeSize);
+    QByteArrayView value;
+    QVERIFY(QBluezAtt::takeValue(&values, 2, &value));
+    QCOMPARE(value.toByteArray(), QByteArray::fromHex("0102"));
+    // the second value was cut off by the MTU
+    QVERIFY(!QBluezAtt::takeValue(&values, 30, &value));
+    QVERIFY(values.isEmpty());
+    QVERIFY(!QBluezAtt::takeValue(&values, 1, &value));
+    QVERIFY(QBluezAtt::takeValue(&values, 0, &value));
+    QVERIFY(value.isEmpty());
+}
+
+void tst_QLowEnergyAttPdu::readMultipleVariable()
+{
+    QByteArray pdu;
+    QBluezAtt::buildOpcode(pdu, AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_RESPONSE);
+    QVERIFY(QBluezAtt::appendLengthValue(pdu, QByteArray::fromHex("0102"), 23));
+    QVERIFY(QBluezAtt::appendLengthValue(pdu, QByteArray(), 23));
+    QVERIFY(QBluezAtt::appendLengthValue(pdu, QByteArray(30, 'x'), 23));
+    QCOMPARE(pdu.size(), 23);
+    // not even the length fits anymore
+    QVERIFY(!QBluezAtt::appendLengthValue(pdu, QByteArray::fromHex("01"), 23));
+    QCOMPARE(pdu.size(), 23);
+
+    QByteArrayView values = QByteArrayView(pdu).sliced(QBluezAtt::OpcodeSize);
+    QByteArrayView value;
+    quint16 length = 0;
+    QVERIFY(QBluezAtt::takeLengthValue(&values, &value, &length));
+    QCOMPARE(length, quint16(2));
+    QCOMPARE(value.toByteArray(), QByteArray::fromHex("0102"));
+    QVERIFY(QBluezAtt::takeLengthValue(&values, &value, &length));
+    QCOMPARE(length, quint16(0));
+    QVERIFY(value.isEmpty());
+    // the truncated value reports its complete length
+    QVERIFY(QBluezAtt::takeLengthValue(&values, &value, &length));
+    QCOMPARE(length, quint16(30));
+    QCOMPARE(value.size(), qsizetype(23 - 1 - 4 - 2 - 2));
+    QVERIFY(values.isEmpty());
+    QVERIFY(!QBluezAtt::takeLengthValue(&values, &value, &length));
+
+    // a single byte cannot hold a length
+    values = QByteArrayView("\x01", 1);
+    QVERIFY(!QBluezAtt::takeLengthValue(&values, &value, &length));
+}
+
+void tst_QLowEnergyAttPdu::attributeDataList()
+{
+    QByteArray pdu;
+    {
+        QBluezAtt::AttributeDataListBuilder builder(
+                pdu, AttCommand::ATT_OP_FIND_INFORMATION_RESPONSE, 4, 11);
+        for (quint16 handle = 1; char *element = builder.appendElement(); ++handle) {
+            putBtData(handle, element);
+            putBtData(quint16(0x2900 + handle), element + 2);
+        }
+        QCOMPARE(builder.size(), qsizetype(2));
+    }
+    QCOMPARE(pdu, QByteArray::fromHex("05010100012902000229"));
+
+    QBluezAtt::AttributeDataList list(pdu);
+    QVERIFY(list.isValid());
+    QCOMPARE(list.elementSize(), qsizetype(4));
+    QCOMPARE(list.size(), qsizetype(2));
+    quint16 handle = 1;
+    for (const QByteArrayView element : list) {
+        QCOMPARE(bt_get_le16(element.data()), handle);
+        QCOMPARE(QBluezAtt::uuidFromData(element.sliced(2)),
+                 QBluetoothUuid(quint16(0x2900 + handle)));
+        ++handle;
+    }
+    QCOMPARE(handle, quint16(3));
+
+    // a trailing partial element is ignored
+    QCOMPARE(QBluezAtt::AttributeDataList(pdu + '\x03').size(), qsizetype(2));
+    // unknown formats and opcodes yield an invalid list
+    QVERIFY(!QBluezAtt::AttributeDataList(QByteArray::fromHex("0503010001")).isValid());
+    QVERIFY(!QBluezAtt::AttributeDataList(QByteArray::fromHex("05")).isValid());
+    QVERIFY(!QBluezAtt::AttributeDataList(QByteArray::fromHex("0a0100")).isValid());
+    QVERIFY(!QBluezAtt::AttributeDataList(QByteArrayView()).isValid());
+    QCOMPARE(QBluezAtt::AttributeDataList(QByteArrayView()).size(), qsizetype(0));
+
+    // a read by type response carries the element length
+    QBluezAtt::AttributeDataList byType(QByteArray::fromHex("0903030001020405"));
+    QVERIFY(byType.isValid());
+    QCOMPARE(byType.size(), qsizetype(2));
+    QCOMPARE(byType.at(1).toByteArray(), QByteArray::fromHex("020405"));
+}
+
+void tst_QLowEnergyAttPdu::characteristicDeclaration()
+{
+    QBluezAtt::CharacteristicDeclaration declaration;
+    QVERIFY(QBluezAtt::parseCharacteristicDeclaration(QByteArray::fromHex("0200120300002a"),
+                                                      &declaration));
+    QCOMPARE(declaration.declarationHandle, quint16(0x0002));
+    QCOMPARE(declaration.properties, quint8(0x12));
+    QCOMPARE(declaration.valueHandle, quint16(0x0003));
+    QCOMPARE(declaration.uuid, QBluetoothUuid(quint16(0x2a00)));
+
+    QVERIFY(QBluezAtt::parseCharacteristicDeclaration(
+            QByteArray::fromHex("020012030000112233445566778899aabbccddeeff"), &declaration));
+    QCOMPARE(declaration.uuid.minimumSize(), 16);
+
+    QVERIFY(!QBluezAtt::parseCharacteristicDeclaration(QByteArray::fromHex("0200120300"),
+                                                       &declaration));
+    QVERIFY(!QBluezAtt::parseCharacteristicDeclaration(QByteArray::fromHex("0200120300002a00"),
+                                                       &declaration));
+}
+
+void tst_QLowEnergyAttPdu::includeDeclaration_data()
+{
+    QTest::addColumn<QByteArray>("element");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QBluetoothUuid>("uuid");
+
+    QTest::newRow("16 bit uuid") << QByteArray::fromHex("1400200030000f18") << true
+                                 << QBluetoothUuid(quint16(0x180f));
+    QTest::newRow("128 bit uuid")
+            << QByteArray::fromHex("140020003000c8e964020102cf9c274b701a950fe1e8") << true
+            << QBluetoothUuid(QStringLiteral("{e8e10f95-1a70-4b27-9ccf-02010264e9c8}"));
+    // servers omit 128 bit UUIDs, which are read from the included service later
+    QTest::newRow("omitted uuid") << QByteArray::fromHex("140020003000") << true
+                                  << QBluetoothUuid();
+    QTest::newRow("truncated handles") << QByteArray::fromHex("1400200030") << false
+                                       << QBluetoothUuid();
+    QTest::newRow("partial uuid") << QByteArray::fromHex("1400200030000f") << false
+                                  << QBluetoothUuid();
+    QTest::newRow("empty") << QByteArray() << false << QBluetoothUuid();
+}
+
+void tst_QLowEnergyAttPdu::includeDeclaration()
+{
+    QFETCH(QByteArray, element);
+    QFETCH(bool, valid);
+    QFETCH(QBluetoothUuid, uuid);
+
+    QBluezAtt::IncludeDeclaration declaration;
+    QCOMPARE(QBluezAtt::parseIncludeDeclaration(element, &declaration), valid);
+    if (!valid)
+        return;
+    QCOMPARE(declaration.declarationHandle, quint16(0x0014));
+    QCOMPARE(declaration.startingHandle, quint16(0x0020));
+    QCOMPARE(declaration.endingHandle, quint16(0x0030));
+    QCOMPARE(declaration.uuid, uuid);
+
+    // include declarations come as elements of read by type responses
+    const QByteArray pdu = QByteArray(1, char(AttCommand::ATT_OP_READ_BY_TYPE_RESPONSE))
+            + char(element.size()) + element + element;
+    const QBluezAtt::AttributeDataList list(pdu);
+    QCOMPARE(list.size(), qsizetype(2));
+    for (const QByteArrayView listElement : list) {
+        QVERIFY(QBluezAtt::parseIncludeDeclaration(listElement, &declaration));
+        QCOMPARE(declaration.uuid, uuid);
+    }
+}
+
+void tst_QLowEnergyAttPdu::groupData()
+{
+    QBluezAtt::GroupData group;
+    QVERIFY(QBluezAtt::parseGroupData(QByteArray::fromHex("010005000018"), &group));
+    QCOMPARE(group.startingHandle, quint16(0x0001));
+    QCOMPARE(group.endingHandle, quint16(0x0005));
+    QCOMPARE(QBluezAtt::uuidFromData(group.value), QBluetoothUuid(quint16(0x1800)));
+    QVERIFY(!QBluezAtt::parseGroupData(QByteArray::fromHex("010005"), &group));
+}
+
+QTEST_MAIN(tst_QLowEnergyAttPdu)
+
+#include "tst_qlowenergyattpdu.moc"
@@ -12,6 +12,7 @@
 #include <QtBluetooth/qlowenergycharacteristicdata.h>
 #include <QtBluetooth/qlowenergydescriptordata.h>
 #include <QtBluetooth/qlowenergyservicedata.h>
+#include <QtBluetooth/qlowenergystaticservicedata.h>
 #include <QtCore/qendian.h>
 #include <QtCore/qscopedpointer.h>
 //#include <QtCore/qloggingcategory.h>
@@ -19,6 +20,7 @@
 #include <QtTest/QtTest>
 
 #ifdef Q_OS_LINUX
+#include <QtBluetooth/private/lebondstore_p.h>
 #include <QtBluetooth/private/lecmaccalculator_p.h>
 #endif
 
@@ -37,11 +39,16 @@ private slots:
     // Static, local stuff goes here.
     void advertisingParameters();
     void advertisingData();
+    void bondStoreReplay();
+    void bondStoreTruncatedRecord();
+    void bondStoreCompaction();
+    void bondStoreSharedCompaction();
     void cmacVerifier();
     void cmacVerifier_data();
     void connectionParameters();
     void controllerType();
     void serviceData();
+    void staticServiceData();
 
     // Interaction with actual GATT server goes here. Order is relevant.
     void advertisedData();
@@ -51,10 +58,6 @@ private:
     QBluetoothAddress m_serverAddress;
     QBluetoothDeviceInfo m_serverInfo;
     QScopedPointer<QLowEnergyController> m_leController;
-
-#if defined(CHECK_CMAC_SUPPORT)
-    bool checkCmacSupport(const quint128& csrkMsb);
-#endif
 };
 
 
@@ -77,6 +80,10 @@ void TestQLowEnergyControllerGattServer::advertisingParameters()
     QCOMPARE(params.maximumInterval(), 1280);
     QCOMPARE(params.mode(), QLowEnergyAdvertisingParameters::AdvInd);
     QVERIFY(params.whiteList().isEmpty());
+    QCOMPARE(params.isExtendedAdvertisingEnabled(), false);
+    QCOMPARE(params.secondaryPhy(), QLowEnergyController::Phy::Le1M);
+    QCOMPARE(params.periodicMinimumInterval(), 0);
+    QCOMPARE(params.periodicMaximumInterval(), 0);
 
     params.setInterval(100, 200);
     QCOMPARE(params.minimumInterval(), 100);
@@ -96,6 +103,25 @@ void TestQLowEnergyControllerGattServer::advertisingParameters()
     QCOMPARE(params.filterPolicy(), QLowEnergyAdvertisingParameters::UseWhiteListForConnecting);
     QVERIFY(params != QLowEnergyAdvertisingParameters());
 
+    QLowEnergyAdvertisingParameters extendedParams;
+    extendedParams.setExtendedAdvertisingEnabled(true);
+    QVERIFY(extendedParams.isExtendedAdvertisingEnabled());
+    QVERIFY(extendedParams != QLowEnergyAdvertisingParameters());
+    extendedParams.setSecondaryPhy(QLowEnergyController::Phy::LeCoded);
+    QCOMPARE(extendedParams.secondaryPhy(), QLowEnergyController::Phy::LeCoded);
+    extendedParams.setExtendedAdvertisingEnabled(false);
+    QVERIFY(extendedParams != QLowEnergyAdvertisingParameters());
+
+    QLowEnergyAdvertisingParameters periodicParams;
+    periodicParams.setPeriodicAdvertisingInterval(100, 50);
+    QCOMPARE(periodicParams.periodicMinimumInterval(), 100);
+    QCOMPARE(periodicParams.periodicMaximumInterval(), 100);
+    QVERIFY(periodicParams != QLowEnergyAdvertisingParameters());
+    periodicParams.setPeriodicAdvertisingInterval(0, 50);
+    QCOMPARE(periodicParams.periodicMinimumInterval(), 0);
+    QCOMPARE(periodicParams.periodicMaximumInterval(), 0);
+    QCOMPARE(periodicParams, QLowEnergyAdvertisingParameters());
+
     // verify default ctor
     QLowEnergyAdvertisingParameters::AddressInfo info;
     QVERIFY(info.address == QBluetoothAddress());
@@ -138,9 +164,148 @@ void TestQLowEnergyControllerGattServer::advertisingData()
     QVERIFY(data != QLowEnergyAdvertisingData());
 }
 
+#if defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
+static LeBondStore::Key bondStoreKey(quint64 device)
+{
+    return LeBondStore::Key{ LeBondStore::RecordType::ClientConfigurations, 0x1122334455ull,
+                             device };
+}
+#endif
+
+void TestQLowEnergyControllerGattServer::bondStoreReplay()
+{
+#if defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.filePath(QStringLiteral("bonds"));
+    {
+        LeBondStore store(filePath);
+        store.setValue(bondStoreKey(1), QByteArray("first"));
+        store.setValue(bondStoreKey(2), QByteArray("second"));
+        store.setValue(bondStoreKey(1), QByteArray("third"));
+        store.setValue(bondStoreKey(2), QByteArray());
+        QCOMPARE(store.value(bondStoreKey(1)), QByteArray("third"));
+        store.waitForWritten();
+    }
+
+    LeBondStore store(filePath);
+    QCOMPARE(store.value(bondStoreKey(1)), QByteArray("third"));
+    QCOMPARE(store.value(bondStoreKey(2)), QByteArray());
+    QCOMPARE(store.value(bondStoreKey(3)), QByteArray());
+    const LeBondStore::Key otherType{ LeBondStore::RecordType::LocalSignCounter,
+                                      bondStoreKey(1).adapter, 1 };
+    QCOMPARE(store.value(otherType), QByteArray());
+#else
+    QSKIP("Bond store test only applicable for developer builds on Linux with BlueZ");
+#endif
+}
+
+void TestQLowEnergyControllerGattServer::bondStoreTruncatedRecord()
+{
+#if defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.filePath(QStringLiteral("bonds"));
+    {
+        LeBondStore store(filePath);
+        store.setValue(bondStoreKey(1), QByteArray("complete"));
+        store.waitForWritten();
+        store.setValue(bondStoreKey(2), QByteArray("cut short"));
+        store.waitForWritten();
+    }
+    QFile file(filePath);
+    const qint64 fullSize = file.size();
+    QVERIFY(file.resize(fullSize - 3));
+
+    {
+        QTest::ignoreMessage(QtWarningMsg,
+                             QRegularExpression(QStringLiteral("truncated tail of bond store")));
+        LeBondStore store(filePath);
+        QCOMPARE(store.value(bondStoreKey(1)), QByteArray("complete"));
+        QCOMPARE(store.value(bondStoreKey(2)), QByteArray());
+
+        // the next change replaces the truncated record
+        store.setValue(bondStoreKey(3), QByteArray("appended"));
+        store.waitForWritten();
+    }
+
+    LeBondStore store(filePath);
+    QCOMPARE(store.value(bondStoreKey(1)), QByteArray("complete"));
+    QCOMPARE(store.value(bondStoreKey(2)), QByteArray());
+    QCOMPARE(store.value(bondStoreKey(3)), QByteArray("appended"));
+#else
+    QSKIP("Bond store test only applicable for developer builds on Linux with BlueZ");
+#endif
+}
+
+void TestQLowEnergyControllerGattServer::bondStoreCompaction()
+{
+#if defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.filePath(QStringLiteral("bonds"));
+    constexpr int changes = 500;
+    {
+        LeBondStore store(filePath);
+        store.setValue(bondStoreKey(1), QByteArray("kept"));
+        for (int i = 0; i < changes; ++i) {
+            QByteArray value(4, Qt::Uninitialized);
+            qToLittleEndian<quint32>(i, value.data());
+            store.setValue(bondStoreKey(2), value);
+            // alternate between appended and batched changes
+            if (i % 3 == 0)
+                store.waitForWritten();
+        }
+        store.waitForWritten();
+    }
+
+    // magic, two live values and at most the slack of outdated records
+    constexpr qint64 recordSize = 1 + 8 + 8 + 2 + 4 + 2;
+    QVERIFY2(QFileInfo(filePath).size() < 8 + 100 * recordSize,
+             QByteArray::number(QFileInfo(filePath).size()).constData());
+
+    LeBondStore store(filePath);
+    QCOMPARE(store.value(bondStoreKey(1)), QByteArray("kept"));
+    const QByteArray last = store.value(bondStoreKey(2));
+    QCOMPARE(last.size(), 4);
+    QCOMPARE(qFromLittleEndian<quint32>(last.constData()), quint32(changes - 1));
+#else
+    QSKIP("Bond store test only applicable for developer builds on Linux with BlueZ");
+#endif
+}
+
+void TestQLowEnergyControllerGattServer::bondStoreSharedCompaction()
+{
+#if defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
+    // two stores on one file stand in for two processes
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filePath = dir.filePath(QStringLiteral("bonds"));
+    LeBondStore first(filePath);
+    LeBondStore second(filePath);
+    first.setValue(bondStoreKey(1), QByteArray("initial"));
+    first.waitForWritten();
+    // loads the journal before the other store appends to it
+    QCOMPARE(second.value(bondStoreKey(1)), QByteArray("initial"));
+
+    first.setValue(bondStoreKey(2), QByteArray("appended"));
+    first.waitForWritten();
+    for (int i = 0; i < 200; ++i)
+        second.setValue(bondStoreKey(3), QByteArray::number(i));
+    second.waitForWritten();
+
+    LeBondStore store(filePath);
+    QCOMPARE(store.value(bondStoreKey(1)), QByteArray("initial"));
+    QCOMPARE(store.value(bondStoreKey(2)), QByteArray("appended"));
+    QCOMPARE(store.value(bondStoreKey(3)), QByteArray("199"));
+#else
+    QSKIP("Bond store test only applicable for developer builds on Linux with BlueZ");
+#endif
+}
+
 void TestQLowEnergyControllerGattServer::cmacVerifier()
 {
-#if defined(CONFIG_LINUX_CRYPTO_API) && defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
+#if defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
     // Test data comes from spec v4.2, Vol 3, Part H, Appendix D.1
     const quint128 csrk = {
         { 0x3c, 0x4f, 0xcf, 0x09, 0x88, 0x15, 0xf7, 0xab,
@@ -149,57 +314,23 @@ void TestQLowEnergyControllerGattServer::cmacVerifier()
     QFETCH(QByteArray, message);
     QFETCH(quint64, expectedMac);
 
-#if defined(CHECK_CMAC_SUPPORT)
-    if (!checkCmacSupport(csrk)) {
-        QSKIP("Needed socket options not available. Running qemu?");
+    const LeCmacCalculator calculator;
+    QVERIFY(calculator.verify(message, csrk, expectedMac));
+    // repeated use of the same key
+    QCOMPARE(calculator.calculateMac(message, csrk), expectedMac);
+
+    // the last four bytes of the message as sign counter
+    if (message.size() >= 4) {
+        const quint32 signCounter = qFromLittleEndian<quint32>(message.constData()
+                                                               + message.size() - 4);
+        QVERIFY(calculator.verify(QByteArrayView(message).chopped(4), signCounter, csrk,
+                                  expectedMac));
     }
-#endif
-
-    const bool success = LeCmacCalculator().verify(message, csrk, expectedMac);
-    QVERIFY(success);
-#else // CONFIG_LINUX_CRYPTO_API
+#else
     QSKIP("CMAC verification test only applicable for developer builds on Linux "
-          "with BlueZ and crypto API");
-#endif // Q_OS_LINUX
-}
-
-#if defined(CHECK_CMAC_SUPPORT)
-#include <sys/socket.h>
-#include <linux/if_alg.h>
-#include <unistd.h>
-
-bool TestQLowEnergyControllerGattServer::checkCmacSupport(const quint128& csrk)
-{
-    bool retval = false;
-#if defined(CONFIG_LINUX_CRYPTO_API) && defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
-    quint128 csrkMsb;
-    std::reverse_copy(std::begin(csrk.data), std::end(csrk.data), std::begin(csrkMsb.data));
-
-    int testSocket = socket(AF_ALG, SOCK_SEQPACKET, 0);
-    if (testSocket != -1) {
-        sockaddr_alg sa;
-        using namespace std;
-        memset(&sa, 0, sizeof sa);
-        sa.salg_family = AF_ALG;
-        strcpy(reinterpret_cast<char *>(sa.salg_type), "hash");
-        strcpy(reinterpret_cast<char *>(sa.salg_name), "cmac(aes)");
-        if (::bind(testSocket, reinterpret_cast<sockaddr *>(&sa), sizeof sa) != -1) {
-            if (setsockopt(testSocket, 279 /* SOL_ALG */, ALG_SET_KEY, csrkMsb.data, sizeof csrkMsb) != -1) {
-                 retval = true;
-            } else {
-                 qWarning("Needed socket options (SOL_ALG) not available");
-            }
-        } else {
-            qWarning("bind() failed for crypto socket:");
-        }
-        close(testSocket);
-    } else {
-         qWarning("Unable to create test socket");
-    }
+          "with BlueZ");
 #endif
-    return retval;
 }
-#endif
 
 void TestQLowEnergyControllerGattServer::cmacVerifier_data()
 {
@@ -601,6 +732,15 @@ void TestQLowEnergyControllerGattServer::serviceData()
     QCOMPARE(charData.descriptors(),
              QList<QLowEnergyDescriptorData>() << descData << descData2 << descData3);
 
+    QLowEnergyCharacteristicData movedCharData = charData;
+    QList<QLowEnergyDescriptorData> movedDescriptors{ descData3, QLowEnergyDescriptorData() };
+    movedCharData.setDescriptors(std::move(movedDescriptors));
+    QCOMPARE(movedCharData.descriptors(), QList<QLowEnergyDescriptorData>() << descData3);
+    movedCharData.addDescriptor(QLowEnergyDescriptorData(descData2.uuid(), QByteArray("abc")));
+    QCOMPARE(movedCharData.descriptors(),
+             QList<QLowEnergyDescriptorData>() << descData3 << descData2);
+    QCOMPARE(charData.descriptors().size(), 3);
+
     QLowEnergyServiceData secondaryData;
     QVERIFY(!secondaryData.isValid());
 
@@ -665,6 +805,68 @@ void TestQLowEnergyControllerGattServer::serviceData()
     QCOMPARE(includedServices.first(), secondaryService->serviceUuid());
 }
 
+static constexpr char staticBatteryLevel[] = { 42 };
+static constexpr QLowEnergyStaticDescriptorData staticBatteryDescriptors[] = {
+    { QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration,
+      QByteArrayView("\x00\x00", 2), true, true },
+    { QBluetoothUuid::DescriptorType::CharacteristicUserDescription,
+      QByteArrayView("Battery") },
+};
+static constexpr QLowEnergyStaticCharacteristicData staticBatteryCharacteristics[] = {
+    { QBluetoothUuid::CharacteristicType::BatteryLevel,
+      QLowEnergyCharacteristic::Read | QLowEnergyCharacteristic::Notify,
+      QByteArrayView(staticBatteryLevel, sizeof(staticBatteryLevel)),
+      staticBatteryDescriptors, 1, 1 },
+};
+static constexpr QLowEnergyStaticServiceData staticBatteryService = {
+    QLowEnergyServiceData::ServiceTypePrimary,
+    QBluetoothUuid::ServiceClassUuid::BatteryService,
+    staticBatteryCharacteristics
+};
+
+void TestQLowEnergyControllerGattServer::staticServiceData()
+{
+    static_assert(staticBatteryService.attributeCount() == 5);
+    QVERIFY(staticBatteryService.isValid());
+    QVERIFY(!QLowEnergyStaticServiceData().isValid());
+
+    const QLowEnergyServiceData serviceData = staticBatteryService.toServiceData();
+    QCOMPARE(serviceData.type(), QLowEnergyServiceData::ServiceTypePrimary);
+    QCOMPARE(serviceData.uuid(),
+             QBluetoothUuid(QBluetoothUuid::ServiceClassUuid::BatteryService));
+    QCOMPARE(serviceData.characteristics().size(), 1);
+    const QLowEnergyCharacteristicData charData = serviceData.characteristics().first();
+    QCOMPARE(charData.uuid(), QBluetoothUuid(QBluetoothUuid::CharacteristicType::BatteryLevel));
+    QCOMPARE(charData.properties(),
+             QLowEnergyCharacteristic::Read | QLowEnergyCharacteristic::Notify);
+    QCOMPARE(charData.value(), QByteArray(1, 42));
+    QCOMPARE(charData.minimumValueLength(), 1);
+    QCOMPARE(charData.maximumValueLength(), 1);
+    QCOMPARE(charData.descriptors().size(), 2);
+    const QLowEnergyDescriptorData cccData = charData.descriptors().first();
+    QCOMPARE(cccData.value(), QByteArray(2, 0));
+    QVERIFY(cccData.isReadable());
+    QVERIFY(cccData.isWritable());
+    const QLowEnergyDescriptorData descriptionData = charData.descriptors().last();
+    QCOMPARE(descriptionData.value(), QByteArray("Battery"));
+    QVERIFY(descriptionData.isReadable());
+    QVERIFY(!descriptionData.isWritable());
+
+#ifdef Q_OS_DARWIN
+    QSKIP("GATT server functionality not implemented for Apple platforms");
+#endif
+    const QScopedPointer<QLowEnergyController> controller(QLowEnergyController::createPeripheral());
+    QVERIFY(!controller->addService(QLowEnergyStaticServiceData()));
+    const QScopedPointer<QLowEnergyService> service(controller->addService(staticBatteryService));
+    QVERIFY(!service.isNull());
+    QCOMPARE(service->serviceUuid(), staticBatteryService.uuid);
+    const QList<QLowEnergyCharacteristic> characteristics = service->characteristics();
+    QCOMPARE(characteristics.size(), 1);
+    QCOMPARE(characteristics.first().uuid(), charData.uuid());
+    QCOMPARE(characteristics.first().value(), charData.value());
+    QCOMPARE(characteristics.first().descriptors().size(), 2);
+}
+
 QTEST_MAIN(TestQLowEnergyControllerGattServer)
 
 #include "tst_qlowenergycontroller-gattserver.moc"
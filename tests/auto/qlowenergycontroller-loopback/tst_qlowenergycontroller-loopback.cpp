@@ -0,0 +1,1104 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtBluetooth/qbluetoothdeviceinfo.h>
+#include <QtBluetooth/qlowenergyadvertisingdata.h>
+#include <QtBluetooth/qlowenergyadvertisingparameters.h>
+#include <QtBluetooth/qlowenergycharacteristicdata.h>
+#include <QtBluetooth/qlowenergycontroller.h>
+#include <QtBluetooth/qlowenergydescriptordata.h>
+#include <QtBluetooth/qlowenergyservicedata.h>
+#include <QtCore/qscopedpointer.h>
+#include <QtCore/qscopeguard.h>
+#include <QtCore/qthread.h>
+#include <QtTest/qsignalspy.h>
+#include <QtTest/QtTest>
+
+static const QBluetoothUuid serviceUuid(QStringLiteral("{6f9e0001-3c8b-4d7a-9b6e-2f1a5c4d3e2b}"));
+static const QBluetoothUuid valueUuid(QStringLiteral("{6f9e0002-3c8b-4d7a-9b6e-2f1a5c4d3e2b}"));
+static const QBluetoothUuid commandUuid(QStringLiteral("{6f9e0003-3c8b-4d7a-9b6e-2f1a5c4d3e2b}"));
+static const QBluetoothUuid batchServiceUuid(
+        QStringLiteral("{6f9e0010-3c8b-4d7a-9b6e-2f1a5c4d3e2b}"));
+static const QBluetoothUuid firstUuid(QStringLiteral("{6f9e0011-3c8b-4d7a-9b6e-2f1a5c4d3e2b}"));
+static const QBluetoothUuid secondUuid(QStringLiteral("{6f9e0012-3c8b-4d7a-9b6e-2f1a5c4d3e2b}"));
+static const QBluetoothUuid secretUuid(QStringLiteral("{6f9e0013-3c8b-4d7a-9b6e-2f1a5c4d3e2b}"));
+static const QBluetoothUuid shortUuid(QStringLiteral("{6f9e0014-3c8b-4d7a-9b6e-2f1a5c4d3e2b}"));
+static const QBluetoothUuid indicatedServiceUuid(
+        QStringLiteral("{6f9e0020-3c8b-4d7a-9b6e-2f1a5c4d3e2b}"));
+static const QBluetoothUuid indicatedUuid(
+        QStringLiteral("{6f9e0021-3c8b-4d7a-9b6e-2f1a5c4d3e2b}"));
+
+class tst_QLowEnergyControllerLoopback : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void connection();
+    void unknownDevice();
+    void gattOperations();
+    void partialDiscovery();
+    void cancelPendingReads();
+    void notifications();
+    void peripheralDisconnect();
+    void workerThread();
+    void congestion();
+    void notificationBatches();
+    void phyAndDataLength();
+    void linkStatistics();
+    void readCharacteristics();
+    void writeCharacteristics();
+    void reliableWrites();
+    void publishCharacteristicValue();
+    void notifiedValueCaching();
+    void periodicAdvertisingData();
+    void lowLatencyNotificationHandler();
+    void autoConnect();
+
+private:
+    void connectCentral();
+    QLowEnergyService *discoverService(const QBluetoothUuid &uuid = serviceUuid);
+    QLowEnergyService *addBatchService();
+    bool enableNotifications(QLowEnergyService *service);
+
+    QScopedPointer<QLowEnergyController> m_peripheral;
+    QScopedPointer<QLowEnergyService> m_localService;
+    QScopedPointer<QLowEnergyController> m_central;
+};
+
+void tst_QLowEnergyControllerLoopback::initTestCase()
+{
+    qputenv("QT_BLUETOOTH_LOOPBACK", "1");
+}
+
+static QLowEnergyServiceData peripheralServiceData()
+{
+    QLowEnergyCharacteristicData valueData;
+    valueData.setUuid(valueUuid);
+    valueData.setProperties(QLowEnergyCharacteristic::Read | QLowEnergyCharacteristic::Write
+                            | QLowEnergyCharacteristic::Notify);
+    valueData.setValue(QByteArray("initial"));
+    valueData.addDescriptor(QLowEnergyDescriptorData(
+            QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration,
+            QByteArray(2, 0)));
+
+    QLowEnergyCharacteristicData commandData;
+    commandData.setUuid(commandUuid);
+    commandData.setProperties(QLowEnergyCharacteristic::WriteNoResponse);
+
+    QLowEnergyServiceData serviceData;
+    serviceData.setType(QLowEnergyServiceData::ServiceTypePrimary);
+    serviceData.setUuid(serviceUuid);
+    serviceData.addCharacteristic(valueData);
+    serviceData.addCharacteristic(commandData);
+    return serviceData;
+}
+
+void tst_QLowEnergyControllerLoopback::init()
+{
+    m_peripheral.reset(QLowEnergyController::createPeripheral());
+    m_localService.reset(m_peripheral->addService(peripheralServiceData()));
+    QVERIFY(m_localService);
+
+    m_peripheral->startAdvertising(QLowEnergyAdvertisingParameters(),
+                                   QLowEnergyAdvertisingData());
+    QCOMPARE(m_peripheral->state(), QLowEnergyController::AdvertisingState);
+
+    const QBluetoothDeviceInfo info(m_peripheral->localAddress(), QStringLiteral("loopback"), 0);
+    m_central.reset(QLowEnergyController::createCentral(info));
+}
+
+void tst_QLowEnergyControllerLoopback::cleanup()
+{
+    m_central.reset();
+    m_localService.reset();
+    m_peripheral.reset();
+}
+
+void tst_QLowEnergyControllerLoopback::connectCentral()
+{
+    m_central->connectToDevice();
+    QTRY_COMPARE(m_central->state(), QLowEnergyController::ConnectedState);
+}
+
+QLowEnergyService *tst_QLowEnergyControllerLoopback::discoverService(const QBluetoothUuid &uuid)
+{
+    m_central->discoverServices();
+    if (!QTest::qWaitFor([this]() {
+            return m_central->state() == QLowEnergyController::DiscoveredState; })) {
+        return nullptr;
+    }
+
+    QLowEnergyService *service = m_central->createServiceObject(uuid, m_central.data());
+    if (!service)
+        return nullptr;
+    service->discoverDetails();
+    if (!QTest::qWaitFor([service]() {
+            return service->state() == QLowEnergyService::RemoteServiceDiscovered; })) {
+        return nullptr;
+    }
+    return service;
+}
+
+bool tst_QLowEnergyControllerLoopback::enableNotifications(QLowEnergyService *service)
+{
+    const QLowEnergyDescriptor configuration =
+            service->characteristic(valueUuid).clientCharacteristicConfiguration();
+    QSignalSpy descriptorWritten(service, &QLowEnergyService::descriptorWritten);
+    service->writeDescriptor(configuration, QLowEnergyCharacteristic::CCCDEnableNotification);
+    return QTest::qWaitFor([&descriptorWritten]() { return descriptorWritten.size() == 1; });
+}
+
+/*
+    Adds a service with the characteristics "first" and "second", which can be
+    read and written, "secret", which can only be written without response, and
+    "short", which takes at most four bytes, and returns the local service object.
+*/
+QLowEnergyService *tst_QLowEnergyControllerLoopback::addBatchService()
+{
+    const auto characteristicData = [](const QBluetoothUuid &uuid,
+                                       QLowEnergyCharacteristic::PropertyTypes properties,
+                                       const QByteArray &value) {
+        QLowEnergyCharacteristicData data;
+        data.setUuid(uuid);
+        data.setProperties(properties);
+        data.setValue(value);
+        return data;
+    };
+    const auto readWrite = QLowEnergyCharacteristic::Read | QLowEnergyCharacteristic::Write;
+
+    QLowEnergyServiceData serviceData;
+    serviceData.setType(QLowEnergyServiceData::ServiceTypePrimary);
+    serviceData.setUuid(batchServiceUuid);
+    serviceData.addCharacteristic(characteristicData(firstUuid, readWrite, "first"));
+    serviceData.addCharacteristic(characteristicData(secondUuid, readWrite, "second"));
+    serviceData.addCharacteristic(characteristicData(
+            secretUuid, QLowEnergyCharacteristic::WriteNoResponse, "secret"));
+    QLowEnergyCharacteristicData shortData = characteristicData(shortUuid, readWrite, "ab");
+    shortData.setValueLength(0, 4);
+    serviceData.addCharacteristic(shortData);
+
+    // services can only be added while the peripheral does not advertise
+    m_peripheral->stopAdvertising();
+    QLowEnergyService *service = m_peripheral->addService(serviceData);
+    m_peripheral->startAdvertising(QLowEnergyAdvertisingParameters(),
+                                   QLowEnergyAdvertisingData());
+    return service;
+}
+
+void tst_QLowEnergyControllerLoopback::connection()
+{
+    QSignalSpy centralConnected(m_central.data(), &QLowEnergyController::connected);
+    QSignalSpy peripheralConnected(m_peripheral.data(), &QLowEnergyController::connected);
+
+    connectCentral();
+    QCOMPARE(centralConnected.size(), 1);
+    QCOMPARE(peripheralConnected.size(), 1);
+    QCOMPARE(m_peripheral->state(), QLowEnergyController::ConnectedState);
+    QCOMPARE(m_peripheral->remoteAddress(), m_central->localAddress());
+    QCOMPARE(m_central->mtu(), m_peripheral->mtu());
+
+    QSignalSpy centralDisconnected(m_central.data(), &QLowEnergyController::disconnected);
+    QSignalSpy peripheralDisconnected(m_peripheral.data(), &QLowEnergyController::disconnected);
+    m_central->disconnectFromDevice();
+    QCOMPARE(centralDisconnected.size(), 1);
+    QCOMPARE(peripheralDisconnected.size(), 1);
+    QCOMPARE(m_central->state(), QLowEnergyController::UnconnectedState);
+    QCOMPARE(m_peripheral->state(), QLowEnergyController::UnconnectedState);
+    QCOMPARE(m_peripheral->error(), QLowEnergyController::NoError);
+}
+
+void tst_QLowEnergyControllerLoopback::unknownDevice()
+{
+    const QBluetoothDeviceInfo info(QBluetoothAddress(quint64(0x112233445566)),
+                                    QStringLiteral("unknown"), 0);
+    QScopedPointer<QLowEnergyController> central(QLowEnergyController::createCentral(info));
+    central->connectToDevice();
+    QCOMPARE(central->error(), QLowEnergyController::UnknownRemoteDeviceError);
+    QCOMPARE(central->state(), QLowEnergyController::UnconnectedState);
+}
+
+void tst_QLowEnergyControllerLoopback::gattOperations()
+{
+    connectCentral();
+    QLowEnergyService *service = discoverService();
+    QVERIFY(service);
+    QCOMPARE(m_central->services(), QList<QBluetoothUuid>() << serviceUuid);
+
+    const QLowEnergyCharacteristic value = service->characteristic(valueUuid);
+    QVERIFY(value.isValid());
+    QCOMPARE(value.value(), QByteArray("initial"));
+    const QLowEnergyCharacteristic command = service->characteristic(commandUuid);
+    QVERIFY(command.isValid());
+
+    QSignalSpy localChanged(m_localService.data(), &QLowEnergyService::characteristicChanged);
+    QSignalSpy written(service, &QLowEnergyService::characteristicWritten);
+    service->writeCharacteristic(value, QByteArray("written"));
+    QTRY_COMPARE(written.size(), 1);
+    QCOMPARE(localChanged.size(), 1);
+    QCOMPARE(m_localService->characteristic(valueUuid).value(), QByteArray("written"));
+
+    // write commands are not confirmed
+    service->writeCharacteristic(command, QByteArray("command"),
+                                 QLowEnergyService::WriteWithoutResponse);
+    QTRY_COMPARE(localChanged.size(), 2);
+    QCOMPARE(written.size(), 1);
+
+    // the peripheral changes the value, the central reads it
+    m_localService->writeCharacteristic(m_localService->characteristic(valueUuid),
+                                        QByteArray("updated"));
+    QSignalSpy read(service, &QLowEnergyService::characteristicRead);
+    service->readCharacteristic(value);
+    QTRY_COMPARE(read.size(), 1);
+    QCOMPARE(read.at(0).at(1).toByteArray(), QByteArray("updated"));
+
+    // the characteristic does not permit this
+    QSignalSpy errors(service, &QLowEnergyService::errorOccurred);
+    service->writeCharacteristic(command, QByteArray("request"));
+    QTRY_COMPARE(errors.size(), 1);
+    QCOMPARE(errors.at(0).at(0).value<QLowEnergyService::ServiceError>(),
+             QLowEnergyService::CharacteristicWriteError);
+}
+
+void tst_QLowEnergyControllerLoopback::partialDiscovery()
+{
+    connectCentral();
+    m_central->discoverServices();
+    QTRY_COMPARE(m_central->state(), QLowEnergyController::DiscoveredState);
+
+    QLowEnergyService *service = m_central->createServiceObject(uuid, m_central.data());
+    QVERIFY(service);
+    service->discoverDetails(QLowEnergyService::DescriptorDiscovery
+                                     | QLowEnergyService::CharacteristicValueDiscovery,
+                             { valueUuid });
+    QTRY_COMPARE(service->state(), QLowEnergyService::RemoteServiceDiscovered);
+
+    // all declarations are known, only the selected attributes are fetched
+    QCOMPARE(service->characteristics().size(), 2);
+    const QLowEnergyCharacteristic value = service->characteristic(valueUuid);
+    QCOMPARE(value.value(), QByteArray("initial"));
+    const QLowEnergyDescriptor configuration = value.clientCharacteristicConfiguration();
+    QVERIFY(configuration.isValid());
+    QVERIFY(configuration.value().isEmpty());
+    QVERIFY(service->characteristic(commandUuid).isValid());
+}
+
+void tst_QLowEnergyControllerLoopback::cancelPendingReads()
+{
+    connectCentral();
+    m_central->discoverServices();
+    QTRY_COMPARE(m_central->state(), QLowEnergyController::DiscoveredState);
+
+    QLowEnergyService *service = m_central->createServiceObject(uuid, m_central.data());
+    QVERIFY(service);
+
+    // an aborted discovery may be started again
+    service->discoverDetails();
+    QCOMPARE(service->state(), QLowEnergyService::RemoteServiceDiscovering);
+    service->cancelPendingReads();
+    QCOMPARE(service->state(), QLowEnergyService::RemoteService);
+    QTest::qWait(50);
+    QCOMPARE(service->state(), QLowEnergyService::RemoteService);
+    QVERIFY(service->characteristics().isEmpty());
+    service->discoverDetails();
+    QTRY_COMPARE(service->state(), QLowEnergyService::RemoteServiceDiscovered);
+
+    // the reads are dropped, the write is still sent
+    const QLowEnergyCharacteristic value = service->characteristic(valueUuid);
+    QSignalSpy read(service, &QLowEnergyService::characteristicRead);
+    QSignalSpy written(service, &QLowEnergyService::characteristicWritten);
+    service->readCharacteristic(value);
+    QFuture<QByteArray> future = service->readCharacteristicAsync(value);
+    service->writeCharacteristic(value, QByteArray("written"));
+    service->readCharacteristic(value);
+    service->cancelPendingReads();
+    QVERIFY(future.isCanceled());
+    QTRY_COMPARE(written.size(), 1);
+    QTest::qWait(50);
+    QCOMPARE(read.size(), 0);
+    QCOMPARE(m_localService->characteristic(valueUuid).value(), QByteArray("written"));
+
+    // reads of a service nobody holds anymore are dropped as well
+    service->readCharacteristic(value);
+    delete service;
+    service = m_central->createServiceObject(serviceUuid, m_central.data());
+    QVERIFY(service);
+    QSignalSpy lateRead(service, &QLowEnergyService::characteristicRead);
+    QTest::qWait(50);
+    QCOMPARE(lateRead.size(), 0);
+    QCOMPARE(service->state(), QLowEnergyService::RemoteServiceDiscovered);
+}
+
+void tst_QLowEnergyControllerLoopback::notifications()
+{
+    connectCentral();
+    QLowEnergyService *service = discoverService();
+    QVERIFY(service);
+
+    const QLowEnergyCharacteristic value = service->characteristic(valueUuid);
+    QSignalSpy changed(service, &QLowEnergyService::characteristicChanged);
+
+    // not enabled yet
+    m_localService->writeCharacteristic(m_localService->characteristic(valueUuid),
+                                        QByteArray("first"));
+    QTest::qWait(50);
+    QCOMPARE(changed.size(), 0);
+
+    const QLowEnergyDescriptor configuration = value.clientCharacteristicConfiguration();
+    QVERIFY(configuration.isValid());
+    QSignalSpy descriptorWritten(service, &QLowEnergyService::descriptorWritten);
+    service->writeDescriptor(configuration, QLowEnergyCharacteristic::CCCDEnableNotification);
+    QTRY_COMPARE(descriptorWritten.size(), 1);
+
+    m_localService->writeCharacteristic(m_localService->characteristic(valueUuid),
+                                        QByteArray("second"));
+    QTRY_COMPARE(changed.size(), 1);
+    QCOMPARE(changed.at(0).at(1).toByteArray(), QByteArray("second"));
+    QCOMPARE(service->characteristic(valueUuid).value(), QByteArray("second"));
+}
+
+void tst_QLowEnergyControllerLoopback::peripheralDisconnect()
+{
+    connectCentral();
+
+    QSignalSpy centralDisconnected(m_central.data(), &QLowEnergyController::disconnected);
+    m_peripheral->disconnectFromDevice();
+    QCOMPARE(centralDisconnected.size(), 1);
+    QCOMPARE(m_central->state(), QLowEnergyController::UnconnectedState);
+    QCOMPARE(m_central->error(), QLowEnergyController::RemoteHostClosedError);
+}
+
+void tst_QLowEnergyControllerLoopback::workerThread()
+{
+    // the controllers are moved right after their creation
+    cleanup();
+
+    QThread worker;
+    worker.start();
+    QThread *testThread = QThread::currentThread();
+    QObject workerContext;
+    workerContext.moveToThread(&worker);
+    const auto runOnWorker = [&workerContext](auto function) {
+        QMetaObject::invokeMethod(&workerContext, function, Qt::BlockingQueuedConnection);
+    };
+    // the controllers are deleted in their own thread
+    const auto stopWorker = qScopeGuard([&]() {
+        runOnWorker([this]() { cleanup(); });
+        worker.quit();
+        worker.wait();
+    });
+
+    m_peripheral.reset(QLowEnergyController::createPeripheral());
+    m_peripheral->moveToThread(&worker);
+    runOnWorker([this]() {
+        m_localService.reset(m_peripheral->addService(peripheralServiceData()));
+        m_peripheral->startAdvertising(QLowEnergyAdvertisingParameters(),
+                                       QLowEnergyAdvertisingData());
+    });
+    QVERIFY(m_localService);
+
+    const QBluetoothDeviceInfo info(m_peripheral->localAddress(), QStringLiteral("loopback"), 0);
+    m_central.reset(QLowEnergyController::createCentral(info));
+    m_central->moveToThread(&worker);
+    const QList<QObject *> internals = m_central->findChildren<QObject *>();
+    QVERIFY(!internals.isEmpty());
+    for (const QObject *object : internals)
+        QCOMPARE(object->thread(), &worker);
+
+    // receives the signals in the test thread
+    QObject receiver;
+    QLowEnergyController::ControllerState state = QLowEnergyController::UnconnectedState;
+    connect(m_central.data(), &QLowEnergyController::stateChanged, &receiver,
+            [&state](QLowEnergyController::ControllerState newState) { state = newState; });
+    runOnWorker([this]() { m_central->connectToDevice(); });
+    QTRY_COMPARE(state, QLowEnergyController::ConnectedState);
+    runOnWorker([this]() { m_central->discoverServices(); });
+    QTRY_COMPARE(state, QLowEnergyController::DiscoveredState);
+
+    QLowEnergyService *service = nullptr;
+    runOnWorker([this, &service, testThread]() {
+        service = m_central->createServiceObject(serviceUuid);
+        if (service)
+            service->moveToThread(testThread);
+    });
+    QVERIFY(service);
+    QScopedPointer<QLowEnergyService> serviceGuard(service);
+
+    QLowEnergyService::ServiceState serviceState = QLowEnergyService::RemoteService;
+    int descriptorsWritten = 0;
+    QByteArrayList changes;
+    connect(service, &QLowEnergyService::stateChanged, &receiver,
+            [&serviceState](QLowEnergyService::ServiceState newState) {
+                serviceState = newState;
+            });
+    connect(service, &QLowEnergyService::descriptorWritten, &receiver,
+            [&descriptorsWritten]() { ++descriptorsWritten; });
+    connect(service, &QLowEnergyService::characteristicChanged, &receiver,
+            [&changes, testThread](const QLowEnergyCharacteristic &, const QByteArray &newValue) {
+                QCOMPARE(QThread::currentThread(), testThread);
+                changes.append(newValue);
+            });
+
+    runOnWorker([service]() { service->discoverDetails(); });
+    QTRY_COMPARE(serviceState, QLowEnergyService::RemoteServiceDiscovered);
+    runOnWorker([service]() {
+        const QLowEnergyCharacteristic value = service->characteristic(valueUuid);
+        service->writeDescriptor(value.clientCharacteristicConfiguration(),
+                                 QLowEnergyCharacteristic::CCCDEnableNotification);
+    });
+    QTRY_COMPARE(descriptorsWritten, 1);
+
+    runOnWorker([this]() {
+        m_localService->writeCharacteristic(m_localService->characteristic(valueUuid),
+                                            QByteArray("threaded"));
+    });
+    QTRY_COMPARE(changes, QByteArrayList() << QByteArray("threaded"));
+
+    runOnWorker([this]() { m_central->disconnectFromDevice(); });
+    QTRY_COMPARE(state, QLowEnergyController::UnconnectedState);
+}
+
+void tst_QLowEnergyControllerLoopback::congestion()
+{
+    // the controllers take the limit when they are created
+    qputenv("QT_BLUETOOTH_SEND_QUEUE_HIGH_WATER_MARK", "4");
+    const auto resetLimit = qScopeGuard([]() {
+        qunsetenv("QT_BLUETOOTH_SEND_QUEUE_HIGH_WATER_MARK");
+    });
+    cleanup();
+    init();
+
+    connectCentral();
+    QLowEnergyService *service = discoverService();
+    QVERIFY(service);
+    const QLowEnergyCharacteristic command = service->characteristic(commandUuid);
+
+    QSignalSpy congestion(m_central.data(), &QLowEnergyController::congestionChanged);
+    QSignalSpy localChanged(m_localService.data(), &QLowEnergyService::characteristicChanged);
+    for (int i = 0; i < 8; ++i) {
+        service->writeCharacteristic(command, QByteArray::number(i),
+                                     QLowEnergyService::WriteWithoutResponse);
+    }
+    QCOMPARE(congestion.size(), 1);
+    QCOMPARE(congestion.at(0).at(0).toBool(), true);
+
+    // nothing is dropped while the queue drains
+    QTRY_COMPARE(localChanged.size(), 8);
+    QCOMPARE(congestion.size(), 2);
+    QCOMPARE(congestion.at(1).at(0).toBool(), false);
+    QCOMPARE(m_localService->characteristic(commandUuid).value(), QByteArray("7"));
+}
+
+void tst_QLowEnergyControllerLoopback::notificationBatches()
+{
+    connectCentral();
+    QLowEnergyService *service = discoverService();
+    QVERIFY(service);
+    QVERIFY(enableNotifications(service));
+    QCOMPARE(service->notificationBatchInterval(), -1);
+
+    const QLowEnergyCharacteristic localValue = m_localService->characteristic(valueUuid);
+    QSignalSpy changed(service, &QLowEnergyService::characteristicChanged);
+    QSignalSpy batches(service, &QLowEnergyService::characteristicsChanged);
+    const auto batchedValues = [&batches]() {
+        QByteArrayList values;
+        for (const QList<QVariant> &arguments : std::as_const(batches))
+            values += arguments.at(1).value<QByteArrayList>();
+        return values;
+    };
+
+    // the changes within the interval arrive as one batch, in order
+    service->setNotificationBatchInterval(500);
+    QCOMPARE(service->notificationBatchInterval(), 500);
+    for (const char *value : { "one", "two", "three" })
+        m_localService->writeCharacteristic(localValue, QByteArray(value));
+    QTRY_COMPARE(batches.size(), 1);
+    QCOMPARE(batchedValues(), QByteArrayList({ "one", "two", "three" }));
+    const auto characteristics = batches.at(0).at(0).value<QList<QLowEnergyCharacteristic>>();
+    QCOMPARE(characteristics.size(), 3);
+    for (const QLowEnergyCharacteristic &characteristic : characteristics)
+        QCOMPARE(characteristic.uuid(), valueUuid);
+    QCOMPARE(service->characteristic(valueUuid).value(), QByteArray("three"));
+
+    // an interval of 0 batches per event loop pass, it still replaces characteristicChanged
+    service->setNotificationBatchInterval(0);
+    for (const char *value : { "four", "five" })
+        m_localService->writeCharacteristic(localValue, QByteArray(value));
+    QTRY_COMPARE(batchedValues().size(), 5);
+    QCOMPARE(batchedValues().mid(3), QByteArrayList({ "four", "five" }));
+    QCOMPARE(changed.size(), 0);
+
+    // disabling batching delivers the pending changes right away
+    service->setNotificationBatchInterval(60000);
+    m_localService->writeCharacteristic(localValue, QByteArray("six"));
+    QTRY_COMPARE(service->characteristic(valueUuid).value(), QByteArray("six"));
+    const qsizetype batchCount = batches.size();
+    service->setNotificationBatchInterval(-1);
+    QCOMPARE(batches.size(), batchCount + 1);
+    QCOMPARE(batches.last().at(1).value<QByteArrayList>(), QByteArrayList({ "six" }));
+
+    // without batching every notification is reported on its own
+    m_localService->writeCharacteristic(localValue, QByteArray("seven"));
+    QTRY_COMPARE(changed.size(), 1);
+    QCOMPARE(changed.at(0).at(1).toByteArray(), QByteArray("seven"));
+    QCOMPARE(batches.size(), batchCount + 1);
+}
+
+void tst_QLowEnergyControllerLoopback::phyAndDataLength()
+{
+    using Phy = QLowEnergyController::Phy;
+
+    connectCentral();
+    QSignalSpy centralPhy(m_central.data(), &QLowEnergyController::phyChanged);
+    QSignalSpy peripheralPhy(m_peripheral.data(), &QLowEnergyController::phyChanged);
+    QSignalSpy centralDataLength(m_central.data(), &QLowEnergyController::dataLengthChanged);
+    QSignalSpy peripheralDataLength(m_peripheral.data(),
+                                    &QLowEnergyController::dataLengthChanged);
+
+    // the peripheral sees the PHYs the other way around
+    m_central->requestPhy(Phy::Le2M, Phy::LeCoded);
+    QTRY_COMPARE(centralPhy.size(), 1);
+    QCOMPARE(centralPhy.at(0).at(0).value<Phy>(), Phy::Le2M);
+    QCOMPARE(centralPhy.at(0).at(1).value<Phy>(), Phy::LeCoded);
+    QCOMPARE(peripheralPhy.size(), 1);
+    QCOMPARE(peripheralPhy.at(0).at(0).value<Phy>(), Phy::LeCoded);
+    QCOMPARE(peripheralPhy.at(0).at(1).value<Phy>(), Phy::Le2M);
+
+    m_central->requestDataLength(251);
+    QTRY_COMPARE(centralDataLength.size(), 1);
+    QCOMPARE(centralDataLength.at(0), QList<QVariant>({ 251, 27 }));
+    QCOMPARE(peripheralDataLength.size(), 1);
+    QCOMPARE(peripheralDataLength.at(0), QList<QVariant>({ 27, 251 }));
+
+    // nothing changes, nothing is reported
+    m_central->requestPhy(Phy::Le2M, Phy::LeCoded);
+    m_central->requestDataLength(251);
+    QTest::qWait(50);
+    QCOMPARE(centralPhy.size(), 1);
+    QCOMPARE(centralDataLength.size(), 1);
+
+    // the peripheral may start the update as well
+    m_peripheral->requestDataLength(200);
+    QTRY_COMPARE(centralDataLength.size(), 2);
+    QCOMPARE(centralDataLength.at(1), QList<QVariant>({ 251, 200 }));
+}
+
+void tst_QLowEnergyControllerLoopback::linkStatistics()
+{
+    QVERIFY(!m_central->linkStatistics().isValid());
+    QVERIFY(!m_peripheral->linkStatistics().isValid());
+
+    connectCentral();
+    const QLowEnergyLinkStatistics connected = m_central->linkStatistics();
+    QVERIFY(connected.isValid());
+    QCOMPARE(connected.packetsSent(), 0u);
+    QCOMPARE(connected.packetsReceived(), 0u);
+    QCOMPARE(connected.connectionInterval(), 0.0);
+    QVERIFY(m_peripheral->linkStatistics().isValid());
+
+    QLowEnergyService *service = discoverService();
+    QVERIFY(service);
+    QVERIFY(enableNotifications(service));
+
+    // each end sees the traffic of the other one mirrored
+    const QLowEnergyLinkStatistics before = m_central->linkStatistics();
+    QVERIFY(before.packetsSent() > 0);
+    QCOMPARE(before.bytesSent(), 2u); // the client characteristic configuration
+    QCOMPARE(m_peripheral->linkStatistics().packetsReceived(), before.packetsSent());
+    QCOMPARE(m_peripheral->linkStatistics().bytesReceived(), before.bytesSent());
+
+    QSignalSpy written(service, &QLowEnergyService::characteristicWritten);
+    service->writeCharacteristic(service->characteristic(valueUuid), QByteArray("abc"));
+    QTRY_COMPARE(written.size(), 1);
+
+    QSignalSpy changed(service, &QLowEnergyService::characteristicChanged);
+    m_localService->writeCharacteristic(m_localService->characteristic(valueUuid),
+                                        QByteArray("xy"));
+    QTRY_COMPARE(changed.size(), 1);
+
+    const QLowEnergyLinkStatistics central = m_central->linkStatistics();
+    QCOMPARE(central.packetsSent(), before.packetsSent() + 1);
+    QCOMPARE(central.bytesSent(), before.bytesSent() + 3);
+    QCOMPARE(central.completedPackets(), central.packetsSent());
+    QCOMPARE(central.packetsReceived(), 1u);
+    QCOMPARE(central.bytesReceived(), 2u);
+    const QLowEnergyLinkStatistics peripheral = m_peripheral->linkStatistics();
+    QCOMPARE(peripheral.packetsSent(), central.packetsReceived());
+    QCOMPARE(peripheral.bytesSent(), central.bytesReceived());
+    QCOMPARE(peripheral.packetsReceived(), central.packetsSent());
+    QCOMPARE(peripheral.bytesReceived(), central.bytesSent());
+
+    // a snapshot does not follow the link
+    QCOMPARE(before.bytesSent(), 2u);
+
+    QLowEnergyLinkStatistics copy(central);
+    QVERIFY(copy.isValid());
+    QCOMPARE(copy.bytesSent(), central.bytesSent());
+    QCOMPARE(copy.packetsReceived(), central.packetsReceived());
+
+    QLowEnergyLinkStatistics assigned;
+    QVERIFY(!assigned.isValid());
+    assigned = copy;
+    QVERIFY(assigned.isValid());
+    QCOMPARE(assigned.packetsSent(), central.packetsSent());
+
+    QLowEnergyLinkStatistics swapped;
+    swapped.swap(assigned);
+    QVERIFY(swapped.isValid());
+    QCOMPARE(swapped.bytesReceived(), central.bytesReceived());
+    QVERIFY(!assigned.isValid());
+    QCOMPARE(assigned.bytesReceived(), 0u);
+
+    m_central->disconnectFromDevice();
+    QVERIFY(!m_central->linkStatistics().isValid());
+    QVERIFY(!m_peripheral->linkStatistics().isValid());
+    // the counters start over with the next connection
+    m_peripheral->startAdvertising(QLowEnergyAdvertisingParameters(),
+                                   QLowEnergyAdvertisingData());
+    connectCentral();
+    QCOMPARE(m_central->linkStatistics().packetsSent(), 0u);
+    QCOMPARE(copy.packetsSent(), central.packetsSent());
+}
+
+void tst_QLowEnergyControllerLoopback::readCharacteristics()
+{
+    using Operation = QLowEnergyRequestStatistics::Operation;
+
+    // with the smallest MTU the response has room for 22 bytes
+    qputenv("QT_BLUETOOTH_LOOPBACK_MTU", "23");
+    const auto resetMtu = qScopeGuard([]() { qunsetenv("QT_BLUETOOTH_LOOPBACK_MTU"); });
+    cleanup();
+    init();
+
+    const QScopedPointer<QLowEnergyService> localService(addBatchService());
+    QVERIFY(localService);
+    connectCentral();
+    QCOMPARE(m_central->mtu(), 23);
+    m_central->setRequestStatisticsEnabled(true);
+    const auto readCount = [this]() {
+        return m_central->requestStatistics().latency(Operation::Read).count;
+    };
+
+    QScopedPointer<QLowEnergyService> service(discoverService(batchServiceUuid));
+    QVERIFY(service);
+    const QLowEnergyCharacteristic first = service->characteristic(firstUuid);
+    const QLowEnergyCharacteristic second = service->characteristic(secondUuid);
+    const QLowEnergyCharacteristic secret = service->characteristic(secretUuid);
+    QVERIFY(first.isValid() && second.isValid() && secret.isValid());
+    QSignalSpy read(service.data(), &QLowEnergyService::characteristicRead);
+    QSignalSpy batches(service.data(), &QLowEnergyService::characteristicsRead);
+    QSignalSpy errors(service.data(), &QLowEnergyService::errorOccurred);
+
+    // both values in one exchange, the batch is reported after the single values
+    localService->writeCharacteristic(localService->characteristic(firstUuid), "1st");
+    localService->writeCharacteristic(localService->characteristic(secondUuid), "2nd");
+    quint64 reads = readCount();
+    service->readCharacteristics({ second, first });
+    QTRY_COMPARE(batches.size(), 1);
+    QCOMPARE(read.size(), 2);
+    QCOMPARE(read.at(0).at(0).value<QLowEnergyCharacteristic>(), second);
+    QCOMPARE(read.at(1).at(0).value<QLowEnergyCharacteristic>(), first);
+    QCOMPARE(batches.at(0).at(0).value<QList<QLowEnergyCharacteristic>>(),
+             QList<QLowEnergyCharacteristic>({ second, first }));
+    QCOMPARE(batches.at(0).at(1).value<QList<QByteArray>>(),
+             QList<QByteArray>({ "2nd", "1st" }));
+    QCOMPARE(readCount(), reads + 1);
+    QCOMPARE(first.value(), QByteArray("1st"));
+
+    // a value which does not fit is read again on its own
+    const QByteArray longValue(30, 'x');
+    localService->writeCharacteristic(localService->characteristic(secondUuid), longValue);
+    read.clear();
+    batches.clear();
+    reads = readCount();
+    service->readCharacteristics({ first, second });
+    QTRY_COMPARE(batches.size(), 1);
+    QCOMPARE(batches.at(0).at(1).value<QList<QByteArray>>(),
+             QList<QByteArray>({ "1st", longValue }));
+    QCOMPARE(read.size(), 2);
+    QCOMPARE(readCount(), reads + 2);
+    QCOMPARE(second.value(), longValue);
+
+    // an unreadable characteristic fails the request, the single reads show which one
+    read.clear();
+    batches.clear();
+    reads = readCount();
+    service->readCharacteristics({ first, secret });
+    QTRY_COMPARE(errors.size(), 1);
+    QCOMPARE(errors.at(0).at(0).value<QLowEnergyService::ServiceError>(),
+             QLowEnergyService::CharacteristicReadError);
+    QCOMPARE(read.size(), 1);
+    QCOMPARE(read.at(0).at(0).value<QLowEnergyCharacteristic>(), first);
+    QCOMPARE(readCount(), reads + 3);
+    QTest::qWait(50);
+    QCOMPARE(batches.size(), 0);
+
+    // an unknown characteristic rejects the whole batch
+    errors.clear();
+    read.clear();
+    service->readCharacteristics({ first, m_localService->characteristic(valueUuid) });
+    QCOMPARE(errors.size(), 1);
+    QCOMPARE(service->error(), QLowEnergyService::OperationError);
+    QTest::qWait(50);
+    QCOMPARE(read.size(), 0);
+}
+
+void tst_QLowEnergyControllerLoopback::writeCharacteristics()
+{
+    const QScopedPointer<QLowEnergyService> localService(addBatchService());
+    QVERIFY(localService);
+    connectCentral();
+    QScopedPointer<QLowEnergyService> service(discoverService(batchServiceUuid));
+    QVERIFY(service);
+    const QLowEnergyCharacteristic first = service->characteristic(firstUuid);
+    const QLowEnergyCharacteristic second = service->characteristic(secondUuid);
+    const QLowEnergyCharacteristic secret = service->characteristic(secretUuid);
+    QSignalSpy written(service.data(), &QLowEnergyService::characteristicWritten);
+    QSignalSpy batches(service.data(), &QLowEnergyService::characteristicsWritten);
+    QSignalSpy errors(service.data(), &QLowEnergyService::errorOccurred);
+
+    // the lists must match
+    service->writeCharacteristics({ first, second }, { "one" });
+    QCOMPARE(errors.size(), 1);
+    QCOMPARE(service->error(), QLowEnergyService::OperationError);
+    QTest::qWait(50);
+    QCOMPARE(written.size(), 0);
+    QCOMPARE(localService->characteristic(firstUuid).value(), QByteArray("first"));
+
+    // a characteristic may appear more than once
+    errors.clear();
+    service->writeCharacteristics({ first, second, first }, { "one", "two", "three" });
+    QTRY_COMPARE(batches.size(), 1);
+    QCOMPARE(written.size(), 3);
+    QCOMPARE(written.at(2).at(0).value<QLowEnergyCharacteristic>(), first);
+    QCOMPARE(batches.at(0).at(0).value<QList<QLowEnergyCharacteristic>>(),
+             QList<QLowEnergyCharacteristic>({ first, second, first }));
+    QCOMPARE(batches.at(0).at(1).value<QList<QByteArray>>(),
+             QList<QByteArray>({ "one", "two", "three" }));
+    QCOMPARE(localService->characteristic(firstUuid).value(), QByteArray("three"));
+    QCOMPARE(localService->characteristic(secondUuid).value(), QByteArray("two"));
+    QCOMPARE(errors.size(), 0);
+
+    // the writes before the failing one are carried out, the batch is not reported
+    written.clear();
+    batches.clear();
+    service->writeCharacteristics({ first, secret, second }, { "1", "2", "3" });
+    QTRY_COMPARE(errors.size(), 1);
+    QCOMPARE(service->error(), QLowEnergyService::CharacteristicWriteError);
+    QTRY_COMPARE(written.size(), 2);
+    QCOMPARE(written.at(0).at(0).value<QLowEnergyCharacteristic>(), first);
+    QCOMPARE(written.at(1).at(0).value<QLowEnergyCharacteristic>(), second);
+    QTest::qWait(50);
+    QCOMPARE(batches.size(), 0);
+    QCOMPARE(localService->characteristic(secretUuid).value(), QByteArray("secret"));
+}
+
+void tst_QLowEnergyControllerLoopback::reliableWrites()
+{
+    const QScopedPointer<QLowEnergyService> localService(addBatchService());
+    QVERIFY(localService);
+    connectCentral();
+    QScopedPointer<QLowEnergyService> service(discoverService(batchServiceUuid));
+    QVERIFY(service);
+    const QLowEnergyCharacteristic first = service->characteristic(firstUuid);
+    const QLowEnergyCharacteristic second = service->characteristic(secondUuid);
+    const QLowEnergyCharacteristic secret = service->characteristic(secretUuid);
+    const QLowEnergyCharacteristic limited = service->characteristic(shortUuid);
+    QVERIFY(limited.isValid());
+    QSignalSpy written(service.data(), &QLowEnergyService::characteristicWritten);
+    QSignalSpy batches(service.data(), &QLowEnergyService::characteristicsWritten);
+    QSignalSpy errors(service.data(), &QLowEnergyService::errorOccurred);
+    const auto localValue = [&localService](const QBluetoothUuid &uuid) {
+        return localService->characteristic(uuid).value();
+    };
+
+    // prepared, echoed and executed, reported in the order of the list
+    service->writeCharacteristicsReliably({ first, limited, first }, { "a", "bcd", "c" });
+    QTRY_COMPARE(batches.size(), 1);
+    QCOMPARE(written.size(), 3);
+    QCOMPARE(written.at(0).at(0).value<QLowEnergyCharacteristic>(), first);
+    QCOMPARE(written.at(1).at(0).value<QLowEnergyCharacteristic>(), limited);
+    QCOMPARE(written.at(1).at(1).toByteArray(), QByteArray("bcd"));
+    QCOMPARE(batches.at(0).at(1).value<QList<QByteArray>>(),
+             QList<QByteArray>({ "a", "bcd", "c" }));
+    QCOMPARE(localValue(firstUuid), QByteArray("c"));
+    QCOMPARE(localValue(shortUuid), QByteArray("bcd"));
+    QCOMPARE(limited.value(), QByteArray("bcd"));
+    QCOMPARE(errors.size(), 0);
+
+    // the peer echoes a truncated value, the transaction is cancelled as a whole
+    written.clear();
+    batches.clear();
+    QTest::ignoreMessage(QtWarningMsg, "Reliable write: prepared value was altered by the peer");
+    service->writeCharacteristicsReliably({ second, limited }, { "x", "too long" });
+    QTRY_COMPARE(errors.size(), 1);
+    QCOMPARE(service->error(), QLowEnergyService::CharacteristicWriteError);
+    QTest::qWait(50);
+    QCOMPARE(written.size(), 0);
+    QCOMPARE(batches.size(), 0);
+    QCOMPARE(localValue(secondUuid), QByteArray("second"));
+    QCOMPARE(localValue(shortUuid), QByteArray("bcd"));
+
+    // a value the peer does not accept cancels the transaction as well
+    errors.clear();
+    service->writeCharacteristicsReliably({ first, secret }, { "y", "z" });
+    QTRY_COMPARE(errors.size(), 1);
+    QCOMPARE(service->error(), QLowEnergyService::CharacteristicWriteError);
+    QTest::qWait(50);
+    QCOMPARE(written.size(), 0);
+    QCOMPARE(localValue(firstUuid), QByteArray("c"));
+
+    // nothing is sent for invalid arguments
+    errors.clear();
+    service->writeCharacteristicsReliably({ first, second }, { "1" });
+    QCOMPARE(errors.size(), 1);
+    QCOMPARE(service->error(), QLowEnergyService::OperationError);
+    localService->writeCharacteristicsReliably({ localService->characteristic(firstUuid) },
+                                               { "1" });
+    QCOMPARE(localService->error(), QLowEnergyService::OperationError);
+    QTest::qWait(50);
+    QCOMPARE(written.size(), 0);
+    QCOMPARE(localValue(firstUuid), QByteArray("c"));
+}
+
+void tst_QLowEnergyControllerLoopback::publishCharacteristicValue()
+{
+    QLowEnergyCharacteristicData indicatedData;
+    indicatedData.setUuid(indicatedUuid);
+    indicatedData.setProperties(QLowEnergyCharacteristic::Read
+                                | QLowEnergyCharacteristic::Indicate);
+    indicatedData.addDescriptor(QLowEnergyDescriptorData(
+            QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration,
+            QByteArray(2, 0)));
+    QLowEnergyServiceData indicatedServiceData;
+    indicatedServiceData.setType(QLowEnergyServiceData::ServiceTypePrimary);
+    indicatedServiceData.setUuid(indicatedServiceUuid);
+    indicatedServiceData.addCharacteristic(indicatedData);
+    m_peripheral->stopAdvertising();
+    const QScopedPointer<QLowEnergyService> localIndicated(
+            m_peripheral->addService(indicatedServiceData));
+    QVERIFY(localIndicated);
+    m_peripheral->startAdvertising(QLowEnergyAdvertisingParameters(),
+                                   QLowEnergyAdvertisingData());
+
+    connectCentral();
+    QScopedPointer<QLowEnergyService> service(discoverService());
+    QVERIFY(service);
+    QScopedPointer<QLowEnergyService> indicated(discoverService(indicatedServiceUuid));
+    QVERIFY(indicated);
+    QSignalSpy changed(service.data(), &QLowEnergyService::characteristicChanged);
+    QSignalSpy indicatedChanged(indicated.data(), &QLowEnergyService::characteristicChanged);
+    const QLowEnergyCharacteristic localValue = m_localService->characteristic(valueUuid);
+    const QLowEnergyCharacteristic localIndicatedValue =
+            localIndicated->characteristic(indicatedUuid);
+
+    // the local value changes, clients which did not subscribe hear nothing
+    m_localService->publishCharacteristicValue(localValue, "one");
+    localIndicated->publishCharacteristicValue(localIndicatedValue, "uno");
+    QCOMPARE(localValue.value(), QByteArray("one"));
+    QCOMPARE(localIndicatedValue.value(), QByteArray("uno"));
+    QTest::qWait(50);
+    QCOMPARE(changed.size(), 0);
+    QCOMPARE(indicatedChanged.size(), 0);
+
+    QVERIFY(enableNotifications(service.data()));
+    m_localService->publishCharacteristicValue(localValue, "two");
+    QTRY_COMPARE(changed.size(), 1);
+    QCOMPARE(changed.at(0).at(1).toByteArray(), QByteArray("two"));
+    QCOMPARE(service->characteristic(valueUuid).value(), QByteArray("two"));
+
+    // only the subscribed client is served, with the kind of update it asked for
+    QSignalSpy descriptorWritten(indicated.data(), &QLowEnergyService::descriptorWritten);
+    indicated->writeDescriptor(
+            indicated->characteristic(indicatedUuid).clientCharacteristicConfiguration(),
+            QLowEnergyCharacteristic::CCCDEnableIndication);
+    QTRY_COMPARE(descriptorWritten.size(), 1);
+    localIndicated->publishCharacteristicValue(localIndicatedValue, "dos");
+    QTRY_COMPARE(indicatedChanged.size(), 1);
+    QCOMPARE(indicatedChanged.at(0).at(1).toByteArray(), QByteArray("dos"));
+    QCOMPARE(changed.size(), 1);
+
+    descriptorWritten.clear();
+    indicated->writeDescriptor(
+            indicated->characteristic(indicatedUuid).clientCharacteristicConfiguration(),
+            QLowEnergyCharacteristic::CCCDDisable);
+    QTRY_COMPARE(descriptorWritten.size(), 1);
+    localIndicated->publishCharacteristicValue(localIndicatedValue, "tres");
+    QCOMPARE(localIndicatedValue.value(), QByteArray("tres"));
+    QTest::qWait(50);
+    QCOMPARE(indicatedChanged.size(), 1);
+
+    // only local characteristics of the service can be published
+    QSignalSpy errors(service.data(), &QLowEnergyService::errorOccurred);
+    service->publishCharacteristicValue(service->characteristic(valueUuid), "three");
+    QCOMPARE(errors.size(), 1);
+    QCOMPARE(service->error(), QLowEnergyService::OperationError);
+    m_localService->publishCharacteristicValue(localIndicatedValue, "three");
+    QCOMPARE(m_localService->error(), QLowEnergyService::OperationError);
+    QCOMPARE(localIndicatedValue.value(), QByteArray("tres"));
+    QTest::qWait(50);
+    QCOMPARE(changed.size(), 1);
+}
+
+void tst_QLowEnergyControllerLoopback::notifiedValueCaching()
+{
+    connectCentral();
+    QScopedPointer<QLowEnergyService> service(discoverService());
+    QVERIFY(service);
+    QVERIFY(service->isNotifiedValueCachingEnabled());
+    QVERIFY(enableNotifications(service.data()));
+    QSignalSpy changed(service.data(), &QLowEnergyService::characteristicChanged);
+    const QLowEnergyCharacteristic localValue = m_localService->characteristic(valueUuid);
+
+    m_localService->writeCharacteristic(localValue, "cached");
+    QTRY_COMPARE(changed.size(), 1);
+    QCOMPARE(service->characteristic(valueUuid).value(), QByteArray("cached"));
+
+    // the setting is shared by all objects of the service
+    QScopedPointer<QLowEnergyService> other(m_central->createServiceObject(serviceUuid));
+    QVERIFY(other);
+    other->setNotifiedValueCachingEnabled(false);
+    QVERIFY(!service->isNotifiedValueCachingEnabled());
+
+    // the value still reaches the signal, it is not stored
+    m_localService->writeCharacteristic(localValue, "dropped");
+    QTRY_COMPARE(changed.size(), 2);
+    QCOMPARE(changed.at(1).at(1).toByteArray(), QByteArray("dropped"));
+    QVERIFY(service->characteristic(valueUuid).value().isEmpty());
+
+    // read values are stored nevertheless
+    QSignalSpy read(service.data(), &QLowEnergyService::characteristicRead);
+    service->readCharacteristic(service->characteristic(valueUuid));
+    QTRY_COMPARE(read.size(), 1);
+    QCOMPARE(service->characteristic(valueUuid).value(), QByteArray("dropped"));
+
+    service->setNotifiedValueCachingEnabled(true);
+    m_localService->writeCharacteristic(localValue, "again");
+    QTRY_COMPARE(changed.size(), 3);
+    QCOMPARE(service->characteristic(valueUuid).value(), QByteArray("again"));
+}
+
+void tst_QLowEnergyControllerLoopback::periodicAdvertisingData()
+{
+    // there is no periodic advertising to synchronize to, advertising goes on
+    QLowEnergyAdvertisingData data;
+    data.setManufacturerData(0xffff, QByteArray("periodic"));
+    QTest::ignoreMessage(QtWarningMsg, "Periodic advertising is not supported on this platform");
+    m_peripheral->setPeriodicAdvertisingData(data);
+    QCOMPARE(m_peripheral->state(), QLowEnergyController::AdvertisingState);
+    QCOMPARE(m_peripheral->error(), QLowEnergyController::NoError);
+
+    QTest::ignoreMessage(QtWarningMsg, "Cannot set periodic advertising data in central role");
+    m_central->setPeriodicAdvertisingData(data);
+
+    connectCentral();
+    QCOMPARE(m_peripheral->state(), QLowEnergyController::ConnectedState);
+}
+
+void tst_QLowEnergyControllerLoopback::lowLatencyNotificationHandler()
+{
+    QStringList events;
+    m_central->setLowLatencyNotificationHandler(
+            [&events](QLowEnergyHandle handle, QByteArrayView value) {
+        events.append(QStringLiteral("handler %1 %2").arg(handle)
+                              .arg(QString::fromLatin1(value.toByteArray())));
+    });
+    connectCentral();
+    QScopedPointer<QLowEnergyService> service(discoverService());
+    QVERIFY(service);
+    QVERIFY(enableNotifications(service.data()));
+    const QLowEnergyHandle valueHandle = service->characteristic(valueUuid).handle();
+    connect(service.data(), &QLowEnergyService::characteristicChanged, this,
+            [&events](const QLowEnergyCharacteristic &, const QByteArray &value) {
+        events.append(QStringLiteral("changed ") + QString::fromLatin1(value));
+    });
+
+    // called for every notification, before the regular processing
+    const QLowEnergyCharacteristic localValue = m_localService->characteristic(valueUuid);
+    m_localService->writeCharacteristic(localValue, "one");
+    m_localService->writeCharacteristic(localValue, "two");
+    QTRY_COMPARE(events.size(), 4);
+    QCOMPARE(events, QStringList({ QStringLiteral("handler %1 one").arg(valueHandle),
+                                   QStringLiteral("changed one"),
+                                   QStringLiteral("handler %1 two").arg(valueHandle),
+                                   QStringLiteral("changed two") }));
+    QCOMPARE(service->characteristic(valueUuid).value(), QByteArray("two"));
+
+    // a new handler waits for the next connection
+    int replacementCalls = 0;
+    m_central->setLowLatencyNotificationHandler(
+            [&replacementCalls](QLowEnergyHandle, QByteArrayView) { ++replacementCalls; });
+    events.clear();
+    m_localService->writeCharacteristic(localValue, "three");
+    QTRY_COMPARE(events.size(), 2);
+    QCOMPARE(events.first(), QStringLiteral("handler %1 three").arg(valueHandle));
+    QCOMPARE(replacementCalls, 0);
+
+    // an empty handler turns it off with the next connection
+    m_central->disconnectFromDevice();
+    service.reset();
+    m_central->setLowLatencyNotificationHandler({});
+    m_peripheral->startAdvertising(QLowEnergyAdvertisingParameters(),
+                                   QLowEnergyAdvertisingData());
+    connectCentral();
+    service.reset(discoverService());
+    QVERIFY(service);
+    QVERIFY(enableNotifications(service.data()));
+    QSignalSpy changed(service.data(), &QLowEnergyService::characteristicChanged);
+    events.clear();
+    m_localService->writeCharacteristic(localValue, "four");
+    QTRY_COMPARE(changed.size(), 1);
+    QVERIFY(events.isEmpty());
+    QCOMPARE(replacementCalls, 0);
+}
+
+void tst_QLowEnergyControllerLoopback::autoConnect()
+{
+    QSignalSpy connected(m_central.data(), &QLowEnergyController::connected);
+    QSignalSpy errors(m_central.data(), &QLowEnergyController::errorOccurred);
+    m_peripheral->stopAdvertising();
+    QVERIFY(!m_central->isAutoConnectEnabled());
+
+    // without auto-connect the attempt fails right away
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("^No loopback peripheral advertises"));
+    m_central->connectToDevice();
+    QCOMPARE(m_central->state(), QLowEnergyController::UnconnectedState);
+    QCOMPARE(m_central->error(), QLowEnergyController::UnknownRemoteDeviceError);
+
+    // with it the central waits for the first advertisement
+    errors.clear();
+    m_central->setAutoConnectEnabled(true);
+    m_central->connectToDevice();
+    QCOMPARE(m_central->state(), QLowEnergyController::ConnectingState);
+    QTest::qWait(50);
+    QCOMPARE(m_central->state(), QLowEnergyController::ConnectingState);
+    QCOMPARE(errors.size(), 0);
+
+    m_peripheral->startAdvertising(QLowEnergyAdvertisingParameters(),
+                                   QLowEnergyAdvertisingData());
+    QTRY_COMPARE(connected.size(), 1);
+    QCOMPARE(m_central->state(), QLowEnergyController::ConnectedState);
+    QCOMPARE(m_peripheral->state(), QLowEnergyController::ConnectedState);
+    QCOMPARE(m_peripheral->remoteAddress(), m_central->localAddress());
+
+    // disconnecting ends the wait, a later advertisement connects nobody
+    m_central->disconnectFromDevice();
+    m_peripheral->stopAdvertising();
+    m_central->connectToDevice();
+    QCOMPARE(m_central->state(), QLowEnergyController::ConnectingState);
+    m_central->disconnectFromDevice();
+    QCOMPARE(m_central->state(), QLowEnergyController::UnconnectedState);
+    m_peripheral->startAdvertising(QLowEnergyAdvertisingParameters(),
+                                   QLowEnergyAdvertisingData());
+    QTest::qWait(50);
+    QCOMPARE(connected.size(), 1);
+    QCOMPARE(m_peripheral->state(), QLowEnergyController::AdvertisingState);
+    QCOMPARE(errors.size(), 0);
+}
+
+QTEST_MAIN(tst_QLowEnergyControllerLoopback)
+
+#include "tst_qlowenergycontroller-loopback.moc"
@@ -7,12 +7,17 @@
 #if QT_CONFIG(bluez)
 #include <QtBluetooth/private/bluez5_helper_p.h>
 #endif
+#ifdef QT_BUILD_INTERNAL
+#include <QtBluetooth/private/qlowenergyrequeststatistics_p.h>
+#endif
 #include <QBluetoothAddress>
 #include <QBluetoothLocalDevice>
 #include <QBluetoothDeviceDiscoveryAgent>
 #include <QBluetoothUuid>
 #include <QLowEnergyController>
 #include <QLowEnergyCharacteristic>
+#include <QLowEnergyCharacteristicData>
+#include <QLowEnergyServiceData>
 
 #include <QDebug>
 
@@ -49,6 +54,14 @@ private slots:
     void tst_readWriteDescriptor();
     void tst_customProgrammableDevice();
     void tst_errorCases();
+    void tst_requestStatistics();
+    void tst_phyAndDataLength();
+    void tst_linkStatistics();
+    void tst_gattCachePolicy();
+    void tst_notifiedValueCaching();
+    void tst_periodicAdvertisingData();
+    void tst_lowLatencyNotificationHandler();
+    void tst_autoConnect();
 private:
     void verifyServiceProperties(const QLowEnergyService *info);
     bool verifyClientCharacteristicValue(const QByteArray& value);
@@ -2735,6 +2748,304 @@ void tst_QLowEnergyController::tst_writeCharacteristicNoResponse()
     QCOMPARE(control->error(), QLowEnergyController::NoError);
 }
 
+void tst_QLowEnergyController::tst_requestStatistics()
+{
+    using Operation = QLowEnergyRequestStatistics::Operation;
+
+    QScopedPointer<QLowEnergyController> control(
+            QLowEnergyController::createCentral(QBluetoothDeviceInfo()));
+    QVERIFY(!control->isRequestStatisticsEnabled());
+    QVERIFY(!control->requestStatistics().isValid());
+
+    control->setRequestStatisticsEnabled(true);
+    QVERIFY(control->isRequestStatisticsEnabled());
+    const QLowEnergyRequestStatistics statistics = control->requestStatistics();
+    QVERIFY(statistics.isValid());
+    QCOMPARE(statistics.latency(Operation::Read).count, 0u);
+    QCOMPARE(statistics.waitTime(Operation::Write).count, 0u);
+    QCOMPARE(statistics.queueHighWaterMark(), 0);
+    QCOMPARE(statistics.retryCount(), 0u);
+    QCOMPARE(statistics.timeoutCount(), 0u);
+
+    control->setRequestStatisticsEnabled(false);
+    QVERIFY(!control->requestStatistics().isValid());
+
+#ifdef QT_BUILD_INTERNAL
+    using namespace std::chrono_literals;
+    using Clock = QLowEnergyRequestRecorder::Clock;
+
+    QLowEnergyRequestRecorder recorder;
+    recorder.recordLatency(Operation::Read, 1ms);
+    QVERIFY(!recorder.statistics().isValid());
+
+    recorder.setEnabled(true);
+    recorder.recordLatency(Operation::Read, 3us);
+    recorder.recordLatency(Operation::Read, 1ms);
+    recorder.recordWaitTime(Operation::Read, 0us);
+    recorder.recordQueueDepth(4);
+    recorder.recordQueueDepth(2);
+    recorder.recordRetry();
+    recorder.recordTimeout();
+    recorder.recordTimeout();
+
+    const Clock::time_point start = Clock::now();
+    recorder.recordNotification(start);
+    recorder.recordNotification(start + 20ms);
+
+    QLowEnergyRequestStatistics result = recorder.statistics();
+    QVERIFY(result.isValid());
+
+    const QLowEnergyRequestStatistics::Histogram reads = result.latency(Operation::Read);
+    QCOMPARE(reads.count, 2u);
+    QCOMPARE(reads.minimum, 3us);
+    QCOMPARE(reads.maximum, 1ms);
+    QCOMPARE(reads.total, 1003us);
+    QCOMPARE(reads.buckets.size(), QLowEnergyRequestRecorder::BucketCount);
+    QCOMPARE(reads.buckets.at(2), 1u); // 2..3 us
+    QCOMPARE(reads.buckets.at(10), 1u); // 512..1023 us
+    QCOMPARE(result.waitTime(Operation::Read).buckets.at(0), 1u);
+    QCOMPARE(result.latency(Operation::Write).count, 0u);
+
+    // the first notification only starts the interval
+    const QLowEnergyRequestStatistics::Histogram notifications =
+            result.latency(Operation::Notification);
+    QCOMPARE(notifications.count, 1u);
+    QCOMPARE(notifications.total, 20ms);
+
+    QCOMPARE(result.queueHighWaterMark(), 4);
+    QCOMPARE(result.retryCount(), 1u);
+    QCOMPARE(result.timeoutCount(), 2u);
+
+    // write commands have no response
+    recorder.recordRequest(Operation::WriteWithoutResponse, start, start + 5us);
+    result = recorder.statistics();
+    QCOMPARE(result.waitTime(Operation::WriteWithoutResponse).total, 5us);
+    QCOMPARE(result.latency(Operation::WriteWithoutResponse).count, 0u);
+
+    recorder.reset();
+    result = recorder.statistics();
+    QVERIFY(result.isValid());
+    QCOMPARE(result.latency(Operation::Read).count, 0u);
+    QCOMPARE(result.latency(Operation::Notification).count, 0u);
+    QCOMPARE(result.queueHighWaterMark(), 0);
+    QCOMPARE(result.timeoutCount(), 0u);
+    QCOMPARE(result.requestTimeout(Operation::Read), 0ms);
+
+    QLowEnergyRequestTimeoutEstimator timeouts;
+    QCOMPARE(timeouts.timeout(Operation::Read), 0ms);
+    timeouts.setMaximumTimeout(20s);
+    // the fixed timeout is used unless adaptive timeouts are enabled
+    QVERIFY(!timeouts.isAdaptive());
+    for (int i = 0; i < QLowEnergyRequestTimeoutEstimator::MinimumSamples; ++i)
+        timeouts.recordResponse(Operation::Write, 30ms);
+    QCOMPARE(timeouts.timeout(Operation::Write), 20s);
+    timeouts.reset();
+    timeouts.setAdaptive(true);
+    // too few responses to trust the measurement
+    for (int i = 1; i < QLowEnergyRequestTimeoutEstimator::MinimumSamples; ++i)
+        timeouts.recordResponse(Operation::Read, 30ms);
+    QCOMPARE(timeouts.timeout(Operation::Read), 20s);
+
+    // fast link, the minimum of the operation applies
+    timeouts.recordResponse(Operation::Read, 30ms);
+    QCOMPARE(timeouts.smoothedLatency(Operation::Read), 30ms);
+    QCOMPARE(timeouts.timeout(Operation::Read), 2s);
+    QCOMPARE(timeouts.timeout(Operation::Write), 20s);
+
+    // each timeout doubles the next one until a response arrives
+    timeouts.recordTimeout(Operation::Read);
+    QCOMPARE(timeouts.timeout(Operation::Read), 4s);
+    timeouts.recordResponse(Operation::Read, 30ms);
+    QCOMPARE(timeouts.timeout(Operation::Read), 2s);
+
+    // 1 s interval with 4 skipped events, the link needs 20 s for a request
+    timeouts.setConnectionParameters(1000, 4, 6000);
+    QCOMPARE(timeouts.timeout(Operation::Read), 20s);
+    timeouts.setConnectionParameters(2000, 4, 32000);
+    QCOMPARE(timeouts.timeout(Operation::Read), 30s);
+
+    timeouts.setAdaptive(false);
+    timeouts.setConnectionParameters(7.5, 0, 720);
+    QCOMPARE(timeouts.timeout(Operation::Read), 20s);
+
+    recorder.reset();
+    result = recorder.statistics(&timeouts);
+    QCOMPARE(result.requestTimeout(Operation::Read), 20s);
+    QCOMPARE(result.smoothedLatency(Operation::Read), 30ms);
+#endif
+}
+
+void tst_QLowEnergyController::tst_phyAndDataLength()
+{
+    using Phy = QLowEnergyController::Phy;
+
+    // the values of the LE Set PHY command
+    QCOMPARE(int(Phy::Le1M), 1);
+    QCOMPARE(int(Phy::Le2M), 2);
+    QCOMPARE(int(Phy::LeCoded), 3);
+
+    QScopedPointer<QLowEnergyController> control(
+            QLowEnergyController::createCentral(QBluetoothDeviceInfo()));
+    // queued connections need the types by name
+    QCOMPARE(QMetaType::fromName("QLowEnergyController::Phy"), QMetaType::fromType<Phy>());
+    QSignalSpy phySpy(control.data(), &QLowEnergyController::phyChanged);
+    QVERIFY(phySpy.isValid());
+    QSignalSpy dataLengthSpy(control.data(), &QLowEnergyController::dataLengthChanged);
+    QVERIFY(dataLengthSpy.isValid());
+
+    // the range is checked before the state
+    for (const int txOctets : { -1, 0, 26, 252 }) {
+        QTest::ignoreMessage(QtWarningMsg,
+                             QRegularExpression(QStringLiteral("^Invalid data length %1 requested")
+                                                        .arg(txOctets)));
+        control->requestDataLength(txOctets);
+    }
+
+    // both requests need a connection
+    QTest::ignoreMessage(QtWarningMsg, "Data length request only possible in connected state");
+    control->requestDataLength(27);
+    QTest::ignoreMessage(QtWarningMsg, "Data length request only possible in connected state");
+    control->requestDataLength(251);
+    QTest::ignoreMessage(QtWarningMsg, "PHY update request only possible in connected state");
+    control->requestPhy(Phy::Le2M, Phy::LeCoded);
+
+    QTest::qWait(50);
+    QCOMPARE(phySpy.size(), 0);
+    QCOMPARE(dataLengthSpy.size(), 0);
+}
+
+void tst_QLowEnergyController::tst_linkStatistics()
+{
+    const QLowEnergyLinkStatistics statistics;
+    QVERIFY(!statistics.isValid());
+    QCOMPARE(statistics.bytesSent(), 0u);
+    QCOMPARE(statistics.bytesReceived(), 0u);
+    QCOMPARE(statistics.packetsSent(), 0u);
+    QCOMPARE(statistics.packetsReceived(), 0u);
+    QCOMPARE(statistics.completedPackets(), 0u);
+    QCOMPARE(statistics.connectionInterval(), 0.0);
+
+    QLowEnergyLinkStatistics copy(statistics);
+    QVERIFY(!copy.isValid());
+    copy = QLowEnergyLinkStatistics();
+    QVERIFY(!copy.isValid());
+    QCOMPARE(copy.packetsSent(), 0u);
+
+    QVERIFY(QMetaType::fromType<QLowEnergyLinkStatistics>().isValid());
+    const QVariant variant = QVariant::fromValue(statistics);
+    QVERIFY(!variant.value<QLowEnergyLinkStatistics>().isValid());
+
+    // an unconnected controller has no link to count
+    QScopedPointer<QLowEnergyController> control(
+            QLowEnergyController::createCentral(QBluetoothDeviceInfo()));
+    QCOMPARE(control->state(), QLowEnergyController::UnconnectedState);
+    QVERIFY(!control->linkStatistics().isValid());
+}
+
+void tst_QLowEnergyController::tst_gattCachePolicy()
+{
+    using Policy = QLowEnergyController::GattCachePolicy;
+
+    QScopedPointer<QLowEnergyController> central(
+            QLowEnergyController::createCentral(QBluetoothDeviceInfo()));
+    QScopedPointer<QLowEnergyController> peripheral(QLowEnergyController::createPeripheral());
+    QCOMPARE(central->gattCachePolicy(), Policy::PlatformDefault);
+    QCOMPARE(peripheral->gattCachePolicy(), Policy::PlatformDefault);
+
+    central->setGattCachePolicy(Policy::Uncached);
+    QCOMPARE(central->gattCachePolicy(), Policy::Uncached);
+    central->setGattCachePolicy(Policy::Cached);
+    QCOMPARE(central->gattCachePolicy(), Policy::Cached);
+    // the policy belongs to the controller
+    QCOMPARE(peripheral->gattCachePolicy(), Policy::PlatformDefault);
+
+    central->setGattCachePolicy(Policy::PlatformDefault);
+    QCOMPARE(central->gattCachePolicy(), Policy::PlatformDefault);
+}
+
+void tst_QLowEnergyController::tst_notifiedValueCaching()
+{
+    QLowEnergyCharacteristicData characteristicData;
+    characteristicData.setUuid(QBluetoothUuid(QBluetoothUuid::CharacteristicType::BatteryLevel));
+    characteristicData.setProperties(QLowEnergyCharacteristic::Read
+                                     | QLowEnergyCharacteristic::Notify);
+    characteristicData.setValue(QByteArray(1, 100));
+    QLowEnergyServiceData serviceData;
+    serviceData.setType(QLowEnergyServiceData::ServiceTypePrimary);
+    serviceData.setUuid(QBluetoothUuid(QBluetoothUuid::ServiceClassUuid::BatteryService));
+    serviceData.addCharacteristic(characteristicData);
+
+    QScopedPointer<QLowEnergyController> peripheral(QLowEnergyController::createPeripheral());
+    QScopedPointer<QLowEnergyService> service(peripheral->addService(serviceData));
+    if (!service)
+        QSKIP("The platform does not support local services");
+    QVERIFY(service->isNotifiedValueCachingEnabled());
+
+    service->setNotifiedValueCachingEnabled(false);
+    QVERIFY(!service->isNotifiedValueCachingEnabled());
+    // the stored value stays until the next notification
+    QCOMPARE(service->characteristic(characteristicData.uuid()).value(), QByteArray(1, 100));
+
+    service->setNotifiedValueCachingEnabled(true);
+    QVERIFY(service->isNotifiedValueCachingEnabled());
+}
+
+void tst_QLowEnergyController::tst_periodicAdvertisingData()
+{
+    QLowEnergyAdvertisingData data;
+    data.setManufacturerData(0xffff, QByteArray("periodic"));
+
+    QScopedPointer<QLowEnergyController> central(
+            QLowEnergyController::createCentral(QBluetoothDeviceInfo()));
+    QTest::ignoreMessage(QtWarningMsg, "Cannot set periodic advertising data in central role");
+    central->setPeriodicAdvertisingData(data);
+    QCOMPARE(central->state(), QLowEnergyController::UnconnectedState);
+    QCOMPARE(central->error(), QLowEnergyController::NoError);
+
+    QScopedPointer<QLowEnergyController> peripheral(QLowEnergyController::createPeripheral());
+    QTest::ignoreMessage(QtWarningMsg, "Invalid advertising set -1");
+    peripheral->setPeriodicAdvertisingData(data, -1);
+    QCOMPARE(peripheral->state(), QLowEnergyController::UnconnectedState);
+    QCOMPARE(peripheral->error(), QLowEnergyController::NoError);
+}
+
+void tst_QLowEnergyController::tst_lowLatencyNotificationHandler()
+{
+    int calls = 0;
+    QScopedPointer<QLowEnergyController> control(
+            QLowEnergyController::createCentral(QBluetoothDeviceInfo()));
+    // the handler is only taken by the next connection
+    control->setLowLatencyNotificationHandler([&calls](QLowEnergyHandle, QByteArrayView) {
+        ++calls;
+    });
+    QCOMPARE(control->state(), QLowEnergyController::UnconnectedState);
+    QCOMPARE(control->error(), QLowEnergyController::NoError);
+
+    control->setLowLatencyNotificationHandler({});
+    QCOMPARE(control->state(), QLowEnergyController::UnconnectedState);
+    control.reset();
+    QCOMPARE(calls, 0);
+}
+
+void tst_QLowEnergyController::tst_autoConnect()
+{
+    QScopedPointer<QLowEnergyController> central(
+            QLowEnergyController::createCentral(QBluetoothDeviceInfo()));
+    QVERIFY(!central->isAutoConnectEnabled());
+
+    central->setAutoConnectEnabled(true);
+    QVERIFY(central->isAutoConnectEnabled());
+    QCOMPARE(central->state(), QLowEnergyController::UnconnectedState);
+
+    // the setting belongs to the controller
+    QScopedPointer<QLowEnergyController> other(
+            QLowEnergyController::createCentral(QBluetoothDeviceInfo()));
+    QVERIFY(!other->isAutoConnectEnabled());
+
+    central->setAutoConnectEnabled(false);
+    QVERIFY(!central->isAutoConnectEnabled());
+}
+
 QTEST_MAIN(tst_QLowEnergyController)
 
 #include "tst_qlowenergycontroller.moc"
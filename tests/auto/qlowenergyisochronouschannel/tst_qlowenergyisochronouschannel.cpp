@@ -0,0 +1,140 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+
+#include <QtBluetooth/qlowenergyisochronouschannel.h>
+
+#if defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
+#include <QtBluetooth/private/qlowenergyisochronouschannel_p.h>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+QT_USE_NAMESPACE
+
+class tst_QLowEnergyIsochronousChannel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void defaults();
+    void receiveQueueFull();
+    void receiveWouldBlock();
+
+#if defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
+private:
+    // feeds the channel through a local SOCK_SEQPACKET pair, which keeps the SDU boundaries
+    bool openSocketPair(QLowEnergyIsochronousChannel *channel, int *peer);
+    static void send(int peer, const QByteArray &sdu);
+#endif
+};
+
+void tst_QLowEnergyIsochronousChannel::defaults()
+{
+    QLowEnergyIsochronousChannel channel;
+    QCOMPARE(channel.state(), QLowEnergyIsochronousChannel::State::UnconnectedState);
+    QCOMPARE(channel.error(), QLowEnergyIsochronousChannel::Error::NoError);
+    QCOMPARE(channel.receiveQueueLength(), 8);
+    QCOMPARE(channel.pendingSduCount(), qsizetype(0));
+    QCOMPARE(channel.droppedSduCount(), quint64(0));
+    QVERIFY(channel.readSdu().data.isEmpty());
+}
+
+#if defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
+bool tst_QLowEnergyIsochronousChannel::openSocketPair(QLowEnergyIsochronousChannel *channel,
+                                                      int *peer)
+{
+    int descriptors[2];
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, descriptors) != 0)
+        return false;
+    ::fcntl(descriptors[0], F_SETFL, ::fcntl(descriptors[0], F_GETFL) | O_NONBLOCK);
+
+    auto d = QLowEnergyIsochronousChannelPrivate::get(channel);
+    if (!d->checkParameters())
+        return false;
+    // the channel closes its end on destruction
+    d->socket = descriptors[0];
+    *peer = descriptors[1];
+    return true;
+}
+
+void tst_QLowEnergyIsochronousChannel::send(int peer, const QByteArray &sdu)
+{
+    QCOMPARE(::write(peer, sdu.constData(), sdu.size()), ssize_t(sdu.size()));
+}
+#endif
+
+void tst_QLowEnergyIsochronousChannel::receiveQueueFull()
+{
+#if defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
+    QLowEnergyIsochronousChannel channel;
+    channel.setMaximumSduSize(8);
+    channel.setReceiveQueueLength(2);
+    int peer = -1;
+    QVERIFY(openSocketPair(&channel, &peer));
+    QSignalSpy readyReadSpy(&channel, &QLowEnergyIsochronousChannel::readyRead);
+
+    const QByteArray sdus[] = { "first", "second", "third" };
+    for (const QByteArray &sdu : sdus)
+        send(peer, sdu);
+    QLowEnergyIsochronousChannelPrivate::get(&channel)->readSdus();
+
+    QCOMPARE(readyReadSpy.size(), 1);
+    QCOMPARE(channel.pendingSduCount(), qsizetype(2));
+    QCOMPARE(channel.droppedSduCount(), quint64(1));
+
+    // an SDU which the application holds on to survives the reuse of its slot
+    const QLowEnergyIsochronousChannel::Sdu held = channel.readSdu();
+    QCOMPARE(held.data, sdus[1]);
+    send(peer, "fourth");
+    send(peer, "fifth");
+    QLowEnergyIsochronousChannelPrivate::get(&channel)->readSdus();
+    QCOMPARE(held.data, sdus[1]);
+    QCOMPARE(channel.pendingSduCount(), qsizetype(2));
+    QCOMPARE(channel.droppedSduCount(), quint64(2));
+    QCOMPARE(channel.readSdu().data, QByteArray("fourth"));
+    QCOMPARE(channel.readSdu().data, QByteArray("fifth"));
+    QCOMPARE(channel.pendingSduCount(), qsizetype(0));
+
+    ::close(peer);
+#else
+    QSKIP("This test requires the BlueZ LE backend of a developer build");
+#endif
+}
+
+void tst_QLowEnergyIsochronousChannel::receiveWouldBlock()
+{
+#if defined(QT_BUILD_INTERNAL) && defined(CONFIG_BLUEZ_LE)
+    QLowEnergyIsochronousChannel channel;
+    channel.setMaximumSduSize(8);
+    channel.setReceiveQueueLength(2);
+    int peer = -1;
+    QVERIFY(openSocketPair(&channel, &peer));
+    QSignalSpy readyReadSpy(&channel, &QLowEnergyIsochronousChannel::readyRead);
+
+    send(peer, "first");
+    send(peer, "second");
+    QLowEnergyIsochronousChannelPrivate::get(&channel)->readSdus();
+    QCOMPARE(readyReadSpy.size(), 1);
+
+    // a notification without data must neither alter nor drop the queued SDUs
+    QLowEnergyIsochronousChannelPrivate::get(&channel)->readSdus();
+    QCOMPARE(readyReadSpy.size(), 1);
+    QCOMPARE(channel.pendingSduCount(), qsizetype(2));
+    QCOMPARE(channel.droppedSduCount(), quint64(0));
+    QCOMPARE(channel.readSdu().data, QByteArray("first"));
+    QCOMPARE(channel.readSdu().data, QByteArray("second"));
+    QCOMPARE(channel.state(), QLowEnergyIsochronousChannel::State::UnconnectedState);
+
+    ::close(peer);
+#else
+    QSKIP("This test requires the BlueZ LE backend of a developer build");
+#endif
+}
+
+QTEST_MAIN(tst_QLowEnergyIsochronousChannel)
+
+#include "tst_qlowenergyisochronouschannel.moc"
@@ -8,6 +8,10 @@
 #include <qndefnfctextrecord.h>
 #include <qndefnfcurirecord.h>
 
+#ifdef QT_BUILD_INTERNAL
+#include <QtNfc/private/qndefmessagedecoder_p.h>
+#endif
+
 QT_USE_NAMESPACE
 
 Q_DECLARE_METATYPE(QNdefRecord)
@@ -28,6 +32,8 @@ private slots:
     void parseCorruptedMessage();
     void parseCorruptedMessage_data();
     void parseComplexMessage();
+    void decodeIncrementally_data();
+    void decodeIncrementally();
 };
 
 tst_QNdefMessage::tst_QNdefMessage()
@@ -430,6 +436,40 @@ void tst_QNdefMessage::parseSingleRecordMessage_data()
                 << (QVariantList() << QUrl(QStringLiteral("tel:+1234567890")));
     }
 
+    // Chunk payload - the last chunk is empty
+    {
+        const QByteArray type("U");
+        QByteArray payload1;
+        payload1.append(char(0x05));
+        payload1.append("+123");
+
+        const QByteArray payload2("4567890");
+
+        QByteArray data;
+        data.append(char(0xB1)); // MB=1, ME=0, CF=1, SR=1, IL=0, TNF=1 (NFC-RTD)
+        data.append(type.length());
+        data.append(payload1.length() & 0xff); // length fits into 1 byte
+        data.append(type);
+        data.append(payload1);
+        data.append(char(0x26)); // MB=0, ME=0, CF=1, SR=0, IL=0, TNF=6 (Unchanged)
+        data.append(char(0x00));
+        data.append(QByteArray::fromHex("00000007")); // 4 byte payload length
+        data.append(payload2);
+        data.append(char(0x56)); // MB=0, ME=1, CF=0, SR=1, IL=0, TNF=6 (Unchanged)
+        data.append(char(0x00));
+        data.append(char(0x00));
+
+        QNdefRecord record;
+        record.setTypeNameFormat(QNdefRecord::NfcRtd);
+        record.setType(type);
+        record.setPayload(QByteArray("\005+1234567890", 12));
+        QList<QNdefRecord> recordList;
+        recordList.append(record);
+        QTest::newRow("chunk payloads empty last chunk")
+                << data << QNdefMessage(recordList)
+                << (QVariantList() << QUrl(QStringLiteral("tel:+1234567890")));
+    }
+
     // Truncated message
     {
         QByteArray type("U");
@@ -733,6 +773,40 @@ void tst_QNdefMessage::parseComplexMessage()
 
 }
 
+void tst_QNdefMessage::decodeIncrementally_data()
+{
+    parseSingleRecordMessage_data();
+}
+
+void tst_QNdefMessage::decodeIncrementally()
+{
+#ifdef QT_BUILD_INTERNAL
+    QFETCH(QByteArray, data);
+    QFETCH(QNdefMessage, message);
+
+    if (QByteArray(QTest::currentDataTag()).startsWith("truncated "))
+        QTest::ignoreMessage(QtWarningMsg, "Unexpected end of message");
+
+    // Feed the data byte by byte, the records must be available as soon as
+    // they are complete
+    QNdefMessageDecoder decoder;
+    QList<QNdefRecord> records;
+    for (qsizetype i = 0; i < data.size(); ++i) {
+        decoder.addData(QByteArrayView(data).sliced(i, 1));
+        records += decoder.takeNewRecords();
+    }
+    decoder.finish();
+    QVERIFY(!decoder.hasNewRecords());
+
+    const QNdefMessage decodedMessage = decoder.takeMessage();
+    QVERIFY(decodedMessage == message);
+    if (decoder.status() == QNdefMessageDecoder::Finished)
+        QVERIFY(QNdefMessage(records) == message);
+#else
+    QSKIP("This test requires a developer build");
+#endif
+}
+
 QTEST_MAIN(tst_QNdefMessage)
 
 #include "tst_qndefmessage.moc"
@@ -79,6 +79,8 @@ private slots:
     void tst_typeInfo();
     void tst_construct();
     void tst_downcast();
+    void tst_lazyDecoding();
+    void tst_chunkedIcon();
 };
 
 tst_QNdefNfcSmartPosterRecord::tst_QNdefNfcSmartPosterRecord()
@@ -538,6 +540,52 @@ void tst_QNdefNfcSmartPosterRecord::tst_downcast()
     QCOMPARE(basePayload, spPayload);
 }
 
+void tst_QNdefNfcSmartPosterRecord::tst_lazyDecoding()
+{
+    QNdefNfcSmartPosterRecord source;
+    source.setUri(QUrl("http://qt.io"));
+    source.addIcon("image/png", QByteArray(1024, 'p'));
+    source.addIcon("image/gif", QByteArray(16, 'g'));
+
+    // The embedded records are decoded from the payload on demand
+    QNdefNfcSmartPosterRecord sprecord(static_cast<const QNdefRecord &>(source));
+    const QNdefNfcSmartPosterRecord copy = sprecord;
+
+    QCOMPARE(sprecord.uri(), QUrl("http://qt.io"));
+    QCOMPARE(sprecord.iconCount(), 2);
+    QVERIFY(sprecord.hasIcon("image/gif"));
+    QVERIFY(!sprecord.hasIcon("image/jpeg"));
+    QCOMPARE(sprecord.icon("image/gif"), QByteArray(16, 'g'));
+    QCOMPARE(sprecord.iconRecord(0).type(), QByteArray("image/png"));
+    QCOMPARE(sprecord.iconRecord(0).data(), QByteArray(1024, 'p'));
+
+    // Modifying a record does not affect its copies
+    QVERIFY(sprecord.removeIcon(QByteArray("image/png")));
+    QCOMPARE(sprecord.iconCount(), 1);
+    QCOMPARE(copy.iconCount(), 2);
+    QCOMPARE(copy.icon(), QByteArray(1024, 'p'));
+    QCOMPARE(copy.iconRecords(), source.iconRecords());
+    QCOMPARE(copy.payload(), source.payload());
+}
+
+void tst_QNdefNfcSmartPosterRecord::tst_chunkedIcon()
+{
+    // A URI record followed by an icon in two chunks
+    const QByteArray data = QByteArray::fromHex("910106550171742e696f")
+            + QByteArray::fromHex("320902") + "image/png" + "ab"
+            + QByteArray::fromHex("560002") + "cd";
+
+    QNdefRecord record;
+    record.setTypeNameFormat(QNdefRecord::NfcRtd);
+    record.setType("Sp");
+    record.setPayload(data);
+
+    QNdefNfcSmartPosterRecord sprecord(record);
+    QCOMPARE(sprecord.uri(), QUrl("http://www.qt.io"));
+    QCOMPARE(sprecord.iconCount(), 1);
+    QCOMPARE(sprecord.icon("image/png"), QByteArray("abcd"));
+}
+
 QTEST_MAIN(tst_QNdefNfcSmartPosterRecord)
 
 #include "tst_qndefnfcsmartposterrecord.moc"
@@ -0,0 +1,147 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+
+#ifdef QT_BUILD_INTERNAL
+#include <QtNfc/private/qnfctlv_p.h>
+#endif
+
+QT_USE_NAMESPACE
+
+class tst_QNfcTlv : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void readTlvs();
+    void readIncrementally();
+    void readAhead();
+    void writeTlvs();
+};
+
+void tst_QNfcTlv::readTlvs()
+{
+#ifdef QT_BUILD_INTERNAL
+    const QByteArray data = QByteArray::fromHex("0000" "0103a00c34" "03ff0100") + QByteArray(256, 'x')
+            + QByteArray::fromHex("fe");
+
+    QNfcTlvReader reader(data);
+    QCOMPARE(reader.readNext(), QNfcTlvReader::Tlv);
+    QCOMPARE(reader.tag(), QNfcTlv::LockControlTlv);
+    QCOMPARE(reader.offset(), 2);
+    QCOMPARE(reader.headerLength(), 2);
+    QCOMPARE(reader.length(), 3);
+    QVERIFY(reader.hasValue());
+    QCOMPARE(reader.value().toByteArray(), QByteArray::fromHex("a00c34"));
+
+    QCOMPARE(reader.readNext(), QNfcTlvReader::Tlv);
+    QCOMPARE(reader.tag(), QNfcTlv::NdefMessageTlv);
+    QCOMPARE(reader.offset(), 7);
+    QCOMPARE(reader.headerLength(), 4);
+    QCOMPARE(reader.valueOffset(), 11);
+    QCOMPARE(reader.length(), 256);
+    QCOMPARE(reader.value().toByteArray(), QByteArray(256, 'x'));
+
+    QCOMPARE(reader.readNext(), QNfcTlvReader::Terminator);
+    QCOMPARE(reader.offset(), data.size() - 1);
+#else
+    QSKIP("This test requires a developer build");
+#endif
+}
+
+void tst_QNfcTlv::readIncrementally()
+{
+#ifdef QT_BUILD_INTERNAL
+    const QByteArray data = QByteArray::fromHex("00" "03ff0005" "0102030405" "fe");
+
+    // Feed the data byte by byte, the header must be available as soon as
+    // it is complete
+    QNfcTlvReader reader;
+    qsizetype size = 0;
+    while (reader.readNext() == QNfcTlvReader::NeedMoreData) {
+        QVERIFY(reader.bytesNeeded() > 0);
+        QVERIFY(size < data.size());
+        reader.setData(QByteArrayView(data).first(++size));
+    }
+    QCOMPARE(size, 5);
+    QCOMPARE(reader.tag(), QNfcTlv::NdefMessageTlv);
+    QCOMPARE(reader.length(), 5);
+    QVERIFY(!reader.hasValue());
+
+    reader.setData(data);
+    QVERIFY(reader.hasValue());
+    QCOMPARE(reader.value().toByteArray(), QByteArray::fromHex("0102030405"));
+    QCOMPARE(reader.readNext(), QNfcTlvReader::Terminator);
+#else
+    QSKIP("This test requires a developer build");
+#endif
+}
+
+void tst_QNfcTlv::readAhead()
+{
+#ifdef QT_BUILD_INTERNAL
+    // A proprietary TLV whose value is not needed to find the next TLV
+    QByteArray data = QByteArray::fromHex("fd20");
+    QNfcTlvReader reader(data);
+    QCOMPARE(reader.readNext(), QNfcTlvReader::Tlv);
+    QCOMPARE(reader.readNext(), QNfcTlvReader::NeedMoreData);
+    QCOMPARE(reader.position(), 34);
+    QCOMPARE(reader.bytesNeeded(), 1);
+
+    // The skipped value is never looked at
+    data.resize(reader.position(), char(0xfe));
+    data.append(QByteArray::fromHex("03"));
+    reader.setData(data);
+    QCOMPARE(reader.readNext(), QNfcTlvReader::NeedMoreData);
+    QCOMPARE(reader.position(), 34);
+    QCOMPARE(reader.bytesNeeded(), 1);
+
+    data.append(QByteArray::fromHex("ff"));
+    reader.setData(data);
+    QCOMPARE(reader.readNext(), QNfcTlvReader::NeedMoreData);
+    QCOMPARE(reader.bytesNeeded(), 2);
+
+    data.append(QByteArray::fromHex("0100"));
+    reader.setData(data);
+    QCOMPARE(reader.readNext(), QNfcTlvReader::Tlv);
+    QCOMPARE(reader.tag(), QNfcTlv::NdefMessageTlv);
+    QCOMPARE(reader.length(), 256);
+#else
+    QSKIP("This test requires a developer build");
+#endif
+}
+
+void tst_QNfcTlv::writeTlvs()
+{
+#ifdef QT_BUILD_INTERNAL
+    QCOMPARE(QNfcTlv::encodedSize(0), 2);
+    QCOMPARE(QNfcTlv::encodedSize(254), 256);
+    QCOMPARE(QNfcTlv::encodedSize(255), 259);
+
+    QByteArray data;
+    QNfcTlvWriter writer(&data);
+    writer.writeTlv(QNfcTlv::NdefMessageTlv, QByteArray::fromHex("d00000"));
+    writer.writeTlv(QNfcTlv::ProprietaryTlv, QByteArray(300, 'x'));
+    writer.writeTerminator();
+
+    QCOMPARE(data.size(), QNfcTlv::encodedSize(3) + QNfcTlv::encodedSize(300) + 1);
+    QCOMPARE(data.first(5), QByteArray::fromHex("0303d00000"));
+    QCOMPARE(data.sliced(5, 4), QByteArray::fromHex("fdff012c"));
+    QCOMPARE(data.back(), char(QNfcTlv::TerminatorTlv));
+
+    // What is written can be read back
+    QNfcTlvReader reader(data);
+    QCOMPARE(reader.readNext(), QNfcTlvReader::Tlv);
+    QCOMPARE(reader.value().toByteArray(), QByteArray::fromHex("d00000"));
+    QCOMPARE(reader.readNext(), QNfcTlvReader::Tlv);
+    QCOMPARE(reader.value().toByteArray(), QByteArray(300, 'x'));
+    QCOMPARE(reader.readNext(), QNfcTlvReader::Terminator);
+#else
+    QSKIP("This test requires a developer build");
+#endif
+}
+
+QTEST_MAIN(tst_QNfcTlv)
+
+#include "tst_qnfctlv.moc"
@@ -0,0 +1,333 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QTest>
+
+#include <QtBluetooth/private/attpdu_p.h>
+
+QT_USE_NAMESPACE
+
+using AttCommand = QBluezConst::AttCommand;
+
+class tst_bench_QLowEnergyAttPdu : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void encode_data();
+    void encode();
+    void decode_data();
+    void decode();
+};
+
+static const struct {
+    AttCommand opcode;
+    const char *name;
+} opcodes[] = {
+    { AttCommand::ATT_OP_ERROR_RESPONSE, "ERROR_RESPONSE" },
+    { AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST, "EXCHANGE_MTU_REQUEST" },
+    { AttCommand::ATT_OP_EXCHANGE_MTU_RESPONSE, "EXCHANGE_MTU_RESPONSE" },
+    { AttCommand::ATT_OP_FIND_INFORMATION_REQUEST, "FIND_INFORMATION_REQUEST" },
+    { AttCommand::ATT_OP_FIND_INFORMATION_RESPONSE, "FIND_INFORMATION_RESPONSE" },
+    { AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_REQUEST, "FIND_BY_TYPE_VALUE_REQUEST" },
+    { AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_RESPONSE, "FIND_BY_TYPE_VALUE_RESPONSE" },
+    { AttCommand::ATT_OP_READ_BY_TYPE_REQUEST, "READ_BY_TYPE_REQUEST" },
+    { AttCommand::ATT_OP_READ_BY_TYPE_RESPONSE, "READ_BY_TYPE_RESPONSE" },
+    { AttCommand::ATT_OP_READ_REQUEST, "READ_REQUEST" },
+    { AttCommand::ATT_OP_READ_RESPONSE, "READ_RESPONSE" },
+    { AttCommand::ATT_OP_READ_BLOB_REQUEST, "READ_BLOB_REQUEST" },
+    { AttCommand::ATT_OP_READ_BLOB_RESPONSE, "READ_BLOB_RESPONSE" },
+    { AttCommand::ATT_OP_READ_MULTIPLE_REQUEST, "READ_MULTIPLE_REQUEST" },
+    { AttCommand::ATT_OP_READ_MULTIPLE_RESPONSE, "READ_MULTIPLE_RESPONSE" },
+    { AttCommand::ATT_OP_READ_BY_GROUP_REQUEST, "READ_BY_GROUP_REQUEST" },
+    { AttCommand::ATT_OP_READ_BY_GROUP_RESPONSE, "READ_BY_GROUP_RESPONSE" },
+    { AttCommand::ATT_OP_WRITE_REQUEST, "WRITE_REQUEST" },
+    { AttCommand::ATT_OP_WRITE_RESPONSE, "WRITE_RESPONSE" },
+    { AttCommand::ATT_OP_PREPARE_WRITE_REQUEST, "PREPARE_WRITE_REQUEST" },
+    { AttCommand::ATT_OP_PREPARE_WRITE_RESPONSE, "PREPARE_WRITE_RESPONSE" },
+    { AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST, "EXECUTE_WRITE_REQUEST" },
+    { AttCommand::ATT_OP_EXECUTE_WRITE_RESPONSE, "EXECUTE_WRITE_RESPONSE" },
+    { AttCommand::ATT_OP_HANDLE_VAL_NOTIFICATION, "HANDLE_VAL_NOTIFICATION" },
+    { AttCommand::ATT_OP_HANDLE_VAL_INDICATION, "HANDLE_VAL_INDICATION" },
+    { AttCommand::ATT_OP_HANDLE_VAL_CONFIRMATION, "HANDLE_VAL_CONFIRMATION" },
+    { AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST, "READ_MULTIPLE_VARIABLE_REQUEST" },
+    { AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_RESPONSE, "READ_MULTIPLE_VARIABLE_RESPONSE" },
+    { AttCommand::ATT_OP_WRITE_COMMAND, "WRITE_COMMAND" },
+    { AttCommand::ATT_OP_SIGNED_WRITE_COMMAND, "SIGNED_WRITE_COMMAND" },
+};
+
+// the default LE MTU, the common maxima of iOS and Android, and the largest ATT MTU
+static const quint16 mtus[] = { 23, 185, 247, 517 };
+
+static const QBluetoothUuid serviceUuid(QStringLiteral("e8e10f95-1a70-4b27-9ccf-02010264e9c8"));
+
+// Builds the largest PDU of the given type which fits into the MTU,
+// list responses are filled with as many elements as possible.
+static void encodePdu(QByteArray &pdu, AttCommand opcode, quint16 mtu, QByteArrayView value)
+{
+    switch (opcode) {
+    case AttCommand::ATT_OP_ERROR_RESPONSE:
+        QBluezAtt::buildErrorResponse(pdu, AttCommand::ATT_OP_READ_REQUEST, 0x0010,
+                                      QBluezConst::AttError::ATT_ERROR_ATTRIBUTE_NOT_FOUND);
+        break;
+    case AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST:
+    case AttCommand::ATT_OP_EXCHANGE_MTU_RESPONSE:
+        QBluezAtt::buildMtu(pdu, opcode, mtu);
+        break;
+    case AttCommand::ATT_OP_FIND_INFORMATION_REQUEST:
+        QBluezAtt::buildHandleRangeRequest(pdu, opcode, 0x0001, 0xffff);
+        break;
+    case AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_REQUEST: {
+        char uuid[16];
+        const qsizetype uuidSize = QBluezAtt::putUuid(serviceUuid, uuid);
+        QBluezAtt::buildFindByTypeValueRequest(pdu, 0x0001, 0xffff, 0x2800,
+                                               QByteArrayView(uuid, uuidSize));
+    } break;
+    case AttCommand::ATT_OP_READ_BY_TYPE_REQUEST:
+        QBluezAtt::buildHandleRangeRequest(pdu, opcode, 0x0001, 0xffff,
+                                           QBluetoothUuid(quint16(0x2803)));
+        break;
+    case AttCommand::ATT_OP_READ_BY_GROUP_REQUEST:
+        QBluezAtt::buildHandleRangeRequest(pdu, opcode, 0x0001, 0xffff,
+                                           QBluetoothUuid(quint16(0x2800)));
+        break;
+    case AttCommand::ATT_OP_READ_REQUEST:
+        QBluezAtt::buildHandleValue(pdu, opcode, 0x0010);
+        break;
+    case AttCommand::ATT_OP_READ_BLOB_REQUEST:
+        QBluezAtt::buildHandleOffsetValue(pdu, opcode, 0x0010, mtu - 1);
+        break;
+    case AttCommand::ATT_OP_READ_MULTIPLE_REQUEST:
+    case AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST: {
+        quint16 handles[(517 - 1) / 2];
+        const qsizetype count = (mtu - 1) / 2;
+        for (qsizetype i = 0; i < count; ++i)
+            handles[i] = quint16(0x0010 + 2 * i);
+        QBluezAtt::buildHandleList(pdu, opcode, handles, count);
+    } break;
+    case AttCommand::ATT_OP_WRITE_REQUEST:
+    case AttCommand::ATT_OP_WRITE_COMMAND:
+    case AttCommand::ATT_OP_SIGNED_WRITE_COMMAND:
+    case AttCommand::ATT_OP_HANDLE_VAL_NOTIFICATION:
+    case AttCommand::ATT_OP_HANDLE_VAL_INDICATION:
+        QBluezAtt::buildHandleValue(pdu, opcode, 0x0010, value, mtu);
+        break;
+    case AttCommand::ATT_OP_PREPARE_WRITE_REQUEST:
+    case AttCommand::ATT_OP_PREPARE_WRITE_RESPONSE:
+        QBluezAtt::buildHandleOffsetValue(pdu, opcode, 0x0010, 0, value, mtu);
+        break;
+    case AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST:
+        QBluezAtt::buildExecuteWriteRequest(pdu, true);
+        break;
+    case AttCommand::ATT_OP_WRITE_RESPONSE:
+    case AttCommand::ATT_OP_EXECUTE_WRITE_RESPONSE:
+    case AttCommand::ATT_OP_HANDLE_VAL_CONFIRMATION:
+        QBluezAtt::buildOpcode(pdu, opcode);
+        break;
+    case AttCommand::ATT_OP_READ_RESPONSE:
+    case AttCommand::ATT_OP_READ_BLOB_RESPONSE:
+    case AttCommand::ATT_OP_READ_MULTIPLE_RESPONSE:
+        QBluezAtt::buildValue(pdu, opcode, value, mtu);
+        break;
+    case AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_RESPONSE:
+        QBluezAtt::buildOpcode(pdu, opcode);
+        while (QBluezAtt::appendLengthValue(pdu, value.first(20), mtu)) {}
+        break;
+    case AttCommand::ATT_OP_FIND_INFORMATION_RESPONSE: {
+        // descriptor handles with 16 bit UUIDs
+        QBluezAtt::AttributeDataListBuilder builder(pdu, opcode, 4, mtu);
+        quint16 handle = 0x0010;
+        while (char *data = builder.appendElement()) {
+            putBtData(handle++, data);
+            putBtData(quint16(0x2902), data + 2);
+        }
+    } break;
+    case AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_RESPONSE: {
+        QBluezAtt::AttributeDataListBuilder builder(pdu, opcode, 4, mtu);
+        quint16 handle = 0x0010;
+        while (char *data = builder.appendElement()) {
+            putBtData(handle, data);
+            putBtData(quint16(handle + 7), data + 2);
+            handle += 8;
+        }
+    } break;
+    case AttCommand::ATT_OP_READ_BY_TYPE_RESPONSE: {
+        // characteristic declarations with 128 bit UUIDs
+        QBluezAtt::AttributeDataListBuilder builder(pdu, opcode, 21, mtu);
+        quint16 handle = 0x0010;
+        while (char *data = builder.appendElement()) {
+            putBtData(handle, data);
+            data[2] = 0x1a;
+            putBtData(quint16(handle + 1), data + 3);
+            QBluezAtt::putUuid(serviceUuid, data + 5);
+            handle += 3;
+        }
+    } break;
+    case AttCommand::ATT_OP_READ_BY_GROUP_RESPONSE: {
+        // services with 16 bit UUIDs
+        QBluezAtt::AttributeDataListBuilder builder(pdu, opcode, 6, mtu);
+        quint16 handle = 0x0001;
+        while (char *data = builder.appendElement()) {
+            putBtData(handle, data);
+            putBtData(quint16(handle + 7), data + 2);
+            putBtData(quint16(0x180f), data + 4);
+            handle += 8;
+        }
+    } break;
+    }
+}
+
+// Decodes the PDU the way the controller does and folds the result into a checksum
+static quint32 decodePdu(QByteArrayView pdu)
+{
+    const AttCommand opcode = QBluezAtt::opcode(pdu);
+    quint32 checksum = quint8(opcode);
+    switch (opcode) {
+    case AttCommand::ATT_OP_ERROR_RESPONSE: {
+        QBluezAtt::ErrorResponse error;
+        if (QBluezAtt::parseErrorResponse(pdu, &error))
+            checksum += error.handle + quint8(error.code);
+    } break;
+    case AttCommand::ATT_OP_EXCHANGE_MTU_REQUEST:
+    case AttCommand::ATT_OP_EXCHANGE_MTU_RESPONSE: {
+        quint16 mtu = 0;
+        if (QBluezAtt::parseMtu(pdu, &mtu))
+            checksum += mtu;
+    } break;
+    case AttCommand::ATT_OP_FIND_INFORMATION_REQUEST:
+    case AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_REQUEST:
+    case AttCommand::ATT_OP_READ_BY_TYPE_REQUEST:
+    case AttCommand::ATT_OP_READ_BY_GROUP_REQUEST: {
+        QBluezAtt::HandleRangeRequest range;
+        if (!QBluezAtt::parseHandleRangeRequest(pdu, &range))
+            break;
+        checksum += range.startingHandle + range.endingHandle;
+        if (opcode == AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_REQUEST)
+            checksum += range.tail.size();
+        else
+            checksum += QBluezAtt::uuidFromData(range.tail).minimumSize();
+    } break;
+    case AttCommand::ATT_OP_READ_REQUEST:
+    case AttCommand::ATT_OP_READ_BLOB_REQUEST:
+    case AttCommand::ATT_OP_WRITE_REQUEST:
+    case AttCommand::ATT_OP_WRITE_COMMAND:
+    case AttCommand::ATT_OP_SIGNED_WRITE_COMMAND:
+    case AttCommand::ATT_OP_PREPARE_WRITE_REQUEST:
+    case AttCommand::ATT_OP_PREPARE_WRITE_RESPONSE:
+    case AttCommand::ATT_OP_HANDLE_VAL_NOTIFICATION:
+    case AttCommand::ATT_OP_HANDLE_VAL_INDICATION: {
+        QBluezAtt::HandleValue handleValue;
+        if (QBluezAtt::parseHandleValue(pdu, &handleValue))
+            checksum += handleValue.handle + handleValue.offset + handleValue.value.size();
+    } break;
+    case AttCommand::ATT_OP_READ_MULTIPLE_REQUEST:
+    case AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_REQUEST:
+        for (qsizetype i = 0; i < QBluezAtt::handleCount(pdu); ++i)
+            checksum += QBluezAtt::handleAt(pdu, i);
+        break;
+    case AttCommand::ATT_OP_EXECUTE_WRITE_REQUEST:
+        checksum += quint8(pdu.at(1));
+        break;
+    case AttCommand::ATT_OP_WRITE_RESPONSE:
+    case AttCommand::ATT_OP_EXECUTE_WRITE_RESPONSE:
+    case AttCommand::ATT_OP_HANDLE_VAL_CONFIRMATION:
+        break;
+    case AttCommand::ATT_OP_READ_RESPONSE:
+    case AttCommand::ATT_OP_READ_BLOB_RESPONSE:
+    case AttCommand::ATT_OP_READ_MULTIPLE_RESPONSE:
+        checksum += pdu.size() - 1;
+        break;
+    case AttCommand::ATT_OP_READ_MULTIPLE_VARIABLE_RESPONSE: {
+        QByteArrayView tuples = pdu.sliced(1);
+        QByteArrayView value;
+        quint16 length = 0;
+        while (QBluezAtt::takeLengthValue(&tuples, &value, &length))
+            checksum += length + value.size();
+    } break;
+    case AttCommand::ATT_OP_FIND_INFORMATION_RESPONSE:
+        for (const QByteArrayView element : QBluezAtt::AttributeDataList(pdu)) {
+            checksum += bt_get_le16(element.data());
+            checksum += QBluezAtt::uuidFromData(element.sliced(2)).minimumSize();
+        }
+        break;
+    case AttCommand::ATT_OP_FIND_BY_TYPE_VALUE_RESPONSE:
+        for (const QByteArrayView element : QBluezAtt::AttributeDataList(pdu))
+            checksum += bt_get_le16(element.data()) + bt_get_le16(element.data() + 2);
+        break;
+    case AttCommand::ATT_OP_READ_BY_TYPE_RESPONSE:
+        for (const QByteArrayView element : QBluezAtt::AttributeDataList(pdu)) {
+            QBluezAtt::CharacteristicDeclaration declaration;
+            if (QBluezAtt::parseCharacteristicDeclaration(element, &declaration))
+                checksum += declaration.valueHandle + declaration.uuid.minimumSize();
+        }
+        break;
+    case AttCommand::ATT_OP_READ_BY_GROUP_RESPONSE:
+        for (const QByteArrayView element : QBluezAtt::AttributeDataList(pdu)) {
+            QBluezAtt::GroupData group;
+            if (QBluezAtt::parseGroupData(element, &group))
+                checksum += group.endingHandle + QBluezAtt::uuidFromData(group.value).minimumSize();
+        }
+        break;
+    }
+    return checksum;
+}
+
+static void addPduRows()
+{
+    // plain ints, the QBluezConst meta object is not exported
+    QTest::addColumn<int>("opcode");
+    QTest::addColumn<int>("mtu");
+
+    for (const auto &entry : opcodes) {
+        for (quint16 mtu : mtus) {
+            const QByteArray name = QByteArray(entry.name) + " MTU " + QByteArray::number(mtu);
+            QTest::newRow(name.constData()) << int(entry.opcode) << int(mtu);
+        }
+    }
+}
+
+void tst_bench_QLowEnergyAttPdu::encode_data()
+{
+    addPduRows();
+}
+
+void tst_bench_QLowEnergyAttPdu::encode()
+{
+    QFETCH(int, opcode);
+    QFETCH(int, mtu);
+
+    const QByteArray value(512, 'v');
+
+    // the buffer is reused, as the controller does for its PDUs
+    QByteArray pdu;
+    pdu.reserve(mtu);
+    QBENCHMARK {
+        encodePdu(pdu, AttCommand(opcode), mtu, value);
+    }
+    QCOMPARE(int(QBluezAtt::opcode(pdu)), opcode);
+    QVERIFY(pdu.size() <= mtu);
+}
+
+void tst_bench_QLowEnergyAttPdu::decode_data()
+{
+    addPduRows();
+}
+
+void tst_bench_QLowEnergyAttPdu::decode()
+{
+    QFETCH(int, opcode);
+    QFETCH(int, mtu);
+
+    QByteArray pdu;
+    encodePdu(pdu, AttCommand(opcode), mtu, QByteArray(512, 'v'));
+
+    quint32 checksum = 0;
+    QBENCHMARK {
+        checksum = decodePdu(pdu);
+    }
+    QVERIFY(checksum > quint32(opcode) || pdu.size() == 1);
+}
+
+QTEST_MAIN(tst_bench_QLowEnergyAttPdu)
+
+#include "tst_bench_qlowenergyattpdu.moc"
@@ -0,0 +1,121 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QTest>
+
+#include <QNdefFilter>
+#include <QNdefMessage>
+#include <QNdefNfcTextRecord>
+#include <QNdefNfcUriRecord>
+
+QT_USE_NAMESPACE
+
+class tst_bench_QNdefFilter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void match_data();
+    void match();
+    void matchManyFilters_data();
+    void matchManyFilters();
+};
+
+static QByteArray recordType(int i)
+{
+    return "application/x-type-" + QByteArray::number(i);
+}
+
+static QNdefMessage createMessage(int recordCount)
+{
+    QNdefMessage message;
+    for (int i = 0; i < recordCount; ++i) {
+        QNdefRecord record;
+        record.setTypeNameFormat(QNdefRecord::Mime);
+        record.setType(recordType(i % 4));
+        record.setPayload(QByteArray(16, char(i)));
+        message.append(record);
+    }
+    return message;
+}
+
+void tst_bench_QNdefFilter::match_data()
+{
+    QTest::addColumn<int>("recordCount");
+    QTest::addColumn<bool>("orderMatch");
+
+    for (int recordCount : { 1, 10, 100 }) {
+        const QByteArray name = QByteArray::number(recordCount) + " records";
+        QTest::newRow((name + ", unordered").constData()) << recordCount << false;
+        QTest::newRow((name + ", ordered").constData()) << recordCount << true;
+    }
+}
+
+void tst_bench_QNdefFilter::match()
+{
+    QFETCH(int, recordCount);
+    QFETCH(bool, orderMatch);
+
+    const QNdefMessage message = createMessage(recordCount);
+
+    // Every record type of the message, in the order of the message
+    QNdefFilter filter;
+    filter.setOrderMatch(orderMatch);
+    if (orderMatch) {
+        for (int i = 0; i < recordCount; ++i)
+            filter.appendRecord(QNdefRecord::Mime, recordType(i % 4), 1, 1);
+    } else {
+        for (int i = 0; i < qMin(recordCount, 4); ++i)
+            filter.appendRecord(QNdefRecord::Mime, recordType(i), 0, recordCount);
+    }
+
+    bool matched = false;
+    QBENCHMARK {
+        matched = filter.match(message);
+    }
+    QVERIFY(matched);
+}
+
+void tst_bench_QNdefFilter::matchManyFilters_data()
+{
+    QTest::addColumn<int>("filterCount");
+
+    QTest::newRow("10 filters") << 10;
+    QTest::newRow("100 filters") << 100;
+    QTest::newRow("1000 filters") << 1000;
+}
+
+void tst_bench_QNdefFilter::matchManyFilters()
+{
+    QFETCH(int, filterCount);
+
+    QNdefMessage message;
+    message.append(QNdefNfcUriRecord());
+    message.append(QNdefNfcTextRecord());
+
+    // Like a dispatcher that has registered handlers for many message types,
+    // only the last one matches
+    QList<QNdefFilter> filters;
+    for (int i = 0; i < filterCount - 1; ++i) {
+        QNdefFilter filter;
+        filter.appendRecord<QNdefNfcUriRecord>();
+        filter.appendRecord(QNdefRecord::Mime, recordType(i));
+        filters.append(filter);
+    }
+    QNdefFilter filter;
+    filter.appendRecord<QNdefNfcUriRecord>();
+    filter.appendRecord<QNdefNfcTextRecord>();
+    filters.append(filter);
+
+    qsizetype matches = 0;
+    QBENCHMARK {
+        matches = 0;
+        for (const QNdefFilter &f : std::as_const(filters))
+            matches += f.match(message) ? 1 : 0;
+    }
+    QCOMPARE(matches, 1);
+}
+
+QTEST_MAIN(tst_bench_QNdefFilter)
+
+#include "tst_bench_qndeffilter.moc"
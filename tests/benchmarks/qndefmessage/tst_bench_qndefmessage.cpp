@@ -0,0 +1,198 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QTest>
+
+#include <QNdefMessage>
+#include <QNdefNfcSmartPosterRecord>
+#include <QNdefNfcTextRecord>
+#include <QNdefNfcUriRecord>
+
+QT_USE_NAMESPACE
+
+class tst_bench_QNdefMessage : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fromByteArray_data();
+    void fromByteArray();
+    void toByteArray_data();
+    void toByteArray();
+
+    void fromByteArrayChunked_data();
+    void fromByteArrayChunked();
+
+    void smartPoster_data();
+    void smartPoster();
+};
+
+static QNdefMessage createMessage(int recordCount, int payloadSize)
+{
+    QNdefMessage message;
+    for (int i = 0; i < recordCount; ++i) {
+        QNdefRecord record;
+        record.setTypeNameFormat(QNdefRecord::Mime);
+        record.setType("application/octet-stream");
+        record.setPayload(QByteArray(payloadSize, char(i)));
+        message.append(record);
+    }
+    return message;
+}
+
+// Splits the payload of a single MIME record into chunks of chunkSize bytes
+static QByteArray createChunkedMessage(int payloadSize, int chunkSize)
+{
+    const QByteArray type = "application/octet-stream";
+
+    QByteArray data;
+    for (int offset = 0; offset < payloadSize; offset += chunkSize) {
+        const int length = qMin(chunkSize, payloadSize - offset);
+        const bool first = offset == 0;
+        const bool last = offset + length == payloadSize;
+
+        quint8 flags = first ? 0x80 | QNdefRecord::Mime : 0x06;
+        if (last)
+            flags |= 0x40;
+        else
+            flags |= 0x20;
+        if (length < 256)
+            flags |= 0x10;
+
+        data.append(char(flags));
+        data.append(char(first ? type.size() : 0));
+        if (length < 256) {
+            data.append(char(length));
+        } else {
+            data.append(char(length >> 24));
+            data.append(char(length >> 16));
+            data.append(char(length >> 8));
+            data.append(char(length));
+        }
+        if (first)
+            data.append(type);
+        data.append(QByteArray(length, 'x'));
+    }
+    return data;
+}
+
+static QNdefNfcSmartPosterRecord createSmartPoster(int iconSize)
+{
+    QNdefNfcSmartPosterRecord poster;
+    poster.addTitle(QStringLiteral("Qt"), QStringLiteral("en"), QNdefNfcTextRecord::Utf8);
+    poster.addTitle(QStringLiteral("Qt"), QStringLiteral("de"), QNdefNfcTextRecord::Utf8);
+    poster.setUri(QUrl(QStringLiteral("https://www.qt.io")));
+    poster.setAction(QNdefNfcSmartPosterRecord::DoAction);
+    poster.setSize(1024);
+    poster.setTypeInfo(QStringLiteral("text/html"));
+    if (iconSize > 0)
+        poster.addIcon("image/png", QByteArray(iconSize, 'i'));
+    return poster;
+}
+
+static void addMessageRows()
+{
+    QTest::addColumn<int>("recordCount");
+    QTest::addColumn<int>("payloadSize");
+
+    for (int recordCount : { 1, 10, 100 }) {
+        for (int payloadSize : { 16, 255, 4096 }) {
+            const QByteArray name = QByteArray::number(recordCount) + " records of "
+                    + QByteArray::number(payloadSize) + " bytes";
+            QTest::newRow(name.constData()) << recordCount << payloadSize;
+        }
+    }
+}
+
+void tst_bench_QNdefMessage::fromByteArray_data()
+{
+    addMessageRows();
+}
+
+void tst_bench_QNdefMessage::fromByteArray()
+{
+    QFETCH(int, recordCount);
+    QFETCH(int, payloadSize);
+
+    const QByteArray data = createMessage(recordCount, payloadSize).toByteArray();
+
+    QNdefMessage message;
+    QBENCHMARK {
+        message = QNdefMessage::fromByteArray(data);
+    }
+    QCOMPARE(message.size(), recordCount);
+}
+
+void tst_bench_QNdefMessage::toByteArray_data()
+{
+    addMessageRows();
+}
+
+void tst_bench_QNdefMessage::toByteArray()
+{
+    QFETCH(int, recordCount);
+    QFETCH(int, payloadSize);
+
+    const QNdefMessage message = createMessage(recordCount, payloadSize);
+
+    QByteArray data;
+    QBENCHMARK {
+        data = message.toByteArray();
+    }
+    QVERIFY(data.size() > recordCount * payloadSize);
+}
+
+void tst_bench_QNdefMessage::fromByteArrayChunked_data()
+{
+    QTest::addColumn<int>("payloadSize");
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("4 KiB in 16 byte chunks") << 4096 << 16;
+    QTest::newRow("4 KiB in 255 byte chunks") << 4096 << 255;
+    QTest::newRow("64 KiB in 255 byte chunks") << 65536 << 255;
+    QTest::newRow("64 KiB in 4 KiB chunks") << 65536 << 4096;
+}
+
+void tst_bench_QNdefMessage::fromByteArrayChunked()
+{
+    QFETCH(int, payloadSize);
+    QFETCH(int, chunkSize);
+
+    const QByteArray data = createChunkedMessage(payloadSize, chunkSize);
+
+    QNdefMessage message;
+    QBENCHMARK {
+        message = QNdefMessage::fromByteArray(data);
+    }
+    QCOMPARE(message.size(), 1);
+    QCOMPARE(message.first().payload().size(), payloadSize);
+}
+
+void tst_bench_QNdefMessage::smartPoster_data()
+{
+    QTest::addColumn<int>("iconSize");
+
+    QTest::newRow("no icon") << 0;
+    QTest::newRow("1 KiB icon") << 1024;
+    QTest::newRow("32 KiB icon") << 32768;
+}
+
+void tst_bench_QNdefMessage::smartPoster()
+{
+    QFETCH(int, iconSize);
+
+    const QByteArray data = QNdefMessage(createSmartPoster(iconSize)).toByteArray();
+
+    // Decode the message and look at the URI, as a tag reading application would
+    QUrl uri;
+    QBENCHMARK {
+        const QNdefMessage message = QNdefMessage::fromByteArray(data);
+        const QNdefNfcSmartPosterRecord poster(message.first());
+        uri = poster.uri();
+    }
+    QCOMPARE(uri, QUrl(QStringLiteral("https://www.qt.io")));
+}
+
+QTEST_MAIN(tst_bench_QNdefMessage)
+
+#include "tst_bench_qndefmessage.moc"
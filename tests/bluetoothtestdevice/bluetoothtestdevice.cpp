@@ -12,6 +12,7 @@
 #include <QLowEnergyServiceData>
 #include <QLowEnergyDescriptorData>
 #include <QTimer>
+#include <QtEndian>
 
 #if defined(Q_OS_ANDROID) || defined(Q_OS_IOS)
 #include <QGuiApplication>
@@ -44,6 +45,19 @@ static const QLatin1String connectionCountCharUuid("9414ec2d-792f-46a2-a19e-186d
 static const QLatin1String mtuServiceUuid("9a9483eb-cf4f-4c32-9a6b-794238d5b483");
 static const QLatin1String mtuCharUuid("960d7e2a-a850-4a70-8064-cd74e9ccb6ff");
 
+// Used by tests/manual/qlowenergycontroller-throughput, see the service definition below
+static const QLatin1String throughputServiceUuid("5e0c4a41-3c4b-4b2f-9d57-7f1e0a6c2b10");
+static const QLatin1String throughputControlCharUuid("5e0c4a42-3c4b-4b2f-9d57-7f1e0a6c2b10");
+static const QLatin1String throughputNotifyCharUuid("5e0c4a43-3c4b-4b2f-9d57-7f1e0a6c2b10");
+static const QLatin1String throughputSinkCharUuid("5e0c4a44-3c4b-4b2f-9d57-7f1e0a6c2b10");
+static const QLatin1String throughputCounterCharUuid("5e0c4a45-3c4b-4b2f-9d57-7f1e0a6c2b10");
+
+// commands written to the throughput control characteristic
+static constexpr char throughputStartNotifications = 0x01; // followed by u32 count, u16 size
+static constexpr char throughputResetCounter = 0x02;
+// notifications sent per event loop iteration during a burst
+static constexpr int throughputBurstSize = 16;
+
 int main(int argc, char *argv[])
 {
     qDebug() << "build:" << __DATE__ << __TIME__;
@@ -203,6 +217,67 @@ int main(int argc, char *argv[])
         serviceDefinitions << serviceData;
     }
 
+    {
+        // throughput service
+        //
+        // This is a service which offers:
+        //   - a control characteristic, writing the start command makes the server send
+        //     the requested number of notifications of the requested size back-to-back,
+        //     writing the reset command clears the counter
+        //   - the characteristic those notifications are sent for
+        //   - a sink characteristic which takes writes with and without response
+        //   - a counter characteristic with the number of writes (u32) and bytes (u32)
+        //     the sink received since the last reset
+        QLowEnergyServiceData serviceData;
+        serviceData.setType(QLowEnergyServiceData::ServiceTypePrimary);
+        serviceData.setUuid(QBluetoothUuid(throughputServiceUuid));
+
+        {
+            QLowEnergyCharacteristicData charData;
+            charData.setUuid(QBluetoothUuid(throughputControlCharUuid));
+            charData.setValue(QByteArray(7, 0));
+            charData.setValueLength(1, 7);
+            charData.setProperties(QLowEnergyCharacteristic::PropertyType::Write);
+
+            serviceData.addCharacteristic(charData);
+        }
+        {
+            QLowEnergyCharacteristicData charData;
+            charData.setUuid(QBluetoothUuid(throughputNotifyCharUuid));
+            charData.setValue(QByteArray(4, 0));
+            charData.setValueLength(4, 512);
+            charData.setProperties(QLowEnergyCharacteristic::PropertyType::Notify);
+
+            const QLowEnergyDescriptorData clientConfig(
+                    QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration,
+                    QLowEnergyCharacteristic::CCCDDisable);
+            charData.addDescriptor(clientConfig);
+
+            serviceData.addCharacteristic(charData);
+        }
+        {
+            QLowEnergyCharacteristicData charData;
+            charData.setUuid(QBluetoothUuid(throughputSinkCharUuid));
+            charData.setValue(QByteArray());
+            charData.setValueLength(0, 512);
+            charData.setProperties(QLowEnergyCharacteristic::PropertyType::Write
+                                   | QLowEnergyCharacteristic::PropertyType::WriteNoResponse);
+
+            serviceData.addCharacteristic(charData);
+        }
+        {
+            QLowEnergyCharacteristicData charData;
+            charData.setUuid(QBluetoothUuid(throughputCounterCharUuid));
+            charData.setValue(QByteArray(8, 0));
+            charData.setValueLength(8, 8);
+            charData.setProperties(QLowEnergyCharacteristic::PropertyType::Read);
+
+            serviceData.addCharacteristic(charData);
+        }
+
+        serviceDefinitions << serviceData;
+    }
+
     {
         // server's platform identifier service
         QLowEnergyServiceData serviceData;
@@ -281,11 +356,84 @@ int main(int argc, char *argv[])
         services.emplaceBack(leController->addService(serviceData));
     }
 
+    // throughput service state, the service is at index 4
+    quint32 sinkWrites = 0;
+    quint32 sinkBytes = 0;
+    quint32 pendingNotifications = 0;
+    quint32 sentNotifications = 0;
+    QByteArray notificationValue;
+    QTimer notificationBurstTimer;
+    notificationBurstTimer.setInterval(0);
+
+    const auto updateSinkCounter = [&services, &sinkWrites, &sinkBytes]() {
+        QByteArray value(8, Qt::Uninitialized);
+        qToLittleEndian(sinkWrites, value.data());
+        qToLittleEndian(sinkBytes, value.data() + 4);
+        const QLowEnergyCharacteristic characteristic = services[4]->characteristic(
+                QBluetoothUuid(throughputCounterCharUuid));
+        Q_ASSERT(characteristic.isValid());
+        services[4]->writeCharacteristic(characteristic, value);
+    };
+
+    QObject::connect(&notificationBurstTimer, &QTimer::timeout,
+                     [&]() {
+        const QLowEnergyCharacteristic characteristic = services[4]->characteristic(
+                QBluetoothUuid(throughputNotifyCharUuid));
+        Q_ASSERT(characteristic.isValid());
+        for (int i = 0; i < throughputBurstSize && pendingNotifications > 0; ++i) {
+            // the sequence number lets the client detect lost notifications
+            qToLittleEndian(sentNotifications++, notificationValue.data());
+            services[4]->writeCharacteristic(characteristic, notificationValue);
+            --pendingNotifications;
+        }
+        if (pendingNotifications == 0)
+            notificationBurstTimer.stop();
+    });
+
+    const auto setupThroughputService = [&]() {
+        Q_ASSERT(services[4]->serviceUuid() == QBluetoothUuid(throughputServiceUuid));
+        notificationBurstTimer.stop();
+        pendingNotifications = 0;
+        sinkWrites = 0;
+        sinkBytes = 0;
+
+        QObject::connect(services[4].data(), &QLowEnergyService::characteristicChanged,
+                         [&](const QLowEnergyCharacteristic &characteristic,
+                             const QByteArray &value) {
+            if (characteristic.uuid() == QBluetoothUuid(throughputSinkCharUuid)) {
+                ++sinkWrites;
+                sinkBytes += quint32(value.size());
+                updateSinkCounter();
+                return;
+            }
+            if (characteristic.uuid() != QBluetoothUuid(throughputControlCharUuid)
+                    || value.isEmpty()) {
+                return;
+            }
+
+            if (value.at(0) == throughputStartNotifications && value.size() >= 7) {
+                pendingNotifications = qFromLittleEndian<quint32>(value.constData() + 1);
+                const quint16 size = qFromLittleEndian<quint16>(value.constData() + 5);
+                notificationValue = QByteArray(qBound(4, int(size), 512), 0x5a);
+                sentNotifications = 0;
+                qDebug() << "Sending" << pendingNotifications << "notifications of size"
+                         << notificationValue.size();
+                notificationBurstTimer.start();
+            } else if (value.at(0) == throughputResetCounter) {
+                sinkWrites = 0;
+                sinkBytes = 0;
+                updateSinkCounter();
+            }
+        });
+    };
+    setupThroughputService();
+
     leController->startAdvertising(QLowEnergyAdvertisingParameters(), advertisingData,
                                    advertisingData);
 
 
-    auto reconnect = [&connectioncount, &leController, advertisingData, &services, serviceDefinitions]() {
+    auto reconnect = [&connectioncount, &leController, advertisingData, &services, serviceDefinitions,
+                      setupThroughputService]() {
         connectioncount++;
         for (qsizetype i = 0; i < services.size(); ++i) {
             services[i].reset(leController->addService(serviceDefinitions[i]));
@@ -308,6 +456,9 @@ int main(int argc, char *argv[])
             allValid = allValid & !service.isNull();
         }
 
+        if (allValid)
+            setupThroughputService();
+
         if (allValid){
             leController->startAdvertising(QLowEnergyAdvertisingParameters(), advertisingData,
                                            advertisingData);
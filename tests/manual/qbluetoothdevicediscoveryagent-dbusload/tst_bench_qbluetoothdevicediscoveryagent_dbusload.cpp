@@ -0,0 +1,729 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QObject>
+#include <QtGlobal>
+#include <QTest>
+#include <QBluetoothDeviceDiscoveryAgent>
+#include <QBluetoothUuid>
+#include <QDBusConnection>
+#include <QDBusMetaType>
+#include <QDBusObjectPath>
+#include <QDBusVariant>
+#include <QDBusVirtualObject>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QProcess>
+#include <QSignalSpy>
+#include <QThread>
+#include <QTimer>
+#include <QtEndian>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <sys/resource.h>
+
+typedef QMap<QString, QVariantMap> InterfaceList;
+typedef QMap<QDBusObjectPath, InterfaceList> ManagedObjectList;
+typedef QMap<quint16, QDBusVariant> ManufacturerDataList;
+
+static const QLatin1String bluezService("org.bluez");
+static const QLatin1String adapterPath("/org/bluez/hci0");
+static const QLatin1String adapterInterface("org.bluez.Adapter1");
+static const QLatin1String deviceInterface("org.bluez.Device1");
+static const QLatin1String propertiesInterface("org.freedesktop.DBus.Properties");
+static const QLatin1String objectManagerInterface("org.freedesktop.DBus.ObjectManager");
+
+// advertised by every other simulated device, used for the discovery filter tests
+static const QLatin1String filteredServiceUuid("8c1e5a40-4f0e-4d5c-9d43-2a7b6f1c93e1");
+// the manufacturer data of every report carries the time it was sent
+static constexpr quint16 timestampCompanyId = 0xffff;
+
+static constexpr int defaultDurationMs = 5000;
+
+static qint64 monotonicNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static qint64 cpuTimeMicroseconds(int who)
+{
+    rusage usage;
+    if (getrusage(who, &usage) != 0)
+        return 0;
+    return (qint64(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000
+            + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+// Returns the value in kB of the field \a name in /proc/self/status.
+static qint64 processStatusValue(const QByteArray &name)
+{
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> lines = status.readAll().split('\n');
+    for (const QByteArray &line : lines) {
+        if (line.startsWith(name + ':'))
+            return line.mid(name.size() + 1).trimmed().split(' ').value(0).toLongLong();
+    }
+    return -1;
+}
+
+/*
+ * Plays bluetoothd on a private bus: an adapter at /org/bluez/hci0 whose
+ * devices appear through InterfacesAdded and advertise through
+ * PropertiesChanged signals, sent at a configurable rate from the thread the
+ * mock lives in. The calls of the discovery agent may arrive on the D-Bus
+ * thread, the state is therefore guarded by a mutex.
+ */
+class MockBluez : public QDBusVirtualObject
+{
+    Q_OBJECT
+public:
+    explicit MockBluez(const QDBusConnection &connection) : bus(connection) { }
+
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override;
+    QString introspect(const QString &path) const override;
+
+    // number of the reports sent since the last reset
+    int sentReports() const { return sent.load(); }
+    int startDiscoveryCalls() const { return startCalls.load(); }
+    QVariantMap lastDiscoveryFilter() const
+    {
+        QMutexLocker locker(&mutex);
+        return discoveryFilter;
+    }
+    qint64 cpuMicroseconds() const { return cpuTime.load(); }
+
+public slots:
+    // All devices appear at once, without timestamps.
+    void addDevices(int count);
+    // The devices appear, ratePerSecond of them per second.
+    void announceDevices(int count, int ratePerSecond);
+    // All devices advertise round-robin, ratePerSecond reports per second.
+    void startUpdates(int ratePerSecond, int durationMs);
+    void removeDevices();
+    void reset();
+
+signals:
+    void loadFinished();
+
+private:
+    QString devicePath(int index) const;
+    QVariantMap deviceProperties(int index, qint64 timestamp) const;
+    QVariantMap adapterProperties() const;
+    void startLoad(int count, int ratePerSecond, bool announcing);
+    void sendDueReports();
+    void sendPropertiesChanged(const QString &path, const QString &interface,
+                               const QVariantMap &changed);
+
+    QDBusConnection bus;
+    mutable QMutex mutex;
+    QHash<QString, QVariantMap> devices; // by path
+    int deviceCount = 0;
+    bool discovering = false;
+    QVariantMap discoveryFilter;
+
+    QTimer *loadTimer = nullptr;
+    QElapsedTimer loadClock;
+    bool announcing = false;
+    int loadRate = 0;
+    int loadTotal = 0;
+    int loadSent = 0;
+    qint64 loadCpuStart = 0;
+
+    std::atomic<int> sent = 0;
+    std::atomic<int> startCalls = 0;
+    std::atomic<qint64> cpuTime = 0;
+};
+
+static QString hexByte(int value)
+{
+    return QStringLiteral("%1").arg(value & 0xff, 2, 16, QLatin1Char('0')).toUpper();
+}
+
+QString MockBluez::devicePath(int index) const
+{
+    return QStringLiteral("%1/dev_C0_00_00_%2_%3_%4")
+            .arg(adapterPath, hexByte(index >> 16), hexByte(index >> 8), hexByte(index));
+}
+
+QVariantMap MockBluez::deviceProperties(int index, qint64 timestamp) const
+{
+    const QString address = devicePath(index).mid(adapterPath.size() + 5)
+                                .replace(QLatin1Char('_'), QLatin1Char(':'));
+    QVariantMap properties;
+    properties.insert(QStringLiteral("Address"), address);
+    properties.insert(QStringLiteral("AddressType"), QStringLiteral("random"));
+    properties.insert(QStringLiteral("Alias"), QStringLiteral("bench-%1").arg(index));
+    properties.insert(QStringLiteral("Adapter"), QVariant::fromValue(QDBusObjectPath(adapterPath)));
+    properties.insert(QStringLiteral("Paired"), false);
+    properties.insert(QStringLiteral("Connected"), false);
+    properties.insert(QStringLiteral("RSSI"), QVariant::fromValue(qint16(-40 - index % 50)));
+    if (index % 2 == 0)
+        properties.insert(QStringLiteral("UUIDs"), QStringList(filteredServiceUuid));
+
+    QByteArray stamp(sizeof(qint64), Qt::Uninitialized);
+    qToLittleEndian(timestamp, stamp.data());
+    ManufacturerDataList manufacturerData;
+    manufacturerData.insert(timestampCompanyId, QDBusVariant(stamp));
+    properties.insert(QStringLiteral("ManufacturerData"), QVariant::fromValue(manufacturerData));
+    return properties;
+}
+
+QVariantMap MockBluez::adapterProperties() const
+{
+    QVariantMap properties;
+    properties.insert(QStringLiteral("Address"), QStringLiteral("00:1A:7D:DA:71:13"));
+    properties.insert(QStringLiteral("AddressType"), QStringLiteral("public"));
+    properties.insert(QStringLiteral("Name"), QStringLiteral("mock"));
+    properties.insert(QStringLiteral("Alias"), QStringLiteral("mock"));
+    properties.insert(QStringLiteral("Class"), 0u);
+    properties.insert(QStringLiteral("Powered"), true);
+    properties.insert(QStringLiteral("Discoverable"), false);
+    properties.insert(QStringLiteral("Pairable"), false);
+    properties.insert(QStringLiteral("Discovering"), discovering);
+    return properties;
+}
+
+bool MockBluez::handleMessage(const QDBusMessage &message, const QDBusConnection &connection)
+{
+    if (message.type() != QDBusMessage::MethodCallMessage)
+        return false;
+
+    const QString path = message.path();
+    const QString interface = message.interface();
+    const QString member = message.member();
+    const QList<QVariant> arguments = message.arguments();
+    QMutexLocker locker(&mutex);
+
+    if (interface == objectManagerInterface && member == QLatin1String("GetManagedObjects")) {
+        ManagedObjectList objects;
+        objects.insert(QDBusObjectPath(adapterPath),
+                       InterfaceList{ { adapterInterface, adapterProperties() } });
+        for (auto it = devices.cbegin(); it != devices.cend(); ++it)
+            objects.insert(QDBusObjectPath(it.key()), InterfaceList{ { deviceInterface, it.value() } });
+        connection.send(message.createReply(QVariant::fromValue(objects)));
+        return true;
+    }
+
+    if (interface == propertiesInterface) {
+        QVariantMap properties;
+        if (path == adapterPath)
+            properties = adapterProperties();
+        else if (devices.contains(path))
+            properties = devices.value(path);
+        else
+            return false;
+
+        if (member == QLatin1String("GetAll")) {
+            connection.send(message.createReply(properties));
+            return true;
+        }
+        if (member == QLatin1String("Get") && arguments.size() == 2) {
+            const QString name = arguments.at(1).toString();
+            if (!properties.contains(name)) {
+                connection.send(message.createErrorReply(
+                        QStringLiteral("org.freedesktop.DBus.Error.InvalidArgs"), name));
+            } else {
+                connection.send(message.createReply(
+                        QVariant::fromValue(QDBusVariant(properties.value(name)))));
+            }
+            return true;
+        }
+        return false;
+    }
+
+    if (interface != adapterInterface || path != adapterPath)
+        return false;
+
+    if (member == QLatin1String("StartDiscovery") || member == QLatin1String("StopDiscovery")) {
+        const bool start = member == QLatin1String("StartDiscovery");
+        if (start)
+            ++startCalls;
+        connection.send(message.createReply());
+        if (discovering != start) {
+            discovering = start;
+            locker.unlock();
+            sendPropertiesChanged(adapterPath, adapterInterface,
+                                  { { QStringLiteral("Discovering"), start } });
+        }
+        return true;
+    }
+    if (member == QLatin1String("SetDiscoveryFilter") && arguments.size() == 1) {
+        discoveryFilter = qdbus_cast<QVariantMap>(arguments.at(0));
+        connection.send(message.createReply());
+        return true;
+    }
+    if (member == QLatin1String("RemoveDevice")) {
+        connection.send(message.createReply());
+        return true;
+    }
+    return false;
+}
+
+QString MockBluez::introspect(const QString &path) const
+{
+    if (path == QLatin1String("/")) {
+        return QStringLiteral("<interface name=\"org.freedesktop.DBus.ObjectManager\">"
+                              "<method name=\"GetManagedObjects\">"
+                              "<arg type=\"a{oa{sa{sv}}}\" direction=\"out\"/>"
+                              "</method></interface>");
+    }
+    return QString();
+}
+
+void MockBluez::sendPropertiesChanged(const QString &path, const QString &interface,
+                                      const QVariantMap &changed)
+{
+    QDBusMessage signal = QDBusMessage::createSignal(path, propertiesInterface,
+                                                     QStringLiteral("PropertiesChanged"));
+    signal << interface << changed << QStringList();
+    bus.send(signal);
+}
+
+void MockBluez::addDevices(int count)
+{
+    for (int i = deviceCount; i < deviceCount + count; ++i) {
+        const QString path = devicePath(i);
+        const QVariantMap properties = deviceProperties(i, 0);
+        {
+            QMutexLocker locker(&mutex);
+            devices.insert(path, properties);
+        }
+        QDBusMessage signal = QDBusMessage::createSignal(QStringLiteral("/"), objectManagerInterface,
+                                                         QStringLiteral("InterfacesAdded"));
+        signal << QVariant::fromValue(QDBusObjectPath(path))
+               << QVariant::fromValue(InterfaceList{ { deviceInterface, properties } });
+        bus.send(signal);
+    }
+    deviceCount += count;
+}
+
+void MockBluez::announceDevices(int count, int ratePerSecond)
+{
+    startLoad(count, ratePerSecond, true);
+}
+
+void MockBluez::startUpdates(int ratePerSecond, int durationMs)
+{
+    startLoad(int(qint64(ratePerSecond) * durationMs / 1000), ratePerSecond, false);
+}
+
+void MockBluez::startLoad(int count, int ratePerSecond, bool announce)
+{
+    if (!loadTimer) {
+        loadTimer = new QTimer(this);
+        loadTimer->setTimerType(Qt::PreciseTimer);
+        loadTimer->setInterval(1);
+        connect(loadTimer, &QTimer::timeout, this, &MockBluez::sendDueReports);
+    }
+
+    announcing = announce;
+    loadRate = ratePerSecond;
+    loadTotal = count;
+    loadSent = 0;
+    loadCpuStart = cpuTimeMicroseconds(RUSAGE_THREAD);
+    loadClock.start();
+    loadTimer->start();
+}
+
+void MockBluez::sendDueReports()
+{
+    const qint64 due = qMin<qint64>(loadTotal, loadClock.nsecsElapsed() * loadRate / 1000000000);
+    for (; loadSent < due; ++loadSent) {
+        if (announcing) {
+            const int index = deviceCount++;
+            const QString path = devicePath(index);
+            const QVariantMap properties = deviceProperties(index, monotonicNanoseconds());
+            {
+                QMutexLocker locker(&mutex);
+                devices.insert(path, properties);
+            }
+            QDBusMessage signal = QDBusMessage::createSignal(
+                    QStringLiteral("/"), objectManagerInterface, QStringLiteral("InterfacesAdded"));
+            signal << QVariant::fromValue(QDBusObjectPath(path))
+                   << QVariant::fromValue(InterfaceList{ { deviceInterface, properties } });
+            bus.send(signal);
+        } else {
+            const int index = loadSent % qMax(deviceCount, 1);
+            QByteArray stamp(sizeof(qint64), Qt::Uninitialized);
+            qToLittleEndian(monotonicNanoseconds(), stamp.data());
+            ManufacturerDataList manufacturerData;
+            manufacturerData.insert(timestampCompanyId, QDBusVariant(stamp));
+            const QVariantMap changed {
+                { QStringLiteral("RSSI"), QVariant::fromValue(qint16(-40 - loadSent % 50)) },
+                { QStringLiteral("ManufacturerData"), QVariant::fromValue(manufacturerData) }
+            };
+            sendPropertiesChanged(devicePath(index), deviceInterface, changed);
+        }
+        ++sent;
+    }
+
+    if (loadSent >= loadTotal) {
+        loadTimer->stop();
+        cpuTime = cpuTimeMicroseconds(RUSAGE_THREAD) - loadCpuStart;
+        emit loadFinished();
+    }
+}
+
+void MockBluez::removeDevices()
+{
+    QHash<QString, QVariantMap> removed;
+    {
+        QMutexLocker locker(&mutex);
+        removed.swap(devices);
+    }
+    for (auto it = removed.cbegin(); it != removed.cend(); ++it) {
+        QDBusMessage signal = QDBusMessage::createSignal(
+                QStringLiteral("/"), objectManagerInterface, QStringLiteral("InterfacesRemoved"));
+        signal << QVariant::fromValue(QDBusObjectPath(it.key())) << QStringList(deviceInterface);
+        bus.send(signal);
+    }
+    deviceCount = 0;
+}
+
+void MockBluez::reset()
+{
+    if (loadTimer)
+        loadTimer->stop();
+    removeDevices();
+    sent = 0;
+    startCalls = 0;
+    cpuTime = 0;
+    QMutexLocker locker(&mutex);
+    discoveryFilter.clear();
+}
+
+/*
+ * This benchmark runs QBluetoothDeviceDiscoveryAgent against a mock of
+ * bluetoothd on a private D-Bus daemon, no Bluetooth hardware or bluetoothd
+ * is used. The mock simulates thousands of devices appearing and
+ * advertising at the given rates:
+ *
+ *   - deviceAnnouncement: devices appearing through InterfacesAdded
+ *   - propertyUpdates: advertisements of known devices, each one
+ *     a PropertiesChanged signal for RSSI and ManufacturerData
+ *
+ * Every row logs the latency from sending a signal until the agent reports
+ * the device, the CPU time spent in the agent's thread and in the whole
+ * process except for the mock, and the growth of the resident memory. The
+ * benchmark result is the median latency. The duration of the update load
+ * can be set in milliseconds with the QT_BENCH_DBUS_LOAD_DURATION environment
+ * variable. dbus-daemon has to be installed.
+ *
+ * sharedScan and discoveryFilter check on the same harness that agents share
+ * the scan on the adapter and that the merged discovery filter reaches
+ * bluetoothd, while each agent still applies its own filter.
+ */
+class tst_bench_qbluetoothdevicediscoveryagent_dbusload : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void cleanup();
+
+    void deviceAnnouncement_data();
+    void deviceAnnouncement();
+    void propertyUpdates_data();
+    void propertyUpdates();
+    void sharedScan();
+    void discoveryFilter();
+
+private:
+    void settle();
+    void report(const char *name, std::vector<qint64> &latencies, int sent, int received,
+                qint64 threadCpu, qint64 processCpu, qint64 rssBefore);
+
+    QProcess mBusDaemon;
+    QThread mMockThread;
+    MockBluez *mMock = nullptr;
+    QString mBusAddress;
+    int mDurationMs = defaultDurationMs;
+};
+
+void tst_bench_qbluetoothdevicediscoveryagent_dbusload::initTestCase()
+{
+    qDBusRegisterMetaType<InterfaceList>();
+    qDBusRegisterMetaType<ManagedObjectList>();
+    qDBusRegisterMetaType<ManufacturerDataList>();
+
+    mBusDaemon.start(QStringLiteral("dbus-daemon"),
+                     { QStringLiteral("--session"), QStringLiteral("--nofork"),
+                       QStringLiteral("--print-address") });
+    if (!mBusDaemon.waitForStarted())
+        QSKIP("dbus-daemon is not available");
+    QVERIFY(mBusDaemon.waitForReadyRead(5000));
+    mBusAddress = QString::fromLatin1(mBusDaemon.readLine().trimmed());
+    QVERIFY(!mBusAddress.isEmpty());
+
+    // the agent talks to "bluetoothd" on the system bus
+    qputenv("DBUS_SYSTEM_BUS_ADDRESS", mBusAddress.toLatin1());
+    qunsetenv("QT_BLUETOOTH_MGMT_DEVICE_FOUND");
+
+    QDBusConnection mockBus = QDBusConnection::connectToBus(mBusAddress,
+                                                            QStringLiteral("mock-bluez"));
+    QVERIFY(mockBus.isConnected());
+    mMock = new MockBluez(mockBus);
+    mMock->moveToThread(&mMockThread);
+    connect(&mMockThread, &QThread::finished, mMock, &QObject::deleteLater);
+    mMockThread.start();
+    QVERIFY(mockBus.registerVirtualObject(QStringLiteral("/"), mMock,
+                                          QDBusConnection::SubPath));
+    QVERIFY(mockBus.registerService(bluezService));
+
+    bool ok = false;
+    const int duration = qEnvironmentVariableIntValue("QT_BENCH_DBUS_LOAD_DURATION", &ok);
+    if (ok && duration > 0)
+        mDurationMs = duration;
+}
+
+void tst_bench_qbluetoothdevicediscoveryagent_dbusload::cleanupTestCase()
+{
+    if (mMock) {
+        QDBusConnection::disconnectFromBus(QStringLiteral("mock-bluez"));
+        mMockThread.quit();
+        mMockThread.wait();
+        mMock = nullptr;
+    }
+    mBusDaemon.terminate();
+    mBusDaemon.waitForFinished();
+}
+
+void tst_bench_qbluetoothdevicediscoveryagent_dbusload::cleanup()
+{
+    if (!mMock)
+        return;
+    QMetaObject::invokeMethod(mMock, &MockBluez::reset, Qt::BlockingQueuedConnection);
+    settle();
+}
+
+// Gives the agent time to process the signals the mock sent so far.
+void tst_bench_qbluetoothdevicediscoveryagent_dbusload::settle()
+{
+    QTest::qWait(500);
+}
+
+void tst_bench_qbluetoothdevicediscoveryagent_dbusload::report(
+        const char *name, std::vector<qint64> &latencies, int sent, int received,
+        qint64 threadCpu, qint64 processCpu, qint64 rssBefore)
+{
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](double p) -> qint64 {
+        if (latencies.empty())
+            return -1;
+        return latencies.at(qMin(latencies.size() - 1, size_t(latencies.size() * p)));
+    };
+
+    qInfo("%s: sent=%d received=%d median_latency_us=%lld p99_latency_us=%lld "
+          "max_latency_us=%lld agent_thread_cpu_ms=%lld process_cpu_ms=%lld "
+          "cpu_per_signal_us=%.2f rss_growth_kb=%lld peak_rss_kb=%lld",
+          name, sent, received, percentile(0.5) / 1000, percentile(0.99) / 1000,
+          percentile(1.0) / 1000, threadCpu / 1000, processCpu / 1000,
+          received > 0 ? double(processCpu) / received : 0.0,
+          processStatusValue("VmRSS") - rssBefore, processStatusValue("VmHWM"));
+
+    QTest::setBenchmarkResult(percentile(0.5), QTest::WalltimeNanoseconds);
+}
+
+static qint64 latencyOf(const QBluetoothDeviceInfo &info)
+{
+    const QByteArray stamp = info.manufacturerData(timestampCompanyId);
+    if (stamp.size() != sizeof(qint64))
+        return -1;
+    const qint64 sentAt = qFromLittleEndian<qint64>(stamp.constData());
+    return sentAt > 0 ? monotonicNanoseconds() - sentAt : -1;
+}
+
+void tst_bench_qbluetoothdevicediscoveryagent_dbusload::deviceAnnouncement_data()
+{
+    QTest::addColumn<int>("devices");
+    QTest::addColumn<int>("rate");
+
+    const int deviceCounts[] = { 1000, 5000 };
+    const int rates[] = { 1000, 10000 };
+    for (const int devices : deviceCounts) {
+        for (const int rate : rates)
+            QTest::addRow("devices%d-rate%d", devices, rate) << devices << rate;
+    }
+}
+
+void tst_bench_qbluetoothdevicediscoveryagent_dbusload::deviceAnnouncement()
+{
+    QFETCH(int, devices);
+    QFETCH(int, rate);
+
+    QBluetoothDeviceDiscoveryAgent agent;
+    agent.setLowEnergyDiscoveryTimeout(0);
+
+    std::vector<qint64> latencies;
+    latencies.reserve(devices);
+    QSet<QBluetoothAddress> found;
+    connect(&agent, &QBluetoothDeviceDiscoveryAgent::deviceDiscovered, this,
+            [&](const QBluetoothDeviceInfo &info) {
+        const qint64 latency = latencyOf(info);
+        if (latency >= 0 && !found.contains(info.address())) {
+            found.insert(info.address());
+            latencies.push_back(latency);
+        }
+    });
+
+    agent.start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
+    QVERIFY(agent.isActive());
+
+    const qint64 rssBefore = processStatusValue("VmRSS");
+    const qint64 threadCpuBefore = cpuTimeMicroseconds(RUSAGE_THREAD);
+    const qint64 processCpuBefore = cpuTimeMicroseconds(RUSAGE_SELF);
+
+    QSignalSpy finishedSpy(mMock, &MockBluez::loadFinished);
+    QMetaObject::invokeMethod(mMock, [this, devices, rate]() {
+        mMock->announceDevices(devices, rate);
+    });
+    QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.size(), 1, 60000 + devices * 1000 / rate);
+    QTRY_COMPARE_WITH_TIMEOUT(int(found.size()), devices, 30000);
+
+    const qint64 threadCpu = cpuTimeMicroseconds(RUSAGE_THREAD) - threadCpuBefore;
+    const qint64 processCpu = cpuTimeMicroseconds(RUSAGE_SELF) - processCpuBefore
+            - mMock->cpuMicroseconds();
+    report("announcement", latencies, mMock->sentReports(), int(found.size()),
+           threadCpu, processCpu, rssBefore);
+    QCOMPARE(int(agent.discoveredDevices().size()), devices);
+    agent.stop();
+}
+
+void tst_bench_qbluetoothdevicediscoveryagent_dbusload::propertyUpdates_data()
+{
+    QTest::addColumn<int>("devices");
+    QTest::addColumn<int>("rate");
+
+    const int deviceCounts[] = { 100, 1000, 5000 };
+    const int rates[] = { 1000, 5000, 20000 };
+    for (const int devices : deviceCounts) {
+        for (const int rate : rates)
+            QTest::addRow("devices%d-rate%d", devices, rate) << devices << rate;
+    }
+}
+
+void tst_bench_qbluetoothdevicediscoveryagent_dbusload::propertyUpdates()
+{
+    QFETCH(int, devices);
+    QFETCH(int, rate);
+
+    QMetaObject::invokeMethod(mMock, [this, devices]() { mMock->addDevices(devices); },
+                              Qt::BlockingQueuedConnection);
+    settle();
+
+    QBluetoothDeviceDiscoveryAgent agent;
+    agent.setLowEnergyDiscoveryTimeout(0);
+    QSignalSpy discoveredSpy(&agent, &QBluetoothDeviceDiscoveryAgent::deviceDiscovered);
+    agent.start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
+    QVERIFY(agent.isActive());
+    QTRY_COMPARE_WITH_TIMEOUT(int(agent.discoveredDevices().size()), devices, 30000);
+
+    std::vector<qint64> latencies;
+    latencies.reserve(size_t(qint64(rate) * mDurationMs / 1000));
+    int updates = 0;
+    connect(&agent, &QBluetoothDeviceDiscoveryAgent::deviceUpdated, this,
+            [&](const QBluetoothDeviceInfo &info, QBluetoothDeviceInfo::Fields fields) {
+        if (!fields.testFlag(QBluetoothDeviceInfo::Field::ManufacturerData))
+            return;
+        ++updates;
+        const qint64 latency = latencyOf(info);
+        if (latency >= 0)
+            latencies.push_back(latency);
+    });
+
+    const qint64 rssBefore = processStatusValue("VmRSS");
+    const qint64 threadCpuBefore = cpuTimeMicroseconds(RUSAGE_THREAD);
+    const qint64 processCpuBefore = cpuTimeMicroseconds(RUSAGE_SELF);
+
+    QSignalSpy finishedSpy(mMock, &MockBluez::loadFinished);
+    QMetaObject::invokeMethod(mMock, [this, rate, duration = mDurationMs]() {
+        mMock->startUpdates(rate, duration);
+    });
+    QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.size(), 1, mDurationMs + 60000);
+    // D-Bus does not drop signals, a slow agent lags behind
+    QTRY_COMPARE_WITH_TIMEOUT(updates, mMock->sentReports(), 60000);
+
+    const qint64 threadCpu = cpuTimeMicroseconds(RUSAGE_THREAD) - threadCpuBefore;
+    const qint64 processCpu = cpuTimeMicroseconds(RUSAGE_SELF) - processCpuBefore
+            - mMock->cpuMicroseconds();
+    report("updates", latencies, mMock->sentReports(), updates, threadCpu, processCpu,
+           rssBefore);
+    agent.stop();
+}
+
+void tst_bench_qbluetoothdevicediscoveryagent_dbusload::sharedScan()
+{
+    constexpr int devices = 200;
+    QMetaObject::invokeMethod(mMock, [this]() { mMock->addDevices(devices); },
+                              Qt::BlockingQueuedConnection);
+    settle();
+
+    QBluetoothDeviceDiscoveryAgent filtered;
+    filtered.setLowEnergyDiscoveryTimeout(0);
+    filtered.setServiceUuidFilter({ QBluetoothUuid(filteredServiceUuid) });
+    QBluetoothDeviceDiscoveryAgent unfiltered;
+    unfiltered.setLowEnergyDiscoveryTimeout(0);
+
+    int filteredUpdates = 0;
+    int unfilteredUpdates = 0;
+    connect(&filtered, &QBluetoothDeviceDiscoveryAgent::deviceUpdated, this,
+            [&]() { ++filteredUpdates; });
+    connect(&unfiltered, &QBluetoothDeviceDiscoveryAgent::deviceUpdated, this,
+            [&]() { ++unfilteredUpdates; });
+
+    filtered.start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
+    unfiltered.start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
+    QVERIFY(filtered.isActive());
+    QVERIFY(unfiltered.isActive());
+    QTRY_COMPARE(int(unfiltered.discoveredDevices().size()), devices);
+    QCOMPARE(int(filtered.discoveredDevices().size()), devices / 2);
+
+    // one discovery on the adapter, with the union of both filters
+    QCOMPARE(mMock->startDiscoveryCalls(), 1);
+    const QVariantMap filter = mMock->lastDiscoveryFilter();
+    QCOMPARE(filter.value(QStringLiteral("Transport")).toString(), QStringLiteral("le"));
+    QVERIFY(!filter.contains(QStringLiteral("UUIDs")));
+
+    QSignalSpy finishedSpy(mMock, &MockBluez::loadFinished);
+    QMetaObject::invokeMethod(mMock, [this]() { mMock->startUpdates(2000, 1000); });
+    QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.size(), 1, 30000);
+    QTRY_COMPARE_WITH_TIMEOUT(unfilteredUpdates, mMock->sentReports(), 30000);
+    QTRY_COMPARE_WITH_TIMEOUT(filteredUpdates, mMock->sentReports() / 2, 30000);
+
+    filtered.stop();
+    unfiltered.stop();
+}
+
+void tst_bench_qbluetoothdevicediscoveryagent_dbusload::discoveryFilter()
+{
+    QBluetoothDeviceDiscoveryAgent agent;
+    agent.setLowEnergyDiscoveryTimeout(0);
+    agent.setServiceUuidFilter({ QBluetoothUuid(filteredServiceUuid) });
+    agent.setRssiThreshold(-70);
+    agent.setReportDuplicateData(false);
+    agent.start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
+    QVERIFY(agent.isActive());
+
+    const QVariantMap filter = mMock->lastDiscoveryFilter();
+    QCOMPARE(filter.value(QStringLiteral("Transport")).toString(), QStringLiteral("le"));
+    QCOMPARE(filter.value(QStringLiteral("UUIDs")).toStringList(),
+             QStringList(filteredServiceUuid));
+    QCOMPARE(filter.value(QStringLiteral("RSSI")).toInt(), -70);
+    QVERIFY(!filter.contains(QStringLiteral("Pathloss")));
+    QCOMPARE(filter.value(QStringLiteral("DuplicateData")).toBool(), false);
+    agent.stop();
+}
+
+QTEST_MAIN(tst_bench_qbluetoothdevicediscoveryagent_dbusload)
+
+#include "tst_bench_qbluetoothdevicediscoveryagent_dbusload.moc"
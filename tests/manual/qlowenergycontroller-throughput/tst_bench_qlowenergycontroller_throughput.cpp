@@ -0,0 +1,372 @@
+// Copyright (C) 2022 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QObject>
+#include <QtGlobal>
+#include <QTest>
+#include <QBluetoothDeviceDiscoveryAgent>
+#include <QElapsedTimer>
+#include <QLowEnergyConnectionParameters>
+#include <QLowEnergyController>
+#include <QSignalSpy>
+#include <QtEndian>
+
+#include <memory>
+
+static const QLatin1String largeCharacteristicServiceUuid("1f85e37c-ac16-11eb-ae5c-93d3a763feed");
+static const QLatin1String largeCharacteristicCharUuid("40e4f68e-ac16-11eb-9956-cfe55a8c370c");
+
+static const QLatin1String throughputServiceUuid("5e0c4a41-3c4b-4b2f-9d57-7f1e0a6c2b10");
+static const QLatin1String throughputControlCharUuid("5e0c4a42-3c4b-4b2f-9d57-7f1e0a6c2b10");
+static const QLatin1String throughputNotifyCharUuid("5e0c4a43-3c4b-4b2f-9d57-7f1e0a6c2b10");
+static const QLatin1String throughputSinkCharUuid("5e0c4a44-3c4b-4b2f-9d57-7f1e0a6c2b10");
+static const QLatin1String throughputCounterCharUuid("5e0c4a45-3c4b-4b2f-9d57-7f1e0a6c2b10");
+
+static constexpr char throughputStartNotifications = 0x01;
+static constexpr char throughputResetCounter = 0x02;
+
+static constexpr int notificationCount = 500;
+static constexpr int writeCommandCount = 500;
+static constexpr int readCount = 50;
+static constexpr int longWriteCount = 10;
+
+/*
+ * This benchmark measures the GATT throughput between this LE client and
+ * the "bluetoothtestdevice" server in the same repository, which needs to be
+ * running when this benchmark is run:
+ *
+ *   - the rate of notifications sent back-to-back by the server
+ *   - the throughput of write commands (writes without response)
+ *   - the latency of reading a short characteristic
+ *   - the time of writing a 512 bytes long characteristic
+ *
+ * Each measurement is repeated for several preferred MTUs and connection
+ * intervals. The platform may not grant them, the negotiated values are
+ * logged for every row. Use the usual QTest options such as "-csv" or
+ * "-o results.xml,xml" for machine-readable results. The name of the server
+ * device can be set with the BTLE_SERVER_DEVICE_NAME environment variable.
+ */
+class tst_bench_qlowenergycontroller_throughput : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanup();
+
+    void notificationThroughput_data();
+    void notificationThroughput();
+    void writeCommandThroughput_data();
+    void writeCommandThroughput();
+    void readLatency_data();
+    void readLatency();
+    void longWrite_data();
+    void longWrite();
+
+private:
+    void addLinkRows();
+    void discoverTestServer();
+    void setUpLink();
+    void writeControl(const QByteArray &command);
+
+    std::unique_ptr<QBluetoothDeviceDiscoveryAgent> mDevAgent;
+    std::unique_ptr<QLowEnergyController> mController;
+    std::unique_ptr<QLowEnergyService> mThroughputService;
+    QBluetoothDeviceInfo mRemoteDeviceInfo;
+    QString mServerDeviceName;
+};
+
+void tst_bench_qlowenergycontroller_throughput::initTestCase()
+{
+    mDevAgent.reset(new QBluetoothDeviceDiscoveryAgent(this));
+    mDevAgent->setLowEnergyDiscoveryTimeout(75000);
+    mServerDeviceName = qEnvironmentVariable("BTLE_SERVER_DEVICE_NAME");
+    if (mServerDeviceName.isEmpty())
+        mServerDeviceName = QStringLiteral("BluetoothTestDevice");
+    qDebug() << "Using server device name for benchmarking: " << mServerDeviceName;
+    qDebug() << "To change this set BTLE_SERVER_DEVICE_NAME environment variable";
+
+    discoverTestServer();
+}
+
+void tst_bench_qlowenergycontroller_throughput::discoverTestServer()
+{
+    QSignalSpy finishedSpy(mDevAgent.get(), &QBluetoothDeviceDiscoveryAgent::finished);
+    QSignalSpy canceledSpy(mDevAgent.get(), &QBluetoothDeviceDiscoveryAgent::canceled);
+
+    QObject forLifeTime;
+    QObject::connect(mDevAgent.get(), &QBluetoothDeviceDiscoveryAgent::deviceDiscovered,
+                     &forLifeTime, [&](const QBluetoothDeviceInfo& info) {
+        if (info.name() == mServerDeviceName)
+            mDevAgent->stop();
+    });
+
+    mDevAgent->start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
+    QTRY_VERIFY_WITH_TIMEOUT(!finishedSpy.isEmpty() || !canceledSpy.isEmpty(), 80000);
+
+    const QList<QBluetoothDeviceInfo> infos = mDevAgent->discoveredDevices();
+    for (const QBluetoothDeviceInfo &info : infos) {
+        if (info.name() == mServerDeviceName) {
+            mRemoteDeviceInfo = info;
+            break;
+        }
+    }
+    QVERIFY2(mRemoteDeviceInfo.isValid(), "Cannot find remote device.");
+}
+
+void tst_bench_qlowenergycontroller_throughput::cleanup()
+{
+    mThroughputService.reset();
+    if (mController) {
+        mController->disconnectFromDevice();
+        QTRY_VERIFY_WITH_TIMEOUT(mController->state() == QLowEnergyController::UnconnectedState,
+                                 30000);
+        mController.reset();
+    }
+    // give the server time to restart advertising
+    QTest::qWait(2000);
+}
+
+void tst_bench_qlowenergycontroller_throughput::addLinkRows()
+{
+    QTest::addColumn<int>("mtu");
+    QTest::addColumn<double>("interval");
+
+    const int mtus[] = { 23, 185, 247, 517 };
+    const double intervals[] = { 7.5, 15, 30 };
+    for (const int mtu : mtus) {
+        for (const double interval : intervals) {
+            QTest::addRow("mtu%d-interval%gms", mtu, interval) << mtu << interval;
+        }
+    }
+}
+
+// Connects with the MTU and connection interval of the current row and
+// discovers the throughput service.
+void tst_bench_qlowenergycontroller_throughput::setUpLink()
+{
+    QFETCH(int, mtu);
+    QFETCH(double, interval);
+
+    mController.reset(QLowEnergyController::createCentral(mRemoteDeviceInfo));
+    mController->setPreferredMtu(mtu);
+    mController->connectToDevice();
+    QTRY_VERIFY_WITH_TIMEOUT(mController->state() != QLowEnergyController::ConnectingState, 45000);
+    QCOMPARE(mController->state(), QLowEnergyController::ConnectedState);
+
+    mController->discoverServices();
+    QTRY_COMPARE_WITH_TIMEOUT(mController->state(), QLowEnergyController::DiscoveredState, 30000);
+
+    mThroughputService.reset(
+            mController->createServiceObject(QBluetoothUuid(throughputServiceUuid)));
+    QVERIFY2(mThroughputService, "The server does not offer the throughput service.");
+    mThroughputService->discoverDetails(QLowEnergyService::SkipValueDiscovery);
+    QTRY_COMPARE_WITH_TIMEOUT(mThroughputService->state(),
+                              QLowEnergyService::RemoteServiceDiscovered, 30000);
+
+    QSignalSpy updatedSpy(mController.get(), &QLowEnergyController::connectionUpdated);
+    QLowEnergyConnectionParameters parameters;
+    parameters.setIntervalRange(interval, interval);
+    parameters.setLatency(0);
+    parameters.setSupervisionTimeout(4000);
+    mController->requestConnectionUpdate(parameters);
+    // not all platforms report the update, continue with what was granted
+    updatedSpy.wait(5000);
+    const double grantedInterval = updatedSpy.isEmpty()
+            ? -1 : updatedSpy.constLast().at(0).value<QLowEnergyConnectionParameters>()
+                           .minimumInterval();
+
+    qInfo("link: requested_mtu=%d mtu=%d requested_interval_ms=%g interval_ms=%g",
+          mtu, mController->mtu(), interval, grantedInterval);
+}
+
+void tst_bench_qlowenergycontroller_throughput::writeControl(const QByteArray &command)
+{
+    const QLowEnergyCharacteristic control =
+            mThroughputService->characteristic(QBluetoothUuid(throughputControlCharUuid));
+    QVERIFY(control.isValid());
+
+    QSignalSpy writtenSpy(mThroughputService.get(), &QLowEnergyService::characteristicWritten);
+    mThroughputService->writeCharacteristic(control, command);
+    QTRY_COMPARE_WITH_TIMEOUT(writtenSpy.size(), 1, 10000);
+}
+
+void tst_bench_qlowenergycontroller_throughput::notificationThroughput_data()
+{
+    addLinkRows();
+}
+
+void tst_bench_qlowenergycontroller_throughput::notificationThroughput()
+{
+    setUpLink();
+    if (QTest::currentTestFailed())
+        return;
+
+    const QLowEnergyCharacteristic notifying =
+            mThroughputService->characteristic(QBluetoothUuid(throughputNotifyCharUuid));
+    QVERIFY(notifying.isValid());
+    const QLowEnergyDescriptor clientConfig = notifying.clientCharacteristicConfiguration();
+    QVERIFY(clientConfig.isValid());
+
+    QSignalSpy descriptorSpy(mThroughputService.get(), &QLowEnergyService::descriptorWritten);
+    mThroughputService->writeDescriptor(clientConfig,
+                                        QLowEnergyCharacteristic::CCCDEnableNotification);
+    QTRY_COMPARE_WITH_TIMEOUT(descriptorSpy.size(), 1, 10000);
+
+    // the rate is measured from the first to the last notification,
+    // independent of the round trip of the start command
+    const int size = mController->mtu() - 3;
+    int received = 0;
+    quint32 lastSequence = 0;
+    int lost = 0;
+    QElapsedTimer timer;
+    connect(mThroughputService.get(), &QLowEnergyService::characteristicChanged, this,
+            [&](const QLowEnergyCharacteristic &characteristic, const QByteArray &value) {
+        if (characteristic.uuid() != QBluetoothUuid(throughputNotifyCharUuid) || value.size() < 4)
+            return;
+        const quint32 sequence = qFromLittleEndian<quint32>(value.constData());
+        if (received == 0)
+            timer.start();
+        else
+            lost += int(sequence - lastSequence) - 1;
+        lastSequence = sequence;
+        ++received;
+    });
+
+    QByteArray command(7, Qt::Uninitialized);
+    command[0] = throughputStartNotifications;
+    qToLittleEndian(quint32(notificationCount), command.data() + 1);
+    qToLittleEndian(quint16(size), command.data() + 5);
+    writeControl(command);
+
+    QTRY_VERIFY_WITH_TIMEOUT(received + lost >= notificationCount, 120000);
+    const qint64 elapsed = timer.nsecsElapsed();
+    QVERIFY(elapsed > 0);
+
+    qInfo("notifications: received=%d lost=%d size=%d per_second=%.1f", received, lost, size,
+          (received - 1) * 1e9 / elapsed);
+    QTest::setBenchmarkResult(qreal(received - 1) * size * 1e9 / elapsed, QTest::BytesPerSecond);
+}
+
+void tst_bench_qlowenergycontroller_throughput::writeCommandThroughput_data()
+{
+    addLinkRows();
+}
+
+void tst_bench_qlowenergycontroller_throughput::writeCommandThroughput()
+{
+    setUpLink();
+    if (QTest::currentTestFailed())
+        return;
+
+    writeControl(QByteArray(1, throughputResetCounter));
+
+    const QLowEnergyCharacteristic sink =
+            mThroughputService->characteristic(QBluetoothUuid(throughputSinkCharUuid));
+    const QLowEnergyCharacteristic counter =
+            mThroughputService->characteristic(QBluetoothUuid(throughputCounterCharUuid));
+    QVERIFY(sink.isValid());
+    QVERIFY(counter.isValid());
+
+    const int size = mController->mtu() - 3;
+    const QByteArray value(size, 0x5a);
+    QSignalSpy readSpy(mThroughputService.get(), &QLowEnergyService::characteristicRead);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < writeCommandCount; ++i)
+        mThroughputService->writeCharacteristic(sink, value,
+                                                QLowEnergyService::WriteWithoutResponse);
+    // ATT requests are answered in order, the read completes once the
+    // server processed all commands before it
+    mThroughputService->readCharacteristic(counter);
+    QTRY_COMPARE_WITH_TIMEOUT(readSpy.size(), 1, 120000);
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    const QByteArray counterValue = readSpy.constFirst().at(1).toByteArray();
+    QCOMPARE(counterValue.size(), 8);
+    const quint32 writes = qFromLittleEndian<quint32>(counterValue.constData());
+    const quint32 bytes = qFromLittleEndian<quint32>(counterValue.constData() + 4);
+
+    qInfo("write_commands: sent=%d received=%u size=%d per_second=%.1f", writeCommandCount,
+          writes, size, writes * 1e9 / elapsed);
+    QCOMPARE(writes, quint32(writeCommandCount));
+    QTest::setBenchmarkResult(qreal(bytes) * 1e9 / elapsed, QTest::BytesPerSecond);
+}
+
+void tst_bench_qlowenergycontroller_throughput::readLatency_data()
+{
+    addLinkRows();
+}
+
+void tst_bench_qlowenergycontroller_throughput::readLatency()
+{
+    setUpLink();
+    if (QTest::currentTestFailed())
+        return;
+
+    const QLowEnergyCharacteristic counter =
+            mThroughputService->characteristic(QBluetoothUuid(throughputCounterCharUuid));
+    QVERIFY(counter.isValid());
+
+    QSignalSpy readSpy(mThroughputService.get(), &QLowEnergyService::characteristicRead);
+    qint64 total = 0;
+    qint64 maximum = 0;
+    for (int i = 0; i < readCount; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        mThroughputService->readCharacteristic(counter);
+        QTRY_COMPARE_WITH_TIMEOUT(readSpy.size(), i + 1, 10000);
+        const qint64 elapsed = timer.nsecsElapsed();
+        total += elapsed;
+        maximum = qMax(maximum, elapsed);
+    }
+
+    qInfo("reads: count=%d mean_us=%.1f max_us=%.1f", readCount,
+          total / 1e3 / readCount, maximum / 1e3);
+    QTest::setBenchmarkResult(qreal(total) / readCount, QTest::WalltimeNanoseconds);
+}
+
+void tst_bench_qlowenergycontroller_throughput::longWrite_data()
+{
+    addLinkRows();
+}
+
+void tst_bench_qlowenergycontroller_throughput::longWrite()
+{
+    setUpLink();
+    if (QTest::currentTestFailed())
+        return;
+
+    std::unique_ptr<QLowEnergyService> service(
+            mController->createServiceObject(QBluetoothUuid(largeCharacteristicServiceUuid)));
+    QVERIFY(service);
+    service->discoverDetails(QLowEnergyService::SkipValueDiscovery);
+    QTRY_COMPARE_WITH_TIMEOUT(service->state(), QLowEnergyService::RemoteServiceDiscovered,
+                              30000);
+
+    const QLowEnergyCharacteristic large =
+            service->characteristic(QBluetoothUuid(largeCharacteristicCharUuid));
+    QVERIFY(large.isValid());
+
+    QByteArray value(512, 0);
+    value[0] = 0x0b;
+    QSignalSpy writtenSpy(service.get(), &QLowEnergyService::characteristicWritten);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < longWriteCount; ++i) {
+        value[1] = char(i);
+        service->writeCharacteristic(large, value);
+        QTRY_COMPARE_WITH_TIMEOUT(writtenSpy.size(), i + 1, 30000);
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    qInfo("long_writes: count=%d size=%d mean_ms=%.2f", longWriteCount, int(value.size()),
+          elapsed / 1e6 / longWriteCount);
+    QTest::setBenchmarkResult(qreal(elapsed) / 1e6 / longWriteCount,
+                              QTest::WalltimeMilliseconds);
+}
+
+QTEST_MAIN(tst_bench_qlowenergycontroller_throughput)
+
+#include "tst_bench_qlowenergycontroller_throughput.moc"